@@ -1 +1,873 @@
-﻿
\ No newline at end of file
+﻿#include "AssetManager.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+AssetManager::AssetManager() {
+    auto placeholder = std::make_shared<sf::Texture>();
+    try {
+        sf::Image placeholderImage;
+        placeholderImage.resize(sf::Vector2u(4, 4), sf::Color::White);
+        if (!placeholder->loadFromImage(placeholderImage)) {
+            Utils::printMsg("Warning: Failed to create placeholder texture", warning);
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception creating placeholder texture - " + std::string(e.what()), error);
+    }
+    placeholderTexture = std::move(placeholder);
+}
+
+AssetManager::~AssetManager() {
+    StopReloads();
+    StopPreload();
+}
+
+bool AssetManager::OpenArchive(const std::string& path) {
+    if (archive.IsOpen()) {
+        return true;
+    }
+    StopReloads();
+    StopPreload();
+    if (!archive.Open(path)) {
+        Utils::printMsg("No asset archive at " + path + ", loading loose files", debug);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Entries are named by generic path (assetDirectory/name.png), which is how
+ * the client asks for them. The atlas is composed with the same packing as
+ * BuildAtlas, so the client only has to decode and upload it.
+ */
+bool AssetManager::PackArchive(const std::string& archivePath, const std::string& assetDirectory) {
+    namespace fs = std::filesystem;
+    std::vector<AssetArchive::PackedFile> files;
+    const auto packFile = [&files](const fs::path& path, const std::string& name) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        AssetArchive::PackedFile file;
+        file.name = name;
+        file.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        files.push_back(std::move(file));
+        return true;
+    };
+
+    try {
+        for (const fs::directory_entry& entry : fs::recursive_directory_iterator(assetDirectory)) {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (!entry.is_regular_file() ||
+                (extension != ".png" && extension != ".jpg" && extension != ".ttf" && extension != ".otf")) {
+                continue;
+            }
+            if (!packFile(entry.path(), entry.path().generic_string())) {
+                Utils::printMsg("Warning: Could not read " + entry.path().generic_string(), warning);
+            }
+        }
+    }
+    catch (const fs::filesystem_error& e) {
+        Utils::printMsg("Error: Could not scan " + assetDirectory + " - " + std::string(e.what()), error);
+        return false;
+    }
+    for (const std::string& fontPath : GetDefaultFontPaths()) {
+        if (packFile(fontPath, fontPath)) {
+            break;
+        }
+    }
+
+    // Pre-compose the atlas from the packed copies of the sprites
+    const std::vector<std::string>& spriteFiles = GetEntitySpriteFiles();
+    std::vector<sf::Image> sprites(spriteFiles.size());
+    for (size_t i = 0; i < spriteFiles.size(); ++i) {
+        auto packed = std::find_if(files.begin(), files.end(),
+            [&](const AssetArchive::PackedFile& file) { return file.name == spriteFiles[i]; });
+        if (packed == files.end() || !sprites[i].loadFromMemory(packed->data.data(), packed->data.size())) {
+            sprites[i] = sf::Image();
+        }
+    }
+    sf::Image atlas;
+    std::unordered_map<std::string, sf::IntRect> regions;
+    if (ComposeAtlas(spriteFiles, std::move(sprites), atlas, regions)) {
+        if (std::optional<std::vector<std::uint8_t>> png = atlas.saveToMemory("png")) {
+            files.push_back(AssetArchive::PackedFile{ AssetArchive::ATLAS_ENTRY, std::move(*png) });
+        }
+        else {
+            regions.clear();
+        }
+    }
+    if (regions.empty()) {
+        Utils::printMsg("Warning: Archive has no pre-composed atlas, clients will pack it at startup", warning);
+    }
+
+    if (!AssetArchive::Write(archivePath, files, regions)) {
+        return false;
+    }
+    Utils::printMsg("Packed " + std::to_string(files.size()) + " files into " + archivePath, success);
+    return true;
+}
+
+void AssetManager::SetResolution(sf::Vector2u windowSize, size_t budgetBytes) {
+    const float scale = std::min(static_cast<float>(windowSize.x) / REFERENCE_WINDOW_WIDTH,
+        static_cast<float>(windowSize.y) / REFERENCE_WINDOW_HEIGHT);
+    halfResolution = scale <= HALF_RESOLUTION_WINDOW_SCALE;
+    textureBudgetBytes = budgetBytes;
+    if (halfResolution) {
+        Utils::printMsg("Small window (" + std::to_string(windowSize.x) + "x" + std::to_string(windowSize.y) +
+            "), loading scalable textures at half resolution", debug);
+    }
+}
+
+float AssetManager::GetTextureScale(const std::string& filename) const {
+    auto it = textureCache.find(filename);
+    return it != textureCache.end() ? it->second.scale : 1.0f;
+}
+
+/**
+ * Returns the cached texture, loading it on first use. A failed load caches
+ * the placeholder under the filename so later requests neither hit the disk
+ * nor log again.
+ */
+std::shared_ptr<const sf::Texture> AssetManager::LoadTexture(const std::string& filename, bool critical,
+    bool repeated, bool scalable) {
+    auto it = textureCache.find(filename);
+    if (it != textureCache.end()) {
+        loadStats.cacheHits++;
+        it->second.lastUsedFrame = frameNumber;
+        return it->second.texture;
+    }
+
+    sf::Image image;
+    TextureEntry entry{ nullptr, true };
+    entry.lastUsedFrame = frameNumber;
+    if (DecodeImage(filename, image) && UploadTexture(image, repeated, scalable, entry)) {
+        Utils::printMsg("Loaded texture: " + filename + (entry.scale < 1.0f ? " (half resolution)" : ""), debug);
+        return textureCache.emplace(filename, std::move(entry)).first->second.texture;
+    }
+    return CacheFailedTexture(filename, critical);
+}
+
+/**
+ * A reload already queued is not queued again. Failures are cached like
+ * LoadTexture's, so a file that went missing resolves to the placeholder.
+ */
+std::shared_ptr<const sf::Texture> AssetManager::RequestTexture(const std::string& filename,
+    bool repeated, bool scalable) {
+    auto it = textureCache.find(filename);
+    if (it != textureCache.end()) {
+        loadStats.cacheHits++;
+        it->second.lastUsedFrame = frameNumber;
+        return it->second.texture;
+    }
+    if (!reloadsPending.insert(filename).second) {
+        return nullptr;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        if (!reloadWorker.joinable()) {
+            reloadStopping = false;
+            reloadWorker = std::thread(&AssetManager::RunReloadWorker, this);
+        }
+        reloadQueue.push_back(ReloadJob{ filename, repeated, scalable, sf::Image() });
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Warning: Could not start texture reload thread - " + std::string(e.what()), warning);
+        reloadsPending.erase(filename);
+        return LoadTexture(filename, false, repeated, scalable);
+    }
+    reloadWake.notify_one();
+    return nullptr;
+}
+
+void AssetManager::BeginFrame() {
+    frameNumber++;
+
+    std::vector<ReloadJob> decoded;
+    if (!reloadsPending.empty()) {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        const size_t count = std::min(reloadsDecoded.size(), PRELOAD_UPLOADS_PER_UPDATE);
+        decoded.assign(std::make_move_iterator(reloadsDecoded.begin()),
+            std::make_move_iterator(reloadsDecoded.begin() + count));
+        reloadsDecoded.erase(reloadsDecoded.begin(), reloadsDecoded.begin() + count);
+    }
+    for (ReloadJob& job : decoded) {
+        reloadsPending.erase(job.filename);
+        if (textureCache.count(job.filename) > 0) {
+            continue;   // Loaded by LoadTexture meanwhile
+        }
+        TextureEntry entry{ nullptr, true };
+        entry.lastUsedFrame = frameNumber;
+        if (UploadTexture(job.image, job.repeated, job.scalable, entry)) {
+            textureCache.emplace(job.filename, std::move(entry));
+            loadStats.texturesReloaded++;
+        }
+        else {
+            CacheFailedTexture(job.filename, false);
+        }
+    }
+
+    const size_t resident = GetResidentTextureBytes();
+    if (resident > textureBudgetBytes) {
+        EvictUnused(resident - textureBudgetBytes);
+    }
+}
+
+/**
+ * Oldest lastUsedFrame first. A texture used this frame may still be drawn,
+ * and one an entity holds would stay in memory anyway, so neither is a
+ * candidate; failed entries hold no memory of their own and stay cached.
+ */
+size_t AssetManager::EvictUnused(size_t neededBytes) {
+    std::vector<std::unordered_map<std::string, TextureEntry>::iterator> candidates;
+    for (auto it = textureCache.begin(); it != textureCache.end(); ++it) {
+        const TextureEntry& entry = it->second;
+        if (entry.loaded && entry.texture.use_count() == 1 && entry.lastUsedFrame < frameNumber) {
+            candidates.push_back(it);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a->second.lastUsedFrame < b->second.lastUsedFrame;
+    });
+
+    size_t freed = 0;
+    for (auto it : candidates) {
+        if (freed >= neededBytes) {
+            break;
+        }
+        freed += GetTextureBytes(*it->second.texture, it->second.mipmapped);
+        Utils::printMsg("Evicted texture: " + it->first + " (unused for " +
+            std::to_string(frameNumber - it->second.lastUsedFrame) + " frames)", debug);
+        textureCache.erase(it);
+        loadStats.texturesEvicted++;
+    }
+    return freed;
+}
+
+/**
+ * Mipmaps cost a third more memory and nothing when the texture is drawn at
+ * its own size; they keep a shrunk draw from skipping texels (aliasing) and
+ * from reading the whole image for a few pixels. A half-resolution variant is
+ * drawn twice its size, so it is smoothed.
+ */
+bool AssetManager::UploadTexture(const sf::Image& image, bool repeated, bool scalable, TextureEntry& out) {
+    try {
+        if (image.getSize().x == 0) {
+            return false;
+        }
+        // Unused textures make room first; half resolution is for when they cannot
+        const size_t fullBytes = static_cast<size_t>(image.getSize().x) * image.getSize().y * 4 * 4 / 3;
+        size_t resident = GetResidentTextureBytes();
+        if (resident + fullBytes > textureBudgetBytes) {
+            resident -= EvictUnused(resident + fullBytes - textureBudgetBytes);
+        }
+        const bool half = scalable && image.getSize().x >= 2 && image.getSize().y >= 2 &&
+            (halfResolution || resident + fullBytes > textureBudgetBytes);
+        auto texture = std::make_shared<sf::Texture>();
+        if (!texture->loadFromImage(half ? HalveImage(image) : image)) {
+            return false;
+        }
+        texture->setRepeated(repeated);
+        texture->setSmooth(half);
+        out.mipmapped = texture->generateMipmap();
+        out.scale = half ? 0.5f : 1.0f;
+        out.texture = std::move(texture);
+        loadStats.texturesLoaded++;
+        loadStats.mipmapsGenerated += out.mipmapped ? 1 : 0;
+        loadStats.halfResolutionTextures += half ? 1 : 0;
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception uploading texture - " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+/**
+ * Box filter: each pixel averages a 2x2 block (an odd last row or column is dropped)
+ */
+sf::Image AssetManager::HalveImage(const sf::Image& image) {
+    const sf::Vector2u size(image.getSize().x / 2, image.getSize().y / 2);
+    sf::Image half;
+    half.resize(size);
+    const std::uint8_t* source = image.getPixelsPtr();
+    const size_t stride = static_cast<size_t>(image.getSize().x) * 4;
+    for (unsigned int y = 0; y < size.y; ++y) {
+        for (unsigned int x = 0; x < size.x; ++x) {
+            const std::uint8_t* topLeft = source + (2 * y) * stride + (2 * x) * 4;
+            std::uint8_t channels[4];
+            for (size_t c = 0; c < 4; ++c) {
+                const unsigned int sum = topLeft[c] + topLeft[c + 4] + topLeft[stride + c] + topLeft[stride + c + 4];
+                channels[c] = static_cast<std::uint8_t>((sum + 2) / 4);
+            }
+            half.setPixel({ x, y }, sf::Color(channels[0], channels[1], channels[2], channels[3]));
+        }
+    }
+    return half;
+}
+
+size_t AssetManager::GetTextureBytes(const sf::Texture& texture, bool mipmapped) {
+    const sf::Vector2u size = texture.getSize();
+    const size_t bytes = static_cast<size_t>(size.x) * size.y * 4;
+    return sizeof(sf::Texture) + (mipmapped ? bytes * 4 / 3 : bytes);
+}
+
+size_t AssetManager::GetResidentTextureBytes() const {
+    size_t bytes = atlasTexture ? GetTextureBytes(*atlasTexture, false) : 0;
+    for (const auto& [filename, entry] : textureCache) {
+        if (entry.loaded) {
+            bytes += GetTextureBytes(*entry.texture, entry.mipmapped);
+        }
+    }
+    return bytes;
+}
+
+std::shared_ptr<const sf::Texture> AssetManager::CacheFailedTexture(const std::string& filename, bool critical) {
+    loadStats.texturesFailed++;
+    Utils::printMsg("Warning: Could not load texture " + filename + ", using placeholder",
+        critical ? error : warning);
+    textureCache.emplace(filename, TextureEntry{ placeholderTexture, false });
+    return placeholderTexture;
+}
+
+const std::vector<std::string>& AssetManager::GetEntitySpriteFiles() {
+    static const std::vector<std::string> files = {
+        "Assets/redTank.png", "Assets/redBarrel.png",
+        "Assets/blueTank.png", "Assets/blueBarrel.png",
+        "Assets/greenTank.png", "Assets/greenBarrel.png",
+        "Assets/blackTank.png", "Assets/blackBarrel.png",
+        "Assets/enemyRedTank.png", "Assets/enemyRedBarrel.png",
+        "Assets/enemyBlackTank.png", "Assets/enemyBlackBarrel.png",
+        "Assets/enemyPurpleTank.png", "Assets/enemyPurpleBarrel.png",
+        "Assets/enemyOrangeTank.png", "Assets/enemyOrangeBarrel.png",
+        "Assets/enemyTealTank.png", "Assets/enemyTealBarrel.png",
+        "Assets/playerBullet.png", "Assets/enemyBullet.png",
+        "Assets/tankShell.png", "Assets/tracerBullet.png",
+        "Assets/muzzleFlash.png", "Assets/explosionParticle.png"
+    };
+    return files;
+}
+
+/**
+ * Uses the archive's pre-composed atlas when it holds every file, otherwise
+ * decodes the files and packs them here.
+ */
+bool AssetManager::BuildAtlas(const std::vector<std::string>& filenames) {
+    if (HasPackedAtlas(filenames)) {
+        sf::Image atlas;
+        if (DecodeImage(AssetArchive::ATLAS_ENTRY, atlas) && UploadAtlas(atlas, archive.GetAtlasRegions())) {
+            return true;
+        }
+    }
+
+    std::vector<sf::Image> images(filenames.size());
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        DecodeImage(filenames[i], images[i]);
+    }
+    sf::Image atlas;
+    std::unordered_map<std::string, sf::IntRect> regions;
+    return ComposeAtlas(filenames, std::move(images), atlas, regions) && UploadAtlas(atlas, std::move(regions));
+}
+
+/**
+ * Tallest images first, placed left to right on shelves ATLAS_WIDTH wide;
+ * the atlas is as tall as the shelves need. Empty images (failed loads) are
+ * left out. CPU only, so the archive packer shares it.
+ */
+bool AssetManager::ComposeAtlas(std::vector<std::string> names, std::vector<sf::Image> images,
+    sf::Image& atlas, std::unordered_map<std::string, sf::IntRect>& regions) {
+    try {
+        // The files, plus a solid white block for untextured quads
+        names.push_back(SOLID_REGION_NAME);
+        images.emplace_back();
+        images.back().resize(sf::Vector2u(4, 4), sf::Color::White);
+
+        std::vector<size_t> order;
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (images[i].getSize().x > 0 && images[i].getSize().x + ATLAS_PADDING <= ATLAS_WIDTH) {
+                order.push_back(i);
+            }
+            else {
+                Utils::printMsg("Warning: Leaving " + names[i] + " out of the sprite atlas", warning);
+            }
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return images[a].getSize().y > images[b].getSize().y;
+        });
+
+        regions.clear();
+        unsigned int x = ATLAS_PADDING;
+        unsigned int y = ATLAS_PADDING;
+        unsigned int shelfHeight = 0;
+        for (size_t index : order) {
+            const sf::Vector2u size = images[index].getSize();
+            if (x + size.x + ATLAS_PADDING > ATLAS_WIDTH) {
+                x = ATLAS_PADDING;
+                y += shelfHeight + ATLAS_PADDING;
+                shelfHeight = 0;
+            }
+            regions[names[index]] = sf::IntRect({ static_cast<int>(x), static_cast<int>(y) },
+                { static_cast<int>(size.x), static_cast<int>(size.y) });
+            x += size.x + ATLAS_PADDING;
+            shelfHeight = std::max(shelfHeight, size.y);
+        }
+        const unsigned int height = y + shelfHeight + ATLAS_PADDING;
+        if (regions.size() < 2 || height > sf::Texture::getMaximumSize()) {
+            Utils::printMsg("Warning: Sprite atlas not built, entities use separate textures", warning);
+            return false;
+        }
+
+        atlas.resize(sf::Vector2u(ATLAS_WIDTH, height), sf::Color::Transparent);
+        for (size_t index : order) {
+            const sf::IntRect& region = regions[names[index]];
+            if (!atlas.copy(images[index], sf::Vector2u(region.position))) {
+                Utils::printMsg("Warning: Could not copy " + names[index] + " into the sprite atlas", warning);
+            }
+        }
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception building sprite atlas - " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+bool AssetManager::UploadAtlas(const sf::Image& atlas, std::unordered_map<std::string, sf::IntRect> regions) {
+    try {
+        auto texture = std::make_shared<sf::Texture>();
+        if (!texture->loadFromImage(atlas)) {
+            Utils::printMsg("Warning: Could not upload the sprite atlas", warning);
+            return false;
+        }
+        atlasTexture = std::move(texture);
+        atlasRegions = std::move(regions);
+        Utils::printMsg("Sprite atlas built: " + std::to_string(atlasRegions.size() - 1) + " images in " +
+            std::to_string(atlas.getSize().x) + "x" + std::to_string(atlas.getSize().y), debug);
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception uploading sprite atlas - " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+bool AssetManager::HasPackedAtlas(const std::vector<std::string>& filenames) const {
+    if (!archive.Find(AssetArchive::ATLAS_ENTRY)) {
+        return false;
+    }
+    const std::unordered_map<std::string, sf::IntRect>& regions = archive.GetAtlasRegions();
+    return regions.count(SOLID_REGION_NAME) > 0 &&
+        std::all_of(filenames.begin(), filenames.end(), [&](const std::string& name) { return regions.count(name) > 0; });
+}
+
+/**
+ * Decodes from the archive mapping when the file is packed, from disk otherwise.
+ * Safe on the preload workers: the archive is not reopened while they run.
+ * @return False (and an empty image) if decoding failed
+ */
+bool AssetManager::DecodeImage(const std::string& filename, sf::Image& image) const {
+    try {
+        const AssetArchive::Entry* entry = archive.Find(filename);
+        if (entry ? image.loadFromMemory(entry->data, entry->size) : image.loadFromFile(filename)) {
+            return true;
+        }
+    }
+    catch (const std::exception&) {
+        // Reported by the caller like any failed load
+    }
+    image = sf::Image();
+    return false;
+}
+
+/**
+ * Workers decode in file order; the render thread picks results up in
+ * UpdatePreload. Up to MAX_PRELOAD_WORKERS workers, leaving a hardware
+ * thread for the render thread.
+ */
+void AssetManager::BeginPreload(const std::vector<std::string>& atlasFiles,
+    const std::vector<TextureRequest>& textures) {
+    StopPreload();
+    if (atlasFiles.empty() && textures.empty()) {
+        return;
+    }
+
+    // A pre-composed atlas is one image to decode instead of one per sprite
+    const bool packedAtlas = !atlasFiles.empty() && HasPackedAtlas(atlasFiles);
+    const size_t atlasItems = packedAtlas ? 1 : atlasFiles.size();
+    preloadItems = std::vector<PreloadItem>(atlasItems + textures.size());
+    if (packedAtlas) {
+        preloadItems[0].filename = AssetArchive::ATLAS_ENTRY;
+        preloadItems[0].packedAtlas = true;
+    }
+    else {
+        for (size_t i = 0; i < atlasFiles.size(); ++i) {
+            preloadItems[i].filename = atlasFiles[i];
+            preloadItems[i].inAtlas = true;
+        }
+    }
+    for (size_t i = 0; i < textures.size(); ++i) {
+        PreloadItem& item = preloadItems[atlasItems + i];
+        item.filename = textures[i].filename;
+        item.repeated = textures[i].repeated;
+        item.scalable = textures[i].scalable;
+    }
+
+    nextPreloadItem = 0;
+    preloadStopping = false;
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    const size_t workerCount = std::min({ static_cast<size_t>(hardwareThreads > 1 ? hardwareThreads - 1 : 1),
+        MAX_PRELOAD_WORKERS, preloadItems.size() });
+    try {
+        for (size_t i = 0; i < workerCount; ++i) {
+            preloadWorkers.emplace_back(&AssetManager::RunPreloadWorker, this);
+        }
+    }
+    catch (const std::exception& e) {
+        // Whatever no worker claims is decoded by the render thread in UpdatePreload
+        Utils::printMsg("Warning: Could not start asset loader threads - " + std::string(e.what()), warning);
+    }
+    preloadClock.restart();
+    Utils::printMsg("Preloading " + std::to_string(preloadItems.size()) + " images on " +
+        std::to_string(preloadWorkers.size()) + " threads", debug);
+}
+
+void AssetManager::RunPreloadWorker() {
+    for (size_t i = nextPreloadItem.fetch_add(1); i < preloadItems.size() && !preloadStopping;
+        i = nextPreloadItem.fetch_add(1)) {
+        PreloadItem& item = preloadItems[i];
+        DecodeImage(item.filename, item.image);     // A failure is reported on upload
+        item.decoded.store(true, std::memory_order_release);
+    }
+}
+
+/**
+ * Standalone textures upload as soon as they are decoded; the atlas is packed
+ * once all its images are. If no worker could be started the render thread
+ * decodes everything itself on the first call.
+ */
+bool AssetManager::UpdatePreload() {
+    if (preloadItems.empty()) {
+        return true;
+    }
+    if (preloadWorkers.empty()) {
+        RunPreloadWorker();
+    }
+
+    size_t uploads = 0;
+    bool complete = true;
+    bool atlasPending = false;
+    bool atlasDecoded = true;
+    for (PreloadItem& item : preloadItems) {
+        if (item.uploaded) {
+            continue;
+        }
+        const bool decoded = item.decoded.load(std::memory_order_acquire);
+        if (item.inAtlas) {
+            atlasPending = true;
+            atlasDecoded = atlasDecoded && decoded;
+        }
+        else if (decoded && uploads < PRELOAD_UPLOADS_PER_UPDATE) {
+            UploadPreloaded(item);
+            uploads++;
+        }
+        else {
+            complete = false;
+        }
+    }
+    if (atlasPending) {
+        if (atlasDecoded && uploads < PRELOAD_UPLOADS_PER_UPDATE) {
+            PackPreloadedAtlas();
+        }
+        else {
+            complete = false;
+        }
+    }
+
+    if (complete) {
+        const size_t itemCount = preloadItems.size();
+        StopPreload();
+        Utils::printMsg("Preloaded " + std::to_string(itemCount) + " images in " +
+            std::to_string(preloadClock.getElapsedTime().asMilliseconds()) + " ms", debug);
+    }
+    return complete;
+}
+
+float AssetManager::GetPreloadProgress() const {
+    if (preloadItems.empty()) {
+        return 1.0f;
+    }
+    size_t steps = 0;
+    for (const PreloadItem& item : preloadItems) {
+        steps += item.decoded.load(std::memory_order_relaxed) ? 1 : 0;
+        steps += item.uploaded ? 1 : 0;
+    }
+    return static_cast<float>(steps) / static_cast<float>(preloadItems.size() * 2);
+}
+
+void AssetManager::UploadPreloaded(PreloadItem& item) {
+    item.uploaded = true;
+    if (item.packedAtlas) {
+        if (!UploadAtlas(item.image, archive.GetAtlasRegions())) {
+            Utils::printMsg("Warning: Packed sprite atlas unusable, entities use separate textures", warning);
+        }
+        item.image = sf::Image();
+        return;
+    }
+    if (textureCache.count(item.filename) > 0) {
+        return;     // Already loaded on demand
+    }
+
+    TextureEntry entry{ nullptr, true };
+    entry.lastUsedFrame = frameNumber;
+    if (UploadTexture(item.image, item.repeated, item.scalable, entry)) {
+        textureCache.emplace(item.filename, std::move(entry));
+        item.image = sf::Image();
+        return;
+    }
+    CacheFailedTexture(item.filename, false);
+}
+
+void AssetManager::PackPreloadedAtlas() {
+    std::vector<std::string> names;
+    std::vector<sf::Image> images;
+    for (PreloadItem& item : preloadItems) {
+        if (item.inAtlas) {
+            names.push_back(item.filename);
+            images.push_back(std::move(item.image));
+            item.uploaded = true;
+        }
+    }
+    sf::Image atlas;
+    std::unordered_map<std::string, sf::IntRect> regions;
+    if (ComposeAtlas(std::move(names), std::move(images), atlas, regions)) {
+        UploadAtlas(atlas, std::move(regions));
+    }
+}
+
+/**
+ * Stops and joins the workers (they finish the image in hand) and drops
+ * anything not yet uploaded.
+ */
+void AssetManager::StopPreload() {
+    preloadStopping = true;
+    for (std::thread& worker : preloadWorkers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    preloadWorkers.clear();
+    preloadItems.clear();
+}
+
+void AssetManager::RunReloadWorker() {
+    std::unique_lock<std::mutex> lock(reloadMutex);
+    while (true) {
+        reloadWake.wait(lock, [this] { return reloadStopping || !reloadQueue.empty(); });
+        if (reloadStopping) {
+            return;
+        }
+        ReloadJob job = std::move(reloadQueue.front());
+        reloadQueue.erase(reloadQueue.begin());
+        lock.unlock();
+        DecodeImage(job.filename, job.image);     // A failure is reported on upload
+        lock.lock();
+        reloadsDecoded.push_back(std::move(job));
+    }
+}
+
+/**
+ * Joins the reload worker (it finishes the image in hand) and drops every
+ * queued and decoded reload; RequestTexture queues them again.
+ */
+void AssetManager::StopReloads() {
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        reloadStopping = true;
+        reloadQueue.clear();
+    }
+    reloadWake.notify_one();
+    if (reloadWorker.joinable()) {
+        reloadWorker.join();
+    }
+    reloadsDecoded.clear();
+    reloadsPending.clear();
+}
+
+AssetManager::SpriteRegion AssetManager::LoadSprite(const std::string& filename, bool critical) {
+    auto it = atlasRegions.find(filename);
+    if (atlasTexture && it != atlasRegions.end()) {
+        loadStats.cacheHits++;
+        return SpriteRegion{ atlasTexture, it->second };
+    }
+    std::shared_ptr<const sf::Texture> texture = LoadTexture(filename, critical);
+    const sf::Vector2u size = texture->getSize();
+    return SpriteRegion{ texture, sf::IntRect({ 0, 0 }, { static_cast<int>(size.x), static_cast<int>(size.y) }) };
+}
+
+AssetManager::SpriteRegion AssetManager::GetSolidRegion() const {
+    auto it = atlasRegions.find(SOLID_REGION_NAME);
+    if (atlasTexture && it != atlasRegions.end()) {
+        return SpriteRegion{ atlasTexture, it->second };
+    }
+    const sf::Vector2u size = placeholderTexture->getSize();
+    return SpriteRegion{ placeholderTexture, sf::IntRect({ 0, 0 }, { static_cast<int>(size.x), static_cast<int>(size.y) }) };
+}
+
+std::shared_ptr<const sf::Font> AssetManager::LoadFont(const std::string& filename) {
+    auto it = fontCache.find(filename);
+    if (it != fontCache.end()) {
+        loadStats.cacheHits++;
+        return it->second;
+    }
+
+    auto font = std::make_shared<sf::Font>();
+    if (TryLoadFont(filename, *font)) {
+        loadStats.fontsLoaded++;
+        Utils::printMsg("Loaded font: " + filename, debug);
+        return fontCache.emplace(filename, std::move(font)).first->second;
+    }
+    loadStats.fontsFailed++;
+    fontCache.emplace(filename, nullptr);
+    return nullptr;
+}
+
+std::shared_ptr<const sf::Font> AssetManager::LoadFontWithFallbacks(const std::vector<std::string>& fontPaths) {
+    for (const std::string& path : fontPaths) {
+        if (std::shared_ptr<const sf::Font> font = LoadFont(path)) {
+            return font;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const sf::Font> AssetManager::LoadDefaultFont() {
+    return LoadFontWithFallbacks(GetDefaultFontPaths());
+}
+
+const std::vector<std::string>& AssetManager::GetDefaultFontPaths() {
+    static const std::vector<std::string> defaultFontPaths = {
+        "C:/Windows/Fonts/arial.ttf",
+        "C:/Windows/Fonts/calibri.ttf",
+        "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf"
+    };
+    return defaultFontPaths;
+}
+
+void AssetManager::PrewarmGlyphs(const sf::Font& font, unsigned int characterSize, float outlineThickness) {
+    for (char32_t codePoint = U' '; codePoint <= U'~'; ++codePoint) {
+        (void)font.getGlyph(codePoint, characterSize, false);
+        if (outlineThickness != 0.0f) {
+            (void)font.getGlyph(codePoint, characterSize, false, outlineThickness);
+        }
+    }
+}
+
+bool AssetManager::IsTextureLoaded(const std::string& filename) const {
+    auto it = textureCache.find(filename);
+    return it != textureCache.end() && it->second.loaded;
+}
+
+/**
+ * Loaded assets referenced only by the cache are dropped; failed entries
+ * stay so missing files are still not retried.
+ */
+size_t AssetManager::ReleaseUnused() {
+    size_t released = 0;
+    for (auto it = textureCache.begin(); it != textureCache.end(); ) {
+        if (it->second.loaded && it->second.texture.use_count() == 1) {
+            it = textureCache.erase(it);
+            released++;
+        }
+        else {
+            ++it;
+        }
+    }
+    for (auto it = fontCache.begin(); it != fontCache.end(); ) {
+        if (it->second && it->second.use_count() == 1) {
+            it = fontCache.erase(it);
+            released++;
+        }
+        else {
+            ++it;
+        }
+    }
+    return released;
+}
+
+/**
+ * Each distinct texture counts once (failed loads share the placeholder), at
+ * 4 bytes per pixel and a third more with mipmaps, with the atlas and the
+ * placeholder included. Duplicates are cached textures whose image is already
+ * resident: a file that is also packed in the atlas, or a second entry for
+ * one file under a differently spelled path. They are included in the texture totals as well. Fonts are
+ * counted without their glyph pages, which SFML does not expose.
+ */
+void AssetManager::ReportMemory(MemoryReport& report) const {
+    const auto normalize = [](std::string path) {
+        std::replace(path.begin(), path.end(), '\\', '/');
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    };
+    std::unordered_set<const sf::Texture*> counted;
+    size_t textureCount = 0;
+    size_t totalTextureBytes = MemoryReport::MapBytes(textureCache) + MemoryReport::MapBytes(atlasRegions);
+    const auto addTexture = [&](const sf::Texture* texture, bool mipmapped) {
+        if (texture && counted.insert(texture).second) {
+            ++textureCount;
+            totalTextureBytes += GetTextureBytes(*texture, mipmapped);
+        }
+    };
+    addTexture(placeholderTexture.get(), false);
+    addTexture(atlasTexture.get(), false);
+
+    std::unordered_set<std::string> residentFiles;
+    for (const auto& [filename, region] : atlasRegions) {
+        residentFiles.insert(normalize(filename));
+    }
+    size_t duplicateCount = 0;
+    size_t duplicateBytes = 0;
+    for (const auto& [filename, entry] : textureCache) {
+        addTexture(entry.texture.get(), entry.mipmapped);
+        if (entry.loaded && !residentFiles.insert(normalize(filename)).second) {
+            ++duplicateCount;
+            duplicateBytes += GetTextureBytes(*entry.texture, entry.mipmapped);
+        }
+    }
+    report.Add("textures", textureCount, totalTextureBytes);
+    report.Add("duplicate textures", duplicateCount, duplicateBytes);
+
+    size_t fontCount = 0;
+    for (const auto& [filename, font] : fontCache) {
+        fontCount += font ? 1 : 0;
+    }
+    report.Add("fonts", fontCount, MemoryReport::MapBytes(fontCache) + fontCount * sizeof(sf::Font));
+}
+
+void AssetManager::Clear() {
+    StopReloads();
+    StopPreload();
+    textureCache.clear();
+    fontCache.clear();
+    atlasTexture.reset();
+    atlasRegions.clear();
+}
+
+bool AssetManager::TryLoadFont(const std::string& filename, sf::Font& font) {
+    try {
+        // The mapping outlives every font: the archive is only closed with the AssetManager
+        if (const AssetArchive::Entry* entry = archive.Find(filename)) {
+            return font.openFromMemory(entry->data, entry->size);
+        }
+        return font.openFromFile(filename);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception loading font " + filename + " - " + std::string(e.what()), error);
+        return false;
+    }
+}
@@ -1,19 +1,44 @@
 #pragma once
-#pragma once
 #include <SFML/Graphics.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
-#include <memory>
+#include <unordered_set>
+#include <vector>
+#include "asset_archive.h"
+#include "memory_report.h"
 #include "utils.h"
 
 /**
- * AssetManager - Centralized asset loading with error handling and fallback support
+ * AssetManager - Shared, reference-counted texture and font cache
  *
  * Features:
+ * - Each file is decoded (and each texture uploaded) once; every entity
+ *   holding it shares the same shared_ptr
  * - Try-catch protection for all file I/O operations
- * - Automatic fallback texture generation when assets fail to load
- * - Asset caching to prevent duplicate loading
- * - Graceful degradation for non-critical assets
+ * - Failed textures resolve to a shared placeholder, and failures are cached
+ *   too, so a missing file is not retried on every spawn
+ * - ReleaseUnused drops assets no entity holds any more
+ * - Entity sprites are packed into one atlas texture at startup, so drawing
+ *   tanks, enemies and bullets never switches textures
+ * - Preloading decodes images on worker threads while the render thread
+ *   uploads a few per frame, so a loading screen stays responsive
+ * - With a packed archive open, files are decoded from its memory mapping
+ *   and the atlas comes pre-composed
+ * - Standalone textures get mipmaps, so anything drawing them shrunk (the
+ *   minimap bake) samples a matching level instead of the full image
+ * - Textures loaded as scalable are uploaded at half resolution in small
+ *   windows or past the texture budget (see SetResolution)
+ * - Standalone textures track the frame they were last used in; past the
+ *   budget the least recently used ones nothing else holds are evicted, and
+ *   RequestTexture reloads them in the background when they are needed again
+ *
+ * Client only. Apart from the preload and reload workers, which only decode
+ * into their own images, used from the main (render) thread only.
  */
 class AssetManager {
 public:
@@ -26,27 +51,186 @@ public:
     AssetManager(const AssetManager&) = delete;
     AssetManager& operator=(const AssetManager&) = delete;
 
+    static constexpr const char* DEFAULT_ARCHIVE_PATH = "Assets.pak";
+    static constexpr unsigned int REFERENCE_WINDOW_WIDTH = 1280;
+    static constexpr unsigned int REFERENCE_WINDOW_HEIGHT = 960;
+    static constexpr float HALF_RESOLUTION_WINDOW_SCALE = 0.6f;   // Of the reference size, see SetResolution
+    static constexpr size_t DEFAULT_TEXTURE_BUDGET_BYTES = 64 * 1024 * 1024;
+
+    /**
+     * Choose the resolution of scalable textures: half resolution when the
+     * window is at most HALF_RESOLUTION_WINDOW_SCALE of the reference size
+     * on either axis, and otherwise for each scalable texture that would
+     * take the resident textures (mipmaps included) past the budget. Call
+     * before loading; textures already resident keep their resolution.
+     * @param windowSize - Size of the window the game renders to
+     * @param textureBudgetBytes - Texture memory to stay within
+     */
+    void SetResolution(sf::Vector2u windowSize, size_t textureBudgetBytes = DEFAULT_TEXTURE_BUDGET_BYTES);
+
+    /**
+     * Resolution a texture was uploaded at, relative to its file; scale a
+     * sprite by the inverse to draw it at its original size
+     * @return 0.5 for a half-resolution variant, otherwise 1
+     */
+    float GetTextureScale(const std::string& filename) const;
+
+    /**
+     * Map a packed asset archive (see PackArchive); later loads of any file it
+     * holds decode from memory instead of opening the file. Call before
+     * loading anything; the archive stays mapped for the program's lifetime,
+     * so further calls are ignored.
+     * @param path - Archive file
+     * @return true if an archive is open
+     */
+    bool OpenArchive(const std::string& path);
+
+    /**
+     * Build step: pack every image and font under assetDirectory, the first
+     * default font found, and the entity sprite atlas composed from them
+     * @param archivePath - Archive to write (overwritten)
+     * @param assetDirectory - Directory scanned recursively; entries are named as the client loads them
+     * @return true if the archive was written
+     */
+    static bool PackArchive(const std::string& archivePath, const std::string& assetDirectory);
+
     /**
      * Load texture with error handling and fallback
      * @param filename - Path to texture file
-     * @param critical - If true, logs error but continues. If false, just warning
-     * @return Reference to loaded or fallback texture (never nullptr)
+     * @param critical - If true, a failure is logged as an error, otherwise as a warning
+     * @param repeated - Tile the texture when a sprite's rect is larger than it (first load only)
+     * @param scalable - The caller draws it through GetTextureScale, so it may be uploaded at half resolution
+     * @return Shared texture, or the shared placeholder if loading failed (never nullptr)
      */
-    const sf::Texture& LoadTexture(const std::string& filename, bool critical = true);
+    std::shared_ptr<const sf::Texture> LoadTexture(const std::string& filename, bool critical = true,
+        bool repeated = false, bool scalable = false);
 
     /**
-     * Load font with error handling and fallback
+     * Non-blocking LoadTexture for textures that may have been evicted: a
+     * resident texture is returned, anything else is decoded on a background
+     * thread and uploaded by a later BeginFrame
+     * @param filename - Path to texture file
+     * @param repeated - As for LoadTexture
+     * @param scalable - As for LoadTexture
+     * @return Shared texture, the placeholder if loading failed, or nullptr while it is being loaded
+     */
+    std::shared_ptr<const sf::Texture> RequestTexture(const std::string& filename,
+        bool repeated = false, bool scalable = false);
+
+    /**
+     * Start a frame: uploads textures RequestTexture reloaded (at most
+     * PRELOAD_UPLOADS_PER_UPDATE), then evicts textures unused since an
+     * earlier frame, least recently used first, while the resident textures
+     * are past the budget. Only textures nothing but the cache holds are
+     * evicted. Call once per frame on the render thread.
+     */
+    void BeginFrame();
+
+    /**
+     * A standalone texture to preload, with the settings LoadTexture would give it
+     */
+    struct TextureRequest {
+        std::string filename;
+        bool repeated;
+        bool scalable = false;
+    };
+
+    /**
+     * Start decoding images on worker threads. atlasFiles become the sprite
+     * atlas (replacing any previous one), textures become cached textures;
+     * both are uploaded by UpdatePreload. Replaces a preload still running.
+     * @param atlasFiles - Images to pack, as for BuildAtlas
+     * @param textures - Standalone textures, as for LoadTexture
+     */
+    void BeginPreload(const std::vector<std::string>& atlasFiles, const std::vector<TextureRequest>& textures);
+
+    /**
+     * Upload decoded images, at most PRELOAD_UPLOADS_PER_UPDATE textures per
+     * call (the packed atlas counts as one). Call once per frame on the render thread.
+     * @return true once every preloaded asset is resident (also when nothing is preloading)
+     */
+    bool UpdatePreload();
+
+    /**
+     * Fraction of the preload done, decoding and uploading weighted equally
+     * @return 0 to 1 (1 when nothing is preloading)
+     */
+    float GetPreloadProgress() const;
+
+    /**
+     * A texture and the part of it holding one image
+     */
+    struct SpriteRegion {
+        std::shared_ptr<const sf::Texture> texture;
+        sf::IntRect rect;
+    };
+
+    /**
+     * Packs images into one atlas texture (shelf packing, ATLAS_PADDING
+     * transparent pixels between images); files that fail to load are left out
+     * and later fall back to LoadTexture. Replaces any previous atlas.
+     * @param filenames - Image files to pack
+     * @return true if the atlas texture was created
+     */
+    bool BuildAtlas(const std::vector<std::string>& filenames);
+
+    /**
+     * Every tank, barrel, enemy, bullet, muzzle flash and particle image in Assets/
+     */
+    static const std::vector<std::string>& GetEntitySpriteFiles();
+
+    /**
+     * Region of the atlas holding the file, or the file's own texture (whole
+     * rect) when it is not in the atlas
+     * @param filename - Path to the image file
+     * @param critical - As for LoadTexture
+     */
+    SpriteRegion LoadSprite(const std::string& filename, bool critical = true);
+
+    /**
+     * Solid white pixels for untextured quads (health bars): a block inside
+     * the atlas when it is built, otherwise the placeholder texture
+     */
+    SpriteRegion GetSolidRegion() const;
+
+    bool IsAtlasBuilt() const { return atlasTexture != nullptr; }
+    sf::Vector2u GetAtlasSize() const { return atlasTexture ? atlasTexture->getSize() : sf::Vector2u(); }
+
+    /**
+     * Load font with error handling
      * @param filename - Path to font file
-     * @return Pointer to loaded font (nullptr if failed and font is optional)
+     * @return Shared font (nullptr if the file could not be opened)
      */
-    const sf::Font* LoadFont(const std::string& filename);
+    std::shared_ptr<const sf::Font> LoadFont(const std::string& filename);
 
     /**
      * Try multiple font paths and return first successful load
      * @param fontPaths - Vector of font file paths to try
-     * @return Pointer to loaded font (nullptr if all failed)
+     * @return Shared font (nullptr if all failed)
+     */
+    std::shared_ptr<const sf::Font> LoadFontWithFallbacks(const std::vector<std::string>& fontPaths);
+
+    /**
+     * The UI font: Arial, then Calibri, then Liberation Sans
+     * @return Shared font (nullptr if none is installed)
+     */
+    std::shared_ptr<const sf::Font> LoadDefaultFont();
+    static const std::vector<std::string>& GetDefaultFontPaths();
+
+    /**
+     * Rasterize printable ASCII into the font's glyph page for one size, with
+     * and without the outline, so the first frame showing new text does not
+     * stall on glyph rendering and texture uploads
+     * @param font - Font to warm
+     * @param characterSize - Size the text is drawn at
+     * @param outlineThickness - Outline the text is drawn with (0 for none)
+     */
+    static void PrewarmGlyphs(const sf::Font& font, unsigned int characterSize, float outlineThickness = 0.0f);
+
+    /**
+     * 4x4 white texture that sprites are constructed with before their real texture is set
      */
-    const sf::Font* LoadFontWithFallbacks(const std::vector<std::string>& fontPaths);
+    const sf::Texture& GetPlaceholderTexture() const { return *placeholderTexture; }
 
     /**
      * Check if a texture was successfully loaded (not a fallback)
@@ -59,44 +243,130 @@ public:
      * Check if any font was successfully loaded
      * @return true if at least one font is available
      */
-    bool IsFontAvailable() const { return defaultFont != nullptr; }
+    bool IsFontAvailable() const { return loadStats.fontsLoaded > 0; }
 
     /**
      * Get statistics about asset loading
      */
     struct LoadStats {
-        size_t texturesLoaded;
-        size_t texturesFailed;
-        size_t fontsLoaded;
-        size_t fontsFailed;
+        size_t texturesLoaded = 0;
+        size_t texturesFailed = 0;
+        size_t fontsLoaded = 0;
+        size_t fontsFailed = 0;
+        size_t cacheHits = 0;
+        size_t mipmapsGenerated = 0;
+        size_t halfResolutionTextures = 0;
+        size_t texturesEvicted = 0;
+        size_t texturesReloaded = 0;
     };
     LoadStats GetLoadStats() const { return loadStats; }
+    size_t GetCachedTextureCount() const { return textureCache.size(); }
 
     /**
-     * Clear all cached assets (for cleanup)
+     * Add textures, duplicate textures and fonts to a memory report
+     */
+    void ReportMemory(MemoryReport& report) const;
+
+    /**
+     * Drop cached assets that only the cache still references
+     * @return Number of assets released
+     */
+    size_t ReleaseUnused();
+
+    /**
+     * Clear all cached assets (entities keep the ones they hold alive)
      */
     void Clear();
 
 private:
+    static constexpr size_t PRELOAD_UPLOADS_PER_UPDATE = 4;
+    static constexpr size_t MAX_PRELOAD_WORKERS = 4;
+    static constexpr unsigned int ATLAS_WIDTH = 512;
+    static constexpr unsigned int ATLAS_PADDING = 2;     // Keeps filtered edges from bleeding
+    static constexpr const char* SOLID_REGION_NAME = "<solid>";
+
     AssetManager();
-    ~AssetManager() = default;
+    ~AssetManager();
+
+    struct TextureEntry {
+        std::shared_ptr<const sf::Texture> texture;
+        bool loaded;            // False when texture is the placeholder
+        bool mipmapped = false;
+        float scale = 1.0f;     // Of the file's resolution
+        uint64_t lastUsedFrame = 0;     // See BeginFrame
+    };
+
+    // Declared before the caches: fonts read from the mapping until they are destroyed
+    AssetArchive archive;
 
-    // Asset caches
-    std::unordered_map<std::string, std::unique_ptr<sf::Texture>> textureCache;
-    std::unordered_map<std::string, bool> textureLoadSuccess; // Track if actual file loaded
-    std::unique_ptr<sf::Font> defaultFont;
+    // Asset caches, keyed by path. A failed font is cached as nullptr.
+    std::unordered_map<std::string, TextureEntry> textureCache;
+    std::unordered_map<std::string, std::shared_ptr<const sf::Font>> fontCache;
+    std::shared_ptr<const sf::Texture> placeholderTexture;
+    std::shared_ptr<const sf::Texture> atlasTexture;
+    std::unordered_map<std::string, sf::IntRect> atlasRegions;
 
-    // Fallback assets
-    std::unique_ptr<sf::Texture> fallbackTexture;
-    std::unique_ptr<sf::Texture> fallbackTransparentTexture;
+    // Preload: workers claim items by index and publish each with decoded;
+    // the render thread owns everything else
+    struct PreloadItem {
+        std::string filename;
+        bool inAtlas = false;
+        bool packedAtlas = false;           // The archive's pre-composed atlas
+        bool repeated = false;
+        bool scalable = false;
+        sf::Image image;                    // Empty if decoding failed
+        std::atomic<bool> decoded{ false };
+        bool uploaded = false;              // Cached, or packed into the atlas
+    };
+    std::vector<PreloadItem> preloadItems;
+    std::vector<std::thread> preloadWorkers;
+    std::atomic<size_t> nextPreloadItem{ 0 };
+    std::atomic<bool> preloadStopping{ false };
+    sf::Clock preloadClock;
+
+    // Resolution choice (see SetResolution)
+    bool halfResolution = false;
+    size_t textureBudgetBytes = DEFAULT_TEXTURE_BUDGET_BYTES;
+
+    // Residency: the frame number BeginFrame counts, and the reload worker.
+    // The worker only takes jobs from reloadQueue and hands back decoded ones.
+    struct ReloadJob {
+        std::string filename;
+        bool repeated = false;
+        bool scalable = false;
+        sf::Image image;                    // Empty if decoding failed
+    };
+    uint64_t frameNumber = 0;
+    std::thread reloadWorker;
+    std::mutex reloadMutex;
+    std::condition_variable reloadWake;
+    std::vector<ReloadJob> reloadQueue;
+    std::vector<ReloadJob> reloadsDecoded;
+    bool reloadStopping = false;
+    std::unordered_set<std::string> reloadsPending;    // Render thread only
 
     // Statistics
     LoadStats loadStats;
 
     // Helper methods
-    void CreateFallbackTextures();
-    sf::Texture* CreateFallbackTexture(sf::Color color, sf::Vector2u size);
-    sf::Texture* CreatePatternTexture(sf::Vector2u size, sf::Color color1, sf::Color color2);
-    bool TryLoadTexture(const std::string& filename, sf::Texture& texture);
+    // Uploads with mipmaps, at half resolution if scalable and SetResolution calls for it
+    bool UploadTexture(const sf::Image& image, bool repeated, bool scalable, TextureEntry& out);
+    // @return Bytes freed
+    size_t EvictUnused(size_t neededBytes);
+    size_t GetResidentTextureBytes() const;
+    static size_t GetTextureBytes(const sf::Texture& texture, bool mipmapped);
+    static sf::Image HalveImage(const sf::Image& image);
     bool TryLoadFont(const std::string& filename, sf::Font& font);
-};
\ No newline at end of file
+    std::shared_ptr<const sf::Texture> CacheFailedTexture(const std::string& filename, bool critical);
+    static bool ComposeAtlas(std::vector<std::string> names, std::vector<sf::Image> images,
+        sf::Image& atlas, std::unordered_map<std::string, sf::IntRect>& regions);
+    bool UploadAtlas(const sf::Image& atlas, std::unordered_map<std::string, sf::IntRect> regions);
+    bool HasPackedAtlas(const std::vector<std::string>& filenames) const;
+    bool DecodeImage(const std::string& filename, sf::Image& image) const;
+    void RunPreloadWorker();
+    void UploadPreloaded(PreloadItem& item);
+    void PackPreloadedAtlas();
+    void StopPreload();
+    void RunReloadWorker();
+    void StopReloads();
+};
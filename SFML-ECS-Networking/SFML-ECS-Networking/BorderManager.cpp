@@ -6,6 +6,12 @@
 #include <cmath>
 #include <limits>
 
+namespace {
+    const char* const HORIZONTAL_WIRE_FILE = "Assets/barbed_wire_horizontal.png";
+    const char* const VERTICAL_WIRE_FILE = "Assets/barbed_wire_vertical.png";
+    const char* const CORNER_POST_FILE = "Assets/border_corner_post.png";
+}
+
 /**
  * Constructor for BorderManager.
  * Initializes border thickness and world bounds using constants.
@@ -75,43 +81,38 @@ bool BorderManager::Initialize(float worldWidth, float worldHeight, float border
     return true;
 }
 
+const std::vector<AssetManager::TextureRequest>& BorderManager::GetTextureRequests() {
+    static const std::vector<AssetManager::TextureRequest> requests = {
+        { HORIZONTAL_WIRE_FILE, true },
+        { VERTICAL_WIRE_FILE, true },
+        { CORNER_POST_FILE, false }
+    };
+    return requests;
+}
+
 /**
- * Loads border textures from files.
+ * Takes the border textures from the AssetManager (already resident after a
+ * preload, loaded from file otherwise).
  * Continues even if some textures fail to load (graceful degradation).
  * @return True if all textures loaded, false if any failed
  */
 bool BorderManager::LoadTextures() {
+    AssetManager& assets = AssetManager::Instance();
     bool allLoaded = true;
+    const auto load = [&](const AssetManager::TextureRequest& request) -> std::shared_ptr<const sf::Texture> {
+        std::shared_ptr<const sf::Texture> texture = assets.LoadTexture(request.filename, false, request.repeated);
+        if (!assets.IsTextureLoaded(request.filename)) {
+            allLoaded = false;
+            return nullptr;
+        }
+        Utils::printMsg("✓ Loaded " + request.filename);
+        return texture;
+    };
 
-    // Load horizontal barbed wire texture
-    if (!horizontalWireTexture.loadFromFile("Assets/barbed_wire_horizontal.png")) {
-        Utils::printMsg("Warning: Could not load barbed_wire_horizontal.png", warning);
-        allLoaded = false;
-    }
-    else {
-        horizontalWireTexture.setRepeated(true);
-        Utils::printMsg("✓ Loaded horizontal barbed wire texture");
-    }
-
-    // Load vertical barbed wire texture
-    if (!verticalWireTexture.loadFromFile("Assets/barbed_wire_vertical.png")) {
-        Utils::printMsg("Warning: Could not load barbed_wire_vertical.png", warning);
-        allLoaded = false;
-    }
-    else {
-        verticalWireTexture.setRepeated(true);
-        Utils::printMsg("✓ Loaded vertical barbed wire texture");
-    }
-
-    // Load corner post texture
-    if (!cornerPostTexture.loadFromFile("Assets/border_corner_post.png")) {
-        Utils::printMsg("Warning: Could not load border_corner_post.png", warning);
-        allLoaded = false;
-    }
-    else {
-        Utils::printMsg("✓ Loaded corner post texture");
-    }
-
+    const std::vector<AssetManager::TextureRequest>& requests = GetTextureRequests();
+    horizontalWireTexture = load(requests[0]);
+    verticalWireTexture = load(requests[1]);
+    cornerPostTexture = load(requests[2]);
     return allLoaded;
 }
 
@@ -149,21 +150,21 @@ void BorderManager::CreateBorderSprites() {
  * @param isTop True if top border, false if bottom
  */
 void BorderManager::CreateHorizontalBorder(float y, bool isTop) {
-    if (horizontalWireTexture.getSize().x == 0) return; // Texture not loaded - skip silently like original
+    if (!horizontalWireTexture) return; // Texture not loaded - skip silently like original
 
     float totalWidth = worldBounds.size.x + 2 * borderThickness;
-    float textureWidth = static_cast<float>(horizontalWireTexture.getSize().x);
+    float textureWidth = static_cast<float>(horizontalWireTexture->getSize().x);
     int numTiles = static_cast<int>(std::ceil(totalWidth / textureWidth));
 
     for (int i = 0; i < numTiles; ++i) {
-        sf::Sprite borderSprite(horizontalWireTexture);
+        sf::Sprite borderSprite(*horizontalWireTexture);
         float x = i * textureWidth;
         borderSprite.setPosition(sf::Vector2f(x, y));
 
         // Set texture rectangle to repeat the pattern - SFML 3.0 syntax
         sf::IntRect textureRect(sf::Vector2i(0, 0),
             sf::Vector2i(static_cast<int>(textureWidth),
-                static_cast<int>(horizontalWireTexture.getSize().y)));
+                static_cast<int>(horizontalWireTexture->getSize().y)));
         if (x + textureWidth > totalWidth) {
             // Adjust last tile to fit exactly
             textureRect.size.x = static_cast<int>(totalWidth - x);
@@ -179,20 +180,20 @@ void BorderManager::CreateHorizontalBorder(float y, bool isTop) {
  * @param isLeft True if left border, false if right
  */
 void BorderManager::CreateVerticalBorder(float x, bool isLeft) {
-    if (verticalWireTexture.getSize().y == 0) return; // Texture not loaded - skip silently like original
+    if (!verticalWireTexture) return; // Texture not loaded - skip silently like original
 
     float totalHeight = worldBounds.size.y + 2 * borderThickness;
-    float textureHeight = static_cast<float>(verticalWireTexture.getSize().y);
+    float textureHeight = static_cast<float>(verticalWireTexture->getSize().y);
     int numTiles = static_cast<int>(std::ceil(totalHeight / textureHeight));
 
     for (int i = 0; i < numTiles; ++i) {
-        sf::Sprite borderSprite(verticalWireTexture);
+        sf::Sprite borderSprite(*verticalWireTexture);
         float y = i * textureHeight;
         borderSprite.setPosition(sf::Vector2f(x, y));
 
         // Set texture rectangle to repeat the single wire pattern - SFML 3.0 syntax
         sf::IntRect textureRect(sf::Vector2i(0, 0),
-            sf::Vector2i(static_cast<int>(verticalWireTexture.getSize().x),
+            sf::Vector2i(static_cast<int>(verticalWireTexture->getSize().x),
                 static_cast<int>(textureHeight)));
         if (y + textureHeight > totalHeight) {
             // Adjust last tile to fit exactly
@@ -207,7 +208,7 @@ void BorderManager::CreateVerticalBorder(float x, bool isLeft) {
  * Creates corner posts at the four corners of the world bounds.
  */
 void BorderManager::CreateCornerPosts() {
-    if (cornerPostTexture.getSize().x == 0) return; // Texture not loaded - skip silently like original
+    if (!cornerPostTexture) return; // Texture not loaded - skip silently like original
 
     float postOffset = borderThickness / 2;
 
@@ -221,7 +222,7 @@ void BorderManager::CreateCornerPosts() {
     };
 
     for (const auto& pos : cornerPositions) {
-        sf::Sprite cornerSprite(cornerPostTexture);
+        sf::Sprite cornerSprite(*cornerPostTexture);
         cornerSprite.setPosition(pos);
         cornerPosts.push_back(cornerSprite);
     }
@@ -237,19 +238,26 @@ void BorderManager::Render(sf::RenderWindow& window) {
         Utils::printMsg("Error: Render window is not open", error);
         return;
     }
+    Draw(window);
+}
 
+/**
+ * Draws all border elements to the target.
+ * @param target Window or render texture to draw into
+ */
+void BorderManager::Draw(sf::RenderTarget& target) const {
     // Draw all border elements in order (back to front) - EXACTLY like original
     // Draw horizontal borders
     for (const auto& border : horizontalBorders) {
-        window.draw(border);
+        target.draw(border);
     }
     // Draw vertical borders
     for (const auto& border : verticalBorders) {
-        window.draw(border);
+        target.draw(border);
     }
     // Draw corner posts (on top of wire)
     for (const auto& post : cornerPosts) {
-        window.draw(post);
+        target.draw(post);
     }
 }
 
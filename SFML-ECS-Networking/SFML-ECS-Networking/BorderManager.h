@@ -2,6 +2,7 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <memory>
+#include "AssetManager.h"
 
 /**
  * BorderManager handles rendering and collision detection for game world borders.
@@ -21,6 +22,9 @@ public:
     // Validates window before rendering
     void Render(sf::RenderWindow& window);
 
+    // Draw all border elements to any target (e.g. when prebaking the static layer)
+    void Draw(sf::RenderTarget& target) const;
+
     // Check if a position is within bounds, considering entity radius
     // Returns false if position or radius is invalid
     bool IsPositionInBounds(sf::Vector2f position, float entityRadius = 20.0f) const;
@@ -32,11 +36,14 @@ public:
     // Get world bounds
     sf::FloatRect GetWorldBounds() const { return worldBounds; }
 
+    // Border textures, for the AssetManager preload
+    static const std::vector<AssetManager::TextureRequest>& GetTextureRequests();
+
 private:
-    // Border textures
-    sf::Texture horizontalWireTexture;
-    sf::Texture verticalWireTexture;
-    sf::Texture cornerPostTexture;
+    // Border textures, shared through the AssetManager (nullptr if not loaded)
+    std::shared_ptr<const sf::Texture> horizontalWireTexture;
+    std::shared_ptr<const sf::Texture> verticalWireTexture;
+    std::shared_ptr<const sf::Texture> cornerPostTexture;
 
     // Border sprites
     std::vector<sf::Sprite> horizontalBorders; // Top and bottom borders
@@ -1,5 +1,8 @@
 ﻿#include "Bullet.h"
 #include "utils.h"
+#include "bullet_stats.h"
+#include "AssetManager.h"
+#include "sprite_batch.h"
 #include <iostream>
 #include <cmath>
 #include <limits>
@@ -15,21 +18,27 @@
  */
 Bullet::Bullet(BulletType type, sf::Vector2f startPosition, sf::Vector2f direction, uint32_t ownerId)
     : bulletType(type), position(startPosition), ownerId(ownerId),
-    bulletId(0), isDestroyed(false), sprite(placeholder)
+    bulletId(0), isDestroyed(false), sprite(AssetManager::Instance().GetPlaceholderTexture())
 {
-    // Initialize placeholder texture (4x4 white square) - FIXED VERSION
-    try {
-        // Create a simple 4x4 white image using sf::Image
-        sf::Image placeholderImage;
-        placeholderImage.resize(sf::Vector2u(4, 4), sf::Color::White);
+    Reset(type, startPosition, direction, ownerId);
+}
 
-        if (!placeholder.loadFromImage(placeholderImage)) {
-            Utils::printMsg("Warning: Failed to create bullet placeholder texture", warning);
-        }
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception creating bullet placeholder - " + std::string(e.what()), error);
-    }
+/**
+ * Re-initializes the bullet as if newly constructed, for pooled reuse. The
+ * texture is only looked up again when the type changes.
+ * @param type Type of bullet (player, enemy, shell, tracer)
+ * @param startPosition Spawn position in world
+ * @param direction Direction vector (should be normalized)
+ * @param ownerId ID of tank that fired this bullet
+ */
+void Bullet::Reset(BulletType type, sf::Vector2f startPosition, sf::Vector2f direction, uint32_t ownerId) {
+    const bool reloadTexture = !texture || type != bulletType;
+    bulletType = type;
+    position = startPosition;
+    this->ownerId = ownerId;
+    bulletId = 0;
+    isDestroyed = false;
+    correctionOffset = sf::Vector2f();
 
     // Normalize direction vector (ensure it's unit length)
     float dirLength = std::sqrt(direction.x * direction.x + direction.y * direction.y);
@@ -52,27 +61,19 @@ Bullet::Bullet(BulletType type, sf::Vector2f startPosition, sf::Vector2f directi
     // Calculate rotation angle from direction (for sprite orientation)
     rotation = std::atan2(direction.y, direction.x) * 180.0f / 3.14159f;
 
-    // Load texture
-    InitializeTexture();
-
-    // Set texture rectangle - SFML 3.0 syntax
-    try {
-        sf::Vector2u textureSize = texture.getSize();
-        sprite.setTextureRect(sf::IntRect({ 0, 0 },
-            { static_cast<int>(textureSize.x), static_cast<int>(textureSize.y) }));
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception setting bullet texture rectangle - " + std::string(e.what()), error);
-    }
+    if (reloadTexture) {
+        // Load texture (sets the texture rectangle too)
+        InitializeTexture();
 
-    // Set sprite origin to center - SFML 3.0 syntax
-    try {
-        sf::FloatRect bounds = sprite.getLocalBounds();
-        sprite.setOrigin({ bounds.position.x + bounds.size.x / 2.0f,
-                          bounds.position.y + bounds.size.y / 2.0f });
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception setting bullet sprite origin - " + std::string(e.what()), error);
+        // Set sprite origin to center - SFML 3.0 syntax
+        try {
+            sf::FloatRect bounds = sprite.getLocalBounds();
+            sprite.setOrigin({ bounds.position.x + bounds.size.x / 2.0f,
+                              bounds.position.y + bounds.size.y / 2.0f });
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Exception setting bullet sprite origin - " + std::string(e.what()), error);
+        }
     }
 
     // Set initial position and rotation
@@ -102,47 +103,12 @@ Bullet::~Bullet() {
  * Different bullet types have different speed, damage, lifetime, size
  */
 void Bullet::InitializeStats() {
-    switch (bulletType) {
-    case BulletType::PLAYER_STANDARD:
-        // Standard player bullet - balanced
-        speed = 500.0f;             // Fast
-        damage = 25.0f;             // Medium damage
-        maxLifetime = 3.0f;         // 3 seconds
-        collisionRadius = 4.0f;     // Small hitbox
-        break;
-
-    case BulletType::ENEMY_STANDARD:
-        // Enemy bullet - slightly different from player
-        speed = 450.0f;             // Slightly slower
-        damage = 20.0f;             // Slightly less damage
-        maxLifetime = 3.0f;         // 3 seconds
-        collisionRadius = 4.0f;     // Small hitbox
-        break;
-
-    case BulletType::TANK_SHELL:
-        // Heavy tank shell - high damage, slow
-        speed = 300.0f;             // Slower
-        damage = 50.0f;             // High damage
-        maxLifetime = 5.0f;         // Longer lifetime
-        collisionRadius = 6.0f;     // Larger hitbox
-        break;
-
-    case BulletType::TRACER:
-        // Tracer round - visual emphasis, balanced stats
-        speed = 600.0f;             // Very fast
-        damage = 20.0f;             // Lower damage
-        maxLifetime = 2.5f;         // Shorter lifetime
-        collisionRadius = 4.0f;     // Small hitbox
-        break;
-
-    default:
-        // Fallback to player standard
-        speed = 500.0f;
-        damage = 25.0f;
-        maxLifetime = 3.0f;
-        collisionRadius = 4.0f;
-        break;
-    }
+    // Stats table is shared with the server's ProjectilePool (bullet_stats.h)
+    const BulletStats::Stats& stats = BulletStats::ForType(static_cast<uint8_t>(bulletType));
+    speed = stats.speed;
+    damage = stats.damage;
+    maxLifetime = stats.lifetime;
+    collisionRadius = stats.radius;
 
     // Start at full lifetime
     lifetime = maxLifetime;
@@ -155,25 +121,13 @@ void Bullet::InitializeStats() {
 
 /**
  * Initializes texture for this bullet type
- * Loads appropriate texture from Assets folder
+ * Takes this type's region of the sprite atlas (or its cached texture) from the AssetManager
  */
 void Bullet::InitializeTexture() {
-    try {
-        std::string filename = GetTextureFilename();
-
-        if (!texture.loadFromFile(filename)) {
-            Utils::printMsg("Warning: Could not load bullet texture: " + filename, warning);
-            sprite.setTexture(placeholder);
-        }
-        else {
-            sprite.setTexture(texture);
-            Utils::printMsg("Loaded bullet texture: " + filename, debug);
-        }
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception loading bullet texture - " + std::string(e.what()), error);
-        sprite.setTexture(placeholder);
-    }
+    const AssetManager::SpriteRegion region = AssetManager::Instance().LoadSprite(GetTextureFilename(), false);
+    texture = region.texture;
+    sprite.setTexture(*texture);
+    sprite.setTextureRect(region.rect);
 }
 
 /**
@@ -212,10 +166,11 @@ void Bullet::Update(float dt) {
     try {
         // Update position based on velocity
         position += velocity * dt;
+        correctionOffset *= std::exp(-CORRECTION_DECAY_RATE * dt);
 
         // Update sprite position
         if (IsValidPosition(position)) {
-            sprite.setPosition(position);
+            sprite.setPosition(position + correctionOffset);
         }
         else {
             Utils::printMsg("Warning: Invalid bullet position, destroying bullet", warning);
@@ -259,6 +214,12 @@ void Bullet::Render(sf::RenderWindow& window) {
     }
 }
 
+void Bullet::SubmitTo(SpriteBatch& batch) const {
+    if (!isDestroyed) {
+        batch.AddSprite(RenderLayer::BULLETS, sprite);
+    }
+}
+
 /**
  * Gets bounding box for collision detection
  * @return FloatRect representing bullet bounds
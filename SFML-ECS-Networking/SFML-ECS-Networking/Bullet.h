@@ -1,8 +1,11 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 #include <cstdint>
+#include <memory>
 #include "utils.h"
 
+class SpriteBatch;
+
 /**
  * Bullet class represents a projectile fired by tanks
  * Handles movement, collision detection, and rendering
@@ -36,11 +39,17 @@ public:
     Bullet(BulletType type, sf::Vector2f startPosition, sf::Vector2f direction, uint32_t ownerId);
     ~Bullet();
 
+    // Start over as a fresh bullet (same arguments as the constructor), so
+    // pooled bullets are reused without reloading their texture
+    void Reset(BulletType type, sf::Vector2f startPosition, sf::Vector2f direction, uint32_t ownerId);
+
     // Update bullet position and lifetime
     void Update(float dt);
 
     // Render bullet to window
     void Render(sf::RenderWindow& window);
+    // Sprite into the batch's bullet layer (skipped once destroyed)
+    void SubmitTo(SpriteBatch& batch) const;
 
     // Check if bullet should be removed
     bool IsExpired() const { return lifetime <= 0.0f || isDestroyed; }
@@ -63,6 +72,10 @@ public:
     uint32_t GetBulletId() const { return bulletId; }
     void SetBulletId(uint32_t id) { bulletId = id; }
     sf::Vector2f GetVelocity() const { return velocity; }
+    // Server correction already applied to position: the sprite starts at the
+    // old spot and glides onto the corrected path instead of jumping
+    void AddCorrectionOffset(sf::Vector2f offset) { correctionOffset += offset; }
+    void ClearCorrectionOffset() { correctionOffset = sf::Vector2f(); }
 
     // Public for easy network sync (like Tank/EnemyTank)
     sf::Vector2f position;
@@ -84,11 +97,12 @@ private:
     float lifetime;             // Time before auto-destroy (seconds)
     float maxLifetime;          // Maximum lifetime
     bool isDestroyed;           // Hit something
+    sf::Vector2f correctionOffset;  // Render-only, decays at CORRECTION_DECAY_RATE
+    static constexpr float CORRECTION_DECAY_RATE = 15.0f;  // Per second
 
     // Rendering
-    sf::Texture texture;
+    std::shared_ptr<const sf::Texture> texture;     // Shared per bullet type (AssetManager)
     sf::Sprite sprite;
-    sf::Texture placeholder;    // Fallback texture
 
     // Helper methods
     void InitializeStats();
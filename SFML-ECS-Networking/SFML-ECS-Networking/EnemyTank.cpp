@@ -1,12 +1,17 @@
 ﻿#include "EnemyTank.h"
 #include "utils.h"
-#include "HealthBarRenderer.h"  // For health bar visualization
+#ifndef HEADLESS_SERVER
+#include "AssetManager.h"       // Shared textures
+#include "sprite_batch.h"       // Batched rendering
+#endif
+#include "navigation_grid.h"
+#include "static_obstacles.h"
 #include <iostream>
 #include <cmath>
 #include <limits>
+#include <unordered_map>
 #include <stdexcept>
 #include <vector>
-#include <random>
 #include <algorithm>
 
 /**
@@ -14,54 +19,52 @@
  * Initializes textures, sprites, stats based on enemy type.
  * @param type The type/variant of enemy tank
  * @param startPosition Initial spawn position in world
+ * @param withSprites False for an AI-only tank (BotBrain): no textures are
+ *        taken and nothing can be drawn
  */
-EnemyTank::EnemyTank(EnemyType type, sf::Vector2f startPosition)
-    : body(placeholder), barrel(placeholder), enemyType(type), position(startPosition),
+EnemyTank::EnemyTank(EnemyType type, sf::Vector2f startPosition, const RandomStream& random, bool withSprites)
+    : enemyType(ValidType(type)), position(startPosition),
     bodyRotation(sf::degrees(0)), barrelRotation(sf::degrees(0)),
-    targetPosition(startPosition), collisionRadius(25.0f)
+    targetPosition(startPosition),
+    rng(random)
 {
-    // Initialize placeholder texture (1x1 white pixel)
-    try {
-        // Create a simple 4x4 white image using sf::Image
-        sf::Image placeholderImage;
-        placeholderImage.resize(sf::Vector2u(4, 4), sf::Color::White);
+    // Initialize stats based on enemy type
+    InitializeStats();
 
-        if (!placeholder.loadFromImage(placeholderImage)) {
-            Utils::printMsg("Warning: Failed to create enemy placeholder texture", warning);
-        }
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception creating enemy placeholder - " + std::string(e.what()), error);
+#ifndef HEADLESS_SERVER
+    // Load textures and set up sprites (client only)
+    showHealthBar = false;
+    if (withSprites) {
+        body.emplace(AssetManager::Instance().GetPlaceholderTexture());
+        barrel.emplace(AssetManager::Instance().GetPlaceholderTexture());
+        InitializeSprites();
     }
+#else
+    (void)withSprites;
+#endif
 
-    // Get color string for this enemy type
-    colorString = GetColorStringFromType(type);
+    LOG_MSG(info, "Created " + GetEnemyTypeName() + " enemy tank at (" +
+        std::to_string(position.x) + ", " + std::to_string(position.y) + ")");
 
-    // Initialize stats based on enemy type
-    InitializeStats();
+    // Initialize AI System - NEW
+    InitializeAIParameters();
+}
 
-    // Load textures
+#ifndef HEADLESS_SERVER
+/**
+ * Takes the shared body/barrel textures and sets up sprites and the health
+ * bar. Not compiled into the headless server.
+ */
+void EnemyTank::InitializeSprites() {
+    // Load textures (sets the texture rectangles too)
     InitializeTextures();
 
-    // Set texture rectangles - SFML 3.0 syntax
-    try {
-        sf::Vector2u bodySize = bodyTexture.getSize();
-        sf::Vector2u barrelSize = barrelTexture.getSize();
-        body.setTextureRect(sf::IntRect({ 0, 0 },
-            { static_cast<int>(bodySize.x), static_cast<int>(bodySize.y) }));
-        barrel.setTextureRect(sf::IntRect({ 0, 0 },
-            { static_cast<int>(barrelSize.x), static_cast<int>(barrelSize.y) }));
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception setting enemy texture rectangles - " + std::string(e.what()), error);
-    }
-
     // Set sprite origins - SFML 3.0 syntax
     try {
-        sf::FloatRect bodyBounds = body.getLocalBounds();
-        body.setOrigin({ bodyBounds.position.x + bodyBounds.size.x / 2.0f,
+        sf::FloatRect bodyBounds = body->getLocalBounds();
+        body->setOrigin({ bodyBounds.position.x + bodyBounds.size.x / 2.0f,
                         bodyBounds.position.y + bodyBounds.size.y / 2.0f });
-        barrel.setOrigin({ 6.0f, 5.0f }); // Barrel mount point
+        barrel->setOrigin({ 6.0f, 5.0f }); // Barrel mount point
     }
     catch (const std::exception& e) {
         Utils::printMsg("Error: Exception setting enemy sprite origins - " + std::string(e.what()), error);
@@ -69,26 +72,18 @@ EnemyTank::EnemyTank(EnemyType type, sf::Vector2f startPosition)
 
     // Set initial positions and rotations
     try {
-        body.setPosition(position);
-        barrel.setPosition(position);
-        body.setRotation(bodyRotation);
-        barrel.setRotation(barrelRotation);
+        body->setPosition(position);
+        barrel->setPosition(position);
+        body->setRotation(bodyRotation);
+        barrel->setRotation(barrelRotation);
     }
     catch (const std::exception& e) {
         Utils::printMsg("Error: Exception setting enemy initial transform - " + std::string(e.what()), error);
     }
 
-    Utils::printMsg("Created " + GetEnemyTypeName() + " enemy tank at (" +
-        std::to_string(position.x) + ", " + std::to_string(position.y) + ")");
-
-    // Initialize health bar renderer
-    // Initialize health bar renderer
-    healthBarRenderer = std::make_unique<HealthBarRenderer>(50.0f, 6.0f, -40.0f);
     showHealthBar = true;
-
-    // Initialize AI System - NEW
-    InitializeAIParameters();
 }
+#endif
 
 /**
  * Destructor for EnemyTank.
@@ -98,130 +93,41 @@ EnemyTank::~EnemyTank() {
 }
 
 /**
- * Initializes enemy stats based on type.
- * Different enemy types have different health, speed, and score values.
+ * Resets health to the type's maximum. The other stats are read from the
+ * type's Archetype where they are used.
  */
 void EnemyTank::InitializeStats() {
-    switch (enemyType) {
-    case EnemyType::RED:
-        // Basic enemy - balanced stats
-        maxHealth = 100.0f;
-        movementSpeed = 80.0f;
-        rotationSpeed = 120.0f;
-        scoreValue = 10;
-        break;
-
-    case EnemyType::BLACK:
-        // Armored variant - high health, slow movement
-        maxHealth = 200.0f;
-        movementSpeed = 50.0f;
-        rotationSpeed = 80.0f;
-        scoreValue = 25;
-        break;
-
-    case EnemyType::PURPLE:
-        // Fast variant - low health, high speed
-        maxHealth = 60.0f;
-        movementSpeed = 150.0f;
-        rotationSpeed = 200.0f;
-        scoreValue = 15;
-        break;
-
-    case EnemyType::ORANGE:
-        // Heavy variant - very high health, very slow
-        maxHealth = 300.0f;
-        movementSpeed = 40.0f;
-        rotationSpeed = 60.0f;
-        scoreValue = 50;
-        break;
-
-    case EnemyType::TEAL:
-        // Scout variant - medium stats
-        maxHealth = 80.0f;
-        movementSpeed = 120.0f;
-        rotationSpeed = 150.0f;
-        scoreValue = 12;
-        break;
-
-    default:
-        // Fallback to basic stats
-        maxHealth = 100.0f;
-        movementSpeed = 80.0f;
-        rotationSpeed = 120.0f;
-        scoreValue = 10;
-        break;
-    }
-
     // Start at full health
+    maxHealth = Stats().maxHealth;
     currentHealth = maxHealth;
-    
-    /*Utils::printMsg("Enemy stats: HP=" + std::to_string(maxHealth) +
-        ", Speed=" + std::to_string(movementSpeed) +
-        ", Score=" + std::to_string(scoreValue), debug);*/
 }
 
+#ifndef HEADLESS_SERVER
 /**
  * Initializes textures for this enemy type.
- * Loads body and barrel textures from Assets folder.
+ * Body and barrel come from the AssetManager: regions of the sprite atlas,
+ * or cached textures if it was not built, so no enemy touches the disk
+ * after the first of each colour.
  */
 void EnemyTank::InitializeTextures() {
-    try {
-        // Load body texture
-        if (!bodyTexture.loadFromFile("Assets/" + colorString + "Tank.png")) {
-            Utils::printMsg("Warning: Could not load enemy body texture: " + colorString, warning);
-            body.setTexture(placeholder);
-        }
-        else {
-            body.setTexture(bodyTexture);
-            Utils::printMsg("Loaded enemy body texture: " + colorString);
-        }
-
-        // Load barrel texture
-        if (!barrelTexture.loadFromFile("Assets/" + colorString + "Barrel.png")) {
-            Utils::printMsg("Warning: Could not load enemy barrel texture: " + colorString, warning);
-            barrel.setTexture(placeholder);
-        }
-        else {
-            barrel.setTexture(barrelTexture);
-            Utils::printMsg("Loaded enemy barrel texture: " + colorString);
-        }
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception loading enemy textures - " + std::string(e.what()), error);
-        body.setTexture(placeholder);
-        barrel.setTexture(placeholder);
-    }
-}
-
-/**
- * Converts enemy type enum to color string for texture loading.
- * @param type Enemy type enum
- * @return Color string matching texture filenames
- */
-std::string EnemyTank::GetColorStringFromType(EnemyType type) const {
-    switch (type) {
-    case EnemyType::RED:    return "enemyRed";
-    case EnemyType::BLACK:  return "enemyBlack";
-    case EnemyType::PURPLE: return "enemyPurple";
-    case EnemyType::ORANGE: return "enemyOrange";
-    case EnemyType::TEAL:   return "enemyTeal";
-    default:                return "enemyRed";
-    }
+    const std::string colorString = Stats().colorString;
+    const AssetManager::SpriteRegion bodyRegion = AssetManager::Instance().LoadSprite("Assets/" + colorString + "Tank.png", false);
+    const AssetManager::SpriteRegion barrelRegion = AssetManager::Instance().LoadSprite("Assets/" + colorString + "Barrel.png", false);
+    bodyTexture = bodyRegion.texture;
+    barrelTexture = barrelRegion.texture;
+    body->setTexture(*bodyTexture);
+    barrel->setTexture(*barrelTexture);
+    body->setTextureRect(bodyRegion.rect);
+    barrel->setTextureRect(barrelRegion.rect);
 }
+#endif
 
 /**
  * Gets human-readable name for enemy type.
  * @return Enemy type name as string
  */
 std::string EnemyTank::GetEnemyTypeName() const {
-    switch (enemyType) {
-    case EnemyType::RED:    return "Red Enemy";
-    case EnemyType::BLACK:  return "Black Armored";
-    case EnemyType::PURPLE: return "Purple Fast";
-    case EnemyType::ORANGE: return "Orange Heavy";
-    case EnemyType::TEAL:   return "Teal Scout";
-    default:                return "Unknown Enemy";
-    }
+    return Stats().name;
 }
 
 /**
@@ -232,7 +138,7 @@ std::string EnemyTank::GetEnemyTypeName() const {
  */
 void EnemyTank::Update(float dt) {
     if (!IsValidDeltaTime(dt)) {
-        Utils::printMsg("Warning: Invalid enemy delta time (" + std::to_string(dt) + ")", warning);
+        LOG_MSG(warning, "Warning: Invalid enemy delta time (" + std::to_string(dt) + ")");
         return;
     }
 
@@ -241,7 +147,19 @@ void EnemyTank::Update(float dt) {
         UpdateCooldown(dt);
 
         // Update AI behavior (state machine logic)
-        UpdateAIBehavior(dt);
+        if (aiLodTier == AILodTier::FULL) {
+            // Finish any glide left from reduced ticking before thinking every tick again
+            position += lodVelocity * lodGlideTime;
+            lodGlideTime = 0.0f;
+            lodThinkTimer = 0.0f;
+            UpdateAIBehavior(dt);
+        }
+        else {
+            UpdateReducedAI(dt);
+        }
+        if (obstacles) {
+            position = obstacles->ResolveCircle(position, COLLISION_RADIUS);
+        }
 
         // Update sprites with current position/rotation
         UpdateSprites();
@@ -256,25 +174,31 @@ void EnemyTank::Update(float dt) {
  * Called after position/rotation changes from network or AI.
  */
 void EnemyTank::UpdateSprites() {
+#ifndef HEADLESS_SERVER
+    if (!body) {
+        return;
+    }
     try {
         // Apply rotation to body and barrel
-        body.setRotation(bodyRotation);
-        barrel.setRotation(barrelRotation);
+        body->setRotation(bodyRotation);
+        barrel->setRotation(barrelRotation);
 
         // Apply position to body and barrel
         if (IsValidPosition(position)) {
-            body.setPosition(position);
-            barrel.setPosition(position);
+            body->setPosition(position);
+            barrel->setPosition(position);
         }
         else {
-            Utils::printMsg("Warning: Invalid enemy position, skipping sprite update", warning);
+            LOG_MSG(warning, "Warning: Invalid enemy position, skipping sprite update");
         }
     }
     catch (const std::exception& e) {
         Utils::printMsg("Error: Exception in enemy UpdateSprites - " + std::string(e.what()), error);
     }
+#endif
 }
 
+#ifndef HEADLESS_SERVER
 /**
  * Renders the enemy tank to the provided window.
  * @param window The SFML render window
@@ -284,28 +208,34 @@ void EnemyTank::Render(sf::RenderWindow& window) {
         Utils::printMsg("Error: Render window is not open for enemy", error);
         return;
     }
+    if (!body) {
+        return;
+    }
 
     try {
-        window.draw(body);
-        window.draw(barrel);
-
-        // Render health bar above enemy tank
-        if (showHealthBar && healthBarRenderer) {
-            healthBarRenderer->Render(window, position, currentHealth, maxHealth);
-        }
+        window.draw(*body);
+        window.draw(*barrel);
     }
     catch (const std::exception& e) {
         Utils::printMsg("Error: Exception during enemy rendering - " + std::string(e.what()), error);
     }
 }
 
+void EnemyTank::SubmitTo(SpriteBatch& batch) const {
+    if (body) {
+        batch.AddSprite(RenderLayer::BODIES, *body);
+        batch.AddSprite(RenderLayer::BARRELS, *barrel);
+    }
+}
+#endif
+
 /**
  * Applies damage to this enemy tank.
  * @param damage Amount of damage to apply (reduces health)
  */
 void EnemyTank::TakeDamage(float damage) {
     if (damage < 0) {
-        Utils::printMsg("Warning: Negative damage value (" + std::to_string(damage) + "), ignoring", warning);
+        LOG_MSG(warning, "Warning: Negative damage value (" + std::to_string(damage) + "), ignoring");
         return;
     }
 
@@ -321,8 +251,8 @@ void EnemyTank::TakeDamage(float damage) {
     //    std::to_string(maxHealth), debug);
 
     if (IsDead()) {
-        Utils::printMsg(GetEnemyTypeName() + " destroyed! +" +
-            std::to_string(scoreValue) + " points", success);
+        LOG_MSG(success, GetEnemyTypeName() + " destroyed! +" +
+            std::to_string(Stats().scoreValue) + " points");
     }
 }
 
@@ -332,7 +262,7 @@ void EnemyTank::TakeDamage(float damage) {
  */
 void EnemyTank::Heal(float amount) {
     if (amount < 0) {
-        Utils::printMsg("Warning: Negative heal value (" + std::to_string(amount) + "), ignoring", warning);
+        LOG_MSG(warning, "Warning: Negative heal value (" + std::to_string(amount) + "), ignoring");
         return;
     }
 
@@ -354,7 +284,7 @@ void EnemyTank::Heal(float amount) {
  */
 void EnemyTank::SetPosition(sf::Vector2f pos) {
     if (!IsValidPosition(pos)) {
-        Utils::printMsg("Warning: Invalid enemy position set, ignoring", warning);
+        LOG_MSG(warning, "Warning: Invalid enemy position set, ignoring");
         return;
     }
 
@@ -403,7 +333,7 @@ void EnemyTank::SetHealth(float health) {
  */
 void EnemyTank::SetMaxHealth(float maxHp) {
     if (maxHp <= 0.0f) {
-        Utils::printMsg("Warning: Invalid maxHealth value (" + std::to_string(maxHp) + "), ignoring", warning);
+        LOG_MSG(warning, "Warning: Invalid maxHealth value (" + std::to_string(maxHp) + "), ignoring");
         return;
     }
     maxHealth = maxHp;
@@ -427,8 +357,8 @@ void EnemyTank::SetAIState(AIState newState) {
     }
 
     // Log state transition
-    Utils::printMsg(GetEnemyTypeName() + " AI state: " + GetAIStateName() +
-        " -> " + GetAIStateName(), debug);
+    LOG_MSG(debug, GetEnemyTypeName() + " AI state: " + GetAIStateName() +
+        " -> " + GetAIStateName());
 
     previousAIState = currentAIState;
     currentAIState = newState;
@@ -459,8 +389,8 @@ void EnemyTank::SetAIState(AIState newState) {
 
     case AIState::RETREAT:
         // Start retreating
-        Utils::printMsg(GetEnemyTypeName() + " is retreating! (Health: " +
-            std::to_string(GetHealthPercentage() * 100.0f) + "%)", warning);
+        LOG_MSG(warning, GetEnemyTypeName() + " is retreating! (Health: " +
+            std::to_string(GetHealthPercentage() * 100.0f) + "%)");
         break;
     }
 }
@@ -550,7 +480,7 @@ bool EnemyTank::IsTargetInRange(float range) const {
  * @return True if should retreat, false otherwise
  */
 bool EnemyTank::ShouldRetreat() const {
-    return GetHealthPercentage() <= retreatHealthThreshold;
+    return GetHealthPercentage() <= Stats().retreatHealthThreshold;
 }
 
 /**
@@ -564,7 +494,7 @@ bool EnemyTank::ShouldChaseTarget() const {
 
     // Chase if target is within detection range
     float distance = CalculateDistanceTo(lastKnownTargetPos);
-    return distance <= detectionRange;
+    return distance <= Stats().detectionRange;
 }
 
 /**
@@ -608,18 +538,16 @@ void EnemyTank::ClearTarget() {
  * Generates a new random patrol waypoint within world bounds.
  */
 void EnemyTank::GenerateNewPatrolWaypoint() {
-    // Use static random for consistency
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+    // Squad members go where the squad goes
+    if (inSquad) {
+        patrolWaypoint = squadWaypoint;
+        return;
+    }
 
     // Generate waypoint within safe patrol area (avoiding borders)
-    // World is 1280x960, border is 48, tank radius is 25
-    // Safe spawn: 83 to 1197 (X), 83 to 877 (Y) with extra 10px margin
-    std::uniform_real_distribution<float> distX(100.0f, 1180.0f);  // Safe X range
-    std::uniform_real_distribution<float> distY(100.0f, 860.0f);   // Safe Y range
-
-    patrolWaypoint.x = distX(gen);
-    patrolWaypoint.y = distY(gen);
+    // 100 px from the world edges: past the border and tank radius with room to spare
+    patrolWaypoint.x = rng.Uniform(100.0f, WorldConstants::WORLD_WIDTH - 100.0f);    // Safe X range
+    patrolWaypoint.y = rng.Uniform(100.0f, WorldConstants::WORLD_HEIGHT - 100.0f);   // Safe Y range
 
     //Utils::printMsg(GetEnemyTypeName() + " new patrol waypoint: (" +
     //    std::to_string(patrolWaypoint.x) + ", " +
@@ -632,7 +560,23 @@ void EnemyTank::GenerateNewPatrolWaypoint() {
  */
 bool EnemyTank::HasReachedWaypoint() const {
     float distance = CalculateDistanceTo(patrolWaypoint);
-    return distance <= waypointReachedDistance;
+    return distance <= WAYPOINT_REACHED_DISTANCE;
+}
+
+/**
+ * Takes this interval's squad orders. The patrol waypoint follows the squad
+ * at once, kept inside the same safe area random waypoints come from.
+ * @param waypoint Formation slot around the leader's waypoint
+ * @param hasRallyPoint Whether the squad has a threat to retreat from
+ * @param rallyPoint Shared retreat destination
+ */
+void EnemyTank::SetSquadOrders(sf::Vector2f waypoint, bool hasRallyPoint, sf::Vector2f rallyPoint) {
+    inSquad = true;
+    squadWaypoint.x = std::clamp(waypoint.x, 100.0f, 1180.0f);
+    squadWaypoint.y = std::clamp(waypoint.y, 100.0f, 860.0f);
+    patrolWaypoint = squadWaypoint;
+    hasSquadRallyPoint = hasRallyPoint;
+    squadRallyPoint = rallyPoint;
 }
 
 // MOVEMENT AND ROTATION FUNCTIONS
@@ -656,7 +600,7 @@ void EnemyTank::RotateTowards(sf::Vector2f targetPos, float dt) {
     if (angleDiff < -180.0f) angleDiff += 360.0f;
 
     // Smoothly rotate towards target
-    float rotationStep = rotationSpeed * dt;
+    float rotationStep = Stats().rotationSpeed * dt;
     if (std::abs(angleDiff) < rotationStep) {
         // Close enough, snap to target angle
         bodyRotation = sf::degrees(targetAngle);
@@ -685,22 +629,21 @@ void EnemyTank::MoveTowards(sf::Vector2f targetPos, float dt) {
     float distance = CalculateDistanceTo(targetPos);
 
     // Only move if not already at target
-    if (distance > waypointReachedDistance) {
+    if (distance > WAYPOINT_REACHED_DISTANCE) {
         // Move forward in the direction we're facing
         float radians = bodyRotation.asDegrees() * 3.14159265f / 180.0f;
         float dirX = std::cos(radians);
         float dirY = std::sin(radians);
 
         // Apply movement
-        position.x += dirX * movementSpeed * dt;
-        position.y += dirY * movementSpeed * dt;
+        position.x += dirX * Stats().movementSpeed * dt;
+        position.y += dirY * Stats().movementSpeed * dt;
 
-        // Clamp to world bounds: 73 to 1207 (X), 73 to 887 (Y)
-        // BORDER_THICKNESS (48) + TANK_RADIUS (25) = 73
-        const float MIN_X = 73.0f;
-        const float MAX_X = 1207.0f; // 1280 - 48 - 25
-        const float MIN_Y = 73.0f;
-        const float MAX_Y = 887.0f;  // 960 - 48 - 25
+        // Clamp to world bounds: BORDER_THICKNESS + TANK_RADIUS from each edge
+        const float MIN_X = WorldConstants::MOVEMENT_MIN_X;
+        const float MAX_X = WorldConstants::MOVEMENT_MAX_X;
+        const float MIN_Y = WorldConstants::MOVEMENT_MIN_Y;
+        const float MAX_Y = WorldConstants::MOVEMENT_MAX_Y;
 
         position.x = std::max(MIN_X, std::min(MAX_X, position.x));
         position.y = std::max(MIN_Y, std::min(MAX_Y, position.y));
@@ -736,79 +679,40 @@ void EnemyTank::MoveAwayFrom(sf::Vector2f threatPos, float dt) {
 // AI INITIALIZATION
 
 /**
- * Initializes AI parameters based on enemy type.
- * Different enemy types have different AI personalities.
+ * Resets the AI state machine for a fresh spawn. The type's personality
+ * (ranges, retreat threshold, aggression) comes from its Archetype.
  */
 void EnemyTank::InitializeAIParameters() {
     // Common defaults
     targetPlayerId = 0;
     lastKnownTargetPos = position;
     targetLostTimer = 0.0f;
+    aiLodTier = AILodTier::FULL;
+    lodThinkTimer = 0.0f;
+    lodVelocity = sf::Vector2f(0.0f, 0.0f);
+    lodGlideTime = 0.0f;
+    chaseFlowField = nullptr;
     targetScanTimer = 0.0f;
-    targetScanInterval = 1.0f;  // Scan for targets every 1 second
     stateChangeTimer = 0.0f;
     stateTimer = 0.0f;
-    waypointReachedDistance = 50.0f;
     patrolWaitTimer = 0.0f;
-    patrolWaitDuration = 2.0f;  // Wait 2 seconds at each waypoint
+    inSquad = false;
+    hasSquadRallyPoint = false;
 
     // Set initial state
     currentAIState = AIState::PATROL;
     previousAIState = AIState::IDLE;
 
-    // Type-specific AI parameters
-    switch (enemyType) {
-    case EnemyType::RED:
-        // Balanced enemy - standard parameters
-        detectionRange = 400.0f;
-        attackRange = 250.0f;
-        retreatHealthThreshold = 0.3f;  // 30% health
-        aggressionLevel = 0.5f;
-        break;
-
-    case EnemyType::BLACK:
-        // Armored tank - defensive, holds ground
-        detectionRange = 350.0f;
-        attackRange = 300.0f;
-        retreatHealthThreshold = 0.2f;  // 20% health (tanky)
-        aggressionLevel = 0.3f;
-        break;
-
-    case EnemyType::PURPLE:
-        // Fast scout - hit and run tactics
-        detectionRange = 500.0f;
-        attackRange = 200.0f;
-        retreatHealthThreshold = 0.5f;  // 50% health (fragile)
-        aggressionLevel = 0.7f;
-        break;
-
-    case EnemyType::ORANGE:
-        // Heavy assault - aggressive and slow
-        detectionRange = 300.0f;
-        attackRange = 350.0f;
-        retreatHealthThreshold = 0.15f; // 15% health (tough)
-        aggressionLevel = 0.8f;
-        break;
-
-    case EnemyType::TEAL:
-        // Scout - balanced mobility and range
-        detectionRange = 450.0f;
-        attackRange = 220.0f;
-        retreatHealthThreshold = 0.4f;  // 40% health
-        aggressionLevel = 0.6f;
-        break;
-    }
-
     // Generate initial patrol waypoint
     GenerateNewPatrolWaypoint();
 
     // Initialize shooting parameters (Phase 3)
     InitializeShootingParameters();
 
-    Utils::printMsg(GetEnemyTypeName() + " AI initialized - Detection: " +
-        std::to_string(detectionRange) + ", Attack: " +
-        std::to_string(attackRange) + ", Aggression: " +
-        std::to_string(aggressionLevel), success);
+    LOG_MSG(success, GetEnemyTypeName() + " AI initialized - Detection: " +
+        std::to_string(Stats().detectionRange) + ", Attack: " +
+        std::to_string(Stats().attackRange) + ", Aggression: " +
+        std::to_string(Stats().aggressionLevel));
 }
 //  MOVEMENT & NAVIGATION
 // State Update Implementations
@@ -856,6 +760,32 @@ void EnemyTank::UpdateAIBehavior(float dt) {
     }
 }
 
+/**
+ * Reduced-rate AI: the state machine runs once per REDUCED_THINK_INTERVAL with
+ * the whole elapsed time, so its timers stay correct. The movement it decides
+ * is undone and replayed as a straight glide over the next interval, which
+ * keeps the replicated position smooth. Positions stay inside the world
+ * because the glide runs between two clamped positions.
+ * @param dt Delta time
+ */
+void EnemyTank::UpdateReducedAI(float dt) {
+    lodThinkTimer += dt;
+    if (lodThinkTimer >= REDUCED_THINK_INTERVAL) {
+        position += lodVelocity * lodGlideTime;
+
+        const sf::Vector2f thinkStart = position;
+        UpdateAIBehavior(lodThinkTimer);
+        lodVelocity = (position - thinkStart) / lodThinkTimer;
+        lodGlideTime = lodThinkTimer;
+        position = thinkStart;
+        lodThinkTimer = 0.0f;
+    }
+
+    const float step = std::min(dt, lodGlideTime);
+    position += lodVelocity * step;
+    lodGlideTime -= step;
+}
+
 /**
  * Updates IDLE state behavior.
  * Enemy stands still and scans for threats.
@@ -885,7 +815,7 @@ void EnemyTank::UpdatePatrolState(float dt) {
         float distanceToTarget = CalculateDistanceTo(lastKnownTargetPos);
 
         // Target is within detection range - start chasing!
-        if (distanceToTarget <= detectionRange) {
+        if (distanceToTarget <= Stats().detectionRange) {
             //Utils::printMsg(GetEnemyTypeName() + " detected target at " +
             //    std::to_string(distanceToTarget) + " units - CHASING!", success);
             SetAIState(AIState::CHASE);
@@ -899,7 +829,7 @@ void EnemyTank::UpdatePatrolState(float dt) {
         // Wait at waypoint
         patrolWaitTimer += dt;
 
-        if (patrolWaitTimer >= patrolWaitDuration) {
+        if (patrolWaitTimer >= PATROL_WAIT_DURATION) {
             // Generate new waypoint and continue patrol
             GenerateNewPatrolWaypoint();
             patrolWaitTimer = 0.0f;
@@ -936,7 +866,7 @@ void EnemyTank::UpdateChaseState(float dt) {
 
     //  Use ENTER threshold (0.7x) to switch to ATTACK
     // This matches the EXIT threshold (1.5x) in UpdateAttackState
-    const float ATTACK_ENTER_RANGE = attackRange * 0.7f;
+    const float ATTACK_ENTER_RANGE = Stats().attackRange * 0.7f;
 
     // Enter ATTACK mode earlier (at 70% of attack range)
     if (distanceToTarget <= ATTACK_ENTER_RANGE) {
@@ -948,7 +878,7 @@ void EnemyTank::UpdateChaseState(float dt) {
     }
 
     // Check if target escaped detection range
-    if (distanceToTarget > detectionRange * 1.5f) {
+    if (distanceToTarget > Stats().detectionRange * 1.5f) {
         //Utils::printMsg(GetEnemyTypeName() + " target out of range (" +
         //    std::to_string(distanceToTarget) + " > " +
         //    std::to_string(detectionRange * 1.5f) + ") - lost target", warning);
@@ -958,7 +888,7 @@ void EnemyTank::UpdateChaseState(float dt) {
     }
 
     // Continue chasing
-    MoveTowardsWithAvoidance(lastKnownTargetPos, dt);
+    MoveAlongFlowField(lastKnownTargetPos, dt);
 
     // Aim barrel at target while chasing
     float targetAngle = CalculateAngleTo(lastKnownTargetPos);
@@ -981,8 +911,8 @@ void EnemyTank::UpdateAttackState(float dt) {
 
 
     // Use DIFFERENT thresholds for entering vs exiting ATTACK state
-    const float ATTACK_EXIT_RANGE = attackRange * 1.5f;  // Stay in ATTACK until 1.5x range
-    const float ATTACK_ENTER_RANGE = attackRange * 0.7f; // Enter ATTACK at 0.7x range
+    const float ATTACK_EXIT_RANGE = Stats().attackRange * 1.5f;  // Stay in ATTACK until 1.5x range
+    const float ATTACK_ENTER_RANGE = Stats().attackRange * 0.7f; // Enter ATTACK at 0.7x range
 
     // Only exit ATTACK if target is MUCH farther than attack range
     if (distanceToTarget > ATTACK_EXIT_RANGE) {
@@ -995,10 +925,15 @@ void EnemyTank::UpdateAttackState(float dt) {
 
     // Range Management 
     // Maintain Optimal Distance
-    const float OPTIMAL_MIN = attackRange * 0.6f;  // Too close
-    const float OPTIMAL_MAX = attackRange * 1.1f;  // Too far
+    const float OPTIMAL_MIN = Stats().attackRange * 0.6f;  // Too close
+    const float OPTIMAL_MAX = Stats().attackRange * 1.1f;  // Too far
+    const bool lineOfSight = HasLineOfSightTo(lastKnownTargetPos);
 
-    if (distanceToTarget < OPTIMAL_MIN) {
+    if (!lineOfSight) {
+        // Behind an obstacle - work around it along the chase field
+        MoveAlongFlowField(lastKnownTargetPos, dt);
+    }
+    else if (distanceToTarget < OPTIMAL_MIN) {
         // Too close - back up slowly
         MoveAwayFrom(lastKnownTargetPos, dt);
     }
@@ -1035,33 +970,25 @@ void EnemyTank::UpdateAttackState(float dt) {
     // Closer targets = stricter aim (they're easier to hit)
     // Farther targets = looser aim (compensate for movement)
     float aimThreshold = 45.0f;  // Base threshold
-    if (distanceToTarget > attackRange * 0.8f) {
+    if (distanceToTarget > Stats().attackRange * 0.8f) {
         aimThreshold = 75.0f;  // Very loose for far targets
     }
-    else if (distanceToTarget > attackRange * 0.5f) {
+    else if (distanceToTarget > Stats().attackRange * 0.5f) {
         aimThreshold = 60.0f;  // Medium for mid-range
     }
 
-    // Log aiming info every 0.5 seconds
-    static std::unordered_map<uint32_t, float> aimLogTimers;
-    static uint32_t enemyIdCounter = 0;
-    uint32_t logId = enemyIdCounter++;
-    aimLogTimers[logId] += dt;
-
-    if (aimLogTimers[logId] >= 0.5f) {
-        //Utils::printMsg("ATTACK: " + GetEnemyTypeName() +
-        //    " | Dist=" + std::to_string(distanceToTarget) +
-        //    " | AimDiff=" + std::to_string(angleDiff) + "°" +
-        //    " | Threshold=" + std::to_string(aimThreshold) + "°" +
-        //    " | Cooldown=" + std::to_string(GetShootCooldown()) + "s", info);
-        aimLogTimers[logId] = 0.0f;
-    }
+    // Aiming info, sampled across all enemies
+    //LOG_SAMPLED(LogCategory::ENEMY_AIM, info, "ATTACK: " + GetEnemyTypeName() +
+    //    " | Dist=" + std::to_string(distanceToTarget) +
+    //    " | AimDiff=" + std::to_string(angleDiff) + "°" +
+    //    " | Threshold=" + std::to_string(aimThreshold) + "°" +
+    //    " | Cooldown=" + std::to_string(GetShootCooldown()) + "s");
 
 
     bool aimIsGoodEnough = (angleDiff <= aimThreshold);
     bool cooldownReady = CanShoot();
 
-    if (aimIsGoodEnough && cooldownReady) {
+    if (aimIsGoodEnough && cooldownReady && lineOfSight) {
         // TRY to shoot - TryShoot() handles burst logic internally
         if (TryShoot()) {
             //Utils::printMsg(GetEnemyTypeName() + " FIRED at distance " +
@@ -1075,24 +1002,14 @@ void EnemyTank::UpdateAttackState(float dt) {
     }
     else if (!aimIsGoodEnough) {
         // Aim not ready - this is normal, just keep aiming
-        static std::unordered_map<uint32_t, float> noAimLogTimers;
-        noAimLogTimers[logId] += dt;
-        if (noAimLogTimers[logId] >= 2.0f) {
-            //Utils::printMsg(GetEnemyTypeName() + " aiming... (off by " +
-            //    std::to_string(angleDiff) + "°, need <" +
-            //    std::to_string(aimThreshold) + "°)", debug);
-            noAimLogTimers[logId] = 0.0f;
-        }
+        //LOG_SAMPLED(LogCategory::ENEMY_AIM, debug, GetEnemyTypeName() + " aiming... (off by " +
+        //    std::to_string(angleDiff) + "°, need <" +
+        //    std::to_string(aimThreshold) + "°)");
     }
     else if (!cooldownReady) {
         // On cooldown - this is normal after shooting
-        static std::unordered_map<uint32_t, float> cooldownLogTimers;
-        cooldownLogTimers[logId] += dt;
-        if (cooldownLogTimers[logId] >= 1.0f) {
-            //Utils::printMsg(GetEnemyTypeName() + " on cooldown: " +
-            //    std::to_string(GetShootCooldown()) + "s remaining", debug);
-            cooldownLogTimers[logId] = 0.0f;
-        }
+        //LOG_SAMPLED(LogCategory::ENEMY_AIM, debug, GetEnemyTypeName() + " on cooldown: " +
+        //    std::to_string(GetShootCooldown()) + "s remaining");
     }
 }
 
@@ -1137,7 +1054,8 @@ void EnemyTank::UpdateRetreatState(float dt) {
             // 2. Away from the threat
             // 3. Within safe movement area
 
-            sf::Vector2f retreatTarget = CalculateSafeRetreatPosition(lastKnownTargetPos);
+            sf::Vector2f retreatTarget = (inSquad && hasSquadRallyPoint) ?
+                squadRallyPoint : CalculateSafeRetreatPosition(lastKnownTargetPos);
             MoveTowardsWithAvoidance(retreatTarget, dt);
 
             //Utils::printMsg(GetEnemyTypeName() + " repositioning from boundary to (" +
@@ -1185,9 +1103,9 @@ void EnemyTank::UpdateRetreatState(float dt) {
 bool EnemyTank::IsPositionSafe(sf::Vector2f pos) const {
     const float BOUNDARY_MARGIN = 80.0f;  // Stay this far from edges
 
-    // Use actual world dimensions: 1280x960
-    return (pos.x > BOUNDARY_MARGIN && pos.x < 1280.0f - BOUNDARY_MARGIN &&
-        pos.y > BOUNDARY_MARGIN && pos.y < 960.0f - BOUNDARY_MARGIN);
+    return (pos.x > BOUNDARY_MARGIN && pos.x < WorldConstants::WORLD_WIDTH - BOUNDARY_MARGIN &&
+        pos.y > BOUNDARY_MARGIN && pos.y < WorldConstants::WORLD_HEIGHT - BOUNDARY_MARGIN) &&
+        !(obstacles && obstacles->OverlapsCircle(pos, COLLISION_RADIUS));
 }
 
 /**
@@ -1204,15 +1122,15 @@ void EnemyTank::MoveTowardsWithAvoidance(sf::Vector2f targetPos, float dt) {
     float distance = CalculateDistanceTo(targetPos);
 
     // Only move if not already at target
-    if (distance > waypointReachedDistance) {
+    if (distance > WAYPOINT_REACHED_DISTANCE) {
         // Calculate intended next position
         float radians = bodyRotation.asDegrees() * 3.14159265f / 180.0f;
         float dirX = std::cos(radians);
         float dirY = std::sin(radians);
 
         sf::Vector2f intendedPos;
-        intendedPos.x = position.x + dirX * movementSpeed * dt;
-        intendedPos.y = position.y + dirY * movementSpeed * dt;
+        intendedPos.x = position.x + dirX * Stats().movementSpeed * dt;
+        intendedPos.y = position.y + dirY * Stats().movementSpeed * dt;
 
         // Check if intended position is safe
         if (IsPositionSafe(intendedPos)) {
@@ -1248,8 +1166,8 @@ void EnemyTank::MoveTowardsWithAvoidance(sf::Vector2f targetPos, float dt) {
                 }
 
                 // Apply blended movement
-                position.x += blendedDir.x * movementSpeed * dt * 0.7f;  // Slower when avoiding
-                position.y += blendedDir.y * movementSpeed * dt * 0.7f;
+                position.x += blendedDir.x * Stats().movementSpeed * dt * 0.7f;  // Slower when avoiding
+                position.y += blendedDir.y * Stats().movementSpeed * dt * 0.7f;
             }
         }
 
@@ -1265,6 +1183,25 @@ void EnemyTank::MoveTowardsWithAvoidance(sf::Vector2f targetPos, float dt) {
     }
 }
 
+/**
+ * Follows the shared flow field toward the target: one O(1) lookup instead of
+ * probing the boundaries. The field already routes around blocked cells, so
+ * plain MoveTowards is enough. Inside the target's cell (or without a field)
+ * falls back to steering straight at the target.
+ * @param targetPos Target position the field leads to
+ * @param dt Delta time
+ */
+void EnemyTank::MoveAlongFlowField(sf::Vector2f targetPos, float dt) {
+    const sf::Vector2f direction = chaseFlowField ? chaseFlowField->GetDirection(position) : sf::Vector2f(0.0f, 0.0f);
+    if (direction.x == 0.0f && direction.y == 0.0f) {
+        MoveTowardsWithAvoidance(targetPos, dt);
+        return;
+    }
+
+    // Steer at a point past the arrival distance so MoveTowards keeps moving
+    MoveTowards(position + direction * (WAYPOINT_REACHED_DISTANCE * 2.0f), dt);
+}
+
 /**
  * Predicts if the enemy will collide with world boundaries soon.
  * Used for proactive obstacle avoidance.
@@ -1278,8 +1215,8 @@ bool EnemyTank::WillCollideWithBoundary(float lookAheadTime) const {
     float dirY = std::sin(radians);
 
     sf::Vector2f futurePos;
-    futurePos.x = position.x + dirX * movementSpeed * lookAheadTime;
-    futurePos.y = position.y + dirY * movementSpeed * lookAheadTime;
+    futurePos.x = position.x + dirX * Stats().movementSpeed * lookAheadTime;
+    futurePos.y = position.y + dirY * Stats().movementSpeed * lookAheadTime;
 
     // Check if future position is unsafe
     return !IsPositionSafe(futurePos);
@@ -1366,8 +1303,8 @@ sf::Vector2f EnemyTank::GetBarrelEndPosition() const {
         float barrelRad = barrelRotation.asDegrees() * 3.14159265f / 180.0f;
 
         // Calculate offset from tank center to barrel end
-        float offsetX = std::cos(barrelRad) * barrelLength;
-        float offsetY = std::sin(barrelRad) * barrelLength;
+        float offsetX = std::cos(barrelRad) * BARREL_LENGTH;
+        float offsetY = std::sin(barrelRad) * BARREL_LENGTH;
 
         // Return position at barrel end
         return sf::Vector2f(position.x + offsetX, position.y + offsetY);
@@ -1396,7 +1333,7 @@ sf::Vector2f EnemyTank::GetAimDirection() const {
 sf::Vector2f EnemyTank::ApplyAccuracySpread(sf::Vector2f direction) const {
     // Perfect accuracy (1.0) means no spread
     // Poor accuracy (0.0) means maximum spread
-    float spreadAmount = (1.0f - baseAccuracy) * accuracySpreadAngle;
+    float spreadAmount = (1.0f - Stats().baseAccuracy) * Stats().accuracySpreadAngle;
 
     if (spreadAmount < 0.01f) {
         // Nearly perfect accuracy, no spread needed
@@ -1404,11 +1341,7 @@ sf::Vector2f EnemyTank::ApplyAccuracySpread(sf::Vector2f direction) const {
     }
 
     // Generate random angle offset within spread range
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> spreadDist(-spreadAmount, spreadAmount);
-
-    float angleOffset = spreadDist(gen);
+    float angleOffset = rng.Uniform(-spreadAmount, spreadAmount);
     float angleRad = angleOffset * 3.14159265f / 180.0f;
 
     // Apply rotation to direction vector
@@ -1445,12 +1378,12 @@ bool EnemyTank::TryShoot() {
     }
 
     // Start cooldown
-    shootCooldown = shootCooldownTime;
+    shootCooldown = Stats().shootCooldownTime;
     lastShotTime = 0.0f;
 
     // Track burst fire
     shotsInBurst++;
-    if (shotsInBurst >= maxBurstSize) {
+    if (shotsInBurst >= Stats().maxBurstSize) {
         // End of burst, add extra cooldown
         shootCooldown *= 1.5f;
         shotsInBurst = 0;
@@ -1510,63 +1443,37 @@ bool EnemyTank::ShouldShootAtTarget() const {
         return false;
     }
 
+    // No shooting into walls
+    if (!HasLineOfSightTo(lastKnownTargetPos)) {
+        return false;
+    }
+
     // All basic checks passed - caller (UpdateAttackState) will check aim
     return true;
 }
+
+/**
+ * True if no static obstacle lies between this tank and targetPos. The ray
+ * is the one a shell takes, starting at the barrel's end.
+ * @param targetPos Position to look at
+ */
+bool EnemyTank::HasLineOfSightTo(sf::Vector2f targetPos) const {
+    if (!obstacles) {
+        return true;
+    }
+    const sf::Vector2f direction = GetDirectionTo(targetPos);
+    return obstacles->HasLineOfSight(position + direction * BARREL_LENGTH, targetPos);
+}
 /**
- * Initializes shooting parameters based on enemy type.
- * Different enemy types have different fire rates and accuracy.
+ * Resets the shooting state. Fire rate, accuracy and burst size come from
+ * the type's Archetype.
  */
 void EnemyTank::InitializeShootingParameters() {
     // Common defaults
-    barrelLength = 20.0f;  // Barrel length for bullet spawn
     shotsInBurst = 0;
     lastShotTime = 0.0f;
     shootCooldown = 0.0f;
 
-    // Type-specific shooting parameters
-    switch (enemyType) {
-    case EnemyType::RED:
-        // Balanced enemy - moderate fire rate and accuracy
-        shootCooldownTime = 1.5f;     // Fire every 1.5 seconds
-        baseAccuracy = 0.6f;          // 60% accuracy
-        accuracySpreadAngle = 15.0f;  // ±15° spread
-        maxBurstSize = 3;             // 3-shot bursts
-        break;
-
-    case EnemyType::BLACK:
-        // Armored tank - slow but accurate
-        shootCooldownTime = 2.5f;     // Fire every 2.5 seconds
-        baseAccuracy = 0.8f;          // 80% accuracy
-        accuracySpreadAngle = 8.0f;   // ±8° spread
-        maxBurstSize = 1;             // Single shots
-        break;
-
-    case EnemyType::PURPLE:
-        // Fast scout - rapid but inaccurate
-        shootCooldownTime = 0.8f;     // Fire every 0.8 seconds
-        baseAccuracy = 0.4f;          // 40% accuracy
-        accuracySpreadAngle = 25.0f;  // ±25° spread
-        maxBurstSize = 5;             // 5-shot bursts
-        break;
-
-    case EnemyType::ORANGE:
-        // Heavy assault - very slow, very accurate
-        shootCooldownTime = 3.0f;     // Fire every 3 seconds
-        baseAccuracy = 0.9f;          // 90% accuracy
-        accuracySpreadAngle = 5.0f;   // ±5° spread
-        maxBurstSize = 1;             // Single heavy shots
-        break;
-
-    case EnemyType::TEAL:
-        // Scout - balanced rapid fire
-        shootCooldownTime = 1.2f;     // Fire every 1.2 seconds
-        baseAccuracy = 0.7f;          // 70% accuracy
-        accuracySpreadAngle = 12.0f;  // ±12° spread
-        maxBurstSize = 2;             // 2-shot bursts
-        break;
-    }
-
     //Utils::printMsg(GetEnemyTypeName() + " shooting initialized - Cooldown: " +
     //    std::to_string(shootCooldownTime) + "s, Accuracy: " +
     //    std::to_string(baseAccuracy * 100.0f) + "%, Burst: " +
@@ -1632,22 +1539,13 @@ sf::Vector2f EnemyTank::CalculateSafeRetreatPosition(sf::Vector2f threatPos) con
 
 sf::Vector2f EnemyTank::GenerateSafeInteriorPosition() const {
     // Use randomization with boundary avoidance
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-
     const float INTERIOR_MARGIN = 150.0f;
 
-    std::uniform_real_distribution<float> distX(
-        WorldConstants::MOVEMENT_MIN_X + INTERIOR_MARGIN,
-        WorldConstants::MOVEMENT_MAX_X - INTERIOR_MARGIN
-    );
-
-    std::uniform_real_distribution<float> distY(
-        WorldConstants::MOVEMENT_MIN_Y + INTERIOR_MARGIN,
-        WorldConstants::MOVEMENT_MAX_Y - INTERIOR_MARGIN
-    );
-
-    return sf::Vector2f(distX(gen), distY(gen));
+    const float x = rng.Uniform(WorldConstants::MOVEMENT_MIN_X + INTERIOR_MARGIN,
+        WorldConstants::MOVEMENT_MAX_X - INTERIOR_MARGIN);
+    const float y = rng.Uniform(WorldConstants::MOVEMENT_MIN_Y + INTERIOR_MARGIN,
+        WorldConstants::MOVEMENT_MAX_Y - INTERIOR_MARGIN);
+    return sf::Vector2f(x, y);
 }
 
 sf::Vector2f EnemyTank::SelectSafeCorner() const {
@@ -1,11 +1,22 @@
 #pragma once
+// HEADLESS_SERVER (Release-Server) keeps only simulation state: no sprites,
+// textures or health bars, so the server links SFML System/Network only
+#ifdef HEADLESS_SERVER
+#include <SFML/System.hpp>
+#else
 #include <SFML/Graphics.hpp>
+#endif
+#include <cstddef>
 #include <string>
 #include "utils.h"
 #include <memory>
+#include <optional>
+#include "random_stream.h"
 #include "world_constants.h"
 // Forward declaration
-class HealthBarRenderer;
+class SpriteBatch;
+class FlowField;
+class StaticObstacles;
 
 /**
  * EnemyTank class represents an AI-controlled enemy tank in the game.
@@ -23,6 +34,56 @@ public:
         ORANGE,     // Burnt orange - heavy variant
         TEAL        // Dark teal - scout variant
     };
+    static constexpr size_t ENEMY_TYPE_COUNT = 5;
+
+    /**
+     * Everything fixed by the enemy type. One table entry per type is shared
+     * by every enemy of that type; instances keep only their type and the
+     * state that changes during play. Tune enemies in ARCHETYPES below.
+     */
+    struct Archetype {
+        const char* name;               // GetEnemyTypeName
+        const char* colorString;        // Texture file prefix
+        int scoreValue;
+
+        // Stats
+        float maxHealth;                // At spawn; the client takes the server's
+        float movementSpeed;
+        float rotationSpeed;            // Degrees per second
+
+        // AI personality
+        float detectionRange;
+        float attackRange;
+        float retreatHealthThreshold;   // Health fraction
+        float aggressionLevel;
+
+        // Shooting
+        float shootCooldownTime;
+        float baseAccuracy;
+        float accuracySpreadAngle;      // Degrees either side
+        int maxBurstSize;
+    };
+
+    static constexpr Archetype ARCHETYPES[ENEMY_TYPE_COUNT] = {
+        // Name             Texture          Score  HP      Speed   Turn    Detect  Attack  Retreat Aggro   Cooldown Acc   Spread  Burst
+        { "Red Enemy",     "enemyRed",      10,    100.0f, 80.0f,  120.0f, 400.0f, 250.0f, 0.3f,   0.5f,   1.5f,    0.6f, 15.0f,  3 },  // Basic, balanced
+        { "Black Armored", "enemyBlack",    25,    200.0f, 50.0f,  80.0f,  350.0f, 300.0f, 0.2f,   0.3f,   2.5f,    0.8f, 8.0f,   1 },  // Armored, holds ground
+        { "Purple Fast",   "enemyPurple",   15,    60.0f,  150.0f, 200.0f, 500.0f, 200.0f, 0.5f,   0.7f,   0.8f,    0.4f, 25.0f,  5 },  // Fast, hit and run
+        { "Orange Heavy",  "enemyOrange",   50,    300.0f, 40.0f,  60.0f,  300.0f, 350.0f, 0.15f,  0.8f,   3.0f,    0.9f, 5.0f,   1 },  // Heavy assault
+        { "Teal Scout",    "enemyTeal",     12,    80.0f,  120.0f, 150.0f, 450.0f, 220.0f, 0.4f,   0.6f,   1.2f,    0.7f, 12.0f,  2 }   // Scout
+    };
+
+    // Same for every type
+    static constexpr float COLLISION_RADIUS = 25.0f;
+    static constexpr float BARREL_LENGTH = 20.0f;               // Bullet spawn distance from the centre
+    static constexpr float WAYPOINT_REACHED_DISTANCE = 50.0f;
+    static constexpr float PATROL_WAIT_DURATION = 2.0f;         // At each waypoint
+
+    // Out of range types (bad network data) are treated as RED
+    static EnemyType ValidType(EnemyType type) {
+        return static_cast<size_t>(type) < ENEMY_TYPE_COUNT ? type : EnemyType::RED;
+    }
+    static const Archetype& GetArchetype(EnemyType type) { return ARCHETYPES[static_cast<size_t>(ValidType(type))]; }
 
     /**
      * AI behavior states for state machine
@@ -34,19 +95,54 @@ public:
         ATTACK,     // In combat range, shooting at target
         RETREAT     // Low health, moving away from threats
     };
+    static constexpr size_t AI_STATE_COUNT = 5;
 
-    // Constructors
-    EnemyTank(EnemyType type, sf::Vector2f startPosition);
+    /**
+     * AI level of detail. REDUCED runs the state machine every REDUCED_THINK_INTERVAL
+     * and glides along the last decided movement in between.
+     */
+    enum class AILodTier {
+        FULL,
+        REDUCED
+    };
+    static constexpr float REDUCED_THINK_INTERVAL = 0.125f;   // 8 Hz
+
+    // Constructors. random is this enemy's own stream (waypoints, aim spread),
+    // at the tick it is created (see RandomStream). withSprites false keeps
+    // only the simulation, as in the headless server build.
+    EnemyTank(EnemyType type, sf::Vector2f startPosition, const RandomStream& random = RandomStream(),
+        bool withSprites = true);
     ~EnemyTank();
 
     // Update enemy state (movement, AI logic)
     void Update(float dt);
+    // Moves the RNG stream to tick's numbers; call before the tick's Update
+    void SetRandomTick(uint32_t tick) { rng.Restart(tick); }
+
+    // Chosen by the server each tick from the distance to the nearest player
+    void SetAILodTier(AILodTier tier) { aiLodTier = tier; }
+    AILodTier GetAILodTier() const { return aiLodTier; }
+
+    // Shared flow field toward the current target, set by the server each tick
+    // (null: chase steers straight at the target with boundary avoidance)
+    void SetChaseFlowField(const FlowField* field) { chaseFlowField = field; }
+
+    // The map's static obstacles, set by the server each tick: movement is
+    // pushed out of them and shots need a clear line (null: open arena)
+    void SetObstacles(const StaticObstacles* obstacleSet) { obstacles = obstacleSet; }
 
     // Update sprite positions and rotations without movement logic
     void UpdateSprites();
 
-    // Render enemy tank to the provided window
+#ifndef HEADLESS_SERVER
+    // Render enemy tank to the provided window (without its health bar)
     void Render(sf::RenderWindow& window);
+    // Body and barrel into the batch's layers
+    void SubmitTo(SpriteBatch& batch) const;
+    // The bar itself is drawn by the owner's shared HealthBarRenderer pass
+    bool IsHealthBarVisible() const { return showHealthBar; }
+    void SetHealthBarVisible(bool visible) { showHealthBar = visible; }
+#endif
 
     // Health management
     void TakeDamage(float damage);
@@ -71,14 +167,14 @@ public:
     std::string GetEnemyTypeName() const;
 
     // Collision detection helper
-    float GetRadius() const { return collisionRadius; }
+    float GetRadius() const { return COLLISION_RADIUS; }
 
     // For future AI: target tracking
     void SetTargetPosition(sf::Vector2f target) { targetPosition = target; }
     sf::Vector2f GetTargetPosition() const { return targetPosition; }
 
     // Score value when destroyed
-    int GetScoreValue() const { return scoreValue; }
+    int GetScoreValue() const { return Stats().scoreValue; }
 
     // Shooting mechanics
     bool CanShoot() const { return shootCooldown <= 0.0f; }
@@ -90,10 +186,17 @@ public:
     bool TryShoot();
     sf::Vector2f GetAimDirection() const;
 
+    // Where a target moving at targetVel will be when a bullet of bulletSpeed
+    // fired now reaches it
+    sf::Vector2f CalculateLeadTarget(sf::Vector2f targetPos, sf::Vector2f targetVel, float bulletSpeed) const;
+
     // Accuracy system
-    float GetAccuracy() const { return baseAccuracy; }
+    float GetAccuracy() const { return Stats().baseAccuracy; }
     sf::Vector2f ApplyAccuracySpread(sf::Vector2f direction) const;
 
+    // Straight-line distance from this tank
+    float CalculateDistanceTo(sf::Vector2f targetPos) const;
+
     // AI state accessors (for debugging/network sync)
     AIState GetAIState() const { return currentAIState; }
     void SetAIState(AIState newState);
@@ -105,15 +208,26 @@ public:
     bool HasTarget() const { return targetPlayerId != 0; }
 
     // AI parameters accessors (for server)
-    float GetDetectionRange() const { return detectionRange; }
-    float GetAttackRange() const { return attackRange; }
-    float GetAggressionLevel() const { return aggressionLevel; }
+    float GetDetectionRange() const { return Stats().detectionRange; }
+    float GetAttackRange() const { return Stats().attackRange; }
+    float GetAggressionLevel() const { return Stats().aggressionLevel; }
 
     // FIXED: Make these public so GameServer can call them
     void SelectNewTarget(uint32_t playerId, sf::Vector2f playerPos);
     void ClearTarget();
 
     bool ShouldShootAtTarget() const;
+    bool HasLineOfSightTo(sf::Vector2f targetPos) const;
+
+    // Squad orders from the server (see EnemySquads). A member patrols to its
+    // formation slot and, when cornered while retreating, heads for the
+    // squad's rally point instead of choosing its own
+    void SetSquadOrders(sf::Vector2f waypoint, bool hasRallyPoint, sf::Vector2f rallyPoint);
+    void ClearSquadOrders() { inSquad = false; }
+    bool IsInSquad() const { return inSquad; }
+    sf::Vector2f GetPatrolWaypoint() const { return patrolWaypoint; }
+    // A retreat destination away from the threat and clear of the walls
+    sf::Vector2f CalculateSafeRetreatPosition(sf::Vector2f threatPos) const;
 
     // Public members for easy network sync (like Tank class)
     sf::Vector2f position;
@@ -121,16 +235,10 @@ public:
     sf::Angle barrelRotation;
 
 private:
-    // Enemy type and stats
+    // Enemy type (always a valid ARCHETYPES index) and health
     EnemyType enemyType;
     float maxHealth;
     float currentHealth;
-    int scoreValue;
-
-    // Movement properties
-    float movementSpeed;
-    float rotationSpeed;
-    float collisionRadius;
 
     // AI state machine
     AIState currentAIState;
@@ -139,71 +247,73 @@ private:
 
     // Shooting system
     float shootCooldown;
-    float shootCooldownTime;
-    float barrelLength;
-
-    // Accuracy system
-    float baseAccuracy;
-    float accuracySpreadAngle;
 
     // Combat behavior
     float lastShotTime;
     int shotsInBurst;
-    int maxBurstSize;
+
+    // Per-enemy RNG: no state is shared between enemies, so their AI can
+    // update in parallel, and it depends only on the tick, so replays and
+    // restored checkpoints draw the same numbers
+    mutable RandomStream rng;
 
     // AI targeting
     uint32_t targetPlayerId;
     sf::Vector2f lastKnownTargetPos;
     float targetLostTimer;
 
+    // AI level of detail (REDUCED: movement from the last think, spread over the next interval)
+    AILodTier aiLodTier;
+    float lodThinkTimer;           // Time since the last think
+    sf::Vector2f lodVelocity;      // Displacement of the last think per second
+    float lodGlideTime;            // Glide time left before that displacement is complete
+
+    const FlowField* chaseFlowField;   // Not owned
+    const StaticObstacles* obstacles = nullptr;    // Not owned
+
     // AI decision-making timers
     float targetScanTimer;
-    float targetScanInterval;
     float stateChangeTimer;
 
-    // AI personality parameters
-    float detectionRange;
-    float attackRange;
-    float retreatHealthThreshold;
-    float aggressionLevel;
-
     // Patrol behavior
     sf::Vector2f patrolWaypoint;
-    float waypointReachedDistance;
     float patrolWaitTimer;
-    float patrolWaitDuration;
+
+    // Squad orders (valid while inSquad)
+    bool inSquad;
+    sf::Vector2f squadWaypoint;
+    bool hasSquadRallyPoint;
+    sf::Vector2f squadRallyPoint;
 
     // AI targeting (for future implementation)
     sf::Vector2f targetPosition;
 
-    // Textures and sprites
-    sf::Texture placeholder;
-    sf::Texture bodyTexture;
-    sf::Texture barrelTexture;
-    sf::Sprite body;
-    sf::Sprite barrel;
+#ifndef HEADLESS_SERVER
+    // Shared textures (AssetManager) and sprites (empty without sprites)
+    std::shared_ptr<const sf::Texture> bodyTexture;
+    std::shared_ptr<const sf::Texture> barrelTexture;
+    std::optional<sf::Sprite> body;
+    std::optional<sf::Sprite> barrel;
 
-    // Color string for texture loading
-    std::string colorString;
+    bool showHealthBar;             // Health bar visibility
 
-    // Health bar visualization
-    std::unique_ptr<HealthBarRenderer> healthBarRenderer;
-    bool showHealthBar;
+    void InitializeTextures();
+    void InitializeSprites();
+#endif
 
     // Helper methods
-    void InitializeTextures();
+    const Archetype& Stats() const { return ARCHETYPES[static_cast<size_t>(enemyType)]; }
     void InitializeStats();
-    std::string GetColorStringFromType(EnemyType type) const;
     bool IsValidDeltaTime(float dt) const;
     bool IsValidPosition(sf::Vector2f pos) const;
 
     // AI utility functions
-    float CalculateDistanceTo(sf::Vector2f targetPos) const;
     float CalculateAngleTo(sf::Vector2f targetPos) const;
     sf::Vector2f GetDirectionTo(sf::Vector2f targetPos) const;
 
     // AI decision-making
     void UpdateAIBehavior(float dt);
+    void UpdateReducedAI(float dt);
     bool IsTargetInRange(float range) const;
     bool ShouldRetreat() const;
     bool ShouldChaseTarget() const;
@@ -226,6 +336,7 @@ private:
 
     // Obstacle avoidance
     void MoveTowardsWithAvoidance(sf::Vector2f targetPos, float dt);
+    void MoveAlongFlowField(sf::Vector2f targetPos, float dt);
     bool IsPositionSafe(sf::Vector2f pos) const;
     bool WillCollideWithBoundary(float lookAheadTime) const;
     sf::Vector2f GetSafeDirection() const;
@@ -234,10 +345,8 @@ private:
     void InitializeAIParameters();
 
     // Shooting helpers
-    sf::Vector2f CalculateLeadTarget(sf::Vector2f targetPos, sf::Vector2f targetVel, float bulletSpeed) const;
     void InitializeShootingParameters();
 
-    sf::Vector2f CalculateSafeRetreatPosition(sf::Vector2f threatPos) const;
     sf::Vector2f GenerateSafeInteriorPosition() const;
     sf::Vector2f SelectSafeCorner() const;
 };
\ No newline at end of file
@@ -1,9 +1,10 @@
 #include "HealthBarRenderer.h"
+#include "sprite_batch.h"
 #include <algorithm>
 #include <cmath>
 
 /**
- * Constructs health bar: sets dimensions, styles shapes for visual health display.
+ * Constructs health bar style: dimensions and colors shared by every bar drawn.
  * @param barWidth Float width of bar for sizing.
  * @param barHeight Float height of bar for sizing.
  * @param offsetY Float vertical offset above entity.
@@ -14,67 +15,58 @@ HealthBarRenderer::HealthBarRenderer(float barWidth, float barHeight, float offs
     , offsetY(offsetY)
     , showBackground(true)
     , showBorder(true)
+    , backgroundColor(40, 40, 40, 200)          // Dark gray, semi-transparent
+    , borderColor(255, 255, 255, 150)           // White, semi-transparent
     , borderThickness(1.0f)
 {
-    // Initialize background bar (dark gray, semi-transparent)
-    backgroundBar.setSize(sf::Vector2f(barWidth, barHeight));
-    backgroundBar.setFillColor(sf::Color(40, 40, 40, 200));
-    backgroundBar.setOrigin(sf::Vector2f(barWidth / 2.0f, barHeight / 2.0f));
-    // Initialize health bar (will be colored based on health %)
-    healthBar.setSize(sf::Vector2f(barWidth, barHeight));
-    healthBar.setFillColor(sf::Color::Green);
-    healthBar.setOrigin(sf::Vector2f(barWidth / 2.0f, barHeight / 2.0f));
-    // Initialize border outline (white, semi-transparent)
-    borderBar.setSize(sf::Vector2f(barWidth + borderThickness * 2, barHeight + borderThickness * 2));
-    borderBar.setFillColor(sf::Color::Transparent);
-    borderBar.setOutlineColor(sf::Color(255, 255, 255, 150));
-    borderBar.setOutlineThickness(borderThickness);
-    borderBar.setOrigin(sf::Vector2f((barWidth + borderThickness * 2) / 2.0f,
-        (barHeight + borderThickness * 2) / 2.0f));
 }
 
 /**
- * Destructs health bar: no manual cleanup needed per SFML RAII.
+ * Destructs health bar: nothing to clean up, the style owns no resources.
  */
 HealthBarRenderer::~HealthBarRenderer() {
-    // Nothing to clean up (SFML shapes manage their own memory)
 }
 
 /**
- * Draws health bar above entity: updates size/color, renders layers for UI feedback.
- * @param window RenderWindow ref for drawing.
+ * Queues the bar as solid quads, back to front: the border outline as four
+ * edges, then the background and the health fill, which shrinks toward its centre.
+ * @param batch SpriteBatch collecting this frame's UI layer.
  * @param entityPosition Vector2f position of entity.
  * @param currentHealth Float current health value.
  * @param maxHealth Float maximum health value.
  */
-void HealthBarRenderer::Render(sf::RenderWindow& window, sf::Vector2f entityPosition,
-    float currentHealth, float maxHealth) {
-    // Validate inputs
+void HealthBarRenderer::Submit(SpriteBatch& batch, sf::Vector2f entityPosition,
+    float currentHealth, float maxHealth) const {
     if (!IsValidHealth(currentHealth, maxHealth)) {
-        return; // Skip rendering for invalid health values
+        return;
     }
-    // Calculate health percentage (clamped to 0-1)
-    float healthPercentage = std::max(0.0f, std::min(1.0f, currentHealth / maxHealth));
-    // Update positions relative to entity
-    UpdatePositions(entityPosition);
-    // Update health bar width based on current health
-    float currentBarWidth = barWidth * healthPercentage;
-    healthBar.setSize(sf::Vector2f(currentBarWidth, barHeight));
-    healthBar.setOrigin(sf::Vector2f(currentBarWidth / 2.0f, barHeight / 2.0f));
-    // Update health bar color based on percentage
-    healthBar.setFillColor(GetHealthColor(healthPercentage));
-    // Render layers (back to front)
+    const float healthPercentage = std::max(0.0f, std::min(1.0f, currentHealth / maxHealth));
+    const sf::Vector2f center(entityPosition.x, entityPosition.y + offsetY);
+
     if (showBorder) {
-        window.draw(borderBar);
+        // The outline sits outside a rect borderThickness larger than the bar on each side
+        const sf::Vector2f outer(barWidth + borderThickness * 4.0f, barHeight + borderThickness * 4.0f);
+        const sf::Vector2f leftTop = center - outer / 2.0f;
+        const sf::Color color = borderColor;
+        batch.AddRect(RenderLayer::UI, sf::FloatRect(leftTop, { outer.x, borderThickness }), color);
+        batch.AddRect(RenderLayer::UI, sf::FloatRect({ leftTop.x, leftTop.y + outer.y - borderThickness },
+            { outer.x, borderThickness }), color);
+        batch.AddRect(RenderLayer::UI, sf::FloatRect({ leftTop.x, leftTop.y + borderThickness },
+            { borderThickness, outer.y - borderThickness * 2.0f }), color);
+        batch.AddRect(RenderLayer::UI, sf::FloatRect({ leftTop.x + outer.x - borderThickness, leftTop.y + borderThickness },
+            { borderThickness, outer.y - borderThickness * 2.0f }), color);
     }
     if (showBackground) {
-        window.draw(backgroundBar);
+        batch.AddRect(RenderLayer::UI, sf::FloatRect({ center.x - barWidth / 2.0f, center.y - barHeight / 2.0f },
+            { barWidth, barHeight }), backgroundColor);
     }
-    window.draw(healthBar);
+    const float currentBarWidth = barWidth * healthPercentage;
+    batch.AddRect(RenderLayer::UI, sf::FloatRect({ center.x - currentBarWidth / 2.0f, center.y - barHeight / 2.0f },
+        { currentBarWidth, barHeight }), GetHealthColor(healthPercentage));
 }
 
 /**
- * Updates bar dimensions: resizes shapes for customizable UI scaling.
+ * Updates bar dimensions for customizable UI scaling.
  * @param width Positive float new width.
  * @param height Positive float new height.
  */
@@ -84,14 +76,6 @@ void HealthBarRenderer::SetDimensions(float width, float height) {
     }
     barWidth = width;
     barHeight = height;
-    // Update shape sizes
-    backgroundBar.setSize(sf::Vector2f(barWidth, barHeight));
-    backgroundBar.setOrigin(sf::Vector2f(barWidth / 2.0f, barHeight / 2.0f));
-    healthBar.setSize(sf::Vector2f(barWidth, barHeight));
-    healthBar.setOrigin(sf::Vector2f(barWidth / 2.0f, barHeight / 2.0f));
-    borderBar.setSize(sf::Vector2f(barWidth + borderThickness * 2, barHeight + borderThickness * 2));
-    borderBar.setOrigin(sf::Vector2f((barWidth + borderThickness * 2) / 2.0f,
-        (barHeight + borderThickness * 2) / 2.0f));
 }
 
 /**
@@ -131,19 +115,6 @@ sf::Color HealthBarRenderer::GetHealthColor(float healthPercentage) const {
     }
 }
 
-/**
- * Syncs shape positions: centers above entity for dynamic tracking.
- * @param entityPosition Vector2f current entity coords.
- */
-void HealthBarRenderer::UpdatePositions(sf::Vector2f entityPosition) {
-    // Calculate health bar position (centered above entity)
-    sf::Vector2f barPosition(entityPosition.x, entityPosition.y + offsetY);
-    // Update all shape positions
-    backgroundBar.setPosition(barPosition);
-    healthBar.setPosition(barPosition);
-    borderBar.setPosition(barPosition);
-}
-
 /**
  * Checks health validity: ensures finite, positive max, non-negative current.
  * @param current Float current health.
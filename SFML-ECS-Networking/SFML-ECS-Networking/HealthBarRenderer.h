@@ -1,5 +1,10 @@
 #pragma once
 #include <SFML/Graphics.hpp>
+class SpriteBatch;
+
+// Health bar pass shared by every entity: holds only the style, and writes
+// each bar as solid quads into the sprite batch's UI layer, so all bars on
+// screen are one vertex array and one draw.
 class HealthBarRenderer {
 public:
     /**
@@ -12,14 +17,14 @@ public:
     ~HealthBarRenderer();
 
     /**
-     * Render a health bar above an entity
-     * @param window SFML render window
+     * Queue a health bar above an entity on the batch's UI layer
+     * @param batch Sprite batch collecting this frame
      * @param entityPosition World position of the entity (center point)
      * @param currentHealth Current health value
      * @param maxHealth Maximum health value
      */
-    void Render(sf::RenderWindow& window, sf::Vector2f entityPosition,
-        float currentHealth, float maxHealth);
+    void Submit(SpriteBatch& batch, sf::Vector2f entityPosition,
+        float currentHealth, float maxHealth) const;
 
     /**
      * Set custom dimensions for the health bar
@@ -51,12 +56,9 @@ private:
     bool showBackground;
     bool showBorder;
 
-    // Rendering components
-    sf::RectangleShape backgroundBar;  // Dark background
-    sf::RectangleShape healthBar;      // Colored health indicator
-    sf::RectangleShape borderBar;      // Border outline
-
-    // Border styling
+    // Colors and border styling
+    sf::Color backgroundColor;         // Dark background
+    sf::Color borderColor;             // Border outline
     float borderThickness;
 
     /**
@@ -65,11 +67,6 @@ private:
      */
     sf::Color GetHealthColor(float healthPercentage) const;
 
-    /**
-     * Update shape positions relative to entity
-     */
-    void UpdatePositions(sf::Vector2f entityPosition);
-
     /**
      * Validate health values to prevent rendering errors
      */
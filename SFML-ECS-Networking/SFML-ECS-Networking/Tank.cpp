@@ -1,7 +1,10 @@
 ﻿#include "Tank.h"
 #include "utils.h" // For Utils::printMsg
-#include "HealthBarRenderer.h"  // For health bar visualization
 #include "world_constants.h"    // For TANK_RADIUS
+#include "tank_movement.h"      // Movement shared with the server
+#include "AssetManager.h"       // Shared textures and fonts
+#include "sprite_batch.h"       // Batched rendering
+#include "tank_batch.h"
 #include <iostream>
 #include <cmath>
 #include <limits>
@@ -24,27 +27,16 @@ Tank::Tank(std::string colour) : Tank(colour, "") {
  * @param playerName The player's name to display
  */
 Tank::Tank(std::string colour, const std::string& playerName)
-    : body(placeholder), barrel(placeholder),  // Initialize sprites with placeholder
+    : body(AssetManager::Instance().GetPlaceholderTexture()),  // Initialize sprites with placeholder
+    barrel(AssetManager::Instance().GetPlaceholderTexture()),
     shootCooldown(0.0f),                     // Can shoot immediately
     shootCooldownTime(1.0f),                 // 1 second between shots
     barrelLength(30.0f),                     // Barrel length for spawn position
     maxHealth(100.0f),                       // NEW: Starting max health
     currentHealth(100.0f),                   // NEW: Starting at full health
-    healthBarRenderer(std::make_unique<HealthBarRenderer>(50.0f, 6.0f, -40.0f)),  // NEW: Health bar (width, height, offset)
     showHealthBar(true),                     // NEW: Show health bar by default
     collisionRadius(WorldConstants::TANK_RADIUS)  // NEW: Collision radius from constants
 {
-    // Initialize placeholder texture (1x1 white pixel to avoid white square)
-    try {
-        std::vector<std::uint8_t> placeholderPixels = { 255, 255, 255, 255 }; // 1x1 white pixel (RGBA)
-        if (!placeholder.loadFromMemory(placeholderPixels.data(), placeholderPixels.size())) {
-            Utils::printMsg("Error: Failed to create placeholder texture", error);
-        }
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception creating placeholder texture - " + std::string(e.what()), error);
-    }
-
     // Validate colour string
     if (!IsValidString(colour)) {
         Utils::printMsg("Error: Invalid tank colour string", error);
@@ -63,41 +55,15 @@ Tank::Tank(std::string colour, const std::string& playerName)
         this->playerName = playerName;
     }
 
-    // Load textures with error handling
-    try {
-        if (!bodyTexture.loadFromFile("Assets/" + colorString + "Tank.png")) {
-            Utils::printMsg("Warning: Could not load tank body texture for " + colorString, warning);
-            body.setTexture(placeholder); // Use placeholder
-        }
-        else {
-            body.setTexture(bodyTexture); // Update body sprite texture
-            Utils::printMsg("✓ Loaded tank body texture for " + colorString);
-        }
-        if (!barrelTexture.loadFromFile("Assets/" + colorString + "Barrel.png")) {
-            Utils::printMsg("Warning: Could not load tank barrel texture for " + colorString, warning);
-            barrel.setTexture(placeholder); // Use placeholder
-        }
-        else {
-            barrel.setTexture(barrelTexture); // Update barrel sprite texture
-            Utils::printMsg("✓ Loaded tank barrel texture for " + colorString);
-        }
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception loading textures - " + std::string(e.what()), error);
-        body.setTexture(placeholder);
-        barrel.setTexture(placeholder);
-    }
-
-    // Set texture rectangles - SFML 3.0 syntax
-    try {
-        sf::Vector2u bodySize = bodyTexture.getSize();
-        sf::Vector2u barrelSize = barrelTexture.getSize();
-        body.setTextureRect(sf::IntRect({ 0, 0 }, { static_cast<int>(bodySize.x), static_cast<int>(bodySize.y) }));
-        barrel.setTextureRect(sf::IntRect({ 0, 0 }, { static_cast<int>(barrelSize.x), static_cast<int>(barrelSize.y) }));
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception setting texture rectangles - " + std::string(e.what()), error);
-    }
+    // Shared textures: atlas regions when packed, placeholder if the file is missing
+    const AssetManager::SpriteRegion bodyRegion = AssetManager::Instance().LoadSprite("Assets/" + colorString + "Tank.png");
+    const AssetManager::SpriteRegion barrelRegion = AssetManager::Instance().LoadSprite("Assets/" + colorString + "Barrel.png");
+    bodyTexture = bodyRegion.texture;
+    barrelTexture = barrelRegion.texture;
+    body.setTexture(*bodyTexture);
+    barrel.setTexture(*barrelTexture);
+    body.setTextureRect(bodyRegion.rect);
+    barrel.setTextureRect(barrelRegion.rect);
 
     // Set sprite origins - SFML 3.0 syntax
     try {
@@ -146,30 +112,20 @@ void Tank::InitializeNameLabel() {
     // Initialize pointer
     nameLabel = nullptr;
 
-    // Try to load a font from multiple sources
-    try {
-        fontLoaded = nameFont.openFromFile("C:/Windows/Fonts/arial.ttf");
-        if (!fontLoaded) {
-            fontLoaded = nameFont.openFromFile("C:/Windows/Fonts/calibri.ttf");
-        }
-        if (!fontLoaded) {
-            fontLoaded = nameFont.openFromFile("/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf");
-        }
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Error: Exception loading font - " + std::string(e.what()), error);
-        fontLoaded = false;
-    }
+    // Shared font, opened once for every tank (tries several system fonts)
+    nameFont = AssetManager::Instance().LoadDefaultFont();
+    fontLoaded = nameFont != nullptr;
 
     // Create text object if font loaded and player name is not empty
     if (fontLoaded && !playerName.empty()) {
         try {
-            nameLabel = new sf::Text(nameFont); // Use sf::Text(const sf::Font&)
+            nameLabel = new sf::Text(*nameFont); // Use sf::Text(const sf::Font&)
             nameLabel->setString(playerName);
             nameLabel->setCharacterSize(16);
             nameLabel->setFillColor(sf::Color::White);
             nameLabel->setOutlineColor(sf::Color::Black);
             nameLabel->setOutlineThickness(1.0f);
+            LayoutNameLabel();
             UpdateNameLabelPosition();
             Utils::printMsg("✓ Name label created for: " + playerName);
         }
@@ -201,10 +157,14 @@ void Tank::SetPlayerName(const std::string& name) {
         return;
     }
 
+    if (name == playerName) {
+        return; // Label geometry is only rebuilt when the name actually changes
+    }
     playerName = name;
     if (fontLoaded && nameLabel) {
         try {
             nameLabel->setString(playerName);
+            LayoutNameLabel();
             UpdateNameLabelPosition();
             Utils::printMsg("Updated player name to: " + playerName);
         }
@@ -216,13 +176,22 @@ void Tank::SetPlayerName(const std::string& name) {
 }
 
 /**
- * Updates the position of the name label above the tank.
+ * Centres the name label's origin on its text. The text's geometry and bounds
+ * only change with the string, so this runs on name changes, not every frame.
+ */
+void Tank::LayoutNameLabel() {
+    if (fontLoaded && nameLabel) {
+        sf::FloatRect textBounds = nameLabel->getLocalBounds();
+        nameLabel->setOrigin({ textBounds.position.x + textBounds.size.x / 2.0f, textBounds.position.y + textBounds.size.y / 2.0f });
+    }
+}
+
+/**
+ * Updates the position of the name label above the tank (transform only).
  */
 void Tank::UpdateNameLabelPosition() {
     if (fontLoaded && showNameLabel && nameLabel) {
         try {
-            sf::FloatRect textBounds = nameLabel->getLocalBounds();
-            nameLabel->setOrigin({ textBounds.position.x + textBounds.size.x / 2.0f, textBounds.position.y + textBounds.size.y / 2.0f });
             nameLabel->setPosition({ position.x, position.y - 45.0f });
         }
         catch (const std::exception& e) {
@@ -232,6 +201,19 @@ void Tank::UpdateNameLabelPosition() {
     }
 }
 
+/**
+ * Turns and moves the body from the held keys with the same kernel the server
+ * runs, so local movement and server state never disagree.
+ * @param dt Delta time for frame-independent movement
+ */
+void Tank::ApplyMovement(float dt) {
+    const TankMovement::Input movement{ isMoving.forward, isMoving.backward, isMoving.left, isMoving.right };
+    const TankMovement::Transform moved = TankMovement::Step(
+        { position.x, position.y, bodyRotation.asDegrees() }, movement, dt);
+    position = sf::Vector2f(moved.x, moved.y);
+    bodyRotation = sf::degrees(moved.rotationDegrees);
+}
+
 /**
  * Updates the tank's position and rotation based on input and delta time.
  * Uses network-driven barrel rotation (for remote players or fallback).
@@ -261,35 +243,7 @@ void Tank::Update(float dt) {
             }
         }
 
-        // Update rotation angle based on input
-        if (isMoving.left) {
-            bodyRotation -= sf::degrees(rotationSpeed * dt);
-        }
-        if (isMoving.right) {
-            bodyRotation += sf::degrees(rotationSpeed * dt);
-        }
-
-        // Normalize rotation to 0-360 like server
-        float bodyRotDegrees = bodyRotation.asDegrees();
-        while (bodyRotDegrees < 0.0f) {
-            bodyRotDegrees += 360.0f;
-        }
-        while (bodyRotDegrees >= 360.0f) {
-            bodyRotDegrees -= 360.0f;
-        }
-        bodyRotation = sf::degrees(bodyRotDegrees);
-
-        // Calculate direction vector - use same math as server
-        float radians = bodyRotDegrees * 3.14159f / 180.0f;
-        sf::Vector2f body_direction = { std::cos(radians), std::sin(radians) };
-
-        // Update position based on input and direction
-        if (isMoving.forward) {
-            position += body_direction * movementSpeed * dt;
-        }
-        if (isMoving.backward) {
-            position -= body_direction * movementSpeed * dt;
-        }
+        ApplyMovement(dt);
 
         // Update barrel rotation (fallback: follow body rotation)
         barrelRotation = bodyRotation; // Used for remote players or fallback
@@ -332,35 +286,7 @@ void Tank::Update(float dt, sf::Vector2f mousePos, bool isLocalPlayer) {
             }
         }
 
-        // Update body rotation and position (same as original Update)
-        if (isMoving.left) {
-            bodyRotation -= sf::degrees(rotationSpeed * dt);
-        }
-        if (isMoving.right) {
-            bodyRotation += sf::degrees(rotationSpeed * dt);
-        }
-
-        // Normalize rotation to 0-360 like server
-        float bodyRotDegrees = bodyRotation.asDegrees();
-        while (bodyRotDegrees < 0.0f) {
-            bodyRotDegrees += 360.0f;
-        }
-        while (bodyRotDegrees >= 360.0f) {
-            bodyRotDegrees -= 360.0f;
-        }
-        bodyRotation = sf::degrees(bodyRotDegrees);
-
-        // Calculate direction vector - use same math as server
-        float radians = bodyRotDegrees * 3.14159f / 180.0f;
-        sf::Vector2f body_direction = { std::cos(radians), std::sin(radians) };
-
-        // Update position based on input and direction
-        if (isMoving.forward) {
-            position += body_direction * movementSpeed * dt;
-        }
-        if (isMoving.backward) {
-            position -= body_direction * movementSpeed * dt;
-        }
+        ApplyMovement(dt);
 
         // Update barrel rotation
         if (isLocalPlayer) {
@@ -435,11 +361,6 @@ void Tank::Render(sf::RenderWindow& window) {
         window.draw(body);
         window.draw(barrel);
 
-        // Render health bar above tank
-        if (showHealthBar && healthBarRenderer) {
-            healthBarRenderer->Render(window, position, currentHealth, maxHealth);
-        }
-
         // Render player name above health bar
         if (fontLoaded && showNameLabel && nameLabel && !playerName.empty()) {
             window.draw(*nameLabel);
@@ -450,6 +371,40 @@ void Tank::Render(sf::RenderWindow& window) {
     }
 }
 
+void Tank::SubmitTo(SpriteBatch& batch) const {
+    batch.AddSprite(RenderLayer::BODIES, body);
+    batch.AddSprite(RenderLayer::BARRELS, barrel);
+}
+
+bool Tank::SubmitTo(TankBatch& batch) const {
+    return batch.AddTank(body, barrel, body.getPosition(), body.getRotation(), barrel.getRotation());
+}
+
+void Tank::RenderNameLabel(sf::RenderTarget& target) const {
+    if (fontLoaded && showNameLabel && nameLabel && !playerName.empty()) {
+        target.draw(*nameLabel);
+    }
+}
+
+/**
+ * Moves the sprites and name label to the given pose without touching the
+ * simulated position or rotation. The barrel keeps its own aim.
+ * @param renderPosition Position to draw at
+ * @param renderBodyRotation Body rotation to draw with
+ */
+void Tank::SetRenderState(sf::Vector2f renderPosition, sf::Angle renderBodyRotation) {
+    if (!IsValidPosition(renderPosition)) {
+        return;
+    }
+    body.setPosition(renderPosition);
+    barrel.setPosition(renderPosition);
+    body.setRotation(renderBodyRotation);
+    barrel.setRotation(barrelRotation);
+    if (fontLoaded && showNameLabel && nameLabel) {
+        nameLabel->setPosition({ renderPosition.x, renderPosition.y - 45.0f });
+    }
+}
+
 /**
  * Validates that delta time is positive and finite.
  * @param dt Delta time
@@ -494,10 +449,17 @@ bool Tank::IsValidString(const std::string& str) const {
  * @param bullets Reference to bullet container (bullets will be added here)
  */
 void Tank::Shoot(std::vector<std::unique_ptr<Bullet>>& bullets) {
+    std::unique_ptr<Bullet> bullet = Fire();
+    if (bullet) {
+        bullets.push_back(std::move(bullet));
+    }
+}
+
+std::unique_ptr<Bullet> Tank::Fire(std::unique_ptr<Bullet> recycled) {
     // Check cooldown with debug logging
     if (!CanShoot()) {
         Utils::printMsg("Cannot shoot - cooldown remaining: " + std::to_string(shootCooldown) + "s", debug);
-        return;  // Still on cooldown
+        return nullptr;  // Still on cooldown
     }
 
     try {
@@ -514,25 +476,30 @@ void Tank::Shoot(std::vector<std::unique_ptr<Bullet>>& bullets) {
 
         // Create bullet
         // Note: ownerId will be set by the caller (client or server)
-        auto bullet = std::make_unique<Bullet>(
-            Bullet::BulletType::PLAYER_STANDARD,
-            spawnPos,
-            barrelDirection,
-            0  // ownerId placeholder (set by network code)
-        );
-
-        // Add to bullets container
-        bullets.push_back(std::move(bullet));
+        std::unique_ptr<Bullet> bullet = std::move(recycled);
+        if (bullet) {
+            bullet->Reset(Bullet::BulletType::PLAYER_STANDARD, spawnPos, barrelDirection, 0);
+        }
+        else {
+            bullet = std::make_unique<Bullet>(
+                Bullet::BulletType::PLAYER_STANDARD,
+                spawnPos,
+                barrelDirection,
+                0  // ownerId placeholder (set by network code)
+            );
+        }
 
         // Start cooldown
         shootCooldown = shootCooldownTime;
 
         Utils::printMsg("Tank fired! Cooldown set to: " + std::to_string(shootCooldown) +
             "s (cooldownTime: " + std::to_string(shootCooldownTime) + "s)", success);
+        return bullet;
     }
     catch (const std::exception& e) {
         Utils::printMsg("Error: Exception in Shoot - " + std::string(e.what()), error);
     }
+    return nullptr;
 }
 
 
@@ -6,7 +6,8 @@
 #include "Bullet.h"  // For shooting mechanics
 
 // Forward declaration to avoid circular dependency
-class HealthBarRenderer;
+class SpriteBatch;
+class TankBatch;
 
 
 
@@ -28,9 +29,22 @@ public:
 
     // Update sprite positions and rotations without movement logic
     void UpdateSprites();
-
-    // Render tank and name label to the provided window
+    // Place the sprites and name label at a drawn pose that differs from the
+    // simulated one (e.g. blended between two prediction steps); position and
+    // bodyRotation are left untouched
+    void SetRenderState(sf::Vector2f renderPosition, sf::Angle renderBodyRotation);
+    // Where the sprites were last placed
+    sf::Vector2f GetRenderPosition() const { return body.getPosition(); }
+
+    // Render tank and name label to the provided window (the health bar is
+    // drawn by the owner's HealthBarRenderer pass)
     void Render(sf::RenderWindow& window);
+    // Batched rendering: body and barrel go into the batch's layers; the name
+    // label is text and is drawn separately, after the batch
+    void SubmitTo(SpriteBatch& batch) const;
+    // Shader-drawn instead (see TankBatch); false if the batch could not take it
+    bool SubmitTo(TankBatch& batch) const;
+    void RenderNameLabel(sf::RenderTarget& target) const;
 
     // Player name management
     void SetPlayerName(const std::string& name);
@@ -45,6 +59,9 @@ public:
     float GetHealthPercentage() const { return currentHealth / maxHealth; }
     void SetHealth(float health);
     void SetMaxHealth(float max);
+    // The bar itself is drawn by the owner's shared HealthBarRenderer pass
+    bool IsHealthBarVisible() const { return showHealthBar; }
+    void SetHealthBarVisible(bool visible) { showHealthBar = visible; }
 
     // Collision detection helper
     float GetRadius() const { return collisionRadius; }
@@ -60,6 +77,9 @@ public:
         bool right = false;
     } isMoving; // Movement flags
     void Shoot(std::vector<std::unique_ptr<Bullet>>& bullets);
+    // Same as Shoot, handing the bullet back instead (null while on cooldown).
+    // A recycled bullet is reset and returned instead of allocating a new one.
+    std::unique_ptr<Bullet> Fire(std::unique_ptr<Bullet> recycled = nullptr);
     bool CanShoot() const { return shootCooldown <= 0.0f; }
     float GetShootCooldown() const { return shootCooldown; }
     sf::Vector2f GetBarrelEndPosition() const;  // Where bullets spawn
@@ -67,9 +87,11 @@ public:
 private:
     // Name display
     void InitializeNameLabel(); // Initializes the name label with font
+    void LayoutNameLabel(); // Centres the label's origin; only needed when the name changes
     void UpdateNameLabelPosition(); // Updates the position of the name label
+    void ApplyMovement(float dt); // Body turn and move (TankMovement kernel)
     std::string playerName = ""; // Player's name
-    sf::Font nameFont; // Font for name label
+    std::shared_ptr<const sf::Font> nameFont; // Shared font for name label (AssetManager)
     sf::Text* nameLabel = nullptr; // Dynamic text for name display
     bool fontLoaded = false; // Tracks if font was loaded successfully
     bool showNameLabel = true; // Controls name label visibility
@@ -80,20 +102,16 @@ private:
     // Health system
     float maxHealth;               // Maximum health points
     float currentHealth;           // Current health points
-    std::unique_ptr<HealthBarRenderer> healthBarRenderer;  // Health bar visualization
     bool showHealthBar;            // Controls health bar visibility
     float collisionRadius;         // Radius for collision detection (same as world constants)
 
     // Tank textures and sprites
-    sf::Texture placeholder; // Fallback texture (1x1 white pixel)
-    sf::Texture bodyTexture; // Tank body texture
-    sf::Texture barrelTexture; // Tank barrel texture
+    std::shared_ptr<const sf::Texture> bodyTexture; // Shared tank body texture (AssetManager)
+    std::shared_ptr<const sf::Texture> barrelTexture; // Shared tank barrel texture (AssetManager)
     sf::Sprite body; // Tank body sprite (initialized in constructor)
     sf::Sprite barrel; // Tank barrel sprite (initialized in constructor)
 
     // Movement properties
-    float movementSpeed = 150.f; // Tank movement speed
-    float rotationSpeed = 200.f; // Tank rotation speed
     float barrelRotationSpeed = 200.f; // Barrel rotation speed
 
     // Tank colour
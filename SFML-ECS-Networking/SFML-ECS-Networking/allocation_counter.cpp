@@ -0,0 +1,79 @@
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> allocationCount(0);
+#if ALLOCATION_TRACKING_ENABLED
+    // Constant-initialized, so reading it from operator new never allocates
+    thread_local AllocationCounter::ScopeCounter* currentScope = nullptr;
+#endif
+
+    void* CountedAllocate(std::size_t size) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+#if ALLOCATION_TRACKING_ENABLED
+        if (currentScope) {
+            currentScope->fetch_add(1, std::memory_order_relaxed);
+        }
+#endif
+        if (size == 0) {
+            size = 1;
+        }
+        while (true) {
+            if (void* memory = std::malloc(size)) {
+                return memory;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+}
+
+uint64_t AllocationCounter::GetCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+#if ALLOCATION_TRACKING_ENABLED
+AllocationCounter::Scope::Scope(ScopeCounter* counter) : previous(currentScope) {
+    currentScope = counter;
+}
+
+AllocationCounter::Scope::~Scope() {
+    currentScope = previous;
+}
+
+AllocationCounter::ScopeCounter* AllocationCounter::GetCurrentScope() {
+    return currentScope;
+}
+#endif
+
+// Replacements for the global allocation functions. The nothrow forms fall back
+// to these by default; over-aligned allocations keep the runtime's own versions
+// and are not counted.
+void* operator new(std::size_t size) {
+    return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return CountedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
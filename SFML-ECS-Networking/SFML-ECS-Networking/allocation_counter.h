@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Counts calls to the global operator new (scalar and array, every thread), so
+// benchmarks and server stats can confirm a code path does not allocate.
+// Counting is a relaxed atomic increment in front of malloc.
+//
+// Define ALLOCATION_TRACKING_ENABLED 1 (in every translation unit) for the
+// hot-path audit build: each allocation is also added to the counter of the
+// innermost Scope open on the allocating thread. The tick and frame phase
+// timers open one per phase, and JobSystem carries the caller's scope over to
+// its workers, so the profilers report allocations per phase. Otherwise Scope
+// compiles to nothing.
+#ifndef ALLOCATION_TRACKING_ENABLED
+#define ALLOCATION_TRACKING_ENABLED 0
+#endif
+
+namespace AllocationCounter {
+    using ScopeCounter = std::atomic<uint64_t>;
+
+    uint64_t GetCount();
+
+#if ALLOCATION_TRACKING_ENABLED
+    // Attributes this thread's allocations to counter until destroyed
+    // (nullptr: to none), then restores the enclosing scope
+    class Scope {
+    public:
+        explicit Scope(ScopeCounter* counter);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ScopeCounter* previous;
+    };
+
+    ScopeCounter* GetCurrentScope();
+#else
+    class Scope {
+    public:
+        explicit Scope(ScopeCounter*) {}
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    inline ScopeCounter* GetCurrentScope() { return nullptr; }
+#endif
+}
@@ -0,0 +1,280 @@
+#include "asset_archive.h"
+#include "utils.h"
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Bounds-checked reads from the mapped index
+    class IndexReader {
+    public:
+        IndexReader(const uint8_t* data, size_t size) : data(data), size(size), offset(0), valid(true) {}
+
+        template <typename T>
+        T Read() {
+            T value{};
+            if (valid && size - offset >= sizeof(T)) {
+                std::memcpy(&value, data + offset, sizeof(T));
+                offset += sizeof(T);
+            }
+            else {
+                valid = false;
+            }
+            return value;
+        }
+
+        std::string ReadName() {
+            const uint32_t length = Read<uint32_t>();
+            if (!valid || size - offset < length) {
+                valid = false;
+                return std::string();
+            }
+            std::string name(reinterpret_cast<const char*>(data + offset), length);
+            offset += length;
+            return name;
+        }
+
+        bool IsValid() const { return valid; }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t offset;
+        bool valid;
+    };
+
+    template <typename T>
+    void WriteValue(std::ofstream& out, T value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void WriteName(std::ofstream& out, const std::string& name) {
+        WriteValue(out, static_cast<uint32_t>(name.size()));
+        out.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+
+    uint64_t AlignUp(uint64_t offset) {
+        return (offset + AssetArchive::DATA_ALIGNMENT - 1) / AssetArchive::DATA_ALIGNMENT * AssetArchive::DATA_ALIGNMENT;
+    }
+}
+
+AssetArchive::AssetArchive()
+    : mappedData(nullptr), mappedSize(0),
+#ifdef _WIN32
+    fileHandle(nullptr), mappingHandle(nullptr)
+#else
+    fileDescriptor(-1)
+#endif
+{
+}
+
+AssetArchive::~AssetArchive() {
+    Close();
+}
+
+bool AssetArchive::Open(const std::string& path) {
+    Close();
+    if (!Map(path)) {
+        return false;
+    }
+    if (!ReadIndex()) {
+        Utils::printMsg("Warning: " + path + " is not a valid asset archive", warning);
+        Close();
+        return false;
+    }
+    Utils::printMsg("Mapped asset archive " + path + ": " + std::to_string(entries.size()) + " files, " +
+        std::to_string(mappedSize / 1024) + " KB", debug);
+    return true;
+}
+
+void AssetArchive::Close() {
+#ifdef _WIN32
+    if (mappedData) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    if (mappedData) {
+        munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+    }
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+    fileDescriptor = -1;
+#endif
+    mappedData = nullptr;
+    mappedSize = 0;
+    entries.clear();
+    atlasRegions.clear();
+}
+
+const AssetArchive::Entry* AssetArchive::Find(const std::string& name) const {
+    auto it = entries.find(name);
+    return it != entries.end() ? &it->second : nullptr;
+}
+
+/**
+ * Writes the index, then every file at a DATA_ALIGNMENT boundary.
+ * @param path Archive to create (overwritten)
+ * @param files Contents keyed by the path the client loads them by
+ * @param atlasRegions Layout of the ATLAS_ENTRY image, if one is among the files
+ * @return False if the file could not be written
+ */
+bool AssetArchive::Write(const std::string& path, const std::vector<PackedFile>& files,
+    const std::unordered_map<std::string, sf::IntRect>& atlasRegions) {
+    try {
+        uint64_t indexSize = 4 * sizeof(uint32_t);
+        for (const PackedFile& file : files) {
+            indexSize += sizeof(uint32_t) + file.name.size() + 2 * sizeof(uint64_t);
+        }
+        for (const auto& [name, rect] : atlasRegions) {
+            indexSize += sizeof(uint32_t) + name.size() + 4 * sizeof(int32_t);
+        }
+
+        std::vector<uint64_t> offsets;
+        offsets.reserve(files.size());
+        uint64_t offset = AlignUp(indexSize);
+        for (const PackedFile& file : files) {
+            offsets.push_back(offset);
+            offset = AlignUp(offset + file.data.size());
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            Utils::printMsg("Error: Could not create asset archive " + path, error);
+            return false;
+        }
+        WriteValue(out, MAGIC);
+        WriteValue(out, VERSION);
+        WriteValue(out, static_cast<uint32_t>(files.size()));
+        WriteValue(out, static_cast<uint32_t>(atlasRegions.size()));
+        for (size_t i = 0; i < files.size(); ++i) {
+            WriteName(out, files[i].name);
+            WriteValue(out, offsets[i]);
+            WriteValue(out, static_cast<uint64_t>(files[i].data.size()));
+        }
+        for (const auto& [name, rect] : atlasRegions) {
+            WriteName(out, name);
+            WriteValue(out, static_cast<int32_t>(rect.position.x));
+            WriteValue(out, static_cast<int32_t>(rect.position.y));
+            WriteValue(out, static_cast<int32_t>(rect.size.x));
+            WriteValue(out, static_cast<int32_t>(rect.size.y));
+        }
+
+        const char padding[DATA_ALIGNMENT] = {};
+        uint64_t written = indexSize;
+        for (size_t i = 0; i < files.size(); ++i) {
+            out.write(padding, static_cast<std::streamsize>(offsets[i] - written));
+            out.write(reinterpret_cast<const char*>(files[i].data.data()), static_cast<std::streamsize>(files[i].data.size()));
+            written = offsets[i] + files[i].data.size();
+        }
+        if (!out) {
+            Utils::printMsg("Error: Failed writing asset archive " + path, error);
+            return false;
+        }
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception writing asset archive " + path + " - " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+bool AssetArchive::Map(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        Close();
+        return false;
+    }
+    mappedData = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat fileInfo;
+    if (fstat(fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0) {
+        Close();
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapping != MAP_FAILED) {
+        mappedData = static_cast<const uint8_t*>(mapping);
+        mappedSize = static_cast<size_t>(fileInfo.st_size);
+    }
+#endif
+    if (!mappedData) {
+        Utils::printMsg("Warning: Could not memory-map " + path, warning);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Every entry must lie inside the mapping; a truncated or foreign file is
+ * rejected as a whole rather than served partially.
+ */
+bool AssetArchive::ReadIndex() {
+    IndexReader reader(mappedData, mappedSize);
+    const uint32_t magic = reader.Read<uint32_t>();
+    const uint32_t version = reader.Read<uint32_t>();
+    const uint32_t fileCount = reader.Read<uint32_t>();
+    const uint32_t regionCount = reader.Read<uint32_t>();
+    if (!reader.IsValid() || magic != MAGIC || version != VERSION) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < fileCount && reader.IsValid(); ++i) {
+        std::string name = reader.ReadName();
+        const uint64_t offset = reader.Read<uint64_t>();
+        const uint64_t size = reader.Read<uint64_t>();
+        if (offset > mappedSize || size > mappedSize - offset) {
+            return false;
+        }
+        entries[std::move(name)] = Entry{ mappedData + offset, static_cast<size_t>(size) };
+    }
+    for (uint32_t i = 0; i < regionCount && reader.IsValid(); ++i) {
+        std::string name = reader.ReadName();
+        const int32_t left = reader.Read<int32_t>();
+        const int32_t top = reader.Read<int32_t>();
+        const int32_t width = reader.Read<int32_t>();
+        const int32_t height = reader.Read<int32_t>();
+        atlasRegions[std::move(name)] = sf::IntRect({ left, top }, { width, height });
+    }
+    return reader.IsValid();
+}
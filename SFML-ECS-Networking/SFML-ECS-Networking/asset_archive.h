@@ -0,0 +1,73 @@
+#pragma once
+#include <SFML/Graphics/Rect.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Read-only view of a packed asset archive: every texture and font in one
+// file, plus a pre-composed sprite atlas and its layout. The file is
+// memory-mapped once at Open and Find hands out pointers into the mapping,
+// so decoding reads straight from the page cache.
+//
+// Layout (little-endian):
+//   u32 magic, u32 version, u32 fileCount, u32 regionCount
+//   fileCount x { u32 nameLength, name, u64 offset, u64 size }
+//   regionCount x { u32 nameLength, name, i32 left, i32 top, i32 width, i32 height }
+//   file contents, each at its offset from the start of the archive
+class AssetArchive {
+public:
+    static constexpr uint32_t MAGIC = 0x4B504754;       // "TGPK"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t DATA_ALIGNMENT = 16;
+    static constexpr const char* ATLAS_ENTRY = "<atlas>";   // PNG of the composed sprite atlas
+
+    struct Entry {
+        const void* data;
+        size_t size;
+    };
+
+    // A file to write, keyed by the path the client asks for
+    struct PackedFile {
+        std::string name;
+        std::vector<uint8_t> data;
+    };
+
+    AssetArchive();
+    ~AssetArchive();
+
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    // Maps the archive and reads its index; replaces any archive already open
+    // @return False if the file is missing or not a valid archive
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return mappedData != nullptr; }
+
+    // @return The file's bytes inside the mapping, or nullptr if it is not packed
+    const Entry* Find(const std::string& name) const;
+
+    // Atlas regions by file name (empty if no atlas was packed)
+    const std::unordered_map<std::string, sf::IntRect>& GetAtlasRegions() const { return atlasRegions; }
+    size_t GetFileCount() const { return entries.size(); }
+
+    static bool Write(const std::string& path, const std::vector<PackedFile>& files,
+        const std::unordered_map<std::string, sf::IntRect>& atlasRegions);
+
+private:
+    const uint8_t* mappedData;
+    size_t mappedSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<std::string, sf::IntRect> atlasRegions;
+
+    bool Map(const std::string& path);
+    bool ReadIndex();
+};
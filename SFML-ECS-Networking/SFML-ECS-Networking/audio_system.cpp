@@ -0,0 +1,186 @@
+#include "audio_system.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr unsigned int SAMPLE_RATE = 22050;
+    constexpr float PI = 3.14159265f;
+    constexpr float LOCAL_PRIORITY_BOOST = 2.0f;
+}
+
+// Explosions outrank shots, shots outrank impacts
+const std::array<AudioSystem::SoundDef, AudioSystem::SOUND_COUNT> AudioSystem::SOUNDS{ {
+    { "gunfire", 2.0f, 70.0f, 8 },
+    { "impact", 1.0f, 60.0f, 6 },
+    { "explosion", 4.0f, 100.0f, 4 },
+} };
+
+AudioSystem::SoundId AudioSystem::SoundFor(EffectKind kind) {
+    switch (kind) {
+    case EffectKind::BULLET_IMPACT: return IMPACT;
+    case EffectKind::TANK_EXPLOSION: return EXPLOSION;
+    case EffectKind::MUZZLE_FLASH: return GUNFIRE;
+    }
+    return IMPACT;
+}
+
+/**
+ * The inverse distance model the voices are spatialised with, so a rating
+ * matches what is heard.
+ */
+float AudioSystem::GainAt(float distance) {
+    return MIN_DISTANCE / (MIN_DISTANCE + ATTENUATION * (std::max(distance, MIN_DISTANCE) - MIN_DISTANCE));
+}
+
+void AudioSystem::Initialize() {
+    ready = false;
+    for (uint8_t id = 0; id < SOUND_COUNT; ++id) {
+        if (!LoadOrSynthesise(static_cast<SoundId>(id))) {
+            Utils::printMsg(std::string("Could not create the ") + SOUNDS[id].name + " sound, audio disabled", warning);
+            return;
+        }
+    }
+    for (Voice& voice : voices) {
+        voice.sound.emplace(buffers[GUNFIRE]);
+        voice.sound->setRelativeToListener(true);
+        voice.sound->setMinDistance(MIN_DISTANCE);
+        voice.sound->setAttenuation(ATTENUATION);
+        voice.sound->setMaxDistance(MAX_DISTANCE);
+    }
+    ready = true;
+    Utils::printMsg("Audio initialized with " + std::to_string(VOICE_COUNT) + " voices", debug);
+}
+
+/**
+ * A file in Assets/sounds replaces the built-in sound. The built-in ones are
+ * decaying noise bursts: a sharp crack for shots, a short dull knock for
+ * impacts, a long low-passed rumble for explosions, each over a low thump.
+ */
+bool AudioSystem::LoadOrSynthesise(SoundId id) {
+    const std::string path = std::string("Assets/sounds/") + SOUNDS[id].name + ".wav";
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+        if (buffers[id].loadFromFile(path) && buffers[id].getChannelCount() == 1) {
+            return true;
+        }
+        Utils::printMsg("Warning: " + path + " is not a mono sound file, using the built-in sound", warning);
+    }
+
+    struct Shape {
+        float seconds;
+        float noiseDecay;       // Per second
+        float lowPass;          // One-pole coefficient, lower is duller
+        float thumpHz;
+        float thumpDecay;
+        float thumpLevel;
+    };
+    static constexpr std::array<Shape, SOUND_COUNT> SHAPES{ {
+        { 0.18f, 30.0f, 0.6f, 120.0f, 40.0f, 0.5f },
+        { 0.12f, 45.0f, 0.3f, 200.0f, 60.0f, 0.3f },
+        { 0.9f, 4.0f, 0.08f, 55.0f, 6.0f, 0.7f },
+    } };
+    const Shape& shape = SHAPES[id];
+    const size_t sampleCount = static_cast<size_t>(shape.seconds * SAMPLE_RATE);
+    std::vector<int16_t> samples(sampleCount);
+    std::minstd_rand random(1234u + id);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    float filtered = 0.0f;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        const float t = static_cast<float>(i) / SAMPLE_RATE;
+        filtered += shape.lowPass * (noise(random) - filtered);
+        const float value = filtered * std::exp(-t * shape.noiseDecay) +
+            shape.thumpLevel * std::sin(2.0f * PI * shape.thumpHz * t) * std::exp(-t * shape.thumpDecay);
+        samples[i] = static_cast<int16_t>(std::clamp(value, -1.0f, 1.0f) * 32000.0f);
+    }
+    return buffers[id].loadFromSamples(samples.data(), samples.size(), 1, SAMPLE_RATE, { sf::SoundChannel::Mono });
+}
+
+void AudioSystem::Play(const EffectEvent& event, bool local) {
+    if (!ready) {
+        return;
+    }
+    const SoundId id = SoundFor(event.kind);
+    const sf::Vector2f offset = local ? sf::Vector2f() : event.position - listener;
+    const float distance = offset.length();
+    if (distance > MAX_DISTANCE) {
+        stats.culled++;
+        return;
+    }
+    const float rating = SOUNDS[id].priority * (local ? LOCAL_PRIORITY_BOOST : 1.0f) * GainAt(distance);
+    const size_t index = PickVoice(id, rating);
+    if (index == VOICE_COUNT) {
+        stats.dropped++;
+        return;
+    }
+
+    Voice& voice = voices[index];
+    if (voice.sound->getStatus() != sf::SoundSource::Status::Stopped) {
+        voice.sound->stop();
+        stats.stolen++;
+    }
+    if (voice.id != id) {
+        voice.sound->setBuffer(buffers[id]);
+        voice.id = id;
+    }
+    voice.rating = rating;
+    voice.sound->setPosition({ offset.x, offset.y, 0.0f });
+    voice.sound->setVolume(SOUNDS[id].volume);
+    voice.sound->play();
+    stats.played++;
+}
+
+/**
+ * A free voice, unless the sound is at its cap; otherwise the lowest rated
+ * voice (of this sound when at its cap), if the new event rates at least as
+ * high. Ties go to the new event, which is the more current.
+ */
+size_t AudioSystem::PickVoice(SoundId id, float rating) {
+    size_t freeVoice = VOICE_COUNT;
+    size_t lowest = VOICE_COUNT;
+    size_t lowestSame = VOICE_COUNT;
+    size_t sameCount = 0;
+    for (size_t i = 0; i < VOICE_COUNT; ++i) {
+        const Voice& voice = voices[i];
+        if (voice.sound->getStatus() == sf::SoundSource::Status::Stopped) {
+            if (freeVoice == VOICE_COUNT) {
+                freeVoice = i;
+            }
+            continue;
+        }
+        if (lowest == VOICE_COUNT || voice.rating < voices[lowest].rating) {
+            lowest = i;
+        }
+        if (voice.id == id) {
+            sameCount++;
+            if (lowestSame == VOICE_COUNT || voice.rating < voices[lowestSame].rating) {
+                lowestSame = i;
+            }
+        }
+    }
+    if (sameCount >= SOUNDS[id].maxVoices) {
+        return rating >= voices[lowestSame].rating ? lowestSame : VOICE_COUNT;
+    }
+    if (freeVoice != VOICE_COUNT) {
+        return freeVoice;
+    }
+    return rating >= voices[lowest].rating ? lowest : VOICE_COUNT;
+}
+
+void AudioSystem::StopAll() {
+    for (Voice& voice : voices) {
+        if (voice.sound) {
+            voice.sound->stop();
+        }
+    }
+}
+
+size_t AudioSystem::GetActiveVoiceCount() const {
+    return static_cast<size_t>(std::count_if(voices.begin(), voices.end(), [](const Voice& voice) {
+        return voice.sound && voice.sound->getStatus() != sf::SoundSource::Status::Stopped;
+    }));
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <SFML/Audio.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "particle_system.h"    // For EffectEvent
+
+// Effect sounds from the same events as the particles (EffectEvent): shots,
+// impacts and tank explosions. Buffers are made once at startup and shared;
+// sounds play on a fixed pool of voices, so a firefight neither allocates
+// nor stacks up unbounded voices. Each play is rated by its sound's priority
+// times its gain at the listener (inverse distance, as the voice is then
+// spatialised). Events beyond MAX_DISTANCE are culled; when the pool (or the
+// sound's own voice cap) is full, the voice rated lowest is stolen if the new
+// event outrates it, otherwise the event is dropped.
+class AudioSystem {
+public:
+    static constexpr size_t VOICE_COUNT = 16;
+    static constexpr float MIN_DISTANCE = 150.0f;   // World units at full gain
+    static constexpr float ATTENUATION = 1.0f;      // Inverse distance rolloff
+    static constexpr float MAX_DISTANCE = 1400.0f;  // Culled beyond
+
+    // Loads Assets/sounds/<name>.wav for each sound, or synthesises it
+    // (mono, so it can be spatialised), and creates the voices
+    void Initialize();
+    bool IsReady() const { return ready; }
+
+    // Where the sounds are heard from (the local tank, or the camera)
+    void SetListener(sf::Vector2f position) { listener = position; }
+    // Local events (own shots) are heard at the listener with higher priority
+    void Play(const EffectEvent& event, bool local = false);
+    void StopAll();
+
+    struct Stats {
+        uint64_t played = 0;
+        uint64_t culled = 0;        // Out of earshot
+        uint64_t stolen = 0;        // Cut another voice short
+        uint64_t dropped = 0;       // Every candidate voice outrated it
+    };
+    const Stats& GetStats() const { return stats; }
+    size_t GetActiveVoiceCount() const;
+
+private:
+    enum SoundId : uint8_t { GUNFIRE, IMPACT, EXPLOSION, SOUND_COUNT };
+
+    struct SoundDef {
+        const char* name;           // File stem under Assets/sounds
+        float priority;
+        float volume;               // 0-100
+        size_t maxVoices;           // Of the pool, so one sound cannot take all of it
+    };
+    static const std::array<SoundDef, SOUND_COUNT> SOUNDS;
+
+    struct Voice {
+        std::optional<sf::Sound> sound;     // sf::Sound needs a buffer to exist
+        SoundId id = GUNFIRE;
+        float rating = 0.0f;        // Priority times gain when it started
+    };
+
+    std::array<sf::SoundBuffer, SOUND_COUNT> buffers;
+    std::array<Voice, VOICE_COUNT> voices;
+    sf::Vector2f listener;
+    bool ready = false;
+    Stats stats;
+
+    static SoundId SoundFor(EffectKind kind);
+    static float GainAt(float distance);
+    bool LoadOrSynthesise(SoundId id);
+    // Index of the voice to play on, or VOICE_COUNT to drop the event
+    size_t PickVoice(SoundId id, float rating);
+};
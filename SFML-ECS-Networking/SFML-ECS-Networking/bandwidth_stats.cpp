@@ -0,0 +1,123 @@
+#include "bandwidth_stats.h"
+#include "network_messages.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+const char* GetNetMessageTypeName(uint8_t type) {
+    switch (static_cast<NetMessageType>(type)) {
+    case NetMessageType::PLAYER_JOIN: return "PLAYER_JOIN";
+    case NetMessageType::PLAYER_LEAVE: return "PLAYER_LEAVE";
+    case NetMessageType::PLAYER_UPDATE: return "PLAYER_UPDATE";
+    case NetMessageType::GAME_STATE: return "GAME_STATE";
+    case NetMessageType::PLAYER_LIST: return "PLAYER_LIST";
+    case NetMessageType::PLAYER_ID_ASSIGNMENT: return "PLAYER_ID_ASSIGNMENT";
+    case NetMessageType::PING: return "PING";
+    case NetMessageType::PONG: return "PONG";
+    case NetMessageType::PLAYER_INPUT: return "PLAYER_INPUT";
+    case NetMessageType::INPUT_ACKNOWLEDGMENT: return "INPUT_ACKNOWLEDGMENT";
+    case NetMessageType::BULLET_SPAWN: return "BULLET_SPAWN";
+    case NetMessageType::BULLET_UPDATE: return "BULLET_UPDATE";
+    case NetMessageType::BULLET_DESTROY: return "BULLET_DESTROY";
+    case NetMessageType::PLAYER_DEATH: return "PLAYER_DEATH";
+    case NetMessageType::PLAYER_RESPAWN: return "PLAYER_RESPAWN";
+    case NetMessageType::GAME_STATE_DELTA: return "GAME_STATE_DELTA";
+    case NetMessageType::INTEREST_UPDATE: return "INTEREST_UPDATE";
+    case NetMessageType::MESSAGE_BUNDLE: return "MESSAGE_BUNDLE";
+    case NetMessageType::MESSAGE_FRAGMENT: return "MESSAGE_FRAGMENT";
+    case NetMessageType::RELIABLE_MESSAGE: return "RELIABLE_MESSAGE";
+    case NetMessageType::RELIABLE_ACK: return "RELIABLE_ACK";
+    case NetMessageType::BULLET_SPAWNED: return "BULLET_SPAWNED";
+    case NetMessageType::COMPRESSED_MESSAGE: return "COMPRESSED_MESSAGE";
+    case NetMessageType::CONNECTION_REQUEST: return "CONNECTION_REQUEST";
+    case NetMessageType::CONNECTION_CHALLENGE: return "CONNECTION_CHALLENGE";
+    case NetMessageType::SPECTATE_REQUEST: return "SPECTATE_REQUEST";
+    case NetMessageType::MULTICAST_GROUP: return "MULTICAST_GROUP";
+    case NetMessageType::GROUP_STATE_ACK: return "GROUP_STATE_ACK";
+    case NetMessageType::MULTICAST_STATUS: return "MULTICAST_STATUS";
+    case NetMessageType::CHUNK_DATA: return "CHUNK_DATA";
+    case NetMessageType::JOIN_ACCEPT: return "JOIN_ACCEPT";
+    case NetMessageType::SESSION_RESUME: return "SESSION_RESUME";
+    case NetMessageType::STATE_RESYNC: return "STATE_RESYNC";
+    case NetMessageType::CLIENT_TELEMETRY: return "CLIENT_TELEMETRY";
+    default: return "Unknown";
+    }
+}
+
+std::string FormatByteRate(uint64_t bytes, double elapsedSeconds) {
+    const double rate = elapsedSeconds > 0.0 ? static_cast<double>(bytes) / elapsedSeconds : 0.0;
+    char text[32];
+    if (rate >= 1024.0) {
+        std::snprintf(text, sizeof(text), "%.1f KB/s", rate / 1024.0);
+    }
+    else {
+        std::snprintf(text, sizeof(text), "%.0f B/s", rate);
+    }
+    return text;
+}
+
+void BandwidthStats::RecordMessageSent(const sf::Packet& message) {
+    if (message.getDataSize() > 0) {
+        RecordMessageSent(static_cast<const uint8_t*>(message.getData())[0], message.getDataSize());
+    }
+}
+
+void BandwidthStats::RecordMessageReceived(const sf::Packet& message) {
+    if (message.getDataSize() > 0) {
+        RecordMessageReceived(static_cast<const uint8_t*>(message.getData())[0], message.getDataSize());
+    }
+}
+
+std::string BandwidthStats::FormatSent(double elapsedSeconds) const {
+    return Format(messagesSent, datagramsSent, elapsedSeconds);
+}
+
+std::string BandwidthStats::FormatReceived(double elapsedSeconds) const {
+    return Format(messagesReceived, datagramsReceived, elapsedSeconds);
+}
+
+/**
+ * Datagram rate and count, then each message type seen this window with its
+ * rate, share of the message bytes and count.
+ */
+std::string BandwidthStats::Format(const std::array<TrafficCounter, TYPE_SLOTS>& messages,
+    const TrafficCounter& datagrams, double elapsedSeconds) {
+    std::vector<uint8_t> types;
+    uint64_t messageBytes = 0;
+    for (size_t type = 0; type < TYPE_SLOTS; ++type) {
+        if (messages[type].packets > 0) {
+            types.push_back(static_cast<uint8_t>(type));
+            messageBytes += messages[type].bytes;
+        }
+    }
+    std::sort(types.begin(), types.end(), [&](uint8_t a, uint8_t b) {
+        return messages[a].bytes > messages[b].bytes;
+    });
+
+    std::string line = FormatByteRate(datagrams.bytes, elapsedSeconds) + " in " +
+        std::to_string(datagrams.packets) + " datagrams";
+    for (uint8_t type : types) {
+        const TrafficCounter& counter = messages[type];
+        line += " - " + std::string(GetNetMessageTypeName(type)) + ": " +
+            FormatByteRate(counter.bytes, elapsedSeconds) +
+            " (" + std::to_string(counter.bytes * 100 / std::max<uint64_t>(messageBytes, 1)) + "%, " +
+            std::to_string(counter.packets) + " msgs)";
+    }
+    return line;
+}
+
+void BandwidthStats::Accumulate(const BandwidthStats& window) {
+    for (size_t type = 0; type < TYPE_SLOTS; ++type) {
+        messagesSent[type].Add(window.messagesSent[type]);
+        messagesReceived[type].Add(window.messagesReceived[type]);
+    }
+    datagramsSent.Add(window.datagramsSent);
+    datagramsReceived.Add(window.datagramsReceived);
+}
+
+void BandwidthStats::Reset() {
+    messagesSent.fill(TrafficCounter());
+    messagesReceived.fill(TrafficCounter());
+    datagramsSent = TrafficCounter();
+    datagramsReceived = TrafficCounter();
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <SFML/Network/Packet.hpp>
+
+// Name of a NetMessageType for stats output ("Unknown" for unassigned bytes)
+const char* GetNetMessageTypeName(uint8_t type);
+
+struct TrafficCounter {
+    uint64_t bytes = 0;
+    uint64_t packets = 0;
+
+    void Add(size_t size) {
+        bytes += size;
+        packets++;
+    }
+    void Add(const TrafficCounter& other) {
+        bytes += other.bytes;
+        packets += other.packets;
+    }
+};
+
+// Bytes and packets in each direction, split by NetMessageType, over a stats
+// window. Two levels are counted separately:
+//  - messages: one per logical message, by its type byte, where it is queued
+//    or handled (bundled, fragmented and reliable messages count as themselves)
+//  - datagrams: what actually crossed the socket, including bundle framing,
+//    reliable envelopes, fragments and resends
+// Counting is a couple of adds; rates come out when the window is closed.
+class BandwidthStats {
+public:
+    static constexpr size_t TYPE_SLOTS = 256;   // Indexed by the raw type byte
+
+    void RecordMessageSent(uint8_t type, size_t bytes) { messagesSent[type].Add(bytes); }
+    void RecordMessageReceived(uint8_t type, size_t bytes) { messagesReceived[type].Add(bytes); }
+    void RecordDatagramSent(size_t bytes) { datagramsSent.Add(bytes); }
+    void RecordDatagramsSent(const TrafficCounter& datagrams) { datagramsSent.Add(datagrams); }
+    void RecordDatagramReceived(size_t bytes) { datagramsReceived.Add(bytes); }
+
+    // Folds another window's counts into this one (running totals across windows)
+    void Accumulate(const BandwidthStats& window);
+
+    // Message helpers: the type is the packet's first byte
+    void RecordMessageSent(const sf::Packet& message);
+    void RecordMessageReceived(const sf::Packet& message);
+
+    const TrafficCounter& GetMessagesSent(uint8_t type) const { return messagesSent[type]; }
+    const TrafficCounter& GetMessagesReceived(uint8_t type) const { return messagesReceived[type]; }
+    const TrafficCounter& GetDatagramsSent() const { return datagramsSent; }
+    const TrafficCounter& GetDatagramsReceived() const { return datagramsReceived; }
+
+    // One line per direction: datagram rate, then message types by bytes (largest first).
+    // Rates are over elapsedSeconds, the length of the window being reported.
+    std::string FormatSent(double elapsedSeconds) const;
+    std::string FormatReceived(double elapsedSeconds) const;
+
+    // Starts a new window
+    void Reset();
+
+private:
+    std::array<TrafficCounter, TYPE_SLOTS> messagesSent;
+    std::array<TrafficCounter, TYPE_SLOTS> messagesReceived;
+    TrafficCounter datagramsSent;
+    TrafficCounter datagramsReceived;
+
+    static std::string Format(const std::array<TrafficCounter, TYPE_SLOTS>& messages,
+        const TrafficCounter& datagrams, double elapsedSeconds);
+};
+
+// Bytes per second as "812 B/s" or "12.4 KB/s"
+std::string FormatByteRate(uint64_t bytes, double elapsedSeconds);
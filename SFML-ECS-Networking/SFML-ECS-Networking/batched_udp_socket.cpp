@@ -0,0 +1,663 @@
+#include "batched_udp_socket.h"
+#include "utils.h"
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mswsock.h>
+#include <mstcpip.h>
+#include <cstring>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+
+#ifdef _WIN32
+struct BatchedUdpSocket::RegisteredIO {
+    // Layout of the registered pool, slot by slot:
+    // [receive data][receive addresses][send data][send addresses]
+    static constexpr DWORD SLOT_BYTES = static_cast<DWORD>(RECEIVE_BUFFER_BYTES);
+    static constexpr DWORD ADDRESS_BYTES = sizeof(SOCKADDR_INET);
+    static constexpr DWORD RECEIVE_ADDRESSES = static_cast<DWORD>(RIO_RECEIVE_SLOTS * SLOT_BYTES);
+    static constexpr DWORD SEND_DATA = RECEIVE_ADDRESSES + static_cast<DWORD>(RIO_RECEIVE_SLOTS * ADDRESS_BYTES);
+    static constexpr DWORD SEND_ADDRESSES = SEND_DATA + static_cast<DWORD>(RIO_SEND_SLOTS * SLOT_BYTES);
+    static constexpr DWORD POOL_BYTES = SEND_ADDRESSES + static_cast<DWORD>(RIO_SEND_SLOTS * ADDRESS_BYTES);
+
+    RIO_EXTENSION_FUNCTION_TABLE table{};
+    bool winsockStarted = false;
+    SOCKET socket = INVALID_SOCKET;
+    char* pool = nullptr;
+    RIO_BUFFERID bufferId = RIO_INVALID_BUFFERID;
+    HANDLE receiveEvent = nullptr;
+    RIO_CQ receiveQueue = RIO_INVALID_CQ;
+    RIO_CQ sendQueue = RIO_INVALID_CQ;
+    RIO_RQ requests = RIO_INVALID_RQ;
+    bool notifyArmed = false;           // RIONotify is pending on receiveQueue
+    std::vector<uint32_t> freeSendSlots;
+
+    ~RegisteredIO() {
+        if (socket != INVALID_SOCKET) {
+            closesocket(socket);        // Also frees the request queue
+        }
+        if (receiveQueue != RIO_INVALID_CQ) {
+            table.RIOCloseCompletionQueue(receiveQueue);
+        }
+        if (sendQueue != RIO_INVALID_CQ) {
+            table.RIOCloseCompletionQueue(sendQueue);
+        }
+        if (bufferId != RIO_INVALID_BUFFERID) {
+            table.RIODeregisterBuffer(bufferId);
+        }
+        if (pool) {
+            VirtualFree(pool, 0, MEM_RELEASE);
+        }
+        if (receiveEvent) {
+            CloseHandle(receiveEvent);
+        }
+        if (winsockStarted) {
+            WSACleanup();
+        }
+    }
+
+    RIO_BUF Slice(DWORD offset, DWORD length) const {
+        RIO_BUF buffer;
+        buffer.BufferId = bufferId;
+        buffer.Offset = offset;
+        buffer.Length = length;
+        return buffer;
+    }
+
+    bool PostReceive(uint32_t slot, DWORD flags) {
+        RIO_BUF data = Slice(slot * SLOT_BYTES, SLOT_BYTES);
+        RIO_BUF address = Slice(RECEIVE_ADDRESSES + slot * ADDRESS_BYTES, ADDRESS_BYTES);
+        return table.RIOReceiveEx(requests, &data, 1, nullptr, &address, nullptr, nullptr, flags,
+            reinterpret_cast<PVOID>(static_cast<uintptr_t>(slot))) != FALSE;
+    }
+
+    void CommitReceives() {
+        table.RIOReceiveEx(requests, nullptr, 0, nullptr, nullptr, nullptr, nullptr, RIO_MSG_COMMIT_ONLY, nullptr);
+    }
+};
+
+namespace {
+    std::string WinsockError(const std::string& what) {
+        return what + " (WSA error " + std::to_string(WSAGetLastError()) + ")";
+    }
+}
+#endif
+
+BatchedUdpSocket::BatchedUdpSocket()
+    :
+#ifndef _WIN32
+    handle(-1),
+#endif
+    localPort(0),
+    receiveBuffers(BATCH_SIZE, std::vector<uint8_t>(RECEIVE_BUFFER_BYTES)),
+    pendingCount(0), receiveCalls(0), sendCalls(0), datagramsReceived(0),
+    datagramsSent(0), sendErrors(0), truncatedCount(0) {
+}
+
+BatchedUdpSocket::~BatchedUdpSocket() {
+    Close();
+}
+
+bool BatchedUdpSocket::IsSupported() {
+#if defined(__linux__) || defined(_WIN32)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool BatchedUdpSocket::IsPortSharingSupported() {
+#if defined(__linux__) && defined(SO_REUSEPORT)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool BatchedUdpSocket::IsOpen() const {
+#ifdef _WIN32
+    return rio != nullptr;
+#else
+    return handle >= 0;
+#endif
+}
+
+#if defined(__linux__)
+
+bool BatchedUdpSocket::Bind(unsigned short port, bool sharePort) {
+    Close();
+
+    handle = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (handle < 0) {
+        Utils::printMsg("Failed to create batched UDP socket: " + std::string(std::strerror(errno)), error);
+        return false;
+    }
+#ifdef SO_REUSEPORT
+    const int reuse = 1;
+    if (sharePort && ::setsockopt(handle, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
+        Utils::printMsg("Failed to share port " + std::to_string(port) + ": " + std::string(std::strerror(errno)), error);
+        Close();
+        return false;
+    }
+#else
+    if (sharePort) {
+        Utils::printMsg("Port sharing is not available on this system", error);
+        Close();
+        return false;
+    }
+#endif
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        Utils::printMsg("Failed to bind batched UDP socket to port " + std::to_string(port) + ": " +
+            std::string(std::strerror(errno)), error);
+        Close();
+        return false;
+    }
+
+    const int flags = ::fcntl(handle, F_GETFL, 0);
+    if (flags < 0 || ::fcntl(handle, F_SETFL, flags | O_NONBLOCK) < 0) {
+        Utils::printMsg("Failed to make batched UDP socket non-blocking", error);
+        Close();
+        return false;
+    }
+
+    socklen_t addressLength = sizeof(address);
+    ::getsockname(handle, reinterpret_cast<sockaddr*>(&address), &addressLength);
+    localPort = ntohs(address.sin_port);
+    return true;
+}
+
+bool BatchedUdpSocket::Adopt(int nativeHandle) {
+    Close();
+    sockaddr_in address;
+    socklen_t addressLength = sizeof(address);
+    if (nativeHandle < 0 || ::getsockname(nativeHandle, reinterpret_cast<sockaddr*>(&address), &addressLength) < 0 ||
+        address.sin_family != AF_INET) {
+        Utils::printMsg("Handed over socket is not a bound IPv4 socket", error);
+        if (nativeHandle >= 0) {
+            ::close(nativeHandle);
+        }
+        return false;
+    }
+    handle = nativeHandle;
+    const int flags = ::fcntl(handle, F_GETFL, 0);
+    if (flags < 0 || ::fcntl(handle, F_SETFL, flags | O_NONBLOCK) < 0) {
+        Utils::printMsg("Failed to make the handed over socket non-blocking", error);
+        Close();
+        return false;
+    }
+    localPort = ntohs(address.sin_port);
+    return true;
+}
+
+int BatchedUdpSocket::GetNativeHandle() const {
+    return handle;
+}
+
+void BatchedUdpSocket::Close() {
+    if (handle >= 0) {
+        ::close(handle);
+        handle = -1;
+    }
+    localPort = 0;
+    pendingCount = 0;
+}
+
+/**
+ * Drains up to BATCH_SIZE ready datagrams with a single recvmmsg. Datagrams
+ * the kernel had to truncate are dropped (no client message is that large).
+ */
+size_t BatchedUdpSocket::ReceiveBatch() {
+    if (handle < 0) {
+        return 0;
+    }
+
+    std::array<mmsghdr, BATCH_SIZE> headers;
+    std::array<iovec, BATCH_SIZE> vectors;
+    std::array<sockaddr_in, BATCH_SIZE> senders;
+    for (size_t i = 0; i < BATCH_SIZE; ++i) {
+        vectors[i].iov_base = receiveBuffers[i].data();
+        vectors[i].iov_len = receiveBuffers[i].size();
+        std::memset(&headers[i], 0, sizeof(mmsghdr));
+        headers[i].msg_hdr.msg_name = &senders[i];
+        headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int count;
+    do {
+        count = ::recvmmsg(handle, headers.data(), BATCH_SIZE, MSG_DONTWAIT, nullptr);
+    } while (count < 0 && errno == EINTR);
+    receiveCalls++;
+
+    if (count < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            Utils::printMsg("recvmmsg failed: " + std::string(std::strerror(errno)), error);
+        }
+        return 0;
+    }
+
+    size_t ready = 0;
+    for (int i = 0; i < count; ++i) {
+        if (headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            truncatedCount++;
+            continue;
+        }
+        QueuedDatagram& datagram = received[ready++];
+        datagram.packet.clear();
+        datagram.packet.append(receiveBuffers[i].data(), headers[i].msg_len);
+        datagram.address = sf::IpAddress(ntohl(senders[i].sin_addr.s_addr));
+        datagram.port = ntohs(senders[i].sin_port);
+    }
+    datagramsReceived += ready;
+    return ready;
+}
+
+void BatchedUdpSocket::QueueSend(const sf::Packet& packet, sf::IpAddress address, unsigned short port) {
+    if (pendingCount == BATCH_SIZE) {
+        FlushSends();
+    }
+
+    PendingSend& pending = pendingSends[pendingCount++];
+    const uint8_t* data = static_cast<const uint8_t*>(packet.getData());
+    pending.bytes.assign(data, data + packet.getDataSize());
+    pending.address = address.toInteger();
+    pending.port = port;
+}
+
+/**
+ * Sends the queued datagrams with as few sendmmsg calls as the kernel allows.
+ * A datagram the kernel rejects is dropped and the rest are still sent; when
+ * the socket buffer is full the remainder of the batch is dropped, as a
+ * non-blocking sf::UdpSocket would.
+ */
+size_t BatchedUdpSocket::FlushSends() {
+    if (handle < 0 || pendingCount == 0) {
+        pendingCount = 0;
+        return 0;
+    }
+
+    std::array<mmsghdr, BATCH_SIZE> headers;
+    std::array<iovec, BATCH_SIZE> vectors;
+    std::array<sockaddr_in, BATCH_SIZE> destinations;
+    for (size_t i = 0; i < pendingCount; ++i) {
+        PendingSend& pending = pendingSends[i];
+        vectors[i].iov_base = pending.bytes.data();
+        vectors[i].iov_len = pending.bytes.size();
+        std::memset(&destinations[i], 0, sizeof(sockaddr_in));
+        destinations[i].sin_family = AF_INET;
+        destinations[i].sin_addr.s_addr = htonl(pending.address);
+        destinations[i].sin_port = htons(pending.port);
+        std::memset(&headers[i], 0, sizeof(mmsghdr));
+        headers[i].msg_hdr.msg_name = &destinations[i];
+        headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t sent = 0;
+    size_t offset = 0;
+    while (offset < pendingCount) {
+        const int result = ::sendmmsg(handle, headers.data() + offset,
+            static_cast<unsigned int>(pendingCount - offset), 0);
+        sendCalls++;
+        if (result > 0) {
+            offset += static_cast<size_t>(result);
+            sent += static_cast<size_t>(result);
+            continue;
+        }
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            sendErrors += pendingCount - offset;
+            break;
+        }
+        sendErrors++;
+        offset++;
+    }
+
+    datagramsSent += sent;
+    pendingCount = 0;
+    return sent;
+}
+
+bool BatchedUdpSocket::WaitReadable(int timeoutMs) {
+    if (handle < 0) {
+        return false;
+    }
+    pollfd descriptor{};
+    descriptor.fd = handle;
+    descriptor.events = POLLIN;
+    return poll(&descriptor, 1, timeoutMs) > 0 && (descriptor.revents & POLLIN) != 0;
+}
+
+#elif defined(_WIN32)
+
+/**
+ * Creates the RIO socket, registers one buffer pool for every receive and
+ * send slot, and posts all the receives. Fails (so GameServer falls back to
+ * sf::UdpSocket) if Registered I/O is not available, i.e. before Windows 8.
+ */
+bool BatchedUdpSocket::Bind(unsigned short port, bool sharePort) {
+    Close();
+    if (sharePort) {
+        Utils::printMsg("Port sharing is not available on Windows", error);
+        return false;
+    }
+
+    auto state = std::make_unique<RegisteredIO>();
+    WSADATA winsockData;
+    if (WSAStartup(MAKEWORD(2, 2), &winsockData) != 0) {
+        Utils::printMsg("Failed to start Winsock for the batched UDP socket", error);
+        return false;
+    }
+    state->winsockStarted = true;
+
+    state->socket = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, nullptr, 0, WSA_FLAG_REGISTERED_IO);
+    if (state->socket == INVALID_SOCKET) {
+        Utils::printMsg(WinsockError("Failed to create batched UDP socket"), error);
+        return false;
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(state->socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR) {
+        Utils::printMsg(WinsockError("Failed to bind batched UDP socket to port " + std::to_string(port)), error);
+        return false;
+    }
+
+    // A datagram to a client that has gone away would otherwise fail a later
+    // receive with WSAECONNRESET (ICMP port unreachable)
+    BOOL reportConnectionReset = FALSE;
+    DWORD bytesReturned = 0;
+    WSAIoctl(state->socket, SIO_UDP_CONNRESET, &reportConnectionReset, sizeof(reportConnectionReset),
+        nullptr, 0, &bytesReturned, nullptr, nullptr);
+
+    GUID functionTableId = WSAID_MULTIPLE_RIO;
+    if (WSAIoctl(state->socket, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &functionTableId, sizeof(functionTableId),
+        &state->table, sizeof(state->table), &bytesReturned, nullptr, nullptr) == SOCKET_ERROR) {
+        Utils::printMsg(WinsockError("Registered I/O is not available on this version of Windows"), warning);
+        return false;
+    }
+
+    state->pool = static_cast<char*>(VirtualAlloc(nullptr, RegisteredIO::POOL_BYTES, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (!state->pool) {
+        Utils::printMsg("Failed to allocate the Registered I/O buffer pool", error);
+        return false;
+    }
+    state->bufferId = state->table.RIORegisterBuffer(state->pool, RegisteredIO::POOL_BYTES);
+    if (state->bufferId == RIO_INVALID_BUFFERID) {
+        Utils::printMsg(WinsockError("Failed to register the Registered I/O buffer pool"), error);
+        return false;
+    }
+
+    // Receive completions signal an event, so an idle server can sleep on it
+    state->receiveEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!state->receiveEvent) {
+        Utils::printMsg("Failed to create the Registered I/O receive event", error);
+        return false;
+    }
+    RIO_NOTIFICATION_COMPLETION notification{};
+    notification.Type = RIO_EVENT_COMPLETION;
+    notification.Event.EventHandle = state->receiveEvent;
+    notification.Event.NotifyReset = FALSE;
+    state->receiveQueue = state->table.RIOCreateCompletionQueue(static_cast<DWORD>(RIO_RECEIVE_SLOTS), &notification);
+    state->sendQueue = state->table.RIOCreateCompletionQueue(static_cast<DWORD>(RIO_SEND_SLOTS), nullptr);
+    if (state->receiveQueue == RIO_INVALID_CQ || state->sendQueue == RIO_INVALID_CQ) {
+        Utils::printMsg(WinsockError("Failed to create Registered I/O completion queues"), error);
+        return false;
+    }
+    state->requests = state->table.RIOCreateRequestQueue(state->socket,
+        static_cast<ULONG>(RIO_RECEIVE_SLOTS), 1, static_cast<ULONG>(RIO_SEND_SLOTS), 1,
+        state->receiveQueue, state->sendQueue, nullptr);
+    if (state->requests == RIO_INVALID_RQ) {
+        Utils::printMsg(WinsockError("Failed to create the Registered I/O request queue"), error);
+        return false;
+    }
+
+    for (uint32_t slot = 0; slot < RIO_RECEIVE_SLOTS; ++slot) {
+        if (!state->PostReceive(slot, RIO_MSG_DEFER)) {
+            Utils::printMsg(WinsockError("Failed to post Registered I/O receives"), error);
+            return false;
+        }
+    }
+    state->CommitReceives();
+    state->freeSendSlots.reserve(RIO_SEND_SLOTS);
+    for (uint32_t slot = static_cast<uint32_t>(RIO_SEND_SLOTS); slot > 0; --slot) {
+        state->freeSendSlots.push_back(slot - 1);
+    }
+
+    int addressLength = sizeof(address);
+    ::getsockname(state->socket, reinterpret_cast<sockaddr*>(&address), &addressLength);
+    localPort = ntohs(address.sin_port);
+    rio = std::move(state);
+    return true;
+}
+
+// Sockets cross processes on Windows through WSADuplicateSocket, which does
+// not carry Registered I/O; a handoff rebinds the port instead
+bool BatchedUdpSocket::Adopt(int) {
+    Utils::printMsg("Taking over a socket is only available on Linux", warning);
+    return false;
+}
+
+int BatchedUdpSocket::GetNativeHandle() const {
+    return -1;
+}
+
+void BatchedUdpSocket::Close() {
+    rio.reset();
+    localPort = 0;
+    pendingCount = 0;
+}
+
+/**
+ * Takes up to BATCH_SIZE receive completions in one dequeue and re-posts
+ * their slots with a single commit. Datagrams larger than a slot complete
+ * with WSAEMSGSIZE and are dropped as truncated.
+ */
+size_t BatchedUdpSocket::ReceiveBatch() {
+    if (!rio) {
+        return 0;
+    }
+
+    std::array<RIORESULT, BATCH_SIZE> results;
+    const ULONG count = rio->table.RIODequeueCompletion(rio->receiveQueue, results.data(), static_cast<ULONG>(BATCH_SIZE));
+    receiveCalls++;
+    if (count == RIO_CORRUPT_CQ) {
+        Utils::printMsg("Registered I/O receive completion queue is corrupt", error);
+        return 0;
+    }
+
+    size_t ready = 0;
+    for (ULONG i = 0; i < count; ++i) {
+        const uint32_t slot = static_cast<uint32_t>(results[i].RequestContext);
+        if (results[i].Status == 0) {
+            const SOCKADDR_INET* sender = reinterpret_cast<const SOCKADDR_INET*>(
+                rio->pool + RegisteredIO::RECEIVE_ADDRESSES + slot * RegisteredIO::ADDRESS_BYTES);
+            if (sender->si_family == AF_INET) {
+                QueuedDatagram& datagram = received[ready++];
+                datagram.packet.clear();
+                datagram.packet.append(rio->pool + slot * RegisteredIO::SLOT_BYTES, results[i].BytesTransferred);
+                datagram.address = sf::IpAddress(ntohl(sender->Ipv4.sin_addr.s_addr));
+                datagram.port = ntohs(sender->Ipv4.sin_port);
+            }
+        }
+        else if (results[i].Status == WSAEMSGSIZE) {
+            truncatedCount++;
+        }
+        rio->PostReceive(slot, RIO_MSG_DEFER);
+    }
+    if (count > 0) {
+        rio->CommitReceives();
+    }
+    datagramsReceived += ready;
+    return ready;
+}
+
+size_t BatchedUdpSocket::ReapSendCompletions() {
+    std::array<RIORESULT, BATCH_SIZE> results;
+    size_t reaped = 0;
+    ULONG count;
+    while ((count = rio->table.RIODequeueCompletion(rio->sendQueue, results.data(), static_cast<ULONG>(BATCH_SIZE))) > 0 &&
+        count != RIO_CORRUPT_CQ) {
+        for (ULONG i = 0; i < count; ++i) {
+            if (results[i].Status == 0) {
+                datagramsSent++;
+            }
+            else {
+                sendErrors++;
+            }
+            rio->freeSendSlots.push_back(static_cast<uint32_t>(results[i].RequestContext));
+        }
+        reaped += count;
+    }
+    return reaped;
+}
+
+/**
+ * Copies the datagram into a free send slot and posts it deferred. With every
+ * slot still in flight the datagram is dropped, as a full socket buffer would.
+ */
+void BatchedUdpSocket::QueueSend(const sf::Packet& packet, sf::IpAddress address, unsigned short port) {
+    if (!rio) {
+        return;
+    }
+    if (pendingCount == BATCH_SIZE) {
+        FlushSends();
+    }
+    if (rio->freeSendSlots.empty()) {
+        ReapSendCompletions();
+    }
+    const size_t size = packet.getDataSize();
+    if (rio->freeSendSlots.empty() || size > RegisteredIO::SLOT_BYTES) {
+        sendErrors++;
+        return;
+    }
+
+    const uint32_t slot = rio->freeSendSlots.back();
+    rio->freeSendSlots.pop_back();
+    if (size > 0) {
+        std::memcpy(rio->pool + RegisteredIO::SEND_DATA + slot * RegisteredIO::SLOT_BYTES, packet.getData(), size);
+    }
+    SOCKADDR_INET* destination = reinterpret_cast<SOCKADDR_INET*>(
+        rio->pool + RegisteredIO::SEND_ADDRESSES + slot * RegisteredIO::ADDRESS_BYTES);
+    std::memset(destination, 0, sizeof(SOCKADDR_INET));
+    destination->Ipv4.sin_family = AF_INET;
+    destination->Ipv4.sin_addr.s_addr = htonl(address.toInteger());
+    destination->Ipv4.sin_port = htons(port);
+
+    RIO_BUF data = rio->Slice(RegisteredIO::SEND_DATA + slot * RegisteredIO::SLOT_BYTES, static_cast<DWORD>(size));
+    RIO_BUF remote = rio->Slice(RegisteredIO::SEND_ADDRESSES + slot * RegisteredIO::ADDRESS_BYTES, RegisteredIO::ADDRESS_BYTES);
+    if (!rio->table.RIOSendEx(rio->requests, &data, 1, nullptr, &remote, nullptr, nullptr, RIO_MSG_DEFER,
+        reinterpret_cast<PVOID>(static_cast<uintptr_t>(slot)))) {
+        sendErrors++;
+        rio->freeSendSlots.push_back(slot);
+        return;
+    }
+    pendingCount++;
+}
+
+/**
+ * Commits every deferred send with one call. Sends complete asynchronously,
+ * so datagramsSent/sendErrors are counted as completions are reaped.
+ * @return Number of datagrams committed
+ */
+size_t BatchedUdpSocket::FlushSends() {
+    if (!rio) {
+        pendingCount = 0;
+        return 0;
+    }
+    const size_t committed = pendingCount;
+    if (committed > 0) {
+        rio->table.RIOSendEx(rio->requests, nullptr, 0, nullptr, nullptr, nullptr, nullptr, RIO_MSG_COMMIT_ONLY, nullptr);
+        sendCalls++;
+        pendingCount = 0;
+    }
+    ReapSendCompletions();
+    return committed;
+}
+
+/**
+ * Arms a notification on the receive completion queue (it fires at once if
+ * completions are already waiting) and sleeps on its event.
+ */
+bool BatchedUdpSocket::WaitReadable(int timeoutMs) {
+    if (!rio) {
+        return false;
+    }
+    if (!rio->notifyArmed) {
+        const INT result = rio->table.RIONotify(rio->receiveQueue);
+        rio->notifyArmed = result == ERROR_SUCCESS || result == WSAEALREADY;
+    }
+    if (WaitForSingleObject(rio->receiveEvent, static_cast<DWORD>(timeoutMs)) == WAIT_OBJECT_0) {
+        rio->notifyArmed = false;
+        return true;
+    }
+    return false;
+}
+
+#else
+
+bool BatchedUdpSocket::Bind(unsigned short, bool) {
+    Utils::printMsg("Batched UDP socket is only available on Linux and Windows", warning);
+    return false;
+}
+
+bool BatchedUdpSocket::Adopt(int) {
+    Utils::printMsg("Taking over a socket is only available on Linux", warning);
+    return false;
+}
+
+int BatchedUdpSocket::GetNativeHandle() const {
+    return -1;
+}
+
+void BatchedUdpSocket::Close() {
+    handle = -1;
+    localPort = 0;
+    pendingCount = 0;
+}
+
+size_t BatchedUdpSocket::ReceiveBatch() {
+    return 0;
+}
+
+void BatchedUdpSocket::QueueSend(const sf::Packet&, sf::IpAddress, unsigned short) {
+}
+
+size_t BatchedUdpSocket::FlushSends() {
+    return 0;
+}
+
+bool BatchedUdpSocket::WaitReadable(int) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "datagram_channel.h"
+
+// Server socket backend that moves datagrams in batches: one call drains up
+// to BATCH_SIZE datagrams and sends queued during a tick leave in batches of
+// up to BATCH_SIZE.
+//  - Linux: recvmmsg/sendmmsg.
+//  - Windows: Registered I/O. RIO_RECEIVE_SLOTS receives stay posted into
+//    one pre-registered buffer pool; completions are dequeued in batches and
+//    the slots re-posted. Sends are copied into registered send slots, posted
+//    deferred and committed with one call per batch.
+// IsSupported() is false elsewhere and GameServer keeps using sf::UdpSocket.
+class BatchedUdpSocket {
+public:
+    static constexpr size_t BATCH_SIZE = 64;              // Datagrams per syscall
+    static constexpr size_t RECEIVE_BUFFER_BYTES = 2048;  // Larger datagrams are dropped as truncated
+    static constexpr size_t RIO_RECEIVE_SLOTS = 1024;     // Windows: receives kept posted (the socket buffer)
+    static constexpr size_t RIO_SEND_SLOTS = 1024;        // Windows: sends in flight; more are dropped
+
+    BatchedUdpSocket();
+    ~BatchedUdpSocket();
+
+    BatchedUdpSocket(const BatchedUdpSocket&) = delete;
+    BatchedUdpSocket& operator=(const BatchedUdpSocket&) = delete;
+
+    static bool IsSupported();
+    // True where several sockets can share one port with the kernel spreading
+    // clients across them (SO_REUSEPORT, Linux)
+    static bool IsPortSharingSupported();
+
+    // Opens a non-blocking IPv4 UDP socket bound to port on all interfaces.
+    // sharePort lets other sockets bind the same port with sharePort too; the
+    // kernel then keeps each sender on one of them.
+    bool Bind(unsigned short port, bool sharePort = false);
+    // Takes over a bound UDP socket handed over by another process (see
+    // handoff.h) instead of binding one; closes it if it cannot. Linux only
+    bool Adopt(int nativeHandle);
+    // Descriptor to hand the socket over with, -1 if closed or not on Linux
+    int GetNativeHandle() const;
+    void Close();
+    bool IsOpen() const;
+    unsigned short GetLocalPort() const { return localPort; }
+
+    // Receives whatever is ready, up to BATCH_SIZE datagrams, in one call
+    // @return Number of datagrams now readable through GetReceived(0..count-1)
+    size_t ReceiveBatch();
+    QueuedDatagram& GetReceived(size_t index) { return received[index]; }
+
+    // Copies the datagram into the send batch (flushing first if it is full)
+    void QueueSend(const sf::Packet& packet, sf::IpAddress address, unsigned short port);
+
+    // Sends every queued datagram. @return Number sent
+    size_t FlushSends();
+
+    // Blocks until a datagram is ready to receive or timeoutMs passes
+    // @return True if a datagram is ready
+    bool WaitReadable(int timeoutMs);
+
+    // Diagnostics
+    uint64_t GetReceiveCalls() const { return receiveCalls; }
+    uint64_t GetSendCalls() const { return sendCalls; }
+    uint64_t GetDatagramsReceived() const { return datagramsReceived; }
+    uint64_t GetDatagramsSent() const { return datagramsSent; }
+    uint64_t GetSendErrors() const { return sendErrors; }
+    uint64_t GetTruncatedCount() const { return truncatedCount; }
+
+private:
+    struct PendingSend {
+        std::vector<uint8_t> bytes;   // Capacity kept between ticks
+        uint32_t address;             // Host byte order
+        unsigned short port;
+    };
+
+#ifdef _WIN32
+    struct RegisteredIO;              // Socket, queues and buffer pool (batched_udp_socket.cpp)
+    std::unique_ptr<RegisteredIO> rio;    // Null when closed
+
+    // Recycles the send slots whose completions have arrived. @return Number recycled
+    size_t ReapSendCompletions();
+#else
+    int handle;                       // Native socket descriptor, -1 when closed
+#endif
+    unsigned short localPort;
+
+    std::vector<std::vector<uint8_t>> receiveBuffers;
+    std::array<QueuedDatagram, BATCH_SIZE> received;
+    std::array<PendingSend, BATCH_SIZE> pendingSends;
+    size_t pendingCount;              // Windows: sends posted deferred, not yet committed
+
+    uint64_t receiveCalls;
+    uint64_t sendCalls;
+    uint64_t datagramsReceived;
+    uint64_t datagramsSent;
+    uint64_t sendErrors;
+    uint64_t truncatedCount;
+};
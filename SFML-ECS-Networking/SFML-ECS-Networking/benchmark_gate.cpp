@@ -0,0 +1,367 @@
+#include "benchmark_gate.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+    // Just enough JSON for the gate's files: objects, strings without
+    // escapes other than \" and \\, and numbers. Other values are skipped.
+    class JsonCursor {
+    public:
+        explicit JsonCursor(const std::string& text) : text(text), pos(0) {}
+
+        bool Consume(char expected) {
+            SkipSpace();
+            if (pos < text.size() && text[pos] == expected) {
+                pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool Peek(char expected) {
+            SkipSpace();
+            return pos < text.size() && text[pos] == expected;
+        }
+
+        bool ReadString(std::string& out) {
+            if (!Consume('"')) {
+                return false;
+            }
+            out.clear();
+            while (pos < text.size() && text[pos] != '"') {
+                if (text[pos] == '\\' && pos + 1 < text.size()) {
+                    pos++;
+                }
+                out += text[pos++];
+            }
+            return Consume('"');
+        }
+
+        bool ReadNumber(double& out) {
+            SkipSpace();
+            const char* start = text.c_str() + pos;
+            char* end = nullptr;
+            out = std::strtod(start, &end);
+            if (end == start) {
+                return false;
+            }
+            pos += static_cast<size_t>(end - start);
+            return true;
+        }
+
+        // Skips one value of any kind, nested objects and arrays included
+        bool SkipValue() {
+            SkipSpace();
+            if (pos >= text.size()) {
+                return false;
+            }
+            std::string ignored;
+            double number = 0.0;
+            switch (text[pos]) {
+            case '"':
+                return ReadString(ignored);
+            case '{':
+            case '[': {
+                const char close = text[pos] == '{' ? '}' : ']';
+                pos++;
+                if (Consume(close)) {
+                    return true;
+                }
+                do {
+                    if (close == '}' && (!ReadString(ignored) || !Consume(':'))) {
+                        return false;
+                    }
+                    if (!SkipValue()) {
+                        return false;
+                    }
+                } while (Consume(','));
+                return Consume(close);
+            }
+            default:
+                if (ReadNumber(number)) {
+                    return true;
+                }
+                while (pos < text.size() && std::isalpha(static_cast<unsigned char>(text[pos]))) {
+                    pos++;      // true, false, null
+                }
+                return true;
+            }
+        }
+
+    private:
+        const std::string& text;
+        size_t pos;
+
+        void SkipSpace() {
+            while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+                pos++;
+            }
+        }
+    };
+
+    // One metric entry: { "value": v, "floor": f, "tolerance": t }
+    bool ReadMetric(JsonCursor& json, BenchmarkMetric& metric, double& tolerance) {
+        tolerance = -1.0;
+        if (!json.Consume('{')) {
+            return false;
+        }
+        if (json.Consume('}')) {
+            return true;
+        }
+        std::string key;
+        do {
+            if (!json.ReadString(key) || !json.Consume(':')) {
+                return false;
+            }
+            const bool known = key == "value" || key == "floor" || key == "tolerance";
+            double number = 0.0;
+            if (known && !json.ReadNumber(number)) {
+                return false;
+            }
+            if (!known && !json.SkipValue()) {
+                return false;
+            }
+            if (key == "value") {
+                metric.value = number;
+            }
+            else if (key == "floor") {
+                metric.floor = number;
+            }
+            else if (key == "tolerance") {
+                tolerance = number;
+            }
+        } while (json.Consume(','));
+        return json.Consume('}');
+    }
+
+    // Each metric of the first pass with the median of its values over every
+    // pass that reported it
+    BenchmarkResults MedianOf(const std::vector<BenchmarkResults>& passes) {
+        std::vector<std::unordered_map<std::string, double>> values(passes.size());
+        for (size_t pass = 0; pass < passes.size(); ++pass) {
+            for (const BenchmarkMetric& metric : passes[pass]) {
+                values[pass][metric.name] = metric.value;
+            }
+        }
+        BenchmarkResults median = passes.front();
+        std::vector<double> samples;
+        for (BenchmarkMetric& metric : median) {
+            samples.clear();
+            for (const auto& pass : values) {
+                const auto it = pass.find(metric.name);
+                if (it != pass.end()) {
+                    samples.push_back(it->second);
+                }
+            }
+            std::sort(samples.begin(), samples.end());
+            metric.value = samples.size() % 2 == 1 ? samples[samples.size() / 2] :
+                (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2.0;
+        }
+        return median;
+    }
+
+    std::string FormatValue(double value) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", value);
+        return text;
+    }
+}
+
+bool BenchmarkGate::WriteJson(const std::string& path, const BenchmarkResults& results,
+    const std::vector<double>& tolerances) {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    file << "{\n  \"version\": " << FILE_VERSION << ",\n  \"metrics\": {";
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::string name;
+        for (char c : results[i].name) {
+            if (c == '"' || c == '\\') {
+                name += '\\';
+            }
+            name += c;
+        }
+        file << (i == 0 ? "\n" : ",\n") << "    \"" << name << "\": { \"value\": " << FormatValue(results[i].value) <<
+            ", \"floor\": " << FormatValue(results[i].floor);
+        if (i < tolerances.size() && tolerances[i] >= 0.0) {
+            file << ", \"tolerance\": " << FormatValue(tolerances[i]);
+        }
+        file << " }";
+    }
+    file << "\n  }\n}\n";
+    return static_cast<bool>(file);
+}
+
+bool BenchmarkGate::ReadJson(const std::string& path, BenchmarkResults& results, std::vector<double>& tolerances) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+
+    results.clear();
+    tolerances.clear();
+    JsonCursor json(text);
+    if (!json.Consume('{')) {
+        return false;
+    }
+    double version = 0.0;
+    bool hasMetrics = false;
+    std::string key;
+    if (!json.Peek('}')) {
+        do {
+            if (!json.ReadString(key) || !json.Consume(':')) {
+                return false;
+            }
+            if (key == "version") {
+                if (!json.ReadNumber(version)) {
+                    return false;
+                }
+            }
+            else if (key == "metrics") {
+                hasMetrics = true;
+                if (!json.Consume('{')) {
+                    return false;
+                }
+                if (json.Consume('}')) {
+                    continue;
+                }
+                do {
+                    BenchmarkMetric metric;
+                    double tolerance = -1.0;
+                    if (!json.ReadString(metric.name) || !json.Consume(':') || !ReadMetric(json, metric, tolerance)) {
+                        return false;
+                    }
+                    results.push_back(metric);
+                    tolerances.push_back(tolerance);
+                } while (json.Consume(','));
+                if (!json.Consume('}')) {
+                    return false;
+                }
+            }
+            else if (!json.SkipValue()) {
+                return false;
+            }
+        } while (json.Consume(','));
+    }
+    return json.Consume('}') && hasMetrics && static_cast<int>(version) == FILE_VERSION;
+}
+
+/**
+ * Benchmarks log at info as they go; the verdict follows as one line per
+ * regressed, new or missing metric and a summary. Regressed and new metrics
+ * fail the run. The results file is
+ * written whatever the verdict, so a failed run can be inspected or
+ * promoted to the baseline.
+ */
+int BenchmarkGate::Run(const BenchmarkGateConfig& config) {
+#ifdef HEADLESS_SERVER
+    if (config.updateBaseline) {
+        Utils::printMsg("Benchmark gate: a server build skips the horde and interpolation benchmarks;"
+            " record the baseline from a client build", error);
+        return -1;
+    }
+#endif
+    BenchmarkResults baseline;
+    std::vector<double> tolerances;
+    if (!config.updateBaseline && !ReadJson(config.baselinePath, baseline, tolerances)) {
+        Utils::printMsg("Benchmark gate: could not read baseline " + config.baselinePath +
+            " (record one on the reference machine with the update option)", error);
+        return -1;
+    }
+    if (!config.updateBaseline && baseline.empty()) {
+        Utils::printMsg("Benchmark gate: baseline " + config.baselinePath + " has no metrics, nothing to compare with"
+            " (record one on the reference machine with the update option)", error);
+        return -1;
+    }
+
+    std::vector<BenchmarkResults> passes(static_cast<size_t>(std::max(config.runs, 1)));
+    for (size_t pass = 0; pass < passes.size(); ++pass) {
+        Utils::printMsg("Benchmark pass " + std::to_string(pass + 1) + " of " + std::to_string(passes.size()));
+        if (Benchmarks::RunAll(&passes[pass]) != 0) {
+            Utils::printMsg("Benchmark gate failed: a benchmark threw", error);
+            return -1;
+        }
+    }
+    const BenchmarkResults results = MedianOf(passes);
+
+    // A new baseline keeps the per-metric tolerances of the one it replaces
+    std::vector<double> keptTolerances;
+    if (config.updateBaseline && ReadJson(config.baselinePath, baseline, tolerances)) {
+        std::unordered_map<std::string, double> toleranceOf;
+        for (size_t i = 0; i < baseline.size(); ++i) {
+            toleranceOf[baseline[i].name] = tolerances[i];
+        }
+        for (const BenchmarkMetric& metric : results) {
+            const auto it = toleranceOf.find(metric.name);
+            keptTolerances.push_back(it != toleranceOf.end() ? it->second : -1.0);
+        }
+    }
+    if (!WriteJson(config.updateBaseline ? config.baselinePath : config.resultsPath, results, keptTolerances)) {
+        Utils::printMsg("Error: Could not write benchmark results to " +
+            (config.updateBaseline ? config.baselinePath : config.resultsPath), error);
+        return -1;
+    }
+    if (config.updateBaseline) {
+        Utils::printMsg("Benchmark baseline written to " + config.baselinePath + ": " +
+            std::to_string(results.size()) + " metrics", success);
+        return 0;
+    }
+
+    std::unordered_map<std::string, size_t> baselineIndex;
+    for (size_t i = 0; i < baseline.size(); ++i) {
+        baselineIndex[baseline[i].name] = i;
+    }
+    std::vector<bool> reported(baseline.size(), false);
+    int regressed = 0;
+    int added = 0;
+    for (const BenchmarkMetric& metric : results) {
+        const auto it = baselineIndex.find(metric.name);
+        if (it == baselineIndex.end()) {
+            Utils::printMsg("  New: " + metric.name + " " + FormatValue(metric.value) + " (not in the baseline)", error);
+            added++;
+            continue;
+        }
+        reported[it->second] = true;
+        const BenchmarkMetric& base = baseline[it->second];
+        const double tolerance = tolerances[it->second] >= 0.0 ? tolerances[it->second] : config.tolerancePercent;
+        const double rise = metric.value - base.value;
+        if (rise > std::max(base.floor, metric.floor) && rise > base.value * tolerance / 100.0) {
+            const double percent = base.value > 0.0 ? rise * 100.0 / base.value : 100.0;
+            Utils::printMsg("  Regressed: " + metric.name + " " + FormatValue(base.value) + " -> " +
+                FormatValue(metric.value) + " (+" + FormatValue(percent) + "%, tolerance " + FormatValue(tolerance) + "%)", error);
+            regressed++;
+        }
+    }
+    int missing = 0;
+    for (size_t i = 0; i < baseline.size(); ++i) {
+        if (!reported[i]) {
+            Utils::printMsg("  Missing: " + baseline[i].name + " (in the baseline, not reported by this run)", warning);
+            missing++;
+        }
+    }
+
+    Utils::printMsg("Benchmark results written to " + config.resultsPath);
+    if (regressed > 0) {
+        Utils::printMsg("Benchmark gate failed: " + std::to_string(regressed) + " of " + std::to_string(results.size()) +
+            " metrics regressed past " + FormatValue(config.tolerancePercent) + "% of " + config.baselinePath, error);
+        return -1;
+    }
+    if (added > 0) {
+        Utils::printMsg("Benchmark gate failed: " + std::to_string(added) + " metrics are not in " + config.baselinePath +
+            " (re-record it on the reference configuration)", error);
+        return -1;
+    }
+    Utils::printMsg("Benchmark gate passed: " + std::to_string(results.size()) +
+        " metrics within tolerance, " + std::to_string(missing) + " missing", success);
+    return 0;
+}
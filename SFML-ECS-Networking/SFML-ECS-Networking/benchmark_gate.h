@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "benchmarks.h"
+
+// Performance regression gate over the benchmark suites: runs
+// Benchmarks::RunAll with its fixed seeds, writes every reported metric to
+// resultsPath as JSON and compares it with the checked-in baseline. A metric
+// regresses when it rises past both its floor and the tolerance (the
+// baseline entry's own "tolerance" when it has one, else tolerancePercent).
+// Metrics the baseline lacks are listed as new and fail the run, since
+// nothing gates them until the baseline is re-recorded; baseline metrics the
+// run does not report (a server build skips the client-only suites) are
+// listed as missing.
+//
+// File layout, results and baseline alike:
+//   { "version": 1, "metrics": {
+//       "simulation.8p20e100b_100pct.enemies_ns": { "value": 5120.0, "floor": 500.0 },
+//       ... } }
+//
+// Timings of a single pass move by tens of percent on a busy machine, so
+// both sides run the suite `runs` times and keep each metric's median.
+// Metrics noisier than that carry their own tolerance in the baseline,
+// which re-recording keeps.
+//
+// Baselines only mean something on the machine and build configuration
+// they were recorded on, so none is checked in until one is recorded on the
+// reference configuration: the Windows MSVC Release client build, which runs
+// every suite (a server build refuses to record). Give the metrics that stay
+// noisy across runs there their own "tolerance" before committing it, and
+// refresh it with updateBaseline after an intended change.
+struct BenchmarkGateConfig {
+    std::string baselinePath = "benchmark_baseline.json";
+    std::string resultsPath = "benchmark_results.json";
+    float tolerancePercent = 15.0f;
+    int runs = 5;                       // Suite passes; each metric is the median over them
+    bool updateBaseline = false;        // Write the results over the baseline instead of comparing
+};
+
+namespace BenchmarkGate {
+    constexpr int FILE_VERSION = 1;
+
+    // @return 0 if nothing regressed (or the baseline was written), -1 on a
+    //         regression, a benchmark failure or an unreadable or empty baseline
+    int Run(const BenchmarkGateConfig& config);
+
+    // tolerances, by metric index, become the entries' "tolerance" (negative
+    // or missing = none)
+    // @return False if the file could not be written
+    bool WriteJson(const std::string& path, const BenchmarkResults& results,
+        const std::vector<double>& tolerances = {});
+
+    // Reads a file WriteJson wrote (or a hand-edited baseline). Entries may
+    // carry a "tolerance" percentage, returned in tolerances by metric index
+    // (negative = none).
+    // @return False if the file is missing, malformed or of another version
+    bool ReadJson(const std::string& path, BenchmarkResults& results, std::vector<double>& tolerances);
+}
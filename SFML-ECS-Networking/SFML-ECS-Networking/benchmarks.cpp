@@ -0,0 +1,1316 @@
+#include "benchmarks.h"
+#include "spatial_grid.h"
+#include "circle_batch.h"
+#include "network_messages.h"
+#include "network_validation.h"
+#include "packet_compression.h"
+#include "world_constants.h"
+#include "utils.h"
+#include "game_server.h"
+#include "synthetic_world.h"
+#include "logger.h"
+#include "allocation_counter.h"
+#include "batched_udp_socket.h"
+#include "connection_token.h"
+#ifndef HEADLESS_SERVER
+#include "entity_interpolation.h"
+#include "client_prediction.h"
+#include "bot_client.h"
+#include "local_server.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+namespace {
+    using BenchClock = std::chrono::steady_clock;
+
+    struct BenchCircle {
+        sf::Vector2f position;
+        float radius;
+    };
+
+    std::vector<BenchCircle> MakeCircles(std::mt19937& rng, size_t count, float radius) {
+        std::uniform_real_distribution<float> xDist(WorldConstants::PLAYABLE_MIN_X, WorldConstants::PLAYABLE_MAX_X);
+        std::uniform_real_distribution<float> yDist(WorldConstants::PLAYABLE_MIN_Y, WorldConstants::PLAYABLE_MAX_Y);
+        std::vector<BenchCircle> circles(count);
+        for (auto& circle : circles) {
+            circle.position = sf::Vector2f(xDist(rng), yDist(rng));
+            circle.radius = radius;
+        }
+        return circles;
+    }
+
+    bool Overlaps(sf::Vector2f a, float ra, sf::Vector2f b, float rb) {
+        float dx = a.x - b.x;
+        float dy = a.y - b.y;
+        float radiusSum = ra + rb;
+        return dx * dx + dy * dy < radiusSum * radiusSum;
+    }
+
+    // Byte-aligned layout the bullet update used before the bit-packed writer
+    void WriteBulletStream(sf::Packet& packet, const BulletData& bullet) {
+        packet << bullet.bulletId << bullet.ownerId << bullet.bulletType
+            << bullet.x << bullet.y << bullet.velocityX << bullet.velocityY
+            << bullet.rotation << bullet.damage << bullet.lifetime << bullet.spawnTime;
+    }
+
+    // "Bullet movement" -> "bullet_movement", for metric names
+    std::string MetricKey(const char* label) {
+        std::string key(label);
+        for (char& c : key) {
+            c = c == ' ' ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return key;
+    }
+
+    void Record(BenchmarkResults* results, const std::string& name, double value, double floor) {
+        if (results) {
+            results->push_back(BenchmarkMetric{ name, value, floor });
+        }
+    }
+
+    double ElapsedMicros(BenchClock::time_point start) {
+        return std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+    }
+
+    // CPU time the calling thread has used, kernel time included
+    double ThreadCpuMicros() {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+            return 0.0;
+        }
+        const uint64_t kernelTicks = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+        const uint64_t userTicks = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+        return static_cast<double>(kernelTicks + userTicks) / 10.0;     // 100 ns units
+#else
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<double>(now.tv_sec) * 1000000.0 + static_cast<double>(now.tv_nsec) / 1000.0;
+#endif
+    }
+
+    // One row of the socket benchmark
+    struct SocketResult {
+        uint64_t datagrams = 0;     // Received, or sent
+        uint64_t calls = 0;         // Receive or send calls made, empty polls included
+        double wallMicros = 0.0;
+        double cpuMicros = 0.0;
+    };
+
+    void PrintSocketResult(const std::string& name, const SocketResult& result, uint64_t offered) {
+        if (result.datagrams == 0) {
+            Utils::printMsg("  " + name + ": nothing got through", warning);
+            return;
+        }
+        Utils::printMsg("  " + name + ": " +
+            std::to_string(static_cast<uint64_t>(result.datagrams / (result.wallMicros / 1000000.0))) + " datagrams/s, " +
+            std::to_string(static_cast<uint64_t>(result.cpuMicros * 1000.0 / result.datagrams)) + " ns CPU/datagram (" +
+            std::to_string(result.datagrams) + " of " + std::to_string(offered) + ", " +
+            std::to_string(result.calls) + " calls)");
+    }
+
+    /**
+     * Blasts count datagrams of size bytes at port from a second thread while
+     * receive() drains on this one, until the sender is done and nothing has
+     * arrived for a while. receive() returns how many datagrams one call got.
+     */
+    template <typename ReceiveFn>
+    SocketResult MeasureReceive(unsigned short port, uint64_t count, size_t size, ReceiveFn&& receive) {
+        const double QUIET_MICROS = 200000.0;
+        std::atomic<bool> senderDone = false;
+        std::thread sender([&]() {
+            sf::UdpSocket socket;
+            std::vector<uint8_t> bytes(size, 0x5A);
+            sf::Packet packet;
+            packet.append(bytes.data(), bytes.size());
+            for (uint64_t i = 0; i < count; ++i) {
+                (void)socket.send(packet, sf::IpAddress::LocalHost, port);
+            }
+            senderDone = true;
+            });
+
+        SocketResult result;
+        const double cpuStart = ThreadCpuMicros();
+        const BenchClock::time_point start = BenchClock::now();
+        BenchClock::time_point lastArrival = start;
+        while (result.datagrams < count) {
+            const size_t received = receive();
+            result.calls++;
+            result.datagrams += received;
+            if (received > 0) {
+                lastArrival = BenchClock::now();
+            }
+            else if (senderDone && ElapsedMicros(lastArrival) > QUIET_MICROS) {
+                break;
+            }
+            else {
+                std::this_thread::yield();      // Lets the sender run on machines with few cores
+            }
+        }
+        result.wallMicros = std::chrono::duration<double, std::micro>(lastArrival - start).count();
+        result.cpuMicros = ThreadCpuMicros() - cpuStart;
+        sender.join();
+        return result;
+    }
+
+    // One row of the codec benchmark
+    struct CodecResult {
+        double encodePerSecond = 0.0;
+        double decodePerSecond = 0.0;
+        size_t bytes = 0;
+        bool ok = true;             // Every decode succeeded and the encoder did not overflow
+    };
+
+    /**
+     * Times encode() and decode() over enough iterations to move roughly
+     * TARGET_BYTES, after one warm-up call of each.
+     * @param encode Returns the encoded size in bytes, 0 if encoding failed
+     * @param decode Decodes the last encoding, returns false on failure
+     */
+    template <typename EncodeFn, typename DecodeFn>
+    CodecResult MeasureCodec(EncodeFn&& encode, DecodeFn&& decode) {
+        const size_t TARGET_BYTES = 16 * 1024 * 1024;
+        const size_t MIN_ITERATIONS = 200;
+        const size_t MAX_ITERATIONS = 200000;
+
+        CodecResult result;
+        result.bytes = encode();
+        if (result.bytes == 0 || !decode()) {
+            result.ok = false;
+            return result;
+        }
+        const size_t iterations = std::clamp(TARGET_BYTES / result.bytes, MIN_ITERATIONS, MAX_ITERATIONS);
+
+        BenchClock::time_point start = BenchClock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            result.ok &= encode() == result.bytes;
+        }
+        result.encodePerSecond = static_cast<double>(iterations) / (ElapsedMicros(start) / 1000000.0);
+
+        start = BenchClock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            result.ok &= decode();
+        }
+        result.decodePerSecond = static_cast<double>(iterations) / (ElapsedMicros(start) / 1000000.0);
+        return result;
+    }
+
+    PlayerData MakeBenchPlayer(std::mt19937& rng, uint32_t playerId) {
+        std::uniform_real_distribution<float> xDist(WorldConstants::PLAYABLE_MIN_X, WorldConstants::PLAYABLE_MAX_X);
+        std::uniform_real_distribution<float> yDist(WorldConstants::PLAYABLE_MIN_Y, WorldConstants::PLAYABLE_MAX_Y);
+        std::uniform_real_distribution<float> angleDist(0.0f, 360.0f);
+        PlayerData player;
+        player.playerId = playerId;
+        player.x = xDist(rng);
+        player.y = yDist(rng);
+        player.bodyRotation = angleDist(rng);
+        player.barrelRotation = angleDist(rng);
+        player.color = static_cast<PlayerColor>(playerId % static_cast<uint32_t>(PlayerColor::COUNT));
+        player.isMoving_forward = playerId % 2 == 0;
+        player.health = 75.0f;
+        player.score = static_cast<int32_t>(playerId) * 10;
+        return player;
+    }
+
+    EnemyData MakeBenchEnemy(std::mt19937& rng, uint32_t enemyId) {
+        std::uniform_real_distribution<float> xDist(WorldConstants::PLAYABLE_MIN_X, WorldConstants::PLAYABLE_MAX_X);
+        std::uniform_real_distribution<float> yDist(WorldConstants::PLAYABLE_MIN_Y, WorldConstants::PLAYABLE_MAX_Y);
+        std::uniform_real_distribution<float> angleDist(0.0f, 360.0f);
+        EnemyData enemy;
+        enemy.enemyId = enemyId;
+        enemy.enemyType = static_cast<uint8_t>(enemyId % 5);
+        enemy.x = xDist(rng);
+        enemy.y = yDist(rng);
+        enemy.bodyRotation = angleDist(rng);
+        enemy.barrelRotation = angleDist(rng);
+        enemy.health = 60.0f;
+        return enemy;
+    }
+
+    BulletData MakeBenchBullet(std::mt19937& rng, uint32_t index, int64_t now) {
+        std::uniform_real_distribution<float> xDist(WorldConstants::PLAYABLE_MIN_X, WorldConstants::PLAYABLE_MAX_X);
+        std::uniform_real_distribution<float> yDist(WorldConstants::PLAYABLE_MIN_Y, WorldConstants::PLAYABLE_MAX_Y);
+        std::uniform_real_distribution<float> velocityDist(-400.0f, 400.0f);
+        BulletData bullet;
+        bullet.bulletId = 10000 + index;
+        bullet.ownerId = index % 3 == 0 ? 1000 + index % 50 : 1 + index % 32;
+        bullet.bulletType = static_cast<uint8_t>(index % 4);
+        bullet.x = xDist(rng);
+        bullet.y = yDist(rng);
+        bullet.velocityX = velocityDist(rng);
+        bullet.velocityY = velocityDist(rng);
+        bullet.lifetime = 2.5f;
+        bullet.spawnTime = now;
+        return bullet;
+    }
+}
+
+/**
+ * Times one tick's worth of bullet collision checks against a fixed set of
+ * targets for bullet counts from 10 to 2000. The grid time includes the
+ * per-tick rebuild so the comparison matches what GameServer pays.
+ */
+void Benchmarks::RunBroadphaseBenchmark(BenchmarkResults* results) {
+    const size_t TARGET_COUNT = 64;          // Enemies + players in a busy match
+    const int ITERATIONS = 200;              // Ticks averaged per sample
+    const size_t bulletCounts[] = { 10, 50, 100, 250, 500, 1000, 2000 };
+
+    std::mt19937 rng(12345);
+    std::vector<BenchCircle> targets = MakeCircles(rng, TARGET_COUNT, WorldConstants::ENEMY_TANK_RADIUS);
+
+    Utils::printMsg("Broadphase benchmark: " + std::to_string(TARGET_COUNT) + " targets, " +
+        std::to_string(ITERATIONS) + " ticks per sample, " + CircleBatch::GetKernelName() + " narrowphase");
+
+    SpatialGrid grid;
+    std::vector<const SpatialGrid::Entry*> candidates;
+    CircleBatch batch;
+
+    for (size_t bulletCount : bulletCounts) {
+        std::vector<BenchCircle> bullets = MakeCircles(rng, bulletCount, WorldConstants::BULLET_RADIUS);
+
+        size_t naiveHits = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            for (const auto& bullet : bullets) {
+                for (const auto& target : targets) {
+                    if (Overlaps(bullet.position, bullet.radius, target.position, target.radius)) {
+                        naiveHits++;
+                        break;
+                    }
+                }
+            }
+        }
+        double naiveMicros = ElapsedMicros(start) / ITERATIONS;
+
+        size_t gridHits = 0;
+        start = BenchClock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            grid.Clear();
+            for (size_t t = 0; t < targets.size(); ++t) {
+                grid.Insert(static_cast<uint32_t>(t), targets[t].position, targets[t].radius);
+            }
+            for (const auto& bullet : bullets) {
+                grid.Query(bullet.position, bullet.radius, candidates);
+                for (const SpatialGrid::Entry* entry : candidates) {
+                    if (Overlaps(bullet.position, bullet.radius, entry->position, entry->radius)) {
+                        gridHits++;
+                        break;
+                    }
+                }
+            }
+        }
+        double gridMicros = ElapsedMicros(start) / ITERATIONS;
+
+        // All targets in one SoA batch, BLOCK_SIZE circles per kernel call
+        size_t batchHits = 0;
+        start = BenchClock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            batch.Clear();
+            for (const auto& target : targets) {
+                batch.Add(target.position, target.radius);
+            }
+            for (const auto& bullet : bullets) {
+                if (batch.FindFirstOverlap(bullet.position, bullet.radius) != CircleBatch::NONE) {
+                    batchHits++;
+                }
+            }
+        }
+        double batchMicros = ElapsedMicros(start) / ITERATIONS;
+
+        // Grid candidates gathered into a batch, as GameServer::CheckBulletCollisions does
+        size_t gridBatchHits = 0;
+        start = BenchClock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            grid.Clear();
+            for (size_t t = 0; t < targets.size(); ++t) {
+                grid.Insert(static_cast<uint32_t>(t), targets[t].position, targets[t].radius);
+            }
+            for (const auto& bullet : bullets) {
+                grid.Query(bullet.position, bullet.radius, candidates);
+                batch.Clear();
+                for (const SpatialGrid::Entry* entry : candidates) {
+                    batch.Add(entry->position, entry->radius);
+                }
+                if (batch.FindFirstOverlap(bullet.position, bullet.radius) != CircleBatch::NONE) {
+                    gridBatchHits++;
+                }
+            }
+        }
+        double gridBatchMicros = ElapsedMicros(start) / ITERATIONS;
+
+        const bool hitsMatch = naiveHits == gridHits && naiveHits == batchHits && naiveHits == gridBatchHits;
+        Record(results, "broadphase." + std::to_string(bulletCount) + "b.grid_batched_us", gridBatchMicros, 1.0);
+        Utils::printMsg("  " + std::to_string(bulletCount) + " bullets: naive " +
+            std::to_string(naiveMicros) + " us, grid " + std::to_string(gridMicros) + " us, batched " +
+            std::to_string(batchMicros) + " us, grid+batched " + std::to_string(gridBatchMicros) + " us" +
+            (hitsMatch ? "" : " (HIT MISMATCH)"),
+            hitsMatch ? info : error);
+    }
+}
+
+/**
+ * Encodes one client's BULLET_UPDATE for several bullet counts, once with
+ * per-field sf::Packet operators and once with BitWriter into a reused buffer,
+ * and reports the per-message time and wire size of each.
+ */
+void Benchmarks::RunSerializationBenchmark(BenchmarkResults* results) {
+    const int ITERATIONS = 500;
+    const size_t bulletCounts[] = { 10, 50, 100, 250 };
+
+    std::mt19937 rng(54321);
+    std::uniform_real_distribution<float> xDist(WorldConstants::PLAYABLE_MIN_X, WorldConstants::PLAYABLE_MAX_X);
+    std::uniform_real_distribution<float> yDist(WorldConstants::PLAYABLE_MIN_Y, WorldConstants::PLAYABLE_MAX_Y);
+    std::uniform_real_distribution<float> velocityDist(-400.0f, 400.0f);
+
+    Utils::printMsg("Serialization benchmark: BULLET_UPDATE, " + std::to_string(ITERATIONS) + " encodes per sample");
+
+    BitWriter writer;
+    BulletUpdateMessage msg;
+    msg.timestamp = GetCurrentTimestamp();
+
+    for (size_t bulletCount : bulletCounts) {
+        msg.bullets.resize(bulletCount);
+        for (size_t i = 0; i < bulletCount; ++i) {
+            BulletData& bullet = msg.bullets[i];
+            bullet.bulletId = 10000 + static_cast<uint32_t>(i);
+            bullet.ownerId = 1000 + static_cast<uint32_t>(i % 8);
+            bullet.bulletType = static_cast<uint8_t>(i % 4);
+            bullet.x = xDist(rng);
+            bullet.y = yDist(rng);
+            bullet.velocityX = velocityDist(rng);
+            bullet.velocityY = velocityDist(rng);
+            bullet.spawnTime = msg.timestamp;
+        }
+
+        size_t streamBytes = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            sf::Packet packet;
+            packet << static_cast<uint8_t>(msg.type) << static_cast<uint32_t>(msg.bullets.size());
+            for (const BulletData& bullet : msg.bullets) {
+                WriteBulletStream(packet, bullet);
+            }
+            packet << msg.timestamp << msg.sequenceNumber;
+            streamBytes = packet.getDataSize();
+        }
+        double streamMicros = ElapsedMicros(start) / ITERATIONS;
+
+        size_t bitBytes = 0;
+        start = BenchClock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            writer.Reset();
+            NetworkUtils::Write(writer, msg);
+            sf::Packet packet;
+            packet << static_cast<uint8_t>(msg.type);
+            writer.AppendTo(packet);
+            bitBytes = packet.getDataSize();
+        }
+        double bitMicros = ElapsedMicros(start) / ITERATIONS;
+
+        Record(results, "serialization." + std::to_string(bulletCount) + "b.bits_us", bitMicros, 1.0);
+        Record(results, "serialization." + std::to_string(bulletCount) + "b.bits_bytes", static_cast<double>(bitBytes), 0.0);
+        Utils::printMsg("  " + std::to_string(bulletCount) + " bullets: stream " +
+            std::to_string(streamMicros) + " us / " + std::to_string(streamBytes) + " B, bits " +
+            std::to_string(bitMicros) + " us / " + std::to_string(bitBytes) + " B");
+    }
+}
+
+/**
+ * Drives a local GameServer with 32 loopback clients that handshake for a
+ * connection token, join and send one PLAYER_INPUT
+ * (with redundant copies and a reliable ack) per tick, and counts the heap
+ * allocations the server makes while receiving and handling them, and over
+ * whole ticks. Joins and the first ticks grow the reused buffers; after that
+ * both counts are gated at zero. Enemy spawns and the stats report are off and
+ * the log is held at error while the server runs, since those allocate by design.
+ */
+void Benchmarks::RunReceivePathBenchmark(BenchmarkResults* results) {
+    const unsigned short SERVER_PORT = 53999;
+    const size_t PLAYER_COUNT = 32;
+    const int WARMUP_TICKS = 120;       // Until every client's snapshot ring (SnapshotHistory) has filled once
+    const int MEASURED_TICKS = 600;
+    const float TICK_SECONDS = 1.0f / 60.0f;
+    const uint32_t RECEIVE_PATH_SEED = 97531;
+
+    GameServer server(SERVER_PORT);
+    server.SetRandomSeed(RECEIVE_PATH_SEED);
+    server.SetEnemySpawnsEnabled(false);
+    server.SetStatsReportingEnabled(false);
+    if (!server.Initialize()) {
+        Utils::printMsg("Receive path benchmark skipped: could not bind port " + std::to_string(SERVER_PORT), warning);
+        return;
+    }
+    Logger::SetMinimumLevel(error);     // Joins and per-client lines
+    auto skip = [&](const std::string& reason) {
+        Logger::SetMinimumLevel(debug);
+        Utils::printMsg("Receive path benchmark skipped: " + reason, warning);
+        server.Shutdown();
+    };
+
+    std::vector<std::unique_ptr<sf::UdpSocket>> clients;
+    std::vector<uint64_t> tokens;
+    sf::Packet packet;
+    std::optional<sf::IpAddress> sender;
+    unsigned short senderPort = 0;
+    for (size_t i = 0; i < PLAYER_COUNT; ++i) {
+        auto client = std::make_unique<sf::UdpSocket>();
+        if (client->bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+            skip("could not bind a client socket");
+            return;
+        }
+        client->setBlocking(false);
+
+        // Handshake: the challenge carries the token every later datagram starts with
+        packet.clear();
+        ConnectionTokens::WriteRequest(packet);
+        if (client->send(packet, sf::IpAddress::LocalHost, SERVER_PORT) != sf::Socket::Status::Done) {
+            skip("could not send connection request " + std::to_string(i + 1));
+            return;
+        }
+        server.Update(TICK_SECONDS);
+        uint64_t token = 0;
+        while (client->receive(packet, sender, senderPort) == sf::Socket::Status::Done) {
+            uint8_t type = 0;
+            uint64_t issued = 0;
+            if ((packet >> type >> issued) && type == static_cast<uint8_t>(NetMessageType::CONNECTION_CHALLENGE)) {
+                token = issued;
+            }
+        }
+        if (token == 0) {
+            skip("no connection challenge for client " + std::to_string(i + 1));
+            return;
+        }
+
+        JoinMessage joinMsg;
+        joinMsg.playerName = "Bench" + std::to_string(i + 1);
+        joinMsg.timestamp = GetCurrentTimestamp();
+        packet.clear();
+        packet << token << joinMsg;
+        if (client->send(packet, sf::IpAddress::LocalHost, SERVER_PORT) != sf::Socket::Status::Done) {
+            skip("could not send join " + std::to_string(i + 1));
+            return;
+        }
+        clients.push_back(std::move(client));
+        tokens.push_back(token);
+
+        // One join per update, so player ids are assigned in socket order starting at 1
+        server.Update(TICK_SECONDS);
+    }
+
+    BitWriter writer;
+    PlayerInputMessage inputMsg;
+    uint64_t allocationsAtStart = 0;
+    uint64_t tickAllocationsAtStart = 0;
+    uint32_t inputsSent = 0;
+
+    for (int tick = 0; tick < WARMUP_TICKS + MEASURED_TICKS; ++tick) {
+        if (tick == WARMUP_TICKS) {
+            allocationsAtStart = server.GetReceivePathAllocations();
+            tickAllocationsAtStart = server.GetTickAllocations();
+            inputsSent = 0;
+        }
+
+        const uint32_t sequence = static_cast<uint32_t>(tick) + 1;
+        for (size_t i = 0; i < clients.size(); ++i) {
+            inputMsg.playerId = static_cast<uint32_t>(i) + 1;
+            inputMsg.sequenceNumber = sequence;
+            inputMsg.timestamp = GetCurrentTimestamp();
+            inputMsg.isMoving_forward = (tick / 30) % 2 == 0;
+            inputMsg.isMoving_left = (tick / 45) % 2 == 0;
+            inputMsg.barrelRotation = static_cast<float>((tick * 3) % 360);
+            inputMsg.hasReliableAck = true;
+            inputMsg.reliableAckSequence = 0;
+            inputMsg.reliableAckBits = 0;
+            inputMsg.previousInputs.clear();
+            for (uint32_t older = 1; older <= 3 && older < sequence; ++older) {
+                RedundantInput redundant;
+                redundant.sequenceNumber = sequence - older;
+                redundant.isMoving_forward = inputMsg.isMoving_forward;
+                redundant.isMoving_backward = false;
+                redundant.isMoving_left = inputMsg.isMoving_left;
+                redundant.isMoving_right = false;
+                inputMsg.previousInputs.push_back(redundant);
+            }
+
+            writer.Reset();
+            NetworkUtils::Write(writer, inputMsg);
+            packet.clear();
+            packet << tokens[i] << static_cast<uint8_t>(inputMsg.type);
+            writer.AppendTo(packet);
+            if (clients[i]->send(packet, sf::IpAddress::LocalHost, SERVER_PORT) == sf::Socket::Status::Done) {
+                inputsSent++;
+            }
+        }
+
+        server.Update(TICK_SECONDS);
+
+        // Drain what the server sent back so the client sockets never fill up
+        for (auto& client : clients) {
+            while (client->receive(packet, sender, senderPort) == sf::Socket::Status::Done) {
+            }
+        }
+    }
+
+    const uint64_t steadyAllocations = server.GetReceivePathAllocations() - allocationsAtStart;
+    const uint64_t steadyTickAllocations = server.GetTickAllocations() - tickAllocationsAtStart;
+    const size_t joinedPlayers = server.GetPlayerCount();
+    server.Shutdown();
+    Logger::SetMinimumLevel(debug);
+    if (joinedPlayers != PLAYER_COUNT) {
+        Utils::printMsg("Receive path benchmark: only " + std::to_string(joinedPlayers) + " of " +
+            std::to_string(PLAYER_COUNT) + " players joined", warning);
+    }
+    Record(results, "receive_path.steady.allocations", static_cast<double>(steadyAllocations), 0.0);
+    Record(results, "receive_path.whole_ticks.allocations", static_cast<double>(steadyTickAllocations), 0.0);
+    Utils::printMsg("Receive path benchmark: " + std::to_string(PLAYER_COUNT) + " players, " +
+        std::to_string(MEASURED_TICKS) + " ticks after " + std::to_string(WARMUP_TICKS) + " warm-up ticks");
+    Utils::printMsg("  Warm-up (joins + buffer growth): " + std::to_string(allocationsAtStart) + " allocations");
+    Utils::printMsg("  Steady state: " + std::to_string(steadyAllocations) + " allocations for " +
+        std::to_string(inputsSent) + " inputs", steadyAllocations == 0 ? success : warning);
+    Utils::printMsg("  Whole ticks (receive to flush): " + std::to_string(steadyTickAllocations) + " allocations",
+        steadyTickAllocations == 0 ? success : warning);
+}
+
+/**
+ * Measures every NetworkUtils codec the game sends at the sizes it sends them:
+ * GAME_STATE for several player/enemy mixes, BULLET_UPDATE from 10 to 1000
+ * bullets (bit-packed, compressed as sent past the compression threshold, plus
+ * the old byte-aligned layout for comparison),
+ * PLAYER_INPUT with and without redundant inputs, and BULLET_DESTROY.
+ * Decoding starts from a reused packet refilled with the encoded bytes, as the
+ * receive path does. Rows go to the log and to CODEC_BENCHMARK_CSV.
+ */
+void Benchmarks::RunMessageCodecBenchmark(BenchmarkResults* results) {
+    std::mt19937 rng(24680);
+    const int64_t now = GetCurrentTimestamp();
+    sf::Packet encoded;
+    sf::Packet decoding;
+    BitWriter writer;
+    PacketCompressor compressor;
+    sf::Packet bitsMessage;
+    sf::Packet decompressed;
+
+    std::ofstream csv(CODEC_BENCHMARK_CSV);
+    const std::string header = "message,format,entities,bytes,encode_msgs_per_sec,decode_msgs_per_sec,ok";
+    if (csv) {
+        csv << header << '\n';
+    }
+    Utils::printMsg("Message codec benchmark (" + header + "):");
+
+    auto report = [&](const std::string& message, const std::string& format, size_t entities,
+        const CodecResult& result) {
+        const std::string row = message + "," + format + "," + std::to_string(entities) + "," +
+            std::to_string(result.bytes) + "," + std::to_string(static_cast<uint64_t>(result.encodePerSecond)) + "," +
+            std::to_string(static_cast<uint64_t>(result.decodePerSecond)) + "," + (result.ok ? "1" : "0");
+        if (csv) {
+            csv << row << '\n';
+        }
+        Utils::printMsg("  " + row, result.ok ? info : warning);
+        // The old byte-aligned layout is only there for comparison
+        if (format != "stream" && result.ok) {
+            const std::string name = "codec." + message + "." + format + "." + std::to_string(entities);
+            Record(results, name + ".encode_ns", 1000000000.0 / result.encodePerSecond, 20.0);
+            Record(results, name + ".decode_ns", 1000000000.0 / result.decodePerSecond, 20.0);
+            Record(results, name + ".bytes", static_cast<double>(result.bytes), 0.0);
+        }
+    };
+    auto refill = [&]() {
+        decoding.clear();
+        decoding.append(encoded.getData(), encoded.getDataSize());
+    };
+    // Bit-packed bodies follow the type byte
+    auto encodeBits = [&](NetMessageType type) -> size_t {
+        encoded.clear();
+        encoded << static_cast<uint8_t>(type);
+        if (writer.HasOverflowed()) {
+            return 0;
+        }
+        writer.AppendTo(encoded);
+        return encoded.getDataSize();
+    };
+
+    // GAME_STATE: players and enemies through the sf::Packet operators
+    const std::pair<size_t, size_t> stateMixes[] = { { 1, 0 }, { 8, 20 }, { 32, 50 }, { 64, 100 }, { 64, 250 } };
+    GameStateMessage state;
+    GameStateMessage decodedState;
+    state.timestamp = now;
+    for (const auto& [playerCount, enemyCount] : stateMixes) {
+        state.players.clear();
+        state.enemies.clear();
+        for (size_t i = 0; i < playerCount; ++i) {
+            state.players.push_back(MakeBenchPlayer(rng, static_cast<uint32_t>(i) + 1));
+        }
+        for (size_t i = 0; i < enemyCount; ++i) {
+            state.enemies.push_back(MakeBenchEnemy(rng, 1000 + static_cast<uint32_t>(i)));
+        }
+        CodecResult result = MeasureCodec(
+            [&]() -> size_t {
+                encoded.clear();
+                encoded << state;
+                return encoded.getDataSize();
+            },
+            [&]() {
+                refill();
+                return static_cast<bool>(decoding >> decodedState) && decodedState.enemies.size() == enemyCount;
+            });
+        report("GAME_STATE", "packet", playerCount + enemyCount, result);
+    }
+
+    // BULLET_UPDATE: bit-packed as sent, and the byte-aligned layout it replaced
+    const size_t bulletCounts[] = { 10, 50, 100, 250, 500, 1000 };
+    BulletUpdateMessage bullets;
+    BulletUpdateMessage decodedBullets;
+    bullets.timestamp = now;
+    for (size_t bulletCount : bulletCounts) {
+        bullets.bullets.clear();
+        for (size_t i = 0; i < bulletCount; ++i) {
+            bullets.bullets.push_back(MakeBenchBullet(rng, static_cast<uint32_t>(i), now));
+        }
+        CodecResult bits = MeasureCodec(
+            [&]() -> size_t {
+                writer.Reset();
+                NetworkUtils::Write(writer, bullets);
+                return encodeBits(bullets.type);
+            },
+            [&]() {
+                refill();
+                uint8_t type = 0;
+                decoding >> type;
+                BitReader reader = BitReader::FromPacket(decoding);
+                return NetworkUtils::Read(reader, decodedBullets) && decodedBullets.bullets.size() == bulletCount;
+            });
+        report("BULLET_UPDATE", "bits", bulletCount, bits);
+
+        // Compressed envelope around the bit-packed message; decoding includes decompression
+        writer.Reset();
+        NetworkUtils::Write(writer, bullets);
+        encodeBits(bullets.type);
+        bitsMessage = encoded;
+        CodecResult compressed = MeasureCodec(
+            [&]() -> size_t {
+                return compressor.Compress(bitsMessage, encoded) ? encoded.getDataSize() : 0;
+            },
+            [&]() {
+                refill();
+                uint8_t type = 0;
+                decoding >> type;
+                if (!compressor.Decompress(decoding, decompressed)) {
+                    return false;
+                }
+                decompressed >> type;
+                BitReader reader = BitReader::FromPacket(decompressed);
+                return NetworkUtils::Read(reader, decodedBullets) && decodedBullets.bullets.size() == bulletCount;
+            });
+        report("BULLET_UPDATE", "bits+lz", bulletCount, compressed);
+
+        CodecResult stream = MeasureCodec(
+            [&]() -> size_t {
+                encoded.clear();
+                encoded << static_cast<uint8_t>(bullets.type) << static_cast<uint32_t>(bullets.bullets.size());
+                for (const BulletData& bullet : bullets.bullets) {
+                    WriteBulletStream(encoded, bullet);
+                }
+                encoded << bullets.timestamp << bullets.sequenceNumber;
+                return encoded.getDataSize();
+            },
+            [&]() {
+                refill();
+                uint8_t type = 0;
+                uint32_t count = 0;
+                decoding >> type >> count;
+                decodedBullets.bullets.resize(count);
+                for (BulletData& bullet : decodedBullets.bullets) {
+                    decoding >> bullet.bulletId >> bullet.ownerId >> bullet.bulletType
+                        >> bullet.x >> bullet.y >> bullet.velocityX >> bullet.velocityY
+                        >> bullet.rotation >> bullet.damage >> bullet.lifetime >> bullet.spawnTime;
+                }
+                decoding >> decodedBullets.timestamp >> decodedBullets.sequenceNumber;
+                return static_cast<bool>(decoding) && count == bulletCount;
+            });
+        report("BULLET_UPDATE", "stream", bulletCount, stream);
+    }
+
+    // PLAYER_INPUT: bare, and with the redundant copies and acks a lossy link adds
+    const size_t redundantCounts[] = { 0, NetworkValidation::MAX_REDUNDANT_INPUTS };
+    PlayerInputMessage input;
+    PlayerInputMessage decodedInput;
+    input.playerId = 7;
+    input.isMoving_forward = true;
+    input.isMoving_left = true;
+    input.barrelRotation = 123.5f;
+    input.timestamp = now;
+    input.sequenceNumber = 5000;
+    input.lastReceivedSnapshot = 4990;
+    input.playerTableVersion = 3;
+    for (size_t redundantCount : redundantCounts) {
+        input.hasReliableAck = redundantCount > 0;
+        input.reliableAckSequence = 42;
+        input.reliableAckBits = 0xFFFF;
+        input.previousInputs.clear();
+        for (size_t i = 0; i < redundantCount; ++i) {
+            RedundantInput redundant;
+            redundant.sequenceNumber = input.sequenceNumber - 1 - static_cast<uint32_t>(i);
+            redundant.isMoving_forward = true;
+            redundant.isMoving_backward = false;
+            redundant.isMoving_left = i % 2 == 0;
+            redundant.isMoving_right = false;
+            input.previousInputs.push_back(redundant);
+        }
+        CodecResult result = MeasureCodec(
+            [&]() -> size_t {
+                writer.Reset();
+                NetworkUtils::Write(writer, input);
+                return encodeBits(input.type);
+            },
+            [&]() {
+                refill();
+                uint8_t type = 0;
+                decoding >> type;
+                BitReader reader = BitReader::FromPacket(decoding);
+                return NetworkUtils::Read(reader, decodedInput, now) && decodedInput.previousInputs.size() == redundantCount;
+            });
+        report("PLAYER_INPUT", "bits", redundantCount, result);
+    }
+
+    // BULLET_DESTROY: fixed size, sf::Packet operators
+    BulletDestroyMessage destroy;
+    BulletDestroyMessage decodedDestroy;
+    destroy.bulletId = 12345;
+    destroy.destroyReason = 2;
+    destroy.hitTargetId = 1007;
+    destroy.hitX = 640.0f;
+    destroy.hitY = 480.0f;
+    destroy.timestamp = now;
+    destroy.sequenceNumber = 99;
+    CodecResult destroyResult = MeasureCodec(
+        [&]() -> size_t {
+            encoded.clear();
+            encoded << destroy;
+            return encoded.getDataSize();
+        },
+        [&]() {
+            refill();
+            return static_cast<bool>(decoding >> decodedDestroy) && decodedDestroy.bulletId == destroy.bulletId;
+        });
+    report("BULLET_DESTROY", "packet", 1, destroyResult);
+
+    if (csv) {
+        Utils::printMsg("  Written to " + std::string(CODEC_BENCHMARK_CSV));
+    }
+    else {
+        Utils::printMsg("  Could not write " + std::string(CODEC_BENCHMARK_CSV), warning);
+    }
+}
+
+/**
+ * Steps synthetic worlds through the enemy, bullet and collision phases of a
+ * server tick and reports the mean ns/tick of each. Worlds are seeded, and
+ * topped back up between ticks, so runs on the same build are comparable.
+ * Info logging is muted while worlds are built (every enemy spawn logs).
+ */
+void Benchmarks::RunSimulationBenchmark(BenchmarkResults* results) {
+    const uint32_t WARMUP_TICKS = 30;
+    const uint32_t MEASURED_TICKS = 300;
+    const float TICK_SECONDS = 1.0f / 60.0f;
+
+    struct Scenario {
+        uint32_t players;
+        uint32_t enemies;
+        uint32_t bullets;
+        float areaFraction;
+    };
+    const Scenario scenarios[] = {
+        { 8, 20, 100, 1.0f },
+        { 32, 50, 500, 1.0f },
+        { 32, 50, 500, 0.1f },
+        { 64, 100, 1000, 1.0f },
+        { 64, 200, 2000, 1.0f },
+        { 64, 200, 2000, 0.1f },
+    };
+
+    Utils::printMsg("Simulation benchmark: " + std::to_string(MEASURED_TICKS) + " ticks at 60 Hz after " +
+        std::to_string(WARMUP_TICKS) + " warm-up ticks, mean ns/tick per phase");
+    for (const Scenario& scenario : scenarios) {
+        SyntheticWorldConfig config;
+        config.playerCount = scenario.players;
+        config.enemyCount = scenario.enemies;
+        config.bulletCount = scenario.bullets;
+        config.areaFraction = scenario.areaFraction;
+
+        Logger::SetMinimumLevel(warning);
+        SyntheticWorld world(config);
+        world.Run(WARMUP_TICKS, TICK_SECONDS);
+        const SimulationTimings timings = world.Run(MEASURED_TICKS, TICK_SECONDS);
+        Logger::SetMinimumLevel(debug);
+
+        std::string line = "  " + std::to_string(scenario.players) + "p/" + std::to_string(scenario.enemies) +
+            "e/" + std::to_string(scenario.bullets) + "b in " +
+            std::to_string(static_cast<int>(scenario.areaFraction * 100.0f)) + "% of the map:";
+        const std::string name = "simulation." + std::to_string(scenario.players) + "p" +
+            std::to_string(scenario.enemies) + "e" + std::to_string(scenario.bullets) + "b_" +
+            std::to_string(static_cast<int>(scenario.areaFraction * 100.0f)) + "pct.";
+        double totalNs = 0.0;
+        for (size_t phase = 0; phase < static_cast<size_t>(SimulationPhase::COUNT); ++phase) {
+            const double ns = timings.GetNsPerTick(static_cast<SimulationPhase>(phase));
+            totalNs += ns;
+            Record(results, name + MetricKey(GetSimulationPhaseName(static_cast<SimulationPhase>(phase))) + "_ns", ns, 500.0);
+            line += " " + std::string(GetSimulationPhaseName(static_cast<SimulationPhase>(phase))) + " " +
+                std::to_string(static_cast<uint64_t>(ns)) + " ns,";
+        }
+        line += " total " + std::to_string(static_cast<uint64_t>(totalNs)) + " ns";
+        Record(results, name + "total_ns", totalNs, 1000.0);
+        Utils::printMsg(line);
+    }
+}
+
+/**
+ * Players join through HandleJoinRequest and leave as timed-out clients do,
+ * each staying a quarter of a second, on top of 32 steady players and 50
+ * enemies. Each tick's leaves, joins and state send are timed together; the
+ * simulation itself is left out (RunSimulationBenchmark covers it).
+ */
+void Benchmarks::RunChurnBenchmark(BenchmarkResults* results) {
+    const uint32_t WARMUP_TICKS = 60;
+    const uint32_t MEASURED_TICKS = 600;
+    const uint32_t SESSION_TICKS = 15;
+    const float TICK_SECONDS = 1.0f / 60.0f;
+    const uint32_t churnRates[] = { 0, 1, 2, 4 };     // Joins per tick
+
+    Utils::printMsg("Churn benchmark: " + std::to_string(MEASURED_TICKS) + " ticks at 60 Hz after " +
+        std::to_string(WARMUP_TICKS) + " warm-up ticks, join/leave and state send time per tick");
+    for (uint32_t joinsPerTick : churnRates) {
+        SyntheticWorldConfig config;
+        config.playerCount = 32;
+        config.enemyCount = 50;
+        config.bulletCount = 0;
+
+        Logger::SetMinimumLevel(warning);
+        SyntheticWorld world(config);
+        world.RunChurn(WARMUP_TICKS, joinsPerTick, SESSION_TICKS, TICK_SECONDS);
+        const ChurnTimings timings = world.RunChurn(MEASURED_TICKS, joinsPerTick, SESSION_TICKS, TICK_SECONDS);
+        Logger::SetMinimumLevel(debug);
+
+        const double seconds = MEASURED_TICKS * TICK_SECONDS;
+        const std::string name = "churn." + std::to_string(joinsPerTick) + "_joins_per_tick.";
+        Record(results, name + "p50_us", static_cast<double>(timings.tickMicros.GetPercentile(50.0)), 20.0);
+        Record(results, name + "p99_us", static_cast<double>(timings.tickMicros.GetPercentile(99.0)), 50.0);
+        Utils::printMsg("  " + std::to_string(static_cast<int>(timings.joins / seconds)) + " joins/s, " +
+            std::to_string(static_cast<int>(timings.leaves / seconds)) + " leaves/s: p50 " +
+            std::to_string(timings.tickMicros.GetPercentile(50.0)) + " us, p99 " +
+            std::to_string(timings.tickMicros.GetPercentile(99.0)) + " us, max " +
+            std::to_string(timings.tickMicros.GetMax()) + " us");
+    }
+}
+
+/**
+ * Receive: a second thread sends small datagrams (PLAYER_INPUT sized) as fast
+ * as it can while the backend drains them, yielding after each empty poll;
+ * empty polls are part of the cost, as on the server. Send: snapshot-sized datagrams to a
+ * socket nobody reads, through socket.send per datagram or QueueSend batches;
+ * a Registered I/O run ends once every send has completed.
+ * Datagrams the kernel drops on loopback are not counted, so compare the
+ * received counts as well as the rates.
+ */
+void Benchmarks::RunSocketBenchmark() {
+    const uint64_t RECEIVE_COUNT = 200000;
+    const size_t RECEIVE_BYTES = 48;
+    const uint64_t SEND_COUNT = 100000;
+    const size_t SEND_BYTES = 1200;         // PacketAggregator::MAX_DATAGRAM_BYTES
+
+    Utils::printMsg("Socket benchmark over loopback: " + std::to_string(RECEIVE_COUNT) + " x " +
+        std::to_string(RECEIVE_BYTES) + " B received, " + std::to_string(SEND_COUNT) + " x " +
+        std::to_string(SEND_BYTES) + " B sent");
+    if (!BatchedUdpSocket::IsSupported()) {
+        Utils::printMsg("  Batched socket is not available on this platform; measuring sf::UdpSocket only", warning);
+    }
+
+    {
+        sf::UdpSocket socket;
+        if (socket.bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+            Utils::printMsg("  Could not bind a receive socket, skipping", warning);
+            return;
+        }
+        socket.setBlocking(false);
+        sf::Packet packet;
+        std::optional<sf::IpAddress> sender;
+        unsigned short senderPort = 0;
+        const SocketResult result = MeasureReceive(socket.getLocalPort(), RECEIVE_COUNT, RECEIVE_BYTES, [&]() -> size_t {
+            return socket.receive(packet, sender, senderPort) == sf::Socket::Status::Done ? 1 : 0;
+            });
+        PrintSocketResult("receive sf::UdpSocket", result, RECEIVE_COUNT);
+    }
+    if (BatchedUdpSocket::IsSupported()) {
+        BatchedUdpSocket socket;
+        if (socket.Bind(0)) {
+            const SocketResult result = MeasureReceive(socket.GetLocalPort(), RECEIVE_COUNT, RECEIVE_BYTES, [&]() {
+                return socket.ReceiveBatch();
+                });
+            PrintSocketResult("receive batched", result, RECEIVE_COUNT);
+        }
+    }
+
+    sf::UdpSocket sink;
+    if (sink.bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+        Utils::printMsg("  Could not bind a sink socket, skipping the send side", warning);
+        return;
+    }
+    std::vector<uint8_t> bytes(SEND_BYTES, 0xA5);
+    sf::Packet packet;
+    packet.append(bytes.data(), bytes.size());
+    {
+        sf::UdpSocket socket;
+        SocketResult result;
+        const double cpuStart = ThreadCpuMicros();
+        const BenchClock::time_point start = BenchClock::now();
+        for (uint64_t i = 0; i < SEND_COUNT; ++i) {
+            result.datagrams += socket.send(packet, sf::IpAddress::LocalHost, sink.getLocalPort()) == sf::Socket::Status::Done;
+        }
+        result.calls = SEND_COUNT;
+        result.wallMicros = ElapsedMicros(start);
+        result.cpuMicros = ThreadCpuMicros() - cpuStart;
+        PrintSocketResult("send sf::UdpSocket", result, SEND_COUNT);
+    }
+    if (BatchedUdpSocket::IsSupported()) {
+        BatchedUdpSocket socket;
+        if (socket.Bind(0)) {
+            SocketResult result;
+            const double cpuStart = ThreadCpuMicros();
+            const BenchClock::time_point start = BenchClock::now();
+            for (uint64_t i = 0; i < SEND_COUNT; ++i) {
+                socket.QueueSend(packet, sf::IpAddress::LocalHost, sink.getLocalPort());
+            }
+            socket.FlushSends();
+            while (socket.GetDatagramsSent() + socket.GetSendErrors() < SEND_COUNT && ElapsedMicros(start) < 10000000.0) {
+                socket.FlushSends();    // Reaps the remaining Registered I/O completions
+            }
+            result.datagrams = socket.GetDatagramsSent();
+            result.calls = socket.GetSendCalls();
+            result.wallMicros = ElapsedMicros(start);
+            result.cpuMicros = ThreadCpuMicros() - cpuStart;
+            PrintSocketResult("send batched", result, SEND_COUNT);
+        }
+    }
+}
+
+#ifndef HEADLESS_SERVER
+/**
+ * Replays a server snapshot stream (one GAME_STATE every 22 ms carrying every
+ * entity, each orbiting its own point) through an InterpolationManager the way
+ * the client does: arrived snapshots are added, then every 60 Hz frame the
+ * manager advances and each entity's state is read. Each network profile adds
+ * latency, per-snapshot jitter, loss and reordering (a reordered snapshot is
+ * held back two intervals). The same frames drive ClientPrediction as the
+ * local player: one input stored per frame, the unacked inputs collected for
+ * redundancy with ForEachInputAfter, and acks arriving with the surviving snapshots.
+ * Frame time is simulated, so only the work itself is measured.
+ */
+void Benchmarks::RunInterpolationBenchmark(BenchmarkResults* results) {
+    const int WARMUP_FRAMES = 120;
+    const int MEASURED_FRAMES = 1200;
+    const float FRAME_SECONDS = 1.0f / 60.0f;
+    const int64_t SNAPSHOT_INTERVAL_MS = 22;    // GameServer gameStateUpdateRate
+    const float TWO_PI = 6.2831853f;
+
+    struct NetworkProfile {
+        const char* name;
+        int64_t latencyMs;      // One way
+        int64_t jitterMs;       // Uniform extra delay per snapshot, 0..jitterMs
+        float lossPercent;
+        float reorderPercent;
+    };
+    const NetworkProfile profiles[] = {
+        { "clean", 40, 0, 0.0f, 0.0f },
+        { "jittery", 40, 25, 5.0f, 3.0f },
+        { "poor", 80, 60, 15.0f, 5.0f },
+    };
+    const size_t entityCounts[] = { 8, 64, 512 };
+
+    struct PendingSnapshot {
+        int64_t arrivalMs;
+        int64_t serverTimeMs;
+    };
+    struct Orbit {
+        sf::Vector2f center;
+        float radius;
+        float angularSpeed;     // Radians per second
+    };
+
+    Utils::printMsg("Interpolation benchmark: " + std::to_string(MEASURED_FRAMES) + " frames at 60 Hz after " +
+        std::to_string(WARMUP_FRAMES) + " warm-up frames, per-frame mean time and allocations");
+    for (const NetworkProfile& profile : profiles) {
+        for (size_t entityCount : entityCounts) {
+            std::mt19937 rng(13579);
+            std::uniform_real_distribution<float> percentDist(0.0f, 100.0f);
+            std::uniform_int_distribution<int64_t> jitterDist(0, profile.jitterMs);
+            std::uniform_real_distribution<float> xDist(WorldConstants::PLAYABLE_MIN_X, WorldConstants::PLAYABLE_MAX_X);
+            std::uniform_real_distribution<float> yDist(WorldConstants::PLAYABLE_MIN_Y, WorldConstants::PLAYABLE_MAX_Y);
+            std::uniform_real_distribution<float> speedDist(0.5f, 2.0f);
+
+            std::vector<Orbit> orbits(entityCount);
+            for (Orbit& orbit : orbits) {
+                orbit = { sf::Vector2f(xDist(rng), yDist(rng)), 100.0f, speedDist(rng) };
+            }
+
+            Logger::SetMinimumLevel(warning);   // Buffer creation and the periodic stats log at debug
+            InterpolationManager interpolation;
+            std::vector<InterpolationManager::EntityState> interpolatedStates;
+            ClientPrediction prediction;
+            std::vector<PendingSnapshot> pending;
+            const int64_t startMs = 1000000;
+            interpolation.Initialize(startMs);
+            int64_t nextSnapshotMs = startMs;
+            uint32_t lastAckedInput = 0;
+            size_t unackedVisited = 0;
+
+            double ingestMicros = 0.0;
+            double renderMicros = 0.0;
+            double predictionMicros = 0.0;
+            double inputsAfterMicros = 0.0;
+            uint64_t ingestAllocations = 0;
+            uint64_t renderAllocations = 0;
+            uint64_t predictionAllocations = 0;
+            uint64_t extrapolatedReads = 0;
+            uint64_t reads = 0;
+
+            for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; ++frame) {
+                const bool measured = frame >= WARMUP_FRAMES;
+                const int64_t nowMs = startMs + static_cast<int64_t>(frame * 1000 / 60);
+
+                // Server side: snapshots sent up to now, if they survive the link
+                while (nextSnapshotMs <= nowMs) {
+                    if (percentDist(rng) >= profile.lossPercent) {
+                        int64_t delay = profile.latencyMs + jitterDist(rng);
+                        if (percentDist(rng) < profile.reorderPercent) {
+                            delay += 2 * SNAPSHOT_INTERVAL_MS;
+                        }
+                        pending.push_back({ nextSnapshotMs + delay, nextSnapshotMs });
+                    }
+                    nextSnapshotMs += SNAPSHOT_INTERVAL_MS;
+                }
+
+                // Ingest every snapshot that has arrived, in arrival order
+                std::sort(pending.begin(), pending.end(), [](const PendingSnapshot& a, const PendingSnapshot& b) {
+                    return a.arrivalMs < b.arrivalMs;
+                });
+                size_t arrived = 0;
+                uint64_t allocationsBefore = AllocationCounter::GetCount();
+                BenchClock::time_point start = BenchClock::now();
+                while (arrived < pending.size() && pending[arrived].arrivalMs <= nowMs) {
+                    const int64_t serverTimeMs = pending[arrived].serverTimeMs;
+                    interpolation.RecordSnapshotArrival(pending[arrived].arrivalMs, serverTimeMs);
+                    const float seconds = static_cast<float>(serverTimeMs - startMs) / 1000.0f;
+                    for (size_t i = 0; i < entityCount; ++i) {
+                        const Orbit& orbit = orbits[i];
+                        const float angle = std::fmod(orbit.angularSpeed * seconds, TWO_PI);
+                        EntitySnapshot snapshot(serverTimeMs,
+                            orbit.center + sf::Vector2f(std::cos(angle), std::sin(angle)) * orbit.radius,
+                            sf::radians(angle + TWO_PI / 4.0f), sf::radians(angle));
+                        snapshot.isMoving_forward = true;
+                        interpolation.AddEntitySnapshot(static_cast<uint32_t>(i) + 1, snapshot);
+                    }
+                    arrived++;
+                }
+                if (measured) {
+                    ingestMicros += ElapsedMicros(start);
+                    ingestAllocations += AllocationCounter::GetCount() - allocationsBefore;
+                }
+                // The ack riding on the newest arrived snapshot covers inputs sent a round trip ago
+                if (arrived > 0) {
+                    const int64_t inputFramesInFlight = (2 * profile.latencyMs) * 60 / 1000;
+                    const uint32_t latestInput = prediction.GetLatestSequenceNumber();
+                    if (latestInput > static_cast<uint32_t>(inputFramesInFlight)) {
+                        lastAckedInput = latestInput - static_cast<uint32_t>(inputFramesInFlight);
+                        prediction.AcknowledgeInput(lastAckedInput);
+                    }
+                }
+                pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(arrived));
+
+                // Render: advance the clock and read every entity
+                allocationsBefore = AllocationCounter::GetCount();
+                start = BenchClock::now();
+                interpolation.SyncRenderClock(nowMs);
+                interpolation.Update(FRAME_SECONDS);
+                interpolation.EvaluateAll(interpolatedStates);
+                for (const InterpolationManager::EntityState& entity : interpolatedStates) {
+                    reads++;
+                    extrapolatedReads += entity.state.wasExtrapolated ? 1 : 0;
+                }
+                if (measured) {
+                    renderMicros += ElapsedMicros(start);
+                    renderAllocations += AllocationCounter::GetCount() - allocationsBefore;
+                }
+
+                // Local player: NetworkClient::SendPlayerInput's prediction bookkeeping
+                allocationsBefore = AllocationCounter::GetCount();
+                start = BenchClock::now();
+                InputState input;
+                input.timestamp = nowMs;
+                input.moveForward = (frame / 90) % 2 == 0;
+                input.turnLeft = (frame / 40) % 3 == 0;
+                input.deltaTime = FRAME_SECONDS;
+                const uint32_t sequence = prediction.StoreInput(input);
+                prediction.StorePredictedState(PredictedState(sequence, nowMs, sf::Vector2f(), sf::degrees(0), sf::degrees(0)));
+                BenchClock::time_point inputsAfterStart = BenchClock::now();
+                size_t visited = 0;
+                prediction.ForEachInputAfter(lastAckedInput, [&](const InputState&) { visited++; });
+                if (measured) {
+                    inputsAfterMicros += ElapsedMicros(inputsAfterStart);
+                    unackedVisited += visited;
+                }
+                if (sequence % 30 == 0) {
+                    prediction.CleanupOldHistory(lastAckedInput);
+                }
+                if (measured) {
+                    predictionMicros += ElapsedMicros(start);
+                    predictionAllocations += AllocationCounter::GetCount() - allocationsBefore;
+                }
+            }
+            Logger::SetMinimumLevel(debug);
+
+            const double frames = static_cast<double>(MEASURED_FRAMES);
+            const uint64_t extrapolatedPercent = reads > 0 ? extrapolatedReads * 100 / reads : 0;
+            const std::string name = "interpolation." + std::string(profile.name) + "." + std::to_string(entityCount) + ".";
+            Record(results, name + "ingest_us", ingestMicros / frames, 1.0);
+            Record(results, name + "render_us", renderMicros / frames, 1.0);
+            Record(results, name + "prediction_us", predictionMicros / frames, 1.0);
+            Record(results, name + "allocations", static_cast<double>(ingestAllocations + renderAllocations + predictionAllocations) / frames, 0.1);
+            Utils::printMsg("  " + std::string(profile.name) + ", " + std::to_string(entityCount) + " entities:" +
+                " ingest " + std::to_string(ingestMicros / frames) + " us (" +
+                std::to_string(static_cast<double>(ingestAllocations) / frames) + " allocs)," +
+                " render " + std::to_string(renderMicros / frames) + " us (" +
+                std::to_string(static_cast<double>(renderAllocations) / frames) + " allocs, " +
+                std::to_string(extrapolatedPercent) + "% extrapolated, delay " +
+                std::to_string(interpolation.GetInterpolationDelay()) + " ms),"  +
+                " prediction " + std::to_string(predictionMicros / frames) + " us (ForEachInputAfter " +
+                std::to_string(inputsAfterMicros / frames) + " us over " +
+                std::to_string(static_cast<double>(unackedVisited) / frames) + " inputs, " +
+                std::to_string(static_cast<double>(predictionAllocations) / frames) + " allocs)");
+        }
+    }
+}
+#endif
+
+int Benchmarks::RunAll(BenchmarkResults* results) {
+    try {
+        RunBroadphaseBenchmark(results);
+        RunSerializationBenchmark(results);
+        RunReceivePathBenchmark(results);
+        RunMessageCodecBenchmark(results);
+        RunSimulationBenchmark(results);
+        RunChurnBenchmark(results);
+        RunSocketBenchmark();
+#ifndef HEADLESS_SERVER
+        RunInterpolationBenchmark(results);
+        RunHordeBenchmark(results);
+#endif
+        Utils::printMsg("Benchmarks complete", success);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception while running benchmarks: " + std::string(e.what()), error);
+        return -1;
+    }
+}
+
+#ifndef HEADLESS_SERVER
+/**
+ * The standard server load test: an in-process server holding a horde of
+ * enemies (GameServer::SetHordeSize) against loopback bots that move and
+ * fire, so the numbers cover the whole tick including replication, not only
+ * the simulation phases SyntheticWorld times. Each horde size gets a fresh
+ * server; the averages include the first ticks while the horde spawns.
+ */
+void Benchmarks::RunHordeBenchmark(BenchmarkResults* results) {
+    const uint32_t hordeSizes[] = { 100, 1000, 5000 };
+    const uint32_t BOT_COUNT = 16;
+    const float RUN_SECONDS = 10.0f;
+    const float FRAME_SECONDS = 1.0f / 60.0f;
+    const uint32_t HORDE_SEED = 86420;      // Server and bots, so every run spawns and drives the same
+
+    Utils::printMsg("Horde benchmark: " + std::to_string(BOT_COUNT) + " bots on the loopback network for " +
+        std::to_string(static_cast<int>(RUN_SECONDS)) + " s per horde size");
+    for (uint32_t hordeSize : hordeSizes) {
+        Logger::SetMinimumLevel(error);     // Spawns, joins and the bots' windows
+        LocalServer server;
+        if (!server.Start([hordeSize](GameServer& game) {
+            game.SetHordeSize(hordeSize);
+            game.SetStatsReportingEnabled(false);
+            game.SetRandomSeed(HORDE_SEED);
+            })) {
+            Logger::SetMinimumLevel(debug);
+            continue;
+        }
+        BotLoadConfig config;
+        config.loopback = &server.GetNetwork();
+        config.botCount = BOT_COUNT;
+        config.maxSessionSeconds = 0.0f;
+        config.runSeconds = RUN_SECONDS;
+        config.seed = HORDE_SEED;
+        BenchClock::time_point start = BenchClock::now();
+        double botMicros = 0.0;
+        uint64_t frames = 0;
+        {
+            BotLoadGenerator bots(config);
+            BenchClock::time_point frameStart = start;
+            while (ElapsedMicros(start) < RUN_SECONDS * 1000000.0) {
+                const BenchClock::time_point now = BenchClock::now();
+                bots.Update(std::chrono::duration<float>(now - frameStart).count());
+                frameStart = now;
+                botMicros += ElapsedMicros(now);
+                frames++;
+                const std::chrono::duration<float> frameTime = BenchClock::now() - now;
+                if (frameTime.count() < FRAME_SECONDS) {
+                    std::this_thread::sleep_for(std::chrono::duration<float>(FRAME_SECONDS) - frameTime);
+                }
+            }
+            bots.Shutdown();
+        }
+        GameServer::RunReport report;
+        server.Stop(&report);
+        const double seconds = ElapsedMicros(start) / 1000000.0;
+        Logger::SetMinimumLevel(debug);
+
+        Utils::printMsg("  " + std::to_string(hordeSize) + " enemies (" + std::to_string(report.enemies) +
+            " at the end), " + std::to_string(report.players) + " players: tick mean " +
+            std::to_string(report.ticks.GetAverageTickMs()) + " ms, max " + std::to_string(report.ticks.maxTickMs) +
+            " ms, " + std::to_string(report.ticks.overrunTicks) + " of " + std::to_string(report.ticks.ticksRun) +
+            " overran, " + std::to_string(report.ticks.droppedTicks) + " dropped");
+        const std::string name = "horde." + std::to_string(hordeSize) + "e.";
+        Record(results, name + "tick_mean_us", report.ticks.GetAverageTickMs() * 1000.0, 100.0);
+        std::string phases = "    Phase means:";
+        for (size_t i = 0; i < static_cast<size_t>(TickPhase::COUNT); ++i) {
+            Record(results, name + MetricKey(GetTickPhaseName(static_cast<TickPhase>(i))) + "_us", report.phaseAverageMicros[i], 50.0);
+            phases += " " + std::string(GetTickPhaseName(static_cast<TickPhase>(i))) + " " +
+                std::to_string(static_cast<int>(report.phaseAverageMicros[i])) + " us";
+        }
+        Utils::printMsg(phases);
+        const double botFrameMicros = frames > 0 ? botMicros / static_cast<double>(frames) : 0.0;
+        Record(results, name + "bot_frame_us", botFrameMicros, 50.0);
+        Utils::printMsg("    Bots: " + std::to_string(botFrameMicros) + " us per frame for " + std::to_string(BOT_COUNT));
+        Utils::printMsg("    Sent: " + report.traffic.FormatSent(seconds));
+        Utils::printMsg("    Received: " + report.traffic.FormatReceived(seconds));
+    }
+}
+#endif
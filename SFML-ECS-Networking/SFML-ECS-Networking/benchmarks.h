@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// One hot-path number a benchmark reports to the regression gate
+// (benchmark_gate.h). Every metric is lower-is-better: a time, a size or
+// an allocation count.
+struct BenchmarkMetric {
+    std::string name;       // "<suite>.<case>.<metric>", the same on every run
+    double value = 0.0;
+    double floor = 0.0;     // Rises smaller than this are noise whatever the percentage
+};
+using BenchmarkResults = std::vector<BenchmarkMetric>;
+
+// In-binary performance benchmarks, selectable from the main menu.
+// Each benchmark prints its results through Utils::printMsg, and appends its
+// hot-path metrics to results when given. Seeds are fixed, so runs on the
+// same build and machine are comparable.
+namespace Benchmarks {
+    // Bullet-vs-target collision cost: naive all-pairs vs SpatialGrid broadphase,
+    // each with one-pair and CircleBatch (SIMD) narrowphase
+    void RunBroadphaseBenchmark(BenchmarkResults* results = nullptr);
+
+    // BULLET_UPDATE encode cost and size: sf::Packet stream operators vs BitWriter
+    void RunSerializationBenchmark(BenchmarkResults* results = nullptr);
+
+    // Heap allocations on the server receive path under a 32-player input load
+    void RunReceivePathBenchmark(BenchmarkResults* results = nullptr);
+
+    // Encode/decode throughput and wire size of the NetworkUtils codecs for
+    // GAME_STATE, BULLET_UPDATE, PLAYER_INPUT and BULLET_DESTROY. Also written
+    // as CSV to CODEC_BENCHMARK_CSV for side-by-side comparison of formats.
+    constexpr const char* CODEC_BENCHMARK_CSV = "codec_benchmark.csv";
+    void RunMessageCodecBenchmark(BenchmarkResults* results = nullptr);
+
+    // ns/tick of the server simulation phases on synthetic worlds (no sockets)
+    // from 8 players/20 enemies/100 bullets up to 64/200/2000, spread and packed
+    void RunSimulationBenchmark(BenchmarkResults* results = nullptr);
+
+    // Tick cost percentiles of the join/leave path and state send against
+    // joins and leaves per second, on a synthetic world with 32 players
+    void RunChurnBenchmark(BenchmarkResults* results = nullptr);
+
+    // Datagrams/s and thread CPU per datagram over loopback for the plain
+    // sf::UdpSocket path against BatchedUdpSocket (recvmmsg/sendmmsg on
+    // Linux, Registered I/O on Windows), receiving and sending. Reports no
+    // metrics: loopback throughput is the kernel's, too noisy to gate on.
+    void RunSocketBenchmark();
+
+#ifndef HEADLESS_SERVER
+    // Per-frame cost and allocations of snapshot interpolation (8/64/512 remote
+    // entities) and input prediction bookkeeping, under clean and lossy streams
+    void RunInterpolationBenchmark(BenchmarkResults* results = nullptr);
+
+    // The standard server load test: tick phase timings and bandwidth of an
+    // in-process server holding 100/1,000/5,000 enemies against 16 loopback
+    // bots, plus what stepping the bots (BotLoadGenerator) costs per frame
+    void RunHordeBenchmark(BenchmarkResults* results = nullptr);
+#endif
+
+    // Runs every benchmark in sequence
+    // @return 0 on success, -1 if a benchmark threw
+    int RunAll(BenchmarkResults* results = nullptr);
+}
@@ -0,0 +1,179 @@
+#include "bit_stream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr int VARINT_GROUP_BITS = 7;
+    constexpr int MAX_VARINT64_GROUPS = 10;    // ceil(64 / 7)
+}
+
+/**
+ * Appends the low bitCount bits of value.
+ * Bits are copied in byte-sized chunks rather than one at a time.
+ */
+void BitWriter::WriteBits(uint32_t value, int bitCount) {
+    if (overflowed || bitCount <= 0) {
+        return;
+    }
+    bitCount = std::min(bitCount, 32);
+    if (bitPosition + static_cast<size_t>(bitCount) > MAX_BYTES * 8) {
+        overflowed = true;
+        return;
+    }
+    if (bitCount < 32) {
+        value &= (1u << bitCount) - 1u;
+    }
+
+    while (bitCount > 0) {
+        const size_t byteIndex = bitPosition / 8;
+        const int bitOffset = static_cast<int>(bitPosition % 8);
+        const int chunkBits = std::min(8 - bitOffset, bitCount);
+        const uint8_t chunk = static_cast<uint8_t>(value & ((1u << chunkBits) - 1u));
+
+        if (bitOffset == 0) {
+            buffer[byteIndex] = chunk;  // First write to this byte clears stale bits
+        }
+        else {
+            buffer[byteIndex] |= static_cast<uint8_t>(chunk << bitOffset);
+        }
+
+        value >>= chunkBits;
+        bitCount -= chunkBits;
+        bitPosition += chunkBits;
+    }
+}
+
+void BitWriter::WriteVarUint(uint32_t value) {
+    WriteVarUint64(value);
+}
+
+/**
+ * Writes value as 7-bit groups, least significant first; bit 7 of each group
+ * says another group follows.
+ */
+void BitWriter::WriteVarUint64(uint64_t value) {
+    do {
+        uint32_t group = static_cast<uint32_t>(value & 0x7F);
+        value >>= VARINT_GROUP_BITS;
+        if (value != 0) {
+            group |= 0x80;
+        }
+        WriteBits(group, VARINT_GROUP_BITS + 1);
+    } while (value != 0 && !overflowed);
+}
+
+void BitWriter::WriteVarInt(int32_t value) {
+    const uint32_t zigZag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    WriteVarUint(zigZag);
+}
+
+void BitWriter::WriteFloat(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    WriteBits(bits, 32);
+}
+
+/**
+ * Copies other's bits 32 at a time; its bytes are little-endian words of the
+ * same LSB-first stream.
+ */
+void BitWriter::Append(const BitWriter& other) {
+    if (other.overflowed) {
+        overflowed = true;
+        return;
+    }
+    const size_t byteCount = other.GetByteCount();
+    size_t copied = 0;
+    while (copied < other.bitPosition && !overflowed) {
+        const size_t byteIndex = copied / 8;
+        const int bitCount = static_cast<int>(std::min<size_t>(32, other.bitPosition - copied));
+        uint32_t word = 0;
+        for (size_t i = 0; i < 4 && byteIndex + i < byteCount; ++i) {
+            word |= static_cast<uint32_t>(other.buffer[byteIndex + i]) << (8 * i);
+        }
+        WriteBits(word, bitCount);
+        copied += static_cast<size_t>(bitCount);
+    }
+}
+
+void BitWriter::AppendTo(sf::Packet& packet) const {
+    if (!overflowed && bitPosition > 0) {
+        packet.append(buffer.data(), GetByteCount());
+    }
+}
+
+BitReader::BitReader(const void* data, size_t sizeInBytes)
+    : data(static_cast<const uint8_t*>(data)), totalBits(sizeInBytes * 8), bitPosition(0),
+    valid(data != nullptr || sizeInBytes == 0) {
+}
+
+BitReader BitReader::FromPacket(const sf::Packet& packet) {
+    const size_t readPosition = std::min(packet.getReadPosition(), packet.getDataSize());
+    const uint8_t* bytes = static_cast<const uint8_t*>(packet.getData());
+    return BitReader(bytes ? bytes + readPosition : nullptr, packet.getDataSize() - readPosition);
+}
+
+/**
+ * @return The next bitCount bits, or 0 (and the reader invalid) if not enough remain
+ */
+uint32_t BitReader::ReadBits(int bitCount) {
+    if (!valid || bitCount <= 0) {
+        return 0;
+    }
+    bitCount = std::min(bitCount, 32);
+    if (bitPosition + static_cast<size_t>(bitCount) > totalBits) {
+        valid = false;
+        return 0;
+    }
+
+    uint32_t value = 0;
+    int written = 0;
+    while (written < bitCount) {
+        const size_t byteIndex = bitPosition / 8;
+        const int bitOffset = static_cast<int>(bitPosition % 8);
+        const int chunkBits = std::min(8 - bitOffset, bitCount - written);
+        const uint32_t chunk = (static_cast<uint32_t>(data[byteIndex]) >> bitOffset) & ((1u << chunkBits) - 1u);
+
+        value |= chunk << written;
+        written += chunkBits;
+        bitPosition += chunkBits;
+    }
+    return value;
+}
+
+uint32_t BitReader::ReadVarUint() {
+    const uint64_t value = ReadVarUint64();
+    if (value > UINT32_MAX) {
+        valid = false;
+        return 0;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+/**
+ * Reads a varint; more than MAX_VARINT64_GROUPS groups is treated as corrupt.
+ */
+uint64_t BitReader::ReadVarUint64() {
+    uint64_t value = 0;
+    for (int group = 0; group < MAX_VARINT64_GROUPS && valid; ++group) {
+        const uint32_t bits = ReadBits(VARINT_GROUP_BITS + 1);
+        value |= static_cast<uint64_t>(bits & 0x7F) << (group * VARINT_GROUP_BITS);
+        if ((bits & 0x80) == 0) {
+            return valid ? value : 0;
+        }
+    }
+    valid = false;
+    return 0;
+}
+
+int32_t BitReader::ReadVarInt() {
+    const uint32_t zigZag = ReadVarUint();
+    return static_cast<int32_t>((zigZag >> 1) ^ (~(zigZag & 1u) + 1u));
+}
+
+float BitReader::ReadFloat() {
+    const uint32_t bits = ReadBits(32);
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
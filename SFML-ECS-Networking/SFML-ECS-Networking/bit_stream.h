@@ -0,0 +1,80 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Bit-packed writer over a fixed, preallocated buffer.
+// Bits are packed LSB-first within each byte. Writing past the end sets the
+// overflow flag and drops the data instead of growing the buffer, so callers
+// check HasOverflowed() before handing the bytes to sf::Packet.
+class BitWriter {
+public:
+    // Largest message body, sized for a crowded world rather than one MTU
+    // (PacketAggregator fragments anything that doesn't fit a datagram)
+    static constexpr size_t MAX_BYTES = 8192;
+
+    BitWriter() : bitPosition(0), overflowed(false) {}
+
+    // Starts a new message (buffer is reused, not cleared)
+    void Reset() { bitPosition = 0; overflowed = false; }
+
+    // @param bitCount 1..32; upper bits of value beyond bitCount are ignored
+    void WriteBits(uint32_t value, int bitCount);
+    void WriteBool(bool value) { WriteBits(value ? 1u : 0u, 1); }
+
+    // Small enums and quantized values with a known bit width
+    template <typename Enum>
+    void WriteEnum(Enum value, int bitCount) { WriteBits(static_cast<uint32_t>(value), bitCount); }
+    void WriteQuantized(uint16_t value, int bitCount) { WriteBits(value, bitCount); }
+
+    // 7 bits per group plus a continuation bit: IDs and counters below 128 take 8 bits
+    void WriteVarUint(uint32_t value);
+    void WriteVarUint64(uint64_t value);
+    void WriteVarInt(int32_t value);        // Zig-zag, so small negatives stay small
+
+    void WriteFloat(float value);           // Full 32-bit precision
+
+    // Every bit other has written, right after the ones already here (no padding)
+    void Append(const BitWriter& other);
+
+    // Appends the written bytes (padded to a whole byte) to packet
+    void AppendTo(sf::Packet& packet) const;
+
+    size_t GetBitCount() const { return bitPosition; }
+    size_t GetByteCount() const { return (bitPosition + 7) / 8; }
+    bool HasOverflowed() const { return overflowed; }
+
+private:
+    std::array<uint8_t, MAX_BYTES> buffer;
+    size_t bitPosition;
+    bool overflowed;
+};
+
+// Reader for BitWriter output. Any read past the end or malformed varint marks
+// the reader invalid; later reads return zeros, so a message can be parsed
+// field by field and checked once with IsValid() at the end.
+class BitReader {
+public:
+    BitReader(const void* data, size_t sizeInBytes);
+
+    // Reads the unread remainder of packet (after fields extracted with >>)
+    static BitReader FromPacket(const sf::Packet& packet);
+
+    uint32_t ReadBits(int bitCount);
+    bool ReadBool() { return ReadBits(1) != 0; }
+    uint16_t ReadQuantized(int bitCount) { return static_cast<uint16_t>(ReadBits(bitCount)); }
+    uint32_t ReadVarUint();
+    uint64_t ReadVarUint64();
+    int32_t ReadVarInt();
+    float ReadFloat();
+
+    bool IsValid() const { return valid; }
+    size_t GetRemainingBits() const { return valid ? totalBits - bitPosition : 0; }
+
+private:
+    const uint8_t* data;
+    size_t totalBits;
+    size_t bitPosition;
+    bool valid;
+};
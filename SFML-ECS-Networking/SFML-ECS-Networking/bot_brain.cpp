@@ -0,0 +1,134 @@
+#include "bot_brain.h"
+#include "bullet_stats.h"
+#include "network_client.h"
+#include <cmath>
+
+namespace {
+    constexpr float VELOCITY_SMOOTHING = 0.3f;      // Weight of the newest sample
+    constexpr float DRIVE_ANGLE = 60.0f;            // Drive forward within this of the wanted heading
+    constexpr float REVERSE_ANGLE = 120.0f;         // Back up past this instead of turning around
+    constexpr float MIN_STEP = 0.01f;               // Shadow moves shorter than this count as standing
+
+    float WrapDegrees(float degrees) {
+        degrees = std::fmod(degrees + 180.0f, 360.0f);
+        return (degrees < 0.0f ? degrees + 360.0f : degrees) - 180.0f;
+    }
+}
+
+BotBrain::BotBrain(uint32_t botIndex, uint64_t seed)
+    : shadow(static_cast<EnemyTank::EnemyType>(botIndex % EnemyTank::ENEMY_TYPE_COUNT), sf::Vector2f(0.0f, 0.0f),
+        RandomStream(seed, RandomPurpose::ENEMY_AI, botIndex, 0), false),
+    scanTimer(0.0f), targetId(0), targetLastPosition(0.0f, 0.0f), targetVelocity(0.0f, 0.0f), tick(0) {
+}
+
+/**
+ * Picks targets as the server does for enemies: without one, the best
+ * scored (proximity, then damage) replicated enemy in detection range, at
+ * most every RESCAN_INTERVAL; a target is kept until it dies, leaves the
+ * view or escapes twice the detection range. It reaches the shadow at its
+ * lead position.
+ */
+void BotBrain::UpdateTarget(const NetworkClient& client, float deltaTime) {
+    const auto& enemies = client.GetEnemies();
+    const sf::Vector2f position = shadow.GetPosition();
+
+    auto current = enemies.find(targetId);
+    scanTimer -= deltaTime;
+    if ((current == enemies.end() || current->second.health <= 0.0f) && scanTimer <= 0.0f) {
+        scanTimer = RESCAN_INTERVAL;
+        const float range = shadow.GetDetectionRange();
+        uint32_t bestId = 0;
+        float bestScore = -1.0f;
+        for (const auto& [enemyId, enemy] : enemies) {
+            if (enemy.health <= 0.0f) {
+                continue;
+            }
+            const float dx = enemy.x - position.x;
+            const float dy = enemy.y - position.y;
+            const float distanceSq = dx * dx + dy * dy;
+            if (distanceSq > range * range) {
+                continue;
+            }
+            const float proximity = 1.0f - std::sqrt(distanceSq) / range;
+            const float damage = enemy.maxHealth > 0.0f ? 1.0f - enemy.health / enemy.maxHealth : 0.0f;
+            const float score = proximity * 100.0f + damage * 20.0f;
+            if (score > bestScore) {
+                bestScore = score;
+                bestId = enemyId;
+            }
+        }
+        if (bestId != 0) {
+            targetId = bestId;
+            current = enemies.find(targetId);
+            targetLastPosition = sf::Vector2f(current->second.x, current->second.y);
+            targetVelocity = sf::Vector2f(0.0f, 0.0f);
+        }
+    }
+
+    if (current == enemies.end() || current->second.health <= 0.0f) {
+        targetId = 0;
+        shadow.ClearTarget();
+        return;
+    }
+    const sf::Vector2f targetPos(current->second.x, current->second.y);
+    const sf::Vector2f offset = targetPos - position;
+    const float escapeRange = shadow.GetDetectionRange() * 2.0f;
+    if (offset.x * offset.x + offset.y * offset.y > escapeRange * escapeRange) {
+        targetId = 0;
+        shadow.ClearTarget();
+        return;
+    }
+
+    if (deltaTime > 0.0f) {
+        const sf::Vector2f sample = (targetPos - targetLastPosition) / deltaTime;
+        targetVelocity += (sample - targetVelocity) * VELOCITY_SMOOTHING;
+    }
+    targetLastPosition = targetPos;
+    shadow.SelectNewTarget(targetId, shadow.CalculateLeadTarget(targetPos, targetVelocity,
+        BulletStats::ForType(BulletStats::PLAYER_STANDARD).speed));
+}
+
+/**
+ * Steps the shadow from the server's pose of the bot and turns where it
+ * went into tank keys: turn toward the shadow's heading, drive forward once
+ * roughly facing it, back up when it lies behind.
+ */
+BotBrain::Output BotBrain::Think(const NetworkClient& client, float deltaTime) {
+    Output output;
+    output.barrelRotation = shadow.GetBarrelRotation().asDegrees();
+    if (!client.HasServerAuthoritativeState() || client.GetServerAuthoritativeIsDead()) {
+        return output;
+    }
+
+    const sf::Vector2f position = client.GetServerAuthoritativePosition();
+    const float bodyRotation = client.GetServerAuthoritativeBodyRotation();
+    shadow.SetMaxHealth(client.GetServerAuthoritativeMaxHealth());
+    shadow.SetHealth(client.GetServerAuthoritativeHealth());
+    shadow.SetPosition(position);
+    shadow.SetBodyRotation(sf::degrees(bodyRotation));
+    shadow.SetObstacles(&client.GetObstacles());
+
+    UpdateTarget(client, deltaTime);
+
+    const float cooldownBefore = shadow.GetShootCooldown();
+    shadow.SetRandomTick(tick++);
+    shadow.Update(deltaTime);
+    output.fire = shadow.GetShootCooldown() - cooldownBefore > 0.5f;   // As the server detects enemy shots
+    output.barrelRotation = shadow.GetBarrelRotation().asDegrees();
+
+    const sf::Vector2f step = shadow.GetPosition() - position;
+    const bool moving = step.x * step.x + step.y * step.y > MIN_STEP * MIN_STEP;
+    const float heading = moving ? std::atan2(step.y, step.x) * 180.0f / 3.14159265f :
+        shadow.GetBodyRotation().asDegrees();
+    float diff = WrapDegrees(heading - bodyRotation);
+    if (moving && std::abs(diff) > REVERSE_ANGLE) {
+        output.input.moveBackward = true;
+        diff = WrapDegrees(diff - 180.0f);
+    }
+    else if (moving && std::abs(diff) < DRIVE_ANGLE) {
+        output.input.moveForward = true;
+    }
+    output.input.turnRight = diff > TURN_DEADZONE;
+    output.input.turnLeft = diff < -TURN_DEADZONE;
+    return output;
+}
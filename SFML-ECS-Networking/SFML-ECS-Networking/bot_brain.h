@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <SFML/System/Vector2.hpp>
+#include "EnemyTank.h"
+#include "client_prediction.h"
+
+class NetworkClient;
+
+// Enemy AI driving a bot's player tank. A shadow EnemyTank without sprites
+// runs the server's state machine (patrol, chase, attack, retreat) against
+// the bot's replicated view: each Think copies the server's pose of the
+// bot's tank into the shadow, picks a target among the replicated enemies
+// as the server picks players for enemies, leads it by the player bullet
+// speed and steps the shadow. The shadow's move becomes keys, its barrel
+// the aim and a cooldown jump a shot. Nothing is drawn or loaded, so
+// a process can think for hundreds of bots (a few microseconds each).
+class BotBrain {
+public:
+    struct Output {
+        InputState input;               // Movement keys only
+        float barrelRotation = 0.0f;    // Degrees
+        bool fire = false;
+    };
+
+    static constexpr float RESCAN_INTERVAL = 0.25f;    // Seconds between target scans
+    static constexpr float TURN_DEADZONE = 5.0f;        // Degrees off the wanted heading before turning
+
+    // botIndex picks the personality (EnemyType) and the random stream
+    BotBrain(uint32_t botIndex, uint64_t seed);
+
+    // No keys and no shot while the server has not placed the bot or it is dead
+    Output Think(const NetworkClient& client, float deltaTime);
+
+private:
+    EnemyTank shadow;
+    float scanTimer;
+    uint32_t targetId;
+    sf::Vector2f targetLastPosition;
+    sf::Vector2f targetVelocity;        // Smoothed from replicated positions
+    uint32_t tick;
+
+    void UpdateTarget(const NetworkClient& client, float deltaTime);
+};
@@ -0,0 +1,314 @@
+#include "bot_client.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr float BOT_BARREL_LENGTH = 30.0f;          // Tank::barrelLength
+    constexpr float MAX_BARREL_SPEED = 90.0f;           // Degrees per second
+    const char* const BOT_COLORS[] = { "red", "blue", "green", "black" };
+}
+
+BotLoadGenerator::BotLoadGenerator(const BotLoadConfig& config)
+    : config(config), random(config.seed != 0 ? config.seed : std::random_device{}()), statsTimer(0.0f) {
+    const uint32_t count = std::min(config.botCount, MAX_BOTS);
+    if (count != config.botCount) {
+        Utils::printMsg("Bot count capped at " + std::to_string(MAX_BOTS), warning);
+    }
+    bots.resize(count);
+    for (size_t i = 0; i < bots.size(); ++i) {
+        bots[i].offlineDelay = static_cast<float>(i) * config.joinInterval;
+    }
+}
+
+BotLoadGenerator::~BotLoadGenerator() {
+    for (Bot& bot : bots) {
+        if (bot.client) {
+            bot.client->Disconnect();
+        }
+    }
+}
+
+float BotLoadGenerator::RandomRange(float low, float high) {
+    return std::uniform_real_distribution<float>(low, high)(random);
+}
+
+/**
+ * Connects a new NetworkClient for the bot; it counts as joined once the
+ * server assigns a player ID.
+ */
+void BotLoadGenerator::StartSession(Bot& bot, size_t index) {
+    window.joinsAttempted++;
+    bot.client = std::make_unique<NetworkClient>();
+    bot.client->SetPredictionEnabled(false);
+    bot.client->SetInputSendMode(config.inputSendMode);
+    bot.client->SetNetworkConditions(config.networkConditions);
+    bot.client->SetLoopback(config.loopback);
+    bot.client->SetSharedMemoryEnabled(config.sharedMemory);
+    bot.stateTime = 0.0f;
+
+    const std::string name = "Bot" + std::to_string(index);
+    const char* color = BOT_COLORS[std::uniform_int_distribution<size_t>(0, 3)(random)];
+    if (!bot.client->Connect(config.serverIP, config.serverPort, name, color, config.roomId)) {
+        window.connectFailures++;
+        bot.client.reset();
+        bot.state = BotState::OFFLINE;
+        bot.offlineDelay = config.rejoinDelaySeconds;
+        return;
+    }
+
+    bot.state = BotState::JOINING;
+    bot.sessionCount++;
+    bot.input = InputState();
+    bot.inputTimer = 0.0f;
+    bot.barrelRotation = RandomRange(0.0f, 360.0f);
+    bot.barrelSpeed = RandomRange(-MAX_BARREL_SPEED, MAX_BARREL_SPEED);
+    bot.stalledTime = 0.0f;
+    bot.lastAckedInput = 0;
+    bot.reportedConfirmedBullets = 0;
+    if (config.inputPattern == BotInputPattern::CIRCLE) {
+        bot.input.moveForward = true;
+        bot.input.turnLeft = index % 2 == 0;
+        bot.input.turnRight = !bot.input.turnLeft;
+    }
+    if (config.inputPattern == BotInputPattern::BRAIN) {
+        bot.brain = std::make_unique<BotBrain>(static_cast<uint32_t>(index), random());
+    }
+}
+
+void BotLoadGenerator::EndSession(Bot& bot) {
+    if (bot.client) {
+        window.bulletsConfirmed += bot.client->GetConfirmedBulletCount() - bot.reportedConfirmedBullets;
+        bot.client->GetInputLatency().MergeInto(windowLatency);
+        bot.client->Disconnect();
+        bot.client.reset();
+    }
+    bot.brain.reset();
+    bot.state = BotState::OFFLINE;
+    bot.stateTime = 0.0f;
+    bot.offlineDelay = config.rejoinDelaySeconds;
+}
+
+void BotLoadGenerator::UpdateInput(Bot& bot, float deltaTime) {
+    bot.barrelRotation = std::fmod(bot.barrelRotation + bot.barrelSpeed * deltaTime + 360.0f, 360.0f);
+    if (config.inputPattern != BotInputPattern::RANDOM) {
+        return;
+    }
+
+    bot.inputTimer -= deltaTime;
+    if (bot.inputTimer > 0.0f) {
+        return;
+    }
+    // Mostly driving forward, sometimes reversing or stopped, turning about half the time
+    const float drive = RandomRange(0.0f, 1.0f);
+    const float turn = RandomRange(0.0f, 1.0f);
+    bot.input.moveForward = drive < 0.5f;
+    bot.input.moveBackward = drive >= 0.5f && drive < 0.65f;
+    bot.input.turnLeft = turn < 0.25f;
+    bot.input.turnRight = turn >= 0.25f && turn < 0.5f;
+    bot.inputTimer = RandomRange(0.5f, 2.0f);
+}
+
+/**
+ * Requests a bullet from the barrel end at the last position the server
+ * reported for this bot.
+ */
+void BotLoadGenerator::Fire(Bot& bot) {
+    NetworkClient& client = *bot.client;
+    if (!client.HasServerAuthoritativeState() || client.GetServerAuthoritativeIsDead()) {
+        return;
+    }
+    const float barrelRad = bot.barrelRotation * 3.14159f / 180.0f;
+    const sf::Vector2f spawnPos = client.GetServerAuthoritativePosition() +
+        sf::Vector2f(std::cos(barrelRad), std::sin(barrelRad)) * BOT_BARREL_LENGTH;
+    client.SendBulletSpawn(spawnPos, bot.barrelRotation);
+    window.bulletsRequested++;
+}
+
+void BotLoadGenerator::Update(float deltaTime) {
+    try {
+        const float fireInterval = config.fireRatePerSecond > 0.0f ? 1.0f / config.fireRatePerSecond : 0.0f;
+
+        for (size_t i = 0; i < bots.size(); ++i) {
+            Bot& bot = bots[i];
+            bot.stateTime += deltaTime;
+
+            if (bot.state == BotState::OFFLINE) {
+                if (bot.stateTime >= bot.offlineDelay) {
+                    StartSession(bot, i);
+                }
+                continue;
+            }
+
+            bot.client->Update(deltaTime);
+
+            if (bot.state == BotState::JOINING) {
+                if (bot.client->GetLocalPlayerId() != 0) {
+                    window.joinsSucceeded++;
+                    bot.state = BotState::PLAYING;
+                    bot.stateTime = 0.0f;
+                    bot.sessionLength = config.maxSessionSeconds > 0.0f ?
+                        RandomRange(config.minSessionSeconds, std::max(config.minSessionSeconds, config.maxSessionSeconds)) : 0.0f;
+                    bot.fireTimer = RandomRange(0.0f, fireInterval);  // Spread shots across frames
+                }
+                else if (bot.stateTime >= JOIN_TIMEOUT_SECONDS) {
+                    window.joinsTimedOut++;
+                    EndSession(bot);
+                }
+                continue;
+            }
+
+            if (!bot.client->IsConnected() ||
+                (bot.sessionLength > 0.0f && bot.stateTime >= bot.sessionLength)) {
+                window.leaves++;
+                EndSession(bot);
+                continue;
+            }
+
+            if (bot.brain) {
+                const BotBrain::Output thought = bot.brain->Think(*bot.client, deltaTime);
+                bot.input.moveForward = thought.input.moveForward;
+                bot.input.moveBackward = thought.input.moveBackward;
+                bot.input.turnLeft = thought.input.turnLeft;
+                bot.input.turnRight = thought.input.turnRight;
+                bot.barrelRotation = thought.barrelRotation;
+                bot.client->SendPlayerInput(bot.input, bot.barrelRotation);
+                if (thought.fire) {
+                    Fire(bot);
+                }
+            }
+            else {
+                UpdateInput(bot, deltaTime);
+                bot.client->SendPlayerInput(bot.input, bot.barrelRotation);
+            }
+
+            if (fireInterval > 0.0f && !bot.brain) {
+                bot.fireTimer -= deltaTime;
+                if (bot.fireTimer <= 0.0f) {
+                    Fire(bot);
+                    bot.fireTimer = std::max(bot.fireTimer + fireInterval, 0.0f);
+                }
+            }
+
+            const uint32_t acked = bot.client->GetLastAcknowledgedInputSeq();
+            if (acked != bot.lastAckedInput) {
+                bot.lastAckedInput = acked;
+                bot.stalledTime = 0.0f;
+            }
+            else {
+                bot.stalledTime += deltaTime;
+            }
+        }
+
+        statsTimer += deltaTime;
+        if (statsTimer >= STATS_INTERVAL) {
+            PrintStats();
+            statsTimer = 0.0f;
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in BotLoadGenerator::Update: " + std::string(e.what()), error);
+    }
+}
+
+uint32_t BotLoadGenerator::GetPlayingCount() const {
+    return static_cast<uint32_t>(std::count_if(bots.begin(), bots.end(),
+        [](const Bot& bot) { return bot.state == BotState::PLAYING; }));
+}
+
+/**
+ * Folds every bot's network stats into the window, prints it and starts a
+ * new one. Bot mode only logs errors (see runBotClient), so the report is
+ * written past the level filter.
+ */
+void BotLoadGenerator::PrintStats() {
+    uint32_t rttSamples = 0;
+    for (Bot& bot : bots) {
+        if (bot.state == BotState::JOINING) {
+            window.joining++;
+        }
+        if (bot.state != BotState::PLAYING) {
+            continue;
+        }
+        window.playing++;
+
+        const uint32_t confirmed = bot.client->GetConfirmedBulletCount();
+        window.bulletsConfirmed += confirmed - bot.reportedConfirmedBullets;
+        bot.reportedConfirmedBullets = confirmed;
+        if (bot.stalledTime >= STATS_INTERVAL) {
+            window.inputStalledBots++;
+        }
+
+        InputLatencyTracker& latency = bot.client->GetInputLatency();
+        latency.MergeInto(windowLatency);
+        latency.ResetStats();
+
+        const NetworkStats& stats = bot.client->GetNetworkStats();
+        if (stats.averageRTT > 0.0f) {
+            rttSamples++;
+            window.averageRTT += stats.averageRTT;
+            window.averageJitter += stats.jitter;
+            window.averagePacketLoss += stats.packetLoss;
+            window.maxRTT = std::max(window.maxRTT, stats.maxRTT);
+        }
+    }
+    if (rttSamples > 0) {
+        window.averageRTT /= static_cast<float>(rttSamples);
+        window.averageJitter /= static_cast<float>(rttSamples);
+        window.averagePacketLoss /= static_cast<float>(rttSamples);
+    }
+
+    const uint32_t unconfirmed = window.bulletsRequested > window.bulletsConfirmed ?
+        window.bulletsRequested - window.bulletsConfirmed : 0;
+    Logger::Write("Bots - Playing: " + std::to_string(window.playing) + "/" + std::to_string(bots.size()) +
+        " - Joining: " + std::to_string(window.joining) +
+        " - Joins: " + std::to_string(window.joinsSucceeded) + "/" + std::to_string(window.joinsAttempted) +
+        " (timed out " + std::to_string(window.joinsTimedOut) +
+        ", connect failures " + std::to_string(window.connectFailures) + ")" +
+        " - Leaves: " + std::to_string(window.leaves), success);
+    Logger::Write("Bots - RTT avg: " + std::to_string(window.averageRTT) + " ms" +
+        " - RTT max: " + std::to_string(window.maxRTT) + " ms" +
+        " - Jitter: " + std::to_string(window.averageJitter) + " ms" +
+        " - Loss: " + std::to_string(window.averagePacketLoss) + "%", success);
+    Logger::Write("Bots - Bullets requested: " + std::to_string(window.bulletsRequested) +
+        " - Confirmed: " + std::to_string(window.bulletsConfirmed) +
+        " - Unconfirmed: " + std::to_string(unconfirmed) +
+        " - Input-stalled bots: " + std::to_string(window.inputStalledBots),
+        (unconfirmed > window.bulletsRequested / 10 || window.inputStalledBots > 0 || window.joinsTimedOut > 0) ?
+        warning : success);
+    std::string latency = InputLatencyTracker::Format(windowLatency);
+    if (!latency.empty()) {
+        latency.pop_back();     // Trailing newline
+        Logger::Write("Bots - Input latency p50 / p95 / p99:\n" + latency, success);
+    }
+
+    for (size_t i = 0; i < InputLatencyTracker::STAGE_COUNT; ++i) {
+        runLatency[i].Merge(windowLatency[i]);
+        windowLatency[i].Reset();
+    }
+    window = BotLoadStats();
+}
+
+/**
+ * Prints the last window, then the input latency over the whole run, which
+ * is the result of a timed latency benchmark.
+ */
+void BotLoadGenerator::Shutdown() {
+    PrintStats();
+    for (Bot& bot : bots) {
+        if (bot.state != BotState::OFFLINE) {
+            EndSession(bot);
+        }
+    }
+    for (size_t i = 0; i < InputLatencyTracker::STAGE_COUNT; ++i) {
+        runLatency[i].Merge(windowLatency[i]);
+        windowLatency[i].Reset();
+    }
+    std::string latency = InputLatencyTracker::Format(runLatency);
+    if (latency.empty()) {
+        Logger::Write("Bots - No input was acknowledged, no input latency to report", warning);
+        return;
+    }
+    latency.pop_back();
+    Logger::Write("Bots - Input latency over the run, p50 / p95 / p99:\n" + latency, success);
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "bot_brain.h"
+#include "network_client.h"
+
+// How bots choose their movement keys
+enum class BotInputPattern : uint8_t {
+    RANDOM,     // New random keys every 0.5-2 seconds
+    CIRCLE,     // Forward while turning one way, so each bot circles its spawn
+    BRAIN       // Enemy AI (BotBrain) hunting the replicated enemies; it aims and fires too
+};
+
+struct BotLoadConfig {
+    std::string serverIP = "127.0.0.1";
+    unsigned short serverPort = 53000;
+    uint16_t roomId = 0;
+    uint32_t botCount = 100;
+    float joinInterval = 0.05f;         // Seconds between bot joins while ramping up
+    float minSessionSeconds = 30.0f;    // Sessions last a random time in [min, max];
+    float maxSessionSeconds = 120.0f;   // max 0 keeps every bot connected
+    float rejoinDelaySeconds = 2.0f;    // Offline time between sessions
+    float fireRatePerSecond = 1.0f;     // Per bot, 0 = never fire (BRAIN bots fire when their AI shoots)
+    BotInputPattern inputPattern = BotInputPattern::RANDOM;
+    InputSendMode inputSendMode = InputSendMode::FIXED_RATE;
+    NetworkConditions networkConditions;    // Per bot socket (each bot gets its own random stream)
+    float runSeconds = 0.0f;            // Stop on its own after this long (latency benchmark), 0 = until Enter
+    LoopbackNetwork* loopback = nullptr;    // In-process server (LocalServer) instead of serverIP:serverPort
+    bool sharedMemory = false;          // Server on this machine's shared memory for serverPort instead of a socket
+    uint32_t seed = 0;                  // Sessions, keys and firing; 0 = a fresh seed per run
+};
+
+// Aggregate over every bot for one report window
+struct BotLoadStats {
+    uint32_t playing = 0;               // Bots with a player ID at report time
+    uint32_t joining = 0;               // Waiting for their ID
+    uint32_t joinsAttempted = 0;
+    uint32_t joinsSucceeded = 0;
+    uint32_t joinsTimedOut = 0;         // No ID within JOIN_TIMEOUT_SECONDS: rejected or lost
+    uint32_t connectFailures = 0;       // Connect returned false (bind/resolve/send)
+    uint32_t leaves = 0;
+    uint32_t bulletsRequested = 0;
+    uint32_t bulletsConfirmed = 0;      // Replicated back by the server
+    uint32_t inputStalledBots = 0;      // Playing all window, but no input acked in it
+    float averageRTT = 0.0f;            // Mean of the bots' averages (bots with samples)
+    float maxRTT = 0.0f;
+    float averageJitter = 0.0f;
+    float averagePacketLoss = 0.0f;     // Percent
+};
+
+// Runs many headless players in one process against a server: each bot is
+// a NetworkClient with scripted, random or enemy AI input (BotBrain) and
+// no window, tank or textures. Bots join gradually, leave and rejoin after
+// random sessions and fire at a fixed rate; Update prints aggregate stats
+// every STATS_INTERVAL, including every bot's input latency
+// (input_latency.h) pooled into one distribution. Shutdown adds the distribution over the whole run.
+class BotLoadGenerator {
+public:
+    static constexpr uint32_t MAX_BOTS = 1000;
+    static constexpr float JOIN_TIMEOUT_SECONDS = 3.0f;
+    static constexpr float STATS_INTERVAL = 5.0f;
+
+    explicit BotLoadGenerator(const BotLoadConfig& config);
+    ~BotLoadGenerator();
+
+    // Steps every bot: lifecycle, input, firing and its NetworkClient
+    void Update(float deltaTime);
+
+    // Disconnects every bot and prints the final window
+    void Shutdown();
+
+    uint32_t GetPlayingCount() const;
+
+private:
+    enum class BotState : uint8_t { OFFLINE, JOINING, PLAYING };
+
+    struct Bot {
+        std::unique_ptr<NetworkClient> client;  // Fresh per session (new socket, clean state)
+        BotState state = BotState::OFFLINE;
+        float stateTime = 0.0f;         // Seconds in the current state
+        float offlineDelay = 0.0f;      // OFFLINE: seconds before joining
+        float sessionLength = 0.0f;     // PLAYING: seconds before leaving (0 = stay)
+        float inputTimer = 0.0f;        // RANDOM: seconds until the keys change
+        float fireTimer = 0.0f;
+        InputState input;
+        std::unique_ptr<BotBrain> brain;        // BRAIN: fresh per session
+        float barrelRotation = 0.0f;
+        float barrelSpeed = 0.0f;       // Degrees per second
+        float stalledTime = 0.0f;       // PLAYING seconds since the acked input last advanced
+        uint32_t lastAckedInput = 0;
+        uint32_t reportedConfirmedBullets = 0;
+        uint32_t sessionCount = 0;
+    };
+
+    BotLoadConfig config;
+    std::vector<Bot> bots;
+    std::mt19937 random;
+    BotLoadStats window;
+    std::array<LatencyHistogram, InputLatencyTracker::STAGE_COUNT> windowLatency;
+    std::array<LatencyHistogram, InputLatencyTracker::STAGE_COUNT> runLatency;
+    float statsTimer;
+
+    void StartSession(Bot& bot, size_t index);
+    void EndSession(Bot& bot);
+    void UpdateInput(Bot& bot, float deltaTime);
+    void Fire(Bot& bot);
+    void PrintStats();
+    float RandomRange(float low, float high);
+};
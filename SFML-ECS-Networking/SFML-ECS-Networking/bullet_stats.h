@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Per-type bullet tuning shared by the rendered client Bullet and the
+ * headless server ProjectilePool. Indexed by the numeric value of
+ * Bullet::BulletType (also the value sent on the wire as BulletData::bulletType).
+ */
+namespace BulletStats {
+    struct Stats {
+        float speed;            // Movement speed (pixels/second)
+        float damage;           // Damage dealt on hit
+        float lifetime;         // Time before auto-destroy (seconds)
+        float radius;           // Collision radius
+    };
+
+    constexpr uint8_t PLAYER_STANDARD = 0;
+    constexpr uint8_t ENEMY_STANDARD = 1;
+    constexpr uint8_t TANK_SHELL = 2;
+    constexpr uint8_t TRACER = 3;
+    constexpr uint8_t TYPE_COUNT = 4;
+
+    constexpr Stats TABLE[TYPE_COUNT] = {
+        { 500.0f, 25.0f, 3.0f, 4.0f },  // PLAYER_STANDARD: balanced, fast
+        { 450.0f, 20.0f, 3.0f, 4.0f },  // ENEMY_STANDARD: slightly slower, less damage
+        { 300.0f, 50.0f, 5.0f, 6.0f },  // TANK_SHELL: heavy, slow, larger hitbox
+        { 600.0f, 20.0f, 2.5f, 4.0f },  // TRACER: very fast, short lifetime
+    };
+
+    // Unknown types fall back to PLAYER_STANDARD stats
+    constexpr const Stats& ForType(uint8_t type) {
+        return TABLE[type < TYPE_COUNT ? type : PLAYER_STANDARD];
+    }
+}
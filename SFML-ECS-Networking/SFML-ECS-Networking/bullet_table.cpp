@@ -0,0 +1,177 @@
+#include "bullet_table.h"
+#include "memory_report.h"
+
+#if defined(__AVX2__)
+#define BULLET_TABLE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BULLET_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+const char* BulletTable::GetKernelName() {
+#if defined(BULLET_TABLE_AVX2)
+    return "AVX2";
+#elif defined(BULLET_TABLE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+size_t BulletTable::Find(uint32_t bulletId) const {
+    const auto it = indexOf.find(bulletId);
+    return it != indexOf.end() ? it->second : NONE;
+}
+
+bool BulletTable::Get(uint32_t bulletId, BulletData& out) const {
+    const size_t index = Find(bulletId);
+    if (index == NONE) {
+        return false;
+    }
+    out = GetAt(index);
+    return true;
+}
+
+BulletData BulletTable::GetAt(size_t index) const {
+    BulletData bullet = records[index];
+    bullet.x = x[index];
+    bullet.y = y[index];
+    bullet.velocityX = velocityX[index];
+    bullet.velocityY = velocityY[index];
+    bullet.lifetime = lifetime[index];
+    return bullet;
+}
+
+size_t BulletTable::Set(const BulletData& bullet) {
+    auto [it, added] = indexOf.try_emplace(bullet.bulletId, static_cast<uint32_t>(ids.size()));
+    const size_t index = it->second;
+    if (added) {
+        x.push_back(bullet.x);
+        y.push_back(bullet.y);
+        velocityX.push_back(bullet.velocityX);
+        velocityY.push_back(bullet.velocityY);
+        lifetime.push_back(bullet.lifetime);
+        records.push_back(bullet);
+        ids.push_back(bullet.bulletId);
+        return index;
+    }
+    x[index] = bullet.x;
+    y[index] = bullet.y;
+    velocityX[index] = bullet.velocityX;
+    velocityY[index] = bullet.velocityY;
+    lifetime[index] = bullet.lifetime;
+    records[index] = bullet;
+    return index;
+}
+
+void BulletTable::AdvanceAt(size_t index, float seconds) {
+    x[index] = x[index] + velocityX[index] * seconds;
+    y[index] = y[index] + velocityY[index] * seconds;
+    lifetime[index] = lifetime[index] - seconds;
+}
+
+bool BulletTable::Remove(uint32_t bulletId) {
+    const size_t index = Find(bulletId);
+    if (index == NONE) {
+        return false;
+    }
+    RemoveAt(index);
+    return true;
+}
+
+void BulletTable::RemoveAt(size_t index) {
+    const size_t last = ids.size() - 1;
+    indexOf.erase(ids[index]);
+    if (index != last) {
+        x[index] = x[last];
+        y[index] = y[last];
+        velocityX[index] = velocityX[last];
+        velocityY[index] = velocityY[last];
+        lifetime[index] = lifetime[last];
+        records[index] = records[last];
+        ids[index] = ids[last];
+        indexOf[ids[index]] = static_cast<uint32_t>(index);
+    }
+    x.pop_back();
+    y.pop_back();
+    velocityX.pop_back();
+    velocityY.pop_back();
+    lifetime.pop_back();
+    records.pop_back();
+    ids.pop_back();
+}
+
+void BulletTable::Clear() {
+    x.clear();
+    y.clear();
+    velocityX.clear();
+    velocityY.clear();
+    lifetime.clear();
+    records.clear();
+    ids.clear();
+    indexOf.clear();
+}
+
+/**
+ * Per bullet: x += vx * dt, y += vy * dt, lifetime -= dt, expired when the
+ * lifetime is no longer above 0. Multiply then add (no fused multiply-add),
+ * the same as AdvanceAt, so every kernel lands on the same positions.
+ */
+size_t BulletTable::Integrate(float deltaTime, std::vector<uint8_t>& expiredMask) {
+    const size_t count = ids.size();
+    expiredMask.resize(count);
+    float* px = x.data();
+    float* py = y.data();
+    float* life = lifetime.data();
+    const float* vx = velocityX.data();
+    const float* vy = velocityY.data();
+    uint8_t* mask = expiredMask.data();
+    size_t expired = 0;
+    size_t i = 0;
+
+#if defined(BULLET_TABLE_AVX2)
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(px + i, _mm256_add_ps(_mm256_loadu_ps(px + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), dt)));
+        _mm256_storeu_ps(py + i, _mm256_add_ps(_mm256_loadu_ps(py + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), dt)));
+        const __m256 remaining = _mm256_sub_ps(_mm256_loadu_ps(life + i), dt);
+        _mm256_storeu_ps(life + i, remaining);
+        const uint32_t lanes = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(remaining, zero, _CMP_LE_OQ)));
+        for (size_t lane = 0; lane < 8; ++lane) {
+            mask[i + lane] = static_cast<uint8_t>((lanes >> lane) & 1u);
+            expired += (lanes >> lane) & 1u;
+        }
+    }
+#elif defined(BULLET_TABLE_SSE2)
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(_mm_loadu_ps(vx + i), dt)));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(_mm_loadu_ps(vy + i), dt)));
+        const __m128 remaining = _mm_sub_ps(_mm_loadu_ps(life + i), dt);
+        _mm_storeu_ps(life + i, remaining);
+        const uint32_t lanes = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(remaining, zero)));
+        for (size_t lane = 0; lane < 4; ++lane) {
+            mask[i + lane] = static_cast<uint8_t>((lanes >> lane) & 1u);
+            expired += (lanes >> lane) & 1u;
+        }
+    }
+#endif
+
+    // Scalar tail (every bullet without a vector kernel)
+    for (; i < count; ++i) {
+        px[i] = px[i] + vx[i] * deltaTime;
+        py[i] = py[i] + vy[i] * deltaTime;
+        life[i] = life[i] - deltaTime;
+        mask[i] = life[i] <= 0.0f ? 1 : 0;
+        expired += mask[i];
+    }
+    return expired;
+}
+
+size_t BulletTable::GetApproximateBytes() const {
+    return MemoryReport::VectorBytes(x, y, velocityX, velocityY, lifetime, records, ids) +
+        MemoryReport::MapBytes(indexOf);
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "network_messages.h"
+
+// The server bullets a client tracks, in dense structure-of-arrays columns
+// with an ID -> index map. The columns every frame touches (position,
+// velocity, lifetime) are separate float arrays; the rest of each bullet
+// stays in a BulletData record whose moving fields are ignored.
+//
+// Integrate moves every bullet and counts its lifetime down in one kernel
+// pass that writes an expired mask. Like CircleBatch the kernel is chosen at
+// compile time (AVX2, SSE2 or scalar) and evaluates the same expressions in
+// every variant, so the choice never changes a position. Removal is
+// swap-and-pop: the last bullet moves into the freed index, so walking the
+// table from the back while removing visits every bullet once.
+class BulletTable {
+public:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    // "AVX2", "SSE2" or "scalar"
+    static const char* GetKernelName();
+
+    size_t GetSize() const { return ids.size(); }
+    bool IsEmpty() const { return ids.empty(); }
+
+    // @return Dense index of the bullet, or NONE
+    size_t Find(uint32_t bulletId) const;
+    bool Contains(uint32_t bulletId) const { return indexOf.count(bulletId) != 0; }
+    // Copies the bullet out. @return False if it is not tracked
+    bool Get(uint32_t bulletId, BulletData& out) const;
+    BulletData GetAt(size_t index) const;
+    uint32_t GetIdAt(size_t index) const { return ids[index]; }
+    sf::Vector2f GetPositionAt(size_t index) const { return { x[index], y[index] }; }
+
+    // Adds the bullet, or overwrites the one with its ID. @return Its dense index
+    size_t Set(const BulletData& bullet);
+    // Moves one bullet along its velocity and takes seconds off its lifetime
+    void AdvanceAt(size_t index, float seconds);
+
+    // @return False if the bullet was not tracked
+    bool Remove(uint32_t bulletId);
+    // Fills index with the last bullet
+    void RemoveAt(size_t index);
+    void Clear();
+
+    // Advances every bullet by deltaTime. expiredMask is resized to the
+    // table; entry i is 1 when bullet i's lifetime ran out.
+    // @return How many ran out
+    size_t Integrate(float deltaTime, std::vector<uint8_t>& expiredMask);
+
+    // Columns and records at their capacity, plus the map (see MemoryReport)
+    size_t GetApproximateBytes() const;
+
+private:
+    std::vector<float> x, y;
+    std::vector<float> velocityX, velocityY;
+    std::vector<float> lifetime;
+    std::vector<BulletData> records;        // Owner, type, rotation, damage, spawn time and token
+    std::vector<uint32_t> ids;
+    std::unordered_map<uint32_t, uint32_t> indexOf;
+};
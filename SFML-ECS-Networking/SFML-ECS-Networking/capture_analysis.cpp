@@ -0,0 +1,300 @@
+#include "capture_analysis.h"
+#include "bit_stream.h"
+#include "connection_token.h"
+#include "network_messages.h"
+#include "packet_aggregator.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+CaptureAnalysis::CaptureAnalysis(PacketCapture::Side side, float bucketSeconds)
+    : side(side), bucketSeconds(std::max(bucketSeconds, 0.01f)) {
+}
+
+/**
+ * Strips the connection token off client-to-server datagrams, then walks the
+ * messages inside. Only received datagrams feed the timing and sequence stats.
+ */
+void CaptureAnalysis::Add(CapturedDatagram& datagram) {
+    if (datagramCount == 0) {
+        firstMicros = datagram.steadyMicros;
+    }
+    lastMicros = std::max(lastMicros, datagram.steadyMicros);
+    datagramCount++;
+
+    const uint64_t key = (static_cast<uint64_t>(datagram.address.toInteger()) << 16) | datagram.port;
+    Stream& stream = streams[key];
+    if (!stream.reassembler) {
+        stream.address = datagram.address;
+        stream.port = datagram.port;
+        stream.reassembler = std::make_unique<FragmentReassembler>();
+    }
+
+    const bool received = datagram.direction == PacketCapture::Direction::RECEIVED;
+    const size_t size = datagram.packet.getDataSize();
+    if (received) {
+        bandwidth.RecordDatagramReceived(size);
+        RecordArrival(stream, datagram.steadyMicros);
+    }
+    else {
+        bandwidth.RecordDatagramSent(size);
+    }
+
+    const bool hasToken = (side == PacketCapture::Side::SERVER) == received;
+    if (hasToken) {
+        if (size <= ConnectionTokens::TOKEN_BYTES) {
+            undecodedCount++;
+            return;
+        }
+        sf::Packet& message = unwrapped[0];
+        message.clear();
+        message.append(static_cast<const uint8_t*>(datagram.packet.getData()) + ConnectionTokens::TOKEN_BYTES,
+            size - ConnectionTokens::TOKEN_BYTES);
+        AddMessage(stream, datagram, message, message.getDataSize(), 0);
+    }
+    else if (size > 0) {
+        AddMessage(stream, datagram, datagram.packet, size, 0);
+    }
+}
+
+/**
+ * Counts one message at its unwrapped size, as BandwidthStats does live, or
+ * opens the container and recurses. wireBytes is what the message took in
+ * its datagram (the compressed size for compressed ones).
+ */
+void CaptureAnalysis::AddMessage(Stream& stream, const CapturedDatagram& datagram, sf::Packet& message,
+    size_t wireBytes, size_t depth) {
+    uint8_t typeByte = 0;
+    if (depth >= MAX_NESTING || !(message >> typeByte)) {
+        undecodedCount++;
+        return;
+    }
+    const bool received = datagram.direction == PacketCapture::Direction::RECEIVED;
+    const int64_t micros = datagram.steadyMicros;
+    const NetMessageType type = static_cast<NetMessageType>(typeByte);
+
+    if (type == NetMessageType::MESSAGE_BUNDLE) {
+        if (!PacketAggregator::ForEachMessage(message, scratch[depth], [&](sf::Packet& inner) {
+            AddMessage(stream, datagram, inner, inner.getDataSize(), depth + 1);
+        })) {
+            undecodedCount++;
+        }
+        return;
+    }
+    if (depth + 1 >= MAX_NESTING) {
+        undecodedCount++;
+        return;
+    }
+    if (type == NetMessageType::MESSAGE_FRAGMENT) {
+        sf::Packet& whole = unwrapped[depth + 1];
+        if (stream.reassembler->AddFragment(message, micros / 1000, whole)) {
+            AddMessage(stream, datagram, whole, whole.getDataSize(), depth + 1);
+        }
+        return;
+    }
+    if (type == NetMessageType::RELIABLE_MESSAGE) {
+        constexpr size_t ENVELOPE_BYTES = 1 + 2;
+        if (message.getDataSize() <= ENVELOPE_BYTES) {
+            undecodedCount++;
+            return;
+        }
+        sf::Packet& inner = unwrapped[depth + 1];
+        inner.clear();
+        inner.append(static_cast<const uint8_t*>(message.getData()) + ENVELOPE_BYTES,
+            message.getDataSize() - ENVELOPE_BYTES);
+        AddMessage(stream, datagram, inner, inner.getDataSize(), depth + 1);
+        return;
+    }
+    if (type == NetMessageType::COMPRESSED_MESSAGE) {
+        if (!compressor.Decompress(message, unwrapped[depth + 1])) {
+            undecodedCount++;
+            return;
+        }
+        AddMessage(stream, datagram, unwrapped[depth + 1], wireBytes, depth + 1);
+        return;
+    }
+
+    const size_t size = message.getDataSize();
+    if (received) {
+        bandwidth.RecordMessageReceived(typeByte, size);
+    }
+    else {
+        bandwidth.RecordMessageSent(typeByte, size);
+    }
+    if (type == NetMessageType::GAME_STATE_DELTA) {
+        RecordSnapshotSize(micros, wireBytes, size);
+        BitReader reader = BitReader::FromPacket(message);
+        StateHeader header;
+        if (received && NetworkUtils::Read(reader, header)) {
+            RecordSequence(stream.snapshots, header.sequence, micros);
+        }
+    }
+    else if (type == NetMessageType::PLAYER_INPUT && received) {
+        BitReader reader = BitReader::FromPacket(message);
+        PlayerInputMessage input;
+        if (NetworkUtils::Read(reader, input, 0)) {     // Only the sequence is used
+            RecordSequence(stream.inputs, input.sequenceNumber, micros);
+        }
+    }
+}
+
+void CaptureAnalysis::RecordArrival(Stream& stream, int64_t micros) {
+    stream.datagrams++;
+    if (stream.datagrams > 1) {
+        const int64_t interval = micros - stream.lastArrivalMicros;
+        stream.intervalSum += static_cast<double>(interval);
+        stream.intervalSquareSum += static_cast<double>(interval) * static_cast<double>(interval);
+        stream.intervals++;
+        if (interval > stream.maxIntervalMicros) {
+            stream.maxIntervalMicros = interval;
+            stream.maxIntervalAtMicros = stream.lastArrivalMicros;
+        }
+        if (stream.lastIntervalMicros >= 0) {
+            const double change = std::fabs(static_cast<double>(interval - stream.lastIntervalMicros));
+            stream.jitterMicros += (change - stream.jitterMicros) / 16.0;
+        }
+        stream.lastIntervalMicros = interval;
+    }
+    stream.lastArrivalMicros = micros;
+}
+
+void CaptureAnalysis::RecordSequence(SequenceTrack& track, uint32_t sequence, int64_t micros) {
+    track.received++;
+    if (!track.started) {
+        track.started = true;
+        track.last = sequence;
+        return;
+    }
+    if (sequence <= track.last) {
+        track.late++;
+        return;
+    }
+    const uint32_t missing = sequence - track.last - 1;
+    if (missing > 0) {
+        track.gaps++;
+        track.missing += missing;
+        track.longestGap = std::max(track.longestGap, missing);
+        if (track.listed.size() < MAX_GAPS_LISTED) {
+            track.listed.push_back(FormatTime(micros) + ": " + std::to_string(track.last + 1) +
+                (missing > 1 ? "-" + std::to_string(sequence - 1) : "") + " missing");
+        }
+    }
+    track.last = sequence;
+}
+
+void CaptureAnalysis::RecordSnapshotSize(int64_t micros, size_t wireBytes, size_t rawBytes) {
+    const size_t bucket = static_cast<size_t>(static_cast<double>(micros - firstMicros) / 1e6 / bucketSeconds);
+    if (bucket >= snapshotBuckets.size()) {
+        snapshotBuckets.resize(bucket + 1);
+    }
+    SnapshotBucket& entry = snapshotBuckets[bucket];
+    entry.count++;
+    entry.wireBytes += wireBytes;
+    entry.rawBytes += rawBytes;
+    entry.maxWireBytes = std::max(entry.maxWireBytes, wireBytes);
+}
+
+std::string CaptureAnalysis::FormatTime(int64_t micros) const {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f s", static_cast<double>(micros - firstMicros) / 1e6);
+    return text;
+}
+
+void CaptureAnalysis::Report() const {
+    const double seconds = std::max(static_cast<double>(lastMicros - firstMicros) / 1e6, 0.001);
+    char line[256];
+    std::snprintf(line, sizeof(line), "%s capture: %.1f s, %llu datagrams (%llu messages not decoded)",
+        side == PacketCapture::Side::SERVER ? "Server" : "Client", seconds,
+        static_cast<unsigned long long>(datagramCount), static_cast<unsigned long long>(undecodedCount));
+    Utils::printMsg(line);
+    Utils::printMsg("Sent: " + bandwidth.FormatSent(seconds));
+    Utils::printMsg("Received: " + bandwidth.FormatReceived(seconds));
+
+    // Busiest endpoints first
+    std::vector<const Stream*> ordered;
+    for (const auto& [key, stream] : streams) {
+        if (stream.datagrams > 0) {
+            ordered.push_back(&stream);
+        }
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const Stream* a, const Stream* b) {
+        return a->datagrams > b->datagrams;
+    });
+
+    Utils::printMsg("Inter-arrival by endpoint:");
+    for (const Stream* stream : ordered) {
+        const double count = static_cast<double>(std::max<uint64_t>(stream->intervals, 1));
+        const double mean = stream->intervalSum / count;
+        const double deviation = std::sqrt(std::max(stream->intervalSquareSum / count - mean * mean, 0.0));
+        std::snprintf(line, sizeof(line), "  %s:%u  %llu datagrams  mean %.2f ms  stddev %.2f ms  jitter %.2f ms  max %.2f ms at %s",
+            stream->address.toString().c_str(), static_cast<unsigned>(stream->port),
+            static_cast<unsigned long long>(stream->datagrams), mean / 1000.0, deviation / 1000.0,
+            stream->jitterMicros / 1000.0, static_cast<double>(stream->maxIntervalMicros) / 1000.0,
+            FormatTime(stream->maxIntervalAtMicros).c_str());
+        Utils::printMsg(line);
+    }
+
+    Utils::printMsg("Sequence gaps received:");
+    for (const Stream* stream : ordered) {
+        for (const SequenceTrack* track : { &stream->snapshots, &stream->inputs }) {
+            if (track->received == 0) {
+                continue;
+            }
+            std::snprintf(line, sizeof(line), "  %s:%u %s: %llu received, %llu missing in %llu gaps (longest %u), %llu late",
+                stream->address.toString().c_str(), static_cast<unsigned>(stream->port), track->name,
+                static_cast<unsigned long long>(track->received), static_cast<unsigned long long>(track->missing),
+                static_cast<unsigned long long>(track->gaps), track->longestGap, static_cast<unsigned long long>(track->late));
+            Utils::printMsg(line, track->missing > 0 ? warning : info);
+            for (const std::string& gap : track->listed) {
+                Utils::printMsg("    at " + gap);
+            }
+        }
+    }
+
+    std::snprintf(line, sizeof(line), "Snapshot sizes per %.1f s:", bucketSeconds);
+    Utils::printMsg(line);
+    for (size_t bucket = 0; bucket < snapshotBuckets.size(); ++bucket) {
+        const SnapshotBucket& entry = snapshotBuckets[bucket];
+        if (entry.count == 0) {
+            continue;
+        }
+        std::snprintf(line, sizeof(line), "  %8.1f s  %5llu snapshots  avg %6llu B  max %6zu B  avg raw %6llu B",
+            static_cast<double>(bucket) * bucketSeconds, static_cast<unsigned long long>(entry.count),
+            static_cast<unsigned long long>(entry.wireBytes / entry.count), entry.maxWireBytes,
+            static_cast<unsigned long long>(entry.rawBytes / entry.count));
+        Utils::printMsg(line);
+    }
+}
+
+bool CaptureAnalysis::Run(const std::string& path, float bucketSeconds) {
+    std::vector<std::string> files;
+    for (uint32_t index = 1; std::ifstream(path + "." + std::to_string(index)).good(); ++index) {
+        files.push_back(path + "." + std::to_string(index));
+    }
+    std::reverse(files.begin(), files.end());
+    files.push_back(path);
+
+    std::unique_ptr<CaptureAnalysis> analysis;
+    CapturedDatagram datagram;
+    for (const std::string& file : files) {
+        PacketCaptureReader reader;
+        if (!reader.Open(file)) {
+            Utils::printMsg("Error: " + file + " is not a packet capture", error);
+            return false;
+        }
+        if (!analysis) {
+            analysis = std::make_unique<CaptureAnalysis>(reader.GetSide(), bucketSeconds);
+        }
+        while (reader.Read(datagram)) {
+            analysis->Add(datagram);
+        }
+        if (reader.IsCorrupt()) {
+            Utils::printMsg("Warning: " + file + " ends with a truncated record", warning);
+        }
+    }
+    Utils::printMsg("Read " + std::to_string(files.size()) + " capture file(s)");
+    analysis->Report();
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SFML/Network/Packet.hpp>
+#include "bandwidth_stats.h"
+#include "fragment_reassembler.h"
+#include "packet_capture.h"
+#include "packet_compression.h"
+
+// Offline report over a PacketCapture, printed through Utils::printMsg:
+//  - bandwidth by message type in each direction, with bundles, fragments,
+//    reliable envelopes and compression unwrapped as the receiver would
+//  - inter-arrival time and jitter of the datagrams from each endpoint
+//  - gaps in the snapshot (GAME_STATE_DELTA) and input (PLAYER_INPUT)
+//    sequences received, i.e. loss as this side saw it
+//  - snapshot count and sizes per time bucket, on the wire and decompressed
+// A client capture shows server-to-client loss and jitter, a server capture
+// the other direction; take both to see a spike from each end.
+class CaptureAnalysis {
+public:
+    static constexpr size_t MAX_GAPS_LISTED = 20;   // Per stream; the rest are only counted
+    static constexpr size_t MAX_NESTING = 4;        // Bundle > reliable > compressed > message
+
+    explicit CaptureAnalysis(PacketCapture::Side side, float bucketSeconds = 1.0f);
+
+    void Add(CapturedDatagram& datagram);
+    void Report() const;
+
+    // Reads path.N ... path.1 (rotated, oldest first), then path, and reports
+    // @return False if path could not be read
+    static bool Run(const std::string& path, float bucketSeconds);
+
+private:
+    struct SequenceTrack {
+        const char* name;
+        bool started = false;
+        uint32_t last = 0;
+        uint64_t received = 0;
+        uint64_t missing = 0;
+        uint64_t gaps = 0;
+        uint32_t longestGap = 0;
+        uint64_t late = 0;                  // Older than one already seen: reordered or duplicated
+        std::vector<std::string> listed;    // First MAX_GAPS_LISTED gaps
+
+        explicit SequenceTrack(const char* name) : name(name) {}
+    };
+
+    struct Stream {
+        sf::IpAddress address = sf::IpAddress::LocalHost;
+        unsigned short port = 0;
+        uint64_t datagrams = 0;
+        int64_t lastArrivalMicros = 0;
+        int64_t lastIntervalMicros = -1;
+        double intervalSum = 0.0;
+        double intervalSquareSum = 0.0;
+        uint64_t intervals = 0;
+        int64_t maxIntervalMicros = 0;
+        int64_t maxIntervalAtMicros = 0;
+        double jitterMicros = 0.0;          // RFC 3550 style: smoothed change between intervals
+        SequenceTrack snapshots{ "snapshots" };
+        SequenceTrack inputs{ "inputs" };
+        std::unique_ptr<FragmentReassembler> reassembler;
+    };
+
+    struct SnapshotBucket {
+        uint64_t count = 0;
+        uint64_t wireBytes = 0;
+        uint64_t rawBytes = 0;
+        size_t maxWireBytes = 0;
+    };
+
+    PacketCapture::Side side;
+    float bucketSeconds;
+    int64_t firstMicros = 0;
+    int64_t lastMicros = 0;
+    uint64_t datagramCount = 0;
+    uint64_t undecodedCount = 0;
+    BandwidthStats bandwidth;
+    std::unordered_map<uint64_t, Stream> streams;   // address << 16 | port
+    std::vector<SnapshotBucket> snapshotBuckets;
+    PacketCompressor compressor;
+    std::array<sf::Packet, MAX_NESTING> scratch;    // Unwrapped messages, one per nesting level
+    std::array<sf::Packet, MAX_NESTING> unwrapped;
+
+    void AddMessage(Stream& stream, const CapturedDatagram& datagram, sf::Packet& message,
+        size_t wireBytes, size_t depth);
+    void RecordArrival(Stream& stream, int64_t micros);
+    void RecordSequence(SequenceTrack& track, uint32_t sequence, int64_t micros);
+    void RecordSnapshotSize(int64_t micros, size_t wireBytes, size_t rawBytes);
+    std::string FormatTime(int64_t micros) const;
+};
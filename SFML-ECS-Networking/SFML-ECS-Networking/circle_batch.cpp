@@ -0,0 +1,235 @@
+#include "circle_batch.h"
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__)
+#define CIRCLE_BATCH_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CIRCLE_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // Parked lanes: the distance squares to infinity, which is never below a radius sum
+    constexpr float FAR_AWAY = std::numeric_limits<float>::max();
+
+    size_t LowestBit(uint32_t mask) {
+        size_t index = 0;
+        while ((mask & 1u) == 0) {
+            mask >>= 1;
+            index++;
+        }
+        return index;
+    }
+}
+
+const char* CircleBatch::GetKernelName() {
+#if defined(CIRCLE_BATCH_AVX2)
+    return "AVX2";
+#elif defined(CIRCLE_BATCH_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void CircleBatch::Clear() {
+    blocks.clear();
+    count = 0;
+}
+
+size_t CircleBatch::Add(sf::Vector2f position, float radius) {
+    const size_t lane = count % BLOCK_SIZE;
+    if (lane == 0) {
+        Block& block = blocks.emplace_back();
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            block.x[i] = FAR_AWAY;
+            block.y[i] = FAR_AWAY;
+            block.radius[i] = 0.0f;
+        }
+    }
+    Block& block = blocks.back();
+    block.x[lane] = position.x;
+    block.y[lane] = position.y;
+    block.radius[lane] = radius;
+    return count++;
+}
+
+void CircleBatch::Remove(size_t index) {
+    if (index >= count) {
+        return;
+    }
+    Block& block = blocks[index / BLOCK_SIZE];
+    const size_t lane = index % BLOCK_SIZE;
+    block.x[lane] = FAR_AWAY;
+    block.y[lane] = FAR_AWAY;
+    block.radius[lane] = 0.0f;
+}
+
+/**
+ * dx*dx + dy*dy < (r + R)^2 per lane, evaluated in the same order as
+ * Overlaps() (no fused multiply-add) so every kernel agrees with it exactly.
+ */
+uint32_t CircleBatch::OverlapMask(size_t blockIndex, sf::Vector2f position, float radius) const {
+    const Block& block = blocks[blockIndex];
+    uint32_t mask = 0;
+
+#if defined(CIRCLE_BATCH_AVX2)
+    const __m256 px = _mm256_set1_ps(position.x);
+    const __m256 py = _mm256_set1_ps(position.y);
+    const __m256 pr = _mm256_set1_ps(radius);
+    for (size_t i = 0; i < BLOCK_SIZE; i += 8) {
+        const __m256 dx = _mm256_sub_ps(px, _mm256_load_ps(block.x + i));
+        const __m256 dy = _mm256_sub_ps(py, _mm256_load_ps(block.y + i));
+        const __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        const __m256 radiusSum = _mm256_add_ps(pr, _mm256_load_ps(block.radius + i));
+        const __m256 hit = _mm256_cmp_ps(distSq, _mm256_mul_ps(radiusSum, radiusSum), _CMP_LT_OQ);
+        mask |= static_cast<uint32_t>(_mm256_movemask_ps(hit)) << i;
+    }
+#elif defined(CIRCLE_BATCH_SSE2)
+    const __m128 px = _mm_set1_ps(position.x);
+    const __m128 py = _mm_set1_ps(position.y);
+    const __m128 pr = _mm_set1_ps(radius);
+    for (size_t i = 0; i < BLOCK_SIZE; i += 4) {
+        const __m128 dx = _mm_sub_ps(px, _mm_load_ps(block.x + i));
+        const __m128 dy = _mm_sub_ps(py, _mm_load_ps(block.y + i));
+        const __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        const __m128 radiusSum = _mm_add_ps(pr, _mm_load_ps(block.radius + i));
+        const __m128 hit = _mm_cmplt_ps(distSq, _mm_mul_ps(radiusSum, radiusSum));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << i;
+    }
+#else
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        if (Overlaps(position, radius, sf::Vector2f(block.x[i], block.y[i]), block.radius[i])) {
+            mask |= 1u << i;
+        }
+    }
+#endif
+
+    return mask;
+}
+
+/**
+ * Per lane, with f = start - center, d = end - start and R the radius sum:
+ * contact while |f + t*d| < R, first at t = (-f.d - sqrt((f.d)^2 - |d|^2 (|f|^2 - R^2))) / |d|^2.
+ * A lane hits when it overlaps at start (t = 0, the same compare as OverlapMask)
+ * or when the segment enters the circle at some t in [0, 1). A grazing
+ * touch (zero discriminant) is not a hit, matching the strict compare.
+ */
+uint32_t CircleBatch::SweptMask(size_t blockIndex, sf::Vector2f start, sf::Vector2f end, float radius,
+    float* outTimes) const {
+    const Block& block = blocks[blockIndex];
+    const float moveX = end.x - start.x;
+    const float moveY = end.y - start.y;
+    const float moveLengthSq = moveX * moveX + moveY * moveY;
+    uint32_t mask = 0;
+
+#if defined(CIRCLE_BATCH_AVX2)
+    const __m256 sx = _mm256_set1_ps(start.x);
+    const __m256 sy = _mm256_set1_ps(start.y);
+    const __m256 pr = _mm256_set1_ps(radius);
+    const __m256 dx = _mm256_set1_ps(moveX);
+    const __m256 dy = _mm256_set1_ps(moveY);
+    const __m256 a = _mm256_set1_ps(moveLengthSq);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    for (size_t i = 0; i < BLOCK_SIZE; i += 8) {
+        const __m256 fx = _mm256_sub_ps(sx, _mm256_load_ps(block.x + i));
+        const __m256 fy = _mm256_sub_ps(sy, _mm256_load_ps(block.y + i));
+        const __m256 distSq = _mm256_add_ps(_mm256_mul_ps(fx, fx), _mm256_mul_ps(fy, fy));
+        const __m256 radiusSum = _mm256_add_ps(pr, _mm256_load_ps(block.radius + i));
+        const __m256 radiusSq = _mm256_mul_ps(radiusSum, radiusSum);
+        const __m256 inside = _mm256_cmp_ps(distSq, radiusSq, _CMP_LT_OQ);
+
+        const __m256 b = _mm256_add_ps(_mm256_mul_ps(fx, dx), _mm256_mul_ps(fy, dy));
+        const __m256 c = _mm256_sub_ps(distSq, radiusSq);
+        const __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+        const __m256 root = _mm256_sqrt_ps(_mm256_max_ps(disc, zero));
+        const __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), root), a);
+        const __m256 enters = _mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GT_OQ),
+            _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, one, _CMP_LT_OQ)));
+
+        _mm256_storeu_ps(outTimes + i, _mm256_andnot_ps(inside, t));
+        mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_or_ps(inside, enters))) << i;
+    }
+#elif defined(CIRCLE_BATCH_SSE2)
+    const __m128 sx = _mm_set1_ps(start.x);
+    const __m128 sy = _mm_set1_ps(start.y);
+    const __m128 pr = _mm_set1_ps(radius);
+    const __m128 dx = _mm_set1_ps(moveX);
+    const __m128 dy = _mm_set1_ps(moveY);
+    const __m128 a = _mm_set1_ps(moveLengthSq);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (size_t i = 0; i < BLOCK_SIZE; i += 4) {
+        const __m128 fx = _mm_sub_ps(sx, _mm_load_ps(block.x + i));
+        const __m128 fy = _mm_sub_ps(sy, _mm_load_ps(block.y + i));
+        const __m128 distSq = _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy));
+        const __m128 radiusSum = _mm_add_ps(pr, _mm_load_ps(block.radius + i));
+        const __m128 radiusSq = _mm_mul_ps(radiusSum, radiusSum);
+        const __m128 inside = _mm_cmplt_ps(distSq, radiusSq);
+
+        const __m128 b = _mm_add_ps(_mm_mul_ps(fx, dx), _mm_mul_ps(fy, dy));
+        const __m128 c = _mm_sub_ps(distSq, radiusSq);
+        const __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+        const __m128 root = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+        const __m128 t = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), root), a);
+        const __m128 enters = _mm_and_ps(_mm_cmpgt_ps(disc, zero),
+            _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, one)));
+
+        _mm_storeu_ps(outTimes + i, _mm_andnot_ps(inside, t));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_or_ps(inside, enters))) << i;
+    }
+#else
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const float fx = start.x - block.x[i];
+        const float fy = start.y - block.y[i];
+        const float distSq = fx * fx + fy * fy;
+        const float radiusSum = radius + block.radius[i];
+        const float radiusSq = radiusSum * radiusSum;
+        if (distSq < radiusSq) {
+            outTimes[i] = 0.0f;
+            mask |= 1u << i;
+            continue;
+        }
+        const float b = fx * moveX + fy * moveY;
+        const float disc = b * b - moveLengthSq * (distSq - radiusSq);
+        const float t = (0.0f - b - std::sqrt(disc > 0.0f ? disc : 0.0f)) / moveLengthSq;
+        outTimes[i] = t;
+        if (disc > 0.0f && t >= 0.0f && t < 1.0f) {
+            mask |= 1u << i;
+        }
+    }
+#endif
+
+    return mask;
+}
+
+size_t CircleBatch::FindEarliestSweptOverlap(sf::Vector2f start, sf::Vector2f end, float radius,
+    float& outTime) const {
+    size_t earliest = NONE;
+    float times[BLOCK_SIZE];
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        uint32_t mask = SweptMask(b, start, end, radius, times);
+        while (mask != 0) {
+            const size_t lane = LowestBit(mask);
+            mask &= mask - 1;
+            if (earliest == NONE || times[lane] < outTime) {
+                earliest = b * BLOCK_SIZE + lane;
+                outTime = times[lane];
+            }
+        }
+    }
+    return earliest;
+}
+
+size_t CircleBatch::FindFirstOverlap(sf::Vector2f position, float radius) const {
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const uint32_t mask = OverlapMask(b, position, radius);
+        if (mask != 0) {
+            return b * BLOCK_SIZE + LowestBit(mask);
+        }
+    }
+    return NONE;
+}
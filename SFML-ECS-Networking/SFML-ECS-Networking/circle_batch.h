@@ -0,0 +1,71 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Narrowphase for one query circle against many: the broadphase candidates
+// are copied into structure-of-arrays blocks of BLOCK_SIZE circles (32-byte
+// aligned x, y and radius lanes) and each block is tested in one kernel call
+// that returns a hit mask. The query is either a circle at rest or a circle
+// sweeping along a segment (a bullet's motion over one tick).
+// The kernel is chosen at compile time: AVX2 when the build targets it
+// (/arch:AVX2, -mavx2), SSE2 on any x64 build, plain scalar otherwise. Every
+// kernel evaluates the same expressions as the scalar path, so the choice
+// never changes which circles hit.
+class CircleBatch {
+public:
+    static constexpr size_t BLOCK_SIZE = 16;
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    // The one overlap rule: centers strictly closer than the radius sum
+    static bool Overlaps(sf::Vector2f a, float radiusA, sf::Vector2f b, float radiusB) {
+        const float dx = a.x - b.x;
+        const float dy = a.y - b.y;
+        const float radiusSum = radiusA + radiusB;
+        return dx * dx + dy * dy < radiusSum * radiusSum;
+    }
+
+    // "AVX2", "SSE2" or "scalar"
+    static const char* GetKernelName();
+
+    // Keeps the block storage for the next fill
+    void Clear();
+
+    // @return Index of the circle, in insertion order
+    size_t Add(sf::Vector2f position, float radius);
+
+    // Takes a circle out of every later test without shifting the others
+    void Remove(size_t index);
+
+    size_t GetSize() const { return count; }
+    size_t GetBlockCount() const { return blocks.size(); }
+
+    // Bit i set when circle blockIndex * BLOCK_SIZE + i overlaps the query circle
+    uint32_t OverlapMask(size_t blockIndex, sf::Vector2f position, float radius) const;
+
+    // @return Lowest index overlapping the query circle, or NONE
+    size_t FindFirstOverlap(sf::Vector2f position, float radius) const;
+
+    // Swept test of a circle moving from start to end. Bit i set when it
+    // overlaps circle blockIndex * BLOCK_SIZE + i at some point of the move;
+    // outTimes[i] (BLOCK_SIZE floats) is then the fraction of the move at first
+    // contact, 0 if the circles already overlap at start. With start == end
+    // this is exactly OverlapMask.
+    uint32_t SweptMask(size_t blockIndex, sf::Vector2f start, sf::Vector2f end, float radius,
+        float* outTimes) const;
+
+    // @return Index with the earliest contact along the move (lowest index
+    // on ties), or NONE. outTime is the fraction of the move at that contact.
+    size_t FindEarliestSweptOverlap(sf::Vector2f start, sf::Vector2f end, float radius, float& outTime) const;
+
+private:
+    struct alignas(32) Block {
+        float x[BLOCK_SIZE];
+        float y[BLOCK_SIZE];
+        float radius[BLOCK_SIZE];
+    };
+
+    std::vector<Block> blocks;  // Unused lanes hold circles that overlap nothing
+    size_t count = 0;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <memory>
+#include "EnemyTank.h"
+
+// Components of the client's registry (entt) of remote tanks: other players
+// and enemies. They are plain data; sync, interpolation and rendering are
+// passes in MultiplayerGame over packed views of them. What used to be per
+// object (textures, sprites, fonts, health bar state) is shared: sprites per
+// colour in TankSprites, name texts in MultiplayerGame's label slots.
+// The local tank stays a Tank, since it is simulated rather than replicated.
+namespace ClientComponents {
+    // Replicated ID (players below 1000, enemies from 1000)
+    struct NetId {
+        uint32_t id;
+    };
+
+    struct Transform {
+        sf::Vector2f position;
+        float bodyRotation;     // Degrees
+        float barrelRotation;   // Degrees
+        float radius;
+    };
+
+    struct Health {
+        float current;
+        float max;
+        bool dead;              // Not drawn
+    };
+
+    // Body and barrel, textured and with their origins set, for every tank
+    // of one colour. Rendering copies them and applies the Transform.
+    struct TankSprites {
+        explicit TankSprites(const sf::Texture& placeholder) : body(placeholder), barrel(placeholder) {}
+
+        std::shared_ptr<const sf::Texture> bodyTexture;     // Shared with the AssetManager cache
+        std::shared_ptr<const sf::Texture> barrelTexture;
+        sf::Sprite body;
+        sf::Sprite barrel;
+    };
+
+    struct SpriteRef {
+        const TankSprites* sprites;
+    };
+
+    // Name label slot (MultiplayerGame::nameLabels); players only, and only
+    // once the player table has a name for them
+    struct Label {
+        uint32_t slot;
+    };
+
+    struct PlayerTag {};
+
+    struct EnemyKind {
+        EnemyTank::EnemyType type;
+    };
+}
@@ -65,7 +65,7 @@ int main() {
         return -1;
     }
 
-    Utils::printMsg("Connected to server successfully!", MessageType::success);
+    Utils::printMsg("Joining the server, the game starts once it answers", MessageType::success);
     Utils::printMsg("Use WASD to move your tank. Press ESC to quit.");
 
     // Game loop
@@ -1,12 +1,12 @@
 #include "client_prediction.h"
 #include <algorithm>
-#include "network_messages.h"
 
 /**
  * Constructs ClientPrediction: initializes sequence counter for input tracking.
  */
 ClientPrediction::ClientPrediction()
-    : nextSequenceNumber(1) { // Start at 1 (0 is reserved for "no sequence")
+    : nextSequenceNumber(1), // Start at 1 (0 is reserved for "no sequence")
+    historyStart(1), bufferStart(1), bufferedCount(0) {
 }
 
 /**
@@ -17,96 +17,122 @@ ClientPrediction::~ClientPrediction() {
 }
 
 /**
- * Stores input: assigns sequence/timestamp, adds to history/buffer, limits size.
+ * Stores input: assigns sequence/timestamp and takes over the sequence's ring
+ * slot, evicting whatever older input held it; trims history and buffer.
  * @param input Const InputState ref to store.
  * @return Uint32_t assigned sequence number.
  */
 uint32_t ClientPrediction::StoreInput(const InputState& input) {
-    // Assign sequence number to this input
-    InputState numberedInput = input;
-    numberedInput.sequenceNumber = nextSequenceNumber++;
-    numberedInput.sentTime = GetCurrentTimestamp();
-    numberedInput.acknowledged = false; // Not yet acknowledged
-    // Add to history
-    inputHistory.push_back(numberedInput);
+    const uint32_t sequence = nextSequenceNumber++;
+    Slot& slot = SlotFor(sequence);
+    Unbuffer(slot);     // The input RING_CAPACITY sequences ago, if still tracked
+
+    slot.input = input;
+    slot.input.sequenceNumber = sequence;
+    slot.input.acknowledged = false; // Not yet acknowledged
+    slot.hasPrediction = false;
     // Also add to buffer for tracking unacknowledged inputs
-    BufferInput(numberedInput);
+    BufferInput(slot.input);
+
     // Limit history size (circular buffer behavior)
-    while (inputHistory.size() > MAX_PREDICTION_HISTORY) {
-        inputHistory.pop_front();
+    if (nextSequenceNumber - historyStart > MAX_PREDICTION_HISTORY) {
+        historyStart = nextSequenceNumber - static_cast<uint32_t>(MAX_PREDICTION_HISTORY);
     }
-    return numberedInput.sequenceNumber;
+    return sequence;
 }
 
 /**
- * Stores predicted state: adds to history, limits size for prediction tracking.
+ * Stores predicted state in the slot of the input that produced it.
  * @param state Const PredictedState ref to store.
  */
 void ClientPrediction::StorePredictedState(const PredictedState& state) {
-    // Add to prediction history
-    predictionHistory.push_back(state);
-    // Limit history size
-    while (predictionHistory.size() > MAX_PREDICTION_HISTORY) {
-        predictionHistory.pop_front();
+    Slot& slot = SlotFor(state.sequenceNumber);
+    if (slot.input.sequenceNumber != state.sequenceNumber || state.sequenceNumber < historyStart) {
+        return;     // Input no longer in the history
     }
+    slot.predicted = state;
+    slot.hasPrediction = true;
 }
 
 /**
- * Retrieves input by sequence: searches history for match.
+ * Looks up an input in the history by its slot.
+ * @param sequenceNumber Uint32_t sequence to find.
+ * @return Pointer to the stored input, or nullptr if not in the history.
+ */
+const InputState* ClientPrediction::FindInput(uint32_t sequenceNumber) const {
+    if (sequenceNumber < historyStart || sequenceNumber >= nextSequenceNumber) {
+        return nullptr;
+    }
+    const Slot& slot = SlotFor(sequenceNumber);
+    return slot.input.sequenceNumber == sequenceNumber ? &slot.input : nullptr;
+}
+
+/**
+ * Retrieves input by sequence.
  * @param sequenceNumber Uint32_t sequence to find.
  * @param outInput InputState ref to populate if found.
  * @return Bool true if found.
  */
 bool ClientPrediction::GetInput(uint32_t sequenceNumber, InputState& outInput) const {
-    // Search for input with matching sequence number
-    for (const auto& input : inputHistory) {
-        if (input.sequenceNumber == sequenceNumber) {
-            outInput = input;
-            return true;
-        }
+    const InputState* input = FindInput(sequenceNumber);
+    if (!input) {
+        return false;
     }
-    return false;
+    outInput = *input;
+    return true;
 }
 
 /**
- * Retrieves predicted state by sequence: searches history for match.
+ * Retrieves predicted state by sequence.
  * @param sequenceNumber Uint32_t sequence to find.
  * @param outState PredictedState ref to populate if found.
  * @return Bool true if found.
  */
 bool ClientPrediction::GetPredictedState(uint32_t sequenceNumber, PredictedState& outState) const {
-    // Search for predicted state with matching sequence number
-    for (const auto& state : predictionHistory) {
-        if (state.sequenceNumber == sequenceNumber) {
-            outState = state;
-            return true;
-        }
+    if (!FindInput(sequenceNumber)) {
+        return false;
+    }
+    const Slot& slot = SlotFor(sequenceNumber);
+    if (!slot.hasPrediction) {
+        return false;
     }
-    return false;
+    outState = slot.predicted;
+    return true;
+}
+
+bool ClientPrediction::ConcealInput(uint32_t sequenceNumber) {
+    const InputState* previous = FindInput(sequenceNumber - 1);
+    if (!previous || !FindInput(sequenceNumber)) {
+        return false;
+    }
+    InputState& input = SlotFor(sequenceNumber).input;
+    if (input.moveForward == previous->moveForward && input.moveBackward == previous->moveBackward &&
+        input.turnLeft == previous->turnLeft && input.turnRight == previous->turnRight) {
+        return false;
+    }
+    input.moveForward = previous->moveForward;
+    input.moveBackward = previous->moveBackward;
+    input.turnLeft = previous->turnLeft;
+    input.turnRight = previous->turnRight;
+    return true;
 }
 
 /**
- * Collects inputs after sequence: gathers and sorts for replay.
- * @param sequenceNumber Uint32_t starting sequence (exclusive).
- * @param outInputs Vector<InputState> ref to fill.
+ * Counts predicted states in the history (debugging).
  */
-void ClientPrediction::GetInputsAfter(uint32_t sequenceNumber, std::vector<InputState>& outInputs) const {
-    outInputs.clear();
-    // Collect all inputs with sequence number > sequenceNumber
-    for (const auto& input : inputHistory) {
-        if (input.sequenceNumber > sequenceNumber) {
-            outInputs.push_back(input);
+size_t ClientPrediction::GetPredictionHistorySize() const {
+    size_t predictions = 0;
+    for (uint32_t sequence = historyStart; sequence < nextSequenceNumber; ++sequence) {
+        const Slot& slot = SlotFor(sequence);
+        if (slot.input.sequenceNumber == sequence && slot.hasPrediction) {
+            predictions++;
         }
     }
-    // Sort by sequence number (should already be sorted, but be safe)
-    std::sort(outInputs.begin(), outInputs.end(),
-        [](const InputState& a, const InputState& b) {
-            return a.sequenceNumber < b.sequenceNumber;
-        });
+    return predictions;
 }
 
 /**
- * Removes old data: cleans history/buffer below cutoff for memory efficiency.
+ * Removes old data: trims history and buffer below the cutoff.
  * @param lastAckedSequence Uint32_t last acknowledged sequence.
  */
 void ClientPrediction::CleanupOldHistory(uint32_t lastAckedSequence) {
@@ -114,24 +140,10 @@ void ClientPrediction::CleanupOldHistory(uint32_t lastAckedSequence) {
     // Keep a small buffer (10 frames) for safety
     const uint32_t safetyBuffer = 10;
     uint32_t cutoff = (lastAckedSequence > safetyBuffer) ? (lastAckedSequence - safetyBuffer) : 0;
-    // Remove old inputs
-    while (!inputHistory.empty() && inputHistory.front().sequenceNumber < cutoff) {
-        inputHistory.pop_front();
-    }
-    // Remove old predictions
-    while (!predictionHistory.empty() && predictionHistory.front().sequenceNumber < cutoff) {
-        predictionHistory.pop_front();
-    }
-    // Clean up acknowledged inputs from buffer
-    auto it = inputBuffer.begin();
-    while (it != inputBuffer.end()) {
-        if (it->second.input.sequenceNumber < cutoff || it->second.input.acknowledged) {
-            it = inputBuffer.erase(it);
-        }
-        else {
-            ++it;
-        }
-    }
+    cutoff = std::min(cutoff, nextSequenceNumber);
+    historyStart = std::max(historyStart, cutoff);
+    // Acknowledged inputs already left the buffer; drop the old ones too
+    AdvanceBufferStart(cutoff);
 }
 
 /**
@@ -146,75 +158,63 @@ uint32_t ClientPrediction::GetLatestSequenceNumber() const {
  * Clears all histories, buffer, resets sequence for reset operations.
  */
 void ClientPrediction::Clear() {
-    inputHistory.clear();
-    predictionHistory.clear();
-    inputBuffer.clear(); // NEW: Clear buffer too
+    ring.fill(Slot());
     nextSequenceNumber = 1;
+    historyStart = 1;
+    bufferStart = 1;
+    bufferedCount = 0;
 }
 
 /**
- * Adds input to buffer: tracks unacknowledged, enforces max size by age.
- * @param input Const InputState ref to buffer.
+ * Flags an input in the ring as unacknowledged; only the newest
+ * MAX_INPUT_BUFFER_SIZE sequences stay buffered.
+ * @param input Const InputState ref to buffer (must be the input in its slot).
  */
 void ClientPrediction::BufferInput(const InputState& input) {
-    // Add input to buffer
-    BufferedInput buffered(input);
-    inputBuffer[input.sequenceNumber] = buffered;
+    Slot& slot = SlotFor(input.sequenceNumber);
+    if (slot.input.sequenceNumber != input.sequenceNumber || slot.buffered) {
+        return;
+    }
+    slot.buffered = true;
+    slot.needsReplay = false;
+    slot.bufferTime = 0;
+    bufferedCount++;
     // Enforce maximum buffer size
-    if (inputBuffer.size() > MAX_INPUT_BUFFER_SIZE) {
-        // Find and remove oldest input
-        uint32_t oldestSeq = UINT32_MAX;
-        int64_t oldestTime = INT64_MAX;
-        for (const auto& pair : inputBuffer) {
-            if (pair.second.input.timestamp < oldestTime) {
-                oldestTime = pair.second.input.timestamp;
-                oldestSeq = pair.first;
-            }
-        }
-        if (oldestSeq != UINT32_MAX) {
-            inputBuffer.erase(oldestSeq);
-        }
+    if (nextSequenceNumber > MAX_INPUT_BUFFER_SIZE) {
+        AdvanceBufferStart(nextSequenceNumber - static_cast<uint32_t>(MAX_INPUT_BUFFER_SIZE));
     }
 }
 
-/**
- * Marks input acknowledged: updates buffer/history, removes from buffer.
- * @param sequenceNumber Uint32_t sequence to acknowledge.
- */
-void ClientPrediction::AcknowledgeInput(uint32_t sequenceNumber) {
-    // Find input in buffer and mark as acknowledged
-    auto it = inputBuffer.find(sequenceNumber);
-    if (it != inputBuffer.end()) {
-        it->second.input.acknowledged = true;
-        // Remove acknowledged input from buffer
-        inputBuffer.erase(it);
+void ClientPrediction::Unbuffer(Slot& slot) {
+    if (slot.buffered) {
+        slot.buffered = false;
+        slot.needsReplay = false;
+        bufferedCount--;
     }
-    // Also update in input history
-    for (auto& input : inputHistory) {
-        if (input.sequenceNumber == sequenceNumber) {
-            input.acknowledged = true;
-            break;
+}
+
+void ClientPrediction::AdvanceBufferStart(uint32_t sequence) {
+    for (; bufferStart < sequence; ++bufferStart) {
+        Slot& slot = SlotFor(bufferStart);
+        if (slot.input.sequenceNumber == bufferStart) {
+            Unbuffer(slot);
         }
     }
 }
 
 /**
- * Collects unacknowledged inputs: gathers and sorts for resending.
- * @param outInputs Vector<InputState> ref to fill.
+ * Marks input acknowledged and removes it from the buffer.
+ * @param sequenceNumber Uint32_t sequence to acknowledge.
  */
-void ClientPrediction::GetUnacknowledgedInputs(std::vector<InputState>& outInputs) const {
-    outInputs.clear();
-    // Collect all unacknowledged inputs
-    for (const auto& pair : inputBuffer) {
-        if (!pair.second.input.acknowledged) {
-            outInputs.push_back(pair.second.input);
-        }
+void ClientPrediction::AcknowledgeInput(uint32_t sequenceNumber) {
+    if (sequenceNumber == 0 || sequenceNumber >= nextSequenceNumber) {
+        return;
+    }
+    Slot& slot = SlotFor(sequenceNumber);
+    if (slot.input.sequenceNumber == sequenceNumber) {
+        slot.input.acknowledged = true;
+        Unbuffer(slot);
     }
-    // Sort by sequence number
-    std::sort(outInputs.begin(), outInputs.end(),
-        [](const InputState& a, const InputState& b) {
-            return a.sequenceNumber < b.sequenceNumber;
-        });
 }
 
 /**
@@ -222,40 +222,20 @@ void ClientPrediction::GetUnacknowledgedInputs(std::vector<InputState>& outInput
  * @param fromSequence Uint32_t starting sequence for marking.
  */
 void ClientPrediction::MarkInputsForReplay(uint32_t fromSequence) {
-    // Mark all inputs from this sequence onwards for replay
-    for (auto& pair : inputBuffer) {
-        if (pair.second.input.sequenceNumber >= fromSequence) {
-            pair.second.needsReplay = true;
+    for (uint32_t sequence = std::max(fromSequence, bufferStart); sequence < nextSequenceNumber; ++sequence) {
+        Slot& slot = SlotFor(sequence);
+        if (slot.buffered && slot.input.sequenceNumber == sequence) {
+            slot.needsReplay = true;
         }
     }
 }
 
-/**
- * Collects flagged replay inputs: gathers and sorts for correction.
- * @param outInputs Vector<InputState> ref to fill.
- */
-void ClientPrediction::GetInputsToReplay(std::vector<InputState>& outInputs) const {
-    outInputs.clear();
-    // Collect all inputs marked for replay
-    for (const auto& pair : inputBuffer) {
-        if (pair.second.needsReplay) {
-            outInputs.push_back(pair.second.input);
-        }
-    }
-    // Sort by sequence number to replay in correct order
-    std::sort(outInputs.begin(), outInputs.end(),
-        [](const InputState& a, const InputState& b) {
-            return a.sequenceNumber < b.sequenceNumber;
-        });
-}
-
 /**
  * Resets all replay flags in buffer after correction.
  */
 void ClientPrediction::ClearReplayFlags() {
-    // Clear all replay flags
-    for (auto& pair : inputBuffer) {
-        pair.second.needsReplay = false;
+    for (uint32_t sequence = bufferStart; sequence < nextSequenceNumber; ++sequence) {
+        SlotFor(sequence).needsReplay = false;
     }
 }
 
@@ -264,10 +244,12 @@ void ClientPrediction::ClearReplayFlags() {
  * @param deltaTime Float time delta in seconds.
  */
 void ClientPrediction::UpdateBufferTimers(float deltaTime) {
-    // Update buffer time for all inputs
-    int64_t deltaTimeMs = static_cast<int64_t>(deltaTime * 1000.0f);
-    for (auto& pair : inputBuffer) {
-        pair.second.bufferTime += deltaTimeMs;
+    int32_t deltaTimeMs = static_cast<int32_t>(deltaTime * 1000.0f);
+    for (uint32_t sequence = bufferStart; sequence < nextSequenceNumber; ++sequence) {
+        Slot& slot = SlotFor(sequence);
+        if (slot.buffered) {
+            slot.bufferTime += deltaTimeMs;
+        }
     }
 }
 
@@ -275,14 +257,10 @@ void ClientPrediction::UpdateBufferTimers(float deltaTime) {
  * Removes timed-out inputs from buffer to prevent stale data.
  */
 void ClientPrediction::CleanupTimedOutInputs() {
-    // Remove inputs that have been in buffer too long
-    auto it = inputBuffer.begin();
-    while (it != inputBuffer.end()) {
-        if (it->second.bufferTime > INPUT_TIMEOUT_MS) {
-            it = inputBuffer.erase(it);
-        }
-        else {
-            ++it;
+    for (uint32_t sequence = bufferStart; sequence < nextSequenceNumber; ++sequence) {
+        Slot& slot = SlotFor(sequence);
+        if (slot.buffered && slot.bufferTime > INPUT_TIMEOUT_MS) {
+            Unbuffer(slot);
         }
     }
 }
@@ -292,14 +270,14 @@ void ClientPrediction::CleanupTimedOutInputs() {
  * @return Int64_t oldest timestamp.
  */
 int64_t ClientPrediction::GetOldestUnacknowledgedTimestamp() const {
-    if (inputBuffer.empty()) {
+    if (bufferedCount == 0) {
         return 0;
     }
     int64_t oldestTimestamp = INT64_MAX;
-    for (const auto& pair : inputBuffer) {
-        if (!pair.second.input.acknowledged &&
-            pair.second.input.timestamp < oldestTimestamp) {
-            oldestTimestamp = pair.second.input.timestamp;
+    for (uint32_t sequence = bufferStart; sequence < nextSequenceNumber; ++sequence) {
+        const Slot& slot = SlotFor(sequence);
+        if (slot.buffered && slot.input.timestamp < oldestTimestamp) {
+            oldestTimestamp = slot.input.timestamp;
         }
     }
     return (oldestTimestamp == INT64_MAX) ? 0 : oldestTimestamp;
@@ -311,25 +289,29 @@ int64_t ClientPrediction::GetOldestUnacknowledgedTimestamp() const {
  */
 ClientPrediction::BufferStats ClientPrediction::GetBufferStats() const {
     BufferStats stats;
-    stats.totalBuffered = inputBuffer.size();
+    stats.totalBuffered = bufferedCount;
     stats.needingReplay = 0;
     stats.oldestTimestamp = 0;
     stats.averageBufferTime = 0.0f;
-    if (inputBuffer.empty()) {
+    if (bufferedCount == 0) {
         return stats;
     }
     int64_t oldestTime = INT64_MAX;
     int64_t totalBufferTime = 0;
-    for (const auto& pair : inputBuffer) {
-        if (pair.second.needsReplay) {
+    for (uint32_t sequence = bufferStart; sequence < nextSequenceNumber; ++sequence) {
+        const Slot& slot = SlotFor(sequence);
+        if (!slot.buffered) {
+            continue;
+        }
+        if (slot.needsReplay) {
             stats.needingReplay++;
         }
-        if (pair.second.input.timestamp < oldestTime) {
-            oldestTime = pair.second.input.timestamp;
+        if (slot.input.timestamp < oldestTime) {
+            oldestTime = slot.input.timestamp;
         }
-        totalBufferTime += pair.second.bufferTime;
+        totalBufferTime += slot.bufferTime;
     }
     stats.oldestTimestamp = (oldestTime == INT64_MAX) ? 0 : oldestTime;
-    stats.averageBufferTime = static_cast<float>(totalBufferTime) / static_cast<float>(inputBuffer.size());
+    stats.averageBufferTime = static_cast<float>(totalBufferTime) / static_cast<float>(bufferedCount);
     return stats;
-}
\ No newline at end of file
+}
@@ -1,28 +1,28 @@
 #pragma once
-#include <deque>
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <unordered_map>
 #include <SFML/System/Vector2.hpp>
 #include <SFML/System/Angle.hpp>
 
-// Input state for a single frame - stores what the player did
+// Input state for a single frame - stores what the player did. The flags
+// share one byte, so a history slot stays small (see ClientPrediction).
 struct InputState {
-    uint32_t sequenceNumber;    // Unique ID for this input
     int64_t timestamp;          // When input was generated
-    bool moveForward;
-    bool moveBackward;
-    bool turnLeft;
-    bool turnRight;
+    int64_t sampleMicros;       // Local steady time the keys were read (latency measurement)
+    uint32_t sequenceNumber;    // Unique ID for this input
     float deltaTime;            // Time step for this input
-    bool acknowledged;          // NEW: Has server acknowledged this input?
-    int64_t sentTime;           // NEW: When was this input sent to server?
+    bool moveForward : 1;
+    bool moveBackward : 1;
+    bool turnLeft : 1;
+    bool turnRight : 1;
+    bool acknowledged : 1;      // Has server acknowledged this input?
 
     InputState()
-        : sequenceNumber(0), timestamp(0),
+        : timestamp(0), sampleMicros(0), sequenceNumber(0), deltaTime(0.0f),
         moveForward(false), moveBackward(false),
-        turnLeft(false), turnRight(false),
-        deltaTime(0.0f), acknowledged(false), sentTime(0) {
+        turnLeft(false), turnRight(false), acknowledged(false) {
     }
 };
 
@@ -47,20 +47,13 @@ struct PredictedState {
     }
 };
 
-// Input buffer entry for tracking unacknowledged inputs
-struct BufferedInput {
-    InputState input;           // The input itself
-    bool needsReplay;           // Should this be replayed after correction?
-    int64_t bufferTime;         // How long has this been buffered (milliseconds)
-
-    BufferedInput() : needsReplay(false), bufferTime(0) {}
-
-    BufferedInput(const InputState& inp)
-        : input(inp), needsReplay(false), bufferTime(0) {
-    }
-};
-
-// Client-side prediction manager - handles prediction history and input buffering
+// Client-side prediction manager - handles prediction history and input buffering.
+// Every input lives in one fixed ring slot, sequenceNumber % RING_CAPACITY,
+// together with its predicted state and its buffered/replay flags, so lookup
+// and ack are O(1). The history is the newest MAX_PREDICTION_HISTORY
+// sequences; the unacknowledged buffer is the slots still flagged buffered,
+// all within the newest MAX_INPUT_BUFFER_SIZE sequences. Range walks visit
+// sequences in order, straight from the ring, and never allocate.
 class ClientPrediction {
 public:
     ClientPrediction();
@@ -70,6 +63,10 @@ public:
     static constexpr size_t MAX_PREDICTION_HISTORY = 60;  // Store last 60 inputs (1 second at 60Hz)
     static constexpr size_t MAX_INPUT_BUFFER_SIZE = 100;  // Maximum buffered inputs
     static constexpr int64_t INPUT_TIMEOUT_MS = 5000;     // 5 seconds before dropping old inputs
+    static constexpr size_t RING_CAPACITY = 128;          // Power of two, covers history and buffer
+    static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "RING_CAPACITY must be a power of two");
+    static_assert(RING_CAPACITY >= MAX_PREDICTION_HISTORY && RING_CAPACITY >= MAX_INPUT_BUFFER_SIZE,
+        "Ring must hold the whole history and input buffer");
 
     // Store a new input and get its sequence number
     uint32_t StoreInput(const InputState& input);
@@ -79,12 +76,28 @@ public:
 
     // Get input by sequence number (for replay during reconciliation)
     bool GetInput(uint32_t sequenceNumber, InputState& outInput) const;
+    // The input in the history, or nullptr (valid until the next StoreInput)
+    const InputState* FindInput(uint32_t sequenceNumber) const;
 
     // Get predicted state by sequence number
     bool GetPredictedState(uint32_t sequenceNumber, PredictedState& outState) const;
 
-    // Server reconciliation: Get all inputs after a certain sequence number
-    void GetInputsAfter(uint32_t sequenceNumber, std::vector<InputState>& outInputs) const;
+    // The server played this input as a repeat of the one before it (input
+    // concealment): give it that input's movement.
+    // @return True if the movement changed (the prediction from it is stale)
+    bool ConcealInput(uint32_t sequenceNumber);
+
+    // Server reconciliation: visit every history input after a sequence
+    // number, oldest first. visit(const InputState&)
+    template <typename Visitor>
+    void ForEachInputAfter(uint32_t sequenceNumber, Visitor&& visit) const {
+        for (uint32_t sequence = std::max(sequenceNumber + 1, historyStart); sequence < nextSequenceNumber; ++sequence) {
+            const Slot& slot = SlotFor(sequence);
+            if (slot.input.sequenceNumber == sequence) {
+                visit(slot.input);
+            }
+        }
+    }
 
     // Clear old history (cleanup)
     void CleanupOldHistory(uint32_t lastAckedSequence);
@@ -93,8 +106,8 @@ public:
     uint32_t GetLatestSequenceNumber() const;
 
     // Get current prediction history size (for debugging)
-    size_t GetHistorySize() const { return inputHistory.size(); }
-    size_t GetPredictionHistorySize() const { return predictionHistory.size(); }
+    size_t GetHistorySize() const { return nextSequenceNumber - historyStart; }
+    size_t GetPredictionHistorySize() const;
 
     // Clear all history
     void Clear();
@@ -106,17 +119,22 @@ public:
     // Mark input as acknowledged by server
     void AcknowledgeInput(uint32_t sequenceNumber);
 
-    // Get all unacknowledged inputs (for display/debugging)
-    void GetUnacknowledgedInputs(std::vector<InputState>& outInputs) const;
-
     // Get count of unacknowledged inputs
-    size_t GetUnacknowledgedCount() const { return inputBuffer.size(); }
+    size_t GetUnacknowledgedCount() const { return bufferedCount; }
 
     // Mark inputs for replay after server correction
     void MarkInputsForReplay(uint32_t fromSequence);
 
-    // Get inputs that need to be replayed
-    void GetInputsToReplay(std::vector<InputState>& outInputs) const;
+    // Visit the inputs marked for replay, oldest first. visit(const InputState&)
+    template <typename Visitor>
+    void ForEachInputToReplay(Visitor&& visit) const {
+        for (uint32_t sequence = bufferStart; sequence < nextSequenceNumber; ++sequence) {
+            const Slot& slot = SlotFor(sequence);
+            if (slot.buffered && slot.needsReplay && slot.input.sequenceNumber == sequence) {
+                visit(slot.input);
+            }
+        }
+    }
 
     // Clear replay flags
     void ClearReplayFlags();
@@ -140,10 +158,26 @@ public:
     BufferStats GetBufferStats() const;
 
 private:
-    std::deque<InputState> inputHistory;           // Circular buffer of inputs
-    std::deque<PredictedState> predictionHistory;  // Circular buffer of predicted states
-    uint32_t nextSequenceNumber;                   // Counter for sequence numbers
+    struct Slot {
+        InputState input;               // input.sequenceNumber identifies the slot's owner
+        PredictedState predicted;
+        int32_t bufferTime = 0;         // How long has this been buffered (milliseconds)
+        bool hasPrediction : 1;
+        bool buffered : 1;              // Unacknowledged and still tracked
+        bool needsReplay : 1;           // Should this be replayed after correction?
+
+        Slot() : hasPrediction(false), buffered(false), needsReplay(false) {}
+    };
 
-    // Input buffer
-    std::unordered_map<uint32_t, BufferedInput> inputBuffer;  // Unacknowledged inputs keyed by sequence
+    std::array<Slot, RING_CAPACITY> ring;
+    uint32_t nextSequenceNumber;        // Counter for sequence numbers
+    uint32_t historyStart;              // Oldest sequence still in the history
+    uint32_t bufferStart;               // No buffered input is older than this
+    size_t bufferedCount;
+
+    Slot& SlotFor(uint32_t sequence) { return ring[sequence & (RING_CAPACITY - 1)]; }
+    const Slot& SlotFor(uint32_t sequence) const { return ring[sequence & (RING_CAPACITY - 1)]; }
+    void Unbuffer(Slot& slot);
+    // Drops every buffered input older than sequence
+    void AdvanceBufferStart(uint32_t sequence);
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "client_telemetry.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    void Count(ClientTelemetryMessage::Buckets& buckets, const ClientTelemetry::Bounds& bounds, float value) {
+        uint16_t& bucket = buckets[ClientTelemetry::GetBucket(bounds, value)];
+        if (bucket < std::numeric_limits<uint16_t>::max()) {
+            bucket++;
+        }
+    }
+
+    void AddSaturating(uint32_t& total, size_t value) {
+        total = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(total) + value,
+            std::numeric_limits<uint32_t>::max()));
+    }
+
+    void AddBuckets(std::array<uint64_t, ClientTelemetry::BUCKET_COUNT>& totals, const ClientTelemetryMessage::Buckets& buckets) {
+        for (size_t i = 0; i < totals.size(); ++i) {
+            totals[i] += buckets[i];
+        }
+    }
+}
+
+size_t ClientTelemetry::GetBucket(const Bounds& bounds, float value) {
+    return static_cast<size_t>(std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin());
+}
+
+uint32_t ClientTelemetry::CountFrom(const ClientTelemetryMessage::Buckets& buckets, const Bounds& bounds, float value) {
+    uint32_t count = 0;
+    for (size_t i = 1; i < buckets.size(); ++i) {
+        if (bounds[i - 1] >= value) {
+            count += buckets[i];
+        }
+    }
+    return count;
+}
+
+void ClientTelemetry::RecordFrame(float frameMs, size_t entities, size_t extrapolatedEntities) {
+    Count(window.frameMs, FRAME_MS_BOUNDS, frameMs);
+    AddSaturating(window.entityFrames, entities);
+    AddSaturating(window.extrapolatedEntityFrames, extrapolatedEntities);
+}
+
+void ClientTelemetry::RecordRtt(float rttMs) {
+    Count(window.rttMs, RTT_MS_BOUNDS, rttMs);
+}
+
+void ClientTelemetry::RecordReconciliation(bool mispredicted) {
+    AddSaturating(window.reconciliations, 1);
+    if (mispredicted) {
+        AddSaturating(window.mispredictions, 1);
+    }
+}
+
+bool ClientTelemetry::Update(int64_t nowMs, float lossPercent, ClientTelemetryMessage& out) {
+    if (!started) {
+        Reset();
+        started = true;
+        windowStartMs = nowMs;
+        nextLossSampleMs = nowMs + LOSS_SAMPLE_MS;
+        return false;
+    }
+    if (nowMs >= nextLossSampleMs) {
+        Count(window.lossPercent, LOSS_PERCENT_BOUNDS, lossPercent);
+        nextLossSampleMs = nowMs + LOSS_SAMPLE_MS;
+    }
+    if (nowMs - windowStartMs < WINDOW_MS) {
+        return false;
+    }
+    window.windowMs = static_cast<uint32_t>(nowMs - windowStartMs);
+    out = window;
+    window = ClientTelemetryMessage();
+    windowStartMs = nowMs;
+    return true;
+}
+
+void ClientTelemetry::Reset() {
+    window = ClientTelemetryMessage();
+    started = false;
+}
+
+void ClientTelemetryTotals::Add(const ClientTelemetryMessage& msg) {
+    AddBuckets(frameMs, msg.frameMs);
+    AddBuckets(rttMs, msg.rttMs);
+    AddBuckets(lossPercent, msg.lossPercent);
+    windows++;
+    windowMs += msg.windowMs;
+    entityFrames += msg.entityFrames;
+    extrapolatedEntityFrames += msg.extrapolatedEntityFrames;
+    reconciliations += msg.reconciliations;
+    mispredictions += msg.mispredictions;
+}
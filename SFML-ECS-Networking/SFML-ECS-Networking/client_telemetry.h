@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "network_messages.h"
+
+// Client quality telemetry. The client sorts frame times, RTT samples and
+// packet loss into fixed-bucket histograms and counts extrapolated entity
+// frames and mispredictions; every WINDOW_MS the window goes to the server as
+// one CLIENT_TELEMETRY message (73 bytes) and a new one begins. The server
+// adds the windows of all clients up (ClientTelemetryTotals) and serves them
+// on its metrics page next to its own tick health, so client hitches can be
+// lined up against server ticks on the same dashboard.
+//
+// Telemetry is best-effort: sent unreliably, rate limited with the pings, and
+// a lost window is simply missing from the totals.
+class ClientTelemetry {
+public:
+    static constexpr size_t BUCKET_COUNT = ClientTelemetryMessage::BUCKET_COUNT;
+    static constexpr int64_t WINDOW_MS = 30000;
+    static constexpr int64_t LOSS_SAMPLE_MS = 1000;
+    static constexpr float SPIKE_FRAME_MS = 50.0f;      // Frames at least this long count as hitches
+
+    // Upper bounds of every bucket but the last, which is open-ended
+    using Bounds = std::array<float, BUCKET_COUNT - 1>;
+    static constexpr Bounds FRAME_MS_BOUNDS = { 8.5f, 17.0f, 25.0f, 34.0f, 50.0f, 100.0f, 250.0f };
+    static constexpr Bounds RTT_MS_BOUNDS = { 25.0f, 50.0f, 75.0f, 100.0f, 150.0f, 200.0f, 300.0f };
+    static constexpr Bounds LOSS_PERCENT_BOUNDS = { 0.5f, 1.0f, 2.0f, 5.0f, 10.0f, 20.0f, 40.0f };
+
+    // @return Bucket a value falls in: the first whose bound it does not exceed
+    static size_t GetBucket(const Bounds& bounds, float value);
+    // @return Samples in the buckets that start at or above value
+    static uint32_t CountFrom(const ClientTelemetryMessage::Buckets& buckets, const Bounds& bounds, float value);
+
+    // Once per rendered frame.
+    // @param entities Remote entities drawn
+    // @param extrapolatedEntities Of those, drawn past their newest snapshot
+    void RecordFrame(float frameMs, size_t entities, size_t extrapolatedEntities);
+    void RecordRtt(float rttMs);
+    void RecordReconciliation(bool mispredicted);
+
+    // Samples the loss once every LOSS_SAMPLE_MS and closes the window once
+    // it is WINDOW_MS old. The first call starts the window.
+    // @return True if a window closed: it is moved into out, with playerId left to the caller
+    bool Update(int64_t nowMs, float lossPercent, ClientTelemetryMessage& out);
+    // Drops the open window (disconnect), so the next one starts afresh
+    void Reset();
+
+private:
+    ClientTelemetryMessage window;
+    int64_t windowStartMs = 0;
+    int64_t nextLossSampleMs = 0;
+    bool started = false;
+};
+
+// Server side: every window received, added up since startup
+struct ClientTelemetryTotals {
+    std::array<uint64_t, ClientTelemetry::BUCKET_COUNT> frameMs{};
+    std::array<uint64_t, ClientTelemetry::BUCKET_COUNT> rttMs{};
+    std::array<uint64_t, ClientTelemetry::BUCKET_COUNT> lossPercent{};
+    uint64_t windows = 0;
+    uint64_t windowMs = 0;
+    uint64_t entityFrames = 0;
+    uint64_t extrapolatedEntityFrames = 0;
+    uint64_t reconciliations = 0;
+    uint64_t mispredictions = 0;
+
+    void Add(const ClientTelemetryMessage& msg);
+};
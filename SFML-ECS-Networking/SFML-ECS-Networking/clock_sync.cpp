@@ -0,0 +1,139 @@
+#include "clock_sync.h"
+#include "network_messages.h"
+#include <algorithm>
+#include <cstdlib>
+
+void ClockSync::Reset() {
+    samples = {};
+    sampleCount = 0;
+    nextSample = 0;
+    estimateOffsetUs = 0;
+    estimateLocalUs = 0;
+    drift = 0.0;
+    minRoundTripUs = 0;
+    appliedOffsetUs = 0;
+    lastUpdateUs = 0;
+    hasEstimate = false;
+    stepPending = false;
+}
+
+/**
+ * Offset and delay as NTP computes them: the offset is exact when the two legs
+ * take equally long, and off by at most half the round trip when they do not.
+ * The first sample replaces whatever the snapshot bound guessed, in one step.
+ */
+int64_t ClockSync::AddPingSample(int64_t clientSendUs, int64_t serverReceiveUs,
+    int64_t serverTransmitUs, int64_t clientReceiveUs) {
+    const int64_t roundTripUs = (clientReceiveUs - clientSendUs) - (serverTransmitUs - serverReceiveUs);
+    if (clientReceiveUs < clientSendUs || serverTransmitUs < serverReceiveUs ||
+        roundTripUs < 0 || roundTripUs > MAX_ROUND_TRIP_US) {
+        return -1;
+    }
+
+    Sample& sample = samples[nextSample];
+    sample.localUs = clientSendUs + (clientReceiveUs - clientSendUs) / 2;
+    sample.offsetUs = ((serverReceiveUs - clientSendUs) + (serverTransmitUs - clientReceiveUs)) / 2;
+    sample.roundTripUs = roundTripUs;
+    nextSample = (nextSample + 1) % SAMPLE_COUNT;
+    if (sampleCount == 0) {
+        stepPending = true;
+    }
+    sampleCount = std::min(sampleCount + 1, SAMPLE_COUNT);
+
+    Recompute();
+    return roundTripUs;
+}
+
+/**
+ * The snapshot left the server no earlier than its timestamp, so
+ * local arrival + offset >= server timestamp. Until a ping sample exists this
+ * bound is the estimate (the latency it misses is absorbed by the
+ * interpolation delay); afterwards it only corrects an estimate that is
+ * provably too low.
+ */
+void ClockSync::ObserveServerTimestamp(int64_t serverTimeMs, int64_t localArrivalUs) {
+    if (serverTimeMs <= 0) {
+        return;
+    }
+    const int64_t lowerBoundUs = serverTimeMs * 1000 - localArrivalUs;
+    if (!hasEstimate) {
+        estimateOffsetUs = lowerBoundUs;
+        estimateLocalUs = localArrivalUs;
+        hasEstimate = true;
+        stepPending = true;
+        return;
+    }
+
+    const int64_t deficitUs = lowerBoundUs - EstimateAt(localArrivalUs);
+    if (deficitUs > 0) {
+        estimateOffsetUs += deficitUs;
+    }
+}
+
+/**
+ * Picks the least-delayed sample as the anchor and fits the drift across the
+ * samples within DRIFT_ROUND_TRIP_MARGIN_US of it (slower ones carry up to
+ * half their extra delay as offset error) once they span MIN_DRIFT_SPAN_US.
+ */
+void ClockSync::Recompute() {
+    size_t best = 0;
+    for (size_t i = 1; i < sampleCount; ++i) {
+        if (samples[i].roundTripUs < samples[best].roundTripUs) {
+            best = i;
+        }
+    }
+    minRoundTripUs = samples[best].roundTripUs;
+
+    // Least squares on (local time, offset), relative to the anchor for precision
+    size_t fitted = 0;
+    int64_t firstUs = samples[best].localUs;
+    int64_t lastUs = samples[best].localUs;
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    for (size_t i = 0; i < sampleCount; ++i) {
+        if (samples[i].roundTripUs > minRoundTripUs + DRIFT_ROUND_TRIP_MARGIN_US) {
+            continue;
+        }
+        fitted++;
+        firstUs = std::min(firstUs, samples[i].localUs);
+        lastUs = std::max(lastUs, samples[i].localUs);
+        const double x = static_cast<double>(samples[i].localUs - samples[best].localUs);
+        const double y = static_cast<double>(samples[i].offsetUs - samples[best].offsetUs);
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+    drift = 0.0;
+    if (fitted >= MIN_DRIFT_SAMPLES && lastUs - firstUs >= MIN_DRIFT_SPAN_US) {
+        const double n = static_cast<double>(fitted);
+        const double denominator = n * sumXX - sumX * sumX;
+        if (denominator > 0.0) {
+            drift = std::max(-MAX_DRIFT, std::min(MAX_DRIFT, (n * sumXY - sumX * sumY) / denominator));
+        }
+    }
+
+    estimateOffsetUs = samples[best].offsetUs;
+    estimateLocalUs = samples[best].localUs;
+    hasEstimate = true;
+}
+
+void ClockSync::Update(int64_t localNowUs) {
+    if (!hasEstimate) {
+        return;
+    }
+
+    const int64_t errorUs = EstimateAt(localNowUs) - appliedOffsetUs;
+    if (stepPending || lastUpdateUs == 0 || std::abs(errorUs) > STEP_THRESHOLD_US) {
+        appliedOffsetUs += errorUs;
+        stepPending = false;
+    }
+    else {
+        const int64_t maxSlewUs = static_cast<int64_t>(SLEW_RATE * static_cast<double>(localNowUs - lastUpdateUs));
+        appliedOffsetUs += std::max(-maxSlewUs, std::min(maxSlewUs, errorUs));
+    }
+    lastUpdateUs = localNowUs;
+}
+
+int64_t ClockSync::GetServerTimeMicros() const {
+    return ToServerMicros(GetSteadyMicros());
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Maps the client's steady clock onto the server's, NTP style. Ping/pong
+// round trips give offset samples; the least-delayed recent sample is trusted
+// most (queueing only ever adds delay) and a least-squares fit over the window
+// gives the drift between the two crystals. Snapshot timestamps bound the
+// offset from below, since a snapshot cannot arrive before it was sent.
+// The applied offset slews toward the estimate so server time never jumps,
+// except for the first ping sample and errors over STEP_THRESHOLD_US.
+class ClockSync {
+public:
+    static constexpr size_t SAMPLE_COUNT = 16;                  // Ping samples kept for filtering and drift
+    static constexpr size_t MIN_DRIFT_SAMPLES = 4;
+    static constexpr int64_t MIN_DRIFT_SPAN_US = 5000000;       // Drift needs 5 s of samples to mean anything
+    static constexpr int64_t DRIFT_ROUND_TRIP_MARGIN_US = 4000; // Drift fit uses samples this close to the best
+    static constexpr double MAX_DRIFT = 0.0005;                 // 500 ppm; clock crystals are far better
+    static constexpr int64_t MAX_ROUND_TRIP_US = 2000000;       // Slower samples are discarded
+    static constexpr int64_t STEP_THRESHOLD_US = 100000;        // Larger errors step instead of slewing
+    static constexpr double SLEW_RATE = 0.005;                  // Slew up to 5 ms per second
+
+    ClockSync() { Reset(); }
+
+    void Reset();
+
+    // One ping/pong exchange: client send, server receive, server transmit,
+    // client receive, each on its own machine's steady clock in microseconds.
+    // @return Round trip minus the server's hold time, or -1 if rejected
+    int64_t AddPingSample(int64_t clientSendUs, int64_t serverReceiveUs,
+        int64_t serverTransmitUs, int64_t clientReceiveUs);
+
+    // A server-stamped message (milliseconds) arrived at localArrivalUs
+    void ObserveServerTimestamp(int64_t serverTimeMs, int64_t localArrivalUs);
+
+    // Slews the applied offset toward the estimate; call once per frame
+    void Update(int64_t localNowUs);
+
+    bool HasPingSample() const { return sampleCount > 0; }
+
+    // Server steady clock for a local time. Before any sample the offset is
+    // zero, so this is the local clock
+    int64_t ToServerMicros(int64_t localUs) const { return localUs + appliedOffsetUs; }
+    int64_t GetServerTimeMicros() const;
+    int64_t GetServerTimeMs() const { return GetServerTimeMicros() / 1000; }
+
+    // Diagnostics
+    int64_t GetOffsetMicros() const { return appliedOffsetUs; }
+    int64_t GetMinRoundTripMicros() const { return minRoundTripUs; }
+    double GetDrift() const { return drift; }   // Server seconds gained per local second
+
+private:
+    struct Sample {
+        int64_t localUs;        // Midpoint of the exchange on the local clock
+        int64_t offsetUs;
+        int64_t roundTripUs;
+    };
+
+    std::array<Sample, SAMPLE_COUNT> samples;
+    size_t sampleCount;
+    size_t nextSample;
+
+    int64_t estimateOffsetUs;   // Offset at estimateLocalUs
+    int64_t estimateLocalUs;
+    double drift;
+    int64_t minRoundTripUs;
+    int64_t appliedOffsetUs;
+    int64_t lastUpdateUs;
+    bool hasEstimate;
+    bool stepPending;           // Next Update jumps straight to the estimate
+
+    int64_t EstimateAt(int64_t localUs) const {
+        return estimateOffsetUs + static_cast<int64_t>(drift * static_cast<double>(localUs - estimateLocalUs));
+    }
+    void Recompute();
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+// Collision layers and masks. Every collider sits on one layer and carries
+// the mask of layers it interacts with; broadphase queries and pair searches
+// filter on them (SpatialGrid), so who can hit or push whom is data on the
+// collider rather than a guess from its ID range. A team mode only needs
+// more layers and different masks.
+namespace CollisionLayers {
+    using Mask = uint8_t;
+
+    constexpr Mask NONE = 0;
+    constexpr Mask PLAYER = 1u << 0;
+    constexpr Mask ENEMY = 1u << 1;
+    constexpr Mask PLAYER_BULLET = 1u << 2;
+    constexpr Mask ENEMY_BULLET = 1u << 3;
+    constexpr Mask OBSTACLE = 1u << 4;
+    constexpr Mask ALL = 0xFF;
+
+    // What each layer interacts with by default. Enemies do not push each
+    // other and bullets only hit the other side.
+    constexpr Mask PLAYER_MASK = PLAYER | ENEMY | ENEMY_BULLET | OBSTACLE;
+    constexpr Mask ENEMY_MASK = PLAYER | PLAYER_BULLET | OBSTACLE;
+    constexpr Mask PLAYER_BULLET_MASK = ENEMY | OBSTACLE;
+    constexpr Mask ENEMY_BULLET_MASK = PLAYER | OBSTACLE;
+
+    constexpr Mask DefaultMask(Mask layer) {
+        return layer == PLAYER ? PLAYER_MASK :
+            layer == ENEMY ? ENEMY_MASK :
+            layer == PLAYER_BULLET ? PLAYER_BULLET_MASK :
+            layer == ENEMY_BULLET ? ENEMY_BULLET_MASK :
+            layer == OBSTACLE ? (PLAYER | ENEMY | PLAYER_BULLET | ENEMY_BULLET) : NONE;
+    }
+
+    // Both sides have to accept each other
+    constexpr bool Interact(Mask layerA, Mask maskA, Mask layerB, Mask maskB) {
+        return (maskA & layerB) != 0 && (maskB & layerA) != 0;
+    }
+}
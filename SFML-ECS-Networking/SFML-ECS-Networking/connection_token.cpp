@@ -0,0 +1,115 @@
+#include "connection_token.h"
+#include "network_messages.h"
+#include <random>
+
+namespace {
+    uint64_t RotateLeft(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    struct SipState {
+        uint64_t v0, v1, v2, v3;
+
+        void Round() {
+            v0 += v1; v1 = RotateLeft(v1, 13); v1 ^= v0; v0 = RotateLeft(v0, 32);
+            v2 += v3; v3 = RotateLeft(v3, 16); v3 ^= v2;
+            v0 += v3; v3 = RotateLeft(v3, 21); v3 ^= v0;
+            v2 += v1; v1 = RotateLeft(v1, 17); v1 ^= v2; v2 = RotateLeft(v2, 32);
+        }
+
+        void Absorb(uint64_t word) {
+            v3 ^= word;
+            Round();
+            Round();
+            v0 ^= word;
+        }
+    };
+
+    // SipHash-2-4 of a 16-byte message given as two little-endian words
+    uint64_t SipHash(uint64_t k0, uint64_t k1, uint64_t word0, uint64_t word1) {
+        SipState state{ k0 ^ 0x736f6d6570736575ull, k1 ^ 0x646f72616e646f6dull,
+            k0 ^ 0x6c7967656e657261ull, k1 ^ 0x7465646279746573ull };
+        state.Absorb(word0);
+        state.Absorb(word1);
+        state.Absorb(uint64_t(16) << 56);   // Final block: length only
+        state.v2 ^= 0xff;
+        for (int i = 0; i < 4; ++i) {
+            state.Round();
+        }
+        return state.v0 ^ state.v1 ^ state.v2 ^ state.v3;
+    }
+
+    uint64_t ReadBigEndian64(const uint8_t* bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+}
+
+ConnectionTokens::ConnectionTokens() {
+    std::random_device device;
+    key.k0 = (static_cast<uint64_t>(device()) << 32) ^ device();
+    key.k1 = (static_cast<uint64_t>(device()) << 32) ^ device();
+}
+
+uint64_t ConnectionTokens::Hash(sf::IpAddress address, unsigned short port, int64_t epoch) const {
+    const uint64_t endpoint = (static_cast<uint64_t>(address.toInteger()) << 16) | port;
+    return SipHash(key.k0, key.k1, endpoint, static_cast<uint64_t>(epoch));
+}
+
+uint64_t ConnectionTokens::Issue(sf::IpAddress address, unsigned short port, int64_t nowMs) const {
+    const uint64_t token = Hash(address, port, nowMs / EPOCH_MS);
+    return token != 0 ? token : 1;
+}
+
+bool ConnectionTokens::Validate(uint64_t token, sf::IpAddress address, unsigned short port, int64_t nowMs) const {
+    if (token == 0) {
+        return false;
+    }
+    const int64_t epoch = nowMs / EPOCH_MS;
+    const auto matches = [&](int64_t tokenEpoch) {
+        const uint64_t expected = Hash(address, port, tokenEpoch);
+        return token == (expected != 0 ? expected : 1);
+    };
+    return matches(epoch) || matches(epoch - 1);
+}
+
+bool ConnectionTokens::ReadToken(const sf::Packet& datagram, uint64_t& token) {
+    if (datagram.getDataSize() < TOKEN_BYTES + 1) {
+        return false;
+    }
+    token = ReadBigEndian64(static_cast<const uint8_t*>(datagram.getData()));
+    return true;
+}
+
+uint8_t ConnectionTokens::PeekMessageType(const sf::Packet& datagram) {
+    return static_cast<const uint8_t*>(datagram.getData())[TOKEN_BYTES];
+}
+
+/**
+ * Undersized requests are refused so that answering them cannot amplify.
+ */
+bool ConnectionTokens::IsConnectionRequest(const sf::Packet& datagram) {
+    if (datagram.getDataSize() < REQUEST_BYTES ||
+        PeekMessageType(datagram) != static_cast<uint8_t>(NetMessageType::CONNECTION_REQUEST)) {
+        return false;
+    }
+    const uint8_t* protocol = static_cast<const uint8_t*>(datagram.getData()) + TOKEN_BYTES + 1;
+    const uint32_t protocolId = (static_cast<uint32_t>(protocol[0]) << 24) | (static_cast<uint32_t>(protocol[1]) << 16) |
+        (static_cast<uint32_t>(protocol[2]) << 8) | protocol[3];
+    return protocolId == PROTOCOL_ID;
+}
+
+void ConnectionTokens::WriteRequest(sf::Packet& packet) {
+    packet << static_cast<uint64_t>(0) << static_cast<uint8_t>(NetMessageType::CONNECTION_REQUEST) << PROTOCOL_ID;
+    const uint8_t padding[REQUEST_BYTES] = {};
+    if (packet.getDataSize() < REQUEST_BYTES) {
+        packet.append(padding, REQUEST_BYTES - packet.getDataSize());
+    }
+}
+
+void ConnectionTokens::WriteChallenge(sf::Packet& packet, uint64_t token) {
+    packet << static_cast<uint8_t>(NetMessageType::CONNECTION_CHALLENGE) << token;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// Stateless connection tokens (cookie style). Every datagram a client sends
+// starts with its token:
+//   [uint64 token][message]
+// A new client first sends a CONNECTION_REQUEST with token 0 and is answered
+// with a CONNECTION_CHALLENGE carrying its token: a keyed hash (SipHash-2-4)
+// of its address, port and the current epoch. The server keeps nothing until
+// the join that echoes the token back, and a spoofed sender never sees the
+// challenge, so a flood is dropped after reading the first few bytes.
+// Connected clients are compared against the token stored at join; only
+// joins are hashed.
+//
+//   CONNECTION_REQUEST   [uint64 0][type][uint32 PROTOCOL_ID][zeros up to REQUEST_BYTES]
+//   CONNECTION_CHALLENGE [type][uint64 token]
+// The request is padded past the size of the answer, so the handshake never
+// sends more than it receives.
+class ConnectionTokens {
+public:
+    static constexpr size_t TOKEN_BYTES = 8;
+    static constexpr size_t REQUEST_BYTES = 32;
+    static constexpr uint32_t PROTOCOL_ID = 0x54414E4B;     // "TANK"
+    static constexpr int64_t EPOCH_MS = 10000;              // A token is accepted until the epoch after the one it was issued in
+
+    struct Key {
+        uint64_t k0 = 0;
+        uint64_t k1 = 0;
+    };
+
+    // Picks a random key
+    ConnectionTokens();
+
+    // Rooms validate the joins their host issued tokens for, so they share its key
+    const Key& GetKey() const { return key; }
+    void SetKey(const Key& sharedKey) { key = sharedKey; }
+
+    // @return Never 0 (reserved for "no token")
+    uint64_t Issue(sf::IpAddress address, unsigned short port, int64_t nowMs) const;
+
+    // @return True for a token issued to this endpoint in the current or previous epoch
+    bool Validate(uint64_t token, sf::IpAddress address, unsigned short port, int64_t nowMs) const;
+
+    // Raw reads of a client datagram's header, no sf::Packet parsing
+    // @return False if the datagram is too short for a token and a type byte
+    static bool ReadToken(const sf::Packet& datagram, uint64_t& token);
+    // @return The type byte after the token (call after ReadToken succeeded)
+    static uint8_t PeekMessageType(const sf::Packet& datagram);
+    static bool IsConnectionRequest(const sf::Packet& datagram);
+
+    static void WriteRequest(sf::Packet& packet);
+    static void WriteChallenge(sf::Packet& packet, uint64_t token);
+
+private:
+    Key key;
+
+    uint64_t Hash(sf::IpAddress address, unsigned short port, int64_t epoch) const;
+};
@@ -0,0 +1,32 @@
+#include "datagram_channel.h"
+
+DatagramChannel::DatagramChannel()
+    : inbound(std::make_unique<Ring>()), outbound(std::make_unique<Ring>()),
+    inboundDropped(0), outboundDropped(0) {
+}
+
+/**
+ * @return False if the inbound ring is full and the datagram was dropped
+ */
+bool DatagramChannel::PushInbound(QueuedDatagram& datagram) {
+    if (!inbound->TryPush(datagram)) {
+        inboundDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @return False if the outbound ring is full and the datagram was dropped
+ */
+bool DatagramChannel::QueueOutbound(const sf::Packet& packet, sf::IpAddress address, unsigned short port) {
+    queueStaging.packet.clear();
+    queueStaging.packet.append(packet.getData(), packet.getDataSize());
+    queueStaging.address = address;
+    queueStaging.port = port;
+    if (!outbound->TryPush(queueStaging)) {
+        outboundDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "spsc_ring_buffer.h"
+
+// A datagram moving between the socket owner and a simulation
+struct QueuedDatagram {
+    sf::Packet packet;
+    sf::IpAddress address;
+    unsigned short port;
+    int64_t arrivalMicros;      // Local steady clock when received (0 = not stamped)
+    bool validated;             // Passed IngressValidator on the receiving thread; set by every producer,
+                                // since ring slots are swapped back and forth
+
+    QueuedDatagram() : address(sf::IpAddress::Any), port(0), arrivalMicros(0), validated(false) {}
+    QueuedDatagram(sf::Packet&& p, sf::IpAddress addr, unsigned short prt)
+        : packet(std::move(p)), address(addr), port(prt), arrivalMicros(0), validated(false) {
+    }
+};
+
+// Two bounded rings connecting the thread that owns a socket to one
+// GameServer or NetworkClient running on another thread:
+//   inbound:  socket owner -> simulation (PushInbound / PopInbound)
+//   outbound: simulation -> socket owner (QueueOutbound / PopOutbound)
+// Each side is single-threaded, so each ring is single-producer/single-consumer.
+// Datagrams are swapped through preallocated slots, so steady-state traffic
+// does not allocate.
+class DatagramChannel {
+public:
+    static constexpr size_t CAPACITY = 2048;   // Slots per direction (power of two)
+
+    DatagramChannel();
+
+    DatagramChannel(const DatagramChannel&) = delete;
+    DatagramChannel& operator=(const DatagramChannel&) = delete;
+
+    // Socket owner side. PushInbound swaps datagram into the ring and hands
+    // back a spent slot to receive into next.
+    bool PushInbound(QueuedDatagram& datagram);
+    bool PopOutbound(QueuedDatagram& outDatagram) { return outbound->TryPop(outDatagram); }
+
+    // Simulation side. QueueOutbound copies the packet, so callers may reuse it.
+    bool PopInbound(QueuedDatagram& outDatagram) { return inbound->TryPop(outDatagram); }
+    bool QueueOutbound(const sf::Packet& packet, sf::IpAddress address, unsigned short port);
+
+    static constexpr size_t GetCapacity() { return Ring::GetCapacity(); }
+
+    // Datagrams dropped because the receiving side fell behind
+    uint64_t GetInboundDropped() const { return inboundDropped.load(std::memory_order_relaxed); }
+    uint64_t GetOutboundDropped() const { return outboundDropped.load(std::memory_order_relaxed); }
+
+private:
+    using Ring = SpscRingBuffer<QueuedDatagram, CAPACITY>;
+
+    std::unique_ptr<Ring> inbound;
+    std::unique_ptr<Ring> outbound;
+    QueuedDatagram queueStaging;           // Server thread: copy being queued outbound
+
+    std::atomic<uint64_t> inboundDropped;
+    std::atomic<uint64_t> outboundDropped;
+};
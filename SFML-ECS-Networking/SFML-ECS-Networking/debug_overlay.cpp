@@ -0,0 +1,229 @@
+#include "debug_overlay.h"
+#include "network_client.h"
+#include "sprite_batch.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+    constexpr float PANEL_X = 10.0f;
+    constexpr float PANEL_Y = 50.0f;           // Below the score
+    constexpr float PADDING = 8.0f;
+    constexpr float TEXT_HEIGHT = 440.0f;         // Timings plus the memory report
+    constexpr float FRAME_60_MS = 1000.0f / 60.0f;
+    constexpr float FRAME_30_MS = 1000.0f / 30.0f;
+}
+
+const char* GetFramePhaseName(FramePhase phase) {
+    switch (phase) {
+    case FramePhase::NETWORK: return "Network";
+    case FramePhase::INTERPOLATION: return "Interpolation";
+    case FramePhase::BULLET_SYNC: return "Bullet sync";
+    case FramePhase::RENDER: return "Render";
+    default: return "Unknown";
+    }
+}
+
+void FrameProfiler::BeginFrame(float frameSeconds) {
+    const float frameMs = frameSeconds * 1000.0f;
+    history[historyNext] = frameMs;
+    historyNext = (historyNext + 1) % HISTORY;
+
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        windowPhaseMs[i] += current[i];
+    }
+    current.fill(0.0f);
+    windowFrameMs += frameMs;
+    windowMaxFrameMs = std::max(windowMaxFrameMs, frameMs);
+    windowFrames++;
+}
+
+FrameProfiler::WindowStats FrameProfiler::TakeWindow() {
+    WindowStats stats;
+    stats.frames = windowFrames;
+    if (windowFrames > 0) {
+        const double frames = static_cast<double>(windowFrames);
+        stats.averageFrameMs = static_cast<float>(windowFrameMs / frames);
+        stats.maxFrameMs = windowMaxFrameMs;
+        for (size_t i = 0; i < PHASE_COUNT; ++i) {
+            stats.averagePhaseMs[i] = static_cast<float>(windowPhaseMs[i] / frames);
+            const uint64_t phaseAllocations = allocations[i].load(std::memory_order_relaxed) - windowAllocationStart[i];
+            stats.averagePhaseAllocations[i] = static_cast<float>(static_cast<double>(phaseAllocations) / frames);
+        }
+        const uint64_t otherPhaseAllocations = otherAllocations.load(std::memory_order_relaxed) - windowOtherAllocationStart;
+        stats.averageOtherAllocations = static_cast<float>(static_cast<double>(otherPhaseAllocations) / frames);
+    }
+    ResetWindow();
+    return stats;
+}
+
+void FrameProfiler::ResetWindow() {
+    windowPhaseMs.fill(0.0);
+    windowFrameMs = 0.0;
+    windowMaxFrameMs = 0.0f;
+    windowFrames = 0;
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        windowAllocationStart[i] = allocations[i].load(std::memory_order_relaxed);
+    }
+    windowOtherAllocationStart = otherAllocations.load(std::memory_order_relaxed);
+}
+
+DebugOverlay::DebugOverlay(const sf::Font& font)
+    : visible(false), refreshTimer(0.0f), text(font),
+    graph(sf::PrimitiveType::Lines, FrameProfiler::HISTORY * 2 + 4) {
+    text.setCharacterSize(14);
+    text.setFillColor(sf::Color::White);
+    text.setPosition(sf::Vector2f(PANEL_X + PADDING, PANEL_Y + PADDING * 2.0f + GRAPH_HEIGHT));
+
+    panel.setPosition(sf::Vector2f(PANEL_X, PANEL_Y));
+    panel.setSize(sf::Vector2f(GRAPH_WIDTH + PADDING * 2.0f, GRAPH_HEIGHT + TEXT_HEIGHT + PADDING * 3.0f));
+    panel.setFillColor(sf::Color(0, 0, 0, 160));
+
+    // Reference lines at 60 and 30 fps; they never move
+    const float left = PANEL_X + PADDING;
+    const float bottom = PANEL_Y + PADDING + GRAPH_HEIGHT;
+    const size_t lines = FrameProfiler::HISTORY * 2;
+    const float y60 = bottom - GRAPH_HEIGHT * FRAME_60_MS / GRAPH_MAX_MS;
+    const float y30 = bottom - GRAPH_HEIGHT * FRAME_30_MS / GRAPH_MAX_MS;
+    graph[lines] = sf::Vertex{ sf::Vector2f(left, y60), sf::Color(255, 255, 255, 90) };
+    graph[lines + 1] = sf::Vertex{ sf::Vector2f(left + GRAPH_WIDTH, y60), sf::Color(255, 255, 255, 90) };
+    graph[lines + 2] = sf::Vertex{ sf::Vector2f(left, y30), sf::Color(255, 255, 255, 90) };
+    graph[lines + 3] = sf::Vertex{ sf::Vector2f(left + GRAPH_WIDTH, y30), sf::Color(255, 255, 255, 90) };
+}
+
+void DebugOverlay::Update(float deltaTime, FrameProfiler& profiler,
+    const InterpolationManager* interpolation, const NetworkClient* client, const SpriteBatch* batch,
+    const MemoryReport* memory) {
+    if (!visible) {
+        return;
+    }
+    refreshTimer += deltaTime;
+    if (refreshTimer >= REFRESH_INTERVAL) {
+        RebuildText(profiler, interpolation, client, batch, memory);
+        refreshTimer = 0.0f;
+    }
+}
+
+/**
+ * Frame time and per-subsystem averages over the refresh window, then the
+ * interpolation buffer depth across entities, extrapolated entities, the
+ * unacknowledged input history, the server clock estimate, input latency
+ * percentiles since connecting, view culling and
+ * the sprite batch's last frame, and the memory report. "Other" is everything outside the timed phases,
+ * including the frame limiter's sleep.
+ */
+void DebugOverlay::RebuildText(FrameProfiler& profiler,
+    const InterpolationManager* interpolation, const NetworkClient* client, const SpriteBatch* batch,
+    const MemoryReport* memory) {
+    const FrameProfiler::WindowStats stats = profiler.TakeWindow();
+
+    char buffer[2048];
+    int length = std::snprintf(buffer, sizeof(buffer), "Frame %.2f ms avg / %.2f max (%.0f fps)\n",
+        stats.averageFrameMs, stats.maxFrameMs,
+        stats.averageFrameMs > 0.0f ? 1000.0f / stats.averageFrameMs : 0.0f);
+
+    float timedMs = 0.0f;
+    for (size_t i = 0; i < FrameProfiler::PHASE_COUNT && length < static_cast<int>(sizeof(buffer)); ++i) {
+        timedMs += stats.averagePhaseMs[i];
+#if ALLOCATION_TRACKING_ENABLED
+        length += std::snprintf(buffer + length, sizeof(buffer) - length, "  %-14s %6.2f ms %6.1f allocs\n",
+            GetFramePhaseName(static_cast<FramePhase>(i)), stats.averagePhaseMs[i], stats.averagePhaseAllocations[i]);
+#else
+        length += std::snprintf(buffer + length, sizeof(buffer) - length, "  %-14s %6.2f ms\n",
+            GetFramePhaseName(static_cast<FramePhase>(i)), stats.averagePhaseMs[i]);
+#endif
+    }
+    if (length < static_cast<int>(sizeof(buffer))) {
+#if ALLOCATION_TRACKING_ENABLED
+        length += std::snprintf(buffer + length, sizeof(buffer) - length, "  %-14s %6.2f ms %6.1f allocs\n",
+            "Other", std::max(0.0f, stats.averageFrameMs - timedMs), stats.averageOtherAllocations);
+#else
+        length += std::snprintf(buffer + length, sizeof(buffer) - length, "  %-14s %6.2f ms\n",
+            "Other", std::max(0.0f, stats.averageFrameMs - timedMs));
+#endif
+    }
+
+    if (interpolation && length < static_cast<int>(sizeof(buffer))) {
+        interpolation->GetBufferInfo(bufferInfo);
+        size_t minDepth = bufferInfo.empty() ? 0 : SIZE_MAX;
+        size_t maxDepth = 0;
+        size_t totalDepth = 0;
+        for (const InterpolationManager::EntityBufferInfo& info : bufferInfo) {
+            minDepth = std::min(minDepth, info.snapshotCount);
+            maxDepth = std::max(maxDepth, info.snapshotCount);
+            totalDepth += info.snapshotCount;
+        }
+        const float averageDepth = bufferInfo.empty() ? 0.0f :
+            static_cast<float>(totalDepth) / static_cast<float>(bufferInfo.size());
+        length += std::snprintf(buffer + length, sizeof(buffer) - length,
+            "Snapshots min %zu / avg %.1f / max %zu (%zu entities)\nExtrapolated %zu\n"
+            "Delay %lld ms (target %lld, jitter %lld)\n",
+            minDepth, averageDepth, maxDepth, bufferInfo.size(), interpolation->GetExtrapolatedEntityCount(),
+            static_cast<long long>(interpolation->GetInterpolationDelay()),
+            static_cast<long long>(interpolation->GetTargetInterpolationDelay()),
+            static_cast<long long>(interpolation->GetArrivalJitter()));
+    }
+    if (client && length < static_cast<int>(sizeof(buffer))) {
+        const ClockSync& clock = client->GetClockSync();
+        length += std::snprintf(buffer + length, sizeof(buffer) - length,
+            "Prediction history %zu inputs, %.1f%% mispredicted\n"
+            "Clock offset %.1f ms (best RTT %.1f ms, drift %.0f ppm)\n",
+            client->GetPredictionHistorySize(), client->GetMispredictionRate() * 100.0f,
+            static_cast<double>(clock.GetOffsetMicros()) / 1000.0,
+            static_cast<double>(clock.GetMinRoundTripMicros()) / 1000.0, clock.GetDrift() * 1e6);
+    }
+    if (client && length < static_cast<int>(sizeof(buffer))) {
+        const std::string latency = client->GetInputLatency().Format();
+        if (!latency.empty()) {
+            length += std::snprintf(buffer + length, sizeof(buffer) - length,
+                "Input latency p50 / p95 / p99\n%s", latency.c_str());
+        }
+    }
+    if (length < static_cast<int>(sizeof(buffer))) {
+        length += std::snprintf(buffer + length, sizeof(buffer) - length,
+            "Entities drawn %zu / culled %zu\nQuality tier %u (busy %.0f%% of frame), world at %.0f%% resolution\n",
+            drawnEntities, culledEntities, static_cast<unsigned int>(qualityTier), qualityBusy * 100.0f, renderScale * 100.0f);
+    }
+    if (batch && length < static_cast<int>(sizeof(buffer))) {
+        length += std::snprintf(buffer + length, sizeof(buffer) - length,
+            "Batch %zu quads in %zu draws (%zu unsorted), %zu texture changes\nTanks by shader %zu\n",
+            batch->GetQuadCount(), batch->GetDrawCallCount(), batch->GetUnsortedDrawCallCount(),
+            batch->GetTextureChangeCount(), instancedTanks);
+    }
+    if (length < static_cast<int>(sizeof(buffer))) {
+        std::snprintf(buffer + length, sizeof(buffer) - length,
+            "Audio %zu / %zu voices, %llu played, %llu stolen, %llu dropped, %llu culled\n",
+            audioVoices, AudioSystem::VOICE_COUNT, static_cast<unsigned long long>(audioStats.played),
+            static_cast<unsigned long long>(audioStats.stolen), static_cast<unsigned long long>(audioStats.dropped),
+            static_cast<unsigned long long>(audioStats.culled));
+    }
+    textBuffer = buffer;
+    if (memory) {
+        memory->AppendText(textBuffer);
+    }
+    text.setString(textBuffer);
+}
+
+void DebugOverlay::Render(sf::RenderWindow& window, const FrameProfiler& profiler) {
+    if (!visible) {
+        return;
+    }
+
+    // One bar per frame, oldest on the left
+    const float left = PANEL_X + PADDING;
+    const float bottom = PANEL_Y + PADDING + GRAPH_HEIGHT;
+    const float barSpacing = GRAPH_WIDTH / static_cast<float>(FrameProfiler::HISTORY);
+    for (size_t i = 0; i < FrameProfiler::HISTORY; ++i) {
+        const float frameMs = profiler.GetFrameMs(i);
+        const float height = GRAPH_HEIGHT * std::min(frameMs, GRAPH_MAX_MS) / GRAPH_MAX_MS;
+        const sf::Color color = frameMs <= FRAME_60_MS + 1.0f ? sf::Color::Green :
+            frameMs <= FRAME_30_MS ? sf::Color::Yellow : sf::Color::Red;
+        const float x = left + barSpacing * static_cast<float>(i);
+        graph[i * 2] = sf::Vertex{ sf::Vector2f(x, bottom), color };
+        graph[i * 2 + 1] = sf::Vertex{ sf::Vector2f(x, bottom - height), color };
+    }
+
+    window.draw(panel);
+    window.draw(graph);
+    window.draw(text);
+}
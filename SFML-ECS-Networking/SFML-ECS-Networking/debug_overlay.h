@@ -0,0 +1,158 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "allocation_counter.h"
+#include "trace_recorder.h"
+#include "entity_interpolation.h"
+#include "memory_report.h"
+#include "audio_system.h"
+
+class NetworkClient;
+class SpriteBatch;
+
+// Client subsystems timed each frame by MultiplayerGame
+enum class FramePhase : uint8_t {
+    NETWORK,            // NetworkClient::Update
+    INTERPOLATION,      // InterpolationManager::Update
+    BULLET_SYNC,        // SynchronizeBulletsFromServer
+    RENDER,             // MultiplayerGame::Render, up to the overlay
+    COUNT
+};
+
+const char* GetFramePhaseName(FramePhase phase);
+
+// Per-frame subsystem times plus a ring of recent frame times for the graph.
+// Phases accumulate into the current frame; BeginFrame closes it and folds
+// it into a window that the overlay drains with TakeWindow. Allocation builds
+// (ALLOCATION_TRACKING_ENABLED) also count each phase's allocations.
+class FrameProfiler {
+public:
+    static constexpr size_t HISTORY = 120;      // Frames shown in the graph
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(FramePhase::COUNT);
+
+    struct WindowStats {
+        uint32_t frames = 0;
+        float averageFrameMs = 0.0f;
+        float maxFrameMs = 0.0f;
+        std::array<float, PHASE_COUNT> averagePhaseMs{};
+        std::array<float, PHASE_COUNT> averagePhaseAllocations{};   // Per frame
+        float averageOtherAllocations = 0.0f;
+    };
+
+    // frameSeconds is the length of the frame that just ended (the loop's delta time)
+    void BeginFrame(float frameSeconds);
+    void Record(FramePhase phase, float milliseconds) { current[static_cast<size_t>(phase)] += milliseconds; }
+    AllocationCounter::ScopeCounter* GetAllocationCounter(FramePhase phase) {
+        return &allocations[static_cast<size_t>(phase)];
+    }
+    // For the whole game update; the phases inside take their own allocations
+    AllocationCounter::ScopeCounter* GetOtherAllocationCounter() { return &otherAllocations; }
+
+    // Averages since the last call (or ResetWindow), then starts a new window
+    WindowStats TakeWindow();
+    void ResetWindow();
+
+    // Oldest first
+    float GetFrameMs(size_t age) const { return history[(historyNext + age) % HISTORY]; }
+
+private:
+    std::array<float, HISTORY> history{};
+    size_t historyNext = 0;
+    std::array<float, PHASE_COUNT> current{};
+    std::array<double, PHASE_COUNT> windowPhaseMs{};
+    double windowFrameMs = 0.0;
+    float windowMaxFrameMs = 0.0f;
+    uint32_t windowFrames = 0;
+    std::array<AllocationCounter::ScopeCounter, PHASE_COUNT> allocations{};     // Since startup
+    std::array<uint64_t, PHASE_COUNT> windowAllocationStart{};
+    AllocationCounter::ScopeCounter otherAllocations{ 0 };
+    uint64_t windowOtherAllocationStart = 0;
+};
+
+// Times the enclosing scope into one frame phase, and attributes its
+// allocations to it; also a trace event while tracing
+class ScopedFrameTimer {
+public:
+    ScopedFrameTimer(FrameProfiler& profiler, FramePhase phase)
+        : profiler(profiler), phase(phase), start(std::chrono::steady_clock::now()),
+        allocations(profiler.GetAllocationCounter(phase)) {
+    }
+    ~ScopedFrameTimer() {
+        const auto end = std::chrono::steady_clock::now();
+        const std::chrono::duration<float, std::milli> elapsed = end - start;
+        profiler.Record(phase, elapsed.count());
+        if (TraceRecorder::IsEnabled()) {
+            TraceRecorder::Instance().Record(GetFramePhaseName(phase), "frame",
+                TraceRecorder::ToMicros(start), TraceRecorder::ToMicros(end));
+        }
+    }
+
+    ScopedFrameTimer(const ScopedFrameTimer&) = delete;
+    ScopedFrameTimer& operator=(const ScopedFrameTimer&) = delete;
+
+private:
+    FrameProfiler& profiler;
+    FramePhase phase;
+    std::chrono::steady_clock::time_point start;
+    AllocationCounter::Scope allocations;
+};
+
+// Toggleable frame-time graph and subsystem breakdown. All text lives in one
+// sf::Text rebuilt every REFRESH_INTERVAL; the graph is a fixed vertex array
+// refilled in place, so a visible overlay costs three draw calls a frame.
+class DebugOverlay {
+public:
+    static constexpr float REFRESH_INTERVAL = 0.25f;
+    static constexpr float GRAPH_WIDTH = 240.0f;
+    static constexpr float GRAPH_HEIGHT = 60.0f;
+    static constexpr float GRAPH_MAX_MS = 50.0f;    // Taller frames are clipped
+
+    explicit DebugOverlay(const sf::Font& font);
+
+    void Toggle() { visible = !visible; refreshTimer = REFRESH_INTERVAL; }
+    bool IsVisible() const { return visible; }
+    // Entities drawn and skipped by view culling in the last frame
+    void SetCullCounts(size_t drawn, size_t culled) { drawnEntities = drawn; culledEntities = culled; }
+    // Rendering quality tier and the busy fraction of the window that set it (QualityController)
+    void SetQualityTier(uint8_t tier, float busyFraction) { qualityTier = tier; qualityBusy = busyFraction; }
+    // Fraction of the window's resolution the world is rendered at (RenderScaleController)
+    void SetRenderScale(float scale) { renderScale = scale; }
+    // Tanks drawn by the tank shader rather than the sprite batch (TankBatch)
+    void SetInstancedTanks(size_t count) { instancedTanks = count; }
+    // Voices playing and the AudioSystem's running totals
+    void SetAudioStats(size_t activeVoices, const AudioSystem::Stats& stats) { audioVoices = activeVoices; audioStats = stats; }
+
+    // Whether Update with this delta time rebuilds the text, so costly inputs
+    // (the memory report) are only gathered when they will be shown
+    bool IsRefreshDue(float deltaTime) const { return visible && refreshTimer + deltaTime >= REFRESH_INTERVAL; }
+
+    // Rebuilds the text when the refresh is due; does nothing while hidden
+    void Update(float deltaTime, FrameProfiler& profiler,
+        const InterpolationManager* interpolation, const NetworkClient* client,
+        const SpriteBatch* batch = nullptr, const MemoryReport* memory = nullptr);
+    void Render(sf::RenderWindow& window, const FrameProfiler& profiler);
+
+private:
+    bool visible;
+    float refreshTimer;
+    size_t drawnEntities = 0;
+    size_t culledEntities = 0;
+    uint8_t qualityTier = 0;
+    float qualityBusy = 0.0f;
+    float renderScale = 1.0f;
+    size_t instancedTanks = 0;
+    size_t audioVoices = 0;
+    AudioSystem::Stats audioStats;
+    sf::Text text;
+    sf::RectangleShape panel;
+    sf::VertexArray graph;          // Two vertices per frame bar, plus the 60 and 30 fps lines
+    std::vector<InterpolationManager::EntityBufferInfo> bufferInfo;
+    std::string textBuffer;
+
+    void RebuildText(FrameProfiler& profiler, const InterpolationManager* interpolation, const NetworkClient* client,
+        const SpriteBatch* batch, const MemoryReport* memory);
+};
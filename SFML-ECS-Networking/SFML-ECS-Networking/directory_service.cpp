@@ -0,0 +1,552 @@
+#include "directory_service.h"
+#include "network_messages.h"
+#include "network_validation.h"
+#include "utils.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+    uint64_t ServerKey(const sf::IpAddress& address, unsigned short port) {
+        return (static_cast<uint64_t>(address.toInteger()) << 16) | port;
+    }
+
+    /**
+     * Sends a request carrying a fresh requestId and waits for the matching
+     * answer, resending on timeout. Replies from anyone but the directory, or
+     * for an older request, are ignored.
+     * @param reply Positioned after the requestId on success
+     * @return False if the directory did not answer
+     */
+    bool Exchange(const sf::IpAddress& directory, unsigned short directoryPort, Directory::MessageType requestType,
+        sf::Packet& reply, uint8_t& replyType) {
+        sf::UdpSocket socket;
+        if (socket.bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+            Utils::printMsg("Could not open a socket to query the directory", error);
+            return false;
+        }
+        sf::SocketSelector selector;
+        selector.add(socket);
+
+        std::random_device randomDevice;
+        const uint32_t requestId = randomDevice();
+        sf::Packet query;
+        query << static_cast<uint8_t>(requestType) << Directory::PROTOCOL_VERSION << requestId;
+
+        for (int attempt = 0; attempt < Directory::QUERY_ATTEMPTS; ++attempt) {
+            if (socket.send(query, directory, directoryPort) != sf::Socket::Status::Done) {
+                Utils::printMsg("Could not send directory query", warning);
+            }
+            const int64_t deadline = GetCurrentTimestamp() + Directory::QUERY_TIMEOUT_MS;
+            int64_t remaining = Directory::QUERY_TIMEOUT_MS;
+            while (remaining > 0 && selector.wait(sf::milliseconds(static_cast<int32_t>(remaining)))) {
+                std::optional<sf::IpAddress> sender;
+                unsigned short senderPort = 0;
+                reply.clear();
+                if (socket.receive(reply, sender, senderPort) == sf::Socket::Status::Done &&
+                    sender == directory && senderPort == directoryPort) {
+                    uint32_t replyId = 0;
+                    if ((reply >> replyType >> replyId) && replyId == requestId) {
+                        return true;
+                    }
+                }
+                remaining = deadline - GetCurrentTimestamp();
+            }
+        }
+        Utils::printMsg("Directory at " + directory.toString() + ":" + std::to_string(directoryPort) + " did not answer", warning);
+        return false;
+    }
+}
+
+void Directory::WriteReport(sf::Packet& packet, const LoadReport& report) {
+    const uint16_t roomCount = static_cast<uint16_t>(std::min<size_t>(report.rooms.size(), MAX_REPORTED_ROOMS));
+    packet << static_cast<uint8_t>(MessageType::REPORT) << PROTOCOL_VERSION << report.advertisedAddress
+        << static_cast<uint16_t>(report.gamePort) << report.maxPlayersPerRoom << roomCount;
+    for (uint16_t i = 0; i < roomCount; ++i) {
+        packet << report.rooms[i].players << report.rooms[i].headroomPercent;
+    }
+}
+
+bool Directory::ReadReport(sf::Packet& packet, LoadReport& report) {
+    uint16_t version = 0;
+    uint16_t gamePort = 0;
+    uint16_t roomCount = 0;
+    if (!(packet >> version >> report.advertisedAddress >> gamePort >> report.maxPlayersPerRoom >> roomCount) ||
+        version != PROTOCOL_VERSION || gamePort == 0 || roomCount == 0 || roomCount > MAX_REPORTED_ROOMS) {
+        return false;
+    }
+    report.gamePort = gamePort;
+    report.rooms.resize(roomCount);
+    for (RoomLoad& room : report.rooms) {
+        packet >> room.players >> room.headroomPercent;
+    }
+    return static_cast<bool>(packet);
+}
+
+size_t Directory::WriteScores(sf::Packet& packet, const std::vector<ScoreChange>& changes, size_t first) {
+    const size_t end = std::min(changes.size(), first + MAX_SCORES_PER_DATAGRAM);
+    packet << static_cast<uint8_t>(MessageType::SCORES) << PROTOCOL_VERSION << static_cast<uint16_t>(end - first);
+    for (size_t i = first; i < end; ++i) {
+        packet << changes[i].name << changes[i].change;
+    }
+    return end;
+}
+
+bool Directory::ReadScores(sf::Packet& packet, std::vector<ScoreChange>& changes) {
+    uint16_t version = 0;
+    uint16_t count = 0;
+    if (!(packet >> version >> count) || version != PROTOCOL_VERSION || count > MAX_SCORES_PER_DATAGRAM) {
+        return false;
+    }
+    changes.resize(count);
+    for (ScoreChange& change : changes) {
+        if (!(packet >> change.name >> change.change) || !NetworkValidation::IsValidPlayerName(change.name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint8_t Directory::ComputeHeadroom(double averageTickMs, unsigned int tickRateHz) {
+    if (tickRateHz == 0) {
+        return 0;
+    }
+    const double budgetMs = 1000.0 / tickRateHz;
+    const double headroom = (1.0 - averageTickMs / budgetMs) * 100.0;
+    return static_cast<uint8_t>(std::clamp(headroom, 0.0, 100.0));
+}
+
+bool Directory::ParseEndpoint(const std::string& text, sf::IpAddress& address, unsigned short& port) {
+    std::string host = text;
+    unsigned short parsedPort = DEFAULT_PORT;
+    const size_t colon = text.rfind(':');
+    if (colon != std::string::npos) {
+        host = text.substr(0, colon);
+        try {
+            size_t used = 0;
+            const int value = std::stoi(text.substr(colon + 1), &used);
+            if (used != text.size() - colon - 1 || value < 1 || value > 65535) {
+                return false;
+            }
+            parsedPort = static_cast<unsigned short>(value);
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+    if (host.empty()) {
+        return false;
+    }
+    const std::optional<sf::IpAddress> resolved = sf::IpAddress::resolve(host);
+    if (!resolved) {
+        return false;
+    }
+    address = resolved.value();
+    port = parsedPort;
+    return true;
+}
+
+bool Directory::FindServer(const sf::IpAddress& directory, unsigned short directoryPort, Assignment& out) {
+    sf::Packet reply;
+    uint8_t type = 0;
+    if (!Exchange(directory, directoryPort, MessageType::QUERY, reply, type)) {
+        return false;
+    }
+    if (type == static_cast<uint8_t>(MessageType::NO_CAPACITY)) {
+        Utils::printMsg("Directory has no server with a free slot", warning);
+        return false;
+    }
+    uint32_t address = 0;
+    uint16_t gamePort = 0;
+    uint16_t room = 0;
+    if (type != static_cast<uint8_t>(MessageType::ASSIGNMENT) || !(reply >> address >> gamePort >> room)) {
+        Utils::printMsg("Malformed directory assignment", warning);
+        return false;
+    }
+    out.address = sf::IpAddress(address);
+    out.port = gamePort;
+    out.room = room;
+    return true;
+}
+
+bool Directory::FindCandidates(const sf::IpAddress& directory, unsigned short directoryPort, std::vector<Assignment>& out) {
+    sf::Packet reply;
+    uint8_t type = 0;
+    uint8_t count = 0;
+    if (!Exchange(directory, directoryPort, MessageType::CANDIDATES_QUERY, reply, type)) {
+        return false;
+    }
+    if (type != static_cast<uint8_t>(MessageType::CANDIDATES) || !(reply >> count) || count > MAX_CANDIDATES) {
+        Utils::printMsg("Malformed candidate list from the directory", warning);
+        return false;
+    }
+    if (count == 0) {
+        Utils::printMsg("Directory has no server with a free slot", warning);
+        return false;
+    }
+    out.resize(count);
+    for (Assignment& candidate : out) {
+        uint32_t address = 0;
+        uint16_t gamePort = 0;
+        reply >> address >> gamePort >> candidate.room;
+        candidate.address = sf::IpAddress(address);
+        candidate.port = gamePort;
+    }
+    return static_cast<bool>(reply);
+}
+
+bool Directory::FetchLeaderboard(const sf::IpAddress& directory, unsigned short directoryPort,
+    std::vector<LeaderboardEntry>& out) {
+    sf::Packet reply;
+    uint8_t type = 0;
+    uint16_t count = 0;
+    if (!Exchange(directory, directoryPort, MessageType::LEADERBOARD_QUERY, reply, type)) {
+        return false;
+    }
+    if (type != static_cast<uint8_t>(MessageType::LEADERBOARD) || !(reply >> count) || count > Leaderboard::TOP_COUNT) {
+        Utils::printMsg("Malformed leaderboard from the directory", warning);
+        return false;
+    }
+    out.resize(count);
+    for (LeaderboardEntry& entry : out) {
+        reply >> entry.name >> entry.score;
+    }
+    return static_cast<bool>(reply);
+}
+
+/**
+ * The player's old total leaves the ranking and the new one goes in. Past
+ * MAX_PLAYERS the lowest ranked player is forgotten, so a flood of one-off
+ * names cannot grow the directory without bound.
+ */
+void Leaderboard::Apply(const Directory::ScoreChange& change) {
+    if (change.change == 0) {
+        return;
+    }
+    auto [it, added] = totals.try_emplace(change.name, 0);
+    if (!added) {
+        ranking.erase({ it->second, &it->first });
+    }
+    it->second += change.change;
+    ranking.insert({ it->second, &it->first });
+    changed = true;
+
+    if (totals.size() > MAX_PLAYERS) {
+        const auto lowest = std::prev(ranking.end());
+        const std::string name = *lowest->second;
+        ranking.erase(lowest);
+        totals.erase(name);
+    }
+}
+
+const std::vector<Directory::LeaderboardEntry>& Leaderboard::GetTop(int64_t nowMs) {
+    if (changed && nowMs - cachedAtMs >= CACHE_REFRESH_MS) {
+        cachedTop.clear();
+        for (auto it = ranking.begin(); it != ranking.end() && cachedTop.size() < TOP_COUNT; ++it) {
+            cachedTop.push_back({ *it->second, it->first });
+        }
+        cachedAtMs = nowMs;
+        changed = false;
+    }
+    return cachedTop;
+}
+
+DirectoryService::DirectoryService(unsigned short listenPort)
+    : port(listenPort), isRunning(false), lastStatsReportMs(0), assignments(0), refusals(0),
+    failedReplies(0), scoreChanges(0), leaderboardQueries(0), candidateQueries(0) {
+}
+
+DirectoryService::~DirectoryService() {
+    Shutdown();
+}
+
+bool DirectoryService::Initialize() {
+    if (isRunning) return true;
+
+    if (socket.bind(port) != sf::Socket::Status::Done) {
+        Utils::printMsg("Failed to bind directory socket to port " + std::to_string(port), error);
+        return false;
+    }
+    socket.setBlocking(false);
+    selector.add(socket);
+    lastStatsReportMs = GetCurrentTimestamp();
+    isRunning = true;
+    LOG_MSG(success, "Directory service listening on port " + std::to_string(port));
+    return true;
+}
+
+void DirectoryService::Update() {
+    if (!isRunning) return;
+
+    try {
+        const size_t MAX_DATAGRAMS_PER_UPDATE = 1024;
+        if (selector.wait(sf::milliseconds(SELECTOR_TIMEOUT_MS))) {
+            const int64_t nowMs = GetCurrentTimestamp();
+            for (size_t i = 0; i < MAX_DATAGRAMS_PER_UPDATE; ++i) {
+                std::optional<sf::IpAddress> sender;
+                unsigned short senderPort = 0;
+                packet.clear();
+                if (socket.receive(packet, sender, senderPort) != sf::Socket::Status::Done) {
+                    break;
+                }
+                uint8_t type = 0;
+                if (!sender || !(packet >> type)) {
+                    continue;
+                }
+                if (type == static_cast<uint8_t>(Directory::MessageType::REPORT)) {
+                    Directory::LoadReport report;
+                    if (Directory::ReadReport(packet, report)) {
+                        HandleReport(report, sender.value(), nowMs);
+                    }
+                    else {
+                        LOG_MSG(debug, "Malformed load report from " + sender.value().toString());
+                    }
+                }
+                else if (type == static_cast<uint8_t>(Directory::MessageType::QUERY)) {
+                    HandleQuery(sender.value(), senderPort, nowMs);
+                }
+                else if (type == static_cast<uint8_t>(Directory::MessageType::SCORES)) {
+                    // Only from servers that report load: anyone else could write the leaderboard
+                    const bool known = std::any_of(servers.begin(), servers.end(), [&](const auto& entry) {
+                        return entry.second.reportAddress == sender.value();
+                    });
+                    if (known && Directory::ReadScores(packet, receivedScores)) {
+                        for (const Directory::ScoreChange& change : receivedScores) {
+                            leaderboard.Apply(change);
+                        }
+                        scoreChanges += receivedScores.size();
+                    }
+                    else {
+                        LOG_MSG(debug, "Ignored score changes from " + sender.value().toString());
+                    }
+                }
+                else if (type == static_cast<uint8_t>(Directory::MessageType::LEADERBOARD_QUERY)) {
+                    HandleLeaderboardQuery(sender.value(), senderPort, nowMs);
+                }
+                else if (type == static_cast<uint8_t>(Directory::MessageType::CANDIDATES_QUERY)) {
+                    HandleCandidatesQuery(sender.value(), senderPort, nowMs);
+                }
+            }
+        }
+
+        const int64_t nowMs = GetCurrentTimestamp();
+        ExpireServers(nowMs);
+        if (nowMs - lastStatsReportMs >= STATS_REPORT_MS) {
+            ReportStats();
+            lastStatsReportMs = nowMs;
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in directory Update: " + std::string(e.what()), error);
+    }
+}
+
+void DirectoryService::Shutdown() {
+    if (!isRunning) return;
+    selector.clear();
+    socket.unbind();
+    servers.clear();
+    isRunning = false;
+}
+
+/**
+ * A report replaces everything known about the server, including the players
+ * assigned to it since the previous one (they are in its count by now, or
+ * never arrived).
+ */
+void DirectoryService::HandleReport(const Directory::LoadReport& report, const sf::IpAddress& sender, int64_t nowMs) {
+    const sf::IpAddress address = report.advertisedAddress != 0 ? sf::IpAddress(report.advertisedAddress) : sender;
+    const uint64_t key = ServerKey(address, report.gamePort);
+    auto it = servers.find(key);
+    if (it == servers.end()) {
+        it = servers.emplace(key, ServerEntry{ address, report.gamePort, 0, {}, 0, sender }).first;
+        LOG_MSG(info, "Server registered: " + address.toString() + ":" + std::to_string(report.gamePort) +
+            " (" + std::to_string(report.rooms.size()) + " rooms of " + std::to_string(report.maxPlayersPerRoom) + ")");
+    }
+
+    ServerEntry& server = it->second;
+    server.maxPlayersPerRoom = report.maxPlayersPerRoom;
+    server.lastReportMs = nowMs;
+    server.reportAddress = sender;
+    server.rooms.resize(report.rooms.size());
+    for (size_t i = 0; i < report.rooms.size(); ++i) {
+        server.rooms[i].players = report.rooms[i].players;
+        server.rooms[i].pending = 0;
+        server.rooms[i].headroomPercent = report.rooms[i].headroomPercent;
+    }
+}
+
+/**
+ * Ranks every room with a free slot: rooms with at least MIN_HEADROOM_PERCENT
+ * of their tick left first, then the emptiest (by share of capacity), then
+ * the most headroom. Players already sent to a room count towards it until
+ * its server reports again, so a burst of joins spreads out.
+ */
+bool DirectoryService::Assign(int64_t nowMs, Directory::Assignment& out) {
+    ServerEntry* bestServer = nullptr;
+    RoomRank best{};
+    for (auto& [key, server] : servers) {
+        RoomRank rank{};
+        if (RankBestRoom(server, nowMs, rank) && (!bestServer || IsBetter(rank, best))) {
+            bestServer = &server;
+            best = rank;
+        }
+    }
+
+    if (!bestServer) {
+        return false;
+    }
+    bestServer->rooms[best.room].pending++;
+    out.address = bestServer->address;
+    out.port = bestServer->port;
+    out.room = static_cast<uint16_t>(best.room);
+    return true;
+}
+
+void DirectoryService::ListCandidates(int64_t nowMs, std::vector<Directory::Assignment>& out) {
+    rankedServers.clear();
+    for (const auto& [key, server] : servers) {
+        RoomRank rank{};
+        if (RankBestRoom(server, nowMs, rank)) {
+            rankedServers.emplace_back(rank, &server);
+        }
+    }
+    const size_t count = std::min<size_t>(rankedServers.size(), Directory::MAX_CANDIDATES);
+    std::partial_sort(rankedServers.begin(), rankedServers.begin() + count, rankedServers.end(),
+        [](const auto& a, const auto& b) { return IsBetter(a.first, b.first); });
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        out[i].address = rankedServers[i].second->address;
+        out[i].port = rankedServers[i].second->port;
+        out[i].room = static_cast<uint16_t>(rankedServers[i].first.room);
+    }
+}
+
+bool DirectoryService::RankBestRoom(const ServerEntry& server, int64_t nowMs, RoomRank& out) const {
+    if (nowMs - server.lastReportMs > SERVER_TIMEOUT_MS || server.maxPlayersPerRoom == 0) {
+        return false;
+    }
+    bool found = false;
+    for (size_t i = 0; i < server.rooms.size(); ++i) {
+        const RoomEntry& room = server.rooms[i];
+        const uint32_t occupied = static_cast<uint32_t>(room.players) + room.pending;
+        if (occupied >= server.maxPlayersPerRoom) {
+            continue;
+        }
+        const RoomRank rank{ i, room.headroomPercent >= MIN_HEADROOM_PERCENT,
+            static_cast<double>(occupied) / server.maxPlayersPerRoom, room.headroomPercent };
+        if (!found || IsBetter(rank, out)) {
+            out = rank;
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool DirectoryService::IsBetter(const RoomRank& a, const RoomRank& b) {
+    return a.hasHeadroom != b.hasHeadroom ? a.hasHeadroom :
+        a.fill != b.fill ? a.fill < b.fill : a.headroomPercent > b.headroomPercent;
+}
+
+void DirectoryService::HandleQuery(const sf::IpAddress& sender, unsigned short senderPort, int64_t nowMs) {
+    uint16_t version = 0;
+    uint32_t requestId = 0;
+    if (!(packet >> version >> requestId) || version != Directory::PROTOCOL_VERSION) {
+        return;
+    }
+
+    sf::Packet reply;
+    Directory::Assignment assignment;
+    if (Assign(nowMs, assignment)) {
+        reply << static_cast<uint8_t>(Directory::MessageType::ASSIGNMENT) << requestId
+            << assignment.address.toInteger() << static_cast<uint16_t>(assignment.port) << assignment.room;
+        assignments++;
+    }
+    else {
+        reply << static_cast<uint8_t>(Directory::MessageType::NO_CAPACITY) << requestId;
+        refusals++;
+    }
+    SendReply(reply, sender, senderPort);
+}
+
+void DirectoryService::SendReply(sf::Packet& reply, const sf::IpAddress& sender, unsigned short senderPort) {
+    if (socket.send(reply, sender, senderPort) != sf::Socket::Status::Done) {
+        failedReplies++;
+    }
+}
+
+void DirectoryService::HandleLeaderboardQuery(const sf::IpAddress& sender, unsigned short senderPort, int64_t nowMs) {
+    uint16_t version = 0;
+    uint32_t requestId = 0;
+    if (!(packet >> version >> requestId) || version != Directory::PROTOCOL_VERSION) {
+        return;
+    }
+
+    const std::vector<Directory::LeaderboardEntry>& top = leaderboard.GetTop(nowMs);
+    sf::Packet reply;
+    reply << static_cast<uint8_t>(Directory::MessageType::LEADERBOARD) << requestId << static_cast<uint16_t>(top.size());
+    for (const Directory::LeaderboardEntry& entry : top) {
+        reply << entry.name << entry.score;
+    }
+    leaderboardQueries++;
+    SendReply(reply, sender, senderPort);
+}
+
+void DirectoryService::HandleCandidatesQuery(const sf::IpAddress& sender, unsigned short senderPort, int64_t nowMs) {
+    uint16_t version = 0;
+    uint32_t requestId = 0;
+    if (!(packet >> version >> requestId) || version != Directory::PROTOCOL_VERSION) {
+        return;
+    }
+
+    ListCandidates(nowMs, candidates);
+    sf::Packet reply;
+    reply << static_cast<uint8_t>(Directory::MessageType::CANDIDATES) << requestId << static_cast<uint8_t>(candidates.size());
+    for (const Directory::Assignment& candidate : candidates) {
+        reply << candidate.address.toInteger() << static_cast<uint16_t>(candidate.port) << candidate.room;
+    }
+    candidateQueries++;
+    SendReply(reply, sender, senderPort);
+}
+
+void DirectoryService::ExpireServers(int64_t nowMs) {
+    for (auto it = servers.begin(); it != servers.end();) {
+        if (nowMs - it->second.lastReportMs > SERVER_TIMEOUT_MS) {
+            LOG_MSG(warning, "Server " + it->second.address.toString() + ":" + std::to_string(it->second.port) +
+                " stopped reporting, removed");
+            it = servers.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void DirectoryService::ReportStats() {
+    LOG_MSG(info, "=== DIRECTORY STATS ===");
+    LOG_MSG(debug, "Servers: " + std::to_string(servers.size()) +
+        " - Assigned: " + std::to_string(assignments) + " - Refused: " + std::to_string(refusals) +
+        " - Candidate lists: " + std::to_string(candidateQueries) +
+        " - Failed replies: " + std::to_string(failedReplies));
+    for (const auto& [key, server] : servers) {
+        std::string rooms;
+        for (const RoomEntry& room : server.rooms) {
+            rooms += (rooms.empty() ? "" : ", ") + std::to_string(room.players + room.pending) + "/" +
+                std::to_string(server.maxPlayersPerRoom) + " (" + std::to_string(room.headroomPercent) + "% headroom)";
+        }
+        LOG_MSG(debug, server.address.toString() + ":" + std::to_string(server.port) + " - " + rooms);
+    }
+    const std::vector<Directory::LeaderboardEntry>& top = leaderboard.GetTop(GetCurrentTimestamp());
+    std::string leaders;
+    for (size_t i = 0; i < std::min<size_t>(top.size(), 3); ++i) {
+        leaders += (leaders.empty() ? "" : ", ") + top[i].name + " " + std::to_string(top[i].score);
+    }
+    LOG_MSG(debug, "Leaderboard: " + std::to_string(leaderboard.GetPlayerCount()) + " players - Score changes: " +
+        std::to_string(scoreChanges) + " - Queries: " + std::to_string(leaderboardQueries) +
+        (leaders.empty() ? "" : " - Top: " + leaders));
+    assignments = 0;
+    refusals = 0;
+    failedReplies = 0;
+    scoreChanges = 0;
+    leaderboardQueries = 0;
+    candidateQueries = 0;
+}
@@ -0,0 +1,249 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Directory of running game servers, for spreading players over several
+// server processes. Each server (single room or RoomServer) reports its rooms'
+// load every REPORT_INTERVAL_MS from its game socket; a client asks the
+// directory once before joining and is sent to the least-full room with free
+// capacity, preferring servers with tick-time headroom. Connected players are
+// never moved: placement happens when a session starts, so the load evens
+// out as sessions end and new ones begin.
+//
+// The directory also keeps the global leaderboard (see Leaderboard): every
+// SCORE_REPORT_INTERVAL_MS each server sends the score changes its rooms saw
+// since the last batch, summed per player, so no kill costs a network call.
+//
+// Datagrams (sf::Packet encoding, type byte first):
+//   REPORT      [uint16 version][uint32 advertisedAddress (0 = sender's)][uint16 gamePort]
+//               [uint32 maxPlayersPerRoom][uint16 roomCount] { [uint16 players][uint8 headroom %] }*
+//   QUERY       [uint16 version][uint32 requestId]
+//   ASSIGNMENT  [uint32 requestId][uint32 address][uint16 port][uint16 room]
+//   NO_CAPACITY [uint32 requestId]
+//   SCORES      [uint16 version][uint16 count] { [string name][int32 change] }*
+//   LEADERBOARD_QUERY [uint16 version][uint32 requestId]
+//   LEADERBOARD [uint32 requestId][uint16 count] { [string name][int64 score] }*   (best first)
+//   CANDIDATES_QUERY [uint16 version][uint32 requestId]
+//   CANDIDATES  [uint32 requestId][uint8 count] { [uint32 address][uint16 port][uint16 room] }*   (best first)
+//
+// CANDIDATES lists up to MAX_CANDIDATES servers with a free room, each with
+// its best room, for clients that pick by latency (see ServerProbe). Unlike
+// an ASSIGNMENT it reserves nothing: the chosen room shows in its server's
+// next report.
+namespace Directory {
+    constexpr unsigned short DEFAULT_PORT = 53100;
+    constexpr uint16_t PROTOCOL_VERSION = 1;
+    constexpr int64_t REPORT_INTERVAL_MS = 1000;
+    constexpr uint16_t MAX_REPORTED_ROOMS = 64;
+    constexpr int64_t SCORE_REPORT_INTERVAL_MS = 5000;
+    constexpr uint16_t MAX_SCORES_PER_DATAGRAM = 16;     // Names are at most 50 bytes: a full batch stays under 1 KB
+    constexpr uint8_t MAX_CANDIDATES = 8;
+
+    enum class MessageType : uint8_t {
+        REPORT = 1,
+        QUERY = 2,
+        ASSIGNMENT = 3,
+        NO_CAPACITY = 4,
+        SCORES = 5,
+        LEADERBOARD_QUERY = 6,
+        LEADERBOARD = 7,
+        CANDIDATES_QUERY = 8,
+        CANDIDATES = 9
+    };
+
+    struct RoomLoad {
+        uint16_t players = 0;
+        uint8_t headroomPercent = 100;  // Share of the tick budget left over
+    };
+
+    struct LoadReport {
+        uint32_t advertisedAddress = 0;     // sf::IpAddress::toInteger(), 0 = the address reports come from
+        unsigned short gamePort = 0;
+        uint32_t maxPlayersPerRoom = 0;
+        std::vector<RoomLoad> rooms;
+    };
+
+    struct Assignment {
+        sf::IpAddress address = sf::IpAddress::LocalHost;
+        unsigned short port = 0;
+        uint16_t room = 0;
+    };
+
+    // A player's score change since the last batch
+    struct ScoreChange {
+        std::string name;
+        int32_t change = 0;
+    };
+
+    struct LeaderboardEntry {
+        std::string name;
+        int64_t score = 0;
+    };
+
+    void WriteReport(sf::Packet& packet, const LoadReport& report);
+
+    // @param packet Positioned after the type byte
+    bool ReadReport(sf::Packet& packet, LoadReport& report);
+
+    // Writes up to MAX_SCORES_PER_DATAGRAM changes starting at first
+    // @return Index of the first change left for the next datagram
+    size_t WriteScores(sf::Packet& packet, const std::vector<ScoreChange>& changes, size_t first);
+
+    // @param packet Positioned after the type byte
+    bool ReadScores(sf::Packet& packet, std::vector<ScoreChange>& changes);
+
+    // Percent of the tick budget an average tick leaves unused (0 when over budget)
+    uint8_t ComputeHeadroom(double averageTickMs, unsigned int tickRateHz);
+
+    // "host[:port]", port defaulting to DEFAULT_PORT; resolves host names
+    bool ParseEndpoint(const std::string& text, sf::IpAddress& address, unsigned short& port);
+
+    // Client side: asks the directory for a room, retrying a few times
+    // (blocks for at most QUERY_ATTEMPTS * QUERY_TIMEOUT_MS)
+    // @return False if the directory did not answer or had no free room
+    constexpr int QUERY_ATTEMPTS = 4;
+    constexpr int QUERY_TIMEOUT_MS = 500;
+    bool FindServer(const sf::IpAddress& directory, unsigned short directoryPort, Assignment& out);
+
+    // Client side: asks the directory for the servers it could be placed on,
+    // best first, retrying like FindServer
+    // @return False if the directory did not answer or had no free room
+    bool FindCandidates(const sf::IpAddress& directory, unsigned short directoryPort, std::vector<Assignment>& out);
+
+    // Client side: asks the directory for the top of the global leaderboard,
+    // retrying like FindServer
+    bool FetchLeaderboard(const sf::IpAddress& directory, unsigned short directoryPort,
+        std::vector<LeaderboardEntry>& out);
+}
+
+// Global leaderboard built from the servers' batched score changes. Players
+// are told apart by name, the only identity that carries across rooms,
+// servers and sessions. Every player's total sits in a ranking kept ordered
+// as changes arrive, so a batch costs a logarithmic update per player; the
+// top entries readers get are a cached copy of the ranking's head, refreshed
+// at most every CACHE_REFRESH_MS, so a burst of queries never walks the ranking.
+class Leaderboard {
+public:
+    static constexpr size_t TOP_COUNT = 10;
+    static constexpr size_t MAX_PLAYERS = 100000;       // The lowest ranked are forgotten beyond
+    static constexpr int64_t CACHE_REFRESH_MS = 1000;
+
+    void Apply(const Directory::ScoreChange& change);
+
+    // Best TOP_COUNT players, best first
+    const std::vector<Directory::LeaderboardEntry>& GetTop(int64_t nowMs);
+
+    size_t GetPlayerCount() const { return totals.size(); }
+
+private:
+    // Highest score first, then by name; names point at the keys of totals
+    struct RankOrder {
+        bool operator()(const std::pair<int64_t, const std::string*>& a,
+            const std::pair<int64_t, const std::string*>& b) const {
+            return a.first != b.first ? a.first > b.first : *a.second < *b.second;
+        }
+    };
+
+    std::unordered_map<std::string, int64_t> totals;
+    std::set<std::pair<int64_t, const std::string*>, RankOrder> ranking;
+    std::vector<Directory::LeaderboardEntry> cachedTop;
+    int64_t cachedAtMs = 0;
+    bool changed = false;           // Since cachedTop was built
+};
+
+class DirectoryService {
+public:
+    static constexpr int64_t SERVER_TIMEOUT_MS = 3500;       // ~3 missed reports
+    static constexpr uint8_t MIN_HEADROOM_PERCENT = 15;      // Busier rooms only get players when nothing else can
+    static constexpr int SELECTOR_TIMEOUT_MS = 100;
+    static constexpr int64_t STATS_REPORT_MS = 10000;
+
+    explicit DirectoryService(unsigned short listenPort = Directory::DEFAULT_PORT);
+    ~DirectoryService();
+
+    DirectoryService(const DirectoryService&) = delete;
+    DirectoryService& operator=(const DirectoryService&) = delete;
+
+    bool Initialize();
+
+    // Handles pending reports and queries, waiting up to SELECTOR_TIMEOUT_MS for them
+    void Update();
+
+    void Shutdown();
+
+    bool IsRunning() const { return isRunning; }
+    size_t GetServerCount() const { return servers.size(); }
+
+    // Records a server's report; sender is used unless the report advertises an address
+    void HandleReport(const Directory::LoadReport& report, const sf::IpAddress& sender, int64_t nowMs);
+
+    // Picks a room for one new player and counts the player there until the
+    // server's next report
+    // @return False if no live server has a room with free capacity
+    bool Assign(int64_t nowMs, Directory::Assignment& out);
+
+    // Every live server with a free room, its best room each, ranked as
+    // Assign ranks rooms; at most Directory::MAX_CANDIDATES, nothing reserved
+    void ListCandidates(int64_t nowMs, std::vector<Directory::Assignment>& out);
+
+    Leaderboard& GetLeaderboard() { return leaderboard; }
+
+private:
+    struct RoomEntry {
+        uint16_t players;
+        uint16_t pending;       // Assigned since the last report
+        uint8_t headroomPercent;
+    };
+
+    // A room's standing in Assign's ranking
+    struct RoomRank {
+        size_t room;
+        bool hasHeadroom;
+        double fill;            // Share of capacity taken
+        uint8_t headroomPercent;
+    };
+
+    struct ServerEntry {
+        sf::IpAddress address;
+        unsigned short port;
+        uint32_t maxPlayersPerRoom;
+        std::vector<RoomEntry> rooms;
+        int64_t lastReportMs;
+        sf::IpAddress reportAddress;    // Reports come from here; so must its score changes
+    };
+
+    unsigned short port;
+    bool isRunning;
+    sf::UdpSocket socket;
+    sf::SocketSelector selector;
+    sf::Packet packet;                                  // Receive buffer, reused
+    std::unordered_map<uint64_t, ServerEntry> servers;  // Keyed by advertised endpoint
+    int64_t lastStatsReportMs;
+    uint64_t assignments;                               // Since the last stats report
+    uint64_t refusals;
+    uint64_t failedReplies;                             // Since the last stats report
+    Leaderboard leaderboard;
+    std::vector<Directory::ScoreChange> receivedScores;     // Reused per SCORES datagram
+    uint64_t scoreChanges;                                  // Since the last stats report
+    uint64_t leaderboardQueries;
+    uint64_t candidateQueries;
+    std::vector<Directory::Assignment> candidates;          // Reused per CANDIDATES_QUERY
+    std::vector<std::pair<RoomRank, const ServerEntry*>> rankedServers;
+
+    void HandleQuery(const sf::IpAddress& sender, unsigned short senderPort, int64_t nowMs);
+    void HandleLeaderboardQuery(const sf::IpAddress& sender, unsigned short senderPort, int64_t nowMs);
+    void HandleCandidatesQuery(const sf::IpAddress& sender, unsigned short senderPort, int64_t nowMs);
+    // Non-blocking: a reply that cannot go out now is covered by the client's
+    // retry, and only counted
+    void SendReply(sf::Packet& reply, const sf::IpAddress& sender, unsigned short senderPort);
+    // @return False if the server is silent or has no free room
+    bool RankBestRoom(const ServerEntry& server, int64_t nowMs, RoomRank& out) const;
+    static bool IsBetter(const RoomRank& a, const RoomRank& b);
+    void ExpireServers(int64_t nowMs);
+    void ReportStats();
+};
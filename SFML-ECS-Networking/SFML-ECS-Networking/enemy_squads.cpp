@@ -0,0 +1,60 @@
+#include "enemy_squads.h"
+#include <algorithm>
+
+/**
+ * Each enemy not yet in a squad leads a new one and takes the nearest
+ * unassigned enemies within SQUAD_RADIUS. Quadratic in the enemy count, which
+ * at one pass per REGROUP_SECONDS stays well below the per-tick AI cost.
+ */
+void EnemySquads::Form(const std::vector<Enemy>& enemies) {
+    squads.clear();
+    members.clear();
+    assigned.assign(enemies.size(), false);
+
+    const float radiusSq = SQUAD_RADIUS * SQUAD_RADIUS;
+    for (size_t leader = 0; leader < enemies.size(); ++leader) {
+        if (assigned[leader]) {
+            continue;
+        }
+        assigned[leader] = true;
+
+        candidates.clear();
+        for (size_t other = leader + 1; other < enemies.size(); ++other) {
+            if (assigned[other]) {
+                continue;
+            }
+            const sf::Vector2f offset = enemies[other].position - enemies[leader].position;
+            const float distanceSq = offset.x * offset.x + offset.y * offset.y;
+            if (distanceSq <= radiusSq) {
+                candidates.push_back({ distanceSq, other });
+            }
+        }
+        // Ties go to the lower ID, which is already the lower index
+        const size_t taken = std::min(candidates.size(), MAX_SQUAD_SIZE - 1);
+        std::partial_sort(candidates.begin(), candidates.begin() + taken, candidates.end());
+
+        squads.push_back({ members.size(), taken + 1 });
+        members.push_back(enemies[leader].enemyId);
+        for (size_t i = 0; i < taken; ++i) {
+            assigned[candidates[i].second] = true;
+            members.push_back(enemies[candidates[i].second].enemyId);
+        }
+    }
+}
+
+void EnemySquads::Clear() {
+    squads.clear();
+    members.clear();
+}
+
+sf::Vector2f EnemySquads::GetFormationOffset(size_t slot) {
+    // Beside and behind the leader in turn; larger squads than MAX_SQUAD_SIZE
+    // would stack on the last slot
+    static constexpr sf::Vector2f SLOTS[MAX_SQUAD_SIZE] = {
+        { 0.0f, 0.0f },
+        { FORMATION_SPACING, 0.0f },
+        { 0.0f, FORMATION_SPACING },
+        { FORMATION_SPACING, FORMATION_SPACING }
+    };
+    return SLOTS[std::min(slot, MAX_SQUAD_SIZE - 1)];
+}
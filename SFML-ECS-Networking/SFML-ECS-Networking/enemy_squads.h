@@ -0,0 +1,53 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Groups nearby enemies into squads so the expensive AI decisions (target
+// search, patrol waypoint, retreat spot) are made once per squad per
+// REGROUP_SECONDS instead of by every enemy. The lowest-ID enemy of a squad
+// leads and decides as a lone enemy would; GameServer hands the result to the
+// other members as orders (EnemyTank::SetSquadOrders), and they only steer:
+// to their formation slot around the leader's waypoint, to the squad's rally
+// point when retreating, at the squad's target when they have none.
+//
+// Squads are formed greedily in enemy ID order from positions alone, so the
+// same world always gives the same squads.
+class EnemySquads {
+public:
+    static constexpr float REGROUP_SECONDS = 0.5f;
+    static constexpr float SQUAD_RADIUS = 250.0f;       // Members within this of the leader
+    static constexpr size_t MAX_SQUAD_SIZE = 4;
+    static constexpr float FORMATION_SPACING = 70.0f;   // Slot distance from the leader's waypoint
+
+    struct Enemy {
+        uint32_t enemyId;
+        sf::Vector2f position;
+    };
+
+    // Members of one squad: GetMembers()[first, first + count), leader first
+    struct Squad {
+        size_t first;
+        size_t count;
+    };
+
+    // Replaces the squads with new ones over these enemies (sorted by ID)
+    void Form(const std::vector<Enemy>& enemies);
+    void Clear();
+
+    const std::vector<Squad>& GetSquads() const { return squads; }
+    // Enemy IDs grouped by squad
+    const std::vector<uint32_t>& GetMembers() const { return members; }
+
+    // Offset of a member's slot from the leader's waypoint (slot 0 is the leader)
+    static sf::Vector2f GetFormationOffset(size_t slot);
+
+private:
+    std::vector<Squad> squads;
+    std::vector<uint32_t> members;
+
+    // Scratch for Form
+    std::vector<bool> assigned;
+    std::vector<std::pair<float, size_t>> candidates;   // Squared distance, enemy index
+};
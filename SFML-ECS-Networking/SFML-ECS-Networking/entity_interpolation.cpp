@@ -1,344 +1,92 @@
 #include "entity_interpolation.h"
+#include "memory_report.h"
 #include "utils.h"
 #include <algorithm>
 #include <cmath>
 
-// EntityInterpolationBuffer Implementation
+namespace {
+    constexpr uint8_t MOVING_FORWARD = 1 << 0;
+    constexpr uint8_t MOVING_BACKWARD = 1 << 1;
+    constexpr uint8_t MOVING_LEFT = 1 << 2;
+    constexpr uint8_t MOVING_RIGHT = 1 << 3;
 
-EntityInterpolationBuffer::EntityInterpolationBuffer()
-    : wasLastStateExtrapolated(false), lastExtrapolationTime(0), cachedSearchIdx(0) {
-}
-
-EntityInterpolationBuffer::~EntityInterpolationBuffer() {
-    Clear();
-}
-
-void EntityInterpolationBuffer::AddSnapshot(const EntitySnapshot& snapshot) {
-    // Calculate velocity before adding snapshot
-    EntitySnapshot snapshotWithVelocity = snapshot;
-
-    if (!snapshots.empty()) {
-        // Find where this snapshot belongs chronologically
-        auto it = std::lower_bound(snapshots.begin(), snapshots.end(), snapshotWithVelocity,
-            [](const EntitySnapshot& a, const EntitySnapshot& b) {
-                return a.timestamp < b.timestamp;
-            });
-
-        // Calculate velocity from chronologically PREVIOUS snapshot (not just .back())
-        if (it != snapshots.begin()) {
-            const EntitySnapshot& prevSnapshot = *(it - 1);
-            snapshotWithVelocity.velocity = CalculateVelocity(prevSnapshot, snapshot);
-            snapshotWithVelocity.angularVelocity = CalculateAngularVelocity(prevSnapshot, snapshot);
-        }
-        else {
-            // This is the earliest snapshot chronologically
-            snapshotWithVelocity.velocity = sf::Vector2f(0.0f, 0.0f);
-            snapshotWithVelocity.angularVelocity = 0.0f;
-        }
-    }
-    else {
-        // First snapshot - no velocity data yet
-        snapshotWithVelocity.velocity = sf::Vector2f(0.0f, 0.0f);
-        snapshotWithVelocity.angularVelocity = 0.0f;
-    }
-
-    // Add snapshot to buffer in chronological order
-    if (snapshots.empty() || snapshotWithVelocity.timestamp >= snapshots.back().timestamp) {
-        snapshots.push_back(snapshotWithVelocity);
-    }
-    else {
-        // Find correct position to insert (maintain chronological order)
-        auto it = std::lower_bound(snapshots.begin(), snapshots.end(), snapshotWithVelocity,
-            [](const EntitySnapshot& a, const EntitySnapshot& b) {
-                return a.timestamp < b.timestamp;
-            });
+    const float MAX_TIME_GAP = 0.3f;                // Was 0.2f - more tolerant of gaps
+    const float MAX_VELOCITY = 500.0f;              // Was 300.0f
+    const float MAX_ANGULAR_VELOCITY = 1080.0f;     // Was 720.0f (3 rotations/sec instead of 2)
 
-        // Check for duplicate timestamp
-        if (it != snapshots.end() && it->timestamp == snapshotWithVelocity.timestamp) {
-            // Update existing snapshot instead of adding duplicate
-            *it = snapshotWithVelocity;
-        }
-        else {
-            snapshots.insert(it, snapshotWithVelocity);
-        }
-    }
-
-    // Enforce maximum buffer size (circular buffer behavior)
-    while (snapshots.size() > MAX_BUFFER_SIZE) {
-        snapshots.pop_front();
-        // Adjust cached index if we removed from front
-        if (cachedSearchIdx > 0) {
-            cachedSearchIdx--;
-        }
+    // Shortest rotation path, [-180, 180); branch-free so the batch loop vectorizes
+    inline float ShortestAngleDiff(float diff) {
+        return diff - 360.0f * std::floor(diff / 360.0f + 0.5f);
     }
-}
-
 
-bool EntityInterpolationBuffer::GetInterpolatedState(int64_t renderTime, InterpolatedState& outState) const {
-    if (snapshots.empty()) {
-        return false;  // No data at all
+    // [0, 360)
+    inline float NormalizeDegrees(float degrees) {
+        return degrees - 360.0f * std::floor(degrees / 360.0f);
     }
 
-    // Single snapshot - use it directly (no interpolation/extrapolation possible)
-    if (snapshots.size() < 2) {
-        const EntitySnapshot& latest = snapshots.back();
-        outState.position = latest.position;
-        outState.bodyRotation = latest.bodyRotation;
-        outState.barrelRotation = latest.barrelRotation;
-        outState.isMoving = latest.isMoving_forward || latest.isMoving_backward ||
-            latest.isMoving_left || latest.isMoving_right;
-        outState.wasExtrapolated = false;
-        return true;
+    // Smoothstep, the ease-in-out applied to angle interpolation
+    inline float SmoothT(float t) {
+        return t * t * (3.0f - 2.0f * t);
     }
 
-    // Get latest snapshot timestamp
-    int64_t latestTimestamp = snapshots.back().timestamp;
-
-    // CASE 1: Render time is AHEAD of latest snapshot (need EXTRAPOLATION)
-    if (renderTime > latestTimestamp) {
-        // We need to extrapolate forward
-        InterpolatedState extrapolatedState = Extrapolate(snapshots.back(), renderTime);
-
-        // If we were previously interpolating and now need to extrapolate,
-        // blend smoothly to avoid sudden jumps
-        if (!wasLastStateExtrapolated) {
-            // First frame of extrapolation - just use it directly
-            outState = extrapolatedState;
-            wasLastStateExtrapolated = true;
-            lastExtrapolationTime = renderTime;
-        }
-        else {
-            // Continue extrapolating
-            outState = extrapolatedState;
-        }
-
-        return true;
-    }
-
-    // CASE 2: Render time is WITHIN buffer range (normal INTERPOLATION)
-    EntitySnapshot before, after;
-    if (!FindSnapshotsForInterpolation(renderTime, before, after)) {
-        // Fallback to latest if search fails
-        const EntitySnapshot& latest = snapshots.back();
-        outState.position = latest.position;
-        outState.bodyRotation = latest.bodyRotation;
-        outState.barrelRotation = latest.barrelRotation;
-        outState.isMoving = latest.isMoving_forward || latest.isMoving_backward ||
-            latest.isMoving_left || latest.isMoving_right;
-        outState.wasExtrapolated = false;
-        wasLastStateExtrapolated = false;
-        return true;
-    }
-
-    // Calculate interpolation factor (t)
-    float t = 0.0f;
-    int64_t timeDiff = after.timestamp - before.timestamp;
-    if (timeDiff > 0) {
-        t = static_cast<float>(renderTime - before.timestamp) / static_cast<float>(timeDiff);
-    }
-
-    // Interpolate between the two snapshots
-    InterpolatedState interpolatedState = Interpolate(before, after, t);
-    interpolatedState.wasExtrapolated = false;
-
-    // CASE 3: Transition from EXTRAPOLATION back to INTERPOLATION (smooth blend)
-    if (wasLastStateExtrapolated) {
-        // Calculate blend factor based on time since extrapolation ended
-        int64_t timeSinceExtrapolation = renderTime - lastExtrapolationTime;
-        float blendFactor = static_cast<float>(timeSinceExtrapolation) / EXTRAPOLATION_BLEND_TIME_MS;
-        blendFactor = std::max(0.0f, std::min(1.0f, blendFactor));
-
-        if (blendFactor < 1.0f) {
-            // Blend from SAVED extrapolated state to interpolated state
-            outState = BlendExtrapolationToInterpolation(
-                lastExtrapolatedState, interpolatedState, blendFactor);
+    /**
+     * Linear velocity between two snapshots, zero across gaps too long or short
+     * to be meaningful and clamped to MAX_VELOCITY.
+     */
+    sf::Vector2f CalculateVelocity(int64_t olderTime, sf::Vector2f olderPos, int64_t newerTime, sf::Vector2f newerPos) {
+        if (newerTime <= olderTime) {
+            return sf::Vector2f(0.0f, 0.0f);
         }
-        else {
-            // Blend complete - use pure interpolation
-            outState = interpolatedState;
-            wasLastStateExtrapolated = false;
+        const float timeDiffSeconds = static_cast<float>(newerTime - olderTime) / 1000.0f;
+        if (timeDiffSeconds > MAX_TIME_GAP || timeDiffSeconds < 0.001f) {
+            return sf::Vector2f(0.0f, 0.0f);
         }
-    }
-    else {
-        // Normal interpolation (no blending needed)
-        outState = interpolatedState;
-    }
-
-    return true;
-}
-
-bool EntityInterpolationBuffer::GetLatestSnapshot(EntitySnapshot& outSnapshot) const {
-    if (snapshots.empty()) {
-        return false;
-    }
-
-    outSnapshot = snapshots.back();
-    return true;
-}
-
-void EntityInterpolationBuffer::Clear() {
-    snapshots.clear();
-}
-
-int64_t EntityInterpolationBuffer::GetOldestTimestamp() const {
-    if (snapshots.empty()) {
-        return 0;
-    }
-    return snapshots.front().timestamp;
-}
-
-int64_t EntityInterpolationBuffer::GetNewestTimestamp() const {
-    if (snapshots.empty()) {
-        return 0;
-    }
-    return snapshots.back().timestamp;
-}
 
-void EntityInterpolationBuffer::CleanupOldSnapshots(int64_t currentRenderTime) {
-    // Keep some safety margin (2x interpolation delay)
-    const int64_t SAFETY_MARGIN = INTERPOLATION_DELAY_MS * 2;
-    int64_t cutoffTime = currentRenderTime - SAFETY_MARGIN;
-
-    // FIX #7: Remove old snapshots, but always keep at least 2 for interpolation
-    while (snapshots.size() > 2 && snapshots.front().timestamp < cutoffTime) {
-        snapshots.pop_front();
-        // Adjust cached index when removing from front
-        if (cachedSearchIdx > 0) {
-            cachedSearchIdx--;
+        sf::Vector2f velocity = (newerPos - olderPos) / timeDiffSeconds;
+        const float velocityMagnitude = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+        if (velocityMagnitude > MAX_VELOCITY) {
+            velocity = velocity * (MAX_VELOCITY / velocityMagnitude);
         }
-    }
-}
-
-bool EntityInterpolationBuffer::FindSnapshotsForInterpolation(int64_t renderTime,
-    EntitySnapshot& outBefore, EntitySnapshot& outAfter) const {
-
-    // Find the two snapshots that bracket the render time
-    // We want: before.timestamp <= renderTime < after.timestamp
-
-    if (snapshots.size() < 2) {
-        return false;
+        return velocity;
     }
 
-    // PERFORMANCE OPTIMIZATION: Try cached position first (frame coherency)
-    // 95% of the time, renderTime advances monotonically, so we're near cachedSearchIdx
-    if (cachedSearchIdx < snapshots.size() - 1) {
-        if (snapshots[cachedSearchIdx].timestamp <= renderTime &&
-            renderTime < snapshots[cachedSearchIdx + 1].timestamp) {
-            // Cache hit! (most common case)
-            outBefore = snapshots[cachedSearchIdx];
-            outAfter = snapshots[cachedSearchIdx + 1];
-            return true;
+    /**
+     * Body rotation speed between two snapshots in degrees per second, along the
+     * shortest path and clamped to MAX_ANGULAR_VELOCITY.
+     */
+    float CalculateAngularVelocity(int64_t olderTime, float olderDeg, int64_t newerTime, float newerDeg) {
+        if (newerTime <= olderTime) {
+            return 0.0f;
         }
-    }
-
-    // Cache miss - search forward (renderTime advanced since last frame)
-    for (size_t i = cachedSearchIdx + 1; i < snapshots.size() - 1; ++i) {
-        if (snapshots[i].timestamp <= renderTime &&
-            renderTime < snapshots[i + 1].timestamp) {
-            cachedSearchIdx = i;
-            outBefore = snapshots[i];
-            outAfter = snapshots[i + 1];
-            return true;
+        const float timeDiffSeconds = static_cast<float>(newerTime - olderTime) / 1000.0f;
+        if (timeDiffSeconds > MAX_TIME_GAP || timeDiffSeconds < 0.001f) {
+            return 0.0f;
         }
-    }
 
-    // Search backward (rare: renderTime went backward or jitter)
-    for (int i = static_cast<int>(cachedSearchIdx) - 1; i >= 0 && i < static_cast<int>(snapshots.size()) - 1; --i) {
-        if (snapshots[i].timestamp <= renderTime &&
-            renderTime < snapshots[i + 1].timestamp) {
-            cachedSearchIdx = static_cast<size_t>(i);
-            outBefore = snapshots[i];
-            outAfter = snapshots[i + 1];
-            return true;
-        }
+        const float angularVelocity = ShortestAngleDiff(newerDeg - olderDeg) / timeDiffSeconds;
+        return std::max(-MAX_ANGULAR_VELOCITY, std::min(MAX_ANGULAR_VELOCITY, angularVelocity));
     }
-
-    // If render time is before all snapshots, DON'T extrapolate backward
-    if (renderTime < snapshots.front().timestamp) {
-        cachedSearchIdx = 0;
-        const EntitySnapshot& first = snapshots.front();
-        outBefore = first;
-        outAfter = first;  // Same snapshot = t will be 0 = no movement (clamped)
-        return true;
-    }
-
-    // If render time is after all snapshots, use last two (extrapolation will handle it)
-    if (renderTime >= snapshots.back().timestamp) {
-        cachedSearchIdx = snapshots.size() - 2;
-        outBefore = snapshots[snapshots.size() - 2];
-        outAfter = snapshots[snapshots.size() - 1];
-        return true;
-    }
-
-    // Shouldn't reach here, but fallback to last two snapshots
-    cachedSearchIdx = snapshots.size() - 2;
-    outBefore = snapshots[snapshots.size() - 2];
-    outAfter = snapshots[snapshots.size() - 1];
-    return true;
-}
-
-InterpolatedState EntityInterpolationBuffer::Interpolate(const EntitySnapshot& before,
-    const EntitySnapshot& after, float t) const {
-
-    // Clamp t to [0, 1] range to prevent extrapolation
-    t = std::max(0.0f, std::min(1.0f, t));
-
-    InterpolatedState result;
-
-    // Linear interpolation for position (LERP)
-    result.position.x = before.position.x + (after.position.x - before.position.x) * t;
-    result.position.y = before.position.y + (after.position.y - before.position.y) * t;
-
-    // Interpolate body rotation (handle 360 wrapping correctly)
-    result.bodyRotation = InterpolateAngle(before.bodyRotation, after.bodyRotation, t);
-
-    // CRITICAL: Interpolate barrel rotation independently from body rotation
-    result.barrelRotation = InterpolateAngle(before.barrelRotation, after.barrelRotation, t);
-
-    // Debug log (optional - comment out after testing)
-    Utils::printMsg("Interpolate: before barrel=" + std::to_string(before.barrelRotation.asDegrees()) + 
-        " after=" + std::to_string(after.barrelRotation.asDegrees()) + 
-        " result=" + std::to_string(result.barrelRotation.asDegrees()) + "", debug);
-
-    // Movement state (use "after" state for current movement indicators)
-    result.isMoving = after.isMoving_forward || after.isMoving_backward ||
-        after.isMoving_left || after.isMoving_right;
-
-    return result;
-}
-sf::Angle EntityInterpolationBuffer::InterpolateAngle(sf::Angle a, sf::Angle b, float t) const {
-    // Convert to degrees for easier math
-    float angleDegrees1 = a.asDegrees();
-    float angleDegrees2 = b.asDegrees();
-
-    // Calculate shortest path between angles
-    float diff = angleDegrees2 - angleDegrees1;
-
-    // Normalize difference to [-180, 180] range (shortest rotation path)
-    while (diff > 180.0f) diff -= 360.0f;
-    while (diff < -180.0f) diff += 360.0f;
-
-    // Apply smoothing - use ease-in-out cubic for smoother interpolation
-    float smoothT = t * t * (3.0f - 2.0f * t);  // Smoothstep function
-
-    // Interpolate along shortest path
-    float result = angleDegrees1 + diff * smoothT;  // Use smoothT instead of t
-
-    // Normalize result to [0, 360] range
-    while (result < 0.0f) result += 360.0f;
-    while (result >= 360.0f) result -= 360.0f;
-
-    return sf::degrees(result);
 }
 
 // InterpolationManager Implementation
 
 InterpolationManager::InterpolationManager()
     : renderTime(0),
-    interpolationDelay(EntityInterpolationBuffer::INTERPOLATION_DELAY_MS),
+    renderTimeRemainderMs(0.0f),
+    interpolationDelayMs(static_cast<float>(INTERPOLATION_DELAY_MS)),
     interpolationEnabled(true),
-    jitterAccumulator(0.0f),
-    lastSnapshotTime(0) {
+    lastSnapshotTime(0),
+    renderClockErrorMs(0.0f),
+    arrivalLateness(),
+    arrivalIntervals(),
+    arrivalLatenessCount(0),
+    nextArrivalLateness(0),
+    arrivalIntervalCount(0),
+    nextArrivalInterval(0),
+    lastArrivalSnapshotTime(0),
+    hasArrival(false),
+    targetDelayMs(INTERPOLATION_DELAY_MS),
+    arrivalJitterMs(0) {
 }
 
 InterpolationManager::~InterpolationManager() {
@@ -347,13 +95,15 @@ InterpolationManager::~InterpolationManager() {
 
 void InterpolationManager::Initialize(int64_t serverTime) {
     // Initialize render time to be (interpolationDelay) milliseconds behind server
-    renderTime = serverTime - interpolationDelay;
+    renderTime = serverTime - GetInterpolationDelay();
+    renderTimeRemainderMs = 0.0f;
+    renderClockErrorMs = 0.0f;
     lastSnapshotTime = serverTime;
 
     Utils::printMsg("Interpolation manager initialized with server time: " +
         std::to_string(serverTime) + " (render time: " +
         std::to_string(renderTime) + ", delay: " +
-        std::to_string(interpolationDelay) + "ms)", debug);
+        std::to_string(GetInterpolationDelay()) + "ms)", debug);
 }
 
 void InterpolationManager::Update(float deltaTime) {
@@ -362,301 +112,689 @@ void InterpolationManager::Update(float deltaTime) {
     }
 
     // Advance render time (this is our interpolation clock)
-    // Convert deltaTime from seconds to milliseconds
-    int64_t deltaTimeMs = static_cast<int64_t>(deltaTime * 1000.0f);
+    // Convert deltaTime from seconds to milliseconds, keeping the fraction so
+    // the clock does not fall behind real time (16.7 ms frames are not 16 ms).
+    // A growing delay holds the clock back by the growth, a shrinking one
+    // lets it run ahead; drift from the server clock is slewed out on top
+    const float frameMs = deltaTime * 1000.0f;
+    const float delayChangeMs = UpdateInterpolationDelay(frameMs);
+    const float maxSlewMs = CLOCK_SLEW_RATE * frameMs;
+    const float clockSlewMs = std::max(-maxSlewMs, std::min(maxSlewMs, renderClockErrorMs));
+    renderClockErrorMs = 0.0f;
+    const float elapsedMs = frameMs - delayChangeMs + clockSlewMs + renderTimeRemainderMs;
+    const int64_t deltaTimeMs = static_cast<int64_t>(std::floor(elapsedMs));
+    renderTimeRemainderMs = elapsedMs - static_cast<float>(deltaTimeMs);
     renderTime += deltaTimeMs;
 
     // Cleanup old snapshots from all entity buffers
-    for (auto& [entityId, buffer] : entityBuffers) {
-        buffer.CleanupOldSnapshots(renderTime);
+    for (uint32_t slot = 0; slot < entityIds.size(); ++slot) {
+        CleanupOldSnapshots(slot);
     }
 
-    // Optional: Update adaptive interpolation delay based on network conditions
-    UpdateInterpolationDelay(deltaTime);
-
     // Log statistics periodically (every 5 seconds)
     static float statsTimer = 0.0f;
     statsTimer += deltaTime;
     if (statsTimer >= 5.0f) {
-        size_t totalSnapshots = GetTotalSnapshotsBuffered();
-        Utils::printMsg("Interpolation:  ACTIVE " 
+        Utils::printMsg("Interpolation:  ACTIVE "
            " render time: " +
             std::to_string(renderTime) + ", delay: " +
-            std::to_string(interpolationDelay) + "ms", debug);
+            std::to_string(GetInterpolationDelay()) + "ms (target " +
+            std::to_string(targetDelayMs) + "ms, jitter " + std::to_string(arrivalJitterMs) + "ms)", debug);
         statsTimer = 0.0f;
     }
 }
 
-void InterpolationManager::AddEntitySnapshot(uint32_t entityId, const EntitySnapshot& snapshot) {
-    // Create buffer for entity if it doesn't exist
-    if (entityBuffers.find(entityId) == entityBuffers.end()) {
-        entityBuffers[entityId] = EntityInterpolationBuffer();
-        Utils::printMsg("Created interpolation buffer for entity " + std::to_string(entityId), debug);
+/**
+ * Appends a slot for a new entity: an empty ring plus its per-entity state.
+ * @return The new slot
+ */
+uint32_t InterpolationManager::AddSlot(uint32_t entityId) {
+    const uint32_t slot = static_cast<uint32_t>(entityIds.size());
+    entitySlots[entityId] = slot;
+    entityIds.push_back(entityId);
+    ringHead.push_back(0);
+    ringCount.push_back(0);
+    cachedSearch.push_back(0);
+    extrapolating.push_back(0);
+    extrapolationStart.push_back(0);
+    extrapolatedX.push_back(0.0f);
+    extrapolatedY.push_back(0.0f);
+    extrapolatedBodyDeg.push_back(0.0f);
+    extrapolatedBarrelDeg.push_back(0.0f);
+
+    const size_t ringEnd = entityIds.size() * MAX_BUFFER_SIZE;
+    snapshotTime.resize(ringEnd);
+    snapshotX.resize(ringEnd);
+    snapshotY.resize(ringEnd);
+    snapshotBodyDeg.resize(ringEnd);
+    snapshotBarrelDeg.resize(ringEnd);
+    snapshotVelocityX.resize(ringEnd);
+    snapshotVelocityY.resize(ringEnd);
+    snapshotAngularVelocity.resize(ringEnd);
+    snapshotMoving.resize(ringEnd);
+
+    Utils::printMsg("Created interpolation buffer for entity " + std::to_string(entityId), debug);
+    return slot;
+}
+
+void InterpolationManager::CopySnapshot(size_t from, size_t to) {
+    snapshotTime[to] = snapshotTime[from];
+    snapshotX[to] = snapshotX[from];
+    snapshotY[to] = snapshotY[from];
+    snapshotBodyDeg[to] = snapshotBodyDeg[from];
+    snapshotBarrelDeg[to] = snapshotBarrelDeg[from];
+    snapshotVelocityX[to] = snapshotVelocityX[from];
+    snapshotVelocityY[to] = snapshotVelocityY[from];
+    snapshotAngularVelocity[to] = snapshotAngularVelocity[from];
+    snapshotMoving[to] = snapshotMoving[from];
+}
+
+void InterpolationManager::DropOldest(uint32_t slot) {
+    ringHead[slot] = (ringHead[slot] + 1) & RING_MASK;
+    ringCount[slot]--;
+    // Keep the cached bracket on the same snapshot
+    if (cachedSearch[slot] > 0) {
+        cachedSearch[slot]--;
     }
+}
 
-    // Add snapshot to entity's buffer
-    entityBuffers[entityId].AddSnapshot(snapshot);
+/**
+ * Inserts a snapshot into the entity's ring in chronological order, with its
+ * velocity taken from the chronologically previous snapshot. A snapshot with
+ * the timestamp of a buffered one replaces it; a full ring drops its oldest.
+ * @param entityId Entity the snapshot belongs to (created on first use)
+ * @param snapshot Position, rotations and movement flags at snapshot.timestamp
+ */
+void InterpolationManager::AddEntitySnapshot(uint32_t entityId, const EntitySnapshot& snapshot) {
+    auto it = entitySlots.find(entityId);
+    const uint32_t slot = (it != entitySlots.end()) ? it->second : AddSlot(entityId);
+    const int64_t timestamp = snapshot.timestamp;
 
     // Update last snapshot time for adaptive delay adjustment
-    lastSnapshotTime = snapshot.timestamp;
+    lastSnapshotTime = timestamp;
+
+    // First buffered snapshot not older than this one
+    uint32_t lowerBound = 0;
+    uint32_t upper = ringCount[slot];
+    while (lowerBound < upper) {
+        const uint32_t middle = (lowerBound + upper) / 2;
+        if (snapshotTime[RingIndex(slot, middle)] < timestamp) {
+            lowerBound = middle + 1;
+        }
+        else {
+            upper = middle;
+        }
+    }
+
+    // Calculate velocity from chronologically PREVIOUS snapshot (not just the newest)
+    sf::Vector2f velocity(0.0f, 0.0f);
+    float angularVelocity = 0.0f;
+    if (lowerBound > 0) {
+        const size_t previous = RingIndex(slot, lowerBound - 1);
+        velocity = CalculateVelocity(snapshotTime[previous], sf::Vector2f(snapshotX[previous], snapshotY[previous]),
+            timestamp, snapshot.position);
+        angularVelocity = CalculateAngularVelocity(snapshotTime[previous], snapshotBodyDeg[previous],
+            timestamp, snapshot.bodyRotation.asDegrees());
+    }
+
+    const uint32_t count = ringCount[slot];
+    uint32_t position = lowerBound;
+    if (count == 0 || timestamp >= snapshotTime[RingIndex(slot, count - 1)]) {
+        position = count;   // Newest, the common case
+    }
+    if (position == count || snapshotTime[RingIndex(slot, position)] != timestamp) {
+        if (count == MAX_BUFFER_SIZE) {
+            if (position == 0) {
+                return;     // Older than everything in a full ring: it would be dropped at once
+            }
+            DropOldest(slot);
+            position--;
+        }
+        // Open a gap at position
+        for (uint32_t i = ringCount[slot]; i > position; --i) {
+            CopySnapshot(RingIndex(slot, i - 1), RingIndex(slot, i));
+        }
+        ringCount[slot]++;
+    }
+    // else: duplicate timestamp, update the existing snapshot in place
+
+    const size_t index = RingIndex(slot, position);
+    snapshotTime[index] = timestamp;
+    snapshotX[index] = snapshot.position.x;
+    snapshotY[index] = snapshot.position.y;
+    snapshotBodyDeg[index] = snapshot.bodyRotation.asDegrees();
+    snapshotBarrelDeg[index] = snapshot.barrelRotation.asDegrees();
+    snapshotVelocityX[index] = velocity.x;
+    snapshotVelocityY[index] = velocity.y;
+    snapshotAngularVelocity[index] = angularVelocity;
+    snapshotMoving[index] = (snapshot.isMoving_forward ? MOVING_FORWARD : 0) |
+        (snapshot.isMoving_backward ? MOVING_BACKWARD : 0) |
+        (snapshot.isMoving_left ? MOVING_LEFT : 0) |
+        (snapshot.isMoving_right ? MOVING_RIGHT : 0);
 }
 
-bool InterpolationManager::GetEntityState(uint32_t entityId, InterpolatedState& outState) const {
-    auto it = entityBuffers.find(entityId);
-    if (it == entityBuffers.end()) {
-        return false;
+void InterpolationManager::CleanupOldSnapshots(uint32_t slot) {
+    // Keep some safety margin (2x interpolation delay)
+    const int64_t cutoffTime = renderTime - INTERPOLATION_DELAY_MS * 2;
+
+    // FIX #7: Remove old snapshots, but always keep at least 2 for interpolation
+    while (ringCount[slot] > 2 && snapshotTime[RingIndex(slot, 0)] < cutoffTime) {
+        DropOldest(slot);
     }
+}
 
-    // If interpolation is disabled, return latest snapshot
-    if (!interpolationEnabled) {
-        EntitySnapshot latest;
-        if (it->second.GetLatestSnapshot(latest)) {
-            outState.position = latest.position;
-            outState.bodyRotation = latest.bodyRotation;
-            outState.barrelRotation = latest.barrelRotation;
-            outState.isMoving = latest.isMoving_forward || latest.isMoving_backward ||
-                latest.isMoving_left || latest.isMoving_right;
-            return true;
+/**
+ * Finds the two snapshots that bracket the render time
+ * (before.timestamp <= renderTime < after.timestamp), starting from the
+ * bracket found last frame. Needs at least two snapshots.
+ * @param outBefore Offset from the oldest snapshot of the earlier one
+ * @param outAfter Offset of the later one (equal to outBefore before the buffer starts)
+ */
+void InterpolationManager::FindBracket(uint32_t slot, uint32_t& outBefore, uint32_t& outAfter) {
+    const uint32_t count = ringCount[slot];
+    uint32_t& cached = cachedSearch[slot];
+    auto brackets = [&](uint32_t i) {
+        return snapshotTime[RingIndex(slot, i)] <= renderTime && renderTime < snapshotTime[RingIndex(slot, i + 1)];
+    };
+
+    // 95% of the time, renderTime advances monotonically, so we're near the cached bracket
+    if (cached < count - 1 && brackets(cached)) {
+        outBefore = cached;
+        outAfter = cached + 1;
+        return;
+    }
+
+    // Cache miss - search forward (renderTime advanced since last frame)
+    for (uint32_t i = cached + 1; i < count - 1; ++i) {
+        if (brackets(i)) {
+            cached = i;
+            outBefore = i;
+            outAfter = i + 1;
+            return;
+        }
+    }
+
+    // Search backward (rare: renderTime went backward or jitter)
+    for (uint32_t i = std::min(cached, count - 1); i-- > 0; ) {
+        if (brackets(i)) {
+            cached = i;
+            outBefore = i;
+            outAfter = i + 1;
+            return;
+        }
+    }
+
+    // If render time is before all snapshots, DON'T extrapolate backward
+    if (renderTime < snapshotTime[RingIndex(slot, 0)]) {
+        cached = 0;
+        outBefore = 0;
+        outAfter = 0;   // Same snapshot = no movement
+        return;
+    }
+
+    // After all snapshots: use the last two (extrapolation handles that case)
+    cached = count - 2;
+    outBefore = count - 2;
+    outAfter = count - 1;
+}
+
+void InterpolationManager::EvaluationScratch::Resize(size_t count) {
+    for (std::vector<float>* column : { &fromX, &fromY, &fromBody, &fromBarrel, &toX, &toY, &toBody, &toBarrel,
+        &t, &baseX, &baseY, &baseBody, &baseBarrel, &blend, &outX, &outY, &outBody, &outBarrel }) {
+        column->resize(count);
+    }
+    moving.resize(count);
+    extrapolated.resize(count);
+}
+
+/**
+ * Evaluates the entities in slots [firstSlot, firstSlot + count) at the render
+ * time into the scratch outputs, in three passes: a scalar pass picks each
+ * entity's two poses and factors (extrapolation becomes a lerp to the
+ * predicted pose), a branch-free pass does the lerp and angle wrapping for all
+ * of them, and a final pass keeps the extrapolated poses for blending back.
+ */
+void InterpolationManager::EvaluateSlots(uint32_t firstSlot, size_t count) {
+    EvaluationScratch& s = scratch;
+    s.Resize(count);
+
+    for (size_t k = 0; k < count; ++k) {
+        const uint32_t slot = firstSlot + static_cast<uint32_t>(k);
+        const uint32_t snapshots = ringCount[slot];
+        const size_t newest = RingIndex(slot, snapshots - 1);
+        s.baseX[k] = 0.0f;
+        s.baseY[k] = 0.0f;
+        s.baseBody[k] = 0.0f;
+        s.baseBarrel[k] = 0.0f;
+        s.blend[k] = 1.0f;      // 0 + (v - 0) * 1: the interpolated value unchanged
+        s.extrapolated[k] = 0;
+
+        size_t from = newest;
+        size_t to = newest;
+        s.t[k] = 0.0f;
+        if (!interpolationEnabled || snapshots < 2) {
+            // Latest snapshot directly (no interpolation/extrapolation possible)
+        }
+        else if (renderTime > snapshotTime[newest]) {
+            // Render time is AHEAD of latest snapshot: extrapolate, written as a lerp to the predicted pose
+            const int64_t extrapolationMs = std::min(renderTime - snapshotTime[newest], MAX_EXTRAPOLATION_TIME_MS);
+            const float seconds = static_cast<float>(extrapolationMs) / 1000.0f;
+            s.fromX[k] = snapshotX[newest];
+            s.fromY[k] = snapshotY[newest];
+            s.fromBody[k] = snapshotBodyDeg[newest];
+            s.fromBarrel[k] = snapshotBarrelDeg[newest];
+            s.toX[k] = snapshotX[newest] + snapshotVelocityX[newest] * seconds;
+            s.toY[k] = snapshotY[newest] + snapshotVelocityY[newest] * seconds;
+            s.toBody[k] = snapshotBodyDeg[newest] + snapshotAngularVelocity[newest] * seconds;
+            // Barrel is mouse-driven (client-authoritative), so it does NOT extrapolate
+            s.toBarrel[k] = snapshotBarrelDeg[newest];
+            s.t[k] = 1.0f;
+            s.moving[k] = snapshotMoving[newest];
+            s.extrapolated[k] = 1;
+            if (!extrapolating[slot]) {
+                extrapolating[slot] = 1;
+                extrapolationStart[slot] = renderTime;
+            }
+            continue;
+        }
+        else {
+            uint32_t before = 0;
+            uint32_t after = 0;
+            FindBracket(slot, before, after);
+            from = RingIndex(slot, before);
+            to = RingIndex(slot, after);
+            const int64_t timeDiff = snapshotTime[to] - snapshotTime[from];
+            if (timeDiff > 0) {
+                const float t = static_cast<float>(renderTime - snapshotTime[from]) / static_cast<float>(timeDiff);
+                s.t[k] = std::max(0.0f, std::min(1.0f, t));
+            }
+
+            // Back from extrapolating: blend from the SAVED extrapolated pose
+            if (extrapolating[slot]) {
+                const float blendFactor = std::max(0.0f, std::min(1.0f,
+                    static_cast<float>(renderTime - extrapolationStart[slot]) / EXTRAPOLATION_BLEND_TIME_MS));
+                if (blendFactor < 1.0f) {
+                    s.baseX[k] = extrapolatedX[slot];
+                    s.baseY[k] = extrapolatedY[slot];
+                    s.baseBody[k] = extrapolatedBodyDeg[slot];
+                    s.baseBarrel[k] = extrapolatedBarrelDeg[slot];
+                    s.blend[k] = blendFactor;
+                }
+                else {
+                    extrapolating[slot] = 0;
+                }
+            }
+        }
+        s.fromX[k] = snapshotX[from];
+        s.fromY[k] = snapshotY[from];
+        s.fromBody[k] = snapshotBodyDeg[from];
+        s.fromBarrel[k] = snapshotBarrelDeg[from];
+        s.toX[k] = snapshotX[to];
+        s.toY[k] = snapshotY[to];
+        s.toBody[k] = snapshotBodyDeg[to];
+        s.toBarrel[k] = snapshotBarrelDeg[to];
+        // Movement state from the later snapshot
+        s.moving[k] = snapshotMoving[to];
+    }
+
+    // Lerp positions, smoothstep angles along the shortest path, then blend; no branches
+    const float* fromX = s.fromX.data();
+    const float* fromY = s.fromY.data();
+    const float* fromBody = s.fromBody.data();
+    const float* fromBarrel = s.fromBarrel.data();
+    const float* toX = s.toX.data();
+    const float* toY = s.toY.data();
+    const float* toBody = s.toBody.data();
+    const float* toBarrel = s.toBarrel.data();
+    const float* factor = s.t.data();
+    const float* baseX = s.baseX.data();
+    const float* baseY = s.baseY.data();
+    const float* baseBody = s.baseBody.data();
+    const float* baseBarrel = s.baseBarrel.data();
+    const float* blend = s.blend.data();
+    float* outX = s.outX.data();
+    float* outY = s.outY.data();
+    float* outBody = s.outBody.data();
+    float* outBarrel = s.outBarrel.data();
+    for (size_t k = 0; k < count; ++k) {
+        const float t = factor[k];
+        const float angleT = SmoothT(t);
+        const float x = fromX[k] + (toX[k] - fromX[k]) * t;
+        const float y = fromY[k] + (toY[k] - fromY[k]) * t;
+        const float body = NormalizeDegrees(fromBody[k] + ShortestAngleDiff(toBody[k] - fromBody[k]) * angleT);
+        const float barrel = NormalizeDegrees(fromBarrel[k] + ShortestAngleDiff(toBarrel[k] - fromBarrel[k]) * angleT);
+
+        const float b = blend[k];
+        const float angleB = SmoothT(b);
+        outX[k] = baseX[k] + (x - baseX[k]) * b;
+        outY[k] = baseY[k] + (y - baseY[k]) * b;
+        outBody[k] = NormalizeDegrees(baseBody[k] + ShortestAngleDiff(body - baseBody[k]) * angleB);
+        outBarrel[k] = NormalizeDegrees(baseBarrel[k] + ShortestAngleDiff(barrel - baseBarrel[k]) * angleB);
+    }
+
+    // Save extrapolated poses for smooth blending
+    for (size_t k = 0; k < count; ++k) {
+        if (s.extrapolated[k]) {
+            const uint32_t slot = firstSlot + static_cast<uint32_t>(k);
+            extrapolatedX[slot] = outX[k];
+            extrapolatedY[slot] = outY[k];
+            extrapolatedBodyDeg[slot] = outBody[k];
+            extrapolatedBarrelDeg[slot] = outBarrel[k];
         }
+    }
+}
+
+InterpolatedState InterpolationManager::ScratchState(size_t index) const {
+    InterpolatedState state;
+    state.position = sf::Vector2f(scratch.outX[index], scratch.outY[index]);
+    state.bodyRotation = sf::degrees(scratch.outBody[index]);
+    state.barrelRotation = sf::degrees(scratch.outBarrel[index]);
+    state.isMoving = scratch.moving[index] != 0;
+    state.wasExtrapolated = scratch.extrapolated[index] != 0;
+    return state;
+}
+
+/**
+ * Interpolated (or extrapolated) state of one entity at the render time. With
+ * interpolation disabled this is the latest snapshot.
+ * @return False if the entity has no snapshots
+ */
+bool InterpolationManager::GetEntityState(uint32_t entityId, InterpolatedState& outState) {
+    auto it = entitySlots.find(entityId);
+    if (it == entitySlots.end()) {
         return false;
     }
+    EvaluateSlots(it->second, 1);
+    outState = ScratchState(0);
+    return true;
+}
+
+/**
+ * Batch form of GetEntityState: every entity at the render time in one pass.
+ * @param outStates Refilled with one state per entity, in no particular order
+ */
+void InterpolationManager::EvaluateAll(std::vector<EntityState>& outStates) {
+    const size_t count = entityIds.size();
+    EvaluateSlots(0, count);
+    outStates.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        outStates[k].entityId = entityIds[k];
+        outStates[k].state = ScratchState(k);
+    }
+}
 
-    // Get interpolated state at current render time
-    return it->second.GetInterpolatedState(renderTime, outState);
+bool InterpolationManager::IsRepeat(const EntitySnapshot& newest, const EntitySnapshot& snapshot) {
+    constexpr float ANGLE_EPSILON_DEG = 0.001f;
+    return snapshot.timestamp - newest.timestamp < REPEATED_STATE_MAX_AGE_MS &&
+        newest.position == snapshot.position &&
+        std::abs((newest.bodyRotation - snapshot.bodyRotation).asDegrees()) < ANGLE_EPSILON_DEG &&
+        std::abs((newest.barrelRotation - snapshot.barrelRotation).asDegrees()) < ANGLE_EPSILON_DEG &&
+        newest.isMoving_forward == snapshot.isMoving_forward &&
+        newest.isMoving_backward == snapshot.isMoving_backward &&
+        newest.isMoving_left == snapshot.isMoving_left &&
+        newest.isMoving_right == snapshot.isMoving_right;
+}
+
+/**
+ * Same velocities as AddEntitySnapshot and the same extrapolation as
+ * EvaluateAll: position and body rotation run on for at most
+ * MAX_EXTRAPOLATION_TIME_MS, the barrel stays put.
+ */
+EntitySnapshot InterpolationManager::Extrapolate(const EntitySnapshot* older, const EntitySnapshot& newest, int64_t time) {
+    EntitySnapshot predicted = newest;
+    if (!older || time <= newest.timestamp) {
+        return predicted;
+    }
+    const sf::Vector2f velocity = CalculateVelocity(older->timestamp, older->position,
+        newest.timestamp, newest.position);
+    const float angularVelocity = CalculateAngularVelocity(older->timestamp, older->bodyRotation.asDegrees(),
+        newest.timestamp, newest.bodyRotation.asDegrees());
+    const float seconds = static_cast<float>(std::min(time - newest.timestamp, MAX_EXTRAPOLATION_TIME_MS)) / 1000.0f;
+    predicted.timestamp = time;
+    predicted.position = newest.position + velocity * seconds;
+    predicted.bodyRotation = sf::degrees(newest.bodyRotation.asDegrees() + angularVelocity * seconds);
+    predicted.velocity = velocity;
+    predicted.angularVelocity = angularVelocity;
+    return predicted;
 }
 
 bool InterpolationManager::GetEntityLatestSnapshot(uint32_t entityId, EntitySnapshot& outSnapshot) const {
-    auto it = entityBuffers.find(entityId);
-    if (it == entityBuffers.end()) {
+    auto it = entitySlots.find(entityId);
+    if (it == entitySlots.end() || ringCount[it->second] == 0) {
         return false;
     }
 
-    return it->second.GetLatestSnapshot(outSnapshot);
+    const size_t newest = RingIndex(it->second, ringCount[it->second] - 1);
+    outSnapshot = EntitySnapshot(snapshotTime[newest], sf::Vector2f(snapshotX[newest], snapshotY[newest]),
+        sf::degrees(snapshotBodyDeg[newest]), sf::degrees(snapshotBarrelDeg[newest]));
+    outSnapshot.isMoving_forward = (snapshotMoving[newest] & MOVING_FORWARD) != 0;
+    outSnapshot.isMoving_backward = (snapshotMoving[newest] & MOVING_BACKWARD) != 0;
+    outSnapshot.isMoving_left = (snapshotMoving[newest] & MOVING_LEFT) != 0;
+    outSnapshot.isMoving_right = (snapshotMoving[newest] & MOVING_RIGHT) != 0;
+    outSnapshot.velocity = sf::Vector2f(snapshotVelocityX[newest], snapshotVelocityY[newest]);
+    outSnapshot.angularVelocity = snapshotAngularVelocity[newest];
+    return true;
 }
 
+/**
+ * Drops an entity's ring; the last slot moves into its place so the arrays
+ * stay dense.
+ */
 void InterpolationManager::RemoveEntity(uint32_t entityId) {
-    auto it = entityBuffers.find(entityId);
-    if (it != entityBuffers.end()) {
-        entityBuffers.erase(it);
-        Utils::printMsg("Removed interpolation buffer for entity " + std::to_string(entityId), debug);
+    auto it = entitySlots.find(entityId);
+    if (it == entitySlots.end()) {
+        return;
     }
+
+    const uint32_t slot = it->second;
+    const uint32_t last = static_cast<uint32_t>(entityIds.size() - 1);
+    entitySlots.erase(it);
+    if (slot != last) {
+        for (size_t i = 0; i < MAX_BUFFER_SIZE; ++i) {
+            CopySnapshot(static_cast<size_t>(last) * MAX_BUFFER_SIZE + i, static_cast<size_t>(slot) * MAX_BUFFER_SIZE + i);
+        }
+        entityIds[slot] = entityIds[last];
+        ringHead[slot] = ringHead[last];
+        ringCount[slot] = ringCount[last];
+        cachedSearch[slot] = cachedSearch[last];
+        extrapolating[slot] = extrapolating[last];
+        extrapolationStart[slot] = extrapolationStart[last];
+        extrapolatedX[slot] = extrapolatedX[last];
+        extrapolatedY[slot] = extrapolatedY[last];
+        extrapolatedBodyDeg[slot] = extrapolatedBodyDeg[last];
+        extrapolatedBarrelDeg[slot] = extrapolatedBarrelDeg[last];
+        entitySlots[entityIds[slot]] = slot;
+    }
+
+    entityIds.pop_back();
+    ringHead.pop_back();
+    ringCount.pop_back();
+    cachedSearch.pop_back();
+    extrapolating.pop_back();
+    extrapolationStart.pop_back();
+    extrapolatedX.pop_back();
+    extrapolatedY.pop_back();
+    extrapolatedBodyDeg.pop_back();
+    extrapolatedBarrelDeg.pop_back();
+
+    const size_t ringEnd = entityIds.size() * MAX_BUFFER_SIZE;
+    snapshotTime.resize(ringEnd);
+    snapshotX.resize(ringEnd);
+    snapshotY.resize(ringEnd);
+    snapshotBodyDeg.resize(ringEnd);
+    snapshotBarrelDeg.resize(ringEnd);
+    snapshotVelocityX.resize(ringEnd);
+    snapshotVelocityY.resize(ringEnd);
+    snapshotAngularVelocity.resize(ringEnd);
+    snapshotMoving.resize(ringEnd);
+
+    Utils::printMsg("Removed interpolation buffer for entity " + std::to_string(entityId), debug);
 }
 
 void InterpolationManager::Clear() {
-    entityBuffers.clear();
+    entitySlots.clear();
+    entityIds.clear();
+    ringHead.clear();
+    ringCount.clear();
+    cachedSearch.clear();
+    extrapolating.clear();
+    extrapolationStart.clear();
+    extrapolatedX.clear();
+    extrapolatedY.clear();
+    extrapolatedBodyDeg.clear();
+    extrapolatedBarrelDeg.clear();
+    snapshotTime.clear();
+    snapshotX.clear();
+    snapshotY.clear();
+    snapshotBodyDeg.clear();
+    snapshotBarrelDeg.clear();
+    snapshotVelocityX.clear();
+    snapshotVelocityY.clear();
+    snapshotAngularVelocity.clear();
+    snapshotMoving.clear();
     renderTime = 0;
+    renderTimeRemainderMs = 0.0f;
+    renderClockErrorMs = 0.0f;
     lastSnapshotTime = 0;
-    jitterAccumulator = 0.0f;
+    arrivalLatenessCount = 0;
+    nextArrivalLateness = 0;
+    arrivalIntervalCount = 0;
+    nextArrivalInterval = 0;
+    lastArrivalSnapshotTime = 0;
+    hasArrival = false;
+    arrivalJitterMs = 0;
 
     Utils::printMsg("Interpolation manager cleared", debug);
 }
 
 void InterpolationManager::SetInterpolationDelay(int64_t delayMs) {
     // Clamp to valid range
-    int64_t oldDelay = interpolationDelay;
-    interpolationDelay = std::max(EntityInterpolationBuffer::MIN_DELAY_MS,
-        std::min(EntityInterpolationBuffer::MAX_DELAY_MS, delayMs));
+    int64_t oldDelay = GetInterpolationDelay();
+    const int64_t newDelay = std::max(MIN_DELAY_MS, std::min(MAX_DELAY_MS, delayMs));
+    interpolationDelayMs = static_cast<float>(newDelay);
 
     // Adjust render time to maintain continuity
-    int64_t delayDiff = interpolationDelay - oldDelay;
+    int64_t delayDiff = newDelay - oldDelay;
     renderTime -= delayDiff;  // If delay increases, render time should go back
 
     Utils::printMsg("Interpolation delay changed from " + std::to_string(oldDelay) +
-        "ms to " + std::to_string(interpolationDelay) + "ms", debug);
+        "ms to " + std::to_string(newDelay) + "ms", debug);
 }
 
 size_t InterpolationManager::GetTotalSnapshotsBuffered() const {
     size_t total = 0;
-    for (const auto& [entityId, buffer] : entityBuffers) {
-        total += buffer.GetBufferSize();
+    for (uint32_t count : ringCount) {
+        total += count;
     }
     return total;
 }
 
+size_t InterpolationManager::GetApproximateBytes() const {
+    return sizeof(*this) +
+        MemoryReport::VectorBytes(snapshotTime, snapshotX, snapshotY, snapshotBodyDeg, snapshotBarrelDeg,
+            snapshotVelocityX, snapshotVelocityY, snapshotAngularVelocity, snapshotMoving) +
+        MemoryReport::MapBytes(entitySlots) +
+        MemoryReport::VectorBytes(entityIds, ringHead, ringCount, cachedSearch, extrapolating, extrapolationStart,
+            extrapolatedX, extrapolatedY, extrapolatedBodyDeg, extrapolatedBarrelDeg) +
+        MemoryReport::VectorBytes(scratch.fromX, scratch.fromY, scratch.fromBody, scratch.fromBarrel,
+            scratch.toX, scratch.toY, scratch.toBody, scratch.toBarrel, scratch.t,
+            scratch.baseX, scratch.baseY, scratch.baseBody, scratch.baseBarrel, scratch.blend,
+            scratch.outX, scratch.outY, scratch.outBody, scratch.outBarrel, scratch.moving, scratch.extrapolated);
+}
+
 void InterpolationManager::GetBufferInfo(std::vector<EntityBufferInfo>& outInfo) const {
     outInfo.clear();
-    outInfo.reserve(entityBuffers.size());
+    outInfo.reserve(entityIds.size());
 
-    for (const auto& [entityId, buffer] : entityBuffers) {
+    for (uint32_t slot = 0; slot < entityIds.size(); ++slot) {
         EntityBufferInfo info;
-        info.entityId = entityId;
-        info.snapshotCount = buffer.GetBufferSize();
-        info.oldestTimestamp = buffer.GetOldestTimestamp();
-        info.newestTimestamp = buffer.GetNewestTimestamp();
+        info.entityId = entityIds[slot];
+        info.snapshotCount = ringCount[slot];
+        info.oldestTimestamp = ringCount[slot] > 0 ? snapshotTime[RingIndex(slot, 0)] : 0;
+        info.newestTimestamp = ringCount[slot] > 0 ? snapshotTime[RingIndex(slot, ringCount[slot] - 1)] : 0;
         outInfo.push_back(info);
     }
 }
-sf::Vector2f EntityInterpolationBuffer::CalculateVelocity(const EntitySnapshot& older, const EntitySnapshot& newer) {
-    if (newer.timestamp <= older.timestamp) {
-        return sf::Vector2f(0.0f, 0.0f);
-    }
-
-    float timeDiffSeconds = static_cast<float>(newer.timestamp - older.timestamp) / 1000.0f;
-
-    const float MAX_TIME_GAP = 0.3f;  // Was 0.2f - more tolerant of gaps
-    if (timeDiffSeconds > MAX_TIME_GAP) {
-        return sf::Vector2f(0.0f, 0.0f);
-    }
-
-    if (timeDiffSeconds < 0.001f) {
-        return sf::Vector2f(0.0f, 0.0f);
+/**
+ * Records when a snapshot arrived. Render time runs at server time minus the
+ * delay, so a snapshot is usable once the delay exceeds how late it arrived;
+ * the render time reaches the newest snapshot's time one interval before the
+ * next one is due, so the delay is the ARRIVAL_PERCENTILE lateness plus one
+ * median interval.
+ * @param arrivalTime Arrival in ms on the synchronised server timeline
+ * @param snapshotTime The snapshot's server timestamp in ms
+ */
+void InterpolationManager::RecordSnapshotArrival(int64_t arrivalTime, int64_t snapshotTime) {
+    arrivalLateness[nextArrivalLateness] = arrivalTime - snapshotTime;
+    nextArrivalLateness = (nextArrivalLateness + 1) % ARRIVAL_HISTORY_SIZE;
+    arrivalLatenessCount = std::min(arrivalLatenessCount + 1, ARRIVAL_HISTORY_SIZE);
+    if (hasArrival && snapshotTime > lastArrivalSnapshotTime) {
+        arrivalIntervals[nextArrivalInterval] = snapshotTime - lastArrivalSnapshotTime;
+        nextArrivalInterval = (nextArrivalInterval + 1) % ARRIVAL_HISTORY_SIZE;
+        arrivalIntervalCount = std::min(arrivalIntervalCount + 1, ARRIVAL_HISTORY_SIZE);
+    }
+    if (!hasArrival || snapshotTime > lastArrivalSnapshotTime) {
+        lastArrivalSnapshotTime = snapshotTime;
+    }
+    hasArrival = true;
+    if (arrivalLatenessCount < MIN_ARRIVAL_SAMPLES || arrivalIntervalCount == 0) {
+        return;
     }
 
-    sf::Vector2f posDiff = newer.position - older.position;
-    sf::Vector2f velocity = posDiff / timeDiffSeconds;
-
-    const float MAX_VELOCITY = 500.0f;  // Was 300.0f
-    float velocityMagnitude = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+    std::array<int64_t, ARRIVAL_HISTORY_SIZE> sorted = arrivalIntervals;
+    std::sort(sorted.begin(), sorted.begin() + arrivalIntervalCount);
+    const int64_t medianInterval = sorted[arrivalIntervalCount / 2];
 
-    if (velocityMagnitude > MAX_VELOCITY) {
-        velocity = velocity * (MAX_VELOCITY / velocityMagnitude);
-    }
+    sorted = arrivalLateness;
+    std::sort(sorted.begin(), sorted.begin() + arrivalLatenessCount);
+    const size_t percentileIndex = static_cast<size_t>(ARRIVAL_PERCENTILE * static_cast<float>(arrivalLatenessCount - 1) + 0.5f);
+    const int64_t percentileLateness = sorted[percentileIndex];
 
-    return velocity;
+    arrivalJitterMs = percentileLateness - sorted[0];
+    targetDelayMs = std::max(MIN_DELAY_MS, std::min(MAX_DELAY_MS, percentileLateness + medianInterval));
 }
-float EntityInterpolationBuffer::CalculateAngularVelocity(const EntitySnapshot& older, const EntitySnapshot& newer) {
-    if (newer.timestamp <= older.timestamp) {
-        return 0.0f;
-    }
 
-    float timeDiffSeconds = static_cast<float>(newer.timestamp - older.timestamp) / 1000.0f;
-
-    const float MAX_TIME_GAP = 0.3f;  // Was 0.2f
-    if (timeDiffSeconds > MAX_TIME_GAP || timeDiffSeconds < 0.001f) {
-        return 0.0f;
+/**
+ * Measures how far the render clock is from serverTime - delay. Past
+ * CLOCK_STEP_MS (a clock resync, a long stall) it jumps; otherwise the next
+ * Update slews the error out at up to CLOCK_SLEW_RATE.
+ */
+void InterpolationManager::SyncRenderClock(int64_t serverTime) {
+    const float errorMs = static_cast<float>(serverTime - renderTime) - interpolationDelayMs - renderTimeRemainderMs;
+    if (std::abs(errorMs) > static_cast<float>(CLOCK_STEP_MS)) {
+        const int64_t stepMs = static_cast<int64_t>(std::floor(errorMs));
+        renderTime += stepMs;
+        renderClockErrorMs = errorMs - static_cast<float>(stepMs);
+        return;
     }
-
-    // Get rotation difference (handle 360 wrapping)
-    float angleDiff = newer.bodyRotation.asDegrees() - older.bodyRotation.asDegrees();
-
-    // Normalize to [-180, 180] (shortest path)
-    while (angleDiff > 180.0f) angleDiff -= 360.0f;
-    while (angleDiff < -180.0f) angleDiff += 360.0f;
-
-    // Angular velocity = angle difference / time
-    float angularVelocity = angleDiff / timeDiffSeconds;
-
-    const float MAX_ANGULAR_VELOCITY = 1080.0f;  // Was 720.0f (3 rotations/sec instead of 2)
-    angularVelocity = std::max(-MAX_ANGULAR_VELOCITY,
-        std::min(MAX_ANGULAR_VELOCITY, angularVelocity));
-
-    return angularVelocity;
+    renderClockErrorMs = errorMs;
 }
-InterpolatedState EntityInterpolationBuffer::Extrapolate(const EntitySnapshot& latest, int64_t renderTime) const {
-    InterpolatedState result;
-    result.wasExtrapolated = true;
-
-    // Calculate how far ahead we need to extrapolate
-    int64_t extrapolationTime = renderTime - latest.timestamp;  // in milliseconds
 
-    // Clamp extrapolation time to max limit (prevent infinite prediction)
-    if (extrapolationTime > MAX_EXTRAPOLATION_TIME_MS) {
-        extrapolationTime = MAX_EXTRAPOLATION_TIME_MS;
-    }
-
-    // If extrapolation time is negative or zero, just return latest state
-    if (extrapolationTime <= 0) {
-        result.position = latest.position;
-        result.bodyRotation = latest.bodyRotation;
-        result.barrelRotation = latest.barrelRotation;  // CRITICAL: Use snapshot's barrel
-        result.isMoving = latest.isMoving_forward || latest.isMoving_backward ||
-            latest.isMoving_left || latest.isMoving_right;
-        return result;
+float InterpolationManager::UpdateInterpolationDelay(float frameMs) {
+    if (arrivalLatenessCount < MIN_ARRIVAL_SAMPLES || arrivalIntervalCount == 0) {
+        return 0.0f;
     }
-
-    // Convert extrapolation time to seconds
-    float extrapolationSeconds = static_cast<float>(extrapolationTime) / 1000.0f;
-
-    // Extrapolate position using velocity: position = position + velocity * time
-    result.position = latest.position + latest.velocity * extrapolationSeconds;
-
-    // Extrapolate BODY rotation using angular velocity
-    float newBodyRotation = latest.bodyRotation.asDegrees() +
-        latest.angularVelocity * extrapolationSeconds;
-
-    // Normalize rotation to [0, 360]
-    while (newBodyRotation < 0.0f) newBodyRotation += 360.0f;
-    while (newBodyRotation >= 360.0f) newBodyRotation -= 360.0f;
-
-    result.bodyRotation = sf::degrees(newBodyRotation);
-
-    // CRITICAL: Barrel rotation does NOT extrapolate with body
-    // Barrel is mouse-driven (client-authoritative), so use latest snapshot value
-    result.barrelRotation = latest.barrelRotation;
-
-    // Movement state from latest snapshot
-    result.isMoving = latest.isMoving_forward || latest.isMoving_backward ||
-        latest.isMoving_left || latest.isMoving_right;
-
-    // Save this extrapolated state for smooth blending
-    lastExtrapolatedState = result;
-
-    return result;
-}
-InterpolatedState EntityInterpolationBuffer::BlendExtrapolationToInterpolation(
-    const InterpolatedState& extrapolated,
-    const InterpolatedState& interpolated,
-    float blendFactor) const {
-
-    // Clamp blend factor to [0, 1]
-    blendFactor = std::max(0.0f, std::min(1.0f, blendFactor));
-
-    InterpolatedState result;
-    result.wasExtrapolated = false;  // We're blending back to interpolation
-
-    // LERP position
-    result.position.x = extrapolated.position.x +
-        (interpolated.position.x - extrapolated.position.x) * blendFactor;
-    result.position.y = extrapolated.position.y +
-        (interpolated.position.y - extrapolated.position.y) * blendFactor;
-
-    // SLERP body rotation (shortest path)
-    result.bodyRotation = InterpolateAngle(extrapolated.bodyRotation,
-        interpolated.bodyRotation, blendFactor);
-
-    // CRITICAL FIX: Also blend barrel rotation
-    result.barrelRotation = InterpolateAngle(extrapolated.barrelRotation,
-        interpolated.barrelRotation, blendFactor);
-
-    // Use interpolated movement state
-    result.isMoving = interpolated.isMoving;
-
-    return result;
+    // Time-stretch the render clock rather than jumping it: growing fast stops
+    // extrapolation on a worsening link, shrinking slowly keeps motion even
+    const float difference = static_cast<float>(targetDelayMs) - interpolationDelayMs;
+    const float change = std::max(-DELAY_SHRINK_RATE * frameMs, std::min(DELAY_GROW_RATE * frameMs, difference));
+    interpolationDelayMs += change;
+    return change;
 }
 
-void InterpolationManager::UpdateInterpolationDelay(float deltaTime) {
-
-    /*
-    // Measure jitter from snapshots
-    if (lastSnapshotTime > 0) {
-        int64_t expectedTime = lastSnapshotTime + 33; // 30Hz = 33ms
-        int64_t actualTime = GetCurrentTimestamp();
-        int64_t jitter = std::abs(actualTime - expectedTime);
-
-        // Accumulate jitter over time
-        jitterAccumulator = jitterAccumulator * 0.95f + static_cast<float>(jitter) * 0.05f;
-
-        // Adjust delay based on accumulated jitter
-        if (jitterAccumulator < 20.0f) {
-            // Low jitter - can use shorter delay for more responsiveness
-            SetInterpolationDelay(50);
-        } else if (jitterAccumulator < 50.0f) {
-            // Medium jitter - use default delay
-            SetInterpolationDelay(100);
-        } else {
-            // High jitter - use longer delay for stability
-            SetInterpolationDelay(150);
-        }
-    }
-    */
-}
+/**
+ * Entities whose render time is past their newest snapshot, so the next
+ * evaluation extrapolates them.
+ */
 size_t InterpolationManager::GetExtrapolatedEntityCount() const {
+    if (!interpolationEnabled) {
+        return 0;
+    }
     size_t count = 0;
-    for (const auto& [entityId, buffer] : entityBuffers) {
-        InterpolatedState state;
-        if (buffer.GetInterpolatedState(renderTime, state) && state.wasExtrapolated) {
+    for (uint32_t slot = 0; slot < entityIds.size(); ++slot) {
+        if (ringCount[slot] >= 2 && renderTime > snapshotTime[RingIndex(slot, ringCount[slot] - 1)]) {
             count++;
         }
     }
     return count;
-}
\ No newline at end of file
+}
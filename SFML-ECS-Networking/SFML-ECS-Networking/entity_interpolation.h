@@ -2,7 +2,7 @@
 
 #include <SFML/System/Vector2.hpp>
 #include <SFML/System/Angle.hpp>
-#include <deque>
+#include <array>
 #include <cstdint>
 #include <unordered_map>
 #include <vector>
@@ -62,81 +62,10 @@ struct InterpolatedState {
 };
 
 
-// This class maintains a buffer of snapshots for a single entity and
-// provides methods to interpolate or extrapolate entity states between snapshots.
-
-
-class EntityInterpolationBuffer {
-public:
-    EntityInterpolationBuffer();
-    ~EntityInterpolationBuffer();
-
-    // Constants for buffer configuration and timing thresholds.
-    static constexpr size_t MAX_BUFFER_SIZE = 64;           // Max number of snapshots to store per entity.
-    static constexpr int64_t INTERPOLATION_DELAY_MS = 100;  // Default interpolation delay to smooth network jitter.
-    static constexpr int64_t MIN_DELAY_MS = 50;             // Minimum allowed delay for smoothing.
-    static constexpr int64_t MAX_DELAY_MS = 200;            // Maximum allowed delay before snapping.
-    static constexpr int64_t MAX_EXTRAPOLATION_TIME_MS = 100;   // Max time we allow extrapolation before freezing entity.
-    static constexpr int64_t EXTRAPOLATION_BLEND_TIME_MS = 200; // Blend window between extrapolated and interpolated state.
-
-    // Adds a new snapshot to the buffer (old ones are removed if limit reached).
-    void AddSnapshot(const EntitySnapshot& snapshot);
-
-    // Retrieves interpolated (or extrapolated) state for the given render time.
-    bool GetInterpolatedState(int64_t renderTime, InterpolatedState& outState) const;
-
-    // Gets the most recent snapshot stored in this buffer.
-    bool GetLatestSnapshot(EntitySnapshot& outSnapshot) const;
-
-    // Clears all stored snapshots.
-    void Clear();
-
-    // Utility accessors
-    size_t GetBufferSize() const { return snapshots.size(); }
-    bool IsEmpty() const { return snapshots.empty(); }
-    int64_t GetOldestTimestamp() const;
-    int64_t GetNewestTimestamp() const;
-
-    // Removes outdated snapshots that are no longer relevant to interpolation.
-    void CleanupOldSnapshots(int64_t currentRenderTime);
-
-private:
-    std::deque<EntitySnapshot> snapshots;   // Rolling buffer of recent snapshots.
-    mutable bool wasLastStateExtrapolated;  // Caches if last returned state was extrapolated.
-    mutable int64_t lastExtrapolationTime;  // Timestamp of last extrapolation.
-    mutable InterpolatedState lastExtrapolatedState; // Cached last extrapolated state.
-    mutable size_t cachedSearchIdx;         // Optimization: remembers last interpolation index.
-
-    // Internal helper: Finds two snapshots that bound the given render time.
-    bool FindSnapshotsForInterpolation(int64_t renderTime,
-        EntitySnapshot& outBefore, EntitySnapshot& outAfter) const;
-
-    // Internal helper: Interpolates between two snapshots.
-    InterpolatedState Interpolate(const EntitySnapshot& before,
-        const EntitySnapshot& after, float t) const;
-
-    // Smoothly interpolates two angles (handles wrapping around 360°).
-    sf::Angle InterpolateAngle(sf::Angle a, sf::Angle b, float t) const;
-
-    // Calculates linear velocity between two snapshots.
-    sf::Vector2f CalculateVelocity(const EntitySnapshot& older, const EntitySnapshot& newer);
-
-    // Calculates angular velocity between two snapshots.
-    float CalculateAngularVelocity(const EntitySnapshot& older, const EntitySnapshot& newer);
-
-    // Predicts (extrapolates) next state if renderTime > latest snapshot time.
-    InterpolatedState Extrapolate(const EntitySnapshot& latest, int64_t renderTime) const;
-
-    // Blends smoothly between extrapolated and interpolated state to avoid snapping.
-    InterpolatedState BlendExtrapolationToInterpolation(
-        const InterpolatedState& extrapolated,
-        const InterpolatedState& interpolated,
-        float blendFactor) const;
-};
-
 //
 // High-level manager that handles interpolation for *all* networked entities.
-// It keeps a buffer per entity and manages timing, interpolation delay, etc.
+// Snapshots live in one fixed-size ring per entity, laid out as parallel arrays
+// (time, x, y, angles, ...) so EvaluateAll can lerp every entity in one pass.
 //
 
 class InterpolationManager {
@@ -144,6 +73,21 @@ public:
     InterpolationManager();
     ~InterpolationManager();
 
+    // Constants for buffer configuration and timing thresholds.
+    static constexpr size_t MAX_BUFFER_SIZE = 64;           // Snapshots per entity ring (power of two).
+    static constexpr int64_t INTERPOLATION_DELAY_MS = 100;  // Default interpolation delay to smooth network jitter.
+    static constexpr int64_t MIN_DELAY_MS = 16;             // Floor for a jitter-free stream (one frame).
+    static constexpr int64_t MAX_DELAY_MS = 500;            // Ceiling; worse links extrapolate.
+    static constexpr size_t ARRIVAL_HISTORY_SIZE = 64;      // Arrival samples behind the jitter estimate.
+    static constexpr size_t MIN_ARRIVAL_SAMPLES = 8;        // Before this the delay stays as set.
+    static constexpr float ARRIVAL_PERCENTILE = 0.95f;      // Arrival lateness the delay must ride out.
+    static constexpr float DELAY_GROW_RATE = 0.25f;         // Render clock slows by up to 25% while the delay grows,
+    static constexpr float DELAY_SHRINK_RATE = 0.05f;       // and speeds up by up to 5% while it shrinks.
+    static constexpr float CLOCK_SLEW_RATE = 0.05f;         // Render clock runs up to 5% fast/slow to track server time,
+    static constexpr int64_t CLOCK_STEP_MS = 250;           // and jumps when it is further off than this.
+    static constexpr int64_t MAX_EXTRAPOLATION_TIME_MS = 100;   // Max time we allow extrapolation before freezing entity.
+    static constexpr int64_t EXTRAPOLATION_BLEND_TIME_MS = 200; // Blend window between extrapolated and interpolated state.
+
     // Initialize system with current server time reference.
     void Initialize(int64_t serverTime);
 
@@ -154,21 +98,56 @@ public:
     void AddEntitySnapshot(uint32_t entityId, const EntitySnapshot& snapshot);
 
     // Retrieves the interpolated (or extrapolated) state for rendering.
-    bool GetEntityState(uint32_t entityId, InterpolatedState& outState) const;
+    bool GetEntityState(uint32_t entityId, InterpolatedState& outState);
+
+    struct EntityState {
+        uint32_t entityId;
+        InterpolatedState state;
+    };
+
+    // Evaluates every entity at the current render time in one pass. outStates
+    // is refilled; keep it across frames so it stops allocating.
+    void EvaluateAll(std::vector<EntityState>& outStates);
 
     // Retrieves the latest snapshot for diagnostic or debug purposes.
     bool GetEntityLatestSnapshot(uint32_t entityId, EntitySnapshot& outSnapshot) const;
 
+    // The server repeats an entity's last state while it holds its updates
+    // back. A snapshot with the same pose and movement as the entity's newest,
+    // less than this after it, is not worth buffering: interpolation then runs
+    // straight to the next real update instead of stopping and jumping.
+    static constexpr int64_t REPEATED_STATE_MAX_AGE_MS = 100;
+    static bool IsRepeat(const EntitySnapshot& newest, const EntitySnapshot& snapshot);
+
+    // Pose EvaluateAll extrapolates to once render time passes the newest
+    // snapshot (older: the one before it, null if none). The server's dead
+    // reckoning predicts clients with it.
+    static EntitySnapshot Extrapolate(const EntitySnapshot* older, const EntitySnapshot& newest, int64_t time);
+
     // Removes an entity from the system (e.g., if destroyed or disconnected).
     void RemoveEntity(uint32_t entityId);
 
     // Clears all entity buffers.
     void Clear();
 
-    // Delay configuration getters/setters.
-    int64_t GetInterpolationDelay() const { return interpolationDelay; }
+    // Delay configuration getters/setters. SetInterpolationDelay jumps the
+    // render clock; the adaptive delay then eases it toward the target.
+    int64_t GetInterpolationDelay() const { return static_cast<int64_t>(interpolationDelayMs + 0.5f); }
     void SetInterpolationDelay(int64_t delayMs);
 
+    // Records a snapshot (world state) stamped snapshotTime arriving at
+    // arrivalTime, both on the server timeline; how late snapshots arrive
+    // sets the target delay
+    void RecordSnapshotArrival(int64_t arrivalTime, int64_t snapshotTime);
+    // ARRIVAL_PERCENTILE lateness plus one median snapshot interval
+    int64_t GetTargetInterpolationDelay() const { return targetDelayMs; }
+    // Percentile lateness minus the lowest (the link's base latency)
+    int64_t GetArrivalJitter() const { return arrivalJitterMs; }
+
+    // Steers the render clock toward serverTime - delay. Call before Update
+    // each frame with the synchronised server time; Update absorbs the error
+    void SyncRenderClock(int64_t serverTime);
+
     // Returns current render time (used to determine what snapshots to interpolate).
     int64_t GetRenderTime() const { return renderTime; }
 
@@ -177,9 +156,11 @@ public:
     bool IsInterpolationEnabled() const { return interpolationEnabled; }
 
     // Diagnostics and metrics
-    size_t GetEntityCount() const { return entityBuffers.size(); }
+    size_t GetEntityCount() const { return entityIds.size(); }
     size_t GetTotalSnapshotsBuffered() const;
     size_t GetExtrapolatedEntityCount() const;
+    // Snapshot rings, per-entity state and evaluation scratch (see MemoryReport)
+    size_t GetApproximateBytes() const;
 
     // Struct for debug info about each entity's buffer.
     struct EntityBufferInfo {
@@ -193,14 +174,79 @@ public:
     void GetBufferInfo(std::vector<EntityBufferInfo>& outInfo) const;
 
 private:
-    std::unordered_map<uint32_t, EntityInterpolationBuffer> entityBuffers; // All entity buffers keyed by entity ID.
+    static constexpr size_t RING_MASK = MAX_BUFFER_SIZE - 1;
+    static_assert((MAX_BUFFER_SIZE & RING_MASK) == 0, "MAX_BUFFER_SIZE must be a power of two");
+
+    // Snapshot rings: entity slot s owns [s * MAX_BUFFER_SIZE, (s + 1) * MAX_BUFFER_SIZE)
+    std::vector<int64_t> snapshotTime;
+    std::vector<float> snapshotX;
+    std::vector<float> snapshotY;
+    std::vector<float> snapshotBodyDeg;
+    std::vector<float> snapshotBarrelDeg;
+    std::vector<float> snapshotVelocityX;
+    std::vector<float> snapshotVelocityY;
+    std::vector<float> snapshotAngularVelocity;
+    std::vector<uint8_t> snapshotMoving;        // MOVING_* bits
+
+    // Per entity slot, dense (RemoveEntity swaps the last slot in)
+    std::unordered_map<uint32_t, uint32_t> entitySlots;
+    std::vector<uint32_t> entityIds;
+    std::vector<uint32_t> ringHead;             // Ring index of the oldest snapshot
+    std::vector<uint32_t> ringCount;
+    std::vector<uint32_t> cachedSearch;         // Bracket found last time, relative to the oldest
+    std::vector<uint8_t> extrapolating;         // Extrapolated since the last blend back completed
+    std::vector<int64_t> extrapolationStart;
+    std::vector<float> extrapolatedX;           // Last extrapolated pose, blended from on recovery
+    std::vector<float> extrapolatedY;
+    std::vector<float> extrapolatedBodyDeg;
+    std::vector<float> extrapolatedBarrelDeg;
+
+    // EvaluateSlots columns, one entry per evaluated entity
+    struct EvaluationScratch {
+        std::vector<float> fromX, fromY, fromBody, fromBarrel;
+        std::vector<float> toX, toY, toBody, toBarrel;
+        std::vector<float> t;
+        std::vector<float> baseX, baseY, baseBody, baseBarrel;  // Blend origin
+        std::vector<float> blend;                               // 1: no blend
+        std::vector<float> outX, outY, outBody, outBarrel;
+        std::vector<uint8_t> moving;
+        std::vector<uint8_t> extrapolated;
+        void Resize(size_t count);
+    } scratch;
 
     int64_t renderTime;             // Current time used for interpolation rendering.
-    int64_t interpolationDelay;     // Current interpolation delay (may adapt dynamically).
+    float renderTimeRemainderMs;    // Sub-millisecond part of the frame times, carried over.
+    float interpolationDelayMs;     // Current interpolation delay (adapts toward targetDelayMs).
     bool interpolationEnabled;      // Flag controlling interpolation behavior.
-    float jitterAccumulator;        // Accumulates timing adjustments to smooth jitter.
     int64_t lastSnapshotTime;       // Tracks last snapshot received time.
-
-    // Adjusts interpolation delay dynamically based on network jitter.
-    void UpdateInterpolationDelay(float deltaTime);
+    float renderClockErrorMs;       // Server time minus delay minus render time, at the last sync
+
+    // Lateness (arrival - snapshot time) of the last ARRIVAL_HISTORY_SIZE
+    // snapshots, and the server-side intervals between them
+    std::array<int64_t, ARRIVAL_HISTORY_SIZE> arrivalLateness;
+    std::array<int64_t, ARRIVAL_HISTORY_SIZE> arrivalIntervals;
+    size_t arrivalLatenessCount;
+    size_t nextArrivalLateness;
+    size_t arrivalIntervalCount;
+    size_t nextArrivalInterval;
+    int64_t lastArrivalSnapshotTime;
+    bool hasArrival;
+    int64_t targetDelayMs;
+    int64_t arrivalJitterMs;
+
+    size_t RingIndex(uint32_t slot, uint32_t offset) const {
+        return static_cast<size_t>(slot) * MAX_BUFFER_SIZE + ((ringHead[slot] + offset) & RING_MASK);
+    }
+    uint32_t AddSlot(uint32_t entityId);
+    void CopySnapshot(size_t from, size_t to);
+    void DropOldest(uint32_t slot);
+    void CleanupOldSnapshots(uint32_t slot);
+    void FindBracket(uint32_t slot, uint32_t& outBefore, uint32_t& outAfter);
+    // Fills the scratch outputs for slots [firstSlot, firstSlot + count) at the render time
+    void EvaluateSlots(uint32_t firstSlot, size_t count);
+    InterpolatedState ScratchState(size_t index) const;
+
+    // Moves the delay toward the target for a frame of frameMs; returns the
+    // change, which the render clock absorbs by advancing that much less
+    float UpdateInterpolationDelay(float frameMs);
 };
@@ -0,0 +1,176 @@
+#include "event_journal.h"
+#include "thread_tuning.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    constexpr char MAGIC[4] = { 'T', 'G', 'E', 'J' };
+    constexpr size_t HEADER_BYTES = sizeof(MAGIC) + 2 + 2 + 8;
+    constexpr size_t BATCH_EVENTS = 1024;
+
+    void Put(std::vector<uint8_t>& buffer, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void PutFloat(std::vector<uint8_t>& buffer, float value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        Put(buffer, bits, 4);
+    }
+
+    std::string RotatedPath(const std::string& path, uint32_t index) {
+        return index == 0 ? path : path + "." + std::to_string(index);
+    }
+}
+
+bool EventJournal::Open(const std::string& path, uint16_t tickRate, uint64_t maxFileBytes, uint32_t fileCount) {
+    Close();
+    this->path = path;
+    this->tickRate = tickRate;
+    this->maxFileBytes = std::max<uint64_t>(maxFileBytes, HEADER_BYTES + BATCH_EVENTS * RECORD_BYTES);
+    this->fileCount = std::max<uint32_t>(fileCount, 1);
+    if (std::ifstream(path).good()) {
+        Rotate();
+    }
+    else {
+        OpenFile();
+    }
+    if (!file.is_open()) {
+        Utils::printMsg("Error: Could not open event journal " + path, error);
+        return false;
+    }
+    batch.reserve(BATCH_EVENTS * RECORD_BYTES);
+    stopping = false;
+    recordedCount = 0;
+    droppedCount = 0;
+    try {
+        writer = std::thread(&EventJournal::Run, this);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Could not start event journal writer - " + std::string(e.what()), error);
+        file.close();
+        return false;
+    }
+    Utils::printMsg("Journaling gameplay events to " + path, success);
+    return true;
+}
+
+void EventJournal::Close() {
+    if (!writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stopRequested.notify_one();
+    writer.join();
+    file.close();
+    Utils::printMsg("Event journal closed: " + std::to_string(GetRecordedCount()) + " events, " +
+        std::to_string(GetDroppedCount()) + " dropped");
+}
+
+void EventJournal::Record(const Event& event) {
+    Event item = event;
+    if (queue.TryPush(item)) {
+        recordedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Writer loop: wakes every FLUSH_INTERVAL_MS and writes whatever the tick
+ * queued since, BATCH_EVENTS at a time. The queue holds several seconds of
+ * even a busy match, so the tick never has to wake it.
+ */
+void EventJournal::Run() {
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::WORKER);
+    while (true) {
+        bool stop = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stop = stopRequested.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS),
+                [this] { return stopping; });
+        }
+        try {
+            while (Drain() > 0) {
+                Write();
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in event journal writer: " + std::string(e.what()), error);
+        }
+        if (stop) {
+            return;
+        }
+    }
+}
+
+size_t EventJournal::Drain() {
+    batch.clear();
+    Event event;
+    size_t count = 0;
+    while (count < BATCH_EVENTS && queue.TryPop(event)) {
+        Put(batch, event.tick, 4);
+        Put(batch, static_cast<uint8_t>(event.type), 1);
+        Put(batch, event.detail, 1);
+        Put(batch, 0, 2);
+        Put(batch, event.subjectId, 4);
+        Put(batch, event.otherId, 4);
+        Put(batch, static_cast<uint32_t>(event.value), 4);
+        PutFloat(batch, event.x);
+        PutFloat(batch, event.y);
+        count++;
+    }
+    return count;
+}
+
+bool EventJournal::OpenFile() {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    const uint64_t openedAtMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+    Put(header, VERSION, 2);
+    Put(header, tickRate, 2);
+    Put(header, openedAtMs, 8);
+    file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    file.flush();
+    fileBytes = header.size();
+    return static_cast<bool>(file);
+}
+
+/**
+ * Shifts path.N to path.N+1, dropping the oldest, and starts a new file at path.
+ */
+void EventJournal::Rotate() {
+    file.close();
+    std::remove(RotatedPath(path, fileCount - 1).c_str());
+    for (uint32_t index = fileCount - 1; index > 0; --index) {
+        std::rename(RotatedPath(path, index - 1).c_str(), RotatedPath(path, index).c_str());
+    }
+    if (!OpenFile()) {
+        Utils::printMsg("Error: Could not start a new event journal file " + path, error);
+    }
+}
+
+void EventJournal::Write() {
+    if (fileBytes > HEADER_BYTES && fileBytes + batch.size() > maxFileBytes) {
+        Rotate();
+    }
+    if (!file.is_open()) {
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(batch.data()), static_cast<std::streamsize>(batch.size()));
+    file.flush();
+    fileBytes += batch.size();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_ring_buffer.h"
+
+// Structured journal of gameplay events for the analytics pipeline (see
+// GameServer::StartJournal): enemy spawns and kills, player deaths and
+// respawns, score changes. The tick only fills a fixed-size record and pushes
+// it onto a lock-free queue; a writer thread drains the queue in batches and
+// appends them to rotating files, so no formatting or I/O happens on the tick.
+//
+// Layout, all integers little-endian, floats as their bits:
+//   header:  "TGEJ" uint16 version, uint16 tickRate, uint64 openedAtMs (system clock)
+//   record:  uint32 tick, uint8 type, uint8 detail, uint16 reserved (0),
+//            uint32 subjectId, uint32 otherId, int32 value, float x, y   (28 bytes)
+// What detail, otherId and value hold depends on the type, see EventType.
+class EventJournal {
+public:
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t RECORD_BYTES = 28;
+    static constexpr uint64_t DEFAULT_FILE_BYTES = 16ull * 1024 * 1024;
+    static constexpr uint32_t DEFAULT_FILE_COUNT = 8;
+    static constexpr size_t QUEUE_CAPACITY = 8192;      // Events are dropped (and counted) beyond this
+    static constexpr int64_t FLUSH_INTERVAL_MS = 250;
+
+    enum class EventType : uint8_t {
+        ENEMY_SPAWNED = 1,      // subject: enemy, detail: enemy type
+        ENEMY_KILLED = 2,       // subject: enemy, other: shooter, detail: enemy type, value: score awarded
+        PLAYER_DIED = 3,        // subject: player, other: killer (0 = enemy), value: score lost
+        PLAYER_RESPAWNED = 4,   // subject: player
+        SCORE_CHANGED = 5       // subject: player, other: enemy killed (0 = death penalty), value: change
+    };
+
+    struct Event {
+        uint32_t tick = 0;
+        EventType type = EventType::ENEMY_SPAWNED;
+        uint8_t detail = 0;
+        uint32_t subjectId = 0;
+        uint32_t otherId = 0;
+        int32_t value = 0;
+        float x = 0.0f, y = 0.0f;
+    };
+
+    ~EventJournal() { Close(); }
+
+    // Starts the writer thread. A journal already at path is rotated out of
+    // the way first, so a restarted server never overwrites events. Rotation
+    // works as in PacketCapture: path.1 to path.N, fileCount files kept.
+    bool Open(const std::string& path, uint16_t tickRate,
+        uint64_t maxFileBytes = DEFAULT_FILE_BYTES, uint32_t fileCount = DEFAULT_FILE_COUNT);
+    // Writes what is queued and stops the writer
+    void Close();
+    bool IsOpen() const { return writer.joinable(); }
+
+    // One thread at a time (the tick's phases, see GameServer::BuildSimulationGraph).
+    // Never blocks, allocates or touches the disk.
+    void Record(const Event& event);
+
+    uint64_t GetRecordedCount() const { return recordedCount.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    std::string path;
+    uint16_t tickRate = 0;
+    uint64_t maxFileBytes = DEFAULT_FILE_BYTES;
+    uint32_t fileCount = DEFAULT_FILE_COUNT;
+
+    SpscRingBuffer<Event, QUEUE_CAPACITY> queue;
+    std::atomic<uint64_t> recordedCount{ 0 };
+    std::atomic<uint64_t> droppedCount{ 0 };
+
+    // Only for the writer's sleep between batches; Record never takes it
+    std::mutex mutex;
+    std::condition_variable stopRequested;
+    bool stopping = false;
+
+    // Writer thread only
+    std::thread writer;
+    std::ofstream file;
+    std::vector<uint8_t> batch;
+    uint64_t fileBytes = 0;
+
+    void Run();
+    // @return Events moved from the queue into batch
+    size_t Drain();
+    bool OpenFile();
+    void Rotate();
+    void Write();
+};
@@ -0,0 +1,136 @@
+#include "fragment_reassembler.h"
+#include <cstring>
+
+static_assert(PacketAggregator::MAX_FRAGMENTS <= 32, "receivedMask holds one bit per fragment");
+
+FragmentReassembler::FragmentReassembler()
+    : completedCount(0), expiredCount(0), malformedCount(0) {
+}
+
+/**
+ * Stores one fragment and returns the message once every fragment has arrived.
+ * Duplicates are ignored; fragments whose header disagrees with the set they
+ * claim to belong to are counted as malformed and dropped.
+ */
+bool FragmentReassembler::AddFragment(const sf::Packet& fragment, int64_t nowMs, sf::Packet& outMessage) {
+    ExpireStale(nowMs);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(fragment.getData());
+    const size_t readPosition = fragment.getReadPosition();
+    const size_t headerBytes = PacketAggregator::FRAGMENT_HEADER_BYTES - 1;  // Type byte already read
+    if (bytes == nullptr || fragment.getDataSize() < readPosition + headerBytes) {
+        malformedCount++;
+        return false;
+    }
+
+    const uint8_t* header = bytes + readPosition;
+    const uint16_t messageId = static_cast<uint16_t>((header[0] << 8) | header[1]);
+    const uint8_t index = header[2];
+    const uint8_t count = header[3];
+    const uint8_t* payload = header + headerBytes;
+    const size_t payloadBytes = fragment.getDataSize() - readPosition - headerBytes;
+
+    const bool isLast = index + 1 == count;
+    if (count < 2 || count > PacketAggregator::MAX_FRAGMENTS || index >= count || payloadBytes == 0 ||
+        payloadBytes > PacketAggregator::FRAGMENT_PAYLOAD_BYTES ||
+        (!isLast && payloadBytes != PacketAggregator::FRAGMENT_PAYLOAD_BYTES)) {
+        malformedCount++;
+        return false;
+    }
+
+    if (IsRecentlyCompleted(messageId, nowMs)) {
+        return false;
+    }
+
+    PendingMessage& message = FindOrStart(messageId, count, nowMs);
+    if (message.fragmentCount != count) {
+        malformedCount++;
+        return false;
+    }
+    const uint32_t bit = 1u << index;
+    if (message.receivedMask & bit) {
+        return false;
+    }
+
+    std::memcpy(message.data.data() + index * PacketAggregator::FRAGMENT_PAYLOAD_BYTES, payload, payloadBytes);
+    message.receivedMask |= bit;
+    message.receivedCount++;
+    if (isLast) {
+        message.lastFragmentBytes = payloadBytes;
+    }
+
+    if (message.receivedCount < message.fragmentCount) {
+        return false;
+    }
+
+    const size_t totalBytes = (message.fragmentCount - 1) * PacketAggregator::FRAGMENT_PAYLOAD_BYTES +
+        message.lastFragmentBytes;
+    outMessage.clear();
+    outMessage.append(message.data.data(), totalBytes);
+    message.inUse = false;
+    message.completed = true;
+    completedCount++;
+    return true;
+}
+
+void FragmentReassembler::Clear() {
+    for (PendingMessage& message : pending) {
+        message.inUse = false;
+        message.completed = false;
+    }
+}
+
+bool FragmentReassembler::IsRecentlyCompleted(uint16_t messageId, int64_t nowMs) const {
+    for (const PendingMessage& message : pending) {
+        if (message.completed && message.messageId == messageId &&
+            nowMs - message.firstFragmentTime <= TIMEOUT_MS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FragmentReassembler::ExpireStale(int64_t nowMs) {
+    for (PendingMessage& message : pending) {
+        if (message.inUse && nowMs - message.firstFragmentTime > TIMEOUT_MS) {
+            message.inUse = false;
+            expiredCount++;
+        }
+    }
+}
+
+/**
+ * Returns the set for messageId, starting one in a free slot (or over the
+ * oldest set) if this is its first fragment.
+ */
+FragmentReassembler::PendingMessage& FragmentReassembler::FindOrStart(uint16_t messageId,
+    uint8_t fragmentCount, int64_t nowMs) {
+    PendingMessage* slot = nullptr;
+    for (PendingMessage& message : pending) {
+        if (message.inUse && message.messageId == messageId) {
+            return message;
+        }
+        if (!message.inUse) {
+            if (!slot || slot->inUse) {
+                slot = &message;
+            }
+        }
+        else if (!slot || (slot->inUse && message.firstFragmentTime < slot->firstFragmentTime)) {
+            slot = &message;
+        }
+    }
+
+    if (slot->inUse) {
+        expiredCount++;
+    }
+    slot->inUse = true;
+    slot->completed = false;
+    slot->messageId = messageId;
+    slot->fragmentCount = fragmentCount;
+    slot->receivedCount = 0;
+    slot->receivedMask = 0;
+    slot->lastFragmentBytes = 0;
+    slot->firstFragmentTime = nowMs;
+    slot->data.resize(fragmentCount * PacketAggregator::FRAGMENT_PAYLOAD_BYTES);
+    return *slot;
+}
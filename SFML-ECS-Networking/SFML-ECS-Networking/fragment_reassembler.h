@@ -0,0 +1,57 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "packet_aggregator.h"
+
+// Rebuilds messages that PacketAggregator split into MESSAGE_FRAGMENT datagrams.
+// Only a few messages are assembled at once. A set that isn't complete within
+// TIMEOUT_MS is dropped: by then a newer snapshot is on its way, and waiting
+// for a stale one would only add latency.
+class FragmentReassembler {
+public:
+    static constexpr int64_t TIMEOUT_MS = 100;   // ~4 snapshot intervals
+    static constexpr size_t MAX_PENDING = 4;     // Oldest set is evicted beyond this
+
+    FragmentReassembler();
+
+    // @param fragment Packet positioned after the MESSAGE_FRAGMENT type byte
+    // @param nowMs Current time in milliseconds
+    // @param outMessage Receives the complete message (type byte first)
+    // @return True when this fragment completed a message
+    bool AddFragment(const sf::Packet& fragment, int64_t nowMs, sf::Packet& outMessage);
+
+    void Clear();
+
+    // Diagnostics
+    uint32_t GetCompletedCount() const { return completedCount; }
+    uint32_t GetExpiredCount() const { return expiredCount; }
+    uint32_t GetMalformedCount() const { return malformedCount; }
+
+private:
+    struct PendingMessage {
+        bool inUse;
+        bool completed;                  // Finished recently; late duplicates of it are ignored
+        uint16_t messageId;
+        uint8_t fragmentCount;
+        uint8_t receivedCount;
+        uint32_t receivedMask;           // Bit i set once fragment i arrived (MAX_FRAGMENTS <= 32)
+        size_t lastFragmentBytes;
+        int64_t firstFragmentTime;
+        std::vector<uint8_t> data;       // fragmentCount * FRAGMENT_PAYLOAD_BYTES, capacity reused
+
+        PendingMessage() : inUse(false), completed(false), messageId(0), fragmentCount(0), receivedCount(0),
+            receivedMask(0), lastFragmentBytes(0), firstFragmentTime(0) {
+        }
+    };
+
+    std::array<PendingMessage, MAX_PENDING> pending;
+    uint32_t completedCount;
+    uint32_t expiredCount;
+    uint32_t malformedCount;
+
+    void ExpireStale(int64_t nowMs);
+    bool IsRecentlyCompleted(uint16_t messageId, int64_t nowMs) const;
+    PendingMessage& FindOrStart(uint16_t messageId, uint8_t fragmentCount, int64_t nowMs);
+};
@@ -0,0 +1,59 @@
+#include "frame_pacer.h"
+#include "network_messages.h"
+#include "utils.h"
+#include <algorithm>
+
+FramePacer::FramePacer(float targetFps)
+    : intervalMicros(static_cast<int64_t>(1000000.0f / std::clamp(targetFps, MIN_FPS, MAX_FPS))) {
+}
+
+void FramePacer::Start() {
+    if (!waiter.Start(true)) {
+        Utils::printMsg("High-resolution waitable timer unavailable, pacing frames with 1 ms sleeps", warning);
+    }
+    nextPresentMicros = GetSteadyMicros() + intervalMicros;
+    workCount = 0;
+    workNext = 0;
+    Utils::printMsg("Low-latency frame pacing at " + std::to_string(1000000 / intervalMicros) + " Hz", debug);
+}
+
+/**
+ * A frame whose work already runs past its present time starts at once.
+ */
+void FramePacer::WaitForFrameStart() {
+    const int64_t startAt = nextPresentMicros - GetWorkEstimateMicros();
+    if (startAt > GetSteadyMicros()) {
+        waiter.WaitUntil(PreciseWaiter::Clock::time_point(std::chrono::microseconds(startAt)));
+    }
+    frameStartMicros = GetSteadyMicros();
+}
+
+void FramePacer::OnFramePresented() {
+    const int64_t now = GetSteadyMicros();
+    workMicros[workNext] = now - frameStartMicros;
+    workNext = (workNext + 1) % WORK_HISTORY;
+    workCount = std::min(workCount + 1, WORK_HISTORY);
+    lastPresentLateMicros = now - nextPresentMicros;
+
+    nextPresentMicros += intervalMicros;
+    while (nextPresentMicros <= now) {
+        nextPresentMicros += intervalMicros;
+        missedPresents++;
+    }
+}
+
+void FramePacer::Resume() {
+    nextPresentMicros = GetSteadyMicros() + intervalMicros;
+}
+
+/**
+ * Before any frame has run, a whole interval: the first frames start early
+ * rather than miss.
+ */
+int64_t FramePacer::GetWorkEstimateMicros() const {
+    if (workCount == 0) {
+        return intervalMicros;
+    }
+    const int64_t longest = *std::max_element(workMicros.begin(), workMicros.begin() + workCount);
+    return std::min(longest + SAFETY_MICROS, intervalMicros);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "precise_wait.h"
+
+// Low-latency frame pacing for the client, instead of vsync or
+// setFramerateLimit (which sleeps after the frame with the coarse OS timer,
+// so input read at the start of the next frame has aged by the sleep).
+// Presents are scheduled on a fixed cadence and the wait is moved to the
+// start of the frame: WaitForFrameStart returns as late as the recent frames'
+// work allows, so the input read after it is as fresh as possible when the
+// frame is shown. The work estimate is the longest frame (start to present)
+// among the last WORK_HISTORY, plus SAFETY_MICROS.
+// Vsync must be off; without it the present can tear.
+class FramePacer {
+public:
+    static constexpr float MIN_FPS = 30.0f;
+    static constexpr float MAX_FPS = 360.0f;
+    static constexpr int64_t SAFETY_MICROS = 1500;     // Between the expected end of the work and the present
+    static constexpr size_t WORK_HISTORY = 32;         // Frames
+
+    explicit FramePacer(float targetFps = 60.0f);
+
+    // Sets up precise waits and schedules the first present an interval from now
+    void Start();
+
+    // Blocks until this frame should start. Poll events and read input after it.
+    void WaitForFrameStart();
+    // Call right after the present: records the frame's work and schedules
+    // the next present, skipping any this frame ran past
+    void OnFramePresented();
+    // Call when presenting resumes after a pause (an unfocused or minimised
+    // window): schedules the next present an interval from now rather than
+    // counting the paused ones as missed
+    void Resume();
+
+    int64_t GetIntervalMicros() const { return intervalMicros; }
+    int64_t GetWorkEstimateMicros() const;
+    uint64_t GetMissedPresents() const { return missedPresents; }
+    // How far after its scheduled time the last present finished
+    int64_t GetLastPresentLateMicros() const { return lastPresentLateMicros; }
+
+private:
+    PreciseWaiter waiter;
+    int64_t intervalMicros;
+    int64_t nextPresentMicros = 0;      // Steady clock (GetSteadyMicros)
+    int64_t frameStartMicros = 0;
+    std::array<int64_t, WORK_HISTORY> workMicros{};
+    size_t workCount = 0;
+    size_t workNext = 0;
+    uint64_t missedPresents = 0;
+    int64_t lastPresentLateMicros = 0;
+};
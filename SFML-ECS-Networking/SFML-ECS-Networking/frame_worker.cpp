@@ -0,0 +1,78 @@
+#include "frame_worker.h"
+#include "thread_tuning.h"
+#include "trace_recorder.h"
+#include "utils.h"
+
+FrameWorker::FrameWorker(const char* name, std::function<void()> job)
+    : name(name), job(std::move(job)) {
+}
+
+FrameWorker::~FrameWorker() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void FrameWorker::Start() {
+    if (!thread.joinable() && !failed) {
+        try {
+            thread = std::thread(&FrameWorker::Run, this);
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg(std::string("Warning: Could not start the ") + name + " thread, running it inline - " + e.what(), warning);
+            failed = true;
+        }
+    }
+    if (!thread.joinable()) {
+        runInline = true;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        allocationScope = AllocationCounter::GetCurrentScope();
+        pending = true;
+    }
+    wake.notify_one();
+}
+
+void FrameWorker::Wait() {
+    if (runInline) {
+        runInline = false;
+        job();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return !pending; });
+}
+
+void FrameWorker::Run() {
+    TraceRecorder::SetThreadName(name);
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::WORKER);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return pending || stopping; });
+        if (stopping) {
+            return;
+        }
+        AllocationCounter::ScopeCounter* scope = allocationScope;
+        lock.unlock();
+        {
+            AllocationCounter::Scope allocations(scope);
+            try {
+                job();
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg(std::string("Exception in ") + name + ": " + e.what(), error);
+            }
+        }
+        lock.lock();
+        pending = false;
+        done.notify_one();
+    }
+}
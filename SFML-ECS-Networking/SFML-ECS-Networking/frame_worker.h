@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "allocation_counter.h"
+
+// One job per frame on a thread of its own, so the calling thread can do
+// other work while it runs: Start hands the job over, Wait blocks until it
+// has finished. Between the two the job owns whatever it writes. The thread
+// starts with the first Start; if it cannot, Wait runs the job on the caller.
+// Allocations the job makes count towards the scope open at Start, as for
+// JobSystem.
+class FrameWorker {
+public:
+    // name labels the thread in traces (a string literal)
+    FrameWorker(const char* name, std::function<void()> job);
+    ~FrameWorker();
+
+    FrameWorker(const FrameWorker&) = delete;
+    FrameWorker& operator=(const FrameWorker&) = delete;
+
+    void Start();
+    // Returns at once if nothing was started
+    void Wait();
+
+    bool IsThreaded() const { return thread.joinable(); }
+
+private:
+    const char* name;
+    std::function<void()> job;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool pending = false;           // Started, not yet finished
+    bool runInline = false;           // No thread: Wait runs the job
+    bool stopping = false;
+    bool failed = false;            // The thread could not be started; never retried
+    AllocationCounter::ScopeCounter* allocationScope = nullptr;
+
+    void Run();
+};
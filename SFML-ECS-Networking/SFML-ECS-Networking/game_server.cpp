@@ -1,24 +1,115 @@
 ﻿#include "game_server.h"
 #include "utils.h"
+#include "allocation_counter.h"
 #include <algorithm>
-#include <random>
+#include <numeric>
 #include <SFML/Network.hpp>
 #include "network_validation.h"
 #include "world_constants.h"
+#include "entity_interpolation.h"
+#include "tank_movement.h"
 #include <unordered_set>
-GameServer::GameServer(unsigned short port)
-    : serverPort(port), isRunning(false), nextPlayerId(1),
-    gameStateUpdateRate(0.022f), gameStateUpdateTimer(0),
-    clientTimeoutDuration(15.0f), outgoingSequenceNumber(0),
-    nextEnemyId(1000),
-    enemySpawnTimer(0),
-    enemySpawnInterval(5.0f),
-    randomGenerator(randomDevice()),
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+    // FNV-1a over raw bytes; floats hash by bit pattern, so any change shows
+    constexpr uint64_t FNV_OFFSET_BASIS = 1469598103934665603ull;
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    template <typename T>
+    void HashValue(uint64_t& hash, const T& value) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            hash = (hash ^ bytes[i]) * FNV_PRIME;
+        }
+    }
+
+    // State the simulation phases touch (see GameServer::BuildSimulationGraph)
+    namespace TickState {
+        constexpr TickGraph::ResourceSet PLAYERS = 1u << 0;        // clients' tanks, health and respawns
+        constexpr TickGraph::ResourceSet ENEMIES = 1u << 1;        // enemyRegistry, AI state, spawning
+        constexpr TickGraph::ResourceSet PROJECTILES = 1u << 2;
+        constexpr TickGraph::ResourceSet TIMERS = 1u << 3;         // Scheduling on the wheel (firedTimers is fixed)
+        constexpr TickGraph::ResourceSet TARGET_GRIDS = 1u << 4;   // targetGrid, spawnMap
+        constexpr TickGraph::ResourceSet LAG_HISTORY = 1u << 5;    // enemyPositionHistory
+        constexpr TickGraph::ResourceSet OUTGOING = 1u << 6;       // Client queues, sequence numbers, world snapshot
+        constexpr TickGraph::ResourceSet COUNTERS = 1u << 7;       // Stats counters
+        constexpr TickGraph::ResourceSet JOURNAL = 1u << 8;        // Event journal queue (one producer at a time)
+        constexpr TickGraph::ResourceSet ALL = ~0u;
+    }
+}
+
+GameServer::GameServer(unsigned short port, unsigned int tickRateHz)
+    : serverPort(port), isRunning(false), idle(false), tickScheduler(tickRateHz),
+    useNetworkThread(false), channel(nullptr), statsReportingEnabled(true), statsTimer(0),
+    useBatchedSocket(false), useSharedMemory(false), useSnapshotPipeline(false), sendFrame(nullptr),
+    useSendPacing(false),
+    reportedPipelineFrames(0), reportedPipelineMicros(0), nextEnemyId(1000), nextPlayerId(1),
+    sessionResumeGrace(DEFAULT_SESSION_RESUME_GRACE), resumedSessions(0),
     nextBulletId(10000),
     bulletUpdateRate(0.033f),
-    bulletUpdateTimer(0)
+    bulletUpdateTimer(0),
+    eventBulletReplication(false),
+    bulletCorrectionTimer(0),
+    clientBandwidth(0),
+    deferredEntityUpdates(0),
+    scheduledEntityHolds(0),
+    deadReckonedHolds(0),
+    deferredBulletUpdates(0),
+    lagCompensationEnabled(true),
+    rewoundHitTests(0),
+    rewoundHitTestMs(0),
+    rewoundHits(0),
+    outgoingSequenceNumber(0),
+    worldSnapshotPlayerTable(0), enemySetChanged(true), worldSnapshotRebuilds(0), dirtyEntityWrites(0),
+    snapshotBytesSent(0), fullSnapshotsSent(0), deltaSnapshotsSent(0), stateResyncs(0),
+    coalescedMessages(0), coalescedDatagrams(0), recoveredInputs(0), reliableResends(0),
+    compressionThreshold(0), compressedMessages(0), compressionBytesSaved(0),
+    challengesSent(0), tokenRejections(0),
+    bandwidthWindowStart(0),
+    metricsPort(0), metricsTimer(0),
+    directoryPort(0), directoryAdvertisedAddress(0), directoryReportTimer(0), scoreReporting(false), scoreReportTimer(0),
+    receivePathAllocations(0), reportedReceiveAllocations(0),
+    tickAllocations(0), reportedTickAllocations(0), reportedTickNumber(0),
+    randomSeed(0), randomSeedSet(false), keyframeInterval(DEFAULT_KEYFRAME_INTERVAL), keyframeTimer(0),
+    replayTick(nullptr), tickNumber(0),
+    checkpointInterval(DEFAULT_CHECKPOINT_INTERVAL), checkpointTimer(0),
+    handoffSocket(-1), handedOff(false),
+    gameStateUpdateRate(0.022f), gameStateUpdateTimer(0),
+    clientTimeoutDuration(15.0f), maxPlayers(NetworkValidation::MAX_PLAYER_COUNT),
+    playerTableVersion(0),
+    enemySpawnTimer(TimerWheel::INVALID_TIMER),
+    enemySpawnDue(false),
+    enemySpawnInterval(5.0f),
+    hordeSize(0),
+    enemySpawnsEnabled(true),
+    aiPlayerGrid(WorldConstants::WORLD_WIDTH, WorldConstants::WORLD_HEIGHT, AI_TARGET_GRID_CELL_SIZE),
+    flowFieldRebuilds(0),
+    enemyAILodEnabled(true),
+    reducedLodEnemies(0),
+    enemyAIBudgetUs(0),
+    aiRoundRobinCursor(0),
+    enemySquadsEnabled(false),
+    recordedOverloadLevel(0)
 {
-    availableColors = { "red", "blue", "green", "black" };
+    randomSeed = randomDevice();   // Until SetRandomSeed picks one
+    SetReplicationRates(replicationRates);
+
+    // Phases in one wave read the registry at the same time; their views
+    // must find the storage rather than create it
+    enemyRegistry.storage<ServerComponents::NetworkId>();
+    enemyRegistry.storage<ServerComponents::Transform>();
+    enemyRegistry.storage<ServerComponents::Health>();
+    // Tanks reaching cells no rebuild has used would otherwise allocate
+    // mid-tick. The AI grid holds players only, in few large cells, so each
+    // gets room for all of them
+    targetGrid.Reserve(GRID_CELL_RESERVE);
+    tankGrid.Reserve(GRID_CELL_RESERVE);
+    aiPlayerGrid.Reserve(NetworkValidation::MAX_PLAYER_COUNT);
+    firedTimers.reserve(FIRED_TIMER_RESERVE);
+    BuildSimulationGraph();
 }
 
 GameServer::~GameServer() {
@@ -26,9 +117,72 @@ GameServer::~GameServer() {
 }
 
 bool GameServer::Initialize() {
-    Utils::printMsg("Initializing game server on port " + std::to_string(serverPort) + "...");
+    LOG_MSG(info, "Initializing game server on port " + std::to_string(serverPort) + "...");
 
     try {
+        if (!handoffPath.empty()) {
+            RequestHandoff();
+        }
+        if (useSharedMemory) {
+            if (useNetworkThread || useBatchedSocket || useSnapshotPipeline || networkConditions.IsActive()) {
+                LOG_MSG(warning, "Shared memory transport replaces the socket; ignoring network thread, "
+                    "batched socket, snapshot pipeline and network conditions settings");
+            }
+            // No socket fallback: clients looking for the region would never find this server
+            auto transport = std::make_unique<SharedMemoryServer>();
+            if (!transport->Create(SharedMemoryTransport::NameForPort(serverPort))) {
+                Utils::printMsg("Failed to create the shared memory transport for port " + std::to_string(serverPort), error);
+                return false;
+            }
+            sharedMemory = std::move(transport);
+            isRunning = true;
+            outgoingSequenceNumber = 0;
+            ResetTimers();
+            ResumeMatch();
+            tickScheduler.Start();
+            bandwidthWindowStart = GetCurrentTimestamp();
+            LOG_MSG(success, "Game server initialized successfully (shared memory transport, no socket)");
+            StartMetricsExporter();
+            return true;
+        }
+        if (networkConditions.IsActive() && (useBatchedSocket || useNetworkThread)) {
+            LOG_MSG(warning, "Network conditions need simulation-thread socket I/O; "
+                "ignoring network thread/batched socket settings");
+            useBatchedSocket = false;
+            useNetworkThread = false;
+        }
+        if (useBatchedSocket || handoffSocket >= 0) {
+            if (!BatchedUdpSocket::IsSupported()) {
+                LOG_MSG(warning, "Batched socket syscalls are not available on this platform");
+            }
+            else {
+                auto batched = std::make_unique<BatchedUdpSocket>();
+                const int adoptedSocket = handoffSocket;
+                handoffSocket = -1;
+                if ((adoptedSocket >= 0 && batched->Adopt(adoptedSocket)) || batched->Bind(serverPort)) {
+                    if (useNetworkThread) {
+                        LOG_MSG(warning, "Batched socket replaces the network I/O thread");
+                    }
+                    if (useSnapshotPipeline) {
+                        LOG_MSG(warning, "Snapshot pipeline needs plain socket I/O; sending on the simulation thread");
+                    }
+                    batchedSocket = std::move(batched);
+                    isRunning = true;
+                    outgoingSequenceNumber = 0;
+                    ResetTimers();
+                    ResumeMatch();
+                    tickScheduler.Start();
+                    bandwidthWindowStart = GetCurrentTimestamp();
+                    LOG_MSG(success, "Game server initialized successfully (batched socket I/O, " +
+                        std::to_string(BatchedUdpSocket::BATCH_SIZE) + " datagrams per call)");
+                    LOG_MSG(info, "Server listening on port " + std::to_string(batchedSocket->GetLocalPort()));
+                    StartMetricsExporter();
+                    return true;
+                }
+                LOG_MSG(warning, "Falling back to sf::UdpSocket");
+            }
+        }
+
         sf::Socket::Status bindStatus = socket.bind(serverPort);
 
         if (bindStatus != sf::Socket::Status::Done) {
@@ -39,10 +193,45 @@ bool GameServer::Initialize() {
         }
 
         socket.setBlocking(false);
+        idleSelector.add(socket);
         isRunning = true;
         outgoingSequenceNumber = 0;
-        Utils::printMsg("Game server initialized successfully", success);
-        Utils::printMsg("Server listening on port " + std::to_string(socket.getLocalPort()));
+        if (networkConditions.IsActive()) {
+            conditioner = std::make_unique<NetworkConditioner>(networkConditions);
+            LOG_MSG(warning, "Simulating network conditions: " + networkConditions.Describe());
+        }
+        if (useNetworkThread) {
+            networkThread = std::make_unique<NetworkIOThread>(socket);
+            networkThread->SetRateLimiter(&ingressLimiter);   // The I/O thread owns it from here on
+            networkThread->SetValidator(&ingressValidator);   // ...and this
+            if (networkThread->Start()) {
+                channel = &networkThread->GetChannel();
+            }
+            else {
+                LOG_MSG(warning, "Falling back to simulation-thread socket I/O");
+                networkThread.reset();
+            }
+        }
+        if (useSnapshotPipeline) {
+            if (channel || conditioner) {
+                LOG_MSG(warning, "Snapshot pipeline needs plain socket I/O; sending on the simulation thread");
+            }
+            else {
+                auto pipeline = std::make_unique<SnapshotPipeline>(socket);
+                pipeline->SetCompressionThreshold(compressionThreshold);
+                pipeline->SetCapture(capture.get());
+                if (pipeline->Start()) {
+                    snapshotPipeline = std::move(pipeline);
+                }
+            }
+        }
+        ResetTimers();
+        ResumeMatch();
+        tickScheduler.Start();
+        bandwidthWindowStart = GetCurrentTimestamp();
+        LOG_MSG(success, "Game server initialized successfully");
+        LOG_MSG(info, "Server listening on port " + std::to_string(socket.getLocalPort()));
+        StartMetricsExporter();
 
         return true;
     }
@@ -58,39 +247,145 @@ bool GameServer::Initialize() {
     }
 }
 
+/**
+ * Starts the world without a socket of its own. Datagrams for this world arrive
+ * on hostChannel and replies are queued back on it; the host thread owns the
+ * socket and must outlive this server.
+ */
+bool GameServer::InitializeHosted(DatagramChannel& hostChannel) {
+    if (isRunning) {
+        LOG_MSG(warning, "Server already running");
+        return false;
+    }
+    if (useNetworkThread || useBatchedSocket || useSharedMemory) {
+        LOG_MSG(warning, "Hosted server ignores network thread/batched socket/shared memory settings");
+    }
+
+    channel = &hostChannel;
+    isRunning = true;
+    outgoingSequenceNumber = 0;
+    statsTimer = 0;
+    ResetTimers();
+    tickScheduler.Start();
+    bandwidthWindowStart = GetCurrentTimestamp();
+    return true;
+}
+
 void GameServer::Update(float deltaTime) {
     if (!isRunning) return;
+    const int64_t traceBeginMicros = TraceRecorder::IsEnabled() ? TraceRecorder::NowMicros() : -1;
+
+    // One clock read per tick. A replay has already begun the tick at the
+    // recorded time; a recording keeps whole milliseconds, which is what it stores.
+    if (!replayTick) {
+        const int64_t nowMicros = GetSteadyMicros();
+        tickClock.BeginTick(tickNumber, recorder ? nowMicros / 1000 * 1000 : nowMicros);
+    }
+    AdvanceTimers();
+    if (recorder) {
+        recorder->BeginTick(tickNumber, tickClock.GetServerMs(), deltaTime);
+        if (overload.GetLevel() != recordedOverloadLevel) {
+            recordedOverloadLevel = overload.GetLevel();
+            recorder->RecordOverloadLevel(recordedOverloadLevel);
+        }
+    }
+    if (replayTick && replayTick->overloadLevel != overload.GetLevel()) {
+        overload.SetLevel(replayTick->overloadLevel);
+        ApplyOverloadLevel();
+    }
 
     try {
-        ProcessIncomingMessages();
-        SimulatePlayerMovement(deltaTime);
-        UpdateEnemies(deltaTime);
-        UpdateBullets(deltaTime);
-        CheckServerSideCollisions(deltaTime);
-        CheckPlayerDeaths();
-        UpdateDeadPlayers(deltaTime);
+        const uint64_t tickAllocationsBefore = AllocationCounter::GetCount();
+        {
+            // Allocations outside the profiled phases (see TickProfiler)
+            AllocationCounter::Scope tickScope(tickProfiler.GetOtherAllocationCounter());
+            {
+                PROFILE_TICK_PHASE(tickProfiler, TickPhase::RECEIVE);
+                const uint64_t allocationsBefore = AllocationCounter::GetCount();
+                ProcessIncomingMessages();
+                receivePathAllocations += AllocationCounter::GetCount() - allocationsBefore;
+            }
+            simulationGraph.Run(deltaTime, enemyJobs.get());
 
-        gameStateUpdateTimer += deltaTime;
-        bulletUpdateTimer += deltaTime;
+            if (snapshotPipeline) {
+                BeginSendFrame();
+            }
+            UpdateClientBudgets(deltaTime);
 
-        if (gameStateUpdateTimer >= gameStateUpdateRate) {
-            SendGameStateToAll();
-            gameStateUpdateTimer = 0;
-        }
+            gameStateUpdateTimer += deltaTime;
+            bulletUpdateTimer += deltaTime;
+            bulletCorrectionTimer += deltaTime;
 
-        if (bulletUpdateTimer >= bulletUpdateRate) {
-            SendBulletUpdates();
-            bulletUpdateTimer = 0;
-        }
+            if (gameStateUpdateTimer >= gameStateUpdateRate) {
+                PROFILE_TICK_PHASE(tickProfiler, TickPhase::SEND_STATE);
+                SendGameStateToAll();
+                gameStateUpdateTimer = 0;
+            }
+            else if (!joinStatePending.empty()) {
+                PROFILE_TICK_PHASE(tickProfiler, TickPhase::SEND_STATE);
+                SendJoinStates();
+            }
+
+            if (bulletUpdateTimer >= bulletUpdateRate) {
+                PROFILE_TICK_PHASE(tickProfiler, TickPhase::SEND_BULLETS);
+                SendBulletUpdates();
+                bulletUpdateTimer = 0;
+            }
 
-        RemoveInactiveClients(deltaTime);
+            RemoveInactiveClients();
+            {
+                PROFILE_TICK_PHASE(tickProfiler, TickPhase::FLUSH);
+                FlushOutgoing();
+                if (conditioner) {
+                    conditioner->Flush(socket);
+                }
+            }
+        }
+        tickAllocations += AllocationCounter::GetCount() - tickAllocationsBefore;
 
-        static float statsTimer = 0;
         statsTimer += deltaTime;
         if (statsTimer >= 5.0f) {
-            PrintServerStats();
+            if (statsReportingEnabled) {
+                PrintServerStats();
+            }
             statsTimer = 0;
         }
+
+        if (metricsExporter) {
+            metricsTimer += deltaTime;
+            if (metricsTimer >= METRICS_PUBLISH_INTERVAL) {
+                PublishMetrics();
+            }
+        }
+
+        if (directoryAddress && !channel) {
+            directoryReportTimer += deltaTime;
+            if (directoryReportTimer * 1000.0f >= static_cast<float>(Directory::REPORT_INTERVAL_MS)) {
+                ReportToDirectory();
+                directoryReportTimer = 0;
+            }
+            scoreReportTimer += deltaTime;
+            if (scoreReportTimer * 1000.0f >= static_cast<float>(Directory::SCORE_REPORT_INTERVAL_MS)) {
+                ReportScoresToDirectory();
+                scoreReportTimer = 0;
+            }
+        }
+
+        if (checkpointWriter.IsRunning()) {
+            checkpointTimer += deltaTime;
+            if (checkpointTimer >= checkpointInterval) {
+                checkpointTimer = 0;
+                if (!checkpointWriter.IsBusy()) {
+                    TRACE_SCOPE("Capture checkpoint", "checkpoint");
+                    CaptureCheckpoint(checkpointWriter.GetStaging());
+                }
+                checkpointWriter.Submit();      // Counted as skipped while the last one is still being written
+            }
+        }
+
+        if (handoffListener.IsListening() && handoffListener.PollRequest()) {
+            HandOff();
+        }
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in server Update: " + std::string(e.what()), error);
@@ -98,28 +393,283 @@ void GameServer::Update(float deltaTime) {
     catch (...) {
         Utils::printMsg("Unknown exception in server Update", error);
     }
+
+    if (recorder) {
+        recorder->EndTick(ComputeStateHash());
+        keyframeTimer += deltaTime;
+        if (keyframeInterval > 0.0f && keyframeTimer >= keyframeInterval) {
+            keyframeTimer = 0;
+            RecordKeyframe();
+        }
+    }
+    tickClock.EndTick();
+    firedTimers.clear();
+    if (traceBeginMicros >= 0) {
+        TraceTick(traceBeginMicros);
+    }
+    tickNumber++;
+}
+
+void GameServer::SetSlowTickTrace(const std::string& pathPrefix, uint32_t thresholdMs) {
+    slowTickTracePrefix = pathPrefix;
+    slowTickTraceMicros = static_cast<int64_t>(thresholdMs) * 1000;
+}
+
+/**
+ * Records the whole tick and, past the slow tick threshold, dumps the trace
+ * so the tick can be inspected phase by phase. The cooldown keeps a stall
+ * of many slow ticks from writing a file per tick.
+ */
+void GameServer::TraceTick(int64_t beginMicros) {
+    const int64_t endMicros = TraceRecorder::NowMicros();
+    TraceRecorder& tracer = TraceRecorder::Instance();
+    tracer.Record("Tick", "tick", beginMicros, endMicros);
+    if (slowTickTraceMicros == 0 || endMicros - beginMicros < slowTickTraceMicros) {
+        return;
+    }
+    if (lastSlowTickTraceMicros != 0 && endMicros - lastSlowTickTraceMicros < SLOW_TICK_TRACE_COOLDOWN_MS * 1000) {
+        return;
+    }
+    lastSlowTickTraceMicros = endMicros;
+    LOG_MSG(warning, "Tick " + std::to_string(tickNumber) + " took " +
+        std::to_string((endMicros - beginMicros) / 1000) + " ms, writing trace");
+    tracer.WriteChromeTrace(slowTickTracePrefix + "-tick" + std::to_string(tickNumber) + ".json");
+}
+
+/**
+ * Declares the simulation part of Update, in the order it always ran. Only
+ * the bullet movement, the hit test grids and the lag compensation history
+ * are independent of each other (all three follow the enemy step and feed the
+ * hit tests), so they share a wave; the rest queue messages for clients or
+ * write the state the next phase reads, and run one at a time. Sending stays
+ * outside the graph: its phases all write the client queues, and encoding
+ * already overlaps the next tick on the snapshot pipeline.
+ */
+void GameServer::BuildSimulationGraph() {
+    using namespace TickState;
+    simulationGraph.AddPhase("Player movement", 0, PLAYERS | OUTGOING | COUNTERS, [this](float deltaTime) {
+        PROFILE_TICK_PHASE(tickProfiler, TickPhase::PLAYER_MOVEMENT);
+        SimulatePlayerMovement(deltaTime);
+    });
+    simulationGraph.AddPhase("Enemies", PLAYERS, ENEMIES | PROJECTILES | TIMERS | TARGET_GRIDS | OUTGOING | COUNTERS | JOURNAL, [this](float deltaTime) {
+        PROFILE_TICK_PHASE(tickProfiler, TickPhase::ENEMIES);
+        UpdateEnemies(deltaTime);
+    }, true);
+    simulationGraph.AddPhase("Bullets", 0, PROJECTILES, [this](float deltaTime) {
+        PROFILE_TICK_PHASE(tickProfiler, TickPhase::BULLETS);
+        UpdateBullets(deltaTime);
+    });
+    simulationGraph.AddPhase("Targets", PLAYERS | ENEMIES, TARGET_GRIDS, [this](float) {
+        PROFILE_TICK_PHASE(tickProfiler, TickPhase::TARGETS);
+        RebuildTargetGrids();
+    });
+    simulationGraph.AddPhase("Lag history", ENEMIES, LAG_HISTORY, [this](float) {
+        if (lagCompensationEnabled) {
+            PROFILE_TICK_PHASE(tickProfiler, TickPhase::LAG_HISTORY);
+            RecordEnemyPositionHistory(GetCurrentTimestamp());
+        }
+    });
+    simulationGraph.AddPhase("Bullet hits", TARGET_GRIDS | LAG_HISTORY,
+        PLAYERS | ENEMIES | PROJECTILES | TIMERS | OUTGOING | COUNTERS | JOURNAL, [this](float) {
+        PROFILE_TICK_PHASE(tickProfiler, TickPhase::BULLET_HITS);
+        CheckBulletCollisions();
+        RemoveDeadBullets();
+    });
+    simulationGraph.AddPhase("Collisions", 0, PLAYERS | ENEMIES | OUTGOING | COUNTERS, [this](float deltaTime) {
+        PROFILE_TICK_PHASE(tickProfiler, TickPhase::COLLISIONS);
+        CheckServerSideCollisions(deltaTime);
+    });
+    simulationGraph.AddPhase("Deaths", 0, ALL, [this](float) {
+        PROFILE_TICK_PHASE(tickProfiler, TickPhase::DEATHS);
+        CheckPlayerDeaths();
+        UpdateDeadPlayers();
+    });
+}
+
+/**
+ * Drops every pending timer (the players and projectiles they were for are
+ * gone or starting over) and starts the enemy spawn interval.
+ */
+void GameServer::ResetTimers() {
+    timers.Reset(tickNumber);
+    firedTimers.clear();
+    enemySpawnDue = false;
+    enemySpawnTimer = timers.Schedule(tickNumber + SecondsToTicks(enemySpawnInterval),
+        static_cast<uint8_t>(ServerTimer::ENEMY_SPAWN), 0);
+}
+
+/**
+ * Moves the timer wheel to this tick. The timers that came due are appended
+ * to firedTimers and each phase handles its own kinds from there (bullet
+ * expiry in UpdateBullets, respawns in UpdateDeadPlayers, ...); the list is
+ * cleared when the tick ends.
+ */
+void GameServer::AdvanceTimers() {
+    timers.Advance(tickNumber, firedTimers);
+}
+
+/**
+ * Whole ticks covering a delay, rounded up. The small slack absorbs the float
+ * tick duration, so 3 s at 60 Hz is 180 ticks rather than 181.
+ */
+uint64_t GameServer::SecondsToTicks(float seconds) const {
+    constexpr double MAX_TICKS = static_cast<double>(uint64_t(1) << 40);
+    const double ticks = std::ceil(static_cast<double>(seconds) / tickScheduler.GetTickDuration() - 1e-4);
+    if (!(ticks > 0.0)) {
+        return 0;
+    }
+    return ticks < MAX_TICKS ? static_cast<uint64_t>(ticks) : static_cast<uint64_t>(MAX_TICKS);
+}
+
+TimerWheel::TimerId GameServer::ScheduleAfter(float seconds, ServerTimer kind, uint32_t target, uint32_t data) {
+    const uint64_t ticks = SecondsToTicks(seconds);
+    const uint64_t dueTick = static_cast<uint64_t>(tickNumber) + (ticks > 0 ? ticks - 1 : 0);
+    if (dueTick <= timers.GetCurrentTick()) {
+        firedTimers.push_back({ TimerWheel::INVALID_TIMER, static_cast<uint8_t>(kind), target, data });
+        return TimerWheel::INVALID_TIMER;
+    }
+    return timers.Schedule(dueTick, static_cast<uint8_t>(kind), target, data);
+}
+
+/**
+ * Runs all simulation ticks that are due according to the tick scheduler.
+ * Each tick advances the world by exactly one fixed step, independent of how
+ * long the previous loop iteration or OS sleep took.
+ */
+void GameServer::RunScheduledTicks() {
+    if (!isRunning) return;
+
+    if (clients.empty() && CanIdle()) {
+        if (!idle) {
+            idle = true;
+            if (metricsExporter) {
+                PublishMetrics();   // The page would otherwise keep the last player count
+            }
+            LOG_MSG(debug, "No players connected, server idle");
+        }
+        return;
+    }
+
+    int dueTicks = tickScheduler.ConsumeDueTicks();
+    const float fixedDeltaTime = tickScheduler.GetTickDuration();
+
+    for (int i = 0; i < dueTicks && isRunning; ++i) {
+        tickScheduler.BeginTick();
+        Update(fixedDeltaTime);
+        tickScheduler.EndTick();
+        UpdateOverloadLevel();
+    }
+}
+
+/**
+ * Feeds the tick just run to the overload controller and applies, logs and
+ * publishes a level change. The new level takes effect from the next tick.
+ */
+void GameServer::UpdateOverloadLevel() {
+    if (!overload.RecordTick(tickScheduler.GetLastTickMs(), tickScheduler.GetTickDuration() * 1000.0)) {
+        return;
+    }
+    ApplyOverloadLevel();
+
+    const OverloadController::Transition& transition = overload.GetLastTransition();
+    const OverloadController::Level& settings = overload.GetLevelSettings();
+    LOG_MSG(transition.to > transition.from ? warning : info,
+        "Overload level " + std::to_string(transition.from) + " -> " + std::to_string(transition.to) +
+        " - Load: " + std::to_string(static_cast<int>(transition.load * 100.0)) + "% of tick budget" +
+        " - Overruns: " + std::to_string(static_cast<int>(transition.overrunFraction * 100.0)) + "% of ticks" +
+        " - Relaxed AI every " + std::to_string(settings.aiStride) + " ticks" +
+        ", far replication x" + std::to_string(settings.replicationScale) +
+        ", enemy cap x" + std::to_string(settings.enemyCapScale));
+    if (metricsExporter) {
+        PublishMetrics();
+    }
+}
+
+/**
+ * Far replication follows the level through the replication intervals; the
+ * AI stride and enemy cap are read by UpdateEnemies every tick.
+ */
+void GameServer::ApplyOverloadLevel() {
+    SetReplicationRates(replicationRates);
+}
+
+/**
+ * Idle: sleeps in the kernel until a datagram arrives, then restarts the tick
+ * clock so the tick that handles it runs at once and no catch-up ticks follow.
+ */
+void GameServer::WaitForNextTick() {
+    if (!idle) {
+        // Paced datagrams go out as they come due; the tick still starts on time
+        while (sendPacer.HasPending() && !tickScheduler.WaitForNextTick(sendPacer.GetNextDueMicros())) {
+            ReleasePacedDatagrams(false);
+        }
+        tickScheduler.WaitForNextTick();
+        return;
+    }
+    if (sendPacer.HasPending()) {
+        ReleasePacedDatagrams(true);
+    }
+    const bool readable = batchedSocket ? batchedSocket->WaitReadable(IDLE_WAIT_MS)
+        : idleSelector.wait(sf::milliseconds(IDLE_WAIT_MS));
+    if (readable && isRunning) {
+        idle = false;
+        tickScheduler.Resume();
+        LOG_MSG(debug, "Traffic received, server ticking again");
+    }
 }
 
 void GameServer::ProcessIncomingMessages() {
+    if (replayTick) {
+        for (size_t i = 0; i < replayTick->messageCount; ++i) {
+            RecordedMessage& message = replayTick->messages[i];
+            ProcessPacket(message.packet, message.address, message.port);
+        }
+        return;
+    }
+    if (channel) {
+        ProcessQueuedMessages();
+        return;
+    }
+    if (batchedSocket) {
+        ProcessBatchedMessages();
+        return;
+    }
+    if (sharedMemory) {
+        ProcessSharedMemoryMessages();
+        return;
+    }
+
     try {
-        sf::Packet packet;
         std::optional<sf::IpAddress> clientIP;
         unsigned short clientPort;
 
+        // Rate-limited datagrams don't count towards the message cap, so one
+        // flooding client cannot use up the frame; they are still bounded
         int messagesProcessed = 0;
+        int datagramsRead = 0;
         const int MAX_MESSAGES_PER_FRAME = 200;
+        const int MAX_DATAGRAMS_PER_FRAME = 1000;
 
-        while (messagesProcessed < MAX_MESSAGES_PER_FRAME) {
-            sf::Socket::Status receiveStatus = socket.receive(packet, clientIP, clientPort);
+        if (conditioner) {
+            conditioner->Flush(socket);
+        }
+        while (messagesProcessed < MAX_MESSAGES_PER_FRAME && datagramsRead < MAX_DATAGRAMS_PER_FRAME) {
+            sf::Socket::Status receiveStatus = conditioner ?
+                conditioner->Receive(socket, receiveBuffer, clientIP, clientPort) :
+                socket.receive(receiveBuffer, clientIP, clientPort);
 
             if (receiveStatus == sf::Socket::Status::Done) {
+                datagramsRead++;
                 if (!clientIP.has_value()) {
-                    Utils::printMsg("Received packet from invalid sender", warning);
+                    LOG_MSG(warning, "Received packet from invalid sender");
                     messagesProcessed++;
                     continue;
                 }
+                if (!ingressLimiter.Admit(receiveBuffer, clientIP.value(), clientPort, GetSteadyMicros())) {
+                    continue;
+                }
 
-                ProcessPacket(packet, clientIP.value(), clientPort);
+                ProcessPacket(receiveBuffer, clientIP.value(), clientPort);
                 messagesProcessed++;
             }
             else if (receiveStatus == sf::Socket::Status::NotReady) {
@@ -133,18 +683,18 @@ void GameServer::ProcessIncomingMessages() {
                 break;
             }
             else if (receiveStatus == sf::Socket::Status::Partial) {
-                Utils::printMsg("Partial packet received (unusual for UDP)", debug);
+                LOG_MSG(debug, "Partial packet received (unusual for UDP)");
                 break;
             }
             else {
-                Utils::printMsg("Unknown socket status while receiving: " +
-                    SocketStatusToString(receiveStatus), warning);
+                LOG_MSG(warning, "Unknown socket status while receiving: " +
+                    SocketStatusToString(receiveStatus));
                 break;
             }
         }
 
-        if (messagesProcessed >= MAX_MESSAGES_PER_FRAME) {
-            Utils::printMsg("Warning: Server hit max messages per frame limit", warning);
+        if (messagesProcessed >= MAX_MESSAGES_PER_FRAME || datagramsRead >= MAX_DATAGRAMS_PER_FRAME) {
+            LOG_MSG(warning, "Warning: Server hit max messages per frame limit");
         }
     }
     catch (const std::exception& e) {
@@ -155,190 +705,592 @@ void GameServer::ProcessIncomingMessages() {
     }
 }
 
-void GameServer::ProcessPacket(sf::Packet& packet, sf::IpAddress clientIP, unsigned short clientPort) {
+/**
+ * Drains datagrams already received by the thread owning the socket (the
+ * network I/O thread or the room host). The inbound ring is bounded, so no
+ * per-frame message cap is needed here.
+ */
+void GameServer::ProcessQueuedMessages() {
     try {
-        uint8_t messageTypeRaw;
-        if (!(packet >> messageTypeRaw)) {
-            return;
-        }
-
-        NetMessageType msgType = static_cast<NetMessageType>(messageTypeRaw);
-
-        if (msgType == NetMessageType::PLAYER_JOIN) {
-            JoinMessage joinMsg;
-            joinMsg.type = msgType;
-
-            if (packet >> joinMsg.playerName >> joinMsg.preferredColor
-                >> joinMsg.timestamp >> joinMsg.sequenceNumber) {
-                HandleJoinRequest(joinMsg, clientIP, clientPort);
-            }
-            else {
-                Utils::printMsg("Failed to parse join message", warning);
-            }
-        }
-        else if (msgType == NetMessageType::PLAYER_UPDATE) {
-            PlayerUpdateMessage updateMsg;
-            updateMsg.type = msgType;
-
-            if (packet >> updateMsg.playerId >> updateMsg.x >> updateMsg.y
-                >> updateMsg.bodyRotation >> updateMsg.barrelRotation
-                >> updateMsg.isMoving_forward >> updateMsg.isMoving_backward
-                >> updateMsg.isMoving_left >> updateMsg.isMoving_right
-                >> updateMsg.timestamp >> updateMsg.sequenceNumber) {
-
-                HandlePlayerUpdate(updateMsg, clientIP, clientPort);
-            }
-            else {
-                Utils::printMsg("Failed to parse player update message", warning);
-            }
+        // Popping swaps the previous datagram's buffer back into the ring for reuse
+        while (channel->PopInbound(queuedDatagram)) {
+            packetArrivalMicros = queuedDatagram.arrivalMicros;
+            packetValidated = queuedDatagram.validated;
+            ProcessPacket(queuedDatagram.packet, queuedDatagram.address, queuedDatagram.port);
         }
-        else if (msgType == NetMessageType::PLAYER_INPUT) {
-            PlayerInputMessage inputMsg;
-            inputMsg.type = msgType;
-
-            if (packet >> inputMsg.playerId
-                >> inputMsg.isMoving_forward
-                >> inputMsg.isMoving_backward
-                >> inputMsg.isMoving_left
-                >> inputMsg.isMoving_right
-                >> inputMsg.timestamp
-                >> inputMsg.sequenceNumber
-                >> inputMsg.barrelRotation) {
+        packetArrivalMicros = 0;
+        packetValidated = false;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in ProcessQueuedMessages: " + std::string(e.what()), error);
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in ProcessQueuedMessages", error);
+    }
+}
 
-                HandlePlayerInput(inputMsg, clientIP, clientPort);
-            }
-            else {
-                static int failCount = 0;
-                if (++failCount % 100 == 0) {
-                    Utils::printMsg("PlayerInput parse failures: " +
-                        std::to_string(failCount) + " (intermittent packet corruption)", debug);
+/**
+ * Receives in batches (recvmmsg, or RIO completions on Windows) until the socket is drained or the per-frame
+ * cap is reached. As on the plain socket, rate-limited datagrams only count
+ * towards the larger datagram cap.
+ */
+void GameServer::ProcessBatchedMessages() {
+    try {
+        const size_t MAX_MESSAGES_PER_FRAME = 200;
+        const size_t MAX_DATAGRAMS_PER_FRAME = 1000;
+        size_t messagesProcessed = 0;
+        size_t datagramsRead = 0;
+
+        while (messagesProcessed < MAX_MESSAGES_PER_FRAME && datagramsRead < MAX_DATAGRAMS_PER_FRAME) {
+            const size_t count = batchedSocket->ReceiveBatch();
+            const int64_t nowMicros = GetSteadyMicros();
+            for (size_t i = 0; i < count; ++i) {
+                QueuedDatagram& datagram = batchedSocket->GetReceived(i);
+                if (ingressLimiter.Admit(datagram.packet, datagram.address, datagram.port, nowMicros)) {
+                    ProcessPacket(datagram.packet, datagram.address, datagram.port);
+                    messagesProcessed++;
                 }
             }
-        }
-        else if (msgType == NetMessageType::BULLET_SPAWN) {
-            BulletSpawnMessage spawnMsg;
-            spawnMsg.type = msgType;
-
-            if (packet >> spawnMsg.playerId >> spawnMsg.spawnX >> spawnMsg.spawnY
-                >> spawnMsg.directionX >> spawnMsg.directionY >> spawnMsg.barrelRotation
-                >> spawnMsg.timestamp >> spawnMsg.sequenceNumber) {
-
-                HandleBulletSpawn(spawnMsg, clientIP, clientPort);
-            }
-            else {
-                Utils::printMsg("Failed to parse bullet spawn message", warning);
-            }
-        }
-        else if (msgType == NetMessageType::PING) {
-            PingMessage pingMsg;
-            pingMsg.type = msgType;
-
-            if (packet >> pingMsg.timestamp >> pingMsg.sequenceNumber) {
-                HandlePing(pingMsg, clientIP, clientPort);
-            }
-            else {
-                Utils::printMsg("Failed to parse ping message", warning);
-            }
-        }
-        else {
-            static std::unordered_map<uint8_t, int> unknownTypes;
-            if (++unknownTypes[messageTypeRaw] % 100 == 0) {
-                Utils::printMsg("Unknown message type " + std::to_string(static_cast<int>(msgType)) +
-                    " (count: " + std::to_string(unknownTypes[messageTypeRaw]) + ")", debug);
+            datagramsRead += count;
+            if (count < BatchedUdpSocket::BATCH_SIZE) {
+                break;
             }
         }
     }
     catch (const std::exception& e) {
-        Utils::printMsg("Exception in ProcessPacket: " + std::string(e.what()), error);
+        Utils::printMsg("Exception in ProcessBatchedMessages: " + std::string(e.what()), error);
     }
     catch (...) {
-        Utils::printMsg("Unknown exception in ProcessPacket", error);
+        Utils::printMsg("Unknown exception in ProcessBatchedMessages", error);
     }
 }
 
-void GameServer::HandleJoinRequest(const JoinMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
+/**
+ * Reads the clients' rings round-robin, so with the cap reached the busiest
+ * bots wait a tick rather than starving the others. Same caps as the sockets.
+ */
+void GameServer::ProcessSharedMemoryMessages() {
     try {
-        if (!NetworkValidation::IsValidPlayerName(msg.playerName)) {
-            Utils::printMsg("Invalid player name from " + clientIP.toString() +
-                " (length: " + std::to_string(msg.playerName.length()) + ")", warning);
-            return;
-        }
-
-        if (!msg.preferredColor.empty() && !NetworkValidation::IsValidColor(msg.preferredColor)) {
-            Utils::printMsg("Invalid color name from " + clientIP.toString() +
-                " (length: " + std::to_string(msg.preferredColor.length()) + ")", warning);
-        }
-
-        int64_t currentTime = GetCurrentTimestamp();
-        if (!NetworkValidation::IsValidTimestamp(msg.timestamp, currentTime)) {
-            Utils::printMsg("Invalid timestamp from " + clientIP.toString() +
-                " (delta: " + std::to_string(std::abs(currentTime - msg.timestamp)) + "ms)", warning);
-        }
-
-        Utils::printMsg("Player join request from " + clientIP.toString() + ":" + std::to_string(clientPort) +
-            " Name: " + msg.playerName + " (Seq: " + std::to_string(msg.sequenceNumber) + ")");
-
-        uint32_t existingPlayerId = FindPlayerByAddress(clientIP, clientPort);
-        if (existingPlayerId != 0) {
-            Utils::printMsg("Player already connected, updating info", warning);
-            clients[existingPlayerId].isActive = true;
-            clients[existingPlayerId].lastUpdateTime = 0;
-            clients[existingPlayerId].playerData.playerName = msg.playerName;
-            SendPlayerIdAssignment(existingPlayerId, clientIP, clientPort);
-            SendGameStateToClient(existingPlayerId);
-            return;
+        const size_t MAX_MESSAGES_PER_FRAME = 200;
+        const size_t MAX_DATAGRAMS_PER_FRAME = 1000;
+        size_t messagesProcessed = 0;
+        size_t datagramsRead = 0;
+        sf::IpAddress clientIP = sf::IpAddress::LocalHost;
+        unsigned short clientPort = 0;
+        const int64_t nowMicros = GetSteadyMicros();
+
+        while (messagesProcessed < MAX_MESSAGES_PER_FRAME && datagramsRead < MAX_DATAGRAMS_PER_FRAME &&
+            sharedMemory->Receive(receiveBuffer, clientIP, clientPort)) {
+            datagramsRead++;
+            if (ingressLimiter.Admit(receiveBuffer, clientIP, clientPort, nowMicros)) {
+                ProcessPacket(receiveBuffer, clientIP, clientPort);
+                messagesProcessed++;
+            }
         }
-
-        ClientInfo newClient(clientIP, clientPort);
-        newClient.playerData.playerId = nextPlayerId++;
-        newClient.playerData.playerName = msg.playerName;
-        newClient.playerData.color = !msg.preferredColor.empty() ? msg.preferredColor : AssignColor();
-
-        newClient.playerData.x = WorldConstants::CENTER_X;
-        newClient.playerData.y = WorldConstants::CENTER_Y;
-        newClient.playerData.health = 100.0f;
-        newClient.playerData.maxHealth = 100.0f;
-
-        RecordReceivedSequence(newClient, msg.sequenceNumber);
-
-        clients[newClient.playerData.playerId] = newClient;
-
-        Utils::printMsg("Player " + std::to_string(newClient.playerData.playerId) +
-            " (" + msg.playerName + ") joined with color " + newClient.playerData.color, success);
-
-        SendPlayerIdAssignment(newClient.playerData.playerId, clientIP, clientPort);
-        SendGameStateToClient(newClient.playerData.playerId);
-        SendGameStateToAll();
     }
     catch (const std::exception& e) {
-        Utils::printMsg("Exception in HandleJoinRequest: " + std::string(e.what()), error);
+        Utils::printMsg("Exception in ProcessSharedMemoryMessages: " + std::string(e.what()), error);
     }
     catch (...) {
-        Utils::printMsg("Unknown exception in HandleJoinRequest", error);
+        Utils::printMsg("Unknown exception in ProcessSharedMemoryMessages", error);
     }
 }
 
-void GameServer::HandlePlayerUpdate(const PlayerUpdateMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
-    try {
-        if (!NetworkValidation::IsValidPlayerId(msg.playerId)) {
-           // Utils::printMsg("Invalid player ID received: " + std::to_string(msg.playerId), warning);
-            return;
-        }
+/**
+ * Sends a packet directly, or hands a copy to the thread owning the socket
+ * (network I/O thread or room host).
+ * With the batched socket the copy joins the send batch flushed at the end of the tick;
+ * with shared memory it is written into the client's ring right away.
+ * Broadcast loops reuse one packet for several clients, so the queued copy is required.
+ * @return Done if sent/queued, NotReady if the outbound queue was full
+ */
+sf::Socket::Status GameServer::SendPacket(sf::Packet& packet, sf::IpAddress address, unsigned short port) {
+    TRACE_SCOPE("Send datagram", "net");
+    if (replayTick) {
+        return sf::Socket::Status::Done;   // Nobody is listening
+    }
+    if (capture) {
+        capture->Record(PacketCapture::Direction::SENT, GetSteadyMicros(), address, port, packet);
+    }
+    if (channel) {
+        return channel->QueueOutbound(packet, address, port)
+            ? sf::Socket::Status::Done : sf::Socket::Status::NotReady;
+    }
+    bandwidth.RecordDatagramSent(packet.getDataSize());
+    if (batchedSocket) {
+        batchedSocket->QueueSend(packet, address, port);
+        return sf::Socket::Status::Done;
+    }
+    if (sharedMemory) {
+        return sharedMemory->Send(packet, address, port) ? sf::Socket::Status::Done : sf::Socket::Status::NotReady;
+    }
+    if (conditioner) {
+        return conditioner->Send(socket, packet, address, port);
+    }
+    return socket.send(packet, address, port);
+}
 
-        if (!NetworkValidation::IsValidPosition(msg.x, msg.y)) {
-           // Utils::printMsg("Invalid position from player " + std::to_string(msg.playerId) +
-             //   " (" + std::to_string(msg.x) + ", " + std::to_string(msg.y) + ")", warning);
-            return;
+/**
+ * Queues a message for a known client; it leaves in that client's coalesced
+ * datagrams when the tick ends (see FlushOutgoing). Messages over the
+ * compression threshold go compressed if that makes them smaller. Traffic by
+ * type is recorded at the original size; the datagrams show the saving.
+ */
+void GameServer::QueueForClient(ClientInfo& client, const sf::Packet& packet) {
+    bandwidth.RecordMessageSent(packet);
+    if (compressionThreshold != 0 && packet.getDataSize() >= compressionThreshold &&
+        compressor.Compress(packet, compressedMessage)) {
+        compressedMessages++;
+        compressionBytesSaved += packet.getDataSize() - compressedMessage.getDataSize();
+        client.outgoing.Queue(compressedMessage);
+        return;
+    }
+    client.outgoing.Queue(packet);
+}
+
+/**
+ * Queues an event on the client's reliable channel: it is sent in order with
+ * this tick's datagrams and resent until the client acks it.
+ */
+void GameServer::QueueReliableForClient(ClientInfo& client, const sf::Packet& packet) {
+    bandwidth.RecordMessageSent(packet);
+    client.reliable.Send(packet);
+}
+
+/**
+ * Packs each client's queued messages into as few MTU-sized datagrams as possible
+ * and sends them. Called once at the end of every tick. With the snapshot
+ * pipeline the messages join the clients' send jobs and the frame is handed to
+ * the send thread instead. With send pacing the datagrams are scheduled over
+ * the tick; the first client's go at once and WaitForNextTick sends the rest.
+ */
+void GameServer::FlushOutgoing() {
+    const int64_t now = GetCurrentTimestamp();
+    const bool pacing = IsSendPacingActive();
+    if (pacing) {
+        ReleasePacedDatagrams(true);        // The loop had no time to wait last tick
+        sendPacer.BeginTick(GetSteadyMicros(),
+            static_cast<int64_t>(tickScheduler.GetTickDuration() * SendPacer::WINDOW_FRACTION * 1000000.0f), clients.size());
+    }
+    for (auto& [playerId, client] : clients) {
+        reliableResends += client.reliable.Update(now, [&](const sf::Packet& envelope) {
+            client.outgoing.Queue(envelope);
+        });
+        if (pacing) {
+            sendPacer.BeginClient(client.budget.IsLimited() ? client.budget.GetRate() : 0.0f);
+        }
+
+        if (sendFrame) {
+            if (!client.outgoing.IsEmpty() || client.sendJob != 0) {
+                SnapshotPipeline::ClientJob& job = AddSendJob(client);
+                job.after.TakeQueued(client.outgoing);
+                job.outgoing.SetNextFragmentId(client.outgoing.ReserveFragmentIds(
+                    job.outgoing.GetQueuedCount() + job.after.GetQueuedCount() + (job.hasSnapshot ? 1 : 0)));
+                client.sendJob = 0;
+            }
+            continue;
+        }
+
+        if (client.outgoing.IsEmpty()) {
+            continue;
+        }
+
+        coalescedMessages += client.outgoing.GetQueuedCount();
+        coalescedDatagrams += client.outgoing.Flush([&](sf::Packet& datagram) {
+            client.trafficSent.Add(datagram.getDataSize());
+            client.budget.Spend(datagram.getDataSize());
+            if (pacing) {
+                sendPacer.Queue(datagram, client.address, client.port);
+                return;
+            }
+            sf::Socket::Status sendStatus = SendPacket(datagram, client.address, client.port);
+            if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
+                LOG_MSG(warning, "Failed to send to player " + std::to_string(playerId) +
+                    " - Status: " + SocketStatusToString(sendStatus));
+            }
+        });
+    }
+
+    if (pacing) {
+        sendPacer.EndTick();
+        ReleasePacedDatagrams(false);
+    }
+
+    spectatorStream.Release(now, [&](sf::Packet& datagram, sf::IpAddress address, unsigned short port) {
+        SendPacket(datagram, address, port);
+    });
+    if (IsLanMulticastEnabled()) {
+        lanStream.ReleaseTo(now, lanGroup, lanGroupPort, [&](sf::Packet& datagram, sf::IpAddress address, unsigned short port) {
+            SendPacket(datagram, address, port);
+        });
+    }
+
+    if (sendFrame) {
+        snapshotPipeline->Submit();
+        sendFrame = nullptr;
+    }
+    if (batchedSocket) {
+        batchedSocket->FlushSends();
+    }
+}
+
+void GameServer::ReleasePacedDatagrams(bool all) {
+    auto send = [this](sf::Packet& datagram, sf::IpAddress address, unsigned short port) {
+        const sf::Socket::Status sendStatus = SendPacket(datagram, address, port);
+        if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
+            LOG_MSG(warning, "Failed to send to " + address.toString() + ":" + std::to_string(port) +
+                " - Status: " + SocketStatusToString(sendStatus));
+        }
+    };
+    if (all) {
+        sendPacer.ReleaseAll(send);
+    }
+    else {
+        sendPacer.Release(GetSteadyMicros(), send);
+    }
+    if (batchedSocket) {
+        batchedSocket->FlushSends();
+    }
+}
+
+/**
+ * Screens the connection token before anything else happens to the datagram:
+ * rejected datagrams are neither recorded nor parsed.
+ */
+void GameServer::ProcessPacket(sf::Packet& packet, sf::IpAddress clientIP, unsigned short clientPort) {
+    TRACE_SCOPE("Receive datagram", "net");
+    try {
+        bandwidth.RecordDatagramReceived(packet.getDataSize());
+        if (capture && !replayTick) {
+            capture->Record(PacketCapture::Direction::RECEIVED,
+                packetArrivalMicros != 0 ? packetArrivalMicros : GetSteadyMicros(), clientIP, clientPort, packet);
+        }
+        auto senderIt = clients.find(FindPlayerByAddress(clientIP, clientPort));
+        if (!AcceptConnectionToken(packet, clientIP, clientPort, senderIt != clients.end() ? &senderIt->second : nullptr)) {
+            return;
+        }
+
+        // Whatever the receiving thread did not check yet (see IngressValidator)
+        if (!packetValidated && !ingressValidator.Check(packet, static_cast<int64_t>(GetCurrentTimestamp()))) {
+            invalidMessages++;
+            return;
+        }
+
+        if (recorder) {
+            recorder->RecordMessage(clientIP, clientPort, packet);
+        }
+
+        // Clients send one message per datagram, so both levels count the same thing
+        bandwidth.RecordMessageReceived(ConnectionTokens::PeekMessageType(packet),
+            packet.getDataSize() - ConnectionTokens::TOKEN_BYTES);
+        if (senderIt != clients.end()) {
+            senderIt->second.trafficReceived.Add(packet.getDataSize());
+        }
+
+        uint64_t connectionToken;
+        uint8_t messageTypeRaw;
+        if (!(packet >> connectionToken >> messageTypeRaw)) {
+            return;
+        }
+
+        if (static_cast<NetMessageType>(messageTypeRaw) == NetMessageType::PLAYER_INPUT) {
+            // Reused so the redundant-input list keeps its capacity between messages
+            BitReader reader = BitReader::FromPacket(packet);
+
+            if (NetworkUtils::Read(reader, receivedInput, GetCurrentTimestamp())) {
+                HandlePlayerInput(receivedInput, clientIP, clientPort);
+            }
+            return;
+        }
+
+        const MessageSchema::DispatchResult result = MessageSchema::Dispatch<ClientToServerMessages>(
+            messageTypeRaw, packet, MessageSchema::Overloaded{
+                [&](const JoinMessage& msg) { HandleJoinRequest(msg, connectionToken, clientIP, clientPort); },
+                [&](const PlayerUpdateMessage& msg) { HandlePlayerUpdate(msg, clientIP, clientPort); },
+                [&](const ReliableAckMessage& msg) { HandleReliableAck(msg, clientIP, clientPort); },
+                [&](const BulletSpawnMessage& msg) { HandleBulletSpawn(msg, clientIP, clientPort); },
+                [&](const PingMessage& msg) { HandlePing(msg, clientIP, clientPort); },
+                [&](const SpectateMessage&) { HandleSpectateRequest(connectionToken, clientIP, clientPort); },
+                [&](const MulticastStatusMessage& msg) { HandleMulticastStatus(msg, clientIP, clientPort); },
+                [&](const SessionResumeMessage& msg) { HandleSessionResume(msg, connectionToken, clientIP, clientPort); },
+                [&](const StateResyncMessage& msg) { HandleStateResync(msg, clientIP, clientPort); },
+                [&](const ClientTelemetryMessage& msg) { HandleClientTelemetry(msg, clientIP, clientPort); }
+            });
+        if (result == MessageSchema::DispatchResult::MALFORMED) {
+            LOG_MSG(warning, "Failed to parse " + std::string(GetNetMessageTypeName(messageTypeRaw)) + " message");
+        }
+        else if (result == MessageSchema::DispatchResult::UNKNOWN) {
+            LOG_SAMPLED(LogCategory::UNKNOWN_MESSAGE, debug,
+                "Unknown message type " + std::to_string(static_cast<int>(messageTypeRaw)));
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in ProcessPacket: " + std::string(e.what()), error);
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in ProcessPacket", error);
+    }
+}
+
+/**
+ * Reads only the raw header. A connected client must repeat the token it
+ * joined with, and a spectator the one it subscribed with; a session resume
+ * is matched against its session by HandleSessionResume. Anything else,
+ * including a join from an unknown endpoint, must carry a token issued to
+ * that endpoint. Token-less connection requests are
+ * answered here without keeping any state. A replay skips the hash: its
+ * tokens were issued under another key, and the recording only holds
+ * datagrams that passed.
+ */
+bool GameServer::AcceptConnectionToken(const sf::Packet& packet, sf::IpAddress clientIP, unsigned short clientPort,
+    const ClientInfo* sender) {
+    uint64_t token = 0;
+    if (!ConnectionTokens::ReadToken(packet, token)) {
+        tokenRejections++;
+        return false;
+    }
+    if (sender && token == sender->connectionToken) {
+        return true;
+    }
+
+    if (token == 0) {
+        if (ConnectionTokens::IsConnectionRequest(packet)) {
+            challengePacket.clear();
+            ConnectionTokens::WriteChallenge(challengePacket,
+                connectionTokens.Issue(clientIP, clientPort, ::GetCurrentTimestamp()));
+            SendPacket(challengePacket, clientIP, clientPort);
+            challengesSent++;
+        }
+        else {
+            tokenRejections++;
+        }
+        return false;
+    }
+
+    // A spectator's refresh repeats the token it subscribed with
+    const uint8_t messageType = ConnectionTokens::PeekMessageType(packet);
+    // A resume carries its session's token from wherever the client is now;
+    // HandleSessionResume matches it against the session
+    if (messageType == static_cast<uint8_t>(NetMessageType::SESSION_RESUME)) {
+        return true;
+    }
+    if (messageType == static_cast<uint8_t>(NetMessageType::SPECTATE_REQUEST) &&
+        token == spectatorStream.FindToken(clientIP, clientPort)) {
+        return true;
+    }
+
+    // A new token is only good for joining or spectating (a reconnecting client joins again with one)
+    if ((messageType != static_cast<uint8_t>(NetMessageType::PLAYER_JOIN) &&
+        messageType != static_cast<uint8_t>(NetMessageType::SPECTATE_REQUEST)) ||
+        (!replayTick && !connectionTokens.Validate(token, clientIP, clientPort, ::GetCurrentTimestamp()))) {
+        tokenRejections++;
+        return false;
+    }
+    return true;
+}
+
+void GameServer::HandleJoinRequest(const JoinMessage& msg, uint64_t connectionToken, sf::IpAddress clientIP, unsigned short clientPort) {
+    try {
+        if (!msg.preferredColor.empty() && !NetworkValidation::IsValidColor(msg.preferredColor)) {
+            LOG_MSG(warning, "Invalid color name from " + clientIP.toString() +
+                " (length: " + std::to_string(msg.preferredColor.length()) + ")");
+        }
+
+        int64_t currentTime = GetCurrentTimestamp();
+        if (!NetworkValidation::IsValidTimestamp(msg.timestamp, currentTime)) {
+            LOG_MSG(warning, "Invalid timestamp from " + clientIP.toString() +
+                " (delta: " + std::to_string(std::abs(currentTime - msg.timestamp)) + "ms)");
+        }
+
+        LOG_MSG(info, "Player join request from " + clientIP.toString() + ":" + std::to_string(clientPort) +
+            " Name: " + msg.playerName + " (Seq: " + std::to_string(msg.sequenceNumber) + ")");
+
+        uint32_t existingPlayerId = FindPlayerByAddress(clientIP, clientPort);
+        if (existingPlayerId != 0) {
+            LOG_MSG(warning, "Player already connected, updating info");
+            clients[existingPlayerId].isActive = true;
+            clients[existingPlayerId].connectionToken = connectionToken;
+            clients[existingPlayerId].lastHeardTick = tickNumber;
+            if (!timers.IsPending(clients[existingPlayerId].timeoutTimer)) {
+                ScheduleClientTimeout(existingPlayerId, clients[existingPlayerId]);
+            }
+            clients[existingPlayerId].lastAcknowledgedInputSeq = 0;  // A reconnecting client restarts its input sequence
+            clients[existingPlayerId].lastInputApplyMicros = 0;
+            clients[existingPlayerId].lastReceivedInputSeq = 0;
+            clients[existingPlayerId].inputBuffer.Reset();
+            clients[existingPlayerId].reliable.Reset();               // ...and its reliable channel
+            clients[existingPlayerId].receivedSequences.Clear();
+            if (clients[existingPlayerId].playerName != msg.playerName) {
+                clients[existingPlayerId].playerName = msg.playerName;
+                playerTableVersion++;
+            }
+            clients[existingPlayerId].streamedChunks.clear();   // The client starts without chunks
+            ResetClientReplication(clients[existingPlayerId]);
+            SendJoinAccept(clients[existingPlayerId], existingPlayerId, msg.sendMicros);
+            joinStatePending.push_back(existingPlayerId);
+            OfferLanMulticast(clients[existingPlayerId]);
+            return;
+        }
+
+        if (clients.size() >= maxPlayers) {
+            LOG_MSG(warning, "Server full (" + std::to_string(maxPlayers) + " players), refusing join from " +
+                clientIP.toString() + ":" + std::to_string(clientPort));
+            return;
+        }
+
+        PlayerColor color = PlayerColor::GREEN;
+        if (!NetworkUtils::ColorFromName(msg.preferredColor, color)) {
+            color = AssignColor();
         }
 
-        if (!NetworkValidation::IsValidRotation(msg.bodyRotation) ||
-            !NetworkValidation::IsValidRotation(msg.barrelRotation)) {
-           // Utils::printMsg("Invalid rotation from player " + std::to_string(msg.playerId) +
-            //    " (body: " + std::to_string(msg.bodyRotation) +
-             //   ", barrel: " + std::to_string(msg.barrelRotation) + ")", warning);
+        const uint32_t playerId = nextPlayerId++;
+        ClientInfo& newClient = clients.emplace(playerId, ClientInfo(clientIP, clientPort)).first->second;
+        newClient.connectionToken = connectionToken;
+        newClient.playerName = msg.playerName;
+        AcquirePlayerSlot(newClient, playerId, color);
+
+        PlayerData& player = SimOf(newClient).player;
+        const sf::Vector2f joinPosition = obstacles.ResolveCircle(sf::Vector2f(WorldConstants::CENTER_X, WorldConstants::CENTER_Y),
+            WorldConstants::TANK_RADIUS + WorldConstants::SPAWN_SAFETY_MARGIN);
+        player.x = joinPosition.x;
+        player.y = joinPosition.y;
+        player.health = 100.0f;
+        player.maxHealth = 100.0f;
+
+        RecordReceivedSequence(newClient, msg.sequenceNumber);
+        newClient.lastHeardTick = tickNumber;
+        newClient.budget.SetLimit(static_cast<float>(clientBandwidth));
+
+        ScheduleClientTimeout(playerId, newClient);
+        clientsByEndpoint[EndpointKey(clientIP, clientPort)] = playerId;
+        playerTableVersion++;
+
+        LOG_MSG(success, "Player " + std::to_string(playerId) +
+            " (" + msg.playerName + ") joined with color " +
+            NetworkUtils::ColorName(color));
+
+        // The rest of the reply goes out at this tick's send, and the other
+        // players see the newcomer in their next regular snapshot
+        SendJoinAccept(newClient, playerId, msg.sendMicros);
+        joinStatePending.push_back(playerId);
+        OfferLanMulticast(newClient);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in HandleJoinRequest: " + std::string(e.what()), error);
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in HandleJoinRequest", error);
+    }
+}
+
+/**
+ * Picks up a session whose client went quiet: an active one whose endpoint
+ * may have changed (a NAT rebinding), or one suspended after its timeout,
+ * whose tank comes back where it was. The client keeps its input sequence,
+ * reliable channel and chunks, so only the input buffer starts over. The
+ * reply is the join's: JOIN_ACCEPT, then a snapshot against the one the
+ * client holds if it is still in the history (silent clients are sent none,
+ * see SILENT_CLIENT_SECONDS), so the client is back within one round trip.
+ * An unknown session is answered with a fresh challenge, which sends the
+ * client through a full join.
+ */
+void GameServer::HandleSessionResume(const SessionResumeMessage& msg, uint64_t connectionToken, sf::IpAddress clientIP,
+    unsigned short clientPort) {
+    try {
+        const uint32_t endpointPlayer = FindPlayerByAddress(clientIP, clientPort);
+        if (endpointPlayer != 0 && endpointPlayer != msg.playerId) {
+            return;     // Another player's endpoint
+        }
+        auto clientIt = clients.find(msg.playerId);
+        const bool active = clientIt != clients.end() && clientIt->second.connectionToken == connectionToken;
+        auto suspendedIt = suspendedClients.find(msg.playerId);
+        if (!active && (suspendedIt == suspendedClients.end() || suspendedIt->second.connectionToken != connectionToken)) {
+            challengePacket.clear();
+            ConnectionTokens::WriteChallenge(challengePacket,
+                connectionTokens.Issue(clientIP, clientPort, ::GetCurrentTimestamp()));
+            SendPacket(challengePacket, clientIP, clientPort);
+            challengesSent++;
             return;
         }
 
+        if (!active && clients.size() >= maxPlayers) {
+            return;     // Full; the client keeps asking until a place frees or its session expires
+        }
+        if (!active) {
+            clientIt = clients.emplace(msg.playerId, std::move(suspendedIt->second)).first;
+            suspendedClients.erase(suspendedIt);
+            ClientInfo& restored = clientIt->second;
+            PlayerSimState& sim = playerSims[restored.slot];
+            sim.inUse = true;
+            sim.dirtyFields = SnapshotDelta::PLAYER_ALL;
+            restored.isActive = true;
+            restored.timeoutTimer = TimerWheel::INVALID_TIMER;
+            if (restored.restored) {
+                // Brought back from a checkpoint without its reliable channel or
+                // snapshot numbering: carry on from where the client is
+                restored.reliable.Reset(msg.nextReliableSequence);
+                restored.nextSnapshotSequence = std::max(restored.nextSnapshotSequence, msg.lastReceivedSnapshot + 1);
+                restored.restored = false;
+            }
+            if (restored.isDead && !timers.IsPending(restored.respawnTimer)) {
+                restored.respawnTimer = ScheduleAfter(0.0f, ServerTimer::RESPAWN, msg.playerId);  // Came due while away
+            }
+            playerTableVersion++;
+        }
+        ClientInfo& client = clientIt->second;
+        if (client.address != clientIP || client.port != clientPort || !active) {
+            clientsByEndpoint.erase(EndpointKey(client.address, client.port));
+            client.address = clientIP;
+            client.port = clientPort;
+            clientsByEndpoint[EndpointKey(clientIP, clientPort)] = msg.playerId;
+            client.groupDelivery = false;       // Unicast until it reports group frames from here
+        }
+        client.lastHeardTick = tickNumber;
+        if (!timers.IsPending(client.timeoutTimer)) {
+            ScheduleClientTimeout(msg.playerId, client);
+        }
+        client.inputBuffer.Reset();
+        const bool delta = msg.lastReceivedSnapshot != 0 && client.snapshotHistory.Find(msg.lastReceivedSnapshot);
+        client.lastAckedSnapshot = delta ? msg.lastReceivedSnapshot : 0;
+        resumedSessions++;
+        LOG_MSG(success, "Player " + std::to_string(msg.playerId) + " (" + client.playerName + ") resumed its " +
+            (active ? "session" : "suspended session") + " from " + clientIP.toString() + ":" +
+            std::to_string(clientPort) + (delta ? ", delta against snapshot " + std::to_string(msg.lastReceivedSnapshot)
+                : ", full snapshot"));
+
+        SendJoinAccept(client, msg.playerId, msg.sendMicros);
+        SendGameStateToClient(msg.playerId);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in HandleSessionResume: " + std::string(e.what()), error);
+    }
+}
+
+/**
+ * Subscribes a spectator, or refreshes its subscription. A player's endpoint
+ * cannot also spectate. New spectators start decoding at the next keyframe,
+ * which reaches them after the stream delay.
+ */
+void GameServer::HandleSpectateRequest(uint64_t connectionToken, sf::IpAddress clientIP, unsigned short clientPort) {
+    if (FindPlayerByAddress(clientIP, clientPort) != 0) {
+        return;
+    }
+    const std::string endpoint = clientIP.toString() + ":" + std::to_string(clientPort);
+    const bool subscribed = spectatorStream.FindToken(clientIP, clientPort) != 0;
+    if (!spectatorStream.Subscribe(clientIP, clientPort, connectionToken, GetCurrentTimestamp())) {
+        LOG_MSG(debug, "Spectator stream full (" + std::to_string(spectatorStream.GetCapacity()) +
+            "), refused " + endpoint + " - larger audiences need a spectator relay");
+        return;
+    }
+    if (!subscribed) {
+        LOG_MSG(info, "Spectator " + endpoint + " subscribed (" + std::to_string(spectatorStream.GetSpectatorCount()) +
+            " watching, " + std::to_string(spectatorStream.GetDelay()) + " ms delay)");
+    }
+}
+
+void GameServer::HandlePlayerUpdate(const PlayerUpdateMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
+    try {
+        // ID, position and rotations were range-checked at ingress (IngressValidator)
         int64_t currentTime = GetCurrentTimestamp();
         if (!NetworkValidation::IsValidTimestamp(msg.timestamp, currentTime)) {
           //  Utils::printMsg("Invalid timestamp from player " + std::to_string(msg.playerId) +
@@ -349,9 +1301,9 @@ void GameServer::HandlePlayerUpdate(const PlayerUpdateMessage& msg, sf::IpAddres
         if (it != clients.end()) {
             if (it->second.address == clientIP && it->second.port == clientPort) {
                 if (!ValidateSequenceNumber(it->second, msg.sequenceNumber)) {
-                    Utils::printMsg("Out-of-order or duplicate packet from player " +
+                    LOG_MSG(debug, "Out-of-order or duplicate packet from player " +
                         std::to_string(msg.playerId) + " (Seq: " +
-                        std::to_string(msg.sequenceNumber) + ")", debug);
+                        std::to_string(msg.sequenceNumber) + ")");
                 }
 
                 float clampedX = NetworkValidation::ClampPositionX(msg.x);
@@ -364,15 +1316,17 @@ void GameServer::HandlePlayerUpdate(const PlayerUpdateMessage& msg, sf::IpAddres
                    //    debug);
                 }
 
-                it->second.playerData.x = clampedX;
-                it->second.playerData.y = clampedY;
-                it->second.playerData.bodyRotation = NetworkValidation::NormalizeRotation(msg.bodyRotation);
-                it->second.playerData.barrelRotation = NetworkValidation::NormalizeRotation(msg.barrelRotation);
-                it->second.playerData.isMoving_forward = msg.isMoving_forward;
-                it->second.playerData.isMoving_backward = msg.isMoving_backward;
-                it->second.playerData.isMoving_left = msg.isMoving_left;
-                it->second.playerData.isMoving_right = msg.isMoving_right;
-                it->second.lastUpdateTime = 0;
+                SimOf(it->second).player.x = clampedX;
+                SimOf(it->second).player.y = clampedY;
+                SimOf(it->second).player.bodyRotation = NetworkValidation::NormalizeRotation(msg.bodyRotation);
+                SimOf(it->second).player.barrelRotation = NetworkValidation::NormalizeRotation(msg.barrelRotation);
+                SimOf(it->second).player.isMoving_forward = msg.isMoving_forward;
+                SimOf(it->second).player.isMoving_backward = msg.isMoving_backward;
+                SimOf(it->second).player.isMoving_left = msg.isMoving_left;
+                SimOf(it->second).player.isMoving_right = msg.isMoving_right;
+                SimOf(it->second).dirtyFields |= SnapshotDelta::PLAYER_POSITION | SnapshotDelta::PLAYER_BODY_ROTATION |
+                    SnapshotDelta::PLAYER_BARREL_ROTATION | SnapshotDelta::PLAYER_MOVEMENT;
+                it->second.lastHeardTick = tickNumber;
 
                 RecordReceivedSequence(it->second, msg.sequenceNumber);
             }
@@ -395,53 +1349,92 @@ void GameServer::HandlePlayerUpdate(const PlayerUpdateMessage& msg, sf::IpAddres
 
 void GameServer::HandlePlayerInput(const PlayerInputMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
     try {
-        if (!NetworkValidation::IsValidPlayerId(msg.playerId)) {
-            Utils::printMsg("Invalid player ID in input: " + std::to_string(msg.playerId), warning);
-            return;
-        }
-
         int64_t currentTime = GetCurrentTimestamp();
         if (!NetworkValidation::IsValidTimestamp(msg.timestamp, currentTime)) {
-            Utils::printMsg("Invalid timestamp from player " + std::to_string(msg.playerId) +
-                " (delta: " + std::to_string(std::abs(currentTime - msg.timestamp)) + "ms)", debug);
+            LOG_MSG(debug, "Invalid timestamp from player " + std::to_string(msg.playerId) +
+                " (delta: " + std::to_string(std::abs(currentTime - msg.timestamp)) + "ms)");
         }
 
         if (!NetworkValidation::IsValidRotation(msg.barrelRotation)) {
-            Utils::printMsg("Invalid barrel rotation from player " + std::to_string(msg.playerId) +
-                ": " + std::to_string(msg.barrelRotation), debug);
+            LOG_MSG(debug, "Invalid barrel rotation from player " + std::to_string(msg.playerId) +
+                ": " + std::to_string(msg.barrelRotation));
         }
 
         auto it = clients.find(msg.playerId);
         if (it != clients.end()) {
             if (it->second.address == clientIP && it->second.port == clientPort) {
-                if (!ValidateSequenceNumber(it->second, msg.sequenceNumber)) {
-                    Utils::printMsg("Out-of-order input from player " +
+                ClientInfo& client = it->second;
+                if (!ValidateSequenceNumber(client, msg.sequenceNumber)) {
+                    LOG_MSG(debug, "Out-of-order input from player " +
                         std::to_string(msg.playerId) + " (Seq: " +
-                        std::to_string(msg.sequenceNumber) + ")", debug);
+                        std::to_string(msg.sequenceNumber) + ")");
                 }
 
-                it->second.playerData.isMoving_forward = msg.isMoving_forward;
-                it->second.playerData.isMoving_backward = msg.isMoving_backward;
-                it->second.playerData.isMoving_left = msg.isMoving_left;
-                it->second.playerData.isMoving_right = msg.isMoving_right;
-                it->second.playerData.barrelRotation = NetworkValidation::NormalizeRotation(msg.barrelRotation);
+                // A datagram overtaken by a newer one carries nothing new: its inputs were
+                // either already queued or superseded, so it must not roll the held state back
+                const bool isNewestInput = msg.sequenceNumber > client.lastReceivedInputSeq;
+                if (isNewestInput) {
+                    BufferedInput buffered;
+                    buffered.barrelRotation = NetworkValidation::NormalizeRotation(msg.barrelRotation);
+                    buffered.step = msg.predictedStep;
+                    // Repeated older inputs the server never received, queued oldest first
+                    for (auto input = msg.previousInputs.rbegin(); input != msg.previousInputs.rend(); ++input) {
+                        if (input->sequenceNumber <= client.lastReceivedInputSeq ||
+                            client.receivedSequences.Contains(input->sequenceNumber)) {
+                            continue;
+                        }
+                        buffered.sequenceNumber = input->sequenceNumber;
+                        buffered.isMoving_forward = input->isMoving_forward;
+                        buffered.isMoving_backward = input->isMoving_backward;
+                        buffered.isMoving_left = input->isMoving_left;
+                        buffered.isMoving_right = input->isMoving_right;
+                        client.inputBuffer.Push(buffered);
+                        RecordReceivedSequence(client, input->sequenceNumber);
+                        recoveredInputs++;
+                    }
+
+                    buffered.sequenceNumber = msg.sequenceNumber;
+                    buffered.isMoving_forward = msg.isMoving_forward;
+                    buffered.isMoving_backward = msg.isMoving_backward;
+                    buffered.isMoving_left = msg.isMoving_left;
+                    buffered.isMoving_right = msg.isMoving_right;
+                    client.inputBuffer.Push(buffered);
+                    // Tick time, not the arrival stamp, so a replay estimates the same jitter
+                    client.inputBuffer.RecordArrival(msg.timestamp, currentTime, tickScheduler.GetTickDuration());
+                }
 
                // static int logCounter2 = 0;
                // if (++logCounter2 % 30 == 0) {
                  //   Utils::printMsg(" SERVER RECV: Player=" + std::to_string(msg.playerId) +
                  //       " Barrel=" + std::to_string(msg.barrelRotation) + "° → Stored=" +
-                 //       std::to_string(it->second.playerData.barrelRotation) + "°", debug);
+                 //       std::to_string(SimOf(it->second).player.barrelRotation) + "°", debug);
               //  }
 
-                it->second.lastUpdateTime = 0;
+                it->second.lastHeardTick = tickNumber;
                 RecordReceivedSequence(it->second, msg.sequenceNumber);
 
-                it->second.lastAcknowledgedInputSeq = msg.sequenceNumber;
-                SendInputAcknowledgment(msg.playerId, msg.sequenceNumber, clientIP, clientPort);
+                // Only snapshots we actually sent can become delta baselines
+                if (msg.lastReceivedSnapshot > it->second.lastAckedSnapshot &&
+                    msg.lastReceivedSnapshot < it->second.nextSnapshotSequence) {
+                    RecordRttSample(it->second, msg.lastReceivedSnapshot);
+                    it->second.lastAckedSnapshot = msg.lastReceivedSnapshot;
+                }
+                if (msg.playerTableVersion > it->second.ackedPlayerTableVersion &&
+                    msg.playerTableVersion <= playerTableVersion) {
+                    it->second.ackedPlayerTableVersion = msg.playerTableVersion;
+                }
+                if (msg.hasReliableAck) {
+                    client.reliable.OnAck(msg.reliableAckSequence, msg.reliableAckBits);
+                }
+
+                if (isNewestInput) {
+                    client.lastReceivedInputSeq = msg.sequenceNumber;
+                }
+                SendInputAcknowledgment(msg.playerId, client.lastAcknowledgedInputSeq, msg.sendMicros, clientIP, clientPort);
             }
             else {
-                Utils::printMsg("Input from incorrect address for player " +
-                    std::to_string(msg.playerId), warning);
+                LOG_MSG(warning, "Input from incorrect address for player " +
+                    std::to_string(msg.playerId));
             }
         }
         else {
@@ -456,20 +1449,42 @@ void GameServer::HandlePlayerInput(const PlayerInputMessage& msg, sf::IpAddress
     }
 }
 
+/**
+ * Only the client's own endpoint may ack its reliable channel.
+ */
+void GameServer::HandleReliableAck(const ReliableAckMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
+    auto it = clients.find(msg.playerId);
+    if (it != clients.end() && it->second.address == clientIP && it->second.port == clientPort) {
+        it->second.reliable.OnAck(msg.ackSequence, msg.ackBits);
+        it->second.lastHeardTick = tickNumber;
+    }
+}
+
 void GameServer::HandlePing(const PingMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
     try {
-        sf::Packet packet;
+        // Real steady time, not the tick clock: the client's offset
+        // estimate needs when this ping actually arrived and was answered
         PongMessage pongMsg;
         pongMsg.originalTimestamp = msg.timestamp;
         pongMsg.sequenceNumber = msg.sequenceNumber;
+        pongMsg.serverReceiveTime = packetArrivalMicros != 0 ? packetArrivalMicros : GetSteadyMicros();
 
-        packet << static_cast<uint8_t>(pongMsg.type) << pongMsg.originalTimestamp << pongMsg.sequenceNumber;
+        PacketPool::Lease packet = sendPackets.Borrow();
+        pongMsg.serverTransmitTime = GetSteadyMicros();
+        *packet << pongMsg;
+
+        auto clientIt = clients.find(FindPlayerByAddress(clientIP, clientPort));
+        if (clientIt != clients.end()) {
+            QueueForClient(clientIt->second, *packet);
+            return;
+        }
 
-        sf::Socket::Status sendStatus = socket.send(packet, clientIP, clientPort);
+        bandwidth.RecordMessageSent(*packet);
+        sf::Socket::Status sendStatus = SendPacket(*packet, clientIP, clientPort);
 
         if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
-            Utils::printMsg("Failed to send pong to " + clientIP.toString() +
-                " - Status: " + SocketStatusToString(sendStatus), warning);
+            LOG_MSG(warning, "Failed to send pong to " + clientIP.toString() +
+                " - Status: " + SocketStatusToString(sendStatus));
         }
     }
     catch (const std::exception& e) {
@@ -481,12 +1496,13 @@ void GameServer::HandlePing(const PingMessage& msg, sf::IpAddress clientIP, unsi
 }
 
 bool GameServer::ValidateSequenceNumber(ClientInfo& client, uint32_t sequenceNumber) {
-    if (client.receivedSequenceNumbers.find(sequenceNumber) != client.receivedSequenceNumbers.end()) {
+    const SequenceWindow& window = client.receivedSequences;
+    if (window.Contains(sequenceNumber)) {
         return false;
     }
 
     const uint32_t OUT_OF_ORDER_THRESHOLD = 50;
-    if (sequenceNumber + OUT_OF_ORDER_THRESHOLD < client.lastReceivedSequenceNumber) {
+    if (window.HasReceived() && SequenceWindow::IsNewer(window.GetLatest(), sequenceNumber + OUT_OF_ORDER_THRESHOLD)) {
         return false;
     }
 
@@ -494,134 +1510,109 @@ bool GameServer::ValidateSequenceNumber(ClientInfo& client, uint32_t sequenceNum
 }
 
 void GameServer::RecordReceivedSequence(ClientInfo& client, uint32_t sequenceNumber) {
-    client.receivedSequenceNumbers[sequenceNumber] = true;
-
-    if (sequenceNumber > client.lastReceivedSequenceNumber) {
-        client.lastReceivedSequenceNumber = sequenceNumber;
-    }
-
-    const size_t MAX_SEQUENCE_HISTORY = 200;
-    if (client.receivedSequenceNumbers.size() > MAX_SEQUENCE_HISTORY) {
-        uint32_t minSequence = client.lastReceivedSequenceNumber > MAX_SEQUENCE_HISTORY ?
-            client.lastReceivedSequenceNumber - MAX_SEQUENCE_HISTORY : 0;
-
-        auto it = client.receivedSequenceNumbers.begin();
-        while (it != client.receivedSequenceNumbers.end()) {
-            if (it->first < minSequence) {
-                it = client.receivedSequenceNumbers.erase(it);
-            }
-            else {
-                ++it;
-            }
-        }
-    }
+    client.receivedSequences.Record(sequenceNumber);
 }
 
-void GameServer::SendPlayerIdAssignment(uint32_t playerId, sf::IpAddress clientIP, unsigned short clientPort) {
+/**
+ * Queued, not reliable: it must lead the player table and snapshot in the same
+ * flush, and a client that misses it starts the handshake over, which sends
+ * the whole reply again.
+ */
+void GameServer::SendJoinAccept(ClientInfo& client, uint32_t playerId, int64_t clientSendMicros) {
     try {
-        sf::Packet packet;
-        packet << static_cast<uint8_t>(NetMessageType::PLAYER_ID_ASSIGNMENT);
-        packet << playerId;
-
-        sf::Socket::Status sendStatus = socket.send(packet, clientIP, clientPort);
-
-        if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
-            Utils::printMsg("Failed to send player ID to player " + std::to_string(playerId) +
-                " - Status: " + SocketStatusToString(sendStatus), warning);
-        }
+        JoinAcceptMessage acceptMsg;
+        acceptMsg.playerId = playerId;
+        acceptMsg.clientSendTime = clientSendMicros;
+        acceptMsg.tickRate = static_cast<uint16_t>(tickScheduler.GetTickRate());
+        acceptMsg.serverReceiveTime = packetArrivalMicros != 0 ? packetArrivalMicros : GetSteadyMicros();
+
+        PacketPool::Lease packet = sendPackets.Borrow();
+        acceptMsg.serverTransmitTime = GetSteadyMicros();
+        *packet << acceptMsg;
+        QueueForClient(client, *packet);
     }
     catch (const std::exception& e) {
-        Utils::printMsg("Exception in SendPlayerIdAssignment: " + std::string(e.what()), error);
+        Utils::printMsg("Exception in SendJoinAccept: " + std::string(e.what()), error);
     }
     catch (...) {
-        Utils::printMsg("Unknown exception in SendPlayerIdAssignment", error);
+        Utils::printMsg("Unknown exception in SendJoinAccept", error);
     }
 }
 
+/**
+ * Sends every active client a snapshot delta-encoded against the last snapshot
+ * that client acknowledged. Clients without a usable baseline get a full snapshot.
+ */
 void GameServer::SendGameStateToAll() {
     if (clients.empty()) return;
 
     try {
-        sf::Packet packet;
-        packet << static_cast<uint8_t>(NetMessageType::GAME_STATE);
+        // Joiners were reset when they joined: without a baseline or table
+        // they get everything from scratch in the loop below
+        joinStatePending.clear();
+        encodeCache.Clear();
+        SendPlayerTableUpdates();
+
+        UpdateWorldSnapshot();
+        IndexEnemyChunks();
+        const uint32_t messageSequence = outgoingSequenceNumber++;
 
         uint32_t activeClientCount = 0;
-        for (const auto& [playerId, client] : clients) {
-            if (client.isActive) {
+        groupDeliveryClients = 0;
+        const int64_t now = GetCurrentTimestamp();
+        const uint64_t silentTicks = SecondsToTicks(SILENT_CLIENT_SECONDS);
+        for (auto& [playerId, client] : clients) {
+            if (client.isActive && tickNumber - client.lastHeardTick >= silentTicks) {
                 activeClientCount++;
+                continue;       // See SILENT_CLIENT_SECONDS
             }
-        }
-        packet << activeClientCount;
-
-        for (auto& [playerId, client] : clients) {  // Changed to non-const to allow modification
             if (client.isActive) {
-                // CRITICAL: Sync client.score to client.playerData.score before sending
-                client.playerData.score = client.score;
-                client.playerData.isDead = client.isDead;
-
-                packet << client.playerData.playerId
-                    << client.playerData.playerName
-                    << client.playerData.x
-                    << client.playerData.y
-                    << client.playerData.bodyRotation
-                    << client.playerData.barrelRotation
-                    << client.playerData.color
-                    << client.playerData.isMoving_forward
-                    << client.playerData.isMoving_backward
-                    << client.playerData.isMoving_left
-                    << client.playerData.isMoving_right
-                    << client.playerData.health
-                    << client.playerData.maxHealth
-                    << client.playerData.score
-                    << client.playerData.isDead;
-            }
-        }
-
-        uint32_t enemyCount = static_cast<uint32_t>(enemies.size());
-        packet << enemyCount;
-
-        for (const auto& [enemyId, enemy] : enemies) {
-            if (enemy) {
-                EnemyData enemyData;
-                enemyData.enemyId = enemyId;
-                enemyData.enemyType = static_cast<uint8_t>(enemy->GetEnemyType());
-                enemyData.x = enemy->GetPosition().x;
-                enemyData.y = enemy->GetPosition().y;
-                enemyData.bodyRotation = enemy->GetBodyRotation().asDegrees();
-                enemyData.barrelRotation = enemy->GetBarrelRotation().asDegrees();
-                enemyData.health = enemy->GetHealth();
-                enemyData.maxHealth = enemy->GetMaxHealth();
-
-                packet << enemyData.enemyId
-                    << enemyData.enemyType
-                    << enemyData.x
-                    << enemyData.y
-                    << enemyData.bodyRotation
-                    << enemyData.barrelRotation
-                    << enemyData.health
-                    << enemyData.maxHealth;
-            }
-        }
-
-        int64_t timestamp = GetCurrentTimestamp();
-        uint32_t lastAckedInput = 0;
-        packet << timestamp << outgoingSequenceNumber++ << lastAckedInput;
-
-        for (const auto& [playerId, client] : clients) {
+                StreamChunks(client);
+            }
+            if (client.isActive && client.groupDelivery) {
+                if (now - client.lastGroupProgressMs <= LanMulticast::STALL_TIMEOUT_MS) {
+                    groupDeliveryClients++;
+                    activeClientCount++;
+                    continue;
+                }
+                LOG_MSG(warning, "Player " + std::to_string(playerId) + " stopped receiving LAN multicast, back to unicast");
+                SendGameStateToClient(playerId);
+                activeClientCount++;
+                continue;
+            }
             if (client.isActive) {
-                sf::Socket::Status sendStatus = socket.send(packet, client.address, client.port);
-
-                if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
-                    Utils::printMsg("Failed to send game state to player " + std::to_string(playerId) +
-                        " - Status: " + SocketStatusToString(sendStatus), warning);
+                // With the pipeline the snapshot is built straight into the client's send job
+                SnapshotPipeline::ClientJob* job = sendFrame ? &AddSendJob(client) : nullptr;
+                WorldSnapshot& snapshot = job ? job->snapshot : clientSnapshot;
+                BuildClientSnapshot(client, worldSnapshot, snapshot);
+                const uint64_t holds = scheduledEntityHolds + deadReckonedHolds + deferredEntityUpdates;
+                ApplyReplicationSchedule(client, snapshot);
+                ApplyDeadReckoning(client, snapshot);
+                ApplyReplicationBudget(client, snapshot);
+                if (scheduledEntityHolds + deadReckonedHolds + deferredEntityUpdates != holds) {
+                    snapshot.contentKey = 0;    // Tailored to this client: nobody else shares its encoding
+                }
+                if (job) {
+                    StageSnapshotForClient(client, *job, messageSequence);
                 }
+                else {
+                    SendSnapshotToClient(client, snapshot, messageSequence);
+                }
+                SendInterestUpdate(client, client.enemyInterest);
+                activeClientCount++;
             }
         }
+        if (spectatorStream.HasSpectators()) {
+            PublishSpectatorFrame();
+        }
+        if (IsLanMulticastEnabled()) {
+            PublishLanFrame();
+        }
 
-        static int syncCounter = 0;
+        static thread_local int syncCounter = 0;
         if (++syncCounter % 100 == 0) {
-            Utils::printMsg("Synced " + std::to_string(enemyCount) + " enemies to " +
-                std::to_string(activeClientCount) + " clients", debug);
+            LOG_MSG(debug, "Synced " + std::to_string(worldSnapshot.enemies.size()) + " enemies to " +
+                std::to_string(activeClientCount) + " clients");
         }
     }
     catch (const std::exception& e) {
@@ -632,79 +1623,171 @@ void GameServer::SendGameStateToAll() {
     }
 }
 
-void GameServer::SendGameStateToClient(uint32_t playerId) {
-    auto it = clients.find(playerId);
-    if (it == clients.end() || !it->second.isActive) return;
-
-    try {
-        sf::Packet packet;
-        packet << static_cast<uint8_t>(NetMessageType::GAME_STATE);
-
-        uint32_t activeClientCount = 0;
-        for (const auto& [id, client] : clients) {
-            if (client.isActive) {
-                activeClientCount++;
-            }
-        }
-        packet << activeClientCount;
-
-        for (auto& [id, client] : clients) {  // Changed to non-const
-            if (client.isActive) {
-                //  Sync client.score to client.playerData.score before sending
-                client.playerData.score = client.score;
-                client.playerData.isDead = client.isDead;
+/**
+ * Encodes this state tick for every spectator at once, from the world
+ * snapshot the clients' snapshots were just built from. Spectators see every
+ * entity: the delay, not interest, keeps the stream from helping a player.
+ */
+void GameServer::PublishSpectatorFrame() {
+    TRACE_SCOPE("Encode spectator frame", "snapshot");
+    PlayerListMessage* table = nullptr;
+    if (spectatorStream.NeedsPlayerTable(playerTableVersion)) {
+        FillPlayerTableMessage();
+        table = &playerTableMessage;
+    }
+    CollectBullets(spectatorBullets);
+    spectatorStream.Publish(worldSnapshot, table, spectatorBullets, GetCurrentTimestamp());
+}
 
-                packet << client.playerData.playerId << client.playerData.playerName
-                    << client.playerData.x << client.playerData.y
-                    << client.playerData.bodyRotation << client.playerData.barrelRotation
-                    << client.playerData.color << client.playerData.isMoving_forward
-                    << client.playerData.isMoving_backward << client.playerData.isMoving_left
-                    << client.playerData.isMoving_right << client.playerData.health
-                    << client.playerData.maxHealth << client.playerData.score
-                    << client.playerData.isDead;
-            }
+void GameServer::CollectBullets(std::vector<BulletData>& out) const {
+    out.clear();
+    for (uint32_t slot : projectiles.GetActiveSlots()) {
+        if (!projectiles.IsDestroyed(slot)) {
+            out.push_back(BulletToBulletData(slot));
         }
+    }
+}
 
-        uint32_t enemyCount = static_cast<uint32_t>(enemies.size());
-        packet << enemyCount;
-
-        for (const auto& [enemyId, enemy] : enemies) {
-            if (enemy) {
-                EnemyData enemyData;
-                enemyData.enemyId = enemyId;
-                enemyData.enemyType = static_cast<uint8_t>(enemy->GetEnemyType());
-                enemyData.x = enemy->GetPosition().x;
-                enemyData.y = enemy->GetPosition().y;
-                enemyData.bodyRotation = enemy->GetBodyRotation().asDegrees();
-                enemyData.barrelRotation = enemy->GetBarrelRotation().asDegrees();
-                enemyData.health = enemy->GetHealth();
-                enemyData.maxHealth = enemy->GetMaxHealth();
+/**
+ * Multicasts this state tick's frame (released in FlushOutgoing) and sends
+ * each client on group delivery the input its tank in that frame reflects.
+ * The frame goes out while any client is still on unicast too: their status
+ * reports are what shows the group reaching them.
+ */
+void GameServer::PublishLanFrame() {
+    TRACE_SCOPE("Encode LAN multicast frame", "snapshot");
+    PlayerListMessage* table = nullptr;
+    if (lanStream.NeedsPlayerTable(playerTableVersion)) {
+        FillPlayerTableMessage();
+        table = &playerTableMessage;
+    }
+    CollectBullets(spectatorBullets);
+    lanStream.Publish(worldSnapshot, table, spectatorBullets, GetCurrentTimestamp());
 
-                packet << enemyData.enemyId
-                    << enemyData.enemyType
-                    << enemyData.x
-                    << enemyData.y
-                    << enemyData.bodyRotation
-                    << enemyData.barrelRotation
-                    << enemyData.health
-                    << enemyData.maxHealth;
-            }
+    if (groupDeliveryClients == 0) {
+        return;
+    }
+    GroupStateAckMessage ackMsg;
+    ackMsg.frameSequence = lanStream.GetFrameSequence();
+    for (auto& [playerId, client] : clients) {
+        if (client.isActive && client.groupDelivery) {
+            ackMsg.lastAckedInput = client.lastAcknowledgedInputSeq;
+            ackMsg.inputApplyMicros = client.lastInputApplyMicros;
+            PacketPool::Lease packet = sendPackets.Borrow();
+            *packet << ackMsg;
+            QueueForClient(client, *packet);
         }
+    }
+}
 
-        int64_t timestamp = GetCurrentTimestamp();
-        uint32_t lastAckedInput = 0;
-        packet << timestamp << outgoingSequenceNumber++ << lastAckedInput;
+/**
+ * Names the group to a client that just joined. Reliable, since the offer is
+ * made once; clients that cannot join simply never report frames.
+ */
+void GameServer::OfferLanMulticast(ClientInfo& client) {
+    if (!IsLanMulticastEnabled()) {
+        return;
+    }
+    MulticastGroupMessage groupMsg;
+    groupMsg.groupAddress = lanGroup.toInteger();
+    groupMsg.groupPort = lanGroupPort;
+    PacketPool::Lease packet = sendPackets.Borrow();
+    *packet << groupMsg;
+    QueueReliableForClient(client, *packet);
+}
 
-        sf::Socket::Status sendStatus = socket.send(packet, it->second.address, it->second.port);
+/**
+ * A report that advances moves the client to group delivery (from the next
+ * frame, a keyframe so it can start decoding at once). Reports that stop
+ * advancing are caught in SendGameStateToAll, which falls back to unicast.
+ */
+void GameServer::HandleMulticastStatus(const MulticastStatusMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
+    auto it = clients.find(msg.playerId);
+    if (!IsLanMulticastEnabled() || it == clients.end() ||
+        it->second.address != clientIP || it->second.port != clientPort) {
+        return;
+    }
+    ClientInfo& client = it->second;
+    if (msg.lastGroupFrame <= client.lastGroupFrame || msg.lastGroupFrame > lanStream.GetFrameSequence()) {
+        return;
+    }
+    client.lastGroupFrame = msg.lastGroupFrame;
+    client.lastGroupProgressMs = GetCurrentTimestamp();
+    if (!client.groupDelivery) {
+        client.groupDelivery = true;
+        client.enemyInterest.Clear();
+        client.bulletInterest.Clear();
+        lanStream.RequestKeyframe();
+        LOG_MSG(info, "Player " + std::to_string(msg.playerId) + " receives LAN multicast, snapshots now go to the group");
+    }
+}
 
-        if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
-            Utils::printMsg("Failed to send initial game state to player " + std::to_string(playerId) +
-                " - Status: " + SocketStatusToString(sendStatus), warning);
-        }
-        else {
-            Utils::printMsg("Sent initial game state with " + std::to_string(enemyCount) +
-                " enemies to player " + std::to_string(playerId), debug);
-        }
+/**
+ * Drops the client's baselines, so the next snapshot is a full one; acks
+ * still in flight for older snapshots find nothing in the history. Only
+ * the first request about a snapshot since the last resync counts: the rest
+ * were sent before the full snapshot could arrive.
+ */
+void GameServer::HandleStateResync(const StateResyncMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
+    auto it = clients.find(msg.playerId);
+    if (it == clients.end() || !it->second.isActive ||
+        it->second.address != clientIP || it->second.port != clientPort) {
+        return;
+    }
+    ClientInfo& client = it->second;
+    if (msg.snapshotSequence < client.resyncSnapshot || msg.snapshotSequence >= client.nextSnapshotSequence) {
+        return;
+    }
+    client.snapshotHistory.Clear();
+    client.lastAckedSnapshot = 0;
+    client.resyncSnapshot = client.nextSnapshotSequence;
+    stateResyncs++;
+    LOG_SAMPLED(LogCategory::STATE_RESYNC, warning, "Player " + std::to_string(msg.playerId) +
+        " failed the state hash of snapshot " + std::to_string(msg.snapshotSequence) + ", resyncing");
+}
+
+/**
+ * Adds a client's telemetry window to the totals on the metrics page and
+ * logs its gist, so a player's hitches can be found in the log by time too.
+ */
+void GameServer::HandleClientTelemetry(const ClientTelemetryMessage& msg, sf::IpAddress clientIP, unsigned short clientPort) {
+    auto it = clients.find(msg.playerId);
+    if (it == clients.end() || !it->second.isActive ||
+        it->second.address != clientIP || it->second.port != clientPort || msg.windowMs == 0) {
+        return;
+    }
+    clientTelemetry.Add(msg);
+
+    uint32_t frames = 0;
+    for (uint16_t count : msg.frameMs) {
+        frames += count;
+    }
+    const uint32_t spikes = ClientTelemetry::CountFrom(msg.frameMs, ClientTelemetry::FRAME_MS_BOUNDS,
+        ClientTelemetry::SPIKE_FRAME_MS);
+    const auto percent = [](uint32_t part, uint32_t whole) {
+        return whole > 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+    };
+    char summary[160];
+    std::snprintf(summary, sizeof(summary),
+        "Telemetry from player %u: %.0f fps over %.0f s - %u frames of %.0f+ ms - %.1f%% extrapolated - %.1f%% mispredicted",
+        static_cast<unsigned>(msg.playerId), frames * 1000.0 / msg.windowMs, msg.windowMs / 1000.0,
+        static_cast<unsigned>(spikes), static_cast<double>(ClientTelemetry::SPIKE_FRAME_MS),
+        percent(msg.extrapolatedEntityFrames, msg.entityFrames), percent(msg.mispredictions, msg.reconciliations));
+    LOG_MSG(debug, summary);
+}
+
+/**
+ * Sends a full snapshot to one client (join or rejoin).
+ * Any previous baselines are discarded because the client starts from nothing.
+ */
+void GameServer::SendGameStateToClient(uint32_t playerId) {
+    auto it = clients.find(playerId);
+    if (it == clients.end() || !it->second.isActive) return;
+
+    try {
+        UpdateWorldSnapshot();
+        IndexEnemyChunks();
+        SendFullState(it->second, playerId);
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in SendGameStateToClient: " + std::string(e.what()), error);
@@ -714,230 +1797,2587 @@ void GameServer::SendGameStateToClient(uint32_t playerId) {
     }
 }
 
-void GameServer::RemoveInactiveClients(float deltaTime) {
+/**
+ * The first state of everyone who joined this tick, from a single update of
+ * the world snapshot: a burst of joins costs one rebuild, not one each, and
+ * the players already in are sent nothing extra.
+ */
+void GameServer::SendJoinStates() {
     try {
-        std::vector<uint32_t> toRemove;
+        UpdateWorldSnapshot();
+        IndexEnemyChunks();
+        for (uint32_t playerId : joinStatePending) {
+            auto it = clients.find(playerId);
+            if (it != clients.end() && it->second.isActive) {
+                SendFullState(it->second, playerId);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SendJoinStates: " + std::string(e.what()), error);
+    }
+    joinStatePending.clear();
+}
 
-        for (auto& [playerId, client] : clients) {
-            if (client.isActive) {
-                client.lastUpdateTime += deltaTime;
-                if (client.lastUpdateTime > clientTimeoutDuration) {
-                    Utils::printMsg("Player " + std::to_string(playerId) + " (" + client.playerData.playerName + ") timed out", warning);
-                    client.isActive = false;
-                    toRemove.push_back(playerId);
-                }
+/**
+ * Forgets what the client was sent: its baselines, player table and interest
+ * sets, so the next state it gets is complete. Back on unicast until its
+ * multicast reports advance again.
+ */
+void GameServer::ResetClientReplication(ClientInfo& client) {
+    client.groupDelivery = false;
+    client.snapshotHistory.Clear();
+    client.lastAckedSnapshot = 0;
+    client.ackedPlayerTableVersion = 0;
+    client.enemyInterest.Clear();
+    client.bulletInterest.Clear();
+}
+
+/**
+ * Player table, full snapshot and interest update, against the current
+ * (indexed) world snapshot.
+ */
+void GameServer::SendFullState(ClientInfo& client, uint32_t playerId) {
+    ResetClientReplication(client);
+    SendPlayerTable(client);
+    BuildClientSnapshot(client, worldSnapshot, clientSnapshot);
+    SendSnapshotToClient(client, clientSnapshot, outgoingSequenceNumber++);
+    SendInterestUpdate(client, client.enemyInterest);
+
+    LOG_MSG(debug, "Sent initial game state with " + std::to_string(clientSnapshot.enemies.size()) +
+        " enemies to player " + std::to_string(playerId));
+}
+
+/**
+ * Writes the current player table (names and colors of all active players)
+ * into playerTableMessage; the sender sets the sequence number.
+ */
+void GameServer::FillPlayerTableMessage() {
+    PlayerListMessage& msg = playerTableMessage;
+    msg.tableVersion = playerTableVersion;
+    size_t count = 0;
+    for (const auto& [playerId, other] : clients) {
+        if (other.isActive) {
+            // Entries are overwritten in place so the names keep their buffers
+            if (count == msg.players.size()) {
+                msg.players.emplace_back();
             }
+            PlayerInfo& info = msg.players[count++];
+            info.playerId = playerId;
+            info.playerName = other.playerName;
+            info.color = SimOf(other).player.color;
         }
+    }
+    msg.players.resize(count);
+    msg.timestamp = GetCurrentTimestamp();
+}
 
-        for (uint32_t playerId : toRemove) {
-            BroadcastPlayerLeft(playerId);
-            clients.erase(playerId);
+/**
+ * Sends the current player table.
+ * @param client Recipient; its sent version and time are updated
+ */
+void GameServer::SendPlayerTable(ClientInfo& client) {
+    FillPlayerTableMessage();
+    PlayerListMessage& msg = playerTableMessage;
+    msg.sequenceNumber = outgoingSequenceNumber++;
+
+    PacketPool::Lease packet = sendPackets.Borrow();
+    *packet << msg;
+
+    client.sentPlayerTableVersion = playerTableVersion;
+    client.playerTableSentTime = msg.timestamp;
+
+    QueueForClient(client, *packet);
+}
+
+/**
+ * Sends the player table to clients that have not acked the current version:
+ * immediately when the version changed, otherwise every PLAYER_TABLE_RESEND_MS
+ * until the ack arrives (UDP gives no delivery guarantee).
+ */
+void GameServer::SendPlayerTableUpdates() {
+    const int64_t now = GetCurrentTimestamp();
+    for (auto& [playerId, client] : clients) {
+        if (!client.isActive || client.ackedPlayerTableVersion == playerTableVersion) {
+            continue;
+        }
+        if (client.sentPlayerTableVersion != playerTableVersion ||
+            now - client.playerTableSentTime >= PLAYER_TABLE_RESEND_MS) {
+            SendPlayerTable(client);
         }
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception in RemoveInactiveClients: " + std::string(e.what()), error);
+}
+
+namespace {
+    // Entry with this ID in a snapshot section sorted by ID, or count if absent
+    template <typename Entity, typename GetId>
+    size_t FindSnapshotEntry(const std::vector<Entity>& entities, uint32_t id, GetId getId) {
+        auto it = std::lower_bound(entities.begin(), entities.end(), id,
+            [&getId](const Entity& entity, uint32_t value) { return getId(entity) < value; });
+        return (it != entities.end() && getId(*it) == id) ? static_cast<size_t>(it - entities.begin()) : entities.size();
     }
-    catch (...) {
-        Utils::printMsg("Unknown exception in RemoveInactiveClients", error);
+
+    float PriorityDistanceWeight(sf::Vector2f viewer, float x, float y, float scale) {
+        const float dx = x - viewer.x;
+        const float dy = y - viewer.y;
+        return 1.0f / (1.0f + std::sqrt(dx * dx + dy * dy) / scale);
+    }
+
+    // Puts back the motion last sent (position, rotations, movement), keeping
+    // the rest current. @return True if that held anything back
+    bool HoldPlayerMotion(PlayerData& player, const PlayerData& sent) {
+        PlayerData held = sent;
+        held.color = player.color;
+        held.health = player.health;
+        held.maxHealth = player.maxHealth;
+        held.score = player.score;
+        held.isDead = player.isDead;
+        const bool changed = SnapshotDelta::DiffPlayer(held, player) != 0;
+        player = held;
+        return changed;
+    }
+
+    bool HoldEnemyMotion(EnemyData& enemy, const EnemyData& sent) {
+        EnemyData held = sent;
+        held.enemyType = enemy.enemyType;
+        held.health = enemy.health;
+        held.maxHealth = enemy.maxHealth;
+        const bool changed = SnapshotDelta::DiffEnemy(held, enemy) != 0;
+        enemy = held;
+        return changed;
+    }
+
+    // The state the client interpolates, as it buffers it
+    EntitySnapshot PlayerMotion(const PlayerData& player, int64_t time) {
+        EntitySnapshot motion(time, sf::Vector2f(player.x, player.y),
+            sf::degrees(player.bodyRotation), sf::degrees(player.barrelRotation));
+        motion.isMoving_forward = player.isMoving_forward;
+        motion.isMoving_backward = player.isMoving_backward;
+        motion.isMoving_left = player.isMoving_left;
+        motion.isMoving_right = player.isMoving_right;
+        return motion;
+    }
+
+    EntitySnapshot EnemyMotion(const EnemyData& enemy, int64_t time) {
+        return EntitySnapshot(time, sf::Vector2f(enemy.x, enemy.y),
+            sf::degrees(enemy.bodyRotation), sf::degrees(enemy.barrelRotation));
+    }
+}
+
+/**
+ * Brings the world snapshot up to date for a broadcast. While the same players
+ * and enemies exist only entities with dirty fields are visited, each written
+ * in place; a join, leave, spawn or removal rebuilds it instead.
+ */
+void GameServer::UpdateWorldSnapshot() {
+    worldSnapshotVersion++;
+    if (enemySetChanged || worldSnapshotPlayerTable != playerTableVersion) {
+        RebuildWorldSnapshot();
+        return;
+    }
+    const auto playerId = [](const PlayerData& player) { return player.playerId; };
+    const auto enemyId = [](const EnemyData& enemy) { return enemy.enemyId; };
+
+    size_t activePlayers = 0;
+    bool missing = false;
+    for (auto& [id, client] : clients) {
+        if (!client.isActive) {
+            continue;
+        }
+        activePlayers++;
+        if (SimOf(client).dirtyFields == 0) {
+            continue;
+        }
+        const size_t index = FindSnapshotEntry(worldSnapshot.players, id, playerId);
+        if (index == worldSnapshot.players.size()) {
+            missing = true;
+            break;
+        }
+        worldSnapshot.players[index] = SimOf(client).player;
+        SimOf(client).dirtyFields = 0;
+        dirtyEntityWrites++;
+    }
+    if (missing || activePlayers != worldSnapshot.players.size()) {
+        RebuildWorldSnapshot();
+        return;
+    }
+
+    auto dirtyView = enemyRegistry.view<const ServerComponents::Dirty, const ServerComponents::NetworkId,
+        const ServerComponents::Transform, const ServerComponents::Health>();
+    for (auto [entity, dirty, networkId, transform, health] : dirtyView.each()) {
+        const size_t index = FindSnapshotEntry(worldSnapshot.enemies, networkId.id, enemyId);
+        if (index == worldSnapshot.enemies.size()) {
+            RebuildWorldSnapshot();
+            return;
+        }
+        EnemyData& enemyData = worldSnapshot.enemies[index];
+        if (dirty.fields & SnapshotDelta::ENEMY_POSITION) {
+            enemyData.x = transform.position.x;
+            enemyData.y = transform.position.y;
+        }
+        if (dirty.fields & SnapshotDelta::ENEMY_BODY_ROTATION) enemyData.bodyRotation = transform.bodyRotation;
+        if (dirty.fields & SnapshotDelta::ENEMY_BARREL_ROTATION) enemyData.barrelRotation = transform.barrelRotation;
+        if (dirty.fields & SnapshotDelta::ENEMY_HEALTH) enemyData.health = health.current;
+        if (dirty.fields & SnapshotDelta::ENEMY_MAX_HEALTH) enemyData.maxHealth = health.max;
+        dirtyEntityWrites++;
+    }
+    enemyRegistry.clear<ServerComponents::Dirty>();
+}
+
+/**
+ * Captures the replicated state of all active players and enemies, sorted by
+ * ID, and clears every dirty mask.
+ */
+void GameServer::RebuildWorldSnapshot() {
+    worldSnapshot.sequence = 0;
+    worldSnapshot.players.clear();
+    worldSnapshot.enemies.clear();
+
+    for (auto& [playerId, client] : clients) {
+        if (client.isActive) {
+            worldSnapshot.players.push_back(SimOf(client).player);
+        }
+        SimOf(client).dirtyFields = 0;
+    }
+
+    auto enemyView = enemyRegistry.view<const ServerComponents::NetworkId, const ServerComponents::Transform,
+        const ServerComponents::Health, const ServerComponents::EnemyKind>();
+    for (auto [entity, networkId, transform, health, kind] : enemyView.each()) {
+        EnemyData enemyData;
+        enemyData.enemyId = networkId.id;
+        enemyData.enemyType = static_cast<uint8_t>(kind.type);
+        enemyData.x = transform.position.x;
+        enemyData.y = transform.position.y;
+        enemyData.bodyRotation = transform.bodyRotation;
+        enemyData.barrelRotation = transform.barrelRotation;
+        enemyData.health = health.current;
+        enemyData.maxHealth = health.max;
+        worldSnapshot.enemies.push_back(enemyData);
     }
+    enemyRegistry.clear<ServerComponents::Dirty>();
+
+    worldSnapshot.SortById();
+    worldSnapshotPlayerTable = playerTableVersion;
+    enemySetChanged = false;
+    worldSnapshotRebuilds++;
 }
 
-void GameServer::BroadcastPlayerLeft(uint32_t playerId) {
-    SendGameStateToAll();
+void GameServer::IndexEnemyChunks() {
+    enemyChunks.Rebuild(worldSnapshot.enemies.size(), [this](size_t index) {
+        return sf::Vector2f(worldSnapshot.enemies[index].x, worldSnapshot.enemies[index].y);
+    });
 }
 
-uint32_t GameServer::FindPlayerByAddress(sf::IpAddress address, unsigned short port) {
-    for (const auto& [playerId, client] : clients) {
-        if (client.address == address && client.port == port) {
-            return playerId;
+/**
+ * Copies the world snapshot for one client, keeping only enemies inside its area
+ * of interest. Only the enemies in the chunks around the client are looked at.
+ * Players are always replicated (scoreboard and player list need them). The
+ * content key hashes the world snapshot version with the enemy IDs kept, so
+ * clients with the same interest set get the same key.
+ * @param client Recipient; its enemy interest set is updated
+ * @param world Full world snapshot, indexed by enemyChunks
+ * @param out Filtered snapshot (reused buffer)
+ */
+void GameServer::BuildClientSnapshot(ClientInfo& client, const WorldSnapshot& world, WorldSnapshot& out) {
+    out.sequence = 0;
+    out.players = world.players;
+    out.enemies.clear();
+
+    uint64_t key = FNV_OFFSET_BASIS;
+    HashValue(key, worldSnapshotVersion);
+
+    client.enemyInterest.BeginUpdate(sf::Vector2f(SimOf(client).player.x, SimOf(client).player.y), interestSettings);
+    GatherNearby(enemyChunks, client, client.nearbyEnemies);
+    for (uint32_t index : client.nearbyEnemies) {
+        const EnemyData& enemy = world.enemies[index];
+        if (client.enemyInterest.Consider(enemy.enemyId, sf::Vector2f(enemy.x, enemy.y))) {
+            out.enemies.push_back(enemy);  // Stays sorted: indices ascend and world is sorted by ID
+            HashValue(key, enemy.enemyId);
         }
     }
-    return 0;
+    client.enemyInterest.EndUpdate();
+    out.contentKey = key != 0 ? key : 1;
 }
 
-std::string GameServer::AssignColor() {
-    std::vector<std::string> usedColors;
-    for (const auto& [playerId, client] : clients) {
-        usedColors.push_back(client.playerData.color);
+/**
+ * Holds back the entities whose replication category is not due on this
+ * snapshot for the client: they keep the state from the previous snapshot
+ * sent, so the delta carries nothing for them, apart from health, score and
+ * death, which always go through. A player coming back to life is sent in
+ * full so its respawn position arrives with it. Own tank and entities the
+ * client has never been sent are never held.
+ * @param client Recipient
+ * @param snapshot Interest-filtered snapshot for the client, edited in place
+ */
+void GameServer::ApplyReplicationSchedule(ClientInfo& client, WorldSnapshot& snapshot) {
+    const uint32_t pass = client.replicationPass++;
+    const WorldSnapshot* previous = client.snapshotHistory.Find(client.nextSnapshotSequence - 1);
+    if (!previous) {
+        return;
+    }
+    const auto playerId = [](const PlayerData& player) { return player.playerId; };
+    const auto enemyId = [](const EnemyData& enemy) { return enemy.enemyId; };
+    const sf::Vector2f viewer(SimOf(client).player.x, SimOf(client).player.y);
+    const float nearDistanceSquared = replicationRates.nearDistance * replicationRates.nearDistance;
+    // nearCategory + 1 is its far counterpart
+    const auto isDue = [&](ReplicationCategory nearCategory, uint32_t id, float x, float y) {
+        const float dx = x - viewer.x;
+        const float dy = y - viewer.y;
+        const uint32_t interval = replicationIntervals[dx * dx + dy * dy <= nearDistanceSquared ?
+            nearCategory : nearCategory + 1];
+        return (pass + id) % interval == 0;
+    };
+
+    if (replicationIntervals[FAR_PLAYERS] > 1 || replicationIntervals[NEAR_PLAYERS] > 1) {
+        for (PlayerData& player : snapshot.players) {
+            if (player.playerId == SimOf(client).player.playerId || isDue(NEAR_PLAYERS, player.playerId, player.x, player.y)) {
+                continue;
+            }
+            const size_t last = FindSnapshotEntry(previous->players, player.playerId, playerId);
+            if (last == previous->players.size() || (previous->players[last].isDead && !player.isDead)) {
+                continue;
+            }
+            if (HoldPlayerMotion(player, previous->players[last])) {
+                scheduledEntityHolds++;
+            }
+        }
+    }
+
+    if (replicationIntervals[FAR_ENEMIES] > 1 || replicationIntervals[NEAR_ENEMIES] > 1) {
+        for (EnemyData& enemy : snapshot.enemies) {
+            if (isDue(NEAR_ENEMIES, enemy.enemyId, enemy.x, enemy.y)) {
+                continue;
+            }
+            const size_t last = FindSnapshotEntry(previous->enemies, enemy.enemyId, enemyId);
+            if (last == previous->enemies.size()) {
+                continue;
+            }
+            if (HoldEnemyMotion(enemy, previous->enemies[last])) {
+                scheduledEntityHolds++;
+            }
+        }
+    }
+}
+
+/**
+ * Holds back the motion of every entity the client can still extrapolate
+ * well enough: it keeps the state from the previous snapshot sent, as with
+ * the replication schedule. Own tank, entities without a model yet and
+ * players coming back to life always go out.
+ * @param client Recipient
+ * @param snapshot Interest-filtered snapshot for the client, edited in place
+ */
+void GameServer::ApplyDeadReckoning(ClientInfo& client, WorldSnapshot& snapshot) {
+    if (!deadReckoningSettings.enabled) {
+        return;
     }
+    const WorldSnapshot* previous = client.snapshotHistory.Find(client.nextSnapshotSequence - 1);
+    if (!previous) {
+        return;
+    }
+    const auto playerId = [](const PlayerData& player) { return player.playerId; };
+    const auto enemyId = [](const EnemyData& enemy) { return enemy.enemyId; };
+    const int64_t now = GetCurrentTimestamp();
 
-    for (const std::string& color : availableColors) {
-        if (std::find(usedColors.begin(), usedColors.end(), color) == usedColors.end()) {
-            return color;
+    for (PlayerData& player : snapshot.players) {
+        if (player.playerId == SimOf(client).player.playerId) {
+            continue;
+        }
+        const size_t last = FindSnapshotEntry(previous->players, player.playerId, playerId);
+        if (last == previous->players.size() || (previous->players[last].isDead && !player.isDead)) {
+            continue;
+        }
+        auto model = client.deadReckonedEntities.find(player.playerId);
+        if (model != client.deadReckonedEntities.end() && IsDeadReckoned(model->second, PlayerMotion(player, now)) &&
+            HoldPlayerMotion(player, previous->players[last])) {
+            deadReckonedHolds++;
         }
     }
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, static_cast<int>(availableColors.size()) - 1);
-    return availableColors[dist(gen)];
+    for (EnemyData& enemy : snapshot.enemies) {
+        const size_t last = FindSnapshotEntry(previous->enemies, enemy.enemyId, enemyId);
+        if (last == previous->enemies.size()) {
+            continue;
+        }
+        auto model = client.deadReckonedEntities.find(enemy.enemyId | DEAD_RECKONING_ENEMY_KEY);
+        if (model != client.deadReckonedEntities.end() && IsDeadReckoned(model->second, EnemyMotion(enemy, now)) &&
+            HoldEnemyMotion(enemy, previous->enemies[last])) {
+            deadReckonedHolds++;
+        }
+    }
 }
 
-void GameServer::PrintServerStats() {
-    if (clients.empty()) {
-        Utils::printMsg("Server running - No players connected - Enemies: " +
-            std::to_string(enemies.size()));
+/**
+ * Whether actual is still within the thresholds of where the client
+ * extrapolates the entity to, and the last state sent is young enough.
+ */
+bool GameServer::IsDeadReckoned(const ClientInfo::DeadReckonedEntity& model, const EntitySnapshot& actual) const {
+    const EntitySnapshot& newest = model.newest;
+    if (actual.timestamp - newest.timestamp >= static_cast<int64_t>(deadReckoningSettings.maxAgeMs) ||
+        actual.isMoving_forward != newest.isMoving_forward || actual.isMoving_backward != newest.isMoving_backward ||
+        actual.isMoving_left != newest.isMoving_left || actual.isMoving_right != newest.isMoving_right) {
+        return false;
     }
-    else {
-        std::string playerList = "Server running - " + std::to_string(clients.size()) +
-            " players connected - Enemies: " + std::to_string(enemies.size()) +
-            " - Players: ";
-        for (const auto& [playerId, client] : clients) {
-            if (client.isActive) {
-                playerList += client.playerData.playerName + " ";
+    const EntitySnapshot predicted = InterpolationManager::Extrapolate(model.hasOlder ? &model.older : nullptr,
+        newest, actual.timestamp);
+    const sf::Vector2f error = actual.position - predicted.position;
+    const float threshold = deadReckoningSettings.positionThreshold;
+    return error.x * error.x + error.y * error.y <= threshold * threshold &&
+        std::abs((actual.bodyRotation - predicted.bodyRotation).wrapSigned().asDegrees()) <=
+            deadReckoningSettings.rotationThreshold &&
+        std::abs((actual.barrelRotation - predicted.barrelRotation).wrapSigned().asDegrees()) <=
+            deadReckoningSettings.rotationThreshold;
+}
+
+/**
+ * Updates the client's dead reckoning models from the snapshot just sent,
+ * buffering a state the way the client does (a repeat of the newest is
+ * skipped), and forgets entities the snapshot no longer has.
+ * @param client Recipient
+ * @param sent Snapshot as sent
+ * @param timestamp Its server timestamp, which the client stamps the states with
+ */
+void GameServer::RecordDeadReckoning(ClientInfo& client, const WorldSnapshot& sent, int64_t timestamp) {
+    const uint32_t pass = ++client.deadReckoningPass;
+    const auto record = [&client, pass](uint32_t key, const EntitySnapshot& motion) {
+        auto [it, added] = client.deadReckonedEntities.try_emplace(key);
+        ClientInfo::DeadReckonedEntity& model = it->second;
+        if (added) {
+            model.newest = motion;
+        }
+        else if (!InterpolationManager::IsRepeat(model.newest, motion)) {
+            model.older = model.newest;
+            model.hasOlder = true;
+            model.newest = motion;
+        }
+        model.pass = pass;
+    };
+
+    for (const PlayerData& player : sent.players) {
+        if (player.playerId != SimOf(client).player.playerId) {
+            record(player.playerId, PlayerMotion(player, timestamp));
+        }
+    }
+    for (const EnemyData& enemy : sent.enemies) {
+        record(enemy.enemyId | DEAD_RECKONING_ENEMY_KEY, EnemyMotion(enemy, timestamp));
+    }
+    for (auto it = client.deadReckonedEntities.begin(); it != client.deadReckonedEntities.end();) {
+        if (it->second.pass != pass) {
+            it = client.deadReckonedEntities.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Fits a client snapshot into the client's bandwidth budget. Its own tank and
+ * entities it has never been sent always go out. Every other entity with
+ * something new competes on accumulated priority, highest first while the
+ * estimated size fits; the others keep their state from the previous snapshot
+ * sent, so the delta carries nothing new for them and the client never sees
+ * them step back. No-op while the client's bandwidth is unlimited.
+ * @param client Recipient
+ * @param snapshot Interest-filtered snapshot for the client, edited in place
+ */
+void GameServer::ApplyReplicationBudget(ClientInfo& client, WorldSnapshot& snapshot) {
+    if (!client.budget.IsLimited()) {
+        return;
+    }
+    const WorldSnapshot* previous = client.snapshotHistory.Find(client.nextSnapshotSequence - 1);
+    if (!previous) {
+        return;  // Starting from a full snapshot: nothing to fall back on
+    }
+    const WorldSnapshot* baseline = client.snapshotHistory.Find(client.lastAckedSnapshot);
+    const auto playerId = [](const PlayerData& player) { return player.playerId; };
+    const auto enemyId = [](const EnemyData& enemy) { return enemy.enemyId; };
+    const sf::Vector2f viewer(SimOf(client).player.x, SimOf(client).player.y);
+
+    float availableBits = (client.budget.GetAvailable() - static_cast<float>(SNAPSHOT_OVERHEAD_BYTES)) * 8.0f;
+    replicationCandidates.clear();
+
+    client.playerPriority.BeginPass();
+    for (size_t i = 0; i < snapshot.players.size(); ++i) {
+        const PlayerData& player = snapshot.players[i];
+        const size_t acked = baseline ? FindSnapshotEntry(baseline->players, player.playerId, playerId) : 0;
+        const size_t bits = SnapshotDelta::EstimatePlayerBits(baseline && acked < baseline->players.size()
+            ? SnapshotDelta::DiffPlayer(baseline->players[acked], player) : SnapshotDelta::PLAYER_ALL);
+        const size_t last = FindSnapshotEntry(previous->players, player.playerId, playerId);
+        client.playerPriority.Touch(player.playerId);
+        if (last == previous->players.size() || player.playerId == SimOf(client).player.playerId) {
+            availableBits -= static_cast<float>(bits);
+            continue;
+        }
+        const uint16_t changes = SnapshotDelta::DiffPlayer(previous->players[last], player);
+        if (changes == 0) {
+            continue;
+        }
+        float weight = PLAYER_PRIORITY_WEIGHT * PriorityDistanceWeight(viewer, player.x, player.y, PRIORITY_DISTANCE_SCALE);
+        if (changes & (SnapshotDelta::PLAYER_HEALTH | SnapshotDelta::PLAYER_SCORE | SnapshotDelta::PLAYER_DEAD)) {
+            weight *= STATUS_PRIORITY_FACTOR;
+        }
+        replicationCandidates.push_back({ client.playerPriority.Accumulate(player.playerId, weight), bits, i, last, true });
+    }
+
+    client.enemyPriority.BeginPass();
+    for (size_t i = 0; i < snapshot.enemies.size(); ++i) {
+        const EnemyData& enemy = snapshot.enemies[i];
+        const size_t acked = baseline ? FindSnapshotEntry(baseline->enemies, enemy.enemyId, enemyId) : 0;
+        const size_t bits = SnapshotDelta::EstimateEnemyBits(baseline && acked < baseline->enemies.size()
+            ? SnapshotDelta::DiffEnemy(baseline->enemies[acked], enemy) : SnapshotDelta::ENEMY_ALL);
+        const size_t last = FindSnapshotEntry(previous->enemies, enemy.enemyId, enemyId);
+        client.enemyPriority.Touch(enemy.enemyId);
+        if (last == previous->enemies.size()) {
+            availableBits -= static_cast<float>(bits);
+            continue;
+        }
+        const uint8_t changes = SnapshotDelta::DiffEnemy(previous->enemies[last], enemy);
+        if (changes == 0) {
+            continue;
+        }
+        float weight = ENEMY_PRIORITY_WEIGHT * PriorityDistanceWeight(viewer, enemy.x, enemy.y, PRIORITY_DISTANCE_SCALE);
+        if (changes & SnapshotDelta::ENEMY_HEALTH) {
+            weight *= STATUS_PRIORITY_FACTOR;
+        }
+        replicationCandidates.push_back({ client.enemyPriority.Accumulate(enemy.enemyId, weight), bits, i, last, false });
+    }
+
+    std::sort(replicationCandidates.begin(), replicationCandidates.end(),
+        [](const ReplicationCandidate& a, const ReplicationCandidate& b) { return a.priority > b.priority; });
+    for (const ReplicationCandidate& candidate : replicationCandidates) {
+        if (static_cast<float>(candidate.bits) <= availableBits) {
+            availableBits -= static_cast<float>(candidate.bits);
+            if (candidate.isPlayer) {
+                client.playerPriority.MarkSent(snapshot.players[candidate.index].playerId);
+            }
+            else {
+                client.enemyPriority.MarkSent(snapshot.enemies[candidate.index].enemyId);
+            }
+        }
+        else if (candidate.isPlayer) {
+            snapshot.players[candidate.index] = previous->players[candidate.previousIndex];
+            deferredEntityUpdates++;
+        }
+        else {
+            snapshot.enemies[candidate.index] = previous->enemies[candidate.previousIndex];
+            deferredEntityUpdates++;
+        }
+    }
+
+    client.playerPriority.EndPass();
+    client.enemyPriority.EndPass();
+}
+
+/**
+ * Refills every client's budget for this tick and adapts its rate to the
+ * client's recent loss and round trip.
+ */
+void GameServer::UpdateClientBudgets(float deltaTime) {
+    if (clientBandwidth == 0) {
+        return;
+    }
+    for (auto& [playerId, client] : clients) {
+        if (!client.isActive) {
+            continue;
+        }
+        float lossPercentage = -1.0f;
+        GetPacketLoss(client, lossPercentage);
+        client.budget.Update(deltaTime, lossPercentage, client.hasRttSample ? client.smoothedRttMs : -1.0f);
+    }
+}
+
+/**
+ * Snapshot and bullet list intervals follow from the rates; each category's
+ * rate is rounded to a whole number of snapshots. Far rates are scaled down
+ * by the current overload level.
+ */
+void GameServer::SetReplicationRates(const ReplicationRates& rates) {
+    replicationRates = rates;
+    gameStateUpdateRate = 1.0f / rates.GetSnapshotHz();
+    bulletUpdateRate = 1.0f / rates.bulletHz;
+    const float farScale = overload.GetLevelSettings().replicationScale;
+    replicationIntervals[NEAR_PLAYERS] = rates.GetSnapshotInterval(rates.nearPlayerHz);
+    replicationIntervals[FAR_PLAYERS] = rates.GetSnapshotInterval(
+        std::max(ReplicationRates::MIN_HZ, rates.farPlayerHz * farScale));
+    replicationIntervals[NEAR_ENEMIES] = rates.GetSnapshotInterval(rates.nearEnemyHz);
+    replicationIntervals[FAR_ENEMIES] = rates.GetSnapshotInterval(
+        std::max(ReplicationRates::MIN_HZ, rates.farEnemyHz * farScale));
+}
+
+void GameServer::SetDeadReckoning(const DeadReckoningSettings& settings) {
+    deadReckoningSettings = settings;
+    for (auto& [playerId, client] : clients) {
+        client.deadReckonedEntities.clear();
+    }
+}
+
+void GameServer::SetClientBandwidth(uint32_t bytesPerSecond) {
+    clientBandwidth = bytesPerSecond;
+    for (auto& [playerId, client] : clients) {
+        client.budget.SetLimit(static_cast<float>(bytesPerSecond));
+        client.playerPriority.Clear();
+        client.enemyPriority.Clear();
+    }
+}
+
+/**
+ * Sends the enter/leave events from the client's last interest pass, if any.
+ */
+void GameServer::SendInterestUpdate(ClientInfo& client, const InterestSet& interest) {
+    if (!interest.HasChanges()) {
+        return;
+    }
+
+    interestUpdate.enteredIds = interest.GetEntered();
+    interestUpdate.leftIds = interest.GetLeft();
+    interestUpdate.timestamp = GetCurrentTimestamp();
+    interestUpdate.sequenceNumber = outgoingSequenceNumber++;
+
+    PacketPool::Lease packet = sendPackets.Borrow();
+    *packet << interestUpdate;
+
+    QueueForClient(client, *packet);
+}
+
+/**
+ * Entries of lists in the chunks the client's interest could reach: the
+ * leave area grown by a chunk, further than anything moves between passes,
+ * so an entity that was relevant is always considered again and leaves with
+ * an event rather than silently.
+ */
+void GameServer::GatherNearby(const ChunkLists& lists, const ClientInfo& client, std::vector<uint32_t>& outIndices) const {
+    const float reach = interestSettings.hysteresisMargin + WorldConstants::CHUNK_SIZE;
+    lists.Gather(sf::Vector2f(SimOf(client).player.x, SimOf(client).player.y),
+        interestSettings.halfWidth + reach, interestSettings.halfHeight + reach, outIndices);
+}
+
+/**
+ * Keeps the client's chunks in step with its tank: forgets those past
+ * FORGET_RADIUS and sends the missing ones within STREAM_RADIUS, nearest
+ * ring first. Sends wait while the reliable channel is backed up, so a join
+ * or a fast move spreads its chunks over a few ticks.
+ */
+void GameServer::StreamChunks(ClientInfo& client) {
+    const sf::Vector2f position(SimOf(client).player.x, SimOf(client).player.y);
+    const WorldChunks::ChunkId center = WorldChunks::ChunkAt(position);
+    std::vector<WorldChunks::ChunkId>& streamed = client.streamedChunks;
+    streamed.erase(std::remove_if(streamed.begin(), streamed.end(), [center](WorldChunks::ChunkId chunk) {
+        return WorldChunks::Distance(chunk, center) > WorldChunks::FORGET_RADIUS;
+    }), streamed.end());
+
+    const int column = WorldChunks::ColumnOfChunk(center);
+    const int row = WorldChunks::RowOfChunk(center);
+    for (int ring = 0; ring <= WorldChunks::STREAM_RADIUS; ++ring) {
+        for (int y = std::max(0, row - ring); y <= std::min(WorldChunks::ROWS - 1, row + ring); ++y) {
+            for (int x = std::max(0, column - ring); x <= std::min(WorldChunks::COLUMNS - 1, column + ring); ++x) {
+                if (std::max(std::abs(x - column), std::abs(y - row)) != ring) {
+                    continue;
+                }
+                const WorldChunks::ChunkId chunk = static_cast<WorldChunks::ChunkId>(y * WorldChunks::COLUMNS + x);
+                if (std::find(streamed.begin(), streamed.end(), chunk) != streamed.end()) {
+                    continue;
+                }
+                if (client.reliable.GetPendingCount() >= WorldChunks::MAX_PENDING_CHUNK_SENDS) {
+                    return;
+                }
+                chunkMessage.chunkId = chunk;
+                chunkMessage.tiles = chunkContent.GetTiles(chunk);
+                chunkMessage.obstacles.clear();
+                for (const StaticObstacles::Obstacle& obstacle : chunkContent.GetObstacles(chunk)) {
+                    ObstacleData data;
+                    data.kind = static_cast<uint8_t>(obstacle.kind);
+                    data.left = static_cast<uint16_t>(obstacle.box.left);
+                    data.top = static_cast<uint16_t>(obstacle.box.top);
+                    data.width = static_cast<uint16_t>(obstacle.box.right - obstacle.box.left);
+                    data.height = static_cast<uint16_t>(obstacle.box.bottom - obstacle.box.top);
+                    chunkMessage.obstacles.push_back(data);
+                }
+                PacketPool::Lease packet = sendPackets.Borrow();
+                *packet << chunkMessage;
+                QueueReliableForClient(client, *packet);
+                streamed.push_back(chunk);
+                chunksStreamed++;
+            }
+        }
+    }
+}
+
+/**
+ * Loose relevance test for one-off events (spawns, impacts) between interest passes.
+ * @return True if position is inside the client's leave rectangle
+ */
+bool GameServer::IsInClientInterest(const ClientInfo& client, sf::Vector2f position) const {
+    return interestSettings.Contains(sf::Vector2f(SimOf(client).player.x, SimOf(client).player.y),
+        position, interestSettings.hysteresisMargin);
+}
+
+/**
+ * Sets the view rectangle used for enemy and bullet replication.
+ * @param halfWidth Half width of the view rectangle around each player (pixels)
+ * @param halfHeight Half height of the view rectangle (pixels)
+ * @param hysteresisMargin Extra distance an entity must move outside before it leaves
+ */
+void GameServer::SetInterestArea(float halfWidth, float halfHeight, float hysteresisMargin) {
+    if (!(halfWidth > 0.0f) || !(halfHeight > 0.0f) || !(hysteresisMargin >= 0.0f)) {
+        LOG_MSG(warning, "Invalid interest area, keeping " + std::to_string(interestSettings.halfWidth) +
+            "x" + std::to_string(interestSettings.halfHeight));
+        return;
+    }
+    interestSettings.halfWidth = halfWidth;
+    interestSettings.halfHeight = halfHeight;
+    interestSettings.hysteresisMargin = hysteresisMargin;
+}
+
+bool GameServer::LoadMap(const std::string& path) {
+    std::vector<StaticObstacles::Obstacle> obstacleList;
+    if (!StaticObstacles::LoadMap(path, obstacleList)) {
+        return false;
+    }
+    SetObstacles(std::move(obstacleList));
+    LOG_MSG(success, "Loaded map " + path + " (" + std::to_string(obstacles.GetObstacles().size()) + " obstacles)");
+    return true;
+}
+
+/**
+ * Rebuilds the obstacle hierarchy and everything derived from it: the
+ * navigation grid the enemies' flow fields run on, the per-chunk lists that
+ * are streamed to clients, and the projectile pool's sweep at spawn.
+ */
+void GameServer::SetObstacles(std::vector<StaticObstacles::Obstacle> obstacleList) {
+    obstacles.Build(std::move(obstacleList));
+    projectiles.SetObstacles(&obstacles);
+    chunkContent.SetObstacles(obstacles.GetObstacles());
+    spawnMap.SetObstacles(obstacles, WorldConstants::TANK_RADIUS + WorldConstants::SPAWN_SAFETY_MARGIN);
+
+    navigationGrid = NavigationGrid();
+    for (int y = 0; y < navigationGrid.GetRowCount(); ++y) {
+        for (int x = 0; x < navigationGrid.GetColumnCount(); ++x) {
+            if (obstacles.OverlapsCircle(navigationGrid.CellCenter(x, y), WorldConstants::ENEMY_TANK_RADIUS)) {
+                navigationGrid.SetBlocked(x, y, true);
+            }
+        }
+    }
+    playerFlowFields.clear();
+}
+
+/**
+ * Encodes world against the client's acknowledged baseline, sends it and keeps
+ * the result as a future baseline candidate.
+ * @param client Recipient (snapshot sequence and history are updated)
+ * @param world Current world snapshot; its sequence is set to the client's sequence
+ * @param messageSequence Server outgoing message sequence for statistics
+ */
+void GameServer::SendSnapshotToClient(ClientInfo& client, WorldSnapshot& world, uint32_t messageSequence) {
+    TRACE_SCOPE("Encode snapshot", "snapshot");
+    const WorldSnapshot* baseline = client.snapshotHistory.Find(client.lastAckedSnapshot);
+
+    SnapshotHeader header;
+    header.snapshotSequence = client.nextSnapshotSequence++;
+    header.baselineSequence = baseline ? baseline->sequence : 0;
+    header.timestamp = GetCurrentTimestamp();
+    header.sequenceNumber = messageSequence;
+    header.lastAckedInput = client.lastAcknowledgedInputSeq;
+    header.inputApplyMicros = client.lastInputApplyMicros;
+
+    messageWriter.Reset();
+    const uint64_t shared = encodeCache.GetSharedCount();
+    if (!encodeCache.Write(messageWriter, header, baseline, world)) {
+        LOG_MSG(warning, "Snapshot for player " + std::to_string(SimOf(client).player.playerId) +
+            " exceeds " + std::to_string(BitWriter::MAX_BYTES) + " bytes, not sent");
+        return;
+    }
+    PacketPool::Lease packet = sendPackets.Borrow();
+    *packet << static_cast<uint8_t>(NetMessageType::GAME_STATE_DELTA);
+    messageWriter.AppendTo(*packet);
+
+    // Stored after encoding: the ring slot may be the baseline's
+    world.sequence = header.snapshotSequence;
+    client.snapshotHistory.Store(world);
+    client.snapshotSentTimes[header.snapshotSequence % SnapshotHistory::HISTORY_SIZE] = header.timestamp;
+    if (deadReckoningSettings.enabled) {
+        RecordDeadReckoning(client, world, header.timestamp);
+    }
+
+    snapshotBytesSent += packet->getDataSize();
+    if (encodeCache.GetSharedCount() != shared) {
+        sharedSnapshotBodies++;
+    }
+    if (baseline) {
+        deltaSnapshotsSent++;
+    }
+    else {
+        fullSnapshotsSent++;
+    }
+
+    QueueForClient(client, *packet);
+}
+
+/**
+ * SendSnapshotToClient for the snapshot pipeline: everything but the encoding,
+ * which the send thread does from the job. The baseline is copied now since
+ * storing this snapshot may reuse its history slot.
+ */
+void GameServer::StageSnapshotForClient(ClientInfo& client, SnapshotPipeline::ClientJob& job, uint32_t messageSequence) {
+    const WorldSnapshot* baseline = client.snapshotHistory.Find(client.lastAckedSnapshot);
+    job.hasSnapshot = true;
+    job.hasBaseline = baseline != nullptr;
+    if (baseline) {
+        job.baseline = *baseline;
+    }
+
+    SnapshotHeader& header = job.header;
+    header.snapshotSequence = client.nextSnapshotSequence++;
+    header.baselineSequence = baseline ? baseline->sequence : 0;
+    header.timestamp = GetCurrentTimestamp();
+    header.sequenceNumber = messageSequence;
+    header.lastAckedInput = client.lastAcknowledgedInputSeq;
+    header.inputApplyMicros = client.lastInputApplyMicros;
+
+    // Messages queued so far go out ahead of the snapshot, as they would have
+    job.outgoing.TakeQueued(client.outgoing);
+
+    job.snapshot.sequence = header.snapshotSequence;
+    client.snapshotHistory.Store(job.snapshot);
+    client.snapshotSentTimes[header.snapshotSequence % SnapshotHistory::HISTORY_SIZE] = header.timestamp;
+    if (deadReckoningSettings.enabled) {
+        RecordDeadReckoning(client, job.snapshot, header.timestamp);
+    }
+
+    if (baseline) {
+        deltaSnapshotsSent++;
+    }
+    else {
+        fullSnapshotsSent++;
+    }
+}
+
+/**
+ * Takes the frame this tick's sends go into and settles what the send thread
+ * reported the last time it sent that frame: traffic counters and each
+ * client's budget catch up FRAME_COUNT ticks late.
+ */
+void GameServer::BeginSendFrame() {
+    if (sendFrame) {
+        return;     // Left over from a tick that threw before flushing
+    }
+    sendFrame = &snapshotPipeline->AcquireFrame();
+    if (sendFrame->hasResults) {
+        for (size_t i = 0; i < sendFrame->jobCount; ++i) {
+            const SnapshotPipeline::ClientJob& job = sendFrame->jobs[i];
+            if (job.snapshotBytes > 0) {
+                bandwidth.RecordMessageSent(static_cast<uint8_t>(NetMessageType::GAME_STATE_DELTA), job.snapshotBytes);
+                snapshotBytesSent += job.snapshotBytes;
+            }
+            if (job.compressionSaved > 0) {
+                compressedMessages++;
+                compressionBytesSaved += job.compressionSaved;
+            }
+            if (job.sharedBody) {
+                sharedSnapshotBodies++;
+            }
+            coalescedMessages += job.messageCount;
+            coalescedDatagrams += job.datagrams.packets;
+            bandwidth.RecordDatagramsSent(job.datagrams);
+            auto client = clients.find(job.playerId);
+            if (client != clients.end()) {
+                client->second.trafficSent.Add(job.datagrams);
+                client->second.budget.Spend(static_cast<size_t>(job.datagrams.bytes));
+            }
+        }
+    }
+    sendFrame->Clear();
+}
+
+SnapshotPipeline::ClientJob& GameServer::AddSendJob(ClientInfo& client) {
+    if (client.sendJob != 0) {
+        return sendFrame->jobs[client.sendJob - 1];
+    }
+    SnapshotPipeline::ClientJob& job = sendFrame->AddJob();
+    job.playerId = SimOf(client).player.playerId;
+    job.address = client.address;
+    job.port = client.port;
+    client.sendJob = static_cast<uint32_t>(sendFrame->jobCount);
+    return job;
+}
+
+/**
+ * Checks the clients whose timeout timer came due this tick. Messages only
+ * stamp lastHeardTick; the timer is moved when it fires, to lastHeardTick plus
+ * the timeout, and a client that stayed silent all along is removed (and
+ * suspended, see SuspendSession). Suspended sessions whose grace ran out go too.
+ */
+void GameServer::RemoveInactiveClients() {
+    try {
+        std::vector<uint32_t> toRemove;
+        const uint64_t timeoutTicks = SecondsToTicks(clientTimeoutDuration);
+
+        for (const TimerWheel::Fired& timer : firedTimers) {
+            if (timer.kind == static_cast<uint8_t>(ServerTimer::SESSION_EXPIRY)) {
+                auto suspendedIt = suspendedClients.find(timer.target);
+                if (suspendedIt != suspendedClients.end() && suspendedIt->second.timeoutTimer == timer.id) {
+                    LOG_MSG(info, "Session of player " + std::to_string(timer.target) + " (" +
+                        suspendedIt->second.playerName + ") expired");
+                    ReleasePlayerSlot(suspendedIt->second);
+                    suspendedClients.erase(suspendedIt);
+                }
+                continue;
+            }
+            if (timer.kind != static_cast<uint8_t>(ServerTimer::CLIENT_TIMEOUT)) {
+                continue;
+            }
+            auto it = clients.find(timer.target);
+            if (it == clients.end() || !it->second.isActive || it->second.timeoutTimer != timer.id) {
+                continue;
+            }
+
+            ClientInfo& client = it->second;
+            if (tickNumber - client.lastHeardTick >= timeoutTicks) {
+                LOG_MSG(warning, "Player " + std::to_string(timer.target) + " (" + client.playerName + ") timed out");
+                client.isActive = false;
+                client.timeoutTimer = TimerWheel::INVALID_TIMER;
+                toRemove.push_back(timer.target);
+            }
+            else {
+                ScheduleClientTimeout(timer.target, client);
+            }
+        }
+
+        for (uint32_t playerId : toRemove) {
+            DropClient(playerId);
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in RemoveInactiveClients: " + std::string(e.what()), error);
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in RemoveInactiveClients", error);
+    }
+}
+
+/**
+ * The tank leaves the world with the client, but its slot stays reserved, so
+ * a resume brings back its position, health and score. Queued messages are
+ * dropped; unacked reliable ones stay and are resent after a resume.
+ */
+void GameServer::SuspendSession(uint32_t playerId, ClientInfo& client) {
+    if (sessionResumeGrace <= 0.0f || client.connectionToken == 0 || client.slot == ClientInfo::NO_SLOT) {
+        ReleasePlayerSlot(client);
+        return;
+    }
+    playerSims[client.slot].inUse = false;
+    client.outgoing.Clear();
+    client.timeoutTimer = ScheduleAfter(sessionResumeGrace, ServerTimer::SESSION_EXPIRY, playerId);
+    suspendedClients.insert_or_assign(playerId, std::move(client));
+}
+
+void GameServer::ScheduleClientTimeout(uint32_t playerId, ClientInfo& client) {
+    client.timeoutTimer = timers.Schedule(
+        static_cast<uint64_t>(client.lastHeardTick) + SecondsToTicks(clientTimeoutDuration),
+        static_cast<uint8_t>(ServerTimer::CLIENT_TIMEOUT), playerId);
+}
+
+/**
+ * Takes a player out of the client table (suspending its session if it can
+ * be resumed). The others see it gone in their next regular snapshot, with
+ * the new player table.
+ */
+void GameServer::DropClient(uint32_t playerId) {
+    auto clientIt = clients.find(playerId);
+    if (clientIt == clients.end()) {
+        return;
+    }
+    clientIt->second.isActive = false;
+    clientsByEndpoint.erase(EndpointKey(clientIt->second.address, clientIt->second.port));
+    SuspendSession(playerId, clientIt->second);
+    clients.erase(clientIt);
+    playerTableVersion++;
+}
+
+/**
+ * @return The player connected from address:port, or 0 if none
+ */
+uint32_t GameServer::FindPlayerByAddress(sf::IpAddress address, unsigned short port) const {
+    auto it = clientsByEndpoint.find(EndpointKey(address, port));
+    return it != clientsByEndpoint.end() ? it->second : 0;
+}
+
+/**
+ * The new state starts as a default PlayerData with every field dirty, so
+ * the next world snapshot picks the player up whole.
+ */
+void GameServer::AcquirePlayerSlot(ClientInfo& client, uint32_t playerId, PlayerColor color) {
+    if (freePlayerSlots.empty()) {
+        client.slot = static_cast<uint32_t>(playerSims.size());
+        playerSims.emplace_back();
+    }
+    else {
+        client.slot = freePlayerSlots.back();
+        freePlayerSlots.pop_back();
+        playerSims[client.slot] = PlayerSimState();
+    }
+    PlayerSimState& sim = playerSims[client.slot];
+    sim.player.playerId = playerId;
+    sim.player.color = color;
+    sim.inUse = true;
+    colorUsers[static_cast<size_t>(color)]++;
+}
+
+void GameServer::ReleasePlayerSlot(ClientInfo& client) {
+    if (client.slot == ClientInfo::NO_SLOT) {
+        return;
+    }
+    playerSims[client.slot].inUse = false;
+    colorUsers[static_cast<size_t>(playerSims[client.slot].player.color)]--;
+    freePlayerSlots.push_back(client.slot);
+    client.slot = ClientInfo::NO_SLOT;
+}
+
+/**
+ * The first color nobody has, or once all are taken the least used one.
+ * Counts are kept per slot (see AcquirePlayerSlot), so no player is visited.
+ */
+PlayerColor GameServer::AssignColor() {
+    size_t best = 0;
+    for (size_t i = 1; i < colorUsers.size(); ++i) {
+        if (colorUsers[i] < colorUsers[best]) {
+            best = i;
+        }
+    }
+    return static_cast<PlayerColor>(best);
+}
+
+TickStats GameServer::TakeTickStats() {
+    TickStats stats = tickScheduler.GetStats();
+    tickScheduler.ResetStats();
+    tickProfiler.Reset();
+    CloseBandwidthWindow();
+    bandwidthWindowStart = GetCurrentTimestamp();
+    return stats;
+}
+
+GameServer::RunReport GameServer::GetRunReport() {
+    RunReport report;
+    report.ticks = tickScheduler.GetStats();
+    for (size_t i = 0; i < static_cast<size_t>(TickPhase::COUNT); ++i) {
+        const TickPhase phase = static_cast<TickPhase>(i);
+        const uint64_t runs = tickProfiler.GetLifetimeRuns(phase);
+        report.phaseAverageMicros[i] = runs > 0 ?
+            static_cast<double>(tickProfiler.GetLifetimeMicros(phase)) / static_cast<double>(runs) : 0.0;
+    }
+    report.traffic = bandwidthTotals;
+    report.traffic.Accumulate(bandwidth);
+    report.enemies = GetEnemyCount();
+    for (const auto& [playerId, client] : clients) {
+        if (client.isActive) {
+            report.players++;
+        }
+    }
+    return report;
+}
+
+/**
+ * Prints one latency line per Update phase that ran in this window, then
+ * starts a new window. A phase whose slowest run alone exceeded the tick
+ * budget is printed as a warning, so overruns point at their cause.
+ * Allocation builds add each phase's allocations per run, and a line for
+ * the allocations made in the tick outside every phase.
+ */
+void GameServer::PrintTickPhaseStats() {
+    const uint64_t tickBudgetUs = static_cast<uint64_t>(tickScheduler.GetTickDuration() * 1000000.0f);
+    for (size_t i = 0; i < static_cast<size_t>(TickPhase::COUNT); ++i) {
+        const TickPhase phase = static_cast<TickPhase>(i);
+        const LatencyHistogram& histogram = tickProfiler.Get(phase);
+        if (histogram.GetCount() == 0) {
+            continue;
+        }
+        const bool overBudget = histogram.GetMax() > tickBudgetUs;
+        Utils::printMsg("Tick phase " + std::string(GetTickPhaseName(phase)) +
+            " - p50: " + std::to_string(histogram.GetPercentile(50.0)) + " us" +
+            " - p95: " + std::to_string(histogram.GetPercentile(95.0)) + " us" +
+            " - p99: " + std::to_string(histogram.GetPercentile(99.0)) + " us" +
+            " - Max: " + std::to_string(histogram.GetMax()) + " us" +
+            " - Runs: " + std::to_string(histogram.GetCount()) +
+            (ALLOCATION_TRACKING_ENABLED ? " - Allocs/run: " + std::to_string(
+                static_cast<double>(tickProfiler.GetAllocations(phase)) / static_cast<double>(histogram.GetCount())) :
+                std::string()),
+            overBudget ? warning : debug);
+    }
+    if (ALLOCATION_TRACKING_ENABLED && tickProfiler.GetOtherAllocations() > 0) {
+        Utils::printMsg("Tick allocations outside phases: " + std::to_string(tickProfiler.GetOtherAllocations()),
+            warning);
+    }
+    tickProfiler.Reset();
+}
+
+/**
+ * Prints server-wide traffic by message type in each direction, then each
+ * client's datagram rates, and starts a new window.
+ */
+void GameServer::PrintBandwidthStats() {
+    const int64_t now = GetCurrentTimestamp();
+    const double elapsedSeconds = static_cast<double>(now - bandwidthWindowStart) / 1000.0;
+    if (elapsedSeconds > 0.0) {
+        LOG_MSG(debug, "Bandwidth out - " + bandwidth.FormatSent(elapsedSeconds));
+        LOG_MSG(debug, "Bandwidth in - " + bandwidth.FormatReceived(elapsedSeconds));
+        for (const auto& [playerId, client] : clients) {
+            LOG_MSG(debug, "Bandwidth player " + std::to_string(playerId) +
+                " - Out: " + FormatByteRate(client.trafficSent.bytes, elapsedSeconds) +
+                " (" + std::to_string(client.trafficSent.packets) + " datagrams)" +
+                " - In: " + FormatByteRate(client.trafficReceived.bytes, elapsedSeconds) +
+                " (" + std::to_string(client.trafficReceived.packets) + " datagrams)" +
+                (client.budget.IsLimited() ? " - Budget: " + FormatByteRate(
+                    static_cast<uint64_t>(client.budget.GetRate()), 1.0) : std::string()));
+        }
+        LOG_MSG(debug, "World snapshot - " + std::to_string(dirtyEntityWrites) + " dirty entity writes, " +
+            std::to_string(worldSnapshotRebuilds) + " rebuilds");
+        if (scheduledEntityHolds != 0) {
+            LOG_MSG(debug, "Replication rates - " + std::to_string(scheduledEntityHolds) +
+                " entity updates held for their category's next turn");
+        }
+        if (deadReckoningSettings.enabled) {
+            LOG_MSG(debug, "Dead reckoning - " + std::to_string(deadReckonedHolds) +
+                " entity updates left to client extrapolation");
+        }
+        if (clientBandwidth != 0) {
+            LOG_MSG(debug, "Replication budget - " + std::to_string(deferredEntityUpdates) +
+                " entity updates and " + std::to_string(deferredBulletUpdates) + " bullet lists deferred");
+        }
+    }
+    deferredEntityUpdates = 0;
+    deferredBulletUpdates = 0;
+    scheduledEntityHolds = 0;
+    deadReckonedHolds = 0;
+    dirtyEntityWrites = 0;
+    worldSnapshotRebuilds = 0;
+
+    CloseBandwidthWindow();
+    for (auto& [playerId, client] : clients) {
+        client.trafficSent = TrafficCounter();
+        client.trafficReceived = TrafficCounter();
+    }
+    bandwidthWindowStart = now;
+}
+
+void GameServer::CloseBandwidthWindow() {
+    bandwidthTotals.Accumulate(bandwidth);
+    bandwidth.Reset();
+}
+
+void GameServer::StartMetricsExporter() {
+    if (metricsPort == 0) {
+        return;
+    }
+    metricsExporter = std::make_unique<MetricsExporter>(metricsPort);
+    if (!metricsExporter->Start()) {
+        LOG_MSG(warning, "Continuing without the metrics endpoint");
+        metricsExporter.reset();
+        return;
+    }
+    PublishMetrics();
+}
+
+void GameServer::SetDirectory(const sf::IpAddress& address, unsigned short port,
+    std::optional<sf::IpAddress> advertisedAddress) {
+    directoryAddress = address;
+    directoryPort = port;
+    directoryAdvertisedAddress = advertisedAddress ? advertisedAddress->toInteger() : 0;
+    directoryReportTimer = static_cast<float>(Directory::REPORT_INTERVAL_MS) / 1000.0f;  // Report on the first tick
+    scoreReporting = true;
+}
+
+/**
+ * Sends the directory this server's single room: players, capacity and the
+ * share of the tick budget the current stats window leaves unused. Sent over
+ * the game socket so the directory sees the address players should use.
+ */
+void GameServer::ReportToDirectory() {
+    Directory::LoadReport report;
+    report.advertisedAddress = directoryAdvertisedAddress;
+    report.gamePort = serverPort;
+    report.maxPlayersPerRoom = maxPlayers;
+    Directory::RoomLoad room;
+    room.players = static_cast<uint16_t>(std::min<size_t>(clients.size(), UINT16_MAX));
+    room.headroomPercent = Directory::ComputeHeadroom(tickScheduler.GetStats().GetAverageTickMs(),
+        tickScheduler.GetTickRate());
+    report.rooms.push_back(room);
+
+    sf::Packet packet;
+    Directory::WriteReport(packet, report);
+    const sf::Socket::Status status = SendPacket(packet, *directoryAddress, directoryPort);
+    if (status != sf::Socket::Status::Done && status != sf::Socket::Status::NotReady) {
+        LOG_MSG(warning, "Failed to report load to the directory - Status: " + SocketStatusToString(status));
+    }
+}
+
+/**
+ * Sends the score changes summed since the last batch, a few players per
+ * datagram. A lost datagram loses its changes: the leaderboard is a ranking
+ * for show, not the players' scores.
+ */
+void GameServer::ReportScoresToDirectory() {
+    scoreBatch.clear();
+    TakeScoreChanges(scoreBatch);
+    for (size_t next = 0; next < scoreBatch.size();) {
+        sf::Packet packet;
+        next = Directory::WriteScores(packet, scoreBatch, next);
+        const sf::Socket::Status status = SendPacket(packet, *directoryAddress, directoryPort);
+        if (status != sf::Socket::Status::Done && status != sf::Socket::Status::NotReady) {
+            LOG_MSG(warning, "Failed to report scores to the directory - Status: " + SocketStatusToString(status));
+        }
+    }
+}
+
+void GameServer::TakeScoreChanges(std::vector<Directory::ScoreChange>& out) {
+    for (auto& [playerId, change] : unreportedScores) {
+        if (change.change != 0) {
+            out.push_back(std::move(change));
+        }
+    }
+    unreportedScores.clear();
+}
+
+void GameServer::RecordScoreChange(uint32_t playerId, const ClientInfo& client, int32_t change) {
+    if (!scoreReporting || replayTick || client.playerName.empty()) {
+        return;
+    }
+    Directory::ScoreChange& total = unreportedScores[playerId];
+    if (total.name.empty()) {
+        total.name = client.playerName;
+    }
+    total.change += change;
+}
+
+namespace {
+    // Packed components and entities plus the sparse index of one registry storage
+    template <typename Component>
+    size_t StorageBytes(const entt::registry& registry) {
+        const auto* storage = registry.storage<Component>();
+        if (!storage) {
+            return 0;
+        }
+        return storage->capacity() * (sizeof(Component) + sizeof(entt::entity)) +
+            storage->extent() * sizeof(entt::entity);
+    }
+}
+
+/**
+ * Entities, per-client replication state and send buffers. Snapshot
+ * baselines and sequence tracking are inline in ClientInfo, so they are
+ * taken out of the players line to keep the lines disjoint.
+ */
+void GameServer::ReportMemory(MemoryReport& report) const {
+    report.Clear();
+    const size_t trackingBytes = sizeof(ClientInfo::receivedSequences) + sizeof(ClientInfo::snapshotSentTimes);
+    size_t historyBytes = 0;
+    size_t trackedEntities = 0;
+    size_t trackedEntityBytes = 0;
+    for (const auto& [playerId, client] : clients) {
+        historyBytes += client.snapshotHistory.GetApproximateBytes();
+        trackedEntities += client.deadReckonedEntities.size();
+        trackedEntityBytes += MemoryReport::MapBytes(client.deadReckonedEntities);
+    }
+    report.Add("players", clients.size(),
+        MemoryReport::MapBytes(clients) - clients.size() * (trackingBytes + sizeof(SnapshotHistory)) +
+        MemoryReport::MapBytes(clientsByEndpoint) + MemoryReport::VectorBytes(playerSims, freePlayerSlots));
+
+    const size_t enemyCount = enemyRegistry.storage<ServerComponents::NetworkId>() ?
+        enemyRegistry.storage<ServerComponents::NetworkId>()->size() : 0;
+    report.Add("enemies", enemyCount,
+        StorageBytes<ServerComponents::NetworkId>(enemyRegistry) + StorageBytes<ServerComponents::Transform>(enemyRegistry) +
+        StorageBytes<ServerComponents::Health>(enemyRegistry) + StorageBytes<ServerComponents::Dirty>(enemyRegistry) +
+        StorageBytes<ServerComponents::EnemyKind>(enemyRegistry) + StorageBytes<ServerComponents::EnemyBrain>(enemyRegistry) +
+        enemyCount * sizeof(EnemyTank));
+    report.Add("bullets", projectiles.GetActiveCount(), projectiles.GetApproximateBytes());
+    report.Add("snapshot history", clients.size() * SnapshotHistory::HISTORY_SIZE, historyBytes);
+    report.Add("sequence tracking", trackedEntities, clients.size() * trackingBytes + trackedEntityBytes);
+    report.Add("packet pool", sendPackets.GetCreatedCount(), sendPackets.GetApproximateBytes());
+    report.Add("spectator stream", spectatorStream.GetSpectatorCount(), spectatorStream.GetApproximateBytes());
+    if (IsLanMulticastEnabled()) {
+        report.Add("LAN multicast stream", groupDeliveryClients, lanStream.GetApproximateBytes());
+    }
+    size_t streamedChunkBytes = nearbyBullets.capacity() * sizeof(uint32_t);
+    for (const auto& [playerId, client] : clients) {
+        streamedChunkBytes += client.streamedChunks.capacity() * sizeof(WorldChunks::ChunkId) +
+            client.nearbyEnemies.capacity() * sizeof(uint32_t);
+    }
+    report.Add("world chunks", chunkContent.GetGeneratedCount(), chunkContent.GetApproximateBytes() +
+        sizeof(enemyChunks) + sizeof(bulletChunks) + (enemyChunks.GetEntryCount() + bulletChunks.GetEntryCount()) *
+        (sizeof(uint32_t) + sizeof(WorldChunks::ChunkId)) + streamedChunkBytes);
+    report.Add("spawn map", spawnMap.GetSafeCellCount(), spawnMap.GetApproximateBytes());
+    if (!obstacles.IsEmpty()) {
+        report.Add("static obstacles", obstacles.GetObstacles().size(), obstacles.GetApproximateBytes());
+    }
+}
+
+/**
+ * Rebuilds the metrics page and hands it to the exporter thread. Counters
+ * are totals since startup (closed stats windows plus the open one); tick
+ * phase quantiles and client gauges describe the current stats window. If a
+ * scrape holds the page, the timer is left running and the next tick retries.
+ */
+void GameServer::PublishMetrics() {
+    metricsPage.Clear();
+    MetricsPage& page = metricsPage;
+
+    page.Describe("tankgame_players", "gauge", "Connected players");
+    page.Add("tankgame_players", static_cast<uint64_t>(clients.size()));
+    page.Describe("tankgame_enemies", "gauge", "Live enemy tanks");
+    page.Add("tankgame_enemies", static_cast<uint64_t>(GetEnemyCount()));
+    page.Describe("tankgame_bullets", "gauge", "Live bullets");
+    page.Add("tankgame_bullets", static_cast<uint64_t>(projectiles.GetActiveCount()));
+    page.Describe("tankgame_spectators", "gauge", "Direct subscribers to the spectator stream");
+    page.Add("tankgame_spectators", static_cast<uint64_t>(spectatorStream.GetSpectatorCount()));
+    page.Describe("tankgame_spectator_stream_bytes_total", "counter",
+        "Spectator stream bytes encoded (once per frame) and sent (once per subscriber) since startup");
+    page.Add("tankgame_spectator_stream_bytes_total", spectatorStream.GetStats().bytesEncoded, "stage=\"encoded\"");
+    page.Add("tankgame_spectator_stream_bytes_total", spectatorStream.GetStats().bytesSent, "stage=\"sent\"");
+    page.Describe("tankgame_lan_group_clients", "gauge", "Players receiving snapshots through LAN multicast");
+    page.Add("tankgame_lan_group_clients", static_cast<uint64_t>(groupDeliveryClients));
+    page.Describe("tankgame_lan_multicast_bytes_total", "counter", "Bytes sent to the LAN multicast group since startup");
+    page.Add("tankgame_lan_multicast_bytes_total", lanStream.GetStats().bytesSent);
+    page.Describe("tankgame_active_chunks", "gauge", "World chunks within the active radius of a player");
+    page.Add("tankgame_active_chunks", static_cast<uint64_t>(chunkActivity.GetActiveCount()));
+    page.Describe("tankgame_sleeping_enemies", "gauge", "Enemies skipped by the AI because no player is near their chunk");
+    page.Add("tankgame_sleeping_enemies", static_cast<uint64_t>(sleepingEnemies));
+    page.Describe("tankgame_tick_rate_hz", "gauge", "Configured simulation tick rate");
+    page.Add("tankgame_tick_rate_hz", static_cast<uint64_t>(tickScheduler.GetTickRate()));
+    page.Describe("tankgame_idle", "gauge", "1 while no players are connected and ticks are paused");
+    page.Add("tankgame_idle", static_cast<uint64_t>(idle ? 1 : 0));
+    page.Describe("tankgame_overload_level", "gauge", "Load shedding level, 0 = none");
+    page.Add("tankgame_overload_level", static_cast<uint64_t>(overload.GetLevel()));
+    page.Describe("tankgame_overload_transitions_total", "counter", "Overload level changes since startup");
+    page.Add("tankgame_overload_transitions_total", overload.GetTransitionCount());
+    page.Describe("tankgame_tick_allocations_total", "counter",
+        "Heap allocations made by ticks (receive through flush) since startup");
+    page.Add("tankgame_tick_allocations_total", tickAllocations);
+    const TickStats& tickStats = tickScheduler.GetStats();
+    page.Describe("tankgame_tick_start_late_milliseconds", "gauge",
+        "How long after their due time ticks started over the current stats window (tick jitter)");
+    page.Add("tankgame_tick_start_late_milliseconds", tickStats.GetAverageLateMs(), "stat=\"avg\"");
+    page.Add("tankgame_tick_start_late_milliseconds", tickStats.maxLateMs, "stat=\"max\"");
+
+    page.Describe("tankgame_tick_phase_microseconds", "gauge",
+        "Update phase latency quantiles over the current stats window");
+    for (size_t i = 0; i < static_cast<size_t>(TickPhase::COUNT); ++i) {
+        const TickPhase phase = static_cast<TickPhase>(i);
+        const LatencyHistogram& histogram = tickProfiler.Get(phase);
+        if (histogram.GetCount() == 0) {
+            continue;
+        }
+        const std::string label = "phase=\"" + std::string(GetTickPhaseName(phase)) + "\"";
+        page.Add("tankgame_tick_phase_microseconds", histogram.GetPercentile(50.0), label + ",quantile=\"0.5\"");
+        page.Add("tankgame_tick_phase_microseconds", histogram.GetPercentile(95.0), label + ",quantile=\"0.95\"");
+        page.Add("tankgame_tick_phase_microseconds", histogram.GetPercentile(99.0), label + ",quantile=\"0.99\"");
+        page.Add("tankgame_tick_phase_microseconds", histogram.GetMax(), label + ",quantile=\"1\"");
+    }
+    page.Describe("tankgame_tick_phase_runs_total", "counter", "Update phase runs since startup");
+    for (size_t i = 0; i < static_cast<size_t>(TickPhase::COUNT); ++i) {
+        const TickPhase phase = static_cast<TickPhase>(i);
+        page.Add("tankgame_tick_phase_runs_total", tickProfiler.GetLifetimeRuns(phase),
+            "phase=\"" + std::string(GetTickPhaseName(phase)) + "\"");
+    }
+    page.Describe("tankgame_tick_phase_microseconds_total", "counter", "Time spent in each Update phase since startup");
+    for (size_t i = 0; i < static_cast<size_t>(TickPhase::COUNT); ++i) {
+        const TickPhase phase = static_cast<TickPhase>(i);
+        page.Add("tankgame_tick_phase_microseconds_total", tickProfiler.GetLifetimeMicros(phase),
+            "phase=\"" + std::string(GetTickPhaseName(phase)) + "\"");
+    }
+    if (ALLOCATION_TRACKING_ENABLED) {
+        page.Describe("tankgame_tick_phase_allocations_total", "counter",
+            "Heap allocations made in each Update phase since startup (allocation tracking builds)");
+        for (size_t i = 0; i < static_cast<size_t>(TickPhase::COUNT); ++i) {
+            const TickPhase phase = static_cast<TickPhase>(i);
+            page.Add("tankgame_tick_phase_allocations_total", tickProfiler.GetLifetimeAllocations(phase),
+                "phase=\"" + std::string(GetTickPhaseName(phase)) + "\"");
+        }
+    }
+
+    // Per message type and direction; types never seen are left out
+    BandwidthStats traffic = bandwidthTotals;
+    traffic.Accumulate(bandwidth);
+    page.Describe("tankgame_messages_total", "counter", "Messages by type and direction since startup");
+    page.Describe("tankgame_message_bytes_total", "counter", "Message bytes by type and direction since startup");
+    for (size_t type = 0; type < BandwidthStats::TYPE_SLOTS; ++type) {
+        const std::string typeLabel = "type=\"" + std::string(GetNetMessageTypeName(static_cast<uint8_t>(type))) + "\"";
+        const TrafficCounter& sent = traffic.GetMessagesSent(static_cast<uint8_t>(type));
+        const TrafficCounter& received = traffic.GetMessagesReceived(static_cast<uint8_t>(type));
+        if (sent.packets > 0) {
+            page.Add("tankgame_messages_total", sent.packets, typeLabel + ",direction=\"sent\"");
+            page.Add("tankgame_message_bytes_total", sent.bytes, typeLabel + ",direction=\"sent\"");
+        }
+        if (received.packets > 0) {
+            page.Add("tankgame_messages_total", received.packets, typeLabel + ",direction=\"received\"");
+            page.Add("tankgame_message_bytes_total", received.bytes, typeLabel + ",direction=\"received\"");
+        }
+    }
+    page.Describe("tankgame_datagrams_total", "counter", "Datagrams on the wire since startup");
+    page.Add("tankgame_datagrams_total", traffic.GetDatagramsSent().packets, "direction=\"sent\"");
+    page.Add("tankgame_datagrams_total", traffic.GetDatagramsReceived().packets, "direction=\"received\"");
+    page.Describe("tankgame_datagram_bytes_total", "counter", "Datagram bytes on the wire since startup");
+    page.Add("tankgame_datagram_bytes_total", traffic.GetDatagramsSent().bytes, "direction=\"sent\"");
+    page.Add("tankgame_datagram_bytes_total", traffic.GetDatagramsReceived().bytes, "direction=\"received\"");
+
+    page.Describe("tankgame_client_rtt_milliseconds", "gauge", "Smoothed round trip from snapshot acks");
+    for (const auto& [playerId, client] : clients) {
+        if (client.isActive && client.hasRttSample) {
+            page.Add("tankgame_client_rtt_milliseconds", static_cast<double>(client.smoothedRttMs),
+                "player=\"" + std::to_string(playerId) + "\"");
+        }
+    }
+    page.Describe("tankgame_client_packet_loss_percent", "gauge", "Client to server loss over the sequence window");
+    for (const auto& [playerId, client] : clients) {
+        float lossPercentage = 0.0f;
+        if (client.isActive && GetPacketLoss(client, lossPercentage)) {
+            page.Add("tankgame_client_packet_loss_percent", static_cast<double>(lossPercentage),
+                "player=\"" + std::to_string(playerId) + "\"");
+        }
+    }
+
+    page.Describe("tankgame_client_input_buffer_depth", "gauge", "Inputs queued for the coming ticks");
+    page.Describe("tankgame_client_input_buffer_target_depth", "gauge", "Input buffer depth tuned to arrival jitter");
+    page.Describe("tankgame_client_input_starved_ticks_total", "counter", "Ticks with no queued input to apply");
+    for (const auto& [playerId, client] : clients) {
+        if (client.isActive) {
+            const std::string label = "player=\"" + std::to_string(playerId) + "\"";
+            page.Add("tankgame_client_input_buffer_depth", static_cast<uint64_t>(client.inputBuffer.GetDepth()), label);
+            page.Add("tankgame_client_input_buffer_target_depth",
+                static_cast<uint64_t>(client.inputBuffer.GetTargetDepth()), label);
+            page.Add("tankgame_client_input_starved_ticks_total", client.inputBuffer.GetTotalStarved(), label);
+        }
+    }
+
+    // Client telemetry, cumulative buckets as in a Prometheus histogram
+    const auto addTelemetryBuckets = [&page](const char* name, const std::array<uint64_t, ClientTelemetry::BUCKET_COUNT>& buckets,
+        const ClientTelemetry::Bounds& bounds) {
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            cumulative += buckets[i];
+            char label[32];
+            if (i < bounds.size()) {
+                std::snprintf(label, sizeof(label), "le=\"%g\"", static_cast<double>(bounds[i]));
+            }
+            else {
+                std::snprintf(label, sizeof(label), "le=\"+Inf\"");
+            }
+            page.Add(name, cumulative, label);
+        }
+    };
+    page.Describe("tankgame_client_frame_milliseconds_total", "counter", "Client frames by frame time, from client telemetry");
+    addTelemetryBuckets("tankgame_client_frame_milliseconds_total", clientTelemetry.frameMs, ClientTelemetry::FRAME_MS_BOUNDS);
+    page.Describe("tankgame_client_rtt_samples_total", "counter", "Client round trip samples by milliseconds, from client telemetry");
+    addTelemetryBuckets("tankgame_client_rtt_samples_total", clientTelemetry.rttMs, ClientTelemetry::RTT_MS_BOUNDS);
+    page.Describe("tankgame_client_loss_samples_total", "counter", "Client packet loss samples (1/s) by percent, from client telemetry");
+    addTelemetryBuckets("tankgame_client_loss_samples_total", clientTelemetry.lossPercent, ClientTelemetry::LOSS_PERCENT_BOUNDS);
+    page.Describe("tankgame_client_telemetry_windows_total", "counter", "Client telemetry windows received");
+    page.Add("tankgame_client_telemetry_windows_total", clientTelemetry.windows);
+    page.Describe("tankgame_client_entity_frames_total", "counter",
+        "Remote entities drawn by clients, summed over frames; extrapolated ones past their newest snapshot");
+    page.Add("tankgame_client_entity_frames_total", clientTelemetry.entityFrames, "state=\"all\"");
+    page.Add("tankgame_client_entity_frames_total", clientTelemetry.extrapolatedEntityFrames, "state=\"extrapolated\"");
+    page.Describe("tankgame_client_reconciliations_total", "counter", "Server states clients compared against their prediction");
+    page.Add("tankgame_client_reconciliations_total", clientTelemetry.reconciliations, "result=\"all\"");
+    page.Add("tankgame_client_reconciliations_total", clientTelemetry.mispredictions, "result=\"mispredicted\"");
+
+    ReportMemory(memoryReport);
+    memoryReport.AddMetrics(page);
+
+    if (metricsExporter->Publish(page.GetText())) {
+        metricsTimer = 0;
+    }
+}
+
+void GameServer::PrintServerStats() {
+    if (clients.empty()) {
+        LOG_MSG(info, "Server running - No players connected - Enemies: " +
+            std::to_string(GetEnemyCount()));
+    }
+    else {
+        std::string playerList = "Server running - " + std::to_string(clients.size()) +
+            " players connected - Enemies: " + std::to_string(GetEnemyCount()) +
+            " (" + std::to_string(reducedLodEnemies) + " reduced AI rate" +
+            (enemySquadsEnabled ? ", " + std::to_string(enemySquads.GetSquads().size()) + " squads" : std::string()) + ")" +
+            " - Flow field rebuilds: " + std::to_string(flowFieldRebuilds) +
+            " - Players: ";
+        for (const auto& [playerId, client] : clients) {
+            if (client.isActive) {
+                playerList += client.playerName + " ";
+            }
+        }
+        LOG_MSG(info, playerList);
+    }
+
+    const TickStats& tickStats = tickScheduler.GetStats();
+    if (tickStats.ticksRun > 0) {
+        Utils::printMsg("Tick stats - Rate: " + std::to_string(tickScheduler.GetTickRate()) + " Hz" +
+            " - Ticks: " + std::to_string(tickStats.ticksRun) +
+            " - Avg: " + std::to_string(tickStats.GetAverageTickMs()) + " ms" +
+            " - Max: " + std::to_string(tickStats.maxTickMs) + " ms" +
+            " - Start late avg/max: " + std::to_string(tickStats.GetAverageLateMs()) + "/" +
+            std::to_string(tickStats.maxLateMs) + " ms" +
+            " - Overruns: " + std::to_string(tickStats.overrunTicks) +
+            " - Dropped: " + std::to_string(tickStats.droppedTicks),
+            (tickStats.overrunTicks > 0 || tickStats.droppedTicks > 0) ? warning : debug);
+    }
+    tickScheduler.ResetStats();
+    PrintTickPhaseStats();
+
+    if (conditioner) {
+        const NetworkConditionerStats& conditioned = conditioner->GetStats();
+        LOG_MSG(info, "Network conditions - " + networkConditions.Describe() +
+            " - Sent: " + std::to_string(conditioned.sent) +
+            " - Received: " + std::to_string(conditioned.received) +
+            " - Dropped: " + std::to_string(conditioned.dropped) +
+            " - Duplicated: " + std::to_string(conditioned.duplicated) +
+            " - Reordered: " + std::to_string(conditioned.reordered) +
+            " - In flight: " + std::to_string(conditioner->GetQueuedCount()));
+    }
+
+    if (enemyAIBudgetUs > 0 && aiBudgetStats.ticks > 0) {
+        const double averageUs = aiBudgetStats.totalUsedUs / static_cast<double>(aiBudgetStats.ticks);
+        Utils::printMsg("Enemy AI budget - " + std::to_string(enemyAIBudgetUs) + " us/tick" +
+            " - Avg used: " + std::to_string(averageUs) + " us" +
+            " - Max used: " + std::to_string(aiBudgetStats.maxUsedUs) + " us" +
+            " - Deferred: " + std::to_string(aiBudgetStats.deferredSteps) +
+            " (max " + std::to_string(aiBudgetStats.maxDeferred) + "/tick)",
+            aiBudgetStats.deferredSteps > 0 ? warning : debug);
+    }
+    aiBudgetStats = EnemyAIBudgetStats();
+
+    if (overload.GetLevel() > 0) {
+        LOG_MSG(warning, "Overload - Level: " + std::to_string(overload.GetLevel()) +
+            " - Transitions: " + std::to_string(overload.GetTransitionCount()));
+    }
+    flowFieldRebuilds = 0;
+
+    if (rewoundHitTests > 0) {
+        LOG_MSG(debug, "Lag compensation - Rewound bullet tests: " + std::to_string(rewoundHitTests) +
+            " - Avg rewind: " + std::to_string(rewoundHitTestMs / static_cast<int64_t>(rewoundHitTests)) + " ms" +
+            " - Hits: " + std::to_string(rewoundHits));
+    }
+    rewoundHitTests = 0;
+    rewoundHitTestMs = 0;
+    rewoundHits = 0;
+
+    if (networkThread) {
+        LOG_MSG(debug, "Network thread - Received: " + std::to_string(networkThread->GetReceivedCount()) +
+            " - Sent: " + std::to_string(networkThread->GetSentCount()) +
+            " - Rejected: " + std::to_string(networkThread->GetRejectedCount()) +
+            " - Invalid: " + std::to_string(networkThread->GetInvalidCount()) +
+            " - Dropped in/out: " + std::to_string(networkThread->GetInboundDropped()) + "/" +
+            std::to_string(networkThread->GetOutboundDropped()));
+    }
+
+    if (batchedSocket) {
+        LOG_MSG(debug, "Batched socket - Received: " + std::to_string(batchedSocket->GetDatagramsReceived()) +
+            " in " + std::to_string(batchedSocket->GetReceiveCalls()) + " calls" +
+            " - Sent: " + std::to_string(batchedSocket->GetDatagramsSent()) +
+            " in " + std::to_string(batchedSocket->GetSendCalls()) + " calls" +
+            " - Send errors: " + std::to_string(batchedSocket->GetSendErrors()) +
+            " - Truncated: " + std::to_string(batchedSocket->GetTruncatedCount()));
+    }
+    if (sharedMemory && sharedMemory->GetDroppedCount() > 0) {
+        LOG_MSG(debug, "Shared memory - Dropped sends (ring full or client gone): " +
+            std::to_string(sharedMemory->GetDroppedCount()));
+    }
+
+    const uint32_t snapshotsSent = fullSnapshotsSent + deltaSnapshotsSent;
+    if (snapshotsSent > 0) {
+        LOG_MSG(debug, "Snapshots - Full: " + std::to_string(fullSnapshotsSent) +
+            " - Delta: " + std::to_string(deltaSnapshotsSent) +
+            " - Avg size: " + std::to_string(snapshotBytesSent / snapshotsSent) + " bytes" +
+            (sharedSnapshotBodies > 0 ? " - Shared encodes: " + std::to_string(sharedSnapshotBodies) : "") +
+            (stateResyncs > 0 ? " - Resyncs: " + std::to_string(stateResyncs) : ""));
+    }
+    stateResyncs = 0;
+    snapshotBytesSent = 0;
+    fullSnapshotsSent = 0;
+    deltaSnapshotsSent = 0;
+    sharedSnapshotBodies = 0;
+
+    if (coalescedDatagrams > 0) {
+        LOG_MSG(debug, "Coalescing - Messages: " + std::to_string(coalescedMessages) +
+            " - Datagrams: " + std::to_string(coalescedDatagrams));
+    }
+    coalescedMessages = 0;
+    coalescedDatagrams = 0;
+
+    if (resumedSessions > 0 || !suspendedClients.empty()) {
+        LOG_MSG(debug, "Sessions - Resumed: " + std::to_string(resumedSessions) +
+            " - Suspended: " + std::to_string(suspendedClients.size()));
+    }
+    resumedSessions = 0;
+
+    if (checkpointWriter.IsRunning()) {
+        const CheckpointWriter::Stats checkpoints = checkpointWriter.GetStats();
+        LOG_MSG(checkpoints.failed > reportedCheckpointStats.failed ? warning : debug,
+            "Checkpoints - Written: " + std::to_string(checkpoints.written - reportedCheckpointStats.written) +
+            " - Skipped: " + std::to_string(checkpoints.skipped - reportedCheckpointStats.skipped) +
+            " - Failed: " + std::to_string(checkpoints.failed - reportedCheckpointStats.failed) +
+            " - Last: " + std::to_string(checkpoints.lastBytes) + " bytes in " +
+            std::to_string(checkpoints.lastWriteMicros) + " us");
+        reportedCheckpointStats = checkpoints;
+    }
+
+    const SendPacer::Stats& pacing = sendPacer.GetStats();
+    if (pacing.datagrams > 0) {
+        LOG_MSG(pacing.late > 0 ? warning : debug, "Send pacing - Datagrams: " + std::to_string(pacing.datagrams) +
+            " - Avg offset: " + std::to_string(pacing.totalOffsetMicros / pacing.datagrams) + " us" +
+            " - Late: " + std::to_string(pacing.late));
+        sendPacer.ResetStats();
+    }
+
+    if (snapshotPipeline) {
+        const uint64_t frames = snapshotPipeline->GetFramesSent() - reportedPipelineFrames;
+        const uint64_t micros = snapshotPipeline->GetSendMicros() - reportedPipelineMicros;
+        LOG_MSG(snapshotPipeline->GetStalls() > 0 ? warning : debug, "Snapshot pipeline - Frames: " +
+            std::to_string(frames) + " - Avg send: " + std::to_string(frames > 0 ? micros / frames : 0) + " us" +
+            " - Tick waits (total): " + std::to_string(snapshotPipeline->GetStalls()));
+        reportedPipelineFrames += frames;
+        reportedPipelineMicros += micros;
+    }
+
+    if (compressedMessages > 0) {
+        LOG_MSG(debug, "Compression - Messages: " + std::to_string(compressedMessages) +
+            " - Saved: " + std::to_string(compressionBytesSaved) + " bytes");
+    }
+    compressedMessages = 0;
+    compressionBytesSaved = 0;
+
+    if (challengesSent > 0 || tokenRejections > 0) {
+        LOG_MSG(debug, "Handshake - Challenges sent: " + std::to_string(challengesSent) +
+            " - Datagrams rejected by token: " + std::to_string(tokenRejections));
+    }
+    challengesSent = 0;
+    tokenRejections = 0;
+
+    if (invalidMessages > 0) {
+        LOG_MSG(debug, "Ingress validation - Messages rejected on the tick thread: " + std::to_string(invalidMessages));
+    }
+    invalidMessages = 0;
+
+    if (ingressLimiter.GetTotalDropped() > 0) {
+        LOG_MSG(debug, "Ingress rate limit - Dropped in total: " + ingressLimiter.FormatDropped() +
+            " - Tracked endpoints: " + std::to_string(ingressLimiter.GetEndpointCount()));
+    }
+
+    const SpectatorStream::Stats& spectatorStats = spectatorStream.GetStats();
+    if (spectatorStream.HasSpectators() || spectatorStats.framesPublished != reportedSpectatorStats.framesPublished) {
+        const uint64_t frames = spectatorStats.framesPublished - reportedSpectatorStats.framesPublished;
+        LOG_MSG(info, "Spectators - Watching: " + std::to_string(spectatorStream.GetSpectatorCount()) +
+            " (delay " + std::to_string(spectatorStream.GetDelay()) + " ms)" +
+            " - Frames: " + std::to_string(frames) +
+            " (keyframes " + std::to_string(spectatorStats.keyframesPublished - reportedSpectatorStats.keyframesPublished) + ")" +
+            " - Avg frame: " + std::to_string(frames > 0 ?
+                (spectatorStats.bytesEncoded - reportedSpectatorStats.bytesEncoded) / frames : 0) + " bytes" +
+            " - Datagrams encoded/sent: " +
+            std::to_string(spectatorStats.datagramsEncoded - reportedSpectatorStats.datagramsEncoded) + "/" +
+            std::to_string(spectatorStats.datagramsSent - reportedSpectatorStats.datagramsSent) +
+            " - Refused: " + std::to_string(spectatorStats.subscriptionsRefused - reportedSpectatorStats.subscriptionsRefused));
+    }
+    reportedSpectatorStats = spectatorStats;
+
+    const SpectatorStream::Stats& lanStats = lanStream.GetStats();
+    if (IsLanMulticastEnabled()) {
+        const uint64_t frames = lanStats.framesPublished - reportedLanStats.framesPublished;
+        LOG_MSG(info, "LAN multicast " + lanGroup.toString() + ":" + std::to_string(lanGroupPort) +
+            " - Group delivery: " + std::to_string(groupDeliveryClients) + "/" + std::to_string(clients.size()) + " players" +
+            " - Frames: " + std::to_string(frames) +
+            " (keyframes " + std::to_string(lanStats.keyframesPublished - reportedLanStats.keyframesPublished) + ")" +
+            " - Sent: " + std::to_string((lanStats.bytesSent - reportedLanStats.bytesSent) / 1024) + " KB in " +
+            std::to_string(lanStats.datagramsSent - reportedLanStats.datagramsSent) + " datagrams");
+    }
+    reportedLanStats = lanStats;
+
+    LOG_MSG(info, "Chunks - Active: " + std::to_string(chunkActivity.GetActiveCount()) + "/" +
+        std::to_string(WorldChunks::COUNT) + " - Occupied: " + std::to_string(enemyChunks.GetOccupiedChunkCount()) +
+        " - Sleeping enemies: " + std::to_string(sleepingEnemies) +
+        " - Streamed: " + std::to_string(chunksStreamed));
+    chunksStreamed = 0;
+
+    if (recoveredInputs > 0) {
+        LOG_MSG(debug, "Inputs recovered from redundant copies: " + std::to_string(recoveredInputs));
+    }
+    recoveredInputs = 0;
+
+    for (auto& [playerId, client] : clients) {
+        const InputJitterBuffer::Stats inputStats = client.inputBuffer.TakeStats();
+        if (!client.isActive || inputStats.consumed + inputStats.concealed + inputStats.starved == 0) {
+            continue;
+        }
+        LOG_MSG(inputStats.starved > 0 || inputStats.trimmed > 0 || inputStats.concealed > 0 ? info : debug,
+            "Input buffer - " + client.playerName +
+            " - Depth: " + std::to_string(client.inputBuffer.GetDepth()) +
+            " (target " + std::to_string(client.inputBuffer.GetTargetDepth()) +
+            ", max " + std::to_string(inputStats.maxDepth) + ")" +
+            " - Jitter: " + std::to_string(client.inputBuffer.GetJitterMs()) + " ms" +
+            " - Starved ticks: " + std::to_string(inputStats.starved) +
+            " - Concealed: " + std::to_string(inputStats.concealed) +
+            " (" + std::to_string(inputStats.superseded) + " late inputs dropped)" +
+            " - Trimmed: " + std::to_string(inputStats.trimmed));
+    }
+
+    if (reliableResends > 0) {
+        LOG_MSG(debug, "Reliable events resent: " + std::to_string(reliableResends));
+    }
+    reliableResends = 0;
+
+    PrintBandwidthStats();
+
+    // Steady-state input traffic should not allocate; joins and leaves still do
+    const uint64_t newReceiveAllocations = receivePathAllocations - reportedReceiveAllocations;
+    if (newReceiveAllocations > 0) {
+        LOG_MSG(debug, "Receive path allocations: " + std::to_string(newReceiveAllocations));
+    }
+    reportedReceiveAllocations = receivePathAllocations;
+
+    const uint64_t newTickAllocations = tickAllocations - reportedTickAllocations;
+    if (newTickAllocations > 0) {
+        LOG_MSG(debug, "Tick allocations: " + std::to_string(newTickAllocations) + " in " +
+            std::to_string(tickNumber - reportedTickNumber) + " ticks");
+    }
+    reportedTickAllocations = tickAllocations;
+    reportedTickNumber = tickNumber;
+}
+
+/**
+ * Two passes: inputs come from the client table (the jitter buffers are
+ * connection state), then the movement step runs over the dense player
+ * states alone.
+ */
+void GameServer::SimulatePlayerMovement(float deltaTime) {
+    for (auto& [playerId, client] : clients) {
+        if (!client.isActive) continue;
+
+        // One queued input per tick (or a concealed repeat, see InputJitterBuffer)
+        BufferedInput input;
+        const InputJitterBuffer::Playout playout = client.inputBuffer.Pop(input);
+        if (playout == InputJitterBuffer::Playout::RELEASED) {
+            // A tick the client's prediction has no step for: stand still
+            input = BufferedInput();
+            input.sequenceNumber = client.lastAcknowledgedInputSeq;
+            input.barrelRotation = SimOf(client).player.barrelRotation;
+        }
+        if (playout != InputJitterBuffer::Playout::HELD) {
+            PlayerSimState& sim = SimOf(client);
+            PlayerData& player = sim.player;
+            if (player.isMoving_forward != input.isMoving_forward || player.isMoving_backward != input.isMoving_backward ||
+                player.isMoving_left != input.isMoving_left || player.isMoving_right != input.isMoving_right) {
+                sim.dirtyFields |= SnapshotDelta::PLAYER_MOVEMENT;
+            }
+            if (player.barrelRotation != input.barrelRotation) {
+                sim.dirtyFields |= SnapshotDelta::PLAYER_BARREL_ROTATION;
+            }
+            player.isMoving_forward = input.isMoving_forward;
+            player.isMoving_backward = input.isMoving_backward;
+            player.isMoving_left = input.isMoving_left;
+            player.isMoving_right = input.isMoving_right;
+            player.barrelRotation = input.barrelRotation;
+            if (playout != InputJitterBuffer::Playout::RELEASED) {
+                client.lastAcknowledgedInputSeq = input.sequenceNumber;
+                client.lastInputApplyMicros = tickClock.GetServerMicros();
+            }
+        }
+    }
+
+    for (PlayerSimState& sim : playerSims) {
+        if (!sim.inUse) continue;
+
+        // Same kernel and obstacle response as the client's prediction
+        PlayerData& player = sim.player;
+        const TankMovement::Input movement{ player.isMoving_forward, player.isMoving_backward,
+            player.isMoving_left, player.isMoving_right };
+        TankMovement::Transform moved = TankMovement::Step(
+            { player.x, player.y, player.bodyRotation }, movement, deltaTime);
+        const sf::Vector2f resolved = obstacles.ResolveCircle(sf::Vector2f(moved.x, moved.y), WorldConstants::TANK_RADIUS);
+        moved.x = resolved.x;
+        moved.y = resolved.y;
+        if (moved.x != player.x || moved.y != player.y) {
+            sim.dirtyFields |= SnapshotDelta::PLAYER_POSITION;
+        }
+        if (moved.rotationDegrees != player.bodyRotation) {
+            sim.dirtyFields |= SnapshotDelta::PLAYER_BODY_ROTATION;
+        }
+        player.x = moved.x;
+        player.y = moved.y;
+        player.bodyRotation = moved.rotationDegrees;
+    }
+}
+
+void GameServer::Shutdown() {
+    try {
+        if (isRunning) {
+            LOG_MSG(warning, "Shutting down game server...");
+            if (networkThread) {
+                networkThread->Stop();
+                networkThread.reset();
+            }
+            channel = nullptr;
+            if (snapshotPipeline) {
+                snapshotPipeline->Stop();   // Sends the frames already handed over
+                snapshotPipeline.reset();
+                sendFrame = nullptr;
+            }
+            if (checkpointWriter.IsRunning()) {
+                checkpointWriter.Stop();
+                checkpointWriter.Remove();      // A match that ended cleanly is not resumed
+            }
+            handoffListener.Close();
+            if (sendPacer.HasPending()) {
+                ReleasePacedDatagrams(true);
+            }
+            if (batchedSocket) {
+                batchedSocket->FlushSends();
+                batchedSocket->Close();
+                batchedSocket.reset();
+            }
+            if (sharedMemory) {
+                sharedMemory->Close();
+                sharedMemory.reset();
+            }
+            if (metricsExporter) {
+                metricsExporter->Stop();
+                metricsExporter.reset();
+            }
+            if (conditioner) {
+                conditioner->Flush(socket, true);
+                conditioner.reset();
+            }
+            CleanupSocketResources();
+            clients.clear();
+            clientsByEndpoint.clear();
+            suspendedClients.clear();
+            playerSims.clear();
+            freePlayerSlots.clear();
+            colorUsers.fill(0);
+            joinStatePending.clear();
+            enemyRegistry.clear();
+            deadEnemies.clear();
+            enemyAIDeferredTime.clear();
+            playerFlowFields.clear();
+            projectiles.Clear();
+            timers.Reset(tickNumber);
+            firedTimers.clear();
+
+            isRunning = false;
+            LOG_MSG(success, "Game server shut down");
+        }
+        if (recorder) {
+            recorder->Close();
+            LOG_MSG(info, "Match recording closed after " + std::to_string(tickNumber) + " ticks (" +
+                std::to_string(recorder->GetBytesWritten()) + " bytes, " + std::to_string(recorder->GetKeyframeCount()) + " keyframes)");
+            recorder.reset();
+        }
+        if (capture) {
+            capture->Close();
+            capture.reset();
+        }
+        if (journal) {
+            journal->Close();
+            journal.reset();
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception during server shutdown: " + std::string(e.what()), error);
+        isRunning = false;
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception during server shutdown", error);
+        isRunning = false;
+    }
+}
+
+void GameServer::CleanupSocketResources() {
+    try {
+        idleSelector.clear();
+        socket.unbind();
+    }
+    catch (const std::exception& e) {
+        LOG_MSG(warning, "Exception during socket cleanup: " + std::string(e.what()));
+    }
+    catch (...) {
+        LOG_MSG(warning, "Unknown exception during socket cleanup");
+    }
+}
+
+std::string GameServer::SocketStatusToString(sf::Socket::Status status) const {
+    switch (status) {
+    case sf::Socket::Status::Done:         return "Done";
+    case sf::Socket::Status::NotReady:     return "NotReady";
+    case sf::Socket::Status::Partial:      return "Partial";
+    case sf::Socket::Status::Disconnected: return "Disconnected";
+    case sf::Socket::Status::Error:        return "Error";
+    default:                                return "Unknown";
+    }
+}
+
+void GameServer::DetectAndReportPacketLoss() {
+    for (auto& [playerId, client] : clients) {
+        if (!client.isActive) continue;
+
+        float lossPercentage = 0.0f;
+        if (GetPacketLoss(client, lossPercentage) && lossPercentage >= NetworkValidation::PACKET_LOSS_THRESHOLD) {
+            LOG_MSG(warning, "High packet loss detected for player " +
+                std::to_string(playerId) + " (" +
+                client.playerName + "): " +
+                std::to_string(lossPercentage) + "%");
+        }
+    }
+}
+
+bool GameServer::GetPacketLoss(const ClientInfo& client, float& lossPercentage) {
+    if (client.receivedSequences.GetSpan() < NetworkValidation::SEQUENCE_WINDOW_SIZE) {
+        return false;
+    }
+    lossPercentage = client.receivedSequences.GetLossPercentage();
+    return true;
+}
+
+/**
+ * The ack doubles as the client's RTT and clock sample, so it carries the
+ * same real steady times a PONG does; clients then need no separate pings
+ * while they are sending input.
+ */
+void GameServer::SendInputAcknowledgment(uint32_t playerId, uint32_t acknowledgedSeq, int64_t echoSendMicros,
+    sf::IpAddress clientIP, unsigned short clientPort) {
+    try {
+        InputAcknowledgmentMessage ackMsg;
+        ackMsg.type = NetMessageType::INPUT_ACKNOWLEDGMENT;
+        ackMsg.playerId = playerId;
+        ackMsg.acknowledgedSequence = acknowledgedSeq;
+        ackMsg.serverTimestamp = GetCurrentTimestamp();
+        auto clientIt = clients.find(playerId);
+        if (clientIt != clients.end()) {
+            ackMsg.concealedBits = clientIt->second.inputBuffer.GetConcealedBits();
+        }
+        if (echoSendMicros > 0) {
+            ackMsg.echoSendMicros = echoSendMicros;
+            ackMsg.serverReceiveMicros = packetArrivalMicros != 0 ? packetArrivalMicros : GetSteadyMicros();
+        }
+
+        PacketPool::Lease packet = sendPackets.Borrow();
+        if (echoSendMicros > 0) {
+            ackMsg.serverTransmitMicros = GetSteadyMicros();
+        }
+        *packet << ackMsg;
+
+        if (clientIt != clients.end()) {
+            QueueForClient(clientIt->second, *packet);
+            return;
+        }
+
+        bandwidth.RecordMessageSent(*packet);
+        sf::Socket::Status sendStatus = SendPacket(*packet, clientIP, clientPort);
+
+        if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
+            static thread_local int failCount = 0;
+            if (++failCount % 100 == 0) {
+                LOG_MSG(warning, "Failed to send input acks (count: " +
+                    std::to_string(failCount) + ")");
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SendInputAcknowledgment: " + std::string(e.what()), error);
+    }
+}
+
+uint64_t GameServer::GetCurrentTimestamp() const {
+    return static_cast<uint64_t>(tickClock.GetServerMs());
+}
+
+void GameServer::SetRandomSeed(uint32_t seed) {
+    randomSeed = seed;
+    randomSeedSet = true;
+    chunkContent.SetSeed(seed);
+}
+
+/**
+ * Opens the recording and writes its header. Every clock read within a tick
+ * returns the tick's start time (see TickClock), which is what the recording
+ * stores, so a replay sees the same times.
+ */
+bool GameServer::StartRecording(const std::string& path, float keyframeIntervalSeconds) {
+    if (!randomSeedSet) {
+        SetRandomSeed(randomSeed);     // Keeps the streams enemies already hold
+    }
+
+    MatchHeader header;
+    header.seed = randomSeed;
+    header.tickRate = static_cast<uint16_t>(GetTickRate());
+    header.flags = (lagCompensationEnabled ? MatchHeader::FLAG_LAG_COMPENSATION : 0) |
+        (enemyAILodEnabled ? MatchHeader::FLAG_ENEMY_AI_LOD : 0) |
+        (enemySquadsEnabled ? MatchHeader::FLAG_ENEMY_SQUADS : 0);
+
+    auto newRecorder = std::make_unique<MatchRecorder>();
+    if (!newRecorder->Open(path, header)) {
+        Utils::printMsg("Could not create match recording " + path, error);
+        return false;
+    }
+    recorder = std::move(newRecorder);
+    recordedOverloadLevel = 0;
+    keyframeInterval = std::max(0.0f, keyframeIntervalSeconds);
+    keyframeTimer = 0;
+
+    LOG_MSG(info, "Recording match to " + path + " (seed " + std::to_string(randomSeed) + ")");
+    if (enemyAIBudgetUs > 0) {
+        LOG_MSG(warning, "Enemy AI budget deferral depends on wall time: replays run unbudgeted and may diverge");
+    }
+    return true;
+}
+
+/**
+ * The world at the end of this tick, sessions included, so a replay restored
+ * from it accepts the next recorded messages as the live server did. Runs on
+ * the tick thread: every keyframeInterval it pays for one capture and encode.
+ */
+void GameServer::RecordKeyframe() {
+    TRACE_SCOPE("Record keyframe", "checkpoint");
+    CaptureCheckpoint(keyframeState, true);
+    CheckpointFormat::Encode(keyframeState, keyframeBytes);
+    recorder->RecordKeyframe(tickNumber, overload.GetLevel(), keyframeBytes);
+}
+
+bool GameServer::StartCapture(const std::string& path) {
+    auto newCapture = std::make_unique<PacketCapture>();
+    if (!newCapture->Open(path, PacketCapture::Side::SERVER)) {
+        return false;
+    }
+    capture = std::move(newCapture);
+    return true;
+}
+
+bool GameServer::StartJournal(const std::string& path) {
+    auto newJournal = std::make_unique<EventJournal>();
+    if (!newJournal->Open(path, static_cast<uint16_t>(GetTickRate()))) {
+        return false;
+    }
+    journal = std::move(newJournal);
+    return true;
+}
+
+void GameServer::JournalEvent(EventJournal::EventType type, uint32_t subjectId, uint32_t otherId, int32_t value,
+    sf::Vector2f position, uint8_t detail) {
+    if (!journal || replayTick) {
+        return;
+    }
+    EventJournal::Event event;
+    event.tick = tickNumber;
+    event.type = type;
+    event.detail = detail;
+    event.subjectId = subjectId;
+    event.otherId = otherId;
+    event.value = value;
+    event.x = position.x;
+    event.y = position.y;
+    journal->Record(event);
+}
+
+/**
+ * Feeds each recorded tick's messages through ProcessPacket in place of the
+ * socket, with the recorded clock and step size, and compares the resulting
+ * world hash with the recorded one. The first mismatch is logged; replay
+ * carries on so the total count shows whether it recovers or stays apart.
+ * A seek restores the keyframe as a handoff would and replays the ticks after
+ * it. Enemy AI restarts from its spawn state there (see RestoreCheckpoint),
+ * so with enemies about, hashes after a seek may differ from the recording.
+ */
+bool GameServer::RunReplay(const std::string& path, ReplayResult& result, uint32_t seekTick) {
+    result = ReplayResult();
+    if (isRunning || recorder) {
+        Utils::printMsg("Replay needs a server that is neither running nor recording", error);
+        return false;
+    }
+
+    MatchReader reader;
+    if (!reader.Open(path)) {
+        Utils::printMsg("Could not open match recording " + path + " (missing, or not a version " +
+            std::to_string(MatchHeader::VERSION) + " recording)", error);
+        return false;
+    }
+    const MatchHeader& header = reader.GetHeader();
+    SetRandomSeed(header.seed);
+    lagCompensationEnabled = (header.flags & MatchHeader::FLAG_LAG_COMPENSATION) != 0;
+    enemyAILodEnabled = (header.flags & MatchHeader::FLAG_ENEMY_AI_LOD) != 0;
+    enemySquadsEnabled = (header.flags & MatchHeader::FLAG_ENEMY_SQUADS) != 0;
+    enemyAIBudgetUs = 0;
+    overload.SetEnabled(false);     // Levels come from the recording
+    overload.SetLevel(0);
+    ApplyOverloadLevel();
+    statsReportingEnabled = false;
+    isRunning = true;
+    tickProfiler.Reset();
+    LOG_MSG(info, "Replaying " + path + " (seed " + std::to_string(header.seed) + ", recorded at " +
+        std::to_string(header.tickRate) + " Hz)");
+
+    RecordedTick tick;
+    const auto start = std::chrono::steady_clock::now();
+    if (seekTick > 0) {
+        MatchCheckpoint keyframe;
+        if (reader.SeekToKeyframe(seekTick, keyframe, tick)) {
+            RestoreCheckpoint(keyframe, path);
+            result.keyframeTick = keyframe.tick;
+        }
+        else {
+            LOG_MSG(warning, "No keyframe at or before tick " + std::to_string(seekTick) + " in " + path +
+                " (" + std::to_string(reader.GetKeyframes().size()) + " keyframes); replaying from the start");
+        }
+    }
+    bool seeking = seekTick > 0;
+    while (isRunning && reader.ReadTick(tick)) {
+        tickNumber = tick.tick;
+        if (result.ticks == 0 && result.keyframeTick == 0) {
+            ResetTimers();
+        }
+        tickClock.BeginTick(tickNumber, tick.timestampMs * 1000);
+        replayTick = &tick;
+        Update(tick.deltaTime);
+
+        result.ticks++;
+        result.messages += tick.messageCount;
+        result.simulatedSeconds += tick.deltaTime;
+        if (seeking && tick.tick >= seekTick) {
+            seeking = false;
+            result.seekSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            LOG_MSG(info, "Reached tick " + std::to_string(tick.tick) + " in " + std::to_string(result.ticks) +
+                " ticks from " + (result.keyframeTick > 0 ? "the keyframe at tick " + std::to_string(result.keyframeTick) : std::string("the start")));
+        }
+        if (tick.hasStateHash && ComputeStateHash() != tick.stateHash) {
+            if (result.hashMismatches == 0) {
+                result.firstMismatchTick = tick.tick;
+                LOG_MSG(warning, "Replay diverged from the recording at tick " + std::to_string(tick.tick));
             }
+            result.hashMismatches++;
         }
-        Utils::printMsg(playerList);
     }
+    replayTick = nullptr;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (reader.IsCorrupt()) {
+        LOG_MSG(warning, "Recording ends in a truncated or unknown record after " +
+            std::to_string(result.ticks) + " ticks");
+    }
+    PrintTickPhaseStats();
+    Shutdown();
+    return true;
 }
 
-void GameServer::SimulatePlayerMovement(float deltaTime) {
-    const float MOVEMENT_SPEED = 150.0f;
-    const float ROTATION_SPEED = 200.0f;
+/**
+ * Everything the simulation decides, in ID order so the hash does not depend
+ * on container iteration order: player transforms, health, score and state;
+ * enemy transforms and health; bullet IDs, owners and positions.
+ */
+uint64_t GameServer::ComputeStateHash() const {
+    uint64_t hash = FNV_OFFSET_BASIS;
 
-    for (auto& [playerId, client] : clients) {
-        if (!client.isActive) continue;
+    std::vector<uint32_t> playerIds;
+    playerIds.reserve(clients.size());
+    for (const auto& [playerId, client] : clients) {
+        playerIds.push_back(playerId);
+    }
+    std::sort(playerIds.begin(), playerIds.end());
+    for (uint32_t playerId : playerIds) {
+        const ClientInfo& client = clients.at(playerId);
+        const PlayerData& player = SimOf(client).player;
+        HashValue(hash, playerId);
+        HashValue(hash, player.x);
+        HashValue(hash, player.y);
+        HashValue(hash, player.bodyRotation);
+        HashValue(hash, player.barrelRotation);
+        HashValue(hash, player.health);
+        HashValue(hash, client.score);
+        HashValue(hash, client.isDead);
+        HashValue(hash, client.isActive);
+    }
 
-        PlayerData& player = client.playerData;
+    std::vector<std::pair<uint32_t, entt::entity>> enemies;
+    auto view = enemyRegistry.view<const ServerComponents::NetworkId>();
+    for (auto [entity, networkId] : view.each()) {
+        enemies.emplace_back(networkId.id, entity);
+    }
+    std::sort(enemies.begin(), enemies.end());
+    for (const auto& [enemyId, entity] : enemies) {
+        const auto& transform = enemyRegistry.get<ServerComponents::Transform>(entity);
+        const auto& health = enemyRegistry.get<ServerComponents::Health>(entity);
+        HashValue(hash, enemyId);
+        HashValue(hash, transform.position.x);
+        HashValue(hash, transform.position.y);
+        HashValue(hash, transform.bodyRotation);
+        HashValue(hash, transform.barrelRotation);
+        HashValue(hash, health.current);
+        HashValue(hash, health.dead);
+    }
 
-        if (player.isMoving_left) {
-            player.bodyRotation -= ROTATION_SPEED * deltaTime;
-        }
-        else if (player.isMoving_right) {
-            player.bodyRotation += ROTATION_SPEED * deltaTime;
-        }
+    std::vector<std::pair<uint32_t, uint32_t>> bullets;   // bulletId, slot
+    for (uint32_t slot : projectiles.GetActiveSlots()) {
+        bullets.emplace_back(projectiles.GetBulletId(slot), slot);
+    }
+    std::sort(bullets.begin(), bullets.end());
+    for (const auto& [bulletId, slot] : bullets) {
+        const sf::Vector2f position = projectiles.GetPosition(slot);
+        HashValue(hash, bulletId);
+        HashValue(hash, projectiles.GetOwnerId(slot));
+        HashValue(hash, position.x);
+        HashValue(hash, position.y);
+    }
+    return hash;
+}
 
-        while (player.bodyRotation < 0.0f) {
-            player.bodyRotation += 360.0f;
-        }
-        while (player.bodyRotation >= 360.0f) {
-            player.bodyRotation -= 360.0f;
-        }
+void GameServer::SetCheckpoint(const std::string& path, float intervalSeconds) {
+    checkpointPath = path;
+    checkpointInterval = std::max(0.0f, intervalSeconds);
+}
 
-        float radians = player.bodyRotation * 3.14159f / 180.0f;
-        float dirX = std::cos(radians);
-        float dirY = std::sin(radians);
+/**
+ * A match handed over by the previous process is carried on. Otherwise a
+ * checkpoint left at checkpointPath means the previous server did not shut
+ * down cleanly: its match is restored before the first tick. One that cannot
+ * be used is reported and overwritten by the new match's first checkpoint.
+ */
+void GameServer::ResumeMatch() {
+    const bool handedOver = handoffState != nullptr;
+    if (handedOver) {
+        RestoreCheckpoint(*handoffState, handoffPath);
+        handoffState.reset();
+    }
 
-        if (player.isMoving_forward) {
-            player.x += dirX * MOVEMENT_SPEED * deltaTime;
-            player.y += dirY * MOVEMENT_SPEED * deltaTime;
+    if (!checkpointPath.empty()) {
+        if (recorder || replayTick) {
+            LOG_MSG(warning, "Checkpoints are off while recording or replaying a match");
         }
-        else if (player.isMoving_backward) {
-            player.x -= dirX * MOVEMENT_SPEED * deltaTime;
-            player.y -= dirY * MOVEMENT_SPEED * deltaTime;
+        else {
+            // After a handoff the checkpoint on disk is older than the match
+            MatchCheckpoint checkpoint;
+            if (!handedOver && CheckpointFormat::Load(checkpointPath, checkpoint)) {
+                if (checkpoint.tickRate != GetTickRate()) {
+                    LOG_MSG(warning, "Checkpoint " + checkpointPath + " was written at " + std::to_string(checkpoint.tickRate) +
+                        " Hz, not " + std::to_string(GetTickRate()) + " Hz; starting a new match");
+                }
+                else {
+                    RestoreCheckpoint(checkpoint, checkpointPath);
+                }
+            }
+            else if (!handedOver && std::ifstream(checkpointPath).good()) {
+                LOG_MSG(warning, "Checkpoint " + checkpointPath + " is damaged or from another version; starting a new match");
+            }
+
+            checkpointTimer = 0;
+            reportedCheckpointStats = CheckpointWriter::Stats();
+            if (checkpointWriter.Start(checkpointPath)) {
+                LOG_MSG(info, "Checkpointing the match to " + checkpointPath + " every " +
+                    std::to_string(checkpointInterval) + " s");
+            }
         }
+    }
 
-        player.x = std::max(WorldConstants::MOVEMENT_MIN_X,
-            std::min(WorldConstants::MOVEMENT_MAX_X, player.x));
-        player.y = std::max(WorldConstants::MOVEMENT_MIN_Y,
-            std::min(WorldConstants::MOVEMENT_MAX_Y, player.y));
+    if (!handoffPath.empty() && handoffListener.Listen(handoffPath)) {
+        LOG_MSG(info, "Waiting for the next server process at " + handoffPath + " to hand the match over to");
     }
 }
 
-void GameServer::Shutdown() {
-    try {
-        if (isRunning) {
-            Utils::printMsg("Shutting down game server...", warning);
-            CleanupSocketResources();
-            clients.clear();
-            enemies.clear();
-            bullets.clear();
+/**
+ * Runs before anything is bound: the old server only lets go of the port
+ * once it has answered. No server at the path is the normal first start.
+ */
+void GameServer::RequestHandoff() {
+    if (useSharedMemory || recorder || replayTick) {
+        LOG_MSG(warning, "Server handoff is off with shared memory and while recording or replaying a match");
+        handoffPath.clear();
+        return;
+    }
+    if (!Handoff::IsSupported()) {
+        LOG_MSG(warning, "Server handoff is not available on this platform");
+        handoffPath.clear();
+        return;
+    }
 
-            isRunning = false;
-            Utils::printMsg("Game server shut down", success);
-        }
+    std::vector<uint8_t> bytes;
+    if (!Handoff::Request(handoffPath, Handoff::REQUEST_TIMEOUT_MS, bytes, handoffSocket)) {
+        return;
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception during server shutdown: " + std::string(e.what()), error);
-        isRunning = false;
+    auto state = std::make_unique<MatchCheckpoint>();
+    if (!CheckpointFormat::Decode(bytes, *state) || !state->handoff) {
+        LOG_MSG(error, "Match handed over at " + handoffPath + " is damaged or from another version; starting a new match");
+        return;
     }
-    catch (...) {
-        Utils::printMsg("Unknown exception during server shutdown", error);
-        isRunning = false;
+    if (state->tickRate != GetTickRate()) {
+        LOG_MSG(error, "Match handed over at " + handoffPath + " runs at " + std::to_string(state->tickRate) +
+            " Hz, not " + std::to_string(GetTickRate()) + " Hz; starting a new match");
+        return;
     }
+    LOG_MSG(success, "Took the match over from the server at " + handoffPath + " (" + std::to_string(bytes.size()) +
+        " bytes" + (handoffSocket >= 0 ? ", with its socket)" : ", binding the port again)"));
+    handoffState = std::move(state);
 }
 
-void GameServer::CleanupSocketResources() {
-    try {
-        socket.unbind();
+/**
+ * Called as a tick ends, after its datagrams went out: everything queued is
+ * flushed first, then the network thread and the checkpoint writer stop, so
+ * nothing in this process touches the socket or the file once the new server
+ * has them. If the reply fails while the socket is still ours, the match
+ * carries on here; once the socket is closed it cannot.
+ */
+void GameServer::HandOff() {
+    LOG_MSG(warning, "Handing the match over to a new server process...");
+    if (networkThread) {
+        networkThread->Stop();
+        networkThread.reset();
+        socket.setBlocking(false);
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception during socket cleanup: " + std::string(e.what()), warning);
+    channel = nullptr;
+    if (snapshotPipeline) {
+        snapshotPipeline->Stop();
+        snapshotPipeline.reset();
+        sendFrame = nullptr;
     }
-    catch (...) {
-        Utils::printMsg("Unknown exception during socket cleanup", warning);
+    if (sendPacer.HasPending()) {
+        ReleasePacedDatagrams(true);
     }
-}
-
-std::string GameServer::SocketStatusToString(sf::Socket::Status status) const {
-    switch (status) {
-    case sf::Socket::Status::Done:         return "Done";
-    case sf::Socket::Status::NotReady:     return "NotReady";
-    case sf::Socket::Status::Partial:      return "Partial";
-    case sf::Socket::Status::Disconnected: return "Disconnected";
-    case sf::Socket::Status::Error:        return "Error";
-    default:                                return "Unknown";
+    if (batchedSocket) {
+        batchedSocket->FlushSends();
+    }
+    if (conditioner) {
+        conditioner->Flush(socket, true);
+    }
+    checkpointWriter.Stop();        // The new server checkpoints from here on
+
+    MatchCheckpoint state;
+    CaptureCheckpoint(state, true);
+    std::vector<uint8_t> bytes;
+    CheckpointFormat::Encode(state, bytes);
+
+    const int socketHandle = batchedSocket ? batchedSocket->GetNativeHandle() : -1;
+    if (socketHandle < 0) {
+        // Nothing to pass: free the port for the new server to bind
+        if (batchedSocket) {
+            batchedSocket->Close();
+        }
+        CleanupSocketResources();
     }
-}
-
-void GameServer::DetectAndReportPacketLoss() {
-    for (auto& [playerId, client] : clients) {
-        if (!client.isActive) continue;
-
-        if (client.lastReceivedSequenceNumber > NetworkValidation::SEQUENCE_WINDOW_SIZE) {
-            uint32_t expectedPackets = NetworkValidation::SEQUENCE_WINDOW_SIZE;
-            uint32_t receivedPackets = static_cast<uint32_t>(client.receivedSequenceNumbers.size());
-
-            if (receivedPackets < expectedPackets) {
-                float lossPercentage = ((expectedPackets - receivedPackets) /
-                    static_cast<float>(expectedPackets)) * 100.0f;
 
-                if (lossPercentage >= NetworkValidation::PACKET_LOSS_THRESHOLD) {
-                    Utils::printMsg("High packet loss detected for player " +
-                        std::to_string(playerId) + " (" +
-                        client.playerData.playerName + "): " +
-                        std::to_string(lossPercentage) + "%", warning);
-                }
+    if (!handoffListener.SendHandoff(bytes, socketHandle)) {
+        if (socketHandle >= 0) {
+            Utils::printMsg("Server handoff failed; carrying on with the match here", error);
+            if (!checkpointPath.empty()) {
+                checkpointWriter.Start(checkpointPath);
             }
+            handoffListener.Listen(handoffPath);
+            return;
         }
+        Utils::printMsg("Server handoff failed after the socket was closed; ending the match", error);
+    }
+    else {
+        LOG_MSG(success, "Handed the match over at tick " + std::to_string(tickNumber) + " (" +
+            std::to_string(state.players.size()) + " players, " + std::to_string(bytes.size()) + " bytes)");
     }
+    handedOff = true;       // The checkpoint file stays: it belongs to the new server, or restarts this match
+    Shutdown();
 }
 
-void GameServer::SendInputAcknowledgment(uint32_t playerId, uint32_t acknowledgedSeq,
-    sf::IpAddress clientIP, unsigned short clientPort) {
-    try {
-        sf::Packet packet;
-        InputAcknowledgmentMessage ackMsg;
-        ackMsg.type = NetMessageType::INPUT_ACKNOWLEDGMENT;
-        ackMsg.playerId = playerId;
-        ackMsg.acknowledgedSequence = acknowledgedSeq;
-        ackMsg.serverTimestamp = GetCurrentTimestamp();
+/**
+ * Runs on the tick thread as the tick ends, so it only copies: encoding and
+ * the disk are the writer thread's. Timers are kept as the ticks they have
+ * left after this one.
+ */
+void GameServer::CaptureCheckpoint(MatchCheckpoint& out, bool withSessions) const {
+    auto ticksLeft = [this](TimerWheel::TimerId timer) -> uint32_t {
+        const uint64_t dueTick = timers.GetDueTick(timer);
+        return dueTick > tickNumber ? static_cast<uint32_t>(dueTick - tickNumber) : 0;
+    };
+
+    out.Clear();
+    out.savedAtMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    out.tick = tickNumber;
+    out.tickRate = static_cast<uint16_t>(GetTickRate());
+    out.seed = randomSeed;
+    out.seedSet = randomSeedSet;
+    out.handoff = withSessions;
+    out.nextPlayerId = nextPlayerId;
+    out.nextEnemyId = nextEnemyId;
+    out.nextBulletId = nextBulletId;
+    out.outgoingSequence = outgoingSequenceNumber;
+    out.playerTableVersion = playerTableVersion;
+    out.enemySpawnTicks = enemySpawnDue ? 0 : ticksLeft(enemySpawnTimer);
+
+    // Suspended sessions too: their clients may still come back
+    auto addPlayer = [&](uint32_t playerId, const ClientInfo& client) {
+        if (client.slot == ClientInfo::NO_SLOT || client.connectionToken == 0) {
+            return;
+        }
+        MatchCheckpoint::Player& player = out.players.emplace_back();
+        player.playerId = playerId;
+        player.name = client.playerName;
+        player.connectionToken = client.connectionToken;
+        player.address = client.address.toInteger();
+        player.port = client.port;
+        player.state = SimOf(client).player;
+        player.state.score = client.score;
+        player.state.isDead = client.isDead;
+        player.respawnTicks = client.isDead ? ticksLeft(client.respawnTimer) : 0;
+        if (withSessions) {
+            MatchCheckpoint::Session& session = player.session;
+            session.active = client.isActive;
+            session.nextSnapshotSequence = client.nextSnapshotSequence;
+            session.lastReceivedInputSeq = client.lastReceivedInputSeq;
+            session.lastAcknowledgedInputSeq = client.lastAcknowledgedInputSeq;
+            session.ackedPlayerTableVersion = client.ackedPlayerTableVersion;
+            session.reliableFirstSequence = client.reliable.GetFirstSequence();
+            client.reliable.ForEachHeld([&session](bool acked, const std::vector<uint8_t>& bytes) {
+                session.reliable.push_back({ acked, bytes });
+            });
+        }
+    };
+    for (const auto& [playerId, client] : clients) {
+        addPlayer(playerId, client);
+    }
+    for (const auto& [playerId, client] : suspendedClients) {
+        addPlayer(playerId, client);
+    }
 
-        packet << static_cast<uint8_t>(ackMsg.type)
-            << ackMsg.playerId
-            << ackMsg.acknowledgedSequence
-            << ackMsg.serverTimestamp;
+    auto enemyView = enemyRegistry.view<const ServerComponents::NetworkId, const ServerComponents::Transform,
+        const ServerComponents::Health, const ServerComponents::EnemyKind>();
+    for (auto [entity, networkId, transform, health, kind] : enemyView.each()) {
+        if (health.dead) {
+            continue;
+        }
+        MatchCheckpoint::Enemy& enemy = out.enemies.emplace_back();
+        enemy.enemyId = networkId.id;
+        enemy.type = static_cast<uint8_t>(kind.type);
+        enemy.x = transform.position.x;
+        enemy.y = transform.position.y;
+        enemy.bodyRotation = transform.bodyRotation;
+        enemy.barrelRotation = transform.barrelRotation;
+        enemy.health = health.current;
+        enemy.maxHealth = health.max;
+    }
 
-        sf::Socket::Status sendStatus = socket.send(packet, clientIP, clientPort);
+    for (uint32_t slot : projectiles.GetActiveSlots()) {
+        if (projectiles.IsDestroyed(slot)) {
+            continue;
+        }
+        const sf::Vector2f position = projectiles.GetPosition(slot);
+        const sf::Vector2f velocity = projectiles.GetVelocity(slot);
+        const float speed = std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+        MatchCheckpoint::Bullet& bullet = out.bullets.emplace_back();
+        bullet.bulletId = projectiles.GetBulletId(slot);
+        bullet.ownerId = projectiles.GetOwnerId(slot);
+        bullet.type = projectiles.GetBulletType(slot);
+        bullet.layer = projectiles.GetCollisionLayer(slot);
+        bullet.x = position.x;
+        bullet.y = position.y;
+        bullet.directionX = speed > 0.0f ? velocity.x / speed : 1.0f;
+        bullet.directionY = speed > 0.0f ? velocity.y / speed : 0.0f;
+        bullet.flownSeconds = BulletStats::ForType(bullet.type).lifetime - projectiles.GetLifetime(slot);
+    }
+}
 
-        if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
-            static int failCount = 0;
-            if (++failCount % 100 == 0) {
-                Utils::printMsg("Failed to send input acks (count: " +
-                    std::to_string(failCount) + ")", warning);
+/**
+ * Rebuilds the match on a server that has not ticked yet, carrying on with
+ * the tick after the checkpoint's. Every player comes back as a suspended
+ * session with the usual grace, so clients that notice the silence resume
+ * with their connection token while the rest expire. Sequence numbers, the
+ * player table version and entity IDs jump past anything the crashed server
+ * may have sent after the checkpoint, so clients take the new state as newer.
+ * A handed over match is exactly where the old server stopped: no gaps, and
+ * connected players stay connected with their sessions as they were.
+ * Enemy AI starts over from its spawn state.
+ */
+void GameServer::RestoreCheckpoint(const MatchCheckpoint& checkpoint, const std::string& source) {
+    tickNumber = checkpoint.tick + 1;
+    // The same seed and tick draw the same numbers the checkpointed match would have
+    randomSeed = checkpoint.seed;
+    if (checkpoint.seedSet) {
+        SetRandomSeed(checkpoint.seed);
+    }
+    timers.Reset(checkpoint.tick);
+    firedTimers.clear();
+    const uint64_t baseTick = checkpoint.tick;
+    const uint32_t sequenceGap = checkpoint.handoff ? 0 : RESTORE_SEQUENCE_GAP;
+    const uint32_t idGap = checkpoint.handoff ? 0 : RESTORE_ID_GAP;
+
+    nextPlayerId = std::max(nextPlayerId, checkpoint.nextPlayerId);
+    nextEnemyId = checkpoint.nextEnemyId + idGap;
+    nextBulletId = checkpoint.nextBulletId + idGap;
+    outgoingSequenceNumber = checkpoint.outgoingSequence + sequenceGap;
+    playerTableVersion = checkpoint.playerTableVersion + sequenceGap;
+
+    enemySpawnDue = checkpoint.enemySpawnTicks == 0;
+    enemySpawnTimer = enemySpawnDue ? TimerWheel::INVALID_TIMER :
+        timers.Schedule(baseTick + checkpoint.enemySpawnTicks, static_cast<uint8_t>(ServerTimer::ENEMY_SPAWN), 0);
+
+    for (const MatchCheckpoint::Player& saved : checkpoint.players) {
+        if (clients.count(saved.playerId) != 0 || suspendedClients.count(saved.playerId) != 0) {
+            continue;
+        }
+        ClientInfo client(sf::IpAddress(saved.address), saved.port);
+        client.isActive = false;
+        client.restored = !checkpoint.handoff;
+        client.connectionToken = saved.connectionToken;
+        client.playerName = saved.name;
+        client.score = saved.state.score;
+        client.isDead = saved.state.isDead;
+        client.budget.SetLimit(static_cast<float>(clientBandwidth));
+        AcquirePlayerSlot(client, saved.playerId, saved.state.color);
+        PlayerData& player = SimOf(client).player;
+        player = saved.state;
+        player.playerId = saved.playerId;
+        if (client.isDead && saved.respawnTicks > 0) {
+            client.respawnTimer = timers.Schedule(baseTick + saved.respawnTicks,
+                static_cast<uint8_t>(ServerTimer::RESPAWN), saved.playerId);
+        }
+        if (checkpoint.handoff) {
+            const MatchCheckpoint::Session& session = saved.session;
+            client.nextSnapshotSequence = session.nextSnapshotSequence;
+            client.lastReceivedInputSeq = session.lastReceivedInputSeq;
+            client.lastAcknowledgedInputSeq = session.lastAcknowledgedInputSeq;
+            client.ackedPlayerTableVersion = session.ackedPlayerTableVersion;
+            client.sentPlayerTableVersion = session.ackedPlayerTableVersion;
+            client.reliable.Reset(session.reliableFirstSequence);
+            for (const MatchCheckpoint::Session::ReliableMessage& message : session.reliable) {
+                client.reliable.Restore(message.acked, message.bytes);
             }
         }
+        if (checkpoint.handoff && saved.session.active) {
+            client.isActive = true;
+            client.lastHeardTick = tickNumber;
+            clientsByEndpoint[EndpointKey(client.address, client.port)] = saved.playerId;
+            ClientInfo& connected = clients.emplace(saved.playerId, std::move(client)).first->second;
+            ScheduleClientTimeout(saved.playerId, connected);
+        }
+        else {
+            SuspendSession(saved.playerId, client);
+        }
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception in SendInputAcknowledgment: " + std::string(e.what()), error);
+
+    for (const MatchCheckpoint::Enemy& saved : checkpoint.enemies) {
+        if (saved.type >= EnemyTank::ENEMY_TYPE_COUNT) {
+            continue;
+        }
+        auto enemy = std::make_unique<EnemyTank>(static_cast<EnemyTank::EnemyType>(saved.type),
+            sf::Vector2f(saved.x, saved.y), RandomFor(RandomPurpose::ENEMY_AI, saved.enemyId));
+        enemy->SetMaxHealth(saved.maxHealth);
+        enemy->SetHealth(saved.health);
+        enemy->SetBodyRotation(sf::degrees(saved.bodyRotation));
+        enemy->SetBarrelRotation(sf::degrees(saved.barrelRotation));
+        CreateEnemy(saved.enemyId, std::move(enemy));
     }
-}
 
-uint64_t GameServer::GetCurrentTimestamp() const {
-    auto now = std::chrono::steady_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
-    return static_cast<uint64_t>(ms.count());
+    for (const MatchCheckpoint::Bullet& saved : checkpoint.bullets) {
+        SpawnProjectile(saved.bulletId, saved.type, sf::Vector2f(saved.x, saved.y),
+            sf::Vector2f(saved.directionX, saved.directionY), saved.ownerId, saved.layer, saved.flownSeconds);
+    }
+
+    const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    LOG_MSG(success, "Restored the match from " + source +
+        " at tick " + std::to_string(checkpoint.tick) +
+        " (" + std::to_string(nowMs - static_cast<int64_t>(checkpoint.savedAtMs)) + " ms old): " +
+        std::to_string(clients.size()) + " players connected, " +
+        std::to_string(suspendedClients.size()) + " waiting to resume, " +
+        std::to_string(checkpoint.enemies.size()) + " enemies, " + std::to_string(checkpoint.bullets.size()) + " bullets");
 }
+
 void GameServer::DiagnoseEnemyShooting(uint32_t enemyId, EnemyTank* enemy) {
     if (!enemy) return;
 
@@ -945,7 +4385,7 @@ void GameServer::DiagnoseEnemyShooting(uint32_t enemyId, EnemyTank* enemy) {
     if (enemy->HasTarget()) {
         auto it = clients.find(enemy->GetTargetPlayerId());
         if (it != clients.end()) {
-            sf::Vector2f targetPos(it->second.playerData.x, it->second.playerData.y);
+            sf::Vector2f targetPos(SimOf(it->second).player.x, SimOf(it->second).player.y);
             float dx = targetPos.x - enemy->GetPosition().x;
             float dy = targetPos.y - enemy->GetPosition().y;
             distance = std::sqrt(dx * dx + dy * dy);
@@ -970,7 +4410,11 @@ void GameServer::DiagnoseEnemyShooting(uint32_t enemyId, EnemyTank* enemy) {
 }
 void GameServer::UpdateEnemies(float deltaTime) {
     try {
-        enemySpawnTimer += deltaTime;
+        for (const TimerWheel::Fired& timer : firedTimers) {
+            if (timer.kind == static_cast<uint8_t>(ServerTimer::ENEMY_SPAWN) && timer.id == enemySpawnTimer) {
+                enemySpawnDue = true;
+            }
+        }
 
         // Calculate dynamic max enemies based on player count
         // Formula: 3 * (PlayerCount > 0) + PlayerCount
@@ -980,239 +4424,557 @@ void GameServer::UpdateEnemies(float deltaTime) {
                 activePlayerCount++;
             }
         }
-        int dynamicMaxEnemies = 3 * (activePlayerCount > 0 ? 1 : 0) + activePlayerCount;
+        // (fewer under overload, see OverloadController)
+        int dynamicMaxEnemies = overload.GetEnemyCap(3 * (activePlayerCount > 0 ? 1 : 0) + activePlayerCount);
 
-        // Spawn enemy if timer ready and below max
-        if (enemySpawnTimer >= enemySpawnInterval &&
-            enemies.size() < static_cast<size_t>(dynamicMaxEnemies)) {
+        if (hordeSize > 0) {
+            // Horde scenario: the count is held, so kills are replaced at once
+            for (uint32_t spawned = 0; spawned < HORDE_SPAWNS_PER_TICK && GetEnemyCount() < hordeSize; ++spawned) {
+                SpawnEnemy();
+            }
+        }
+        // Spawn enemy if the interval has elapsed and below max; the next
+        // interval starts from the spawn
+        else if (enemySpawnsEnabled && enemySpawnDue &&
+            GetEnemyCount() < static_cast<size_t>(dynamicMaxEnemies)) {
 
             SpawnEnemy();
-            enemySpawnTimer = 0;
+            enemySpawnDue = false;
+            enemySpawnTimer = timers.Schedule(tickNumber + SecondsToTicks(enemySpawnInterval),
+                static_cast<uint8_t>(ServerTimer::ENEMY_SPAWN), 0);
 
             // Log dynamic max for debugging
-            static int spawnLogCounter = 0;
+            static thread_local int spawnLogCounter = 0;
             if (++spawnLogCounter % 5 == 0) {
-                Utils::printMsg("🎮 Enemy spawned | Active Players: " +
+                LOG_MSG(info, "🎮 Enemy spawned | Active Players: " +
                     std::to_string(activePlayerCount) +
                     " | Max Enemies: " + std::to_string(dynamicMaxEnemies) +
-                    " | Current: " + std::to_string(enemies.size()), info);
+                    " | Current: " + std::to_string(GetEnemyCount()));
             }
         }
 
-        //Track which enemies shot THIS frame to prevent multi-spawn
-        std::unordered_set<uint32_t> enemiesWhoShotThisFrame;
-
-        for (auto& [enemyId, enemy] : enemies) {
-            if (!enemy) continue;
-
-            // TARGET ACQUISITION
-            if (!enemy->HasTarget()) {
-                uint32_t targetId = SelectTargetForEnemy(enemy.get());
-                if (targetId != 0) {
-                    auto it = clients.find(targetId);
-                    if (it != clients.end() && it->second.isActive) {
-                        sf::Vector2f targetPos(it->second.playerData.x, it->second.playerData.y);
-                        enemy->SelectNewTarget(targetId, targetPos);
+        // Decide every enemy's AI against this tick's player snapshot. Each job
+        // writes only its own enemy and result, so the order jobs run in cannot
+        // change the outcome.
+        TakeEnemyAIPlayerSnapshot(deltaTime);
+        // Enemies in chunks no player is near sleep through the tick
+        RefreshChunkActivity();
+        aiResults.clear();
+        sleepingEnemies = 0;
+        auto brains = enemyRegistry.view<const ServerComponents::NetworkId, const ServerComponents::EnemyBrain,
+            const ServerComponents::Transform>();
+        for (auto [entity, networkId, brain, transform] : brains.each()) {
+            if (!chunkActivity.IsActive(transform.position)) {
+                sleepingEnemies++;
+                continue;
+            }
+            aiResults.push_back({ networkId.id, brain.tank.get(), deltaTime, false, false, false, false, false });
+        }
+        std::sort(aiResults.begin(), aiResults.end(),
+            [](const EnemyAIResult& a, const EnemyAIResult& b) { return a.enemyId < b.enemyId; });
+        UpdateEnemySquads();
+
+        // With a budget, aiResults is reordered into service order and whatever
+        // the budget does not reach is deferred. Under overload, relaxed enemies
+        // only think on every aiStride-th tick (staggered by ID) and catch up then.
+        const bool budgeted = enemyAIBudgetUs > 0;
+        const uint32_t aiStride = overload.GetLevelSettings().aiStride;
+        const bool scheduled = budgeted || aiStride > 1;
+        if (scheduled) {
+            ScheduleEnemyAI();
+        }
+        // The budget serves enemies in schedule order; otherwise they run in
+        // batches of one AI state
+        if (budgeted) {
+            aiRunOrder.resize(aiResults.size());
+            std::iota(aiRunOrder.begin(), aiRunOrder.end(), 0u);
+        }
+        else {
+            GroupEnemyAIByState();
+        }
+        const auto aiStart = std::chrono::steady_clock::now();
+        const auto aiDeadline = aiStart + std::chrono::microseconds(enemyAIBudgetUs);
+        auto runEnemyAI = [this, budgeted, aiStride, aiDeadline](size_t index) {
+            EnemyAIResult& result = aiResults[index];
+            if (aiStride > 1 && !result.urgent && (result.enemyId + tickNumber) % aiStride != 0) {
+                result.deferred = true;
+                return;
+            }
+            if (budgeted && index > 0 && !result.mustRun && std::chrono::steady_clock::now() >= aiDeadline) {
+                result.deferred = true;
+                return;
+            }
+            UpdateEnemyAI(result, result.elapsed);
+        };
+
+        if (enemyJobs) {
+            const size_t ENEMIES_PER_JOB = 4;
+            enemyJobs->ParallelFor(aiRunOrder.size(), ENEMIES_PER_JOB, [this, &runEnemyAI](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    runEnemyAI(aiRunOrder[i]);
+                }
+                });
+        }
+        else {
+            for (uint32_t index : aiRunOrder) {
+                runEnemyAI(index);
+            }
+        }
 
-                        float distance = std::sqrt(
-                            std::pow(targetPos.x - enemy->GetPosition().x, 2) +
-                            std::pow(targetPos.y - enemy->GetPosition().y, 2)
-                        );
+        if (scheduled) {
+            RecordEnemyAIBudget(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - aiStart).count());
+            std::sort(aiResults.begin(), aiResults.end(),
+                [](const EnemyAIResult& a, const EnemyAIResult& b) { return a.enemyId < b.enemyId; });
+        }
 
-                      //  Utils::printMsg(enemy->GetEnemyTypeName() + " (ID: " +
-                        //    std::to_string(enemyId) + ") NOW TARGETING player " +
-                         //   std::to_string(targetId) + " at distance " +
-                          //  std::to_string(distance), success);
-                    }
-                }
+        // Side effects touch shared state (projectile pool, client queues), so apply them here
+        reducedLodEnemies = 0;
+        for (const EnemyAIResult& result : aiResults) {
+            if (result.shot) {
+                SpawnEnemyBullet(result.enemyId, result.enemy);
             }
-            else {
-                UpdateEnemyTargetPosition(enemy.get());
+            if (result.reducedLod) {
+                reducedLodEnemies++;
             }
+        }
+
+        SyncEnemyComponents();
+        RemoveDeadEnemies();
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in UpdateEnemies: " + std::string(e.what()), error);
+    }
+}
+
+void GameServer::RefreshChunkActivity() {
+    chunkActivity.Clear();
+    for (const auto& [playerId, client] : clients) {
+        if (client.isActive) {
+            chunkActivity.ActivateAround(sf::Vector2f(SimOf(client).player.x, SimOf(client).player.y));
+        }
+    }
+}
 
-            //  Store cooldown BEFORE update
-            float cooldownBefore = enemy->GetShootCooldown();
+/**
+ * Orders aiResults for the budget: urgent enemies (fighting, fleeing, or
+ * deferred too long) first, then the rest round-robin starting after the last
+ * one served. Adds the time each enemy still owes from deferred ticks.
+ */
+void GameServer::ScheduleEnemyAI() {
+    for (EnemyAIResult& result : aiResults) {
+        auto owed = enemyAIDeferredTime.find(result.enemyId);
+        if (owed != enemyAIDeferredTime.end()) {
+            result.elapsed += owed->second;
+        }
+        const EnemyTank::AIState state = result.enemy->GetAIState();
+        result.mustRun = result.elapsed >= MAX_AI_DEFER_SECONDS;
+        result.urgent = result.mustRun || state == EnemyTank::AIState::ATTACK ||
+            state == EnemyTank::AIState::CHASE || state == EnemyTank::AIState::RETREAT;
+    }
 
-            // AI BEHAVIOR UPDATE
-            enemy->Update(deltaTime);
+    auto relaxed = std::stable_partition(aiResults.begin(), aiResults.end(),
+        [](const EnemyAIResult& result) { return result.urgent; });
+    // Still in ID order here: rotate so the first enemy after the cursor leads
+    auto next = std::upper_bound(relaxed, aiResults.end(), aiRoundRobinCursor,
+        [](uint32_t cursor, const EnemyAIResult& result) { return cursor < result.enemyId; });
+    std::rotate(relaxed, next, aiResults.end());
+}
 
-            //  Store cooldown AFTER update
-            float cooldownAfter = enemy->GetShootCooldown();
+/**
+ * Orders the AI step by state (a counting sort into aiRunOrder): all enemies
+ * in one AIState run before the next state's, in aiResults order within a state, so
+ * consecutive enemies take the same branches through EnemyTank::Update and
+ * the same state handler stays hot. Enemies only write their own state, so
+ * the order cannot change the outcome; a transition moves the enemy to its
+ * new batch from the next tick.
+ */
+void GameServer::GroupEnemyAIByState() {
+    std::array<uint32_t, EnemyTank::AI_STATE_COUNT + 1> offsets{};
+    for (const EnemyAIResult& result : aiResults) {
+        offsets[static_cast<size_t>(result.enemy->GetAIState()) + 1]++;
+    }
+    for (size_t state = 1; state < offsets.size(); ++state) {
+        offsets[state] += offsets[state - 1];
+    }
+    aiRunOrder.resize(aiResults.size());
+    for (uint32_t index = 0; index < aiResults.size(); ++index) {
+        aiRunOrder[offsets[static_cast<size_t>(aiResults[index].enemy->GetAIState())]++] = index;
+    }
+}
 
-            //  DEBUG: Log attack state enemies
-            if (enemy->GetAIState() == EnemyTank::AIState::ATTACK) {
-                static std::unordered_map<uint32_t, float> attackLogTimers;
-                attackLogTimers[enemyId] += deltaTime;
+/**
+ * Every EnemySquads::REGROUP_SECONDS: regroups the enemies and makes each
+ * squad's decisions once, through its leader. The target is the leader's, or
+ * one search from the leader's position; members without a target take it.
+ * Members patrol to formation slots around the leader's waypoint and, when
+ * cornered while retreating, head for a rally point chosen once away from the
+ * target. Runs before the AI jobs, which only read the orders on their own enemy.
+ */
+void GameServer::UpdateEnemySquads() {
+    if (!enemySquadsEnabled) {
+        if (!enemySquads.GetSquads().empty()) {
+            // Switched off: everyone decides alone again
+            for (const EnemyAIResult& result : aiResults) {
+                result.enemy->ClearSquadOrders();
+            }
+            enemySquads.Clear();
+        }
+        return;
+    }
+    if (tickNumber % std::max<uint64_t>(SecondsToTicks(EnemySquads::REGROUP_SECONDS), 1) != 0) {
+        return;
+    }
 
-                if (attackLogTimers[enemyId] >= 2.0f) {
-                   // Utils::printMsg(" ATTACKING: " + enemy->GetEnemyTypeName() +
-                    //    " (ID: " + std::to_string(enemyId) + ") | " +
-                     //   "Cooldown: " + std::to_string(cooldownAfter) + "s | " +
-                      //  "Target: " + std::to_string(enemy->GetTargetPlayerId()), warning);
-                    attackLogTimers[enemyId] = 0.0f;
-                }
+    squadEnemies.clear();
+    for (const EnemyAIResult& result : aiResults) {
+        squadEnemies.push_back({ result.enemyId, result.enemy->GetPosition() });
+    }
+    enemySquads.Form(squadEnemies);
+
+    // aiResults is sorted by ID here
+    auto findEnemy = [this](uint32_t enemyId) -> EnemyTank& {
+        auto it = std::lower_bound(aiResults.begin(), aiResults.end(), enemyId,
+            [](const EnemyAIResult& result, uint32_t id) { return result.enemyId < id; });
+        return *it->enemy;
+    };
+    const std::vector<uint32_t>& members = enemySquads.GetMembers();
+    for (const EnemySquads::Squad& squad : enemySquads.GetSquads()) {
+        EnemyTank& leader = findEnemy(members[squad.first]);
+        leader.ClearSquadOrders();
+        if (squad.count == 1) {
+            continue;
+        }
+
+        const EnemyAIPlayer* target = FindAIPlayer(leader.HasTarget() ?
+            leader.GetTargetPlayerId() : SelectTargetForEnemy(leader));
+        const sf::Vector2f targetPos = target ? sf::Vector2f(target->x, target->y) : leader.GetPosition();
+        const sf::Vector2f rallyPoint = target ? leader.CalculateSafeRetreatPosition(targetPos) : leader.GetPosition();
+        const sf::Vector2f waypoint = leader.GetPatrolWaypoint();
+        for (size_t slot = 1; slot < squad.count; ++slot) {
+            EnemyTank& member = findEnemy(members[squad.first + slot]);
+            member.SetSquadOrders(waypoint + EnemySquads::GetFormationOffset(slot), target != nullptr, rallyPoint);
+            if (target && !member.HasTarget()) {
+                member.SelectNewTarget(target->playerId, targetPos);
             }
+        }
+    }
+}
 
-            //  SHOOTING DETECTION - Check if cooldown INCREASED
-            bool enemyJustShot = false;
+/**
+ * Settles the budget bookkeeping after the AI step: deferred enemies carry
+ * their time forward, the round-robin cursor moves past the last enemy served.
+ * @param usedUs Wall time the AI step took
+ */
+void GameServer::RecordEnemyAIBudget(double usedUs) {
+    uint32_t deferred = 0;
+    for (const EnemyAIResult& result : aiResults) {
+        if (result.deferred) {
+            enemyAIDeferredTime[result.enemyId] = result.elapsed;
+            deferred++;
+            continue;
+        }
+        enemyAIDeferredTime.erase(result.enemyId);
+        if (!result.urgent) {
+            aiRoundRobinCursor = result.enemyId;
+        }
+    }
 
-            if (cooldownAfter > cooldownBefore) {
-                // Cooldown increased - enemy just shot!
-                float cooldownJump = cooldownAfter - cooldownBefore;
+    aiBudgetStats.ticks++;
+    aiBudgetStats.deferredSteps += deferred;
+    aiBudgetStats.maxDeferred = std::max(aiBudgetStats.maxDeferred, deferred);
+    aiBudgetStats.totalUsedUs += usedUs;
+    aiBudgetStats.maxUsedUs = std::max(aiBudgetStats.maxUsedUs, usedUs);
+}
 
-                // Verify it's a real shot (not just floating point error)
-                if (cooldownJump > 0.5f) {
-                    enemyJustShot = true;
+void GameServer::SetParallelEnemyAI(bool enabled, unsigned int workerCount) {
+    if (!enabled) {
+        enemyJobs.reset();
+        return;
+    }
+    try {
+        enemyJobs = std::make_unique<JobSystem>(workerCount);
+        LOG_MSG(success, "Enemy AI runs on " + std::to_string(enemyJobs->GetThreadCount()) + " threads");
+        LOG_MSG(info, "Simulation phase waves: " + simulationGraph.Describe());
+    }
+    catch (const std::exception& e) {
+        LOG_MSG(warning, "Failed to start enemy AI job system, running serially: " + std::string(e.what()));
+        enemyJobs.reset();
+    }
+}
 
-                    //  DEBUG: Confirm shot detection
-                   /* Utils::printMsg(" SHOT DETECTED: " + enemy->GetEnemyTypeName() +
-                        " (ID: " + std::to_string(enemyId) + ") | " +
-                        "Cooldown jump: " + std::to_string(cooldownBefore) + " → " +
-                        std::to_string(cooldownAfter), success);*/
-                }
-            }
+/**
+ * Copies the active players the AI may target into one contiguous perception
+ * snapshot shared by every enemy this tick: positions, velocities and health,
+ * a flat ID index and the target grid. Sorted by ID so target ties resolve
+ * the same way every run.
+ */
+void GameServer::TakeEnemyAIPlayerSnapshot(float deltaTime) {
+    for (const EnemyAIPlayer& player : aiPlayers) {
+        aiPlayerIndex[player.playerId] = INVALID_AI_PLAYER;
+    }
+    aiPlayers.swap(previousAIPlayers);
+    aiPlayers.clear();
+    for (const auto& [playerId, client] : clients) {
+        if (!client.isActive) continue;
+        aiPlayers.push_back({ playerId, SimOf(client).player.x, SimOf(client).player.y, 0.0f, 0.0f,
+            SimOf(client).player.health, SimOf(client).player.maxHealth });
+    }
+    std::sort(aiPlayers.begin(), aiPlayers.end(),
+        [](const EnemyAIPlayer& a, const EnemyAIPlayer& b) { return a.playerId < b.playerId; });
+
+    // Both lists are sorted by ID: velocities come from one merge pass
+    auto previous = previousAIPlayers.begin();
+    for (uint32_t i = 0; i < aiPlayers.size(); ++i) {
+        EnemyAIPlayer& player = aiPlayers[i];
+        while (previous != previousAIPlayers.end() && previous->playerId < player.playerId) {
+            ++previous;
+        }
+        if (previous != previousAIPlayers.end() && previous->playerId == player.playerId && deltaTime > 0.0f) {
+            player.velocityX = (player.x - previous->x) / deltaTime;
+            player.velocityY = (player.y - previous->y) / deltaTime;
+        }
+        if (player.playerId >= aiPlayerIndex.size()) {
+            aiPlayerIndex.resize(player.playerId + 1, INVALID_AI_PLAYER);
+        }
+        aiPlayerIndex[player.playerId] = i;
+    }
 
-            // Spawn server bullet if enemy shot AND we haven't already spawned for this enemy
-            if (enemyJustShot && enemiesWhoShotThisFrame.find(enemyId) == enemiesWhoShotThisFrame.end()) {
-                SpawnEnemyBullet(enemyId, enemy.get());
-                enemiesWhoShotThisFrame.insert(enemyId);
+    aiPlayerGrid.Clear();
+    for (size_t i = 0; i < aiPlayers.size(); ++i) {
+        aiPlayerGrid.Insert(static_cast<uint32_t>(i), sf::Vector2f(aiPlayers[i].x, aiPlayers[i].y), 0.0f);
+    }
 
-              //  Utils::printMsg(" Server confirmed bullet spawn for enemy " +
-                   // std::to_string(enemyId), success);
-            }
+    RefreshPlayerFlowFields();
+}
+
+/**
+ * Keeps one flow field per snapshot player. A field is only rebuilt when its
+ * player has moved into a different navigation cell, so a stationary or
+ * slow player costs nothing per tick. Fields of departed players are dropped.
+ */
+void GameServer::RefreshPlayerFlowFields() {
+    for (auto it = playerFlowFields.begin(); it != playerFlowFields.end();) {
+        if (!FindAIPlayer(it->first)) {
+            it = playerFlowFields.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for (const EnemyAIPlayer& player : aiPlayers) {
+        const sf::Vector2f position(player.x, player.y);
+        FlowField& field = playerFlowFields[player.playerId];
+        if (!field.IsBuilt() || field.GetTargetCell() != navigationGrid.CellIndex(position)) {
+            field.Build(navigationGrid, position);
+            flowFieldRebuilds++;
         }
+    }
+}
 
-        RemoveDeadEnemies();
+const EnemyAIPlayer* GameServer::FindAIPlayer(uint32_t playerId) const {
+    if (playerId >= aiPlayerIndex.size() || aiPlayerIndex[playerId] == INVALID_AI_PLAYER) {
+        return nullptr;
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception in UpdateEnemies: " + std::string(e.what()), error);
+    return &aiPlayers[aiPlayerIndex[playerId]];
+}
+
+/**
+ * One enemy's AI step: target acquisition against the player snapshot, then
+ * EnemyTank::Update. Reads only the snapshot and writes only this enemy and
+ * its result, so it is safe to run for different enemies in parallel.
+ */
+void GameServer::UpdateEnemyAI(EnemyAIResult& result, float deltaTime) const {
+    EnemyTank& enemy = *result.enemy;
+
+    // TARGET ACQUISITION - squad members get theirs from the squad (see UpdateEnemySquads)
+    if (!enemy.HasTarget() && !enemy.IsInSquad()) {
+        uint32_t targetId = SelectTargetForEnemy(enemy);
+        if (const EnemyAIPlayer* target = FindAIPlayer(targetId)) {
+            enemy.SelectNewTarget(targetId, sf::Vector2f(target->x, target->y));
+        }
+    }
+    else {
+        UpdateEnemyTargetPosition(enemy);
+    }
+
+    // LEVEL OF DETAIL - full rate while anything is close enough to matter
+    bool reduced = false;
+    if (enemyAILodEnabled && !enemy.HasTarget()) {
+        reduced = !IsAnyPlayerWithin(enemy.GetPosition(), enemy.GetDetectionRange() * ENEMY_LOD_RANGE_FACTOR);
     }
+    enemy.SetAILodTier(reduced ? EnemyTank::AILodTier::REDUCED : EnemyTank::AILodTier::FULL);
+    result.reducedLod = reduced;
+
+    // Fields are only read here; RefreshPlayerFlowFields ran before the jobs
+    const FlowField* chaseField = nullptr;
+    if (enemy.HasTarget()) {
+        auto field = playerFlowFields.find(enemy.GetTargetPlayerId());
+        if (field != playerFlowFields.end()) {
+            chaseField = &field->second;
+        }
+    }
+    enemy.SetChaseFlowField(chaseField);
+    enemy.SetObstacles(&obstacles);
+
+    //  Store cooldown BEFORE update
+    float cooldownBefore = enemy.GetShootCooldown();
+
+    // AI BEHAVIOR UPDATE
+    enemy.SetRandomTick(tickNumber);
+    enemy.Update(deltaTime);
+
+    //  SHOOTING DETECTION - the cooldown jumps when the enemy fires
+    // (a real shot, not floating point noise, if it grew by more than 0.5 s)
+    float cooldownAfter = enemy.GetShootCooldown();
+    result.shot = cooldownAfter - cooldownBefore > 0.5f;
 }
+
 // SelectTargetForEnemy - Add scoring logic for best target
 
-uint32_t GameServer::SelectTargetForEnemy(EnemyTank* enemy) {
-    if (!enemy) return 0;
+/**
+ * Scores the players inside the enemy's detection range, found through the
+ * snapshot grid so only nearby players are visited. Range checks use squared
+ * distances; the square root is only taken for players in range.
+ * Safe to call from AI jobs: the query buffer is per thread.
+ */
+uint32_t GameServer::SelectTargetForEnemy(const EnemyTank& enemy) const {
+    static thread_local std::vector<const SpatialGrid::Entry*> candidates;
 
     uint32_t bestTarget = 0;
     float bestScore = -1.0f;
 
-    sf::Vector2f enemyPos = enemy->GetPosition();
-    float detectionRange = enemy->GetDetectionRange();
+    sf::Vector2f enemyPos = enemy.GetPosition();
+    float detectionRange = enemy.GetDetectionRange();
+    const float detectionRangeSq = detectionRange * detectionRange;
 
-    for (const auto& [playerId, client] : clients) {
-        if (!client.isActive) continue;
+    aiPlayerGrid.Query(enemyPos, detectionRange, candidates);
+    for (const SpatialGrid::Entry* candidate : candidates) {
+        const EnemyAIPlayer& player = aiPlayers[candidate->id];
 
-        sf::Vector2f playerPos(client.playerData.x, client.playerData.y);
-
-        // Calculate distance
-        float dx = playerPos.x - enemyPos.x;
-        float dy = playerPos.y - enemyPos.y;
-        float distance = std::sqrt(dx * dx + dy * dy);
+        float dx = player.x - enemyPos.x;
+        float dy = player.y - enemyPos.y;
+        float distanceSq = dx * dx + dy * dy;
 
         // Skip if out of detection range
-        if (distance > detectionRange) continue;
+        if (distanceSq > detectionRangeSq) continue;
 
         // Calculate threat score (closer = higher priority)
-        float proximityScore = 1.0f - (distance / detectionRange);
+        float proximityScore = 1.0f - (std::sqrt(distanceSq) / detectionRange);
         float score = proximityScore * 100.0f;
 
         // Optional: Add health-based scoring (target low health players)
-        float healthFactor = 1.0f - (client.playerData.health / client.playerData.maxHealth);
+        float healthFactor = 1.0f - (player.health / player.maxHealth);
         score += healthFactor * 20.0f;
 
-        // Check if this is the best target so far
-        if (score > bestScore) {
+        // Check if this is the best target so far (ties go to the lower ID,
+        // independent of grid visiting order)
+        if (score > bestScore || (score == bestScore && player.playerId < bestTarget)) {
             bestScore = score;
-            bestTarget = playerId;
+            bestTarget = player.playerId;
         }
     }
 
-    // Log targeting decision
-    if (bestTarget != 0) {
-      //  Utils::printMsg(enemy->GetEnemyTypeName() + " selected target " +
-       //     std::to_string(bestTarget) + " (score: " +
-       //     std::to_string(bestScore) + ")", debug);
-    }
-
     return bestTarget;
 }
 
-void GameServer::UpdateEnemyTargetPosition(EnemyTank* enemy) {
-    if (!enemy || !enemy->HasTarget()) return;
+bool GameServer::IsAnyPlayerWithin(sf::Vector2f position, float range) const {
+    static thread_local std::vector<const SpatialGrid::Entry*> candidates;
+
+    const float rangeSq = range * range;
+    aiPlayerGrid.Query(position, range, candidates);
+    for (const SpatialGrid::Entry* candidate : candidates) {
+        const float dx = candidate->position.x - position.x;
+        const float dy = candidate->position.y - position.y;
+        if (dx * dx + dy * dy <= rangeSq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GameServer::UpdateEnemyTargetPosition(EnemyTank& enemy) const {
+    if (!enemy.HasTarget()) return;
 
-    uint32_t targetId = enemy->GetTargetPlayerId();
+    uint32_t targetId = enemy.GetTargetPlayerId();
 
-    auto it = clients.find(targetId);
-    if (it == clients.end() || !it->second.isActive) {
+    const EnemyAIPlayer* target = FindAIPlayer(targetId);
+    if (!target) {
         // Target disconnected or became inactive
-        enemy->ClearTarget();
-      //  Utils::printMsg(enemy->GetEnemyTypeName() + " lost target " +
-       //     std::to_string(targetId) + " (disconnected)", debug);
+        enemy.ClearTarget();
         return;
     }
 
     // Update enemy with fresh player position
-    sf::Vector2f playerPos(it->second.playerData.x, it->second.playerData.y);
-
-    // Calculate distance
-    float distance = std::sqrt(
-        std::pow(playerPos.x - enemy->GetPosition().x, 2) +
-        std::pow(playerPos.y - enemy->GetPosition().y, 2)
-    );
+    sf::Vector2f playerPos(target->x, target->y);
 
     // Check if target escaped detection range (with hysteresis)
-    float detectionRange = enemy->GetDetectionRange();
-    if (distance > detectionRange * 2.0f) {
-        enemy->ClearTarget();
-      //  Utils::printMsg(enemy->GetEnemyTypeName() + " lost target " +
-       //     std::to_string(targetId) + " (out of range: " +
-       //     std::to_string(distance) + ")", debug);
+    const float dx = playerPos.x - enemy.GetPosition().x;
+    const float dy = playerPos.y - enemy.GetPosition().y;
+    const float escapeRange = enemy.GetDetectionRange() * 2.0f;
+    if (dx * dx + dy * dy > escapeRange * escapeRange) {
+        enemy.ClearTarget();
         return;
     }
 
     // Update target position for AI to use
-    enemy->SelectNewTarget(targetId, playerPos);
+    enemy.SelectNewTarget(targetId, playerPos);
 }
 
 void GameServer::SpawnEnemy() {
-    try {
-        sf::Vector2f spawnPos = GetRandomSpawnPosition();
-        EnemyTank::EnemyType enemyType = GetRandomEnemyType();
-
-        auto newEnemy = std::make_unique<EnemyTank>(enemyType, spawnPos);
+    // Keyed by the ID the enemy is about to get
+    RandomStream random = RandomFor(RandomPurpose::ENEMY_SPAWN, nextEnemyId);
+    const sf::Vector2f position = GetRandomSpawnPosition(random);
+    SpawnEnemyAt(position, GetRandomEnemyType(random));
+}
 
-        uint32_t enemyId = nextEnemyId++;
+void GameServer::SpawnEnemyAt(sf::Vector2f spawnPos, EnemyTank::EnemyType enemyType) {
+    try {
+        const uint32_t enemyId = nextEnemyId++;
+        auto newEnemy = std::make_unique<EnemyTank>(enemyType, spawnPos, RandomFor(RandomPurpose::ENEMY_AI, enemyId));
+        const EnemyTank& enemy = *newEnemy;
 
-        enemies[enemyId] = std::move(newEnemy);
+        CreateEnemy(enemyId, std::move(newEnemy));
+        JournalEvent(EventJournal::EventType::ENEMY_SPAWNED, enemyId, 0, 0, spawnPos, static_cast<uint8_t>(enemyType));
 
-        Utils::printMsg("Spawned " + enemies[enemyId]->GetEnemyTypeName() +
+        LOG_MSG(success, "Spawned " + enemy.GetEnemyTypeName() +
             " (ID: " + std::to_string(enemyId) + ") at (" +
-            std::to_string(spawnPos.x) + ", " + std::to_string(spawnPos.y) + ")",
-            success);
+            std::to_string(spawnPos.x) + ", " + std::to_string(spawnPos.y) + ")");
     }
     catch (const std::exception& e) {
-        Utils::printMsg("Exception in SpawnEnemy: " + std::string(e.what()), error);
+        Utils::printMsg("Exception in SpawnEnemyAt: " + std::string(e.what()), error);
     }
 }
 
-sf::Vector2f GameServer::GetRandomSpawnPosition() {
-    const float SPAWN_MIN_X = WorldConstants::SPAWN_MIN_X;
-    const float SPAWN_MAX_X = WorldConstants::SPAWN_MAX_X;
-    const float SPAWN_MIN_Y = WorldConstants::SPAWN_MIN_Y;
-    const float SPAWN_MAX_Y = WorldConstants::SPAWN_MAX_Y;
-
-    std::uniform_real_distribution<float> distX(SPAWN_MIN_X, SPAWN_MAX_X);
-    std::uniform_real_distribution<float> distY(SPAWN_MIN_Y, SPAWN_MAX_Y);
-
-    float x = distX(randomGenerator);
-    float y = distY(randomGenerator);
+entt::entity GameServer::CreateEnemy(uint32_t enemyId, std::unique_ptr<EnemyTank> newEnemy) {
+    const EnemyTank& enemy = *newEnemy;
+    const entt::entity entity = enemyRegistry.create();
+    enemyRegistry.emplace<ServerComponents::NetworkId>(entity, enemyId);
+    enemyRegistry.emplace<ServerComponents::Transform>(entity, enemy.GetPosition(),
+        enemy.GetBodyRotation().asDegrees(), enemy.GetBarrelRotation().asDegrees(), enemy.GetRadius());
+    enemyRegistry.emplace<ServerComponents::Health>(entity, enemy.GetHealth(), enemy.GetMaxHealth(), enemy.IsDead());
+    if (enemy.IsDead()) {
+        deadEnemies.push_back(entity);      // A checkpoint can hold a wreck
+    }
+    enemyRegistry.emplace<ServerComponents::EnemyKind>(entity, enemy.GetEnemyType());
+    enemyRegistry.emplace<ServerComponents::EnemyBrain>(entity, std::move(newEnemy));
+    enemySetChanged = true;
+    return entity;
+}
 
-    return sf::Vector2f(x, y);
+/**
+ * Enemies come in away from players and other enemies, from the same safe
+ * cells as respawns (see GetRandomRespawnPosition).
+ */
+sf::Vector2f GameServer::GetRandomSpawnPosition(RandomStream& random) {
+    const sf::Vector2f position = spawnMap.Pick(random, obstacles);
+    spawnMap.AddDanger(position);
+    return position;
 }
 
-EnemyTank::EnemyType GameServer::GetRandomEnemyType() {
-    std::uniform_int_distribution<int> dist(1, 100);
-    int roll = dist(randomGenerator);
+EnemyTank::EnemyType GameServer::GetRandomEnemyType(RandomStream& random) {
+    const uint32_t roll = random.Below(100) + 1;
 
     if (roll <= 40) {
         return EnemyTank::EnemyType::RED;
@@ -1231,20 +4993,65 @@ EnemyTank::EnemyType GameServer::GetRandomEnemyType() {
     }
 }
 
+/**
+ * Destroys the enemies that died since the last call. Deaths are queued where
+ * Health::dead turns true, so this costs one step per death rather than a
+ * walk over every enemy; the registry's storage removes each entity by
+ * moving its last one into the hole.
+ */
 void GameServer::RemoveDeadEnemies() {
-    auto it = enemies.begin();
-    while (it != enemies.end()) {
-        if (it->second && it->second->IsDead()) {
-            Utils::printMsg("Removing dead enemy (ID: " + std::to_string(it->first) + ")",
-                debug);
-            it = enemies.erase(it);
+    if (deadEnemies.empty()) {
+        return;
+    }
+    for (entt::entity entity : deadEnemies) {
+        const uint32_t enemyId = enemyRegistry.get<ServerComponents::NetworkId>(entity).id;
+        LOG_MSG(debug, "Removing dead enemy (ID: " + std::to_string(enemyId) + ")");
+        enemyAIDeferredTime.erase(enemyId);
+    }
+    enemyRegistry.destroy(deadEnemies.begin(), deadEnemies.end());
+    deadEnemies.clear();
+    enemySetChanged = true;
+}
+
+/**
+ * Copies what the AI step changed (movement, aim, healing) from each enemy's
+ * EnemyTank into the POD components the rest of the tick reads, marking the
+ * snapshot fields that actually changed.
+ */
+void GameServer::SyncEnemyComponents() {
+    auto view = enemyRegistry.view<ServerComponents::Transform, ServerComponents::Health,
+        const ServerComponents::EnemyBrain>();
+    for (auto [entity, transform, health, brain] : view.each()) {
+        const EnemyTank& enemy = *brain.tank;
+        const sf::Vector2f position = enemy.GetPosition();
+        const float bodyRotation = enemy.GetBodyRotation().asDegrees();
+        const float barrelRotation = enemy.GetBarrelRotation().asDegrees();
+        uint8_t changed = 0;
+        if (position != transform.position) changed |= SnapshotDelta::ENEMY_POSITION;
+        if (bodyRotation != transform.bodyRotation) changed |= SnapshotDelta::ENEMY_BODY_ROTATION;
+        if (barrelRotation != transform.barrelRotation) changed |= SnapshotDelta::ENEMY_BARREL_ROTATION;
+        if (enemy.GetHealth() != health.current) changed |= SnapshotDelta::ENEMY_HEALTH;
+        if (enemy.GetMaxHealth() != health.max) changed |= SnapshotDelta::ENEMY_MAX_HEALTH;
+
+        transform.position = position;
+        transform.bodyRotation = bodyRotation;
+        transform.barrelRotation = barrelRotation;
+        health.current = enemy.GetHealth();
+        health.max = enemy.GetMaxHealth();
+        if (enemy.IsDead() && !health.dead) {
+            deadEnemies.push_back(entity);
         }
-        else {
-            ++it;
+        health.dead = enemy.IsDead();
+        if (changed != 0) {
+            MarkEnemyDirty(entity, changed);
         }
     }
 }
 
+void GameServer::MarkEnemyDirty(entt::entity entity, uint8_t fields) {
+    enemyRegistry.get_or_emplace<ServerComponents::Dirty>(entity).fields |= fields;
+}
+
 void GameServer::SpawnEnemyBullet(uint32_t enemyId, EnemyTank* enemy) {
     if (!enemy) return;
 
@@ -1260,15 +5067,9 @@ void GameServer::SpawnEnemyBullet(uint32_t enemyId, EnemyTank* enemy) {
             ") direction=(" + std::to_string(finalDirection.x) + ", " +
             std::to_string(finalDirection.y) + ")", success);*/
 
-        auto bullet = std::make_unique<Bullet>(
-            Bullet::BulletType::ENEMY_STANDARD,
-            spawnPos,
-            finalDirection,
-            enemyId  // This is the owner ID
-        );
-
         uint32_t bulletId = nextBulletId++;
-        bullet->SetBulletId(bulletId);
+        SpawnProjectile(bulletId, BulletStats::ENEMY_STANDARD, spawnPos, finalDirection,
+            enemyId, CollisionLayers::ENEMY_BULLET);  // enemyId is the owner ID
 
         // DEBUG: Verify owner ID
      /*   Utils::printMsg("  Bullet ID: " + std::to_string(bulletId) +
@@ -1276,9 +5077,11 @@ void GameServer::SpawnEnemyBullet(uint32_t enemyId, EnemyTank* enemy) {
             " | Is Enemy Bullet: " + std::string(bullet->GetOwnerId() >= 1000 ? "YES" : "NO"),
             info);*/
 
-        bullets[bulletId] = std::move(bullet);
 
-        BroadcastEnemyBulletSpawn(bulletId, spawnPos, finalDirection, enemyId);
+        // In event mode the bullet is announced as it enters each client's view instead
+        if (!eventBulletReplication) {
+            BroadcastEnemyBulletSpawn(bulletId, spawnPos, finalDirection, enemyId);
+        }
 
      /*   Utils::printMsg("  Bullet " + std::to_string(bulletId) + " added to bullets map (total: " +
             std::to_string(bullets.size()) + ")", success);*/
@@ -1291,8 +5094,6 @@ void GameServer::SpawnEnemyBullet(uint32_t enemyId, EnemyTank* enemy) {
 void GameServer::BroadcastEnemyBulletSpawn(uint32_t bulletId, sf::Vector2f position,
     sf::Vector2f direction, uint32_t ownerId) {
     try {
-        sf::Packet packet;
-
         BulletSpawnMessage msg;
         msg.type = NetMessageType::BULLET_SPAWN;
         //  Use correct field names
@@ -1305,19 +5106,12 @@ void GameServer::BroadcastEnemyBulletSpawn(uint32_t bulletId, sf::Vector2f posit
         msg.timestamp = GetCurrentTimestamp();
         msg.sequenceNumber = outgoingSequenceNumber++;
 
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.playerId
-            << msg.spawnX
-            << msg.spawnY
-            << msg.directionX
-            << msg.directionY
-            << msg.barrelRotation
-            << msg.timestamp
-            << msg.sequenceNumber;
+        PacketPool::Lease packet = sendPackets.Borrow();
+        *packet << msg;
 
-        for (const auto& [playerId, client] : clients) {
-            if (client.isActive) {
-                socket.send(packet, client.address, client.port);
+        for (auto& [playerId, client] : clients) {
+            if (client.isActive && IsInClientInterest(client, position)) {
+                QueueForClient(client, *packet);
             }
         }
     }
@@ -1331,20 +5125,16 @@ void GameServer::HandleBulletSpawn(const BulletSpawnMessage& msg,
     try {
         auto clientIt = clients.find(msg.playerId);
         if (clientIt == clients.end()) {
-            Utils::printMsg("Bullet spawn from unknown player: " + std::to_string(msg.playerId), warning);
+            LOG_MSG(warning, "Bullet spawn from unknown player: " + std::to_string(msg.playerId));
             return;
         }
 
         if (clientIt->second.address != clientIP || clientIt->second.port != clientPort) {
-            Utils::printMsg("Bullet spawn from incorrect address", warning);
-            return;
-        }
-
-        if (!ValidateBulletSpawnRequest(msg, msg.playerId)) {
-            Utils::printMsg("Invalid bullet spawn request from player " + std::to_string(msg.playerId), warning);
+            LOG_MSG(warning, "Bullet spawn from incorrect address");
             return;
         }
 
+        // Spawn position, direction and timestamp were checked at ingress (IngressValidator)
         sf::Vector2f spawnPos(msg.spawnX, msg.spawnY);
         sf::Vector2f direction(msg.directionX, msg.directionY);
 
@@ -1353,20 +5143,13 @@ void GameServer::HandleBulletSpawn(const BulletSpawnMessage& msg,
             direction /= dirLength;
         }
 
-        auto bullet = std::make_unique<Bullet>(
-            Bullet::BulletType::PLAYER_STANDARD,
-            spawnPos,
-            direction,
-            msg.playerId
-        );
-
         uint32_t bulletId = nextBulletId++;
-        bullet->SetBulletId(bulletId);
+        const uint32_t slot = SpawnProjectile(bulletId, BulletStats::PLAYER_STANDARD, spawnPos, direction, msg.playerId,
+            CollisionLayers::PLAYER_BULLET);
+        projectiles.SetSpawnToken(slot, msg.spawnToken);   // Echoed to the shooter in its bullet updates
 
-        bullets[bulletId] = std::move(bullet);
-
-        Utils::printMsg("Player " + std::to_string(msg.playerId) +
-            " spawned bullet " + std::to_string(bulletId), success);
+        LOG_MSG(success, "Player " + std::to_string(msg.playerId) +
+            " spawned bullet " + std::to_string(bulletId));
 
         SendBulletUpdates();
     }
@@ -1375,67 +5158,145 @@ void GameServer::HandleBulletSpawn(const BulletSpawnMessage& msg,
     }
 }
 
-void GameServer::UpdateBullets(float deltaTime) {
-    try {
-        for (auto& [bulletId, bullet] : bullets) {
-            if (bullet) {
-                bullet->Update(deltaTime);
-            }
+/**
+ * Adds a projectile to the pool and schedules its expiry (lifetime or border
+ * exit, see ProjectilePool) for the tick whose update reaches it.
+ * @return Slot index of the new projectile
+ */
+uint32_t GameServer::SpawnProjectile(uint32_t bulletId, uint8_t bulletType, sf::Vector2f position,
+    sf::Vector2f direction, uint32_t ownerId, CollisionLayers::Mask layer, float flownSeconds) {
+    const uint32_t slot = projectiles.Spawn(bulletId, bulletType, position, direction, ownerId, layer, flownSeconds);
+    if (!projectiles.IsDestroyed(slot)) {
+        ScheduleAfter(static_cast<float>(projectiles.GetTimeToExpiry(slot)), ServerTimer::BULLET_EXPIRY,
+            slot, bulletId);
+    }
+    return slot;
+}
+
+// Timers of projectiles that hit something first are stale; Expire ignores them
+void GameServer::ExpireProjectiles() {
+    for (const TimerWheel::Fired& timer : firedTimers) {
+        if (timer.kind == static_cast<uint8_t>(ServerTimer::BULLET_EXPIRY)) {
+            projectiles.Expire(timer.target, timer.data);
         }
+    }
+}
 
-        CheckBulletCollisions();
-        RemoveDeadBullets();
+/**
+ * Moves the projectiles and ends the ones whose time ran out. Hits are tested
+ * in a phase of their own, once the target grids are built (see BuildSimulationGraph).
+ */
+void GameServer::UpdateBullets(float deltaTime) {
+    try {
+        projectiles.Update(deltaTime);
+        ExpireProjectiles();
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in UpdateBullets: " + std::string(e.what()), error);
     }
 }
 
+/**
+ * Sends each client the bullets inside its area of interest. In event mode only
+ * bullets that just entered a client's view are sent (as BULLET_SPAWNED), plus
+ * the full list once per BULLET_CORRECTION_INTERVAL; clients simulate the rest.
+ */
 void GameServer::SendBulletUpdates() {
-    if (bullets.empty() || clients.empty()) {
+    if (projectiles.IsEmpty() || clients.empty()) {
         return;
     }
 
     try {
-        sf::Packet packet;
-        BulletUpdateMessage updateMsg;
+        BulletUpdateMessage& updateMsg = bulletUpdate;
         updateMsg.type = NetMessageType::BULLET_UPDATE;
         updateMsg.timestamp = GetCurrentTimestamp();
         updateMsg.sequenceNumber = outgoingSequenceNumber++;
 
-        for (const auto& [bulletId, bullet] : bullets) {
-            if (bullet && !bullet->IsDestroyed()) {
-                BulletData data = BulletToBulletData(*bullet, bulletId);
-                updateMsg.bullets.push_back(data);
+        updateMsg.bullets.clear();
+        for (uint32_t slot : projectiles.GetActiveSlots()) {
+            if (!projectiles.IsDestroyed(slot)) {
+                updateMsg.bullets.push_back(BulletToBulletData(slot));
             }
         }
-
-        packet << static_cast<uint8_t>(updateMsg.type);
-
-        uint32_t bulletCount = static_cast<uint32_t>(updateMsg.bullets.size());
-        packet << bulletCount;
-
-        for (const auto& bulletData : updateMsg.bullets) {
-            packet << bulletData;
+        bulletChunks.Rebuild(updateMsg.bullets.size(), [&updateMsg](size_t index) {
+            return sf::Vector2f(updateMsg.bullets[index].x, updateMsg.bullets[index].y);
+        });
+
+        clientBulletUpdate.timestamp = updateMsg.timestamp;
+        clientBulletUpdate.sequenceNumber = updateMsg.sequenceNumber;
+        clientBulletSpawns.timestamp = updateMsg.timestamp;
+        clientBulletSpawns.sequenceNumber = updateMsg.sequenceNumber;
+
+        const bool sendCorrection = !eventBulletReplication || bulletCorrectionTimer >= BULLET_CORRECTION_INTERVAL;
+        if (eventBulletReplication && sendCorrection) {
+            bulletCorrectionTimer = 0;
         }
 
-        packet << updateMsg.timestamp << updateMsg.sequenceNumber;
+        for (auto& [playerId, client] : clients) {
+            // Group delivery: the multicast frame lists every bullet
+            if (!client.isActive || client.groupDelivery) {
+                continue;
+            }
 
-        for (const auto& [playerId, client] : clients) {
-            if (client.isActive) {
-                sf::Socket::Status sendStatus = socket.send(packet, client.address, client.port);
+            clientBulletUpdate.bullets.clear();
+            clientBulletSpawns.bullets.clear();
+            client.bulletInterest.BeginUpdate(sf::Vector2f(SimOf(client).player.x, SimOf(client).player.y), interestSettings);
+            GatherNearby(bulletChunks, client, nearbyBullets);
+            for (uint32_t index : nearbyBullets) {
+                const BulletData& bulletData = updateMsg.bullets[index];
+                const bool wasRelevant = client.bulletInterest.IsRelevant(bulletData.bulletId);
+                if (client.bulletInterest.Consider(bulletData.bulletId, sf::Vector2f(bulletData.x, bulletData.y))) {
+                    clientBulletUpdate.bullets.push_back(bulletData);
+                    if (!wasRelevant) {
+                        clientBulletSpawns.bullets.push_back(bulletData);
+                    }
+                }
+            }
+            client.bulletInterest.EndUpdate();
+
+            if (eventBulletReplication && !clientBulletSpawns.bullets.empty()) {
+                messageWriter.Reset();
+                NetworkUtils::Write(messageWriter, clientBulletSpawns);
+                if (!messageWriter.HasOverflowed()) {
+                    PacketPool::Lease packet = sendPackets.Borrow();
+                    *packet << static_cast<uint8_t>(NetMessageType::BULLET_SPAWNED);
+                    messageWriter.AppendTo(*packet);
+                    QueueForClient(client, *packet);
+                }
+            }
+            if (!sendCorrection) {
+                SendInterestUpdate(client, client.bulletInterest);
+                continue;
+            }
 
-                if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::NotReady) {
-                    Utils::printMsg("Failed to send bullet update to player " +
-                        std::to_string(playerId), debug);
+            messageWriter.Reset();
+            NetworkUtils::Write(messageWriter, clientBulletUpdate);
+            if (messageWriter.HasOverflowed()) {
+                LOG_MSG(warning, "Bullet update for player " + std::to_string(playerId) +
+                    " exceeds " + std::to_string(BitWriter::MAX_BYTES) + " bytes, not sent");
+                continue;
+            }
+            PacketPool::Lease packet = sendPackets.Borrow();
+            *packet << static_cast<uint8_t>(updateMsg.type);
+            messageWriter.AppendTo(*packet);
+
+            // Over budget the list waits (clients keep simulating the bullets
+            // they have), but not past MAX_BULLET_UPDATE_HOLD_MS
+            if (client.budget.IsLimited() && client.budget.GetAvailable() < static_cast<float>(packet->getDataSize())) {
+                if (client.bulletUpdateHeldSince == 0) {
+                    client.bulletUpdateHeldSince = updateMsg.timestamp;
+                }
+                if (static_cast<int64_t>(updateMsg.timestamp) - client.bulletUpdateHeldSince < MAX_BULLET_UPDATE_HOLD_MS) {
+                    deferredBulletUpdates++;
+                    SendInterestUpdate(client, client.bulletInterest);
+                    continue;
                 }
             }
-        }
+            client.bulletUpdateHeldSince = 0;
 
-        static int updateCounter = 0;
-        if (++updateCounter % 30 == 0) {
-           // Utils::printMsg("Sent bullet update: " + std::to_string(bulletCount) +
-             //   " bullets to " + std::to_string(clients.size()) + " clients", debug);
+            QueueForClient(client, *packet);
+
+            SendInterestUpdate(client, client.bulletInterest);
         }
     }
     catch (const std::exception& e) {
@@ -1450,7 +5311,6 @@ void GameServer::BroadcastBulletDestruction(uint32_t bulletId, uint8_t reason,
     }
 
     try {
-        sf::Packet packet;
         BulletDestroyMessage destroyMsg;
         destroyMsg.type = NetMessageType::BULLET_DESTROY;
         destroyMsg.bulletId = bulletId;
@@ -1461,11 +5321,14 @@ void GameServer::BroadcastBulletDestruction(uint32_t bulletId, uint8_t reason,
         destroyMsg.timestamp = GetCurrentTimestamp();
         destroyMsg.sequenceNumber = outgoingSequenceNumber++;
 
-        packet << destroyMsg;
+        PacketPool::Lease packet = sendPackets.Borrow();
+        *packet << destroyMsg;
 
-        for (const auto& [playerId, client] : clients) {
-            if (client.isActive) {
-                socket.send(packet, client.address, client.port);
+        // Clients that never saw the bullet don't need its destruction
+        for (auto& [playerId, client] : clients) {
+            if (client.isActive &&
+                (client.bulletInterest.IsRelevant(bulletId) || IsInClientInterest(client, hitPos))) {
+                QueueReliableForClient(client, *packet);
             }
         }
 
@@ -1481,352 +5344,424 @@ void GameServer::BroadcastBulletDestruction(uint32_t bulletId, uint8_t reason,
 void GameServer::CheckBulletCollisions() {
     try {
         //  DEBUG: Log collision check start
-        static int checkCounter = 0;
+        static thread_local int checkCounter = 0;
         if (++checkCounter % 60 == 0) {  // Every ~2 seconds at 30Hz
          //   Utils::printMsg("COLLISION CHECK: " + std::to_string(bullets.size()) +
            //     " bullets vs " + std::to_string(clients.size()) + " players vs " +
            //     std::to_string(enemies.size()) + " enemies", debug);
         }
 
-        for (auto& [bulletId, bullet] : bullets) {
-            if (!bullet || bullet->IsDestroyed()) {
+        // Target grids and this tick's enemy history are built by the phases before
+        const int64_t nowMs = GetCurrentTimestamp();
+
+        for (uint32_t slot : projectiles.GetActiveSlots()) {
+            if (projectiles.IsDestroyed(slot)) {
                 continue;
             }
 
-            sf::Vector2f bulletPos = bullet->GetPosition();
-            float bulletRadius = bullet->GetRadius();
-            uint32_t ownerId = bullet->GetOwnerId();
-
-            //  Determine bullet faction ONCE at the start
-            bool isEnemyBullet = (ownerId >= 1000);  // Enemy IDs start at 1000
-            bool isPlayerBullet = (ownerId < 1000);  // Player IDs are < 1000
-
-            // : Log bullet info periodically
-            static std::unordered_map<uint32_t, int> bulletLogCounters;
-            if (++bulletLogCounters[bulletId] % 30 == 0) {
-                std::string bulletType = isEnemyBullet ? "ENEMY" : "PLAYER";
-               // Utils::printMsg("  Bullet " + std::to_string(bulletId) +
-                //    " [" + bulletType + "] at (" +
-                 //   std::to_string(bulletPos.x) + ", " + std::to_string(bulletPos.y) +
-                  //  ") owner=" + std::to_string(ownerId), debug);
+            uint32_t bulletId = projectiles.GetBulletId(slot);
+            sf::Vector2f bulletPos = projectiles.GetPosition(slot);
+            float bulletRadius = projectiles.GetRadius(slot);
+            uint32_t ownerId = projectiles.GetOwnerId(slot);
+
+            // Hits are swept over the bullet's whole move this tick, so a fast
+            // bullet cannot step over a tank at low tick rates. The broadphase
+            // query covers the move: its midpoint, padded by half its length.
+            const sf::Vector2f bulletStart = projectiles.GetPreviousPosition(slot);
+            const sf::Vector2f halfMove = (bulletPos - bulletStart) * 0.5f;
+            const sf::Vector2f sweepCenter = bulletStart + halfMove;
+            const float sweepRadius = bulletRadius + std::sqrt(halfMove.x * halfMove.x + halfMove.y * halfMove.y);
+            float hitTime = 0.0f;
+
+            // The bullet's mask picks its targets. Enemies are tested where the
+            // shooter saw them; the grid holds current positions, so the query
+            // grows by how far an enemy could have moved since.
+            const CollisionLayers::Mask bulletMask = projectiles.GetCollisionMask(slot);
+            const int64_t rewindMs = lagCompensationEnabled && (bulletMask & CollisionLayers::ENEMY) != 0 ?
+                GetLagCompensationRewindMs(ownerId) : 0;
+            const int64_t viewTimeMs = nowMs - rewindMs;
+            const float rewindPadding = static_cast<float>(rewindMs) * 0.001f * LAG_COMPENSATION_MAX_SPEED;
+            if (rewindMs > 0) {
+                rewoundHitTests++;
+                rewoundHitTestMs += rewindMs;
             }
 
-            // CHECK: Bullet vs Enemies
-            if (isPlayerBullet) {
-                for (auto& [enemyId, enemy] : enemies) {
-                    if (!enemy || enemy->IsDead()) {
-                        continue;
+            targetGrid.Query(sweepCenter, sweepRadius + rewindPadding, broadphaseCandidates, bulletMask);
+            LOG_SAMPLED(LogCategory::BULLET_HIT_CHECK, debug, "  Bullet " + std::to_string(bulletId) +
+                " (layers " + std::to_string(bulletMask) + ") checking " +
+                std::to_string(broadphaseCandidates.size()) + " targets...");
+            narrowphaseCircles.Clear();
+            narrowphaseTargets.clear();
+            for (const SpatialGrid::Entry* candidate : broadphaseCandidates) {
+                sf::Vector2f targetPos = candidate->position;
+                if (candidate->layer == CollisionLayers::ENEMY) {
+                    const entt::entity entity = static_cast<entt::entity>(candidate->id);
+                    if (enemyRegistry.get<ServerComponents::Health>(entity).dead) {
+                        continue;   // Killed earlier this tick
                     }
-
-                    sf::Vector2f enemyPos = enemy->GetPosition();
-                    float enemyRadius = enemy->GetRadius();
-
-                    float dx = bulletPos.x - enemyPos.x;
-                    float dy = bulletPos.y - enemyPos.y;
-                    float distSq = dx * dx + dy * dy;
-                    float radiusSum = bulletRadius + enemyRadius;
-
-                    if (distSq < radiusSum * radiusSum) {
-                        float damage = bullet->GetDamage();
-                        float oldHealth = enemy->GetHealth();
-                        enemy->TakeDamage(damage);
-                        float newHealth = enemy->GetHealth();
-
-                     /*   Utils::printMsg("Player bullet " + std::to_string(bulletId) +
-                            " (owner: " + std::to_string(ownerId) + ") hit enemy " +
-                            std::to_string(enemyId) + " for " + std::to_string(damage) +
-                            " damage (Health: " + std::to_string(oldHealth) + " → " +
-                            std::to_string(newHealth) + ")", success);*/
-
-                        // Award score if enemy died
-                        if (enemy->IsDead() && oldHealth > 0.0f) {
-                            auto ownerIt = clients.find(ownerId);
-                            if (ownerIt != clients.end()) {
-                                int scoreValue = enemy->GetScoreValue();
-                                ownerIt->second.score += scoreValue;
-                                ownerIt->second.playerData.score = ownerIt->second.score;
-
-                                Utils::printMsg("Player " + std::to_string(ownerId) +
-                                    " killed enemy " + std::to_string(enemyId) +
-                                    "! +" + std::to_string(scoreValue) + " points | " +
-                                    "Total: " + std::to_string(ownerIt->second.score), success);
-                            }
-                        }
-
-                        bullet->Destroy();
-                        BroadcastBulletDestruction(bulletId, 2, enemyId, bulletPos);
-                        break;
+                    if (rewindMs > 0) {
+                        // Keeps the current position if the enemy has no history yet
+                        enemyPositionHistory.Sample(enemyRegistry.get<ServerComponents::NetworkId>(entity).id,
+                            viewTimeMs, targetPos);
                     }
                 }
-
-                if (bullet->IsDestroyed()) {
-                    continue;
-                }
+                narrowphaseCircles.Add(targetPos, candidate->radius);
+                narrowphaseTargets.push_back(candidate);
             }
 
-            // CHECK: Bullet vs Players 
-      
-            if (isEnemyBullet) {
-                // : Log enemy bullet checking players
-                static std::unordered_map<uint32_t, int> enemyBulletLogCounters;
-                if (++enemyBulletLogCounters[bulletId] % 30 == 0) {
-                    Utils::printMsg("  Enemy bullet " + std::to_string(bulletId) +
-                        " checking " + std::to_string(clients.size()) + " players...", debug);
-                }
-
-                for (auto& [playerId, client] : clients) {
-                    if (!client.isActive) {
-                        continue;
-                    }
-
-                    // Log player positions
-              /*      static std::unordered_map<uint32_t, int> playerPosLogCounters;*/
-                    //if (++playerPosLogCounters[playerId] % 60 == 0) {
-                    //    Utils::printMsg("    Player " + std::to_string(playerId) +
-                    //        " at (" + std::to_string(client.playerData.x) + ", " +
-                    //        std::to_string(client.playerData.y) + ")", debug);
-                    //}
-
-                    float dx = bulletPos.x - client.playerData.x;
-                    float dy = bulletPos.y - client.playerData.y;
-                    float distSq = dx * dx + dy * dy;
-                    float radiusSum = bulletRadius + WorldConstants::TANK_RADIUS;
-                    float distance = std::sqrt(distSq);
-
-                    //  Log close calls
-                    //if (distance < radiusSum * 2.0f) {  // Within 2x collision distance
-                    //    Utils::printMsg("CLOSE: Bullet " + std::to_string(bulletId) +
-                    //        " vs Player " + std::to_string(playerId) +
-                    //        " dist=" + std::to_string(distance) +
-                    //        " (need <" + std::to_string(radiusSum) + ")", warning);
-                    //}
-
-                    if (distSq < radiusSum * radiusSum) {
-                        float damage = bullet->GetDamage();
-                        float oldHealth = client.playerData.health;
-                        client.playerData.health -= damage;
-
-                        if (client.playerData.health < 0.0f) {
-                            client.playerData.health = 0.0f;
-                        }
-
-                        Utils::printMsg("HIT CONFIRMED Enemy bullet " + std::to_string(bulletId) +
-                            " (owner: " + std::to_string(ownerId) + ") hit player " +
-                            std::to_string(playerId) + " for " + std::to_string(damage) +
-                            " damage | Health: " + std::to_string(oldHealth) + " → " +
-                            std::to_string(client.playerData.health), error);  // Use ERROR to make it stand out
-
-                        bullet->Destroy();
-                        BroadcastBulletDestruction(bulletId, 1, playerId, bulletPos);
-                        break;
-                    }
-                }
-
-                if (bullet->IsDestroyed()) {
-                    continue;
+            // Earliest contact along the move wins
+            const size_t hitIndex = narrowphaseCircles.FindEarliestSweptOverlap(bulletStart, bulletPos,
+                bulletRadius, hitTime);
+            if (hitIndex == CircleBatch::NONE) {
+                continue;
+            }
+            const SpatialGrid::Entry& target = *narrowphaseTargets[hitIndex];
+            const sf::Vector2f hitPos = bulletStart + (bulletPos - bulletStart) * hitTime;
+            projectiles.MarkHit(slot);
+            if (target.layer == CollisionLayers::ENEMY) {
+                ApplyBulletHitToEnemy(slot, static_cast<entt::entity>(target.id), hitPos);
+                if (rewindMs > 0) {
+                    rewoundHits++;
                 }
             }
-
-            // CHECK: Bullet vs World Boundaries
-
-            sf::FloatRect worldBounds(
-                sf::Vector2f(WorldConstants::PLAYABLE_MIN_X, WorldConstants::PLAYABLE_MIN_Y),
-                sf::Vector2f(WorldConstants::PLAYABLE_WIDTH, WorldConstants::PLAYABLE_HEIGHT)
-            );
-
-            if (bulletPos.x < worldBounds.position.x ||
-                bulletPos.x > worldBounds.position.x + worldBounds.size.x ||
-                bulletPos.y < worldBounds.position.y ||
-                bulletPos.y > worldBounds.position.y + worldBounds.size.y) {
-
-                Utils::printMsg("Bullet " + std::to_string(bulletId) + " hit border", debug);
-                bullet->Destroy();
-                BroadcastBulletDestruction(bulletId, 3, 0, bulletPos);
+            else {
+                ApplyBulletHitToPlayer(slot, target.id, hitPos);
             }
+            // World boundaries: the border exit was scheduled at spawn (see RemoveDeadBullets)
         }
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in CheckBulletCollisions: " + std::string(e.what()), error);
     }
 }
-void GameServer::RemoveDeadBullets() {
-    auto it = bullets.begin();
-    while (it != bullets.end()) {
-        if (it->second && it->second->IsExpired()) {
-            uint32_t bulletId = it->first;
-            sf::Vector2f pos = it->second->GetPosition();
-
-            // Only broadcast destruction if bullet expired naturally (lifetime)
-            // Don't broadcast if bullet was already destroyed by collision
-            // (collision already sent a destruction message)
 
-            // Check if bullet was destroyed by collision (not just expired)
-            // If destroyed but still has lifetime > 0, it was destroyed by collision
-            bool destroyedByCollision = it->second->IsDestroyed();
-
-            if (!destroyedByCollision) {
-                // Bullet expired naturally (ran out of lifetime) - broadcast
-                BroadcastBulletDestruction(bulletId, 0, 0, pos);
-                //Utils::printMsg("Bullet " + std::to_string(bulletId) +
-                //    " expired naturally", debug);
-            }
-            // else: Already destroyed by collision, destruction already broadcasted
-
-            it = bullets.erase(it);
-        }
-        else {
-            ++it;
+/**
+ * Damages the enemy and, if the shot killed it, scores it for the shooter.
+ * @param slot Projectile that hit (already marked)
+ * @param entity Enemy in enemyRegistry
+ * @param hitPos Contact point along the bullet's move
+ */
+void GameServer::ApplyBulletHitToEnemy(uint32_t slot, entt::entity entity, sf::Vector2f hitPos) {
+    ServerComponents::Health& health = enemyRegistry.get<ServerComponents::Health>(entity);
+    const uint32_t enemyId = enemyRegistry.get<ServerComponents::NetworkId>(entity).id;
+    const uint32_t ownerId = projectiles.GetOwnerId(slot);
+
+    EnemyTank& enemy = *enemyRegistry.get<ServerComponents::EnemyBrain>(entity).tank;
+    float oldHealth = enemy.GetHealth();
+    enemy.TakeDamage(projectiles.GetDamage(slot));
+    health.current = enemy.GetHealth();
+    if (enemy.IsDead() && !health.dead) {
+        deadEnemies.push_back(entity);      // Removed by the next UpdateEnemies
+    }
+    health.dead = enemy.IsDead();
+    MarkEnemyDirty(entity, SnapshotDelta::ENEMY_HEALTH);
+
+    // Award score if enemy died
+    if (health.dead && oldHealth > 0.0f) {
+        auto ownerIt = clients.find(ownerId);
+        const int scoreValue = ownerIt != clients.end() ? enemy.GetScoreValue() : 0;
+        JournalEvent(EventJournal::EventType::ENEMY_KILLED, enemyId, ownerId, scoreValue, hitPos,
+            static_cast<uint8_t>(enemyRegistry.get<ServerComponents::EnemyKind>(entity).type));
+        if (ownerIt != clients.end()) {
+            JournalEvent(EventJournal::EventType::SCORE_CHANGED, ownerId, enemyId, scoreValue, hitPos);
+            RecordScoreChange(ownerId, ownerIt->second, scoreValue);
+            ownerIt->second.score += scoreValue;
+            SimOf(ownerIt->second).player.score = ownerIt->second.score;
+            SimOf(ownerIt->second).dirtyFields |= SnapshotDelta::PLAYER_SCORE;
+
+            LOG_MSG(success, "Player " + std::to_string(ownerId) +
+                " killed enemy " + std::to_string(enemyId) +
+                "! +" + std::to_string(scoreValue) + " points | " +
+                "Total: " + std::to_string(ownerIt->second.score));
         }
     }
+
+    BroadcastBulletDestruction(projectiles.GetBulletId(slot), 2, enemyId, hitPos);
 }
 
-BulletData GameServer::BulletToBulletData(const Bullet& bullet, uint32_t bulletId) const {
-    BulletData data;
-    data.bulletId = bulletId;
-    data.ownerId = bullet.GetOwnerId();
-    data.bulletType = static_cast<uint8_t>(bullet.GetBulletType());
-    data.x = bullet.GetPosition().x;
-    data.y = bullet.GetPosition().y;
-    data.velocityX = bullet.GetVelocity().x;
-    data.velocityY = bullet.GetVelocity().y;
-    data.rotation = bullet.rotation;
-    data.damage = bullet.GetDamage();
-    data.lifetime = 0;
-    data.spawnTime = GetCurrentTimestamp();
+/**
+ * Damages the player; death itself is handled by CheckPlayerDeaths.
+ * @param slot Projectile that hit (already marked)
+ * @param playerId Player that was hit
+ * @param hitPos Contact point along the bullet's move
+ */
+void GameServer::ApplyBulletHitToPlayer(uint32_t slot, uint32_t playerId, sf::Vector2f hitPos) {
+    ClientInfo& client = clients.at(playerId);
+    const uint32_t bulletId = projectiles.GetBulletId(slot);
 
-    return data;
-}
+    float damage = projectiles.GetDamage(slot);
+    float oldHealth = SimOf(client).player.health;
+    SimOf(client).player.health -= damage;
 
-bool GameServer::ValidateBulletSpawnRequest(const BulletSpawnMessage& msg, uint32_t playerId) const {
-    if (!NetworkValidation::IsValidPosition(msg.spawnX, msg.spawnY)) {
-        return false;
+    if (SimOf(client).player.health < 0.0f) {
+        SimOf(client).player.health = 0.0f;
     }
+    SimOf(client).dirtyFields |= SnapshotDelta::PLAYER_HEALTH;
 
-    float dirLength = std::sqrt(msg.directionX * msg.directionX +
-        msg.directionY * msg.directionY);
-    if (dirLength < 0.001f || dirLength > 2.0f) {
-        return false;
-    }
+    Utils::printMsg("HIT CONFIRMED Bullet " + std::to_string(bulletId) +
+        " (owner: " + std::to_string(projectiles.GetOwnerId(slot)) + ") hit player " +
+        std::to_string(playerId) + " for " + std::to_string(damage) +
+        " damage | Health: " + std::to_string(oldHealth) + " → " +
+        std::to_string(SimOf(client).player.health), error);  // Use ERROR to make it stand out
 
-    int64_t currentTime = GetCurrentTimestamp();
-    if (!NetworkValidation::IsValidTimestamp(msg.timestamp, currentTime)) {
-        return false;
+    BroadcastBulletDestruction(bulletId, 1, playerId, hitPos);
+}
+/**
+ * Rebuilds the bullet target grid (enemies and players) from current positions.
+ * Runs once per tick before bullet collision checks, so each bullet only
+ * visits targets in neighbouring cells instead of every enemy and player.
+ * The spawn map's danger counts come from the same pass over live tanks.
+ */
+void GameServer::RebuildTargetGrids() {
+    targetGrid.Clear();
+    spawnMap.ClearDanger();
+    auto enemyView = enemyRegistry.view<const ServerComponents::Transform, const ServerComponents::Health>();
+    for (auto [entity, transform, health] : enemyView.each()) {
+        if (!health.dead) {
+            targetGrid.Insert(static_cast<uint32_t>(entity), transform.position, transform.radius,
+                CollisionLayers::ENEMY, CollisionLayers::ENEMY_MASK);
+            spawnMap.AddDanger(transform.position);
+        }
     }
 
-    return true;
+    for (const auto& [playerId, client] : clients) {
+        if (client.isActive) {
+            const sf::Vector2f position(SimOf(client).player.x, SimOf(client).player.y);
+            targetGrid.Insert(playerId, position, WorldConstants::TANK_RADIUS,
+                CollisionLayers::PLAYER, CollisionLayers::PLAYER_MASK);
+            if (!client.isDead) {
+                spawnMap.AddDanger(position);
+            }
+        }
+    }
 }
 
-void GameServer::CheckServerSideCollisions(float deltaTime) {
-    try {
-        const float TANK_RADIUS = WorldConstants::TANK_RADIUS;
-        const float ENEMY_RADIUS = WorldConstants::ENEMY_TANK_RADIUS;
-        const float SEPARATION_SPEED = 200.0f;
-        const float MIN_SEPARATION = 2.0f;
+/**
+ * Appends this tick's enemy positions to the lag compensation history.
+ * Dead enemies are left out, so they cannot be hit in the past either.
+ */
+void GameServer::RecordEnemyPositionHistory(int64_t nowMs) {
+    enemyPositionHistory.BeginFrame(nowMs);
+    auto view = enemyRegistry.view<const ServerComponents::NetworkId, const ServerComponents::Transform,
+        const ServerComponents::Health>();
+    for (auto [entity, networkId, transform, health] : view.each()) {
+        if (!health.dead) {
+            enemyPositionHistory.Add(networkId.id, transform.position);
+        }
+    }
+    enemyPositionHistory.EndFrame();
+}
 
-        for (auto& [playerId, client] : clients) {
-            if (!client.isActive) continue;
+/**
+ * How far back the owner of a player bullet was looking: clients render
+ * enemies INTERPOLATION_DELAY_MS behind the newest snapshot, which itself
+ * left the server half a round trip earlier.
+ * @return 0 if the owner is unknown (disconnected since firing)
+ */
+int64_t GameServer::GetLagCompensationRewindMs(uint32_t ownerId) const {
+    auto it = clients.find(ownerId);
+    if (it == clients.end() || !it->second.isActive) {
+        return 0;
+    }
 
-            sf::Vector2f playerPos(client.playerData.x, client.playerData.y);
+    const ClientInfo& client = it->second;
+    const int64_t halfRttMs = client.hasRttSample ? static_cast<int64_t>(client.smoothedRttMs * 0.5f) : 0;
+    return std::min(InterpolationManager::INTERPOLATION_DELAY_MS + halfRttMs, MAX_LAG_COMPENSATION_MS);
+}
 
-            for (const auto& [enemyId, enemy] : enemies) {
-                if (!enemy || enemy->IsDead()) continue;
+/**
+ * Folds the round trip of a newly acknowledged snapshot into the client's
+ * smoothed RTT. Snapshots old enough for their send time to be overwritten
+ * are ignored.
+ */
+void GameServer::RecordRttSample(ClientInfo& client, uint32_t ackedSnapshot) {
+    if (client.nextSnapshotSequence - ackedSnapshot > SnapshotHistory::HISTORY_SIZE) {
+        return;
+    }
 
-                sf::Vector2f enemyPos = enemy->GetPosition();
+    const int64_t sentTime = client.snapshotSentTimes[ackedSnapshot % SnapshotHistory::HISTORY_SIZE];
+    const int64_t sampleMs = GetCurrentTimestamp() - sentTime;
+    if (sentTime == 0 || sampleMs < 0) {
+        return;
+    }
 
-                float dx = playerPos.x - enemyPos.x;
-                float dy = playerPos.y - enemyPos.y;
-                float distSq = dx * dx + dy * dy;
-                float minDist = TANK_RADIUS + ENEMY_RADIUS + MIN_SEPARATION;
-                float minDistSq = minDist * minDist;
+    if (!client.hasRttSample) {
+        client.smoothedRttMs = static_cast<float>(sampleMs);
+        client.hasRttSample = true;
+    }
+    else {
+        client.smoothedRttMs += (static_cast<float>(sampleMs) - client.smoothedRttMs) * RTT_SMOOTHING;
+    }
+}
 
-                if (distSq < minDistSq) {
-                    float currentDist = std::sqrt(distSq);
+void GameServer::RemoveDeadBullets() {
+    projectiles.RemoveDead([this](uint32_t slot, ProjectilePool::EndReason reason) {
+        // Collisions already broadcast their own destruction message, so only
+        // bullets whose scheduled expiry fell due are announced here
+        const uint32_t bulletId = projectiles.GetBulletId(slot);
+        if (reason == ProjectilePool::EndReason::LIFETIME) {
+            BroadcastBulletDestruction(bulletId, 0, 0, projectiles.GetPosition(slot));
+        }
+        else if (reason == ProjectilePool::EndReason::BORDER) {
+            LOG_MSG(debug, "Bullet " + std::to_string(bulletId) + " hit border");
+            BroadcastBulletDestruction(bulletId, 3, 0, projectiles.GetPosition(slot));
+        }
+        else if (reason == ProjectilePool::EndReason::OBSTACLE) {
+            BroadcastBulletDestruction(bulletId, 4, 0, projectiles.GetPosition(slot));
+        }
+        });
+}
 
-                    if (currentDist < 0.001f) {
-                        playerPos.x += minDist;
-                    }
-                    else {
-                        float overlap = minDist - currentDist;
-                        float maxSeparation = SEPARATION_SPEED * deltaTime;
-                        float separationAmount = std::min(overlap, maxSeparation);
+BulletData GameServer::BulletToBulletData(uint32_t slot) const {
+    BulletData data;
+    data.bulletId = projectiles.GetBulletId(slot);
+    data.ownerId = projectiles.GetOwnerId(slot);
+    data.bulletType = projectiles.GetBulletType(slot);
+    data.x = projectiles.GetPosition(slot).x;
+    data.y = projectiles.GetPosition(slot).y;
+    data.velocityX = projectiles.GetVelocity(slot).x;
+    data.velocityY = projectiles.GetVelocity(slot).y;
+    data.rotation = projectiles.GetRotation(slot);
+    data.damage = projectiles.GetDamage(slot);
+    data.lifetime = projectiles.GetLifetime(slot);   // Remaining; clients expire bullets they simulate
+    data.spawnTime = GetCurrentTimestamp();
+    data.spawnToken = projectiles.GetSpawnToken(slot);
 
-                        sf::Vector2f pushDir(dx / currentDist, dy / currentDist);
+    return data;
+}
 
-                        playerPos = playerPos + pushDir * separationAmount;
-                    }
+namespace {
+    constexpr float SEPARATION_SPEED = 200.0f;
+    constexpr float MIN_SEPARATION = 2.0f;
 
-                    client.playerData.x = playerPos.x;
-                    client.playerData.y = playerPos.y;
+    // Separation never pushes a tank through the border or into an obstacle
+    void ClampToMovementBounds(PlayerData& player, const StaticObstacles& obstacles) {
+        player.x = std::max(WorldConstants::MOVEMENT_MIN_X,
+            std::min(WorldConstants::MOVEMENT_MAX_X, player.x));
+        player.y = std::max(WorldConstants::MOVEMENT_MIN_Y,
+            std::min(WorldConstants::MOVEMENT_MAX_Y, player.y));
+        const sf::Vector2f resolved = obstacles.ResolveCircle(sf::Vector2f(player.x, player.y), WorldConstants::TANK_RADIUS);
+        player.x = resolved.x;
+        player.y = resolved.y;
+    }
+}
 
-                    client.playerData.x = std::max(WorldConstants::MOVEMENT_MIN_X,
-                        std::min(WorldConstants::MOVEMENT_MAX_X, client.playerData.x));
-                    client.playerData.y = std::max(WorldConstants::MOVEMENT_MIN_Y,
-                        std::min(WorldConstants::MOVEMENT_MAX_Y, client.playerData.y));
-                }
+/**
+ * Authoritative tank separation. Players and enemies are put in one spatial
+ * grid per tick and only the overlapping pairs it reports are resolved, so
+ * the cost grows with entity count instead of with the number of pairs.
+ * Enemy-vs-enemy pairs are left out by the layer masks, as before.
+ */
+void GameServer::CheckServerSideCollisions(float deltaTime) {
+    try {
+        tankGrid.Clear();
+        for (uint32_t slot = 0; slot < playerSims.size(); ++slot) {
+            const PlayerSimState& sim = playerSims[slot];
+            if (sim.inUse) {
+                tankGrid.Insert(PLAYER_GRID_KEY | slot, sf::Vector2f(sim.player.x, sim.player.y),
+                    WorldConstants::TANK_RADIUS, CollisionLayers::PLAYER, CollisionLayers::PLAYER_MASK);
             }
         }
-
-        std::vector<uint32_t> playerIds;
-        for (const auto& [id, client] : clients) {
-            if (client.isActive) {
-                playerIds.push_back(id);
+        auto enemyView = enemyRegistry.view<const ServerComponents::NetworkId, const ServerComponents::Transform,
+            const ServerComponents::Health>();
+        for (auto [entity, networkId, transform, health] : enemyView.each()) {
+            if (!health.dead) {
+                tankGrid.Insert(networkId.id, transform.position, WorldConstants::ENEMY_TANK_RADIUS,
+                    CollisionLayers::ENEMY, CollisionLayers::ENEMY_MASK);
             }
         }
 
-        for (size_t i = 0; i < playerIds.size(); ++i) {
-            for (size_t j = i + 1; j < playerIds.size(); ++j) {
-                uint32_t id1 = playerIds[i];
-                uint32_t id2 = playerIds[j];
+        tankGrid.FindOverlappingPairs(MIN_SEPARATION, tankOverlapPairs);
 
-                auto& client1 = clients[id1];
-                auto& client2 = clients[id2];
+        for (const SpatialGrid::OverlapPair& pair : tankOverlapPairs) {
+            const bool aIsPlayer = pair.a->layer == CollisionLayers::PLAYER;
+            const bool bIsPlayer = pair.b->layer == CollisionLayers::PLAYER;
+            PlayerSimState* simA = aIsPlayer ? &playerSims[pair.a->id & ~PLAYER_GRID_KEY] : nullptr;
+            PlayerSimState* simB = bIsPlayer ? &playerSims[pair.b->id & ~PLAYER_GRID_KEY] : nullptr;
 
-                sf::Vector2f pos1(client1.playerData.x, client1.playerData.y);
-                sf::Vector2f pos2(client2.playerData.x, client2.playerData.y);
+            if (simA && simB) {
+                SeparatePlayers(*simA, *simB, deltaTime);
+            }
+            else if (simA) {
+                SeparatePlayerFromEnemy(*simA, pair.b->position, deltaTime);
+            }
+            else if (simB) {
+                SeparatePlayerFromEnemy(*simB, pair.a->position, deltaTime);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in CheckServerSideCollisions: " + std::string(e.what()), error);
+    }
+}
 
-                float dx = pos2.x - pos1.x;
-                float dy = pos2.y - pos1.y;
-                float distSq = dx * dx + dy * dy;
-                float minDist = TANK_RADIUS * 2.0f + MIN_SEPARATION;
-                float minDistSq = minDist * minDist;
+/**
+ * Pushes a player out of an enemy tank (enemies are never moved by players).
+ * Separation speed is capped per tick so corrections look smooth on clients.
+ */
+void GameServer::SeparatePlayerFromEnemy(PlayerSimState& sim, sf::Vector2f enemyPos, float deltaTime) {
+    sf::Vector2f playerPos(sim.player.x, sim.player.y);
 
-                if (distSq < minDistSq) {
-                    float currentDist = std::sqrt(distSq);
+    float dx = playerPos.x - enemyPos.x;
+    float dy = playerPos.y - enemyPos.y;
+    float distSq = dx * dx + dy * dy;
+    float minDist = WorldConstants::TANK_RADIUS + WorldConstants::ENEMY_TANK_RADIUS + MIN_SEPARATION;
 
-                    if (currentDist < 0.001f) {
-                        client1.playerData.x -= minDist / 2.0f;
-                        client2.playerData.x += minDist / 2.0f;
-                    }
-                    else {
-                        float overlap = minDist - currentDist;
-                        float maxSeparation = (SEPARATION_SPEED * deltaTime) / 2.0f;
-                        float separationAmount = std::min(overlap / 2.0f, maxSeparation);
+    if (distSq >= minDist * minDist) {
+        return;  // Already separated by an earlier pair this tick
+    }
 
-                        sf::Vector2f pushDir(dx / currentDist, dy / currentDist);
+    float currentDist = std::sqrt(distSq);
+    if (currentDist < 0.001f) {
+        playerPos.x += minDist;
+    }
+    else {
+        float overlap = minDist - currentDist;
+        float separationAmount = std::min(overlap, SEPARATION_SPEED * deltaTime);
+        sf::Vector2f pushDir(dx / currentDist, dy / currentDist);
+        playerPos = playerPos + pushDir * separationAmount;
+    }
 
-                        client1.playerData.x -= pushDir.x * separationAmount;
-                        client1.playerData.y -= pushDir.y * separationAmount;
+    sim.player.x = playerPos.x;
+    sim.player.y = playerPos.y;
+    ClampToMovementBounds(sim.player, obstacles);
+    sim.dirtyFields |= SnapshotDelta::PLAYER_POSITION;
+}
 
-                        client2.playerData.x += pushDir.x * separationAmount;
-                        client2.playerData.y += pushDir.y * separationAmount;
-                    }
+/**
+ * Pushes two overlapping players apart, each taking half of the correction.
+ */
+void GameServer::SeparatePlayers(PlayerSimState& sim1, PlayerSimState& sim2, float deltaTime) {
+    float dx = sim2.player.x - sim1.player.x;
+    float dy = sim2.player.y - sim1.player.y;
+    float distSq = dx * dx + dy * dy;
+    float minDist = WorldConstants::TANK_RADIUS * 2.0f + MIN_SEPARATION;
 
-                    client1.playerData.x = std::max(WorldConstants::MOVEMENT_MIN_X,
-                        std::min(WorldConstants::MOVEMENT_MAX_X, client1.playerData.x));
-                    client1.playerData.y = std::max(WorldConstants::MOVEMENT_MIN_Y,
-                        std::min(WorldConstants::MOVEMENT_MAX_Y, client1.playerData.y));
+    if (distSq >= minDist * minDist) {
+        return;
+    }
 
-                    client2.playerData.x = std::max(WorldConstants::MOVEMENT_MIN_X,
-                        std::min(WorldConstants::MOVEMENT_MAX_X, client2.playerData.x));
-                    client2.playerData.y = std::max(WorldConstants::MOVEMENT_MIN_Y,
-                        std::min(WorldConstants::MOVEMENT_MAX_Y, client2.playerData.y));
-                }
-            }
-        }
+    float currentDist = std::sqrt(distSq);
+    if (currentDist < 0.001f) {
+        sim1.player.x -= minDist / 2.0f;
+        sim2.player.x += minDist / 2.0f;
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception in CheckServerSideCollisions: " + std::string(e.what()), error);
+    else {
+        float overlap = minDist - currentDist;
+        float maxSeparation = (SEPARATION_SPEED * deltaTime) / 2.0f;
+        float separationAmount = std::min(overlap / 2.0f, maxSeparation);
+        sf::Vector2f pushDir(dx / currentDist, dy / currentDist);
+
+        sim1.player.x -= pushDir.x * separationAmount;
+        sim1.player.y -= pushDir.y * separationAmount;
+        sim2.player.x += pushDir.x * separationAmount;
+        sim2.player.y += pushDir.y * separationAmount;
     }
+
+    ClampToMovementBounds(sim1.player, obstacles);
+    ClampToMovementBounds(sim2.player, obstacles);
+    sim1.dirtyFields |= SnapshotDelta::PLAYER_POSITION;
+    sim2.dirtyFields |= SnapshotDelta::PLAYER_POSITION;
 }
 // DEATH AND RESPAWN SYSTEM IMPLEMENTATION
 
@@ -1842,14 +5777,14 @@ void GameServer::CheckPlayerDeaths() {
             }
 
             // Check if player's health dropped to zero or below
-            if (client.playerData.health <= 0.0f) {
+            if (SimOf(client).player.health <= 0.0f) {
                 // Determine killer (0 = killed by enemy)
                 uint32_t killerId = 0; 
 
                 Utils::printMsg("PLAYER DEATH DETECTED: Player " +
-                    std::to_string(playerId) + " (" + client.playerData.playerName +
-                    ") died at (" + std::to_string(client.playerData.x) + ", " +
-                    std::to_string(client.playerData.y) + ")", error);
+                    std::to_string(playerId) + " (" + client.playerName +
+                    ") died at (" + std::to_string(SimOf(client).player.x) + ", " +
+                    std::to_string(SimOf(client).player.y) + ")", error);
 
                 HandlePlayerDeath(playerId, killerId);
             }
@@ -1875,11 +5810,11 @@ void GameServer::HandlePlayerDeath(uint32_t playerId, uint32_t killerId) {
 
     // Mark player as dead
     client.isDead = true;
-    client.playerData.isDead = true;
-    client.deathTimer = ClientInfo::RESPAWN_COOLDOWN; // 5 seconds
+    SimOf(client).player.isDead = true;
+    client.respawnTimer = ScheduleAfter(ClientInfo::RESPAWN_COOLDOWN, ServerTimer::RESPAWN, playerId);
 
     // Store death position for broadcast
-    sf::Vector2f deathPos(client.playerData.x, client.playerData.y);
+    sf::Vector2f deathPos(SimOf(client).player.x, SimOf(client).player.y);
 
     // Apply score penalty (minimum 0)
     int32_t oldScore = client.score;
@@ -1887,55 +5822,45 @@ void GameServer::HandlePlayerDeath(uint32_t playerId, uint32_t killerId) {
     if (client.score < 0) {
         client.score = 0;
     }
-    client.playerData.score = client.score;
+    SimOf(client).player.score = client.score;
 
     int32_t actualPenalty = oldScore - client.score;
+    JournalEvent(EventJournal::EventType::PLAYER_DIED, playerId, killerId, actualPenalty, deathPos);
+    if (actualPenalty != 0) {
+        JournalEvent(EventJournal::EventType::SCORE_CHANGED, playerId, 0, -actualPenalty, deathPos);
+        RecordScoreChange(playerId, client, -actualPenalty);
+    }
 
-    Utils::printMsg("DEATH PENALTY: Player " + std::to_string(playerId) +
+    LOG_MSG(warning, "DEATH PENALTY: Player " + std::to_string(playerId) +
         " lost " + std::to_string(actualPenalty) + " points | " +
-        "Score: " + std::to_string(oldScore) + " → " + std::to_string(client.score),
-        warning);
+        "Score: " + std::to_string(oldScore) + " → " + std::to_string(client.score));
 
     // Set health to 0 (in case it went negative)
-    client.playerData.health = 0.0f;
+    SimOf(client).player.health = 0.0f;
+    SimOf(client).dirtyFields |= SnapshotDelta::PLAYER_DEAD | SnapshotDelta::PLAYER_SCORE | SnapshotDelta::PLAYER_HEALTH;
 
     // Broadcast death to all clients
     BroadcastPlayerDeath(playerId, killerId, deathPos, actualPenalty);
 
-    Utils::printMsg("Player " + std::to_string(playerId) +
-        " will respawn in " + std::to_string(ClientInfo::RESPAWN_COOLDOWN) + " seconds",
-        info);
+    LOG_MSG(info, "Player " + std::to_string(playerId) +
+        " will respawn in " + std::to_string(ClientInfo::RESPAWN_COOLDOWN) + " seconds");
 }
 
 /**
- * Update all dead players' respawn timers and respawn them when ready
- * @param deltaTime Time elapsed since last frame
+ * Respawn the dead players whose respawn timer came due this tick
  */
-void GameServer::UpdateDeadPlayers(float deltaTime) {
+void GameServer::UpdateDeadPlayers() {
     try {
-        for (auto& [playerId, client] : clients) {
-            if (!client.isActive || !client.isDead) {
-                continue; // Only process active, dead players
-            }
-
-            // Countdown respawn timer
-            client.deathTimer -= deltaTime;
-
-            // Log countdown periodically (every second)
-            static std::unordered_map<uint32_t, float> logTimers;
-            logTimers[playerId] += deltaTime;
-            if (logTimers[playerId] >= 1.0f && client.deathTimer > 0) {
-                Utils::printMsg("Player " + std::to_string(playerId) +
-                    " respawns in " + std::to_string((int)std::ceil(client.deathTimer)) +
-                    " seconds", debug);
-                logTimers[playerId] = 0.0f;
+        for (const TimerWheel::Fired& timer : firedTimers) {
+            if (timer.kind != static_cast<uint8_t>(ServerTimer::RESPAWN)) {
+                continue;
             }
-
-            // Check if respawn timer expired
-            if (client.deathTimer <= 0.0f) {
-                RespawnPlayer(playerId);
-                logTimers.erase(playerId); // Clear log timer
+            auto it = clients.find(timer.target);
+            if (it == clients.end() || !it->second.isActive || !it->second.isDead ||
+                it->second.respawnTimer != timer.id) {
+                continue; // Player left, or already respawned
             }
+            RespawnPlayer(timer.target);
         }
     }
     catch (const std::exception& e) {
@@ -1956,32 +5881,37 @@ void GameServer::RespawnPlayer(uint32_t playerId) {
     ClientInfo& client = it->second;
 
     // Get random spawn position
-    sf::Vector2f spawnPos = GetRandomRespawnPosition();
+    sf::Vector2f spawnPos = GetRandomRespawnPosition(playerId);
 
     // Reset player state
     client.isDead = false;
-    client.playerData.isDead = false;
-    client.deathTimer = 0.0f;
-    client.playerData.health = client.playerData.maxHealth; // Full health
-    client.playerData.x = spawnPos.x;
-    client.playerData.y = spawnPos.y;
-    client.playerData.bodyRotation = 0.0f;
-    client.playerData.barrelRotation = 0.0f;
+    SimOf(client).player.isDead = false;
+    timers.Cancel(client.respawnTimer);
+    client.respawnTimer = TimerWheel::INVALID_TIMER;
+    SimOf(client).player.health = SimOf(client).player.maxHealth; // Full health
+    SimOf(client).player.x = spawnPos.x;
+    SimOf(client).player.y = spawnPos.y;
+    SimOf(client).player.bodyRotation = 0.0f;
+    SimOf(client).player.barrelRotation = 0.0f;
 
     // Clear movement flags
-    client.playerData.isMoving_forward = false;
-    client.playerData.isMoving_backward = false;
-    client.playerData.isMoving_left = false;
-    client.playerData.isMoving_right = false;
-
-    Utils::printMsg("RESPAWN: Player " + std::to_string(playerId) + " (" +
-        client.playerData.playerName + ") respawned at (" +
+    SimOf(client).player.isMoving_forward = false;
+    SimOf(client).player.isMoving_backward = false;
+    SimOf(client).player.isMoving_left = false;
+    SimOf(client).player.isMoving_right = false;
+    SimOf(client).dirtyFields |= SnapshotDelta::PLAYER_DEAD | SnapshotDelta::PLAYER_HEALTH | SnapshotDelta::PLAYER_POSITION |
+        SnapshotDelta::PLAYER_BODY_ROTATION | SnapshotDelta::PLAYER_BARREL_ROTATION | SnapshotDelta::PLAYER_MOVEMENT;
+
+    LOG_MSG(success, "RESPAWN: Player " + std::to_string(playerId) + " (" +
+        client.playerName + ") respawned at (" +
         std::to_string(spawnPos.x) + ", " + std::to_string(spawnPos.y) + ") | " +
         "Score: " + std::to_string(client.score) + " | Health: " +
-        std::to_string(client.playerData.health), success);
+        std::to_string(SimOf(client).player.health));
+
+    JournalEvent(EventJournal::EventType::PLAYER_RESPAWNED, playerId, 0, 0, spawnPos);
 
     // Broadcast respawn to all clients
-    BroadcastPlayerRespawn(playerId, spawnPos, client.playerData.health);
+    BroadcastPlayerRespawn(playerId, spawnPos, SimOf(client).player.health);
 }
 
 /**
@@ -1998,7 +5928,6 @@ void GameServer::BroadcastPlayerDeath(uint32_t playerId, uint32_t killerId,
     }
 
     try {
-        sf::Packet packet;
         PlayerDeathMessage deathMsg;
         deathMsg.type = NetMessageType::PLAYER_DEATH;
         deathMsg.playerId = playerId;
@@ -2010,23 +5939,17 @@ void GameServer::BroadcastPlayerDeath(uint32_t playerId, uint32_t killerId,
         deathMsg.sequenceNumber = outgoingSequenceNumber++;
 
         // Serialize death message
-        packet << static_cast<uint8_t>(deathMsg.type)
-            << deathMsg.playerId
-            << deathMsg.killerId
-            << deathMsg.deathX
-            << deathMsg.deathY
-            << deathMsg.scorePenalty
-            << deathMsg.timestamp
-            << deathMsg.sequenceNumber;
+        PacketPool::Lease packet = sendPackets.Borrow();
+        *packet << deathMsg;
 
         // Send to all active clients
-        for (const auto& [id, client] : clients) {
+        for (auto& [id, client] : clients) {
             if (client.isActive) {
-                socket.send(packet, client.address, client.port);
+                QueueReliableForClient(client, *packet);
             }
         }
 
-        Utils::printMsg("Broadcasted death message for player " + std::to_string(playerId), debug);
+        LOG_MSG(debug, "Broadcasted death message for player " + std::to_string(playerId));
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in BroadcastPlayerDeath: " + std::string(e.what()), error);
@@ -2045,7 +5968,6 @@ void GameServer::BroadcastPlayerRespawn(uint32_t playerId, sf::Vector2f spawnPos
     }
 
     try {
-        sf::Packet packet;
         PlayerRespawnMessage respawnMsg;
         respawnMsg.type = NetMessageType::PLAYER_RESPAWN;
         respawnMsg.playerId = playerId;
@@ -2056,22 +5978,17 @@ void GameServer::BroadcastPlayerRespawn(uint32_t playerId, sf::Vector2f spawnPos
         respawnMsg.sequenceNumber = outgoingSequenceNumber++;
 
         // Serialize respawn message
-        packet << static_cast<uint8_t>(respawnMsg.type)
-            << respawnMsg.playerId
-            << respawnMsg.spawnX
-            << respawnMsg.spawnY
-            << respawnMsg.health
-            << respawnMsg.timestamp
-            << respawnMsg.sequenceNumber;
+        PacketPool::Lease packet = sendPackets.Borrow();
+        *packet << respawnMsg;
 
         // Send to all active clients
-        for (const auto& [id, client] : clients) {
+        for (auto& [id, client] : clients) {
             if (client.isActive) {
-                socket.send(packet, client.address, client.port);
+                QueueReliableForClient(client, *packet);
             }
         }
 
-        Utils::printMsg("Broadcasted respawn message for player " + std::to_string(playerId), debug);
+        LOG_MSG(debug, "Broadcasted respawn message for player " + std::to_string(playerId));
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in BroadcastPlayerRespawn: " + std::string(e.what()), error);
@@ -2079,70 +5996,18 @@ void GameServer::BroadcastPlayerRespawn(uint32_t playerId, sf::Vector2f spawnPos
 }
 
 /**
- * Get a random respawn position that's safe (not near enemies or other players)
- * @return Random spawn position within world bounds
+ * A point in a random cell with no live enemy or player within
+ * SpawnMap::SAFE_DISTANCE, or the least crowded cell when none is left.
+ * The spot is marked at once, so players respawning together spread out.
+ * @param playerId The player respawning, whose stream picks the spot
+ * @return Spawn position inside the spawn bounds, clear of obstacles
  */
-sf::Vector2f GameServer::GetRandomRespawnPosition() {
-    // Use the same spawn logic as GetRandomSpawnPosition() but with safety checks
-    std::uniform_real_distribution<float> distX(
-        WorldConstants::PLAYABLE_MIN_X + WorldConstants::TANK_RADIUS + 50.0f,
-        WorldConstants::PLAYABLE_MAX_X - WorldConstants::TANK_RADIUS - 50.0f
-    );
-
-    std::uniform_real_distribution<float> distY(
-        WorldConstants::PLAYABLE_MIN_Y + WorldConstants::TANK_RADIUS + 50.0f,
-        WorldConstants::PLAYABLE_MAX_Y - WorldConstants::TANK_RADIUS - 50.0f
-    );
-
-    // Try to find a safe spawn position (max 10 attempts)
-    const int MAX_ATTEMPTS = 10;
-    const float MIN_SAFE_DISTANCE = 200.0f; // Minimum distance from enemies/players
-
-    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
-        sf::Vector2f candidatePos(distX(randomGenerator), distY(randomGenerator));
-        bool isSafe = true;
-
-        // Check distance from all enemies
-        for (const auto& [enemyId, enemy] : enemies) {
-            if (!enemy || enemy->IsDead()) continue;
-
-            sf::Vector2f enemyPos = enemy->GetPosition();
-            float dx = candidatePos.x - enemyPos.x;
-            float dy = candidatePos.y - enemyPos.y;
-            float distSq = dx * dx + dy * dy;
-
-            if (distSq < MIN_SAFE_DISTANCE * MIN_SAFE_DISTANCE) {
-                isSafe = false;
-                break;
-            }
-        }
-
-        if (!isSafe) continue;
-
-        // Check distance from all active players
-        for (const auto& [playerId, client] : clients) {
-            if (!client.isActive || client.isDead) continue;
-
-            float dx = candidatePos.x - client.playerData.x;
-            float dy = candidatePos.y - client.playerData.y;
-            float distSq = dx * dx + dy * dy;
-
-            if (distSq < MIN_SAFE_DISTANCE * MIN_SAFE_DISTANCE) {
-                isSafe = false;
-                break;
-            }
-        }
-
-        if (isSafe) {
-            Utils::printMsg("Found safe respawn position at (" +
-                std::to_string(candidatePos.x) + ", " +
-                std::to_string(candidatePos.y) + ") on attempt " +
-                std::to_string(attempt + 1), debug);
-            return candidatePos;
-        }
+sf::Vector2f GameServer::GetRandomRespawnPosition(uint32_t playerId) {
+    RandomStream random = RandomFor(RandomPurpose::PLAYER_RESPAWN, playerId);
+    const sf::Vector2f position = spawnMap.Pick(random, obstacles);
+    if (spawnMap.GetSafeCellCount() == 0) {
+        LOG_MSG(warning, "No safe respawn cell left, using the least crowded one");
     }
-
-    // If no safe position found, return center position
-    Utils::printMsg(" Could not find safe respawn position, using center", warning);
-    return sf::Vector2f(WorldConstants::CENTER_X, WorldConstants::CENTER_Y);
+    spawnMap.AddDanger(position);
+    return position;
 }
\ No newline at end of file
@@ -1,114 +1,1010 @@
 #pragma once
 #include <SFML/Network.hpp>
+#include <algorithm>
+#include <array>
 #include <unordered_map>
 #include <vector>
 #include <string>
 #include "network_messages.h"
 #include "EnemyTank.h"
 #include <random>
-#include "Bullet.h"
+#include "random_stream.h"
+#include "tick_scheduler.h"
+#include "tick_clock.h"
+#include "tick_profiler.h"
+#include "tick_graph.h"
+#include "timer_wheel.h"
+#include "bandwidth_stats.h"
+#include "network_io_thread.h"
+#include "batched_udp_socket.h"
+#include "shared_memory_transport.h"
+#include "spatial_grid.h"
+#include "circle_batch.h"
+#include "projectile_pool.h"
+#include "snapshot_delta.h"
+#include "snapshot_encode_cache.h"
+#include "interest_area.h"
+#include "packet_aggregator.h"
+#include "packet_compression.h"
+#include "packet_pool.h"
+#include "send_pacer.h"
+#include "snapshot_pipeline.h"
+#include "connection_token.h"
+#include "ingress_rate_limiter.h"
+#include "ingress_validator.h"
+#include "client_telemetry.h"
+#include "overload_controller.h"
+#include "enemy_squads.h"
+#include "directory_service.h"
+#include "reliable_channel.h"
+#include "replication_budget.h"
+#include "entity_interpolation.h"
+#include "sequence_window.h"
+#include "input_jitter_buffer.h"
+#include "job_system.h"
+#include "navigation_grid.h"
+#include "spawn_map.h"
+#include "position_history.h"
+#include "server_components.h"
+#include "match_recording.h"
+#include "match_checkpoint.h"
+#include "handoff.h"
+#include "metrics_exporter.h"
+#include "packet_capture.h"
+#include "event_journal.h"
+#include "memory_report.h"
+#include "network_conditioner.h"
+#include "spectator_stream.h"
+#include "lan_multicast.h"
+#include "world_chunks.h"
+#include <entt.hpp>
+
+// What the simulation reads and writes of a player every tick. GameServer
+// keeps these in one dense array indexed by ClientInfo::slot, so movement,
+// tank collisions and hit tests walk a few cache lines instead of the client
+// table's nodes, and the connection state around them stays cold.
+struct PlayerSimState {
+    PlayerData player;
+    uint16_t dirtyFields;           // SnapshotDelta::PLAYER_* written since the world snapshot was updated
+    bool inUse;                     // Slot belongs to a client
+
+    PlayerSimState() : dirtyFields(SnapshotDelta::PLAYER_ALL), inUse(false) {}
+};
+
 struct ClientInfo {
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
     sf::IpAddress address;
     unsigned short port;
-    PlayerData playerData;
-    float lastUpdateTime;
+    uint64_t connectionToken;       // Every datagram from this client must start with it
+    uint32_t slot;                  // Index of its PlayerSimState (see GameServer::SimOf)
+    std::string playerName;         // Replicated through the player table, not snapshots
+    uint32_t lastHeardTick;         // Tick of the last message from this client
+    TimerWheel::TimerId timeoutTimer;   // While suspended (see SetSessionResumeGrace): the session's expiry
     bool isActive;
+    bool restored;                  // Suspended by a checkpoint restore: its reliable channel restarts on resume
 
     // Sequence number tracking for this client
-    uint32_t lastReceivedSequenceNumber;
-    std::unordered_map<uint32_t, bool> receivedSequenceNumbers;
+    SequenceWindow receivedSequences;
 
-    // Track last acknowledged input for this client
+    // Inputs wait in the jitter buffer and are applied one per tick; the ack
+    // is the last input applied, so it matches the state in the snapshots
+    InputJitterBuffer inputBuffer;
+    uint32_t lastReceivedInputSeq;
     uint32_t lastAcknowledgedInputSeq;
+    int64_t lastInputApplyMicros;   // Tick time the acked input was applied, echoed for latency measurement
+
+    // LAN multicast (see GameServer::SetLanMulticast): on group delivery the
+    // client's snapshots and bullet lists come from the group
+    bool groupDelivery;
+    uint32_t lastGroupFrame;        // Newest multicast frame it reported receiving
+    int64_t lastGroupProgressMs;    // When its reports last advanced
+
+    // Delta snapshots: recent snapshots sent to this client, used as baselines once acked
+    SnapshotHistory snapshotHistory;
+    uint32_t nextSnapshotSequence;  // Starts at 1 (0 means "no snapshot")
+    uint32_t lastAckedSnapshot;     // Newest snapshot the client reported decoding
+    uint32_t resyncSnapshot;        // First snapshot after the last STATE_RESYNC; requests about older ones are answered
+    // Round trip estimate from snapshot acks (send time -> first ack), for lag compensation
+    std::array<int64_t, SnapshotHistory::HISTORY_SIZE> snapshotSentTimes;  // Indexed by sequence % size
+    float smoothedRttMs;
+    bool hasRttSample;
+
+    // Player table (names/colors): resent until the client acks the current version
+    uint32_t ackedPlayerTableVersion;
+    uint32_t sentPlayerTableVersion;
+    int64_t playerTableSentTime;    // ms timestamp of the last PLAYER_LIST sent
+
+    // Area of interest: enemies/bullets currently replicated to this client
+    InterestSet enemyInterest;
+    InterestSet bulletInterest;
+    std::vector<uint32_t> nearbyEnemies;    // Scratch: worldSnapshot.enemies indices in the chunks around it
+
+    // Chunks whose static content the client holds, as far as the server knows
+    std::vector<WorldChunks::ChunkId> streamedChunks;
+
+    // Messages queued during the current tick, coalesced when the tick ends
+    PacketAggregator outgoing;
+    ReliableSender reliable;        // Gameplay events, resent until acked
+    uint32_t sendJob;               // Index + 1 of its job in the snapshot pipeline frame being filled (0 = none)
+
+    // Datagram traffic to and from this client in the current stats window
+    TrafficCounter trafficSent;
+    TrafficCounter trafficReceived;
+
+    // Replication within the link's bandwidth (see GameServer::SetClientBandwidth)
+    BandwidthBudget budget;
+    PriorityAccumulator playerPriority;
+    PriorityAccumulator enemyPriority;
+    int64_t bulletUpdateHeldSince;  // ms timestamp, 0 while bullet lists go out on time
+    uint32_t replicationPass;       // Snapshots built for this client (see SetReplicationRates)
+
+    // What the client extrapolates each entity from (see SetDeadReckoning):
+    // the last two states sent that it buffered
+    struct DeadReckonedEntity {
+        EntitySnapshot older;
+        EntitySnapshot newest;
+        bool hasOlder = false;
+        uint32_t pass = 0;
+    };
+    std::unordered_map<uint32_t, DeadReckonedEntity> deadReckonedEntities;  // Player ID, or enemy ID | DEAD_RECKONING_ENEMY_KEY
+    uint32_t deadReckoningPass;
 
     // Death and respawn system
     int32_t score;                  // Player score (starts at 0, penalty -100 on death)
     bool isDead;                    // Whether player is currently dead
-    float deathTimer;               // Countdown timer for respawn (5 seconds)
+    TimerWheel::TimerId respawnTimer;   // Pending while dead
     static constexpr float RESPAWN_COOLDOWN = 5.0f;
     static constexpr int32_t DEATH_PENALTY = 100;
 
-    ClientInfo() : address(sf::IpAddress::LocalHost), port(0), lastUpdateTime(0),
-        isActive(false), lastReceivedSequenceNumber(0), lastAcknowledgedInputSeq(0),
-        score(0), isDead(false), deathTimer(0.0f) {
+    ClientInfo() : address(sf::IpAddress::LocalHost), port(0), connectionToken(0), slot(NO_SLOT), lastHeardTick(0),
+        timeoutTimer(TimerWheel::INVALID_TIMER), isActive(false), restored(false), lastReceivedInputSeq(0), lastAcknowledgedInputSeq(0),
+        lastInputApplyMicros(0), groupDelivery(false), lastGroupFrame(0), lastGroupProgressMs(0),
+        nextSnapshotSequence(1), lastAckedSnapshot(0), resyncSnapshot(0), snapshotSentTimes{}, smoothedRttMs(0.0f),
+        hasRttSample(false), ackedPlayerTableVersion(0),
+        sentPlayerTableVersion(0), playerTableSentTime(0), sendJob(0), bulletUpdateHeldSince(0), replicationPass(0),
+        deadReckoningPass(0), score(0), isDead(false), respawnTimer(TimerWheel::INVALID_TIMER) {
     }
     ClientInfo(sf::IpAddress addr, unsigned short p)
-        : address(addr), port(p), lastUpdateTime(0), isActive(true),
-        lastReceivedSequenceNumber(0), lastAcknowledgedInputSeq(0),
-        score(0), isDead(false), deathTimer(0.0f) {
+        : address(addr), port(p), connectionToken(0), slot(NO_SLOT), lastHeardTick(0),
+        timeoutTimer(TimerWheel::INVALID_TIMER), isActive(true), restored(false),
+        lastReceivedInputSeq(0), lastAcknowledgedInputSeq(0), lastInputApplyMicros(0),
+        groupDelivery(false), lastGroupFrame(0), lastGroupProgressMs(0), nextSnapshotSequence(1), lastAckedSnapshot(0), resyncSnapshot(0), snapshotSentTimes{}, smoothedRttMs(0.0f),
+        hasRttSample(false), ackedPlayerTableVersion(0),
+        sentPlayerTableVersion(0), playerTableSentTime(0), sendJob(0), bulletUpdateHeldSince(0), replicationPass(0),
+        deadReckoningPass(0), score(0), isDead(false), respawnTimer(TimerWheel::INVALID_TIMER) {
     }
 };
 
+// Read-only copy of an active player taken before the enemy AI step, so AI
+// jobs never touch the client table
+struct EnemyAIPlayer {
+    uint32_t playerId;
+    float x, y;
+    float velocityX, velocityY;     // Since the previous snapshot (0 on the first)
+    float health;
+    float maxHealth;
+};
+
+// One enemy's AI step for this tick. Side effects are applied serially in
+// enemy ID order.
+struct EnemyAIResult {
+    uint32_t enemyId;
+    EnemyTank* enemy;
+    float elapsed;      // Time to simulate: this tick plus any deferred ticks
+    bool urgent;        // Budget scheduler: ATTACK/CHASE/RETREAT, served first
+    bool mustRun;       // Budget scheduler: deferred too long, runs even over budget
+    bool deferred;      // Budget scheduler: skipped this tick
+    bool shot;
+    bool reducedLod;    // Ticked at reduced AI rate this tick
+};
+
+// Enemy AI budget usage, reset each stats window
+struct EnemyAIBudgetStats {
+    uint64_t ticks;
+    uint64_t deferredSteps;     // Enemy steps pushed to a later tick
+    uint32_t maxDeferred;       // Most enemies deferred in one tick
+    double totalUsedUs;
+    double maxUsedUs;
+
+    EnemyAIBudgetStats() : ticks(0), deferredSteps(0), maxDeferred(0), totalUsedUs(0.0), maxUsedUs(0.0) {}
+};
+
+// What a server timer is for; its target is a player ID, or a projectile
+// slot with the bullet ID as data
+enum class ServerTimer : uint8_t {
+    CLIENT_TIMEOUT,
+    RESPAWN,
+    BULLET_EXPIRY,
+    ENEMY_SPAWN,
+    SESSION_EXPIRY
+};
+
 class GameServer {
+    friend class SyntheticWorld;    // Benchmarks drive the simulation phases directly
+
 public:
-    GameServer(unsigned short port = 53000);
+    GameServer(unsigned short port = 53000, unsigned int tickRateHz = TickScheduler::DEFAULT_TICK_RATE);
     ~GameServer();
     bool Initialize();
+    // Hosted mode: another thread owns the socket and exchanges this world's
+    // datagrams through channel (see RoomServer). Nothing is bound here.
+    bool InitializeHosted(DatagramChannel& hostChannel);
     void Update(float deltaTime);
+
+    // Fixed-timestep driving: runs every due tick at the configured rate,
+    // then blocks until the next one is due.
+    // With nobody connected the server goes idle instead: no ticks, and
+    // WaitForNextTick blocks on the socket for up to IDLE_WAIT_MS. The next
+    // datagram (normally a join) resumes ticking. Only when this thread owns
+    // the socket; hosted rooms, the network I/O thread and simulated network
+    // conditions keep ticking.
+    static constexpr int IDLE_WAIT_MS = 1000;
+    void RunScheduledTicks();
+    void WaitForNextTick();
+    bool IsIdle() const { return idle; }
+    unsigned int GetTickRate() const { return tickScheduler.GetTickRate(); }
+    // Tick number and clock readings of the tick in progress (or the last one)
+    const TickTime& GetTickTime() const { return tickClock.GetTickTime(); }
+
+    // Optional dedicated network I/O thread (must be set before Initialize)
+    void SetNetworkThreadEnabled(bool enabled) { useNetworkThread = enabled; }
+    bool IsNetworkThreadEnabled() const { return useNetworkThread; }
+
+    // Optional batched socket backend, recvmmsg/sendmmsg on Linux and Registered
+    // I/O on Windows (must be set before Initialize). Used instead of the
+    // network I/O thread when both are requested.
+    void SetBatchedSocketEnabled(bool enabled) { useBatchedSocket = enabled; }
+    bool IsBatchedSocketActive() const { return batchedSocket != nullptr; }
+
+    // Serve clients on this machine through a shared memory region named after
+    // the port instead of a socket (see shared_memory_transport.h; must be set
+    // before Initialize). Replaces the socket, so the network thread, batched
+    // socket, snapshot pipeline and network conditions are ignored.
+    void SetSharedMemoryEnabled(bool enabled) { useSharedMemory = enabled; }
+    bool IsSharedMemoryActive() const { return sharedMemory != nullptr; }
+
+    // Encodes and sends snapshots and the tick's other messages on a send
+    // thread while the next tick simulates (see SnapshotPipeline; must be set
+    // before Initialize). Needs plain socket I/O, so it is ignored with the
+    // network thread, batched socket or network conditions.
+    void SetSnapshotPipelineEnabled(bool enabled) { useSnapshotPipeline = enabled; }
+    bool IsSnapshotPipelineActive() const { return snapshotPipeline != nullptr; }
+
+    // Spreads each tick's datagrams over the tick, clients staggered and each
+    // at its bandwidth budget's rate (see SendPacer), instead of sending them
+    // all as the tick ends. The datagrams go out while the loop waits for the
+    // next tick, so this needs the simulation thread to send: it is ignored
+    // with the network thread, shared memory, the snapshot pipeline and in
+    // hosted mode.
+    void SetSendPacingEnabled(bool enabled) { useSendPacing = enabled; }
+    bool IsSendPacingActive() const { return useSendPacing && !channel && !sharedMemory && !snapshotPipeline && !replayTick; }
+
+    // Simulated latency/jitter/loss/duplication/reordering on this server's
+    // socket (must be set before Initialize). Needs the simulation thread to
+    // own the socket, so it overrides the network thread and batched socket.
+    void SetNetworkConditions(const NetworkConditions& conditions) { networkConditions = conditions; }
+
+    // Area of interest for enemy/bullet replication (half extents around each player's tank)
+    void SetInterestArea(float halfWidth, float halfHeight, float hysteresisMargin);
+    const InterestSettings& GetInterestArea() const { return interestSettings; }
+
+    // Enemies further than this many chunks from every player sleep (see world_chunks.h)
+    void SetChunkActiveRadius(int chunks) { chunkActivity.SetActiveRadius(chunks); }
+    int GetChunkActiveRadius() const { return chunkActivity.GetActiveRadius(); }
+
+    // Static obstacles of the map (see static_obstacles.h), set before
+    // Initialize. LoadMap reads a map file and keeps the current set if it fails
+    bool LoadMap(const std::string& path);
+    void SetObstacles(std::vector<StaticObstacles::Obstacle> obstacleList);
+    const StaticObstacles& GetObstacles() const { return obstacles; }
+
+    // Event bullet replication: bullets are sent once as they enter a client's view
+    // (BULLET_SPAWNED) and clients simulate their flight; the full per-client list
+    // only goes out every BULLET_CORRECTION_INTERVAL as a correction
+    void SetEventBulletReplication(bool enabled) { eventBulletReplication = enabled; }
+    bool IsEventBulletReplication() const { return eventBulletReplication; }
+
+    // Bandwidth ceiling per client in bytes per second (0: unlimited, the
+    // default). Each client's rate adapts below it to loss and round trip.
+    // State that does not fit is sent by accumulated priority (own tank and
+    // new entities always, then nearby players, health and death changes,
+    // nearby enemies); the rest keeps its last sent state until its turn.
+    // Bullet lists are held back for at most MAX_BULLET_UPDATE_HOLD_MS.
+    void SetClientBandwidth(uint32_t bytesPerSecond);
+    uint32_t GetClientBandwidth() const { return clientBandwidth; }
+
+    // Per-category replication rates. Snapshots go out at the fastest entity
+    // rate; nearby players and enemies can be sent on every one while distant
+    // ones only move on every few (staggered by entity ID so the load spreads
+    // out). Own tank and new entities always go out in full, and health,
+    // score and death changes go out on the next snapshot for any category.
+    void SetReplicationRates(const ReplicationRates& rates);
+    const ReplicationRates& GetReplicationRates() const { return replicationRates; }
+
+    // Dead reckoning (off by default): besides its replication rate, a player
+    // or enemy only has its motion sent when the client's extrapolation of it
+    // would drift past the thresholds, so tanks driving straight and enemies
+    // on patrol cost a fraction of the updates
+    void SetDeadReckoning(const DeadReckoningSettings& settings);
+    const DeadReckoningSettings& GetDeadReckoning() const { return deadReckoningSettings; }
+
+    // Messages of at least this many bytes (0 = off, the default) are sent
+    // compressed when that makes them smaller: mostly the full snapshot after
+    // a join and long bullet lists (see PacketCompressor)
+    void SetCompressionThreshold(uint32_t bytes) { compressionThreshold = bytes; }
+    uint32_t GetCompressionThreshold() const { return compressionThreshold; }
+
+    // Rooms accept joins with tokens issued by their RoomServer (see ConnectionTokens)
+    void SetConnectionTokenKey(const ConnectionTokens::Key& key) { connectionTokens.SetKey(key); }
+
+    // Runs the enemy AI step on a job system (workerCount 0: one per spare
+    // hardware thread). Results are identical to the serial step. The same
+    // workers overlap the simulation phases that touch disjoint state.
+    void SetParallelEnemyAI(bool enabled, unsigned int workerCount = 0);
+    bool IsParallelEnemyAI() const { return enemyJobs != nullptr; }
+
+    // Enemies with no target and no player within ENEMY_LOD_RANGE_FACTOR x their
+    // detection range think at reduced rate (see EnemyTank::AILodTier). On by default.
+    void SetEnemyAILodEnabled(bool enabled) { enemyAILodEnabled = enabled; }
+    bool IsEnemyAILodEnabled() const { return enemyAILodEnabled; }
+
+    // Nearby enemies form squads that decide together (see EnemySquads). Off by default.
+    void SetEnemySquadsEnabled(bool enabled) { enemySquadsEnabled = enabled; }
+    bool IsEnemySquadsEnabled() const { return enemySquadsEnabled; }
+
+    // Per-tick time budget for enemy AI in microseconds (0: unlimited). Once it
+    // is spent the remaining enemies are deferred to later ticks and catch up
+    // with the time they missed. Enemies in ATTACK/CHASE/RETREAT go first, the
+    // rest take turns round-robin; none waits longer than MAX_AI_DEFER_SECONDS.
+    void SetEnemyAIBudget(uint32_t microseconds) { enemyAIBudgetUs = microseconds; }
+    uint32_t GetEnemyAIBudget() const { return enemyAIBudgetUs; }
+
+    // Sustained tick overruns step the server down through OverloadController's
+    // levels (relaxed enemy AI, far replication, enemy cap) and back up as
+    // headroom returns. Each change is logged and published. On by default.
+    void SetOverloadControl(bool enabled) { overload.SetEnabled(enabled); }
+    uint8_t GetOverloadLevel() const { return overload.GetLevel(); }
+
+    // Player bullets are tested against enemies where the shooter saw them:
+    // rewound by the client's interpolation delay plus half its round trip,
+    // capped at MAX_LAG_COMPENSATION_MS. On by default.
+    void SetLagCompensationEnabled(bool enabled) { lagCompensationEnabled = enabled; }
+    bool IsLagCompensationEnabled() const { return lagCompensationEnabled; }
+
+    // Spectators get one shared stream, delayed by delayMs and encoded once
+    // per state tick (see SpectatorStream). At most maxSpectators subscribe
+    // directly (0 turns spectating off); larger audiences go through relays.
+    // The stream runs while the room has players.
+    void SetSpectatorStream(uint32_t delayMs, size_t maxSpectators) {
+        spectatorStream.SetDelay(delayMs);
+        spectatorStream.SetCapacity(maxSpectators);
+    }
+    size_t GetSpectatorCount() const { return spectatorStream.GetSpectatorCount(); }
+
+    // LAN fan-out (see lan_multicast.h): each state tick's shared frame goes
+    // once to group:port with no delay, and players whose client receives it
+    // get only their acks and events by unicast. Single room only; port 0
+    // (the default) turns it off. Set before Initialize
+    void SetLanMulticast(const sf::IpAddress& group, unsigned short port) {
+        lanGroup = group;
+        lanGroupPort = port;
+        lanStream.SetDelay(0);
+    }
+    bool IsLanMulticastEnabled() const { return lanGroupPort != 0; }
+
+    // While TraceRecorder is enabled, a tick longer than thresholdMs writes
+    // the trace to "<pathPrefix>-tick<N>.json", at most once per
+    // SLOW_TICK_TRACE_COOLDOWN_MS. 0 disables the dumps.
+    void SetSlowTickTrace(const std::string& pathPrefix, uint32_t thresholdMs);
     void Shutdown();
 
     // Server management
     bool IsRunning() const { return isRunning; }
     size_t GetPlayerCount() const { return clients.size(); }
 
+    // Unique key for a client endpoint (IPv4 address and port)
+    static uint64_t EndpointKey(sf::IpAddress address, unsigned short port) {
+        return (static_cast<uint64_t>(address.toInteger()) << 16) | port;
+    }
+
+    // Heap allocations made while receiving and handling messages, since startup
+    uint64_t GetReceivePathAllocations() const { return receivePathAllocations; }
+    // Heap allocations made by ticks (receive through flush), since startup.
+    // A steady world should add none; joins, leaves and growth still do.
+    uint64_t GetTickAllocations() const { return tickAllocations; }
+
+    // Periodic stats printing (on by default). When off, the owner collects the
+    // tick stats itself with TakeTickStats.
+    void SetStatsReportingEnabled(bool enabled) { statsReportingEnabled = enabled; }
+    // Returns the current tick stats window and starts a new one
+    TickStats TakeTickStats();
+
+    // Optional Prometheus-style HTTP endpoint on its own port and thread
+    // (0 = off, the default; must be set before Initialize). The page is
+    // rebuilt on the tick thread every METRICS_PUBLISH_INTERVAL.
+    void SetMetricsPort(unsigned short port) { metricsPort = port; }
+    // Join requests from new endpoints are refused once this many players are
+    // connected (defaults to NetworkValidation::MAX_PLAYER_COUNT)
+    void SetMaxPlayers(uint32_t count) { maxPlayers = count; }
+    // A client that times out is kept this long (0 = dropped at once), its
+    // tank out of the world, so a SESSION_RESUME carrying its connection token
+    // brings it back from any endpoint with its state and snapshot history
+    void SetSessionResumeGrace(float seconds) { sessionResumeGrace = std::max(0.0f, seconds); }
+    static constexpr float DEFAULT_SESSION_RESUME_GRACE = 30.0f;
+    // A client unheard from this long is sent no snapshots: none would
+    // arrive, and the baseline it acked stays in its history for a resume
+    static constexpr float SILENT_CLIENT_SECONDS = 0.5f;
+    bool IsMetricsExporterRunning() const { return metricsExporter != nullptr; }
+
+    // Reports this server's load to a directory service every
+    // Directory::REPORT_INTERVAL_MS, so the directory can send it players.
+    // advertisedAddress is what clients are told to connect to (nullopt: the
+    // address the reports arrive from). Not used when hosted by a RoomServer,
+    // which reports for all of its rooms.
+    void SetDirectory(const sf::IpAddress& address, unsigned short port,
+        std::optional<sf::IpAddress> advertisedAddress = std::nullopt);
+
+    // Sums every player's score changes for the directory's global leaderboard
+    // (see Leaderboard). SetDirectory turns it on and sends the sums every
+    // Directory::SCORE_REPORT_INTERVAL_MS; a RoomServer turns it on for its
+    // rooms and collects the sums with TakeScoreChanges instead.
+    void SetScoreReporting(bool enabled) { scoreReporting = enabled; }
+    // Appends the changes summed since the last call to out
+    void TakeScoreChanges(std::vector<Directory::ScoreChange>& out);
+
+    // The match seed every RNG stream is keyed by (random by default)
+    void SetRandomSeed(uint32_t seed);
+
+    // Records the match to path for RunReplay (see match_recording.h). Call
+    // before Initialize and after the other settings. Picks a seed unless one
+    // was set, and from now on freezes the clock once per tick. A keyframe for
+    // seeking is written every keyframeIntervalSeconds (0 = none).
+    static constexpr float DEFAULT_KEYFRAME_INTERVAL = 10.0f;
+    bool StartRecording(const std::string& path, float keyframeIntervalSeconds = DEFAULT_KEYFRAME_INTERVAL);
+    bool IsRecording() const { return recorder != nullptr; }
+
+    // Writes every datagram sent and received to path, rotating at
+    // PacketCapture::DEFAULT_FILE_BYTES (see packet_capture.h). Call before
+    // Initialize so the snapshot send thread records too.
+    bool StartCapture(const std::string& path);
+
+    // Journals enemy spawns and kills, player deaths and respawns and score
+    // changes to path as fixed-size binary records for analytics, rotating at
+    // EventJournal::DEFAULT_FILE_BYTES (see event_journal.h)
+    bool StartJournal(const std::string& path);
+
+    // Horde stress scenario: keeps this many enemies in the arena whatever the
+    // player count, topping up HORDE_SPAWNS_PER_TICK a tick regardless of the
+    // spawn interval and the overload controller's cap (0 = off, the default)
+    void SetHordeSize(uint32_t enemies) { hordeSize = enemies; }
+    // Off: the spawn interval spawns nothing, so the arena holds players only
+    // (allocation benchmarks). The horde scenario still tops up. On by default.
+    void SetEnemySpawnsEnabled(bool enabled) { enemySpawnsEnabled = enabled; }
+    static constexpr uint32_t MAX_HORDE_SIZE = 20000;
+    static constexpr uint32_t HORDE_SPAWNS_PER_TICK = 100;
+
+    // Tick cost and traffic of the run so far, for benchmarks. Only from the
+    // tick thread, or once it has stopped.
+    struct RunReport {
+        TickStats ticks;                // Since the last TakeTickStats (startup without stats reporting)
+        std::array<double, static_cast<size_t>(TickPhase::COUNT)> phaseAverageMicros{};   // Since startup
+        BandwidthStats traffic;         // Since startup
+        size_t enemies = 0;
+        size_t players = 0;             // Active
+    };
+    RunReport GetRunReport();
+    // Live objects and approximate bytes per subsystem (see MemoryReport), with
+    // the same thread rule
+    void ReportMemory(MemoryReport& report) const;
+
+    // Rebuilds a recorded match on a fresh server instead of Initialize: no
+    // sockets, ticks back to back, replies dropped, and the state hash checked
+    // after every tick. Prints the tick phase timings at the end. With
+    // seekTick, starts from the last keyframe at or before it instead of the
+    // first tick (see ReplayResult::keyframeTick).
+    bool RunReplay(const std::string& path, ReplayResult& result, uint32_t seekTick = 0);
+
+    // Hash of the simulated world: players, enemies and bullets in ID order
+    uint64_t ComputeStateHash() const;
+
+    // Checkpoints the match to path every intervalSeconds on a writer thread
+    // (see CheckpointWriter; set before Initialize). If path already holds a
+    // checkpoint, Initialize restores the match from it first: a server
+    // restarted after a crash carries on from the last checkpoint, and its
+    // players come back as suspended sessions their clients resume on their
+    // own. A clean Shutdown deletes the file. Not used while recording or
+    // replaying, whose worlds must start empty.
+    static constexpr float DEFAULT_CHECKPOINT_INTERVAL = 2.0f;
+    void SetCheckpoint(const std::string& path, float intervalSeconds = DEFAULT_CHECKPOINT_INTERVAL);
+    bool IsCheckpointing() const { return checkpointWriter.IsRunning(); }
+
+    // Hands the match over between server processes on one machine, for
+    // deploys without ending it (see handoff.h; set before Initialize).
+    // Initialize first asks a server listening at path for its match and
+    // carries it on, sessions included, so its clients only see a tick or two
+    // of delay; then it listens at path for the next server itself. The UDP
+    // socket is passed along with the batched socket on Linux, otherwise the
+    // port is bound again. One room per process, not with shared memory.
+    void SetHandoff(const std::string& path) { handoffPath = path; }
+    // True once this server has handed its match over and shut down
+    bool IsHandedOff() const { return handedOff; }
+
 private:
     sf::UdpSocket socket;
     unsigned short serverPort;
     bool isRunning;
+    bool idle;                       // No players: not ticking (see RunScheduledTicks)
+    sf::SocketSelector idleSelector; // socket, waited on while idle
+
+    // Fixed-step simulation timing
+    TickScheduler tickScheduler;
+    TickClock tickClock;             // "Now" for everything inside a tick (see GetCurrentTimestamp)
+    TickProfiler tickProfiler;       // Per-phase Update timings, printed with the stats
+    TickGraph simulationGraph;       // Update's phases from movement to deaths (see BuildSimulationGraph)
+    TimerWheel timers;               // Timeouts, respawns, bullet expiry, enemy spawns (by tick)
+    std::vector<TimerWheel::Fired> firedTimers;  // Came due this tick; each phase takes its own kinds
+    static constexpr size_t FIRED_TIMER_RESERVE = 256;
+
+    // Socket I/O offloading (null when the simulation thread owns the socket)
+    bool useNetworkThread;
+    std::unique_ptr<NetworkIOThread> networkThread;
+    DatagramChannel* channel;        // networkThread's channel, or the host's in hosted mode
+
+    bool statsReportingEnabled;
+    float statsTimer;
+
+    // Batched syscalls (null when sf::UdpSocket is used directly)
+    bool useBatchedSocket;
+    NetworkConditions networkConditions;
+    std::unique_ptr<NetworkConditioner> conditioner;    // Set when networkConditions is active
+    std::unique_ptr<BatchedUdpSocket> batchedSocket;
+
+    // Shared memory rings instead of a socket (null when a socket is used)
+    bool useSharedMemory;
+    std::unique_ptr<SharedMemoryServer> sharedMemory;
+
+    // Send thread (null when sending synchronously)
+    bool useSnapshotPipeline;
+    std::unique_ptr<SnapshotPipeline> snapshotPipeline;
+    SnapshotPipeline::Frame* sendFrame;     // Being filled this tick
+
+    // Paced sends (see SetSendPacingEnabled)
+    bool useSendPacing;
+    SendPacer sendPacer;
+    // Sends the paced datagrams that are due, or all of them
+    void ReleasePacedDatagrams(bool all);
+    uint64_t reportedPipelineFrames;
+    uint64_t reportedPipelineMicros;
+    void BeginSendFrame();
+    SnapshotPipeline::ClientJob& AddSendJob(ClientInfo& client);
+    void StageSnapshotForClient(ClientInfo& client, SnapshotPipeline::ClientJob& job, uint32_t messageSequence);
     // Enemy management
-    std::unordered_map<uint32_t, std::unique_ptr<EnemyTank>> enemies;
+    // One entity per enemy (see ServerComponents)
+    entt::registry enemyRegistry;
+    std::vector<entt::entity> deadEnemies;   // Died since the last RemoveDeadEnemies
     uint32_t nextEnemyId;
     // Client management
     std::unordered_map<uint32_t, ClientInfo> clients;
+    std::unordered_map<uint64_t, uint32_t> clientsByEndpoint;  // EndpointKey -> playerId, mirrors clients
     uint32_t nextPlayerId;
-    std::unordered_map<uint32_t, std::unique_ptr<Bullet>> bullets;  // All active bullets
+    // Hot half of each client, by slot; freed slots are reused before the array grows
+    std::vector<PlayerSimState> playerSims;
+    std::vector<uint32_t> freePlayerSlots;
+    std::array<uint32_t, static_cast<size_t>(PlayerColor::COUNT)> colorUsers{};    // Slots holding each color
+    std::vector<uint32_t> joinStatePending;     // Joined this tick, sent their first state at the tick's send
+    // Timed-out clients waiting for a resume; their slots stay reserved, out of use
+    std::unordered_map<uint32_t, ClientInfo> suspendedClients;
+    float sessionResumeGrace;
+    uint32_t resumedSessions;           // Since the last stats report
+    // Tank grid IDs of players: their slot with this bit set. The layer says
+    // which kind an entry is; the bit only keeps IDs unique for pair ordering.
+    static constexpr uint32_t PLAYER_GRID_KEY = 0x80000000u;
+
+    // Gives client a fresh simulation slot for playerId
+    void AcquirePlayerSlot(ClientInfo& client, uint32_t playerId, PlayerColor color);
+    void ReleasePlayerSlot(ClientInfo& client);
+    PlayerSimState& SimOf(const ClientInfo& client) { return playerSims[client.slot]; }
+    const PlayerSimState& SimOf(const ClientInfo& client) const { return playerSims[client.slot]; }
+    ProjectilePool projectiles;      // All active bullets (headless SoA pool)
     uint32_t nextBulletId;           // Counter for bullet IDs (starts at 10000)
     float bulletUpdateRate;          // How often to send bullet updates (0.033f = 30Hz)
     float bulletUpdateTimer;         // Timer for bullet updates
+    bool eventBulletReplication;     // Send spawns + rare corrections instead of every bullet at 30Hz
+    float bulletCorrectionTimer;
+    static constexpr float BULLET_CORRECTION_INTERVAL = 0.5f;
+
+    // Per-client replication budget (see SetClientBandwidth)
+    static constexpr float PRIORITY_DISTANCE_SCALE = 400.0f;    // Weight halves this far from the viewer
+    static constexpr float PLAYER_PRIORITY_WEIGHT = 2.0f;
+    static constexpr float ENEMY_PRIORITY_WEIGHT = 1.0f;
+    static constexpr float STATUS_PRIORITY_FACTOR = 4.0f;       // Health, score or death changed
+    static constexpr size_t SNAPSHOT_OVERHEAD_BYTES = 24;       // Headers and section counts
+    static constexpr int64_t MAX_BULLET_UPDATE_HOLD_MS = 250;
+    struct ReplicationCandidate {
+        float priority;
+        size_t bits;
+        size_t index;           // Into the client snapshot
+        size_t previousIndex;   // Into the previous snapshot sent
+        bool isPlayer;
+    };
+    uint32_t clientBandwidth;
+    std::vector<ReplicationCandidate> replicationCandidates;     // Reused per client
+    uint64_t deferredEntityUpdates;      // Since the last bandwidth report
+    uint64_t scheduledEntityHolds;
+
+    // Per-category replication rates (see SetReplicationRates)
+    enum ReplicationCategory : uint8_t {
+        NEAR_PLAYERS,
+        FAR_PLAYERS,
+        NEAR_ENEMIES,
+        FAR_ENEMIES,
+        REPLICATION_CATEGORY_COUNT
+    };
+    ReplicationRates replicationRates;
+    uint32_t replicationIntervals[REPLICATION_CATEGORY_COUNT];  // In snapshots, 1 = every one
+
+    // Dead reckoning (see SetDeadReckoning)
+    static constexpr uint32_t DEAD_RECKONING_ENEMY_KEY = 0x80000000u;
+    DeadReckoningSettings deadReckoningSettings;
+    uint64_t deadReckonedHolds;          // Since the last bandwidth report
+    uint64_t deferredBulletUpdates;
+
+    // Broadphase for bullet hits, rebuilt each tick from current positions.
+    // Enemies (ENEMY layer, entry id = enemyRegistry entity) and players
+    // (PLAYER layer, entry id = player ID); a bullet queries with its mask.
+    SpatialGrid targetGrid;
+    static constexpr size_t GRID_CELL_RESERVE = 4;   // Entries per cell reserved in the per-tick grids
+    SpawnMap spawnMap;       // Safe spawn cells around the same live tanks, rebuilt alongside
+    std::vector<const SpatialGrid::Entry*> broadphaseCandidates;  // Reused query buffer
+    CircleBatch narrowphaseCircles;                               // Live candidates of one query (SIMD test)
+    std::vector<const SpatialGrid::Entry*> narrowphaseTargets;    // Grid entry per narrowphase circle
+
+    // Lag compensation: enemy positions of recent ticks (see SetLagCompensationEnabled)
+    static constexpr int64_t MAX_LAG_COMPENSATION_MS = 250;
+    // Broadphase padding for rewound tests; the fastest enemy type moves at 150 px/s
+    static constexpr float LAG_COMPENSATION_MAX_SPEED = 200.0f;
+    static constexpr float RTT_SMOOTHING = 0.125f;
+    bool lagCompensationEnabled;
+    PositionHistory enemyPositionHistory;
+    uint64_t rewoundHitTests;            // Since the last stats report
+    int64_t rewoundHitTestMs;            // Sum of the rewind applied to those tests
+    uint32_t rewoundHits;
+
+    // Broadphase for tank separation (players and enemies share one grid)
+    SpatialGrid tankGrid;
+    std::vector<SpatialGrid::OverlapPair> tankOverlapPairs;       // Reused pair buffer
 
     // Server-side sequence numbering for outgoing messages
     uint32_t outgoingSequenceNumber;
+    BitWriter messageWriter;             // Reused body buffer for bit-packed messages
+    PacketPool sendPackets;              // Buffers for building outgoing messages
+    BulletUpdateMessage bulletUpdate;        // Reused list of every live bullet
+    BulletUpdateMessage clientBulletUpdate;  // Reused per-client bullet list
+    BulletUpdateMessage clientBulletSpawns;  // Reused per-client list of bullets entering view
+    InterestUpdateMessage interestUpdate;    // Reused enter/leave lists
+    PlayerListMessage playerTableMessage;    // Reused player table
+
+    // Delayed shared stream for spectators
+    SpectatorStream spectatorStream;
+    std::vector<BulletData> spectatorBullets;           // Reused full bullet list
+    SpectatorStream::Stats reportedSpectatorStats;      // Totals at the last stats report
+
+    // LAN multicast: the spectator frame format, undelayed, sent once to the group
+    sf::IpAddress lanGroup = sf::IpAddress::Any;
+    unsigned short lanGroupPort = 0;
+    SpectatorStream lanStream;
+    size_t groupDeliveryClients = 0;                    // At the last state tick
+    SpectatorStream::Stats reportedLanStats;
+
+    // World chunks: replicated entities by chunk, simulation activity and
+    // streamed static content
+    ChunkLists enemyChunks;                             // Over worldSnapshot.enemies, at each state tick
+    ChunkLists bulletChunks;                            // Over bulletUpdate.bullets
+    std::vector<uint32_t> nearbyBullets;                // Scratch for one client's bullet pass
+    ChunkActivity chunkActivity;
+    ChunkContentStore chunkContent;
+    ChunkDataMessage chunkMessage;                      // Reused
+    size_t sleepingEnemies = 0;                         // At the last enemy update
+    uint64_t chunksStreamed = 0;                        // Since the last stats report
+
+    // Delta snapshot replication
+    WorldSnapshot worldSnapshot;         // Updated from dirty fields before each state broadcast
+    uint32_t worldSnapshotPlayerTable;   // playerTableVersion it was last rebuilt at (joins and leaves bump it)
+    bool enemySetChanged;                // Spawn or removal since the last rebuild
+    uint64_t worldSnapshotRebuilds;      // Since the last bandwidth report
+    uint64_t dirtyEntityWrites;
+    uint64_t worldSnapshotVersion = 0;   // Bumped by every update, part of each client snapshot's contentKey
+    WorldSnapshot clientSnapshot;        // worldSnapshot filtered by one client's interest
+    SnapshotEncodeCache encodeCache;     // Bodies shared between clients (synchronous sending)
+    InterestSettings interestSettings;
+    uint64_t snapshotBytesSent;
+    uint32_t fullSnapshotsSent;
+    uint32_t deltaSnapshotsSent;
+    uint32_t sharedSnapshotBodies = 0;   // Of those, encoded once for several clients
+    uint32_t stateResyncs;              // STATE_RESYNC requests answered
+
+    // Per-client coalescing (messages queued vs datagrams actually sent)
+    uint64_t coalescedMessages;
+    uint64_t coalescedDatagrams;
+    uint32_t recoveredInputs;           // Lost inputs applied from a later PLAYER_INPUT's copies
+    uint32_t reliableResends;           // Reliable events sent again for lack of an ack
+
+    // Compression of large messages (see SetCompressionThreshold)
+    PacketCompressor compressor;
+    sf::Packet compressedMessage;       // Reused envelope
+    uint32_t compressionThreshold;
+    uint32_t compressedMessages;        // Since the last stats report
+    uint64_t compressionBytesSaved;
+
+    // Connection handshake (see ConnectionTokens)
+    ConnectionTokens connectionTokens;
+    sf::Packet challengePacket;         // Reused CONNECTION_CHALLENGE
+    uint32_t challengesSent;            // Since the last stats report
+    uint32_t tokenRejections;
+
+    // Per-client message rate limits at the socket (owned by the network I/O thread when it runs)
+    IngressRateLimiter ingressLimiter;
+    // Stateless message checks, likewise; ProcessPacket runs them on datagrams not yet validated
+    IngressValidator ingressValidator;
+    uint32_t invalidMessages = 0;       // Rejected by ProcessPacket's own check, since the last stats report
+
+    // Traffic by message type and on the wire, printed and reset with the stats
+    BandwidthStats bandwidth;
+    int64_t bandwidthWindowStart;       // ms timestamp the current window began
+    BandwidthStats bandwidthTotals;     // Every closed window, for the metrics counters
+
+    // Metrics endpoint (see SetMetricsPort)
+    static constexpr float METRICS_PUBLISH_INTERVAL = 1.0f;
+    unsigned short metricsPort;
+    std::unique_ptr<MetricsExporter> metricsExporter;
+    MetricsPage metricsPage;
+    MemoryReport memoryReport;
+    ClientTelemetryTotals clientTelemetry;  // Every CLIENT_TELEMETRY window since startup
+    float metricsTimer;
+
+    // Directory registration (see SetDirectory)
+    std::optional<sf::IpAddress> directoryAddress;
+    unsigned short directoryPort;
+    uint32_t directoryAdvertisedAddress;    // 0 = let the directory use the sender address
+    float directoryReportTimer;
+    bool scoreReporting;
+    float scoreReportTimer;
+    // Per player since the last batch; written by the tick phases (COUNTERS in the tick graph)
+    std::unordered_map<uint32_t, Directory::ScoreChange> unreportedScores;
+    std::vector<Directory::ScoreChange> scoreBatch;     // Reused by ReportScoresToDirectory
+
+    // Receive path: buffers reused across messages so steady-state traffic does not allocate
+    sf::Packet receiveBuffer;            // Socket receive target (simulation-thread I/O)
+    QueuedDatagram queuedDatagram;       // Pop target (network I/O thread)
+    int64_t packetArrivalMicros = 0;     // I/O thread's arrival stamp for the packet being handled (0 = none)
+    bool packetValidated = false;        // The packet being handled passed the receiving thread's IngressValidator
+    PlayerInputMessage receivedInput;    // Parsed PLAYER_INPUT
+    uint64_t receivePathAllocations;
+    uint64_t reportedReceiveAllocations; // Printed by PrintServerStats
+    // Whole tick, receive to flush (stats and metrics reporting excluded)
+    uint64_t tickAllocations;
+    uint64_t reportedTickAllocations;
+
+    // Slow tick trace dumps (see SetSlowTickTrace)
+    static constexpr int64_t SLOW_TICK_TRACE_COOLDOWN_MS = 10000;
+    std::string slowTickTracePrefix;
+    int64_t slowTickTraceMicros = 0;
+    int64_t lastSlowTickTraceMicros = 0;
+    void TraceTick(int64_t beginMicros);
+    uint32_t reportedTickNumber;
+
+    // Match recording and replay
+    uint32_t randomSeed;
+    bool randomSeedSet;
+    std::unique_ptr<MatchRecorder> recorder;
+    float keyframeInterval;
+    float keyframeTimer;
+    MatchCheckpoint keyframeState;          // Reused between keyframes
+    std::vector<uint8_t> keyframeBytes;
+    void RecordKeyframe();
+    std::unique_ptr<PacketCapture> capture;
+    std::unique_ptr<EventJournal> journal;
+    RecordedTick* replayTick;            // Tick being replayed: its messages stand in for the socket
+    uint32_t tickNumber;
+
+    // Crash recovery checkpoints (see SetCheckpoint)
+    // Added to the outgoing sequence and player table version on a restore,
+    // past whatever the crashed server sent after its last checkpoint
+    static constexpr uint32_t RESTORE_SEQUENCE_GAP = 1u << 20;
+    static constexpr uint32_t RESTORE_ID_GAP = 10000;      // Enemy and bullet IDs
+    std::string checkpointPath;
+    float checkpointInterval;
+    float checkpointTimer;
+    CheckpointWriter checkpointWriter;
+    CheckpointWriter::Stats reportedCheckpointStats;    // At the last stats report
+    // Restores the handed over match, or from checkpointPath if it holds a
+    // checkpoint, then starts the checkpoint writer and the handoff listener
+    void ResumeMatch();
+    // withSessions: for a handoff, with each session's connection state
+    void CaptureCheckpoint(MatchCheckpoint& out, bool withSessions = false) const;
+    void RestoreCheckpoint(const MatchCheckpoint& checkpoint, const std::string& source);
+
+    // Server handoff (see SetHandoff)
+    std::string handoffPath;
+    HandoffListener handoffListener;
+    std::unique_ptr<MatchCheckpoint> handoffState;  // Taken over in Initialize, until ResumeMatch restores it
+    int handoffSocket;              // Handed over UDP socket until the batched socket adopts it, -1 if none
+    bool handedOff;
+    // Asks the server at handoffPath for its match
+    void RequestHandoff();
+    // Hands the match to the new server that asked for it and shuts down
+    void HandOff();
 
     // Timing
     float gameStateUpdateRate;  // How often to send full game state (seconds)
     float gameStateUpdateTimer;
     float clientTimeoutDuration; // How long before disconnecting inactive clients
+    uint32_t maxPlayers;
 
-    // Available colors for players
-    std::vector<std::string> availableColors;
+    // Player table: names/colors sent on join instead of in every snapshot
+    uint32_t playerTableVersion;
+    static constexpr int64_t PLAYER_TABLE_RESEND_MS = 250;
 
     // Enemy spawning
-    float enemySpawnTimer;
+    TimerWheel::TimerId enemySpawnTimer;
+    bool enemySpawnDue;        // Interval elapsed, waiting for room under the cap
     float enemySpawnInterval;  // How often to spawn enemies (seconds)
+    uint32_t hordeSize;        // Enemy count held by the horde scenario (0 = off, see SetHordeSize)
+    bool enemySpawnsEnabled;   // See SetEnemySpawnsEnabled
     // Note: Max enemies is now calculated dynamically: 3 * (PlayerCount > 0) + PlayerCount
 
-    // Random number generation for enemy spawning
+    // Picks the match seed when none was set (see SetRandomSeed)
     std::random_device randomDevice;
-    std::mt19937 randomGenerator;
+
+    // Enemy AI step (see UpdateEnemies)
+    std::unique_ptr<JobSystem> enemyJobs;      // Null: AI runs serially on the simulation thread
+    std::vector<EnemyAIPlayer> aiPlayers;      // Snapshot for this tick, sorted by player ID
+    std::vector<EnemyAIPlayer> previousAIPlayers;  // Last tick's, for velocities
+    // playerId -> index into aiPlayers (INVALID_AI_PLAYER: not in the snapshot).
+    // Player IDs are small, so a flat table replaces searching per lookup.
+    static constexpr uint32_t INVALID_AI_PLAYER = UINT32_MAX;
+    std::vector<uint32_t> aiPlayerIndex;
+    // Broadphase over aiPlayers (entry id = index into aiPlayers). Cells are
+    // sized for detection-range queries rather than tank-sized hits.
+    static constexpr float AI_TARGET_GRID_CELL_SIZE = 200.0f;
+    SpatialGrid aiPlayerGrid;
+    // Chase navigation: one flow field per active player, rebuilt when that
+    // player enters another navigation cell
+    NavigationGrid navigationGrid;                  // Cells a tank would overlap an obstacle in are blocked
+    StaticObstacles obstacles;                      // Read by the parallel enemy AI, only set before Initialize
+    std::unordered_map<uint32_t, FlowField> playerFlowFields;
+    uint64_t flowFieldRebuilds;               // Since the last stats report
+    std::vector<EnemyAIResult> aiResults;      // One per enemy, sorted by enemy ID
+    std::vector<uint32_t> aiRunOrder;          // Indices into aiResults, the order the AI step runs them in
+    static constexpr float ENEMY_LOD_RANGE_FACTOR = 1.5f;
+    bool enemyAILodEnabled;
+    size_t reducedLodEnemies;                  // Enemies on the reduced tier last tick
+
+    // Enemy AI time budget (see SetEnemyAIBudget)
+    static constexpr float MAX_AI_DEFER_SECONDS = 0.25f;
+    uint32_t enemyAIBudgetUs;
+    uint32_t aiRoundRobinCursor;                               // Last non-urgent enemy served
+    std::unordered_map<uint32_t, float> enemyAIDeferredTime;   // enemyId -> time owed
+    EnemyAIBudgetStats aiBudgetStats;
+
+    // Load shedding (see SetOverloadControl)
+    OverloadController overload;
+
+    // Enemy squads (see UpdateEnemySquads)
+    bool enemySquadsEnabled;
+    EnemySquads enemySquads;
+    std::vector<EnemySquads::Enemy> squadEnemies;   // Scratch for regrouping
+    uint8_t recordedOverloadLevel;             // Last level written to the recording
+    void UpdateOverloadLevel();
+    void ApplyOverloadLevel();
 
     // Enemy management methods
+    void BuildSimulationGraph();
     void UpdateEnemies(float deltaTime);
+    void TakeEnemyAIPlayerSnapshot(float deltaTime);
+    void RefreshPlayerFlowFields();
+    void ScheduleEnemyAI();
+    void GroupEnemyAIByState();
+    void UpdateEnemySquads();
+    void RecordEnemyAIBudget(double usedUs);
+    void UpdateEnemyAI(EnemyAIResult& result, float deltaTime) const;
     void SpawnEnemy();
-    sf::Vector2f GetRandomSpawnPosition();
-    EnemyTank::EnemyType GetRandomEnemyType();
+    void SpawnEnemyAt(sf::Vector2f spawnPos, EnemyTank::EnemyType enemyType);
+    // Adds enemy to the registry under enemyId; @return Its entity
+    entt::entity CreateEnemy(uint32_t enemyId, std::unique_ptr<EnemyTank> enemy);
+    // Every random draw of the simulation comes from one of these streams
+    RandomStream RandomFor(RandomPurpose purpose, uint32_t entityId) const {
+        return RandomStream(randomSeed, purpose, entityId, tickNumber);
+    }
+    sf::Vector2f GetRandomSpawnPosition(RandomStream& random);
+    EnemyTank::EnemyType GetRandomEnemyType(RandomStream& random);
     void RemoveDeadEnemies();
+    void SyncEnemyComponents();
+    void MarkEnemyDirty(entt::entity entity, uint8_t fields);
+    size_t GetEnemyCount() { return enemyRegistry.storage<ServerComponents::NetworkId>().size(); }
 
 
     // Network Handling
     void ProcessIncomingMessages();
+    void ProcessQueuedMessages();
+    void ProcessBatchedMessages();
+    void ProcessSharedMemoryMessages();
+    sf::Socket::Status SendPacket(sf::Packet& packet, sf::IpAddress address, unsigned short port);
+    void QueueForClient(ClientInfo& client, const sf::Packet& packet);
+    void QueueReliableForClient(ClientInfo& client, const sf::Packet& packet);
+    void FlushOutgoing();
     void ProcessPacket(sf::Packet& packet, sf::IpAddress clientIP, unsigned short clientPort);
-    void HandleJoinRequest(const JoinMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);
+    // Checks the token in front of a datagram and answers connection requests
+    // @param sender Client at this endpoint, nullptr if none
+    // @return True if the datagram should be parsed
+    bool AcceptConnectionToken(const sf::Packet& packet, sf::IpAddress clientIP, unsigned short clientPort,
+        const ClientInfo* sender);
+    void HandleJoinRequest(const JoinMessage& msg, uint64_t connectionToken, sf::IpAddress clientIP, unsigned short clientPort);
+    void HandleSpectateRequest(uint64_t connectionToken, sf::IpAddress clientIP, unsigned short clientPort);
+    void HandleSessionResume(const SessionResumeMessage& msg, uint64_t connectionToken, sf::IpAddress clientIP,
+        unsigned short clientPort);
+    // Keeps a timed-out client in suspendedClients, or frees it when sessions are not resumable
+    void SuspendSession(uint32_t playerId, ClientInfo& client);
+    void PublishSpectatorFrame();
+    void CollectBullets(std::vector<BulletData>& out) const;
+    void OfferLanMulticast(ClientInfo& client);
+    void HandleMulticastStatus(const MulticastStatusMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);
+    void HandleStateResync(const StateResyncMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);
+    void HandleClientTelemetry(const ClientTelemetryMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);
+    void PublishLanFrame();
     void HandlePlayerUpdate(const PlayerUpdateMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);
     void HandlePlayerInput(const PlayerInputMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);  // Step 1.3
+    void HandleReliableAck(const ReliableAckMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);
     void SendGameStateToAll();
     void SendGameStateToClient(uint32_t playerId);
-    void RemoveInactiveClients(float deltaTime);
-    void BroadcastPlayerLeft(uint32_t playerId);
-    void SendPlayerIdAssignment(uint32_t playerId, sf::IpAddress clientIP, unsigned short clientPort);
+    void SendJoinStates();
+    void ResetClientReplication(ClientInfo& client);
+    void SendFullState(ClientInfo& client, uint32_t playerId);
+    void UpdateWorldSnapshot();
+    void RebuildWorldSnapshot();
+    void SendSnapshotToClient(ClientInfo& client, WorldSnapshot& world, uint32_t messageSequence);
+    void BuildClientSnapshot(ClientInfo& client, const WorldSnapshot& world, WorldSnapshot& out);
+    void SendInterestUpdate(ClientInfo& client, const InterestSet& interest);
+    void UpdateClientBudgets(float deltaTime);
+    void ApplyReplicationSchedule(ClientInfo& client, WorldSnapshot& snapshot);
+    void ApplyDeadReckoning(ClientInfo& client, WorldSnapshot& snapshot);
+    void RecordDeadReckoning(ClientInfo& client, const WorldSnapshot& sent, int64_t timestamp);
+    bool IsDeadReckoned(const ClientInfo::DeadReckonedEntity& model, const EntitySnapshot& actual) const;
+    void ApplyReplicationBudget(ClientInfo& client, WorldSnapshot& snapshot);
+    bool IsInClientInterest(const ClientInfo& client, sf::Vector2f position) const;
+    void GatherNearby(const ChunkLists& lists, const ClientInfo& client, std::vector<uint32_t>& outIndices) const;
+    void RefreshChunkActivity();
+    void IndexEnemyChunks();
+    void StreamChunks(ClientInfo& client);
+    void RemoveInactiveClients();
+    void DropClient(uint32_t playerId);
+    void ScheduleClientTimeout(uint32_t playerId, ClientInfo& client);
+
+    // Timers
+    void ResetTimers();
+    void AdvanceTimers();
+    uint64_t SecondsToTicks(float seconds) const;
+    // Due on the tick in which the delay runs out, counting the current tick
+    // as the first (as the per-tick countdowns did). Shorter than one tick:
+    // fires this tick and returns INVALID_TIMER.
+    TimerWheel::TimerId ScheduleAfter(float seconds, ServerTimer kind, uint32_t target, uint32_t data = 0);
+    uint32_t SpawnProjectile(uint32_t bulletId, uint8_t bulletType, sf::Vector2f position,
+        sf::Vector2f direction, uint32_t ownerId, CollisionLayers::Mask layer, float flownSeconds = 0.0f);
+    void ExpireProjectiles();
+    // First message of the join reply; SendJoinStates (or a resume's
+    // SendGameStateToClient) queues the rest behind it in the same tick;
+    // clientSendMicros is echoed as the clock sample
+    void SendJoinAccept(ClientInfo& client, uint32_t playerId, int64_t clientSendMicros);
+    void FillPlayerTableMessage();
+    void SendPlayerTable(ClientInfo& client);
+    void SendPlayerTableUpdates();
 
     // Server-side movement simulation
     void SimulatePlayerMovement(float deltaTime);
     void CheckServerSideCollisions(float deltaTime);  // NEW: Authoritative collision checking
+    void SeparatePlayerFromEnemy(PlayerSimState& sim, sf::Vector2f enemyPos, float deltaTime);
+    void SeparatePlayers(PlayerSimState& sim1, PlayerSimState& sim2, float deltaTime);
 
     // Ping/Pong handling
     void HandlePing(const PingMessage& msg, sf::IpAddress clientIP, unsigned short clientPort);
@@ -122,13 +1018,27 @@ private:
     std::string SocketStatusToString(sf::Socket::Status status) const;
 
     // Helper methods
-    uint32_t FindPlayerByAddress(sf::IpAddress address, unsigned short port);
-    std::string AssignColor();
+    uint32_t FindPlayerByAddress(sf::IpAddress address, unsigned short port) const;
+    PlayerColor AssignColor();
     void PrintServerStats();
+    void PrintTickPhaseStats();
+    void PrintBandwidthStats();
+    void CloseBandwidthWindow();
+    void StartMetricsExporter();
+    bool CanIdle() const {
+        return channel == nullptr && conditioner == nullptr && replayTick == nullptr && sharedMemory == nullptr;
+    }
+    void PublishMetrics();
+    void ReportToDirectory();
+    void ReportScoresToDirectory();
+    void RecordScoreChange(uint32_t playerId, const ClientInfo& client, int32_t change);
     void DetectAndReportPacketLoss();
+    // Loss over the client's sequence window, once the window has filled
+    static bool GetPacketLoss(const ClientInfo& client, float& lossPercentage);
 
     // Input acknowledgment
-    void SendInputAcknowledgment(uint32_t playerId, uint32_t acknowledgedSeq,
+    // Echoes the input's send time with this server's receive and transmit times
+    void SendInputAcknowledgment(uint32_t playerId, uint32_t acknowledgedSeq, int64_t echoSendMicros,
         sf::IpAddress clientIP, unsigned short clientPort);
     
     // Bullet Mechanics 
@@ -137,23 +1047,34 @@ private:
     void SendBulletUpdates();
     void BroadcastBulletDestruction(uint32_t bulletId, uint8_t reason, uint32_t hitTargetId, sf::Vector2f hitPos);
     void CheckBulletCollisions();
+    void ApplyBulletHitToEnemy(uint32_t slot, entt::entity entity, sf::Vector2f hitPos);
+    void ApplyBulletHitToPlayer(uint32_t slot, uint32_t playerId, sf::Vector2f hitPos);
+    void RebuildTargetGrids();
+    void RecordEnemyPositionHistory(int64_t nowMs);
+    int64_t GetLagCompensationRewindMs(uint32_t ownerId) const;
+    void RecordRttSample(ClientInfo& client, uint32_t ackedSnapshot);
     void RemoveDeadBullets();
-    BulletData BulletToBulletData(const Bullet& bullet, uint32_t bulletId) const;
-    bool ValidateBulletSpawnRequest(const BulletSpawnMessage& msg, uint32_t playerId) const;
+    BulletData BulletToBulletData(uint32_t slot) const;
     //Enemy Targeting AI
-    uint32_t SelectTargetForEnemy(EnemyTank* enemy);
-    void UpdateEnemyTargetPosition(EnemyTank* enemy);
+    uint32_t SelectTargetForEnemy(const EnemyTank& enemy) const;
+    bool IsAnyPlayerWithin(sf::Vector2f position, float range) const;
+    void UpdateEnemyTargetPosition(EnemyTank& enemy) const;
+    const EnemyAIPlayer* FindAIPlayer(uint32_t playerId) const;
     void SpawnEnemyBullet(uint32_t enemyId, EnemyTank* enemy);
     void BroadcastEnemyBulletSpawn(uint32_t bulletId, sf::Vector2f position, sf::Vector2f direction, uint32_t ownerId);
+    // Tick start time in ms while ticking (one clock read per tick), live clock otherwise
     uint64_t GetCurrentTimestamp() const;
     void DiagnoseEnemyShooting(uint32_t enemyId, EnemyTank* enemy);
 
     // Death and respawn system
     void CheckPlayerDeaths();
     void HandlePlayerDeath(uint32_t playerId, uint32_t killerId);
+    // Queues the event on the journal, if one is open (see StartJournal)
+    void JournalEvent(EventJournal::EventType type, uint32_t subjectId, uint32_t otherId, int32_t value,
+        sf::Vector2f position, uint8_t detail = 0);
     void RespawnPlayer(uint32_t playerId);
-    void UpdateDeadPlayers(float deltaTime);
+    void UpdateDeadPlayers();
     void BroadcastPlayerDeath(uint32_t playerId, uint32_t killerId, sf::Vector2f deathPos, int32_t scorePenalty);
     void BroadcastPlayerRespawn(uint32_t playerId, sf::Vector2f spawnPos, float health);
-    sf::Vector2f GetRandomRespawnPosition();
+    sf::Vector2f GetRandomRespawnPosition(uint32_t playerId);
 };
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "handoff.h"
+#include "utils.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char REQUEST_MARKER[4] = { 'T', 'G', 'H', 'R' };
+    constexpr char REPLY_MARKER[4] = { 'T', 'G', 'H', 'O' };
+    constexpr size_t REPLY_HEADER_BYTES = 8;
+
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+    constexpr int SEND_FLAGS = MSG_NOSIGNAL;    // A vanished peer is an error, not SIGPIPE
+#else
+    constexpr int SEND_FLAGS = 0;
+#endif
+
+    using Clock = std::chrono::steady_clock;
+
+    bool MakeAddress(const std::string& path, sockaddr_un& address) {
+        std::memset(&address, 0, sizeof(address));
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        return true;
+    }
+
+    bool SetNonBlocking(int handle) {
+        const int flags = ::fcntl(handle, F_GETFL, 0);
+        return flags >= 0 && ::fcntl(handle, F_SETFL, flags | O_NONBLOCK) >= 0;
+    }
+
+    // @return False once the deadline passes without the events
+    bool WaitFor(int handle, short events, Clock::time_point deadline) {
+        while (true) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0) {
+                return false;
+            }
+            pollfd entry{ handle, events, 0 };
+            const int ready = ::poll(&entry, 1, static_cast<int>(left));
+            if (ready > 0) {
+                return true;
+            }
+            if (ready < 0 && errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    bool SendAll(int handle, const void* data, size_t size, Clock::time_point deadline) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            const ssize_t sent = ::send(handle, bytes, size, SEND_FLAGS);
+            if (sent > 0) {
+                bytes += sent;
+                size -= static_cast<size_t>(sent);
+            }
+            else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                if (!WaitFor(handle, POLLOUT, deadline)) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReceiveAll(int handle, void* data, size_t size, Clock::time_point deadline) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            const ssize_t received = ::recv(handle, bytes, size, 0);
+            if (received > 0) {
+                bytes += received;
+                size -= static_cast<size_t>(received);
+            }
+            else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                if (!WaitFor(handle, POLLIN, deadline)) {
+                    return false;
+                }
+            }
+            else {
+                return false;   // Closed early
+            }
+        }
+        return true;
+    }
+
+    // The descriptor rides on the header's first byte, so the header is
+    // read with recvmsg; the rest of it may trail in later reads
+    bool ReceiveHeader(int handle, uint8_t (&header)[REPLY_HEADER_BYTES], int& socketHandle, Clock::time_point deadline) {
+        union {
+            cmsghdr align;
+            char buffer[CMSG_SPACE(sizeof(int))];
+        } control;
+        iovec vector{ header, REPLY_HEADER_BYTES };
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+
+        ssize_t received = -1;
+        while (received < 0) {
+            if (!WaitFor(handle, POLLIN, deadline)) {
+                return false;
+            }
+            received = ::recvmsg(handle, &message, 0);
+            if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return false;
+            }
+        }
+        for (cmsghdr* entry = CMSG_FIRSTHDR(&message); entry != nullptr; entry = CMSG_NXTHDR(&message, entry)) {
+            if (entry->cmsg_level == SOL_SOCKET && entry->cmsg_type == SCM_RIGHTS) {
+                std::memcpy(&socketHandle, CMSG_DATA(entry), sizeof(int));
+            }
+        }
+        return received > 0 && ReceiveAll(handle, header + received, REPLY_HEADER_BYTES - received, deadline);
+    }
+#endif
+}
+
+#ifndef _WIN32
+
+namespace Handoff {
+    bool IsSupported() {
+        return true;
+    }
+
+    /**
+     * No server at path is the normal case of a first start and fails
+     * quietly. Once connected, the old server answers as its tick ends.
+     */
+    bool Request(const std::string& path, int timeoutMs, std::vector<uint8_t>& state, int& socketHandle) {
+        socketHandle = -1;
+        state.clear();
+        sockaddr_un address;
+        if (!MakeAddress(path, address)) {
+            Utils::printMsg("Handoff path is empty or too long: " + path, error);
+            return false;
+        }
+        const int handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (handle < 0) {
+            return false;
+        }
+        if (::connect(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || !SetNonBlocking(handle)) {
+            ::close(handle);
+            return false;
+        }
+
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        uint8_t header[REPLY_HEADER_BYTES];
+        bool complete = SendAll(handle, REQUEST_MARKER, sizeof(REQUEST_MARKER), deadline) &&
+            ReceiveHeader(handle, header, socketHandle, deadline) &&
+            std::memcmp(header, REPLY_MARKER, sizeof(REPLY_MARKER)) == 0;
+        if (complete) {
+            const uint32_t stateBytes = static_cast<uint32_t>(header[4]) | (static_cast<uint32_t>(header[5]) << 8) |
+                (static_cast<uint32_t>(header[6]) << 16) | (static_cast<uint32_t>(header[7]) << 24);
+            complete = stateBytes <= MAX_STATE_BYTES;
+            if (complete) {
+                state.resize(stateBytes);
+                complete = ReceiveAll(handle, state.data(), state.size(), deadline);
+            }
+        }
+        ::close(handle);
+
+        if (!complete) {
+            Utils::printMsg("Handoff from the server at " + path + " did not complete", error);
+            if (socketHandle >= 0) {
+                ::close(socketHandle);
+                socketHandle = -1;
+            }
+            state.clear();
+        }
+        return complete;
+    }
+}
+
+bool HandoffListener::Listen(const std::string& listenPath) {
+    Close();
+    sockaddr_un address;
+    if (!MakeAddress(listenPath, address)) {
+        Utils::printMsg("Handoff path is empty or too long: " + listenPath, error);
+        return false;
+    }
+    // Replace a socket left by a server that is gone, never anything else
+    struct stat existing;
+    if (::stat(listenPath.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            Utils::printMsg("Handoff path " + listenPath + " exists and is not a socket", error);
+            return false;
+        }
+        ::unlink(listenPath.c_str());
+    }
+
+    const int handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (handle < 0 || ::bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(handle, 1) < 0 || !SetNonBlocking(handle)) {
+        Utils::printMsg("Failed to listen for handoffs at " + listenPath + ": " + std::string(std::strerror(errno)), error);
+        if (handle >= 0) {
+            ::close(handle);
+        }
+        return false;
+    }
+    listenHandle = handle;
+    path = listenPath;
+    return true;
+}
+
+void HandoffListener::Close() {
+    DropRequest();
+    if (listenHandle >= 0) {
+        ::close(listenHandle);
+        listenHandle = -1;
+        ::unlink(path.c_str());
+    }
+    path.clear();
+}
+
+/**
+ * Takes one connection at a time. It must send the request marker within
+ * REQUEST_TIMEOUT_MS, or it is dropped and the next one is taken.
+ */
+bool HandoffListener::PollRequest() {
+    if (listenHandle < 0) {
+        return false;
+    }
+    if (requestHandle >= 0 && Clock::now() > requestDeadline) {
+        DropRequest();
+    }
+    if (requestHandle < 0) {
+        requestHandle = ::accept(listenHandle, nullptr, nullptr);
+        if (requestHandle < 0) {
+            return false;
+        }
+        if (!SetNonBlocking(requestHandle)) {
+            DropRequest();
+            return false;
+        }
+        requestBytes = 0;
+        requestDeadline = Clock::now() + std::chrono::milliseconds(Handoff::REQUEST_TIMEOUT_MS);
+    }
+
+    const ssize_t received = ::recv(requestHandle, request + requestBytes, sizeof(request) - requestBytes, 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        DropRequest();
+        return false;
+    }
+    if (received > 0) {
+        requestBytes += static_cast<size_t>(received);
+    }
+    if (requestBytes < sizeof(request)) {
+        return false;
+    }
+    if (std::memcmp(request, REQUEST_MARKER, sizeof(REQUEST_MARKER)) != 0) {
+        DropRequest();
+        return false;
+    }
+    return true;
+}
+
+bool HandoffListener::SendHandoff(const std::vector<uint8_t>& state, int socketHandle) {
+    if (requestHandle < 0 || state.size() > Handoff::MAX_STATE_BYTES) {
+        return false;
+    }
+    if (listenHandle >= 0) {
+        ::close(listenHandle);
+        listenHandle = -1;
+        ::unlink(path.c_str());
+        path.clear();
+    }
+
+    uint8_t header[REPLY_HEADER_BYTES];
+    std::memcpy(header, REPLY_MARKER, sizeof(REPLY_MARKER));
+    const uint32_t stateBytes = static_cast<uint32_t>(state.size());
+    for (size_t i = 0; i < 4; ++i) {
+        header[4 + i] = static_cast<uint8_t>(stateBytes >> (8 * i));
+    }
+
+    union {
+        cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    std::memset(&control, 0, sizeof(control));
+    iovec vector{ header, sizeof(header) };
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    if (socketHandle >= 0) {
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        cmsghdr* entry = CMSG_FIRSTHDR(&message);
+        entry->cmsg_level = SOL_SOCKET;
+        entry->cmsg_type = SCM_RIGHTS;
+        entry->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(entry), &socketHandle, sizeof(int));
+    }
+
+    const auto deadline = Clock::now() + std::chrono::milliseconds(Handoff::REQUEST_TIMEOUT_MS);
+    ssize_t sent = -1;
+    while (sent < 0) {
+        if (!WaitFor(requestHandle, POLLOUT, deadline)) {
+            break;
+        }
+        sent = ::sendmsg(requestHandle, &message, SEND_FLAGS);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            break;
+        }
+    }
+    const bool complete = sent > 0 &&
+        SendAll(requestHandle, header + sent, sizeof(header) - static_cast<size_t>(sent), deadline) &&
+        SendAll(requestHandle, state.data(), state.size(), deadline);
+    if (!complete) {
+        Utils::printMsg("Failed to hand the match over: " + std::string(std::strerror(errno)), error);
+    }
+    DropRequest();
+    return complete;
+}
+
+void HandoffListener::DropRequest() {
+    if (requestHandle >= 0) {
+        ::close(requestHandle);
+        requestHandle = -1;
+    }
+    requestBytes = 0;
+}
+
+#else
+
+namespace Handoff {
+    bool IsSupported() {
+        return false;
+    }
+
+    bool Request(const std::string&, int, std::vector<uint8_t>& state, int& socketHandle) {
+        state.clear();
+        socketHandle = -1;
+        return false;
+    }
+}
+
+bool HandoffListener::Listen(const std::string&) {
+    Utils::printMsg("Server handoff needs Unix domain sockets and is not available on Windows", warning);
+    return false;
+}
+
+void HandoffListener::Close() {
+}
+
+bool HandoffListener::PollRequest() {
+    return false;
+}
+
+bool HandoffListener::SendHandoff(const std::vector<uint8_t>&, int) {
+    return false;
+}
+
+void HandoffListener::DropRequest() {
+}
+
+#endif
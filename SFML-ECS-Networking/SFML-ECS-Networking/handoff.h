@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Local control channel for handing a running match over to a new server
+// process on the same machine, so a deploy does not end it (see
+// GameServer::SetHandoff). The running server listens on a Unix domain socket
+// at a path. A new server started with the same path connects and asks for the
+// match. The running one finishes its tick, sends the match state (a
+// MatchCheckpoint with the sessions, see match_checkpoint.h) together with its
+// bound UDP socket, and stops. Clients keep talking to the same endpoint.
+// When it has no socket to pass (sf::UdpSocket, or not Linux), the old server
+// closes its socket before replying and the new one binds the port again.
+//
+// Wire format: the new server sends "TGHR"; the old one answers "TGHO",
+// uint32 stateBytes (little-endian) with the socket attached (SCM_RIGHTS)
+// when there is one, then the state.
+// Unix domain sockets only: IsSupported() is false on Windows.
+namespace Handoff {
+    static constexpr int REQUEST_TIMEOUT_MS = 5000;     // For the old server's whole reply
+    static constexpr uint32_t MAX_STATE_BYTES = 64u << 20;
+
+    bool IsSupported();
+
+    // Asks the server listening at path for its match
+    // @param socketHandle Set to the handed over socket, or -1 if none came with it
+    // @return False if no server listens at path or its reply was incomplete
+    bool Request(const std::string& path, int timeoutMs, std::vector<uint8_t>& state, int& socketHandle);
+}
+
+// The running server's end. Polled once per tick; everything but
+// SendHandoff's reply is non-blocking.
+class HandoffListener {
+public:
+    HandoffListener() = default;
+    ~HandoffListener() { Close(); }
+
+    HandoffListener(const HandoffListener&) = delete;
+    HandoffListener& operator=(const HandoffListener&) = delete;
+
+    // Listens at path, replacing a socket file left there by a server that is gone
+    bool Listen(const std::string& path);
+    // Stops listening and removes the path
+    void Close();
+    bool IsListening() const { return listenHandle >= 0; }
+
+    // @return True once a new server has asked for the match
+    bool PollRequest();
+    // Answers the request with state and socketHandle (-1: none) and closes
+    // the channel. The path is removed first, so the new server can listen there.
+    bool SendHandoff(const std::vector<uint8_t>& state, int socketHandle);
+
+private:
+    std::string path;
+    int listenHandle = -1;
+    int requestHandle = -1;         // Connection being checked or answered, -1 if none
+    size_t requestBytes = 0;        // Of the request marker read so far
+    char request[4] = {};
+    std::chrono::steady_clock::time_point requestDeadline;  // A connection silent past it is dropped
+
+    void DropRequest();
+};
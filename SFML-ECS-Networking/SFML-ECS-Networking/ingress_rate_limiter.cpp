@@ -0,0 +1,175 @@
+#include "ingress_rate_limiter.h"
+#include "connection_token.h"
+#include "logger.h"
+#include "network_messages.h"
+#include <algorithm>
+
+namespace {
+    // Twice what a well-behaved client sends, with bursts covering a client
+    // catching up after a long frame (prediction steps run back to back)
+    constexpr IngressRateLimiter::Limit LIMITS[] = {
+        { 8.0f, 16.0f },     // HANDSHAKE: a request and a join every 500 ms while joining
+        { 120.0f, 60.0f },   // INPUT: one per 60 Hz prediction step
+        { 20.0f, 10.0f },    // BULLET_SPAWN: well above the fastest fire rate
+        { 10.0f, 5.0f },     // PING: once a second, and LAN multicast status as often
+        { 60.0f, 30.0f },    // RELIABLE_ACK: at most one per 50 ms ack delay
+        { 10.0f, 10.0f }     // OTHER
+    };
+
+    uint64_t EndpointKey(sf::IpAddress address, unsigned short port) {
+        return (static_cast<uint64_t>(address.toInteger()) << 16) | port;
+    }
+}
+
+IngressRateLimiter::IngressRateLimiter()
+    : lastSweepMicros(0), endpointCount(0) {
+    for (auto& count : dropped) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    Reset(overflow, 0);
+}
+
+IngressRateLimiter::MessageClass IngressRateLimiter::Classify(const sf::Packet& datagram) {
+    uint64_t token = 0;
+    if (!ConnectionTokens::ReadToken(datagram, token)) {
+        return MessageClass::OTHER;
+    }
+    switch (static_cast<NetMessageType>(ConnectionTokens::PeekMessageType(datagram))) {
+    case NetMessageType::CONNECTION_REQUEST:
+    case NetMessageType::PLAYER_JOIN:
+    case NetMessageType::SPECTATE_REQUEST:
+    case NetMessageType::SESSION_RESUME:
+        return MessageClass::HANDSHAKE;
+    case NetMessageType::PLAYER_INPUT:
+    case NetMessageType::PLAYER_UPDATE:
+        return MessageClass::INPUT;
+    case NetMessageType::BULLET_SPAWN:
+        return MessageClass::BULLET_SPAWN;
+    case NetMessageType::PING:
+    case NetMessageType::MULTICAST_STATUS:
+    case NetMessageType::STATE_RESYNC:
+    case NetMessageType::CLIENT_TELEMETRY:
+        return MessageClass::PING;
+    case NetMessageType::RELIABLE_ACK:
+        return MessageClass::RELIABLE_ACK;
+    default:
+        return MessageClass::OTHER;
+    }
+}
+
+const char* IngressRateLimiter::GetClassName(MessageClass messageClass) {
+    switch (messageClass) {
+    case MessageClass::HANDSHAKE:    return "HANDSHAKE";
+    case MessageClass::INPUT:        return "INPUT";
+    case MessageClass::BULLET_SPAWN: return "BULLET_SPAWN";
+    case MessageClass::PING:         return "PING";
+    case MessageClass::RELIABLE_ACK: return "RELIABLE_ACK";
+    default:                         return "OTHER";
+    }
+}
+
+IngressRateLimiter::Limit IngressRateLimiter::GetLimit(MessageClass messageClass) {
+    return LIMITS[std::min(static_cast<size_t>(messageClass), CLASS_COUNT - 1)];
+}
+
+void IngressRateLimiter::Reset(Endpoint& endpoint, int64_t nowMicros) {
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        endpoint.tokens[i] = LIMITS[i].burst;
+    }
+    endpoint.lastRefillMicros = nowMicros;
+    endpoint.droppedSinceSweep = 0;
+}
+
+void IngressRateLimiter::Refill(Endpoint& endpoint, int64_t nowMicros) {
+    const float seconds = static_cast<float>(nowMicros - endpoint.lastRefillMicros) * 1e-6f;
+    if (seconds <= 0.0f) {
+        return;
+    }
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        endpoint.tokens[i] = std::min(endpoint.tokens[i] + LIMITS[i].perSecond * seconds, LIMITS[i].burst);
+    }
+    endpoint.lastRefillMicros = nowMicros;
+}
+
+/**
+ * One map lookup and a handful of float operations per datagram; the table
+ * is swept at most once per SWEEP_INTERVAL_MICROS.
+ */
+bool IngressRateLimiter::Admit(const sf::Packet& datagram, sf::IpAddress address, unsigned short port, int64_t nowMicros) {
+    if (nowMicros - lastSweepMicros >= SWEEP_INTERVAL_MICROS) {
+        Sweep(nowMicros);
+        lastSweepMicros = nowMicros;
+    }
+
+    Endpoint* endpoint = nullptr;
+    const uint64_t key = EndpointKey(address, port);
+    auto it = endpoints.find(key);
+    if (it != endpoints.end()) {
+        endpoint = &it->second;
+    }
+    else if (endpoints.size() < MAX_ENDPOINTS) {
+        endpoint = &endpoints[key];
+        Reset(*endpoint, nowMicros);
+        endpointCount.store(endpoints.size(), std::memory_order_relaxed);
+    }
+    else {
+        endpoint = &overflow;
+    }
+
+    Refill(*endpoint, nowMicros);
+    const size_t messageClass = static_cast<size_t>(Classify(datagram));
+    if (endpoint->tokens[messageClass] < 1.0f) {
+        dropped[messageClass].fetch_add(1, std::memory_order_relaxed);
+        endpoint->droppedSinceSweep++;
+        return false;
+    }
+    endpoint->tokens[messageClass] -= 1.0f;
+    return true;
+}
+
+void IngressRateLimiter::Sweep(int64_t nowMicros) {
+    for (auto it = endpoints.begin(); it != endpoints.end();) {
+        Endpoint& endpoint = it->second;
+        if (endpoint.droppedSinceSweep > 0) {
+            const sf::IpAddress address(static_cast<uint32_t>(it->first >> 16));
+            LOG_MSG(warning, "Rate limited " + address.toString() + ":" + std::to_string(it->first & 0xFFFF) +
+                " - Dropped " + std::to_string(endpoint.droppedSinceSweep) + " datagrams");
+            endpoint.droppedSinceSweep = 0;
+        }
+        if (nowMicros - endpoint.lastRefillMicros > IDLE_TIMEOUT_MICROS) {
+            it = endpoints.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    if (overflow.droppedSinceSweep > 0) {
+        LOG_MSG(warning, "Rate limited endpoints beyond the tracked " + std::to_string(MAX_ENDPOINTS) +
+            " - Dropped " + std::to_string(overflow.droppedSinceSweep) + " datagrams");
+        overflow.droppedSinceSweep = 0;
+    }
+    endpointCount.store(endpoints.size(), std::memory_order_relaxed);
+}
+
+uint64_t IngressRateLimiter::GetTotalDropped() const {
+    uint64_t total = 0;
+    for (const auto& count : dropped) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::string IngressRateLimiter::FormatDropped() const {
+    std::string text;
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        const uint64_t count = dropped[i].load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        if (!text.empty()) {
+            text += ", ";
+        }
+        text += std::string(GetClassName(static_cast<MessageClass>(i))) + " " + std::to_string(count);
+    }
+    return text.empty() ? "none" : text;
+}
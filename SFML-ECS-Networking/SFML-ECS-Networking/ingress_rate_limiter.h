@@ -0,0 +1,86 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Per-client token buckets for incoming messages, checked where datagrams
+// come off the socket (network I/O thread, RoomServer router, or the tick
+// thread's own receive loop) before anything is queued or parsed. Every
+// message class has its own bucket per endpoint, refilled at a steady rate up
+// to a burst, so a client flooding PLAYER_INPUT or BULLET_SPAWN loses its own
+// excess and never the rest of the server's receive budget.
+//
+// Endpoints are forgotten after IDLE_TIMEOUT_MICROS. Once MAX_ENDPOINTS are
+// tracked, new endpoints share one set of buckets, so a spread of spoofed
+// senders can't grow the table or drain anyone else's buckets.
+//
+// Admit is called from the ingress thread only; drop counters may be read
+// from any thread.
+class IngressRateLimiter {
+public:
+    enum class MessageClass : uint8_t {
+        HANDSHAKE,      // Connection requests, joins and spectate requests
+        INPUT,          // PLAYER_INPUT, PLAYER_UPDATE
+        BULLET_SPAWN,
+        PING,           // Pings and LAN multicast status
+        RELIABLE_ACK,
+        OTHER,          // Anything else, including malformed datagrams
+        COUNT
+    };
+
+    struct Limit {
+        float perSecond;
+        float burst;
+    };
+
+    static constexpr size_t MAX_ENDPOINTS = 4096;
+    static constexpr int64_t IDLE_TIMEOUT_MICROS = 30000000;
+    static constexpr int64_t SWEEP_INTERVAL_MICROS = 1000000;
+
+    IngressRateLimiter();
+
+    IngressRateLimiter(const IngressRateLimiter&) = delete;
+    IngressRateLimiter& operator=(const IngressRateLimiter&) = delete;
+
+    // @param datagram Client datagram (connection token first)
+    // @return False if the sender's bucket for this message is empty; the datagram should be dropped
+    bool Admit(const sf::Packet& datagram, sf::IpAddress address, unsigned short port, int64_t nowMicros);
+
+    static MessageClass Classify(const sf::Packet& datagram);
+    static const char* GetClassName(MessageClass messageClass);
+    static Limit GetLimit(MessageClass messageClass);
+
+    uint64_t GetDropped(MessageClass messageClass) const {
+        return dropped[static_cast<size_t>(messageClass)].load(std::memory_order_relaxed);
+    }
+    uint64_t GetTotalDropped() const;
+    size_t GetEndpointCount() const { return endpointCount.load(std::memory_order_relaxed); }
+
+    // "INPUT 120, BULLET_SPAWN 4" (classes with drops only), or "none"
+    std::string FormatDropped() const;
+
+private:
+    static constexpr size_t CLASS_COUNT = static_cast<size_t>(MessageClass::COUNT);
+
+    struct Endpoint {
+        std::array<float, CLASS_COUNT> tokens;
+        int64_t lastRefillMicros = 0;
+        uint32_t droppedSinceSweep = 0;
+    };
+
+    std::unordered_map<uint64_t, Endpoint> endpoints;   // Keyed like GameServer::EndpointKey
+    Endpoint overflow;                                   // Shared by endpoints beyond MAX_ENDPOINTS
+    int64_t lastSweepMicros;
+    std::array<std::atomic<uint64_t>, CLASS_COUNT> dropped;
+    std::atomic<size_t> endpointCount;
+
+    static void Reset(Endpoint& endpoint, int64_t nowMicros);
+    static void Refill(Endpoint& endpoint, int64_t nowMicros);
+
+    // Forgets idle endpoints and logs the ones that were throttled since the last sweep
+    void Sweep(int64_t nowMicros);
+};
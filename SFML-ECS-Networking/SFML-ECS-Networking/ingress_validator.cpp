@@ -0,0 +1,51 @@
+#include "ingress_validator.h"
+#include "network_validation.h"
+#include <cmath>
+
+namespace {
+    bool IsValidBulletSpawn(const BulletSpawnMessage& msg, int64_t nowMs) {
+        if (!NetworkValidation::IsValidPosition(msg.spawnX, msg.spawnY)) {
+            return false;
+        }
+        const float dirLength = std::sqrt(msg.directionX * msg.directionX + msg.directionY * msg.directionY);
+        if (dirLength < 0.001f || dirLength > 2.0f) {
+            return false;
+        }
+        return NetworkValidation::IsValidTimestamp(msg.timestamp, nowMs);
+    }
+}
+
+/**
+ * Decodes the copy the way GameServer::ProcessPacket decodes the datagram:
+ * PLAYER_INPUT from the bit-packed body, everything else through the
+ * client-to-server dispatch table.
+ */
+bool IngressValidator::Check(const sf::Packet& datagram, int64_t nowMs) {
+    scratch.clear();
+    scratch.append(datagram.getData(), datagram.getDataSize());
+    uint64_t token = 0;
+    uint8_t messageType = 0;
+    if (!(scratch >> token >> messageType)) {
+        return false;
+    }
+
+    if (static_cast<NetMessageType>(messageType) == NetMessageType::PLAYER_INPUT) {
+        BitReader reader = BitReader::FromPacket(scratch);
+        return NetworkUtils::Read(reader, input, nowMs) && NetworkValidation::IsValidPlayerId(input.playerId);
+    }
+
+    bool valid = true;
+    const MessageSchema::DispatchResult result = MessageSchema::Dispatch<ClientToServerMessages>(
+        messageType, scratch, MessageSchema::Overloaded{
+            [&](const JoinMessage& msg) { valid = NetworkValidation::IsValidPlayerName(msg.playerName); },
+            [&](const PlayerUpdateMessage& msg) {
+                valid = NetworkValidation::IsValidPlayerId(msg.playerId) &&
+                    NetworkValidation::IsValidPosition(msg.x, msg.y) &&
+                    NetworkValidation::IsValidRotation(msg.bodyRotation) &&
+                    NetworkValidation::IsValidRotation(msg.barrelRotation);
+            },
+            [&](const BulletSpawnMessage& msg) { valid = IsValidBulletSpawn(msg, nowMs); },
+            [](const auto&) {}
+        });
+    return result != MessageSchema::DispatchResult::MALFORMED && valid;
+}
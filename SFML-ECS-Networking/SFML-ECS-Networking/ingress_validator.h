@@ -0,0 +1,29 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include "network_messages.h"
+
+// The checks on client messages that need no server state: the message must
+// decode, and player IDs, positions, rotations, name lengths and bullet
+// spawns must be in range. Run where datagrams come off the socket (network
+// I/O thread, RoomServer router or shards), so malformed and out-of-range
+// messages never reach the tick; those datagrams are marked validated and
+// GameServer::ProcessPacket runs the same check itself on any that are not
+// (plain, batched or shared-memory receive, replays, loopback). What depends
+// on the server's state (sender owns the player ID, sequence order, tokens)
+// stays with the handlers.
+//
+// One per receiving thread: it decodes from a buffer of its own.
+class IngressValidator {
+public:
+    // @param datagram Client datagram (connection token first), left unread
+    // @param nowMs Server timestamp bullet spawns are checked against and input
+    //        timestamps are expanded around
+    // @return False if the message does not decode or a field is out of range;
+    //         types not decoded here (connection requests) pass
+    bool Check(const sf::Packet& datagram, int64_t nowMs);
+
+private:
+    sf::Packet scratch;             // Copy the message is decoded from
+    PlayerInputMessage input;       // Reused, so the redundant input list keeps its capacity
+};
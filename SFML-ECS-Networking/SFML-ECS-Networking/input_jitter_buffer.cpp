@@ -0,0 +1,114 @@
+#include "input_jitter_buffer.h"
+#include "sequence_window.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+void InputJitterBuffer::Reset() {
+    head = 0;
+    count = 0;
+    newestSequence = 0;
+    hasNewest = false;
+    playing = false;
+    lastPlayed = BufferedInput();
+    hasPlayed = false;
+    concealedRun = 0;
+    concealedBits = 0;
+    jitterMs = 0.0f;
+    lastTransitMs = 0;
+    hasTransit = false;
+    targetDepth = MIN_DEPTH;
+    stats = Stats();
+    totalStarved = 0;
+}
+
+bool InputJitterBuffer::Push(const BufferedInput& input) {
+    if (hasNewest && !SequenceWindow::IsNewer(input.sequenceNumber, newestSequence)) {
+        return false;
+    }
+    if (count == CAPACITY) {
+        DropOldest();
+        stats.trimmed++;
+    }
+    inputs[(head + count) & (CAPACITY - 1)] = input;
+    count++;
+    newestSequence = input.sequenceNumber;
+    hasNewest = true;
+    stats.maxDepth = std::max(stats.maxDepth, count);
+    return true;
+}
+
+/**
+ * Jitter is the smoothed change in transit time between consecutive
+ * datagrams (J += (|D| - J) / 16). The client's clock offset cancels out of D.
+ */
+void InputJitterBuffer::RecordArrival(int64_t sentMs, int64_t arrivalMs, float tickSeconds) {
+    const int64_t transitMs = arrivalMs - sentMs;
+    if (hasTransit) {
+        const float change = static_cast<float>(std::llabs(transitMs - lastTransitMs));
+        jitterMs += (change - jitterMs) / 16.0f;
+    }
+    lastTransitMs = transitMs;
+    hasTransit = true;
+
+    const float tickMs = std::max(tickSeconds * 1000.0f, 1.0f);
+    const uint32_t depth = MIN_DEPTH + static_cast<uint32_t>(std::ceil(JITTER_DEPTH_SCALE * jitterMs / tickMs));
+    targetDepth = std::min(depth, MAX_DEPTH);
+}
+
+/**
+ * Inputs whose sequence a concealed tick already stood in for are dropped
+ * unplayed: the tick they belonged to has passed.
+ */
+InputJitterBuffer::Playout InputJitterBuffer::Pop(BufferedInput& input) {
+    if (!playing && count >= targetDepth) {
+        playing = true;
+    }
+    if (playing) {
+        while (hasPlayed && count > 0 && !SequenceWindow::IsNewer(inputs[head].sequenceNumber, lastPlayed.sequenceNumber)) {
+            DropOldest();
+            stats.superseded++;
+        }
+        if (count > 0) {
+            while (count > targetDepth + TRIM_SLACK) {
+                DropOldest();
+                stats.trimmed++;
+            }
+            input = inputs[head];
+            head = (head + 1) & (CAPACITY - 1);
+            count--;
+            stats.consumed++;
+            const uint32_t advance = hasPlayed ? input.sequenceNumber - lastPlayed.sequenceNumber : 1;
+            concealedBits = advance < 32 ? concealedBits << advance : 0;
+            lastPlayed = input;
+            hasPlayed = true;
+            concealedRun = 0;
+            return Playout::PLAYED;
+        }
+        if (hasPlayed && lastPlayed.step && concealedRun < MAX_CONCEALED_TICKS) {
+            concealedRun++;
+            lastPlayed.sequenceNumber++;
+            concealedBits = (concealedBits << 1) | 1u;
+            input = lastPlayed;
+            stats.concealed++;
+            return Playout::CONCEALED;
+        }
+    }
+
+    playing = false;
+    stats.starved++;
+    totalStarved++;
+    return hasPlayed && lastPlayed.step ? Playout::RELEASED : Playout::HELD;
+}
+
+InputJitterBuffer::Stats InputJitterBuffer::TakeStats() {
+    Stats taken = stats;
+    stats = Stats();
+    stats.maxDepth = count;
+    return taken;
+}
+
+void InputJitterBuffer::DropOldest() {
+    head = (head + 1) & (CAPACITY - 1);
+    count--;
+}
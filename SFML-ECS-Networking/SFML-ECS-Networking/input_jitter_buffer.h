@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// One client input step as the server applies it
+struct BufferedInput {
+    uint32_t sequenceNumber = 0;
+    bool isMoving_forward = false;
+    bool isMoving_backward = false;
+    bool isMoving_left = false;
+    bool isMoving_right = false;
+    float barrelRotation = 0.0f;
+    bool step = false;              // One of a stream of prediction steps (PlayerInputMessage::predictedStep)
+};
+
+// Per-client playout queue for input steps. The client sends one input per
+// prediction step; the server consumes exactly one per tick, so a burst after
+// network jitter is spread over the following ticks instead of landing in one.
+// The target depth follows the client's arrival jitter (RFC 3550 estimator
+// over send timestamps): playout starts once that many inputs are queued, and
+// a backlog well past it is trimmed, oldest first, to bound the added latency.
+// When the queue runs dry, a stream of prediction steps is concealed: the
+// last input is repeated for up to MAX_CONCEALED_TICKS, each repeat standing
+// in for the next sequence number (the real input, if it turns up, is then
+// dropped), so the server's timeline stays one input per tick as the
+// client's prediction assumes. The ack reports which sequences were
+// concealed (GetConcealedBits). Past the bound the tick is starved: a step
+// stream stops moving, since the client's prediction has no step for it,
+// while a sparse stream (inputs sent on change) keeps its last input held.
+// Playout then waits for the queue to refill to the target.
+class InputJitterBuffer {
+public:
+    enum class Playout : uint8_t {
+        PLAYED,         // A queued input
+        CONCEALED,      // The last input again, standing in for the next sequence
+        HELD,           // Starved; keep holding the last input (sparse stream, or none yet)
+        RELEASED        // Starved step stream; stop moving
+    };
+
+    static constexpr size_t CAPACITY = 32;              // Inputs queued at most (power of two)
+    static constexpr uint32_t MIN_DEPTH = 1;
+    static constexpr uint32_t MAX_DEPTH = 8;
+    static constexpr uint32_t TRIM_SLACK = 2;           // Backlog allowed above the target before trimming
+    static constexpr float JITTER_DEPTH_SCALE = 2.0f;   // Target covers this many jitter estimates
+    static constexpr uint32_t MAX_CONCEALED_TICKS = 4;  // Consecutive stand-ins before a step stream stops
+
+    InputJitterBuffer() { Reset(); }
+
+    void Reset();
+
+    // Queues an input newer than every input queued so far
+    // @return False if it is not newer (duplicate or reordered)
+    bool Push(const BufferedInput& input);
+
+    // Updates the jitter estimate from one input datagram's send and arrival
+    // times (ms on the server clock) and retunes the target depth
+    void RecordArrival(int64_t sentMs, int64_t arrivalMs, float tickSeconds);
+
+    // Once per tick. input is set for PLAYED and CONCEALED.
+    Playout Pop(BufferedInput& input);
+
+    // Bit i set: sequence (last played or concealed - i) was a concealed stand-in
+    uint32_t GetConcealedBits() const { return concealedBits; }
+
+    size_t GetDepth() const { return count; }
+    uint32_t GetTargetDepth() const { return targetDepth; }
+    float GetJitterMs() const { return jitterMs; }
+    uint64_t GetTotalStarved() const { return totalStarved; }
+
+    // Counters since the last TakeStats
+    struct Stats {
+        uint64_t consumed = 0;      // Ticks that applied a queued input
+        uint64_t starved = 0;       // Ticks with nothing to apply
+        uint64_t concealed = 0;     // Ticks that repeated the last input in place of a late one
+        uint64_t superseded = 0;    // Late inputs dropped, their sequence already concealed
+        uint64_t trimmed = 0;       // Inputs dropped to cut latency
+        size_t maxDepth = 0;
+    };
+    Stats TakeStats();
+
+private:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    std::array<BufferedInput, CAPACITY> inputs;
+    size_t head;                // Oldest queued input
+    size_t count;
+    uint32_t newestSequence;
+    bool hasNewest;
+    bool playing;               // False until the queue reaches the target depth
+    BufferedInput lastPlayed;   // Sequence advanced by each concealed tick
+    bool hasPlayed;
+    uint32_t concealedRun;      // Consecutive concealed ticks
+    uint32_t concealedBits;
+
+    float jitterMs;
+    int64_t lastTransitMs;
+    bool hasTransit;
+    uint32_t targetDepth;
+
+    Stats stats;
+    uint64_t totalStarved;
+
+    void DropOldest();
+};
@@ -0,0 +1,94 @@
+#include "input_latency.h"
+#include <cstdio>
+
+const char* InputLatencyTracker::GetStageName(Stage stage) {
+    switch (stage) {
+    case Stage::INPUT_TO_APPLY: return "Input to apply";
+    case Stage::APPLY_TO_RECEIVE: return "Apply to receive";
+    case Stage::INPUT_TO_RECEIVE: return "Input to receive";
+    case Stage::RECEIVE_TO_PRESENT: return "Receive to present";
+    case Stage::INPUT_TO_PRESENT: return "Input to present";
+    default: return "Unknown";
+    }
+}
+
+void InputLatencyTracker::Reset() {
+    sent.fill(SentInput{ 0, 0 });
+    newestSent = 0;
+    lastMeasured = 0;
+    pendingCount = 0;
+    ResetStats();
+}
+
+void InputLatencyTracker::ResetStats() {
+    for (LatencyHistogram& histogram : stages) {
+        histogram.Reset();
+    }
+}
+
+void InputLatencyTracker::OnInputSent(uint32_t sequence, int64_t sampleMicros) {
+    if (sequence == 0 || sequence <= newestSent) {
+        return;
+    }
+    sent[sequence & (RING_CAPACITY - 1)] = SentInput{ sequence, sampleMicros };
+    newestSent = sequence;
+}
+
+/**
+ * Only the acked sequence itself is timed: inputs the server skipped or that
+ * were acked together are not, since no snapshot says when they applied.
+ */
+void InputLatencyTracker::OnStateReceived(uint32_t ackedSequence, int64_t applyServerMicros,
+    int64_t arrivalMicros, const ClockSync& clock) {
+    if (ackedSequence == 0 || ackedSequence <= lastMeasured || ackedSequence > newestSent) {
+        return;
+    }
+    lastMeasured = ackedSequence;
+    const SentInput& input = sent[ackedSequence & (RING_CAPACITY - 1)];
+    if (input.sequence != ackedSequence) {
+        return;     // Overwritten: older than the ring
+    }
+
+    Record(Stage::INPUT_TO_RECEIVE, arrivalMicros - input.sampleMicros);
+    if (applyServerMicros != 0) {
+        Record(Stage::INPUT_TO_APPLY, applyServerMicros - clock.ToServerMicros(input.sampleMicros));
+        Record(Stage::APPLY_TO_RECEIVE, clock.ToServerMicros(arrivalMicros) - applyServerMicros);
+    }
+    if (pendingCount < MAX_PENDING_PRESENTS) {
+        pending[pendingCount++] = PendingPresent{ input.sampleMicros, arrivalMicros };
+    }
+}
+
+void InputLatencyTracker::OnFramePresented(int64_t presentMicros) {
+    for (size_t i = 0; i < pendingCount; ++i) {
+        Record(Stage::RECEIVE_TO_PRESENT, presentMicros - pending[i].arrivalMicros);
+        Record(Stage::INPUT_TO_PRESENT, presentMicros - pending[i].sampleMicros);
+    }
+    pendingCount = 0;
+}
+
+void InputLatencyTracker::MergeInto(std::array<LatencyHistogram, STAGE_COUNT>& totals) const {
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        totals[i].Merge(stages[i]);
+    }
+}
+
+std::string InputLatencyTracker::Format(const std::array<LatencyHistogram, STAGE_COUNT>& histograms) {
+    std::string text;
+    char line[128];
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const LatencyHistogram& histogram = histograms[i];
+        if (histogram.GetCount() == 0) {
+            continue;
+        }
+        std::snprintf(line, sizeof(line), "%-18s %6.1f / %6.1f / %6.1f ms (max %.1f, %llu inputs)\n",
+            GetStageName(static_cast<Stage>(i)),
+            static_cast<double>(histogram.GetPercentile(50.0)) / 1000.0,
+            static_cast<double>(histogram.GetPercentile(95.0)) / 1000.0,
+            static_cast<double>(histogram.GetPercentile(99.0)) / 1000.0,
+            static_cast<double>(histogram.GetMax()) / 1000.0,
+            static_cast<unsigned long long>(histogram.GetCount()));
+        text += line;
+    }
+    return text;
+}
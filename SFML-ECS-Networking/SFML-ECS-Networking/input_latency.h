@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "clock_sync.h"
+#include "tick_profiler.h"
+
+// End-to-end input latency on a client, split where each side can see it:
+//   input to apply:     input sampled (client) -> server tick that applied it
+//   apply to receive:   that tick -> first snapshot acking it arrives (client)
+//   receive to present: that arrival -> first frame presented after it
+// The server sends the apply tick's time with each snapshot (SnapshotHeader).
+// Client times are moved onto the server clock through ClockSync, so an offset
+// error shifts time between the first two stages but never changes their sum;
+// input to receive and input to present use the local clock alone.
+// Headless clients (bots) never present, so their last two stages stay empty.
+class InputLatencyTracker {
+public:
+    static constexpr size_t RING_CAPACITY = 256;        // Power of two; inputs older than this are not matched
+    static constexpr size_t MAX_PENDING_PRESENTS = 8;   // Acked inputs waiting for a frame
+    static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "RING_CAPACITY must be a power of two");
+
+    enum class Stage : uint8_t {
+        INPUT_TO_APPLY,
+        APPLY_TO_RECEIVE,
+        INPUT_TO_RECEIVE,
+        RECEIVE_TO_PRESENT,
+        INPUT_TO_PRESENT,
+        COUNT
+    };
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::COUNT);
+    static const char* GetStageName(Stage stage);
+
+    InputLatencyTracker() { Reset(); }
+
+    // Forgets in-flight inputs and every sample (new connection)
+    void Reset();
+    // Clears the histograms only
+    void ResetStats();
+
+    // An input left with this sequence; sampleMicros is the local steady time
+    // it was read. Resends of a sequence already seen keep the first time.
+    void OnInputSent(uint32_t sequence, int64_t sampleMicros);
+
+    // A snapshot arrived at arrivalMicros (local) saying the server applied
+    // input ackedSequence in the tick at applyServerMicros (0 = not reported).
+    // Each sequence is measured once, by the first snapshot acking it.
+    void OnStateReceived(uint32_t ackedSequence, int64_t applyServerMicros, int64_t arrivalMicros,
+        const ClockSync& clock);
+
+    // A frame showing everything received so far went to the screen
+    void OnFramePresented(int64_t presentMicros);
+
+    const LatencyHistogram& Get(Stage stage) const { return stages[static_cast<size_t>(stage)]; }
+
+    // Adds this tracker's samples to histograms (bots aggregate many clients)
+    void MergeInto(std::array<LatencyHistogram, STAGE_COUNT>& totals) const;
+
+    // One line per stage with samples: p50 / p95 / p99, max and count
+    static std::string Format(const std::array<LatencyHistogram, STAGE_COUNT>& histograms);
+    std::string Format() const { return Format(stages); }
+
+private:
+    struct SentInput {
+        uint32_t sequence;
+        int64_t sampleMicros;
+    };
+    struct PendingPresent {
+        int64_t sampleMicros;
+        int64_t arrivalMicros;
+    };
+
+    std::array<SentInput, RING_CAPACITY> sent;
+    uint32_t newestSent;
+    uint32_t lastMeasured;          // Newest sequence already measured
+    std::array<PendingPresent, MAX_PENDING_PRESENTS> pending;
+    size_t pendingCount;
+    std::array<LatencyHistogram, STAGE_COUNT> stages;
+
+    void Record(Stage stage, int64_t micros) {
+        stages[static_cast<size_t>(stage)].Record(static_cast<uint64_t>(micros > 0 ? micros : 0));
+    }
+};
@@ -0,0 +1,54 @@
+#include "interest_area.h"
+
+/**
+ * Starts a relevance pass for one viewer.
+ * @param viewerPosition Position of the client's tank
+ * @param interestSettings View rectangle and hysteresis to apply
+ */
+void InterestSet::BeginUpdate(sf::Vector2f viewerPosition, const InterestSettings& interestSettings) {
+    viewer = viewerPosition;
+    settings = interestSettings;
+    nextRelevant.clear();
+    entered.clear();
+    left.clear();
+}
+
+/**
+ * Classifies one live entity and records enter/leave transitions.
+ * @param id Entity ID (enemy or bullet)
+ * @param position Current entity position
+ * @return True if the entity should be replicated to this viewer
+ */
+bool InterestSet::Consider(uint32_t id, sf::Vector2f position) {
+    const bool wasRelevant = IsRelevant(id);
+    const float margin = wasRelevant ? settings.hysteresisMargin : 0.0f;
+    const bool isRelevant = settings.Contains(viewer, position, margin);
+
+    if (isRelevant) {
+        nextRelevant.push_back(id);
+        if (!wasRelevant) {
+            entered.push_back(id);
+        }
+    }
+    else if (wasRelevant) {
+        left.push_back(id);
+    }
+    return isRelevant;
+}
+
+/**
+ * Publishes the pass. Callers consider each entity once, so sorting is all
+ * the new set needs.
+ */
+void InterestSet::EndUpdate() {
+    std::sort(nextRelevant.begin(), nextRelevant.end());
+    relevant.swap(nextRelevant);
+    nextRelevant.clear();
+}
+
+void InterestSet::Clear() {
+    relevant.clear();
+    nextRelevant.clear();
+    entered.clear();
+    left.clear();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "world_constants.h"
+
+// View rectangle used for replication relevance, centered on the viewer's tank.
+// Entities enter at the rectangle and only leave once outside the rectangle grown
+// by hysteresisMargin, so anything hovering at the edge doesn't flicker.
+struct InterestSettings {
+    // Defaults reach the whole world from any position (no culling yet); shrink
+    // towards the client view once the world grows beyond one screen
+    static constexpr float DEFAULT_HALF_WIDTH = WorldConstants::WORLD_WIDTH;
+    static constexpr float DEFAULT_HALF_HEIGHT = WorldConstants::WORLD_HEIGHT;
+    static constexpr float DEFAULT_HYSTERESIS = WorldConstants::TANK_RADIUS * 4.0f;
+
+    float halfWidth;
+    float halfHeight;
+    float hysteresisMargin;
+
+    InterestSettings() : halfWidth(DEFAULT_HALF_WIDTH), halfHeight(DEFAULT_HALF_HEIGHT),
+        hysteresisMargin(DEFAULT_HYSTERESIS) {
+    }
+
+    // @param margin Extra reach on every side (0 = enter area, hysteresisMargin = leave area)
+    bool Contains(sf::Vector2f viewer, sf::Vector2f position, float margin = 0.0f) const {
+        const float dx = position.x - viewer.x;
+        const float dy = position.y - viewer.y;
+        return dx >= -(halfWidth + margin) && dx <= halfWidth + margin &&
+            dy >= -(halfHeight + margin) && dy <= halfHeight + margin;
+    }
+};
+
+// Set of entity IDs currently relevant to one client, rebuilt each replication pass:
+//   BeginUpdate(viewer) -> Consider(id, pos) for every live entity -> EndUpdate()
+// Entities that were relevant but are no longer considered (destroyed) are dropped
+// silently; their removal is already replicated by the snapshot or BULLET_DESTROY.
+// The sets are sorted ID lists that keep their capacity, so passes over a steady
+// world do not allocate.
+class InterestSet {
+public:
+    void BeginUpdate(sf::Vector2f viewerPosition, const InterestSettings& interestSettings);
+
+    // @return True if the entity is relevant after this pass
+    bool Consider(uint32_t id, sf::Vector2f position);
+
+    void EndUpdate();
+
+    bool IsRelevant(uint32_t id) const { return std::binary_search(relevant.begin(), relevant.end(), id); }
+    size_t GetRelevantCount() const { return relevant.size(); }
+
+    // Changes produced by the last pass
+    const std::vector<uint32_t>& GetEntered() const { return entered; }
+    const std::vector<uint32_t>& GetLeft() const { return left; }
+    bool HasChanges() const { return !entered.empty() || !left.empty(); }
+
+    void Clear();
+
+private:
+    std::vector<uint32_t> relevant;         // Sorted
+    std::vector<uint32_t> nextRelevant;     // In Consider order until EndUpdate
+    std::vector<uint32_t> entered;
+    std::vector<uint32_t> left;
+
+    sf::Vector2f viewer;
+    InterestSettings settings;
+};
@@ -0,0 +1,123 @@
+#include "job_system.h"
+#include "thread_tuning.h"
+#include "trace_recorder.h"
+#include "utils.h"
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned int workerCount)
+    : stopping(false), currentJob(nullptr), jobCount(0), jobGrain(1), batchId(0),
+    batchAllocationScope(nullptr), nextIndex(0), activeWorkers(0) {
+    if (workerCount == 0) {
+        const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    try {
+        for (unsigned int i = 0; i < workerCount; ++i) {
+            workers.emplace_back(&JobSystem::RunWorker, this);
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Job system started only " + std::to_string(workers.size()) + " workers: " +
+            std::string(e.what()), warning);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+/**
+ * Publishes the batch, helps run it on the calling thread and waits until
+ * every worker has left it, so job may safely go out of scope afterwards.
+ */
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& job) {
+    if (count == 0) return;
+    const size_t grain = std::max<size_t>(1, grainSize);
+
+    if (workers.empty() || count <= grain) {
+        job(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentJob = &job;
+        jobCount = count;
+        jobGrain = grain;
+        batchAllocationScope = AllocationCounter::GetCurrentScope();
+        nextIndex.store(0, std::memory_order_relaxed);
+        activeWorkers = workers.size();
+        batchId++;
+    }
+    workReady.notify_all();
+
+    RunChunks(job, count, grain);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this]() { return activeWorkers == 0; });
+    currentJob = nullptr;
+}
+
+void JobSystem::RunWorker() {
+    TraceRecorder::SetThreadName("Job worker");
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::WORKER);
+    uint64_t seenBatch = 0;
+    while (true) {
+        const std::function<void(size_t, size_t)>* job = nullptr;
+        size_t count = 0;
+        size_t grain = 1;
+        AllocationCounter::ScopeCounter* allocationScope = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [this, seenBatch]() { return stopping || batchId != seenBatch; });
+            if (stopping) return;
+            seenBatch = batchId;
+            job = currentJob;
+            count = jobCount;
+            grain = jobGrain;
+            allocationScope = batchAllocationScope;
+        }
+
+        {
+            AllocationCounter::Scope allocations(allocationScope);
+            TRACE_SCOPE("Run jobs", "jobs");
+            RunChunks(*job, count, grain);
+        }
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = --activeWorkers == 0;
+        }
+        if (last) {
+            workDone.notify_one();
+        }
+    }
+}
+
+void JobSystem::RunChunks(const std::function<void(size_t, size_t)>& job, size_t count, size_t grain) {
+    while (true) {
+        const size_t begin = nextIndex.fetch_add(grain, std::memory_order_relaxed);
+        if (begin >= count) return;
+        const size_t end = std::min(count, begin + grain);
+        try {
+            job(begin, end);
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in job system worker: " + std::string(e.what()), error);
+        }
+        catch (...) {
+            Utils::printMsg("Unknown exception in job system worker", error);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "allocation_counter.h"
+
+// Small fixed-size worker pool for data-parallel simulation steps.
+// ParallelFor splits [0, count) into chunks that the workers and the calling
+// thread claim until none are left, then returns. Jobs must only write state
+// owned by their own indices. Workers attribute their allocations to the
+// caller's AllocationCounter scope for the batch.
+class JobSystem {
+public:
+    // workerCount 0 uses one worker per hardware thread besides the caller
+    explicit JobSystem(unsigned int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Runs job(begin, end) over [0, count) in chunks of at most grainSize and
+    // blocks until every chunk has finished. Not reentrant.
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& job);
+
+    // Threads that run jobs, including the caller of ParallelFor
+    size_t GetThreadCount() const { return workers.size() + 1; }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    bool stopping;
+
+    // Current batch (published under mutex, chunks claimed lock-free)
+    const std::function<void(size_t, size_t)>* currentJob;
+    size_t jobCount;
+    size_t jobGrain;
+    uint64_t batchId;
+    AllocationCounter::ScopeCounter* batchAllocationScope;
+    std::atomic<size_t> nextIndex;
+    size_t activeWorkers;            // Workers still inside the current batch
+
+    void RunWorker();
+    void RunChunks(const std::function<void(size_t, size_t)>& job, size_t count, size_t grain);
+};
@@ -0,0 +1,221 @@
+#include "lan_multicast.h"
+#include "utils.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <cstring>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    constexpr uintptr_t CLOSED = static_cast<uintptr_t>(INVALID_SOCKET);
+
+    std::string LastSocketError() {
+        return "error " + std::to_string(WSAGetLastError());
+    }
+
+    void CloseSocket(uintptr_t handle) {
+        closesocket(static_cast<SOCKET>(handle));
+    }
+#else
+    constexpr int CLOSED = -1;
+
+    std::string LastSocketError() {
+        return std::strerror(errno);
+    }
+
+    void CloseSocket(int handle) {
+        ::close(handle);
+    }
+#endif
+}
+
+bool LanMulticast::IsGroupAddress(const sf::IpAddress& address) {
+    return (address.toInteger() >> 28) == 0xE;
+}
+
+bool LanMulticast::ParseGroup(const std::string& text, sf::IpAddress& group, unsigned short& port) {
+    std::string host = text;
+    unsigned short parsedPort = DEFAULT_PORT;
+    const size_t colon = text.rfind(':');
+    if (colon != std::string::npos) {
+        host = text.substr(0, colon);
+        try {
+            size_t used = 0;
+            const int value = std::stoi(text.substr(colon + 1), &used);
+            if (used != text.size() - colon - 1 || value < 1024 || value > 65535) {
+                return false;
+            }
+            parsedPort = static_cast<unsigned short>(value);
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+    const std::optional<sf::IpAddress> address = sf::IpAddress::resolve(host);
+    if (!address || !IsGroupAddress(address.value())) {
+        return false;
+    }
+    group = address.value();
+    port = parsedPort;
+    return true;
+}
+
+MulticastReceiver::MulticastReceiver()
+    : handle(CLOSED),
+#ifdef _WIN32
+    winsockStarted(false),
+#endif
+    group(sf::IpAddress::Any), port(0) {
+}
+
+MulticastReceiver::~MulticastReceiver() {
+    Leave();
+#ifdef _WIN32
+    if (winsockStarted) {
+        WSACleanup();
+    }
+#endif
+}
+
+bool MulticastReceiver::IsSupported() {
+#if defined(_WIN32) || defined(__linux__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MulticastReceiver::IsJoined() const {
+    return handle != CLOSED;
+}
+
+/**
+ * Several clients on one host (bots, a player next to the server) each bind
+ * the group port, which SO_REUSEADDR allows for multicast; every one of them
+ * gets its own copy of each datagram.
+ */
+bool MulticastReceiver::Join(const sf::IpAddress& groupAddress, unsigned short groupPort) {
+    Leave();
+#ifdef _WIN32
+    if (!winsockStarted) {
+        WSADATA winsockData;
+        if (WSAStartup(MAKEWORD(2, 2), &winsockData) != 0) {
+            Utils::printMsg("Failed to start Winsock for the multicast socket", error);
+            return false;
+        }
+        winsockStarted = true;
+    }
+    const SOCKET socketHandle = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socketHandle == INVALID_SOCKET) {
+        Utils::printMsg("Failed to create multicast socket: " + LastSocketError(), error);
+        return false;
+    }
+    handle = static_cast<uintptr_t>(socketHandle);
+    const BOOL reuse = TRUE;
+    const char* reuseValue = reinterpret_cast<const char*>(&reuse);
+#else
+    handle = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (handle < 0) {
+        Utils::printMsg("Failed to create multicast socket: " + LastSocketError(), error);
+        return false;
+    }
+    const int reuse = 1;
+    const int* reuseValue = &reuse;
+#endif
+    if (::setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reuseValue, sizeof(reuse)) < 0) {
+        Utils::printMsg("Failed to share multicast port " + std::to_string(groupPort) + ": " + LastSocketError(), warning);
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(groupPort);
+    if (::bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        Utils::printMsg("Failed to bind multicast port " + std::to_string(groupPort) + ": " + LastSocketError(), error);
+        Leave();
+        return false;
+    }
+
+    ip_mreq membership;
+    std::memset(&membership, 0, sizeof(membership));
+    membership.imr_multiaddr.s_addr = htonl(groupAddress.toInteger());
+    membership.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (::setsockopt(handle, IPPROTO_IP, IP_ADD_MEMBERSHIP, reinterpret_cast<const char*>(&membership),
+        sizeof(membership)) < 0) {
+        Utils::printMsg("Failed to join multicast group " + groupAddress.toString() + ": " + LastSocketError(), error);
+        Leave();
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    const bool madeNonBlocking = ioctlsocket(static_cast<SOCKET>(handle), FIONBIO, &nonBlocking) == 0;
+#else
+    const int flags = ::fcntl(handle, F_GETFL, 0);
+    const bool madeNonBlocking = flags >= 0 && ::fcntl(handle, F_SETFL, flags | O_NONBLOCK) >= 0;
+#endif
+    if (!madeNonBlocking) {
+        Utils::printMsg("Failed to make multicast socket non-blocking", error);
+        Leave();
+        return false;
+    }
+
+    group = groupAddress;
+    port = groupPort;
+    buffer.resize(RECEIVE_BUFFER_BYTES);
+    return true;
+}
+
+/**
+ * Closing the socket also drops the membership.
+ */
+void MulticastReceiver::Leave() {
+    if (handle != CLOSED) {
+        CloseSocket(handle);
+        handle = CLOSED;
+    }
+    group = sf::IpAddress::Any;
+    port = 0;
+}
+
+bool MulticastReceiver::Receive(sf::Packet& packet, sf::IpAddress& sender, unsigned short& senderPort) {
+    if (handle == CLOSED) {
+        return false;
+    }
+    sockaddr_in from;
+    std::memset(&from, 0, sizeof(from));
+#ifdef _WIN32
+    int fromLength = sizeof(from);
+    const int received = ::recvfrom(static_cast<SOCKET>(handle), reinterpret_cast<char*>(buffer.data()),
+        static_cast<int>(buffer.size()), 0, reinterpret_cast<sockaddr*>(&from), &fromLength);
+#else
+    socklen_t fromLength = sizeof(from);
+    const ssize_t received = ::recvfrom(handle, buffer.data(), buffer.size(), 0,
+        reinterpret_cast<sockaddr*>(&from), &fromLength);
+#endif
+    if (received <= 0) {
+        return false;
+    }
+    packet.clear();
+    packet.append(buffer.data(), static_cast<size_t>(received));
+    sender = sf::IpAddress(ntohl(from.sin_addr.s_addr));
+    senderPort = ntohs(from.sin_port);
+    return true;
+}
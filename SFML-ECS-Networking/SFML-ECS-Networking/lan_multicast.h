@@ -0,0 +1,70 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// LAN fan-out: the server sends each state tick's shared frame (world, player
+// table, bullets; see SpectatorStream) once to a multicast group instead of a
+// snapshot per client. Players keep a unicast path for what is theirs alone:
+// the input ack paired with each frame (GROUP_STATE_ACK), reliable events,
+// pongs and the join handshake.
+//
+// After a join the server names the group (MULTICAST_GROUP, reliable); the
+// client joins it and reports the newest frame it received every
+// STATUS_INTERVAL_MS (MULTICAST_STATUS). Only a client whose reports show
+// frames arriving is moved to group delivery, and one whose reports stop
+// advancing for STALL_TIMEOUT_MS goes back to unicast snapshots, so routers
+// that drop multicast, or clients without it, still play.
+//
+// sf::UdpSocket cannot join groups, so the receiving side is a native socket.
+// Sending needs nothing special: multicast leaves a plain UDP socket with a
+// TTL of 1 (the local subnet) and loops back to receivers on the same host.
+namespace LanMulticast {
+    constexpr uint32_t DEFAULT_GROUP = 0xEFFF3500;          // 239.255.53.0, organization-local scope
+    constexpr unsigned short DEFAULT_PORT = 53010;
+    constexpr int64_t STATUS_INTERVAL_MS = 1000;
+    constexpr int64_t STALL_TIMEOUT_MS = 3000;
+
+    // 224.0.0.0/4
+    bool IsGroupAddress(const sf::IpAddress& address);
+
+    // "group[:port]", port defaulting to DEFAULT_PORT; the address must be a group
+    bool ParseGroup(const std::string& text, sf::IpAddress& group, unsigned short& port);
+}
+
+class MulticastReceiver {
+public:
+    static constexpr size_t RECEIVE_BUFFER_BYTES = 65536;   // Frames are sent whole past MAX_FRAGMENTS
+
+    MulticastReceiver();
+    ~MulticastReceiver();
+
+    MulticastReceiver(const MulticastReceiver&) = delete;
+    MulticastReceiver& operator=(const MulticastReceiver&) = delete;
+
+    static bool IsSupported();
+
+    // Binds the group port (shared with other receivers on this host) and
+    // joins the group on the default interface
+    bool Join(const sf::IpAddress& group, unsigned short port);
+    void Leave();
+    bool IsJoined() const;
+    const sf::IpAddress& GetGroup() const { return group; }
+    unsigned short GetPort() const { return port; }
+
+    // Non-blocking. @return False when nothing is waiting
+    bool Receive(sf::Packet& packet, sf::IpAddress& sender, unsigned short& senderPort);
+
+private:
+#ifdef _WIN32
+    uintptr_t handle;                 // SOCKET, INVALID_SOCKET when not joined
+    bool winsockStarted;
+#else
+    int handle;                       // -1 when not joined
+#endif
+    sf::IpAddress group;
+    unsigned short port;
+    std::vector<uint8_t> buffer;
+};
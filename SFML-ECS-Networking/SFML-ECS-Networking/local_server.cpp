@@ -0,0 +1,103 @@
+#include "local_server.h"
+#include "trace_recorder.h"
+#include "utils.h"
+
+LocalServer::LocalServer() : running(false) {
+}
+
+LocalServer::~LocalServer() {
+    Stop();
+}
+
+bool LocalServer::Start(const std::function<void(GameServer&)>& configure) {
+    if (IsRunning()) {
+        return true;
+    }
+    server = std::make_unique<GameServer>(LoopbackNetwork::SERVER_PORT);
+    if (configure) {
+        configure(*server);
+    }
+    if (!server->InitializeHosted(network.GetServerChannel())) {
+        Utils::printMsg("Error: Could not start the in-process server", error);
+        server.reset();
+        return false;
+    }
+    running.store(true, std::memory_order_release);
+    try {
+        thread = std::thread(&LocalServer::Run, this);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Could not start the in-process server thread - " + std::string(e.what()), error);
+        running.store(false, std::memory_order_release);
+        server->Shutdown();
+        server.reset();
+        return false;
+    }
+    Utils::printMsg("In-process server running on the loopback network", success);
+    return true;
+}
+
+void LocalServer::Stop(GameServer::RunReport* report) {
+    running.store(false, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(inspectMutex);
+        pendingInspect = nullptr;
+    }
+    inspected.notify_all();
+    if (server) {
+        if (report != nullptr) {
+            *report = server->GetRunReport();
+        }
+        server->Shutdown();
+        server.reset();
+    }
+}
+
+void LocalServer::Inspect(const std::function<void(GameServer&)>& inspect) {
+    std::unique_lock<std::mutex> lock(inspectMutex);
+    if (!IsRunning()) {
+        return;
+    }
+    pendingInspect = &inspect;
+    inspected.wait(lock, [this] { return pendingInspect == nullptr; });
+}
+
+void LocalServer::RunPendingInspect() {
+    {
+        std::lock_guard<std::mutex> lock(inspectMutex);
+        if (pendingInspect == nullptr) {
+            return;
+        }
+        try {
+            (*pendingInspect)(*server);
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception while inspecting the in-process server: " + std::string(e.what()), error);
+        }
+        pendingInspect = nullptr;
+    }
+    inspected.notify_all();
+}
+
+/**
+ * Hosted servers never go idle, so WaitForNextTick only sleeps until the next tick is due.
+ */
+void LocalServer::Run() {
+    TraceRecorder::SetThreadName("Local server");
+    while (running.load(std::memory_order_acquire)) {
+        try {
+            server->RunScheduledTicks();
+            RunPendingInspect();
+            server->WaitForNextTick();
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in local server thread: " + std::string(e.what()), error);
+        }
+        catch (...) {
+            Utils::printMsg("Unknown exception in local server thread", error);
+        }
+    }
+}
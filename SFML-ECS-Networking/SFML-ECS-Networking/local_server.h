@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "game_server.h"
+#include "loopback_network.h"
+
+// A GameServer for this process alone: hosted on a LoopbackNetwork and ticked
+// on its own thread, so local play and bot runs need no socket. Clients join
+// with NetworkClient::SetLoopback(&GetNetwork()).
+class LocalServer {
+public:
+    LocalServer();
+    ~LocalServer();
+
+    LocalServer(const LocalServer&) = delete;
+    LocalServer& operator=(const LocalServer&) = delete;
+
+    // configure, if given, is applied to the new server before it initializes
+    bool Start(const std::function<void(GameServer&)>& configure = nullptr);
+    // Joins the tick thread, then shuts the server down from this thread;
+    // report, if given, gets the server's run report just before
+    void Stop(GameServer::RunReport* report = nullptr);
+    bool IsRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Runs inspect on the tick thread between ticks and waits for it, so it
+    // may read or adjust the server. Skipped if the server stops first.
+    void Inspect(const std::function<void(GameServer&)>& inspect);
+
+    LoopbackNetwork& GetNetwork() { return network; }
+
+private:
+    LoopbackNetwork network;
+    std::unique_ptr<GameServer> server;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    std::mutex inspectMutex;
+    std::condition_variable inspected;
+    const std::function<void(GameServer&)>* pendingInspect = nullptr;
+
+    void Run();
+    void RunPendingInspect();
+};
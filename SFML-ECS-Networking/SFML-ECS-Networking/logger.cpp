@@ -0,0 +1,267 @@
+#include "logger.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+std::atomic<int> Logger::minimumSeverity(0);
+std::atomic<bool> Logger::asyncActive(false);
+std::atomic<uint64_t> Logger::droppedCount(0);
+
+static_assert((Logger::QUEUE_CAPACITY & (Logger::QUEUE_CAPACITY - 1)) == 0,
+    "Logger::QUEUE_CAPACITY must be a power of two");
+
+namespace {
+    struct LogRecord {
+        std::chrono::system_clock::time_point time;
+        MessageType type;
+        uint32_t length;
+        char text[Logger::MAX_MESSAGE_BYTES];
+    };
+
+    // Bounded multi-producer/single-consumer queue: each cell's sequence says
+    // whose turn it is (pos: free for the producer claiming pos, pos + 1:
+    // filled for the consumer), so producers only contend on the tail counter
+    struct LogCell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    constexpr size_t QUEUE_MASK = Logger::QUEUE_CAPACITY - 1;
+    std::array<LogCell, Logger::QUEUE_CAPACITY> cells;
+    std::atomic<size_t> queueTail(0);
+    size_t queueHead = 0;                // Consumer only
+
+    constexpr size_t LOG_CATEGORY_COUNT = static_cast<size_t>(LogCategory::COUNT);
+    std::array<std::atomic<int64_t>, LOG_CATEGORY_COUNT> sampleIntervalMs = {};    // 0: default
+    std::array<std::atomic<int64_t>, LOG_CATEGORY_COUNT> nextSampleMs = {};
+    std::array<std::atomic<uint32_t>, LOG_CATEGORY_COUNT> suppressedSamples = {};
+
+    int64_t SteadyMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::mutex lifecycleMutex;           // Serializes StartAsync/StopAsync
+    std::mutex consoleMutex;             // Synchronous writers and the drain thread
+    std::thread drainThread;
+    std::atomic<bool> drainRunning(false);
+    uint64_t reportedDrops = 0;          // Drain thread only
+
+    bool TryEnqueue(const std::string& message, MessageType type) {
+        size_t position = queueTail.load(std::memory_order_relaxed);
+        LogCell* cell;
+        for (;;) {
+            cell = &cells[position & QUEUE_MASK];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (queueTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (difference < 0) {
+                return false;  // Full: the consumer has not freed this cell yet
+            }
+            else {
+                position = queueTail.load(std::memory_order_relaxed);
+            }
+        }
+
+        LogRecord& record = cell->record;
+        record.time = std::chrono::system_clock::now();
+        record.type = type;
+        record.length = static_cast<uint32_t>(std::min(message.size(), Logger::MAX_MESSAGE_BYTES));
+        std::memcpy(record.text, message.data(), record.length);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryDequeue(LogRecord& out) {
+        LogCell& cell = cells[queueHead & QUEUE_MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != queueHead + 1) {
+            return false;
+        }
+        out.time = cell.record.time;
+        out.type = cell.record.type;
+        out.length = cell.record.length;
+        std::memcpy(out.text, cell.record.text, out.length);
+        cell.sequence.store(queueHead + Logger::QUEUE_CAPACITY, std::memory_order_release);
+        queueHead++;
+        return true;
+    }
+
+    /**
+     * Writes one line in the console format printMsg has always used.
+     */
+    void WriteLine(std::ostream& out, MessageType type, std::chrono::system_clock::time_point time,
+        const char* text, size_t length) {
+        const std::time_t currentTime = std::chrono::system_clock::to_time_t(time);
+        std::tm localTime = {};
+        localtime_s(&localTime, &currentTime);
+        const auto timestamp = std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
+
+        const char* color = nullptr;
+        switch (type)
+        {
+        case debug: color = "\033[36m"; break;
+        case warning: color = "\033[33m"; break;
+        case error: color = "\033[1;31m"; break;
+        case success: color = "\033[1;32m"; break;
+        default: break;
+        }
+
+        if (color) {
+            out << color;
+        }
+        out << timestamp << "   ";
+        out.write(text, static_cast<std::streamsize>(length));
+        if (color) {
+            out << "\033[0m";
+        }
+        out << '\n';
+    }
+
+    /**
+     * Writes everything queued so far with a single flush.
+     * @return False if the queue was empty
+     */
+    bool DrainQueue() {
+        static LogRecord record;  // Drain thread (or StopAsync after it joined) only
+        bool wroteAny = false;
+        std::lock_guard<std::mutex> lock(consoleMutex);
+        while (TryDequeue(record)) {
+            WriteLine(std::cout, record.type, record.time, record.text, record.length);
+            wroteAny = true;
+        }
+
+        const uint64_t dropped = Logger::GetDroppedCount();
+        if (dropped != reportedDrops) {
+            const std::string notice = std::to_string(dropped - reportedDrops) + " log messages dropped (queue full)";
+            WriteLine(std::cout, warning, std::chrono::system_clock::now(), notice.data(), notice.size());
+            reportedDrops = dropped;
+            wroteAny = true;
+        }
+
+        if (wroteAny) {
+            std::cout.flush();
+        }
+        return wroteAny;
+    }
+
+    void DrainLoop() {
+        const auto IDLE_WAIT = std::chrono::milliseconds(2);
+        while (drainRunning.load(std::memory_order_acquire)) {
+            if (!DrainQueue()) {
+                std::this_thread::sleep_for(IDLE_WAIT);
+            }
+        }
+        DrainQueue();
+    }
+}
+
+/**
+ * Queues the message while async logging runs, otherwise writes it directly.
+ * The caller has already checked IsEnabled (printMsg and LOG_MSG do).
+ */
+void Logger::Write(const std::string& message, MessageType type) {
+    if (asyncActive.load(std::memory_order_acquire)) {
+        if (!TryEnqueue(message, type)) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(consoleMutex);
+    WriteLine(std::cout, type, std::chrono::system_clock::now(), message.data(), message.size());
+    std::cout.flush();
+}
+
+/**
+ * Lets the first caller at or after the category's next slot through and
+ * moves the slot one interval on; everyone else only bumps the suppressed
+ * count, which the caller that gets through takes over.
+ */
+bool LogSampler::ShouldLog(LogCategory category, uint32_t& suppressed) {
+    const size_t index = static_cast<size_t>(category);
+    if (index >= LOG_CATEGORY_COUNT) {
+        return false;
+    }
+
+    const int64_t now = SteadyMs();
+    int64_t next = nextSampleMs[index].load(std::memory_order_relaxed);
+    if (now < next) {
+        suppressedSamples[index].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    int64_t interval = sampleIntervalMs[index].load(std::memory_order_relaxed);
+    if (interval == 0) {
+        interval = DEFAULT_INTERVAL_MS;
+    }
+    if (!nextSampleMs[index].compare_exchange_strong(next, now + interval, std::memory_order_relaxed)) {
+        suppressedSamples[index].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressedSamples[index].exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+void LogSampler::SetInterval(LogCategory category, int64_t intervalMs) {
+    const size_t index = static_cast<size_t>(category);
+    if (index >= LOG_CATEGORY_COUNT) {
+        return;
+    }
+    sampleIntervalMs[index].store(std::max<int64_t>(intervalMs, 1), std::memory_order_relaxed);
+}
+
+std::string LogSampler::WithSuppressed(const std::string& message, uint32_t suppressed) {
+    if (suppressed == 0) {
+        return message;
+    }
+    return message + " (" + std::to_string(suppressed) + " more suppressed)";
+}
+
+void Logger::StartAsync() {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (drainRunning.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    for (size_t i = 0; i < QUEUE_CAPACITY; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    queueTail.store(0, std::memory_order_relaxed);
+    queueHead = 0;
+    reportedDrops = droppedCount.load(std::memory_order_relaxed);
+
+    drainRunning.store(true, std::memory_order_release);
+    try {
+        drainThread = std::thread(DrainLoop);
+    }
+    catch (const std::exception& e) {
+        drainRunning.store(false, std::memory_order_release);
+        Write("Failed to start log thread, logging stays synchronous: " + std::string(e.what()), warning);
+        return;
+    }
+    asyncActive.store(true, std::memory_order_release);
+}
+
+void Logger::StopAsync() {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (!drainRunning.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // New messages go straight to the console; the drain thread writes what is queued
+    asyncActive.store(false, std::memory_order_release);
+    drainRunning.store(false, std::memory_order_release);
+    if (drainThread.joinable()) {
+        drainThread.join();
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum MessageType { info, debug, warning, error, success };
+
+// Levels below this are compiled out of LOG_MSG entirely: 0 keeps everything,
+// 1 drops debug, 2 keeps warnings and errors, 3 keeps errors only
+#ifndef LOG_COMPILED_MIN_SEVERITY
+#define LOG_COMPILED_MIN_SEVERITY 0
+#endif
+
+// Logs message at type if that level is enabled. message is only evaluated
+// (strings built, numbers formatted) when it is, so disabled levels cost a
+// branch; levels under LOG_COMPILED_MIN_SEVERITY fold away at compile time.
+#define LOG_MSG(type, message)                          \
+    do {                                                \
+        if (Logger::IsEnabled(type)) {                  \
+            Logger::Write((message), (type));           \
+        }                                               \
+    } while (0)
+
+// LOG_MSG for diagnostics on per-entity or per-packet paths: at most one
+// message per interval of category gets written, with the number of events
+// skipped since the previous one appended.
+#define LOG_SAMPLED(category, type, message)                                        \
+    do {                                                                            \
+        uint32_t logSuppressed_ = 0;                                                \
+        if (Logger::IsEnabled(type) && LogSampler::ShouldLog((category), logSuppressed_)) { \
+            Logger::Write(LogSampler::WithSuppressed((message), logSuppressed_), (type)); \
+        }                                                                           \
+    } while (0)
+
+// High-frequency diagnostics, each rate limited on its own
+enum class LogCategory : uint8_t {
+    UNKNOWN_MESSAGE,        // Server: datagrams of an unknown type
+    BULLET_HIT_CHECK,       // Server: bullets tested against their targets
+    REMOTE_PLAYER_STATE,    // Client: other players' states received and applied
+    ENEMY_AIM,              // Enemy AI aiming and cooldown
+    STATE_RESYNC,           // Snapshots that failed their state hash
+    COUNT
+};
+
+// Per-category rate limiting in fixed memory (a few atomics per category), so
+// a log site that fires for every bullet or entity never grows a map or takes
+// a lock. Safe from any thread.
+class LogSampler {
+public:
+    static constexpr int64_t DEFAULT_INTERVAL_MS = 1000;
+
+    // @return True if a message in category may be written now; suppressed
+    // receives the events skipped since the last one that was
+    static bool ShouldLog(LogCategory category, uint32_t& suppressed);
+
+    // Minimum 1 ms; categories never set use DEFAULT_INTERVAL_MS
+    static void SetInterval(LogCategory category, int64_t intervalMs);
+
+    // message, plus " (N more suppressed)" when N > 0
+    static std::string WithSuppressed(const std::string& message, uint32_t suppressed);
+};
+
+// Process-wide log sink. Synchronous until StartAsync: then any thread hands
+// messages to a lock-free bounded queue and a background thread formats the
+// timestamps and writes them out, flushing once per batch. Messages that find
+// the queue full are dropped and counted rather than blocking the caller.
+class Logger {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 4096;      // Power of two
+    static constexpr size_t MAX_MESSAGE_BYTES = 496;    // Longer messages are truncated
+
+    // debug 0, info/success 1, warning 2, error 3
+    static constexpr int Severity(MessageType type) {
+        return type == debug ? 0 : type == warning ? 2 : type == error ? 3 : 1;
+    }
+
+    static bool IsEnabled(MessageType type) {
+        return Severity(type) >= LOG_COMPILED_MIN_SEVERITY &&
+            Severity(type) >= minimumSeverity.load(std::memory_order_relaxed);
+    }
+
+    // Runtime filter on top of the compiled one (default: everything)
+    static void SetMinimumLevel(MessageType type) {
+        minimumSeverity.store(Severity(type), std::memory_order_relaxed);
+    }
+
+    static void Write(const std::string& message, MessageType type);
+
+    // Console prompts should not run while async: queued lines could print
+    // after them. Stop drains the queue before returning.
+    static void StartAsync();
+    static void StopAsync();
+    static bool IsAsync() { return asyncActive.load(std::memory_order_acquire); }
+
+    // Messages lost to a full queue since startup
+    static uint64_t GetDroppedCount() { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    static std::atomic<int> minimumSeverity;
+    static std::atomic<bool> asyncActive;
+    static std::atomic<uint64_t> droppedCount;
+};
+
+// Stays async for its lifetime (the running phase of a server or client)
+class AsyncLogScope {
+public:
+    AsyncLogScope() { Logger::StartAsync(); }
+    ~AsyncLogScope() { Logger::StopAsync(); }
+
+    AsyncLogScope(const AsyncLogScope&) = delete;
+    AsyncLogScope& operator=(const AsyncLogScope&) = delete;
+};
@@ -0,0 +1,64 @@
+#include "loopback_network.h"
+#include "network_messages.h"
+#include "utils.h"
+
+LoopbackNetwork::LoopbackNetwork() : nextPort(1), unroutedCount(0) {
+}
+
+DatagramChannel* LoopbackNetwork::OpenEndpoint(unsigned short& outPort) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (endpoints.size() >= MAX_ENDPOINTS) {
+        Utils::printMsg("Loopback network full (" + std::to_string(MAX_ENDPOINTS) + " endpoints)", warning);
+        return nullptr;
+    }
+    if (nextPort == 0) {
+        nextPort = 1;
+    }
+    if (nextPort == SERVER_PORT) {
+        nextPort++;
+    }
+    if (endpoints.count(nextPort) > 0) {
+        Utils::printMsg("Loopback network ran out of endpoint ports", warning);
+        return nullptr;
+    }
+    outPort = nextPort++;
+    auto inserted = endpoints.emplace(outPort, std::make_unique<DatagramChannel>());
+    return inserted.first->second.get();
+}
+
+void LoopbackNetwork::CloseEndpoint(unsigned short port) {
+    std::lock_guard<std::mutex> lock(mutex);
+    endpoints.erase(port);
+}
+
+void LoopbackNetwork::Pump() {
+    std::lock_guard<std::mutex> lock(mutex);
+    const int64_t nowMicros = GetSteadyMicros();
+
+    for (auto& [port, channel] : endpoints) {
+        while (channel->PopOutbound(staging)) {
+            staging.address = sf::IpAddress::LocalHost;
+            staging.port = port;
+            staging.arrivalMicros = nowMicros;
+            staging.validated = false;
+            serverChannel.PushInbound(staging);
+        }
+    }
+
+    while (serverChannel.PopOutbound(staging)) {
+        auto it = endpoints.find(staging.port);
+        if (it == endpoints.end()) {
+            unroutedCount++;
+            continue;
+        }
+        staging.address = sf::IpAddress::LocalHost;
+        staging.port = SERVER_PORT;
+        staging.arrivalMicros = nowMicros;
+        it->second->PushInbound(staging);
+    }
+}
+
+uint64_t LoopbackNetwork::GetUnroutedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return unroutedCount;
+}
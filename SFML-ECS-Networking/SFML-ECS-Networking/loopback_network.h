@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "datagram_channel.h"
+
+// In-process stand-in for the UDP network between one hosted GameServer and
+// the NetworkClients of the same process (local play, bot runs without
+// sockets). Both sides keep the DatagramChannel they already use for a socket
+// owned elsewhere: the server's is the one InitializeHosted takes, and each
+// client endpoint gets its own. Pump moves datagrams between them by swapping
+// ring slots, so after QueueOutbound's copy a datagram is never copied,
+// reserialized or handed to the kernel again.
+// Clients appear to the server as LocalHost with a made-up port per endpoint,
+// and see the server as LocalHost:SERVER_PORT.
+class LoopbackNetwork {
+public:
+    static constexpr unsigned short SERVER_PORT = 53000;
+    static constexpr size_t MAX_ENDPOINTS = 256;
+
+    LoopbackNetwork();
+
+    LoopbackNetwork(const LoopbackNetwork&) = delete;
+    LoopbackNetwork& operator=(const LoopbackNetwork&) = delete;
+
+    // Pass to GameServer::InitializeHosted
+    DatagramChannel& GetServerChannel() { return serverChannel; }
+
+    // Client side. The channel stays valid until CloseEndpoint; nullptr when
+    // MAX_ENDPOINTS are open. Ports count up rather than being reused, so a
+    // new endpoint does not inherit a recent one's server-side state.
+    DatagramChannel* OpenEndpoint(unsigned short& outPort);
+    void CloseEndpoint(unsigned short port);
+
+    // Delivers everything queued in both directions, stamping arrival times.
+    // Any thread may call it; calls are serialized, which keeps each ring
+    // single-producer/single-consumer.
+    void Pump();
+
+    // Server datagrams addressed to an endpoint that is not open
+    uint64_t GetUnroutedCount() const;
+
+private:
+    DatagramChannel serverChannel;
+    mutable std::mutex mutex;
+    std::unordered_map<unsigned short, std::unique_ptr<DatagramChannel>> endpoints;
+    unsigned short nextPort;
+    QueuedDatagram staging;         // Swapped through the rings, so its buffer circulates
+    uint64_t unroutedCount;
+};
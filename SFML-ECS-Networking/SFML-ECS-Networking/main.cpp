@@ -1,13 +1,37 @@
+#ifndef HEADLESS_SERVER
 #include <SFML/Graphics.hpp>
+#endif
 #include <SFML/Network.hpp>
 #include <iostream>
 #include <string>
 #include <thread>
+#include <atomic>
 #include "game_server.h"
+#include "room_server.h"
+#ifndef HEADLESS_SERVER
 #include "multiplayer_game.h"
+#include "bot_client.h"
+#include "local_server.h"
+#include "soak_test.h"
+#include "server_probe.h"
+#include "frame_pacer.h"
+#include "AssetManager.h"
+#endif
 #include "utils.h"
+#include "benchmarks.h"
+#include "benchmark_gate.h"
+#include "server_options.h"
+#include "thread_tuning.h"
+#include "trace_recorder.h"
+#include "capture_analysis.h"
+#include "directory_service.h"
+#include "spectator_relay.h"
+#include <csignal>
+#include <cstdio>
+#include <fstream>
 #include <limits>
 #include <regex>
+#include <algorithm>
 
 /**
  * Validates port in 1024-65535 range to ensure safe, non-privileged use per IANA standards.
@@ -50,12 +74,348 @@ bool IsValidColor(const std::string& color) {
 }
 
 /**
- * Runs server: prompts port, initializes, updates in loop until stopped, handles errors.
+ * Asks for simulated network conditions applied on this endpoint's socket.
+ * @return Inactive conditions (off) when the input is empty or invalid.
+ */
+NetworkConditions PromptNetworkConditions() {
+    NetworkConditions conditions;
+    std::string input;
+    std::cout << "Simulate network conditions as latency ms,jitter ms,loss %[,duplicate %[,reorder %]] "
+        "(e.g. 150,20,5; empty = off): ";
+    std::getline(std::cin, input);
+    if (!input.empty() && !NetworkConditions::Parse(input, conditions)) {
+        Utils::printMsg("Error: Invalid network conditions (" + input + "), simulation off", error);
+    }
+    return conditions;
+}
+
+namespace {
+    // Set from SIGINT/SIGTERM; the unattended server loops poll it
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void RequestStop(int) {
+        stopRequested = 1;
+    }
+
+    void InstallStopHandlers() {
+        std::signal(SIGINT, RequestStop);
+        std::signal(SIGTERM, RequestStop);
+#ifdef SIGBREAK
+        std::signal(SIGBREAK, RequestStop);
+#endif
+    }
+
+    /**
+     * Tells an orchestrator the socket is bound: one flushed "READY <port>" line
+     * on stdout and, if asked for, a ready file. The file is written under a
+     * temporary name and renamed so a watcher never sees it half written.
+     */
+    void SignalReady(unsigned short port, const std::string& readyFile) {
+        std::cout << "READY " << port << std::endl;
+        if (readyFile.empty()) {
+            return;
+        }
+        const std::string tempFile = readyFile + ".tmp";
+        {
+            std::ofstream out(tempFile, std::ios::trunc);
+            out << port << "\n";
+            if (!out) {
+                Utils::printMsg("Error: Could not write ready file " + tempFile, error);
+                return;
+            }
+        }
+        std::remove(readyFile.c_str());
+        if (std::rename(tempFile.c_str(), readyFile.c_str()) != 0) {
+            Utils::printMsg("Error: Could not create ready file " + readyFile, error);
+        }
+    }
+
+    // Stops on Enter when interactive, otherwise on SIGINT/SIGTERM
+    class StopTrigger {
+    public:
+        explicit StopTrigger(bool interactive) : enterPressed(false) {
+            if (interactive) {
+                inputThread = std::thread([this]() {
+                    std::string input;
+                    std::getline(std::cin, input);
+                    enterPressed = true;
+                    });
+            }
+            else {
+                InstallStopHandlers();
+            }
+        }
+
+        ~StopTrigger() {
+            if (inputThread.joinable()) {
+                try {
+                    inputThread.join();
+                }
+                catch (const std::exception& e) {
+                    Utils::printMsg("Error: Exception joining input thread - " + std::string(e.what()), error);
+                }
+            }
+        }
+
+        bool IsStopRequested() const { return enterPressed || stopRequested != 0; }
+
+    private:
+        std::atomic<bool> enterPressed;
+        std::thread inputThread;
+    };
+
+    // Points a server at the directory service named in options, if any
+    template <typename Server>
+    void ApplyDirectory(Server& server, const ServerOptions& options) {
+        if (options.directory.empty()) {
+            return;
+        }
+        sf::IpAddress address = sf::IpAddress::LocalHost;
+        unsigned short port = 0;
+        if (!Directory::ParseEndpoint(options.directory, address, port)) {
+            Utils::printMsg("Error: Cannot resolve directory " + options.directory + ", not reporting load", error);
+            return;
+        }
+        std::optional<sf::IpAddress> advertised;
+        if (!options.advertiseAddress.empty()) {
+            advertised = sf::IpAddress::resolve(options.advertiseAddress);
+        }
+        server.SetDirectory(address, port, advertised);
+        Utils::printMsg("Reporting load to directory " + address.toString() + ":" + std::to_string(port));
+    }
+
+    // Starts the tracer if options name a trace file; slow tick dumps go next to it
+    template <typename Server>
+    void ApplyTracing(Server& server, const ServerOptions& options, const char* threadName) {
+        if (options.tracePath.empty()) {
+            return;
+        }
+        std::string prefix = options.tracePath;
+        if (prefix.size() > 5 && prefix.compare(prefix.size() - 5, 5, ".json") == 0) {
+            prefix.erase(prefix.size() - 5);
+        }
+        if (options.slowTickTraceMs != 0) {
+            server.SetSlowTickTrace(prefix, options.slowTickTraceMs);
+        }
+        TraceRecorder& tracer = TraceRecorder::Instance();
+        tracer.SetProcessName("Server :" + std::to_string(options.port), 1);
+        TraceRecorder::SetThreadName(threadName);
+        tracer.SetEnabled(true);
+        Utils::printMsg("Tracing to " + options.tracePath);
+    }
+
+    void WriteExitTrace(const ServerOptions& options) {
+        if (!options.tracePath.empty()) {
+            TraceRecorder::Instance().SetEnabled(false);
+            TraceRecorder::Instance().WriteChromeTrace(options.tracePath);
+        }
+    }
+}
+
+/**
+ * Runs a multi-room server until stopped. The calling thread routes
+ * datagrams while worker threads tick the rooms.
+ * @param interactive Stop on Enter; otherwise on SIGINT/SIGTERM, with a ready signal once bound
+ * @return Int: 0 success, -1 failure for main program exit codes.
+ */
+int runRoomServer(const ServerOptions& options, bool interactive) {
+    RoomServer server(options.port, options.roomCount, options.tickRate);
+    server.SetIngressShards(options.ingressShards);
+    server.SetEventBulletReplication(options.eventBullets);
+    server.SetClientBandwidth(options.clientBandwidth);
+    server.SetReplicationRates(options.replicationRates);
+    server.SetDeadReckoning(options.deadReckoning);
+    server.SetCompressionThreshold(options.compressionThreshold);
+    server.SetMaxPlayersPerRoom(options.maxPlayers);
+    server.SetOverloadControl(options.overloadControl);
+    server.SetEnemySquads(options.enemySquads);
+    server.SetChunkActiveRadius(options.chunkActiveRadius);
+    server.SetSpectatorStream(options.spectatorDelayMs, options.maxSpectators);
+    if (!options.mapPath.empty()) {
+        std::vector<StaticObstacles::Obstacle> mapObstacles;
+        if (!StaticObstacles::LoadMap(options.mapPath, mapObstacles)) {
+            Utils::printMsg("Failed to load map " + options.mapPath, error);
+            return -1;
+        }
+        Utils::printMsg("Loaded map " + options.mapPath + " (" + std::to_string(mapObstacles.size()) + " obstacles) for every room", success);
+        server.SetMapObstacles(std::move(mapObstacles));
+    }
+    ApplyDirectory(server, options);
+    ApplyTracing(server, options, "Router");
+    if (options.metricsPort != 0) {
+        Utils::printMsg("Warning: The metrics endpoint is only available with a single room", warning);
+    }
+    if (!options.capturePath.empty()) {
+        Utils::printMsg("Warning: Packet capture is only available with a single room", warning);
+    }
+    if (!options.journalPath.empty()) {
+        Utils::printMsg("Warning: The event journal is only available with a single room", warning);
+    }
+    if (options.hordeSize != 0) {
+        Utils::printMsg("Warning: The horde scenario is only available with a single room", warning);
+    }
+    if (!options.checkpointPath.empty()) {
+        Utils::printMsg("Warning: Match checkpoints are only available with a single room", warning);
+    }
+    if (!options.handoffPath.empty()) {
+        Utils::printMsg("Warning: Server handoff is only available with a single room", warning);
+    }
+    if (options.sharedMemory) {
+        Utils::printMsg("Warning: The shared memory transport is only available with a single room", warning);
+    }
+    if (options.lanMulticastPort != 0) {
+        Utils::printMsg("Warning: LAN multicast is only available with a single room", warning);
+    }
+    if (options.sendPacing) {
+        Utils::printMsg("Warning: Send pacing is only available with a single room", warning);
+    }
+    if (!server.Initialize()) {
+        Utils::printMsg("Failed to initialize room server", error);
+        return -1;
+    }
+    Utils::printMsg("Room server running. Clients choose a room (0-" + std::to_string(server.GetRoomCount() - 1) +
+        ") when joining." + (interactive ? " Press Enter to stop server..." : ""));
+    if (!interactive) {
+        SignalReady(options.port, options.readyFile);
+    }
+    // No more prompts from here on: logging moves off the routing and room threads
+    AsyncLogScope asyncLog;
+    StopTrigger stop(interactive);
+    // Placed last, so the threads started above do not inherit its core
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::IO);
+    while (!stop.IsStopRequested() && server.IsRunning()) {
+        server.Update();
+    }
+    Utils::printMsg("Shutting down server...", warning);
+    server.Shutdown();
+    WriteExitTrace(options);
+    if (!options.readyFile.empty()) {
+        std::remove(options.readyFile.c_str());
+    }
+    Utils::printMsg("Server stopped", success);
+    return 0;
+}
+
+/**
+ * Runs a single-room server from options until stopped.
+ * @param interactive Stop on Enter; otherwise on SIGINT/SIGTERM, with a ready signal once bound
+ * @return Int: 0 success, -1 failure for main program exit codes.
+ */
+int runConfiguredServer(const ServerOptions& options, bool interactive) {
+    ThreadTuner::Configure(options.threadTuning);
+    if (!options.threadTuning.IsDefault()) {
+        Utils::printMsg("Thread tuning: " + options.threadTuning.Describe());
+    }
+    if (options.roomCount > 1) {
+        return runRoomServer(options, interactive);
+    }
+    if (options.ingressShards > 1) {
+        Utils::printMsg("Warning: Ingress shards are only used with multiple rooms", warning);
+    }
+    GameServer server(options.port, options.tickRate);
+    server.SetMaxPlayers(options.maxPlayers);
+    server.SetNetworkThreadEnabled(options.networkThread);
+    server.SetBatchedSocketEnabled(options.batchedSocket);
+    server.SetSharedMemoryEnabled(options.sharedMemory);
+    server.SetSnapshotPipelineEnabled(options.snapshotPipeline);
+    server.SetSendPacingEnabled(options.sendPacing);
+    server.SetEventBulletReplication(options.eventBullets);
+    server.SetClientBandwidth(options.clientBandwidth);
+    server.SetReplicationRates(options.replicationRates);
+    server.SetDeadReckoning(options.deadReckoning);
+    server.SetCompressionThreshold(options.compressionThreshold);
+    server.SetParallelEnemyAI(options.parallelEnemyAI);
+    server.SetEnemyAIBudget(options.enemyAIBudgetUs);
+    server.SetOverloadControl(options.overloadControl);
+    server.SetEnemySquadsEnabled(options.enemySquads);
+    server.SetChunkActiveRadius(options.chunkActiveRadius);
+    server.SetSpectatorStream(options.spectatorDelayMs, options.maxSpectators);
+    if (!options.mapPath.empty() && !server.LoadMap(options.mapPath)) {
+        Utils::printMsg("Failed to load map " + options.mapPath, error);
+        return -1;
+    }
+    if (options.lanMulticastPort != 0) {
+        if (options.sharedMemory) {
+            Utils::printMsg("Warning: LAN multicast needs a socket, ignored with shared memory", warning);
+        }
+        else {
+            server.SetLanMulticast(sf::IpAddress(options.lanMulticastGroup), options.lanMulticastPort);
+            Utils::printMsg("LAN multicast: shared state goes to " + sf::IpAddress(options.lanMulticastGroup).toString() +
+                ":" + std::to_string(options.lanMulticastPort));
+        }
+    }
+    server.SetMetricsPort(options.metricsPort);
+    server.SetNetworkConditions(options.networkConditions);
+    ApplyDirectory(server, options);
+    ApplyTracing(server, options, "Simulation");
+    if (!options.recordingPath.empty() && !server.StartRecording(options.recordingPath)) {
+        Utils::printMsg("Error: Continuing without recording", error);
+    }
+    if (!options.capturePath.empty() && !server.StartCapture(options.capturePath)) {
+        Utils::printMsg("Error: Continuing without packet capture", error);
+    }
+    if (!options.journalPath.empty() && !server.StartJournal(options.journalPath)) {
+        Utils::printMsg("Error: Continuing without the event journal", error);
+    }
+    if (options.hordeSize != 0) {
+        server.SetHordeSize(options.hordeSize);
+        Utils::printMsg("Horde scenario: holding " + std::to_string(options.hordeSize) + " enemies", warning);
+    }
+    if (!options.checkpointPath.empty()) {
+        server.SetCheckpoint(options.checkpointPath);
+    }
+    if (!options.handoffPath.empty()) {
+        server.SetHandoff(options.handoffPath);
+    }
+    if (!server.Initialize()) {
+        Utils::printMsg("Failed to initialize server", error);
+        return -1;
+    }
+    if (interactive) {
+        Utils::printMsg("Server running. Press Enter to stop server...");
+        auto localIP = sf::IpAddress::getLocalAddress();
+        if (server.IsSharedMemoryActive()) {
+            Utils::printMsg("Bots on this machine can connect through shared memory on port " + std::to_string(options.port));
+        }
+        else if (localIP) {
+            Utils::printMsg("Players can connect to: " + localIP.value().toString() + ":" + std::to_string(options.port));
+        }
+        else {
+            Utils::printMsg("Players can connect to: localhost:" + std::to_string(options.port));
+        }
+    }
+    else {
+        Utils::printMsg("Server running on port " + std::to_string(options.port));
+        SignalReady(options.port, options.readyFile);
+    }
+    // No more prompts from here on: logging moves off the tick thread
+    AsyncLogScope asyncLog;
+    StopTrigger stop(interactive);
+    // Placed last, so the threads started above do not inherit its core
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::SIMULATION);
+    // Fixed-step loop: simulation step size no longer depends on frame or sleep timing
+    while (!stop.IsStopRequested() && server.IsRunning()) {
+        server.RunScheduledTicks();
+        server.WaitForNextTick();
+    }
+    Utils::printMsg("Shutting down server...", warning);
+    server.Shutdown();
+    WriteExitTrace(options);
+    // After a handoff the ready file is the new server's
+    if (!options.readyFile.empty() && !server.IsHandedOff()) {
+        std::remove(options.readyFile.c_str());
+    }
+    Utils::printMsg(server.IsHandedOff() ? "Server stopped after handing its match over" : "Server stopped", success);
+    return 0;
+}
+
+/**
+ * Runs server: prompts for the settings, then runs it until Enter is pressed.
  * @return Int: 0 success, -1 failure for main program exit codes.
  */
 int runServer() {
     Utils::printMsg("Starting Tank Game Server...");
-    unsigned short port = 53000;
+    ServerOptions options;
     std::cout << "Enter server port (default 53000): ";
     std::string input;
     std::getline(std::cin, input);
@@ -64,70 +424,162 @@ int runServer() {
             int tempPort = std::stoi(input);
             if (tempPort < 0 || tempPort > 65535) {
                 Utils::printMsg("Error: Port out of range (0-65535), using default 53000", error);
-                port = 53000;
             }
             else if (!IsValidPort(static_cast<unsigned short>(tempPort))) {
                 Utils::printMsg("Error: Port must be between 1024 and 65535, using default 53000", error);
-                port = 53000;
             }
             else {
-                port = static_cast<unsigned short>(tempPort);
-                Utils::printMsg("Using port: " + std::to_string(port));
+                options.port = static_cast<unsigned short>(tempPort);
+                Utils::printMsg("Using port: " + std::to_string(options.port));
             }
         }
         catch (const std::exception& e) {
             Utils::printMsg("Error: Invalid port input (" + input + "), using default 53000 - " + std::string(e.what()), error);
-            port = 53000;
         }
     }
     else {
         Utils::printMsg("Using default port: 53000");
     }
-    GameServer server(port);
-    if (!server.Initialize()) {
-        Utils::printMsg("Failed to initialize server", error);
-        return -1;
-    }
-    Utils::printMsg("Server running. Press Enter to stop server...");
-    auto localIP = sf::IpAddress::getLocalAddress();
-    if (localIP) {
-        Utils::printMsg("Players can connect to: " + localIP.value().toString() + ":" + std::to_string(port));
+    std::cout << "Enter server tick rate in Hz (30/60/128, default 60): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        try {
+            int tempRate = std::stoi(input);
+            if (tempRate < static_cast<int>(TickScheduler::MIN_TICK_RATE) ||
+                tempRate > static_cast<int>(TickScheduler::MAX_TICK_RATE)) {
+                Utils::printMsg("Error: Tick rate must be between " + std::to_string(TickScheduler::MIN_TICK_RATE) +
+                    " and " + std::to_string(TickScheduler::MAX_TICK_RATE) + " Hz, using default 60", error);
+            }
+            else {
+                options.tickRate = static_cast<unsigned int>(tempRate);
+                Utils::printMsg("Using tick rate: " + std::to_string(options.tickRate) + " Hz");
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid tick rate input (" + input + "), using default 60 - " + std::string(e.what()), error);
+        }
     }
     else {
-        Utils::printMsg("Players can connect to: localhost:" + std::to_string(port));
+        Utils::printMsg("Using default tick rate: 60 Hz");
     }
-    sf::Clock clock;
-    bool running = true;
-    std::thread inputThread([&running]() {
-        std::string input;
+    std::cout << "Number of rooms to host (default 1): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        try {
+            int tempRooms = std::stoi(input);
+            if (tempRooms < 1 || tempRooms > static_cast<int>(RoomServer::MAX_ROOMS)) {
+                Utils::printMsg("Error: Room count must be between 1 and " + std::to_string(RoomServer::MAX_ROOMS) +
+                    ", using default 1", error);
+            }
+            else {
+                options.roomCount = static_cast<uint16_t>(tempRooms);
+                Utils::printMsg("Hosting " + std::to_string(options.roomCount) + " rooms");
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid room count input (" + input + "), using default 1 - " + std::string(e.what()), error);
+        }
+    }
+    std::cout << "Directory service to report load to (host[:port], empty = none): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        sf::IpAddress directoryAddress = sf::IpAddress::LocalHost;
+        unsigned short directoryPort = 0;
+        if (!Directory::ParseEndpoint(input, directoryAddress, directoryPort)) {
+            Utils::printMsg("Error: Cannot resolve directory (" + input + "), not reporting load", error);
+        }
+        else {
+            options.directory = input;
+        }
+    }
+    if (options.roomCount > 1) {
+        if (BatchedUdpSocket::IsPortSharingSupported()) {
+            std::cout << "Ingress shards: receive sockets sharing the port, a thread each (1-" <<
+                RoomServer::MAX_INGRESS_SHARDS << ", default 1): ";
+            std::getline(std::cin, input);
+            if (!input.empty()) {
+                try {
+                    int tempShards = std::stoi(input);
+                    if (tempShards < 1 || tempShards > static_cast<int>(RoomServer::MAX_INGRESS_SHARDS)) {
+                        Utils::printMsg("Error: Shard count must be between 1 and " +
+                            std::to_string(RoomServer::MAX_INGRESS_SHARDS) + ", using default 1", error);
+                    }
+                    else {
+                        options.ingressShards = static_cast<uint32_t>(tempShards);
+                    }
+                }
+                catch (const std::exception& e) {
+                    Utils::printMsg("Error: Invalid shard count input (" + input + "), using default 1 - " + std::string(e.what()), error);
+                }
+            }
+        }
+        std::cout << "Replicate bullets as spawn events (clients simulate flight)? (y/N): ";
         std::getline(std::cin, input);
-        running = false;
-        });
-    while (running && server.IsRunning()) {
-        float deltaTime = clock.restart().asSeconds();
-        if (deltaTime < 0 || !std::isfinite(deltaTime)) {
-            Utils::printMsg("Warning: Invalid delta time, skipping update", warning);
-            continue;
+        options.eventBullets = (input == "y" || input == "Y");
+        return runConfiguredServer(options, true);
+    }
+    std::cout << "Use dedicated network I/O thread? (y/N): ";
+    std::getline(std::cin, input);
+    options.networkThread = (input == "y" || input == "Y");
+    if (BatchedUdpSocket::IsSupported()) {
+        std::cout << "Batch socket I/O (recvmmsg/sendmmsg on Linux, Registered I/O on Windows)? (y/N): ";
+        std::getline(std::cin, input);
+        options.batchedSocket = (input == "y" || input == "Y");
+    }
+    std::cout << "Serve bots on this machine through shared memory instead of a socket? (y/N): ";
+    std::getline(std::cin, input);
+    options.sharedMemory = (input == "y" || input == "Y");
+    std::cout << "Replicate bullets as spawn events (clients simulate flight)? (y/N): ";
+    std::getline(std::cin, input);
+    options.eventBullets = (input == "y" || input == "Y");
+    std::cout << "Run enemy AI on a job system (parallel across cores)? (y/N): ";
+    std::getline(std::cin, input);
+    options.parallelEnemyAI = (input == "y" || input == "Y");
+    std::cout << "Enemy AI time budget per tick in microseconds (0 = unlimited, default 0): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        try {
+            int tempBudget = std::stoi(input);
+            if (tempBudget < 0) {
+                Utils::printMsg("Error: Budget cannot be negative, using unlimited", error);
+            }
+            else {
+                options.enemyAIBudgetUs = static_cast<uint32_t>(tempBudget);
+                Utils::printMsg("Enemy AI budget: " + std::to_string(options.enemyAIBudgetUs) + " us per tick");
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid budget input (" + input + "), using unlimited - " + std::string(e.what()), error);
         }
-        server.Update(deltaTime);
-        sf::sleep(sf::milliseconds(1));
     }
-    Utils::printMsg("Shutting down server...", warning);
-    server.Shutdown();
-    if (inputThread.joinable()) {
+    std::cout << "Metrics endpoint port (0 = off, default 0): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
         try {
-            inputThread.join();
+            int tempPort = std::stoi(input);
+            if (tempPort < 0 || tempPort > 65535) {
+                Utils::printMsg("Error: Port must be between 0 and 65535, metrics endpoint off", error);
+            }
+            else {
+                options.metricsPort = static_cast<unsigned short>(tempPort);
+            }
         }
         catch (const std::exception& e) {
-            Utils::printMsg("Error: Exception joining input thread - " + std::string(e.what()), error);
+            Utils::printMsg("Error: Invalid metrics port input (" + input + "), metrics endpoint off - " + std::string(e.what()), error);
         }
     }
-    Utils::printMsg("Server stopped", success);
-    return 0;
+    options.networkConditions = PromptNetworkConditions();
+    std::cout << "Record the match for replay (file path, empty = off): ";
+    std::getline(std::cin, options.recordingPath);
+    std::cout << "Capture datagrams for analysis (file path, empty = off): ";
+    std::getline(std::cin, options.capturePath);
+    return runConfiguredServer(options, true);
 }
 
+#ifndef HEADLESS_SERVER
 /**
  * Runs client: prompts name/IP/port/color, connects, runs game loop with events/update/render.
+ * Server IP "local" starts a LocalServer and plays on it over the loopback network.
  * @return Int: 0 success, -1 failure for program control.
  */
 int runClient() {
@@ -145,47 +597,87 @@ int runClient() {
     else {
         Utils::printMsg("Using player name: " + playerName);
     }
-    std::cout << "Enter server IP (default 127.0.0.1): ";
+    std::cout << "Directory service (host[:port], empty = enter a server directly): ";
     std::string input;
     std::getline(std::cin, input);
+    uint16_t roomId = 0;
+    Directory::Assignment assignment;
+    sf::IpAddress directoryAddress = sf::IpAddress::LocalHost;
+    unsigned short directoryPort = Directory::DEFAULT_PORT;
+    bool placedByDirectory = false;
     if (!input.empty()) {
-        if (!IsValidIPAddress(input)) {
-            Utils::printMsg("Error: Invalid IP address (" + input + "), using default 127.0.0.1", error);
-            serverIP = "127.0.0.1";
+        if (!Directory::ParseEndpoint(input, directoryAddress, directoryPort)) {
+            Utils::printMsg("Error: Cannot resolve directory (" + input + "), enter a server instead", error);
+        }
+        else if (!ServerProbe::FindNearestServer(directoryAddress, directoryPort, assignment)) {
+            Utils::printMsg("Error: Directory had no free room or did not answer, enter a server instead", error);
         }
         else {
-            serverIP = input;
-            Utils::printMsg("Using server IP: " + serverIP);
+            serverIP = assignment.address.toString();
+            serverPort = assignment.port;
+            roomId = assignment.room;
+            placedByDirectory = true;
+            Utils::printMsg("Directory placed you on " + serverIP + ":" + std::to_string(serverPort) +
+                ", room " + std::to_string(roomId));
+            std::vector<Directory::LeaderboardEntry> leaders;
+            if (Directory::FetchLeaderboard(directoryAddress, directoryPort, leaders) && !leaders.empty()) {
+                Utils::printMsg("Leaderboard across all servers:");
+                for (size_t i = 0; i < leaders.size(); ++i) {
+                    Utils::printMsg("  " + std::to_string(i + 1) + ". " + leaders[i].name + " - " +
+                        std::to_string(leaders[i].score));
+                }
+            }
         }
     }
-    else {
-        Utils::printMsg("Using default server IP: 127.0.0.1");
-    }
-    std::cout << "Enter server port (default 53000): ";
-    std::getline(std::cin, input);
-    if (!input.empty()) {
-        try {
-            int tempPort = std::stoi(input);
-            if (tempPort < 0 || tempPort > 65535) {
-                Utils::printMsg("Error: Port out of range (0-65535), using default 53000", error);
-                serverPort = 53000;
-            }
-            else if (!IsValidPort(static_cast<unsigned short>(tempPort))) {
-                Utils::printMsg("Error: Port must be between 1024 and 65535, using default 53000", error);
-                serverPort = 53000;
+    bool useLocalServer = false;
+    if (!placedByDirectory) {
+        std::cout << "Enter server IP (default 127.0.0.1, 'local' = play on an in-process server without sockets): ";
+        std::getline(std::cin, input);
+        if (input == "local") {
+            useLocalServer = true;
+            Utils::printMsg("Playing on an in-process server");
+        }
+        else if (!input.empty()) {
+            if (!IsValidIPAddress(input)) {
+                Utils::printMsg("Error: Invalid IP address (" + input + "), using default 127.0.0.1", error);
+                serverIP = "127.0.0.1";
             }
             else {
-                serverPort = static_cast<unsigned short>(tempPort);
-                Utils::printMsg("Using server port: " + std::to_string(serverPort));
+                serverIP = input;
+                Utils::printMsg("Using server IP: " + serverIP);
             }
         }
-        catch (const std::exception& e) {
-            Utils::printMsg("Error: Invalid port input (" + input + "), using default 53000 - " + std::string(e.what()), error);
-            serverPort = 53000;
+        else {
+            Utils::printMsg("Using default server IP: 127.0.0.1");
         }
     }
-    else {
-        Utils::printMsg("Using default server port: 53000");
+    if (!placedByDirectory && !useLocalServer) {
+        std::cout << "Enter server port (default 53000): ";
+        std::getline(std::cin, input);
+        if (!input.empty()) {
+            try {
+                int tempPort = std::stoi(input);
+                if (tempPort < 0 || tempPort > 65535) {
+                    Utils::printMsg("Error: Port out of range (0-65535), using default 53000", error);
+                    serverPort = 53000;
+                }
+                else if (!IsValidPort(static_cast<unsigned short>(tempPort))) {
+                    Utils::printMsg("Error: Port must be between 1024 and 65535, using default 53000", error);
+                    serverPort = 53000;
+                }
+                else {
+                    serverPort = static_cast<unsigned short>(tempPort);
+                    Utils::printMsg("Using server port: " + std::to_string(serverPort));
+                }
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid port input (" + input + "), using default 53000 - " + std::string(e.what()), error);
+                serverPort = 53000;
+            }
+        }
+        else {
+            Utils::printMsg("Using default server port: 53000");
+        }
     }
     std::cout << "Enter preferred color (red/blue/green/black, default green): ";
     std::getline(std::cin, input);
@@ -202,31 +694,140 @@ int runClient() {
     else {
         Utils::printMsg("Using default color: green");
     }
+    if (!placedByDirectory && !useLocalServer) {
+        std::cout << "Enter room (multi-room servers only, default 0): ";
+        std::getline(std::cin, input);
+        if (!input.empty()) {
+            try {
+                int tempRoom = std::stoi(input);
+                if (tempRoom < 0 || tempRoom >= static_cast<int>(RoomServer::MAX_ROOMS)) {
+                    Utils::printMsg("Error: Room must be between 0 and " + std::to_string(RoomServer::MAX_ROOMS - 1) +
+                        ", using default 0", error);
+                }
+                else {
+                    roomId = static_cast<uint16_t>(tempRoom);
+                    Utils::printMsg("Using room: " + std::to_string(roomId));
+                }
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid room input (" + input + "), using default 0 - " + std::string(e.what()), error);
+            }
+        }
+    }
+    bool spectate = false;
+    if (!useLocalServer) {
+        std::cout << "Spectate instead of playing (delayed view; the server may be a spectator relay)? (y/N): ";
+        std::getline(std::cin, input);
+        spectate = (input == "y" || input == "Y");
+    }
+    bool useNetworkThread = false;
+    NetworkConditions networkConditions;
+    if (!useLocalServer) {
+        std::cout << "Receive and send on a network thread (steadier RTT during slow frames)? (y/N): ";
+        std::getline(std::cin, input);
+        useNetworkThread = (input == "y" || input == "Y");
+        networkConditions = PromptNetworkConditions();
+    }
+    std::cout << "Capture datagrams for analysis (file path, empty = off): ";
+    std::string capturePath;
+    std::getline(std::cin, capturePath);
+    float pacedFps = 0.0f;
+    std::cout << "Low-latency frame pacing: frame rate to pace at, e.g. your display's refresh (empty = vsync): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        try {
+            pacedFps = std::stof(input);
+            if (pacedFps < FramePacer::MIN_FPS || pacedFps > FramePacer::MAX_FPS) {
+                Utils::printMsg("Error: Paced frame rate must be between " + std::to_string(static_cast<int>(FramePacer::MIN_FPS)) +
+                    " and " + std::to_string(static_cast<int>(FramePacer::MAX_FPS)) + ", using vsync", error);
+                pacedFps = 0.0f;
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid frame rate (" + input + "), using vsync - " + std::string(e.what()), error);
+        }
+    }
     sf::RenderWindow window;
     try {
         window.create(sf::VideoMode({ 1280, 960 }), "Tank Game - Multiplayer Client (" + playerName + ")");
-        window.setFramerateLimit(60);
+        // Render at the display's refresh, or present on FramePacer's cadence; prediction
+        // runs in fixed steps inside MultiplayerGame either way
+        window.setVerticalSyncEnabled(pacedFps == 0.0f);
     }
     catch (const std::exception& e) {
         Utils::printMsg("Error: Failed to create window - " + std::string(e.what()), error);
         return -1;
     }
+    // Declared before the game, so its clients are gone before it stops
+    LocalServer localServer;
     MultiplayerGame game;
+    AssetManager::Instance().SetResolution(window.getSize());
+    // Loading phase: textures decode on worker threads while this loop uploads
+    // them and keeps the window responsive; nothing loads once connected
+    game.BeginLoading();
+    while (window.isOpen() && !game.UpdateLoading()) {
+        while (const std::optional event = window.pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                window.close();
+            }
+        }
+        window.clear();
+        game.RenderLoading(window);
+        window.display();
+    }
+    if (!window.isOpen()) {
+        Utils::printMsg("Window closed while loading", warning);
+        return 0;
+    }
+    game.SetSpectating(spectate);
     if (!game.Initialize(playerName, preferredColor)) {
         Utils::printMsg("Failed to initialize game", error);
         return -1;
     }
     game.SetWindow(&window);
-    Utils::printMsg("Connecting to server " + serverIP + ":" + std::to_string(serverPort) + "...");
-    if (!game.ConnectToServer(serverIP, serverPort)) {
+    game.SetNetworkConditions(networkConditions);
+    game.SetNetworkThreadEnabled(useNetworkThread);
+    if (!capturePath.empty() && !game.StartPacketCapture(capturePath)) {
+        Utils::printMsg("Error: Continuing without packet capture", error);
+    }
+    if (useLocalServer) {
+        if (!localServer.Start()) {
+            return -1;
+        }
+        game.SetLoopback(&localServer.GetNetwork());
+    }
+    Utils::printMsg(useLocalServer ? std::string("Connecting to the in-process server...") :
+        "Connecting to server " + serverIP + ":" + std::to_string(serverPort) + "...");
+    if (!game.ConnectToServer(serverIP, serverPort, roomId)) {
         Utils::printMsg("Failed to connect to server", error);
         Utils::printMsg("Make sure the server is running and accessible");
         return -1;
     }
     Utils::printMsg("Connected to server successfully!", success);
-    Utils::printMsg("Use WASD to move your tank, mouse to aim barrel. Press ESC to quit.");
+    Utils::printMsg(spectate ? "Spectating. F3 toggles the debug overlay. Press ESC to quit." :
+        "Use WASD to move your tank, mouse to aim barrel. F3 toggles the debug overlay. Press ESC to quit.");
+    AsyncLogScope asyncLog;
+    FramePacer pacer(pacedFps > 0.0f ? pacedFps : 60.0f);
+    if (pacedFps > 0.0f) {
+        pacer.Start();
+    }
     sf::Clock clock;
+    sf::Clock backgroundRenderClock;
+    WindowActivity lastActivity = WindowActivity::FOREGROUND;
     while (window.isOpen()) {
+        const WindowActivity activity = GetWindowActivity(window);
+        if (activity != lastActivity) {
+            game.SetWindowActivity(activity);
+            if (activity == WindowActivity::FOREGROUND && pacedFps > 0.0f) {
+                pacer.Resume();
+            }
+            lastActivity = activity;
+        }
+        const bool foreground = activity == WindowActivity::FOREGROUND;
+        if (foreground && pacedFps > 0.0f) {
+            TRACE_SCOPE("Frame pacing", "render");
+            pacer.WaitForFrameStart();
+        }
         float deltaTime = clock.restart().asSeconds();
         if (deltaTime < 0 || !std::isfinite(deltaTime)) {
             Utils::printMsg("Warning: Invalid delta time, skipping update", warning);
@@ -260,14 +861,38 @@ int runClient() {
             Utils::printMsg("Lost connection to server", error);
             window.close();
         }
-        try {
-            window.clear();
-            game.Render(window);
-            window.display();
+        // Unfocused, the window still shows but only needs redrawing now and
+        // then; minimised, nothing is visible, so nothing is drawn
+        bool render = foreground;
+        if (activity == WindowActivity::UNFOCUSED
+            && backgroundRenderClock.getElapsedTime().asSeconds() >= 1.0f / MultiplayerGame::UNFOCUSED_RENDER_HZ) {
+            backgroundRenderClock.restart();
+            render = true;
         }
-        catch (const std::exception& e) {
-            Utils::printMsg("Error: Exception during rendering - " + std::string(e.what()), error);
-            window.close();
+        if (render) {
+            try {
+                window.clear();
+                game.Render(window);
+                TRACE_SCOPE("Present", "render");
+                window.display();
+                if (foreground && pacedFps > 0.0f) {
+                    pacer.OnFramePresented();
+                }
+                game.OnFramePresented();
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Exception during rendering - " + std::string(e.what()), error);
+                window.close();
+            }
+        }
+        if (!foreground) {
+            // No vsync or pacer to hold the loop back: run the network and
+            // simulation at BACKGROUND_UPDATE_HZ instead of spinning
+            const float frameSeconds = clock.getElapsedTime().asSeconds();
+            const float remaining = 1.0f / MultiplayerGame::BACKGROUND_UPDATE_HZ - frameSeconds;
+            if (remaining > 0.0f) {
+                std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(remaining * 1000000.0f)));
+            }
         }
         static float titleUpdateTimer = 0;
         titleUpdateTimer += deltaTime;
@@ -294,15 +919,456 @@ int runClient() {
 }
 
 /**
- * Main: prompts mode choice (1 server, 2 client), runs corresponding function.
+ * Runs headless bots against a server until Enter is pressed: prompts server,
+ * bot count, fire rate, input pattern and session churn, then steps every bot
+ * at 60 Hz and prints aggregate RTT, loss and rejection stats every 5 seconds.
+ * @return Int: 0 success, -1 failure for program control.
+ */
+int runBotClient() {
+    Utils::printMsg("Starting bot load generator...");
+    BotLoadConfig config;
+    std::string input;
+    std::cout << "Enter server IP (default 127.0.0.1, 'local' = in-process server without sockets): ";
+    std::getline(std::cin, input);
+    const bool useLocalServer = input == "local";
+    if (!useLocalServer && !input.empty()) {
+        if (!IsValidIPAddress(input)) {
+            Utils::printMsg("Error: Invalid IP address (" + input + "), using default 127.0.0.1", error);
+        }
+        else {
+            config.serverIP = input;
+        }
+    }
+    if (!useLocalServer) {
+        std::cout << "Enter server port (default 53000): ";
+        std::getline(std::cin, input);
+        if (!input.empty()) {
+            try {
+                int tempPort = std::stoi(input);
+                if (tempPort < 0 || tempPort > 65535 || !IsValidPort(static_cast<unsigned short>(tempPort))) {
+                    Utils::printMsg("Error: Port must be between 1024 and 65535, using default 53000", error);
+                }
+                else {
+                    config.serverPort = static_cast<unsigned short>(tempPort);
+                }
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid port input (" + input + "), using default 53000 - " + std::string(e.what()), error);
+            }
+        }
+        std::cout << "Connect through shared memory (server on this machine run with --shared-memory)? (y/N): ";
+        std::getline(std::cin, input);
+        config.sharedMemory = (input == "y" || input == "Y");
+    }
+    if (!useLocalServer && !config.sharedMemory) {
+        std::cout << "Enter room (multi-room servers only, default 0): ";
+        std::getline(std::cin, input);
+        if (!input.empty()) {
+            try {
+                int tempRoom = std::stoi(input);
+                if (tempRoom < 0 || tempRoom >= static_cast<int>(RoomServer::MAX_ROOMS)) {
+                    Utils::printMsg("Error: Room must be between 0 and " + std::to_string(RoomServer::MAX_ROOMS - 1) +
+                        ", using default 0", error);
+                }
+                else {
+                    config.roomId = static_cast<uint16_t>(tempRoom);
+                }
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid room input (" + input + "), using default 0 - " + std::string(e.what()), error);
+            }
+        }
+    }
+    std::cout << "Number of bots (1-" << BotLoadGenerator::MAX_BOTS << ", default 100): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        try {
+            int tempBots = std::stoi(input);
+            if (tempBots < 1 || tempBots > static_cast<int>(BotLoadGenerator::MAX_BOTS)) {
+                Utils::printMsg("Error: Bot count must be between 1 and " + std::to_string(BotLoadGenerator::MAX_BOTS) +
+                    ", using default 100", error);
+            }
+            else {
+                config.botCount = static_cast<uint32_t>(tempBots);
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid bot count input (" + input + "), using default 100 - " + std::string(e.what()), error);
+        }
+    }
+    std::cout << "Shots per second per bot (0 = never fire, default 1): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        try {
+            float tempRate = std::stof(input);
+            if (tempRate < 0.0f || tempRate > 20.0f) {
+                Utils::printMsg("Error: Fire rate must be between 0 and 20, using default 1", error);
+            }
+            else {
+                config.fireRatePerSecond = tempRate;
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid fire rate input (" + input + "), using default 1 - " + std::string(e.what()), error);
+        }
+    }
+    std::cout << "Drive bots with the enemy AI, hunting enemies (patrol/chase/attack)? (y/N): ";
+    std::getline(std::cin, input);
+    if (input == "y" || input == "Y") {
+        config.inputPattern = BotInputPattern::BRAIN;
+    }
+    else {
+        std::cout << "Scripted circling instead of random input? (y/N): ";
+        std::getline(std::cin, input);
+        if (input == "y" || input == "Y") {
+            config.inputPattern = BotInputPattern::CIRCLE;
+        }
+    }
+    std::cout << "Send input only on change, with keep-alives? (y/N): ";
+    std::getline(std::cin, input);
+    if (input == "y" || input == "Y") {
+        config.inputSendMode = InputSendMode::ON_CHANGE;
+    }
+    std::cout << "Keep every bot connected (no leave/rejoin churn)? (y/N): ";
+    std::getline(std::cin, input);
+    if (input == "y" || input == "Y") {
+        config.maxSessionSeconds = 0.0f;
+    }
+    if (!useLocalServer && !config.sharedMemory) {
+        config.networkConditions = PromptNetworkConditions();
+    }
+    std::cout << "Latency benchmark: stop after how many seconds (0 = when Enter is pressed, default 0): ";
+    std::getline(std::cin, input);
+    if (!input.empty()) {
+        try {
+            float tempSeconds = std::stof(input);
+            if (tempSeconds < 0.0f || tempSeconds > 86400.0f) {
+                Utils::printMsg("Error: Run time must be between 0 and 86400 seconds, stopping on Enter", error);
+            }
+            else {
+                config.runSeconds = tempSeconds;
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid run time input (" + input + "), stopping on Enter - " + std::string(e.what()), error);
+        }
+    }
+
+    // Declared before the generator, so the bots are gone before it stops
+    LocalServer localServer;
+    if (useLocalServer) {
+        if (!localServer.Start()) {
+            return -1;
+        }
+        config.loopback = &localServer.GetNetwork();
+        if (config.botCount > LoopbackNetwork::MAX_ENDPOINTS) {
+            Utils::printMsg("Bot count capped at " + std::to_string(LoopbackNetwork::MAX_ENDPOINTS) +
+                " on the in-process server", warning);
+            config.botCount = static_cast<uint32_t>(LoopbackNetwork::MAX_ENDPOINTS);
+        }
+    }
+
+    BotLoadGenerator generator(config);
+    Utils::printMsg("Running " + std::to_string(config.botCount) + " bots against " +
+        (useLocalServer ? std::string("the in-process server") :
+        config.sharedMemory ? "shared memory for port " + std::to_string(config.serverPort) :
+        config.serverIP + ":" + std::to_string(config.serverPort)) + (config.runSeconds > 0.0f ?
+        " for " + std::to_string(static_cast<int>(config.runSeconds)) + " seconds..." : ". Press Enter to stop..."));
+    // Hundreds of clients would drown the console: keep their errors, the report bypasses the filter
+    Logger::SetMinimumLevel(error);
+    AsyncLogScope asyncLog;
+    std::atomic<bool> running = true;
+    // A timed run reads nothing more, so it also works with answers piped in
+    std::thread inputThread;
+    if (config.runSeconds <= 0.0f) {
+        inputThread = std::thread([&running]() {
+            std::string input;
+            std::getline(std::cin, input);
+            running = false;
+            });
+    }
+    const float FRAME_SECONDS = 1.0f / 60.0f;
+    sf::Clock clock;
+    sf::Clock runClock;
+    while (running) {
+        if (config.runSeconds > 0.0f && runClock.getElapsedTime().asSeconds() >= config.runSeconds) {
+            break;
+        }
+        generator.Update(clock.restart().asSeconds());
+        const float frameTime = clock.getElapsedTime().asSeconds();
+        if (frameTime < FRAME_SECONDS) {
+            sf::sleep(sf::seconds(FRAME_SECONDS - frameTime));
+        }
+    }
+    generator.Shutdown();
+    Logger::SetMinimumLevel(debug);
+    if (inputThread.joinable()) {
+        try {
+            inputThread.join();
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Exception joining input thread - " + std::string(e.what()), error);
+        }
+    }
+    Utils::printMsg("Bots stopped", success);
+    return 0;
+}
+#endif
+
+/**
+ * Runs the directory service that places players on the least-loaded server.
+ * @param interactive Stop on Enter; otherwise on SIGINT/SIGTERM
+ * @return Int: 0 success, -1 failure for main program exit codes.
+ */
+int runDirectoryService(unsigned short port, bool interactive) {
+    DirectoryService service(port);
+    if (!service.Initialize()) {
+        return -1;
+    }
+    Utils::printMsg("Directory service running on port " + std::to_string(port) +
+        (interactive ? ". Press Enter to stop..." : ""));
+    StopTrigger stop(interactive);
+    while (!stop.IsStopRequested() && service.IsRunning()) {
+        service.Update();
+    }
+    service.Shutdown();
+    Utils::printMsg("Directory service stopped", success);
+    return 0;
+}
+
+/**
+ * Runs a spectator relay that re-broadcasts one room's spectator stream.
+ * @param upstream "host[:port]" of the game server (or another relay), port defaulting to the game port
+ * @param interactive Stop on Enter; otherwise on SIGINT/SIGTERM
+ * @return Int: 0 success, -1 failure for main program exit codes.
+ */
+int runSpectatorRelay(const std::string& upstream, unsigned short listenPort, uint16_t room, bool interactive) {
+    sf::IpAddress upstreamAddress = sf::IpAddress::LocalHost;
+    unsigned short upstreamPort = 0;
+    const std::string endpoint = upstream.find(':') == std::string::npos ?
+        upstream + ":" + std::to_string(ServerOptions().port) : upstream;
+    if (!Directory::ParseEndpoint(endpoint, upstreamAddress, upstreamPort)) {
+        Utils::printMsg("Error: Invalid or unresolvable server address (" + upstream + ")", error);
+        return -1;
+    }
+    SpectatorRelay relay(upstreamAddress, upstreamPort, room, listenPort);
+    if (!relay.Initialize()) {
+        return -1;
+    }
+    Utils::printMsg("Spectator relay running. Spectators can connect to port " + std::to_string(listenPort) +
+        (interactive ? ". Press Enter to stop..." : ""));
+    StopTrigger stop(interactive);
+    while (!stop.IsStopRequested() && relay.IsRunning()) {
+        relay.Update();
+    }
+    relay.Shutdown();
+    Utils::printMsg("Spectator relay stopped", success);
+    return 0;
+}
+
+/**
+ * Replays a match recorded by the server, offline and as fast as it runs,
+ * and reports whether every tick reproduced the recorded world. A start tick
+ * seeks to the keyframe before it rather than replaying from the beginning.
+ * @return Int: 0 if the replay matched, -1 on failure or divergence.
+ */
+int runReplay() {
+    std::cout << "Match recording to replay: ";
+    std::string path;
+    std::getline(std::cin, path);
+    std::cout << "Run enemy AI on a job system (parallel across cores)? (y/N): ";
+    std::string input;
+    std::getline(std::cin, input);
+    const bool parallelEnemyAI = input == "y" || input == "Y";
+    std::cout << "Start at tick (empty = the beginning): ";
+    std::getline(std::cin, input);
+    uint32_t seekTick = 0;
+    if (!input.empty()) {
+        try {
+            seekTick = static_cast<uint32_t>(std::stoul(input));
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid tick input (" + input + "), starting at the beginning - " + std::string(e.what()), error);
+        }
+    }
+
+    GameServer server;
+    server.SetParallelEnemyAI(parallelEnemyAI);
+    ReplayResult result;
+    if (!server.RunReplay(path, result, seekTick)) {
+        return -1;
+    }
+    if (result.keyframeTick > 0) {
+        Utils::printMsg("Seeked to tick " + std::to_string(seekTick) + " from the keyframe at tick " +
+            std::to_string(result.keyframeTick) + " in " + std::to_string(result.seekSeconds) + " s");
+    }
+    Utils::printMsg("Replayed " + std::to_string(result.ticks) + " ticks (" + std::to_string(result.simulatedSeconds) +
+        " s of play) and " + std::to_string(result.messages) + " messages in " + std::to_string(result.seconds) + " s");
+    if (result.hashMismatches > 0) {
+        Utils::printMsg("Replay diverged: " + std::to_string(result.hashMismatches) + " ticks differ, first at tick " +
+            std::to_string(result.firstMismatchTick), error);
+        return -1;
+    }
+    Utils::printMsg("Every tick matched the recording", success);
+    return 0;
+}
+
+/**
+ * Reports bandwidth, jitter, loss gaps and snapshot sizes from a packet capture.
+ * @param bucketSeconds Width of the snapshot size buckets
+ * @return Int: 0 success, -1 if the capture could not be read.
+ */
+int runCaptureAnalysis(const std::string& path, float bucketSeconds) {
+    return CaptureAnalysis::Run(path, bucketSeconds) ? 0 : -1;
+}
+
+/**
+ * Main: prompts mode choice (1 server, 2 client, 3 benchmarks, 4 bots, 5 replay, 6 pack assets,
+ * 7 directory service, 8 capture analysis, 9 spectator relay), runs corresponding function.
  * @return Int: 0 success, -1 invalid choice for error reporting.
  */
-int main() {
+int main(int argc, char* argv[]) {
+    // Unattended server for orchestration: settings from the command line, no stdin
+    if (ServerOptions::IsServerCommandLine(argc, argv)) {
+        ServerOptions options;
+        if (!ServerOptions::ParseCommandLine(argc, argv, options)) {
+            return -1;
+        }
+        return runConfiguredServer(options, false);
+    }
+    // Unattended directory service: --directory-service [port]
+    if (argc > 1 && std::string(argv[1]) == "--directory-service") {
+        unsigned short port = Directory::DEFAULT_PORT;
+        if (argc > 2) {
+            try {
+                int tempPort = std::stoi(argv[2]);
+                if (tempPort < 0 || tempPort > 65535 || !IsValidPort(static_cast<unsigned short>(tempPort))) {
+                    Utils::printMsg("Error: Directory port must be between 1024 and 65535", error);
+                    return -1;
+                }
+                port = static_cast<unsigned short>(tempPort);
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid directory port (" + std::string(argv[2]) + ") - " + std::string(e.what()), error);
+                return -1;
+            }
+        }
+        return runDirectoryService(port, false);
+    }
+    // Unattended spectator relay: --spectator-relay <host[:port]> [listen port] [room]
+    if (argc > 2 && std::string(argv[1]) == "--spectator-relay") {
+        unsigned short listenPort = SpectatorRelay::DEFAULT_PORT;
+        uint16_t room = 0;
+        try {
+            if (argc > 3) {
+                int tempPort = std::stoi(argv[3]);
+                if (tempPort < 0 || tempPort > 65535 || !IsValidPort(static_cast<unsigned short>(tempPort))) {
+                    Utils::printMsg("Error: Relay port must be between 1024 and 65535", error);
+                    return -1;
+                }
+                listenPort = static_cast<unsigned short>(tempPort);
+            }
+            if (argc > 4) {
+                int tempRoom = std::stoi(argv[4]);
+                if (tempRoom < 0 || tempRoom >= RoomServer::MAX_ROOMS) {
+                    Utils::printMsg("Error: Room must be between 0 and " + std::to_string(RoomServer::MAX_ROOMS - 1), error);
+                    return -1;
+                }
+                room = static_cast<uint16_t>(tempRoom);
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid relay port or room - " + std::string(e.what()), error);
+            return -1;
+        }
+        return runSpectatorRelay(argv[2], listenPort, room, false);
+    }
+    // Performance regression gate: --benchmark-gate [tolerance %] [baseline.json] [results.json]
+    // (BenchmarkGateConfig::runs passes of the suite, medians compared)
+    // Re-recording the baseline: --benchmark-baseline [baseline.json]
+    if (argc > 1 && (std::string(argv[1]) == "--benchmark-gate" || std::string(argv[1]) == "--benchmark-baseline")) {
+        BenchmarkGateConfig config;
+        config.updateBaseline = std::string(argv[1]) == "--benchmark-baseline";
+        int next = 2;
+        if (!config.updateBaseline && argc > next) {
+            try {
+                config.tolerancePercent = std::stof(argv[next++]);
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid tolerance (" + std::string(argv[next - 1]) + ") - " + std::string(e.what()), error);
+                return -1;
+            }
+            if (config.tolerancePercent < 0.0f) {
+                Utils::printMsg("Error: Tolerance must not be negative", error);
+                return -1;
+            }
+        }
+        if (argc > next) {
+            config.baselinePath = argv[next++];
+        }
+        if (argc > next) {
+            config.resultsPath = argv[next++];
+        }
+        return BenchmarkGate::Run(config);
+    }
+    // Unattended soak test: --soak <hours> [bots] [samples.csv]
+    if (argc > 2 && std::string(argv[1]) == "--soak") {
+#ifndef HEADLESS_SERVER
+        SoakTestConfig config;
+        try {
+            config.hours = std::stof(argv[2]);
+            if (argc > 3) {
+                int tempBots = std::stoi(argv[3]);
+                if (tempBots < 1 || tempBots > static_cast<int>(LoopbackNetwork::MAX_ENDPOINTS)) {
+                    Utils::printMsg("Error: Bot count must be between 1 and " + std::to_string(LoopbackNetwork::MAX_ENDPOINTS), error);
+                    return -1;
+                }
+                config.botCount = static_cast<uint32_t>(tempBots);
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Invalid soak length or bot count - " + std::string(e.what()), error);
+            return -1;
+        }
+        if (config.hours <= 0.0f) {
+            Utils::printMsg("Error: Soak length must be positive", error);
+            return -1;
+        }
+        if (argc > 4) {
+            config.csvPath = argv[4];
+        }
+        return SoakTest::Run(config);
+#else
+        Utils::printMsg("Error: This is a headless server build, the soak test's bots need the client build", error);
+        return -1;
+#endif
+    }
+    // Offline capture report: --analyze-capture <file> [bucket seconds]
+    if (argc > 2 && std::string(argv[1]) == "--analyze-capture") {
+        float bucketSeconds = 1.0f;
+        if (argc > 3) {
+            try {
+                bucketSeconds = std::stof(argv[3]);
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid bucket length (" + std::string(argv[3]) + ") - " + std::string(e.what()), error);
+                return -1;
+            }
+        }
+        return runCaptureAnalysis(argv[2], bucketSeconds);
+    }
     Utils::printMsg("Tank Game - Multiplayer");
     std::cout << "Choose mode:\n";
     std::cout << "1. Start Server\n";
     std::cout << "2. Join as Player\n";
-    std::cout << "Enter choice (1 or 2): ";
+    std::cout << "3. Run Benchmarks\n";
+    std::cout << "4. Run Bot Load Test\n";
+    std::cout << "5. Replay Recorded Match\n";
+    std::cout << "6. Pack Assets (build step)\n";
+    std::cout << "7. Run Directory Service\n";
+    std::cout << "8. Analyze Packet Capture\n";
+    std::cout << "9. Run Spectator Relay\n";
+    std::cout << "Enter choice (1-9): ";
     std::string choice;
     std::getline(std::cin, choice);
     if (choice == "1") {
@@ -310,11 +1376,108 @@ int main() {
         return runServer();
     }
     else if (choice == "2") {
+#ifndef HEADLESS_SERVER
         Utils::printMsg("Starting client mode...");
         return runClient();
+#else
+        Utils::printMsg("Error: This is a headless server build, client mode is not available", error);
+        return -1;
+#endif
+    }
+    else if (choice == "3") {
+        Utils::printMsg("Running benchmarks...");
+        return Benchmarks::RunAll();
+    }
+    else if (choice == "4") {
+#ifndef HEADLESS_SERVER
+        return runBotClient();
+#else
+        Utils::printMsg("Error: This is a headless server build, bots need the client build", error);
+        return -1;
+#endif
+    }
+    else if (choice == "5") {
+        Utils::printMsg("Replaying match...");
+        return runReplay();
+    }
+    else if (choice == "6") {
+#ifndef HEADLESS_SERVER
+        return AssetManager::PackArchive(AssetManager::DEFAULT_ARCHIVE_PATH, "Assets") ? 0 : -1;
+#else
+        Utils::printMsg("Error: This is a headless server build, packing assets needs the client build", error);
+        return -1;
+#endif
+    }
+    else if (choice == "7") {
+        std::cout << "Directory port (default " << Directory::DEFAULT_PORT << "): ";
+        std::string input;
+        std::getline(std::cin, input);
+        unsigned short port = Directory::DEFAULT_PORT;
+        if (!input.empty()) {
+            try {
+                int tempPort = std::stoi(input);
+                if (tempPort < 0 || tempPort > 65535 || !IsValidPort(static_cast<unsigned short>(tempPort))) {
+                    Utils::printMsg("Error: Port must be between 1024 and 65535, using default", error);
+                }
+                else {
+                    port = static_cast<unsigned short>(tempPort);
+                }
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid port input (" + input + "), using default - " + std::string(e.what()), error);
+            }
+        }
+        return runDirectoryService(port, true);
+    }
+    else if (choice == "8") {
+        std::cout << "Packet capture to analyze: ";
+        std::string path;
+        std::getline(std::cin, path);
+        return runCaptureAnalysis(path, 1.0f);
+    }
+    else if (choice == "9") {
+        std::cout << "Server to relay (host[:port]): ";
+        std::string upstream;
+        std::getline(std::cin, upstream);
+        std::cout << "Room to relay (default 0): ";
+        std::string input;
+        std::getline(std::cin, input);
+        uint16_t room = 0;
+        if (!input.empty()) {
+            try {
+                int tempRoom = std::stoi(input);
+                if (tempRoom < 0 || tempRoom >= RoomServer::MAX_ROOMS) {
+                    Utils::printMsg("Error: Room out of range, using room 0", error);
+                }
+                else {
+                    room = static_cast<uint16_t>(tempRoom);
+                }
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid room input (" + input + "), using room 0 - " + std::string(e.what()), error);
+            }
+        }
+        std::cout << "Relay port (default " << SpectatorRelay::DEFAULT_PORT << "): ";
+        std::getline(std::cin, input);
+        unsigned short port = SpectatorRelay::DEFAULT_PORT;
+        if (!input.empty()) {
+            try {
+                int tempPort = std::stoi(input);
+                if (tempPort < 0 || tempPort > 65535 || !IsValidPort(static_cast<unsigned short>(tempPort))) {
+                    Utils::printMsg("Error: Port must be between 1024 and 65535, using default", error);
+                }
+                else {
+                    port = static_cast<unsigned short>(tempPort);
+                }
+            }
+            catch (const std::exception& e) {
+                Utils::printMsg("Error: Invalid port input (" + input + "), using default - " + std::string(e.what()), error);
+            }
+        }
+        return runSpectatorRelay(upstream, port, room, true);
     }
     else {
-        Utils::printMsg("Error: Invalid choice (" + choice + "). Must be '1' or '2'", error);
+        Utils::printMsg("Error: Invalid choice (" + choice + "). Must be '1' to '9'", error);
         return -1;
     }
 }
\ No newline at end of file
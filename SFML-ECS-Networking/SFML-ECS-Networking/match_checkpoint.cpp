@@ -0,0 +1,416 @@
+#include "match_checkpoint.h"
+#include "thread_tuning.h"
+#include "trace_recorder.h"
+#include "utils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    constexpr char MAGIC[4] = { 'T', 'G', 'C', 'P' };
+    constexpr size_t TRAILER_BYTES = 8;
+
+    constexpr uint8_t FLAG_FORWARD = 1 << 0;
+    constexpr uint8_t FLAG_BACKWARD = 1 << 1;
+    constexpr uint8_t FLAG_LEFT = 1 << 2;
+    constexpr uint8_t FLAG_RIGHT = 1 << 3;
+    constexpr uint8_t FLAG_DEAD = 1 << 4;
+
+    uint64_t Fnv1a(const uint8_t* data, size_t size) {
+        uint64_t hash = 1469598103934665603ull;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    class Writer {
+    public:
+        explicit Writer(std::vector<uint8_t>& out) : out(out) {}
+
+        void Put(uint64_t value, size_t bytes) {
+            for (size_t i = 0; i < bytes; ++i) {
+                out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+            }
+        }
+        void PutFloat(float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            Put(bits, 4);
+        }
+        void PutBytes(const void* data, size_t size) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            out.insert(out.end(), bytes, bytes + size);
+        }
+
+    private:
+        std::vector<uint8_t>& out;
+    };
+
+    // Reads stop at the end of the data; IsValid tells whether any ran past it
+    class Reader {
+    public:
+        Reader(const uint8_t* data, size_t size) : data(data), size(size), position(0), valid(true) {}
+
+        uint64_t Get(size_t bytes) {
+            if (!valid || size - position < bytes) {
+                valid = false;
+                return 0;
+            }
+            uint64_t value = 0;
+            for (size_t i = 0; i < bytes; ++i) {
+                value |= static_cast<uint64_t>(data[position + i]) << (8 * i);
+            }
+            position += bytes;
+            return value;
+        }
+        float GetFloat() {
+            const uint32_t bits = static_cast<uint32_t>(Get(4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        bool GetBytes(void* target, size_t bytes) {
+            if (!valid || size - position < bytes) {
+                valid = false;
+                return false;
+            }
+            std::memcpy(target, data + position, bytes);
+            position += bytes;
+            return true;
+        }
+        bool IsValid() const { return valid; }
+        bool AtEnd() const { return position == size; }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t position;
+        bool valid;
+    };
+}
+
+void MatchCheckpoint::Clear() {
+    players.clear();
+    enemies.clear();
+    bullets.clear();
+}
+
+namespace CheckpointFormat {
+    void Encode(const MatchCheckpoint& checkpoint, std::vector<uint8_t>& out) {
+        out.clear();
+        Writer writer(out);
+        writer.PutBytes(MAGIC, sizeof(MAGIC));
+        writer.Put(MatchCheckpoint::VERSION, 2);
+        writer.Put(checkpoint.savedAtMs, 8);
+        writer.Put(checkpoint.tick, 4);
+        writer.Put(checkpoint.tickRate, 2);
+        writer.Put(checkpoint.seed, 4);
+        writer.Put(checkpoint.seedSet ? 1 : 0, 1);
+        writer.Put(checkpoint.handoff ? 1 : 0, 1);
+
+        writer.Put(checkpoint.nextPlayerId, 4);
+        writer.Put(checkpoint.nextEnemyId, 4);
+        writer.Put(checkpoint.nextBulletId, 4);
+        writer.Put(checkpoint.outgoingSequence, 4);
+        writer.Put(checkpoint.playerTableVersion, 4);
+        writer.Put(checkpoint.enemySpawnTicks, 4);
+
+        writer.Put(checkpoint.players.size(), 2);
+        for (const MatchCheckpoint::Player& player : checkpoint.players) {
+            const PlayerData& state = player.state;
+            const size_t nameLength = std::min<size_t>(player.name.size(), UINT8_MAX);
+            writer.Put(player.playerId, 4);
+            writer.Put(nameLength, 1);
+            writer.PutBytes(player.name.data(), nameLength);
+            writer.Put(player.connectionToken, 8);
+            writer.Put(player.address, 4);
+            writer.Put(player.port, 2);
+            writer.Put(static_cast<uint8_t>(state.color), 1);
+            writer.Put((state.isMoving_forward ? FLAG_FORWARD : 0) | (state.isMoving_backward ? FLAG_BACKWARD : 0) |
+                (state.isMoving_left ? FLAG_LEFT : 0) | (state.isMoving_right ? FLAG_RIGHT : 0) |
+                (state.isDead ? FLAG_DEAD : 0), 1);
+            writer.PutFloat(state.x);
+            writer.PutFloat(state.y);
+            writer.PutFloat(state.bodyRotation);
+            writer.PutFloat(state.barrelRotation);
+            writer.PutFloat(state.health);
+            writer.PutFloat(state.maxHealth);
+            writer.Put(static_cast<uint32_t>(state.score), 4);
+            writer.Put(player.respawnTicks, 4);
+            if (checkpoint.handoff) {
+                const MatchCheckpoint::Session& session = player.session;
+                writer.Put(session.active ? 1 : 0, 1);
+                writer.Put(session.nextSnapshotSequence, 4);
+                writer.Put(session.lastReceivedInputSeq, 4);
+                writer.Put(session.lastAcknowledgedInputSeq, 4);
+                writer.Put(session.ackedPlayerTableVersion, 4);
+                writer.Put(session.reliableFirstSequence, 2);
+                writer.Put(session.reliable.size(), 2);
+                for (const MatchCheckpoint::Session::ReliableMessage& message : session.reliable) {
+                    writer.Put(message.acked ? 1 : 0, 1);
+                    writer.Put(message.bytes.size(), 2);
+                    writer.PutBytes(message.bytes.data(), message.bytes.size());
+                }
+            }
+        }
+
+        writer.Put(checkpoint.enemies.size(), 2);
+        for (const MatchCheckpoint::Enemy& enemy : checkpoint.enemies) {
+            writer.Put(enemy.enemyId, 4);
+            writer.Put(enemy.type, 1);
+            writer.PutFloat(enemy.x);
+            writer.PutFloat(enemy.y);
+            writer.PutFloat(enemy.bodyRotation);
+            writer.PutFloat(enemy.barrelRotation);
+            writer.PutFloat(enemy.health);
+            writer.PutFloat(enemy.maxHealth);
+        }
+
+        writer.Put(checkpoint.bullets.size(), 2);
+        for (const MatchCheckpoint::Bullet& bullet : checkpoint.bullets) {
+            writer.Put(bullet.bulletId, 4);
+            writer.Put(bullet.ownerId, 4);
+            writer.Put(bullet.type, 1);
+            writer.Put(bullet.layer, 1);
+            writer.PutFloat(bullet.x);
+            writer.PutFloat(bullet.y);
+            writer.PutFloat(bullet.directionX);
+            writer.PutFloat(bullet.directionY);
+            writer.PutFloat(bullet.flownSeconds);
+        }
+
+        writer.Put(Fnv1a(out.data(), out.size()), TRAILER_BYTES);
+    }
+
+    /**
+     * The trailer is checked before anything is read, so a damaged file is
+     * refused whole instead of restoring half a match.
+     */
+    bool Decode(const std::vector<uint8_t>& bytes, MatchCheckpoint& out) {
+        if (bytes.size() < sizeof(MAGIC) + TRAILER_BYTES || std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC)) != 0) {
+            return false;
+        }
+        const size_t bodySize = bytes.size() - TRAILER_BYTES;
+        Reader trailer(bytes.data() + bodySize, TRAILER_BYTES);
+        if (trailer.Get(TRAILER_BYTES) != Fnv1a(bytes.data(), bodySize)) {
+            return false;
+        }
+
+        Reader reader(bytes.data() + sizeof(MAGIC), bodySize - sizeof(MAGIC));
+        if (reader.Get(2) != MatchCheckpoint::VERSION) {
+            return false;
+        }
+        out.Clear();
+        out.savedAtMs = reader.Get(8);
+        out.tick = static_cast<uint32_t>(reader.Get(4));
+        out.tickRate = static_cast<uint16_t>(reader.Get(2));
+        out.seed = static_cast<uint32_t>(reader.Get(4));
+        out.seedSet = reader.Get(1) != 0;
+        out.handoff = reader.Get(1) != 0;
+
+        out.nextPlayerId = static_cast<uint32_t>(reader.Get(4));
+        out.nextEnemyId = static_cast<uint32_t>(reader.Get(4));
+        out.nextBulletId = static_cast<uint32_t>(reader.Get(4));
+        out.outgoingSequence = static_cast<uint32_t>(reader.Get(4));
+        out.playerTableVersion = static_cast<uint32_t>(reader.Get(4));
+        out.enemySpawnTicks = static_cast<uint32_t>(reader.Get(4));
+
+        const size_t playerCount = static_cast<size_t>(reader.Get(2));
+        for (size_t i = 0; i < playerCount && reader.IsValid(); ++i) {
+            MatchCheckpoint::Player& player = out.players.emplace_back();
+            PlayerData& state = player.state;
+            player.playerId = static_cast<uint32_t>(reader.Get(4));
+            player.name.resize(static_cast<size_t>(reader.Get(1)));
+            reader.GetBytes(player.name.data(), player.name.size());
+            player.connectionToken = reader.Get(8);
+            player.address = static_cast<uint32_t>(reader.Get(4));
+            player.port = static_cast<unsigned short>(reader.Get(2));
+            const uint8_t colorId = static_cast<uint8_t>(reader.Get(1));
+            state.color = NetworkUtils::IsValidColorId(colorId) ? static_cast<PlayerColor>(colorId) : PlayerColor::GREEN;
+            const uint8_t flags = static_cast<uint8_t>(reader.Get(1));
+            state.isMoving_forward = (flags & FLAG_FORWARD) != 0;
+            state.isMoving_backward = (flags & FLAG_BACKWARD) != 0;
+            state.isMoving_left = (flags & FLAG_LEFT) != 0;
+            state.isMoving_right = (flags & FLAG_RIGHT) != 0;
+            state.isDead = (flags & FLAG_DEAD) != 0;
+            state.playerId = player.playerId;
+            state.x = reader.GetFloat();
+            state.y = reader.GetFloat();
+            state.bodyRotation = reader.GetFloat();
+            state.barrelRotation = reader.GetFloat();
+            state.health = reader.GetFloat();
+            state.maxHealth = reader.GetFloat();
+            state.score = static_cast<int32_t>(reader.Get(4));
+            player.respawnTicks = static_cast<uint32_t>(reader.Get(4));
+            if (out.handoff) {
+                MatchCheckpoint::Session& session = player.session;
+                session.active = reader.Get(1) != 0;
+                session.nextSnapshotSequence = static_cast<uint32_t>(reader.Get(4));
+                session.lastReceivedInputSeq = static_cast<uint32_t>(reader.Get(4));
+                session.lastAcknowledgedInputSeq = static_cast<uint32_t>(reader.Get(4));
+                session.ackedPlayerTableVersion = static_cast<uint32_t>(reader.Get(4));
+                session.reliableFirstSequence = static_cast<uint16_t>(reader.Get(2));
+                const size_t messageCount = static_cast<size_t>(reader.Get(2));
+                for (size_t m = 0; m < messageCount && reader.IsValid(); ++m) {
+                    MatchCheckpoint::Session::ReliableMessage& message = session.reliable.emplace_back();
+                    message.acked = reader.Get(1) != 0;
+                    message.bytes.resize(static_cast<size_t>(reader.Get(2)));
+                    reader.GetBytes(message.bytes.data(), message.bytes.size());
+                }
+            }
+        }
+
+        const size_t enemyCount = static_cast<size_t>(reader.Get(2));
+        for (size_t i = 0; i < enemyCount && reader.IsValid(); ++i) {
+            MatchCheckpoint::Enemy& enemy = out.enemies.emplace_back();
+            enemy.enemyId = static_cast<uint32_t>(reader.Get(4));
+            enemy.type = static_cast<uint8_t>(reader.Get(1));
+            enemy.x = reader.GetFloat();
+            enemy.y = reader.GetFloat();
+            enemy.bodyRotation = reader.GetFloat();
+            enemy.barrelRotation = reader.GetFloat();
+            enemy.health = reader.GetFloat();
+            enemy.maxHealth = reader.GetFloat();
+        }
+
+        const size_t bulletCount = static_cast<size_t>(reader.Get(2));
+        for (size_t i = 0; i < bulletCount && reader.IsValid(); ++i) {
+            MatchCheckpoint::Bullet& bullet = out.bullets.emplace_back();
+            bullet.bulletId = static_cast<uint32_t>(reader.Get(4));
+            bullet.ownerId = static_cast<uint32_t>(reader.Get(4));
+            bullet.type = static_cast<uint8_t>(reader.Get(1));
+            bullet.layer = static_cast<uint8_t>(reader.Get(1));
+            bullet.x = reader.GetFloat();
+            bullet.y = reader.GetFloat();
+            bullet.directionX = reader.GetFloat();
+            bullet.directionY = reader.GetFloat();
+            bullet.flownSeconds = reader.GetFloat();
+        }
+        return reader.IsValid() && reader.AtEnd();
+    }
+
+    bool Load(const std::string& path, MatchCheckpoint& out) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return Decode(bytes, out);
+    }
+}
+
+bool CheckpointWriter::Start(const std::string& checkpointPath) {
+    Stop();
+    path = checkpointPath;
+    try {
+        stopping = false;
+        thread = std::thread(&CheckpointWriter::Run, this);
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Failed to start checkpoint thread: " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+void CheckpointWriter::Stop() {
+    if (!thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void CheckpointWriter::Submit() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (busy.load(std::memory_order_relaxed) || !thread.joinable()) {
+            stats.skipped++;
+            return;
+        }
+        std::swap(staging, writing);
+        busy.store(true, std::memory_order_release);
+    }
+    wake.notify_one();
+}
+
+void CheckpointWriter::Remove() {
+    if (!path.empty()) {
+        std::remove(path.c_str());
+    }
+}
+
+CheckpointWriter::Stats CheckpointWriter::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+/**
+ * Writer loop: one checkpoint at a time. A checkpoint submitted just before
+ * Stop is still written.
+ */
+void CheckpointWriter::Run() {
+    TraceRecorder::SetThreadName("Checkpoint");
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::WORKER);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || busy.load(std::memory_order_relaxed); });
+        if (!busy.load(std::memory_order_relaxed)) {
+            return;     // Stopping with nothing left to write
+        }
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        bool written = false;
+        try {
+            TRACE_SCOPE("Write checkpoint", "checkpoint");
+            CheckpointFormat::Encode(writing, encoded);
+            written = WriteFile(encoded);
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in checkpoint thread: " + std::string(e.what()), error);
+        }
+        const int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        if (written) {
+            stats.written++;
+            stats.lastBytes = encoded.size();
+            stats.lastWriteMicros = micros;
+        }
+        else {
+            stats.failed++;
+        }
+        busy.store(false, std::memory_order_release);
+    }
+}
+
+bool CheckpointWriter::WriteFile(const std::vector<uint8_t>& bytes) {
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        file.flush();
+        if (!file) {
+            return false;
+        }
+    }
+    // Replaces the previous checkpoint in one step (the standard leaves an
+    // existing target to the platform, so Windows needs it removed first)
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::remove(path.c_str());
+        return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+    return true;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "network_messages.h"
+
+// Periodic checkpoint of a running match, so a replacement server process can
+// pick the match up where a crashed one left it (see GameServer::SetCheckpoint).
+// It holds what the simulation needs to carry on: the players with their
+// sessions (tokens and endpoints, so their clients can resume), the enemies,
+// the bullets in flight, the pending timers as ticks left, the ID counters and
+// the match seed (all the RNG streams need, see random_stream.h). Connection
+// state that a client rebuilds by itself (snapshot baselines, input buffers,
+// interest sets) is not saved, and enemy AI restarts from its spawn state. A
+// handoff to another process (see handoff.h) also carries each session's
+// numbering and unacked reliable messages, so its clients carry on without
+// resuming.
+//
+// Layout, all integers little-endian, floats as their bits:
+//   header:  "TGCP" uint16 version, uint64 savedAtMs (system clock), uint32 tick,
+//            uint16 tickRate, uint32 seed, uint8 seedSet, uint8 handoff
+//   world:   uint32 nextPlayerId, nextEnemyId, nextBulletId, outgoingSequence,
+//            playerTableVersion, uint32 enemySpawnTicks (0 = due)
+//   players: uint16 count, then per player uint32 id, uint8 nameLength, name,
+//            uint64 token, uint32 address, uint16 port, uint8 color, uint8 flags,
+//            float x, y, bodyRotation, barrelRotation, health, maxHealth,
+//            int32 score, uint32 respawnTicks, and with handoff set its session:
+//            uint8 active, uint32 nextSnapshotSequence, lastReceivedInputSeq,
+//            lastAcknowledgedInputSeq, ackedPlayerTableVersion, uint16 reliableFirstSequence,
+//            uint16 reliableCount, then per message uint8 acked, uint16 size, bytes
+//   enemies: uint16 count, then uint32 id, uint8 type, float x, y, bodyRotation,
+//            barrelRotation, health, maxHealth
+//   bullets: uint16 count, then uint32 id, uint32 owner, uint8 type, uint8 layer,
+//            float x, y, directionX, directionY, flownSeconds
+//   trailer: uint64 FNV-1a of everything before it
+struct MatchCheckpoint {
+    static constexpr uint16_t VERSION = 3;     // 3: no RNG state
+
+    // Connection state a handoff keeps, so the client does not notice the new process
+    struct Session {
+        struct ReliableMessage {
+            bool acked = false;
+            std::vector<uint8_t> bytes;
+        };
+        bool active = false;            // Connected, rather than suspended
+        uint32_t nextSnapshotSequence = 1;
+        uint32_t lastReceivedInputSeq = 0;
+        uint32_t lastAcknowledgedInputSeq = 0;
+        uint32_t ackedPlayerTableVersion = 0;
+        uint16_t reliableFirstSequence = 0;
+        std::vector<ReliableMessage> reliable;  // Held by the sender, oldest first, sequences from reliableFirstSequence
+    };
+
+    struct Player {
+        uint32_t playerId = 0;
+        std::string name;
+        uint64_t connectionToken = 0;
+        uint32_t address = 0;
+        unsigned short port = 0;
+        PlayerData state;
+        uint32_t respawnTicks = 0;      // Ticks until the respawn, while dead
+        Session session;                // Only with handoff
+    };
+
+    struct Enemy {
+        uint32_t enemyId = 0;
+        uint8_t type = 0;
+        float x = 0.0f, y = 0.0f;
+        float bodyRotation = 0.0f, barrelRotation = 0.0f;
+        float health = 0.0f, maxHealth = 0.0f;
+    };
+
+    struct Bullet {
+        uint32_t bulletId = 0;
+        uint32_t ownerId = 0;
+        uint8_t type = 0;
+        uint8_t layer = 0;              // CollisionLayers::Mask
+        float x = 0.0f, y = 0.0f;
+        float directionX = 0.0f, directionY = 0.0f;
+        float flownSeconds = 0.0f;      // Of its lifetime
+    };
+
+    uint64_t savedAtMs = 0;
+    uint32_t tick = 0;
+    uint16_t tickRate = 0;
+    uint32_t seed = 0;
+    bool seedSet = false;
+    bool handoff = false;               // Written for a handoff: sessions included
+
+    uint32_t nextPlayerId = 0;
+    uint32_t nextEnemyId = 0;
+    uint32_t nextBulletId = 0;
+    uint32_t outgoingSequence = 0;
+    uint32_t playerTableVersion = 0;
+    uint32_t enemySpawnTicks = 0;
+
+    // Cleared rather than replaced between checkpoints, so they keep their capacity
+    std::vector<Player> players;
+    std::vector<Enemy> enemies;
+    std::vector<Bullet> bullets;
+
+    void Clear();
+};
+
+namespace CheckpointFormat {
+    void Encode(const MatchCheckpoint& checkpoint, std::vector<uint8_t>& out);
+    // @return False if the bytes are not a checkpoint of this version, or are cut short or damaged
+    bool Decode(const std::vector<uint8_t>& bytes, MatchCheckpoint& out);
+    // @return False if the file is missing or does not decode
+    bool Load(const std::string& path, MatchCheckpoint& out);
+}
+
+// Writes checkpoints on a thread of its own. The tick fills the staging
+// checkpoint and hands it over with Submit, which swaps it with the one the
+// thread writes from: the tick only pays for copying the world, never for
+// encoding or the disk. A checkpoint is written to "<path>.tmp" and renamed
+// over path, so a crash mid-write leaves the previous one intact. While the
+// thread is still writing, new checkpoints are skipped.
+class CheckpointWriter {
+public:
+    struct Stats {
+        uint64_t written = 0;
+        uint64_t skipped = 0;           // Submitted while the previous one was being written
+        uint64_t failed = 0;
+        size_t lastBytes = 0;
+        int64_t lastWriteMicros = 0;    // Encode and write, on the writer thread
+    };
+
+    ~CheckpointWriter() { Stop(); }
+
+    bool Start(const std::string& checkpointPath);
+    // Writes the checkpoint being written, then stops the thread
+    void Stop();
+    bool IsRunning() const { return thread.joinable(); }
+
+    // True while the previous checkpoint is still being written
+    bool IsBusy() const { return busy.load(std::memory_order_acquire); }
+    // Filled by the tick thread between Submits
+    MatchCheckpoint& GetStaging() { return staging; }
+    // Hands the staging checkpoint to the writer (skipped while busy)
+    void Submit();
+
+    // Deletes the checkpoint file (the match ended cleanly); the writer must be stopped
+    void Remove();
+
+    Stats GetStats() const;
+    const std::string& GetPath() const { return path; }
+
+private:
+    std::string path;
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<bool> busy{ false };
+    bool stopping = false;
+
+    MatchCheckpoint staging;
+    MatchCheckpoint writing;            // Owned by the writer thread while busy
+    std::vector<uint8_t> encoded;       // Writer thread only
+    Stats stats;
+
+    void Run();
+    bool WriteFile(const std::vector<uint8_t>& bytes);
+};
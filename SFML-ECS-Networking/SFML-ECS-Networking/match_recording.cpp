@@ -0,0 +1,447 @@
+#include "match_recording.h"
+#include "match_checkpoint.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char MAGIC[4] = { 'T', 'G', 'M', 'R' };
+    constexpr char INDEX_MAGIC[4] = { 'T', 'G', 'M', 'I' };
+    constexpr size_t FOOTER_BYTES = 8 + sizeof(INDEX_MAGIC);
+    constexpr size_t HEADER_BYTES = sizeof(MAGIC) + 2 + 4 + 2 + 1;
+    constexpr size_t TICK_BYTES = 4 + 8 + 4;        // After the kind byte
+
+    enum RecordKind : uint8_t {
+        RECORD_TICK = 1,
+        RECORD_MESSAGE = 2,
+        RECORD_HASH = 3,
+        RECORD_LOAD = 4,
+        RECORD_KEYFRAME = 5,
+        RECORD_INDEX = 6
+    };
+
+    uint32_t FloatBits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float BitsToFloat(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+bool MatchRecorder::Open(const std::string& path, const MatchHeader& header) {
+    Close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    buffer.reserve(FLUSH_BYTES * 2);
+    bytesWritten = 0;
+    buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    Put(MatchHeader::VERSION, 2);
+    Put(header.seed, 4);
+    Put(header.tickRate, 2);
+    Put(header.flags, 1);
+    keyframes.clear();
+    Flush();
+    return static_cast<bool>(file);
+}
+
+void MatchRecorder::Close() {
+    if (file.is_open()) {
+        WriteIndex();
+        Flush();
+        file.close();
+    }
+}
+
+void MatchRecorder::BeginTick(uint32_t tick, int64_t timestampMs, float deltaTime) {
+    Put(RECORD_TICK, 1);
+    Put(tick, 4);
+    Put(static_cast<uint64_t>(timestampMs), 8);
+    Put(FloatBits(deltaTime), 4);
+}
+
+void MatchRecorder::RecordOverloadLevel(uint8_t level) {
+    Put(RECORD_LOAD, 1);
+    Put(level, 1);
+}
+
+void MatchRecorder::RecordMessage(sf::IpAddress address, unsigned short port, const sf::Packet& message) {
+    const size_t size = std::min<size_t>(message.getDataSize(), UINT16_MAX);
+    Put(RECORD_MESSAGE, 1);
+    Put(address.toInteger(), 4);
+    Put(port, 2);
+    Put(size, 2);
+    const uint8_t* data = static_cast<const uint8_t*>(message.getData());
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+void MatchRecorder::EndTick(uint64_t stateHash) {
+    Put(RECORD_HASH, 1);
+    Put(stateHash, 8);
+    if (buffer.size() >= FLUSH_BYTES) {
+        Flush();
+    }
+}
+
+void MatchRecorder::RecordKeyframe(uint32_t tick, uint8_t overloadLevel, const std::vector<uint8_t>& checkpoint) {
+    keyframes.push_back(ReplayKeyframe{ tick, GetBytesWritten() });
+    Put(RECORD_KEYFRAME, 1);
+    Put(tick, 4);
+    Put(overloadLevel, 1);
+    Put(checkpoint.size(), 4);
+    buffer.insert(buffer.end(), checkpoint.begin(), checkpoint.end());
+}
+
+void MatchRecorder::WriteIndex() {
+    const uint64_t indexOffset = GetBytesWritten();
+    Put(RECORD_INDEX, 1);
+    Put(keyframes.size(), 4);
+    for (const ReplayKeyframe& keyframe : keyframes) {
+        Put(keyframe.tick, 4);
+        Put(keyframe.offset, 8);
+    }
+    Put(indexOffset, 8);
+    buffer.insert(buffer.end(), INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+}
+
+void MatchRecorder::Put(uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void MatchRecorder::Flush() {
+    if (!buffer.empty() && file.is_open()) {
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        file.flush();
+        bytesWritten += buffer.size();
+    }
+    buffer.clear();
+}
+
+MatchReader::MatchReader()
+    : mappedData(nullptr), mappedSize(0),
+#ifdef _WIN32
+    fileHandle(nullptr), mappingHandle(nullptr)
+#else
+    fileDescriptor(-1)
+#endif
+{
+}
+
+bool MatchReader::Open(const std::string& path) {
+    Close();
+    if (!Map(path)) {
+        return false;
+    }
+    uint64_t version = 0, seed = 0, tickRate = 0, flags = 0;
+    if (mappedSize < HEADER_BYTES || std::memcmp(mappedData, MAGIC, sizeof(MAGIC)) != 0) {
+        Close();
+        return false;
+    }
+    position = sizeof(MAGIC);
+    if (!Get(version, 2) || version != MatchHeader::VERSION ||
+        !Get(seed, 4) || !Get(tickRate, 2) || !Get(flags, 1)) {
+        Close();
+        return false;
+    }
+    header.seed = static_cast<uint32_t>(seed);
+    header.tickRate = static_cast<uint16_t>(tickRate);
+    header.flags = static_cast<uint8_t>(flags);
+    if (!ReadIndex()) {
+        FindKeyframes();
+    }
+    position = HEADER_BYTES;
+    return true;
+}
+
+void MatchReader::Close() {
+#ifdef _WIN32
+    if (mappedData) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    if (mappedData) {
+        munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+    }
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+    fileDescriptor = -1;
+#endif
+    mappedData = nullptr;
+    mappedSize = 0;
+    position = 0;
+    keyframes.clear();
+    corrupt = false;
+}
+
+bool MatchReader::Map(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        Close();
+        return false;
+    }
+    mappedData = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    struct stat fileInfo;
+    if (fstat(fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0) {
+        Close();
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapping != MAP_FAILED) {
+        mappedData = static_cast<const uint8_t*>(mapping);
+        mappedSize = static_cast<size_t>(fileInfo.st_size);
+    }
+#endif
+    if (!mappedData) {
+        Utils::printMsg("Warning: Could not memory-map " + path, warning);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * The footer's offset must land on an INDEX record whose entries all point
+ * at KEYFRAME records inside the file; anything else counts as no index.
+ */
+bool MatchReader::ReadIndex() {
+    if (mappedSize < HEADER_BYTES + FOOTER_BYTES ||
+        std::memcmp(mappedData + mappedSize - sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        return false;
+    }
+    uint64_t indexOffset = 0, kind = 0, count = 0;
+    position = mappedSize - FOOTER_BYTES;
+    if (!Get(indexOffset, 8) || indexOffset < HEADER_BYTES || indexOffset >= mappedSize - FOOTER_BYTES) {
+        return false;
+    }
+    position = static_cast<size_t>(indexOffset);
+    if (!Get(kind, 1) || kind != RECORD_INDEX || !Get(count, 4) || count > (mappedSize - position) / 12) {
+        return false;
+    }
+    keyframes.resize(static_cast<size_t>(count));
+    for (ReplayKeyframe& keyframe : keyframes) {
+        uint64_t tick = 0, offset = 0;
+        if (!Get(tick, 4) || !Get(offset, 8) || offset >= indexOffset || mappedData[offset] != RECORD_KEYFRAME) {
+            keyframes.clear();
+            return false;
+        }
+        keyframe.tick = static_cast<uint32_t>(tick);
+        keyframe.offset = offset;
+    }
+    return true;
+}
+
+/**
+ * Walks the record headers, skipping message and keyframe bodies, up to the
+ * first truncated or unknown record.
+ */
+void MatchReader::FindKeyframes() {
+    keyframes.clear();
+    position = HEADER_BYTES;
+    uint64_t kind = 0, value = 0;
+    while (Get(kind, 1)) {
+        bool complete = false;
+        switch (kind) {
+        case RECORD_TICK:
+            complete = mappedSize - position >= TICK_BYTES;
+            position += complete ? TICK_BYTES : 0;
+            break;
+        case RECORD_MESSAGE:
+            complete = mappedSize - position >= 8;
+            if (complete) {
+                position += 6;
+                complete = Get(value, 2) && mappedSize - position >= value;
+                position += complete ? static_cast<size_t>(value) : 0;
+            }
+            break;
+        case RECORD_HASH:
+            complete = Get(value, 8);
+            break;
+        case RECORD_LOAD:
+            complete = Get(value, 1);
+            break;
+        case RECORD_KEYFRAME: {
+            const size_t offset = position - 1;
+            uint64_t tick = 0;
+            complete = Get(tick, 4);
+            position = offset + 1;
+            if (complete && SkipKeyframe()) {
+                keyframes.push_back(ReplayKeyframe{ static_cast<uint32_t>(tick), offset });
+            }
+            else {
+                complete = false;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        if (!complete) {
+            return;
+        }
+    }
+}
+
+bool MatchReader::SkipKeyframe() {
+    uint64_t tick = 0, level = 0, size = 0;
+    if (!Get(tick, 4) || !Get(level, 1) || !Get(size, 4) || mappedSize - position < size) {
+        return false;
+    }
+    position += static_cast<size_t>(size);
+    return true;
+}
+
+bool MatchReader::SeekToKeyframe(uint32_t tick, MatchCheckpoint& out, RecordedTick& next) {
+    const auto after = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+        [](uint32_t value, const ReplayKeyframe& keyframe) { return value < keyframe.tick; });
+    if (after == keyframes.begin()) {
+        return false;
+    }
+    const size_t savedPosition = position;
+    position = static_cast<size_t>((after - 1)->offset) + 1;
+    uint64_t keyframeTick = 0, level = 0, size = 0;
+    if (!Get(keyframeTick, 4) || !Get(level, 1) || !Get(size, 4) || mappedSize - position < size) {
+        position = savedPosition;
+        return false;
+    }
+    scratch.assign(mappedData + position, mappedData + position + size);
+    if (!CheckpointFormat::Decode(scratch, out)) {
+        position = savedPosition;
+        return false;
+    }
+    position += static_cast<size_t>(size);
+    next.overloadLevel = static_cast<uint8_t>(level);
+    return true;
+}
+
+/**
+ * Reads one TICK record and the LOAD and MESSAGE records after it, up to and
+ * including its HASH. Keyframes between ticks are skipped, and the index
+ * ends the ticks. A recording cut off mid-tick (server killed) ends at the
+ * last complete tick.
+ */
+bool MatchReader::ReadTick(RecordedTick& out) {
+    uint64_t kind = 0;
+    if (!Get(kind, 1)) {
+        return false;   // Clean end of file
+    }
+    if (kind == RECORD_KEYFRAME) {
+        if (!SkipKeyframe()) {
+            corrupt = true;
+            return false;
+        }
+        if (!Get(kind, 1)) {
+            return false;
+        }
+    }
+    if (kind == RECORD_INDEX) {
+        return false;
+    }
+    uint64_t tick = 0, timestamp = 0, deltaBits = 0;
+    if (kind != RECORD_TICK || !Get(tick, 4) || !Get(timestamp, 8) || !Get(deltaBits, 4)) {
+        corrupt = true;
+        return false;
+    }
+    out.tick = static_cast<uint32_t>(tick);
+    out.timestampMs = static_cast<int64_t>(timestamp);
+    out.deltaTime = BitsToFloat(static_cast<uint32_t>(deltaBits));
+    out.hasStateHash = false;
+    out.messageCount = 0;
+
+    while (Get(kind, 1)) {
+        if (kind == RECORD_HASH) {
+            uint64_t hash = 0;
+            if (!Get(hash, 8)) {
+                break;
+            }
+            out.stateHash = hash;
+            out.hasStateHash = true;
+            return true;
+        }
+        if (kind == RECORD_LOAD) {
+            uint64_t level = 0;
+            if (!Get(level, 1)) {
+                break;
+            }
+            out.overloadLevel = static_cast<uint8_t>(level);
+            continue;
+        }
+        uint64_t address = 0, port = 0, size = 0;
+        if (kind != RECORD_MESSAGE || !Get(address, 4) || !Get(port, 2) || !Get(size, 2) ||
+            mappedSize - position < size) {
+            break;
+        }
+        if (out.messageCount == out.messages.size()) {
+            out.messages.emplace_back();
+        }
+        RecordedMessage& message = out.messages[out.messageCount++];
+        message.address = sf::IpAddress(static_cast<uint32_t>(address));
+        message.port = static_cast<unsigned short>(port);
+        message.packet.clear();
+        message.packet.append(mappedData + position, static_cast<size_t>(size));
+        position += static_cast<size_t>(size);
+    }
+    corrupt = true;
+    return false;
+}
+
+bool MatchReader::Get(uint64_t& value, size_t bytes) {
+    if (mappedSize - position < bytes) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(mappedData[position + i]) << (8 * i);
+    }
+    position += bytes;
+    return true;
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/Packet.hpp>
+
+struct MatchCheckpoint;
+
+// Match recordings: everything a GameServer needs to rebuild a match offline.
+// The server's only inputs are the datagrams it receives, its clock and its
+// RNG seed, so a recording is the seed, then per tick the frozen timestamp,
+// the step size and every received message, closed by a hash of the world
+// after the tick (see GameServer::ComputeStateHash). Leaves are timeouts
+// counted in ticks, so they replay from the same data. Overload levels are
+// decided from wall time, so each change is recorded in the tick it applies to.
+//
+// For seeking, every few seconds a tick is followed by a keyframe: the whole
+// match as a checkpoint with its sessions (see MatchCheckpoint), as a handoff
+// carries it. Close appends an index of the keyframes and a footer pointing
+// at it, so a reader finds any keyframe without walking the file, restores
+// the server from it and replays only the ticks after it. The file is read
+// through a memory mapping.
+//
+// Layout, all integers little-endian:
+//   header:   "TGMR" uint16 version, uint32 seed, uint16 tickRate, uint8 flags
+//   TICK:     uint8 1, uint32 tick, int64 timestampMs, float deltaTime
+//   MESSAGE:  uint8 2, uint32 address, uint16 port, uint16 size, bytes (connection token first)
+//   HASH:     uint8 3, uint64 stateHash
+//   LOAD:     uint8 4, uint8 overloadLevel (before the tick's messages)
+//   KEYFRAME: uint8 5, uint32 tick, uint8 overloadLevel, uint32 size, checkpoint bytes (after the tick's HASH)
+//   INDEX:    uint8 6, uint32 count, then per keyframe uint32 tick, uint64 offset of its KEYFRAME record
+//   footer:   uint64 offset of the INDEX record, "TGMI" (the last 12 bytes)
+// A recording cut off before Close has no index; the reader then finds the
+// keyframes by walking the records once.
+struct MatchHeader {
+    static constexpr uint16_t VERSION = 4;     // 2: messages carry their connection token, 3: LOAD records, 4: keyframes
+    static constexpr uint8_t FLAG_LAG_COMPENSATION = 1 << 0;
+    static constexpr uint8_t FLAG_ENEMY_AI_LOD = 1 << 1;
+    static constexpr uint8_t FLAG_ENEMY_SQUADS = 1 << 2;
+
+    uint32_t seed = 0;
+    uint16_t tickRate = 0;
+    uint8_t flags = 0;
+};
+
+struct RecordedMessage {
+    sf::IpAddress address = sf::IpAddress::LocalHost;
+    unsigned short port = 0;
+    sf::Packet packet;
+};
+
+struct RecordedTick {
+    uint32_t tick = 0;
+    int64_t timestampMs = 0;
+    float deltaTime = 0.0f;
+    uint64_t stateHash = 0;
+    bool hasStateHash = false;
+    std::vector<RecordedMessage> messages;  // Only the first messageCount are this tick's
+    size_t messageCount = 0;
+    uint8_t overloadLevel = 0;  // Carried over from earlier ticks until a LOAD record changes it
+};
+
+struct ReplayKeyframe {
+    uint32_t tick = 0;
+    uint64_t offset = 0;        // Of its KEYFRAME record
+};
+
+// Outcome of GameServer::RunReplay
+struct ReplayResult {
+    uint32_t keyframeTick = 0;      // The replay started from this keyframe (0 = from the start)
+    double seekSeconds = 0.0;       // Wall time to restore it and reach the tick asked for
+    uint32_t ticks = 0;
+    uint64_t messages = 0;
+    uint32_t hashMismatches = 0;
+    uint32_t firstMismatchTick = 0;
+    double simulatedSeconds = 0.0;  // Sum of the recorded step sizes
+    double seconds = 0.0;           // Wall time spent replaying
+};
+
+// Appends ticks to a recording. Records are staged in memory and written in
+// FLUSH_BYTES chunks, so the tick loop does not wait on the disk.
+class MatchRecorder {
+public:
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;
+
+    ~MatchRecorder() { Close(); }
+
+    bool Open(const std::string& path, const MatchHeader& header);
+    void Close();
+    bool IsOpen() const { return file.is_open(); }
+
+    void BeginTick(uint32_t tick, int64_t timestampMs, float deltaTime);
+    void RecordOverloadLevel(uint8_t level);
+    void RecordMessage(sf::IpAddress address, unsigned short port, const sf::Packet& message);
+    void EndTick(uint64_t stateHash);
+    // After EndTick: the encoded checkpoint of the world at the end of the tick
+    void RecordKeyframe(uint32_t tick, uint8_t overloadLevel, const std::vector<uint8_t>& checkpoint);
+
+    uint64_t GetBytesWritten() const { return bytesWritten + buffer.size(); }
+    size_t GetKeyframeCount() const { return keyframes.size(); }
+
+private:
+    std::ofstream file;
+    std::vector<uint8_t> buffer;
+    uint64_t bytesWritten = 0;
+    std::vector<ReplayKeyframe> keyframes;
+
+    void WriteIndex();
+
+    void Put(uint64_t value, size_t bytes);
+    void Flush();
+};
+
+// Reads a recording back one tick at a time, from a read-only mapping of the file
+class MatchReader {
+public:
+    MatchReader();
+    ~MatchReader() { Close(); }
+
+    MatchReader(const MatchReader&) = delete;
+    MatchReader& operator=(const MatchReader&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    const MatchHeader& GetHeader() const { return header; }
+
+    // Fills out with the next tick and its messages (buffers are reused).
+    // Returns false at the end of the file or on a truncated or unknown record.
+    bool ReadTick(RecordedTick& out);
+
+    // True once ReadTick stopped on something other than a clean end of file
+    bool IsCorrupt() const { return corrupt; }
+
+    // Keyframes in tick order, from the index or found by walking the file
+    const std::vector<ReplayKeyframe>& GetKeyframes() const { return keyframes; }
+    // Decodes the last keyframe at or before tick into out and moves the read
+    // position to the tick after it. The next ReadTick's overload level is the
+    // keyframe's. False if there is none or it does not decode; the read
+    // position is then unchanged.
+    bool SeekToKeyframe(uint32_t tick, MatchCheckpoint& out, RecordedTick& next);
+
+private:
+    const uint8_t* mappedData;
+    size_t mappedSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+    size_t position = 0;
+    MatchHeader header;
+    std::vector<ReplayKeyframe> keyframes;
+    std::vector<uint8_t> scratch;   // Keyframe bytes on their way to the decoder
+    bool corrupt = false;
+
+    bool Map(const std::string& path);
+    bool ReadIndex();
+    void FindKeyframes();
+    bool Get(uint64_t& value, size_t bytes);
+    // Moves past a KEYFRAME record whose kind byte was just read
+    bool SkipKeyframe();
+};
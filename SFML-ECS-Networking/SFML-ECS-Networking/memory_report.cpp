@@ -0,0 +1,100 @@
+#include "memory_report.h"
+#include "metrics_exporter.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+void MemoryReport::Add(const char* subsystem, size_t count, size_t bytes) {
+    for (Line& line : lines) {
+        if (std::strcmp(line.subsystem, subsystem) == 0) {
+            line.count += count;
+            line.bytes += bytes;
+            return;
+        }
+    }
+    lines.push_back(Line{ subsystem, count, bytes });
+}
+
+size_t MemoryReport::GetTotalBytes() const {
+    size_t total = 0;
+    for (const Line& line : lines) {
+        total += line.bytes;
+    }
+    return total;
+}
+
+void MemoryReport::AppendText(std::string& text) const {
+    char buffer[96];
+    std::snprintf(buffer, sizeof(buffer), "Memory %s\n", FormatBytes(GetTotalBytes()).c_str());
+    text += buffer;
+    for (const Line& line : lines) {
+        std::snprintf(buffer, sizeof(buffer), "  %-18s %6zu %10s\n",
+            line.subsystem, line.count, FormatBytes(line.bytes).c_str());
+        text += buffer;
+    }
+}
+
+void MemoryReport::AddMetrics(MetricsPage& page) const {
+    page.Describe("tankgame_memory_objects", "gauge", "Live objects per subsystem");
+    for (const Line& line : lines) {
+        page.Add("tankgame_memory_objects", static_cast<uint64_t>(line.count),
+            "subsystem=\"" + std::string(line.subsystem) + "\"");
+    }
+    page.Describe("tankgame_memory_bytes", "gauge", "Approximate bytes held per subsystem");
+    for (const Line& line : lines) {
+        page.Add("tankgame_memory_bytes", static_cast<uint64_t>(line.bytes),
+            "subsystem=\"" + std::string(line.subsystem) + "\"");
+    }
+}
+
+/**
+ * Windows: the working set. Linux: resident pages from /proc/self/statm.
+ */
+size_t MemoryReport::GetResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long totalPages = 0;
+    unsigned long residentPages = 0;
+    const int read = std::fscanf(file, "%lu %lu", &totalPages, &residentPages);
+    std::fclose(file);
+    return read == 2 ? static_cast<size_t>(residentPages) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
+
+std::string MemoryReport::FormatBytes(size_t bytes) {
+    char text[32];
+    if (bytes < 1024) {
+        std::snprintf(text, sizeof(text), "%zu B", bytes);
+    }
+    else if (bytes < 1024 * 1024) {
+        std::snprintf(text, sizeof(text), "%.1f KiB", static_cast<double>(bytes) / 1024.0);
+    }
+    else {
+        std::snprintf(text, sizeof(text), "%.1f MiB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    }
+    return text;
+}
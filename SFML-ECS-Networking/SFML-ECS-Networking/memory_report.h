@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class MetricsPage;
+
+// Live object counts and approximate bytes per subsystem, filled on demand by
+// the owners (nothing is tracked between reports). The server publishes one
+// with its metrics, the client shows one in the debug overlay.
+//
+// Bytes are estimates from container capacities and element sizes, with a
+// node and bucket overhead for hash maps and width * height * 4 for textures.
+// They are meant for spotting growth and regressions, not for matching what
+// the allocator reports.
+class MemoryReport {
+public:
+    struct Line {
+        const char* subsystem;      // Static string; also the metric label
+        size_t count;               // Live objects: entities, textures, buffers, packets...
+        size_t bytes;
+    };
+
+    void Clear() { lines.clear(); }
+    // Adds to the subsystem's line if it already has one
+    void Add(const char* subsystem, size_t count, size_t bytes);
+
+    const std::vector<Line>& GetLines() const { return lines; }
+    size_t GetTotalBytes() const;
+
+    // "subsystem  count  size" per line, after a total
+    void AppendText(std::string& text) const;
+    // tankgame_memory_objects and tankgame_memory_bytes gauges, labelled by subsystem
+    void AddMetrics(MetricsPage& page) const;
+
+    // Resident set of this process as the OS counts it (0 where it cannot be read)
+    static size_t GetResidentBytes();
+
+    // "512 B", "12.3 KiB", "4.0 MiB"
+    static std::string FormatBytes(size_t bytes);
+
+    // Allocated storage of any number of vectors
+    template <typename... Vectors>
+    static size_t VectorBytes(const Vectors&... vectors) {
+        return (size_t(0) + ... + (vectors.capacity() * sizeof(typename Vectors::value_type)));
+    }
+
+    // Nodes (value, next pointer and cached hash) plus the bucket array
+    template <typename Key, typename Value, typename... Rest>
+    static size_t MapBytes(const std::unordered_map<Key, Value, Rest...>& map) {
+        return map.size() * (sizeof(std::pair<const Key, Value>) + 2 * sizeof(void*)) +
+            map.bucket_count() * sizeof(void*);
+    }
+
+private:
+    std::vector<Line> lines;
+};
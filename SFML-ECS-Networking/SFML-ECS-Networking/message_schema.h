@@ -0,0 +1,356 @@
+#pragma once
+#include <SFML/Network/Packet.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Wire layout of the sf::Packet messages, declared once per type. A Schema
+// specialisation lists the fields in wire order as member pointers; messages
+// also name their type byte:
+//
+//     template <> struct MessageSchema::Schema<PingMessage> {
+//         static constexpr NetMessageType TYPE = NetMessageType::PING;
+//         using Fields = FieldList<&PingMessage::timestamp, &PingMessage::sequenceNumber>;
+//     };
+//
+// Encode, Decode, EncodedSize and the receive dispatch table are generated
+// from that list, so sender and receiver cannot drift apart and every field
+// access inlines. Types without a TYPE are records, written inside messages
+// with no type byte of their own (PlayerData inside GAME_STATE).
+//
+// Fields use sf::Packet's own encoding (bool as one byte, big-endian integers,
+// strings and vectors prefixed with a uint32 count), so the bytes on the wire
+// are the ones the hand-written operators produced. Another field type needs
+// a Codec specialisation; the bit-packed hot messages keep their own
+// Write/Read in NetworkUtils.
+namespace MessageSchema {
+    // Specialised per message or record
+    template <typename T>
+    struct Schema;
+
+    template <auto... Members>
+    struct FieldList {};
+
+    // A schema may also list TrailingFields: appended after the protocol
+    // shipped, so older peers leave them off. Decoding value-initialises those
+    // that are missing.
+
+    template <typename... Messages>
+    struct MessageSet {};
+
+    template <typename T, typename = void>
+    constexpr bool HAS_SCHEMA = false;
+    template <typename T>
+    constexpr bool HAS_SCHEMA<T, std::void_t<typename Schema<T>::Fields>> = true;
+
+    template <typename T, typename = void>
+    constexpr bool IS_MESSAGE = false;
+    template <typename T>
+    constexpr bool IS_MESSAGE<T, std::void_t<decltype(Schema<T>::TYPE)>> = true;
+
+    template <typename T, typename = void>
+    struct TrailingFieldsOf { using Type = FieldList<>; };
+    template <typename T>
+    struct TrailingFieldsOf<T, std::void_t<typename Schema<T>::TrailingFields>> {
+        using Type = typename Schema<T>::TrailingFields;
+    };
+
+    template <typename Member>
+    struct MemberTraits;
+    template <typename Class, typename Value>
+    struct MemberTraits<Value Class::*> {
+        using Type = Value;
+    };
+    template <auto Member>
+    using FieldType = typename MemberTraits<decltype(Member)>::Type;
+
+    // Marks the packet as failed, as a read past its end does, so callers
+    // testing the packet see a rejected value the same way as a truncated one
+    inline void Fail(sf::Packet& packet) {
+        uint8_t discard = 0;
+        while (packet >> discard) {
+        }
+    }
+
+    inline size_t RemainingBytes(const sf::Packet& packet) {
+        return packet.getDataSize() - packet.getReadPosition();
+    }
+
+    // How one field type goes on the wire. MIN_SIZE is the fewest bytes a
+    // value takes; FIXED_SIZE says every value takes exactly that many.
+    template <typename T, typename = void>
+    struct Codec;
+
+    template <typename T>
+    struct Codec<T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+        static constexpr size_t MIN_SIZE = std::is_same_v<T, bool> ? 1 : sizeof(T);
+        static constexpr bool FIXED_SIZE = true;
+
+        static void Write(sf::Packet& packet, T value) { packet << value; }
+        static bool Read(sf::Packet& packet, T& value) { return static_cast<bool>(packet >> value); }
+        static size_t Size(T) { return MIN_SIZE; }
+    };
+
+    // Enums as their underlying type, unchecked; specialise to validate
+    template <typename T>
+    struct Codec<T, std::enable_if_t<std::is_enum_v<T>>> {
+        using Underlying = std::underlying_type_t<T>;
+        static constexpr size_t MIN_SIZE = sizeof(Underlying);
+        static constexpr bool FIXED_SIZE = true;
+
+        static void Write(sf::Packet& packet, T value) { packet << static_cast<Underlying>(value); }
+        static bool Read(sf::Packet& packet, T& value) {
+            Underlying raw = 0;
+            if (!(packet >> raw)) {
+                return false;
+            }
+            value = static_cast<T>(raw);
+            return true;
+        }
+        static size_t Size(T) { return MIN_SIZE; }
+    };
+
+    template <>
+    struct Codec<std::string> {
+        static constexpr size_t MIN_SIZE = sizeof(uint32_t);
+        static constexpr bool FIXED_SIZE = false;
+
+        static void Write(sf::Packet& packet, const std::string& value) { packet << value; }
+        static bool Read(sf::Packet& packet, std::string& value) { return static_cast<bool>(packet >> value); }
+        static size_t Size(const std::string& value) { return MIN_SIZE + value.size(); }
+    };
+
+    // A count that could not fit in the rest of the packet is rejected before
+    // anything is allocated. The vector is resized in place, so a message
+    // reused between reads keeps its capacity.
+    template <typename T>
+    struct Codec<std::vector<T>> {
+        static constexpr size_t MIN_SIZE = sizeof(uint32_t);
+        static constexpr bool FIXED_SIZE = false;
+
+        static void Write(sf::Packet& packet, const std::vector<T>& values) {
+            packet << static_cast<uint32_t>(values.size());
+            for (const T& value : values) {
+                Codec<T>::Write(packet, value);
+            }
+        }
+        static bool Read(sf::Packet& packet, std::vector<T>& values) {
+            uint32_t count = 0;
+            if (!(packet >> count) || count > RemainingBytes(packet) / Codec<T>::MIN_SIZE) {
+                return false;
+            }
+            values.resize(count);
+            for (T& value : values) {
+                if (!Codec<T>::Read(packet, value)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        static size_t Size(const std::vector<T>& values) {
+            if constexpr (Codec<T>::FIXED_SIZE) {
+                return MIN_SIZE + values.size() * Codec<T>::MIN_SIZE;
+            }
+            else {
+                size_t size = MIN_SIZE;
+                for (const T& value : values) {
+                    size += Codec<T>::Size(value);
+                }
+                return size;
+            }
+        }
+    };
+
+    // Fixed element count, so no count prefix: the size is part of the layout
+    template <typename T, size_t N>
+    struct Codec<std::array<T, N>> {
+        static constexpr size_t MIN_SIZE = N * Codec<T>::MIN_SIZE;
+        static constexpr bool FIXED_SIZE = Codec<T>::FIXED_SIZE;
+
+        static void Write(sf::Packet& packet, const std::array<T, N>& values) {
+            for (const T& value : values) {
+                Codec<T>::Write(packet, value);
+            }
+        }
+        static bool Read(sf::Packet& packet, std::array<T, N>& values) {
+            for (T& value : values) {
+                if (!Codec<T>::Read(packet, value)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        static size_t Size(const std::array<T, N>& values) {
+            size_t size = 0;
+            for (const T& value : values) {
+                size += Codec<T>::Size(value);
+            }
+            return size;
+        }
+    };
+
+    template <typename T, auto... Members>
+    void WriteFields(sf::Packet& packet, const T& value, FieldList<Members...>) {
+        (Codec<FieldType<Members>>::Write(packet, value.*Members), ...);
+    }
+
+    template <typename T, auto... Members>
+    bool ReadFields(sf::Packet& packet, T& value, FieldList<Members...>) {
+        return (Codec<FieldType<Members>>::Read(packet, value.*Members) && ...);
+    }
+
+    template <typename T, auto... Members>
+    bool ReadTrailingFields(sf::Packet& packet, T& value, FieldList<Members...>) {
+        return ((packet.endOfPacket() ? (value.*Members = FieldType<Members>(), true)
+            : Codec<FieldType<Members>>::Read(packet, value.*Members)) && ...);
+    }
+
+    template <typename T, auto... Members>
+    size_t FieldsSize(const T& value, FieldList<Members...>) {
+        return (size_t(0) + ... + Codec<FieldType<Members>>::Size(value.*Members));
+    }
+
+    template <auto... Members>
+    constexpr size_t FieldsMinSize(FieldList<Members...>) {
+        return (size_t(0) + ... + Codec<FieldType<Members>>::MIN_SIZE);
+    }
+
+    template <auto... Members>
+    constexpr bool FieldsFixedSize(FieldList<Members...>) {
+        return (true && ... && Codec<FieldType<Members>>::FIXED_SIZE);
+    }
+
+    // Records: the fields one after the other. Trailing fields of a record
+    // would only work at the very end of a message, so records have none.
+    template <typename T>
+    struct Codec<T, std::enable_if_t<HAS_SCHEMA<T> && !IS_MESSAGE<T>>> {
+        using Fields = typename Schema<T>::Fields;
+        static constexpr size_t MIN_SIZE = FieldsMinSize(Fields());
+        static constexpr bool FIXED_SIZE = FieldsFixedSize(Fields());
+
+        static void Write(sf::Packet& packet, const T& value) { WriteFields(packet, value, Fields()); }
+        static bool Read(sf::Packet& packet, T& value) { return ReadFields(packet, value, Fields()); }
+        static size_t Size(const T& value) { return FieldsSize(value, Fields()); }
+    };
+
+    // Message body: what follows the type byte
+    template <typename T>
+    void EncodeBody(sf::Packet& packet, const T& value) {
+        WriteFields(packet, value, typename Schema<T>::Fields());
+        WriteFields(packet, value, typename TrailingFieldsOf<T>::Type());
+    }
+
+    template <typename T>
+    bool DecodeBody(sf::Packet& packet, T& value) {
+        return ReadFields(packet, value, typename Schema<T>::Fields()) &&
+            ReadTrailingFields(packet, value, typename TrailingFieldsOf<T>::Type());
+    }
+
+    // A message with its type byte, or a record on its own
+    template <typename T>
+    void Encode(sf::Packet& packet, const T& value) {
+        if constexpr (IS_MESSAGE<T>) {
+            packet << static_cast<uint8_t>(Schema<T>::TYPE);
+        }
+        EncodeBody(packet, value);
+    }
+
+    // False if the packet ran out, a count was impossible or the type byte
+    // was another message's
+    template <typename T>
+    bool Decode(sf::Packet& packet, T& value) {
+        if constexpr (IS_MESSAGE<T>) {
+            uint8_t type = 0;
+            if (!(packet >> type) || type != static_cast<uint8_t>(Schema<T>::TYPE)) {
+                return false;
+            }
+        }
+        return DecodeBody(packet, value);
+    }
+
+    // Exact bytes Encode appends
+    template <typename T>
+    size_t EncodedSize(const T& value) {
+        return (IS_MESSAGE<T> ? 1 : 0) + FieldsSize(value, typename Schema<T>::Fields()) +
+            FieldsSize(value, typename TrailingFieldsOf<T>::Type());
+    }
+
+    // Exact bytes Encode appends, for types with only fixed-size fields
+    template <typename T>
+    constexpr size_t FixedEncodedSize() {
+        using Fields = typename Schema<T>::Fields;
+        using Trailing = typename TrailingFieldsOf<T>::Type;
+        static_assert(FieldsFixedSize(Fields()) && FieldsFixedSize(Trailing()), "Message has variable-size fields");
+        return (IS_MESSAGE<T> ? 1 : 0) + FieldsMinSize(Fields()) + FieldsMinSize(Trailing());
+    }
+
+    enum class DispatchResult {
+        HANDLED,
+        MALFORMED,      // A message of the set that failed to decode
+        UNKNOWN         // Not a type of the set
+    };
+
+    template <typename... Messages>
+    constexpr bool HasDuplicateTypes() {
+        const uint8_t types[] = { static_cast<uint8_t>(Schema<Messages>::TYPE)... };
+        for (size_t i = 0; i < sizeof...(Messages); ++i) {
+            for (size_t j = i + 1; j < sizeof...(Messages); ++j) {
+                if (types[i] == types[j]) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template <typename Handler, typename Set>
+    struct DispatchTable;
+
+    // One entry per type byte, filled at compile time; each decodes its
+    // message on the stack and passes it to the handler overload for it
+    template <typename Handler, typename... Messages>
+    struct DispatchTable<Handler, MessageSet<Messages...>> {
+        static_assert((IS_MESSAGE<Messages> && ...), "Dispatch sets hold messages, not records");
+        static_assert(!HasDuplicateTypes<Messages...>(), "Two messages of the set share a type byte");
+
+        using Entry = DispatchResult(*)(sf::Packet&, Handler&);
+
+        template <typename Message>
+        static DispatchResult DecodeAndHandle(sf::Packet& packet, Handler& handler) {
+            Message message;
+            if (!DecodeBody(packet, message)) {
+                return DispatchResult::MALFORMED;
+            }
+            handler(message);
+            return DispatchResult::HANDLED;
+        }
+
+        static constexpr std::array<Entry, 256> Build() {
+            std::array<Entry, 256> entries{};
+            ((entries[static_cast<uint8_t>(Schema<Messages>::TYPE)] = &DecodeAndHandle<Messages>), ...);
+            return entries;
+        }
+
+        static constexpr std::array<Entry, 256> ENTRIES = Build();
+    };
+
+    // Decodes the body of a message whose type byte was already read and
+    // calls handler(message). The handler must accept every message of Set.
+    template <typename Set, typename Handler>
+    DispatchResult Dispatch(uint8_t type, sf::Packet& packet, Handler&& handler) {
+        using Table = DispatchTable<std::remove_reference_t<Handler>, Set>;
+        const typename Table::Entry entry = Table::ENTRIES[type];
+        return entry ? entry(packet, handler) : DispatchResult::UNKNOWN;
+    }
+
+    // Builds a handler from one lambda per message
+    template <typename... Handlers>
+    struct Overloaded : Handlers... {
+        using Handlers::operator()...;
+    };
+    template <typename... Handlers>
+    Overloaded(Handlers...) -> Overloaded<Handlers...>;
+}
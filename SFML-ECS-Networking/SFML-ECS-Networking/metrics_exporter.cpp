@@ -0,0 +1,166 @@
+#include "metrics_exporter.h"
+#include "thread_tuning.h"
+#include "utils.h"
+#include <cstdio>
+
+void MetricsPage::Describe(const char* name, const char* type, const char* help) {
+    text += "# HELP ";
+    text += name;
+    text += ' ';
+    text += help;
+    text += "\n# TYPE ";
+    text += name;
+    text += ' ';
+    text += type;
+    text += '\n';
+}
+
+void MetricsPage::Add(const char* name, uint64_t value, const std::string& labels) {
+    AddLine(name, labels, std::to_string(value).c_str());
+}
+
+void MetricsPage::Add(const char* name, double value, const std::string& labels) {
+    char formatted[32];
+    std::snprintf(formatted, sizeof(formatted), "%.3f", value);
+    AddLine(name, labels, formatted);
+}
+
+void MetricsPage::AddLine(const char* name, const std::string& labels, const char* value) {
+    text += name;
+    if (!labels.empty()) {
+        text += '{';
+        text += labels;
+        text += '}';
+    }
+    text += ' ';
+    text += value;
+    text += '\n';
+}
+
+MetricsExporter::MetricsExporter(unsigned short port)
+    : port(port), running(false), scrapeCount(0) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    Stop();
+}
+
+/**
+ * Binds the metrics port and starts the server thread.
+ * @return True if listening
+ */
+bool MetricsExporter::Start() {
+    if (IsRunning()) return true;
+
+    try {
+        if (listener.listen(port) != sf::Socket::Status::Done) {
+            Utils::printMsg("Failed to bind metrics port " + std::to_string(port), error);
+            return false;
+        }
+        running.store(true, std::memory_order_release);
+        worker = std::thread(&MetricsExporter::Run, this);
+        Utils::printMsg("Metrics available at http://<server>:" + std::to_string(port) + "/metrics", success);
+        return true;
+    }
+    catch (const std::exception& e) {
+        running.store(false, std::memory_order_release);
+        listener.close();
+        Utils::printMsg("Failed to start metrics thread: " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+void MetricsExporter::Stop() {
+    if (!running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    try {
+        if (worker.joinable()) {
+            worker.join();
+        }
+        listener.close();
+        Utils::printMsg("Metrics endpoint stopped after " + std::to_string(GetScrapeCount()) + " scrapes", info);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception stopping metrics thread: " + std::string(e.what()), error);
+    }
+}
+
+bool MetricsExporter::Publish(std::string& page) {
+    std::unique_lock<std::mutex> lock(pageMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return false;
+    }
+    publishedPage.swap(page);
+    return true;
+}
+
+/**
+ * Server loop: waits briefly for a connection so Stop() is noticed, then
+ * answers it and closes it.
+ */
+void MetricsExporter::Run() {
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::WORKER);
+    sf::SocketSelector selector;
+    selector.add(listener);
+
+    while (running.load(std::memory_order_acquire)) {
+        try {
+            if (!selector.wait(sf::milliseconds(ACCEPT_TIMEOUT_MS))) {
+                continue;
+            }
+            sf::TcpSocket client;
+            if (listener.accept(client) == sf::Socket::Status::Done) {
+                Serve(client);
+                client.disconnect();
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in metrics thread: " + std::string(e.what()), error);
+        }
+        catch (...) {
+            Utils::printMsg("Unknown exception in metrics thread", error);
+        }
+    }
+}
+
+/**
+ * Reads the request head and answers GET /metrics (or /) with the latest
+ * page, anything else with 404. The page is copied under the lock and sent
+ * after releasing it.
+ */
+void MetricsExporter::Serve(sf::TcpSocket& client) {
+    std::string request;
+    char buffer[1024];
+    sf::SocketSelector selector;
+    selector.add(client);
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        if (!selector.wait(sf::milliseconds(REQUEST_TIMEOUT_MS))) {
+            return;
+        }
+        std::size_t received = 0;
+        if (client.receive(buffer, sizeof(buffer), received) != sf::Socket::Status::Done) {
+            return;
+        }
+        request.append(buffer, received);
+    }
+
+    const bool isMetrics = request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET / ", 0) == 0;
+    std::string body;
+    if (isMetrics) {
+        std::lock_guard<std::mutex> lock(pageMutex);
+        body = publishedPage;
+    }
+    else {
+        body = "Not found. Metrics are at /metrics\n";
+    }
+
+    response = isMetrics ? "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+        : "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    response += body;
+    if (client.send(response.data(), response.size()) == sf::Socket::Status::Done && isMetrics) {
+        scrapeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
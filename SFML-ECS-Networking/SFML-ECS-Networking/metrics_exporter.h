@@ -0,0 +1,66 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Builds a page in the Prometheus text exposition format (version 0.0.4).
+// Labels are passed preformatted, e.g. phase="receive"; values must not need escaping.
+class MetricsPage {
+public:
+    void Clear() { text.clear(); }
+
+    // # HELP and # TYPE lines; type is "counter" or "gauge"
+    void Describe(const char* name, const char* type, const char* help);
+    void Add(const char* name, uint64_t value, const std::string& labels = std::string());
+    void Add(const char* name, double value, const std::string& labels = std::string());
+
+    std::string& GetText() { return text; }
+
+private:
+    std::string text;
+
+    void AddLine(const char* name, const std::string& labels, const char* value);
+};
+
+// Serves the latest published metrics page over HTTP (GET /metrics) on its own
+// port and thread. The simulation thread hands pages over with Publish, which
+// only try-locks: if a scrape is copying the page at that moment the publish
+// is skipped and the caller retries later, so a tick never waits on a scraper.
+// One connection is served at a time; scrapers are expected to be few.
+class MetricsExporter {
+public:
+    static constexpr int ACCEPT_TIMEOUT_MS = 100;      // Stop() latency
+    static constexpr int REQUEST_TIMEOUT_MS = 1000;    // A client that sends nothing is dropped
+    static constexpr size_t MAX_REQUEST_BYTES = 4096;
+
+    explicit MetricsExporter(unsigned short port);
+    ~MetricsExporter();
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const { return running.load(std::memory_order_acquire); }
+    unsigned short GetPort() const { return port; }
+
+    // Simulation thread: swaps page in and hands back the previous buffer to
+    // refill. Returns false, leaving page untouched, if a scrape holds the lock.
+    bool Publish(std::string& page);
+
+    uint64_t GetScrapeCount() const { return scrapeCount.load(std::memory_order_relaxed); }
+
+private:
+    unsigned short port;
+    sf::TcpListener listener;
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> scrapeCount;
+
+    std::mutex pageMutex;
+    std::string publishedPage;      // Guarded by pageMutex
+    std::string response;           // Worker thread only
+
+    void Run();
+    void Serve(sf::TcpSocket& client);
+};
@@ -0,0 +1,139 @@
+#include "minimap.h"
+#include "client_components.h"
+#include "utils.h"
+#include "world_constants.h"
+
+namespace {
+    const sf::Color MAP_FRAME_COLOR(0, 0, 0, 160);
+    const sf::Color ENEMY_DOT_COLOR(220, 60, 50);
+    const sf::Color PLAYER_DOT_COLOR(70, 140, 255);
+    const sf::Color LOCAL_DOT_COLOR(90, 230, 90);
+    const sf::Color VIEW_OUTLINE_COLOR(255, 255, 255, 180);
+}
+
+/**
+ * Creates both textures at minimap size. Drawing into them goes through a
+ * view of the whole world, so everything is submitted in world coordinates.
+ */
+bool Minimap::Initialize() {
+    map.reset();
+    mapSprite.reset();
+    background.reset();
+    backgroundSprite.reset();
+    try {
+        const float height = WIDTH * WorldConstants::WORLD_HEIGHT / WorldConstants::WORLD_WIDTH;
+        const sf::Vector2u size(WIDTH, static_cast<unsigned int>(height));
+        auto backgroundTexture = std::make_unique<sf::RenderTexture>();
+        auto mapTexture = std::make_unique<sf::RenderTexture>();
+        if (!backgroundTexture->resize(size) || !mapTexture->resize(size)) {
+            return false;
+        }
+        backgroundTexture->setSmooth(true);
+        worldView = sf::View(sf::FloatRect({ 0.0f, 0.0f }, { WorldConstants::WORLD_WIDTH, WorldConstants::WORLD_HEIGHT }));
+        backgroundTexture->setView(worldView);
+        backgroundTexture->clear(sf::Color::Black);
+        backgroundTexture->display();
+
+        background = std::move(backgroundTexture);
+        map = std::move(mapTexture);
+        backgroundSprite = std::make_unique<sf::Sprite>(background->getTexture());
+        mapSprite = std::make_unique<sf::Sprite>(map->getTexture());
+        refreshTimer = refreshInterval;
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception creating minimap - " + std::string(e.what()), error);
+        map.reset();
+        mapSprite.reset();
+        background.reset();
+        backgroundSprite.reset();
+        return false;
+    }
+}
+
+void Minimap::BakeBackground(const sf::Drawable* staticLayer, const sf::Drawable* chunkContent) {
+    if (!background) return;
+    background->clear(sf::Color::Black);
+    if (staticLayer) background->draw(*staticLayer);
+    if (chunkContent) background->draw(*chunkContent);
+    background->display();
+    refreshTimer = refreshInterval;         // Show the new content with the next frame
+}
+
+/**
+ * Enemies and other players come straight from the registry's packed
+ * views; dead tanks are left out as they are on screen.
+ */
+void Minimap::Refresh(const entt::registry& remoteTanks, bool localAlive, sf::Vector2f localPosition, const sf::View& camera) {
+    if (!map) return;
+    refreshTimer = 0.0f;
+
+    overlay.clear();
+    remoteTanks.view<const ClientComponents::Transform, const ClientComponents::Health, const ClientComponents::EnemyKind>().each(
+        [this](const ClientComponents::Transform& transform, const ClientComponents::Health& health, const ClientComponents::EnemyKind&) {
+            if (!health.dead) {
+                AddDot(transform.position, DOT_SIZE, ENEMY_DOT_COLOR);
+            }
+        });
+    for (auto [entity, transform, health] :
+        remoteTanks.view<const ClientComponents::Transform, const ClientComponents::Health, const ClientComponents::PlayerTag>().each()) {
+        if (!health.dead) {
+            AddDot(transform.position, DOT_SIZE, PLAYER_DOT_COLOR);
+        }
+    }
+    if (localAlive) {
+        AddDot(localPosition, DOT_SIZE * 1.5f, LOCAL_DOT_COLOR);
+    }
+
+    // The camera's view as four bars
+    const sf::Vector2f viewMin = camera.getCenter() - camera.getSize() / 2.0f;
+    const sf::Vector2f viewMax = camera.getCenter() + camera.getSize() / 2.0f;
+    AddQuad(viewMin, sf::Vector2f(viewMax.x, viewMin.y + VIEW_OUTLINE), VIEW_OUTLINE_COLOR);
+    AddQuad(sf::Vector2f(viewMin.x, viewMax.y - VIEW_OUTLINE), viewMax, VIEW_OUTLINE_COLOR);
+    AddQuad(sf::Vector2f(viewMin.x, viewMin.y + VIEW_OUTLINE), sf::Vector2f(viewMin.x + VIEW_OUTLINE, viewMax.y - VIEW_OUTLINE),
+        VIEW_OUTLINE_COLOR);
+    AddQuad(sf::Vector2f(viewMax.x - VIEW_OUTLINE, viewMin.y + VIEW_OUTLINE), sf::Vector2f(viewMax.x, viewMax.y - VIEW_OUTLINE),
+        VIEW_OUTLINE_COLOR);
+
+    map->setView(map->getDefaultView());
+    map->clear(sf::Color::Black);
+    map->draw(*backgroundSprite);
+    map->setView(worldView);
+    map->draw(overlay);
+    map->display();
+}
+
+void Minimap::Render(sf::RenderTarget& target) const {
+    if (!visible || !mapSprite) return;
+    const sf::Vector2f size(map->getSize());
+    const sf::Vector2f position(target.getView().getSize().x - size.x - SCREEN_MARGIN, SCREEN_MARGIN);
+    sf::RectangleShape frame(size + sf::Vector2f(4.0f, 4.0f));
+    frame.setPosition(position - sf::Vector2f(2.0f, 2.0f));
+    frame.setFillColor(MAP_FRAME_COLOR);
+    target.draw(frame);
+    sf::Sprite sprite = *mapSprite;
+    sprite.setPosition(position);
+    target.draw(sprite);
+}
+
+size_t Minimap::GetApproximateBytes() const {
+    size_t bytes = sizeof(*this) + overlay.getVertexCount() * sizeof(sf::Vertex);
+    if (map) {
+        bytes += 2 * (sizeof(sf::RenderTexture) + static_cast<size_t>(map->getSize().x) * map->getSize().y * 4);
+    }
+    return bytes;
+}
+
+void Minimap::AddQuad(sf::Vector2f topLeft, sf::Vector2f bottomRight, sf::Color color) {
+    overlay.append(sf::Vertex{ topLeft, color });
+    overlay.append(sf::Vertex{ sf::Vector2f(bottomRight.x, topLeft.y), color });
+    overlay.append(sf::Vertex{ bottomRight, color });
+    overlay.append(sf::Vertex{ topLeft, color });
+    overlay.append(sf::Vertex{ bottomRight, color });
+    overlay.append(sf::Vertex{ sf::Vector2f(topLeft.x, bottomRight.y), color });
+}
+
+void Minimap::AddDot(sf::Vector2f center, float size, sf::Color color) {
+    const sf::Vector2f half(size / 2.0f, size / 2.0f);
+    AddQuad(center - half, center + half, color);
+}
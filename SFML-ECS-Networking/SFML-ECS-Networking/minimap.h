@@ -0,0 +1,52 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <memory>
+#include <entt.hpp>
+
+// World overview in the top-right corner. Two render textures at minimap
+// size: the background (static layer, streamed tiles and obstacles scaled
+// down), redrawn only when that content changes, and the map itself, redrawn
+// from the remote tank registry (client_components.h) at a low fixed rate.
+// Each frame only draws the map as one sprite.
+class Minimap {
+public:
+    static constexpr float REFRESH_INTERVAL = 0.2f;     // 5 Hz by default
+    static constexpr unsigned int WIDTH = 192;          // Pixels; the height follows the world's aspect
+    static constexpr float SCREEN_MARGIN = 10.0f;       // From the window's top-right corner
+    static constexpr float DOT_SIZE = 56.0f;            // World units, so a tank stays a few pixels wide
+    static constexpr float VIEW_OUTLINE = 10.0f;        // World units
+
+    // @return False if the render textures could not be created (no minimap)
+    bool Initialize();
+    bool IsReady() const { return map != nullptr; }
+    void Toggle() { visible = !visible; }
+    bool IsVisible() const { return visible; }
+
+    // Redraws the background from world-space drawables (null ones are skipped)
+    void BakeBackground(const sf::Drawable* staticLayer, const sf::Drawable* chunkContent);
+    void AdvanceClock(float dt) { refreshTimer += dt; }
+    // Seconds between refreshes (lowered by the quality tiers)
+    void SetRefreshInterval(float seconds) { refreshInterval = seconds; }
+    bool IsRefreshDue() const { return visible && map && refreshTimer >= refreshInterval; }
+    // Redraws the map: background, remote tanks, the local tank and the camera's view
+    void Refresh(const entt::registry& remoteTanks, bool localAlive, sf::Vector2f localPosition, const sf::View& camera);
+    // In the target's current view, which should be the window's default
+    void Render(sf::RenderTarget& target) const;
+
+    size_t GetApproximateBytes() const;
+
+private:
+    std::unique_ptr<sf::RenderTexture> background;
+    std::unique_ptr<sf::RenderTexture> map;
+    std::unique_ptr<sf::Sprite> backgroundSprite;
+    std::unique_ptr<sf::Sprite> mapSprite;
+    sf::VertexArray overlay{ sf::PrimitiveType::Triangles };    // Dots and view outline, world units
+    sf::View worldView;
+    float refreshInterval = REFRESH_INTERVAL;
+    float refreshTimer = REFRESH_INTERVAL;                      // First refresh at once
+    bool visible = true;
+
+    void AddQuad(sf::Vector2f topLeft, sf::Vector2f bottomRight, sf::Color color);
+    void AddDot(sf::Vector2f center, float size, sf::Color color);
+};
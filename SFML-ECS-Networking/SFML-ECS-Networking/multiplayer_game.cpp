@@ -2,7 +2,11 @@
 #include "utils.h"
 #include "world_constants.h"
 #include "network_client.h"
-#include <unordered_set>
+#include "AssetManager.h"
+#include "trace_recorder.h"
+#include "world_chunks.h"
+#include <algorithm>
+#include <thread>
 MultiplayerGame::MultiplayerGame()
     : background(nullptr), window(nullptr), playerScore(0),          
     scoreText(nullptr),       //  Initialize text pointer
@@ -11,6 +15,12 @@ MultiplayerGame::MultiplayerGame()
     networkClient = std::make_unique<NetworkClient>();
     borderManager = std::make_unique<BorderManager>();
     interpolationManager = std::make_unique<InterpolationManager>();
+    bullets.Reserve(BULLET_CAPACITY);
+    serverBulletHandles.reserve(BULLET_CAPACITY);
+    changedBulletIds.reserve(BULLET_CAPACITY);
+    deadBulletHandles.reserve(BULLET_CAPACITY);
+    bulletPool.reserve(BULLET_CAPACITY);
+    removedBulletIds.reserve(BULLET_CAPACITY);
 }
 
 MultiplayerGame::~MultiplayerGame() {
@@ -21,42 +31,99 @@ MultiplayerGame::~MultiplayerGame() {
     }
 }
 
+/**
+ * Maps the asset archive if one was packed, then queues the sprite atlas, the
+ * background tile and the border textures for the AssetManager preload. Entities only ever take atlas regions, so once this
+ * finishes nothing in a match touches the disk or uploads a texture.
+ */
+void MultiplayerGame::BeginLoading() {
+    AssetManager::Instance().OpenArchive(AssetManager::DEFAULT_ARCHIVE_PATH);
+    std::vector<AssetManager::TextureRequest> textures = BorderManager::GetTextureRequests();
+    textures.push_back({ "Assets/background_" + backgroundTheme + "_tile.png", true, true });
+    AssetManager::Instance().BeginPreload(AssetManager::GetEntitySpriteFiles(), textures);
+}
+
+bool MultiplayerGame::UpdateLoading() {
+    return AssetManager::Instance().UpdatePreload();
+}
+
+/**
+ * Progress bar in the middle of the window (no font is loaded yet)
+ */
+void MultiplayerGame::RenderLoading(sf::RenderWindow& window) const {
+    const sf::Vector2f windowSize(window.getSize());
+    const sf::Vector2f barSize(windowSize.x * 0.5f, 16.0f);
+    const sf::Vector2f barPosition((windowSize.x - barSize.x) * 0.5f, (windowSize.y - barSize.y) * 0.5f);
+
+    sf::RectangleShape frame(barSize);
+    frame.setPosition(barPosition);
+    frame.setFillColor(sf::Color(40, 40, 40));
+    frame.setOutlineColor(sf::Color(160, 160, 160));
+    frame.setOutlineThickness(2.0f);
+    window.draw(frame);
+
+    sf::RectangleShape fill(sf::Vector2f(barSize.x * AssetManager::Instance().GetPreloadProgress(), barSize.y));
+    fill.setPosition(barPosition);
+    fill.setFillColor(sf::Color(90, 170, 90));
+    window.draw(fill);
+}
+
 bool MultiplayerGame::Initialize(const std::string& playerName, const std::string& preferredColor) {
     this->playerName = playerName;
     this->playerColor = preferredColor;
     playerScore = 0;  // Initialize score to 0
 
-    if (!backgroundTexture.loadFromFile("Assets/background_snow.png")) {
-        Utils::printMsg("Warning: Could not load background texture", warning);
-        sf::Image fallbackImage;
-        fallbackImage.resize(sf::Vector2u(1, 1), sf::Color::White);
-        if (!backgroundTexture.loadFromImage(fallbackImage)) {
-            Utils::printMsg("Error: Failed to create fallback texture", error);
-            return false;
-        }
+    // Finish a loading phase the caller did not wait out
+    while (!AssetManager::Instance().UpdatePreload()) {
+        std::this_thread::yield();
+    }
+    AssetManager::Instance().OpenArchive(AssetManager::DEFAULT_ARCHIVE_PATH);
+
+    if (!LoadBackground()) {
+        return false;
     }
-    backgroundTexture.setRepeated(true);
-    background = std::make_unique<sf::Sprite>(backgroundTexture);
-    background->setTextureRect(sf::IntRect({ 0, 0 }, { 1280, 960 }));
 
-    if (!borderManager->Initialize(1280.0f, 960.0f, 48.0f)) {
+    if (!borderManager->Initialize(WorldConstants::WORLD_WIDTH, WorldConstants::WORLD_HEIGHT,
+        WorldConstants::BORDER_THICKNESS)) {
         Utils::printMsg("Warning: Border system initialization had issues", warning);
     }
+    if (!BakeStaticLayer()) {
+        Utils::printMsg("Warning: Could not prebake background and borders - drawing them every frame", warning);
+    }
+    if (minimap.Initialize()) {
+        BakeMinimapBackground();
+    }
+    else {
+        Utils::printMsg("Warning: Could not create the minimap textures - minimap disabled", warning);
+    }
     try {
-        scoreFontLoaded = scoreFont.openFromFile("C:/Windows/Fonts/arial.ttf");
-        if (!scoreFontLoaded) {
-            scoreFontLoaded = scoreFont.openFromFile("C:/Windows/Fonts/calibri.ttf");
-        }
+        scoreFont = AssetManager::Instance().LoadDefaultFont();
+        scoreFontLoaded = scoreFont != nullptr;
 
         if (scoreFontLoaded) {
             //  Create text with font in constructor
-            scoreText = new sf::Text(scoreFont);
+            scoreText = new sf::Text(*scoreFont);
             scoreText->setString("Score: 0");
             scoreText->setCharacterSize(24);
             scoreText->setFillColor(sf::Color::White);
             scoreText->setOutlineColor(sf::Color::Black);
             scoreText->setOutlineThickness(2.0f);
             scoreText->setPosition(sf::Vector2f(10.0f, 10.0f)); 
+            displayedScore = 0;
+
+            deadText = std::make_unique<sf::Text>(*scoreFont);
+            deadText->setString("DEAD - Respawning...");
+            deadText->setCharacterSize(48);
+            deadText->setFillColor(sf::Color::Red);
+            deadText->setOutlineColor(sf::Color::Black);
+            deadText->setOutlineThickness(3.0f);
+
+            // Rasterize every glyph the HUD, name labels and overlay draw, at their sizes
+            AssetManager::PrewarmGlyphs(*scoreFont, 24, 2.0f);     // Score
+            AssetManager::PrewarmGlyphs(*scoreFont, 48, 3.0f);     // Dead banner
+            AssetManager::PrewarmGlyphs(*scoreFont, 16, 1.0f);     // Name labels
+            AssetManager::PrewarmGlyphs(*scoreFont, 14);           // Debug overlay
+            debugOverlay = std::make_unique<DebugOverlay>(*scoreFont);
             Utils::printMsg("✓ Score display initialized");
         }
     }
@@ -65,47 +132,104 @@ bool MultiplayerGame::Initialize(const std::string& playerName, const std::strin
             std::string(e.what()), warning);
         scoreFontLoaded = false;
     }
+    // Pack every entity sprite into one texture before the first entity takes its region
+    if (!AssetManager::Instance().IsAtlasBuilt()) {
+        AssetManager::Instance().BuildAtlas(AssetManager::GetEntitySpriteFiles());
+    }
+    particles.Initialize();
+    audio.Initialize();
+    const AssetManager::SpriteRegion solid = AssetManager::Instance().GetSolidRegion();
+    spriteBatch.SetSolidRegion(solid.texture.get(), solid.rect);
+    tankBatch.Initialize();
+    predictionAccumulator = 0.0f;
+    if (spectating) {
+        Utils::printMsg("Multiplayer game initialized for spectating");
+        return true;
+    }
     localTank = std::make_unique<Tank>(preferredColor, playerName);
     localTank->position = { WorldConstants::CENTER_X, WorldConstants::CENTER_Y };
+    previousLocalPosition = localTank->position;
+    previousLocalRotation = localTank->bodyRotation;
 
     Utils::printMsg("Multiplayer game initialized for player: " + playerName);
     return true;
 }
 
-bool MultiplayerGame::ConnectToServer(const std::string& serverIP, unsigned short serverPort) {
-    if (!localTank) {
-        Utils::printMsg("Game not initialized before connecting to server", error);
-        return false;
-    }
+void MultiplayerGame::SetNetworkConditions(const NetworkConditions& conditions) {
+    networkClient->SetNetworkConditions(conditions);
+}
 
-    bool connected = networkClient->Connect(serverIP, serverPort, playerName, playerColor);
+void MultiplayerGame::SetNetworkThreadEnabled(bool enabled) {
+    networkClient->SetNetworkThreadEnabled(enabled);
+}
 
-    if (connected && interpolationManager) {
-        snapshotCountForInterpolation = 0;
-        gameStartTime = 0;
+void MultiplayerGame::SetLoopback(LoopbackNetwork* network) {
+    networkClient->SetLoopback(network);
+}
 
-        networkClient->SetOnFirstGameStateCallback([this](int64_t serverTime) {
-            snapshotCountForInterpolation++;
+void MultiplayerGame::SetSpectating(bool enabled) {
+    spectating = enabled;
+    networkClient->SetSpectating(enabled);
+}
 
-            if (snapshotCountForInterpolation == 1) {
-                gameStartTime = GetCurrentTimestamp();
-            }
+bool MultiplayerGame::StartPacketCapture(const std::string& path) {
+    return networkClient->StartCapture(path);
+}
 
-            if (snapshotCountForInterpolation >= 2) {
-                float rtt = networkClient->GetAverageRTT();
+void MultiplayerGame::OnFramePresented() {
+    if (networkClient) {
+        networkClient->OnFramePresented(GetSteadyMicros());
+    }
+}
 
-                // CHANGED: Use 2x RTT instead of 0.5x for smoother interpolation
-                // Higher delay = more buffering = smoother movement
-                int64_t delay = static_cast<int64_t>(std::max(100.0f, rtt * 2.0f));  // Was rtt * 0.5f
-                int64_t renderTime = GetCurrentTimestamp() - delay;
+/**
+ * Leaving the foreground releases the movement keys, since their key-up
+ * events go to whichever window has focus. Coming back from minimised
+ * restarts interpolation as after connecting: its buffers and render clock
+ * stood still while snapshots kept arriving. Entities and bullets catch up
+ * in the next Update (a bullet change list that overflowed meanwhile makes
+ * it a full resync).
+ */
+void MultiplayerGame::SetWindowActivity(WindowActivity activity) {
+    if (activity == windowActivity) {
+        return;
+    }
+    if (windowActivity == WindowActivity::FOREGROUND && localTank) {
+        localTank->isMoving.forward = false;
+        localTank->isMoving.backward = false;
+        localTank->isMoving.left = false;
+        localTank->isMoving.right = false;
+    }
+    if (windowActivity == WindowActivity::MINIMISED) {
+        snapshotCountForInterpolation = 0;
+        firstSnapshotTime = 0;
+        ingestedWorldStateVersion = networkClient ? networkClient->GetWorldStateVersion() : 0;
+        if (interpolationManager) {
+            interpolationManager->Clear();
+        }
+        particles.Clear();
+    }
+    Utils::printMsg(std::string("Window ") + GetWindowActivityName(activity) +
+        (activity == WindowActivity::FOREGROUND ? ", full rate" : ", running in the background"), debug);
+    windowActivity = activity;
+}
+
+bool MultiplayerGame::ConnectToServer(const std::string& serverIP, unsigned short serverPort, uint16_t roomId) {
+    if (!localTank && !spectating) {
+        Utils::printMsg("Game not initialized before connecting to server", error);
+        return false;
+    }
 
-                interpolationManager->Initialize(renderTime);
-                interpolationManager->SetInterpolationDelay(delay);
+    bool connected = networkClient->Connect(serverIP, serverPort, playerName, playerColor, roomId);
 
-                Utils::printMsg("Interpolation STARTED: renderTime=" + std::to_string(renderTime) +
-                    " delay=" + std::to_string(delay) + "ms (RTT=" + std::to_string(rtt) + "ms)", success);
-            }
-            });
+    if (connected) {
+        // Interpolation starts once the second world state arrives (IngestWorldState)
+        snapshotCountForInterpolation = 0;
+        firstSnapshotTime = 0;
+        ingestedWorldStateVersion = networkClient->GetWorldStateVersion();
+        if (interpolationManager) {
+            interpolationManager->Clear();
+        }
     }
 
     return connected;
@@ -119,10 +243,22 @@ void MultiplayerGame::Shutdown() {
         interpolationManager->Clear();
     }
     localTank.reset();
-    otherTanks.clear();
-    enemies.clear();  //  Clear all enemies
-    bullets.clear();  //  Clear all bullets
+    remoteRegistry.clear();  //  Clear other players and enemies
+    remoteEntities.clear();
+    nameLabels.clear();
+    freeNameLabels.clear();
+    tankGrid.Clear();
+    particles.Clear();
+    audio.StopAll();
+    bullets.Clear();  //  Clear all bullets
+    serverBulletHandles.clear();
+    bulletPool.clear();
+    pendingShots.fill(PendingShot{});
     borderManager.reset();
+    staticLayerSprite.reset();
+    staticLayer.reset();
+    worldSprite.reset();
+    worldTarget.reset();
     background.reset();
     window = nullptr;  // Clear window reference
     snapshotCountForInterpolation = 0;
@@ -134,6 +270,20 @@ void MultiplayerGame::HandleEvents(const std::optional<sf::Event> event) {
     if (!localTank || !event) return;
 
     if (const auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
+        if (keyPressed->scancode == sf::Keyboard::Scancode::F3 && debugOverlay) {
+            debugOverlay->Toggle();
+            frameProfiler.ResetWindow();
+        }
+        if (keyPressed->scancode == sf::Keyboard::Scancode::F4) {
+            ToggleTrace();
+        }
+        if (keyPressed->scancode == sf::Keyboard::Scancode::F5 && tankBatch.IsAvailable()) {
+            tankBatch.SetEnabled(!tankBatch.IsEnabled());
+            Utils::printMsg(std::string("Tanks drawn ") + (tankBatch.IsEnabled() ? "by the tank shader" : "as batched sprites"), debug);
+        }
+        if (keyPressed->scancode == sf::Keyboard::Scancode::M) {
+            minimap.Toggle();
+        }
         if (keyPressed->scancode == sf::Keyboard::Scancode::W) {
             localTank->isMoving.forward = true;
             localTank->isMoving.backward = false;
@@ -153,10 +303,13 @@ void MultiplayerGame::HandleEvents(const std::optional<sf::Event> event) {
         if (keyPressed->scancode == sf::Keyboard::Scancode::Space) {
             if (localTank->CanShoot() && networkClient && networkClient->IsConnected()) {
                 // Send bullet spawn request to server
-                networkClient->SendBulletSpawn(*localTank);
+                const uint16_t spawnToken = networkClient->SendBulletSpawn(*localTank);
 
                 // Start local cooldown immediately (client prediction)
-                localTank->Shoot(bullets);  // This starts cooldown + spawns local bullet
+                if (std::unique_ptr<Bullet> bullet = localTank->Fire(TakePooledBullet())) {  // Starts cooldown + spawns local bullet
+                    AddPredictedBullet(std::move(bullet), spawnToken);
+                    EmitMuzzleFlash();
+                }
 
                 Utils::printMsg("Requested bullet spawn from server", debug);
             }
@@ -171,21 +324,147 @@ void MultiplayerGame::HandleEvents(const std::optional<sf::Event> event) {
     else if (const auto* mousePressed = event->getIf<sf::Event::MouseButtonPressed>()) {
         if (mousePressed->button == sf::Mouse::Button::Left) {
             if (localTank->CanShoot() && networkClient && networkClient->IsConnected()) {
-                networkClient->SendBulletSpawn(*localTank);
-                localTank->Shoot(bullets);  // Start cooldown + local spawn
+                const uint16_t spawnToken = networkClient->SendBulletSpawn(*localTank);
+                if (std::unique_ptr<Bullet> bullet = localTank->Fire(TakePooledBullet())) {  // Start cooldown + local spawn
+                    AddPredictedBullet(std::move(bullet), spawnToken);
+                    EmitMuzzleFlash();
+                }
                 Utils::printMsg("Requested bullet spawn from server (mouse)", debug);
             }
         }
     }
 }
 
+void MultiplayerGame::EmitMuzzleFlash() {
+    const EffectEvent event{ EffectKind::MUZZLE_FLASH, localTank->GetBarrelEndPosition(), localTank->barrelRotation };
+    particles.Emit(event);
+    audio.Play(event, true);
+}
+
+/**
+ * Matches the prediction step to the tick rate the server sent in
+ * JOIN_ACCEPT. The server takes one input per tick from its jitter buffer,
+ * so stepping at any other rate would back the buffer up or starve it.
+ */
+void MultiplayerGame::SyncPredictionRate() {
+    unsigned int rate = networkClient->GetServerTickRate();
+    if (rate == 0) {
+        rate = TickScheduler::DEFAULT_TICK_RATE;
+    }
+    if (rate == predictionTickRate) {
+        return;
+    }
+    predictionTickRate = rate;
+    predictionStep = 1.0f / static_cast<float>(rate);
+    maxPredictionSteps = std::max(1, static_cast<int>((MAX_PREDICTION_STEPS * rate +
+        TickScheduler::DEFAULT_TICK_RATE - 1) / TickScheduler::DEFAULT_TICK_RATE));
+    predictionAccumulator = std::min(predictionAccumulator, predictionStep);
+}
+
+/**
+ * One prediction step of the local tank: input, reconciliation against the
+ * server, then border and tank collisions. The pose before the step is kept
+ * so rendering can blend toward the new one.
+ * @param step Fixed step length in seconds
+ */
+void MultiplayerGame::StepLocalTank(float step) {
+    previousLocalPosition = localTank->position;
+    previousLocalRotation = localTank->bodyRotation;
+
+    localTank->UpdateCooldown(step);
+    const sf::Vector2f mousePos = latchedMousePosition;
+
+    if (networkClient->IsPredictionEnabled()) {
+        networkClient->ApplyLocalInputWithPrediction(*localTank, step, mousePos);
+        networkClient->ApplyServerReconciliation(*localTank, step);
+    }
+    else {
+        localTank->Update(step, mousePos, true);
+        if (IsConnected()) {
+            networkClient->SendPlayerInput(*localTank);
+        }
+    }
+
+    EnforceBorderCollision(*localTank);
+    CheckTankCollisions();
+}
+
+/**
+ * Draws the local tank between its last two prediction steps, by the
+ * fraction of a step left in the accumulator. Each drawn pose lags the
+ * newest prediction by under one step, in exchange for smooth motion at any
+ * refresh rate.
+ */
+void MultiplayerGame::UpdateLocalTankRenderState() {
+    if (!localTank) {
+        return;
+    }
+    // Reconciliation hides small corrections behind an offset that decays
+    sf::Vector2f offset;
+    sf::Angle rotationOffset = sf::Angle::Zero;
+    if (networkClient && networkClient->IsPredictionEnabled()) {
+        offset = networkClient->GetCorrectionOffset();
+        rotationOffset = networkClient->GetCorrectionRotationOffset();
+    }
+    const sf::Vector2f current = localTank->position;
+    const sf::Vector2f delta = current - previousLocalPosition;
+    if (delta.lengthSquared() > PREDICTION_SNAP_DISTANCE * PREDICTION_SNAP_DISTANCE) {
+        localTank->SetRenderState(current, localTank->bodyRotation);
+        return;
+    }
+    const float alpha = std::clamp(predictionAccumulator / predictionStep, 0.0f, 1.0f);
+    const sf::Angle rotation = previousLocalRotation +
+        (localTank->bodyRotation - previousLocalRotation).wrapSigned() * alpha;
+    localTank->SetRenderState(previousLocalPosition + delta * alpha + offset, rotation + rotationOffset);
+}
+
 void MultiplayerGame::Update(float dt) {
     if (!networkClient) return;
 
-    networkClient->Update(dt);
+    frameProfiler.BeginFrame(dt);
+    frameWorkStart = std::chrono::steady_clock::now();
+    AssetManager::Instance().BeginFrame();
+    // Background frames are slow on purpose: they must not count as late frames
+    const bool foreground = windowActivity == WindowActivity::FOREGROUND;
+    const bool minimised = windowActivity == WindowActivity::MINIMISED;
+    if (foreground && quality.RecordFrame(dt, lastBusyMs)) {
+        ApplyQualityTier();
+    }
+    if (foreground && renderScale.RecordFrame(dt, lastBusyMs)) {
+        Utils::printMsg("World render scale " + std::to_string(static_cast<int>(renderScale.GetScale() * 100.0f + 0.5f)) +
+            "% (frames at " + std::to_string(static_cast<int>(renderScale.GetLastFrameFraction() * 100.0f)) +
+            "% of the frame budget)", debug);
+    }
+    AllocationCounter::Scope updateAllocations(frameProfiler.GetOtherAllocationCounter());
+    {
+        ScopedFrameTimer timer(frameProfiler, FramePhase::NETWORK);
+        networkClient->Update(dt);
+        networkClient->TakeEffectEvents(effectEvents);
+    }
+    // Sounds go on while the window is in the background
+    audio.SetListener(localTank ? localTank->GetRenderPosition() : camera.getCenter());
+    for (const EffectEvent& event : effectEvents) {
+        audio.Play(event);
+    }
+    if (!minimised) {
+        for (const EffectEvent& event : effectEvents) {
+            particles.Emit(event);
+        }
+        particles.Update(dt);
+        minimap.AdvanceClock(dt);
 
-    if (interpolationManager) {
-        interpolationManager->Update(dt);
+        if (interpolationManager) {
+            ScopedFrameTimer timer(frameProfiler, FramePhase::INTERPOLATION);
+            if (IsInterpolating()) {
+                interpolationManager->SyncRenderClock(networkClient->GetServerTime());
+            }
+            interpolationManager->Update(dt);
+        }
+    }
+    if (foreground) {
+        networkClient->GetTelemetry().RecordFrame(dt * 1000.0f,
+            interpolationManager ? interpolationManager->GetEntityCount() : 0,
+            interpolationManager ? interpolationManager->GetExtrapolatedEntityCount() : 0);
     }
 
     if (localTank) {
@@ -193,25 +472,28 @@ void MultiplayerGame::Update(float dt) {
         bool isDead = networkClient->GetServerAuthoritativeIsDead();
 
         if (!isDead) {
-            localTank->UpdateCooldown(dt);
-
-            sf::Vector2f mousePos = GetMouseWorldPosition();
-
-            if (networkClient->IsPredictionEnabled()) {
-                networkClient->ApplyLocalInputWithPrediction(*localTank, dt, mousePos);
-                networkClient->ApplyServerReconciliation(*localTank);
+            // Aim is latched here, after the network and interpolation work, so the
+            // steps use the freshest mouse position; keys come from the event poll,
+            // which a paced frame (FramePacer) runs just before Update
+            if (foreground) {
+                latchedMousePosition = GetMouseWorldPosition();
             }
-            else {
-                localTank->Update(dt, mousePos, true);
-                if (IsConnected()) {
-                    networkClient->SendPlayerInput(*localTank);
-                }
+            // Fixed steps: the prediction matches the server's tick and does not
+            // wobble with frame time
+            SyncPredictionRate();
+            predictionAccumulator += dt;
+            int steps = 0;
+            while (predictionAccumulator >= predictionStep && steps < maxPredictionSteps) {
+                StepLocalTank(predictionStep);
+                predictionAccumulator -= predictionStep;
+                steps++;
+            }
+            if (steps == maxPredictionSteps) {
+                predictionAccumulator = std::min(predictionAccumulator, predictionStep);
             }
-
-            EnforceBorderCollision(*localTank);
-            CheckTankCollisions();
         }
         else {
+            predictionAccumulator = 0.0f;
             // Player is dead - clear all movement flags to stop any motion
             localTank->isMoving.forward = false;
             localTank->isMoving.backward = false;
@@ -261,39 +543,52 @@ void MultiplayerGame::Update(float dt) {
         }
         playerScore = serverScore;
     }
+    if (minimised) {
+        return;     // Nothing below is seen until the window comes back (see SetWindowActivity)
+    }
     int64_t serverTimestamp = networkClient->GetLastGameStateTimestamp();
     if (serverTimestamp == 0) {
-        serverTimestamp = GetCurrentTimestamp();
+        serverTimestamp = networkClient->GetServerTime();
     }
 
     UpdateOtherPlayers(serverTimestamp);
 
     if (networkClient && IsConnected()) {
         UpdateEnemies(networkClient->GetEnemies());
+        IngestWorldState();
+        ApplyInterpolatedStates();
     }
+    SyncTankGrid();
 
     if (networkClient && IsConnected()) {
+        ScopedFrameTimer timer(frameProfiler, FramePhase::BULLET_SYNC);
         SynchronizeBulletsFromServer();
     }
 
     // Update all bullets (both local prediction and server-confirmed)
+    size_t bulletIndex = 0;
     for (auto& bullet : bullets) {
         if (bullet) {
             bullet->Update(dt);
+            if (bullet->IsExpired()) {
+                deadBulletHandles.push_back(bullets.GetHandleAt(bulletIndex));
+            }
         }
+        bulletIndex++;
     }
 
     // Check bullet collisions (client-side for immediate feedback)
     CheckBulletCollisions();
 
-    // Remove expired bullets
-    bullets.erase(
-        std::remove_if(bullets.begin(), bullets.end(),
-            [](const std::unique_ptr<Bullet>& bullet) {
-                return bullet->IsExpired();
-            }),
-        bullets.end()
-    );
+    // Remove the bullets that expired or hit something this frame
+    for (SlotMap<std::unique_ptr<Bullet>>::Handle handle : deadBulletHandles) {
+        std::unique_ptr<Bullet>* bullet = bullets.Get(handle);
+        if (bullet && *bullet && (*bullet)->GetBulletId() != 0) {
+            serverBulletHandles.erase((*bullet)->GetBulletId());
+        }
+        RemoveBullet(handle);
+    }
+    deadBulletHandles.clear();
     // Debug logging
     static float logTimer = 0;
     logTimer += dt;
@@ -305,6 +600,66 @@ void MultiplayerGame::Update(float dt) {
         //    " | Score: " + std::to_string(playerScore));
         logTimer = 0;
     }
+
+    if (debugOverlay) {
+        AllocationCounter::Scope overlayAllocations(nullptr);  // Diagnostics, not game work
+        if (debugOverlay->IsRefreshDue(dt)) {
+            ReportMemory(memoryReport);
+        }
+        debugOverlay->Update(dt, frameProfiler, interpolationManager.get(), networkClient.get(), &spriteBatch,
+            &memoryReport);
+    }
+}
+
+namespace {
+    // Packed components and entities plus the sparse index of one registry storage
+    template <typename Component>
+    size_t StorageBytes(const entt::registry& registry) {
+        const auto* storage = registry.storage<Component>();
+        if (!storage) {
+            return 0;
+        }
+        return storage->capacity() * (sizeof(Component) + sizeof(entt::entity)) +
+            storage->extent() * sizeof(entt::entity);
+    }
+}
+
+/**
+ * Game-side entities (pooled bullets count toward the bytes, not the count),
+ * then the network client, interpolation and asset cache. The static layer
+ * is a texture of its own, outside the asset cache.
+ */
+void MultiplayerGame::ReportMemory(MemoryReport& report) const {
+    report.Clear();
+    report.Add("entities", (localTank ? 1 : 0) + bullets.Size(),
+        (localTank ? sizeof(Tank) : 0) + (bullets.Size() + bulletPool.size()) * sizeof(Bullet) +
+        MemoryReport::MapBytes(serverBulletHandles) + MemoryReport::VectorBytes(bulletPool, interpolatedStates));
+    report.Add("remote tanks", remoteEntities.size(),
+        StorageBytes<ClientComponents::NetId>(remoteRegistry) + StorageBytes<ClientComponents::Transform>(remoteRegistry) +
+        StorageBytes<ClientComponents::Health>(remoteRegistry) + StorageBytes<ClientComponents::SpriteRef>(remoteRegistry) +
+        StorageBytes<ClientComponents::Label>(remoteRegistry) + StorageBytes<ClientComponents::PlayerTag>(remoteRegistry) +
+        StorageBytes<ClientComponents::EnemyKind>(remoteRegistry) + MemoryReport::MapBytes(remoteEntities) +
+        MemoryReport::MapBytes(tankSprites) + nameLabels.capacity() * sizeof(NameLabel) +
+        MemoryReport::VectorBytes(removedEntities, freeNameLabels, visibleLabels));
+    if (networkClient) {
+        networkClient->ReportMemory(report);
+    }
+    if (interpolationManager) {
+        report.Add("interpolation", interpolationManager->GetEntityCount(), interpolationManager->GetApproximateBytes());
+    }
+    AssetManager::Instance().ReportMemory(report);
+    report.Add("chunk tiles", chunkTiles.getVertexCount() / 6, chunkTiles.getVertexCount() * sizeof(sf::Vertex));
+    if (minimap.IsReady()) {
+        report.Add("minimap", 2, minimap.GetApproximateBytes());
+    }
+    if (staticLayer) {
+        const sf::Vector2u size = staticLayer->getSize();
+        report.Add("textures", 1, sizeof(sf::RenderTexture) + static_cast<size_t>(size.x) * size.y * 4);
+    }
+    if (worldTarget) {
+        const sf::Vector2u size = worldTarget->getSize();
+        report.Add("textures", 1, sizeof(sf::RenderTexture) + static_cast<size_t>(size.x) * size.y * 4);
+    }
 }
 
 // NEW: Get mouse position in world coordinates
@@ -319,8 +674,8 @@ sf::Vector2f MultiplayerGame::GetMouseWorldPosition() const {
         // Get mouse position relative to window
         sf::Vector2i pixelPos = sf::Mouse::getPosition(*window);
 
-        // Convert to world coordinates (no view/camera transform needed for now)
-        sf::Vector2f worldPos = window->mapPixelToCoords(pixelPos);
+        // Convert to world coordinates through the camera
+        sf::Vector2f worldPos = window->mapPixelToCoords(pixelPos, cameraPlaced ? camera : window->getDefaultView());
 
         return worldPos;
     }
@@ -331,14 +686,18 @@ sf::Vector2f MultiplayerGame::GetMouseWorldPosition() const {
 }
 
 void MultiplayerGame::EnforceBorderCollision(Tank& tank) {
+    const sf::Vector2f before = tank.position;
+    ClampToBorder(tank.position);
+    if (tank.position != before) {
+        tank.UpdateSprites();
+    }
+}
+
+void MultiplayerGame::ClampToBorder(sf::Vector2f& position) const {
     if (!borderManager) return;
     const float tankRadius = WorldConstants::TANK_RADIUS;
-    if (!borderManager->IsPositionInBounds(tank.position, tankRadius)) {
-        sf::Vector2f clamped = borderManager->ClampPositionToBounds(tank.position, tankRadius);
-        if (tank.position != clamped) {
-            tank.position = clamped;
-            tank.UpdateSprites();
-        }
+    if (!borderManager->IsPositionInBounds(position, tankRadius)) {
+        position = borderManager->ClampPositionToBounds(position, tankRadius);
     }
 }
 
@@ -348,74 +707,35 @@ void MultiplayerGame::UpdateOtherPlayers(int64_t serverTimestamp) {
     const auto& otherPlayersData = networkClient->GetOtherPlayers();
 
     //  Remove players who left the game
-    for (auto tankIt = otherTanks.begin(); tankIt != otherTanks.end(); ) {
-        uint32_t playerId = tankIt->first;
-        if (otherPlayersData.find(playerId) == otherPlayersData.end()) {
-            Utils::printMsg("Player " + std::to_string(playerId) + " left the game");
-            if (interpolationManager) {
-                interpolationManager->RemoveEntity(playerId);
-            }
-            tankIt = otherTanks.erase(tankIt);
-        }
-        else {
-            ++tankIt;
+    removedEntities.clear();
+    for (auto [entity, netId] : remoteRegistry.view<const ClientComponents::NetId, const ClientComponents::PlayerTag>().each()) {
+        if (otherPlayersData.find(netId.id) == otherPlayersData.end()) {
+            Utils::printMsg("Player " + std::to_string(netId.id) + " left the game");
+            removedEntities.push_back(entity);
         }
     }
+    for (entt::entity entity : removedEntities) {
+        DestroyRemote(entity);
+    }
 
     //  Update or create tanks for current players 
+    const bool interpolating = IsInterpolating();
     for (auto dataIt = otherPlayersData.begin(); dataIt != otherPlayersData.end(); ++dataIt) {
         uint32_t playerId = dataIt->first;
         const PlayerData& playerData = dataIt->second;
 
         // Find or create tank
-        auto tankIt = otherTanks.find(playerId);
-        if (tankIt == otherTanks.end()) {
+        entt::entity entity = FindRemote(playerId);
+        if (entity == entt::null) {
             CreateTankForPlayer(playerId, playerData);
-            Utils::printMsg("Player " + playerData.playerName + " (" + std::to_string(playerId) + ") joined");
-            tankIt = otherTanks.find(playerId);
-        }
-
-        // === 3. Use interpolation if enabled and render time > 0 ===
-        if (interpolationManager && interpolationManager->GetRenderTime() > 0 && gameStartTime != 0) {
-            // Use RELATIVE time
-            int64_t relativeTime = GetCurrentTimestamp() - gameStartTime;
-
-            EntitySnapshot snapshot;
-            snapshot.timestamp = relativeTime;
-            snapshot.position = sf::Vector2f(playerData.x, playerData.y);
-            snapshot.bodyRotation = sf::degrees(playerData.bodyRotation);
-            snapshot.barrelRotation = sf::degrees(playerData.barrelRotation);
-            snapshot.isMoving_forward = playerData.isMoving_forward;
-            snapshot.isMoving_backward = playerData.isMoving_backward;
-            snapshot.isMoving_left = playerData.isMoving_left;
-            snapshot.isMoving_right = playerData.isMoving_right;
-
-            static std::unordered_map<uint32_t, int> logCounters;
-            if (++logCounters[playerId] % 30 == 0) {
-                Utils::printMsg(" SNAPSHOT: Player=" + std::to_string(playerId) +
-                    " Body=" + std::to_string(playerData.bodyRotation) + "° " +
-                    "Barrel=" + std::to_string(playerData.barrelRotation) + "°", debug);
-            }
-
-            // Add snapshot to interpolation manager
-            interpolationManager->AddEntitySnapshot(playerId, snapshot);
-
-            // Get interpolated state
-            InterpolatedState interpState;
-            if (interpolationManager->GetEntityState(playerId, interpState)) {
-                UpdateTankFromInterpolatedState(*tankIt->second, interpState);
-
-                //  Sync health separately (not part of interpolation)
-                tankIt->second->SetHealth(playerData.health);
-                tankIt->second->SetMaxHealth(playerData.maxHealth);
-
-                EnforceBorderCollision(*tankIt->second);
-            }
+            Utils::printMsg("Player " + networkClient->GetPlayerName(playerId) + " (" + std::to_string(playerId) + ") joined");
+            continue;
         }
+
+        // Interpolated players are placed by ApplyInterpolatedStates
         //  Fallback: use raw server data (before interpolation starts)
-        else {
-            UpdateTankFromPlayerData(*tankIt->second, playerData);
-            EnforceBorderCollision(*tankIt->second);
+        if (!interpolating) {
+            UpdateTankFromPlayerData(entity, playerData);
         }
     }
     // The local player's health must be synchronized from server data because:
@@ -448,108 +768,638 @@ void MultiplayerGame::UpdateOtherPlayers(int64_t serverTimestamp) {
     }
 }
 
+entt::entity MultiplayerGame::FindRemote(uint32_t netId) const {
+    auto it = remoteEntities.find(netId);
+    return it != remoteEntities.end() ? it->second : entt::null;
+}
+
+/**
+ * Drops a remote tank with everything keyed by its ID: interpolation buffers,
+ * its broadphase entry and its name label slot.
+ */
+void MultiplayerGame::DestroyRemote(entt::entity entity) {
+    const uint32_t netId = remoteRegistry.get<ClientComponents::NetId>(entity).id;
+    if (interpolationManager) {
+        interpolationManager->RemoveEntity(remoteRegistry.all_of<ClientComponents::EnemyKind>(entity) ?
+            ENEMY_INTERPOLATION_ID | netId : netId);
+    }
+    if (const auto* label = remoteRegistry.try_get<ClientComponents::Label>(entity)) {
+        freeNameLabels.push_back(label->slot);
+    }
+    tankGrid.Remove(netId);
+    remoteEntities.erase(netId);
+    remoteRegistry.destroy(entity);
+}
+
+/**
+ * Body and barrel sprites for one texture prefix, set up the first time it is
+ * asked for: atlas regions from the AssetManager, body origin centred.
+ * @param texturePrefix Colour part of the file names, e.g. "red" or "enemyTeal"
+ * @param barrelOrigin Barrel mount point in its texture
+ */
+const ClientComponents::TankSprites& MultiplayerGame::GetTankSprites(const std::string& texturePrefix,
+    sf::Vector2f barrelOrigin) {
+    auto [it, inserted] = tankSprites.try_emplace(texturePrefix, AssetManager::Instance().GetPlaceholderTexture());
+    if (inserted) {
+        ClientComponents::TankSprites& sprites = it->second;
+        const AssetManager::SpriteRegion bodyRegion = AssetManager::Instance().LoadSprite("Assets/" + texturePrefix + "Tank.png", false);
+        const AssetManager::SpriteRegion barrelRegion = AssetManager::Instance().LoadSprite("Assets/" + texturePrefix + "Barrel.png", false);
+        sprites.bodyTexture = bodyRegion.texture;
+        sprites.barrelTexture = barrelRegion.texture;
+        sprites.body.setTexture(*sprites.bodyTexture);
+        sprites.barrel.setTexture(*sprites.barrelTexture);
+        sprites.body.setTextureRect(bodyRegion.rect);
+        sprites.barrel.setTextureRect(barrelRegion.rect);
+        const sf::FloatRect bodyBounds = sprites.body.getLocalBounds();
+        sprites.body.setOrigin({ bodyBounds.position.x + bodyBounds.size.x / 2.0f, bodyBounds.position.y + bodyBounds.size.y / 2.0f });
+        sprites.barrel.setOrigin(barrelOrigin);
+    }
+    return it->second;
+}
+
 void MultiplayerGame::CreateTankForPlayer(uint32_t playerId, const PlayerData& playerData) {
-    auto tank = std::make_unique<Tank>(playerData.color, playerData.playerName);
-    UpdateTankFromPlayerData(*tank, playerData);
-    otherTanks[playerId] = std::move(tank);
+    static constexpr sf::Vector2f PLAYER_BARREL_ORIGIN{ 6.0f, 2.0f };
+    const entt::entity entity = remoteRegistry.create();
+    remoteRegistry.emplace<ClientComponents::NetId>(entity, playerId);
+    remoteRegistry.emplace<ClientComponents::PlayerTag>(entity);
+    remoteRegistry.emplace<ClientComponents::Transform>(entity, sf::Vector2f(playerData.x, playerData.y),
+        playerData.bodyRotation, playerData.barrelRotation, WorldConstants::TANK_RADIUS);
+    remoteRegistry.emplace<ClientComponents::Health>(entity, playerData.health, playerData.maxHealth, playerData.isDead);
+    remoteRegistry.emplace<ClientComponents::SpriteRef>(entity,
+        &GetTankSprites(NetworkUtils::ColorName(playerData.color), PLAYER_BARREL_ORIGIN));
+    remoteEntities[playerId] = entity;
+    UpdateTankFromPlayerData(entity, playerData);
 }
 
-void MultiplayerGame::UpdateTankFromPlayerData(Tank& tank, const PlayerData& playerData) {
-    tank.position.x = playerData.x;
-    tank.position.y = playerData.y;
-    tank.bodyRotation = sf::degrees(playerData.bodyRotation);
+void MultiplayerGame::UpdateTankFromPlayerData(entt::entity entity, const PlayerData& playerData) {
+    auto& transform = remoteRegistry.get<ClientComponents::Transform>(entity);
+    transform.position = sf::Vector2f(playerData.x, playerData.y);
+    transform.bodyRotation = playerData.bodyRotation;
 
     //  Apply barrel rotation from server data
-    tank.barrelRotation = sf::degrees(playerData.barrelRotation);
+    transform.barrelRotation = playerData.barrelRotation;
+    ClampToBorder(transform.position);
 
-    tank.isMoving.forward = playerData.isMoving_forward;
-    tank.isMoving.backward = playerData.isMoving_backward;
-    tank.isMoving.left = playerData.isMoving_left;
-    tank.isMoving.right = playerData.isMoving_right;
-
-    if (tank.GetPlayerName() != playerData.playerName) {
-        tank.SetPlayerName(playerData.playerName);
-    }
+    SyncTankName(entity, playerData.playerId);
     // Synchronize health from server
-    tank.SetHealth(playerData.health);
-    tank.SetMaxHealth(playerData.maxHealth);
+    remoteRegistry.replace<ClientComponents::Health>(entity, playerData.health, playerData.maxHealth, playerData.isDead);
+}
 
-    tank.UpdateSprites();
+/**
+ * Applies the name from the player table, which may arrive after the first
+ * snapshot. The first name takes a label slot; later changes reuse it.
+ */
+void MultiplayerGame::SyncTankName(entt::entity entity, uint32_t playerId) {
+    const std::string& name = networkClient->GetPlayerName(playerId);
+    if (name.empty()) {
+        return;
+    }
+    if (const auto* label = remoteRegistry.try_get<ClientComponents::Label>(entity)) {
+        NameLabel& nameLabel = nameLabels[label->slot];
+        if (nameLabel.name == name) {
+            return;
+        }
+        nameLabel.name = name;
+        nameLabel.text.setString(name);
+    }
+    else {
+        if (!labelFont) {
+            labelFont = AssetManager::Instance().LoadDefaultFont();
+            if (!labelFont) {
+                return;     // No font on this machine: players stay unlabelled
+            }
+        }
+        uint32_t slot;
+        if (!freeNameLabels.empty()) {
+            slot = freeNameLabels.back();
+            freeNameLabels.pop_back();
+            nameLabels[slot].name = name;
+            nameLabels[slot].text.setString(name);
+        }
+        else {
+            slot = static_cast<uint32_t>(nameLabels.size());
+            nameLabels.push_back({ name, sf::Text(*labelFont, name, 16) });
+            sf::Text& text = nameLabels.back().text;
+            text.setFillColor(sf::Color::White);
+            text.setOutlineColor(sf::Color::Black);
+            text.setOutlineThickness(1.0f);
+        }
+        remoteRegistry.emplace<ClientComponents::Label>(entity, slot);
+    }
+    // The text's bounds only change with the string
+    sf::Text& text = nameLabels[remoteRegistry.get<ClientComponents::Label>(entity).slot].text;
+    const sf::FloatRect textBounds = text.getLocalBounds();
+    text.setOrigin({ textBounds.position.x + textBounds.size.x / 2.0f, textBounds.position.y + textBounds.size.y / 2.0f });
 }
 
-void MultiplayerGame::UpdateTankFromInterpolatedState(Tank& tank, const InterpolatedState& state) {
-    tank.position = state.position;
-    tank.bodyRotation = state.bodyRotation;
+/**
+ * Feeds a newly applied world state to the interpolation buffers: every other
+ * player and every enemy, stamped with the state's server timestamp. The
+ * second state starts the render clock on the synchronised server timeline
+ * with a delay that covers the round trip and two snapshot intervals; from
+ * then on how late states arrive steers it
+ * (InterpolationManager::RecordSnapshotArrival).
+ */
+void MultiplayerGame::IngestWorldState() {
+    if (!interpolationManager) return;
+
+    const uint32_t version = networkClient->GetWorldStateVersion();
+    if (version == ingestedWorldStateVersion) {
+        return;
+    }
+    ingestedWorldStateVersion = version;
+
+    const int64_t arrivalTime = networkClient->ToServerTime(networkClient->GetLastWorldStateArrival());
+    const int64_t snapshotTime = networkClient->HasServerTimestamp() ?
+        networkClient->GetLastServerTimestamp() : arrivalTime;
+    snapshotCountForInterpolation++;
+    if (snapshotCountForInterpolation == 1) {
+        firstSnapshotTime = snapshotTime;
+    }
+    interpolationManager->RecordSnapshotArrival(arrivalTime, snapshotTime);
+
+    if (snapshotCountForInterpolation == 2) {
+        float rtt = networkClient->GetAverageRTT();
+
+        // CHANGED: Use 2x RTT instead of 0.5x for smoother interpolation
+        // Higher delay = more buffering = smoother movement
+        int64_t delay = static_cast<int64_t>(std::max(100.0f, rtt * 2.0f));  // Was rtt * 0.5f
+        delay = std::max(delay, (snapshotTime - firstSnapshotTime) * 2);  // Two snapshot intervals; a starting guess only
 
-    //Apply barrel rotation from interpolated state
-    tank.barrelRotation = state.barrelRotation;
+        interpolationManager->SetInterpolationDelay(delay);
+        interpolationManager->Initialize(networkClient->GetServerTime());
 
-    static std::unordered_map<std::string, int> logCounters;
-    std::string tankKey = tank.GetPlayerName();
-    if (++logCounters[tankKey] % 30 == 0) {
-     /*   Utils::printMsg(" TANK UPDATED: " + tankKey +
-            " Body=" + std::to_string(state.bodyRotation.asDegrees()) + "° " +
-            "Barrel=" + std::to_string(state.barrelRotation.asDegrees()) + "°", debug);*/
+        Utils::printMsg("Interpolation STARTED: renderTime=" + std::to_string(interpolationManager->GetRenderTime()) +
+            " delay=" + std::to_string(interpolationManager->GetInterpolationDelay()) + "ms (RTT=" +
+            std::to_string(rtt) + "ms)", success);
+    }
+
+    for (const auto& [playerId, playerData] : networkClient->GetOtherPlayers()) {
+        EntitySnapshot snapshot(snapshotTime, sf::Vector2f(playerData.x, playerData.y),
+            sf::degrees(playerData.bodyRotation), sf::degrees(playerData.barrelRotation));
+        snapshot.isMoving_forward = playerData.isMoving_forward;
+        snapshot.isMoving_backward = playerData.isMoving_backward;
+        snapshot.isMoving_left = playerData.isMoving_left;
+        snapshot.isMoving_right = playerData.isMoving_right;
+        if (!RepeatsLatestSnapshot(playerId, snapshot)) {
+            interpolationManager->AddEntitySnapshot(playerId, snapshot);
+        }
+    }
+    for (const auto& [enemyId, enemyData] : networkClient->GetEnemies()) {
+        const EntitySnapshot snapshot(snapshotTime, sf::Vector2f(enemyData.x, enemyData.y),
+            sf::degrees(enemyData.bodyRotation), sf::degrees(enemyData.barrelRotation));
+        if (!RepeatsLatestSnapshot(ENEMY_INTERPOLATION_ID | enemyId, snapshot)) {
+            interpolationManager->AddEntitySnapshot(ENEMY_INTERPOLATION_ID | enemyId, snapshot);
+        }
     }
+}
 
-    tank.isMoving.forward = state.isMoving;
-    tank.isMoving.backward = false;
-    tank.isMoving.left = false;
-    tank.isMoving.right = false;
+/**
+ * Whether snapshot only repeats the entity's newest buffered snapshot
+ * (InterpolationManager::IsRepeat).
+ */
+bool MultiplayerGame::RepeatsLatestSnapshot(uint32_t entityId, const EntitySnapshot& snapshot) const {
+    EntitySnapshot latest;
+    return interpolationManager->GetEntityLatestSnapshot(entityId, latest) &&
+        InterpolationManager::IsRepeat(latest, snapshot);
+}
 
-    tank.UpdateSprites();
+/**
+ * Places other players and enemies at their interpolated states, evaluated for
+ * all of them in one pass.
+ */
+void MultiplayerGame::ApplyInterpolatedStates() {
+    if (!IsInterpolating()) return;
+
+    const auto& otherPlayersData = networkClient->GetOtherPlayers();
+    interpolationManager->EvaluateAll(interpolatedStates);
+    for (const InterpolationManager::EntityState& interpolated : interpolatedStates) {
+        const bool isEnemy = (interpolated.entityId & ENEMY_INTERPOLATION_ID) != 0;
+        const uint32_t netId = interpolated.entityId & ~ENEMY_INTERPOLATION_ID;
+        const entt::entity entity = FindRemote(netId);
+        if (entity == entt::null) {
+            continue;
+        }
+        auto& transform = remoteRegistry.get<ClientComponents::Transform>(entity);
+        transform.position = interpolated.state.position;
+        transform.bodyRotation = interpolated.state.bodyRotation.asDegrees();
+        transform.barrelRotation = interpolated.state.barrelRotation.asDegrees();
+        if (isEnemy) {
+            continue;
+        }
+
+        //  Sync health separately (not part of interpolation)
+        auto dataIt = otherPlayersData.find(netId);
+        if (dataIt != otherPlayersData.end()) {
+            remoteRegistry.replace<ClientComponents::Health>(entity,
+                dataIt->second.health, dataIt->second.maxHealth, dataIt->second.isDead);
+            SyncTankName(entity, netId);
+        }
+        ClampToBorder(transform.position);
+    }
 }
 
 void MultiplayerGame::Render(sf::RenderWindow& window) {
-    if (background) window.draw(*background);
-    if (borderManager) borderManager->Render(window);
-    for (auto& [enemyId, enemy] : enemies) {
-        if (enemy) {
-            enemy->Render(window);
+    {
+        ScopedFrameTimer timer(frameProfiler, FramePhase::RENDER);
+        RenderWorld(window);
+    }
+    const std::chrono::duration<float, std::milli> busy = std::chrono::steady_clock::now() - frameWorkStart;
+    lastBusyMs = busy.count();
+    if (debugOverlay) {
+        TRACE_SCOPE("Debug overlay", "render");
+        debugOverlay->SetQualityTier(quality.GetTier(), quality.GetLastBusyFraction());
+        debugOverlay->SetRenderScale(renderScale.GetScale());
+        debugOverlay->SetInstancedTanks(tankBatch.GetTankCount());
+        debugOverlay->SetAudioStats(audio.GetActiveVoiceCount(), audio.GetStats());
+        debugOverlay->Render(window, frameProfiler);
+    }
+}
+
+/**
+ * The target is sized to the scale of the window and recreated only when that
+ * size changes; if it cannot be created the world draws to the window.
+ * @return The target the world pass draws to, cleared
+ */
+sf::RenderTarget& MultiplayerGame::BeginWorldTarget(sf::RenderWindow& window) {
+    const float scale = renderScale.GetScale();
+    if (scale >= RenderScaleController::MAX_SCALE) {
+        worldSprite.reset();
+        worldTarget.reset();
+        return window;
+    }
+    const sf::Vector2u size(std::max(1u, static_cast<unsigned int>(window.getSize().x * scale + 0.5f)),
+        std::max(1u, static_cast<unsigned int>(window.getSize().y * scale + 0.5f)));
+    if (!worldTarget || worldTarget->getSize() != size) {
+        worldSprite.reset();
+        try {
+            if (!worldTarget) {
+                worldTarget = std::make_unique<sf::RenderTexture>();
+            }
+            if (!worldTarget->resize(size)) {
+                Utils::printMsg("Warning: Could not create the world render target, rendering at full resolution", warning);
+                worldTarget.reset();
+                renderScale.SetEnabled(false);
+                return window;
+            }
+            worldTarget->setSmooth(true);
+            worldSprite = std::make_unique<sf::Sprite>(worldTarget->getTexture());
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Error: Exception creating the world render target - " + std::string(e.what()), error);
+            worldTarget.reset();
+            renderScale.SetEnabled(false);
+            return window;
         }
     }
-    for (auto& bullet : bullets) {
-        if (bullet) {
-            bullet->Render(window);
+    worldTarget->clear(sf::Color::Black);
+    return *worldTarget;
+}
+
+/**
+ * Stretches the world target over the window with smoothing, under the
+ * default view, and puts the camera back for the labels drawn after it.
+ */
+void MultiplayerGame::PresentWorldTarget(sf::RenderWindow& window) {
+    if (!worldTarget || !worldSprite) {
+        return;
+    }
+    TRACE_SCOPE("World upscale", "render");
+    worldTarget->display();
+    const sf::Vector2u size = worldTarget->getSize();
+    const sf::View& screen = window.getDefaultView();
+    worldSprite->setScale({ screen.getSize().x / static_cast<float>(size.x), screen.getSize().y / static_cast<float>(size.y) });
+    window.setView(screen);
+    window.draw(*worldSprite);
+    window.setView(camera);
+}
+
+/**
+ * Pushes the current tier's settings into the systems it scales; labels are
+ * checked in the render pass.
+ */
+void MultiplayerGame::ApplyQualityTier() {
+    const QualityController::Tier& tier = quality.GetTierSettings();
+    healthBars.SetShowBorder(tier.healthBarBorder);
+    healthBars.SetShowBackground(tier.healthBarBackground);
+    particles.SetBurstScale(tier.particleScale);
+    minimap.SetRefreshInterval(tier.minimapInterval);
+    Utils::printMsg("Render quality tier " + std::to_string(quality.GetTier()) + " (busy " +
+        std::to_string(static_cast<int>(quality.GetLastBusyFraction() * 100.0f)) + "% of the frame budget)", debug);
+}
+
+/**
+ * The first press starts recording; later presses write what has been
+ * recorded so far, shifted onto the server clock so the file lines up with a
+ * server trace of the same session.
+ */
+void MultiplayerGame::ToggleTrace() {
+    TraceRecorder& tracer = TraceRecorder::Instance();
+    if (!TraceRecorder::IsEnabled()) {
+        TraceRecorder::SetThreadName("Main");
+        tracer.SetEnabled(true);
+        Utils::printMsg("Tracing started, press F4 again to write the trace");
+        return;
+    }
+    const uint32_t playerId = networkClient ? networkClient->GetLocalPlayerId() : 0;
+    tracer.SetProcessName("Client " + playerName, 2 + playerId);
+    const int64_t offsetMicros = networkClient ? networkClient->GetClockSync().GetOffsetMicros() : 0;
+    tracer.WriteChromeTrace("client-trace-" + std::to_string(++traceDumpCount) + ".json", offsetMicros);
+}
+
+/**
+ * Takes the theme's 512x512 tile (falling back to the full-size image, then
+ * to the plain white placeholder) with repeat on, and covers the world with
+ * one sprite whose texture rect is the world size, so the GPU wraps the tile
+ * across it. A half-resolution tile (small window) gets a texture rect half
+ * as large and the sprite twice the scale, so the pattern keeps its size.
+ * @return true (the placeholder always exists)
+ */
+bool MultiplayerGame::LoadBackground() {
+    AssetManager& assets = AssetManager::Instance();
+    const std::string tilePath = "Assets/background_" + backgroundTheme + "_tile.png";
+    const std::string fullPath = "Assets/background_" + backgroundTheme + ".png";
+    std::string path = tilePath;
+    backgroundTexture = assets.LoadTexture(tilePath, false, true, true);
+    if (!assets.IsTextureLoaded(tilePath)) {
+        Utils::printMsg("Warning: Could not load background tile " + tilePath + " - trying " + fullPath, warning);
+        path = fullPath;
+        backgroundTexture = assets.LoadTexture(fullPath, false, true, true);
+    }
+    const float scale = assets.GetTextureScale(path);
+    background = std::make_unique<sf::Sprite>(*backgroundTexture);
+    background->setTextureRect(sf::IntRect({ 0, 0 },
+        { static_cast<int>(WorldConstants::WORLD_WIDTH * scale), static_cast<int>(WorldConstants::WORLD_HEIGHT * scale) }));
+    background->setScale({ 1.0f / scale, 1.0f / scale });
+    return true;
+}
+
+/**
+ * Renders the background and every border sprite once into a world-sized
+ * render texture, replacing a few dozen draws per frame with one. Its
+ * mipmaps serve the minimap, which draws the whole layer a fraction of its size.
+ * @return false if the render texture could not be created
+ */
+bool MultiplayerGame::BakeStaticLayer() {
+    staticLayerSprite.reset();
+    staticLayer.reset();
+    try {
+        auto layer = std::make_unique<sf::RenderTexture>();
+        const sf::Vector2u size(static_cast<unsigned int>(WorldConstants::WORLD_WIDTH),
+            static_cast<unsigned int>(WorldConstants::WORLD_HEIGHT));
+        if (!layer->resize(size)) {
+            return false;
+        }
+        layer->clear(sf::Color::Black);
+        if (background) layer->draw(*background);
+        if (borderManager) borderManager->Draw(*layer);
+        layer->display();
+        if (!layer->generateMipmap()) {
+            Utils::printMsg("Warning: No mipmaps for the static layer, the minimap samples it at full size", warning);
         }
+
+        staticLayer = std::move(layer);
+        staticLayerSprite = std::make_unique<sf::Sprite>(staticLayer->getTexture());
+        return true;
     }
-    // Only render local tank if alive
-    if (localTank && networkClient && !networkClient->GetServerAuthoritativeIsDead()) {
-        localTank->Render(window);
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Exception baking static layer - " + std::string(e.what()), error);
+        staticLayer.reset();
+        return false;
     }
-    for (auto it = otherTanks.begin(); it != otherTanks.end(); ++it) {
-        // Only render other players if they're alive
-        uint32_t playerId = it->first;
-        const auto& otherPlayersData = networkClient->GetOtherPlayers();
-        auto playerDataIt = otherPlayersData.find(playerId);
+}
 
-        if (playerDataIt != otherPlayersData.end() && !playerDataIt->second.isDead) {
-            it->second->Render(window);
+/**
+ * One quad per non-grass tile of every loaded chunk, tinted by kind, then
+ * the chunks' obstacles on top: a dark outline quad with a lighter inset.
+ */
+void MultiplayerGame::BakeMinimapBackground() {
+    if (!minimap.IsReady()) return;
+    const sf::Drawable* staticContent = staticLayerSprite ? static_cast<const sf::Drawable*>(staticLayerSprite.get()) : background.get();
+    minimap.BakeBackground(staticContent, chunkTiles.getVertexCount() > 0 ? &chunkTiles : nullptr);
+}
+
+void MultiplayerGame::RebuildChunkTiles() {
+    static constexpr std::array<sf::Color, static_cast<size_t>(WorldChunks::TileKind::COUNT)> TILE_TINTS = {
+        sf::Color::Transparent,             // GRASS
+        sf::Color(110, 80, 50, 70),         // DIRT
+        sf::Color(128, 128, 128, 60),       // GRAVEL
+        sf::Color(30, 25, 20, 90)           // SCORCHED
+    };
+    static constexpr std::array<sf::Color, static_cast<size_t>(StaticObstacles::Kind::COUNT)> OBSTACLE_EDGES = {
+        sf::Color(60, 60, 65),              // WALL
+        sf::Color(90, 60, 30)               // CRATE
+    };
+    static constexpr std::array<sf::Color, static_cast<size_t>(StaticObstacles::Kind::COUNT)> OBSTACLE_FILLS = {
+        sf::Color(115, 115, 120),           // WALL
+        sf::Color(160, 115, 65)             // CRATE
+    };
+    static constexpr float OBSTACLE_INSET = 3.0f;
+
+    auto appendQuad = [this](sf::Vector2f topLeft, sf::Vector2f bottomRight, sf::Color color) {
+        chunkTiles.append(sf::Vertex{ topLeft, color });
+        chunkTiles.append(sf::Vertex{ sf::Vector2f(bottomRight.x, topLeft.y), color });
+        chunkTiles.append(sf::Vertex{ bottomRight, color });
+        chunkTiles.append(sf::Vertex{ topLeft, color });
+        chunkTiles.append(sf::Vertex{ bottomRight, color });
+        chunkTiles.append(sf::Vertex{ sf::Vector2f(topLeft.x, bottomRight.y), color });
+    };
+    chunkTiles.clear();
+    drawnChunkVersion = networkClient ? networkClient->GetChunkVersion() : 0;
+    if (!networkClient) return;
+
+    for (const auto& [chunk, content] : networkClient->GetLoadedChunks()) {
+        const sf::Vector2f origin = WorldChunks::ChunkOrigin(chunk);
+        for (int tile = 0; tile < WorldChunks::TILE_COUNT; ++tile) {
+            const size_t kind = content.tiles[tile];
+            if (kind == 0 || kind >= TILE_TINTS.size()) continue;
+            const sf::Vector2f topLeft = origin + sf::Vector2f((tile % WorldChunks::TILES_PER_SIDE) * WorldChunks::TILE_SIZE,
+                (tile / WorldChunks::TILES_PER_SIDE) * WorldChunks::TILE_SIZE);
+            appendQuad(topLeft, topLeft + sf::Vector2f(WorldChunks::TILE_SIZE, WorldChunks::TILE_SIZE), TILE_TINTS[kind]);
+        }
+    }
+
+    // After every chunk's tiles, so no tile covers a neighbour's obstacle
+    for (const auto& [chunk, content] : networkClient->GetLoadedChunks()) {
+        for (const StaticObstacles::Obstacle& obstacle : content.obstacles) {
+            const size_t kind = static_cast<size_t>(obstacle.kind);
+            const sf::Vector2f topLeft(obstacle.box.left, obstacle.box.top);
+            const sf::Vector2f bottomRight(obstacle.box.right, obstacle.box.bottom);
+            const sf::Vector2f inset(OBSTACLE_INSET, OBSTACLE_INSET);
+            appendQuad(topLeft, bottomRight, OBSTACLE_EDGES[kind]);
+            appendQuad(topLeft + inset, bottomRight - inset, OBSTACLE_FILLS[kind]);
         }
     }
+}
+
+/**
+ * Centres on the local tank while it is alive and holds still otherwise. The
+ * centre is clamped so the view never shows past the world edge; on an axis
+ * where the world is no larger than the window it stays on the world centre,
+ * which at the default world size is exactly the default view.
+ */
+void MultiplayerGame::UpdateCamera(const sf::RenderWindow& window, bool followLocalTank) {
+    const sf::Vector2f size(window.getSize());
+    sf::Vector2f center = cameraPlaced ? camera.getCenter() : sf::Vector2f(WorldConstants::CENTER_X, WorldConstants::CENTER_Y);
+    if (followLocalTank && localTank) {
+        center = localTank->GetRenderPosition();
+    }
+    center.x = size.x >= WorldConstants::WORLD_WIDTH ? WorldConstants::CENTER_X
+        : std::clamp(center.x, size.x / 2.0f, WorldConstants::WORLD_WIDTH - size.x / 2.0f);
+    center.y = size.y >= WorldConstants::WORLD_HEIGHT ? WorldConstants::CENTER_Y
+        : std::clamp(center.y, size.y / 2.0f, WorldConstants::WORLD_HEIGHT - size.y / 2.0f);
+    camera.setSize(size);
+    camera.setCenter(center);
+    cameraPlaced = true;
+}
+
+void MultiplayerGame::RenderWorld(sf::RenderWindow& window) {
+    const bool localAlive = localTank && networkClient && !networkClient->GetServerAuthoritativeIsDead();
+    if (localAlive) {
+        UpdateLocalTankRenderState();
+    }
+    UpdateCamera(window, localAlive);
+    preparedEntities.localAlive = localAlive;
+    renderPrepare.Start();
+    sf::RenderTarget& world = BeginWorldTarget(window);
+    world.setView(camera);
+    window.setView(camera);
+
+    {
+        TRACE_SCOPE("Static layer", "render");
+        if (staticLayerSprite) {
+            world.draw(*staticLayerSprite);
+        }
+        else {
+            if (background) world.draw(*background);
+            if (borderManager) borderManager->Draw(world);
+        }
+        if (networkClient && networkClient->GetChunkVersion() != drawnChunkVersion) {
+            RebuildChunkTiles();
+            BakeMinimapBackground();
+        }
+        if (chunkTiles.getVertexCount() > 0) {
+            world.draw(chunkTiles);
+        }
+    }
+
+    {
+        TRACE_SCOPE("Wait for render prepare", "render");
+        renderPrepare.Wait();
+    }
+    {
+        TRACE_SCOPE("Batch draw", "render");
+        // Tanks first: the batch's bullets, effects and health bars go over them
+        tankBatch.Draw(world);
+        spriteBatch.Draw(world);
+    }
+    PresentWorldTarget(window);
+
+    // Name labels are text, so they stay individual draws on top of the batch
+    TRACE_SCOPE("Labels and HUD", "render");
+    if (preparedEntities.localVisible && quality.GetTierSettings().nameLabels) {
+        localTank->RenderNameLabel(window);
+    }
+    for (entt::entity entity : visibleLabels) {
+        const sf::Vector2f position = remoteRegistry.get<ClientComponents::Transform>(entity).position;
+        sf::Text& text = nameLabels[remoteRegistry.get<ClientComponents::Label>(entity).slot].text;
+        text.setPosition({ position.x, position.y - NAME_LABEL_OFFSET });
+        window.draw(text);
+    }
+    if (debugOverlay) {
+        debugOverlay->SetCullCounts(preparedEntities.drawn, preparedEntities.culled);
+    }
+    if (minimap.IsRefreshDue()) {
+        TRACE_SCOPE("Minimap refresh", "render");
+        minimap.Refresh(remoteRegistry, localAlive, localAlive ? localTank->GetRenderPosition() : sf::Vector2f(), camera);
+    }
+    window.setView(window.getDefaultView());
+    minimap.Render(window);
     if (scoreFontLoaded && scoreText) {
-        scoreText->setString("Score: " + std::to_string(playerScore));
+        // Reformat (and rebuild the text geometry) only when the score changes
+        if (playerScore != displayedScore) {
+            scoreText->setString("Score: " + std::to_string(playerScore));
+            displayedScore = playerScore;
+        }
         window.draw(*scoreText);
 
         // Show "DEAD - Respawning..." overlay if player is dead
-        if (networkClient && networkClient->GetServerAuthoritativeIsDead()) {
-            sf::Text deadText(scoreFont);
-            deadText.setString("DEAD - Respawning...");
-            deadText.setCharacterSize(48);
-            deadText.setFillColor(sf::Color::Red);
-            deadText.setOutlineColor(sf::Color::Black);
-            deadText.setOutlineThickness(3.0f);
-
-            // Center on screen
-            sf::FloatRect textBounds = deadText.getLocalBounds();
-            deadText.setPosition(
+        if (deadText && networkClient && networkClient->GetServerAuthoritativeIsDead()) {
+            // Center on screen (bounds are cached by the text)
+            sf::FloatRect textBounds = deadText->getLocalBounds();
+            deadText->setPosition(
                 sf::Vector2f((window.getSize().x - textBounds.size.x) / 2.0f,
                     (window.getSize().y - textBounds.size.y) / 2.0f)
             );
+            window.draw(*deadText);
+        }
+    }
+}
 
-            window.draw(deadText);
+/**
+ * Runs on the render prepare thread (or inline, see FrameWorker) between
+ * renderPrepare.Start and Wait in RenderWorld: culls against the camera,
+ * submits every visible entity to the batch and sorts it, touching no GPU
+ * state. The local tank's render state and the camera are updated before it starts.
+ */
+void MultiplayerGame::PrepareEntities() {
+    TRACE_SCOPE("Render prepare", "render");
+    // Cull against the view, grown by the largest thing drawn around an entity
+    // (name label and health bar above it, barrel beside it)
+    const sf::View& view = camera;
+    const sf::Vector2f viewMin = view.getCenter() - view.getSize() / 2.0f;
+    const sf::Vector2f viewMax = view.getCenter() + view.getSize() / 2.0f;
+    PreparedEntities& prepared = preparedEntities;
+    prepared.drawn = 0;
+    prepared.culled = 0;
+    const auto inView = [&](sf::Vector2f position, float radius) {
+        const float extent = radius + RENDER_CULL_MARGIN;
+        const bool visible = position.x + extent >= viewMin.x && position.x - extent <= viewMax.x &&
+            position.y + extent >= viewMin.y && position.y - extent <= viewMax.y;
+        (visible ? prepared.drawn : prepared.culled)++;
+        return visible;
+    };
+
+    // Entities go through the batch: one draw per layer instead of several per entity
+    spriteBatch.Begin();
+    tankBatch.Begin();
+    const entt::registry& registry = remoteRegistry;     // Const: views never create storage here
+    const auto enemyView = registry.view<const ClientComponents::Transform, const ClientComponents::SpriteRef,
+        const ClientComponents::Health, const ClientComponents::EnemyKind>();
+    for (auto [entity, transform, sprite, health, kind] : enemyView.each()) {
+        if (!health.dead && inView(transform.position, transform.radius)) {
+            SubmitRemoteTank(transform, sprite, health);
+        }
+    }
+    for (auto& bullet : bullets) {
+        if (bullet && inView(bullet->GetPosition(), bullet->GetRadius())) {
+            bullet->SubmitTo(spriteBatch);
         }
     }
+    particles.SubmitTo(spriteBatch);
+    // Only render tanks that are alive; visible labelled ones are kept for the label pass
+    prepared.localVisible = prepared.localAlive && inView(localTank->GetRenderPosition(), localTank->GetRadius());
+    if (prepared.localVisible) {
+        if (!localTank->SubmitTo(tankBatch)) {
+            localTank->SubmitTo(spriteBatch);
+        }
+        if (localTank->IsHealthBarVisible()) {
+            healthBars.Submit(spriteBatch, localTank->GetRenderPosition(), localTank->GetHealth(), localTank->GetMaxHealth());
+        }
+    }
+    visibleLabels.clear();
+    const bool showLabels = quality.GetTierSettings().nameLabels;
+    const auto playerView = registry.view<const ClientComponents::Transform, const ClientComponents::SpriteRef,
+        const ClientComponents::Health, const ClientComponents::PlayerTag>();
+    for (auto [entity, transform, sprite, health] : playerView.each()) {
+        if (!health.dead && inView(transform.position, transform.radius)) {
+            SubmitRemoteTank(transform, sprite, health);
+            if (showLabels && registry.all_of<ClientComponents::Label>(entity)) {
+                visibleLabels.push_back(entity);
+            }
+        }
+    }
+    spriteBatch.Prepare();
 }
 
 bool MultiplayerGame::IsConnected() const {
@@ -558,10 +1408,32 @@ bool MultiplayerGame::IsConnected() const {
 
 size_t MultiplayerGame::GetPlayerCount() const {
     size_t count = localTank ? 1 : 0;
-    count += otherTanks.size();
+    if (const auto* players = remoteRegistry.storage<ClientComponents::PlayerTag>()) {
+        count += players->size();
+    }
     return count;
 }
 
+/**
+ * Body and barrel into the tank batch, or else from the shared sprites placed
+ * at the transform into the sprite batch; the health bar into the sprite batch.
+ */
+void MultiplayerGame::SubmitRemoteTank(const ClientComponents::Transform& transform,
+    const ClientComponents::SpriteRef& sprite, const ClientComponents::Health& health) {
+    if (!tankBatch.AddTank(sprite.sprites->body, sprite.sprites->barrel, transform.position,
+            sf::degrees(transform.bodyRotation), sf::degrees(transform.barrelRotation))) {
+        sf::Sprite body = sprite.sprites->body;
+        sf::Sprite barrel = sprite.sprites->barrel;
+        body.setPosition(transform.position);
+        barrel.setPosition(transform.position);
+        body.setRotation(sf::degrees(transform.bodyRotation));
+        barrel.setRotation(sf::degrees(transform.barrelRotation));
+        spriteBatch.AddSprite(RenderLayer::BODIES, body);
+        spriteBatch.AddSprite(RenderLayer::BARRELS, barrel);
+    }
+    healthBars.Submit(spriteBatch, transform.position, health.current, health.max);
+}
+
 float MultiplayerGame::GetAverageRTT() const {
     return networkClient ? networkClient->GetAverageRTT() : 35.0f;
 }
@@ -573,33 +1445,34 @@ float MultiplayerGame::GetAverageRTT() const {
 void MultiplayerGame::UpdateEnemies(const std::unordered_map<uint32_t, EnemyData>& enemyData) {
     try {
         // Remove enemies that no longer exist on server OR are dead locally
-        auto it = enemies.begin();
-        while (it != enemies.end()) {
-            uint32_t enemyId = it->first;
-
-            // Remove if server stopped sending OR if dead locally
-            if (enemyData.find(enemyId) == enemyData.end() ||
-                (it->second && it->second->IsDead())) {
-
-                Utils::printMsg("Enemy " + std::to_string(enemyId) + " removed", debug);
-                it = enemies.erase(it);
-            }
-            else {
-                ++it;
-            }
+        removedEntities.clear();
+        remoteRegistry.view<const ClientComponents::NetId, const ClientComponents::Health, const ClientComponents::EnemyKind>().each(
+            [&](entt::entity entity, const ClientComponents::NetId& netId, const ClientComponents::Health& health,
+                const ClientComponents::EnemyKind&) {
+                if (enemyData.find(netId.id) == enemyData.end() || health.dead) {
+                    Utils::printMsg("Enemy " + std::to_string(netId.id) + " removed", debug);
+                    removedEntities.push_back(entity);
+                }
+            });
+        for (entt::entity entity : removedEntities) {
+            DestroyRemote(entity);
         }
 
         // Create or update enemies from server data
         for (const auto& [enemyId, data] : enemyData) {
-            auto enemyIt = enemies.find(enemyId);
+            const entt::entity entity = FindRemote(enemyId);
 
-            if (enemyIt == enemies.end()) {
+            if (entity == entt::null) {
                 // New enemy - create it
                 CreateEnemyFromData(enemyId, data);
             }
+            else if (IsInterpolating()) {
+                // Pose comes from ApplyInterpolatedStates; server IS authoritative for enemy health
+                remoteRegistry.replace<ClientComponents::Health>(entity, data.health, data.maxHealth, data.health <= 0.0f);
+            }
             else {
                 // Existing enemy - update position/rotation only
-                UpdateEnemyFromData(*enemyIt->second, data);
+                UpdateEnemyFromData(entity, data);
             }
         }
 
@@ -608,7 +1481,8 @@ void MultiplayerGame::UpdateEnemies(const std::unordered_map<uint32_t, EnemyData
         static float lastDt = 0.016f;
         logTimer += lastDt;
         if (logTimer >= 5.0f) {
-            Utils::printMsg("Client: " + std::to_string(enemies.size()) + " enemies active", debug);
+            Utils::printMsg("Client: " + std::to_string(remoteRegistry.storage<ClientComponents::EnemyKind>().size()) +
+                " enemies active", debug);
             logTimer = 0;
         }
     }
@@ -624,28 +1498,23 @@ void MultiplayerGame::UpdateEnemies(const std::unordered_map<uint32_t, EnemyData
  * @param data Enemy data received from server
  */
 void MultiplayerGame::CreateEnemyFromData(uint32_t enemyId, const EnemyData& data) {
+    static constexpr sf::Vector2f ENEMY_BARREL_ORIGIN{ 6.0f, 5.0f };
     try {
         // Convert network type to EnemyType enum
-        EnemyTank::EnemyType enemyType = ConvertEnemyType(data.enemyType);
-
-        // Create enemy at the position specified
-        sf::Vector2f position(data.x, data.y);
-        auto newEnemy = std::make_unique<EnemyTank>(enemyType, position);
-
-        // Set rotation from network data
-        newEnemy->SetBodyRotation(sf::degrees(data.bodyRotation));
-        newEnemy->SetBarrelRotation(sf::degrees(data.barrelRotation));
+        const EnemyTank::EnemyType enemyType = ConvertEnemyType(data.enemyType);
+        const EnemyTank::Archetype& archetype = EnemyTank::GetArchetype(enemyType);
+
+        const entt::entity entity = remoteRegistry.create();
+        remoteRegistry.emplace<ClientComponents::NetId>(entity, enemyId);
+        remoteRegistry.emplace<ClientComponents::EnemyKind>(entity, enemyType);
+        remoteRegistry.emplace<ClientComponents::Transform>(entity, sf::Vector2f(data.x, data.y),
+            data.bodyRotation, data.barrelRotation, EnemyTank::COLLISION_RADIUS);
         //  Set health from server data on creation
-        newEnemy->SetHealth(data.health);
-        newEnemy->SetMaxHealth(data.maxHealth);
+        remoteRegistry.emplace<ClientComponents::Health>(entity, data.health, data.maxHealth, data.health <= 0.0f);
+        remoteRegistry.emplace<ClientComponents::SpriteRef>(entity, &GetTankSprites(archetype.colorString, ENEMY_BARREL_ORIGIN));
+        remoteEntities[enemyId] = entity;
 
-        // Update sprites with initial data
-        newEnemy->UpdateSprites();
-
-        // Add to enemies map
-        enemies[enemyId] = std::move(newEnemy);
-
-        Utils::printMsg("Created " + enemies[enemyId]->GetEnemyTypeName() +
+        Utils::printMsg("Created " + std::string(archetype.name) +
             " (ID: " + std::to_string(enemyId) + ")", success);
     }
     catch (const std::exception& e) {
@@ -655,29 +1524,18 @@ void MultiplayerGame::CreateEnemyFromData(uint32_t enemyId, const EnemyData& dat
 
 /**
  * Updates an existing enemy tank with new network data
- * @param enemy Reference to enemy tank to update
+ * @param entity Enemy to update
  * @param data New data from server
  */
-void MultiplayerGame::UpdateEnemyFromData(EnemyTank& enemy, const EnemyData& data) {
-    try {
-        // Update position
-        enemy.SetPosition(sf::Vector2f(data.x, data.y));
-
-        // Update rotations
-        enemy.SetBodyRotation(sf::degrees(data.bodyRotation));
-        enemy.SetBarrelRotation(sf::degrees(data.barrelRotation));
-
-        // Sync health from server (server IS authoritative for enemy health)
-        // Server tracks bullet damage and enemy health, so we must sync it
-        enemy.SetHealth(data.health);
-        enemy.SetMaxHealth(data.maxHealth);
-
-        // Update sprites
-        enemy.UpdateSprites();
-    }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception in UpdateEnemyFromData: " + std::string(e.what()), error);
-    }
+void MultiplayerGame::UpdateEnemyFromData(entt::entity entity, const EnemyData& data) {
+    auto& transform = remoteRegistry.get<ClientComponents::Transform>(entity);
+    transform.position = sf::Vector2f(data.x, data.y);
+    transform.bodyRotation = data.bodyRotation;
+    transform.barrelRotation = data.barrelRotation;
+
+    // Sync health from server (server IS authoritative for enemy health)
+    // Server tracks bullet damage and enemy health, so we must sync it
+    remoteRegistry.replace<ClientComponents::Health>(entity, data.health, data.maxHealth, data.health <= 0.0f);
 }
 /**
  * Converts network enemy type value to EnemyType enum
@@ -697,37 +1555,36 @@ EnemyTank::EnemyType MultiplayerGame::ConvertEnemyType(uint8_t typeValue) {
         return EnemyTank::EnemyType::RED;
     }
 }
+/**
+ * Moves every enemy and other player to its position for this frame. Most
+ * stay in their cell, so this is an in-place write per tank; tanks that
+ * left are removed where they are erased.
+ */
+void MultiplayerGame::SyncTankGrid() {
+    for (auto [entity, netId, transform] : remoteRegistry.view<const ClientComponents::NetId, const ClientComponents::Transform>().each()) {
+        const CollisionLayers::Mask layer = remoteRegistry.all_of<ClientComponents::EnemyKind>(entity) ?
+            CollisionLayers::ENEMY : CollisionLayers::PLAYER;
+        tankGrid.Update(netId.id, transform.position, transform.radius, layer, CollisionLayers::DefaultMask(layer));
+    }
+}
+
 /**
  * SIMPLIFIED: Just detect collisions for feedback, don't block movement
  * Server is authoritative for collision resolution
  * This prevents client-server position fighting
+ * Uses the shared SpatialGrid broadphase so only nearby tanks are tested
  */
 void MultiplayerGame::CheckTankCollisions() {
     if (!localTank) return;
 
-    const float TANK_RADIUS = 25.0f;
+    const float TANK_RADIUS = WorldConstants::TANK_RADIUS;
 
     // Just check for collision, don't modify position
     // Let server handle authoritative collision resolution
-
-    // Check collision with enemies
-    for (auto& [enemyId, enemy] : enemies) {
-        if (!enemy) continue;
-
+    tankGrid.Query(localTank->position, TANK_RADIUS, collisionCandidates);
+    for (const SpatialGrid::Entry* candidate : collisionCandidates) {
         if (CheckCircleCollision(localTank->position, TANK_RADIUS,
-            enemy->GetPosition(), enemy->GetRadius())) {
-            // Collision detected - could add visual/audio feedback here
-            // But don't modify position - server will handle it
-            return;
-        }
-    }
-
-    // Check collision with other player tanks
-    for (auto& [playerId, otherTank] : otherTanks) {
-        if (!otherTank) continue;
-
-        if (CheckCircleCollision(localTank->position, TANK_RADIUS,
-            otherTank->position, TANK_RADIUS)) {
+            candidate->position, candidate->radius)) {
             // Collision detected - could add visual/audio feedback here
             // But don't modify position - server will handle it
             return;
@@ -745,17 +1602,8 @@ void MultiplayerGame::CheckTankCollisions() {
  */
 bool MultiplayerGame::CheckCircleCollision(sf::Vector2f pos1, float radius1,
     sf::Vector2f pos2, float radius2) {
-    // Calculate distance between centers
-    float dx = pos2.x - pos1.x;
-    float dy = pos2.y - pos1.y;
-    float distanceSquared = dx * dx + dy * dy;
-
-    // Calculate minimum distance for collision
-    float minDistance = radius1 + radius2;
-    float minDistanceSquared = minDistance * minDistance;
-
-    // Collision occurs if distance is less than sum of radii
-    return distanceSquared < minDistanceSquared;
+    // Same rule the batched kernels apply
+    return CircleBatch::Overlaps(pos1, radius1, pos2, radius2);
 }
 
 
@@ -780,7 +1628,8 @@ void MultiplayerGame::CheckBulletEnemyCollisions() {
     collisionChecks++;
 
     // Iterate through all bullets
-    for (auto& bullet : bullets) {
+    for (size_t index = 0; index < bullets.Size(); ++index) {
+        std::unique_ptr<Bullet>& bullet = bullets.begin()[index];
         if (!bullet || bullet->IsDestroyed()) {
             continue;
         }
@@ -800,46 +1649,41 @@ void MultiplayerGame::CheckBulletEnemyCollisions() {
             continue;
         }
 
-        // Now we know this is a player bullet - check against enemies
-        for (auto& [enemyId, enemy] : enemies) {
-            if (!enemy || enemy->IsDead()) {
-                continue;
+        // Now we know this is a player bullet - check the enemies near it
+        // One bullet can only hit one enemy: the first one overlapping
+        entt::entity hitEnemy = entt::null;
+        tankGrid.Query(bulletPos, bulletRadius, collisionCandidates, CollisionLayers::PLAYER_BULLET_MASK);
+        for (const SpatialGrid::Entry* candidate : collisionCandidates) {
+            const entt::entity entity = FindRemote(candidate->id);
+            if (entity == entt::null || remoteRegistry.get<ClientComponents::Health>(entity).dead) {
+                continue;   // Later bullets this frame pass through a wreck
             }
+            if (CheckCircleCollision(bulletPos, bulletRadius, candidate->position, candidate->radius)) {
+                hitEnemy = entity;
+                break;
+            }
+        }
+        if (hitEnemy == entt::null) {
+            continue;
+        }
 
-            // Check circle collision
-            if (CheckCircleCollision(bulletPos, bulletRadius,
-                enemy->GetPosition(), enemy->GetRadius())) {
-
-                // HIT!
-                float damage = bullet->GetDamage();
-                float oldHealth = enemy->GetHealth();
-
-                enemy->TakeDamage(damage);
-
-                float newHealth = enemy->GetHealth();
-
-                //Utils::printMsg("HIT! Enemy " + std::to_string(enemyId) +
-                //    " (" + enemy->GetEnemyTypeName() +
-                //    ") damaged: " + std::to_string(oldHealth) +
-                //    " → " + std::to_string(newHealth) + " HP", success);
-
-                // Check if enemy died
-                if (enemy->IsDead()) {
-                    int points = enemy->GetScoreValue();
-                    // NOTE: Don't modify playerScore here - server is authoritative
-                    // Score will be synced from server in next game state update
-
-                    Utils::printMsg(" Enemy DESTROYED! +" + std::to_string(points) +
-                        " points (server will update)", success);
-                }
+        // HIT! Local feedback only; the server's health arrives with the next state
+        auto& health = remoteRegistry.get<ClientComponents::Health>(hitEnemy);
+        health.current = std::max(0.0f, health.current - bullet->GetDamage());
+        health.dead = health.current <= 0.0f;
 
-                // Destroy bullet
-                bullet->Destroy();
+        // Check if enemy died
+        if (health.dead) {
+            int points = EnemyTank::GetArchetype(remoteRegistry.get<ClientComponents::EnemyKind>(hitEnemy).type).scoreValue;
+            // NOTE: Don't modify playerScore here - server is authoritative
+            // Score will be synced from server in next game state update
 
-                // One bullet can only hit one enemy
-                break;
-            }
+            Utils::printMsg(" Enemy DESTROYED! +" + std::to_string(points) +
+                " points (server will update)", success);
         }
+
+        // Destroy bullet
+        DestroyBulletAt(index);
     }
 
     // Log every 60 frames (about once per second)
@@ -859,7 +1703,8 @@ void MultiplayerGame::CheckBulletBorderCollisions() {
 
     sf::FloatRect worldBounds = borderManager->GetWorldBounds();
 
-    for (auto& bullet : bullets) {
+    for (size_t index = 0; index < bullets.Size(); ++index) {
+        const std::unique_ptr<Bullet>& bullet = bullets.begin()[index];
         if (!bullet || bullet->IsDestroyed()) {
             continue;
         }
@@ -872,7 +1717,7 @@ void MultiplayerGame::CheckBulletBorderCollisions() {
             bulletPos.y < worldBounds.position.y ||
             bulletPos.y > worldBounds.position.y + worldBounds.size.y) {
 
-            bullet->Destroy();
+            DestroyBulletAt(index);
             Utils::printMsg("Bullet hit border and was destroyed", debug);
         }
     }
@@ -883,56 +1728,53 @@ void MultiplayerGame::SynchronizeBulletsFromServer() {
     try {
         const auto& serverBullets = networkClient->GetBullets();
 
-        // STRATEGY: Replace local bullets with server state
-        // Clear all bullets and recreate from server data
-        // This ensures server is always authoritative
-
-        // Track which bullets exist on server
-        std::unordered_set<uint32_t> serverBulletIds;
-        for (const auto& [bulletId, bulletData] : serverBullets) {
-            serverBulletIds.insert(bulletId);
-        }
-
-        // Remove bullets not on server (client predicted bullets that server rejected/destroyed)
-        bullets.erase(
-            std::remove_if(bullets.begin(), bullets.end(),
-                [&serverBulletIds](const std::unique_ptr<Bullet>& bullet) {
-                    uint32_t bulletId = bullet->GetBulletId();
-                    // Keep bullets with ID 0 (local predicted, waiting for server confirmation)
-                    // Remove bullets with IDs not in server list
-                    return bulletId != 0 && serverBulletIds.find(bulletId) == serverBulletIds.end();
-                }),
-            bullets.end()
-        );
-
-        // Add or update bullets from server
-        for (const auto& [bulletId, bulletData] : serverBullets) {
-            // Check if we already have this bullet
-            auto it = std::find_if(bullets.begin(), bullets.end(),
-                [bulletId](const std::unique_ptr<Bullet>& bullet) {
-                    return bullet->GetBulletId() == bulletId;
-                });
-
-            if (it != bullets.end()) {
-                // Update existing bullet position (server correction)
-                (*it)->position = sf::Vector2f(bulletData.x, bulletData.y);
-                (*it)->velocity = sf::Vector2f(bulletData.velocityX, bulletData.velocityY);
-                (*it)->rotation = bulletData.rotation;
+        // Only bullets the client reported as changed or removed are touched
+        if (networkClient->TakeBulletChanges(changedBulletIds, removedBulletIds)) {
+            // Change lists overflowed: drop bullets the server no longer has and revisit the rest
+            for (auto it = serverBulletHandles.begin(); it != serverBulletHandles.end();) {
+                if (!serverBullets.Contains(it->first)) {
+                    RemoveBullet(it->second);
+                    it = serverBulletHandles.erase(it);
+                }
+                else {
+                    ++it;
+                }
             }
-            else {
-                // Create new bullet from server data
-                CreateBulletFromServerData(bulletData);
+            for (size_t index = 0; index < serverBullets.GetSize(); ++index) {
+                changedBulletIds.push_back(serverBullets.GetIdAt(index));
             }
         }
 
-        // Debug log periodically
-        static float logTimer = 0;
-        static float lastDt = 0.016f;
-        logTimer += lastDt;
-        if (logTimer >= 2.0f) {
- //           Utils::printMsg("Client bullets: " + std::to_string(bullets.size()) +
-  //              " (Server: " + std::to_string(serverBullets.size()) + ")", debug);
-            logTimer = 0;
+        for (uint32_t bulletId : removedBulletIds) {
+            auto handleIt = serverBulletHandles.find(bulletId);
+            if (handleIt != serverBulletHandles.end()) {
+                RemoveBullet(handleIt->second);
+                serverBulletHandles.erase(handleIt);
+            }
+        }
+
+        BulletData bulletData;
+        for (uint32_t bulletId : changedBulletIds) {
+            if (!serverBullets.Get(bulletId, bulletData)) {
+                continue;   // Removed again after the change
+            }
+
+            auto handleIt = serverBulletHandles.find(bulletId);
+            std::unique_ptr<Bullet>* existing =
+                handleIt != serverBulletHandles.end() ? bullets.Get(handleIt->second) : nullptr;
+            if (existing) {
+                // Update existing bullet position (server correction)
+                ApplyServerBulletState(**existing, bulletData);
+                continue;
+            }
+
+            // A bullet of ours takes over the predicted shot that carries its token
+            if (bulletData.spawnToken != 0 && bulletData.ownerId == networkClient->GetLocalPlayerId() &&
+                AdoptPredictedBullet(bulletData)) {
+                continue;
+            }
+            // Create new bullet from server data
+            CreateBulletFromServerData(bulletData);
         }
     }
     catch (const std::exception& e) {
@@ -940,6 +1782,99 @@ void MultiplayerGame::SynchronizeBulletsFromServer() {
     }
 }
 
+/**
+ * Parks a removed bullet for reuse; beyond BULLET_CAPACITY it is destroyed
+ */
+void MultiplayerGame::RecycleBullet(std::unique_ptr<Bullet> bullet) {
+    if (bullet && bulletPool.size() < BULLET_CAPACITY) {
+        bulletPool.push_back(std::move(bullet));
+    }
+}
+
+std::unique_ptr<Bullet> MultiplayerGame::TakePooledBullet() {
+    if (bulletPool.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<Bullet> bullet = std::move(bulletPool.back());
+    bulletPool.pop_back();
+    return bullet;
+}
+
+/**
+ * Destroys the bullet at a dense position and queues it for removal at the
+ * end of Update. Bullets whose lifetime already ran out are queued already.
+ */
+void MultiplayerGame::DestroyBulletAt(size_t index) {
+    Bullet& bullet = *bullets.begin()[index];
+    if (!bullet.IsExpired()) {
+        deadBulletHandles.push_back(bullets.GetHandleAt(index));
+    }
+    bullet.Destroy();
+}
+
+void MultiplayerGame::RemoveBullet(SlotMap<std::unique_ptr<Bullet>>::Handle handle) {
+    if (std::unique_ptr<Bullet>* bullet = bullets.Get(handle)) {
+        RecycleBullet(std::move(*bullet));
+        bullets.Remove(handle);
+    }
+}
+
+/**
+ * Corrects a bullet to the server's state, extrapolated along its velocity by
+ * the half round trip the update spent in flight. Small corrections move the
+ * bullet at once but leave its sprite to glide over (Bullet::AddCorrectionOffset).
+ */
+void MultiplayerGame::ApplyServerBulletState(Bullet& bullet, const BulletData& data) {
+    const float ageSeconds = GetAverageRTT() * 0.5f / 1000.0f;
+    const sf::Vector2f velocity(data.velocityX, data.velocityY);
+    const sf::Vector2f corrected = sf::Vector2f(data.x, data.y) + velocity * ageSeconds;
+    const sf::Vector2f correction = bullet.position - corrected;
+    if (correction.lengthSquared() < BULLET_SNAP_DISTANCE * BULLET_SNAP_DISTANCE) {
+        bullet.AddCorrectionOffset(correction);
+    }
+    else {
+        bullet.ClearCorrectionOffset();
+    }
+    bullet.position = corrected;
+    bullet.velocity = velocity;
+    bullet.rotation = data.rotation;
+}
+
+/**
+ * Records a locally fired bullet under its spawn token until the server
+ * bullet it turns into arrives. Without a token (nothing was sent) the bullet
+ * simply flies out its lifetime.
+ */
+void MultiplayerGame::AddPredictedBullet(std::unique_ptr<Bullet> bullet, uint16_t spawnToken) {
+    const auto handle = bullets.Insert(std::move(bullet));
+    if (spawnToken != 0) {
+        pendingShots[spawnToken % MAX_PENDING_SHOTS] = PendingShot{ handle, GetCurrentTimestamp(), spawnToken };
+    }
+}
+
+/**
+ * Gives the predicted bullet that fired data's spawn token the server ID and
+ * corrects it to the server state, so it carries on as that bullet without
+ * being replaced. Shots older than SPAWN_TOKEN_TIMEOUT_MS were rejected.
+ * @return true if a predicted bullet took over the server bullet
+ */
+bool MultiplayerGame::AdoptPredictedBullet(const BulletData& data) {
+    PendingShot& shot = pendingShots[data.spawnToken % MAX_PENDING_SHOTS];
+    if (shot.token != data.spawnToken) {
+        return false;
+    }
+    shot.token = 0;
+    std::unique_ptr<Bullet>* predicted = bullets.Get(shot.handle);
+    if (!predicted || (*predicted)->GetBulletId() != 0 ||
+        GetCurrentTimestamp() - shot.firedAt > SPAWN_TOKEN_TIMEOUT_MS) {
+        return false;
+    }
+    (*predicted)->SetBulletId(data.bulletId);
+    ApplyServerBulletState(**predicted, data);
+    serverBulletHandles[data.bulletId] = shot.handle;
+    return true;
+}
+
 /**
  * Creates a bullet from server bullet data
  */
@@ -957,13 +1892,19 @@ void MultiplayerGame::CreateBulletFromServerData(const BulletData& data) {
             direction = velocity / velLength;
         }
 
-        // Create bullet
-        auto bullet = std::make_unique<Bullet>(
-            bulletType,
-            sf::Vector2f(data.x, data.y),
-            direction,
-            data.ownerId
-        );
+        // Create bullet (reusing a pooled one when there is one)
+        std::unique_ptr<Bullet> bullet = TakePooledBullet();
+        if (bullet) {
+            bullet->Reset(bulletType, sf::Vector2f(data.x, data.y), direction, data.ownerId);
+        }
+        else {
+            bullet = std::make_unique<Bullet>(
+                bulletType,
+                sf::Vector2f(data.x, data.y),
+                direction,
+                data.ownerId
+            );
+        }
 
         // Set server-assigned ID
         bullet->SetBulletId(data.bulletId);
@@ -973,7 +1914,7 @@ void MultiplayerGame::CreateBulletFromServerData(const BulletData& data) {
         bullet->rotation = data.rotation;
 
         // Add to bullets
-        bullets.push_back(std::move(bullet));
+        serverBulletHandles[data.bulletId] = bullets.Insert(std::move(bullet));
 
      //   Utils::printMsg("Created bullet " + std::to_string(data.bulletId) +
      //       " from server (owner: " + std::to_string(data.ownerId) + ")", debug);
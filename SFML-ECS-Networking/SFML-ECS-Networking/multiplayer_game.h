@@ -1,31 +1,59 @@
 ﻿#pragma once
 
 #include <SFML/Graphics.hpp>
+#include <array>
 #include <memory>
 #include <unordered_map>
 #include <optional>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 class NetworkClient;
 class Tank;
 class BorderManager;
 class InterpolationManager;
+struct NetworkConditions;
+class LoopbackNetwork;
 
 #include "tank.h"
 #include "BorderManager.h"
 #include "entity_interpolation.h"
 #include "network_messages.h"  // For PlayerData
 #include "EnemyTank.h"
+#include "client_components.h"
 #include "Bullet.h"  
+#include "spatial_grid.h"
+#include "circle_batch.h"
+#include "slot_map.h"
+#include "debug_overlay.h"
+#include "sprite_batch.h"
+#include "tank_batch.h"
+#include "HealthBarRenderer.h"
+#include "tick_scheduler.h"
+#include "particle_system.h"
+#include "audio_system.h"
+#include "minimap.h"
+#include "quality_controller.h"
+#include "render_scale_controller.h"
+#include "frame_worker.h"
+#include "window_activity.h"
+#include <entt.hpp>
 
 class MultiplayerGame {
 public:
     MultiplayerGame();
     ~MultiplayerGame();
 
+    // Loading phase: BeginLoading decodes every texture a match can use on
+    // worker threads; call UpdateLoading and RenderLoading each frame until
+    // UpdateLoading returns true, then Initialize. Skipping it loads the same
+    // assets synchronously in Initialize
+    void BeginLoading();
+    bool UpdateLoading();
+    void RenderLoading(sf::RenderWindow& window) const;
     bool Initialize(const std::string& playerName, const std::string& preferredColor);
-    bool ConnectToServer(const std::string& serverIP, unsigned short serverPort);
+    bool ConnectToServer(const std::string& serverIP, unsigned short serverPort, uint16_t roomId = 0);
     void Shutdown();
     void HandleEvents(const std::optional<sf::Event> event);
     void Update(float dt);
@@ -37,31 +65,184 @@ public:
 
     //    Set window reference for mouse tracking
     void SetWindow(sf::RenderWindow* window) { this->window = window; }
+    // Simulated network conditions for the client socket (set before ConnectToServer)
+    void SetNetworkConditions(const NetworkConditions& conditions);
+    // Socket I/O on a background thread (set before ConnectToServer)
+    void SetNetworkThreadEnabled(bool enabled);
+    // Plays on a server in this process instead of over a socket (set before ConnectToServer)
+    void SetLoopback(LoopbackNetwork* network);
+    // Watch the room's delayed spectator stream with no tank of our own (set before Initialize)
+    void SetSpectating(bool enabled);
+    bool IsSpectating() const { return spectating; }
+    // Writes every datagram to path for CaptureAnalysis (see packet_capture.h)
+    bool StartPacketCapture(const std::string& path);
+    // Call right after window.display(): closes input latency samples at the frame that shows them
+    void OnFramePresented();
+
+    // Background mode. The main loop runs at BACKGROUND_UPDATE_HZ outside the
+    // foreground and renders at UNFOCUSED_RENDER_HZ while unfocused, not at all
+    // while minimised. Minimised, Update keeps the session alive (network
+    // receive and acks, pings, prediction steps and their inputs) and skips
+    // interpolation, entity and bullet sync and particles; interpolation
+    // restarts from the next snapshots when the window comes back.
+    static constexpr float BACKGROUND_UPDATE_HZ = 30.0f;
+    static constexpr float UNFOCUSED_RENDER_HZ = 10.0f;
+    // Call before Update each frame
+    void SetWindowActivity(WindowActivity activity);
+    WindowActivity GetWindowActivity() const { return windowActivity; }
+    // Background theme: snow, grass, desert, night or urban (set before BeginLoading)
+    void SetBackgroundTheme(const std::string& theme) { backgroundTheme = theme; }
     int GetPlayerScore() const { return playerScore; }
 
 private:
     std::unique_ptr<NetworkClient>      networkClient;
     std::unique_ptr<Tank>               localTank;
-    std::unordered_map<uint32_t, std::unique_ptr<Tank>> otherTanks;
-    std::vector<std::unique_ptr<Bullet>> bullets;
-    sf::Font scoreFont;
+    // Other players and enemies as components (client_components.h), found
+    // by NetId through remoteEntities
+    entt::registry remoteRegistry;
+    std::unordered_map<uint32_t, entt::entity> remoteEntities;
+    std::vector<entt::entity> removedEntities;      // Reused by the sync passes
+    // Sprites per texture prefix ("red", "enemyRed", ...); nodes never move
+    std::unordered_map<std::string, ClientComponents::TankSprites> tankSprites;
+    // Name texts, one slot per named player; freed slots keep their text for reuse
+    struct NameLabel {
+        std::string name;
+        sf::Text text;
+    };
+    std::vector<NameLabel> nameLabels;
+    std::vector<uint32_t> freeNameLabels;
+    std::shared_ptr<const sf::Font> labelFont;     // Shared default font (AssetManager)
+    static constexpr float NAME_LABEL_OFFSET = 45.0f;   // Above the tank centre
+    // Predicted (ID 0) and server bullets; serverBulletHandles maps server IDs to their handles
+    SlotMap<std::unique_ptr<Bullet>> bullets;
+    std::unordered_map<uint32_t, SlotMap<std::unique_ptr<Bullet>>::Handle> serverBulletHandles;
+    static constexpr size_t BULLET_CAPACITY = 256;
+    static constexpr float BULLET_SNAP_DISTANCE = 48.0f;   // Larger corrections jump instead of gliding
+    // Expired or destroyed this frame; removed together after the collision
+    // checks, so removal costs one step per dead bullet
+    std::vector<SlotMap<std::unique_ptr<Bullet>>::Handle> deadBulletHandles;
+    std::vector<uint32_t> changedBulletIds;         // Drained from the client each frame
+    std::vector<uint32_t> removedBulletIds;
+    // Predicted bullets waiting for the server bullet that echoes their spawn
+    // token, so the two are merged instead of drawn twice. Tokens are handed
+    // out in sequence, so token % MAX_PENDING_SHOTS finds a shot's slot; a
+    // shot still waiting when its slot comes round again was rejected.
+    struct PendingShot {
+        SlotMap<std::unique_ptr<Bullet>>::Handle handle = SlotMap<std::unique_ptr<Bullet>>::INVALID_HANDLE;
+        int64_t firedAt = 0;
+        uint16_t token = 0;             // 0: slot unused
+    };
+    static constexpr size_t MAX_PENDING_SHOTS = 16;
+    static constexpr int64_t SPAWN_TOKEN_TIMEOUT_MS = 1000;
+    std::array<PendingShot, MAX_PENDING_SHOTS> pendingShots{};
+    // Removed bullets are parked here and reset on the next spawn, instead of
+    // being destroyed and reconstructed with their texture lookups
+    std::vector<std::unique_ptr<Bullet>> bulletPool;
+    std::shared_ptr<const sf::Font> scoreFont;     // Shared UI font (AssetManager)
     sf::Text* scoreText;  // SFML 3.0: Use pointer for sf::Text
+    int displayedScore = 0;                        // Score scoreText currently shows
+    std::unique_ptr<sf::Text> deadText;            // "DEAD - Respawning...", built once
     bool scoreFontLoaded = false;
+    // Frame-time breakdown, shown with F3 (needs the score font)
+    FrameProfiler frameProfiler;
+    std::unique_ptr<DebugOverlay> debugOverlay;
+    MemoryReport memoryReport;                      // Refilled when the overlay refreshes
+    // Sheds labels, bar detail, particles and minimap refreshes while frames run late
+    QualityController quality;
+    std::chrono::steady_clock::time_point frameWorkStart;  // Start of this frame's Update
+    float lastBusyMs = 0.0f;                        // Update through Render of the previous frame
+    void ApplyQualityTier();
+    // The world pass renders into worldTarget at renderScale's fraction of the
+    // window and is stretched over it; name labels, minimap and HUD stay native.
+    // At full scale the world draws straight to the window.
+    RenderScaleController renderScale;
+    std::unique_ptr<sf::RenderTexture> worldTarget;
+    std::unique_ptr<sf::Sprite> worldSprite;
+    sf::RenderTarget& BeginWorldTarget(sf::RenderWindow& window);
+    void PresentWorldTarget(sf::RenderWindow& window);
+    // F4 starts tracing, then each press writes client-trace-<n>.json (see TraceRecorder)
+    int traceDumpCount = 0;
+    void ToggleTrace();
+    // Tanks, enemies, bullets and health bars, one draw per layer
+    SpriteBatch spriteBatch;
+    // Tank bodies and barrels in one shader draw under the batch, when the
+    // shader compiled; F5 switches back to the batch for comparison
+    TankBatch tankBatch;
+    // One style for every health bar; the bars share the batch's UI layer
+    HealthBarRenderer healthBars{ 50.0f, 6.0f, -40.0f };
+    // View culling: entities whose radius plus this margin misses the view are skipped
+    static constexpr float RENDER_CULL_MARGIN = 64.0f;
+    std::vector<entt::entity> visibleLabels;        // Reused each frame
+    // Culling and the batch's quads are built on renderPrepare's thread while
+    // RenderWorld draws the ground, and sorted there too; RenderWorld waits for
+    // it before drawing the batch. Until then the job owns spriteBatch,
+    // tankBatch, visibleLabels and preparedEntities, and the entities are only read.
+    struct PreparedEntities {
+        bool localAlive = false;        // Set before the job starts
+        bool localVisible = false;
+        size_t drawn = 0;
+        size_t culled = 0;
+    };
+    PreparedEntities preparedEntities;
+    FrameWorker renderPrepare{ "Render prepare", [this] { PrepareEntities(); } };
+    void PrepareEntities();
+    // Impact, explosion and muzzle flash effects
+    ParticleSystem particles;
+    // Their sounds, heard from the local tank (the camera when spectating)
+    AudioSystem audio;
+    std::vector<EffectEvent> effectEvents;          // Drained from the client each frame
+    void EmitMuzzleFlash();
     std::string playerName;
     std::string playerColor;
     void SynchronizeBulletsFromServer();
+    void ReportMemory(MemoryReport& report) const;
+    void RenderWorld(sf::RenderWindow& window);
+    bool BakeStaticLayer();
+    bool LoadBackground();
     void CreateBulletFromServerData(const BulletData& data);
+    void ApplyServerBulletState(Bullet& bullet, const BulletData& data);
+    void RecycleBullet(std::unique_ptr<Bullet> bullet);
+    void DestroyBulletAt(size_t index);
+    std::unique_ptr<Bullet> TakePooledBullet();
+    void RemoveBullet(SlotMap<std::unique_ptr<Bullet>>::Handle handle);
+    void AddPredictedBullet(std::unique_ptr<Bullet> bullet, uint16_t spawnToken);
+    bool AdoptPredictedBullet(const BulletData& data);
     Bullet::BulletType ConvertBulletType(uint8_t typeValue);
     std::unique_ptr<BorderManager>      borderManager;
-    sf::Texture                         backgroundTexture;
-    std::unique_ptr<sf::Sprite>         background;
+    std::shared_ptr<const sf::Texture>  backgroundTexture;   // From the AssetManager
+    std::unique_ptr<sf::Sprite>         background;     // One quad over the world, tile repeated
+    std::string                         backgroundTheme = "snow";
+    bool                                spectating = false;
+    // Background and borders never change: rendered once into a texture at
+    // Initialize and drawn as one sprite (falls back to per-frame drawing)
+    std::unique_ptr<sf::RenderTexture>  staticLayer;
+    std::unique_ptr<sf::Sprite>         staticLayerSprite;
+    // Streamed ground tiles and obstacles over the static layer, rebuilt when the client
+    // loads or unloads a chunk
+    sf::VertexArray                     chunkTiles{ sf::PrimitiveType::Triangles };
+    uint32_t                            drawnChunkVersion = 0;
+    void RebuildChunkTiles();
+    // Top-right overview (M toggles); its background is rebaked with the chunk tiles
+    Minimap                             minimap;
+    void BakeMinimapBackground();
+    // Follows the local tank, clamped to the world; the HUD keeps the default view
+    sf::View                            camera;
+    bool                                cameraPlaced = false;
+    void UpdateCamera(const sf::RenderWindow& window, bool followLocalTank);
 
     std::unique_ptr<InterpolationManager> interpolationManager;
-    std::unordered_map<uint32_t, std::unique_ptr<EnemyTank>> enemies;
+    std::vector<InterpolationManager::EntityState> interpolatedStates;     // Reused every frame
 
     // Track how many GameState messages we've received to delay interpolation start
     int snapshotCountForInterpolation = 0;
-    int64_t gameStartTime = 0;
+    int64_t firstSnapshotTime = 0;     // Server timestamp of the first world state
+    uint32_t ingestedWorldStateVersion = 0;
+    // Enemies share the players' snapshot buffers under IDs with this bit set
+    static constexpr uint32_t ENEMY_INTERPOLATION_ID = 0x80000000u;
+    bool IsInterpolating() const { return interpolationManager && snapshotCountForInterpolation >= 2; }
+    void IngestWorldState();
+    bool RepeatsLatestSnapshot(uint32_t entityId, const EntitySnapshot& snapshot) const;
+    void ApplyInterpolatedStates();
 
     //    Window reference for mouse position tracking
     sf::RenderWindow* window = nullptr;
@@ -70,20 +251,50 @@ private:
     sf::Vector2f GetMouseWorldPosition() const;
 
     void UpdateOtherPlayers(int64_t serverTimestamp);
+    entt::entity FindRemote(uint32_t netId) const;
+    void DestroyRemote(entt::entity entity);
+    const ClientComponents::TankSprites& GetTankSprites(const std::string& texturePrefix, sf::Vector2f barrelOrigin);
     void CreateTankForPlayer(uint32_t playerId, const PlayerData& playerData);
-    void UpdateTankFromPlayerData(Tank& tank, const PlayerData& playerData);
-    void UpdateTankFromInterpolatedState(Tank& tank, const InterpolatedState& state);
+    void UpdateTankFromPlayerData(entt::entity entity, const PlayerData& playerData);
+    void SyncTankName(entt::entity entity, uint32_t playerId);
     void EnforceBorderCollision(Tank& tank);
+    void ClampToBorder(sf::Vector2f& position) const;
     void UpdateEnemies(const std::unordered_map<uint32_t, EnemyData>& enemyData);
     void CreateEnemyFromData(uint32_t enemyId, const EnemyData& data);
-    void UpdateEnemyFromData(EnemyTank& enemy, const EnemyData& data);
+    void UpdateEnemyFromData(entt::entity entity, const EnemyData& data);
+    void SubmitRemoteTank(const ClientComponents::Transform& transform, const ClientComponents::SpriteRef& sprite,
+        const ClientComponents::Health& health);
     EnemyTank::EnemyType ConvertEnemyType(uint8_t typeValue);
     void CheckTankCollisions();
+    // Same broadphase the server uses, over enemies (ids 1000+) and other
+    // players, kept across frames and moved to the interpolated positions
+    SpatialGrid tankGrid;
+    std::vector<const SpatialGrid::Entry*> collisionCandidates;
+    void SyncTankGrid();
     bool CheckCircleCollision(sf::Vector2f pos1, float radius1,
         sf::Vector2f pos2, float radius2);
        // sf::Vector2f obstaclePos, float tankRadius, float obstacleRadius);
     int playerScore;
 
+    // Local prediction runs in fixed steps at the server's tick rate, whatever
+    // the frame rate; the local tank is drawn between the last two steps.
+    // The rate comes from JOIN_ACCEPT (see SyncPredictionRate)
+    static constexpr int MAX_PREDICTION_STEPS = 5;        // Per frame at the default rate; the rest is dropped after a stall
+    unsigned int predictionTickRate = TickScheduler::DEFAULT_TICK_RATE;
+    float predictionStep = 1.0f / static_cast<float>(TickScheduler::DEFAULT_TICK_RATE);
+    int maxPredictionSteps = MAX_PREDICTION_STEPS;       // Scaled with the rate, so a stall drops the same time
+    static constexpr float PREDICTION_SNAP_DISTANCE = 100.0f;   // Larger step jumps (respawn) are not blended
+    float predictionAccumulator = 0.0f;
+    sf::Vector2f previousLocalPosition;
+    sf::Angle previousLocalRotation;
+    // Aim read once per frame, right before the prediction steps (late latching);
+    // kept as it was while the window is in the background
+    sf::Vector2f latchedMousePosition;
+    WindowActivity windowActivity = WindowActivity::FOREGROUND;
+    void StepLocalTank(float step);
+    void SyncPredictionRate();
+    void UpdateLocalTankRenderState();
+
     // Bullet collision methods
     void CheckBulletCollisions();
     void CheckBulletEnemyCollisions();
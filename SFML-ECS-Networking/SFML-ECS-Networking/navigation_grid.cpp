@@ -0,0 +1,160 @@
+#include "navigation_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+    // 8-way neighbour offsets; the first four are the straight ones
+    const int NEIGHBOUR_DX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    const int NEIGHBOUR_DY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+}
+
+/**
+ * Creates a grid covering the world and blocks cells whose center lies
+ * outside the tank movement bounds.
+ */
+NavigationGrid::NavigationGrid(float cellSize, float worldWidth, float worldHeight)
+    : cellSize(cellSize > 1.0f ? cellSize : DEFAULT_CELL_SIZE)
+{
+    inverseCellSize = 1.0f / this->cellSize;
+    columns = std::max(1, static_cast<int>(std::ceil(worldWidth * inverseCellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(worldHeight * inverseCellSize)));
+    walkable.assign(static_cast<size_t>(columns) * static_cast<size_t>(rows), 0);
+
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < columns; ++x) {
+            const sf::Vector2f center = CellCenter(x, y);
+            const bool inside = center.x >= WorldConstants::MOVEMENT_MIN_X && center.x <= WorldConstants::MOVEMENT_MAX_X &&
+                center.y >= WorldConstants::MOVEMENT_MIN_Y && center.y <= WorldConstants::MOVEMENT_MAX_Y;
+            walkable[Index(x, y)] = inside ? 1 : 0;
+        }
+    }
+}
+
+void NavigationGrid::SetBlocked(int x, int y, bool blocked) {
+    if (x < 0 || y < 0 || x >= columns || y >= rows) return;
+    walkable[Index(x, y)] = blocked ? 0 : 1;
+}
+
+int NavigationGrid::CellX(float x) const {
+    if (!std::isfinite(x)) return 0;
+    return std::max(0, std::min(columns - 1, static_cast<int>(x * inverseCellSize)));
+}
+
+int NavigationGrid::CellY(float y) const {
+    if (!std::isfinite(y)) return 0;
+    return std::max(0, std::min(rows - 1, static_cast<int>(y * inverseCellSize)));
+}
+
+sf::Vector2f NavigationGrid::CellCenter(int x, int y) const {
+    return sf::Vector2f((static_cast<float>(x) + 0.5f) * cellSize, (static_cast<float>(y) + 0.5f) * cellSize);
+}
+
+bool NavigationGrid::FindNearestWalkable(int x, int y, int& outX, int& outY) const {
+    const int maxRing = std::max(columns, rows);
+    for (int ring = 0; ring <= maxRing; ++ring) {
+        for (int dy = -ring; dy <= ring; ++dy) {
+            for (int dx = -ring; dx <= ring; ++dx) {
+                // Only the ring's border; the inside was searched already
+                if (std::abs(dx) != ring && std::abs(dy) != ring) continue;
+                if (IsWalkable(x + dx, y + dy)) {
+                    outX = x + dx;
+                    outY = y + dy;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+FlowField::FlowField() : grid(nullptr), targetCell(-1) {
+}
+
+/**
+ * Dijkstra from the target cell, then points every cell at its cheapest
+ * reachable neighbour. A target in a blocked cell (a player hugging a wall)
+ * is searched from the nearest walkable cell. Blocked cells bordering open ones
+ * also get a direction, so an enemy pushed into one is led back out.
+ */
+void FlowField::Build(const NavigationGrid& navigation, sf::Vector2f target) {
+    grid = &navigation;
+    const int columns = navigation.GetColumnCount();
+    const int rows = navigation.GetRowCount();
+    const size_t cellCount = static_cast<size_t>(navigation.GetCellCount());
+    costs.assign(cellCount, UNREACHABLE);
+    directions.assign(cellCount, sf::Vector2f(0.0f, 0.0f));
+
+    targetCell = navigation.CellIndex(target);
+    int seedX = navigation.CellX(target.x);
+    int seedY = navigation.CellY(target.y);
+    if (!navigation.FindNearestWalkable(seedX, seedY, seedX, seedY)) {
+        return;
+    }
+    const int seedCell = navigation.Index(seedX, seedY);
+    costs[seedCell] = 0;
+    openHeap.clear();
+    openHeap.push_back(static_cast<uint64_t>(seedCell));
+
+    while (!openHeap.empty()) {
+        std::pop_heap(openHeap.begin(), openHeap.end(), std::greater<uint64_t>());
+        const uint64_t top = openHeap.back();
+        openHeap.pop_back();
+        const uint32_t cost = static_cast<uint32_t>(top >> 32);
+        const int cell = static_cast<int>(top & 0xFFFFFFFFu);
+        if (cost != costs[cell]) continue;   // Stale entry
+
+        const int cx = cell % columns;
+        const int cy = cell / columns;
+        for (int n = 0; n < 8; ++n) {
+            const int nx = cx + NEIGHBOUR_DX[n];
+            const int ny = cy + NEIGHBOUR_DY[n];
+            if (!navigation.IsWalkable(nx, ny)) continue;
+            // Diagonals only when both straight neighbours are open
+            if (n >= 4 && (!navigation.IsWalkable(nx, cy) || !navigation.IsWalkable(cx, ny))) continue;
+
+            const uint32_t stepCost = cost + (n < 4 ? STRAIGHT_COST : DIAGONAL_COST);
+            const int neighbour = navigation.Index(nx, ny);
+            if (stepCost < costs[neighbour]) {
+                costs[neighbour] = stepCost;
+                openHeap.push_back((static_cast<uint64_t>(stepCost) << 32) | static_cast<uint32_t>(neighbour));
+                std::push_heap(openHeap.begin(), openHeap.end(), std::greater<uint64_t>());
+            }
+        }
+    }
+
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < columns; ++x) {
+            const int cell = navigation.Index(x, y);
+            if (cell == seedCell) continue;
+
+            const bool open = navigation.IsWalkable(x, y);
+            uint32_t bestCost = open ? costs[cell] : UNREACHABLE;
+            int bestX = x;
+            int bestY = y;
+            for (int n = 0; n < 8; ++n) {
+                const int nx = x + NEIGHBOUR_DX[n];
+                const int ny = y + NEIGHBOUR_DY[n];
+                if (nx < 0 || ny < 0 || nx >= columns || ny >= rows) continue;
+                if (open && n >= 4 && (!navigation.IsWalkable(nx, y) || !navigation.IsWalkable(x, ny))) continue;
+
+                const uint32_t neighbourCost = costs[navigation.Index(nx, ny)];
+                if (neighbourCost < bestCost) {
+                    bestCost = neighbourCost;
+                    bestX = nx;
+                    bestY = ny;
+                }
+            }
+
+            if (bestX != x || bestY != y) {
+                sf::Vector2f step(static_cast<float>(bestX - x), static_cast<float>(bestY - y));
+                directions[cell] = step / std::sqrt(step.x * step.x + step.y * step.y);
+            }
+        }
+    }
+}
+
+sf::Vector2f FlowField::GetDirection(sf::Vector2f position) const {
+    if (!grid) return sf::Vector2f(0.0f, 0.0f);
+    return directions[grid->CellIndex(position)];
+}
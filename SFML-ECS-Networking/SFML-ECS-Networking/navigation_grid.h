@@ -0,0 +1,74 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+#include "world_constants.h"
+
+// Coarse walkability grid over the world. Cells whose center a tank cannot
+// reach (outside the movement bounds) start blocked; future obstacles are
+// added with SetBlocked. Shared read-only by every flow field built on it.
+class NavigationGrid {
+public:
+    static constexpr float DEFAULT_CELL_SIZE = 40.0f;
+
+    explicit NavigationGrid(float cellSize = DEFAULT_CELL_SIZE,
+        float worldWidth = WorldConstants::WORLD_WIDTH,
+        float worldHeight = WorldConstants::WORLD_HEIGHT);
+
+    void SetBlocked(int x, int y, bool blocked);
+    bool IsWalkable(int x, int y) const {
+        return x >= 0 && y >= 0 && x < columns && y < rows && walkable[Index(x, y)];
+    }
+
+    // Cell containing position (clamped to the grid)
+    int CellX(float x) const;
+    int CellY(float y) const;
+    int CellIndex(sf::Vector2f position) const { return Index(CellX(position.x), CellY(position.y)); }
+    int Index(int x, int y) const { return y * columns + x; }
+    sf::Vector2f CellCenter(int x, int y) const;
+
+    // Closest walkable cell to (x, y) by ring search; false if none exists
+    bool FindNearestWalkable(int x, int y, int& outX, int& outY) const;
+
+    int GetColumnCount() const { return columns; }
+    int GetRowCount() const { return rows; }
+    int GetCellCount() const { return columns * rows; }
+    float GetCellSize() const { return cellSize; }
+
+private:
+    float cellSize;
+    float inverseCellSize;
+    int columns;
+    int rows;
+    std::vector<uint8_t> walkable;
+};
+
+// Directions toward one target cell for every cell of a NavigationGrid,
+// from a Dijkstra pass over walkable cells (8-way, no corner cutting).
+// Any number of enemies heading for the same target read it in O(1).
+class FlowField {
+public:
+    FlowField();
+
+    // Recomputes the field toward target's cell
+    void Build(const NavigationGrid& grid, sf::Vector2f target);
+
+    // Unit direction to follow from position; zero inside the target cell or
+    // where the target cannot be reached (move straight at it there)
+    sf::Vector2f GetDirection(sf::Vector2f position) const;
+
+    // Cell containing the target (the field itself leads to the nearest walkable cell)
+    int GetTargetCell() const { return targetCell; }
+    bool IsBuilt() const { return grid != nullptr; }
+
+private:
+    static constexpr uint32_t UNREACHABLE = 0xFFFFFFFFu;
+    static constexpr uint32_t STRAIGHT_COST = 10;
+    static constexpr uint32_t DIAGONAL_COST = 14;
+
+    const NavigationGrid* grid;
+    int targetCell;
+    std::vector<uint32_t> costs;
+    std::vector<sf::Vector2f> directions;
+    std::vector<uint64_t> openHeap;     // (cost << 32 | cell) min-heap, reused between builds
+};
@@ -1,14 +1,43 @@
 ﻿#include "network_client.h"
 #include "utils.h"
 #include <algorithm>
+#include <limits>
 #include "network_validation.h"
 #include "client_prediction.h"
+#include "tank_movement.h"
+#include "tick_scheduler.h"
+#include "trace_recorder.h"
 #include <cmath>
 
+namespace {
+    // Drops the entries of an ID-keyed table that listed does not hold (sorts listed)
+    template <typename Table>
+    void RemoveUnlisted(Table& table, std::vector<uint32_t>& listed) {
+        std::sort(listed.begin(), listed.end());
+        for (auto it = table.begin(); it != table.end();) {
+            if (std::binary_search(listed.begin(), listed.end(), it->first)) {
+                ++it;
+            }
+            else {
+                it = table.erase(it);
+            }
+        }
+    }
+}
+
 NetworkClient::NetworkClient()
-    : isConnected(false), localPlayerId(0), updateRate(0.0167f), updateTimer(0),
-    serverAddress(sf::IpAddress::LocalHost), outgoingSequenceNumber(0),
-    lastReceivedSequenceNumber(0), pingTimer(0), pingInterval(1.0f),
+    : bulletResyncNeeded(false),
+    serverAddress(sf::IpAddress::LocalHost), roomId(0), connectionToken(0), lastHandshakeSendMs(0),
+    isConnected(false),
+    serverAuthoritativeHealth(100.0f), serverAuthoritativeMaxHealth(100.0f),
+    serverAuthoritativeScore(0), serverAuthoritativeIsDead(false),
+    localPlayerId(0), latestSnapshotSequence(0), playerTableVersion(0),
+    updateRate(0.0167f), updateTimer(0), statsTimer(0), outgoingSequenceNumber(0),
+    lastBulletUpdateSequence(0), lastBulletSpawnSequence(0),
+    useNetworkThread(false), packetArrivalMicros(0),
+    reliableAckPendingSince(0), lastServerTimestamp(0),
+    pingTimer(0), pingInterval(1.0f),
+    bandwidthWindowStart(0), newestOwnBulletId(0), confirmedBulletCount(0), nextSpawnToken(1),
     consecutiveErrors(0), maxConsecutiveErrors(5),
     prediction(std::make_unique<ClientPrediction>()),
     lastServerAckedSequence(0),
@@ -16,17 +45,24 @@ NetworkClient::NetworkClient()
     serverAuthoritativePosition(0.0f, 0.0f),
     serverAuthoritativeBodyRotation(0.0f),
     serverAuthoritativeBarrelRotation(0.0f),
-    serverAuthoritativeHealth(100.0f),
-    serverAuthoritativeMaxHealth(100.0f),
-    serverAuthoritativeScore(0),
-    serverAuthoritativeIsDead(false),
     hasServerAuthoritativeState(false),
-    reconciliationTargetPosition(0.0f, 0.0f),
-    reconciliationTargetRotation(0.0f),
-    isReconciling(false),
+    hasUnreconciledServerState(false),
+    concealedReplayFrom(0),
+    correctionOffset(0.0f, 0.0f),
+    correctionRotationOffset(sf::Angle::Zero),
+    reconciliationChecks(0),
+    mispredictions(0),
     lastInputAckTime(0),
-    lastServerTimestamp(0),
     lastAcknowledgedInputSeq(0) {
+    effectEvents.reserve(MAX_QUEUED_EFFECT_EVENTS);
+    changedBulletIds.reserve(MAX_PENDING_BULLET_CHANGES);
+    removedBulletIds.reserve(MAX_PENDING_BULLET_CHANGES);
+}
+
+void NetworkClient::QueueEffectEvent(EffectKind kind, sf::Vector2f position, sf::Angle angle) {
+    if (effectEvents.size() < MAX_QUEUED_EFFECT_EVENTS) {
+        effectEvents.push_back(EffectEvent{ kind, position, angle });
+    }
 }
 
 NetworkClient::~NetworkClient() {
@@ -43,7 +79,8 @@ void NetworkClient::ApplyLocalInputWithPrediction(Tank& localPlayer, float delta
 
     // Create input state from current player input
     InputState input;
-    input.timestamp = GetCurrentTimestamp();
+    input.timestamp = GetServerTime();
+    input.sampleMicros = GetSteadyMicros();
     input.moveForward = localPlayer.isMoving.forward;
     input.moveBackward = localPlayer.isMoving.backward;
     input.turnLeft = localPlayer.isMoving.left;
@@ -86,37 +123,13 @@ void NetworkClient::ApplyLocalInputWithPrediction(Tank& localPlayer, float delta
 }
 
 void NetworkClient::ApplyInputToTank(Tank& tank, const InputState& input, sf::Vector2f mousePos) {
-    // Apply rotation (body only - A/D keys control body rotation)
-    if (input.turnLeft) {
-        tank.bodyRotation -= sf::degrees(ROTATION_SPEED * input.deltaTime);
-    }
-    else if (input.turnRight) {
-        tank.bodyRotation += sf::degrees(ROTATION_SPEED * input.deltaTime);
-    }
-
-    //  Normalize rotation to 0-360 degrees EXACTLY like server
-    // This ensures client prediction matches server simulation
-    float bodyRotDegrees = tank.bodyRotation.asDegrees();
-    while (bodyRotDegrees < 0.0f) {
-        bodyRotDegrees += 360.0f;
-    }
-    while (bodyRotDegrees >= 360.0f) {
-        bodyRotDegrees -= 360.0f;
-    }
-    tank.bodyRotation = sf::degrees(bodyRotDegrees);
-
-    // Calculate movement direction from BODY rotation (not barrel!)
-    // Tank moves in the direction the body is facing
-    float radians = bodyRotDegrees * 3.14159f / 180.0f;
-    sf::Vector2f direction(std::cos(radians), std::sin(radians));
-
-    // Apply position change based on W/S keys
-    if (input.moveForward) {
-        tank.position += direction * MOVEMENT_SPEED * input.deltaTime;
-    }
-    else if (input.moveBackward) {
-        tank.position -= direction * MOVEMENT_SPEED * input.deltaTime;
-    }
+    // Body rotation (A/D) and movement (W/S) through the server's own kernel,
+    // so a prediction step matches the server's tick bit for bit
+    const TankMovement::Input movement{ input.moveForward, input.moveBackward, input.turnLeft, input.turnRight };
+    const TankMovement::Transform moved = TankMovement::Step(
+        { tank.position.x, tank.position.y, tank.bodyRotation.asDegrees() }, movement, input.deltaTime);
+    tank.position = obstacles.ResolveCircle(sf::Vector2f(moved.x, moved.y), WorldConstants::TANK_RADIUS);
+    tank.bodyRotation = sf::degrees(moved.rotationDegrees);
 
     //  Calculate barrel rotation from mouse position (independent of body)
     // Barrel aims at mouse cursor, not in the direction of movement
@@ -139,153 +152,142 @@ void NetworkClient::ApplyInputToTank(Tank& tank, const InputState& input, sf::Ve
     tank.UpdateSprites();
 }
 
-void NetworkClient::ApplyServerReconciliation(Tank& localPlayer) {
-    if (!predictionEnabled || !isConnected || localPlayerId == 0) {
-        // If we're already reconciling, continue smooth interpolation
-        if (isReconciling) {
-            float lerpFactor = RECONCILIATION_RATE * 0.016f;
-
-            sf::Vector2f currentPos = localPlayer.position;
-            sf::Vector2f targetPos = reconciliationTargetPosition;
-            localPlayer.position.x = currentPos.x + (targetPos.x - currentPos.x) * lerpFactor;
-            localPlayer.position.y = currentPos.y + (targetPos.y - currentPos.y) * lerpFactor;
-
-            float currentRot = localPlayer.bodyRotation.asDegrees();
-            float targetRot = reconciliationTargetRotation;
-            float rotDiff = targetRot - currentRot;
-            if (rotDiff > 180.0f) rotDiff -= 360.0f;
-            if (rotDiff < -180.0f) rotDiff += 360.0f;
-
-            localPlayer.bodyRotation = sf::degrees(currentRot + rotDiff * lerpFactor);
-            // NOTE: Don't sync barrel with body - barrel is mouse-driven
-            // localPlayer.barrelRotation = localPlayer.bodyRotation; // OLD - REMOVED
-
-            float distToTarget = std::sqrt(
-                std::pow(targetPos.x - localPlayer.position.x, 2) +
-                std::pow(targetPos.y - localPlayer.position.y, 2)
-            );
-
-            if (distToTarget < 2.0f) {
-                isReconciling = false;
-            }
+/**
+ * Checks the prediction stored for the input the server state reflects against
+ * that state. A prediction within MISPREDICTION_TOLERANCE needs no work, so an
+ * accurate client never replays. Otherwise the tank is rebased on the server
+ * state and only the inputs after the acked one are replayed; a correction
+ * below SNAP_CORRECTION_THRESHOLD is hidden by a render offset that decays.
+ * Inputs the server concealed are re-predicted first, so the state checked
+ * here already assumes what the server played.
+ * @param localPlayer Local tank
+ * @param deltaTime Step length in seconds, for decaying the correction offset
+ */
+void NetworkClient::ApplyServerReconciliation(Tank& localPlayer, float deltaTime) {
+    // Frame-rate independent decay of the offset left by earlier corrections
+    const float decay = std::exp(-RECONCILIATION_RATE * deltaTime);
+    correctionOffset *= decay;
+    correctionRotationOffset *= decay;
 
-            localPlayer.UpdateSprites();
-        }
+    if (!predictionEnabled || !isConnected || localPlayerId == 0) {
         return;
     }
-
-    // Check if we have fresh server data
-    if (!hasServerAuthoritativeState) {
-        if (isReconciling) {
-            // Continue smooth interpolation
-            float lerpFactor = RECONCILIATION_RATE * 0.016f;
-
-            sf::Vector2f currentPos = localPlayer.position;
-            sf::Vector2f targetPos = reconciliationTargetPosition;
-            localPlayer.position.x = currentPos.x + (targetPos.x - currentPos.x) * lerpFactor;
-            localPlayer.position.y = currentPos.y + (targetPos.y - currentPos.y) * lerpFactor;
-
-            float currentRot = localPlayer.bodyRotation.asDegrees();
-            float targetRot = reconciliationTargetRotation;
-            float rotDiff = targetRot - currentRot;
-            if (rotDiff > 180.0f) rotDiff -= 360.0f;
-            if (rotDiff < -180.0f) rotDiff += 360.0f;
-
-            localPlayer.bodyRotation = sf::degrees(currentRot + rotDiff * lerpFactor);
-            // NOTE: Don't sync barrel with body - barrel is mouse-driven
-            // localPlayer.barrelRotation = localPlayer.bodyRotation; // OLD - REMOVED
-
-            float distToTarget = std::sqrt(
-                std::pow(targetPos.x - localPlayer.position.x, 2) +
-                std::pow(targetPos.y - localPlayer.position.y, 2)
-            );
-
-            if (distToTarget < 2.0f) {
-                isReconciling = false;
-            }
-
-            localPlayer.UpdateSprites();
-        }
+    if (concealedReplayFrom != 0) {
+        ReplayConcealedInputs(localPlayer);
+    }
+    if (!hasUnreconciledServerState) {
         return;
     }
+    hasUnreconciledServerState = false;
 
-    // We have new server data - analyze the error
-    sf::Vector2f serverPos = serverAuthoritativePosition;
-    float serverRot = serverAuthoritativeBodyRotation;
+    const uint32_t ackedSequence = lastServerAckedSequence;
+    const sf::Vector2f serverPos = serverAuthoritativePosition;
+    const sf::Angle serverRot = sf::degrees(serverAuthoritativeBodyRotation);
+    reconciliationChecks++;
 
-    float errorX = localPlayer.position.x - serverPos.x;
-    float errorY = localPlayer.position.y - serverPos.y;
-    float error = std::sqrt(errorX * errorX + errorY * errorY);
-
-    // Four-tier reconciliation strategy:
-    if (error < 5.0f) {
-        // TIER 1: Tiny error - Ignore
-    }
-    else if (error < SMOOTH_CORRECTION_THRESHOLD) {
-        // TIER 2: Small error - Smooth interpolation
-        reconciliationTargetPosition = serverPos;
-        reconciliationTargetRotation = serverRot;
-        isReconciling = true;
+    PredictedState predicted;
+    if (prediction->GetPredictedState(ackedSequence, predicted)) {
+        const float positionError = (predicted.position - serverPos).length();
+        const float rotationError = std::abs((predicted.bodyRotation - serverRot).wrapSigned().asDegrees());
+        if (positionError <= MISPREDICTION_TOLERANCE && rotationError <= MISPREDICTION_ROTATION_TOLERANCE) {
+            telemetry.RecordReconciliation(false);
+            return;     // Prediction confirmed
+        }
     }
-    else if (error < SNAP_CORRECTION_THRESHOLD) {
-        // TIER 3: Medium error - Partial correction + smooth
-        sf::Vector2f halfway = localPlayer.position + (serverPos - localPlayer.position) * 0.5f;
-        localPlayer.position = halfway;
+    // Mispredicted, or the acked input has left the history: rebase and replay
+    mispredictions++;
+    telemetry.RecordReconciliation(true);
 
-        reconciliationTargetPosition = serverPos;
-        reconciliationTargetRotation = serverRot;
-        isReconciling = true;
+    const sf::Vector2f predictedPos = localPlayer.position;
+    const sf::Angle predictedRot = localPlayer.bodyRotation;
+    localPlayer.position = serverPos;
+    localPlayer.bodyRotation = serverRot;
+    prediction->StorePredictedState(PredictedState(ackedSequence, GetServerTime(),
+        serverPos, serverRot, localPlayer.barrelRotation));
+    const size_t replayed = ReplayInputsAfterCorrection(localPlayer, ackedSequence, lastMousePosition);
+    SmoothCorrection(localPlayer, predictedPos, predictedRot, replayed);
 
-        localPlayer.bodyRotation = sf::degrees(serverRot);
-        // NOTE: Don't sync barrel with body - barrel is mouse-driven
-        // localPlayer.barrelRotation = localPlayer.bodyRotation; // OLD - REMOVED
-        localPlayer.UpdateSprites();
+    // NOTE: Do NOT clear hasServerAuthoritativeState here!
+    // The flag needs to remain true so that health updates can be processed
+    // in multiplayer_game.cpp after this function returns.
+    // The flag will be cleared there after health sync is complete.
+}
 
-        Utils::printMsg("Medium correction: " + std::to_string(error) + "px error", debug);
+/**
+ * The server played these inputs as repeats of earlier ones and the history
+ * now holds what it played (HandleInputAcknowledgment). Re-predicting from the
+ * input before the first one means the coming server states confirm the
+ * prediction instead of correcting it. Once the server state has passed that
+ * input the normal reconciliation covers it, so nothing is done.
+ */
+void NetworkClient::ReplayConcealedInputs(Tank& localPlayer) {
+    const uint32_t baseSequence = concealedReplayFrom - 1;
+    concealedReplayFrom = 0;
+    PredictedState base;
+    if (lastServerAckedSequence > baseSequence || !prediction->GetPredictedState(baseSequence, base)) {
+        return;
+    }
+    const sf::Vector2f predictedPos = localPlayer.position;
+    const sf::Angle predictedRot = localPlayer.bodyRotation;
+    localPlayer.position = base.position;
+    localPlayer.bodyRotation = base.bodyRotation;
+    const size_t replayed = ReplayInputsAfterCorrection(localPlayer, baseSequence, lastMousePosition);
+    SmoothCorrection(localPlayer, predictedPos, predictedRot, replayed);
+}
 
-        // Mark unacknowledged inputs for replay
-        prediction->MarkInputsForReplay(lastAcknowledgedInputSeq + 1);
+void NetworkClient::SmoothCorrection(const Tank& localPlayer, sf::Vector2f predictedPos, sf::Angle predictedRot, size_t replayed) {
+    const sf::Vector2f correction = predictedPos - localPlayer.position;
+    if (correction.length() < SNAP_CORRECTION_THRESHOLD) {
+        correctionOffset += correction;
+        correctionRotationOffset += (predictedRot - localPlayer.bodyRotation).wrapSigned();
     }
     else {
-        // TIER 4: Large error - Snap immediately
-        Utils::printMsg("SNAP correction: Error: " + std::to_string(error) + "px", warning);
-
-        localPlayer.position = serverPos;
-        localPlayer.bodyRotation = sf::degrees(serverRot);
-        // NOTE: Don't sync barrel with body - barrel is mouse-driven
-        // localPlayer.barrelRotation = localPlayer.bodyRotation; // OLD - REMOVED
-        localPlayer.UpdateSprites();
-
-        isReconciling = false;
-
-        // Get current mouse position for replay
-        // We need to get mouse position from MultiplayerGame
-        // Since we don't have direct access, use a fallback approach:
-        // Use the current barrel rotation as reference (already set by prediction)
-        sf::Vector2f mousePos = localPlayer.position; // Fallback
-
-        // Calculate approximate mouse position from current barrel rotation
-        float barrelDeg = localPlayer.barrelRotation.asDegrees();
-        float barrelRad = barrelDeg * 3.14159f / 180.0f;
-        float mouseDistance = 100.0f; // Approximate distance
-        mousePos.x = localPlayer.position.x + std::cos(barrelRad) * mouseDistance;
-        mousePos.y = localPlayer.position.y + std::sin(barrelRad) * mouseDistance;
-
-        // Replay all unacknowledged inputs after snap
-        ReplayInputsAfterCorrection(localPlayer, lastAcknowledgedInputSeq + 1, mousePos);
+        Utils::printMsg("SNAP correction: Error: " + std::to_string(correction.length()) + "px, replayed " +
+            std::to_string(replayed) + " inputs", warning);
+        correctionOffset = sf::Vector2f();
+        correctionRotationOffset = sf::Angle::Zero;
     }
+    if (correctionOffset.length() >= SNAP_CORRECTION_THRESHOLD) {
+        correctionOffset = sf::Vector2f();      // Stacked corrections; stop hiding them
+        correctionRotationOffset = sf::Angle::Zero;
+    }
+}
 
-    // NOTE: Do NOT clear hasServerAuthoritativeState here!
-    // The flag needs to remain true so that health updates can be processed
-    // in multiplayer_game.cpp after this function returns.
-    // The flag will be cleared there after health sync is complete.
+float NetworkClient::GetMispredictionRate() const {
+    return reconciliationChecks > 0 ?
+        static_cast<float>(mispredictions) / static_cast<float>(reconciliationChecks) : 0.0f;
+}
+
+/**
+ * The replicated entity tables count as one subsystem; the player table is
+ * included since it is keyed like them. Sequence tracking is the receive
+ * window, the reliable receiver and the RTT bookkeeping.
+ */
+void NetworkClient::ReportMemory(MemoryReport& report) const {
+    report.Add("replicated state", otherPlayers.size() + enemyData.size() + bulletData.GetSize(),
+        MemoryReport::MapBytes(otherPlayers) + MemoryReport::MapBytes(enemyData) +
+        bulletData.GetApproximateBytes() + MemoryReport::MapBytes(playerTable) +
+        MemoryReport::VectorBytes(listedPlayerIds, listedEnemyIds, changedBulletIds, removedBulletIds, bulletIdScratch));
+    report.Add("snapshot history", SnapshotHistory::HISTORY_SIZE, receivedSnapshots.GetApproximateBytes());
+    report.Add("loaded chunks", loadedChunks.size(),
+        MemoryReport::MapBytes(loadedChunks) + loadedChunks.size() * WorldChunks::TILE_COUNT);
+    report.Add("obstacles", obstacles.GetObstacles().size(), obstacles.GetApproximateBytes());
+    if (groupReceiver.IsJoined()) {
+        report.Add("LAN multicast history", SnapshotHistory::HISTORY_SIZE, groupSnapshots.GetApproximateBytes());
+    }
+    report.Add("sequence tracking", rttHistory.size(),
+        sizeof(receivedSequences) + sizeof(reliableReceiver) + (rttHistory.size() * sizeof(float)));
+    if (prediction) {
+        report.Add("prediction history", prediction->GetHistorySize(), sizeof(ClientPrediction));
+    }
+    report.Add("packet pool", sendPackets.GetCreatedCount(), sendPackets.GetApproximateBytes());
 }
 
 void NetworkClient::SendInputWithSequence(uint32_t sequenceNumber, const InputState& input, float barrelRotation) {
     if (!isConnected) return;
 
     try {
-        sf::Packet packet;
+        PacketPool::Lease packet = sendPackets.Borrow();
 
         PlayerInputMessage inputMsg;
         inputMsg.type = NetMessageType::PLAYER_INPUT;
@@ -297,32 +299,41 @@ void NetworkClient::SendInputWithSequence(uint32_t sequenceNumber, const InputSt
         inputMsg.timestamp = input.timestamp;
         inputMsg.sequenceNumber = sequenceNumber;
         inputMsg.barrelRotation = barrelRotation;  // Include barrel rotation
+        inputMsg.lastReceivedSnapshot = latestSnapshotSequence;  // Snapshot ack for delta baselines
+        inputMsg.playerTableVersion = playerTableVersion;        // Player table ack
+        FillReliableAck(inputMsg);                               // Reliable event ack
+        inputMsg.sendMicros = GetSteadyMicros();                 // Echoed in the ack as an RTT sample
+        inputMsg.predictedStep = true;                           // One per step: the server may conceal a gap
+        inputLatency.OnInputSent(sequenceNumber, input.sampleMicros);
+
+        // Repeat the newest inputs the server hasn't acked, so one lost datagram costs no latency
+        for (uint32_t olderSequence = sequenceNumber - 1; olderSequence > lastAcknowledgedInputSeq &&
+            inputMsg.previousInputs.size() < NetworkValidation::MAX_REDUNDANT_INPUTS; --olderSequence) {
+            const InputState* older = prediction->FindInput(olderSequence);
+            if (!older) {
+                break;      // Older inputs have left the history too
+            }
+            RedundantInput redundant;
+            redundant.sequenceNumber = older->sequenceNumber;
+            redundant.isMoving_forward = older->moveForward;
+            redundant.isMoving_backward = older->moveBackward;
+            redundant.isMoving_left = older->turnLeft;
+            redundant.isMoving_right = older->turnRight;
+            inputMsg.previousInputs.push_back(redundant);
+        }
 
         // Debug log (optional - comment out after testing)
         // Utils::printMsg("Sending barrel: " + std::to_string(barrelRotation) + "°", debug);
 
-        // Serialize message - CRITICAL: barrel must be included
-        packet << static_cast<uint8_t>(inputMsg.type) << inputMsg.playerId
-            << inputMsg.isMoving_forward << inputMsg.isMoving_backward
-            << inputMsg.isMoving_left << inputMsg.isMoving_right
-            << inputMsg.timestamp << inputMsg.sequenceNumber
-            << inputMsg.barrelRotation;  // Serialize barrel rotation
-
-        // Track sent packet for RTT calculation
-        SentPacket sentPacket;
-        sentPacket.sequenceNumber = sequenceNumber;
-        sentPacket.sentTime = input.timestamp;
-        sentPackets.push_back(sentPacket);
-
-        // Limit history size
-        if (sentPackets.size() > MAX_SENT_PACKETS_HISTORY) {
-            sentPackets.pop_front();
-        }
+        messageWriter.Reset();
+        NetworkUtils::Write(messageWriter, inputMsg);
+        *packet << static_cast<uint8_t>(inputMsg.type);
+        messageWriter.AppendTo(*packet);
 
         networkStats.totalPacketsSent++;
 
         // Send packet with error handling
-        sf::Socket::Status sendStatus = socket.send(packet, serverAddress, serverPort);
+        sf::Socket::Status sendStatus = SendToServer(*packet);
 
         if (sendStatus == sf::Socket::Status::Done) {
             consecutiveErrors = 0;
@@ -344,72 +355,154 @@ void NetworkClient::SendInputWithSequence(uint32_t sequenceNumber, const InputSt
     }
 }
 
-bool NetworkClient::Connect(const std::string& serverIP, unsigned short serverPort,
-    const std::string& playerName, const std::string& preferredColor) {
-
-    Utils::printMsg("Attempting to connect to server " + serverIP + ":" + std::to_string(serverPort));
+/**
+ * Binds the socket and starts the network thread or conditioner the settings ask for.
+ * @return False if the server address does not resolve or the socket cannot bind
+ */
+bool NetworkClient::OpenSocket(const std::string& serverIP, unsigned short serverPort) {
+    // Parse server IP - use resolve for string to IpAddress conversion
+    auto resolvedIP = sf::IpAddress::resolve(serverIP);
+    if (!resolvedIP) {
+        Utils::printMsg("Failed to resolve server IP: " + serverIP, error);
+        CleanupSocketResources();
+        return false;
+    }
+    serverAddress = resolvedIP.value();
 
-    try {
-        // Parse server IP - use resolve for string to IpAddress conversion
-        auto resolvedIP = sf::IpAddress::resolve(serverIP);
-        if (!resolvedIP) {
-            Utils::printMsg("Failed to resolve server IP: " + serverIP, error);
-            CleanupSocketResources();
-            return false;
-        }
-        serverAddress = resolvedIP.value();
+    this->serverPort = serverPort;
 
-        this->serverPort = serverPort;
+    // Bind client socket to any available port with error handling
+    sf::Socket::Status bindStatus = socket.bind(sf::Socket::AnyPort);
+    if (bindStatus != sf::Socket::Status::Done) {
+        Utils::printMsg("Failed to bind client socket - Status: " +
+            SocketStatusToString(bindStatus), error);
+        CleanupSocketResources();
+        return false;
+    }
 
-        // Bind client socket to any available port with error handling
-        sf::Socket::Status bindStatus = socket.bind(sf::Socket::AnyPort);
-        if (bindStatus != sf::Socket::Status::Done) {
-            Utils::printMsg("Failed to bind client socket - Status: " +
-                SocketStatusToString(bindStatus), error);
-            CleanupSocketResources();
-            return false;
+    // Set socket to non-blocking mode
+    socket.setBlocking(false);
+    conditioner.reset();
+    if (networkConditions.IsActive()) {
+        conditioner = std::make_unique<NetworkConditioner>(networkConditions);
+        Utils::printMsg("Simulating network conditions: " + networkConditions.Describe(), warning);
+        if (useNetworkThread) {
+            Utils::printMsg("Network conditions need game-thread socket I/O; ignoring network thread setting", warning);
         }
+    }
+    else if (useNetworkThread) {
+        networkThread = std::make_unique<NetworkIOThread>(socket, &NetworkIOThread::IsNonEmptyMessage);
+        if (!networkThread->Start()) {
+            Utils::printMsg("Falling back to game-thread socket I/O", warning);
+            networkThread.reset();
+        }
+    }
 
-        // Set socket to non-blocking mode
-        socket.setBlocking(false);
-
-        Utils::printMsg("Client socket bound to port " + std::to_string(socket.getLocalPort()));
-
-        // Reset network statistics
-        networkStats.Reset();
-        outgoingSequenceNumber = 0;
-        lastReceivedSequenceNumber = 0;
-        sentPackets.clear();
-        rttHistory.clear();
-        receivedSequenceNumbers.clear();
-        consecutiveErrors = 0;
+    Utils::printMsg("Client socket bound to port " + std::to_string(socket.getLocalPort()));
+    return true;
+}
 
-        // Send join request to server with retry logic
-        const int MAX_JOIN_ATTEMPTS = 3;
-        bool joinSuccess = false;
+/**
+ * Opens an endpoint on the loopback network. Datagrams are exchanged on this
+ * thread through its channel, so there is no socket, conditioner or network thread.
+ */
+bool NetworkClient::OpenLoopbackEndpoint() {
+    CleanupSocketResources();
+    conditioner.reset();
+    loopbackChannel = loopback->OpenEndpoint(loopbackPort);
+    if (!loopbackChannel) {
+        return false;
+    }
+    serverAddress = sf::IpAddress::LocalHost;
+    serverPort = LoopbackNetwork::SERVER_PORT;
+    if (networkConditions.IsActive() || useNetworkThread) {
+        Utils::printMsg("Loopback connection ignores network conditions and the network thread", warning);
+    }
+    Utils::printMsg("Client joined the in-process loopback network as port " + std::to_string(loopbackPort));
+    return true;
+}
 
-        for (int attempt = 1; attempt <= MAX_JOIN_ATTEMPTS && !joinSuccess; ++attempt) {
-            if (attempt > 1) {
-                Utils::printMsg("Join request attempt " + std::to_string(attempt) +
-                    " of " + std::to_string(MAX_JOIN_ATTEMPTS), warning);
-            }
+/**
+ * Claims a slot in the shared memory region of the server on serverPort.
+ * Datagrams are exchanged on this thread through the slot's rings, so there
+ * is no socket, conditioner or network thread.
+ */
+bool NetworkClient::OpenSharedMemoryEndpoint(unsigned short serverPort) {
+    CleanupSocketResources();
+    conditioner.reset();
+    if (!sharedMemory.Open(SharedMemoryTransport::NameForPort(serverPort))) {
+        return false;
+    }
+    serverAddress = sf::IpAddress::LocalHost;
+    this->serverPort = SharedMemoryTransport::SERVER_PORT;
+    if (networkConditions.IsActive() || useNetworkThread) {
+        Utils::printMsg("Shared memory connection ignores network conditions and the network thread", warning);
+    }
+    Utils::printMsg("Client mapped shared memory for port " + std::to_string(serverPort) +
+        " as port " + std::to_string(sharedMemory.GetPort()));
+    return true;
+}
 
-            joinSuccess = SendJoinRequest(playerName, preferredColor);
+bool NetworkClient::Connect(const std::string& serverIP, unsigned short serverPort,
+    const std::string& playerName, const std::string& preferredColor, uint16_t roomId) {
 
-            if (!joinSuccess && attempt < MAX_JOIN_ATTEMPTS) {
-                sf::sleep(sf::milliseconds(500)); // Wait before retry
-            }
-        }
+    Utils::printMsg("Attempting to connect to " +
+        (loopback ? std::string("the in-process server") : "server " + serverIP + ":" + std::to_string(serverPort)) +
+        (roomId != 0 ? " (room " + std::to_string(roomId) + ")" : "") + (spectating ? " as a spectator" : ""));
 
-        if (!joinSuccess) {
-            Utils::printMsg("Failed to send join request after " +
-                std::to_string(MAX_JOIN_ATTEMPTS) + " attempts", error);
-            CleanupSocketResources();
+    try {
+        this->roomId = roomId;
+        const bool opened = loopback ? OpenLoopbackEndpoint()
+            : useSharedMemory ? OpenSharedMemoryEndpoint(serverPort) : OpenSocket(serverIP, serverPort);
+        if (!opened) {
             return false;
         }
 
+        // Reset network statistics
+        networkStats.Reset();
+        outgoingSequenceNumber = 0;
+        lastTimingSampleMicros = 0;
+        timingWindowStartMicros = 0;
+        hasTimingCandidate = false;
+        concealedReplayFrom = 0;
+        rttHistory.clear();
+        clockSync.Reset();
+        inputLatency.Reset();
+        lastWorldStateArrivalMicros = 0;
+        receivedSequences.Clear();
+        consecutiveErrors = 0;
+        receivedSnapshots.Clear();
+        latestSnapshotSequence = 0;
+        lastStateResyncMs = 0;
+        lastBulletUpdateSequence = 0;
+        lastBulletSpawnSequence = 0;
+        playerTable.clear();
+        playerTableVersion = 0;
+        fragmentReassembler.Clear();
+        LeaveMulticastGroup();
+        loadedChunks.clear();
+        chunkVersion++;
+        RebuildObstacles();
+        reliableReceiver.Reset();
+        reliableAckPendingSince = 0;
+        bandwidth.Reset();
+        bandwidthWindowStart = GetCurrentTimestamp();
+        newestOwnBulletId = 0;
+        confirmedBulletCount = 0;
+        hasSentInput = false;
+        recentInputCount = 0;
+        connectionToken = 0;
+        joinPlayerName = playerName;
+        joinPreferredColor = preferredColor;
+        connectPort = serverPort;
+        resumeStartMs = 0;
+        reconnectRequested = false;
+
+        // Open the handshake; retries and the join that follows the server's
+        // challenge happen in Update, so the caller never waits on the network
         isConnected = true;
-        Utils::printMsg("Connected to server successfully", success);
+        StartHandshake();
+        Utils::printMsg("Connection request sent, joining in the background");
 
         return true;
     }
@@ -430,16 +523,34 @@ void NetworkClient::Disconnect() {
         if (isConnected) {
             Utils::printMsg("Disconnecting from server...", warning);
 
+            if (conditioner) {
+                conditioner->Flush(socket, true);
+            }
             // Clean up socket resources
             CleanupSocketResources();
+            LeaveMulticastGroup();
+
+            if (inputLatency.Get(InputLatencyTracker::Stage::INPUT_TO_RECEIVE).GetCount() > 0) {
+                std::string latency = inputLatency.Format();
+                latency.pop_back();
+                Utils::printMsg("Input latency p50 / p95 / p99 this session:\n" + latency);
+            }
 
             isConnected = false;
             localPlayerId = 0;
+            connectionToken = 0;
+            telemetry.Reset();
             otherPlayers.clear();
-            sentPackets.clear();
             rttHistory.clear();
-            receivedSequenceNumbers.clear();
-            bulletData.clear();
+            clockSync.Reset();
+            receivedSequences.Clear();
+            bulletData.Clear();
+            changedBulletIds.clear();
+            removedBulletIds.clear();
+            bulletResyncNeeded = true;
+            loadedChunks.clear();
+            chunkVersion++;
+            RebuildObstacles();
 
             consecutiveErrors = 0;
 
@@ -463,6 +574,24 @@ void NetworkClient::Update(float deltaTime) {
     try {
         // Process incoming messages from server
         ProcessIncomingMessages();
+        ProcessGroupMessages();
+        if (reconnectRequested) {
+            Reconnect();
+            return;
+        }
+        if (spectating) {
+            UpdateSpectating();
+        }
+        else if (localPlayerId == 0) {
+            RetryHandshake();           // Lost request, challenge or join: start over with a fresh token
+        }
+        else {
+            UpdateSession();
+        }
+        clockSync.Update(GetSteadyMicros());
+        UnloadFarChunks();
+        RebuildObstacles();
+        UpdateBullets(deltaTime);
 
         // Update timers
         updateTimer += deltaTime;
@@ -471,12 +600,39 @@ void NetworkClient::Update(float deltaTime) {
         // NEW: Process input buffer (update timers, cleanup timeouts)
         ProcessInputBuffer(deltaTime);
 
-        // Send periodic ping for RTT measurement
-        if (pingTimer >= pingInterval) {
-            SendPing();
+        // Ping only when acks have stopped carrying timing (idle, dead, or an
+        // older server); spectators only talk to subscribe
+        if (pingTimer >= pingInterval && !spectating) {
+            if (GetSteadyMicros() - lastTimingSampleMicros >= static_cast<int64_t>(pingInterval * 1000000.0f)) {
+                SendPing();
+            }
             pingTimer = 0;
         }
 
+        if (reliableAckPendingSince != 0 &&
+            GetCurrentTimestamp() - reliableAckPendingSince >= RELIABLE_ACK_DELAY_MS) {
+            SendReliableAck();
+        }
+
+        if (groupReceiver.IsJoined() && localPlayerId != 0 &&
+            GetCurrentTimestamp() - lastMulticastStatusMs >= LanMulticast::STATUS_INTERVAL_MS) {
+            MulticastStatusMessage statusMsg;
+            statusMsg.playerId = localPlayerId;
+            statusMsg.lastGroupFrame = latestGroupFrame;
+            PacketPool::Lease packet = sendPackets.Borrow();
+            *packet << statusMsg;
+            SendToServer(*packet);
+            lastMulticastStatusMs = GetCurrentTimestamp();
+        }
+
+        if (localPlayerId != 0 && !spectating &&
+            telemetry.Update(GetCurrentTimestamp(), networkStats.packetLoss, telemetryWindow)) {
+            telemetryWindow.playerId = localPlayerId;
+            PacketPool::Lease packet = sendPackets.Borrow();
+            *packet << telemetryWindow;
+            SendToServer(*packet);
+        }
+
         // Check for connection health
         if (consecutiveErrors >= maxConsecutiveErrors) {
             Utils::printMsg("Too many consecutive errors (" +
@@ -500,7 +656,7 @@ void NetworkClient::SendPlayerUpdate(const Tank& localPlayer) {
     if (updateTimer < updateRate) return;
 
     try {
-        sf::Packet packet;
+        PacketPool::Lease packet = sendPackets.Borrow();
 
         // Create update message with timestamp and sequence number
         PlayerUpdateMessage updateMsg;
@@ -517,32 +673,15 @@ void NetworkClient::SendPlayerUpdate(const Tank& localPlayer) {
         updateMsg.isMoving_backward = localPlayer.isMoving.backward;
         updateMsg.isMoving_left = localPlayer.isMoving.left;
         updateMsg.isMoving_right = localPlayer.isMoving.right;
-        updateMsg.timestamp = GetCurrentTimestamp();
+        updateMsg.timestamp = GetServerTime();
         updateMsg.sequenceNumber = outgoingSequenceNumber++;
 
-        // Manual serialization to maintain compatibility
-        packet << static_cast<uint8_t>(updateMsg.type) << updateMsg.playerId
-            << updateMsg.x << updateMsg.y
-            << updateMsg.bodyRotation << updateMsg.barrelRotation
-            << updateMsg.isMoving_forward << updateMsg.isMoving_backward
-            << updateMsg.isMoving_left << updateMsg.isMoving_right
-            << updateMsg.timestamp << updateMsg.sequenceNumber;
-
-        // Track sent packet for potential RTT calculation
-        SentPacket sentPacket;
-        sentPacket.sequenceNumber = updateMsg.sequenceNumber;
-        sentPacket.sentTime = updateMsg.timestamp;
-        sentPackets.push_back(sentPacket);
-
-        // Limit history size
-        if (sentPackets.size() > MAX_SENT_PACKETS_HISTORY) {
-            sentPackets.pop_front();
-        }
+        *packet << updateMsg;
 
         networkStats.totalPacketsSent++;
 
         // Send with error handling
-        sf::Socket::Status sendStatus = socket.send(packet, serverAddress, serverPort);
+        sf::Socket::Status sendStatus = SendToServer(*packet);
 
         if (sendStatus == sf::Socket::Status::Done) {
             consecutiveErrors = 0; // Reset error counter on success
@@ -574,45 +713,95 @@ void NetworkClient::SendPlayerUpdate(const Tank& localPlayer) {
 }
 
 void NetworkClient::SendPlayerInput(const Tank& localPlayer) {
+    InputState input;
+    input.sampleMicros = GetSteadyMicros();
+    input.moveForward = localPlayer.isMoving.forward;
+    input.moveBackward = localPlayer.isMoving.backward;
+    input.turnLeft = localPlayer.isMoving.left;
+    input.turnRight = localPlayer.isMoving.right;
+    SendPlayerInput(input, localPlayer.barrelRotation.asDegrees());
+}
+
+/**
+ * Whether the unpredicted input goes out this frame: on the fixed rate, or
+ * (ON_CHANGE) at once for a key change, at most at the fixed rate for a barrel
+ * move past the threshold, and otherwise as the keep-alive.
+ */
+bool NetworkClient::IsInputSendDue(const InputState& input, float barrelRotation) const {
+    if (inputSendMode == InputSendMode::FIXED_RATE) {
+        return updateTimer >= updateRate;
+    }
+    if (!hasSentInput || updateTimer >= INPUT_KEEPALIVE_SECONDS) {
+        return true;
+    }
+    if (input.moveForward != lastSentInput.isMoving_forward || input.moveBackward != lastSentInput.isMoving_backward ||
+        input.turnLeft != lastSentInput.isMoving_left || input.turnRight != lastSentInput.isMoving_right) {
+        return true;
+    }
+    const float barrelChange = std::abs(sf::degrees(barrelRotation - lastSentBarrel).wrapSigned().asDegrees());
+    return barrelChange >= INPUT_BARREL_THRESHOLD_DEGREES && updateTimer >= updateRate;
+}
+
+/**
+ * Sends the movement keys and barrel angle without local prediction, paced by
+ * the input send mode (used by headless bots and unpredicted clients).
+ */
+void NetworkClient::SendPlayerInput(const InputState& input, float barrelRotation) {
     if (!isConnected || localPlayerId == 0) return;
 
-    // Only send at the specified rate
-    if (updateTimer < updateRate) return;
+    if (!IsInputSendDue(input, barrelRotation)) return;
 
     try {
-        sf::Packet packet;
+        PacketPool::Lease packet = sendPackets.Borrow();
 
         // Create lightweight input message
         PlayerInputMessage inputMsg;
         inputMsg.type = NetMessageType::PLAYER_INPUT;
         inputMsg.playerId = localPlayerId;
-        inputMsg.isMoving_forward = localPlayer.isMoving.forward;
-        inputMsg.isMoving_backward = localPlayer.isMoving.backward;
-        inputMsg.isMoving_left = localPlayer.isMoving.left;
-        inputMsg.isMoving_right = localPlayer.isMoving.right;
-        inputMsg.timestamp = GetCurrentTimestamp();
+        inputMsg.isMoving_forward = input.moveForward;
+        inputMsg.isMoving_backward = input.moveBackward;
+        inputMsg.isMoving_left = input.turnLeft;
+        inputMsg.isMoving_right = input.turnRight;
+        inputMsg.barrelRotation = barrelRotation;
+        inputMsg.timestamp = GetServerTime();
         inputMsg.sequenceNumber = outgoingSequenceNumber++;
+        inputMsg.lastReceivedSnapshot = latestSnapshotSequence;
+        inputMsg.playerTableVersion = playerTableVersion;
+        FillReliableAck(inputMsg);
+        inputMsg.sendMicros = GetSteadyMicros();
+        if (inputSendMode == InputSendMode::ON_CHANGE) {
+            // Newest first, as in SendInputWithSequence; acked ones are not repeated
+            for (size_t i = recentInputCount; i-- > 0 && recentInputs[i].sequenceNumber > lastAcknowledgedInputSeq;) {
+                inputMsg.previousInputs.push_back(recentInputs[i]);
+            }
+            if (recentInputCount == recentInputs.size()) {
+                std::move(recentInputs.begin() + 1, recentInputs.end(), recentInputs.begin());
+                recentInputCount--;
+            }
+            RedundantInput& sent = recentInputs[recentInputCount++];
+            sent.sequenceNumber = inputMsg.sequenceNumber;
+            sent.isMoving_forward = input.moveForward;
+            sent.isMoving_backward = input.moveBackward;
+            sent.isMoving_left = input.turnLeft;
+            sent.isMoving_right = input.turnRight;
+            lastSentInput = sent;
+            lastSentBarrel = barrelRotation;
+            hasSentInput = true;
+        }
+        // Bots keep one InputState for a whole session, so it is sampled as it leaves
+        inputLatency.OnInputSent(inputMsg.sequenceNumber,
+            input.sampleMicros != 0 ? input.sampleMicros : GetSteadyMicros());
 
         // Serialize input message
-        packet << static_cast<uint8_t>(inputMsg.type) << inputMsg.playerId
-            << inputMsg.isMoving_forward << inputMsg.isMoving_backward
-            << inputMsg.isMoving_left << inputMsg.isMoving_right
-            << inputMsg.timestamp << inputMsg.sequenceNumber;
-
-        // Track sent packet for RTT calculation
-        SentPacket sentPacket;
-        sentPacket.sequenceNumber = inputMsg.sequenceNumber;
-        sentPacket.sentTime = inputMsg.timestamp;
-        sentPackets.push_back(sentPacket);
-
-        if (sentPackets.size() > MAX_SENT_PACKETS_HISTORY) {
-            sentPackets.pop_front();
-        }
+        messageWriter.Reset();
+        NetworkUtils::Write(messageWriter, inputMsg);
+        *packet << static_cast<uint8_t>(inputMsg.type);
+        messageWriter.AppendTo(*packet);
 
         networkStats.totalPacketsSent++;
 
         // Send with error handling
-        sf::Socket::Status sendStatus = socket.send(packet, serverAddress, serverPort);
+        sf::Socket::Status sendStatus = SendToServer(*packet);
 
         if (sendStatus == sf::Socket::Status::Done) {
             consecutiveErrors = 0;
@@ -647,27 +836,17 @@ void NetworkClient::SendPing() {
     if (!isConnected) return;
 
     try {
-        sf::Packet packet;
+        PacketPool::Lease packet = sendPackets.Borrow();
         PingMessage pingMsg;
-        pingMsg.timestamp = GetCurrentTimestamp();
+        pingMsg.timestamp = GetSteadyMicros();
         pingMsg.sequenceNumber = outgoingSequenceNumber++;
 
-        packet << static_cast<uint8_t>(pingMsg.type) << pingMsg.timestamp << pingMsg.sequenceNumber;
-
-        // Track ping for RTT calculation
-        SentPacket sentPacket;
-        sentPacket.sequenceNumber = pingMsg.sequenceNumber;
-        sentPacket.sentTime = pingMsg.timestamp;
-        sentPackets.push_back(sentPacket);
-
-        if (sentPackets.size() > MAX_SENT_PACKETS_HISTORY) {
-            sentPackets.pop_front();
-        }
+        *packet << pingMsg;
 
         networkStats.totalPacketsSent++;
 
         // Send with error handling
-        sf::Socket::Status sendStatus = socket.send(packet, serverAddress, serverPort);
+        sf::Socket::Status sendStatus = SendToServer(*packet);
 
         if (sendStatus == sf::Socket::Status::Done) {
             consecutiveErrors = 0;
@@ -691,9 +870,54 @@ void NetworkClient::SendPing() {
     }
 }
 
+/**
+ * Acks the reliable channel on its own, for when no PLAYER_INPUT has carried
+ * the ack recently.
+ */
+void NetworkClient::SendReliableAck() {
+    if (!isConnected || localPlayerId == 0 || !reliableReceiver.HasReceived()) return;
+
+    try {
+        ReliableAckMessage ackMsg;
+        ackMsg.playerId = localPlayerId;
+        ackMsg.ackSequence = reliableReceiver.GetAckSequence();
+        ackMsg.ackBits = reliableReceiver.GetAckBits();
+
+        PacketPool::Lease packet = sendPackets.Borrow();
+        *packet << ackMsg;
+
+        sf::Socket::Status sendStatus = SendToServer(*packet);
+        if (sendStatus == sf::Socket::Status::Done) {
+            reliableAckPendingSince = 0;
+        }
+        else if (sendStatus != sf::Socket::Status::NotReady) {
+            Utils::printMsg("Failed to send reliable ack - Status: " +
+                SocketStatusToString(sendStatus), warning);
+            consecutiveErrors++;
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SendReliableAck: " + std::string(e.what()), error);
+    }
+}
+
+void NetworkClient::FillReliableAck(PlayerInputMessage& msg) {
+    msg.hasReliableAck = reliableReceiver.HasReceived();
+    msg.reliableAckSequence = reliableReceiver.GetAckSequence();
+    msg.reliableAckBits = reliableReceiver.GetAckBits();
+    reliableAckPendingSince = 0;
+}
+
 void NetworkClient::ProcessIncomingMessages() {
+    if (GetChannel()) {
+        ProcessQueuedMessages();
+        return;
+    }
+    if (sharedMemory.IsOpen()) {
+        ProcessSharedMemoryMessages();
+        return;
+    }
     try {
-        sf::Packet packet;
         std::optional<sf::IpAddress> senderIP;
         unsigned short senderPort;
 
@@ -701,12 +925,18 @@ void NetworkClient::ProcessIncomingMessages() {
         int messagesProcessed = 0;
         const int MAX_MESSAGES_PER_FRAME = 100; // Prevent infinite loop
 
+        if (conditioner) {
+            conditioner->Flush(socket);
+        }
         while (messagesProcessed < MAX_MESSAGES_PER_FRAME) {
-            sf::Socket::Status receiveStatus = socket.receive(packet, senderIP, senderPort);
+            sf::Socket::Status receiveStatus = conditioner ?
+                conditioner->Receive(socket, receiveBuffer, senderIP, senderPort) :
+                socket.receive(receiveBuffer, senderIP, senderPort);
 
             if (receiveStatus == sf::Socket::Status::Done) {
                 // Successfully received a packet
                 networkStats.totalPacketsReceived++;
+                bandwidth.RecordDatagramReceived(receiveBuffer.getDataSize());
                 consecutiveErrors = 0; // Reset on successful receive
 
                 // Validate sender
@@ -717,7 +947,12 @@ void NetworkClient::ProcessIncomingMessages() {
                 }
 
                 // Process the packet
-                ProcessPacket(packet, senderIP.value(), senderPort);
+                packetArrivalMicros = GetSteadyMicros();
+                if (capture) {
+                    capture->Record(PacketCapture::Direction::RECEIVED, packetArrivalMicros,
+                        senderIP.value(), senderPort, receiveBuffer);
+                }
+                ProcessPacket(receiveBuffer, senderIP.value(), senderPort);
                 messagesProcessed++;
             }
             else if (receiveStatus == sf::Socket::Status::NotReady) {
@@ -768,7 +1003,70 @@ void NetworkClient::ProcessIncomingMessages() {
     }
 }
 
+/**
+ * Drains datagrams the network thread has received, each carrying the time it
+ * came off the socket, or those the loopback network delivers on this pump.
+ * The inbound ring is bounded, so no per-frame cap.
+ */
+void NetworkClient::ProcessQueuedMessages() {
+    try {
+        if (loopbackChannel) {
+            loopback->Pump();
+        }
+        DatagramChannel& channel = *GetChannel();
+        // Popping swaps the previous datagram's buffer back into the ring for reuse
+        while (channel.PopInbound(queuedDatagram)) {
+            networkStats.totalPacketsReceived++;
+            bandwidth.RecordDatagramReceived(queuedDatagram.packet.getDataSize());
+            consecutiveErrors = 0;
+            packetArrivalMicros = queuedDatagram.arrivalMicros;
+            if (capture) {
+                capture->Record(PacketCapture::Direction::RECEIVED, packetArrivalMicros,
+                    queuedDatagram.address, queuedDatagram.port, queuedDatagram.packet);
+            }
+            ProcessPacket(queuedDatagram.packet, queuedDatagram.address, queuedDatagram.port);
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in ProcessQueuedMessages: " + std::string(e.what()), error);
+        consecutiveErrors++;
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in ProcessQueuedMessages", error);
+        consecutiveErrors++;
+    }
+}
+
+/**
+ * Drains this client's shared memory ring. Datagrams are stamped as they are
+ * read, which is at most a frame after the server wrote them.
+ */
+void NetworkClient::ProcessSharedMemoryMessages() {
+    try {
+        while (sharedMemory.Receive(receiveBuffer)) {
+            networkStats.totalPacketsReceived++;
+            bandwidth.RecordDatagramReceived(receiveBuffer.getDataSize());
+            consecutiveErrors = 0;
+            packetArrivalMicros = GetSteadyMicros();
+            if (capture) {
+                capture->Record(PacketCapture::Direction::RECEIVED, packetArrivalMicros,
+                    serverAddress, serverPort, receiveBuffer);
+            }
+            ProcessPacket(receiveBuffer, serverAddress, serverPort);
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in ProcessSharedMemoryMessages: " + std::string(e.what()), error);
+        consecutiveErrors++;
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in ProcessSharedMemoryMessages", error);
+        consecutiveErrors++;
+    }
+}
+
 void NetworkClient::ProcessPacket(sf::Packet& packet, sf::IpAddress senderIP, unsigned short senderPort) {
+    TRACE_SCOPE("Receive datagram", "net");
     try {
         uint8_t messageTypeRaw;
         if (!(packet >> messageTypeRaw)) {
@@ -777,308 +1075,132 @@ void NetworkClient::ProcessPacket(sf::Packet& packet, sf::IpAddress senderIP, un
             return;
         }
         NetMessageType msgType = static_cast<NetMessageType>(messageTypeRaw);
-        if (msgType == NetMessageType::GAME_STATE) {
-            uint32_t playerCount;
-            if (!(packet >> playerCount)) {
-                Utils::printMsg("Failed to extract player count from game state", warning);
+        // The group carries the shared frame only; anything else there is not from our server
+        if (receivingGroupDatagram && msgType != NetMessageType::MESSAGE_BUNDLE &&
+            msgType != NetMessageType::MESSAGE_FRAGMENT && msgType != NetMessageType::GAME_STATE_DELTA &&
+            msgType != NetMessageType::BULLET_UPDATE && msgType != NetMessageType::PLAYER_LIST) {
+            return;
+        }
+        // Containers are counted as datagrams; what they carry comes back through here
+        if (msgType != NetMessageType::MESSAGE_BUNDLE && msgType != NetMessageType::MESSAGE_FRAGMENT &&
+            msgType != NetMessageType::RELIABLE_MESSAGE && msgType != NetMessageType::COMPRESSED_MESSAGE) {
+            bandwidth.RecordMessageReceived(messageTypeRaw, packet.getDataSize());
+        }
+        if (msgType == NetMessageType::GAME_STATE_DELTA ||
+            msgType == NetMessageType::BULLET_UPDATE || msgType == NetMessageType::BULLET_SPAWNED) {
+            ProcessStateMessage(msgType, packet);
+        }
+        else if (msgType == NetMessageType::GAME_STATE) {
+            HandleGameState(packet);
+        }
+        else if (msgType == NetMessageType::CONNECTION_CHALLENGE) {
+            uint64_t token = 0;
+            if (localPlayerId == 0 && senderIP == serverAddress && senderPort == serverPort &&
+                packet >> token && token != 0) {
+                connectionToken = token;
+                if (spectating) {
+                    SendSpectateRequest();
+                }
+                else {
+                    SendJoinRequest(joinPlayerName, joinPreferredColor);
+                }
+            }
+            else if (resumeStartMs != 0 && senderIP == serverAddress && senderPort == serverPort) {
+                reconnectRequested = true;      // The server answered a resume: it no longer knows the session
+            }
+        }
+        else if (msgType == NetMessageType::PLAYER_ID_ASSIGNMENT) {
+            // Servers from before JOIN_ACCEPT
+            uint32_t assignedId;
+            if (packet >> assignedId) {
+                AcceptPlayerId(assignedId);
+            }
+            else {
+                Utils::printMsg("Failed to extract player ID from assignment", warning);
                 consecutiveErrors++;
-                return;
             }
-            // Validate player count is reasonable
-            if (!NetworkValidation::IsValidPlayerCount(playerCount)) {
-                Utils::printMsg("Invalid player count received: " + std::to_string(playerCount), error);
+        }
+        else if (msgType == NetMessageType::MESSAGE_BUNDLE) {
+            // Several server messages coalesced into one datagram; each is handled as if received alone
+            uint32_t bundledCount = 0;
+            const bool intact = PacketAggregator::ForEachMessage(packet, bundledMessage, [&](sf::Packet& message) {
+                bundledCount++;
+                ProcessPacket(message, senderIP, senderPort);
+            });
+            if (bundledCount > 1) {
+                networkStats.totalPacketsReceived += bundledCount - 1;  // Loss estimate counts messages
+            }
+            if (!intact) {
+                Utils::printMsg("Malformed message bundle after " + std::to_string(bundledCount) + " messages", warning);
                 consecutiveErrors++;
-                return;
             }
-            // Clear current other players
-            otherPlayers.clear();
-            uint32_t successfullyParsed = 0;
-            for (uint32_t i = 0; i < playerCount; ++i) {
-                PlayerData player;
-                // Extract basic data
-                if (!(packet >> player.playerId >> player.playerName >> player.x >> player.y)) {
-                    Utils::printMsg("Failed to extract player " + std::to_string(i) + " basic data", warning);
-                    break;
-                }
-                // Validate player ID
-                if (!NetworkValidation::IsValidPlayerId(player.playerId)) {
-                    Utils::printMsg("Invalid player ID in game state: " + std::to_string(player.playerId), warning);
-                    continue;
-                }
-                // Validate player name
-                if (!NetworkValidation::IsValidPlayerName(player.playerName)) {
-                    Utils::printMsg("Invalid player name in game state (length: " +
-                        std::to_string(player.playerName.length()) + ")", warning);
-                    player.playerName = "Player" + std::to_string(player.playerId);
+        }
+        else if (msgType == NetMessageType::RELIABLE_MESSAGE) {
+            // Events are delivered once and in order, however often they are resent
+            const bool accepted = reliableReceiver.Receive(packet, [&](sf::Packet& message) {
+                ProcessPacket(message, senderIP, senderPort);
+            });
+            if (accepted) {
+                if (reliableAckPendingSince == 0) {
+                    reliableAckPendingSince = GetCurrentTimestamp();
                 }
-                // Validate position
-                if (!NetworkValidation::IsValidPosition(player.x, player.y)) {
-                    Utils::printMsg("Invalid position for player " + std::to_string(player.playerId) +
-                        " (" + std::to_string(player.x) + ", " + std::to_string(player.y) + ")", warning);
-                    player.x = NetworkValidation::ClampPositionX(player.x);
-                    player.y = NetworkValidation::ClampPositionY(player.y);
+            }
+            else {
+                Utils::printMsg("Rejected reliable message outside the receive window", debug);
+            }
+        }
+        else if (msgType == NetMessageType::MESSAGE_FRAGMENT) {
+            // Group and unicast fragments number their messages independently
+            FragmentReassembler& reassembler = receivingGroupDatagram ? groupReassembler : fragmentReassembler;
+            const uint32_t expiredBefore = reassembler.GetExpiredCount();
+            if (reassembler.AddFragment(packet, GetCurrentTimestamp(), reassembledMessage)) {
+                // Handled like any other datagram; a fragmented message never holds fragments
+                if (reassembledMessage.getDataSize() > 0 && static_cast<const uint8_t*>(reassembledMessage.getData())[0] !=
+                    static_cast<uint8_t>(NetMessageType::MESSAGE_FRAGMENT)) {
+                    ProcessPacket(reassembledMessage, senderIP, senderPort);
                 }
-                // Extract rotations including barrel rotation
-                if (!(packet >> player.bodyRotation >> player.barrelRotation)) {
-                    Utils::printMsg("Failed to extract player rotations", warning);
-                    break;
-                }
-                if (player.playerId != localPlayerId) { // Only log other players
-                    static std::unordered_map<uint32_t, int> logCounters;
-                    if (++logCounters[player.playerId] % 30 == 0) {
-                    //    Utils::printMsg(" CLIENT RECV: Player=" + std::to_string(player.playerId) +
-                     //       " Body=" + std::to_string(player.bodyRotation) + "° " +
-                      //      "Barrel=" + std::to_string(player.barrelRotation) + "°", debug);
-                    }
-                }
-                // Validate rotations
-                if (!NetworkValidation::IsValidRotation(player.bodyRotation)) {
-                    Utils::printMsg("Invalid body rotation for player " + std::to_string(player.playerId) +
-                        ": " + std::to_string(player.bodyRotation), debug);
-                    player.bodyRotation = NetworkValidation::NormalizeRotation(player.bodyRotation);
-                }
-                if (!NetworkValidation::IsValidRotation(player.barrelRotation)) {
-                    Utils::printMsg("Invalid barrel rotation for player " + std::to_string(player.playerId) +
-                        ": " + std::to_string(player.barrelRotation), debug);
-                    player.barrelRotation = NetworkValidation::NormalizeRotation(player.barrelRotation);
-                }
-                // Extract remaining data
-                if (!(packet >> player.color >> player.isMoving_forward)) {
-                    Utils::printMsg("Failed to extract player movement data", warning);
-                    break;
-                }
-                // Validate color
-                if (!NetworkValidation::IsValidColor(player.color)) {
-                    Utils::printMsg("Invalid color for player " + std::to_string(player.playerId), debug);
-                    player.color = "green";
-                }
-                if (!(packet >> player.isMoving_backward >> player.isMoving_left >> player.isMoving_right)) {
-                    Utils::printMsg("Failed to extract player directional data", warning);
-                    break;
-                }
-
-                // CRITICAL: Extract health data (added for health bar system)
-                if (!(packet >> player.health >> player.maxHealth)) {
-                    Utils::printMsg("Failed to extract player health data", warning);
-                    break;
-                }
-
-                // Extract score and death state
-                if (!(packet >> player.score >> player.isDead)) {
-                    Utils::printMsg("Failed to extract player score/death data", warning);
-                    break;
-                }
-
-                // Process local player for reconciliation
-                if (player.playerId == localPlayerId && localPlayerId != 0) {
-                    serverAuthoritativePosition = sf::Vector2f(player.x, player.y);
-                    serverAuthoritativeBodyRotation = player.bodyRotation;
-                    serverAuthoritativeBarrelRotation = player.barrelRotation;
-
-                    //Store health/maxHealth/score/isDead for local player synchronization
-                    serverAuthoritativeHealth = player.health;
-                    serverAuthoritativeMaxHealth = player.maxHealth;
-                    serverAuthoritativeScore = player.score;
-                    serverAuthoritativeIsDead = player.isDead;
-
-                    hasServerAuthoritativeState = true;
-                    successfullyParsed++;
-                }
-                // Add other players to map
-                else if (player.playerId != localPlayerId && localPlayerId != 0) {
-                    otherPlayers[player.playerId] = player;
-                    successfullyParsed++;
-                }
-            }
-            // Verify we parsed expected number of players
-            uint32_t expectedOtherPlayers = (localPlayerId == 0) ? playerCount : playerCount - 1;
-            if (successfullyParsed < expectedOtherPlayers) {
-                Utils::printMsg("Warning: Only parsed " + std::to_string(successfullyParsed) +
-                    " of " + std::to_string(expectedOtherPlayers) + " expected players", warning);
-            }
-
-            // NEW: Parse enemy data from packet
-            uint32_t enemyCount;
-            if (packet >> enemyCount) {
-                // Clear existing enemy data
-                enemyData.clear();
-                // Parse each enemy
-                for (uint32_t i = 0; i < enemyCount; ++i) {
-                    EnemyData enemy;
-                    if (packet >> enemy.enemyId >> enemy.enemyType >> enemy.x >> enemy.y >>
-                        enemy.bodyRotation >> enemy.barrelRotation >> enemy.health >> enemy.maxHealth) {
-                        // Store enemy data
-                        enemyData[enemy.enemyId] = enemy;
-                    }
-                    else {
-                        Utils::printMsg("Failed to parse enemy " + std::to_string(i), warning);
-                        break;
-                    }
-                }
-                // Debug log enemy reception
-                static int receiveCounter = 0;
-                if (++receiveCounter % 100 == 0) {
-                    Utils::printMsg("Client received " + std::to_string(enemyCount) + " enemies", debug);
-                }
-            }
-            else {
-                Utils::printMsg("Failed to extract enemy count (may be old server version)", debug);
-                // Not a critical error - continue without enemies
-            }
-
-            // Extract timestamp and sequence number
-            int64_t timestamp;
-            uint32_t sequenceNumber;
-            uint32_t lastAckedInput;
-            if (packet >> timestamp >> sequenceNumber >> lastAckedInput) {
-                int64_t currentTime = GetCurrentTimestamp();
-                if (NetworkValidation::IsValidTimestamp(timestamp, currentTime)) {
-                    RecordReceivedPacket(sequenceNumber);
-                    lastServerTimestamp = timestamp;
-                    // Process acknowledged input
-                    if (lastAckedInput > 0 && lastAckedInput > lastAcknowledgedInputSeq) {
-                        prediction->AcknowledgeInput(lastAckedInput);
-                        lastAcknowledgedInputSeq = lastAckedInput;
-                        lastInputAckTime = currentTime;
-                    }
-                    consecutiveErrors = 0;
-                }
-                else {
-                    Utils::printMsg("Invalid timestamp in game state (delta: " +
-                        std::to_string(std::abs(currentTime - timestamp)) + "ms)", debug);
-                }
-            }
-        }
-        else if (msgType == NetMessageType::PLAYER_ID_ASSIGNMENT) {
-            uint32_t assignedId;
-            if (packet >> assignedId) {
-                //  Validate assigned player ID
-                if (!NetworkValidation::IsValidPlayerId(assignedId)) {
-                    Utils::printMsg("Invalid player ID assignment: " + std::to_string(assignedId), error);
-                    consecutiveErrors++;
-                    return;
-                }
-                localPlayerId = assignedId;
-                Utils::printMsg("Assigned player ID: " + std::to_string(localPlayerId));
-                consecutiveErrors = 0;
             }
-            else {
-                Utils::printMsg("Failed to extract player ID from assignment", warning);
-                consecutiveErrors++;
+            if (reassembler.GetExpiredCount() != expiredBefore) {
+                Utils::printMsg("Dropped incomplete fragmented message (total dropped: " +
+                    std::to_string(reassembler.GetExpiredCount()) + ")", debug);
             }
         }
-        else if (msgType == NetMessageType::PONG) {
-            PongMessage pongMsg;
-            if (packet >> pongMsg.originalTimestamp >> pongMsg.sequenceNumber) {
-                //  Validate pong timestamp
-                if (pongMsg.originalTimestamp <= 0) {
-                    Utils::printMsg("Invalid pong timestamp: " + std::to_string(pongMsg.originalTimestamp), warning);
-                    return;
-                }
-                HandlePong(pongMsg);
-                consecutiveErrors = 0;
-            }
-            else {
-                Utils::printMsg("Failed to extract pong message data", warning);
+        else if (msgType == NetMessageType::COMPRESSED_MESSAGE) {
+            if (!decompressor.Decompress(packet, decompressedMessage)) {
+                Utils::printMsg("Dropped compressed message (corrupt, or server dictionary differs)", warning);
                 consecutiveErrors++;
-            }
-        }
-        else if (msgType == NetMessageType::BULLET_UPDATE) {
-            BulletUpdateMessage updateMsg;
-            updateMsg.type = msgType;
-
-            uint32_t bulletCount;
-            if (!(packet >> bulletCount)) {
-                Utils::printMsg("Failed to extract bullet count", warning);
                 return;
             }
-
-            updateMsg.bullets.clear();
-            updateMsg.bullets.reserve(bulletCount);
-
-            for (uint32_t i = 0; i < bulletCount; ++i) {
-                BulletData bullet;
-                if (packet >> bullet) {
-                    updateMsg.bullets.push_back(bullet);
-                }
-                else {
-                    Utils::printMsg("Failed to parse bullet " + std::to_string(i), warning);
-                    break;
-                }
-            }
-
-            if (packet >> updateMsg.timestamp >> updateMsg.sequenceNumber) {
-                HandleBulletUpdate(updateMsg);
-            }
-            else {
-                Utils::printMsg("Failed to extract bullet update metadata", warning);
+            // The server compresses single messages, never containers
+            const NetMessageType innerType = static_cast<NetMessageType>(
+                static_cast<const uint8_t*>(decompressedMessage.getData())[0]);
+            if (innerType != NetMessageType::MESSAGE_BUNDLE && innerType != NetMessageType::MESSAGE_FRAGMENT &&
+                innerType != NetMessageType::RELIABLE_MESSAGE && innerType != NetMessageType::COMPRESSED_MESSAGE) {
+                ProcessPacket(decompressedMessage, senderIP, senderPort);
             }
         }
-
-        // Handle bullet destroy
-        else if (msgType == NetMessageType::BULLET_DESTROY) {
-            BulletDestroyMessage destroyMsg;
-            destroyMsg.type = msgType;
-
-            if (packet >> destroyMsg.bulletId >> destroyMsg.destroyReason
-                >> destroyMsg.hitTargetId >> destroyMsg.hitX >> destroyMsg.hitY
-                >> destroyMsg.timestamp >> destroyMsg.sequenceNumber) {
-
-                HandleBulletDestroy(destroyMsg);
-            }
-            else {
-                Utils::printMsg("Failed to parse bullet destroy message", warning);
-            }
-        }
-        else if (msgType == NetMessageType::INPUT_ACKNOWLEDGMENT) {
-            // Handle explicit input acknowledgment
-            InputAcknowledgmentMessage ackMsg;
-            if (packet >> ackMsg.playerId >> ackMsg.acknowledgedSequence >> ackMsg.serverTimestamp) {
-                HandleInputAcknowledgment(ackMsg);
-            }
-            else {
-                Utils::printMsg("Failed to extract input acknowledgment data", warning);
-            }
-        }
-        else if (msgType == NetMessageType::PLAYER_DEATH) {
-            // Handle player death message
-            PlayerDeathMessage deathMsg;
-            if (packet >> deathMsg.playerId >> deathMsg.killerId >> deathMsg.deathX >> deathMsg.deathY
-                >> deathMsg.scorePenalty >> deathMsg.timestamp >> deathMsg.sequenceNumber) {
-
-                Utils::printMsg(" DEATH MESSAGE: Player " + std::to_string(deathMsg.playerId) +
-                    " died | Penalty: " + std::to_string(deathMsg.scorePenalty) + " points", error);
-
-                // If this is the local player, notify them
-                if (deathMsg.playerId == localPlayerId) {
-                    Utils::printMsg("YOU DIED! You will respawn in 5 seconds...", error);
-                }
-            }
-            else {
-                Utils::printMsg("Failed to extract player death data", warning);
+        else {
+            const MessageSchema::DispatchResult result = MessageSchema::Dispatch<ServerToClientMessages>(
+                messageTypeRaw, packet, MessageSchema::Overloaded{
+                    [&](PlayerListMessage& msg) { HandlePlayerList(msg); },
+                    [&](const InterestUpdateMessage& msg) { HandleInterestUpdate(msg); },
+                    [&](const PongMessage& msg) { HandlePong(msg); },
+                    [&](const InputAcknowledgmentMessage& msg) { HandleInputAcknowledgment(msg); },
+                    [&](const BulletDestroyMessage& msg) { HandleBulletDestroy(msg); },
+                    [&](const PlayerDeathMessage& msg) { HandlePlayerDeath(msg); },
+                    [&](const PlayerRespawnMessage& msg) { HandlePlayerRespawn(msg); },
+                    [&](const MulticastGroupMessage& msg) { HandleMulticastGroup(msg); },
+                    [&](const GroupStateAckMessage& msg) { HandleGroupStateAck(msg); },
+                    [&](ChunkDataMessage& msg) { HandleChunkData(msg); },
+                    [&](const JoinAcceptMessage& msg) { HandleJoinAccept(msg); }
+                });
+            if (result == MessageSchema::DispatchResult::MALFORMED) {
+                Utils::printMsg("Failed to parse " + std::string(GetNetMessageTypeName(messageTypeRaw)) + " message", warning);
+                consecutiveErrors++;
             }
-        }
-        else if (msgType == NetMessageType::PLAYER_RESPAWN) {
-            // Handle player respawn message
-            PlayerRespawnMessage respawnMsg;
-            if (packet >> respawnMsg.playerId >> respawnMsg.spawnX >> respawnMsg.spawnY
-                >> respawnMsg.health >> respawnMsg.timestamp >> respawnMsg.sequenceNumber) {
-
-                Utils::printMsg("RESPAWN MESSAGE: Player " + std::to_string(respawnMsg.playerId) +
-                    " respawned at (" + std::to_string(respawnMsg.spawnX) + ", " +
-                    std::to_string(respawnMsg.spawnY) + ")", success);
-
-                // If this is the local player, notify them
-                if (respawnMsg.playerId == localPlayerId) {
-                    Utils::printMsg("YOU RESPAWNED! Back in action!", success);
-                }
+            else if (result == MessageSchema::DispatchResult::UNKNOWN) {
+                Utils::printMsg("Received unknown message type: " + std::to_string(static_cast<int>(msgType)), debug);
             }
-            else {
-                Utils::printMsg("Failed to extract player respawn data", warning);
-            }
-        }
-        else {
-            Utils::printMsg("Received unknown message type: " + std::to_string(static_cast<int>(msgType)), debug);
         }
     }
     catch (const std::exception& e) {
@@ -1121,201 +1243,997 @@ void NetworkClient::ValidateAndClampLocalPlayerData(Tank& localPlayer) {
     }
 }
 
+/**
+ * Takes the ID the server assigned; false (and no ID) if it is out of range.
+ */
+bool NetworkClient::AcceptPlayerId(uint32_t assignedId) {
+    if (!NetworkValidation::IsValidPlayerId(assignedId)) {
+        Utils::printMsg("Invalid player ID assignment: " + std::to_string(assignedId), error);
+        consecutiveErrors++;
+        return false;
+    }
+    localPlayerId = assignedId;
+    Utils::printMsg("Assigned player ID: " + std::to_string(localPlayerId) + " (joined in " +
+        std::to_string(GetCurrentTimestamp() - handshakeStartMs) + " ms, " +
+        std::to_string(handshakeAttempts) + " connection request(s))", success);
+    consecutiveErrors = 0;
+    return true;
+}
+
+/**
+ * The ID comes first in the join reply, so the snapshot behind it in the same
+ * datagrams already applies to the local tank. The join's round trip is the
+ * first clock sample: the server time and RTT are known before any ping.
+ */
+void NetworkClient::HandleJoinAccept(const JoinAcceptMessage& msg) {
+    if (spectating) {
+        return;
+    }
+    if (localPlayerId != 0 && msg.playerId == localPlayerId) {
+        if (resumeStartMs != 0) {
+            Utils::printMsg("Session resume accepted after " + std::to_string(GetCurrentTimestamp() - resumeStartMs) +
+                " ms", success);
+        }
+    }
+    else if (!AcceptPlayerId(msg.playerId)) {
+        return;
+    }
+    if (msg.tickRate >= TickScheduler::MIN_TICK_RATE && msg.tickRate <= TickScheduler::MAX_TICK_RATE &&
+        msg.tickRate != serverTickRate) {
+        serverTickRate = msg.tickRate;
+        updateRate = 1.0f / static_cast<float>(serverTickRate);     // Unpredicted input, one per tick too
+        Utils::printMsg("Server ticks at " + std::to_string(serverTickRate) + " Hz", info);
+    }
+    if (msg.clientSendTime <= 0) {
+        return;
+    }
+    const int64_t roundTripMicros = clockSync.AddPingSample(msg.clientSendTime,
+        msg.serverReceiveTime, msg.serverTransmitTime, packetArrivalMicros);
+    if (roundTripMicros >= 0) {
+        UpdateNetworkStatistics(static_cast<float>(roundTripMicros) / 1000.0f);
+    }
+}
+
 void NetworkClient::HandlePong(const PongMessage& msg) {
+    if (msg.originalTimestamp <= 0) {
+        Utils::printMsg("Invalid pong timestamp: " + std::to_string(msg.originalTimestamp), warning);
+        return;
+    }
+    consecutiveErrors = 0;
     try {
-        // Calculate RTT
-        int64_t currentTime = GetCurrentTimestamp();
-        float rtt = static_cast<float>(currentTime - msg.originalTimestamp);
+        // RTT excludes the time the server held the ping; the same four
+        // times are a clock offset sample
+        const int64_t roundTripMicros = clockSync.AddPingSample(msg.originalTimestamp,
+            msg.serverReceiveTime, msg.serverTransmitTime, packetArrivalMicros);
+        if (roundTripMicros < 0) {
+            Utils::printMsg("Invalid pong times (sent " + std::to_string(msg.originalTimestamp) +
+                "us, server " + std::to_string(msg.serverReceiveTime) + "-" +
+                std::to_string(msg.serverTransmitTime) + "us)", warning);
+            return;
+        }
+        UpdateNetworkStatistics(static_cast<float>(roundTripMicros) / 1000.0f);
+        lastTimingSampleMicros = packetArrivalMicros;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in HandlePong: " + std::string(e.what()), error);
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in HandlePong", error);
+    }
+}
+
+void NetworkClient::UpdateNetworkStatistics(float rtt) {
+    // Add to RTT history
+    rttHistory.push_back(rtt);
+    if (rttHistory.size() > RTT_HISTORY_SIZE) {
+        rttHistory.pop_front();
+    }
+
+    // Update min/max RTT
+    networkStats.minRTT = std::min(networkStats.minRTT, rtt);
+    telemetry.RecordRtt(rtt);
+    networkStats.maxRTT = std::max(networkStats.maxRTT, rtt);
+
+    // Calculate average RTT
+    float totalRTT = 0;
+    for (float r : rttHistory) {
+        totalRTT += r;
+    }
+    networkStats.averageRTT = totalRTT / rttHistory.size();
+    networkStats.averageLatency = networkStats.averageRTT / 2.0f;
+
+    // Calculate jitter (variation in delay)
+    if (rttHistory.size() > 1) {
+        float variance = 0;
+        for (float r : rttHistory) {
+            float diff = r - networkStats.averageRTT;
+            variance += diff * diff;
+        }
+        networkStats.jitter = std::sqrt(variance / rttHistory.size());
+    }
+
+    // Calculate packet loss percentage
+    if (networkStats.totalPacketsSent > 0) {
+        networkStats.packetsLost = networkStats.totalPacketsSent - networkStats.totalPacketsReceived;
+        networkStats.packetLoss = (static_cast<float>(networkStats.packetsLost) /
+            static_cast<float>(networkStats.totalPacketsSent)) * 100.0f;
+    }
+}
+
+void NetworkClient::RecordReceivedPacket(uint32_t sequenceNumber) {
+    // Check for out-of-order packets
+    if (IsPacketOutOfOrder(sequenceNumber)) {
+        Utils::printMsg("Out-of-order packet detected: " + std::to_string(sequenceNumber), debug);
+    }
+
+    // Record this sequence number (the window slides forward by itself)
+    receivedSequences.Record(sequenceNumber);
+}
+
+bool NetworkClient::IsPacketOutOfOrder(uint32_t sequenceNumber) const {
+    // If we've already received this packet, it's a duplicate
+    if (receivedSequences.Contains(sequenceNumber)) {
+        return true;
+    }
 
-        // Validate RTT is reasonable (< 10 seconds)
-        if (rtt < 0 || rtt > 10000) {
-            Utils::printMsg("Invalid RTT calculated: " + std::to_string(rtt), warning);
+    // If this sequence is older than the last received, it's out of order
+    if (receivedSequences.HasReceived() && SequenceWindow::IsNewer(receivedSequences.GetLatest(), sequenceNumber)) {
+        return true;
+    }
+
+    return false;
+}
+
+void NetworkClient::SetOnFirstGameStateCallback(OnFirstGameStateCallback cb) {
+    onFirstGameState = std::move(cb);
+}
+
+int64_t NetworkClient::GetLastGameStateTimestamp() const {
+    return lastGameStateTimestamp;
+}
+
+/**
+ * Full state from servers that predate delta snapshots, decoded one record at
+ * a time straight into otherPlayers and enemyData. Known entities are
+ * overwritten in place, so only ones seen for the first time allocate; those
+ * the message no longer lists are dropped once it has decoded completely.
+ * @param packet Packet positioned just after the message type
+ */
+void NetworkClient::HandleGameState(sf::Packet& packet) {
+    TRACE_SCOPE("Decode game state", "snapshot");
+    uint32_t playerCount = 0;
+    if (!(packet >> playerCount) || !NetworkValidation::IsValidPlayerCount(playerCount)) {
+        Utils::printMsg("Invalid player count in game state", warning);
+        consecutiveErrors++;
+        return;
+    }
+    listedPlayerIds.clear();
+    PlayerData player;
+    for (uint32_t i = 0; i < playerCount; ++i) {
+        if (!MessageSchema::Codec<PlayerData>::Read(packet, player)) {
+            Utils::printMsg("Game state truncated after " + std::to_string(i) + " players", warning);
+            consecutiveErrors++;
             return;
         }
+        if (ApplyPlayerState(player)) {
+            listedPlayerIds.push_back(player.playerId);
+        }
+    }
 
-        // Update network statistics
-        UpdateNetworkStatistics(rtt);
+    uint32_t enemyCount = 0;
+    if (!(packet >> enemyCount) ||
+        enemyCount > MessageSchema::RemainingBytes(packet) / MessageSchema::Codec<EnemyData>::MIN_SIZE) {
+        Utils::printMsg("Invalid enemy count in game state", warning);
+        consecutiveErrors++;
+        return;
+    }
+    listedEnemyIds.clear();
+    EnemyData enemy;
+    for (uint32_t i = 0; i < enemyCount; ++i) {
+        if (!MessageSchema::Codec<EnemyData>::Read(packet, enemy)) {
+            Utils::printMsg("Game state truncated after " + std::to_string(i) + " enemies", warning);
+            consecutiveErrors++;
+            return;
+        }
+        enemyData[enemy.enemyId] = enemy;
+        listedEnemyIds.push_back(enemy.enemyId);
+    }
 
-        // Remove this ping from sent packets tracking
-        auto it = std::find_if(sentPackets.begin(), sentPackets.end(),
-            [&msg](const SentPacket& sp) { return sp.sequenceNumber == msg.sequenceNumber; });
+    int64_t timestamp = 0;
+    uint32_t sequenceNumber = 0;
+    uint32_t lastAckedInput = 0;
+    if (!(packet >> timestamp >> sequenceNumber >> lastAckedInput)) {
+        Utils::printMsg("Game state truncated before its timing", warning);
+        consecutiveErrors++;
+        return;
+    }
+
+    RemoveUnlisted(otherPlayers, listedPlayerIds);
+    RemoveUnlisted(enemyData, listedEnemyIds);
+    if (groupDelivery) {
+        Utils::printMsg("LAN multicast stalled, game state back on unicast", warning);
+        groupDelivery = false;
+        awaitingGroupFrame = 0;
+    }
+    ProcessGameStateTiming(timestamp, sequenceNumber, lastAckedInput, 0);
+}
+
+/**
+ * Reads the StateHeader that leads GAME_STATE_DELTA, BULLET_UPDATE and
+ * BULLET_SPAWNED and drops stale or duplicate messages before their body is
+ * decoded. The rest is decoded straight into the live entity tables.
+ * @param packet Packet positioned just after the message type
+ */
+void NetworkClient::ProcessStateMessage(NetMessageType msgType, sf::Packet& packet) {
+    BitReader reader = BitReader::FromPacket(packet);
+    StateHeader header;
+    if (!NetworkUtils::Read(reader, header)) {
+        Utils::printMsg("Failed to extract state header", warning);
+        consecutiveErrors++;
+        return;
+    }
+    if (receivingGroupDatagram) {
+        ProcessGroupStateMessage(msgType, reader, header);
+        return;
+    }
+    if (IsStaleState(msgType, header)) {
+        Utils::printMsg("Dropped stale " + std::string(GetNetMessageTypeName(static_cast<uint8_t>(msgType))) +
+            " " + std::to_string(header.sequence), debug);
+        return;
+    }
 
-        if (it != sentPackets.end()) {
-            sentPackets.erase(it);
+    if (msgType == NetMessageType::GAME_STATE_DELTA) {
+        if (groupDelivery) {
+            Utils::printMsg("LAN multicast stalled, snapshots back on unicast", warning);
+            groupDelivery = false;
+            awaitingGroupFrame = 0;
+        }
+        HandleGameStateDelta(reader, header);
+    }
+    else if (msgType == NetMessageType::BULLET_UPDATE) {
+        if (HandleBulletUpdate(reader)) {
+            lastBulletUpdateSequence = header.sequence;
         }
+        else {
+            Utils::printMsg("Failed to parse bullet update message", warning);
+        }
+    }
+    else if (HandleBulletSpawned(reader)) {
+        lastBulletSpawnSequence = header.sequence;
+    }
+    else {
+        Utils::printMsg("Failed to parse bullet spawn event", warning);
+    }
+}
+
+/**
+ * A snapshot is stale once a newer one was applied; it is never needed as a
+ * baseline either, since only the newest applied snapshot is acked. Bullet
+ * spawns are also covered by any full bullet list at least as new.
+ */
+bool NetworkClient::IsStaleState(NetMessageType msgType, const StateHeader& header) const {
+    const auto notNewer = [&header](uint32_t lastApplied) {
+        return lastApplied != 0 && !SequenceWindow::IsNewer(header.sequence, lastApplied);
+    };
+    switch (msgType) {
+    case NetMessageType::GAME_STATE_DELTA:
+        return header.sequence <= latestSnapshotSequence;
+    case NetMessageType::BULLET_UPDATE:
+        return notNewer(lastBulletUpdateSequence);
+    case NetMessageType::BULLET_SPAWNED:
+        return notNewer(lastBulletSpawnSequence) || notNewer(lastBulletUpdateSequence);
+    default:
+        return false;
+    }
+}
+
+/**
+ * Decodes a delta snapshot against the baseline the server chose, directly into
+ * its history slot, and applies it. Only called for snapshots newer than any
+ * applied so far.
+ * @param reader Reader positioned just after the StateHeader
+ * @param stateHeader Snapshot sequence and server timestamp
+ */
+void NetworkClient::HandleGameStateDelta(BitReader& reader, const StateHeader& stateHeader) {
+    TRACE_SCOPE("Decode snapshot", "snapshot");
+    SnapshotHeader header;
+    if (!SnapshotDelta::ReadHeader(reader, stateHeader, header)) {
+        Utils::printMsg("Failed to extract delta snapshot header", warning);
+        consecutiveErrors++;
+        return;
+    }
+
+    const WorldSnapshot* baseline = nullptr;
+    if (header.baselineSequence != 0) {
+        baseline = receivedSnapshots.Find(header.baselineSequence);
+        if (!baseline) {
+            // Server falls back to a full snapshot once this baseline ages out of its history
+            Utils::printMsg("Delta snapshot " + std::to_string(header.snapshotSequence) +
+                " references unknown baseline " + std::to_string(header.baselineSequence), debug);
+            return;
+        }
+    }
+
+    WorldSnapshot& snapshot = receivedSnapshots.SlotFor(header.snapshotSequence);
+    if (!SnapshotDelta::ReadBody(reader, header, baseline, snapshot)) {
+        snapshot.sequence = 0;  // Half-decoded; must not be found as a baseline
+        Utils::printMsg("Failed to decode delta snapshot " + std::to_string(header.snapshotSequence), warning);
+        consecutiveErrors++;
+        return;
+    }
+    latestSnapshotSequence = header.snapshotSequence;
+    // Applied all the same: a drifted copy is the best there is until the full snapshot lands
+    if (header.hasStateHash && SnapshotDelta::Hash(snapshot) != header.stateHash) {
+        RequestStateResync(header.snapshotSequence);
+    }
+
+    ApplyWorldSnapshot(snapshot);
+    ProcessGameStateTiming(header.timestamp, header.sequenceNumber, header.lastAckedInput,
+        header.inputApplyMicros);
+}
+
+/**
+ * Spectators have nothing to resync: their stream's next keyframe repairs
+ * the copy. Snapshots already in flight fail too until the full one
+ * arrives, so requests are spaced rather than sent for each.
+ */
+void NetworkClient::RequestStateResync(uint32_t snapshotSequence) {
+    uint32_t suppressed = 0;
+    if (LogSampler::ShouldLog(LogCategory::STATE_RESYNC, suppressed)) {
+        Utils::printMsg(LogSampler::WithSuppressed("Snapshot " + std::to_string(snapshotSequence) +
+            " failed its state hash", suppressed), warning);
+    }
+    const int64_t now = GetCurrentTimestamp();
+    if (spectating || localPlayerId == 0 || now - lastStateResyncMs < STATE_RESYNC_RETRY_MS) {
+        return;
+    }
+    StateResyncMessage resyncMsg;
+    resyncMsg.playerId = localPlayerId;
+    resyncMsg.snapshotSequence = snapshotSequence;
+    PacketPool::Lease packet = sendPackets.Borrow();
+    *packet << resyncMsg;
+    if (SendToServer(*packet) == sf::Socket::Status::Done) {
+        lastStateResyncMs = now;
+    }
+}
+
+/**
+ * Clamps one player's replicated state and files it: the local player's as the
+ * authoritative state for reconciliation, anyone else's over its entry in
+ * otherPlayers. Nothing is kept before the server has assigned our ID,
+ * unless spectating, where every player is someone else.
+ * @return False if the player ID is invalid and the state was ignored
+ */
+bool NetworkClient::ApplyPlayerState(PlayerData player) {
+    if (!NetworkValidation::IsValidPlayerId(player.playerId)) {
+        return false;
+    }
+    if (!NetworkValidation::IsValidPosition(player.x, player.y)) {
+        player.x = NetworkValidation::ClampPositionX(player.x);
+        player.y = NetworkValidation::ClampPositionY(player.y);
+    }
+    if (!NetworkValidation::IsValidRotation(player.bodyRotation)) {
+        player.bodyRotation = NetworkValidation::NormalizeRotation(player.bodyRotation);
+    }
+    if (!NetworkValidation::IsValidRotation(player.barrelRotation)) {
+        player.barrelRotation = NetworkValidation::NormalizeRotation(player.barrelRotation);
+    }
+
+    if (localPlayerId == 0 && !spectating) {
+        return true;
+    }
+    if (player.playerId == localPlayerId) {
+        serverAuthoritativePosition = sf::Vector2f(player.x, player.y);
+        serverAuthoritativeBodyRotation = player.bodyRotation;
+        serverAuthoritativeBarrelRotation = player.barrelRotation;
+        serverAuthoritativeHealth = player.health;
+        serverAuthoritativeMaxHealth = player.maxHealth;
+        serverAuthoritativeScore = player.score;
+        serverAuthoritativeIsDead = player.isDead;
+        hasServerAuthoritativeState = true;
+        hasUnreconciledServerState = true;
+    }
+    else {
+        otherPlayers[player.playerId] = player;
+    }
+    return true;
+}
+
+/**
+ * Updates other players and enemies in place to the snapshot contents, dropping
+ * any it no longer lists, and records the local player's authoritative state
+ * for reconciliation.
+ */
+void NetworkClient::ApplyWorldSnapshot(const WorldSnapshot& snapshot) {
+    for (const PlayerData& player : snapshot.players) {
+        ApplyPlayerState(player);
+    }
+
+    for (const EnemyData& enemy : snapshot.enemies) {
+        enemyData[enemy.enemyId] = enemy;
+    }
+
+    // Snapshot entities are sorted by ID
+    for (auto it = otherPlayers.begin(); it != otherPlayers.end();) {
+        auto listed = std::lower_bound(snapshot.players.begin(), snapshot.players.end(), it->first,
+            [](const PlayerData& player, uint32_t id) { return player.playerId < id; });
+        if (listed == snapshot.players.end() || listed->playerId != it->first) {
+            it = otherPlayers.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    for (auto it = enemyData.begin(); it != enemyData.end();) {
+        auto listed = std::lower_bound(snapshot.enemies.begin(), snapshot.enemies.end(), it->first,
+            [](const EnemyData& enemy, uint32_t id) { return enemy.enemyId < id; });
+        if (listed == snapshot.enemies.end() || listed->enemyId != it->first) {
+            it = enemyData.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Replaces the player table when a newer version arrives. Resends of the current
+ * version are ignored; the ack goes out with the next input either way.
+ * Unknown colours already read as green.
+ */
+void NetworkClient::HandlePlayerList(PlayerListMessage& msg) {
+    if (msg.players.size() > NetworkValidation::MAX_PLAYER_COUNT) {
+        Utils::printMsg("Player list too long: " + std::to_string(msg.players.size()), warning);
+        consecutiveErrors++;
+        return;
+    }
+    if (msg.tableVersion <= playerTableVersion) {
+        return;
+    }
+    playerTableVersion = msg.tableVersion;
+    playerTable.clear();
+    for (PlayerInfo& info : msg.players) {
+        if (!NetworkValidation::IsValidPlayerId(info.playerId)) {
+            continue;
+        }
+        if (!NetworkValidation::IsValidPlayerName(info.playerName)) {
+            info.playerName = "Player" + std::to_string(info.playerId);
+        }
+        playerTable[info.playerId] = std::move(info);
+    }
+    Utils::printMsg("Player table v" + std::to_string(playerTableVersion) + ": " +
+        std::to_string(playerTable.size()) + " players", debug);
+}
+
+const std::string& NetworkClient::GetPlayerName(uint32_t playerId) const {
+    static const std::string unknownName;
+    auto it = playerTable.find(playerId);
+    return it != playerTable.end() ? it->second.playerName : unknownName;
+}
+
+/**
+ * Shared tail of GAME_STATE and GAME_STATE_DELTA handling: packet statistics,
+ * server timestamp, piggybacked input acknowledgment and its latency.
+ * @param inputApplyMicros Server tick time the acked input was applied (0 = not sent, as in GAME_STATE)
+ */
+void NetworkClient::ProcessGameStateTiming(int64_t timestamp, uint32_t sequenceNumber, uint32_t lastAckedInput,
+    int64_t inputApplyMicros) {
+    const int64_t arrivalMicros = packetArrivalMicros;
+    int64_t currentTime = GetCurrentTimestamp();
+    lastServerAckedSequence = lastAckedInput;   // Input the local player's server state reflects
+    worldStateVersion++;
+    lastWorldStateArrivalMicros = arrivalMicros;
+
+    // Checked against the synchronised server clock. Until the first pong
+    // the snapshot timestamps themselves seed that clock
+    if (!clockSync.HasPingSample()) {
+        clockSync.ObserveServerTimestamp(timestamp, arrivalMicros);
+        clockSync.Update(arrivalMicros);
+    }
+    const int64_t serverNow = ToServerTime(arrivalMicros);
+    if (NetworkValidation::IsValidTimestamp(timestamp, serverNow)) {
+        if (clockSync.HasPingSample()) {
+            clockSync.ObserveServerTimestamp(timestamp, arrivalMicros);
+        }
+        if (!receivingGroupDatagram) {
+            RecordReceivedPacket(sequenceNumber);  // Group frames number their own stream
+        }
+        lastServerTimestamp = timestamp;
+        inputLatency.OnStateReceived(lastAckedInput, inputApplyMicros, arrivalMicros, clockSync);
+        // Process acknowledged input
+        if (lastAckedInput > 0 && lastAckedInput > lastAcknowledgedInputSeq) {
+            prediction->AcknowledgeInput(lastAckedInput);
+            lastAcknowledgedInputSeq = lastAckedInput;
+            lastInputAckTime = currentTime;
+        }
+        consecutiveErrors = 0;
+    }
+    else {
+        Utils::printMsg("Invalid timestamp in game state (delta: " +
+            std::to_string(std::abs(serverNow - timestamp)) + "ms)", debug);
+    }
+}
+
+/**
+ * Starts a handshake over: the first request goes out now and the backoff
+ * timer starts from its shortest wait.
+ */
+void NetworkClient::StartHandshake() {
+    handshakeStartMs = GetCurrentTimestamp();
+    handshakeAttempts = 0;
+    handshakeRetryMs = HANDSHAKE_RETRY_MIN_MS;
+    SendConnectionRequest();
+}
+
+/**
+ * Each unanswered request doubles the wait before the next one, so a lost
+ * first packet costs tens of milliseconds while a server that is down is not
+ * flooded. A request the socket could not take yet (NotReady) still counts.
+ */
+void NetworkClient::RetryHandshake() {
+    if (GetCurrentTimestamp() - lastHandshakeSendMs < handshakeRetryMs) {
+        return;
+    }
+    handshakeRetryMs = std::min(handshakeRetryMs * 2, HANDSHAKE_RETRY_MAX_MS);
+    if (handshakeAttempts == HANDSHAKE_WARN_ATTEMPTS) {
+        Utils::printMsg("No answer from the server after " + std::to_string(handshakeAttempts) +
+            " connection requests, still trying", warning);
+    }
+    SendConnectionRequest();
+}
+
+/**
+ * Sends a token-less CONNECTION_REQUEST; the server answers with the token
+ * the join and everything after it must carry.
+ */
+bool NetworkClient::SendConnectionRequest() {
+    try {
+        PacketPool::Lease packet = sendPackets.Borrow();
+        ConnectionTokens::WriteRequest(*packet);
+        connectionToken = 0;
+        lastHandshakeSendMs = GetCurrentTimestamp();
+        handshakeAttempts++;
+        bandwidth.RecordMessageSent(static_cast<uint8_t>(NetMessageType::CONNECTION_REQUEST), packet->getDataSize());
+
+        sf::Socket::Status sendStatus = SendDatagram(*packet);
+        if (sendStatus == sf::Socket::Status::Done) {
+            consecutiveErrors = 0;
+            return true;
+        }
+        if (sendStatus != sf::Socket::Status::NotReady) {
+            Utils::printMsg("Failed to send connection request - Status: " +
+                SocketStatusToString(sendStatus), error);
+            consecutiveErrors++;
+        }
+        return false;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SendConnectionRequest: " + std::string(e.what()), error);
+        consecutiveErrors++;
+        return false;
+    }
+}
+
+bool NetworkClient::SendJoinRequest(const std::string& playerName, const std::string& preferredColor) {
+    try {
+        PacketPool::Lease packet = sendPackets.Borrow();
+
+        JoinMessage joinMsg;
+        joinMsg.playerName = playerName;
+        joinMsg.preferredColor = preferredColor;
+        joinMsg.timestamp = GetCurrentTimestamp();
+        joinMsg.sequenceNumber = outgoingSequenceNumber++;
+        joinMsg.roomId = roomId;
+        joinMsg.sendMicros = GetSteadyMicros();
+
+        *packet << joinMsg;
+
+        networkStats.totalPacketsSent++;
+
+        sf::Socket::Status sendStatus = SendToServer(*packet);
+
+        if (sendStatus == sf::Socket::Status::Done) {
+            Utils::printMsg("Join request sent to server");
+            consecutiveErrors = 0;
+            return true;
+        }
+        else if (sendStatus == sf::Socket::Status::NotReady) {
+            Utils::printMsg("Socket not ready for join request", warning);
+            return false;
+        }
+        else {
+            Utils::printMsg("Failed to send join request - Status: " +
+                SocketStatusToString(sendStatus), error);
+            consecutiveErrors++;
+            return false;
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SendJoinRequest: " + std::string(e.what()), error);
+        consecutiveErrors++;
+        return false;
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in SendJoinRequest", error);
+        consecutiveErrors++;
+        return false;
+    }
+}
+
+/**
+ * Subscribes to the room's spectator stream, or refreshes the subscription.
+ */
+bool NetworkClient::SendSpectateRequest() {
+    try {
+        PacketPool::Lease packet = sendPackets.Borrow();
+        SpectateMessage spectateMsg;
+        spectateMsg.roomId = roomId;
+        *packet << spectateMsg;
+        lastSpectateSendMs = GetCurrentTimestamp();
+
+        sf::Socket::Status sendStatus = SendToServer(*packet);
+        if (sendStatus == sf::Socket::Status::Done) {
+            consecutiveErrors = 0;
+            return true;
+        }
+        if (sendStatus != sf::Socket::Status::NotReady) {
+            Utils::printMsg("Failed to send spectate request - Status: " +
+                SocketStatusToString(sendStatus), warning);
+            consecutiveErrors++;
+        }
+        return false;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SendSpectateRequest: " + std::string(e.what()), error);
+        consecutiveErrors++;
+        return false;
+    }
+}
+
+/**
+ * The request names the newest snapshot held, so the server's answer is a
+ * delta against it when it still has it.
+ */
+bool NetworkClient::SendSessionResume() {
+    try {
+        PacketPool::Lease packet = sendPackets.Borrow();
+        SessionResumeMessage resumeMsg;
+        resumeMsg.playerId = localPlayerId;
+        resumeMsg.lastReceivedSnapshot = latestSnapshotSequence;
+        resumeMsg.sendMicros = GetSteadyMicros();
+        resumeMsg.nextReliableSequence = reliableReceiver.GetNextExpected();
+        *packet << resumeMsg;
+        lastResumeSendMs = GetCurrentTimestamp();
+
+        sf::Socket::Status sendStatus = SendToServer(*packet);
+        if (sendStatus == sf::Socket::Status::Done) {
+            return true;
+        }
+        if (sendStatus != sf::Socket::Status::NotReady) {
+            Utils::printMsg("Failed to send session resume - Status: " + SocketStatusToString(sendStatus), warning);
+            consecutiveErrors++;
+        }
+        return false;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SendSessionResume: " + std::string(e.what()), error);
+        consecutiveErrors++;
+        return false;
+    }
+}
+
+/**
+ * Silence from the server is what a wifi blip or a NAT rebinding looks like
+ * from here: the server may be sending to an endpoint that is gone, or
+ * dropping datagrams from the new one. A resume request re-announces the
+ * session from wherever the client is now; the first request goes at once,
+ * later ones back off like the handshake.
+ */
+void NetworkClient::UpdateSession() {
+    const int64_t now = GetCurrentTimestamp();
+    const bool silent = lastWorldStateArrivalMicros != 0 &&
+        GetSteadyMicros() - lastWorldStateArrivalMicros >= SESSION_SILENCE_MS * 1000;
+    if (!silent) {
+        if (resumeStartMs != 0) {
+            Utils::printMsg("Session resumed, world state back after " + std::to_string(now - resumeStartMs) + " ms",
+                success);
+            resumeStartMs = 0;
+        }
+        return;
+    }
+    if (resumeStartMs == 0) {
+        Utils::printMsg("No world state for " + std::to_string(SESSION_SILENCE_MS) + " ms, resuming the session", warning);
+        resumeStartMs = now;
+        resumeRetryMs = HANDSHAKE_RETRY_MIN_MS;
+    }
+    else if (now - lastResumeSendMs < resumeRetryMs) {
+        return;
+    }
+    else {
+        resumeRetryMs = std::min(resumeRetryMs * 2, HANDSHAKE_RETRY_MAX_MS);
+    }
+    SendSessionResume();
+}
+
+/**
+ * The server dropped the session: joins again as a new player with the name
+ * and colour of the first join.
+ */
+void NetworkClient::Reconnect() {
+    reconnectRequested = false;
+    Utils::printMsg("Session expired on the server, connecting again", warning);
+    const std::string address = serverAddress.toString();
+    const unsigned short port = connectPort;
+    const std::string playerName = joinPlayerName;
+    const std::string preferredColor = joinPreferredColor;
+    Disconnect();
+    Connect(address, port, playerName, preferredColor, roomId);
+}
+
+/**
+ * Keeps the spectator subscription alive. The stream is delayed and never
+ * answers a request directly, so a lost handshake only shows as silence:
+ * after a subscription timeout without any stream the handshake starts over
+ * (a server that restarted no longer accepts the old token).
+ */
+void NetworkClient::UpdateSpectating() {
+    const int64_t now = GetCurrentTimestamp();
+    if (connectionToken == 0) {
+        RetryHandshake();
+        return;
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception in HandlePong: " + std::string(e.what()), error);
+    if (now - lastHandshakeSendMs >= SpectatorStream::SPECTATOR_TIMEOUT_MS &&
+        GetSteadyMicros() - lastWorldStateArrivalMicros >= SpectatorStream::SPECTATOR_TIMEOUT_MS * 1000) {
+        Utils::printMsg("No spectator stream for " + std::to_string(SpectatorStream::SPECTATOR_TIMEOUT_MS / 1000) +
+            " s, subscribing again", warning);
+        StartHandshake();
+        return;
     }
-    catch (...) {
-        Utils::printMsg("Unknown exception in HandlePong", error);
+    if (now - lastSpectateSendMs >= SpectatorStream::REFRESH_MS) {
+        SendSpectateRequest();
     }
 }
 
-void NetworkClient::UpdateNetworkStatistics(float rtt) {
-    // Add to RTT history
-    rttHistory.push_back(rtt);
-    if (rttHistory.size() > RTT_HISTORY_SIZE) {
-        rttHistory.pop_front();
+/**
+ * Joins the LAN multicast group the server offered. Only over a real network
+ * path: in-process and shared memory clients are cheaper to reach directly,
+ * and spectators have their own stream. A group that cannot be joined is not
+ * an error, the server simply keeps sending snapshots by unicast.
+ */
+void NetworkClient::HandleMulticastGroup(const MulticastGroupMessage& msg) {
+    if (spectating || loopbackChannel || sharedMemory.IsOpen() || !MulticastReceiver::IsSupported()) {
+        return;
     }
-
-    // Update min/max RTT
-    networkStats.minRTT = std::min(networkStats.minRTT, rtt);
-    networkStats.maxRTT = std::max(networkStats.maxRTT, rtt);
-
-    // Calculate average RTT
-    float totalRTT = 0;
-    for (float r : rttHistory) {
-        totalRTT += r;
+    const sf::IpAddress group(msg.groupAddress);
+    if (!LanMulticast::IsGroupAddress(group) || msg.groupPort == 0) {
+        Utils::printMsg("Ignored invalid LAN multicast group " + group.toString() + ":" + std::to_string(msg.groupPort), warning);
+        return;
     }
-    networkStats.averageRTT = totalRTT / rttHistory.size();
-    networkStats.averageLatency = networkStats.averageRTT / 2.0f;
-
-    // Calculate jitter (variation in delay)
-    if (rttHistory.size() > 1) {
-        float variance = 0;
-        for (float r : rttHistory) {
-            float diff = r - networkStats.averageRTT;
-            variance += diff * diff;
-        }
-        networkStats.jitter = std::sqrt(variance / rttHistory.size());
+    if (groupReceiver.IsJoined() && groupReceiver.GetGroup() == group && groupReceiver.GetPort() == msg.groupPort) {
+        return;
     }
-
-    // Calculate packet loss percentage
-    if (networkStats.totalPacketsSent > 0) {
-        networkStats.packetsLost = networkStats.totalPacketsSent - networkStats.totalPacketsReceived;
-        networkStats.packetLoss = (static_cast<float>(networkStats.packetsLost) /
-            static_cast<float>(networkStats.totalPacketsSent)) * 100.0f;
+    LeaveMulticastGroup();
+    if (!groupReceiver.Join(group, msg.groupPort)) {
+        Utils::printMsg("Could not join LAN multicast group " + group.toString() + ":" + std::to_string(msg.groupPort) +
+            ", game state stays on unicast", warning);
+        return;
     }
+    lastMulticastStatusMs = 0;      // Report right away
+    Utils::printMsg("Joined LAN multicast group " + group.toString() + ":" + std::to_string(msg.groupPort));
 }
 
-void NetworkClient::RecordReceivedPacket(uint32_t sequenceNumber) {
-    // Check for out-of-order packets
-    if (IsPacketOutOfOrder(sequenceNumber)) {
-        Utils::printMsg("Out-of-order packet detected: " + std::to_string(sequenceNumber), debug);
+/**
+ * The first ack switches to group delivery. An ack for the frame applied
+ * last completes it: reconciliation was held back until the input its tank
+ * reflects was known.
+ */
+void NetworkClient::HandleGroupStateAck(const GroupStateAckMessage& msg) {
+    if (!groupReceiver.IsJoined()) {
+        return;
     }
-
-    // Record this sequence number
-    receivedSequenceNumbers[sequenceNumber] = true;
-
-    // Update last received sequence number if this is newer
-    if (sequenceNumber > lastReceivedSequenceNumber) {
-        lastReceivedSequenceNumber = sequenceNumber;
+    if (!groupDelivery) {
+        groupDelivery = true;
+        awaitingGroupFrame = 0;
+        Utils::printMsg("Game state now arrives through LAN multicast", success);
     }
-
-    // Cleanup old sequence numbers periodically
-    CleanupOldSequenceNumbers();
-}
-
-bool NetworkClient::IsPacketOutOfOrder(uint32_t sequenceNumber) const {
-    // If we've already received this packet, it's a duplicate
-    if (receivedSequenceNumbers.find(sequenceNumber) != receivedSequenceNumbers.end()) {
-        return true;
+    groupAcks[msg.frameSequence % GROUP_ACK_HISTORY] = msg;
+    if (msg.frameSequence != awaitingGroupFrame) {
+        return;
     }
-
-    // If this sequence is less than the last received, it's out of order
-    if (sequenceNumber < lastReceivedSequenceNumber) {
-        return true;
+    awaitingGroupFrame = 0;
+    lastServerAckedSequence = msg.lastAckedInput;
+    inputLatency.OnStateReceived(msg.lastAckedInput, msg.inputApplyMicros, lastWorldStateArrivalMicros, clockSync);
+    if (msg.lastAckedInput > 0 && msg.lastAckedInput > lastAcknowledgedInputSeq) {
+        prediction->AcknowledgeInput(msg.lastAckedInput);
+        lastAcknowledgedInputSeq = msg.lastAckedInput;
+        lastInputAckTime = GetCurrentTimestamp();
     }
-
-    return false;
+    hasUnreconciledServerState = hasServerAuthoritativeState;
 }
 
-void NetworkClient::CleanupOldSequenceNumbers() {
-    if (receivedSequenceNumbers.size() > MAX_SEQUENCE_HISTORY) {
-        // Find oldest sequence numbers and remove them
-        uint32_t minSequence = lastReceivedSequenceNumber > MAX_SEQUENCE_HISTORY ?
-            lastReceivedSequenceNumber - MAX_SEQUENCE_HISTORY : 0;
-
-        auto it = receivedSequenceNumbers.begin();
-        while (it != receivedSequenceNumbers.end()) {
-            if (it->first < minSequence) {
-                it = receivedSequenceNumbers.erase(it);
-            }
-            else {
-                ++it;
-            }
+void NetworkClient::HandleChunkData(ChunkDataMessage& msg) {
+    if (msg.chunkId >= WorldChunks::COUNT || msg.tiles.size() != static_cast<size_t>(WorldChunks::TILE_COUNT)) {
+        Utils::printMsg("Dropped chunk data for chunk " + std::to_string(msg.chunkId) + " (" +
+            std::to_string(msg.tiles.size()) + " tiles)", warning);
+        return;
+    }
+    LoadedChunk& chunk = loadedChunks[msg.chunkId];
+    chunk.tiles = std::move(msg.tiles);
+    chunk.obstacles.clear();
+    for (const ObstacleData& data : msg.obstacles) {
+        const float right = static_cast<float>(data.left) + data.width;
+        const float bottom = static_cast<float>(data.top) + data.height;
+        if (data.kind >= static_cast<uint8_t>(StaticObstacles::Kind::COUNT) || data.width == 0 || data.height == 0 ||
+            data.width > StaticObstacles::MAX_OBSTACLE_SIZE || data.height > StaticObstacles::MAX_OBSTACLE_SIZE ||
+            right > WorldConstants::WORLD_WIDTH || bottom > WorldConstants::WORLD_HEIGHT) {
+            Utils::printMsg("Dropped invalid obstacle in chunk " + std::to_string(msg.chunkId), warning);
+            continue;
         }
+        StaticObstacles::Obstacle obstacle;
+        obstacle.box = { static_cast<float>(data.left), static_cast<float>(data.top), right, bottom };
+        obstacle.kind = static_cast<StaticObstacles::Kind>(data.kind);
+        chunk.obstacles.push_back(obstacle);
     }
-}
-void NetworkClient::SetOnFirstGameStateCallback(OnFirstGameStateCallback cb) {
-    onFirstGameState = std::move(cb);
+    chunkVersion++;
 }
 
-int64_t NetworkClient::GetLastGameStateTimestamp() const {
-    return lastGameStateTimestamp;
+/**
+ * Prediction and bullets collide with the obstacles of the loaded chunks.
+ * Everything within a tank's reach is streamed well before it gets there,
+ * so the partial set resolves like the server's full map.
+ */
+void NetworkClient::RebuildObstacles() {
+    if (obstacleVersion == chunkVersion) {
+        return;
+    }
+    obstacleVersion = chunkVersion;
+    std::vector<StaticObstacles::Obstacle> visible;
+    for (const auto& entry : loadedChunks) {
+        visible.insert(visible.end(), entry.second.obstacles.begin(), entry.second.obstacles.end());
+    }
+    obstacles.Build(std::move(visible));
 }
-void NetworkClient::HandleGameState(const GameStateMessage& msg) {
-    // Clear current other players
-    otherPlayers.clear();
-    lastGameStateTimestamp = msg.timestamp;
-    if (!interpolationInitialized && onFirstGameState) {
-        onFirstGameState(msg.timestamp);
-        interpolationInitialized = true;
+
+/**
+ * Drops chunks beyond UNLOAD_RADIUS of the tank. The server has forgotten
+ * them a ring earlier, so they are streamed again on the way back.
+ */
+void NetworkClient::UnloadFarChunks() {
+    if (loadedChunks.empty() || !hasServerAuthoritativeState) {
+        return;
     }
-    // Process all players in the game state
-    for (const PlayerData& player : msg.players) {
-        if (localPlayerId == 0) {
-            localPlayerId = player.playerId;
-            Utils::printMsg("Assigned player ID: " + std::to_string(localPlayerId));
+    const WorldChunks::ChunkId center = WorldChunks::ChunkAt(serverAuthoritativePosition);
+    for (auto it = loadedChunks.begin(); it != loadedChunks.end();) {
+        if (WorldChunks::Distance(it->first, center) > WorldChunks::UNLOAD_RADIUS) {
+            it = loadedChunks.erase(it);
+            chunkVersion++;
         }
-
-        if (player.playerId != localPlayerId) {
-            otherPlayers[player.playerId] = player;
+        else {
+            ++it;
         }
     }
-    lastGameStateTimestamp = msg.timestamp;
-    // Record received packet for statistics
-    RecordReceivedPacket(msg.sequenceNumber);
 }
 
-bool NetworkClient::SendJoinRequest(const std::string& playerName, const std::string& preferredColor) {
+/**
+ * Drains the multicast group socket. Datagrams are accepted from the
+ * server's port only, and from its address unless it was reached through
+ * localhost (multicast then leaves from the LAN interface instead).
+ */
+void NetworkClient::ProcessGroupMessages() {
+    if (!groupReceiver.IsJoined()) {
+        return;
+    }
     try {
-        sf::Packet packet;
-
-        JoinMessage joinMsg;
-        joinMsg.playerName = playerName;
-        joinMsg.preferredColor = preferredColor;
-        joinMsg.timestamp = GetCurrentTimestamp();
-        joinMsg.sequenceNumber = outgoingSequenceNumber++;
-
-        packet << static_cast<uint8_t>(joinMsg.type) << joinMsg.playerName << joinMsg.preferredColor
-            << joinMsg.timestamp << joinMsg.sequenceNumber;
-
-        networkStats.totalPacketsSent++;
-
-        sf::Socket::Status sendStatus = socket.send(packet, serverAddress, serverPort);
+        const int MAX_MESSAGES_PER_FRAME = 100;
+        sf::IpAddress sender = sf::IpAddress::Any;
+        unsigned short senderPort = 0;
+        for (int processed = 0; processed < MAX_MESSAGES_PER_FRAME &&
+            groupReceiver.Receive(receiveBuffer, sender, senderPort); ++processed) {
+            if (senderPort != serverPort || (sender != serverAddress && serverAddress != sf::IpAddress::LocalHost)) {
+                continue;
+            }
+            bandwidth.RecordDatagramReceived(receiveBuffer.getDataSize());
+            packetArrivalMicros = GetSteadyMicros();
+            if (capture) {
+                capture->Record(PacketCapture::Direction::RECEIVED, packetArrivalMicros, sender, senderPort, receiveBuffer);
+            }
+            receivingGroupDatagram = true;
+            ProcessPacket(receiveBuffer, sender, senderPort);
+            receivingGroupDatagram = false;
+        }
+    }
+    catch (const std::exception& e) {
+        receivingGroupDatagram = false;
+        Utils::printMsg("Exception in ProcessGroupMessages: " + std::string(e.what()), error);
+        consecutiveErrors++;
+    }
+}
 
-        if (sendStatus == sf::Socket::Status::Done) {
-            Utils::printMsg("Join request sent to server");
-            consecutiveErrors = 0;
-            return true;
+/**
+ * Group counterpart of ProcessStateMessage. Frames are decoded whatever the
+ * delivery mode, so the keyframe is at hand when the switch comes, but only
+ * applied on group delivery.
+ * @param reader Reader positioned just after the StateHeader
+ */
+void NetworkClient::ProcessGroupStateMessage(NetMessageType msgType, BitReader& reader, const StateHeader& stateHeader) {
+    if (msgType == NetMessageType::BULLET_UPDATE) {
+        if (!groupDelivery || (lastGroupBulletSequence != 0 &&
+            !SequenceWindow::IsNewer(stateHeader.sequence, lastGroupBulletSequence))) {
+            return;
         }
-        else if (sendStatus == sf::Socket::Status::NotReady) {
-            Utils::printMsg("Socket not ready for join request", warning);
-            return false;
+        if (HandleBulletUpdate(reader)) {
+            lastGroupBulletSequence = stateHeader.sequence;
         }
         else {
-            Utils::printMsg("Failed to send join request - Status: " +
-                SocketStatusToString(sendStatus), error);
-            consecutiveErrors++;
-            return false;
+            Utils::printMsg("Failed to parse multicast bullet update", warning);
         }
+        return;
     }
-    catch (const std::exception& e) {
-        Utils::printMsg("Exception in SendJoinRequest: " + std::string(e.what()), error);
-        consecutiveErrors++;
-        return false;
+    if (msgType != NetMessageType::GAME_STATE_DELTA || stateHeader.sequence <= latestGroupFrame) {
+        return;
     }
-    catch (...) {
-        Utils::printMsg("Unknown exception in SendJoinRequest", error);
-        consecutiveErrors++;
-        return false;
+
+    TRACE_SCOPE("Decode multicast snapshot", "snapshot");
+    SnapshotHeader header;
+    if (!SnapshotDelta::ReadHeader(reader, stateHeader, header)) {
+        Utils::printMsg("Failed to extract multicast snapshot header", warning);
+        return;
+    }
+    const WorldSnapshot* baseline = nullptr;
+    if (header.baselineSequence != 0) {
+        baseline = groupSnapshots.Find(header.baselineSequence);
+        if (!baseline) {
+            return;     // Keyframe lost; the next one follows within KEYFRAME_INTERVAL frames
+        }
+    }
+    WorldSnapshot& snapshot = groupSnapshots.SlotFor(header.snapshotSequence);
+    if (!SnapshotDelta::ReadBody(reader, header, baseline, snapshot)) {
+        snapshot.sequence = 0;
+        Utils::printMsg("Failed to decode multicast snapshot " + std::to_string(header.snapshotSequence), warning);
+        return;
+    }
+    latestGroupFrame = header.snapshotSequence;
+    if (!groupDelivery) {
+        return;
+    }
+
+    ApplyWorldSnapshot(snapshot);
+    const GroupStateAckMessage& ack = groupAcks[header.snapshotSequence % GROUP_ACK_HISTORY];
+    if (ack.frameSequence == header.snapshotSequence) {
+        awaitingGroupFrame = 0;
+        ProcessGameStateTiming(header.timestamp, header.sequenceNumber, ack.lastAckedInput, ack.inputApplyMicros);
+    }
+    else {
+        // Ack still on its way: keep the previous one and reconcile when it lands
+        ProcessGameStateTiming(header.timestamp, header.sequenceNumber, lastServerAckedSequence, 0);
+        hasUnreconciledServerState = false;
+        awaitingGroupFrame = header.snapshotSequence;
     }
 }
 
+void NetworkClient::LeaveMulticastGroup() {
+    groupReceiver.Leave();
+    groupDelivery = false;
+    groupSnapshots.Clear();
+    latestGroupFrame = 0;
+    lastGroupBulletSequence = 0;
+    awaitingGroupFrame = 0;
+    groupAcks.fill(GroupStateAckMessage());
+    groupReassembler.Clear();
+}
+
 void NetworkClient::CleanupSocketResources() {
     try {
+        if (networkThread) {
+            networkThread->Stop();      // Flushes what is still queued for sending
+            networkThread.reset();
+        }
+        if (loopbackChannel) {
+            loopback->Pump();           // Delivers what is still queued
+            loopback->CloseEndpoint(loopbackPort);
+            loopbackChannel = nullptr;
+        }
+        sharedMemory.Close();
         socket.unbind();
     }
     catch (const std::exception& e) {
@@ -1337,6 +2255,69 @@ std::string NetworkClient::SocketStatusToString(sf::Socket::Status status) const
     }
 }
 
+/**
+ * Every client message goes out as its own datagram, behind the connection
+ * token; both are counted here.
+ */
+sf::Socket::Status NetworkClient::SendToServer(sf::Packet& packet) {
+    bandwidth.RecordMessageSent(packet);
+    outgoingDatagram.clear();
+    outgoingDatagram << connectionToken;
+    outgoingDatagram.append(packet.getData(), packet.getDataSize());
+    return SendDatagram(outgoingDatagram);
+}
+
+bool NetworkClient::StartCapture(const std::string& path) {
+    auto newCapture = std::make_unique<PacketCapture>();
+    if (!newCapture->Open(path, PacketCapture::Side::CLIENT)) {
+        return false;
+    }
+    capture = std::move(newCapture);
+    return true;
+}
+
+/**
+ * With the network thread running the datagram is queued for it to send; on
+ * loopback it is queued and delivered to the server's channel right away.
+ * Through shared memory it is written straight into this client's ring.
+ */
+sf::Socket::Status NetworkClient::SendDatagram(sf::Packet& datagram) {
+    TRACE_SCOPE("Send datagram", "net");
+    bandwidth.RecordDatagramSent(datagram.getDataSize());
+    if (capture) {
+        capture->Record(PacketCapture::Direction::SENT, GetSteadyMicros(), serverAddress, serverPort, datagram);
+    }
+    if (DatagramChannel* channel = GetChannel()) {
+        const bool queued = channel->QueueOutbound(datagram, serverAddress, serverPort);
+        if (loopbackChannel) {
+            loopback->Pump();
+        }
+        return queued ? sf::Socket::Status::Done : sf::Socket::Status::NotReady;
+    }
+    if (sharedMemory.IsOpen()) {
+        return sharedMemory.Send(datagram) ? sf::Socket::Status::Done : sf::Socket::Status::NotReady;
+    }
+    if (conditioner) {
+        return conditioner->Send(socket, datagram, serverAddress, serverPort);
+    }
+    return socket.send(datagram, serverAddress, serverPort);
+}
+
+/**
+ * Prints traffic by message type in each direction since the last call, then
+ * starts a new window.
+ */
+void NetworkClient::PrintBandwidthStats() {
+    const int64_t now = GetCurrentTimestamp();
+    const double elapsedSeconds = static_cast<double>(now - bandwidthWindowStart) / 1000.0;
+    if (elapsedSeconds > 0.0 && isConnected) {
+        Utils::printMsg("Bandwidth out - " + bandwidth.FormatSent(elapsedSeconds), debug);
+        Utils::printMsg("Bandwidth in - " + bandwidth.FormatReceived(elapsedSeconds), debug);
+    }
+    bandwidth.Reset();
+    bandwidthWindowStart = now;
+}
+
 void NetworkClient::DetectPacketLoss() {
     // Calculate packet loss from network statistics
     if (networkStats.totalPacketsSent > NetworkValidation::SEQUENCE_WINDOW_SIZE) {
@@ -1363,6 +2344,23 @@ void NetworkClient::HandleInputAcknowledgment(const InputAcknowledgmentMessage&
         Utils::printMsg("Client received 100 input acks (total: " + std::to_string(acksReceived) + ")", debug);
     }
 
+    if (msg.echoSendMicros > 0) {
+        // Inputs carry their send time wrapped (WirePrecision::ECHO_MICROS_BITS)
+        const int64_t sendMicros = NetworkUtils::Unwrap(static_cast<uint64_t>(msg.echoSendMicros),
+            WirePrecision::ECHO_MICROS_BITS, GetSteadyMicros());
+        AddTimingSample(sendMicros, msg.serverReceiveMicros, msg.serverTransmitMicros);
+    }
+
+    // Inputs the server played as repeats of the one before (bit i: acked - i),
+    // oldest first so a run repeats the same input throughout
+    for (uint32_t bit = 32; msg.concealedBits != 0 && bit-- > 0;) {
+        const uint32_t sequence = msg.acknowledgedSequence - bit;
+        if ((msg.concealedBits >> bit) & 1u && bit < msg.acknowledgedSequence &&
+            prediction->ConcealInput(sequence) && (concealedReplayFrom == 0 || sequence < concealedReplayFrom)) {
+            concealedReplayFrom = sequence;
+        }
+    }
+
     // Acknowledge the input in our buffer
     prediction->AcknowledgeInput(msg.acknowledgedSequence);
 
@@ -1375,28 +2373,62 @@ void NetworkClient::HandleInputAcknowledgment(const InputAcknowledgmentMessage&
     }
 }
 
-void NetworkClient::ReplayInputsAfterCorrection(Tank& localPlayer, uint32_t fromSequence, sf::Vector2f mousePos) {
-    // Get inputs to replay
-    std::vector<InputState> inputsToReplay;
-    prediction->GetInputsToReplay(inputsToReplay);
-
-    if (inputsToReplay.empty()) {
+/**
+ * Acks come at the input rate, far more often than ClockSync's few samples
+ * should turn over (its drift fit wants them spread over seconds), so each
+ * pingInterval contributes only its least delayed sample: the one whose
+ * offset is least skewed by queueing. The very first is used at once.
+ */
+void NetworkClient::AddTimingSample(int64_t clientSendMicros, int64_t serverReceiveMicros, int64_t serverTransmitMicros) {
+    const int64_t arrivalMicros = packetArrivalMicros != 0 ? packetArrivalMicros : GetSteadyMicros();
+    const int64_t roundTripMicros = (arrivalMicros - clientSendMicros) - (serverTransmitMicros - serverReceiveMicros);
+    if (arrivalMicros < clientSendMicros || serverTransmitMicros < serverReceiveMicros ||
+        roundTripMicros < 0 || roundTripMicros > ClockSync::MAX_ROUND_TRIP_US) {
+        return;
+    }
+    consecutiveErrors = 0;
+    lastTimingSampleMicros = arrivalMicros;
+    if (!hasTimingCandidate || roundTripMicros < timingCandidate.roundTripMicros) {
+        timingCandidate = TimingSample{ clientSendMicros, serverReceiveMicros, serverTransmitMicros,
+            arrivalMicros, roundTripMicros };
+        hasTimingCandidate = true;
+    }
+    if (timingWindowStartMicros != 0 &&
+        arrivalMicros - timingWindowStartMicros < static_cast<int64_t>(pingInterval * 1000000.0f)) {
         return;
     }
 
-    Utils::printMsg("Replaying " + std::to_string(inputsToReplay.size()) +
-        " inputs after correction", debug);
+    const int64_t acceptedMicros = clockSync.AddPingSample(timingCandidate.clientSendMicros,
+        timingCandidate.serverReceiveMicros, timingCandidate.serverTransmitMicros, timingCandidate.clientReceiveMicros);
+    if (acceptedMicros >= 0) {
+        UpdateNetworkStatistics(static_cast<float>(acceptedMicros) / 1000.0f);
+    }
+    hasTimingCandidate = false;
+    timingWindowStartMicros = arrivalMicros;
+}
 
-    // Replay each input in order
-    for (const auto& input : inputsToReplay) {
+/**
+ * Re-applies the inputs after the acked one, oldest first, recording the
+ * corrected prediction for each so later checks compare against it.
+ * @return Number of inputs replayed
+ */
+size_t NetworkClient::ReplayInputsAfterCorrection(Tank& localPlayer, uint32_t ackedSequence, sf::Vector2f mousePos) {
+    size_t replayed = 0;
+    prediction->ForEachInputAfter(ackedSequence, [&](const InputState& input) {
         ApplyInputToTank(localPlayer, input, mousePos);
-    }
+        prediction->StorePredictedState(PredictedState(input.sequenceNumber, input.timestamp,
+            localPlayer.position, localPlayer.bodyRotation, localPlayer.barrelRotation));
+        replayed++;
+    });
 
-    // Clear replay flags
-    prediction->ClearReplayFlags();
+    if (replayed > 0) {
+        Utils::printMsg("Replaying " + std::to_string(replayed) +
+            " inputs after correction", debug);
+    }
 
     // Update sprites after replay
     localPlayer.UpdateSprites();
+    return replayed;
 }
 
 void NetworkClient::ProcessInputBuffer(float deltaTime) {
@@ -1409,7 +2441,6 @@ void NetworkClient::ProcessInputBuffer(float deltaTime) {
     prediction->CleanupTimedOutInputs();
 
     // Optional: Log buffer stats periodically for debugging
-    static float statsTimer = 0;
     statsTimer += deltaTime;
     if (statsTimer >= 5.0f) {  // Every 5 seconds
         auto stats = prediction->GetBufferStats();
@@ -1421,6 +2452,7 @@ void NetworkClient::ProcessInputBuffer(float deltaTime) {
             " need replay, avg time: " +
             std::to_string(stats.averageBufferTime) + "ms | RTT: " +
             std::to_string(currentRTT) + "ms", debug);
+        PrintBandwidthStats();
 
         // Diagnostic: buffer time should be close to RTT (only check if buffer has items)
         if (stats.totalBuffered > 0 && stats.averageBufferTime > currentRTT * 3.0f) {
@@ -1432,46 +2464,42 @@ void NetworkClient::ProcessInputBuffer(float deltaTime) {
         statsTimer = 0;
     }
 }
-void NetworkClient::SendBulletSpawn(const Tank& localPlayer) {
+uint16_t NetworkClient::SendBulletSpawn(const Tank& localPlayer) {
+    // Spawn at the barrel end
+    return SendBulletSpawn(localPlayer.GetBarrelEndPosition(), localPlayer.barrelRotation.asDegrees());
+}
+
+uint16_t NetworkClient::SendBulletSpawn(sf::Vector2f spawnPos, float barrelRotation) {
     if (!isConnected || localPlayerId == 0) {
-        return;
+        return 0;
     }
 
     try {
-        sf::Packet packet;
+        PacketPool::Lease packet = sendPackets.Borrow();
         BulletSpawnMessage spawnMsg;
         spawnMsg.type = NetMessageType::BULLET_SPAWN;
         spawnMsg.playerId = localPlayerId;
-
-        // Get spawn position (barrel end)
-        sf::Vector2f spawnPos = localPlayer.GetBarrelEndPosition();
         spawnMsg.spawnX = spawnPos.x;
         spawnMsg.spawnY = spawnPos.y;
 
         // Calculate direction from barrel rotation
-        float barrelRad = localPlayer.barrelRotation.asDegrees() * 3.14159f / 180.0f;
+        float barrelRad = barrelRotation * 3.14159f / 180.0f;
         spawnMsg.directionX = std::cos(barrelRad);
         spawnMsg.directionY = std::sin(barrelRad);
 
-        spawnMsg.barrelRotation = localPlayer.barrelRotation.asDegrees();
-        spawnMsg.timestamp = GetCurrentTimestamp();
+        spawnMsg.barrelRotation = barrelRotation;
+        spawnMsg.timestamp = GetServerTime();
         spawnMsg.sequenceNumber = outgoingSequenceNumber++;
+        spawnMsg.spawnToken = nextSpawnToken;
+        nextSpawnToken = nextSpawnToken == std::numeric_limits<uint16_t>::max() ? 1 : nextSpawnToken + 1;
 
         // Serialize
-        packet << static_cast<uint8_t>(spawnMsg.type)
-            << spawnMsg.playerId
-            << spawnMsg.spawnX
-            << spawnMsg.spawnY
-            << spawnMsg.directionX
-            << spawnMsg.directionY
-            << spawnMsg.barrelRotation
-            << spawnMsg.timestamp
-            << spawnMsg.sequenceNumber;
+        *packet << spawnMsg;
 
         networkStats.totalPacketsSent++;
 
         // Send to server
-        sf::Socket::Status sendStatus = socket.send(packet, serverAddress, serverPort);
+        sf::Socket::Status sendStatus = SendToServer(*packet);
 
         if (sendStatus == sf::Socket::Status::Done) {
             Utils::printMsg("Sent bullet spawn request (seq: " +
@@ -1483,35 +2511,212 @@ void NetworkClient::SendBulletSpawn(const Tank& localPlayer) {
                 SocketStatusToString(sendStatus), warning);
             consecutiveErrors++;
         }
+        return spawnMsg.spawnToken;
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in SendBulletSpawn: " + std::string(e.what()), error);
         consecutiveErrors++;
+        return 0;
+    }
+}
+
+/**
+ * Counts each bullet of ours the first time the server sends it. Server
+ * bullet IDs only grow, so the newest ID seen is enough to skip repeats.
+ */
+void NetworkClient::CountOwnBullet(const BulletData& bullet) {
+    if (bullet.ownerId == localPlayerId && bullet.bulletId > newestOwnBulletId) {
+        newestOwnBulletId = bullet.bulletId;
+        confirmedBulletCount++;
+    }
+}
+
+/**
+ * Records a bullet change for TakeBulletChanges. A full list just switches the
+ * consumer to a resync, so an endpoint that never drains (bots) stays bounded.
+ */
+void NetworkClient::MarkBulletChanged(uint32_t bulletId) {
+    if (bulletResyncNeeded) {
+        return;
+    }
+    if (changedBulletIds.size() >= MAX_PENDING_BULLET_CHANGES) {
+        changedBulletIds.clear();
+        removedBulletIds.clear();
+        bulletResyncNeeded = true;
+        return;
+    }
+    changedBulletIds.push_back(bulletId);
+}
+
+void NetworkClient::MarkBulletRemoved(uint32_t bulletId) {
+    if (bulletResyncNeeded) {
+        return;
+    }
+    if (removedBulletIds.size() >= MAX_PENDING_BULLET_CHANGES) {
+        changedBulletIds.clear();
+        removedBulletIds.clear();
+        bulletResyncNeeded = true;
+        return;
     }
+    removedBulletIds.push_back(bulletId);
+}
+
+bool NetworkClient::TakeBulletChanges(std::vector<uint32_t>& changed, std::vector<uint32_t>& removed) {
+    changed.clear();
+    removed.clear();
+    changed.swap(changedBulletIds);
+    removed.swap(removedBulletIds);
+    const bool resync = bulletResyncNeeded;
+    bulletResyncNeeded = false;
+    return resync;
 }
 
 /**
- * Handles bullet update from server
+ * Handles bullet update from server: the full list of bullets in view, decoded
+ * straight into bulletData. Listed bullets are corrected in place and any
+ * tracked bullet missing from the list is dropped, so only those two sets are
+ * reported as changes.
+ * @param reader Reader positioned just after the StateHeader
+ * @return False if the body was truncated or malformed (bullets decoded so far are kept)
  */
-void NetworkClient::HandleBulletUpdate(const BulletUpdateMessage& msg) {
+bool NetworkClient::HandleBulletUpdate(BitReader& reader) {
     try {
-        // Clear existing bullets
-        bulletData.clear();
+        const uint32_t bulletCount = reader.ReadVarUint();
+        if (!reader.IsValid() || bulletCount > NetworkValidation::MAX_BULLETS_PER_UPDATE) {
+            return false;
+        }
+        bulletIdScratch.clear();
+        BulletData bullet;
+        for (uint32_t i = 0; i < bulletCount; ++i) {
+            if (!NetworkUtils::Read(reader, bullet)) {
+                return false;
+            }
+            bulletData.Set(bullet);
+            bulletIdScratch.push_back(bullet.bulletId);
+            MarkBulletChanged(bullet.bulletId);
+            CountOwnBullet(bullet);
+        }
 
-        // Update with new bullet data
-        for (const auto& bullet : msg.bullets) {
-            bulletData[bullet.bulletId] = bullet;
+        // Bullets the server no longer lists
+        std::sort(bulletIdScratch.begin(), bulletIdScratch.end());
+        for (size_t index = bulletData.GetSize(); index-- > 0;) {
+            const uint32_t bulletId = bulletData.GetIdAt(index);
+            if (!std::binary_search(bulletIdScratch.begin(), bulletIdScratch.end(), bulletId)) {
+                MarkBulletRemoved(bulletId);
+                bulletData.RemoveAt(index);
+            }
         }
 
         // Debug log periodically
         static int updateCounter = 0;
         if (++updateCounter % 30 == 0) {
             Utils::printMsg("Client received bullet update: " +
-                std::to_string(bulletData.size()) + " bullets", debug);
+                std::to_string(bulletData.GetSize()) + " bullets", debug);
         }
+        return true;
     }
     catch (const std::exception& e) {
         Utils::printMsg("Exception in HandleBulletUpdate: " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+/**
+ * Adds bullets that entered this client's view. They are server state from
+ * when the message was sent, so each is moved forward by the one-way latency
+ * estimate before UpdateBullets takes over. Other tanks' freshly fired
+ * bullets queue a muzzle flash (and its sound) where they left the barrel;
+ * the local player's shots have theirs already.
+ * @param reader Reader positioned just after the StateHeader
+ * @return False if the body was truncated or malformed
+ */
+bool NetworkClient::HandleBulletSpawned(BitReader& reader) {
+    const float MAX_CATCH_UP_SECONDS = 0.25f;
+    const float catchUp = std::clamp(networkStats.averageLatency / 1000.0f, 0.0f, MAX_CATCH_UP_SECONDS);
+
+    const uint32_t bulletCount = reader.ReadVarUint();
+    if (!reader.IsValid() || bulletCount > NetworkValidation::MAX_BULLETS_PER_UPDATE) {
+        return false;
+    }
+    const int64_t freshSince = GetServerTime() - static_cast<int64_t>(networkStats.averageLatency) - FRESH_SHOT_MS;
+    BulletData bullet;
+    for (uint32_t i = 0; i < bulletCount; ++i) {
+        if (!NetworkUtils::Read(reader, bullet)) {
+            return false;
+        }
+        if (bullet.ownerId != localPlayerId && bullet.spawnTime >= freshSince) {
+            QueueEffectEvent(EffectKind::MUZZLE_FLASH, sf::Vector2f(bullet.x, bullet.y),
+                sf::radians(std::atan2(bullet.velocityY, bullet.velocityX)));
+        }
+        bulletData.AdvanceAt(bulletData.Set(bullet), catchUp);
+        CountOwnBullet(bullet);
+        MarkBulletChanged(bullet.bulletId);
+    }
+    return true;
+}
+
+/**
+ * Moves server bullets along their straight-line path between server messages,
+ * all in one BulletTable kernel pass. Bullets are removed on BULLET_DESTROY;
+ * running out of lifetime or reaching an obstacle only drops them early if
+ * that message is still on its way. The walk goes from the back, so each
+ * swap-and-pop fills the freed index with a bullet already checked.
+ */
+void NetworkClient::UpdateBullets(float deltaTime) {
+    bulletData.Integrate(deltaTime, expiredBulletMask);
+    const bool checkObstacles = !obstacles.IsEmpty();
+    for (size_t index = bulletData.GetSize(); index-- > 0;) {
+        if (expiredBulletMask[index] != 0 ||
+            (checkObstacles && obstacles.OverlapsCircle(bulletData.GetPositionAt(index), 0.0f))) {
+            MarkBulletRemoved(bulletData.GetIdAt(index));
+            bulletData.RemoveAt(index);
+        }
+    }
+}
+
+/**
+ * Handles area-of-interest changes: entities that left are dropped immediately
+ * instead of waiting for the next snapshot or bullet update.
+ */
+void NetworkClient::HandleInterestUpdate(const InterestUpdateMessage& msg) {
+    for (uint32_t id : msg.leftIds) {
+        if (id >= 10000) {
+            if (bulletData.Remove(id)) {        // Bullet IDs start at 10000
+                MarkBulletRemoved(id);
+            }
+        }
+        else if (id >= 1000) {
+            enemyData.erase(id);        // Enemy IDs start at 1000
+        }
+    }
+
+    static int updateCounter = 0;
+    if (++updateCounter % 100 == 0) {
+        Utils::printMsg("Interest update: " + std::to_string(msg.enteredIds.size()) + " entered, " +
+            std::to_string(msg.leftIds.size()) + " left", debug);
+    }
+}
+
+/**
+ * Death effects play for every player; the local player is also told.
+ */
+void NetworkClient::HandlePlayerDeath(const PlayerDeathMessage& msg) {
+    QueueEffectEvent(EffectKind::TANK_EXPLOSION, sf::Vector2f(msg.deathX, msg.deathY));
+    Utils::printMsg(" DEATH MESSAGE: Player " + std::to_string(msg.playerId) +
+        " died | Penalty: " + std::to_string(msg.scorePenalty) + " points");
+
+    if (msg.playerId == localPlayerId) {
+        Utils::printMsg("YOU DIED! You will respawn in 5 seconds...", warning);
+    }
+}
+
+void NetworkClient::HandlePlayerRespawn(const PlayerRespawnMessage& msg) {
+    Utils::printMsg("RESPAWN MESSAGE: Player " + std::to_string(msg.playerId) +
+        " respawned at (" + std::to_string(msg.spawnX) + ", " +
+        std::to_string(msg.spawnY) + ")", success);
+
+    if (msg.playerId == localPlayerId) {
+        Utils::printMsg("YOU RESPAWNED! Back in action!", success);
     }
 }
 
@@ -1521,9 +2726,11 @@ void NetworkClient::HandleBulletUpdate(const BulletUpdateMessage& msg) {
 void NetworkClient::HandleBulletDestroy(const BulletDestroyMessage& msg) {
     try {
         // Remove bullet from tracked bullets
-        auto it = bulletData.find(msg.bulletId);
-        if (it != bulletData.end()) {
-            bulletData.erase(it);
+        if (bulletData.Remove(msg.bulletId)) {
+            MarkBulletRemoved(msg.bulletId);
+        }
+        if (msg.destroyReason != 0) {   // Expired bullets just vanish
+            QueueEffectEvent(EffectKind::BULLET_IMPACT, sf::Vector2f(msg.hitX, msg.hitY));
         }
 
         // Log destruction
@@ -1533,6 +2740,7 @@ void NetworkClient::HandleBulletDestroy(const BulletDestroyMessage& msg) {
         case 1: reasonStr = "Hit Player"; break;
         case 2: reasonStr = "Hit Enemy"; break;
         case 3: reasonStr = "Hit Border"; break;
+        case 4: reasonStr = "Hit Obstacle"; break;
         default: reasonStr = "Unknown"; break;
         }
 
@@ -1,23 +1,50 @@
-#pragma once
+﻿#pragma once
 #include <SFML/Network.hpp>
 #include <string>
 #include <unordered_map>
 #include <queue>
 #include <deque>
+#include <array>
+#include "bullet_table.h"
 #include "network_messages.h"
+#include "network_validation.h"
 #include "Tank.h"
 #include "client_prediction.h"
 #include <memory>
 #include "multiplayer_game.h"
 #include <functional>
 #include "Bullet.h"  
+#include "snapshot_delta.h"
+#include "packet_aggregator.h"
+#include "fragment_reassembler.h"
+#include "packet_compression.h"
+#include "packet_pool.h"
+#include "connection_token.h"
+#include "reliable_channel.h"
+#include "sequence_window.h"
+#include "bandwidth_stats.h"
+#include "network_conditioner.h"
+#include "network_io_thread.h"
+#include "loopback_network.h"
+#include "shared_memory_transport.h"
+#include "spectator_stream.h"
+#include "client_telemetry.h"
+#include "lan_multicast.h"
+#include "packet_capture.h"
+#include "particle_system.h"
+#include "clock_sync.h"
+#include "input_latency.h"
+#include "memory_report.h"
+#include "world_chunks.h"
 
 class MultiplayerGame;
 
-// Structure to track sent packets for RTT calculation 
-struct SentPacket {
-    uint32_t sequenceNumber;
-    int64_t sentTime;
+// How SendPlayerInput (the unpredicted input path) paces its messages. The
+// predicted path sends one input per prediction step in either mode, since
+// reconciliation matches the server's acks to those steps.
+enum class InputSendMode : uint8_t {
+    FIXED_RATE,     // One message every updateRate seconds
+    ON_CHANGE       // At once when the keys or the barrel change, else a keep-alive
 };
 
 class NetworkClient {
@@ -29,18 +56,32 @@ public:
     int64_t GetLastGameStateTimestamp() const;
 
     // Connection management
+    // roomId selects the world on a multi-room server (ignored by single-room servers).
+    // Returns once the endpoint is open and the first connection request is out;
+    // the handshake then runs in Update (IsJoining until the server assigns an ID)
     bool Connect(const std::string& serverIP, unsigned short serverPort,
-        const std::string& playerName, const std::string& preferredColor = "");
+        const std::string& playerName, const std::string& preferredColor = "", uint16_t roomId = 0);
     void Disconnect();
     bool IsConnected() const { return isConnected; }
+    bool IsJoining() const { return isConnected && localPlayerId == 0 && !spectating; }
 
     // Network communication
     void Update(float deltaTime);
     void SendPlayerUpdate(const Tank& localPlayer);  // Full update (kept for compatibility)
     void SendPlayerInput(const Tank& localPlayer);    // Lightweight input-only update
+    void SendPlayerInput(const InputState& input, float barrelRotation);  // Same, without a Tank
+    // ON_CHANGE: the server holds the last input it received, so an idle tank
+    // costs one keep-alive every INPUT_KEEPALIVE_SECONDS; each message repeats
+    // the unacked recent inputs, so a lost key change is recovered by the next one
+    void SetInputSendMode(InputSendMode mode) { inputSendMode = mode; }
+    InputSendMode GetInputSendMode() const { return inputSendMode; }
+    static constexpr float INPUT_KEEPALIVE_SECONDS = 0.25f;
+    static constexpr float INPUT_BARREL_THRESHOLD_DEGREES = 1.0f;   // Smaller barrel moves wait for the keep-alive
 
     // Game state access
     const std::unordered_map<uint32_t, PlayerData>& GetOtherPlayers() const { return otherPlayers; }
+    // Name from the join-time player table (empty until the table arrives)
+    const std::string& GetPlayerName(uint32_t playerId) const;
     uint32_t GetLocalPlayerId() const { return localPlayerId; }
 
     // Step 1.1: Network statistics access
@@ -48,6 +89,10 @@ public:
     float GetAverageRTT() const { return networkStats.averageRTT; }
     float GetPacketLoss() const { return networkStats.packetLoss; }
     float GetJitter() const { return networkStats.jitter; }
+    // Traffic by message type in the current stats window (printed every 5 seconds)
+    const BandwidthStats& GetBandwidthStats() const { return bandwidth; }
+    // Replicated state, snapshot baselines, sequence tracking, prediction and send packets
+    void ReportMemory(MemoryReport& report) const;
 
     // Step 1.2: Error monitoring
     int GetConsecutiveErrors() const { return consecutiveErrors; }
@@ -56,7 +101,35 @@ public:
     // Client-side prediction - NEW: Support mouse position for barrel rotation
     void ApplyLocalInputWithPrediction(Tank& localPlayer, float deltaTime, sf::Vector2f mousePos);
     void SetPredictionEnabled(bool enabled) { predictionEnabled = enabled; }
+
+    // Simulated latency/jitter/loss/duplication/reordering on this client's
+    // socket (set before Connect; inactive conditions turn it off)
+    void SetNetworkConditions(const NetworkConditions& conditions) { networkConditions = conditions; }
+    const NetworkConditioner* GetNetworkConditioner() const { return conditioner.get(); }
+    // Socket receive/send on a background thread that stamps each datagram's
+    // arrival, so a slow frame no longer delays it or skews RTT (set before
+    // Connect; network conditions keep the socket on the game thread)
+    void SetNetworkThreadEnabled(bool enabled) { useNetworkThread = enabled; }
+    bool IsNetworkThreadRunning() const { return networkThread != nullptr; }
+    // Talk to a server in this process through network instead of a socket
+    // (set before Connect, which then ignores the server address; nullptr = socket)
+    void SetLoopback(LoopbackNetwork* network) { loopback = network; }
+    bool IsLoopback() const { return loopbackChannel != nullptr; }
+    // Talk to a server on this machine started with --shared-memory: Connect
+    // maps the region for its port instead of binding a socket (set before Connect)
+    void SetSharedMemoryEnabled(bool enabled) { useSharedMemory = enabled; }
+    bool IsSharedMemory() const { return sharedMemory.IsOpen(); }
+    // Watch the room's delayed spectator stream (see SpectatorStream) instead
+    // of joining: every player lands in GetOtherPlayers, and nothing but the
+    // subscription is ever sent. Works the same against a SpectatorRelay (set before Connect)
+    void SetSpectating(bool enabled) { spectating = enabled; }
+    bool IsSpectating() const { return spectating; }
     bool IsPredictionEnabled() const { return predictionEnabled; }
+    // The server's simulation rate from JOIN_ACCEPT, 0 until then (and from
+    // servers that do not send it, which tick at TickScheduler::DEFAULT_TICK_RATE)
+    unsigned int GetServerTickRate() const { return serverTickRate; }
+    // Writes every datagram sent and received to path (see packet_capture.h)
+    bool StartCapture(const std::string& path);
 
     // Get prediction stats (for debugging)
     size_t GetPredictionHistorySize() const {
@@ -73,7 +146,16 @@ public:
     void ClearServerAuthoritativeState() { hasServerAuthoritativeState = false; }
     sf::Vector2f GetServerAuthoritativePosition() const { return serverAuthoritativePosition; }
     float GetServerAuthoritativeBodyRotation() const { return serverAuthoritativeBodyRotation; }
-    void ApplyServerReconciliation(Tank& localPlayer);
+    void ApplyServerReconciliation(Tank& localPlayer, float deltaTime);
+    // Visual offset still hiding recent corrections; add to the drawn pose
+    sf::Vector2f GetCorrectionOffset() const { return correctionOffset; }
+    sf::Angle GetCorrectionRotationOffset() const { return correctionRotationOffset; }
+    // Share of server states that disagreed with the stored prediction
+    float GetMispredictionRate() const;
+    uint64_t GetMispredictionCount() const { return mispredictions; }
+    // Quality telemetry the client reports every ClientTelemetry::WINDOW_MS;
+    // the game feeds it frames, the client RTT, loss and reconciliations
+    ClientTelemetry& GetTelemetry() { return telemetry; }
 
     // Input buffering system access
     size_t GetUnacknowledgedInputCount() const {
@@ -84,20 +166,138 @@ public:
     }
     uint32_t GetLastAcknowledgedInputSeq() const { return lastAcknowledgedInputSeq; }
 
+    // Server clock as estimated from ping/pong and snapshot timestamps (ms).
+    // Interpolation, input and spawn timestamps all use this timeline
+    int64_t GetServerTime() const { return clockSync.GetServerTimeMs(); }
+    int64_t ToServerTime(int64_t localMicros) const { return clockSync.ToServerMicros(localMicros) / 1000; }
+    const ClockSync& GetClockSync() const { return clockSync; }
+    // Local steady time (us) the newest world state was received
+    int64_t GetLastWorldStateArrival() const { return lastWorldStateArrivalMicros; }
+
+    // Input latency from sampling to the server's apply tick, the snapshot
+    // acking it and the first frame presented after that (see input_latency.h)
+    const InputLatencyTracker& GetInputLatency() const { return inputLatency; }
+    InputLatencyTracker& GetInputLatency() { return inputLatency; }
+    void OnFramePresented(int64_t presentMicros) { inputLatency.OnFramePresented(presentMicros); }
+
     // Get server timestamp from last received game state
     int64_t GetLastServerTimestamp() const { return lastServerTimestamp; }
     bool HasServerTimestamp() const { return lastServerTimestamp > 0; }
+    // Bumped whenever a newer world state (players and enemies) has been applied
+    uint32_t GetWorldStateVersion() const { return worldStateVersion; }
     const std::unordered_map<uint32_t, EnemyData>& GetEnemies() const { return enemyData; }
-    void SendBulletSpawn(const Tank& localPlayer);
-    const std::unordered_map<uint32_t, BulletData>& GetBullets() const { return bulletData; }
+    // @return The spawn token the server bullet will carry (BulletData::spawnToken); 0 if nothing was sent
+    uint16_t SendBulletSpawn(const Tank& localPlayer);
+    uint16_t SendBulletSpawn(sf::Vector2f spawnPos, float barrelRotation);
+    // Own bullets the server has replicated back since Connect (accepted spawn requests)
+    uint32_t GetConfirmedBulletCount() const { return confirmedBulletCount; }
+    const BulletTable& GetBullets() const { return bulletData; }
+    // Server bullet IDs added or corrected, and removed, since the last call.
+    // Both vectors are cleared and swapped with the client's lists. Returns true
+    // when the lists overflowed and the caller must resync from GetBullets.
+    bool TakeBulletChanges(std::vector<uint32_t>& changed, std::vector<uint32_t>& removed);
+    // Streamed static chunk content (tile kinds, see world_chunks.h, and the
+    // obstacles centred in the chunk); the version is bumped whenever a chunk
+    // is loaded or unloaded
+    struct LoadedChunk {
+        std::vector<uint8_t> tiles;
+        std::vector<StaticObstacles::Obstacle> obstacles;
+    };
+    const std::unordered_map<WorldChunks::ChunkId, LoadedChunk>& GetLoadedChunks() const { return loadedChunks; }
+    uint32_t GetChunkVersion() const { return chunkVersion; }
+    // Obstacles of every loaded chunk, rebuilt in Update when chunks change
+    const StaticObstacles& GetObstacles() const { return obstacles; }
     float GetServerAuthoritativeHealth() const { return serverAuthoritativeHealth; }
     float GetServerAuthoritativeMaxHealth() const { return serverAuthoritativeMaxHealth; }
     int32_t GetServerAuthoritativeScore() const { return serverAuthoritativeScore; }
     bool GetServerAuthoritativeIsDead() const { return serverAuthoritativeIsDead; }
+    // Impacts and deaths received since the last call, for the particle system.
+    // out is cleared and swapped with the queue, so both keep their capacity.
+    void TakeEffectEvents(std::vector<EffectEvent>& out) {
+        out.clear();
+        out.swap(effectEvents);
+    }
 private:
+    // Queue bound, so an endpoint that never drains it (bots) stays flat
+    static constexpr size_t MAX_QUEUED_EFFECT_EVENTS = 256;
+    std::vector<EffectEvent> effectEvents;
+    std::unordered_map<WorldChunks::ChunkId, LoadedChunk> loadedChunks;
+    uint32_t chunkVersion = 0;
+    StaticObstacles obstacles;
+    uint32_t obstacleVersion = 0;       // chunkVersion the obstacles were built from
+    void RebuildObstacles();
+    void QueueEffectEvent(EffectKind kind, sf::Vector2f position, sf::Angle angle = sf::Angle::Zero);
+    // A BULLET_SPAWNED bullet this much older than the latency entered the
+    // view in flight rather than being fired: no muzzle flash for it
+    static constexpr int64_t FRESH_SHOT_MS = 150;
+    // Bullet change lists, drained by TakeBulletChanges; bounded like effectEvents
+    static constexpr size_t MAX_PENDING_BULLET_CHANGES = 4096;
+    std::vector<uint32_t> changedBulletIds;
+    std::vector<uint32_t> removedBulletIds;
+    std::vector<uint32_t> bulletIdScratch;          // Sorted IDs of the last BULLET_UPDATE
+    bool bulletResyncNeeded;
+    void MarkBulletChanged(uint32_t bulletId);
+    void MarkBulletRemoved(uint32_t bulletId);
     sf::UdpSocket socket;
     sf::IpAddress serverAddress;
     unsigned short serverPort;
+    uint16_t roomId;
+
+    // Handshake (see ConnectionTokens): until an ID is assigned, a fresh
+    // connection request goes out on a backoff timer, starting at
+    // HANDSHAKE_RETRY_MIN_MS and doubling up to HANDSHAKE_RETRY_MAX_MS, and each
+    // challenge is answered with the join
+    uint64_t connectionToken;                      // Prefixed to every datagram, 0 until challenged
+    std::string joinPlayerName;
+    std::string joinPreferredColor;
+    int64_t lastHandshakeSendMs;
+    int64_t handshakeRetryMs = HANDSHAKE_RETRY_MIN_MS;  // Wait before the next request
+    int64_t handshakeStartMs = 0;                  // First request of this handshake
+    uint32_t handshakeAttempts = 0;                // Requests sent in this handshake
+    uint16_t serverTickRate = 0;                   // From JOIN_ACCEPT, see GetServerTickRate
+    sf::Packet outgoingDatagram;                   // Token + message, reused
+    PacketPool sendPackets;                        // Buffers for building outgoing messages
+    static constexpr int64_t HANDSHAKE_RETRY_MIN_MS = 50;
+    static constexpr int64_t HANDSHAKE_RETRY_MAX_MS = 800;
+    static constexpr uint32_t HANDSHAKE_WARN_ATTEMPTS = 8;     // Logged once, about 3 s in
+    void StartHandshake();
+    // Resends the connection request when the backoff timer has run out
+    void RetryHandshake();
+    // Spectating: the subscription is refreshed every SpectatorStream::REFRESH_MS,
+    // and the handshake starts over once no stream has arrived for a timeout
+    bool spectating = false;
+    int64_t lastSpectateSendMs = 0;
+    // Session resume: once a joined client has had no world state for
+    // SESSION_SILENCE_MS it sends SESSION_RESUME on the handshake's backoff
+    // until state flows again. A challenge in answer means the server no
+    // longer knows the session, and the client connects again from scratch.
+    static constexpr int64_t SESSION_SILENCE_MS = 1000;
+    int64_t resumeStartMs = 0;                     // First resume request of this silence (0 = not resuming)
+    int64_t lastResumeSendMs = 0;
+    int64_t resumeRetryMs = HANDSHAKE_RETRY_MIN_MS;
+    unsigned short connectPort = 0;                // As passed to Connect, for reconnecting
+    bool reconnectRequested = false;               // Session expired; Update connects again
+    void UpdateSession();
+
+    // LAN multicast (see LanMulticast): frames from the group are decoded into
+    // their own history, since their sequences are the group stream's, and
+    // applied only once the server delivers to this client through the group
+    // (the first GROUP_STATE_ACK). Any unicast snapshot means it fell back.
+    // Each frame's input ack comes by unicast and may arrive on either side
+    // of the frame, so recent ones are kept by frame sequence
+    MulticastReceiver groupReceiver;
+    bool groupDelivery = false;
+    bool receivingGroupDatagram = false;            // ProcessPacket is handling a group datagram
+    SnapshotHistory groupSnapshots;
+    uint32_t latestGroupFrame = 0;
+    uint32_t lastGroupBulletSequence = 0;
+    uint32_t awaitingGroupFrame = 0;                // Applied frame whose ack has not arrived yet
+    static constexpr size_t GROUP_ACK_HISTORY = 8;
+    std::array<GroupStateAckMessage, GROUP_ACK_HISTORY> groupAcks{};
+    int64_t lastMulticastStatusMs = 0;
+    FragmentReassembler groupReassembler;
+    ClientTelemetry telemetry;
+    ClientTelemetryMessage telemetryWindow;
     bool isConnected;
     std::unordered_map<uint32_t, EnemyData> enemyData;
     float serverAuthoritativeHealth;
@@ -107,36 +307,120 @@ private:
     // Player management
     uint32_t localPlayerId;
     std::unordered_map<uint32_t, PlayerData> otherPlayers;
-    std::unordered_map<uint32_t, BulletData> bulletData;  // Bullets from server
-    void HandleBulletUpdate(const BulletUpdateMessage& msg);
+    // Scratch for HandleGameState: IDs the message listed
+    std::vector<uint32_t> listedPlayerIds;
+    std::vector<uint32_t> listedEnemyIds;
+    BulletTable bulletData;                 // Bullets from server
+    std::vector<uint8_t> expiredBulletMask; // Scratch for UpdateBullets
+
+    // Delta snapshots: decoded snapshots kept as baselines, newest one is acked in inputs
+    SnapshotHistory receivedSnapshots;
+    uint32_t latestSnapshotSequence;
+    // A snapshot that fails its state hash asks for a full one (StateResyncMessage)
+    static constexpr int64_t STATE_RESYNC_RETRY_MS = 200;
+    int64_t lastStateResyncMs = 0;
+    void RequestStateResync(uint32_t snapshotSequence);
+
+    // Player table (names/colors) received once per join; version is acked in inputs
+    std::unordered_map<uint32_t, PlayerInfo> playerTable;
+    uint32_t playerTableVersion;
+    void HandlePlayerList(PlayerListMessage& msg);
+    bool IsStaleState(NetMessageType msgType, const StateHeader& header) const;
+    bool HandleBulletUpdate(BitReader& reader);
+    bool HandleBulletSpawned(BitReader& reader);
+    void UpdateBullets(float deltaTime);
     void HandleBulletDestroy(const BulletDestroyMessage& msg);
+    void HandleInterestUpdate(const InterestUpdateMessage& msg);
+    void HandlePlayerDeath(const PlayerDeathMessage& msg);
+    void HandlePlayerRespawn(const PlayerRespawnMessage& msg);
 
     // Timing
     float updateRate; // How often to send updates to server
     float updateTimer;
+    // Change-driven input (InputSendMode::ON_CHANGE): the last input sent and
+    // the recent ones, newest last, repeated until the server acks them
+    InputSendMode inputSendMode = InputSendMode::FIXED_RATE;
+    bool hasSentInput = false;
+    RedundantInput lastSentInput;
+    float lastSentBarrel = 0.0f;
+    std::array<RedundantInput, NetworkValidation::MAX_REDUNDANT_INPUTS> recentInputs{};
+    size_t recentInputCount = 0;
+    bool IsInputSendDue(const InputState& input, float barrelRotation) const;
+    float statsTimer;    // Buffer and bandwidth stats, printed every 5 seconds
     OnFirstGameStateCallback onFirstGameState;
     bool interpolationInitialized = false;
     int64_t lastGameStateTimestamp = 0;
 
     // Sequence number tracking
     uint32_t outgoingSequenceNumber;
-    uint32_t lastReceivedSequenceNumber;
+    BitWriter messageWriter;  // Reused body buffer for bit-packed messages
+    uint32_t lastBulletUpdateSequence;  // Newest BULLET_UPDATE applied (0 = none)
+    uint32_t lastBulletSpawnSequence;   // Newest BULLET_SPAWNED applied (0 = none)
+    FragmentReassembler fragmentReassembler;       // Large server messages split by PacketAggregator
+    sf::Packet reassembledMessage;
+    sf::Packet receiveBuffer;                      // Socket receive target, reused every frame
+    bool useNetworkThread;
+    std::unique_ptr<NetworkIOThread> networkThread;
+    LoopbackNetwork* loopback = nullptr;
+    DatagramChannel* loopbackChannel = nullptr;    // This client's endpoint while connected through loopback
+    unsigned short loopbackPort = 0;
+    bool useSharedMemory = false;
+    SharedMemoryClient sharedMemory;               // Open while connected through shared memory
+    // Where datagrams are exchanged when this thread does not own a socket
+    // (network thread or loopback), nullptr otherwise
+    DatagramChannel* GetChannel() {
+        return loopbackChannel ? loopbackChannel : networkThread ? &networkThread->GetChannel() : nullptr;
+    }
+    QueuedDatagram queuedDatagram;                 // Network thread handoff, swapped back for reuse
+    int64_t packetArrivalMicros;                   // Arrival of the datagram being processed
+    sf::Packet bundledMessage;                     // Current message while splitting a MESSAGE_BUNDLE
+    PacketCompressor decompressor;                 // Same preset dictionary as the server's
+    sf::Packet decompressedMessage;
+
+    // Reliable gameplay events: acked on PLAYER_INPUT, or by RELIABLE_ACK when no input
+    // has carried the ack for RELIABLE_ACK_DELAY_MS (e.g. while dead)
+    ReliableReceiver reliableReceiver;
+    int64_t reliableAckPendingSince;               // 0 = nothing waiting to be acked
+    static constexpr int64_t RELIABLE_ACK_DELAY_MS = 50;
     int64_t lastServerTimestamp;  // Timestamp from last received game state
+    uint32_t worldStateVersion = 0;
+    int64_t lastWorldStateArrivalMicros = 0;
+    ClockSync clockSync;
+    InputLatencyTracker inputLatency;
 
-    // RTT and ping tracking
+    // RTT and ping tracking. Input acks echo the input's send time, so while
+    // input flows every ack is a timing sample; the least delayed one of each
+    // pingInterval goes to clockSync and the RTT statistics. Pings are only
+    // the fallback when no sample has come for a whole interval.
     float pingTimer;
     float pingInterval;  // How often to send ping (e.g., 1.0 seconds)
-    std::deque<SentPacket> sentPackets;  // Track sent packets for RTT calculation
-    static const size_t MAX_SENT_PACKETS_HISTORY = 100;
+    struct TimingSample {
+        int64_t clientSendMicros;
+        int64_t serverReceiveMicros;
+        int64_t serverTransmitMicros;
+        int64_t clientReceiveMicros;
+        int64_t roundTripMicros;
+    };
+    TimingSample timingCandidate{};     // Least delayed sample of the current window
+    bool hasTimingCandidate = false;
+    int64_t timingWindowStartMicros = 0;    // 0 = the next sample is used at once
+    int64_t lastTimingSampleMicros = 0;     // Arrival of the newest pong, join reply or echoing ack
 
     //  Network statistics
     NetworkStats networkStats;
+    BandwidthStats bandwidth;
+    int64_t bandwidthWindowStart;  // ms timestamp the current window began
+    NetworkConditions networkConditions;
+    std::unique_ptr<NetworkConditioner> conditioner;
+    std::unique_ptr<PacketCapture> capture;
+    uint32_t newestOwnBulletId;
+    uint32_t confirmedBulletCount;
+    uint16_t nextSpawnToken;        // Never 0, which means none
     std::deque<float> rttHistory;  // For calculating average and jitter
     static const size_t RTT_HISTORY_SIZE = 30;
 
     // Out-of-order packet detection
-    std::unordered_map<uint32_t, bool> receivedSequenceNumbers;  // Track received sequences
-    static const size_t MAX_SEQUENCE_HISTORY = 200;
+    SequenceWindow receivedSequences;  // Server message sequences seen recently
 
     //  Error tracking
     int consecutiveErrors;
@@ -144,10 +428,8 @@ private:
 
     // Client prediction system
     std::unique_ptr<ClientPrediction> prediction;
-    uint32_t lastServerAckedSequence;
+    uint32_t lastServerAckedSequence;      // Input the latest server state reflects
     bool predictionEnabled;
-    static constexpr float MOVEMENT_SPEED = 150.0f;
-    static constexpr float ROTATION_SPEED = 200.0f;
 
     // Server authoritative state for reconciliation
     sf::Vector2f serverAuthoritativePosition;
@@ -155,13 +437,18 @@ private:
     float serverAuthoritativeBarrelRotation;
     bool hasServerAuthoritativeState;
 
+    bool hasUnreconciledServerState;       // Not yet checked against the prediction
+    uint32_t concealedReplayFrom;          // First input the server concealed differently (0 = none)
+
     // Smooth reconciliation system (prevents jerky corrections)
-    sf::Vector2f reconciliationTargetPosition;
-    float reconciliationTargetRotation;
-    bool isReconciling;
-    static constexpr float SMOOTH_CORRECTION_THRESHOLD = 30.0f;  // Below this, use smooth correction
+    sf::Vector2f correctionOffset;
+    sf::Angle correctionRotationOffset;
+    uint64_t reconciliationChecks;
+    uint64_t mispredictions;
+    static constexpr float MISPREDICTION_TOLERANCE = 5.0f;           // Pixels between prediction and server
+    static constexpr float MISPREDICTION_ROTATION_TOLERANCE = 2.0f;  // Degrees
     static constexpr float SNAP_CORRECTION_THRESHOLD = 50.0f;     // Above this, snap immediately
-    static constexpr float RECONCILIATION_RATE = 6.0f;           // Lerp speed (higher = faster)
+    static constexpr float RECONCILIATION_RATE = 6.0f;           // Offset decay per second (higher = faster)
 
     // Input buffering system tracking
     int64_t lastInputAckTime;              // Last time we received input ack
@@ -170,29 +457,65 @@ private:
 
     // Private methods
     void ProcessIncomingMessages();
+    void ProcessQueuedMessages();
     void ProcessPacket(sf::Packet& packet, sf::IpAddress senderIP, unsigned short senderPort);
-    void HandleGameState(const GameStateMessage& msg);
+    void HandleGameState(sf::Packet& packet);
+    void ProcessStateMessage(NetMessageType msgType, sf::Packet& packet);
+    void HandleGameStateDelta(BitReader& reader, const StateHeader& stateHeader);
+    bool ApplyPlayerState(PlayerData player);
+    void ApplyWorldSnapshot(const WorldSnapshot& snapshot);
+    void ProcessGameStateTiming(int64_t timestamp, uint32_t sequenceNumber, uint32_t lastAckedInput,
+        int64_t inputApplyMicros);
+    bool SendConnectionRequest();
+    bool AcceptPlayerId(uint32_t assignedId);
+    void HandleJoinAccept(const JoinAcceptMessage& msg);
     bool SendJoinRequest(const std::string& playerName, const std::string& preferredColor);
+    bool SendSpectateRequest();
+    void UpdateSpectating();
+    bool SendSessionResume();
+    void Reconnect();
+    void HandleMulticastGroup(const MulticastGroupMessage& msg);
+    void HandleGroupStateAck(const GroupStateAckMessage& msg);
+    void HandleChunkData(ChunkDataMessage& msg);
+    void UnloadFarChunks();
+    void ProcessGroupMessages();
+    void ProcessGroupStateMessage(NetMessageType msgType, BitReader& reader, const StateHeader& header);
+    void LeaveMulticastGroup();
 
     //  RTT and statistics methods
     void SendPing();
+    void SendReliableAck();
+    void FillReliableAck(PlayerInputMessage& msg);
     void HandlePong(const PongMessage& msg);
     void UpdateNetworkStatistics(float rtt);
     void RecordReceivedPacket(uint32_t sequenceNumber);
     bool IsPacketOutOfOrder(uint32_t sequenceNumber) const;
-    void CleanupOldSequenceNumbers();
 
     //  Error handling helpers
+    bool OpenSocket(const std::string& serverIP, unsigned short serverPort);
+    bool OpenLoopbackEndpoint();
+    bool OpenSharedMemoryEndpoint(unsigned short serverPort);
+    void ProcessSharedMemoryMessages();
     void CleanupSocketResources();
     std::string SocketStatusToString(sf::Socket::Status status) const;
     void ValidateAndClampLocalPlayerData(Tank& localPlayer);
     void DetectPacketLoss();
+    sf::Socket::Status SendToServer(sf::Packet& packet);
+    sf::Socket::Status SendDatagram(sf::Packet& datagram);
+    void CountOwnBullet(const BulletData& bullet);
+    void PrintBandwidthStats();
 
     // Prediction helpers  Mouse position parameter
     void ApplyInputToTank(Tank& tank, const InputState& input, sf::Vector2f mousePos);
     void SendInputWithSequence(uint32_t sequenceNumber, const InputState& input, float barrelRotation);
     //  Input buffering system methods
     void HandleInputAcknowledgment(const InputAcknowledgmentMessage& msg);
-    void ReplayInputsAfterCorrection(Tank& localPlayer, uint32_t fromSequence, sf::Vector2f mousePos); // ADD mousePos HERE!
+    // One echoed four-time exchange from an input ack
+    void AddTimingSample(int64_t clientSendMicros, int64_t serverReceiveMicros, int64_t serverTransmitMicros);
+    size_t ReplayInputsAfterCorrection(Tank& localPlayer, uint32_t ackedSequence, sf::Vector2f mousePos);
+    // Re-predicts from the input before concealedReplayFrom
+    void ReplayConcealedInputs(Tank& localPlayer);
+    // Hides the jump from predictedPos/Rot to the tank's new state behind the render offset
+    void SmoothCorrection(const Tank& localPlayer, sf::Vector2f predictedPos, sf::Angle predictedRot, size_t replayed);
     void ProcessInputBuffer(float deltaTime);
 };
\ No newline at end of file
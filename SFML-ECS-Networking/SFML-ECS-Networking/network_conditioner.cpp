@@ -0,0 +1,145 @@
+#include "network_conditioner.h"
+#include <cstdio>
+#include <sstream>
+
+namespace {
+    constexpr int MAX_DRAIN_PER_RECEIVE = 1024;
+}
+
+bool NetworkConditions::Parse(const std::string& text, NetworkConditions& conditions) {
+    NetworkConditions parsed = conditions;
+    std::stringstream stream(text);
+    std::string field;
+    int index = 0;
+    try {
+        while (std::getline(stream, field, ',')) {
+            switch (index++) {
+            case 0: parsed.latencyMs = static_cast<uint32_t>(std::stoul(field)); break;
+            case 1: parsed.jitterMs = static_cast<uint32_t>(std::stoul(field)); break;
+            case 2: parsed.lossPercent = std::stof(field); break;
+            case 3: parsed.duplicatePercent = std::stof(field); break;
+            case 4: parsed.reorderPercent = std::stof(field); break;
+            default: return false;
+            }
+        }
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    const auto isPercent = [](float value) { return value >= 0.0f && value <= 100.0f; };
+    if (index == 0 || !isPercent(parsed.lossPercent) || !isPercent(parsed.duplicatePercent) ||
+        !isPercent(parsed.reorderPercent)) {
+        return false;
+    }
+    conditions = parsed;
+    return true;
+}
+
+std::string NetworkConditions::Describe() const {
+    char text[160];
+    std::snprintf(text, sizeof(text),
+        "%u ms latency, %u ms jitter, %.1f%% loss, %.1f%% duplicate, %.1f%% reorder (+%u ms)",
+        latencyMs, jitterMs, lossPercent, duplicatePercent, reorderPercent, reorderDelayMs);
+    return text;
+}
+
+NetworkConditioner::NetworkConditioner(const NetworkConditions& conditions)
+    : conditions(conditions),
+    random(conditions.seed != 0 ? conditions.seed : std::random_device{}()),
+    nextOrder(0) {
+}
+
+bool NetworkConditioner::Roll(float percent) {
+    return percent > 0.0f && std::uniform_real_distribution<float>(0.0f, 100.0f)(random) < percent;
+}
+
+sf::Socket::Status NetworkConditioner::Send(sf::UdpSocket& socket, const sf::Packet& packet,
+    sf::IpAddress address, unsigned short port) {
+    stats.sent++;
+    Schedule(outbound, packet, address, port);
+    Flush(socket);      // Zero-delay settings go straight out
+    return sf::Socket::Status::Done;
+}
+
+sf::Socket::Status NetworkConditioner::Receive(sf::UdpSocket& socket, sf::Packet& packet,
+    std::optional<sf::IpAddress>& address, unsigned short& port) {
+    for (int i = 0; i < MAX_DRAIN_PER_RECEIVE; ++i) {
+        std::optional<sf::IpAddress> sender;
+        unsigned short senderPort = 0;
+        const sf::Socket::Status status = socket.receive(receiveStaging.packet, sender, senderPort);
+        if (status == sf::Socket::Status::NotReady) {
+            break;
+        }
+        if (status != sf::Socket::Status::Done) {
+            return status;
+        }
+        if (sender.has_value()) {
+            stats.received++;
+            Schedule(inbound, receiveStaging.packet, sender.value(), senderPort);
+        }
+    }
+
+    if (inbound.empty() || inbound.top().due > Clock::now()) {
+        return sf::Socket::Status::NotReady;
+    }
+    const size_t slot = inbound.top().slot;
+    inbound.pop();
+    // Swap buffers so both the caller's packet and the slot keep their capacity
+    std::swap(packet, slots[slot].packet);
+    address = slots[slot].address;
+    port = slots[slot].port;
+    freeSlots.push_back(slot);
+    return sf::Socket::Status::Done;
+}
+
+void NetworkConditioner::Flush(sf::UdpSocket& socket, bool flushAll) {
+    const Clock::time_point now = Clock::now();
+    while (!outbound.empty() && (flushAll || outbound.top().due <= now)) {
+        const size_t slot = outbound.top().slot;
+        outbound.pop();
+        QueuedDatagram& datagram = slots[slot];
+        (void)socket.send(datagram.packet, datagram.address, datagram.port);  // Failures look like loss
+        freeSlots.push_back(slot);
+    }
+}
+
+void NetworkConditioner::Schedule(TimerQueue& queue, const sf::Packet& packet,
+    sf::IpAddress address, unsigned short port) {
+    if (Roll(conditions.lossPercent)) {
+        stats.dropped++;
+        return;
+    }
+    const Clock::time_point now = Clock::now();
+    Enqueue(queue, packet, address, port, now);
+    if (Roll(conditions.duplicatePercent)) {
+        stats.duplicated++;
+        Enqueue(queue, packet, address, port, now);
+    }
+}
+
+void NetworkConditioner::Enqueue(TimerQueue& queue, const sf::Packet& packet,
+    sf::IpAddress address, unsigned short port, Clock::time_point now) {
+    uint32_t delayMs = conditions.latencyMs;
+    if (conditions.jitterMs > 0) {
+        delayMs += std::uniform_int_distribution<uint32_t>(0, conditions.jitterMs)(random);
+    }
+    if (Roll(conditions.reorderPercent)) {
+        stats.reordered++;
+        delayMs += conditions.reorderDelayMs;
+    }
+
+    size_t slot;
+    if (freeSlots.empty()) {
+        slot = slots.size();
+        slots.emplace_back();
+    }
+    else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    QueuedDatagram& datagram = slots[slot];
+    datagram.packet = packet;
+    datagram.address = address;
+    datagram.port = port;
+    queue.push(Pending{ now + std::chrono::milliseconds(delayMs), nextOrder++, slot });
+}
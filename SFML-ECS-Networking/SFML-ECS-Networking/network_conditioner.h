@@ -0,0 +1,101 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+#include "datagram_channel.h"
+
+// Simulated network impairments. Every setting applies to each direction at
+// the endpoint using it, so latencyMs on one endpoint adds 2 * latencyMs to
+// the round trip.
+struct NetworkConditions {
+    uint32_t latencyMs = 0;         // Added one-way delay
+    uint32_t jitterMs = 0;          // Extra delay, uniform in [0, jitterMs]
+    float lossPercent = 0.0f;       // Datagrams dropped
+    float duplicatePercent = 0.0f;  // Datagrams delivered twice (independent delays)
+    float reorderPercent = 0.0f;    // Datagrams held back by an extra reorderDelayMs
+    uint32_t reorderDelayMs = 40;
+    uint32_t seed = 0;              // 0 = random
+
+    bool IsActive() const {
+        return latencyMs > 0 || jitterMs > 0 || lossPercent > 0.0f ||
+            duplicatePercent > 0.0f || reorderPercent > 0.0f;
+    }
+
+    // "latency,jitter,loss[,duplicate[,reorder]]" in ms and percent, e.g. "150,20,5".
+    // Returns false, leaving conditions untouched, if the text does not parse.
+    static bool Parse(const std::string& text, NetworkConditions& conditions);
+    std::string Describe() const;
+};
+
+struct NetworkConditionerStats {
+    uint64_t sent = 0;              // Datagrams offered in each direction
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    uint64_t duplicated = 0;
+    uint64_t reordered = 0;
+};
+
+// Transport shim between an endpoint and its sf::UdpSocket. Send and Receive
+// mirror the socket calls; instead of going straight through, each datagram
+// is dropped, duplicated or scheduled for a delivery time on a timer queue.
+// Nothing blocks or sleeps: due outbound datagrams leave on Flush, which the
+// owner calls every update, and Receive drains the socket and hands back
+// only inbound datagrams whose time has come. Delivery is therefore accurate
+// to the caller's update interval. Queued datagrams live in reused slots,
+// so steady traffic does not allocate.
+class NetworkConditioner {
+public:
+    explicit NetworkConditioner(const NetworkConditions& conditions);
+
+    const NetworkConditions& GetConditions() const { return conditions; }
+    const NetworkConditionerStats& GetStats() const { return stats; }
+    size_t GetQueuedCount() const { return outbound.size() + inbound.size(); }
+
+    // Queues the datagram (the packet is copied, so callers may reuse it).
+    // Returns Done like a successful send, including for dropped datagrams.
+    sf::Socket::Status Send(sf::UdpSocket& socket, const sf::Packet& packet,
+        sf::IpAddress address, unsigned short port);
+
+    // Drains the socket into the inbound queue, then returns the next due
+    // datagram (Done) or NotReady. Socket errors are passed through.
+    sf::Socket::Status Receive(sf::UdpSocket& socket, sf::Packet& packet,
+        std::optional<sf::IpAddress>& address, unsigned short& port);
+
+    // Sends outbound datagrams that are due; all of them if flushAll (e.g.
+    // so a leave message still goes out on disconnect)
+    void Flush(sf::UdpSocket& socket, bool flushAll = false);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Clock::time_point due;
+        uint64_t order;             // Breaks ties in arrival order
+        size_t slot;
+        bool operator>(const Pending& other) const {
+            return due != other.due ? due > other.due : order > other.order;
+        }
+    };
+    using TimerQueue = std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>>;
+
+    NetworkConditions conditions;
+    NetworkConditionerStats stats;
+    std::mt19937 random;
+    TimerQueue outbound;
+    TimerQueue inbound;
+    std::vector<QueuedDatagram> slots;
+    std::vector<size_t> freeSlots;
+    uint64_t nextOrder;
+    QueuedDatagram receiveStaging;
+
+    // Drops, duplicates and schedules one datagram into the queue
+    void Schedule(TimerQueue& queue, const sf::Packet& packet, sf::IpAddress address, unsigned short port);
+    void Enqueue(TimerQueue& queue, const sf::Packet& packet, sf::IpAddress address, unsigned short port,
+        Clock::time_point now);
+    bool Roll(float percent);
+};
@@ -0,0 +1,177 @@
+#include "network_io_thread.h"
+#include "network_messages.h"
+#include "connection_token.h"
+#include "thread_tuning.h"
+#include "trace_recorder.h"
+#include "utils.h"
+
+NetworkIOThread::NetworkIOThread(sf::UdpSocket& socket, MessageFilter filter)
+    : socket(socket),
+    filter(filter),
+    rateLimiter(nullptr),
+    validator(nullptr),
+    running(false),
+    receivedCount(0), sentCount(0),
+    sendFailedCount(0), rejectedCount(0), invalidCount(0) {
+}
+
+NetworkIOThread::~NetworkIOThread() {
+    Stop();
+}
+
+/**
+ * Starts the I/O thread. The socket must already be bound and must not be
+ * touched by any other thread until Stop() returns.
+ * @return True if the worker thread was started
+ */
+bool NetworkIOThread::Start() {
+    if (IsRunning()) return true;
+
+    try {
+        running.store(true, std::memory_order_release);
+        worker = std::thread(&NetworkIOThread::Run, this);
+        Utils::printMsg("Network I/O thread started (queue capacity " +
+            std::to_string(DatagramChannel::GetCapacity()) + " per direction)", success);
+        return true;
+    }
+    catch (const std::exception& e) {
+        running.store(false, std::memory_order_release);
+        Utils::printMsg("Failed to start network I/O thread: " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+/**
+ * Stops the worker and flushes anything still queued for sending.
+ */
+void NetworkIOThread::Stop() {
+    if (!running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    try {
+        if (worker.joinable()) {
+            worker.join();
+        }
+        FlushOutbound();
+        Utils::printMsg("Network I/O thread stopped", info);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception stopping network I/O thread: " + std::string(e.what()), error);
+    }
+}
+
+/**
+ * Worker loop: waits briefly for socket readiness, drains every received
+ * datagram into the inbound ring and flushes the outbound ring.
+ */
+void NetworkIOThread::Run() {
+    TraceRecorder::SetThreadName("Network IO");
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::IO);
+    sf::SocketSelector selector;
+    selector.add(socket);
+
+    while (running.load(std::memory_order_acquire)) {
+        try {
+            if (selector.wait(sf::milliseconds(SELECTOR_TIMEOUT_MS))) {
+                TRACE_SCOPE("Receive datagrams", "net");
+                ReceiveAvailable();
+            }
+            FlushOutbound();
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in network I/O thread: " + std::string(e.what()), error);
+        }
+        catch (...) {
+            Utils::printMsg("Unknown exception in network I/O thread", error);
+        }
+    }
+}
+
+int NetworkIOThread::ReceiveAvailable() {
+    int received = 0;
+    std::optional<sf::IpAddress> senderIP;
+    unsigned short senderPort = 0;
+
+    while (true) {
+        sf::Socket::Status status = socket.receive(receiveStaging.packet, senderIP, senderPort);
+        if (status != sf::Socket::Status::Done) {
+            if (status == sf::Socket::Status::Error) {
+                Utils::printMsg("Socket error while receiving on network I/O thread", error);
+            }
+            break;
+        }
+
+        receivedCount.fetch_add(1, std::memory_order_relaxed);
+        if (!senderIP.has_value() || !filter(receiveStaging.packet)) {
+            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        receiveStaging.arrivalMicros = GetSteadyMicros();
+        if (rateLimiter && !rateLimiter->Admit(receiveStaging.packet, senderIP.value(), senderPort, receiveStaging.arrivalMicros)) {
+            continue;   // Counted by the limiter
+        }
+        if (validator && !validator->Check(receiveStaging.packet, GetCurrentTimestamp())) {
+            invalidCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        receiveStaging.validated = validator != nullptr;
+        receiveStaging.address = senderIP.value();
+        receiveStaging.port = senderPort;
+        channel.PushInbound(receiveStaging);
+        received++;
+    }
+    return received;
+}
+
+int NetworkIOThread::FlushOutbound() {
+    int sent = 0;
+
+    while (channel.PopOutbound(sendStaging)) {
+        TRACE_SCOPE("Send datagram", "net");
+        sf::Socket::Status status = socket.send(sendStaging.packet, sendStaging.address, sendStaging.port);
+        if (status == sf::Socket::Status::Done) {
+            sentCount.fetch_add(1, std::memory_order_relaxed);
+            sent++;
+        }
+        else {
+            sendFailedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return sent;
+}
+
+/**
+ * Cheap screening done off the simulation thread: only message types that
+ * clients are allowed to send, behind a connection token, make it into the
+ * inbound ring. The token itself is checked by GameServer.
+ */
+bool NetworkIOThread::IsKnownClientMessage(const sf::Packet& packet) {
+    uint64_t token = 0;
+    if (!ConnectionTokens::ReadToken(packet, token)) {
+        return false;
+    }
+
+    switch (static_cast<NetMessageType>(ConnectionTokens::PeekMessageType(packet))) {
+    case NetMessageType::CONNECTION_REQUEST:
+    case NetMessageType::PLAYER_JOIN:
+    case NetMessageType::PLAYER_UPDATE:
+    case NetMessageType::PLAYER_INPUT:
+    case NetMessageType::BULLET_SPAWN:
+    case NetMessageType::PING:
+    case NetMessageType::RELIABLE_ACK:
+    case NetMessageType::SPECTATE_REQUEST:
+    case NetMessageType::MULTICAST_STATUS:
+    case NetMessageType::SESSION_RESUME:
+    case NetMessageType::STATE_RESYNC:
+    case NetMessageType::CLIENT_TELEMETRY:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool NetworkIOThread::IsNonEmptyMessage(const sf::Packet& packet) {
+    return packet.getDataSize() > 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "datagram_channel.h"
+#include "ingress_rate_limiter.h"
+#include "ingress_validator.h"
+
+// Owns socket receive/send on a dedicated thread while running.
+// Received datagrams are stamped with their arrival time, pre-screened by the
+// message filter and handed to the simulation through a DatagramChannel;
+// outgoing datagrams are queued on the same channel by the simulation and
+// flushed by the I/O thread. Used by the server and, optionally, the client.
+class NetworkIOThread {
+public:
+    static constexpr int SELECTOR_TIMEOUT_MS = 1;                 // Max wait for socket readiness
+
+    // Decides which received datagrams reach the channel; the rest count as rejected
+    using MessageFilter = bool (*)(const sf::Packet& packet);
+
+    explicit NetworkIOThread(sf::UdpSocket& socket, MessageFilter filter = &NetworkIOThread::IsKnownClientMessage);
+    ~NetworkIOThread();
+
+    // Checks every datagram that passes the filter against the limiter's
+    // buckets before it is queued; set before Start (nullptr = no limit)
+    void SetRateLimiter(IngressRateLimiter* limiter) { rateLimiter = limiter; }
+    // Decodes and range-checks every datagram the limiter admits, dropping
+    // the ones that fail and marking the rest validated; set before Start
+    // (nullptr = queued unchecked)
+    void SetValidator(IngressValidator* ingressValidator) { validator = ingressValidator; }
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Simulation thread side
+    DatagramChannel& GetChannel() { return channel; }
+
+    // Diagnostics
+    uint64_t GetReceivedCount() const { return receivedCount.load(std::memory_order_relaxed); }
+    uint64_t GetSentCount() const { return sentCount.load(std::memory_order_relaxed); }
+    uint64_t GetInboundDropped() const { return channel.GetInboundDropped(); }
+    uint64_t GetOutboundDropped() const {
+        return channel.GetOutboundDropped() + sendFailedCount.load(std::memory_order_relaxed);
+    }
+    uint64_t GetRejectedCount() const { return rejectedCount.load(std::memory_order_relaxed); }
+    uint64_t GetInvalidCount() const { return invalidCount.load(std::memory_order_relaxed); }
+
+    // Filters: message types clients may send (server socket), and any
+    // non-empty datagram (client socket; ProcessPacket screens types itself)
+    static bool IsKnownClientMessage(const sf::Packet& packet);
+    static bool IsNonEmptyMessage(const sf::Packet& packet);
+
+private:
+    sf::UdpSocket& socket;
+    MessageFilter filter;
+    IngressRateLimiter* rateLimiter;
+    IngressValidator* validator;
+    DatagramChannel channel;
+    std::thread worker;
+    std::atomic<bool> running;
+
+    std::atomic<uint64_t> receivedCount;
+    std::atomic<uint64_t> sentCount;
+    std::atomic<uint64_t> sendFailedCount;
+    std::atomic<uint64_t> rejectedCount;
+    std::atomic<uint64_t> invalidCount;     // Failed the validator
+
+    // Swapped through the channel, so their packet buffers are reused rather than reallocated
+    QueuedDatagram receiveStaging;   // Receives straight into the next inbound slot
+    QueuedDatagram sendStaging;      // Datagram being sent
+
+    void Run();
+    int ReceiveAvailable();
+    int FlushOutbound();
+};
@@ -1,502 +1,394 @@
 #include "network_messages.h"
+#include "network_validation.h"
+#include <algorithm>
+#include <cmath>
 
 namespace NetworkUtils {
-    // PlayerData serialization
-    /**
-     * Serializes PlayerData to packet for network transmission in multiplayer sync.
-     * @param packet SFML packet reference for binary data appending.
-     * @param player Const PlayerData reference to avoid copying during serialization.
-     * @return Packet reference for chaining per SFML standards.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerData& player) {
-        packet << player.playerId
-            << player.playerName
-            << player.x
-            << player.y
-            << player.bodyRotation
-            << player.barrelRotation
-            << player.color
-            << player.isMoving_forward
-            << player.isMoving_backward
-            << player.isMoving_left
-            << player.isMoving_right
-            << player.health
-            << player.maxHealth
-            << player.score
-            << player.isDead;
-        return packet;
+    namespace {
+        /**
+         * Maps value in [min, max] onto an unsigned integer with the given bit width.
+         * NaN/inf and out-of-range values are clamped to the nearest bound.
+         */
+        uint16_t QuantizeRange(float value, float min, float max, int bits) {
+            const float steps = static_cast<float>((1u << bits) - 1u);
+            if (!std::isfinite(value)) {
+                value = min;
+            }
+            const float normalized = (std::clamp(value, min, max) - min) / (max - min);
+            return static_cast<uint16_t>(std::lround(normalized * steps));
+        }
+
+        float DequantizeRange(uint16_t value, float min, float max, int bits) {
+            const float steps = static_cast<float>((1u << bits) - 1u);
+            const uint16_t clamped = std::min<uint16_t>(value, static_cast<uint16_t>(steps));
+            return min + (static_cast<float>(clamped) / steps) * (max - min);
+        }
+
+        // Movement flags of one input as forward | backward << 1 | left << 2 | right << 3
+        constexpr int INPUT_FLAG_BITS = 4;
+
+        uint32_t InputFlags(bool forward, bool backward, bool left, bool right) {
+            return (forward ? 0x1u : 0u) | (backward ? 0x2u : 0u) | (left ? 0x4u : 0u) | (right ? 0x8u : 0u);
+        }
     }
-    /**
-     * Deserializes PlayerData from packet for receiving game state updates.
-     * @param packet SFML packet reference for data extraction.
-     * @param player PlayerData reference to populate with received data.
-     * @return Packet reference for chaining per SFML standards.
-     */
-    sf::Packet& operator>>(sf::Packet& packet, PlayerData& player) {
-        packet >> player.playerId
-            >> player.playerName
-            >> player.x
-            >> player.y
-            >> player.bodyRotation
-            >> player.barrelRotation
-            >> player.color
-            >> player.isMoving_forward
-            >> player.isMoving_backward
-            >> player.isMoving_left
-            >> player.isMoving_right
-            >> player.health
-            >> player.maxHealth
-            >> player.score
-            >> player.isDead;
-        return packet;
+
+    // Quantized field encoding
+    uint16_t QuantizePositionX(float x) {
+        return QuantizeRange(x, NetworkValidation::ENTITY_MIN_X, NetworkValidation::ENTITY_MAX_X,
+            WirePrecision::POSITION_BITS);
     }
-    // EnemyData serialization
-    /**
-     * Serializes EnemyData to packet for syncing enemy states across clients.
-     * @param packet SFML packet reference for appending enemy info.
-     * @param enemy Const EnemyData reference for efficient serialization.
-     * @return Packet reference for operator chaining.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const EnemyData& enemy) {
-        packet << enemy.enemyId
-            << enemy.enemyType
-            << enemy.x
-            << enemy.y
-            << enemy.bodyRotation
-            << enemy.barrelRotation
-            << enemy.health
-            << enemy.maxHealth;
-        return packet;
+
+    uint16_t QuantizePositionY(float y) {
+        return QuantizeRange(y, NetworkValidation::ENTITY_MIN_Y, NetworkValidation::ENTITY_MAX_Y,
+            WirePrecision::POSITION_BITS);
     }
+
     /**
-     * Deserializes EnemyData from packet to update local enemy representations.
-     * @param packet SFML packet reference for data reading.
-     * @param enemy EnemyData reference to fill with deserialized values.
-     * @return Packet reference for chaining.
+     * Rotations wrap instead of clamping: 360 degrees maps back to 0.
      */
-    sf::Packet& operator>>(sf::Packet& packet, EnemyData& enemy) {
-        packet >> enemy.enemyId
-            >> enemy.enemyType
-            >> enemy.x
-            >> enemy.y
-            >> enemy.bodyRotation
-            >> enemy.barrelRotation
-            >> enemy.health
-            >> enemy.maxHealth;
-        return packet;
+    uint16_t QuantizeRotation(float degrees) {
+        const uint32_t steps = 1u << WirePrecision::ROTATION_BITS;
+        if (!std::isfinite(degrees)) {
+            return 0;
+        }
+        float wrapped = std::fmod(degrees, 360.0f);
+        if (wrapped < 0.0f) {
+            wrapped += 360.0f;
+        }
+        return static_cast<uint16_t>(std::lround(wrapped / 360.0f * steps) % steps);
     }
-    // BulletData serialization
-    /**
-     * Serializes BulletData to packet for transmitting bullet spawns/updates.
-     * @param packet SFML packet for appending bullet properties.
-     * @param bullet Const BulletData ref for serialization without modification.
-     * @return Packet ref for chaining.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const BulletData& bullet) {
-        packet << bullet.bulletId
-            << bullet.ownerId
-            << bullet.bulletType
-            << bullet.x
-            << bullet.y
-            << bullet.velocityX
-            << bullet.velocityY
-            << bullet.rotation
-            << bullet.damage
-            << bullet.lifetime
-            << bullet.spawnTime;
-        return packet;
+
+    uint16_t QuantizeVelocity(float velocity) {
+        return QuantizeRange(velocity, -NetworkValidation::MAX_ENTITY_SPEED, NetworkValidation::MAX_ENTITY_SPEED,
+            WirePrecision::VELOCITY_BITS);
     }
-    /**
-     * Deserializes BulletData from packet to recreate bullets client-side.
-     * @param packet SFML packet for extracting bullet data.
-     * @param bullet BulletData ref to populate.
-     * @return Packet ref for chaining.
-     */
-    sf::Packet& operator>>(sf::Packet& packet, BulletData& bullet) {
-        packet >> bullet.bulletId
-            >> bullet.ownerId
-            >> bullet.bulletType
-            >> bullet.x
-            >> bullet.y
-            >> bullet.velocityX
-            >> bullet.velocityY
-            >> bullet.rotation
-            >> bullet.damage
-            >> bullet.lifetime
-            >> bullet.spawnTime;
-        return packet;
+
+    uint16_t QuantizeHealth(float health) {
+        return QuantizeRange(health, 0.0f, NetworkValidation::MAX_HEALTH_VALUE, WirePrecision::HEALTH_BITS);
     }
-    // JoinMessage serialization
-    /**
-     * Serializes JoinMessage to packet for client join requests.
-     * @param packet Packet for appending join details.
-     * @param msg Const JoinMessage ref for data.
-     * @return Packet ref.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const JoinMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.playerName
-            << msg.preferredColor
-            << msg.timestamp
-            << msg.sequenceNumber;
-        return packet;
+
+    uint16_t QuantizeLifetime(float seconds) {
+        return QuantizeRange(seconds, 0.0f, NetworkValidation::MAX_BULLET_LIFETIME, WirePrecision::LIFETIME_BITS);
     }
-    /**
-     * Deserializes JoinMessage from packet to handle new players.
-     * @param packet Packet for reading.
-     * @param msg JoinMessage ref to fill.
-     * @return Packet ref.
-     */
-    sf::Packet& operator>>(sf::Packet& packet, JoinMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.playerName
-            >> msg.preferredColor
-            >> msg.timestamp
-            >> msg.sequenceNumber;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+
+    float DequantizePositionX(uint16_t value) {
+        return DequantizeRange(value, NetworkValidation::ENTITY_MIN_X, NetworkValidation::ENTITY_MAX_X,
+            WirePrecision::POSITION_BITS);
     }
-    // PlayerUpdateMessage serialization
-    /**
-     * Serializes PlayerUpdateMessage for sending position/rotation updates.
-     * @param packet Packet for data.
-     * @param msg Const msg ref.
-     * @return Packet ref.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerUpdateMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.playerId
-            << msg.x
-            << msg.y
-            << msg.bodyRotation
-            << msg.barrelRotation
-            << msg.isMoving_forward
-            << msg.isMoving_backward
-            << msg.isMoving_left
-            << msg.isMoving_right
-            << msg.timestamp
-            << msg.sequenceNumber;
-        return packet;
+
+    float DequantizePositionY(uint16_t value) {
+        return DequantizeRange(value, NetworkValidation::ENTITY_MIN_Y, NetworkValidation::ENTITY_MAX_Y,
+            WirePrecision::POSITION_BITS);
     }
-    /**
-     * Deserializes PlayerUpdateMessage to apply updates.
-     * @param packet Packet.
-     * @param msg Msg ref.
-     * @return Packet ref.
-     */
-    sf::Packet& operator>>(sf::Packet& packet, PlayerUpdateMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.playerId
-            >> msg.x
-            >> msg.y
-            >> msg.bodyRotation
-            >> msg.barrelRotation
-            >> msg.isMoving_forward
-            >> msg.isMoving_backward
-            >> msg.isMoving_left
-            >> msg.isMoving_right
-            >> msg.timestamp
-            >> msg.sequenceNumber;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+
+    float DequantizeRotation(uint16_t value) {
+        const uint32_t steps = 1u << WirePrecision::ROTATION_BITS;
+        return static_cast<float>(value % steps) * (360.0f / steps);
     }
-    
-    // PlayerInputMessage serialization
-    /**
-     * Serializes PlayerInputMessage for client inputs to server.
-     * @param packet Packet.
-     * @param msg Const ref.
-     * @return Ref.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerInputMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.playerId
-            << msg.isMoving_forward
-            << msg.isMoving_backward
-            << msg.isMoving_left
-            << msg.isMoving_right
-            << msg.timestamp
-            << msg.sequenceNumber
-            << msg.barrelRotation;
-        return packet;
+
+    float DequantizeVelocity(uint16_t value) {
+        return DequantizeRange(value, -NetworkValidation::MAX_ENTITY_SPEED, NetworkValidation::MAX_ENTITY_SPEED,
+            WirePrecision::VELOCITY_BITS);
     }
-    /**
-     * Deserializes PlayerInputMessage for server processing.
-     * @param packet Packet.
-     * @param msg Ref.
-     * @return Ref.
-     */
-    sf::Packet& operator>>(sf::Packet& packet, PlayerInputMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.playerId
-            >> msg.isMoving_forward
-            >> msg.isMoving_backward
-            >> msg.isMoving_left
-            >> msg.isMoving_right
-            >> msg.timestamp
-            >> msg.sequenceNumber
-            >> msg.barrelRotation;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+
+    float DequantizeHealth(uint16_t value) {
+        return DequantizeRange(value, 0.0f, NetworkValidation::MAX_HEALTH_VALUE, WirePrecision::HEALTH_BITS);
     }
-    // GameStateMessage serialization
-    /**
-     * Serializes GameStateMessage with players/enemies for full state sync.
-     * @param packet Packet.
-     * @param msg Const ref.
-     * @return Ref.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const GameStateMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type);
-        // Serialize player count and players
-        packet << static_cast<uint32_t>(msg.players.size());
-        for (const auto& player : msg.players) {
-            packet << player;
-        }
-        // Serialize enemy count and enemies
-        packet << static_cast<uint32_t>(msg.enemies.size());
-        for (const auto& enemy : msg.enemies) {
-            packet << enemy;
-        }
-        packet << msg.timestamp
-            << msg.sequenceNumber
-            << msg.lastAckedInput;
-        return packet;
+
+    float DequantizeLifetime(uint16_t value) {
+        return DequantizeRange(value, 0.0f, NetworkValidation::MAX_BULLET_LIFETIME, WirePrecision::LIFETIME_BITS);
     }
-    /**
-     * Deserializes GameStateMessage to reconstruct game state.
-     * @param packet Packet.
-     * @param msg Ref.
-     * @return Ref.
-     */
-    sf::Packet& operator>>(sf::Packet& packet, GameStateMessage& msg) {
-        uint8_t type;
-        uint32_t playerCount;
-        uint32_t enemyCount;
-        packet >> type >> playerCount;
-        msg.type = static_cast<NetMessageType>(type);
-        // Deserialize players
-        msg.players.clear();
-        msg.players.reserve(playerCount);
-        for (uint32_t i = 0; i < playerCount; ++i) {
-            PlayerData player;
-            packet >> player;
-            msg.players.push_back(player);
-        }
-        // Deserialize enemies
-        packet >> enemyCount;
-        msg.enemies.clear();
-        msg.enemies.reserve(enemyCount);
-        for (uint32_t i = 0; i < enemyCount; ++i) {
-            EnemyData enemy;
-            packet >> enemy;
-            msg.enemies.push_back(enemy);
-        }
-        packet >> msg.timestamp
-            >> msg.sequenceNumber
-            >> msg.lastAckedInput;
-        return packet;
+
+    int64_t Unwrap(uint64_t low, int bits, int64_t reference) {
+        const uint64_t mask = (uint64_t(1) << bits) - 1;
+        const uint64_t half = uint64_t(1) << (bits - 1);
+        // Distance forward from reference to low, mod 2^bits, read as signed
+        const uint64_t ahead = (low - static_cast<uint64_t>(reference)) & mask;
+        return ahead < half ? reference + static_cast<int64_t>(ahead)
+            : reference - static_cast<int64_t>(mask + 1 - ahead);
     }
-    // PingMessage serialization
-    /**
-     * Serializes PingMessage for latency measurement.
-     * @param packet Packet.
-     * @param msg Const ref.
-     * @return Ref.
-     */
-    sf::Packet& operator<<(sf::Packet& packet, const PingMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.timestamp
-            << msg.sequenceNumber;
-        return packet;
+
+    void WritePosition(BitWriter& writer, float x, float y) {
+        writer.WriteQuantized(QuantizePositionX(x), WirePrecision::POSITION_BITS);
+        writer.WriteQuantized(QuantizePositionY(y), WirePrecision::POSITION_BITS);
     }
-    /**
-     * Deserializes PingMessage to respond with pong.
-     * @param packet Packet.
-     * @param msg Ref.
-     * @return Ref.
-     */
-    sf::Packet& operator>>(sf::Packet& packet, PingMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.timestamp
-            >> msg.sequenceNumber;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+
+    void ReadPosition(BitReader& reader, float& x, float& y) {
+        x = DequantizePositionX(reader.ReadQuantized(WirePrecision::POSITION_BITS));
+        y = DequantizePositionY(reader.ReadQuantized(WirePrecision::POSITION_BITS));
+    }
+
+    void WriteRotation(BitWriter& writer, float degrees) {
+        writer.WriteQuantized(QuantizeRotation(degrees), WirePrecision::ROTATION_BITS);
     }
-    // PongMessage serialization
+
+    float ReadRotation(BitReader& reader) {
+        return DequantizeRotation(reader.ReadQuantized(WirePrecision::ROTATION_BITS));
+    }
+
+    void WriteHealth(BitWriter& writer, float health) {
+        writer.WriteQuantized(QuantizeHealth(health), WirePrecision::HEALTH_BITS);
+    }
+
+    float ReadHealth(BitReader& reader) {
+        return DequantizeHealth(reader.ReadQuantized(WirePrecision::HEALTH_BITS));
+    }
+
+    // Player colors
+    namespace {
+        const char* const COLOR_NAMES[] = { "red", "blue", "green", "black" };
+        static_assert(sizeof(COLOR_NAMES) / sizeof(COLOR_NAMES[0]) == static_cast<size_t>(PlayerColor::COUNT),
+            "COLOR_NAMES must cover every PlayerColor");
+    }
+
     /**
-     * Serializes PongMessage as ping response.
-     * @param packet Packet.
-     * @param msg Const ref.
-     * @return Ref.
+     * @return Colour name used by the tank textures; unknown IDs map to "green"
      */
-    sf::Packet& operator<<(sf::Packet& packet, const PongMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.originalTimestamp
-            << msg.sequenceNumber;
-        return packet;
+    const char* ColorName(PlayerColor color) {
+        const uint8_t colorId = static_cast<uint8_t>(color);
+        return IsValidColorId(colorId) ? COLOR_NAMES[colorId] : COLOR_NAMES[static_cast<uint8_t>(PlayerColor::GREEN)];
     }
+
     /**
-     * Deserializes PongMessage to calculate RTT.
-     * @param packet Packet.
-     * @param msg Ref.
-     * @return Ref.
+     * Parses a colour name from a join request.
+     * @return False (color untouched) if the name is not a known tank colour
      */
-    sf::Packet& operator>>(sf::Packet& packet, PongMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.originalTimestamp
-            >> msg.sequenceNumber;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+    bool ColorFromName(const std::string& name, PlayerColor& color) {
+        for (uint8_t i = 0; i < static_cast<uint8_t>(PlayerColor::COUNT); ++i) {
+            if (name == COLOR_NAMES[i]) {
+                color = static_cast<PlayerColor>(i);
+                return true;
+            }
+        }
+        return false;
     }
-    // InputAcknowledgmentMessage serialization
+
+    // Wire sizes of the fixed-size messages: a schema edit that changes one
+    // changes the protocol, and older peers stop understanding the message
+    static_assert(MessageSchema::FixedEncodedSize<PingMessage>() == 13, "PING layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<PongMessage>() == 29, "PONG layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<JoinAcceptMessage>() == 31, "JOIN_ACCEPT layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<SessionResumeMessage>() == 19, "SESSION_RESUME layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<StateResyncMessage>() == 9, "STATE_RESYNC layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<ClientTelemetryMessage>() == 73, "CLIENT_TELEMETRY layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<PlayerUpdateMessage>() == 37, "PLAYER_UPDATE layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<ReliableAckMessage>() == 11, "RELIABLE_ACK layout changed");
+    static_assert(MessageSchema::FixedEncodedSize<BulletDestroyMessage>() == 30, "BULLET_DESTROY layout changed");
+
+    // StateHeader serialization
     /**
-     * Serializes InputAcknowledgmentMessage for confirming inputs.
-     * @param packet Packet.
-     * @param msg Const ref.
-     * @return Ref.
+     * Writes the header that leads every server state message body.
+     * @param writer Writer positioned just after the message type.
+     * @param header Sequence and server timestamp of the state.
      */
-    sf::Packet& operator<<(sf::Packet& packet, const InputAcknowledgmentMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.playerId
-            << msg.acknowledgedSequence
-            << msg.serverTimestamp;
-        return packet;
+    void Write(BitWriter& writer, const StateHeader& header) {
+        writer.WriteVarUint(header.sequence);
+        writer.WriteVarUint64(static_cast<uint64_t>(header.timestamp));
     }
     /**
-     * Deserializes InputAcknowledgmentMessage to process acks.
-     * @param packet Packet.
-     * @param msg Ref.
-     * @return Ref.
+     * Reads only the state header, leaving the reader at the body.
+     * @param reader Reader positioned just after the message type.
+     * @param header StateHeader ref to populate.
+     * @return False if the reader ran out of data.
      */
-    sf::Packet& operator>>(sf::Packet& packet, InputAcknowledgmentMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.playerId
-            >> msg.acknowledgedSequence
-            >> msg.serverTimestamp;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+    bool Read(BitReader& reader, StateHeader& header) {
+        header.sequence = reader.ReadVarUint();
+        header.timestamp = static_cast<int64_t>(reader.ReadVarUint64());
+        return reader.IsValid();
     }
-    // BulletSpawnMessage serialization
+    // BulletData serialization
     /**
-     * Serializes BulletSpawnMessage for notifying bullet fires.
-     * @param packet Packet.
-     * @param msg Const ref.
-     * @return Ref.
+     * Bit-packs BulletData for bullet updates.
+     * Position, velocity, rotation, damage and lifetime are quantized (see WirePrecision).
+     * A spawn token costs one bit when absent.
+     * @param writer Writer positioned at the bullet.
+     * @param bullet Bullet to write.
      */
-    sf::Packet& operator<<(sf::Packet& packet, const BulletSpawnMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.playerId
-            << msg.spawnX
-            << msg.spawnY
-            << msg.directionX
-            << msg.directionY
-            << msg.barrelRotation
-            << msg.timestamp
-            << msg.sequenceNumber;
-        return packet;
+    void Write(BitWriter& writer, const BulletData& bullet) {
+        writer.WriteVarUint(bullet.bulletId);
+        writer.WriteVarUint(bullet.ownerId);
+        writer.WriteBits(bullet.bulletType, WirePrecision::BULLET_TYPE_BITS);
+        WritePosition(writer, bullet.x, bullet.y);
+        writer.WriteQuantized(QuantizeVelocity(bullet.velocityX), WirePrecision::VELOCITY_BITS);
+        writer.WriteQuantized(QuantizeVelocity(bullet.velocityY), WirePrecision::VELOCITY_BITS);
+        WriteRotation(writer, bullet.rotation);
+        WriteHealth(writer, bullet.damage);
+        writer.WriteQuantized(QuantizeLifetime(bullet.lifetime), WirePrecision::LIFETIME_BITS);
+        writer.WriteVarUint64(static_cast<uint64_t>(bullet.spawnTime));
+        writer.WriteBool(bullet.spawnToken != 0);
+        if (bullet.spawnToken != 0) {
+            writer.WriteVarUint(bullet.spawnToken);
+        }
     }
     /**
-     * Deserializes BulletSpawnMessage to spawn bullets.
-     * @param packet Packet.
-     * @param msg Ref.
-     * @return Ref.
+     * Reads a bullet written by Write(BitWriter&, const BulletData&).
+     * @param reader Reader positioned at the bullet.
+     * @param bullet BulletData ref to populate.
+     * @return False if the reader ran out of data.
      */
-    sf::Packet& operator>>(sf::Packet& packet, BulletSpawnMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.playerId
-            >> msg.spawnX
-            >> msg.spawnY
-            >> msg.directionX
-            >> msg.directionY
-            >> msg.barrelRotation
-            >> msg.timestamp
-            >> msg.sequenceNumber;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+    bool Read(BitReader& reader, BulletData& bullet) {
+        bullet.bulletId = reader.ReadVarUint();
+        bullet.ownerId = reader.ReadVarUint();
+        bullet.bulletType = static_cast<uint8_t>(reader.ReadBits(WirePrecision::BULLET_TYPE_BITS));
+        ReadPosition(reader, bullet.x, bullet.y);
+        bullet.velocityX = DequantizeVelocity(reader.ReadQuantized(WirePrecision::VELOCITY_BITS));
+        bullet.velocityY = DequantizeVelocity(reader.ReadQuantized(WirePrecision::VELOCITY_BITS));
+        bullet.rotation = ReadRotation(reader);
+        bullet.damage = ReadHealth(reader);
+        bullet.lifetime = DequantizeLifetime(reader.ReadQuantized(WirePrecision::LIFETIME_BITS));
+        bullet.spawnTime = static_cast<int64_t>(reader.ReadVarUint64());
+        bullet.spawnToken = reader.ReadBool() ? static_cast<uint16_t>(reader.ReadVarUint()) : 0;
+        return reader.IsValid();
     }
-    // BulletUpdateMessage serialization
+    // PlayerInputMessage serialization
     /**
-     * Serializes BulletUpdateMessage with multiple bullets for sync.
-     * @param packet Packet.
+     * Bit-packs PlayerInputMessage. The input itself is one 16-bit command:
+     * four movement bits and the quantized barrel rotation. The timestamp and
+     * the echoed send time go wrapped (WirePrecision), since the receiver
+     * already knows them to within seconds. Snapshot, player table and
+     * reliable channel acks ride along. Repeated older inputs follow, each
+     * coded against the next newer one: one bit when it directly precedes it
+     * (or the sequence gap), and its movement bits only when they differ.
+     * @param writer Writer for the message body.
      * @param msg Const ref.
-     * @return Ref.
      */
-    sf::Packet& operator<<(sf::Packet& packet, const BulletUpdateMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type);
-        // Serialize bullet count and bullets
-        uint32_t bulletCount = static_cast<uint32_t>(msg.bullets.size());
-        packet << bulletCount;
-        for (const auto& bullet : msg.bullets) {
-            packet << bullet;
+    void Write(BitWriter& writer, const PlayerInputMessage& msg) {
+        writer.WriteVarUint(msg.playerId);
+        writer.WriteBits(InputFlags(msg.isMoving_forward, msg.isMoving_backward,
+            msg.isMoving_left, msg.isMoving_right), INPUT_FLAG_BITS);
+        WriteRotation(writer, msg.barrelRotation);
+        writer.WriteBits(static_cast<uint32_t>(static_cast<uint64_t>(msg.timestamp) &
+            ((uint64_t(1) << WirePrecision::INPUT_TIME_BITS) - 1)), WirePrecision::INPUT_TIME_BITS);
+        writer.WriteVarUint(msg.sequenceNumber);
+        writer.WriteVarUint(msg.lastReceivedSnapshot);
+        writer.WriteVarUint(msg.playerTableVersion);
+        writer.WriteBool(msg.hasReliableAck);
+        if (msg.hasReliableAck) {
+            writer.WriteBits(msg.reliableAckSequence, 16);
+            writer.WriteBits(msg.reliableAckBits, 32);
+        }
+
+        const size_t count = std::min<size_t>(msg.previousInputs.size(), NetworkValidation::MAX_REDUNDANT_INPUTS);
+        writer.WriteVarUint(static_cast<uint32_t>(count));
+
+        uint32_t newerSequence = msg.sequenceNumber;
+        uint32_t newerFlags = InputFlags(msg.isMoving_forward, msg.isMoving_backward,
+            msg.isMoving_left, msg.isMoving_right);
+        for (size_t i = 0; i < count; ++i) {
+            const RedundantInput& input = msg.previousInputs[i];
+            const uint32_t flags = InputFlags(input.isMoving_forward, input.isMoving_backward,
+                input.isMoving_left, input.isMoving_right);
+
+            const uint32_t gap = newerSequence - input.sequenceNumber - 1;
+            writer.WriteBool(gap == 0);
+            if (gap != 0) {
+                writer.WriteVarUint(gap);
+            }
+            writer.WriteBool(flags != newerFlags);
+            if (flags != newerFlags) {
+                writer.WriteBits(flags, INPUT_FLAG_BITS);
+            }
+            newerSequence = input.sequenceNumber;
+            newerFlags = flags;
         }
-        packet << msg.timestamp << msg.sequenceNumber;
-        return packet;
+        writer.WriteBool(msg.sendMicros != 0);
+        if (msg.sendMicros != 0) {
+            writer.WriteBits(static_cast<uint32_t>(msg.sendMicros), WirePrecision::ECHO_MICROS_BITS);
+        }
+        writer.WriteBool(msg.predictedStep);
     }
     /**
-     * Deserializes BulletUpdateMessage to update bullets.
-     * @param packet Packet.
+     * Reads a PlayerInputMessage body for server processing. The echoed send
+     * time stays wrapped: only the client can expand it (see HandleInputAcknowledgment).
+     * @param reader Reader positioned after the message type.
      * @param msg Ref.
-     * @return Ref.
+     * @param nowMs Server time the timestamp is expanded around.
+     * @return False if the body was truncated or malformed.
      */
-    sf::Packet& operator>>(sf::Packet& packet, BulletUpdateMessage& msg) {
-        uint8_t type;
-        uint32_t bulletCount;
-        packet >> type >> bulletCount;
-        msg.type = static_cast<NetMessageType>(type);
-        // Deserialize bullets
-        msg.bullets.clear();
-        msg.bullets.reserve(bulletCount);
-        for (uint32_t i = 0; i < bulletCount; ++i) {
-            BulletData bullet;
-            packet >> bullet;
-            msg.bullets.push_back(bullet);
+    bool Read(BitReader& reader, PlayerInputMessage& msg, int64_t nowMs) {
+        msg.type = NetMessageType::PLAYER_INPUT;
+        msg.playerId = reader.ReadVarUint();
+        uint32_t flags = reader.ReadBits(INPUT_FLAG_BITS);
+        msg.isMoving_forward = (flags & 0x1) != 0;
+        msg.isMoving_backward = (flags & 0x2) != 0;
+        msg.isMoving_left = (flags & 0x4) != 0;
+        msg.isMoving_right = (flags & 0x8) != 0;
+        msg.barrelRotation = ReadRotation(reader);
+        msg.timestamp = Unwrap(reader.ReadBits(WirePrecision::INPUT_TIME_BITS), WirePrecision::INPUT_TIME_BITS, nowMs);
+        msg.sequenceNumber = reader.ReadVarUint();
+        msg.lastReceivedSnapshot = reader.ReadVarUint();
+        msg.playerTableVersion = reader.ReadVarUint();
+        msg.hasReliableAck = reader.ReadBool();
+        if (msg.hasReliableAck) {
+            msg.reliableAckSequence = static_cast<uint16_t>(reader.ReadBits(16));
+            msg.reliableAckBits = reader.ReadBits(32);
+        }
+
+        const uint32_t count = reader.ReadVarUint();
+        if (!reader.IsValid() || count > NetworkValidation::MAX_REDUNDANT_INPUTS) {
+            return false;
+        }
+        msg.previousInputs.resize(count);
+
+        uint32_t newerSequence = msg.sequenceNumber;
+        for (RedundantInput& input : msg.previousInputs) {
+            const uint32_t gap = reader.ReadBool() ? 0 : reader.ReadVarUint();
+            if (reader.ReadBool()) {
+                flags = reader.ReadBits(INPUT_FLAG_BITS);
+            }
+            // Sequence numbers start at 1 and strictly decrease through the list
+            if (!reader.IsValid() || newerSequence == 0 || gap >= newerSequence - 1) {
+                return false;
+            }
+            input.sequenceNumber = newerSequence - gap - 1;
+            input.isMoving_forward = (flags & 0x1) != 0;
+            input.isMoving_backward = (flags & 0x2) != 0;
+            input.isMoving_left = (flags & 0x4) != 0;
+            input.isMoving_right = (flags & 0x8) != 0;
+            newerSequence = input.sequenceNumber;
         }
-        packet >> msg.timestamp >> msg.sequenceNumber;
-        return packet;
+        msg.sendMicros = reader.ReadBool() ? static_cast<int64_t>(reader.ReadBits(WirePrecision::ECHO_MICROS_BITS)) : 0;
+        msg.predictedStep = reader.ReadBool();
+        return reader.IsValid();
     }
-    // BulletDestroyMessage serialization
+    // BulletUpdateMessage serialization
     /**
-     * Serializes BulletDestroyMessage for removing bullets on hit/expiry.
-     * @param packet Packet.
+     * Bit-packs BulletUpdateMessage with multiple bullets for sync.
+     * @param writer Writer for the message body.
      * @param msg Const ref.
-     * @return Ref.
      */
-    sf::Packet& operator<<(sf::Packet& packet, const BulletDestroyMessage& msg) {
-        packet << static_cast<uint8_t>(msg.type)
-            << msg.bulletId
-            << msg.destroyReason
-            << msg.hitTargetId
-            << msg.hitX
-            << msg.hitY
-            << msg.timestamp
-            << msg.sequenceNumber;
-        return packet;
+    void Write(BitWriter& writer, const BulletUpdateMessage& msg) {
+        Write(writer, StateHeader(msg.sequenceNumber, msg.timestamp));
+        writer.WriteVarUint(static_cast<uint32_t>(msg.bullets.size()));
+        for (const BulletData& bullet : msg.bullets) {
+            Write(writer, bullet);
+        }
     }
     /**
-     * Deserializes BulletDestroyMessage to handle destructions.
-     * @param packet Packet.
-     * @param msg Ref.
-     * @return Ref.
+     * Reads a BulletUpdateMessage body; the bullet count is capped so a corrupt
+     * header cannot trigger a huge allocation.
+     * @param reader Reader positioned after the message type.
+     * @param msg Ref (bullets vector is reused).
+     * @return False if the body was truncated or malformed.
      */
-    sf::Packet& operator>>(sf::Packet& packet, BulletDestroyMessage& msg) {
-        uint8_t type;
-        packet >> type
-            >> msg.bulletId
-            >> msg.destroyReason
-            >> msg.hitTargetId
-            >> msg.hitX
-            >> msg.hitY
-            >> msg.timestamp
-            >> msg.sequenceNumber;
-        msg.type = static_cast<NetMessageType>(type);
-        return packet;
+    bool Read(BitReader& reader, BulletUpdateMessage& msg) {
+        msg.type = NetMessageType::BULLET_UPDATE;
+        StateHeader header;
+        if (!Read(reader, header)) {
+            return false;
+        }
+        msg.sequenceNumber = header.sequence;
+        msg.timestamp = header.timestamp;
+        const uint32_t bulletCount = reader.ReadVarUint();
+        if (bulletCount > NetworkValidation::MAX_BULLETS_PER_UPDATE) {
+            return false;
+        }
+        msg.bullets.resize(bulletCount);
+        for (BulletData& bullet : msg.bullets) {
+            if (!Read(reader, bullet)) {
+                return false;
+            }
+        }
+        return reader.IsValid();
     }
 } // namespace NetworkUtils
\ No newline at end of file
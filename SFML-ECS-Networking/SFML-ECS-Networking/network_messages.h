@@ -1,9 +1,12 @@
 #pragma once
+#include <array>
 #include <string>
 #include <vector>
 #include <cstdint>
 #include <SFML/Network.hpp>
 #include <chrono>
+#include "bit_stream.h"
+#include "message_schema.h"
 
 // Message types for different kinds of network communication
 enum class NetMessageType : uint8_t {
@@ -21,7 +24,26 @@ enum class NetMessageType : uint8_t {
     BULLET_UPDATE = 12,       //    Server sends bullet state
     BULLET_DESTROY = 13,      //    Server notifies bullet destruction
     PLAYER_DEATH = 14,        //    Player died
-    PLAYER_RESPAWN = 15       //    Player respawned
+    PLAYER_RESPAWN = 15,      //    Player respawned
+    GAME_STATE_DELTA = 16,    //    Per-client delta snapshot (see snapshot_delta.h)
+    INTEREST_UPDATE = 17,     //    Entities entering/leaving a client's area of interest
+    MESSAGE_BUNDLE = 18,      //    Several length-prefixed messages in one datagram (see packet_aggregator.h)
+    MESSAGE_FRAGMENT = 19,    //    One MTU-sized piece of a larger message (see fragment_reassembler.h)
+    RELIABLE_MESSAGE = 20,    //    Sequenced envelope for events resent until acked (see reliable_channel.h)
+    RELIABLE_ACK = 21,        //    Client acks reliable messages while no PLAYER_INPUT carries them
+    BULLET_SPAWNED = 22,      //    Bullets entering a client's view; BULLET_UPDATE body, merged instead of replacing
+    COMPRESSED_MESSAGE = 23,  //    One large message, LZ4-style compressed (see packet_compression.h)
+    CONNECTION_REQUEST = 24,  //    Token-less first contact; answered with a challenge (see connection_token.h)
+    CONNECTION_CHALLENGE = 25, //   Connection token the client prefixes to every datagram
+    SPECTATE_REQUEST = 26,    //    Subscribe to a room's delayed spectator stream; repeated as a keepalive
+    MULTICAST_GROUP = 27,     //    LAN fan-out group to listen on (see lan_multicast.h), sent reliably
+    GROUP_STATE_ACK = 28,     //    Input the client's tank in a multicast frame reflects
+    MULTICAST_STATUS = 29,    //    Newest multicast frame the client received, once a second
+    CHUNK_DATA = 30,          //    Static content of one world chunk (see world_chunks.h), sent reliably
+    JOIN_ACCEPT = 31,         //    Player ID and a clock sample, first in the join reply (see JoinAcceptMessage)
+    SESSION_RESUME = 32,      //    Pick a session up again after silence, from any endpoint (see SessionResumeMessage)
+    STATE_RESYNC = 33,        //    A decoded snapshot failed its state hash: send a full one (see StateResyncMessage)
+    CLIENT_TELEMETRY = 34     //    Client frame, RTT and loss histograms, every 30 s (see client_telemetry.h)
 };
 struct EnemyData {
     uint32_t enemyId;           // Unique enemy ID (starts at 1000)
@@ -47,12 +69,13 @@ struct BulletData {
     float damage;               // Damage value
     float lifetime;             // Remaining lifetime (seconds)
     int64_t spawnTime;          // When bullet was created (timestamp)
+    uint16_t spawnToken;        // The shooter's BulletSpawnMessage::spawnToken (0 = none)
 
     BulletData()
         : bulletId(0), ownerId(0), bulletType(0),
         x(0.0f), y(0.0f), velocityX(0.0f), velocityY(0.0f),
         rotation(0.0f), damage(25.0f), lifetime(3.0f),
-        spawnTime(0) {
+        spawnTime(0), spawnToken(0) {
     }
 };
 
@@ -90,21 +113,35 @@ struct NetworkStats {
     }
 };
 
-// Timestamp helper using high-resolution clock
+// Local steady clock in microseconds. Monotonic, so intervals and clock sync
+// samples never see it jump; the epoch is arbitrary and differs per machine.
+inline int64_t GetSteadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Local steady clock in milliseconds. Server time on a client comes from
+// ClockSync, not from this.
 inline int64_t GetCurrentTimestamp() {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto duration = now.time_since_epoch();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    return GetSteadyMicros() / 1000;
 }
 
-// Individual player data
+// Tank colors, replicated as one byte
+enum class PlayerColor : uint8_t {
+    RED = 0,
+    BLUE = 1,
+    GREEN = 2,
+    BLACK = 3,
+    COUNT
+};
+
+// Individual player data (per-snapshot state; names live in the player table)
 struct PlayerData {
     uint32_t playerId;
-    std::string playerName;  // Added player name for labels
     float x, y;
     float bodyRotation;  // in degrees
     float barrelRotation; // in degrees
-    std::string color;
+    PlayerColor color;
     bool isMoving_forward;
     bool isMoving_backward;
     bool isMoving_left;
@@ -114,8 +151,8 @@ struct PlayerData {
     int32_t score;         // Player score
     bool isDead;           // Whether player is currently dead
 
-    PlayerData() : playerId(0), playerName(""), x(0), y(0), bodyRotation(0), barrelRotation(0),
-        color("green"), isMoving_forward(false), isMoving_backward(false),
+    PlayerData() : playerId(0), x(0), y(0), bodyRotation(0), barrelRotation(0),
+        color(PlayerColor::GREEN), isMoving_forward(false), isMoving_backward(false),
         isMoving_left(false), isMoving_right(false), health(100.0f), maxHealth(100.0f),
         score(0), isDead(false) {
     }
@@ -156,8 +193,104 @@ struct JoinMessage {
     std::string preferredColor;
     int64_t timestamp;              //   : Message timestamp
     uint32_t sequenceNumber;        //   : Sequence number for ordering
+    uint16_t roomId;                //   : Room to join on a multi-room server (optional trailing field)
+    int64_t sendMicros;             //   : Client steady clock when sent, echoed in JOIN_ACCEPT (optional trailing field)
+
+    JoinMessage() : timestamp(0), sequenceNumber(0), roomId(0), sendMicros(0) {}
+};
+
+// Answer to a join. The server queues it ahead of the player table, a full
+// snapshot and the interest update, so the whole reply leaves in that tick's
+// coalesced (and if need be fragmented) datagrams and the client can draw
+// after one round trip. The echoed send time and the server's two stamps are
+// a clock sample, as in PONG, so interpolation starts with a measured RTT.
+// The tick rate sets the client's prediction step: the server takes one
+// input per tick, so the client must send at the same rate (--tick-rate).
+// Unreliable: a lost reply leaves the client without an ID, and its
+// handshake retry asks again
+struct JoinAcceptMessage {
+    NetMessageType type = NetMessageType::JOIN_ACCEPT;
+    uint32_t playerId;
+    int64_t clientSendTime;         // JoinMessage::sendMicros, 0 from clients that do not send it
+    int64_t serverReceiveTime;      // Server steady clock when the join was handled (us)
+    int64_t serverTransmitTime;     // Server steady clock when the reply was written (us)
+    uint16_t tickRate;              // Server simulation ticks per second, 0 from servers that do not send it
+
+    JoinAcceptMessage() : playerId(0), clientSendTime(0), serverReceiveTime(0), serverTransmitTime(0), tickRate(0) {}
+};
+
+// Sent by a joined client that has had no world state for a while, with the
+// session's connection token in front, from whatever endpoint it has now (a
+// NAT may have rebound it). The server picks the session up, active or
+// suspended after a timeout (see GameServer::SetSessionResumeGrace), and
+// answers as it does a join: JOIN_ACCEPT, then a snapshot that is a delta
+// against lastReceivedSnapshot when it still holds it. A session it does not
+// know is answered with a fresh CONNECTION_CHALLENGE, and the client joins again.
+// A server restored from a checkpoint (see GameServer::SetCheckpoint) lost the
+// reliable channel's state and carries on from nextReliableSequence.
+struct SessionResumeMessage {
+    NetMessageType type = NetMessageType::SESSION_RESUME;
+    uint32_t playerId;
+    uint32_t lastReceivedSnapshot;  // Newest snapshot the client holds (0 = none)
+    int64_t sendMicros;             // Client steady clock, echoed in JOIN_ACCEPT
+    uint16_t nextReliableSequence;  // Next reliable message the client expects
+
+    SessionResumeMessage() : playerId(0), lastReceivedSnapshot(0), sendMicros(0), nextReliableSequence(0) {}
+};
 
-    JoinMessage() : timestamp(0), sequenceNumber(0) {}
+// Sent when a decoded snapshot does not match the state hash it carried
+// (SnapshotDelta::STATE_HASH_INTERVAL): the client's copy has drifted from
+// what the server thinks it holds, and so has every delta built on it. The
+// server drops this client's baselines, so its next snapshot is a full one.
+// Repeated while snapshots keep failing the check, at most every
+// NetworkClient::STATE_RESYNC_RETRY_MS.
+struct StateResyncMessage {
+    NetMessageType type = NetMessageType::STATE_RESYNC;
+    uint32_t playerId;
+    uint32_t snapshotSequence;      // The snapshot that failed
+
+    StateResyncMessage() : playerId(0), snapshotSequence(0) {}
+};
+
+// Spectator subscription (see spectator_stream.h). Repeated every
+// SpectatorStream::REFRESH_MS; a subscription not refreshed expires
+struct SpectateMessage {
+    NetMessageType type = NetMessageType::SPECTATE_REQUEST;
+    uint16_t roomId;                // Room to watch on a multi-room server
+
+    SpectateMessage() : roomId(0) {}
+};
+
+// Sent every LanMulticast::STATUS_INTERVAL_MS while in the LAN multicast group
+struct MulticastStatusMessage {
+    NetMessageType type = NetMessageType::MULTICAST_STATUS;
+    uint32_t playerId;
+    uint32_t lastGroupFrame;        // Newest multicast frame received, 0 = none yet
+
+    MulticastStatusMessage() : playerId(0), lastGroupFrame(0) {}
+};
+
+// One window of client quality telemetry (ClientTelemetry::WINDOW_MS).
+// Histogram buckets are counts; their bounds are ClientTelemetry's. The
+// extrapolation rate is extrapolatedEntityFrames / entityFrames, the
+// misprediction rate mispredictions / reconciliations.
+struct ClientTelemetryMessage {
+    static constexpr size_t BUCKET_COUNT = 8;
+    using Buckets = std::array<uint16_t, BUCKET_COUNT>;
+
+    NetMessageType type = NetMessageType::CLIENT_TELEMETRY;
+    uint32_t playerId;
+    uint32_t windowMs;              // Time the window covers
+    Buckets frameMs;                // Frame times
+    Buckets rttMs;                  // Round trip samples
+    Buckets lossPercent;            // Packet loss, sampled once a second
+    uint32_t entityFrames;          // Remote entities drawn, summed over frames
+    uint32_t extrapolatedEntityFrames;  // Of those, drawn past their newest snapshot
+    uint32_t reconciliations;       // Server states compared against the prediction
+    uint32_t mispredictions;        // Of those, corrected
+
+    ClientTelemetryMessage() : playerId(0), windowMs(0), frameMs{}, rttMs{}, lossPercent{},
+        entityFrames(0), extrapolatedEntityFrames(0), reconciliations(0), mispredictions(0) {}
 };
 
 // Network message for player updates (sent from client to server)
@@ -180,6 +313,21 @@ struct PlayerUpdateMessage {
     }
 };
 
+// Older input repeated in later PLAYER_INPUT messages until acknowledged, so a
+// lost datagram doesn't lose the input. Barrel aim is absolute and only the
+// newest value matters, so it is not repeated.
+struct RedundantInput {
+    uint32_t sequenceNumber;
+    bool isMoving_forward;
+    bool isMoving_backward;
+    bool isMoving_left;
+    bool isMoving_right;
+
+    RedundantInput() : sequenceNumber(0), isMoving_forward(false), isMoving_backward(false),
+        isMoving_left(false), isMoving_right(false) {
+    }
+};
+
 //  Lightweight input-only message (reduces bandwidth by ~40%)
 struct PlayerInputMessage {
     NetMessageType type = NetMessageType::PLAYER_INPUT;
@@ -191,23 +339,90 @@ struct PlayerInputMessage {
     float barrelRotation;  //   Client's barrel rotation (mouse-driven)
     int64_t timestamp;
     uint32_t sequenceNumber;
+    uint32_t lastReceivedSnapshot;  // Newest GAME_STATE_DELTA decoded (snapshot ack, optional trailer)
+    uint32_t playerTableVersion;    // Newest PLAYER_LIST applied (player table ack, optional trailer)
+    bool hasReliableAck;            // Reliable channel ack (see reliable_channel.h)
+    uint16_t reliableAckSequence;
+    uint32_t reliableAckBits;
+    std::vector<RedundantInput> previousInputs;  // Unacked older inputs, newest first
+    int64_t sendMicros;             // Client steady clock at send, echoed in the ack (0 = no echo); sent wrapped
+    bool predictedStep;             // One message per prediction step; the server conceals a late one
 
     PlayerInputMessage() : playerId(0),
         isMoving_forward(false), isMoving_backward(false),
         isMoving_left(false), isMoving_right(false),
         barrelRotation(0.0f),  //   
-        timestamp(0), sequenceNumber(0) {
+        timestamp(0), sequenceNumber(0), lastReceivedSnapshot(0), playerTableVersion(0),
+        hasReliableAck(false), reliableAckSequence(0), reliableAckBits(0), sendMicros(0), predictedStep(false) {
     }
 };
 
+// Standalone reliable channel ack (client -> server), e.g. while dead and not sending input
+struct ReliableAckMessage {
+    NetMessageType type = NetMessageType::RELIABLE_ACK;
+    uint32_t playerId;
+    uint16_t ackSequence;           // Newest reliable sequence received
+    uint32_t ackBits;               // Bit i: ackSequence - 1 - i was received
+
+    ReliableAckMessage() : playerId(0), ackSequence(0), ackBits(0) {}
+};
+
 // Input acknowledgment message (server -> client)
 struct InputAcknowledgmentMessage {
     NetMessageType type = NetMessageType::INPUT_ACKNOWLEDGMENT;
     uint32_t playerId;              // Which player's input is being acknowledged
     uint32_t acknowledgedSequence;  // Last input sequence server processed
     int64_t serverTimestamp;        // When server processed this input
+    // Timing echo of the input that triggered the ack, the same four-time
+    // exchange as PING/PONG (see ClockSync): 0 when the input carried none
+    int64_t echoSendMicros;         // The input's sendMicros
+    int64_t serverReceiveMicros;    // Server steady clock at arrival
+    int64_t serverTransmitMicros;   // Server steady clock when the ack was queued
+    // Bit i: acknowledgedSequence - i was concealed, played as a repeat of the
+    // input before it (see InputJitterBuffer)
+    uint32_t concealedBits;
+
+    InputAcknowledgmentMessage() : playerId(0), acknowledgedSequence(0), serverTimestamp(0),
+        echoSendMicros(0), serverReceiveMicros(0), serverTransmitMicros(0), concealedBits(0) {}
+};
+
+// LAN fan-out group (see lan_multicast.h), offered after the join
+struct MulticastGroupMessage {
+    NetMessageType type = NetMessageType::MULTICAST_GROUP;
+    uint32_t groupAddress;          // sf::IpAddress::toInteger()
+    uint16_t groupPort;
 
-    InputAcknowledgmentMessage() : playerId(0), acknowledgedSequence(0), serverTimestamp(0) {}
+    MulticastGroupMessage() : groupAddress(0), groupPort(0) {}
+};
+
+// Multicast frames are shared, so the input ack a snapshot header carries
+// comes separately: one per frame to each client on group delivery
+struct GroupStateAckMessage {
+    NetMessageType type = NetMessageType::GROUP_STATE_ACK;
+    uint32_t frameSequence;         // Snapshot sequence of the multicast frame
+    uint32_t lastAckedInput;        // As SnapshotHeader::lastAckedInput
+    int64_t inputApplyMicros;       // As SnapshotHeader::inputApplyMicros
+
+    GroupStateAckMessage() : frameSequence(0), lastAckedInput(0), inputApplyMicros(0) {}
+};
+
+// One static obstacle (see static_obstacles.h), in whole pixels
+struct ObstacleData {
+    uint8_t kind;                   // StaticObstacles::Kind
+    uint16_t left, top;
+    uint16_t width, height;
+
+    ObstacleData() : kind(0), left(0), top(0), width(0), height(0) {}
+};
+
+// Static content of one chunk, streamed as the client's tank nears it
+struct ChunkDataMessage {
+    NetMessageType type = NetMessageType::CHUNK_DATA;
+    uint16_t chunkId;               // WorldChunks::ChunkId
+    std::vector<uint8_t> tiles;     // WorldChunks::TILE_COUNT TileKind values, row-major
+    std::vector<ObstacleData> obstacles;    // Those whose centre lies in the chunk
+
+    ChunkDataMessage() : chunkId(0) {}
 };
 struct BulletSpawnMessage {
     NetMessageType type = NetMessageType::BULLET_SPAWN;
@@ -217,13 +432,26 @@ struct BulletSpawnMessage {
     float barrelRotation;       // Visual rotation for bullet sprite
     int64_t timestamp;          // When shot was fired
     uint32_t sequenceNumber;    // For packet ordering
+    // Names the client's predicted bullet; the server bullet echoes it so the
+    // prediction is adopted in place (0 = none, older clients)
+    uint16_t spawnToken;
 
     BulletSpawnMessage()
         : playerId(0), spawnX(0.0f), spawnY(0.0f),
         directionX(1.0f), directionY(0.0f), barrelRotation(0.0f),
-        timestamp(0), sequenceNumber(0) {
+        timestamp(0), sequenceNumber(0), spawnToken(0) {
     }
 };
+// Leads the body of every server state message (GAME_STATE_DELTA, BULLET_UPDATE,
+// BULLET_SPAWNED), straight after the type byte, so the client can drop stale
+// and duplicate messages before decoding the rest
+struct StateHeader {
+    uint32_t sequence;          // Snapshot sequence, or server message sequence for bullets
+    int64_t timestamp;          // Server time the state was captured
+
+    StateHeader() : sequence(0), timestamp(0) {}
+    StateHeader(uint32_t sequence, int64_t timestamp) : sequence(sequence), timestamp(timestamp) {}
+};
 struct BulletUpdateMessage {
     NetMessageType type = NetMessageType::BULLET_UPDATE;
     std::vector<BulletData> bullets; // All active bullets
@@ -236,7 +464,7 @@ struct BulletUpdateMessage {
 struct BulletDestroyMessage {
     NetMessageType type = NetMessageType::BULLET_DESTROY;
     uint32_t bulletId;          // Which bullet was destroyed
-    uint8_t destroyReason;      // 0=Expired, 1=HitPlayer, 2=HitEnemy, 3=HitBorder
+    uint8_t destroyReason;      // 0=Expired, 1=HitPlayer, 2=HitEnemy, 3=HitBorder, 4=HitObstacle
     uint32_t hitTargetId;       // ID of what was hit (0 if none)
     float hitX, hitY;           // Where impact occurred
     int64_t timestamp;          // When destruction occurred
@@ -248,6 +476,19 @@ struct BulletDestroyMessage {
     }
 };
 
+// Area-of-interest changes for one client (server -> client).
+// IDs use the usual ranges: enemies from 1000, bullets from 10000.
+// Advisory only: snapshots and bullet updates remain the source of truth if this is lost.
+struct InterestUpdateMessage {
+    NetMessageType type = NetMessageType::INTEREST_UPDATE;
+    std::vector<uint32_t> enteredIds;   // Now replicated to this client
+    std::vector<uint32_t> leftIds;      // Still alive, but no longer replicated
+    int64_t timestamp;
+    uint32_t sequenceNumber;
+
+    InterestUpdateMessage() : timestamp(0), sequenceNumber(0) {}
+};
+
 // Network message for full game state (sent from server to clients)
 struct GameStateMessage {
     NetMessageType type = NetMessageType::GAME_STATE;
@@ -261,89 +502,344 @@ struct GameStateMessage {
     GameStateMessage() : timestamp(0), sequenceNumber(0), lastAckedInput(0) {}
 };
 
-// Network message for player list updates
+// Join-time player table entry: strings that only change on join/rename
+struct PlayerInfo {
+    uint32_t playerId;
+    std::string playerName;
+    PlayerColor color;
+
+    PlayerInfo() : playerId(0), color(PlayerColor::GREEN) {}
+};
+
+// Network message for player list updates (server -> client).
+// Sent whenever the table version changes and resent until the client
+// echoes the version back in PLAYER_INPUT.
 struct PlayerListMessage {
     NetMessageType type = NetMessageType::PLAYER_LIST;
-    std::vector<PlayerData> players;
+    uint32_t tableVersion;          // Increments on every join/leave/rename (0 = none)
+    std::vector<PlayerInfo> players;
     int64_t timestamp;              //   : Message timestamp
     uint32_t sequenceNumber;        //   : Sequence number for ordering
 
-    PlayerListMessage() : timestamp(0), sequenceNumber(0) {}
+    PlayerListMessage() : tableVersion(0), timestamp(0), sequenceNumber(0) {}
 };
 
 //  Ping message for RTT measurement
 struct PingMessage {
     NetMessageType type = NetMessageType::PING;
-    int64_t timestamp;
+    int64_t timestamp;              // Client steady clock, microseconds
     uint32_t sequenceNumber;
 
-    PingMessage() : timestamp(GetCurrentTimestamp()), sequenceNumber(0) {}
+    PingMessage() : timestamp(GetSteadyMicros()), sequenceNumber(0) {}
 };
 
-//  Pong message response
+//  Pong message response. The four times make one NTP-style clock sample
 struct PongMessage {
     NetMessageType type = NetMessageType::PONG;
-    int64_t originalTimestamp;      // Echo back the ping timestamp
+    int64_t originalTimestamp;      // Echo back the ping timestamp (client us)
     uint32_t sequenceNumber;        // Echo back sequence number
+    int64_t serverReceiveTime;      // Server steady clock when the ping was handled (us)
+    int64_t serverTransmitTime;     // Server steady clock when the pong was written (us)
 
-    PongMessage() : originalTimestamp(0), sequenceNumber(0) {}
+    PongMessage() : originalTimestamp(0), sequenceNumber(0), serverReceiveTime(0), serverTransmitTime(0) {}
 };
 
 
-// Helper functions for packet serialization/deserialization
-namespace NetworkUtils {
-    // Serialize PlayerData to packet
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerData& player);
-    sf::Packet& operator>>(sf::Packet& packet, PlayerData& player);
-
-    // Serialize messages to packets
-    sf::Packet& operator<<(sf::Packet& packet, const JoinMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, JoinMessage& msg);
-
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerUpdateMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, PlayerUpdateMessage& msg);
-
-    // Step 1.3: Input-only message serialization
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerInputMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, PlayerInputMessage& msg);
-
-    sf::Packet& operator<<(sf::Packet& packet, const GameStateMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, GameStateMessage& msg);
-
-    //   Ping/Pong serialization
-    sf::Packet& operator<<(sf::Packet& packet, const PingMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, PingMessage& msg);
-
-    sf::Packet& operator<<(sf::Packet& packet, const PongMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, PongMessage& msg);
-
-    //    Input acknowledgment serialization
-    sf::Packet& operator<<(sf::Packet& packet, const InputAcknowledgmentMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, InputAcknowledgmentMessage& msg);
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerInputMessage& msg);
-
-    sf::Packet& operator>>(sf::Packet& packet, PlayerInputMessage& msg);
-    sf::Packet& operator<<(sf::Packet& packet, const BulletData& bullet);
-
-    sf::Packet& operator>>(sf::Packet& packet, BulletData& bullet);
-
-
-    // BulletSpawnMessage serialization
-    sf::Packet& operator<<(sf::Packet& packet, const BulletSpawnMessage& msg);
+// Wire layout of the sf::Packet messages (see message_schema.h)
+namespace MessageSchema {
+    template <>
+    struct Codec<PlayerColor> {
+        static constexpr size_t MIN_SIZE = 1;
+        static constexpr bool FIXED_SIZE = true;
+
+        static void Write(sf::Packet& packet, PlayerColor color) { packet << static_cast<uint8_t>(color); }
+        // Unknown colours read as green
+        static bool Read(sf::Packet& packet, PlayerColor& color) {
+            uint8_t colorId = 0;
+            if (!(packet >> colorId)) {
+                return false;
+            }
+            color = colorId < static_cast<uint8_t>(PlayerColor::COUNT) ? static_cast<PlayerColor>(colorId) : PlayerColor::GREEN;
+            return true;
+        }
+        static size_t Size(PlayerColor) { return MIN_SIZE; }
+    };
+
+    template <>
+    struct Schema<PlayerData> {
+        using Fields = FieldList<&PlayerData::playerId, &PlayerData::x, &PlayerData::y,
+            &PlayerData::bodyRotation, &PlayerData::barrelRotation, &PlayerData::color,
+            &PlayerData::isMoving_forward, &PlayerData::isMoving_backward,
+            &PlayerData::isMoving_left, &PlayerData::isMoving_right,
+            &PlayerData::health, &PlayerData::maxHealth, &PlayerData::score, &PlayerData::isDead>;
+    };
+
+    template <>
+    struct Schema<EnemyData> {
+        using Fields = FieldList<&EnemyData::enemyId, &EnemyData::enemyType, &EnemyData::x, &EnemyData::y,
+            &EnemyData::bodyRotation, &EnemyData::barrelRotation, &EnemyData::health, &EnemyData::maxHealth>;
+    };
+
+    template <>
+    struct Schema<ObstacleData> {
+        using Fields = FieldList<&ObstacleData::kind, &ObstacleData::left, &ObstacleData::top,
+            &ObstacleData::width, &ObstacleData::height>;
+    };
+
+    template <>
+    struct Schema<PlayerInfo> {
+        using Fields = FieldList<&PlayerInfo::playerId, &PlayerInfo::playerName, &PlayerInfo::color>;
+    };
+
+    template <>
+    struct Schema<JoinMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::PLAYER_JOIN;
+        using Fields = FieldList<&JoinMessage::playerName, &JoinMessage::preferredColor,
+            &JoinMessage::timestamp, &JoinMessage::sequenceNumber>;
+        using TrailingFields = FieldList<&JoinMessage::roomId, &JoinMessage::sendMicros>;  // Older clients join room 0
+    };
+
+    template <>
+    struct Schema<JoinAcceptMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::JOIN_ACCEPT;
+        using Fields = FieldList<&JoinAcceptMessage::playerId, &JoinAcceptMessage::clientSendTime,
+            &JoinAcceptMessage::serverReceiveTime, &JoinAcceptMessage::serverTransmitTime>;
+        using TrailingFields = FieldList<&JoinAcceptMessage::tickRate>;    // Older servers tick at the default rate
+    };
+
+    template <>
+    struct Schema<SessionResumeMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::SESSION_RESUME;
+        using Fields = FieldList<&SessionResumeMessage::playerId, &SessionResumeMessage::lastReceivedSnapshot,
+            &SessionResumeMessage::sendMicros, &SessionResumeMessage::nextReliableSequence>;
+    };
+
+    template <>
+    struct Schema<StateResyncMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::STATE_RESYNC;
+        using Fields = FieldList<&StateResyncMessage::playerId, &StateResyncMessage::snapshotSequence>;
+    };
+
+    template <>
+    struct Schema<SpectateMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::SPECTATE_REQUEST;
+        using Fields = FieldList<&SpectateMessage::roomId>;
+    };
+
+    template <>
+    struct Schema<MulticastStatusMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::MULTICAST_STATUS;
+        using Fields = FieldList<&MulticastStatusMessage::playerId, &MulticastStatusMessage::lastGroupFrame>;
+    };
+
+    template <>
+    struct Schema<ClientTelemetryMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::CLIENT_TELEMETRY;
+        using Fields = FieldList<&ClientTelemetryMessage::playerId, &ClientTelemetryMessage::windowMs,
+            &ClientTelemetryMessage::frameMs, &ClientTelemetryMessage::rttMs, &ClientTelemetryMessage::lossPercent,
+            &ClientTelemetryMessage::entityFrames, &ClientTelemetryMessage::extrapolatedEntityFrames,
+            &ClientTelemetryMessage::reconciliations, &ClientTelemetryMessage::mispredictions>;
+    };
+
+    template <>
+    struct Schema<PlayerUpdateMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::PLAYER_UPDATE;
+        using Fields = FieldList<&PlayerUpdateMessage::playerId, &PlayerUpdateMessage::x, &PlayerUpdateMessage::y,
+            &PlayerUpdateMessage::bodyRotation, &PlayerUpdateMessage::barrelRotation,
+            &PlayerUpdateMessage::isMoving_forward, &PlayerUpdateMessage::isMoving_backward,
+            &PlayerUpdateMessage::isMoving_left, &PlayerUpdateMessage::isMoving_right,
+            &PlayerUpdateMessage::timestamp, &PlayerUpdateMessage::sequenceNumber>;
+    };
+
+    template <>
+    struct Schema<ReliableAckMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::RELIABLE_ACK;
+        using Fields = FieldList<&ReliableAckMessage::playerId, &ReliableAckMessage::ackSequence,
+            &ReliableAckMessage::ackBits>;
+    };
+
+    template <>
+    struct Schema<InputAcknowledgmentMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::INPUT_ACKNOWLEDGMENT;
+        using Fields = FieldList<&InputAcknowledgmentMessage::playerId, &InputAcknowledgmentMessage::acknowledgedSequence,
+            &InputAcknowledgmentMessage::serverTimestamp>;
+        using TrailingFields = FieldList<&InputAcknowledgmentMessage::echoSendMicros,
+            &InputAcknowledgmentMessage::serverReceiveMicros,
+            &InputAcknowledgmentMessage::serverTransmitMicros,
+            &InputAcknowledgmentMessage::concealedBits>;            // Older servers send no echo
+    };
+
+    template <>
+    struct Schema<MulticastGroupMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::MULTICAST_GROUP;
+        using Fields = FieldList<&MulticastGroupMessage::groupAddress, &MulticastGroupMessage::groupPort>;
+    };
+
+    template <>
+    struct Schema<GroupStateAckMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::GROUP_STATE_ACK;
+        using Fields = FieldList<&GroupStateAckMessage::frameSequence, &GroupStateAckMessage::lastAckedInput,
+            &GroupStateAckMessage::inputApplyMicros>;
+    };
+
+    template <>
+    struct Schema<ChunkDataMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::CHUNK_DATA;
+        using Fields = FieldList<&ChunkDataMessage::chunkId, &ChunkDataMessage::tiles, &ChunkDataMessage::obstacles>;
+    };
+
+    template <>
+    struct Schema<BulletSpawnMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::BULLET_SPAWN;
+        using Fields = FieldList<&BulletSpawnMessage::playerId, &BulletSpawnMessage::spawnX, &BulletSpawnMessage::spawnY,
+            &BulletSpawnMessage::directionX, &BulletSpawnMessage::directionY, &BulletSpawnMessage::barrelRotation,
+            &BulletSpawnMessage::timestamp, &BulletSpawnMessage::sequenceNumber>;
+        using TrailingFields = FieldList<&BulletSpawnMessage::spawnToken>;     // Older clients predict nothing
+    };
+
+    template <>
+    struct Schema<BulletDestroyMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::BULLET_DESTROY;
+        using Fields = FieldList<&BulletDestroyMessage::bulletId, &BulletDestroyMessage::destroyReason,
+            &BulletDestroyMessage::hitTargetId, &BulletDestroyMessage::hitX, &BulletDestroyMessage::hitY,
+            &BulletDestroyMessage::timestamp, &BulletDestroyMessage::sequenceNumber>;
+    };
+
+    template <>
+    struct Schema<PlayerDeathMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::PLAYER_DEATH;
+        using Fields = FieldList<&PlayerDeathMessage::playerId, &PlayerDeathMessage::killerId,
+            &PlayerDeathMessage::deathX, &PlayerDeathMessage::deathY, &PlayerDeathMessage::scorePenalty,
+            &PlayerDeathMessage::timestamp, &PlayerDeathMessage::sequenceNumber>;
+    };
+
+    template <>
+    struct Schema<PlayerRespawnMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::PLAYER_RESPAWN;
+        using Fields = FieldList<&PlayerRespawnMessage::playerId, &PlayerRespawnMessage::spawnX,
+            &PlayerRespawnMessage::spawnY, &PlayerRespawnMessage::health,
+            &PlayerRespawnMessage::timestamp, &PlayerRespawnMessage::sequenceNumber>;
+    };
+
+    template <>
+    struct Schema<InterestUpdateMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::INTEREST_UPDATE;
+        using Fields = FieldList<&InterestUpdateMessage::enteredIds, &InterestUpdateMessage::leftIds,
+            &InterestUpdateMessage::timestamp, &InterestUpdateMessage::sequenceNumber>;
+    };
+
+    template <>
+    struct Schema<GameStateMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::GAME_STATE;
+        using Fields = FieldList<&GameStateMessage::players, &GameStateMessage::enemies,
+            &GameStateMessage::timestamp, &GameStateMessage::sequenceNumber, &GameStateMessage::lastAckedInput>;
+    };
+
+    template <>
+    struct Schema<PlayerListMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::PLAYER_LIST;
+        using Fields = FieldList<&PlayerListMessage::tableVersion, &PlayerListMessage::players,
+            &PlayerListMessage::timestamp, &PlayerListMessage::sequenceNumber>;
+    };
+
+    template <>
+    struct Schema<PingMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::PING;
+        using Fields = FieldList<&PingMessage::timestamp, &PingMessage::sequenceNumber>;
+    };
+
+    template <>
+    struct Schema<PongMessage> {
+        static constexpr NetMessageType TYPE = NetMessageType::PONG;
+        using Fields = FieldList<&PongMessage::originalTimestamp, &PongMessage::sequenceNumber,
+            &PongMessage::serverReceiveTime, &PongMessage::serverTransmitTime>;
+    };
+}
 
-    sf::Packet& operator>>(sf::Packet& packet, BulletSpawnMessage& msg);
-    // BulletUpdateMessage serialization
-    sf::Packet& operator<<(sf::Packet& packet, const BulletUpdateMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, BulletUpdateMessage& msg);
-    // BulletDestroyMessage serialization
-    sf::Packet& operator<<(sf::Packet& packet, const BulletDestroyMessage& msg);
+// The schema messages each side receives. PLAYER_INPUT, the state messages
+// (GAME_STATE is decoded in place into the client's tables), the containers
+// and the one-field handshake messages are read by hand first.
+using ClientToServerMessages = MessageSchema::MessageSet<JoinMessage, PlayerUpdateMessage, ReliableAckMessage,
+    BulletSpawnMessage, PingMessage, SpectateMessage, MulticastStatusMessage, SessionResumeMessage,
+    StateResyncMessage, ClientTelemetryMessage>;
+using ServerToClientMessages = MessageSchema::MessageSet<PlayerListMessage, InterestUpdateMessage,
+    PongMessage, InputAcknowledgmentMessage, BulletDestroyMessage, PlayerDeathMessage, PlayerRespawnMessage,
+    MulticastGroupMessage, GroupStateAckMessage, ChunkDataMessage, JoinAcceptMessage>;
+
+// Wire precision of every quantized field, declared in one place.
+// Ranges are the NetworkValidation entity bounds; values outside are clamped.
+namespace WirePrecision {
+    constexpr int POSITION_BITS = 16;   // 1280 px / 65535 = ~0.02 px
+    constexpr int ROTATION_BITS = 12;   // 360 deg / 4096 = ~0.09 deg (wraps)
+    constexpr int VELOCITY_BITS = 16;   // 2000 px/s / 65535 = ~0.03 px/s
+    constexpr int HEALTH_BITS = 16;     // 1024 / 65535 = ~1/64 HP (also damage)
+    constexpr int LIFETIME_BITS = 16;   // 10 s / 65535 = ~0.15 ms
+    constexpr int COLOR_BITS = 2;       // PlayerColor
+    constexpr int ENEMY_TYPE_BITS = 3;  // EnemyTank::EnemyType (5 types)
+    constexpr int BULLET_TYPE_BITS = 2; // BulletStats::TYPE_COUNT
+    // Wrapping clock fields, expanded around the receiver's clock (NetworkUtils::Unwrap)
+    constexpr int INPUT_TIME_BITS = 17;     // ms: +-65 s, past NetworkValidation::MAX_TIMESTAMP_DELTA
+    constexpr int ECHO_MICROS_BITS = 32;    // Steady micros: +-35 min, only ever an RTT old
+}
 
-    sf::Packet& operator>>(sf::Packet& packet, BulletDestroyMessage& msg);
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerDeathMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, PlayerDeathMessage& msg);
+// Helper functions for packet serialization/deserialization
+namespace NetworkUtils {
+    // Quantized encoders/decoders (see WirePrecision)
+    uint16_t QuantizePositionX(float x);
+    uint16_t QuantizePositionY(float y);
+    uint16_t QuantizeRotation(float degrees);
+    uint16_t QuantizeVelocity(float velocity);
+    uint16_t QuantizeHealth(float health);
+    uint16_t QuantizeLifetime(float seconds);
+    float DequantizePositionX(uint16_t value);
+    float DequantizePositionY(uint16_t value);
+    float DequantizeRotation(uint16_t value);   // Returns [0, 360)
+    float DequantizeVelocity(uint16_t value);
+    float DequantizeHealth(uint16_t value);
+    float DequantizeLifetime(uint16_t value);
+
+    // Quantized field pairs for the bit-packed hot messages
+    void WritePosition(BitWriter& writer, float x, float y);
+    void ReadPosition(BitReader& reader, float& x, float& y);
+    void WriteRotation(BitWriter& writer, float degrees);
+    float ReadRotation(BitReader& reader);
+    void WriteHealth(BitWriter& writer, float health);
+    float ReadHealth(BitReader& reader);
+    // The value whose low bits are low nearest to reference: a clock sent
+    // wrapped, read back against the receiver's own reading of it
+    int64_t Unwrap(uint64_t low, int bits, int64_t reference);
+
+    // Player colors: enum <-> the names used by textures and the join request
+    const char* ColorName(PlayerColor color);
+    bool ColorFromName(const std::string& name, PlayerColor& color);
+    inline bool IsValidColorId(uint8_t colorId) { return colorId < static_cast<uint8_t>(PlayerColor::COUNT); }
+
+    // sf::Packet operators for every type with a schema (see message_schema.h)
+    template <typename T, typename = std::enable_if_t<MessageSchema::HAS_SCHEMA<T>>>
+    sf::Packet& operator<<(sf::Packet& packet, const T& value) {
+        MessageSchema::Encode(packet, value);
+        return packet;
+    }
+    template <typename T, typename = std::enable_if_t<MessageSchema::HAS_SCHEMA<T>>>
+    sf::Packet& operator>>(sf::Packet& packet, T& value) {
+        if (!MessageSchema::Decode(packet, value)) {
+            MessageSchema::Fail(packet);
+        }
+        return packet;
+    }
 
-    sf::Packet& operator<<(sf::Packet& packet, const PlayerRespawnMessage& msg);
-    sf::Packet& operator>>(sf::Packet& packet, PlayerRespawnMessage& msg);
+    // Bit-packed hot-path messages: the body after the message type byte.
+    // Send as packet << type, then writer.AppendTo(packet); read with BitReader::FromPacket.
+    // Read functions return false if the body was truncated or malformed.
+    void Write(BitWriter& writer, const StateHeader& header);
+    bool Read(BitReader& reader, StateHeader& header);
+    void Write(BitWriter& writer, const PlayerInputMessage& msg);
+    // nowMs: the reader's server clock, which the wrapped timestamp is expanded around
+    bool Read(BitReader& reader, PlayerInputMessage& msg, int64_t nowMs);
+    void Write(BitWriter& writer, const BulletData& bullet);
+    bool Read(BitReader& reader, BulletData& bullet);
+    void Write(BitWriter& writer, const BulletUpdateMessage& msg);
+    bool Read(BitReader& reader, BulletUpdateMessage& msg);
 }
 using NetworkUtils::operator<<;
 using NetworkUtils::operator>>;
\ No newline at end of file
@@ -17,8 +17,20 @@ namespace NetworkValidation {
     constexpr float MIN_ROTATION = -360.0f;
     constexpr float MAX_ROTATION = 720.0f;
 
+    // Outer bounds for any replicated entity (bullets fly up to the world edge);
+    // also the ranges of the quantized wire format in network_messages.cpp
+    constexpr float ENTITY_MIN_X = 0.0f;
+    constexpr float ENTITY_MAX_X = WorldConstants::WORLD_WIDTH;
+    constexpr float ENTITY_MIN_Y = 0.0f;
+    constexpr float ENTITY_MAX_Y = WorldConstants::WORLD_HEIGHT;
+    constexpr float MAX_ENTITY_SPEED = 1000.0f;    // pixels/second, per axis
+    constexpr float MAX_HEALTH_VALUE = 1024.0f;    // health, maxHealth and damage
+    constexpr float MAX_BULLET_LIFETIME = 10.0f;   // seconds
+
     // Sanity checks
     constexpr uint32_t MAX_PLAYER_COUNT = 100;
+    constexpr uint32_t MAX_BULLETS_PER_UPDATE = 1024;
+    constexpr uint32_t MAX_REDUNDANT_INPUTS = 8;   // Older inputs repeated per PLAYER_INPUT
     constexpr uint32_t MAX_PLAYER_NAME_LENGTH = 50;
     constexpr uint32_t MAX_COLOR_NAME_LENGTH = 20;
     constexpr int64_t MAX_TIMESTAMP_DELTA = 60000; // 60 seconds in milliseconds
@@ -0,0 +1,84 @@
+#include "overload_controller.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr OverloadController::Level LEVELS[OverloadController::MAX_LEVEL + 1] = {
+        { 1, 1.0f, 1.0f },
+        { 2, 1.0f, 1.0f },
+        { 2, 0.5f, 1.0f },
+        { 4, 0.25f, 0.5f }
+    };
+}
+
+/**
+ * Windows are counted in budget time rather than ticks, so the judgement
+ * covers the same span of play at any tick rate.
+ */
+bool OverloadController::RecordTick(double tickMs, double budgetMs) {
+    if (!enabled || budgetMs <= 0.0) {
+        return false;
+    }
+    windowTicks++;
+    windowMs += tickMs;
+    windowBudgetMs += budgetMs;
+    if (tickMs > budgetMs) {
+        windowOverruns++;
+    }
+    if (windowBudgetMs < WINDOW_SECONDS * 1000.0) {
+        return false;
+    }
+
+    const double load = windowMs / windowBudgetMs;
+    const double overrunFraction = static_cast<double>(windowOverruns) / static_cast<double>(windowTicks);
+    windowTicks = 0;
+    windowOverruns = 0;
+    windowMs = 0.0;
+    windowBudgetMs = 0.0;
+
+    uint8_t next = level;
+    if (load >= ESCALATE_LOAD || overrunFraction >= ESCALATE_OVERRUN_FRACTION) {
+        calmWindows = 0;
+        next = std::min<uint8_t>(level + 1, MAX_LEVEL);
+    }
+    else if (load < RECOVER_LOAD && level > 0) {
+        if (++calmWindows >= RECOVER_WINDOWS) {
+            calmWindows = 0;
+            next = level - 1;
+        }
+    }
+    else {
+        calmWindows = 0;
+    }
+
+    if (next == level) {
+        return false;
+    }
+    lastTransition.from = level;
+    lastTransition.to = next;
+    lastTransition.load = load;
+    lastTransition.overrunFraction = overrunFraction;
+    level = next;
+    transitions++;
+    return true;
+}
+
+void OverloadController::SetLevel(uint8_t newLevel) {
+    level = std::min(newLevel, MAX_LEVEL);
+    windowTicks = 0;
+    windowOverruns = 0;
+    windowMs = 0.0;
+    windowBudgetMs = 0.0;
+    calmWindows = 0;
+}
+
+const OverloadController::Level& OverloadController::GetLevelSettings() const {
+    return LEVELS[level];
+}
+
+int OverloadController::GetEnemyCap(int fullCap) const {
+    if (fullCap <= 0) {
+        return fullCap;
+    }
+    return std::max(1, static_cast<int>(std::floor(fullCap * LEVELS[level].enemyCapScale)));
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Sheds optional work while the server cannot hold its tick rate. Tick times
+// are judged over windows of WINDOW_SECONDS: a window with too many overruns
+// or too little headroom raises the level by one, and RECOVER_WINDOWS calm
+// windows in a row lower it by one again, so the server steps down and back
+// up without flapping between two levels.
+//
+//   Level  Relaxed enemy AI   Far replication   Enemy cap
+//   0      every tick         as configured     3 * (players > 0) + players
+//   1      every 2nd tick     as configured     as above
+//   2      every 2nd tick     1/2               as above
+//   3      every 4th tick     1/4               1/2 of the above
+//
+// Enemies that are fighting, fleeing or have waited MAX_AI_DEFER_SECONDS
+// always think (see GameServer::ScheduleEnemyAI); only the rest are thinned.
+class OverloadController {
+public:
+    static constexpr uint8_t MAX_LEVEL = 3;
+    static constexpr double WINDOW_SECONDS = 1.0;
+    static constexpr double ESCALATE_OVERRUN_FRACTION = 0.1;   // Of a window's ticks
+    static constexpr double ESCALATE_LOAD = 0.9;               // Average tick time / tick budget
+    static constexpr double RECOVER_LOAD = 0.6;
+    static constexpr uint32_t RECOVER_WINDOWS = 3;
+
+    // What a level gives up
+    struct Level {
+        uint32_t aiStride;          // Relaxed enemies think on one tick in this many
+        float replicationScale;     // Applied to the far player and enemy rates
+        float enemyCapScale;        // Applied to the dynamic enemy cap
+    };
+
+    // Load over the window that caused a level change
+    struct Transition {
+        uint8_t from = 0;
+        uint8_t to = 0;
+        double load = 0.0;              // Average tick time / tick budget
+        double overrunFraction = 0.0;
+    };
+
+    OverloadController() = default;
+
+    void SetEnabled(bool isEnabled) { enabled = isEnabled; }
+    bool IsEnabled() const { return enabled; }
+
+    // Feeds one tick's execution time.
+    // @param budgetMs Tick duration at the configured rate
+    // @return True if the level changed at the end of a window (see GetLastTransition)
+    bool RecordTick(double tickMs, double budgetMs);
+
+    // Forces a level (replay), clearing the current window
+    void SetLevel(uint8_t newLevel);
+
+    uint8_t GetLevel() const { return level; }
+    const Level& GetLevelSettings() const;
+    const Transition& GetLastTransition() const { return lastTransition; }
+    uint64_t GetTransitionCount() const { return transitions; }
+
+    // Dynamic enemy cap at this level, at least 1 while the full cap is
+    int GetEnemyCap(int fullCap) const;
+
+private:
+    bool enabled = true;
+    uint8_t level = 0;
+    uint32_t windowTicks = 0;
+    uint32_t windowOverruns = 0;
+    double windowMs = 0.0;
+    double windowBudgetMs = 0.0;
+    uint32_t calmWindows = 0;
+    uint64_t transitions = 0;
+    Transition lastTransition;
+};
@@ -0,0 +1,44 @@
+#include "packet_aggregator.h"
+
+/**
+ * Queues one complete message (type byte first) for the next flush.
+ * Empty packets are ignored; messages above the uint16 length prefix cannot be
+ * bundled but are still queued and will be sent on their own.
+ */
+void PacketAggregator::Queue(const sf::Packet& message) {
+    const size_t size = message.getDataSize();
+    if (size == 0) {
+        return;
+    }
+
+    MessageSpan span;
+    span.offset = static_cast<uint32_t>(bytes.size());
+    span.size = static_cast<uint32_t>(size);
+
+    const uint8_t* data = static_cast<const uint8_t*>(message.getData());
+    bytes.insert(bytes.end(), data, data + size);
+    messages.push_back(span);
+}
+
+/**
+ * Swaps the buffers when this queue is empty, so handing a tick's messages
+ * over does not copy them.
+ */
+void PacketAggregator::TakeQueued(PacketAggregator& source) {
+    if (source.messages.empty()) {
+        return;
+    }
+    if (messages.empty()) {
+        bytes.swap(source.bytes);
+        messages.swap(source.messages);
+        source.Clear();
+        return;
+    }
+    const uint32_t base = static_cast<uint32_t>(bytes.size());
+    bytes.insert(bytes.end(), source.bytes.begin(), source.bytes.end());
+    for (MessageSpan span : source.messages) {
+        span.offset += base;
+        messages.push_back(span);
+    }
+    source.Clear();
+}
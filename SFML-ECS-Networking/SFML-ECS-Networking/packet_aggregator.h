@@ -0,0 +1,178 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "network_messages.h"
+
+// Collects the messages sent to one client during a tick and packs them into
+// as few datagrams as possible when flushed. Bundle layout:
+//   [MESSAGE_BUNDLE] { [uint16 length (big-endian)][message bytes incl. type] }*
+// A datagram holding a single message goes out unwrapped, so the receiver only
+// has to understand bundles, never require them.
+//
+// A message larger than one datagram is split into fragments instead of being
+// left to IP fragmentation (where losing any piece loses the whole datagram
+// silently). Fragment layout:
+//   [MESSAGE_FRAGMENT][uint16 messageId][uint8 index][uint8 count][payload]
+// Every fragment but the last carries exactly FRAGMENT_PAYLOAD_BYTES.
+class PacketAggregator {
+public:
+    // Conservative payload limit that fits common path MTUs without IP fragmentation
+    static constexpr size_t MAX_DATAGRAM_BYTES = 1200;
+    static constexpr size_t BUNDLE_HEADER_BYTES = 1;
+    static constexpr size_t LENGTH_PREFIX_BYTES = 2;
+    static constexpr size_t FRAGMENT_HEADER_BYTES = 5;
+    static constexpr size_t FRAGMENT_PAYLOAD_BYTES = MAX_DATAGRAM_BYTES - FRAGMENT_HEADER_BYTES;
+    static constexpr size_t MAX_FRAGMENTS = 32;  // Larger messages are sent whole (and left to IP)
+
+    // Room for a few datagrams' worth of messages up front, so ordinary ticks
+    // never grow the queue or the datagram buffer
+    static constexpr size_t RESERVED_DATAGRAMS = 4;
+    static constexpr size_t RESERVED_MESSAGES = 64;
+
+    PacketAggregator() : nextFragmentedMessageId(0) {
+        bytes.reserve(RESERVED_DATAGRAMS * MAX_DATAGRAM_BYTES);
+        messages.reserve(RESERVED_MESSAGES);
+        // sf::Packet has no reserve; clearing keeps the capacity a full datagram grew
+        const std::array<uint8_t, MAX_DATAGRAM_BYTES> fullDatagram{};
+        datagram.append(fullDatagram.data(), fullDatagram.size());
+        datagram.clear();
+    }
+
+    // Copies the packet's bytes; the caller's packet may be reused immediately
+    void Queue(const sf::Packet& message);
+
+    // Builds the tick's datagrams and hands each to send(sf::Packet&)
+    // @return Number of datagrams produced
+    template <typename SendFn>
+    size_t Flush(SendFn&& send);
+
+    bool IsEmpty() const { return messages.empty(); }
+    size_t GetQueuedCount() const { return messages.size(); }
+    void Clear() { bytes.clear(); messages.clear(); }
+
+    // Moves source's queued messages to the end of this queue, in order
+    void TakeQueued(PacketAggregator& source);
+
+    // For messages flushed by another aggregator on this client's behalf
+    // (SnapshotPipeline): reserves one fragment set ID per message, so the two
+    // never reuse an ID the client may still be reassembling
+    uint16_t ReserveFragmentIds(size_t messageCount) {
+        const uint16_t first = nextFragmentedMessageId;
+        nextFragmentedMessageId = static_cast<uint16_t>(nextFragmentedMessageId + messageCount);
+        return first;
+    }
+    void SetNextFragmentId(uint16_t id) { nextFragmentedMessageId = id; }
+
+    // Receiver side: splits a bundle (type byte already extracted) and calls
+    // onMessage(sf::Packet&) for each contained message, in order. Each message
+    // is copied into scratch, which the caller keeps so its buffer is reused.
+    // @return False if the bundle was truncated or held a nested bundle
+    template <typename MessageFn>
+    static bool ForEachMessage(const sf::Packet& bundle, sf::Packet& scratch, MessageFn&& onMessage);
+
+private:
+    struct MessageSpan {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    std::vector<uint8_t> bytes;          // Queued message bytes, back to back (capacity reused)
+    std::vector<MessageSpan> messages;
+    sf::Packet datagram;                 // Reused while flushing
+    uint16_t nextFragmentedMessageId;    // Wraps; lets the receiver tell fragment sets apart
+
+    static bool FitsInBundle(size_t bundleBytes, size_t messageBytes) {
+        return bundleBytes + LENGTH_PREFIX_BYTES + messageBytes <= MAX_DATAGRAM_BYTES;
+    }
+
+    template <typename SendFn>
+    size_t SendFragments(const MessageSpan& message, SendFn& send);
+};
+
+template <typename SendFn>
+size_t PacketAggregator::Flush(SendFn&& send) {
+    size_t datagramCount = 0;
+    size_t first = 0;
+
+    while (first < messages.size()) {
+        if (messages[first].size > MAX_DATAGRAM_BYTES &&
+            messages[first].size <= FRAGMENT_PAYLOAD_BYTES * MAX_FRAGMENTS) {
+            datagramCount += SendFragments(messages[first], send);
+            ++first;
+            continue;
+        }
+
+        // Greedily extend the run while the next message still fits (order is kept)
+        size_t last = first + 1;
+        size_t bundleBytes = BUNDLE_HEADER_BYTES + LENGTH_PREFIX_BYTES + messages[first].size;
+        while (last < messages.size() && FitsInBundle(bundleBytes, messages[last].size)) {
+            bundleBytes += LENGTH_PREFIX_BYTES + messages[last].size;
+            ++last;
+        }
+
+        datagram.clear();
+        if (last - first == 1) {
+            datagram.append(bytes.data() + messages[first].offset, messages[first].size);
+        }
+        else {
+            datagram << static_cast<uint8_t>(NetMessageType::MESSAGE_BUNDLE);
+            for (size_t i = first; i < last; ++i) {
+                datagram << static_cast<uint16_t>(messages[i].size);
+                datagram.append(bytes.data() + messages[i].offset, messages[i].size);
+            }
+        }
+        send(datagram);
+        ++datagramCount;
+        first = last;
+    }
+
+    Clear();
+    return datagramCount;
+}
+
+template <typename SendFn>
+size_t PacketAggregator::SendFragments(const MessageSpan& message, SendFn& send) {
+    const size_t count = (message.size + FRAGMENT_PAYLOAD_BYTES - 1) / FRAGMENT_PAYLOAD_BYTES;
+    const uint16_t messageId = nextFragmentedMessageId++;
+
+    for (size_t index = 0; index < count; ++index) {
+        const size_t offset = index * FRAGMENT_PAYLOAD_BYTES;
+        const size_t payloadBytes = std::min<size_t>(FRAGMENT_PAYLOAD_BYTES, message.size - offset);
+
+        datagram.clear();
+        datagram << static_cast<uint8_t>(NetMessageType::MESSAGE_FRAGMENT) << messageId
+            << static_cast<uint8_t>(index) << static_cast<uint8_t>(count);
+        datagram.append(bytes.data() + message.offset + offset, payloadBytes);
+        send(datagram);
+    }
+    return count;
+}
+
+template <typename MessageFn>
+bool PacketAggregator::ForEachMessage(const sf::Packet& bundle, sf::Packet& scratch, MessageFn&& onMessage) {
+    const uint8_t* data = static_cast<const uint8_t*>(bundle.getData());
+    const size_t end = bundle.getDataSize();
+    size_t position = bundle.getReadPosition();
+
+    while (position < end) {
+        if (position + LENGTH_PREFIX_BYTES > end) {
+            return false;
+        }
+        const size_t size = (static_cast<size_t>(data[position]) << 8) | data[position + 1];
+        position += LENGTH_PREFIX_BYTES;
+        if (size == 0 || position + size > end ||
+            data[position] == static_cast<uint8_t>(NetMessageType::MESSAGE_BUNDLE)) {
+            return false;
+        }
+
+        scratch.clear();
+        scratch.append(data + position, size);
+        position += size;
+        onMessage(scratch);
+    }
+    return true;
+}
@@ -0,0 +1,238 @@
+#include "packet_capture.h"
+#include "connection_token.h"
+#include "thread_tuning.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    constexpr char MAGIC[4] = { 'T', 'G', 'P', 'C' };
+    constexpr size_t HEADER_BYTES = sizeof(MAGIC) + 2 + 1;
+    constexpr size_t RECORD_HEADER_BYTES = 8 + 1 + 4 + 2 + 1 + 2;
+
+    void Put(std::vector<uint8_t>& buffer, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    std::string RotatedPath(const std::string& path, uint32_t index) {
+        return index == 0 ? path : path + "." + std::to_string(index);
+    }
+}
+
+bool PacketCapture::Open(const std::string& path, Side side, uint64_t maxFileBytes, uint32_t fileCount) {
+    Close();
+    this->path = path;
+    this->side = side;
+    this->maxFileBytes = std::max<uint64_t>(maxFileBytes, FLUSH_BYTES);
+    this->fileCount = std::max<uint32_t>(fileCount, 1);
+    if (!OpenFile()) {
+        Utils::printMsg("Error: Could not open packet capture " + path, error);
+        return false;
+    }
+    pending.reserve(FLUSH_BYTES * 2);
+    writing.reserve(FLUSH_BYTES * 2);
+    stopping = false;
+    recordedCount = 0;
+    droppedCount = 0;
+    try {
+        writer = std::thread(&PacketCapture::Run, this);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error: Could not start packet capture writer - " + std::string(e.what()), error);
+        file.close();
+        return false;
+    }
+    Utils::printMsg("Capturing datagrams to " + path, success);
+    return true;
+}
+
+void PacketCapture::Close() {
+    if (!writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pendingReady.notify_one();
+    writer.join();
+    file.close();
+    Utils::printMsg("Packet capture closed: " + std::to_string(GetRecordedCount()) + " datagrams, " +
+        std::to_string(GetDroppedCount()) + " dropped");
+}
+
+void PacketCapture::Record(Direction direction, int64_t steadyMicros, sf::IpAddress address, unsigned short port,
+    const sf::Packet& datagram) {
+    const bool hasToken = (side == Side::SERVER) == (direction == Direction::RECEIVED);
+    const uint8_t type = PeekType(datagram, hasToken);
+    const size_t size = std::min<size_t>(datagram.getDataSize(), UINT16_MAX);
+    const uint8_t* data = static_cast<const uint8_t*>(datagram.getData());
+
+    bool wakeWriter = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || pending.size() + RECORD_HEADER_BYTES + size > MAX_PENDING_BYTES) {
+            droppedCount++;
+            return;
+        }
+        const size_t before = pending.size();
+        Put(pending, static_cast<uint64_t>(steadyMicros), 8);
+        Put(pending, static_cast<uint8_t>(direction), 1);
+        Put(pending, address.toInteger(), 4);
+        Put(pending, port, 2);
+        Put(pending, type, 1);
+        Put(pending, size, 2);
+        pending.insert(pending.end(), data, data + size);
+        recordedCount++;
+        wakeWriter = before < FLUSH_BYTES && pending.size() >= FLUSH_BYTES;
+    }
+    if (wakeWriter) {
+        pendingReady.notify_one();
+    }
+}
+
+uint64_t PacketCapture::GetRecordedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recordedCount;
+}
+
+uint64_t PacketCapture::GetDroppedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return droppedCount;
+}
+
+uint8_t PacketCapture::PeekType(const sf::Packet& datagram, bool hasConnectionToken) {
+    const size_t offset = hasConnectionToken ? ConnectionTokens::TOKEN_BYTES : 0;
+    if (datagram.getDataSize() <= offset) {
+        return 0;
+    }
+    return static_cast<const uint8_t*>(datagram.getData())[offset];
+}
+
+/**
+ * Writer loop: takes the whole pending buffer at once, at least every
+ * FLUSH_INTERVAL_MS, so recording threads only ever wait for a swap.
+ */
+void PacketCapture::Run() {
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::WORKER);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        pendingReady.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS),
+            [this] { return stopping || pending.size() >= FLUSH_BYTES; });
+        if (pending.empty()) {
+            if (stopping) {
+                return;
+            }
+            continue;
+        }
+        writing.swap(pending);
+        lock.unlock();
+        try {
+            Write(writing);
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in packet capture writer: " + std::string(e.what()), error);
+        }
+        writing.clear();
+        lock.lock();
+    }
+}
+
+bool PacketCapture::OpenFile() {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+    Put(header, VERSION, 2);
+    Put(header, static_cast<uint8_t>(side), 1);
+    file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    fileBytes = header.size();
+    return static_cast<bool>(file);
+}
+
+/**
+ * Shifts path.N to path.N+1, dropping the oldest, and starts a new file at path.
+ */
+void PacketCapture::Rotate() {
+    file.close();
+    std::remove(RotatedPath(path, fileCount - 1).c_str());
+    for (uint32_t index = fileCount - 1; index > 0; --index) {
+        std::rename(RotatedPath(path, index - 1).c_str(), RotatedPath(path, index).c_str());
+    }
+    if (!OpenFile()) {
+        Utils::printMsg("Error: Could not start a new packet capture file " + path, error);
+    }
+}
+
+void PacketCapture::Write(const std::vector<uint8_t>& bytes) {
+    if (fileBytes > HEADER_BYTES && fileBytes + bytes.size() > maxFileBytes) {
+        Rotate();
+    }
+    if (!file.is_open()) {
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    file.flush();
+    fileBytes += bytes.size();
+}
+
+bool PacketCaptureReader::Open(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    char magic[sizeof(MAGIC)];
+    uint64_t version = 0, sideValue = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !Get(version, 2) || version != PacketCapture::VERSION || !Get(sideValue, 1) || sideValue > 1) {
+        file.close();
+        return false;
+    }
+    side = static_cast<PacketCapture::Side>(sideValue);
+    return true;
+}
+
+/**
+ * A capture cut off mid-record (process killed) ends at the last whole datagram.
+ */
+bool PacketCaptureReader::Read(CapturedDatagram& out) {
+    uint64_t micros = 0;
+    if (!Get(micros, 8)) {
+        return false;   // Clean end of file
+    }
+    uint64_t direction = 0, address = 0, port = 0, type = 0, size = 0;
+    if (!Get(direction, 1) || direction > 1 || !Get(address, 4) || !Get(port, 2) || !Get(type, 1) || !Get(size, 2)) {
+        corrupt = true;
+        return false;
+    }
+    scratch.resize(static_cast<size_t>(size));
+    if (size > 0 && !file.read(reinterpret_cast<char*>(scratch.data()), static_cast<std::streamsize>(size))) {
+        corrupt = true;
+        return false;
+    }
+    out.steadyMicros = static_cast<int64_t>(micros);
+    out.direction = static_cast<PacketCapture::Direction>(direction);
+    out.address = sf::IpAddress(static_cast<uint32_t>(address));
+    out.port = static_cast<unsigned short>(port);
+    out.type = static_cast<uint8_t>(type);
+    out.packet.clear();
+    out.packet.append(scratch.data(), scratch.size());
+    return true;
+}
+
+bool PacketCaptureReader::Get(uint64_t& value, size_t bytes) {
+    uint8_t raw[8];
+    if (!file.read(reinterpret_cast<char*>(raw), static_cast<std::streamsize>(bytes))) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(raw[i]) << (8 * i);
+    }
+    return true;
+}
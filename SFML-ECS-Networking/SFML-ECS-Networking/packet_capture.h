@@ -0,0 +1,114 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/Packet.hpp>
+
+// Datagram captures for looking into lag spikes after the fact (see
+// capture_analysis.h). Every datagram a GameServer or NetworkClient sends or
+// receives is stored whole, with the time it crossed the socket, the remote
+// endpoint and its type.
+//
+// Layout, all integers little-endian:
+//   header:   "TGPC" uint16 version, uint8 side (0 server, 1 client)
+//   DATAGRAM: int64 steadyMicros, uint8 direction (0 received, 1 sent),
+//             uint32 address, uint16 port, uint8 type, uint16 size, bytes
+// The type is the first message type in the datagram (after the connection
+// token on client-to-server datagrams), so MESSAGE_BUNDLE for bundles.
+// Timestamps are GetSteadyMicros; a client's are not shifted to server time.
+class PacketCapture {
+public:
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint64_t DEFAULT_FILE_BYTES = 64ull * 1024 * 1024;
+    static constexpr uint32_t DEFAULT_FILE_COUNT = 4;
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;            // Writer wakes early past this
+    static constexpr size_t MAX_PENDING_BYTES = 8 * 1024 * 1024; // Datagrams are dropped (and counted) beyond this
+    static constexpr int64_t FLUSH_INTERVAL_MS = 200;
+
+    enum class Side : uint8_t { SERVER = 0, CLIENT = 1 };
+    enum class Direction : uint8_t { RECEIVED = 0, SENT = 1 };
+
+    ~PacketCapture() { Close(); }
+
+    // Starts the writer thread. Once path reaches maxFileBytes it is renamed to
+    // path.1 (path.1 to path.2 and so on) and a new file begins; fileCount files
+    // are kept. Each file has its own header and holds whole records, so one
+    // may run past maxFileBytes by the last batch written to it.
+    bool Open(const std::string& path, Side side,
+        uint64_t maxFileBytes = DEFAULT_FILE_BYTES, uint32_t fileCount = DEFAULT_FILE_COUNT);
+    // Writes what is pending and stops the writer
+    void Close();
+    bool IsOpen() const { return writer.joinable(); }
+
+    // Any thread. Copies the datagram into the pending buffer; never touches the disk.
+    void Record(Direction direction, int64_t steadyMicros, sf::IpAddress address, unsigned short port,
+        const sf::Packet& datagram);
+
+    uint64_t GetRecordedCount() const;
+    uint64_t GetDroppedCount() const;
+
+    // Message type of a datagram as stored in the capture (0 if empty)
+    static uint8_t PeekType(const sf::Packet& datagram, bool hasConnectionToken);
+
+private:
+    std::string path;
+    Side side = Side::SERVER;
+    uint64_t maxFileBytes = DEFAULT_FILE_BYTES;
+    uint32_t fileCount = DEFAULT_FILE_COUNT;
+
+    // Shared with the writer
+    mutable std::mutex mutex;
+    std::condition_variable pendingReady;
+    std::vector<uint8_t> pending;
+    bool stopping = false;
+    uint64_t recordedCount = 0;
+    uint64_t droppedCount = 0;
+
+    // Writer thread only
+    std::thread writer;
+    std::ofstream file;
+    std::vector<uint8_t> writing;        // Swapped with pending
+    uint64_t fileBytes = 0;
+
+    void Run();
+    bool OpenFile();
+    void Rotate();
+    void Write(const std::vector<uint8_t>& bytes);
+};
+
+struct CapturedDatagram {
+    int64_t steadyMicros = 0;
+    PacketCapture::Direction direction = PacketCapture::Direction::RECEIVED;
+    sf::IpAddress address = sf::IpAddress::LocalHost;
+    unsigned short port = 0;
+    uint8_t type = 0;
+    sf::Packet packet;
+};
+
+// Reads a capture file back one datagram at a time
+class PacketCaptureReader {
+public:
+    bool Open(const std::string& path);
+    PacketCapture::Side GetSide() const { return side; }
+
+    // Fills out with the next datagram (its packet buffer is reused).
+    // Returns false at the end of the file or on a truncated record.
+    bool Read(CapturedDatagram& out);
+
+    // True once Read stopped on something other than a clean end of file
+    bool IsCorrupt() const { return corrupt; }
+
+private:
+    std::ifstream file;
+    PacketCapture::Side side = PacketCapture::Side::SERVER;
+    std::vector<uint8_t> scratch;
+    bool corrupt = false;
+
+    bool Get(uint64_t& value, size_t bytes);
+};
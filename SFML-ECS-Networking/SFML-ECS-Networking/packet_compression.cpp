@@ -0,0 +1,317 @@
+#include "packet_compression.h"
+#include "network_messages.h"
+#include "snapshot_delta.h"
+#include "world_constants.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5;         // LZ4 rule: the block ends with literals...
+    constexpr size_t MATCH_SEARCH_LIMIT = 12;   // ...and no match starts this close to the end
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr uint8_t RUN_MASK = 15;
+
+    uint32_t Read32(const uint8_t* bytes) {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    void AppendMessage(std::vector<uint8_t>& out, const sf::Packet& packet) {
+        const uint8_t* data = static_cast<const uint8_t*>(packet.getData());
+        out.insert(out.end(), data, data + packet.getDataSize());
+    }
+
+    /**
+     * Encodes the messages that get compressed, in the shapes a freshly joined
+     * client sees: a full snapshot of a busy room, a bullet list and the player
+     * table. Values come from fixed formulas (no RNG or library distributions),
+     * so every build produces the same bytes. The tail is kept when the samples
+     * outgrow MAX_DICTIONARY_BYTES.
+     */
+    std::vector<uint8_t> BuildDictionary() {
+        std::vector<uint8_t> samples;
+        BitWriter writer;
+
+        WorldSnapshot world;
+        for (uint32_t i = 0; i < 8; ++i) {
+            PlayerData player;
+            player.playerId = i + 1;
+            player.x = WorldConstants::PLAYABLE_MIN_X + 150.0f * static_cast<float>(i + 1);
+            player.y = WorldConstants::PLAYABLE_MIN_Y + 100.0f * static_cast<float>(i % 4 + 1);
+            player.bodyRotation = 45.0f * static_cast<float>(i);
+            player.barrelRotation = player.bodyRotation;
+            player.color = static_cast<PlayerColor>(i % static_cast<uint32_t>(PlayerColor::COUNT));
+            world.players.push_back(player);
+        }
+        for (uint32_t i = 0; i < 20; ++i) {
+            EnemyData enemy;
+            enemy.enemyId = 1000 + i;
+            enemy.enemyType = static_cast<uint8_t>(i % 5);
+            enemy.x = WorldConstants::PLAYABLE_MIN_X + 60.0f * static_cast<float>(i + 1);
+            enemy.y = WorldConstants::PLAYABLE_MIN_Y + 40.0f * static_cast<float>(i % 10 + 1);
+            enemy.bodyRotation = 18.0f * static_cast<float>(i);
+            enemy.barrelRotation = enemy.bodyRotation;
+            world.enemies.push_back(enemy);
+        }
+        SnapshotHeader header;
+        header.snapshotSequence = 1;
+        writer.Reset();
+        if (SnapshotDelta::Write(writer, header, nullptr, world)) {
+            sf::Packet packet;
+            packet << static_cast<uint8_t>(NetMessageType::GAME_STATE_DELTA);
+            writer.AppendTo(packet);
+            AppendMessage(samples, packet);
+        }
+
+        BulletUpdateMessage bullets;
+        for (uint32_t i = 0; i < 24; ++i) {
+            BulletData bullet;
+            bullet.bulletId = 1 + i;
+            bullet.ownerId = i % 3 == 0 ? 1000 + i : 1 + i % 8;
+            bullet.bulletType = static_cast<uint8_t>(i % 4);
+            bullet.x = WorldConstants::PLAYABLE_MIN_X + 50.0f * static_cast<float>(i + 1);
+            bullet.y = WorldConstants::PLAYABLE_MIN_Y + 30.0f * static_cast<float>(i % 12 + 1);
+            bullet.velocityX = i % 2 == 0 ? 500.0f : -500.0f;
+            bullet.velocityY = 0.0f;
+            bullet.rotation = i % 2 == 0 ? 0.0f : 180.0f;
+            bullets.bullets.push_back(bullet);
+        }
+        writer.Reset();
+        NetworkUtils::Write(writer, bullets);
+        if (!writer.HasOverflowed()) {
+            sf::Packet packet;
+            packet << static_cast<uint8_t>(NetMessageType::BULLET_UPDATE);
+            writer.AppendTo(packet);
+            AppendMessage(samples, packet);
+        }
+
+        PlayerListMessage list;
+        for (uint32_t i = 0; i < 8; ++i) {
+            PlayerInfo info;
+            info.playerId = i + 1;
+            info.playerName = "Player";
+            info.color = static_cast<PlayerColor>(i % static_cast<uint32_t>(PlayerColor::COUNT));
+            list.players.push_back(info);
+        }
+        sf::Packet listPacket;
+        listPacket << list;
+        AppendMessage(samples, listPacket);
+
+        if (samples.size() > PacketCompressor::MAX_DICTIONARY_BYTES) {
+            samples.erase(samples.begin(), samples.end() - PacketCompressor::MAX_DICTIONARY_BYTES);
+        }
+        return samples;
+    }
+}
+
+/**
+ * Builds the dictionary and hashes every position in it once; each message
+ * starts its match search from a copy of that table.
+ */
+PacketCompressor::PacketCompressor()
+    : dictionarySize(0), dictionaryId(0), dictionaryTable(size_t(1) << HASH_BITS, 0) {
+    window = BuildDictionary();
+    dictionarySize = window.size();
+
+    // FNV-1a folded to 16 bits; 0 is reserved for "no dictionary"
+    uint32_t hash = 2166136261u;
+    for (uint8_t byte : window) {
+        hash = (hash ^ byte) * 16777619u;
+    }
+    dictionaryId = static_cast<uint16_t>((hash >> 16) ^ hash);
+    if (dictionaryId == 0) {
+        dictionaryId = 1;
+    }
+
+    for (size_t position = 0; position + MIN_MATCH <= dictionarySize; ++position) {
+        dictionaryTable[Hash(window.data() + position)] = static_cast<uint32_t>(position + 1);
+    }
+}
+
+uint32_t PacketCompressor::Hash(const uint8_t* bytes) {
+    return (Read32(bytes) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void PacketCompressor::WriteLength(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+void PacketCompressor::EmitSequence(const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+    const size_t matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+    block.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, RUN_MASK) << 4) |
+        std::min<size_t>(matchCode, RUN_MASK)));
+    if (literalCount >= RUN_MASK) {
+        WriteLength(block, literalCount - RUN_MASK);
+    }
+    block.insert(block.end(), literals, literals + literalCount);
+    if (matchLength == 0) {
+        return;
+    }
+    block.push_back(static_cast<uint8_t>(offset & 0xFF));
+    block.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= RUN_MASK) {
+        WriteLength(block, matchCode - RUN_MASK);
+    }
+}
+
+/**
+ * Greedy single-probe LZ4 parse over dictionary + message: one hash lookup
+ * per position, the candidate is taken if its first four bytes really match,
+ * then extended forwards (and backwards over pending literals). Gives up on
+ * the message if the block would not be smaller than the envelope it saves.
+ */
+bool PacketCompressor::Compress(const sf::Packet& message, sf::Packet& outEnvelope) {
+    const size_t rawSize = message.getDataSize();
+    if (rawSize <= ENVELOPE_HEADER_BYTES + MATCH_SEARCH_LIMIT || rawSize > MAX_RAW_BYTES) {
+        return false;
+    }
+
+    window.resize(dictionarySize);
+    const uint8_t* raw = static_cast<const uint8_t*>(message.getData());
+    window.insert(window.end(), raw, raw + rawSize);
+    table = dictionaryTable;
+    block.clear();
+
+    const uint8_t* base = window.data();
+    const size_t end = window.size();
+    const size_t matchLimit = end - LAST_LITERALS;
+    const size_t searchLimit = end - MATCH_SEARCH_LIMIT;
+    size_t anchor = dictionarySize;
+    size_t position = dictionarySize;
+
+    while (position < searchLimit) {
+        const uint32_t hash = Hash(base + position);
+        const uint32_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(position + 1);
+        if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET ||
+            Read32(base + candidate - 1) != Read32(base + position)) {
+            position++;
+            continue;
+        }
+
+        size_t reference = candidate - 1;
+        while (position > anchor && reference > 0 && base[position - 1] == base[reference - 1]) {
+            position--;
+            reference--;
+        }
+        size_t length = MIN_MATCH;
+        while (position + length < matchLimit && base[reference + length] == base[position + length]) {
+            length++;
+        }
+
+        EmitSequence(base + anchor, position - anchor, position - reference, length);
+        position += length;
+        anchor = position;
+        if (position - 2 < searchLimit) {
+            table[Hash(base + position - 2)] = static_cast<uint32_t>(position - 1);
+        }
+    }
+    EmitSequence(base + anchor, end - anchor, 0, 0);
+
+    if (block.size() + ENVELOPE_HEADER_BYTES >= rawSize) {
+        return false;
+    }
+
+    outEnvelope.clear();
+    outEnvelope << static_cast<uint8_t>(NetMessageType::COMPRESSED_MESSAGE) << dictionaryId
+        << static_cast<uint16_t>(rawSize);
+    outEnvelope.append(block.data(), block.size());
+    return true;
+}
+
+/**
+ * Decodes into the window behind the dictionary, so offsets reaching past
+ * the start of the message land in the dictionary without any special case.
+ * Every length is checked against both buffers before it is used.
+ */
+bool PacketCompressor::Decompress(const sf::Packet& envelope, sf::Packet& outMessage) {
+    const uint8_t* source = static_cast<const uint8_t*>(envelope.getData());
+    size_t in = envelope.getReadPosition();
+    const size_t inEnd = envelope.getDataSize();
+    if (in + ENVELOPE_HEADER_BYTES - 1 > inEnd) {
+        return false;
+    }
+    const uint16_t id = static_cast<uint16_t>((source[in] << 8) | source[in + 1]);
+    const size_t rawSize = (static_cast<size_t>(source[in + 2]) << 8) | source[in + 3];
+    in += ENVELOPE_HEADER_BYTES - 1;
+    if (id != dictionaryId || rawSize == 0) {
+        return false;
+    }
+
+    window.resize(dictionarySize + rawSize);
+    uint8_t* base = window.data();
+    size_t out = dictionarySize;
+    const size_t outEnd = window.size();
+
+    const auto readLength = [&](size_t& length) {
+        uint8_t extra;
+        do {
+            if (in >= inEnd) {
+                return false;
+            }
+            extra = source[in++];
+            length += extra;
+        } while (extra == 255);
+        return true;
+    };
+
+    while (true) {
+        if (in >= inEnd) {
+            return false;
+        }
+        const uint8_t token = source[in++];
+
+        size_t literalCount = token >> 4;
+        if (literalCount == RUN_MASK && !readLength(literalCount)) {
+            return false;
+        }
+        if (literalCount > inEnd - in || literalCount > outEnd - out) {
+            return false;
+        }
+        std::memcpy(base + out, source + in, literalCount);
+        in += literalCount;
+        out += literalCount;
+
+        if (in == inEnd) {
+            break;
+        }
+
+        if (in + 2 > inEnd) {
+            return false;
+        }
+        const size_t offset = source[in] | (static_cast<size_t>(source[in + 1]) << 8);
+        in += 2;
+        size_t matchLength = token & RUN_MASK;
+        if (matchLength == RUN_MASK && !readLength(matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > out || matchLength > outEnd - out) {
+            return false;
+        }
+
+        const uint8_t* match = base + out - offset;
+        if (offset >= matchLength) {
+            std::memcpy(base + out, match, matchLength);
+        }
+        else {
+            for (size_t i = 0; i < matchLength; ++i) {
+                base[out + i] = match[i];  // Overlapping: repeats the last offset bytes
+            }
+        }
+        out += matchLength;
+    }
+
+    if (out != outEnd) {
+        return false;
+    }
+    outMessage.clear();
+    outMessage.append(base + dictionarySize, rawSize);
+    return true;
+}
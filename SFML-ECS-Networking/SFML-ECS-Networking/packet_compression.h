@@ -0,0 +1,59 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LZ4-style block compression for large messages (full snapshots after a join,
+// long bullet lists, the player table). Applied per message, before bundling
+// and fragmentation; a compressed message travels in an envelope whose type
+// byte is the flag:
+//   [COMPRESSED_MESSAGE][uint16 dictionaryId][uint16 rawSize][LZ4 block]
+// rawSize is the original message (type byte included). Matches may reach back
+// into a preset dictionary built the same way on both ends from sample
+// encodings of our own messages, so even the first full snapshot finds its
+// repeated layouts. A receiver whose dictionary id differs drops the message.
+//
+// The block layout is LZ4's (token, literals, 16-bit offset, match length),
+// and the decoder is a bounds-checked copy loop: a few microseconds for the
+// largest message.
+class PacketCompressor {
+public:
+    static constexpr size_t ENVELOPE_HEADER_BYTES = 5;
+    static constexpr size_t MAX_RAW_BYTES = 65535;
+    static constexpr size_t MAX_DICTIONARY_BYTES = 4096;
+
+    PacketCompressor();
+
+    PacketCompressor(const PacketCompressor&) = delete;
+    PacketCompressor& operator=(const PacketCompressor&) = delete;
+
+    // @param message Complete message (type byte first)
+    // @param outEnvelope Receives the envelope, only when it is smaller than message
+    // @return True if outEnvelope was filled
+    bool Compress(const sf::Packet& message, sf::Packet& outEnvelope);
+
+    // @param envelope Packet positioned after the COMPRESSED_MESSAGE type byte
+    // @param outMessage Receives the original message (type byte first)
+    // @return False for a foreign dictionary or a corrupt block
+    bool Decompress(const sf::Packet& envelope, sf::Packet& outMessage);
+
+    uint16_t GetDictionaryId() const { return dictionaryId; }
+    size_t GetDictionarySize() const { return dictionarySize; }
+
+private:
+    static constexpr int HASH_BITS = 12;
+
+    size_t dictionarySize;
+    uint16_t dictionaryId;
+    std::vector<uint32_t> dictionaryTable;  // Hash -> dictionary position + 1 (0 = empty)
+    std::vector<uint32_t> table;            // Working copy per message
+    std::vector<uint8_t> window;            // Dictionary, then the message (kept between calls)
+    std::vector<uint8_t> block;
+
+    static uint32_t Hash(const uint8_t* bytes);
+    static void WriteLength(std::vector<uint8_t>& out, size_t length);
+
+    // Appends one sequence: literals, then a match unless matchLength is 0
+    void EmitSequence(const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength);
+};
@@ -0,0 +1,42 @@
+#include "packet_pool.h"
+
+PacketPool::PacketPool() : created(0) {
+    for (size_t i = 0; i < INITIAL_PACKETS; ++i) {
+        available.push_back(Create());
+    }
+}
+
+PacketPool::Lease::~Lease() {
+    if (packet) {
+        pool->Return(std::move(packet));
+    }
+}
+
+PacketPool::Lease PacketPool::Borrow() {
+    if (available.empty()) {
+        return Lease(*this, Create());
+    }
+    std::unique_ptr<sf::Packet> packet = std::move(available.back());
+    available.pop_back();
+    return Lease(*this, std::move(packet));
+}
+
+/**
+ * sf::Packet has no reserve: writing RESERVED_BYTES and clearing leaves the
+ * buffer that size. The free list grows with the pool, so returning never
+ * allocates either.
+ */
+std::unique_ptr<sf::Packet> PacketPool::Create() {
+    static const std::vector<std::byte> filler(RESERVED_BYTES);
+    auto packet = std::make_unique<sf::Packet>();
+    packet->append(filler.data(), filler.size());
+    packet->clear();
+    created++;
+    available.reserve(created);
+    return packet;
+}
+
+void PacketPool::Return(std::unique_ptr<sf::Packet> packet) {
+    packet->clear();
+    available.push_back(std::move(packet));
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Send buffers for building outgoing messages. A packet is borrowed for one
+// send and comes back cleared with its capacity intact, so once the pool is
+// warm, building a message does not allocate. Packets start with
+// RESERVED_BYTES of capacity (a full datagram), which covers every
+// fixed-size message without growth.
+//
+// Borrowing from an empty pool creates another packet, so a send made while
+// building another message (a death broadcast during hit handling) simply
+// takes a second one. The pool is not thread-safe: each sending thread uses
+// its own.
+class PacketPool {
+public:
+    static constexpr size_t RESERVED_BYTES = 1200;  // PacketAggregator::MAX_DATAGRAM_BYTES
+    static constexpr size_t INITIAL_PACKETS = 4;
+
+    // A borrowed packet, returned to its pool when the lease goes out of scope
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : pool(other.pool), packet(std::move(other.packet)) {}
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        sf::Packet& operator*() const { return *packet; }
+        sf::Packet* operator->() const { return packet.get(); }
+
+    private:
+        friend class PacketPool;
+        Lease(PacketPool& pool, std::unique_ptr<sf::Packet> packet) : pool(&pool), packet(std::move(packet)) {}
+
+        PacketPool* pool;
+        std::unique_ptr<sf::Packet> packet;
+    };
+
+    PacketPool();
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // An empty packet; must be returned (the lease destroyed) before the pool is
+    Lease Borrow();
+
+    size_t GetFreeCount() const { return available.size(); }
+    // Packets created so far; stops growing once the deepest nesting was seen
+    size_t GetCreatedCount() const { return created; }
+    // Every packet created at its reserved size (borrowed ones included)
+    size_t GetApproximateBytes() const {
+        return created * (sizeof(sf::Packet) + RESERVED_BYTES) + available.capacity() * sizeof(available[0]);
+    }
+
+private:
+    std::vector<std::unique_ptr<sf::Packet>> available;
+    size_t created;
+
+    std::unique_ptr<sf::Packet> Create();
+    void Return(std::unique_ptr<sf::Packet> packet);
+};
@@ -0,0 +1,131 @@
+#include "particle_system.h"
+#include "AssetManager.h"
+#include "sprite_batch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr float DRAG = 4.0f;                // Velocity lost per second, as a fraction
+    const sf::Color IMPACT_COLOR(255, 210, 120);
+    const sf::Color EXPLOSION_COLOR(255, 150, 60);
+    const sf::Color FLASH_COLOR(255, 240, 200);
+}
+
+ParticleSystem::ParticleSystem()
+    : count(0), dropped(0), random(std::random_device{}()) {
+}
+
+void ParticleSystem::Initialize() {
+    const AssetManager::SpriteRegion spark = AssetManager::Instance().LoadSprite("Assets/explosionParticle.png", false);
+    const AssetManager::SpriteRegion flash = AssetManager::Instance().LoadSprite("Assets/muzzleFlash.png", false);
+    regions[SPARK] = Region{ spark.texture, spark.rect };
+    regions[FLASH] = Region{ flash.texture, flash.rect };
+    count = 0;
+}
+
+float ParticleSystem::Random(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(random);
+}
+
+/**
+ * Impacts throw a spray of sparks, deaths a large flash plus a slower ring of
+ * embers, shots a short flash at the muzzle and a few sparks along the barrel.
+ */
+void ParticleSystem::Emit(const EffectEvent& event) {
+    switch (event.kind) {
+    case EffectKind::BULLET_IMPACT:
+        EmitBurst(event.position, event.angle, sf::degrees(180.0f), 10, 60.0f, 180.0f, 0.15f, 0.35f, 6.0f, IMPACT_COLOR);
+        break;
+    case EffectKind::TANK_EXPLOSION:
+        Spawn(FLASH, event.position, {}, 0.18f, 48.0f, 72.0f, FLASH_COLOR);
+        EmitBurst(event.position, event.angle, sf::degrees(180.0f), 48, 40.0f, 220.0f, 0.4f, 0.9f, 14.0f, EXPLOSION_COLOR);
+        break;
+    case EffectKind::MUZZLE_FLASH:
+        Spawn(FLASH, event.position, {}, 0.08f, 22.0f, 10.0f, FLASH_COLOR);
+        EmitBurst(event.position, event.angle, sf::degrees(20.0f), 3, 80.0f, 160.0f, 0.08f, 0.15f, 4.0f, IMPACT_COLOR);
+        break;
+    }
+}
+
+void ParticleSystem::EmitBurst(sf::Vector2f position, sf::Angle direction, sf::Angle spread, int particles,
+    float minSpeed, float maxSpeed, float minLife, float maxLife, float size, sf::Color tint) {
+    const float spreadRadians = spread.asRadians();
+    const int scaled = static_cast<int>(static_cast<float>(particles) * burstScale + 0.5f);
+    for (int i = 0; i < scaled; ++i) {
+        const float angle = direction.asRadians() + Random(-spreadRadians, spreadRadians);
+        const float speed = Random(minSpeed, maxSpeed);
+        Spawn(SPARK, position, sf::Vector2f(std::cos(angle), std::sin(angle)) * speed,
+            Random(minLife, maxLife), size, size * 0.2f, tint);
+    }
+}
+
+void ParticleSystem::Spawn(ParticleImage particleImage, sf::Vector2f position, sf::Vector2f velocity, float life,
+    float sizeFrom, float sizeTo, sf::Color tint) {
+    if (count == CAPACITY) {
+        dropped++;
+        return;
+    }
+    const size_t i = count++;
+    positionX[i] = position.x;
+    positionY[i] = position.y;
+    velocityX[i] = velocity.x;
+    velocityY[i] = velocity.y;
+    age[i] = 0.0f;
+    lifetime[i] = life;
+    startSize[i] = sizeFrom;
+    endSize[i] = sizeTo;
+    color[i] = tint;
+    image[i] = particleImage;
+}
+
+/**
+ * Ages and moves every live particle, then compacts: an expired particle is
+ * overwritten by the last live one, so the live range stays contiguous.
+ */
+void ParticleSystem::Update(float deltaTime) {
+    const float damping = std::max(0.0f, 1.0f - DRAG * deltaTime);
+    for (size_t i = 0; i < count; ++i) {
+        age[i] += deltaTime;
+        positionX[i] += velocityX[i] * deltaTime;
+        positionY[i] += velocityY[i] * deltaTime;
+        velocityX[i] *= damping;
+        velocityY[i] *= damping;
+    }
+
+    size_t i = 0;
+    while (i < count) {
+        if (age[i] < lifetime[i]) {
+            ++i;
+            continue;
+        }
+        const size_t last = --count;
+        positionX[i] = positionX[last];
+        positionY[i] = positionY[last];
+        velocityX[i] = velocityX[last];
+        velocityY[i] = velocityY[last];
+        age[i] = age[last];
+        lifetime[i] = lifetime[last];
+        startSize[i] = startSize[last];
+        endSize[i] = endSize[last];
+        color[i] = color[last];
+        image[i] = image[last];
+    }
+}
+
+/**
+ * Size blends from start to end over the lifetime and alpha fades out.
+ */
+void ParticleSystem::SubmitTo(SpriteBatch& batch) const {
+    for (size_t i = 0; i < count; ++i) {
+        const Region& region = regions[image[i]];
+        if (!region.texture) {
+            continue;
+        }
+        const float t = std::min(age[i] / lifetime[i], 1.0f);
+        const float size = startSize[i] + (endSize[i] - startSize[i]) * t;
+        sf::Color tint = color[i];
+        tint.a = static_cast<uint8_t>(255.0f * (1.0f - t));
+        batch.AddTexturedRect(RenderLayer::EFFECTS, region.texture.get(), region.rect,
+            sf::FloatRect({ positionX[i] - size / 2.0f, positionY[i] - size / 2.0f }, { size, size }), tint);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+
+class SpriteBatch;
+
+// Gameplay moments that spawn effects and sounds. NetworkClient queues them
+// from BULLET_SPAWNED, BULLET_DESTROY and PLAYER_DEATH; MultiplayerGame adds
+// local muzzle flashes.
+enum class EffectKind : uint8_t {
+    BULLET_IMPACT,      // Bullet hit a tank, an enemy or the border
+    TANK_EXPLOSION,     // Player died
+    MUZZLE_FLASH        // Shot fired; angle is the barrel direction
+};
+
+struct EffectEvent {
+    EffectKind kind;
+    sf::Vector2f position;
+    sf::Angle angle;
+};
+
+// Fixed-capacity particle pool. Particles are stored as parallel arrays
+// (structure of arrays) so Update streams through only the fields it needs;
+// live particles are packed at the front and removed by swapping in the
+// last one. Emitting into a full pool drops the new particles, so a heavy
+// firefight never allocates. Everything is submitted to one sprite batch
+// layer, whose textures come from the atlas, so it adds no draw calls.
+class ParticleSystem {
+public:
+    static constexpr size_t CAPACITY = 2048;
+
+    ParticleSystem();
+
+    // Looks up the spark and flash images (atlas regions once it is built)
+    void Initialize();
+
+    void Emit(const EffectEvent& event);
+    void Update(float deltaTime);
+    void SubmitTo(SpriteBatch& batch) const;
+    void Clear() { count = 0; }
+    // Scales the spark count of every burst (quality tiers); single flashes are kept
+    void SetBurstScale(float scale) { burstScale = std::clamp(scale, 0.0f, 1.0f); }
+
+    size_t GetActiveCount() const { return count; }
+    uint64_t GetDroppedCount() const { return dropped; }
+
+private:
+    enum ParticleImage : uint8_t { SPARK, FLASH, IMAGE_COUNT };
+
+    struct Region {
+        std::shared_ptr<const sf::Texture> texture;
+        sf::IntRect rect;
+    };
+
+    // One particle per index across every array
+    std::array<float, CAPACITY> positionX;
+    std::array<float, CAPACITY> positionY;
+    std::array<float, CAPACITY> velocityX;
+    std::array<float, CAPACITY> velocityY;
+    std::array<float, CAPACITY> age;
+    std::array<float, CAPACITY> lifetime;
+    std::array<float, CAPACITY> startSize;
+    std::array<float, CAPACITY> endSize;
+    std::array<sf::Color, CAPACITY> color;
+    std::array<uint8_t, CAPACITY> image;
+    size_t count;
+    uint64_t dropped;
+    float burstScale = 1.0f;
+
+    std::array<Region, IMAGE_COUNT> regions;
+    std::mt19937 random;
+
+    float Random(float min, float max);
+    // Spreads `particles` sparks from position, within `spread` of direction
+    void EmitBurst(sf::Vector2f position, sf::Angle direction, sf::Angle spread, int particles,
+        float minSpeed, float maxSpeed, float minLife, float maxLife, float size, sf::Color tint);
+    void Spawn(ParticleImage image, sf::Vector2f position, sf::Vector2f velocity, float life,
+        float sizeFrom, float sizeTo, sf::Color tint);
+};
@@ -0,0 +1,90 @@
+#include "position_history.h"
+#include <algorithm>
+
+PositionHistory::PositionHistory() : newest(HISTORY_FRAMES - 1), frameCount(0) {
+    for (Frame& frame : frames) {
+        frame.timeMs = 0;
+    }
+}
+
+void PositionHistory::BeginFrame(int64_t timeMs) {
+    newest = (newest + 1) % HISTORY_FRAMES;
+    if (frameCount < HISTORY_FRAMES) {
+        frameCount++;
+    }
+    Frame& frame = frames[newest];
+    frame.timeMs = timeMs;
+    frame.entries.clear();
+}
+
+void PositionHistory::Add(uint32_t id, sf::Vector2f position) {
+    frames[newest].entries.push_back(Entry{ id, position });
+}
+
+void PositionHistory::EndFrame() {
+    std::vector<Entry>& entries = frames[newest].entries;
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.id < b.id; });
+}
+
+/**
+ * Walks back from the newest frame to the first one recorded at or before
+ * timeMs and blends it with the frame after it. An entity that only exists in
+ * one of the two (spawned or removed in between) takes that frame's position.
+ */
+bool PositionHistory::Sample(uint32_t id, int64_t timeMs, sf::Vector2f& outPosition) const {
+    if (frameCount == 0) {
+        return false;
+    }
+
+    size_t age = 0;
+    while (age + 1 < frameCount && FrameAt(age).timeMs > timeMs) {
+        age++;
+    }
+
+    const Frame& older = FrameAt(age);
+    const Entry* from = Find(older, id);
+    if (age == 0 || older.timeMs >= timeMs) {
+        // At or past the newest frame, or before the oldest one: nothing to blend
+        if (from) {
+            outPosition = from->position;
+            return true;
+        }
+        return false;
+    }
+
+    const Frame& newer = FrameAt(age - 1);
+    const Entry* to = Find(newer, id);
+    if (!from || !to) {
+        const Entry* only = from ? from : to;
+        if (!only) {
+            return false;
+        }
+        outPosition = only->position;
+        return true;
+    }
+
+    const int64_t span = newer.timeMs - older.timeMs;
+    const float t = span > 0 ? static_cast<float>(timeMs - older.timeMs) / static_cast<float>(span) : 1.0f;
+    outPosition = from->position + (to->position - from->position) * t;
+    return true;
+}
+
+int64_t PositionHistory::GetOldestTime() const {
+    return frameCount == 0 ? 0 : FrameAt(frameCount - 1).timeMs;
+}
+
+void PositionHistory::Clear() {
+    for (Frame& frame : frames) {
+        frame.entries.clear();
+        frame.timeMs = 0;
+    }
+    newest = HISTORY_FRAMES - 1;
+    frameCount = 0;
+}
+
+const PositionHistory::Entry* PositionHistory::Find(const Frame& frame, uint32_t id) {
+    auto it = std::lower_bound(frame.entries.begin(), frame.entries.end(), id,
+        [](const Entry& entry, uint32_t value) { return entry.id < value; });
+    return (it != frame.entries.end() && it->id == id) ? &*it : nullptr;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed ring of recent per-tick entity positions, used to rewind hit tests to
+// the moment a shooter was looking at. Each frame is one tick's positions
+// sorted by ID; frames and their entry buffers are reused, so recording does
+// not allocate once the entity count has peaked.
+class PositionHistory {
+public:
+    static constexpr size_t HISTORY_FRAMES = 64;  // ~1 s at 60 Hz, ~0.27 s at the 240 Hz maximum
+
+    struct Entry {
+        uint32_t id;
+        sf::Vector2f position;
+    };
+
+    PositionHistory();
+
+    // Starts recording a tick into the oldest frame (overwriting it)
+    void BeginFrame(int64_t timeMs);
+    void Add(uint32_t id, sf::Vector2f position);
+    // Sorts the frame started by BeginFrame so it can be sampled
+    void EndFrame();
+
+    // Position of id at timeMs, interpolated between the two recorded frames
+    // around it. Times outside the history are clamped to its oldest/newest
+    // frame. @return False if id was in neither frame
+    bool Sample(uint32_t id, int64_t timeMs, sf::Vector2f& outPosition) const;
+
+    size_t GetFrameCount() const { return frameCount; }
+    int64_t GetOldestTime() const;
+    void Clear();
+
+private:
+    struct Frame {
+        int64_t timeMs;
+        std::vector<Entry> entries;   // Sorted by id after EndFrame
+    };
+
+    std::array<Frame, HISTORY_FRAMES> frames;
+    size_t newest;        // Index of the most recent frame
+    size_t frameCount;    // Frames recorded so far, up to HISTORY_FRAMES
+
+    // Frame age 0 is the newest
+    const Frame& FrameAt(size_t age) const { return frames[(newest + HISTORY_FRAMES - age) % HISTORY_FRAMES]; }
+    static const Entry* Find(const Frame& frame, uint32_t id);
+};
@@ -0,0 +1,91 @@
+#include "precise_wait.h"
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002     // Older SDKs
+#endif
+#endif
+
+namespace {
+    // Sleeping is only trusted up to this much before a deadline; the rest is spun
+    constexpr auto SPIN_THRESHOLD = std::chrono::microseconds(2000);
+#ifdef _WIN32
+    // Same for a high-resolution waitable timer, which wakes within a few hundred microseconds
+    constexpr auto TIMER_SPIN_THRESHOLD = std::chrono::microseconds(500);
+#endif
+}
+
+PreciseWaiter::~PreciseWaiter() {
+#ifdef _WIN32
+    if (timerPeriodRaised) {
+        timeEndPeriod(1);
+    }
+    if (waitTimer) {
+        CloseHandle(waitTimer);
+    }
+#endif
+}
+
+/**
+ * Safe to call again: what is already set up is kept, a missing timer is
+ * asked for once more.
+ */
+bool PreciseWaiter::Start(bool highResolutionTimer) {
+#ifdef _WIN32
+    if (!timerPeriodRaised) {
+        timerPeriodRaised = (timeBeginPeriod(1) == TIMERR_NOERROR);
+    }
+    if (!waitTimer && highResolutionTimer) {
+        waitTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        return waitTimer != nullptr;
+    }
+#else
+    (void)highResolutionTimer;
+#endif
+    return true;
+}
+
+/**
+ * Sleeps in 1 ms steps while far from the deadline (or once on the waitable
+ * timer, up to its shorter threshold) and yields for the final stretch for
+ * precise pacing.
+ */
+void PreciseWaiter::WaitUntil(Clock::time_point deadline) const {
+
+#ifdef _WIN32
+    if (waitTimer) {
+        const Clock::duration sleepFor = deadline - Clock::now() - TIMER_SPIN_THRESHOLD;
+        if (sleepFor > Clock::duration::zero()) {
+            LARGE_INTEGER due;
+            due.QuadPart = -static_cast<LONGLONG>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(sleepFor).count() / 100);     // Relative, 100 ns units
+            if (SetWaitableTimer(waitTimer, &due, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(waitTimer, INFINITE);
+            }
+        }
+    }
+#endif
+
+    while (true) {
+        Clock::duration remaining = deadline - Clock::now();
+        if (remaining <= Clock::duration::zero()) {
+            break;
+        }
+        if (remaining > SPIN_THRESHOLD) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
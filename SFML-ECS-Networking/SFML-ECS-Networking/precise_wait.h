@@ -0,0 +1,30 @@
+#pragma once
+#include <chrono>
+
+// Waits for a steady-clock deadline more precisely than the OS sleep
+// granularity: 1 ms sleeps while far from it, then yields for the final
+// stretch. On Windows, Start raises the system timer resolution to 1 ms
+// (otherwise a 1 ms sleep rounds up to the ~15.6 ms system tick) and can use
+// a high-resolution waitable timer (Windows 10 1803 and later), which wakes
+// within a few hundred microseconds, instead of the sleeps.
+// Used by TickScheduler for server ticks and FramePacer for client frames.
+class PreciseWaiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    PreciseWaiter() = default;
+    ~PreciseWaiter();
+
+    PreciseWaiter(const PreciseWaiter&) = delete;
+    PreciseWaiter& operator=(const PreciseWaiter&) = delete;
+
+    // @param highResolutionTimer Also ask for the waitable timer
+    // @return False if the waitable timer was asked for but is unavailable
+    bool Start(bool highResolutionTimer);
+
+    void WaitUntil(Clock::time_point deadline) const;
+
+private:
+    bool timerPeriodRaised = false;     // Windows: raised the system timer resolution
+    void* waitTimer = nullptr;          // Windows: high-resolution waitable timer, or nullptr
+};
@@ -0,0 +1,217 @@
+#include "projectile_pool.h"
+#include "memory_report.h"
+#include "static_obstacles.h"
+#include "world_constants.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Seconds until a coordinate moving at velocity leaves [minimum, maximum];
+    // 0 if it starts outside, infinity if it never leaves
+    double ExitTime(float origin, float velocity, float minimum, float maximum) {
+        if (origin < minimum || origin > maximum) {
+            return 0.0;
+        }
+        if (velocity > 0.0f) {
+            return (static_cast<double>(maximum) - origin) / velocity;
+        }
+        if (velocity < 0.0f) {
+            return (static_cast<double>(minimum) - origin) / velocity;
+        }
+        return std::numeric_limits<double>::infinity();
+    }
+}
+
+ProjectilePool::ProjectilePool(size_t initialCapacity) : now(0.0), previousNow(0.0), obstacles(nullptr) {
+    originX.reserve(initialCapacity);
+    originY.reserve(initialCapacity);
+    velX.reserve(initialCapacity);
+    velY.reserve(initialCapacity);
+    spawnTime.reserve(initialCapacity);
+    endTime.reserve(initialCapacity);
+    ended.reserve(initialCapacity);
+    endReason.reserve(initialCapacity);
+    lifetime.reserve(initialCapacity);
+    radius.reserve(initialCapacity);
+    damage.reserve(initialCapacity);
+    rotation.reserve(initialCapacity);
+    ownerId.reserve(initialCapacity);
+    bulletId.reserve(initialCapacity);
+    bulletType.reserve(initialCapacity);
+    spawnToken.reserve(initialCapacity);
+    collisionLayer.reserve(initialCapacity);
+    collisionMask.reserve(initialCapacity);
+    endedSlots.reserve(initialCapacity);
+    activeIndex.reserve(initialCapacity);
+    activeSlots.reserve(initialCapacity);
+    freeSlots.reserve(initialCapacity);
+}
+
+/**
+ * Adds a projectile using the stats for its type and works out when it
+ * expires: whichever comes first of its lifetime running out, its center
+ * leaving the playable area and its edge touching a static obstacle (one
+ * sweep along the path it can still fly, since the obstacles never move).
+ * @param id Network bullet ID
+ * @param type Bullet type (BulletStats index)
+ * @param position Spawn position
+ * @param direction Flight direction (normalized here)
+ * @param owner ID of the player or enemy that fired
+ * @param layer CollisionLayers::PLAYER_BULLET or ENEMY_BULLET
+ * @return Slot index of the new projectile
+ */
+uint32_t ProjectilePool::Spawn(uint32_t id, uint8_t type, sf::Vector2f position,
+    sf::Vector2f direction, uint32_t owner, CollisionLayers::Mask layer, float flownSeconds) {
+    float dirLength = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+    if (dirLength > 0.001f) {
+        direction /= dirLength;
+    }
+    else {
+        direction = sf::Vector2f(1.0f, 0.0f);
+    }
+
+    const BulletStats::Stats& stats = BulletStats::ForType(type);
+    const uint32_t slot = AllocateSlot();
+
+    originX[slot] = position.x;
+    originY[slot] = position.y;
+    velX[slot] = direction.x * stats.speed;
+    velY[slot] = direction.y * stats.speed;
+    spawnTime[slot] = now;
+    ended[slot] = 0;
+    lifetime[slot] = std::max(stats.lifetime - flownSeconds, 0.0f);
+    radius[slot] = stats.radius;
+    damage[slot] = stats.damage;
+    rotation[slot] = std::atan2(direction.y, direction.x) * 180.0f / 3.14159f;
+    ownerId[slot] = owner;
+    bulletId[slot] = id;
+    bulletType[slot] = type;
+    spawnToken[slot] = 0;
+    collisionLayer[slot] = layer;
+    collisionMask[slot] = CollisionLayers::DefaultMask(layer);
+
+    if (!std::isfinite(position.x) || !std::isfinite(position.y) ||
+        !std::isfinite(velX[slot]) || !std::isfinite(velY[slot])) {
+        endTime[slot] = now;
+        End(slot, EndReason::HIT);
+        return slot;
+    }
+
+    const double borderExit = std::min(
+        ExitTime(position.x, velX[slot], WorldConstants::PLAYABLE_MIN_X,
+            WorldConstants::PLAYABLE_MIN_X + WorldConstants::PLAYABLE_WIDTH),
+        ExitTime(position.y, velY[slot], WorldConstants::PLAYABLE_MIN_Y,
+            WorldConstants::PLAYABLE_MIN_Y + WorldConstants::PLAYABLE_HEIGHT));
+    const double lifetimeEnd = static_cast<double>(lifetime[slot]);
+    endReason[slot] = borderExit < lifetimeEnd ? EndReason::BORDER : EndReason::LIFETIME;
+    double flightTime = std::min(borderExit, lifetimeEnd);
+    if (obstacles && !obstacles->IsEmpty() && (collisionMask[slot] & CollisionLayers::OBSTACLE) != 0) {
+        const sf::Vector2f reach(velX[slot] * static_cast<float>(flightTime), velY[slot] * static_cast<float>(flightTime));
+        float fraction = 1.0f;
+        if (obstacles->SweepCircle(position, position + reach, stats.radius, fraction)) {
+            endReason[slot] = EndReason::OBSTACLE;
+            flightTime *= fraction;
+        }
+    }
+    endTime[slot] = now + flightTime;
+    return slot;
+}
+
+void ProjectilePool::Update(float deltaTime) {
+    if (!(deltaTime >= 0.0f) || !std::isfinite(deltaTime)) {
+        return;
+    }
+
+    previousNow = now;
+    now += deltaTime;
+}
+
+bool ProjectilePool::Expire(uint32_t slot, uint32_t id) {
+    if (slot >= activeIndex.size() || activeIndex[slot] == INVALID_SLOT ||
+        bulletId[slot] != id || ended[slot]) {
+        return false;
+    }
+    End(slot, endReason[slot]);
+    return true;
+}
+
+void ProjectilePool::MarkHit(uint32_t slot) {
+    if (!ended[slot]) {
+        End(slot, EndReason::HIT);
+    }
+}
+
+float ProjectilePool::GetLifetime(uint32_t slot) const {
+    const double remaining = static_cast<double>(lifetime[slot]) - (now - spawnTime[slot]);
+    return remaining > 0.0 ? static_cast<float>(remaining) : 0.0f;
+}
+
+void ProjectilePool::Clear() {
+    while (!activeSlots.empty()) {
+        ReleaseSlot(activeSlots.back());
+    }
+    endedSlots.clear();
+}
+
+size_t ProjectilePool::GetApproximateBytes() const {
+    return sizeof(*this) + MemoryReport::VectorBytes(originX, originY, velX, velY, spawnTime, endTime, ended,
+        endReason, lifetime, radius, damage, rotation, ownerId, bulletId, bulletType, spawnToken, collisionLayer, collisionMask, endedSlots,
+        freeSlots, activeSlots, activeIndex);
+}
+
+void ProjectilePool::End(uint32_t slot, EndReason reason) {
+    ended[slot] = 1;
+    endReason[slot] = reason;
+    endedSlots.push_back(slot);
+}
+
+uint32_t ProjectilePool::AllocateSlot() {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(originX.size());
+        originX.push_back(0.0f);
+        originY.push_back(0.0f);
+        velX.push_back(0.0f);
+        velY.push_back(0.0f);
+        spawnTime.push_back(0.0);
+        endTime.push_back(0.0);
+        ended.push_back(0);
+        endReason.push_back(EndReason::LIFETIME);
+        lifetime.push_back(0.0f);
+        radius.push_back(0.0f);
+        damage.push_back(0.0f);
+        rotation.push_back(0.0f);
+        ownerId.push_back(0);
+        bulletId.push_back(0);
+        bulletType.push_back(0);
+        spawnToken.push_back(0);
+        collisionLayer.push_back(CollisionLayers::NONE);
+        collisionMask.push_back(CollisionLayers::NONE);
+        activeIndex.push_back(INVALID_SLOT);
+    }
+
+    activeIndex[slot] = static_cast<uint32_t>(activeSlots.size());
+    activeSlots.push_back(slot);
+    return slot;
+}
+
+void ProjectilePool::ReleaseSlot(uint32_t slot) {
+    const uint32_t index = activeIndex[slot];
+    if (index == INVALID_SLOT) {
+        return;
+    }
+
+    // Swap-and-pop keeps the live list dense
+    const uint32_t lastSlot = activeSlots.back();
+    activeSlots[index] = lastSlot;
+    activeIndex[lastSlot] = index;
+    activeSlots.pop_back();
+
+    activeIndex[slot] = INVALID_SLOT;
+    freeSlots.push_back(slot);
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+#include "bullet_stats.h"
+#include "collision_layers.h"
+
+class StaticObstacles;
+
+/**
+ * Headless server-side projectile storage.
+ * Structure-of-arrays pool with free-list slot reuse and a dense list of live
+ * slots for iteration. No textures or sprites: spawning never touches the disk.
+ *
+ * A projectile flies in a straight line at constant speed, so it is stored as
+ * its spawn time, origin and velocity and its position is evaluated only when
+ * asked for. The time it leaves the playable area, hits a static obstacle or
+ * runs out of lifetime is known at spawn; the owner schedules the earlier one on its own
+ * timers (GetTimeToExpiry) and calls Expire when it falls due, so a tick only
+ * touches the projectiles that end in it.
+ */
+class ProjectilePool {
+public:
+    static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+    static constexpr size_t DEFAULT_CAPACITY = 512;
+
+    // Why a projectile left the pool
+    enum class EndReason : uint8_t {
+        HIT,        // MarkHit (or a non-finite spawn)
+        LIFETIME,   // Lifetime ran out
+        BORDER,     // Left the playable area
+        OBSTACLE    // Reached a static obstacle
+    };
+
+    explicit ProjectilePool(size_t initialCapacity = DEFAULT_CAPACITY);
+
+    // Adds a projectile at the current pool time; direction is normalized
+    // (falls back to +X if degenerate). The layer's default mask decides
+    // what it hits (collision_layers.h). flownSeconds of its lifetime are
+    // already used up (a projectile restored mid-flight).
+    // @return Slot index of the new projectile
+    uint32_t Spawn(uint32_t bulletId, uint8_t bulletType, sf::Vector2f position,
+        sf::Vector2f direction, uint32_t ownerId, CollisionLayers::Mask layer, float flownSeconds = 0.0f);
+
+    // Static obstacles new projectiles are swept against (not owned; null for none)
+    void SetObstacles(const StaticObstacles* obstacleSet) { obstacles = obstacleSet; }
+
+    // Advances the pool clock
+    void Update(float deltaTime);
+
+    // Seconds from now until the projectile leaves the playable area, reaches
+    // an obstacle or its lifetime runs out, whichever is first
+    double GetTimeToExpiry(uint32_t slot) const { return endTime[slot] - now; }
+
+    // Ends the projectile for the reason found at spawn (removed on next
+    // RemoveDead). bulletId tells a recycled slot from the projectile the
+    // expiry was scheduled for.
+    // @return False if the slot no longer holds that projectile, or it already ended
+    bool Expire(uint32_t slot, uint32_t bulletId);
+
+    // Marks a projectile as having hit something (removed on next RemoveDead)
+    void MarkHit(uint32_t slot);
+
+    // Frees every slot that expired or hit something since the last call,
+    // calling onRemove(slot, EndReason) before the slot is recycled
+    template <typename Callback>
+    void RemoveDead(Callback&& onRemove);
+
+    void Clear();
+
+    // Dense iteration over live slots
+    const std::vector<uint32_t>& GetActiveSlots() const { return activeSlots; }
+    size_t GetActiveCount() const { return activeSlots.size(); }
+    bool IsEmpty() const { return activeSlots.empty(); }
+    // Every column at its capacity (see MemoryReport)
+    size_t GetApproximateBytes() const;
+
+    // Per-slot accessors
+    bool IsDestroyed(uint32_t slot) const { return ended[slot] != 0; }
+    bool WasHit(uint32_t slot) const { return ended[slot] != 0 && endReason[slot] == EndReason::HIT; }
+    sf::Vector2f GetPosition(uint32_t slot) const { return PositionAt(slot, now); }
+    // Position at the previous Update (the spawn point until the first one)
+    sf::Vector2f GetPreviousPosition(uint32_t slot) const {
+        return PositionAt(slot, previousNow > spawnTime[slot] ? previousNow : spawnTime[slot]);
+    }
+    sf::Vector2f GetVelocity(uint32_t slot) const { return { velX[slot], velY[slot] }; }
+    float GetRotation(uint32_t slot) const { return rotation[slot]; }
+    float GetRadius(uint32_t slot) const { return radius[slot]; }
+    float GetDamage(uint32_t slot) const { return damage[slot]; }
+    float GetLifetime(uint32_t slot) const;     // Remaining
+    uint32_t GetOwnerId(uint32_t slot) const { return ownerId[slot]; }
+    uint32_t GetBulletId(uint32_t slot) const { return bulletId[slot]; }
+    uint8_t GetBulletType(uint32_t slot) const { return bulletType[slot]; }
+    // The shooter's BulletSpawnMessage::spawnToken (0 = none), echoed so its
+    // predicted bullet takes this one over
+    uint16_t GetSpawnToken(uint32_t slot) const { return spawnToken[slot]; }
+    void SetSpawnToken(uint32_t slot, uint16_t token) { spawnToken[slot] = token; }
+    CollisionLayers::Mask GetCollisionLayer(uint32_t slot) const { return collisionLayer[slot]; }
+    CollisionLayers::Mask GetCollisionMask(uint32_t slot) const { return collisionMask[slot]; }
+
+private:
+    // Pool clock: seconds of Update since construction
+    double now;
+    double previousNow;
+    const StaticObstacles* obstacles;
+
+    // Trajectory (read for collision candidates and replication)
+    std::vector<float> originX, originY;
+    std::vector<float> velX, velY;
+    std::vector<double> spawnTime;
+    std::vector<double> endTime;            // Earliest of lifetime expiry, border exit and obstacle contact
+    std::vector<uint8_t> ended;
+    std::vector<EndReason> endReason;
+
+    // Cold data (collision/replication only)
+    std::vector<float> lifetime;            // Full lifetime at spawn
+    std::vector<float> radius;
+    std::vector<float> damage;
+    std::vector<float> rotation;
+    std::vector<uint32_t> ownerId;
+    std::vector<uint32_t> bulletId;
+    std::vector<uint8_t> bulletType;
+    std::vector<uint16_t> spawnToken;
+    std::vector<CollisionLayers::Mask> collisionLayer;
+    std::vector<CollisionLayers::Mask> collisionMask;
+
+    std::vector<uint32_t> endedSlots;       // Awaiting RemoveDead
+
+    // Slot bookkeeping
+    std::vector<uint32_t> freeSlots;        // Recycled slot indices
+    std::vector<uint32_t> activeSlots;      // Dense list of live slots
+    std::vector<uint32_t> activeIndex;      // slot -> position in activeSlots
+
+    sf::Vector2f PositionAt(uint32_t slot, double time) const {
+        const float elapsed = static_cast<float>(time - spawnTime[slot]);
+        return { originX[slot] + velX[slot] * elapsed, originY[slot] + velY[slot] * elapsed };
+    }
+    void End(uint32_t slot, EndReason reason);
+    uint32_t AllocateSlot();
+    void ReleaseSlot(uint32_t slot);
+};
+
+template <typename Callback>
+void ProjectilePool::RemoveDead(Callback&& onRemove) {
+    for (uint32_t slot : endedSlots) {
+        onRemove(slot, endReason[slot]);
+        ReleaseSlot(slot);
+    }
+    endedSlots.clear();
+}
@@ -0,0 +1,82 @@
+#include "quality_controller.h"
+#include <algorithm>
+
+namespace {
+    constexpr QualityController::Tier TIERS[QualityController::MAX_TIER + 1] = {
+        { true, true, true, 1.0f, 0.2f },
+        { true, true, true, 0.5f, 0.5f },
+        { false, false, true, 0.25f, 0.5f },
+        { false, false, false, 0.0f, 1.0f }
+    };
+}
+
+QualityController::QualityController(float targetFps)
+    : budgetMs(1000.0f / std::max(targetFps, 1.0f)) {
+}
+
+/**
+ * Disabling goes back to full quality and forgets the current window.
+ */
+void QualityController::SetEnabled(bool isEnabled) {
+    enabled = isEnabled;
+    tier = 0;
+    windowSeconds = 0.0f;
+    windowFrames = 0;
+    windowLateFrames = 0;
+    windowBusyMs = 0.0f;
+    calmWindows = 0;
+}
+
+/**
+ * Windows are counted in wall time rather than frames, so a slow window is
+ * judged as soon as a fast one. A window needs both little busy time and no
+ * late frames to count as calm: a hitch elsewhere (a chunk rebake, the OS)
+ * holds the tier without raising it unless it keeps happening.
+ */
+bool QualityController::RecordFrame(float frameSeconds, float busyMs) {
+    if (!enabled || frameSeconds <= 0.0f) {
+        return false;
+    }
+    windowSeconds += frameSeconds;
+    windowFrames++;
+    windowBusyMs += busyMs;
+    if (frameSeconds * 1000.0f > budgetMs * LATE_FRAME_FACTOR) {
+        windowLateFrames++;
+    }
+    if (windowSeconds < WINDOW_SECONDS) {
+        return false;
+    }
+
+    lastBusy = windowBusyMs / static_cast<float>(windowFrames) / budgetMs;
+    lastLate = static_cast<float>(windowLateFrames) / static_cast<float>(windowFrames);
+    windowSeconds = 0.0f;
+    windowFrames = 0;
+    windowLateFrames = 0;
+    windowBusyMs = 0.0f;
+
+    uint8_t next = tier;
+    if (lastBusy >= ESCALATE_BUSY || lastLate >= ESCALATE_LATE_FRACTION) {
+        calmWindows = 0;
+        next = std::min<uint8_t>(tier + 1, MAX_TIER);
+    }
+    else if (lastBusy < RECOVER_BUSY && lastLate == 0.0f && tier > 0) {
+        if (++calmWindows >= RECOVER_WINDOWS) {
+            calmWindows = 0;
+            next = tier - 1;
+        }
+    }
+    else {
+        calmWindows = 0;
+    }
+
+    if (next == tier) {
+        return false;
+    }
+    tier = next;
+    transitions++;
+    return true;
+}
+
+const QualityController::Tier& QualityController::GetTierSettings() const {
+    return TIERS[tier];
+}
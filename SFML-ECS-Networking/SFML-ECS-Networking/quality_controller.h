@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Steps client rendering quality down while frames run late and back up when
+// there is headroom, the client-side counterpart of OverloadController. Frames
+// are judged over windows of WINDOW_SECONDS: a window with too many late frames
+// (longer than LATE_FRAME_FACTOR budgets) or too busy a frame raises the tier
+// by one, RECOVER_WINDOWS quiet windows in a row lower it by one again.
+// Busy time is the game's own update and render work, without the frame limiter's
+// sleep and the buffer swap, so headroom is visible even at a capped frame rate.
+//
+//   Tier  Name labels  Health bars        Particle bursts  Minimap refresh
+//   0     shown        border + backing   all              5 Hz
+//   1     shown        border + backing   1/2              2 Hz
+//   2     hidden       backing only       1/4              2 Hz
+//   3     hidden       fill only          none             1 Hz
+//
+// Single flashes (muzzle, explosion core) are kept at every tier.
+class QualityController {
+public:
+    static constexpr uint8_t MAX_TIER = 3;
+    static constexpr float WINDOW_SECONDS = 1.0f;
+    static constexpr float LATE_FRAME_FACTOR = 1.5f;
+    static constexpr float ESCALATE_LATE_FRACTION = 0.1f;   // Of a window's frames
+    static constexpr float ESCALATE_BUSY = 0.85f;           // Average busy time / frame budget
+    static constexpr float RECOVER_BUSY = 0.5f;
+    static constexpr uint32_t RECOVER_WINDOWS = 3;
+
+    // What a tier keeps
+    struct Tier {
+        bool nameLabels;
+        bool healthBarBorder;
+        bool healthBarBackground;
+        float particleScale;        // Applied to burst particle counts
+        float minimapInterval;      // Seconds between minimap refreshes
+    };
+
+    // Frame budget at the target frame rate
+    explicit QualityController(float targetFps = 60.0f);
+
+    void SetEnabled(bool isEnabled);
+    bool IsEnabled() const { return enabled; }
+
+    // Feeds one frame.
+    // @param frameSeconds Frame length (the loop's delta time)
+    // @param busyMs Time spent in update and render this frame
+    // @return True if the tier changed at the end of a window
+    bool RecordFrame(float frameSeconds, float busyMs);
+
+    uint8_t GetTier() const { return tier; }
+    const Tier& GetTierSettings() const;
+    float GetLastBusyFraction() const { return lastBusy; }
+    float GetLastLateFraction() const { return lastLate; }
+    uint64_t GetTransitionCount() const { return transitions; }
+
+private:
+    bool enabled = true;
+    float budgetMs;
+    uint8_t tier = 0;
+    float windowSeconds = 0.0f;
+    uint32_t windowFrames = 0;
+    uint32_t windowLateFrames = 0;
+    float windowBusyMs = 0.0f;
+    uint32_t calmWindows = 0;
+    float lastBusy = 0.0f;
+    float lastLate = 0.0f;
+    uint64_t transitions = 0;
+};
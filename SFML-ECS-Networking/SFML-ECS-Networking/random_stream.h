@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+
+// What a stream is drawn for, so the streams of one entity ID never overlap
+enum class RandomPurpose : uint32_t {
+    ENEMY_SPAWN = 1,    // Keyed by the ID the enemy will get: position and type
+    ENEMY_AI,           // Keyed by enemy ID: waypoints, aim spread
+    PLAYER_RESPAWN,     // Keyed by player ID: respawn position
+};
+
+// Counter-based random numbers for the simulation. Draw n of a stream is a
+// pure function of (match seed, purpose, entity ID, tick, n): SplitMix64's
+// mixer over a key built from them. Nothing is carried between ticks, so
+// there is no generator state to share between threads, to order draws
+// through or to save in checkpoints. Enemies think in any order on any
+// worker, and a replay or a restored checkpoint draws the same numbers as
+// the recorded match did at the same tick.
+//
+// Uniform and Below are computed here rather than with <random>'s
+// distributions, whose algorithms differ between standard libraries. The
+// stream is still a UniformRandomBitGenerator for anything that needs one.
+class RandomStream {
+public:
+    using result_type = uint32_t;
+
+    constexpr RandomStream() : RandomStream(0, RandomPurpose::ENEMY_AI, 0, 0) {}
+    constexpr RandomStream(uint64_t seed, RandomPurpose purpose, uint32_t entityId, uint32_t tick)
+        : key(Mix(seed ^ Mix((static_cast<uint64_t>(purpose) << 32) | entityId))), base(0), counter(0) {
+        Restart(tick);
+    }
+
+    // Moves to the first draw of tick's numbers
+    constexpr void Restart(uint32_t tick) {
+        base = Mix(key + GAMMA * (static_cast<uint64_t>(tick) + 1));
+        counter = 0;
+    }
+
+    constexpr result_type operator()() {
+        return static_cast<result_type>(Mix(base + GAMMA * ++counter) >> 32);
+    }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    // [low, high); low when the range is empty
+    constexpr float Uniform(float low, float high) {
+        // 24 bits: every value is exact in a float
+        const float unit = static_cast<float>((*this)() >> 8) * (1.0f / 16777216.0f);
+        return high > low ? low + (high - low) * unit : low;
+    }
+
+    // [0, bound), by multiply and shift (bias under 2^-32 * bound); 0 for 0
+    constexpr uint32_t Below(uint32_t bound) {
+        return static_cast<uint32_t>((static_cast<uint64_t>((*this)()) * bound) >> 32);
+    }
+
+private:
+    static constexpr uint64_t GAMMA = 0x9E3779B97F4A7C15ull;
+
+    static constexpr uint64_t Mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t key;       // Seed, purpose and entity, mixed
+    uint64_t base;      // Key and tick, mixed
+    uint32_t counter;   // Draws so far this tick
+};
+
+namespace RandomStreamChecks {
+    constexpr uint32_t FirstDraw(uint64_t seed, uint32_t entityId, uint32_t tick) {
+        RandomStream stream(seed, RandomPurpose::ENEMY_AI, entityId, tick);
+        return stream();
+    }
+    constexpr uint32_t SecondDraw(uint64_t seed, uint32_t entityId, uint32_t tick) {
+        RandomStream stream(seed, RandomPurpose::ENEMY_AI, entityId, tick);
+        stream();
+        return stream();
+    }
+
+    static_assert(FirstDraw(1, 1000, 5) == FirstDraw(1, 1000, 5), "a stream must repeat");
+    static_assert(FirstDraw(1, 1000, 5) != FirstDraw(2, 1000, 5), "seeds must differ");
+    static_assert(FirstDraw(1, 1000, 5) != FirstDraw(1, 1001, 5), "entities must differ");
+    static_assert(FirstDraw(1, 1000, 5) != FirstDraw(1, 1000, 6), "ticks must differ");
+    static_assert(FirstDraw(1, 1000, 5) != SecondDraw(1, 1000, 5), "draws must differ");
+}
@@ -0,0 +1,116 @@
+#include "reliable_channel.h"
+
+ReliableSender::ReliableSender() : nextSequence(0) {
+}
+
+void ReliableSender::Send(const sf::Packet& message) {
+    if (message.getDataSize() == 0) {
+        return;
+    }
+
+    Entry entry;
+    entry.sequence = nextSequence++;
+    entry.acked = false;
+    entry.sendCount = 0;
+    entry.lastSentTime = 0;
+    if (!spareBytes.empty()) {
+        entry.bytes = std::move(spareBytes.back());
+        spareBytes.pop_back();
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(message.getData());
+    entry.bytes.assign(data, data + message.getDataSize());
+    entries.push_back(std::move(entry));
+}
+
+/**
+ * Marks every in-flight message covered by the ack, then drops the acked
+ * prefix so the window can advance. Acks for sequences never sent are ignored.
+ */
+void ReliableSender::OnAck(uint16_t ackSequence, uint32_t ackBits) {
+    if (entries.empty() || !ReliableSequence::IsNewer(nextSequence, ackSequence)) {
+        return;
+    }
+
+    for (Entry& entry : entries) {
+        if (entry.sendCount == 0) {
+            break;
+        }
+        const uint16_t distance = static_cast<uint16_t>(ackSequence - entry.sequence);
+        if (distance == 0 || (distance <= WINDOW && (ackBits & (1u << (distance - 1))) != 0)) {
+            entry.acked = true;
+        }
+    }
+
+    while (!entries.empty() && entries.front().acked) {
+        Recycle(entries.front());
+        entries.pop_front();
+    }
+}
+
+void ReliableSender::Restore(bool acked, const std::vector<uint8_t>& bytes) {
+    Entry entry;
+    entry.sequence = nextSequence++;
+    entry.acked = acked;
+    entry.sendCount = acked ? 1 : 0;
+    entry.lastSentTime = 0;
+    entry.bytes = bytes;
+    entries.push_back(std::move(entry));
+}
+
+void ReliableSender::Reset(uint16_t firstSequence) {
+    for (Entry& entry : entries) {
+        Recycle(entry);
+    }
+    entries.clear();
+    nextSequence = firstSequence;
+}
+
+// Up to a window's worth is kept: a backlog that built up while a client was
+// not acking would otherwise stay allocated for good
+void ReliableSender::Recycle(Entry& entry) {
+    if (spareBytes.size() < WINDOW) {
+        spareBytes.push_back(std::move(entry.bytes));
+    }
+}
+
+ReliableReceiver::ReliableReceiver()
+    : nextExpected(0), anyReceived(false), latestReceived(0), receivedBits(0) {
+}
+
+/**
+ * Folds a received sequence into (latestReceived, receivedBits).
+ */
+void ReliableReceiver::RecordAck(uint16_t sequence) {
+    if (!anyReceived) {
+        anyReceived = true;
+        latestReceived = sequence;
+        receivedBits = 0;
+        return;
+    }
+
+    if (ReliableSequence::IsNewer(sequence, latestReceived)) {
+        const uint16_t shift = static_cast<uint16_t>(sequence - latestReceived);
+        // The old latest becomes bit (shift - 1); anything beyond 32 back falls off
+        receivedBits = shift >= 32 ? 0 : receivedBits << shift;
+        if (shift <= 32) {
+            receivedBits |= 1u << (shift - 1);
+        }
+        latestReceived = sequence;
+    }
+    else {
+        const uint16_t distance = static_cast<uint16_t>(latestReceived - sequence);
+        if (distance >= 1 && distance <= 32) {
+            receivedBits |= 1u << (distance - 1);
+        }
+    }
+}
+
+void ReliableReceiver::Reset() {
+    nextExpected = 0;
+    anyReceived = false;
+    latestReceived = 0;
+    receivedBits = 0;
+    for (Slot& slot : buffered) {
+        slot.filled = false;
+    }
+}
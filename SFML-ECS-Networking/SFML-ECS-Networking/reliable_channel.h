@@ -0,0 +1,178 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "network_messages.h"
+
+// Lightweight reliable, ordered channel for one-off gameplay events on top of
+// the unreliable datagrams. Each reliable message travels in an envelope:
+//   [RELIABLE_MESSAGE][uint16 sequence][message bytes incl. type]
+// The receiver reports the newest sequence it has seen plus a 32-bit bitfield
+// for the 32 before it (bit i = sequence - 1 - i). The ack rides on every
+// PLAYER_INPUT, with RELIABLE_ACK as a fallback while no inputs flow. Unacked
+// messages are resent until acked.
+namespace ReliableSequence {
+    // Wrap-aware comparison: true if a was sent after b
+    inline bool IsNewer(uint16_t a, uint16_t b) {
+        return a != b && static_cast<uint16_t>(a - b) < 0x8000;
+    }
+}
+
+// Sender half (one per client on the server)
+class ReliableSender {
+public:
+    static constexpr size_t WINDOW = 32;         // In flight at once; the ack bitfield covers this span
+    static constexpr int64_t RESEND_MS = 100;    // Resend interval for unacked messages
+
+    ReliableSender();
+
+    // Copies a complete message (type byte first); sent by the next Update
+    void Send(const sf::Packet& message);
+
+    // Sends new messages and due resends inside the window as envelopes via
+    // sendEnvelope(const sf::Packet&). @return Number of resends
+    template <typename SendFn>
+    uint32_t Update(int64_t nowMs, SendFn&& sendEnvelope);
+
+    void OnAck(uint16_t ackSequence, uint32_t ackBits);
+    // @param firstSequence Sequence of the next message, to carry on a receiver's count
+    void Reset(uint16_t firstSequence = 0);
+
+    size_t GetPendingCount() const { return entries.size(); }
+
+    // Messages still held, oldest first, as fn(bool acked, const std::vector<uint8_t>& bytes);
+    // their sequences run on from GetFirstSequence (for a handoff, see handoff.h)
+    template <typename Fn>
+    void ForEachHeld(Fn&& fn) const {
+        for (const Entry& entry : entries) {
+            fn(entry.acked, entry.bytes);
+        }
+    }
+    uint16_t GetFirstSequence() const { return entries.empty() ? nextSequence : entries.front().sequence; }
+    // Appends a held message after Reset(GetFirstSequence()), in the same order;
+    // unacked ones go out with the next Update
+    void Restore(bool acked, const std::vector<uint8_t>& bytes);
+
+private:
+    struct Entry {
+        uint16_t sequence;
+        bool acked;
+        uint32_t sendCount;
+        int64_t lastSentTime;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::deque<Entry> entries;       // Oldest first; the acked prefix is dropped
+    std::vector<std::vector<uint8_t>> spareBytes;   // Buffers of dropped entries, reused by Send
+    uint16_t nextSequence;
+
+    void Recycle(Entry& entry);
+    sf::Packet envelope;             // Reused while sending
+};
+
+// Receiver half (on the client): delivers messages exactly once, in send order
+class ReliableReceiver {
+public:
+    static constexpr size_t WINDOW = ReliableSender::WINDOW;
+
+    ReliableReceiver();
+
+    // @param envelope Packet positioned after the RELIABLE_MESSAGE type byte
+    // @param deliver Called with each message (sf::Packet&) that is now in order
+    // @return False if the envelope was malformed or outside the window
+    template <typename DeliverFn>
+    bool Receive(const sf::Packet& envelope, DeliverFn&& deliver);
+
+    bool HasReceived() const { return anyReceived; }
+    uint16_t GetAckSequence() const { return latestReceived; }
+    uint32_t GetAckBits() const { return receivedBits; }
+    // Sequence of the next message to deliver
+    uint16_t GetNextExpected() const { return nextExpected; }
+
+    void Reset();
+
+private:
+    struct Slot {
+        bool filled;
+        std::vector<uint8_t> bytes;
+        Slot() : filled(false) {}
+    };
+
+    uint16_t nextExpected;
+    bool anyReceived;
+    uint16_t latestReceived;
+    uint32_t receivedBits;
+    std::array<Slot, WINDOW> buffered;   // Out-of-order arrivals, indexed by sequence % WINDOW
+    sf::Packet message;                  // Reused while delivering
+
+    void RecordAck(uint16_t sequence);
+};
+
+template <typename SendFn>
+uint32_t ReliableSender::Update(int64_t nowMs, SendFn&& sendEnvelope) {
+    uint32_t resends = 0;
+    const size_t inWindow = entries.size() < WINDOW ? entries.size() : WINDOW;
+
+    for (size_t i = 0; i < inWindow; ++i) {
+        Entry& entry = entries[i];
+        if (entry.acked || (entry.sendCount > 0 && nowMs - entry.lastSentTime < RESEND_MS)) {
+            continue;
+        }
+        if (entry.sendCount > 0) {
+            resends++;
+        }
+
+        envelope.clear();
+        envelope << static_cast<uint8_t>(NetMessageType::RELIABLE_MESSAGE) << entry.sequence;
+        envelope.append(entry.bytes.data(), entry.bytes.size());
+        sendEnvelope(envelope);
+
+        entry.sendCount++;
+        entry.lastSentTime = nowMs;
+    }
+    return resends;
+}
+
+template <typename DeliverFn>
+bool ReliableReceiver::Receive(const sf::Packet& envelope, DeliverFn&& deliver) {
+    const uint8_t* data = static_cast<const uint8_t*>(envelope.getData());
+    const size_t position = envelope.getReadPosition();
+    if (data == nullptr || envelope.getDataSize() < position + 3) {
+        return false;
+    }
+
+    const uint16_t sequence = static_cast<uint16_t>((data[position] << 8) | data[position + 1]);
+    const uint8_t* body = data + position + 2;
+    const size_t bodyBytes = envelope.getDataSize() - position - 2;
+    if (body[0] == static_cast<uint8_t>(NetMessageType::RELIABLE_MESSAGE)) {
+        return false;
+    }
+
+    // Already delivered: only the ack matters (the previous one was probably lost)
+    if (ReliableSequence::IsNewer(nextExpected, sequence)) {
+        RecordAck(sequence);
+        return true;
+    }
+    if (static_cast<uint16_t>(sequence - nextExpected) >= WINDOW) {
+        return false;
+    }
+
+    RecordAck(sequence);
+    Slot& slot = buffered[sequence % WINDOW];
+    if (!slot.filled) {
+        slot.bytes.assign(body, body + bodyBytes);
+        slot.filled = true;
+    }
+
+    while (buffered[nextExpected % WINDOW].filled) {
+        Slot& next = buffered[nextExpected % WINDOW];
+        message.clear();
+        message.append(next.bytes.data(), next.bytes.size());
+        next.filled = false;
+        nextExpected++;
+        deliver(message);
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#include "render_scale_controller.h"
+#include <algorithm>
+#include <cmath>
+
+RenderScaleController::RenderScaleController(float targetFps)
+    : budgetMs(1000.0f / std::max(targetFps, 1.0f)) {
+}
+
+/**
+ * Disabling goes back to full resolution and forgets the current window.
+ */
+void RenderScaleController::SetEnabled(bool isEnabled) {
+    enabled = isEnabled;
+    scale = MAX_SCALE;
+    windowSeconds = 0.0f;
+    windowFrames = 0;
+    windowBusyMs = 0.0f;
+    calmWindows = 0;
+}
+
+/**
+ * A slow window is cut to the step at or below sqrt(budget / frame) of the
+ * current scale, and always by at least one step, so a frame that is only
+ * just late still moves. Growth is one step at a time: overshooting costs a
+ * slow window, undershooting only some sharpness.
+ */
+bool RenderScaleController::RecordFrame(float frameSeconds, float busyMs) {
+    if (!enabled || frameSeconds <= 0.0f) {
+        return false;
+    }
+    windowSeconds += frameSeconds;
+    windowFrames++;
+    windowBusyMs += busyMs;
+    if (windowSeconds < WINDOW_SECONDS) {
+        return false;
+    }
+
+    lastFrame = windowSeconds * 1000.0f / static_cast<float>(windowFrames) / budgetMs;
+    const float lastBusy = windowBusyMs / static_cast<float>(windowFrames) / budgetMs;
+    windowSeconds = 0.0f;
+    windowFrames = 0;
+    windowBusyMs = 0.0f;
+
+    float next = scale;
+    if (lastFrame >= SLOW_FRAME_FACTOR) {
+        calmWindows = 0;
+        const float fit = std::floor(scale * std::sqrt(1.0f / lastFrame) / SCALE_STEP) * SCALE_STEP;
+        next = std::max(std::min(fit, scale - SCALE_STEP), MIN_SCALE);
+    }
+    else if (lastBusy < GROW_BUSY && scale < MAX_SCALE) {
+        if (++calmWindows >= GROW_WINDOWS) {
+            calmWindows = 0;
+            next = std::min(scale + SCALE_STEP, MAX_SCALE);
+        }
+    }
+    else {
+        calmWindows = 0;
+    }
+
+    // Steps are compared rounded, so float drift never counts as a change
+    next = std::round(next / SCALE_STEP) * SCALE_STEP;
+    if (std::fabs(next - scale) < SCALE_STEP / 2.0f) {
+        return false;
+    }
+    scale = next;
+    changes++;
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+// Picks the resolution the world layer is rendered at, as a fraction of the
+// window's, so frames fit the frame budget when the GPU's fill rate is what
+// holds them back (the full-window background, borders, overdraw from health
+// bars). Works alongside QualityController, which sheds detail instead.
+//
+// Frames are judged over windows of WINDOW_SECONDS. A window whose average
+// frame runs past SLOW_FRAME_FACTOR budgets lowers the scale at once, by as
+// much as the pixel count (the scale squared) has to shrink to fit; a window
+// with frames on time and busy time under GROW_BUSY of the budget counts as
+// calm, and GROW_WINDOWS calm windows in a row raise it by one SCALE_STEP.
+// Frame length includes the buffer swap, where a GPU-bound frame waits, so
+// the cut is sized by it; growth is judged by busy time, since a capped frame
+// rate hides the headroom from the frame length.
+//
+// The scale moves in SCALE_STEPs, so the render target is only resized when
+// the choice really changes.
+class RenderScaleController {
+public:
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+    static constexpr float SCALE_STEP = 0.05f;
+    static constexpr float WINDOW_SECONDS = 0.5f;
+    static constexpr float SLOW_FRAME_FACTOR = 1.05f;       // Average frame / frame budget
+    static constexpr float GROW_BUSY = 0.7f;                // Average busy time / frame budget
+    static constexpr uint32_t GROW_WINDOWS = 4;
+
+    // Frame budget at the target frame rate
+    explicit RenderScaleController(float targetFps = 60.0f);
+
+    void SetEnabled(bool isEnabled);
+    bool IsEnabled() const { return enabled; }
+
+    // Feeds one frame.
+    // @param frameSeconds Frame length (the loop's delta time)
+    // @param busyMs Time spent in update and render this frame
+    // @return True if the scale changed at the end of a window
+    bool RecordFrame(float frameSeconds, float busyMs);
+
+    // Fraction of the window's width and height the world layer is rendered at
+    float GetScale() const { return scale; }
+    float GetLastFrameFraction() const { return lastFrame; }
+    uint64_t GetChangeCount() const { return changes; }
+
+private:
+    bool enabled = true;
+    float budgetMs;
+    float scale = MAX_SCALE;
+    float windowSeconds = 0.0f;
+    uint32_t windowFrames = 0;
+    float windowBusyMs = 0.0f;
+    uint32_t calmWindows = 0;
+    float lastFrame = 0.0f;
+    uint64_t changes = 0;
+};
@@ -0,0 +1,181 @@
+#include "replication_budget.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace {
+    // How fast the lowest round trip drifts up towards the current one, per second,
+    // so a route change that adds latency for good stops reading as congestion
+    constexpr float MIN_RTT_FORGET_PER_SECOND = 0.02f;
+}
+
+float ReplicationRates::GetSnapshotHz() const {
+    return std::max(std::max(nearPlayerHz, farPlayerHz), std::max(nearEnemyHz, farEnemyHz));
+}
+
+uint32_t ReplicationRates::GetSnapshotInterval(float rateHz) const {
+    return static_cast<uint32_t>(std::max(std::lround(GetSnapshotHz() / rateHz), 1L));
+}
+
+bool ReplicationRates::Parse(const std::string& text, ReplicationRates& rates) {
+    ReplicationRates parsed = rates;
+    std::stringstream stream(text);
+    std::string field;
+    int index = 0;
+    try {
+        while (std::getline(stream, field, ',')) {
+            switch (index++) {
+            case 0: parsed.nearPlayerHz = std::stof(field); break;
+            case 1: parsed.farPlayerHz = std::stof(field); break;
+            case 2: parsed.nearEnemyHz = std::stof(field); break;
+            case 3: parsed.farEnemyHz = std::stof(field); break;
+            case 4: parsed.bulletHz = std::stof(field); break;
+            case 5: parsed.nearDistance = std::stof(field); break;
+            default: return false;
+            }
+        }
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    const auto isRate = [](float value) { return value >= MIN_HZ && value <= MAX_HZ; };
+    if (index < 4 || !isRate(parsed.nearPlayerHz) || !isRate(parsed.farPlayerHz) ||
+        !isRate(parsed.nearEnemyHz) || !isRate(parsed.farEnemyHz) || !isRate(parsed.bulletHz) ||
+        !(parsed.nearDistance >= 0.0f) || !std::isfinite(parsed.nearDistance)) {
+        return false;
+    }
+    rates = parsed;
+    return true;
+}
+
+/**
+ * Shows the rates each category actually gets: whole snapshot intervals.
+ */
+std::string ReplicationRates::Describe() const {
+    const float snapshotHz = GetSnapshotHz();
+    char text[200];
+    std::snprintf(text, sizeof(text),
+        "snapshots %.1f Hz, players %.1f/%.1f Hz, enemies %.1f/%.1f Hz (near/far at %.0f px), bullets %.1f Hz",
+        snapshotHz, snapshotHz / GetSnapshotInterval(nearPlayerHz), snapshotHz / GetSnapshotInterval(farPlayerHz),
+        snapshotHz / GetSnapshotInterval(nearEnemyHz), snapshotHz / GetSnapshotInterval(farEnemyHz),
+        nearDistance, bulletHz);
+    return text;
+}
+
+bool DeadReckoningSettings::Parse(const std::string& text, DeadReckoningSettings& settings) {
+    DeadReckoningSettings parsed = settings;
+    std::stringstream stream(text);
+    std::string field;
+    int index = 0;
+    try {
+        while (std::getline(stream, field, ',')) {
+            switch (index++) {
+            case 0: parsed.positionThreshold = std::stof(field); break;
+            case 1: parsed.rotationThreshold = std::stof(field); break;
+            case 2: parsed.maxAgeMs = static_cast<uint32_t>(std::stoul(field)); break;
+            default: return false;
+            }
+        }
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    const auto isThreshold = [](float value) { return value >= 0.0f && std::isfinite(value); };
+    if (index < 2 || !isThreshold(parsed.positionThreshold) || !isThreshold(parsed.rotationThreshold)) {
+        return false;
+    }
+    parsed.enabled = true;
+    settings = parsed;
+    return true;
+}
+
+std::string DeadReckoningSettings::Describe() const {
+    if (!enabled) {
+        return "off";
+    }
+    char text[120];
+    std::snprintf(text, sizeof(text), "%.1f px, %.1f deg, refreshed after %u ms",
+        positionThreshold, rotationThreshold, maxAgeMs);
+    return text;
+}
+
+BandwidthBudget::BandwidthBudget()
+    : limit(0.0f), rate(0.0f), available(0.0f), minRttMs(-1.0f), holdTimer(0.0f) {
+}
+
+void BandwidthBudget::SetLimit(float bytesPerSecond) {
+    limit = (bytesPerSecond > 0.0f && std::isfinite(bytesPerSecond)) ? std::max(bytesPerSecond, MIN_RATE) : 0.0f;
+    rate = limit;
+    available = limit * BURST_SECONDS;
+    minRttMs = -1.0f;
+    holdTimer = 0.0f;
+}
+
+/**
+ * Refills first at the current rate, then adapts the rate for the next
+ * interval. A decrease holds off further decreases for DECREASE_HOLD_SECONDS,
+ * long enough for the smaller rate to show up in the loss and round trip.
+ */
+void BandwidthBudget::Update(float seconds, float lossPercent, float rttMs) {
+    if (!IsLimited() || !(seconds > 0.0f)) {
+        return;
+    }
+
+    available = std::min(available + rate * seconds, rate * BURST_SECONDS);
+
+    bool congested = lossPercent > LOSS_THRESHOLD;
+    if (rttMs >= 0.0f) {
+        if (minRttMs < 0.0f || rttMs < minRttMs) {
+            minRttMs = rttMs;
+        }
+        else {
+            minRttMs += (rttMs - minRttMs) * std::min(MIN_RTT_FORGET_PER_SECOND * seconds, 1.0f);
+        }
+        congested = congested || rttMs > minRttMs * RTT_RISE_FACTOR + RTT_RISE_SLACK_MS;
+    }
+
+    holdTimer = std::max(holdTimer - seconds, 0.0f);
+    if (congested) {
+        if (holdTimer <= 0.0f) {
+            rate = std::max(rate * DECREASE_FACTOR, MIN_RATE);
+            holdTimer = DECREASE_HOLD_SECONDS;
+        }
+    }
+    else {
+        rate = std::min(rate + limit * INCREASE_PER_SECOND * seconds, limit);
+    }
+}
+
+void BandwidthBudget::Spend(size_t bytes) {
+    available = std::max(available - static_cast<float>(bytes), -rate * BURST_SECONDS);
+}
+
+float PriorityAccumulator::Accumulate(uint32_t id, float growth) {
+    Entry& entry = entries[id];
+    entry.priority += growth;
+    entry.pass = pass;
+    return entry.priority;
+}
+
+void PriorityAccumulator::Touch(uint32_t id) {
+    entries[id].pass = pass;
+}
+
+void PriorityAccumulator::MarkSent(uint32_t id) {
+    auto it = entries.find(id);
+    if (it != entries.end()) {
+        it->second.priority = 0.0f;
+    }
+}
+
+void PriorityAccumulator::EndPass() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.pass != pass) {
+            it = entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
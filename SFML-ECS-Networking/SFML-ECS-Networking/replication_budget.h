@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Send rates in Hz per replication category. Snapshots go out at the fastest
+// of the entity rates; on a snapshot where an entity's category is not due it
+// keeps the state it was last sent with, except that health, score and death
+// changes go out straight away whatever the category (see
+// GameServer::SetReplicationRates). Near means within nearDistance of the
+// client's own tank.
+struct ReplicationRates {
+    static constexpr float MIN_HZ = 1.0f;
+    static constexpr float MAX_HZ = 128.0f;
+
+    float nearPlayerHz = 45.0f;
+    float farPlayerHz = 15.0f;
+    float nearEnemyHz = 45.0f;
+    float farEnemyHz = 15.0f;
+    float bulletHz = 30.0f;
+    float nearDistance = 400.0f;
+
+    float GetSnapshotHz() const;
+
+    // Snapshots between two sends of a category at rateHz (rounded, at least 1)
+    uint32_t GetSnapshotInterval(float rateHz) const;
+
+    // "near-players,far-players,near-enemies,far-enemies[,bullets[,near-distance]]"
+    // in Hz and pixels, e.g. "45,15,30,10". Returns false, leaving rates
+    // untouched, if the text does not parse or a rate is out of range.
+    static bool Parse(const std::string& text, ReplicationRates& rates);
+    std::string Describe() const;
+};
+
+// Dead reckoning: an entity's motion is sent again only once the client's
+// extrapolation of it (InterpolationManager::Extrapolate from the last two
+// states it was sent) is off by more than a threshold, its movement flags
+// change, or the last state sent is maxAgeMs old (see
+// GameServer::SetDeadReckoning)
+struct DeadReckoningSettings {
+    bool enabled = false;
+    float positionThreshold = 4.0f;     // Pixels
+    float rotationThreshold = 5.0f;     // Degrees, body and barrel
+    uint32_t maxAgeMs = 100;
+
+    // "position,rotation[,max-age-ms]" in pixels, degrees and ms, e.g. "4,5,100".
+    // Enables dead reckoning; returns false, leaving settings untouched, if the
+    // text does not parse.
+    static bool Parse(const std::string& text, DeadReckoningSettings& settings);
+    std::string Describe() const;
+};
+
+// Bytes one client's link can take, as a token bucket refilled at a rate that
+// adapts to the link: additive increase while it looks healthy, multiplicative
+// decrease on packet loss or when the round trip climbs well above the
+// lowest seen (queues building up). Everything sent to the client spends from
+// it; replication sends what it can afford (see GameServer::SetClientBandwidth).
+class BandwidthBudget {
+public:
+    static constexpr float MIN_RATE = 2048.0f;              // bytes/s the rate never drops below
+    static constexpr float BURST_SECONDS = 0.1f;            // Unused allowance is kept this long at most
+    static constexpr float LOSS_THRESHOLD = 5.0f;           // Percent
+    static constexpr float RTT_RISE_FACTOR = 1.5f;          // Congested above minRtt * factor + slack
+    static constexpr float RTT_RISE_SLACK_MS = 25.0f;
+    static constexpr float INCREASE_PER_SECOND = 0.1f;      // Of the limit, while healthy
+    static constexpr float DECREASE_FACTOR = 0.75f;
+    static constexpr float DECREASE_HOLD_SECONDS = 0.5f;    // One cut per congestion episode
+
+    BandwidthBudget();
+
+    // Ceiling for the adaptive rate in bytes per second (0 = unlimited, the
+    // default); the rate restarts at the ceiling
+    void SetLimit(float bytesPerSecond);
+    bool IsLimited() const { return limit > 0.0f; }
+
+    // Adds the allowance for seconds of time and adapts the rate
+    // @param lossPercent Recent loss, negative if not known yet
+    // @param rttMs Smoothed round trip, negative if not known yet
+    void Update(float seconds, float lossPercent, float rttMs);
+
+    // Overspending is carried as debt of at most one burst, so a run of
+    // messages that had to go out anyway does not starve the client for long
+    void Spend(size_t bytes);
+
+    // Negative while in debt
+    float GetAvailable() const { return available; }
+    float GetRate() const { return rate; }
+
+private:
+    float limit;
+    float rate;
+    float available;
+    float minRttMs;                 // Lowest round trip seen, slowly forgotten
+    float holdTimer;                // Time left before another decrease
+};
+
+// Per-entity replication priority for one client. Every pass (the passes run
+// at a fixed rate) each candidate's priority grows by its weight, and drops
+// back to zero once it is sent, so an entity's priority is roughly how
+// long it has been waiting scaled by how much it matters: a distant enemy is
+// deferred while budget is short, but never forever.
+class PriorityAccumulator {
+public:
+    void BeginPass() { pass++; }
+
+    // @return The entity's priority after this pass's growth
+    float Accumulate(uint32_t id, float growth);
+
+    // Keeps an entity without taking part in this pass (nothing new to send)
+    void Touch(uint32_t id);
+
+    void MarkSent(uint32_t id);
+
+    // Forgets entities not seen this pass (destroyed or out of interest)
+    void EndPass();
+
+    void Clear() { entries.clear(); }
+    size_t GetTrackedCount() const { return entries.size(); }
+
+private:
+    struct Entry {
+        float priority = 0.0f;
+        uint32_t pass = 0;
+    };
+
+    std::unordered_map<uint32_t, Entry> entries;
+    uint32_t pass = 0;
+};
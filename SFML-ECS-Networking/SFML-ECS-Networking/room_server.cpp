@@ -0,0 +1,639 @@
+#include "room_server.h"
+#include "network_messages.h"
+#include "network_validation.h"
+#include "thread_tuning.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+RoomServer::RoomServer(unsigned short port, uint16_t roomCount, unsigned int tickRateHz, unsigned int workerCount)
+    : serverPort(port),
+    requestedRooms(std::max<uint16_t>(1, std::min<uint16_t>(roomCount, MAX_ROOMS))),
+    tickRate(tickRateHz), requestedWorkers(workerCount),
+    eventBulletReplication(false), clientBandwidth(0), compressionThreshold(0), maxPlayersPerRoom(NetworkValidation::MAX_PLAYER_COUNT), overloadControl(true), enemySquads(false), isRunning(false), workersRunning(false),
+    shardsRunning(false), lastStatsReportMs(0), directoryPort(0), directoryAdvertisedAddress(0), lastDirectoryReportMs(0),
+    lastScoreReportMs(0) {
+}
+
+RoomServer::~RoomServer() {
+    Shutdown();
+}
+
+/**
+ * Binds the shared socket (or the ingress shards' sockets), starts every room
+ * in hosted mode and launches the tick workers, then the shard threads.
+ */
+bool RoomServer::Initialize() {
+    if (isRunning) return true;
+
+    LOG_MSG(info, "Initializing room server on port " + std::to_string(serverPort) + " with " +
+        std::to_string(requestedRooms) + " rooms...");
+
+    try {
+        unsigned int shardCount = std::min(std::max(requestedShards, 1u), MAX_INGRESS_SHARDS);
+        if (shardCount > 1 && !BatchedUdpSocket::IsPortSharingSupported()) {
+            LOG_MSG(warning, "Ingress shards need SO_REUSEPORT (Linux); receiving on one socket");
+            shardCount = 1;
+        }
+        if (shardCount > 1) {
+            for (unsigned int i = 0; i < shardCount; ++i) {
+                auto shard = std::make_unique<IngressShard>();
+                shard->index = i;
+                if (!shard->socket.Bind(serverPort, true)) {
+                    Utils::printMsg("Failed to bind ingress shard " + std::to_string(i) + " to port " +
+                        std::to_string(serverPort), error);
+                    shards.clear();
+                    return false;
+                }
+                shards.push_back(std::move(shard));
+            }
+            // Directory reports only
+            if (socket.bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+                LOG_MSG(warning, "No socket for directory reports");
+            }
+        }
+        else {
+            sf::Socket::Status bindStatus = socket.bind(serverPort);
+            if (bindStatus != sf::Socket::Status::Done) {
+                Utils::printMsg("Failed to bind room server socket to port " + std::to_string(serverPort), error);
+                return false;
+            }
+            socket.setBlocking(false);
+            selector.add(socket);
+        }
+
+        for (uint16_t id = 0; id < requestedRooms; ++id) {
+            auto room = std::make_unique<Room>(id, serverPort, tickRate);
+            room->server.SetEventBulletReplication(eventBulletReplication);
+            room->server.SetClientBandwidth(clientBandwidth);
+            room->server.SetReplicationRates(replicationRates);
+            room->server.SetDeadReckoning(deadReckoning);
+            room->server.SetCompressionThreshold(compressionThreshold);
+            room->server.SetMaxPlayers(maxPlayersPerRoom);
+            room->server.SetOverloadControl(overloadControl);
+            room->server.SetEnemySquadsEnabled(enemySquads);
+            room->server.SetChunkActiveRadius(chunkActiveRadius);
+            if (!mapObstacles.empty()) {
+                room->server.SetObstacles(mapObstacles);
+            }
+            room->server.SetSpectatorStream(spectatorDelayMs, maxSpectators);
+            if (!slowTickTracePrefix.empty()) {
+                room->server.SetSlowTickTrace(slowTickTracePrefix + "-room" + std::to_string(id), slowTickTraceMs);
+            }
+            room->server.SetStatsReportingEnabled(false);
+            room->server.SetConnectionTokenKey(connectionTokens.GetKey());
+            room->server.SetScoreReporting(directoryAddress.has_value());
+            if (!room->server.InitializeHosted(room->channel)) {
+                Utils::printMsg("Failed to start room " + std::to_string(id), error);
+                rooms.clear();
+                shards.clear();
+                selector.clear();
+                socket.unbind();
+                return false;
+            }
+            rooms.push_back(std::move(room));
+        }
+        // Before the workers start draining them
+        for (auto& shard : shards) {
+            for (size_t i = 0; i < rooms.size(); ++i) {
+                shard->toRooms.push_back(std::make_unique<ShardRing>());
+            }
+        }
+
+        unsigned int workerCount = requestedWorkers;
+        if (workerCount == 0) {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        workerCount = std::min<unsigned int>(workerCount, static_cast<unsigned int>(rooms.size()));
+
+        workersRunning.store(true, std::memory_order_release);
+        for (unsigned int i = 0; i < workerCount; ++i) {
+            workers.emplace_back(&RoomServer::RunWorker, this, static_cast<size_t>(i), workerCount);
+        }
+
+        const int64_t nowMs = GetCurrentTimestamp();
+        router.lastRouteSweepMs = nowMs;
+        lastStatsReportMs = nowMs;
+        shardsRunning.store(true, std::memory_order_release);
+        for (auto& shard : shards) {
+            shard->ingress.lastRouteSweepMs = nowMs;
+            shard->thread = std::thread(&RoomServer::RunShard, this, std::ref(*shard));
+        }
+        isRunning = true;
+        LOG_MSG(success, "Room server initialized: " + std::to_string(rooms.size()) + " rooms on " +
+            std::to_string(workers.size()) + " worker threads at " + std::to_string(tickRate) + " Hz" +
+            (shards.empty() ? std::string() : ", " + std::to_string(shards.size()) + " ingress shards"));
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception during room server initialization: " + std::string(e.what()), error);
+        Shutdown();
+        return false;
+    }
+}
+
+void RoomServer::Update() {
+    if (!isRunning) return;
+
+    try {
+        const int64_t nowMs = GetCurrentTimestamp();
+        if (!shards.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SELECTOR_TIMEOUT_MS));
+        }
+        else {
+            if (selector.wait(sf::milliseconds(SELECTOR_TIMEOUT_MS))) {
+                ReceiveAvailable(nowMs);
+            }
+            FlushOutbound();
+            if (nowMs - router.lastRouteSweepMs >= 1000) {
+                ExpireRoutes(router, nowMs);
+                router.lastRouteSweepMs = nowMs;
+            }
+        }
+        if (nowMs - lastStatsReportMs >= STATS_REPORT_MS) {
+            ReportStats();
+            lastStatsReportMs = nowMs;
+        }
+        if (directoryAddress && nowMs - lastDirectoryReportMs >= Directory::REPORT_INTERVAL_MS) {
+            ReportToDirectory();
+            lastDirectoryReportMs = nowMs;
+        }
+        if (directoryAddress && nowMs - lastScoreReportMs >= Directory::SCORE_REPORT_INTERVAL_MS) {
+            ReportScoresToDirectory();
+            lastScoreReportMs = nowMs;
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in room server Update: " + std::string(e.what()), error);
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in room server Update", error);
+    }
+}
+
+/**
+ * Stops the workers before touching the rooms, so each room is shut down from
+ * this thread only once nothing else runs its ticks.
+ */
+void RoomServer::Shutdown() {
+    try {
+        workersRunning.store(false, std::memory_order_release);
+        for (std::thread& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers.clear();
+        shardsRunning.store(false, std::memory_order_release);
+        for (auto& shard : shards) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+
+        if (!isRunning && rooms.empty()) {
+            return;
+        }
+
+        LOG_MSG(warning, "Shutting down room server...");
+        for (auto& room : rooms) {
+            room->server.Shutdown();
+        }
+        if (shards.empty()) {
+            FlushOutbound();
+        }
+        for (auto& shard : shards) {
+            FlushShardOutbound(*shard);
+        }
+        rooms.clear();
+        shards.clear();
+        router.routes.clear();
+        router.routeCount = 0;
+        selector.clear();
+        socket.unbind();
+        isRunning = false;
+        LOG_MSG(success, "Room server shut down");
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception during room server shutdown: " + std::string(e.what()), error);
+        isRunning = false;
+    }
+}
+
+/**
+ * Connection requests are answered. A join or spectate request with a valid
+ * token (re)assigns its endpoint to the requested room; a spectator's refresh
+ * for the room it already watches keeps its route without one, since it
+ * repeats a token that may have outlived its epoch. Anything else from an
+ * endpoint without a route is dropped, as is anything the ingress validator
+ * rejects. Routed datagrams have their token checked by the room.
+ */
+RoomServer::RouteAction RoomServer::RouteDatagram(Ingress& ingress, QueuedDatagram& datagram, int64_t nowMs,
+    uint16_t& outRoomId) const {
+    uint64_t token = 0;
+    if (!ConnectionTokens::ReadToken(datagram.packet, token)) {
+        ingress.unroutedCount++;
+        return RouteAction::DROP;
+    }
+    if (!ingress.ingressLimiter.Admit(datagram.packet, datagram.address, datagram.port, datagram.arrivalMicros)) {
+        return RouteAction::DROP;   // Counted by the limiter
+    }
+    if (token == 0) {
+        if (ConnectionTokens::IsConnectionRequest(datagram.packet)) {
+            ingress.challengePacket.clear();
+            ConnectionTokens::WriteChallenge(ingress.challengePacket,
+                connectionTokens.Issue(datagram.address, datagram.port, nowMs));
+            return RouteAction::CHALLENGE;
+        }
+        ingress.unroutedCount++;
+        return RouteAction::DROP;
+    }
+    if (!ingress.validator.Check(datagram.packet, nowMs)) {
+        ingress.invalidCount++;
+        return RouteAction::DROP;
+    }
+    datagram.validated = true;
+
+    const uint64_t key = GameServer::EndpointKey(datagram.address, datagram.port);
+    const uint8_t messageType = ConnectionTokens::PeekMessageType(datagram.packet);
+
+    Route* route = nullptr;
+    if (messageType == static_cast<uint8_t>(NetMessageType::PLAYER_JOIN) ||
+        messageType == static_cast<uint8_t>(NetMessageType::SPECTATE_REQUEST)) {
+        auto it = ingress.routes.find(key);
+        const bool spectatorRoute = messageType == static_cast<uint8_t>(NetMessageType::SPECTATE_REQUEST) &&
+            it != ingress.routes.end();
+        const bool tokenValid = connectionTokens.Validate(token, datagram.address, datagram.port, nowMs);
+        if (!spectatorRoute && !tokenValid) {
+            ingress.unroutedCount++;
+            return RouteAction::DROP;
+        }
+        uint16_t roomId = 0;
+        if (!ReadRequestedRoom(ingress.requestProbe, datagram.packet, roomId)) {
+            LOG_MSG(warning, std::string(GetNetMessageTypeName(messageType)) + " for unknown room " +
+                std::to_string(roomId) + " from " + datagram.address.toString() + ":" + std::to_string(datagram.port));
+            ingress.unroutedCount++;
+            return RouteAction::DROP;
+        }
+        if (spectatorRoute && it->second.roomId != roomId && !tokenValid) {
+            ingress.unroutedCount++;
+            return RouteAction::DROP;
+        }
+        route = &ingress.routes[key];
+        route->roomId = roomId;
+        ingress.routeCount.store(ingress.routes.size(), std::memory_order_relaxed);
+    }
+    else {
+        auto it = ingress.routes.find(key);
+        if (it == ingress.routes.end()) {
+            ingress.unroutedCount++;
+            return RouteAction::DROP;
+        }
+        route = &it->second;
+    }
+
+    route->lastSeenMs = nowMs;
+    outRoomId = route->roomId;
+    return RouteAction::ROOM;
+}
+
+void RoomServer::ReceiveAvailable(int64_t nowMs) {
+    const size_t MAX_DATAGRAMS_PER_UPDATE = 1024;
+
+    QueuedDatagram& datagram = router.receiveStaging;
+    for (size_t i = 0; i < MAX_DATAGRAMS_PER_UPDATE; ++i) {
+        std::optional<sf::IpAddress> sender;
+        unsigned short senderPort = 0;
+        datagram.packet.clear();
+        if (socket.receive(datagram.packet, sender, senderPort) != sf::Socket::Status::Done) {
+            break;
+        }
+        if (!sender) {
+            router.unroutedCount++;
+            continue;
+        }
+        datagram.address = sender.value();
+        datagram.port = senderPort;
+        datagram.arrivalMicros = GetSteadyMicros();
+
+        uint16_t roomId = 0;
+        switch (RouteDatagram(router, datagram, nowMs, roomId)) {
+        case RouteAction::CHALLENGE:
+            if (socket.send(router.challengePacket, datagram.address, datagram.port) == sf::Socket::Status::Done) {
+                router.challengesSent++;
+            }
+            break;
+        case RouteAction::ROOM:
+            rooms[roomId]->channel.PushInbound(datagram);
+            router.routedCount++;
+            break;
+        case RouteAction::DROP:
+            break;
+        }
+    }
+}
+
+void RoomServer::FlushOutbound() {
+    for (auto& room : rooms) {
+        while (room->channel.PopOutbound(router.sendStaging)) {
+            if (socket.send(router.sendStaging.packet, router.sendStaging.address, router.sendStaging.port) ==
+                sf::Socket::Status::Done) {
+                router.sentCount++;
+            }
+        }
+    }
+}
+
+/**
+ * Shard loop: receives and routes, then sends what this shard's rooms
+ * queued, like the router's Update but on the shard's own socket.
+ */
+void RoomServer::RunShard(IngressShard& shard) {
+    TraceRecorder::SetThreadName("Ingress shard");
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::IO, shard.index);
+    while (shardsRunning.load(std::memory_order_acquire)) {
+        try {
+            const bool readable = shard.socket.WaitReadable(SELECTOR_TIMEOUT_MS);
+            const int64_t nowMs = GetCurrentTimestamp();
+            if (readable) {
+                ReceiveShard(shard, nowMs);
+            }
+            FlushShardOutbound(shard);
+            if (nowMs - shard.ingress.lastRouteSweepMs >= 1000) {
+                ExpireRoutes(shard.ingress, nowMs);
+                shard.ingress.lastRouteSweepMs = nowMs;
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in ingress shard " + std::to_string(shard.index) + ": " + std::string(e.what()), error);
+        }
+        catch (...) {
+            Utils::printMsg("Unknown exception in ingress shard " + std::to_string(shard.index), error);
+        }
+    }
+}
+
+/**
+ * Routed datagrams are swapped into the shard's ring for their room; the
+ * room's worker moves them on to the room before its next tick.
+ */
+void RoomServer::ReceiveShard(IngressShard& shard, int64_t nowMs) {
+    const size_t MAX_DATAGRAMS_PER_UPDATE = 1024;
+
+    size_t datagramsRead = 0;
+    while (datagramsRead < MAX_DATAGRAMS_PER_UPDATE) {
+        const size_t count = shard.socket.ReceiveBatch();
+        const int64_t arrivalMicros = GetSteadyMicros();
+        for (size_t i = 0; i < count; ++i) {
+            QueuedDatagram& datagram = shard.socket.GetReceived(i);
+            datagram.arrivalMicros = arrivalMicros;
+            uint16_t roomId = 0;
+            switch (RouteDatagram(shard.ingress, datagram, nowMs, roomId)) {
+            case RouteAction::CHALLENGE:
+                shard.socket.QueueSend(shard.ingress.challengePacket, datagram.address, datagram.port);
+                shard.ingress.challengesSent++;
+                break;
+            case RouteAction::ROOM:
+                if (shard.toRooms[roomId]->TryPush(datagram)) {
+                    shard.ingress.routedCount++;
+                }
+                else {
+                    shard.ingress.ringDropped++;
+                }
+                break;
+            case RouteAction::DROP:
+                break;
+            }
+        }
+        datagramsRead += count;
+        if (count < BatchedUdpSocket::BATCH_SIZE) {
+            break;
+        }
+    }
+}
+
+void RoomServer::FlushShardOutbound(IngressShard& shard) {
+    for (size_t i = shard.index; i < rooms.size(); i += shards.size()) {
+        while (rooms[i]->channel.PopOutbound(shard.ingress.sendStaging)) {
+            shard.socket.QueueSend(shard.ingress.sendStaging.packet, shard.ingress.sendStaging.address,
+                shard.ingress.sendStaging.port);
+            shard.ingress.sentCount++;
+        }
+    }
+    shard.socket.FlushSends();
+}
+
+/**
+ * Reads the room of a spectate request, or the optional trailing roomId of a
+ * join request. Joins without one (older clients) go to room 0.
+ * @return False if the request is malformed or names a room that does not exist
+ */
+bool RoomServer::ReadRequestedRoom(sf::Packet& probe, const sf::Packet& packet, uint16_t& outRoomId) const {
+    probe.clear();
+    probe.append(packet.getData(), packet.getDataSize());
+
+    uint64_t token = 0;
+    uint8_t type = 0;
+    outRoomId = 0;
+    if (!(probe >> token >> type)) {
+        return false;
+    }
+    if (type == static_cast<uint8_t>(NetMessageType::SPECTATE_REQUEST)) {
+        return probe >> outRoomId && outRoomId < rooms.size();
+    }
+
+    std::string playerName;
+    std::string preferredColor;
+    int64_t timestamp = 0;
+    uint32_t sequenceNumber = 0;
+    if (!(probe >> playerName >> preferredColor >> timestamp >> sequenceNumber)) {
+        return false;
+    }
+    if (!probe.endOfPacket() && !(probe >> outRoomId)) {
+        return false;
+    }
+    return outRoomId < rooms.size();
+}
+
+void RoomServer::ExpireRoutes(Ingress& ingress, int64_t nowMs) {
+    for (auto it = ingress.routes.begin(); it != ingress.routes.end();) {
+        if (nowMs - it->second.lastSeenMs > ROUTE_TIMEOUT_MS) {
+            it = ingress.routes.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    ingress.routeCount.store(ingress.routes.size(), std::memory_order_relaxed);
+}
+
+std::string RoomServer::FormatIngress(const Ingress& ingress) {
+    return "Routes: " + std::to_string(ingress.routeCount.load(std::memory_order_relaxed)) +
+        " - Routed: " + std::to_string(ingress.routedCount.load(std::memory_order_relaxed)) +
+        " - Unrouted: " + std::to_string(ingress.unroutedCount.load(std::memory_order_relaxed)) +
+        " - Invalid: " + std::to_string(ingress.invalidCount.load(std::memory_order_relaxed)) +
+        " - Sent: " + std::to_string(ingress.sentCount.load(std::memory_order_relaxed)) +
+        " - Challenges: " + std::to_string(ingress.challengesSent.load(std::memory_order_relaxed)) +
+        " - Rate limited: " + ingress.ingressLimiter.FormatDropped();
+}
+
+void RoomServer::ReportStats() {
+    LOG_MSG(info, "=== ROOM SERVER STATS ===");
+    if (shards.empty()) {
+        LOG_MSG(debug, FormatIngress(router));
+    }
+    for (auto& shard : shards) {
+        const uint64_t ringDropped = shard->ingress.ringDropped.load(std::memory_order_relaxed);
+        LOG_MSG(ringDropped > 0 ? warning : debug, "Ingress shard " + std::to_string(shard->index) + " - " +
+            FormatIngress(shard->ingress) + " - Ring drops: " + std::to_string(ringDropped));
+    }
+
+    for (auto& room : rooms) {
+        PublishedStats stats;
+        {
+            std::lock_guard<std::mutex> lock(room->statsMutex);
+            stats = room->published;
+            room->published.ticks = TickStats();
+        }
+        Utils::printMsg("Room " + std::to_string(room->id) +
+            " - Players: " + std::to_string(stats.playerCount) +
+            " - Ticks: " + std::to_string(stats.ticks.ticksRun) +
+            " - Avg: " + std::to_string(stats.ticks.GetAverageTickMs()) + " ms" +
+            " - Max: " + std::to_string(stats.ticks.maxTickMs) + " ms" +
+            " - Start late avg/max: " + std::to_string(stats.ticks.GetAverageLateMs()) + "/" +
+            std::to_string(stats.ticks.maxLateMs) + " ms" +
+            " - Overruns: " + std::to_string(stats.ticks.overrunTicks) +
+            " - Dropped in/out: " + std::to_string(room->channel.GetInboundDropped()) + "/" +
+            std::to_string(room->channel.GetOutboundDropped()),
+            (stats.ticks.overrunTicks > 0 || stats.ticks.droppedTicks > 0) ? warning : debug);
+    }
+}
+
+void RoomServer::SetDirectory(const sf::IpAddress& address, unsigned short port,
+    std::optional<sf::IpAddress> advertisedAddress) {
+    directoryAddress = address;
+    directoryPort = port;
+    directoryAdvertisedAddress = advertisedAddress ? advertisedAddress->toInteger() : 0;
+}
+
+/**
+ * One report for the whole process: every room's players and tick headroom
+ * as last published by its worker.
+ */
+void RoomServer::ReportToDirectory() {
+    Directory::LoadReport report;
+    report.advertisedAddress = directoryAdvertisedAddress;
+    report.gamePort = serverPort;
+    report.maxPlayersPerRoom = maxPlayersPerRoom;
+    for (auto& room : rooms) {
+        Directory::RoomLoad load;
+        {
+            std::lock_guard<std::mutex> lock(room->statsMutex);
+            load.players = static_cast<uint16_t>(std::min<size_t>(room->published.playerCount, UINT16_MAX));
+            load.headroomPercent = room->published.headroomPercent;
+        }
+        report.rooms.push_back(load);
+    }
+
+    sf::Packet packet;
+    Directory::WriteReport(packet, report);
+    if (socket.send(packet, *directoryAddress, directoryPort) == sf::Socket::Status::Error) {
+        LOG_MSG(warning, "Failed to report load to the directory");
+    }
+}
+
+/**
+ * Every room's score changes as last published by its worker, a few players
+ * per datagram (see GameServer::ReportScoresToDirectory).
+ */
+void RoomServer::ReportScoresToDirectory() {
+    scoreBatch.clear();
+    for (auto& room : rooms) {
+        std::lock_guard<std::mutex> lock(room->statsMutex);
+        std::vector<Directory::ScoreChange>& changes = room->published.scoreChanges;
+        std::move(changes.begin(), changes.end(), std::back_inserter(scoreBatch));
+        changes.clear();
+    }
+    for (size_t next = 0; next < scoreBatch.size();) {
+        sf::Packet packet;
+        next = Directory::WriteScores(packet, scoreBatch, next);
+        if (socket.send(packet, *directoryAddress, directoryPort) == sf::Socket::Status::Error) {
+            LOG_MSG(warning, "Failed to report scores to the directory");
+        }
+    }
+}
+
+/**
+ * Worker loop: runs the due ticks of rooms workerIndex, workerIndex + workerCount, ...
+ * and periodically hands their tick stats to the router. Every room is ticked
+ * by exactly one worker, so a room's GameServer is only ever touched by one thread.
+ * With ingress shards the worker also moves each room's datagrams from the
+ * shards' rings into the room's channel, so that ring keeps a single producer.
+ */
+void RoomServer::RunWorker(size_t workerIndex, unsigned int workerCount) {
+    TraceRecorder::SetThreadName("Room worker");
+    // Without configured simulation cores a worker still takes a core of its
+    // own so its rooms stay cache-warm, skipping any reserved for I/O
+    const ThreadTuning& tuning = ThreadTuner::GetTuning();
+    if (tuning.simulationCores.empty()) {
+        std::vector<unsigned int> available;
+        const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int core = 0; core < cores; ++core) {
+            if (std::find(tuning.ioCores.begin(), tuning.ioCores.end(), core) == tuning.ioCores.end()) {
+                available.push_back(core);
+            }
+        }
+        if (available.empty() || !ThreadTuner::PinCurrentThread(available[workerIndex % available.size()])) {
+            LOG_MSG(warning, "Room worker " + std::to_string(workerIndex) + " could not be pinned to a core");
+        }
+    }
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::SIMULATION, workerIndex);
+
+    std::vector<Room*> owned;
+    for (size_t i = workerIndex; i < rooms.size(); i += workerCount) {
+        owned.push_back(rooms[i].get());
+    }
+
+    QueuedDatagram handoff;
+    int64_t lastPublishMs = GetCurrentTimestamp();
+    while (workersRunning.load(std::memory_order_acquire)) {
+        try {
+            for (Room* room : owned) {
+                for (auto& shard : shards) {
+                    ShardRing& ring = *shard->toRooms[room->id];
+                    while (ring.TryPop(handoff)) {
+                        room->channel.PushInbound(handoff);
+                    }
+                }
+                room->server.RunScheduledTicks();
+            }
+
+            const int64_t nowMs = GetCurrentTimestamp();
+            if (nowMs - lastPublishMs >= STATS_PUBLISH_MS) {
+                for (Room* room : owned) {
+                    const TickStats ticks = room->server.TakeTickStats();
+                    std::lock_guard<std::mutex> lock(room->statsMutex);
+                    PublishedStats& published = room->published;
+                    published.playerCount = room->server.GetPlayerCount();
+                    room->server.TakeScoreChanges(published.scoreChanges);
+                    published.ticks.Merge(ticks);
+                    if (ticks.ticksRun > 0) {
+                        published.headroomPercent = Directory::ComputeHeadroom(ticks.GetAverageTickMs(),
+                            room->server.GetTickRate());
+                    }
+                }
+                lastPublishMs = nowMs;
+            }
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in room worker " + std::to_string(workerIndex) + ": " + std::string(e.what()), error);
+        }
+        catch (...) {
+            Utils::printMsg("Unknown exception in room worker " + std::to_string(workerIndex), error);
+        }
+
+        // Rooms keep their own fixed-step accumulators; this only bounds how late a tick can start
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "batched_udp_socket.h"
+#include "datagram_channel.h"
+#include "game_server.h"
+#include "spsc_ring_buffer.h"
+#include "tick_scheduler.h"
+
+// Hosts several independent game worlds (rooms) in one process.
+// The router (the thread calling Update) owns the only socket: it routes each
+// datagram to its sender's room and sends what the rooms queue back. Rooms are
+// hosted GameServers exchanging datagrams with the router over a
+// DatagramChannel; their ticks run on a fixed set of worker threads, each
+// pinned to one core and owning a round-robin share of the rooms.
+// Clients pick a room with the roomId field of their join request.
+// The router answers connection requests and checks the token of every join
+// before creating a route; rooms share its token key (see ConnectionTokens).
+//
+// With ingress shards (Linux) the port is shared by several sockets instead,
+// each received on by its own thread; the kernel keeps every client endpoint
+// on one shard. Each shard checks tokens and keeps the routes of its clients,
+// so shards share nothing but the token key. They hand datagrams to a ring
+// per room that the room's worker drains, and shard N sends what rooms N,
+// N + shardCount, ... queue back. The calling thread only reports.
+class RoomServer {
+public:
+    static constexpr uint16_t MAX_ROOMS = 64;
+    static constexpr int SELECTOR_TIMEOUT_MS = 1;            // Max router wait for socket readiness
+    static constexpr int64_t ROUTE_TIMEOUT_MS = 20000;       // Forget endpoints silent this long (> client timeout)
+    static constexpr int64_t STATS_PUBLISH_MS = 1000;        // Workers hand tick stats to the router this often
+    static constexpr int64_t STATS_REPORT_MS = 5000;         // Router prints per-room stats this often
+    static constexpr unsigned int MAX_INGRESS_SHARDS = 16;
+    static constexpr size_t SHARD_RING_CAPACITY = 512;      // Per shard and room (power of two)
+
+    // workerCount 0 uses one worker per hardware thread (capped at the room count)
+    RoomServer(unsigned short port, uint16_t roomCount,
+        unsigned int tickRateHz = TickScheduler::DEFAULT_TICK_RATE, unsigned int workerCount = 0);
+    ~RoomServer();
+
+    RoomServer(const RoomServer&) = delete;
+    RoomServer& operator=(const RoomServer&) = delete;
+
+    // Applied to every room (must be set before Initialize)
+    void SetEventBulletReplication(bool enabled) { eventBulletReplication = enabled; }
+    void SetClientBandwidth(uint32_t bytesPerSecond) { clientBandwidth = bytesPerSecond; }
+    void SetReplicationRates(const ReplicationRates& rates) { replicationRates = rates; }
+    void SetDeadReckoning(const DeadReckoningSettings& settings) { deadReckoning = settings; }
+    void SetCompressionThreshold(uint32_t bytes) { compressionThreshold = bytes; }
+    void SetMaxPlayersPerRoom(uint32_t count) { maxPlayersPerRoom = count; }
+    void SetOverloadControl(bool enabled) { overloadControl = enabled; }
+    void SetEnemySquads(bool enabled) { enemySquads = enabled; }
+    void SetChunkActiveRadius(int chunks) { chunkActiveRadius = chunks; }
+    void SetMapObstacles(std::vector<StaticObstacles::Obstacle> obstacles) { mapObstacles = std::move(obstacles); }
+    void SetSpectatorStream(uint32_t delayMs, size_t spectatorsPerRoom) { spectatorDelayMs = delayMs; maxSpectators = spectatorsPerRoom; }
+    // Receive sockets sharing the port, one thread each (must be set before
+    // Initialize). Above 1 needs BatchedUdpSocket::IsPortSharingSupported().
+    void SetIngressShards(unsigned int count) { requestedShards = count; }
+    // Rooms dump to "<pathPrefix>-room<id>-tick<N>.json" (see GameServer::SetSlowTickTrace)
+    void SetSlowTickTrace(const std::string& pathPrefix, uint32_t thresholdMs) {
+        slowTickTracePrefix = pathPrefix;
+        slowTickTraceMs = thresholdMs;
+    }
+
+    // Reports every room's load to a directory service (see GameServer::SetDirectory)
+    void SetDirectory(const sf::IpAddress& address, unsigned short port,
+        std::optional<sf::IpAddress> advertisedAddress = std::nullopt);
+
+    bool Initialize();
+
+    // Router step: receives and routes pending datagrams, then sends everything
+    // the rooms queued. Waits up to SELECTOR_TIMEOUT_MS for traffic. With
+    // ingress shards the shard threads do that and this only reports.
+    void Update();
+
+    void Shutdown();
+
+    bool IsRunning() const { return isRunning; }
+    uint16_t GetRoomCount() const { return static_cast<uint16_t>(rooms.size()); }
+    size_t GetWorkerCount() const { return workers.size(); }
+    size_t GetIngressShardCount() const { return shards.empty() ? 1 : shards.size(); }
+
+private:
+    // Tick stats a worker has handed over since the last report
+    struct PublishedStats {
+        size_t playerCount;
+        TickStats ticks;
+        uint8_t headroomPercent;    // Over the last publish interval
+        std::vector<Directory::ScoreChange> scoreChanges;   // For the next score report (see GameServer::TakeScoreChanges)
+        PublishedStats() : playerCount(0), headroomPercent(100) {}
+    };
+
+    struct Room {
+        uint16_t id;
+        DatagramChannel channel;
+        GameServer server;
+
+        std::mutex statsMutex;    // Guards published (worker writes, router reads)
+        PublishedStats published;
+
+        Room(uint16_t roomId, unsigned short port, unsigned int tickRateHz)
+            : id(roomId), server(port, tickRateHz) {
+        }
+    };
+
+    struct Route {
+        uint16_t roomId;
+        int64_t lastSeenMs;
+    };
+
+    // Routing state of one receiving thread (the router or an ingress shard).
+    // Counters are atomic because the reporting thread reads them.
+    struct Ingress {
+        std::unordered_map<uint64_t, Route> routes;   // GameServer::EndpointKey -> room
+        QueuedDatagram receiveStaging;                // Swapped into the room's inbound ring
+        QueuedDatagram sendStaging;
+        sf::Packet requestProbe;                      // Copy of a join or spectate request being inspected
+        sf::Packet challengePacket;
+        IngressRateLimiter ingressLimiter;
+        IngressValidator validator;
+        int64_t lastRouteSweepMs = 0;
+        std::atomic<size_t> routeCount{ 0 };
+        std::atomic<uint64_t> routedCount{ 0 };
+        std::atomic<uint64_t> unroutedCount{ 0 };
+        std::atomic<uint64_t> invalidCount{ 0 };      // Failed the validator
+        std::atomic<uint64_t> sentCount{ 0 };
+        std::atomic<uint64_t> challengesSent{ 0 };
+        std::atomic<uint64_t> ringDropped{ 0 };       // Shards: a room's ring was full
+    };
+
+    using ShardRing = SpscRingBuffer<QueuedDatagram, SHARD_RING_CAPACITY>;
+
+    struct IngressShard {
+        size_t index = 0;
+        Ingress ingress;
+        BatchedUdpSocket socket;
+        std::vector<std::unique_ptr<ShardRing>> toRooms;    // By room id; drained by the room's worker
+        std::thread thread;
+    };
+
+    enum class RouteAction { DROP, CHALLENGE, ROOM };
+
+    unsigned short serverPort;
+    uint16_t requestedRooms;
+    unsigned int tickRate;
+    unsigned int requestedWorkers;
+    bool eventBulletReplication;
+    uint32_t clientBandwidth;
+    ReplicationRates replicationRates;
+    DeadReckoningSettings deadReckoning;
+    uint32_t compressionThreshold;
+    uint32_t maxPlayersPerRoom;
+    bool overloadControl;
+    bool enemySquads;
+    int chunkActiveRadius = WorldChunks::DEFAULT_ACTIVE_RADIUS;
+    std::vector<StaticObstacles::Obstacle> mapObstacles;     // Loaded once, copied into every room
+    uint32_t spectatorDelayMs = SpectatorStream::DEFAULT_DELAY_MS;
+    size_t maxSpectators = SpectatorStream::MAX_SPECTATORS;
+    std::string slowTickTracePrefix;
+    uint32_t slowTickTraceMs = 0;
+    unsigned int requestedShards = 1;
+    bool isRunning;
+
+    sf::UdpSocket socket;               // Game traffic, or only directory reports with shards
+    sf::SocketSelector selector;
+
+    std::vector<std::unique_ptr<Room>> rooms;
+    std::vector<std::thread> workers;
+    std::atomic<bool> workersRunning;
+    std::vector<std::unique_ptr<IngressShard>> shards;  // Empty: the router receives on socket
+    std::atomic<bool> shardsRunning;
+    ConnectionTokens connectionTokens;  // Read-only once running
+
+    // Router thread only
+    Ingress router;
+    int64_t lastStatsReportMs;
+    std::optional<sf::IpAddress> directoryAddress;
+    unsigned short directoryPort;
+    uint32_t directoryAdvertisedAddress;
+    int64_t lastDirectoryReportMs;
+    int64_t lastScoreReportMs;
+    std::vector<Directory::ScoreChange> scoreBatch;
+
+    void RunShard(IngressShard& shard);
+    void ReceiveShard(IngressShard& shard, int64_t nowMs);
+    void FlushShardOutbound(IngressShard& shard);
+
+    // Decides where a datagram (address, port and arrival set) goes. Any
+    // receiving thread may call it with its own ingress; CHALLENGE leaves the
+    // reply in ingress.challengePacket and ROOM sets outRoomId.
+    RouteAction RouteDatagram(Ingress& ingress, QueuedDatagram& datagram, int64_t nowMs, uint16_t& outRoomId) const;
+    void ReceiveAvailable(int64_t nowMs);
+    void FlushOutbound();
+    bool ReadRequestedRoom(sf::Packet& probe, const sf::Packet& packet, uint16_t& outRoomId) const;
+    static void ExpireRoutes(Ingress& ingress, int64_t nowMs);
+    static std::string FormatIngress(const Ingress& ingress);
+    void ReportStats();
+    void ReportToDirectory();
+    void ReportScoresToDirectory();
+
+    void RunWorker(size_t workerIndex, unsigned int workerCount);
+};
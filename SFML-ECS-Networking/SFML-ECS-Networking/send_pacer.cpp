@@ -0,0 +1,54 @@
+#include "send_pacer.h"
+#include <algorithm>
+#include <numeric>
+
+void SendPacer::BeginTick(int64_t nowMicros, int64_t windowMicros, size_t clientCount) {
+    tickStartMicros = nowMicros;
+    windowEndMicros = nowMicros + std::max<int64_t>(windowMicros, 0);
+    slotMicros = clientCount > 0 ? std::max<int64_t>(windowMicros, 0) / static_cast<int64_t>(clientCount) : 0;
+    clientIndex = 0;
+    entryCount = 0;
+    order.clear();
+    next = 0;
+}
+
+void SendPacer::BeginClient(float bytesPerSecond) {
+    clientDueMicros = std::min(tickStartMicros + slotMicros * static_cast<int64_t>(clientIndex), windowEndMicros);
+    clientRate = bytesPerSecond;
+    clientIndex++;
+}
+
+/**
+ * The datagram after this one waits for this one's bytes at the client's
+ * rate; without a rate it follows at once.
+ */
+void SendPacer::Queue(const sf::Packet& datagram, sf::IpAddress address, unsigned short port) {
+    if (entryCount == entries.size()) {
+        entries.emplace_back();
+    }
+    Entry& entry = entries[entryCount++];
+    entry.datagram = datagram;
+    entry.address = address;
+    entry.port = port;
+    entry.dueMicros = clientDueMicros;
+
+    stats.datagrams++;
+    stats.totalOffsetMicros += static_cast<uint64_t>(clientDueMicros - tickStartMicros);
+    if (clientRate > 0.0f) {
+        const int64_t sendMicros = static_cast<int64_t>(datagram.getDataSize() * 1000000.0 / clientRate);
+        clientDueMicros = std::min(clientDueMicros + sendMicros, windowEndMicros);
+    }
+}
+
+/**
+ * A client's datagrams are due in queue order and the index breaks ties, so
+ * the order is total and a plain sort keeps each client's sequence.
+ */
+void SendPacer::EndTick() {
+    order.resize(entryCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return entries[a].dueMicros != entries[b].dueMicros ? entries[a].dueMicros < entries[b].dueMicros : a < b;
+    });
+    next = 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Spreads a tick's outgoing datagrams over the tick instead of sending them
+// all as it ends, so with many clients the socket buffer, the NIC and home
+// routers see a steady trickle rather than one burst per tick. Clients are
+// staggered across the first WINDOW_FRACTION of the tick (client i of n
+// starts i/n of the way in); one client's datagrams follow each other at its
+// bandwidth budget's rate, or back to back when it has no limit. Nothing is
+// scheduled past the window.
+//
+// The server loop releases due datagrams while it waits for the next tick.
+// Whatever is still queued when the next tick flushes goes out first then,
+// so datagrams to a client never overtake each other.
+//
+// Datagrams are copied in; the copies keep their capacity between ticks, so
+// a warm pacer does not allocate.
+class SendPacer {
+public:
+    static constexpr float WINDOW_FRACTION = 0.75f;     // Of the tick; the rest is slack before the next one
+
+    struct Stats {
+        uint64_t datagrams = 0;         // Scheduled
+        uint64_t late = 0;              // Not released before the next tick's flush
+        uint64_t totalOffsetMicros = 0; // Due time after the flush, summed over datagrams
+    };
+
+    // Starts a tick's schedule, windowMicros long from nowMicros, for clientCount clients.
+    // Everything from the previous tick must have been released.
+    void BeginTick(int64_t nowMicros, int64_t windowMicros, size_t clientCount);
+    // Moves to the next client's slot. Its datagrams are spaced for bytesPerSecond (0 = unlimited)
+    void BeginClient(float bytesPerSecond);
+    void Queue(const sf::Packet& datagram, sf::IpAddress address, unsigned short port);
+    // Orders the tick's datagrams by due time
+    void EndTick();
+
+    // Hands each datagram due by nowMicros to send(sf::Packet&, sf::IpAddress, unsigned short)
+    template <typename SendFn>
+    void Release(int64_t nowMicros, SendFn&& send);
+    // Sends everything still queued, due or not
+    template <typename SendFn>
+    void ReleaseAll(SendFn&& send);
+
+    bool HasPending() const { return next < order.size(); }
+    int64_t GetNextDueMicros() const { return entries[order[next]].dueMicros; }
+
+    const Stats& GetStats() const { return stats; }
+    void ResetStats() { stats = Stats(); }
+
+private:
+    struct Entry {
+        sf::Packet datagram;
+        sf::IpAddress address = sf::IpAddress::Any;
+        unsigned short port = 0;
+        int64_t dueMicros = 0;
+    };
+
+    std::vector<Entry> entries;         // The first entryCount are this tick's; the rest keep their buffers
+    size_t entryCount = 0;
+    std::vector<uint32_t> order;        // This tick's entries by due time
+    size_t next = 0;                    // order[next] is sent next
+
+    int64_t tickStartMicros = 0;
+    int64_t windowEndMicros = 0;
+    int64_t slotMicros = 0;             // Offset between two clients' first datagrams
+    size_t clientIndex = 0;             // Of the client being scheduled, + 1
+    int64_t clientDueMicros = 0;        // Of its next datagram
+    float clientRate = 0.0f;
+
+    Stats stats;
+};
+
+template <typename SendFn>
+void SendPacer::Release(int64_t nowMicros, SendFn&& send) {
+    while (next < order.size() && entries[order[next]].dueMicros <= nowMicros) {
+        Entry& entry = entries[order[next++]];
+        send(entry.datagram, entry.address, entry.port);
+    }
+}
+
+template <typename SendFn>
+void SendPacer::ReleaseAll(SendFn&& send) {
+    stats.late += order.size() - next;
+    while (next < order.size()) {
+        Entry& entry = entries[order[next++]];
+        send(entry.datagram, entry.address, entry.port);
+    }
+}
@@ -0,0 +1,68 @@
+#include "sequence_window.h"
+
+static_assert(SequenceWindow::SIZE % 64 == 0, "SequenceWindow::SIZE must be a multiple of 64");
+
+/**
+ * Records a received sequence. A newer sequence slides the window forward,
+ * clearing the slots it passes over (those sequences count as lost until they
+ * arrive late).
+ */
+bool SequenceWindow::Record(uint32_t sequence) {
+    if (!hasLatest) {
+        hasLatest = true;
+        latest = sequence;
+        SetBit(sequence);
+        span = 1;
+        receivedCount = 1;
+        return true;
+    }
+
+    if (IsNewer(sequence, latest)) {
+        const uint32_t advance = sequence - latest;
+        if (advance >= SIZE) {
+            bits.fill(0);
+            receivedCount = 0;
+        }
+        else {
+            for (uint32_t step = 1; step <= advance; ++step) {
+                const uint32_t entering = latest + step;
+                // The slot being reused held entering - SIZE, which now leaves the window
+                if (TestBit(entering)) {
+                    ClearBit(entering);
+                    receivedCount--;
+                }
+            }
+        }
+        span = advance >= SIZE - span ? SIZE : span + advance;
+        latest = sequence;
+        SetBit(sequence);
+        receivedCount++;
+        return true;
+    }
+
+    const uint32_t age = latest - sequence;
+    if (age >= SIZE || TestBit(sequence)) {
+        return false;
+    }
+    SetBit(sequence);
+    receivedCount++;
+    if (age >= span) {
+        span = age + 1;
+    }
+    return true;
+}
+
+bool SequenceWindow::Contains(uint32_t sequence) const {
+    if (!hasLatest || IsNewer(sequence, latest)) {
+        return false;
+    }
+    return latest - sequence < SIZE && TestBit(sequence);
+}
+
+void SequenceWindow::Clear() {
+    bits.fill(0);
+    latest = 0;
+    span = 0;
+    receivedCount = 0;
+    hasLatest = false;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Tracks which of the last SIZE sequence numbers were received, as a bitset
+// ring indexed by sequence % SIZE. Recording, duplicate checks and the loss
+// estimate are O(1) and never allocate. Sequence comparisons are wrap-aware.
+class SequenceWindow {
+public:
+    static constexpr uint32_t SIZE = 1024;
+
+    SequenceWindow() { Clear(); }
+
+    // Wrap-aware: true if a comes after b
+    static bool IsNewer(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b) > 0;
+    }
+
+    // @return False for duplicates and sequences too old to track
+    bool Record(uint32_t sequence);
+
+    // @return True if sequence was received and is still inside the window
+    bool Contains(uint32_t sequence) const;
+
+    bool HasReceived() const { return hasLatest; }
+    uint32_t GetLatest() const { return latest; }
+
+    // Sequences the window currently covers (grows to SIZE as traffic arrives)
+    uint32_t GetSpan() const { return span; }
+    uint32_t GetReceivedCount() const { return receivedCount; }
+    float GetLossPercentage() const {
+        return span == 0 ? 0.0f : (static_cast<float>(span - receivedCount) / static_cast<float>(span)) * 100.0f;
+    }
+
+    void Clear();
+
+private:
+    static constexpr uint32_t WORD_BITS = 64;
+
+    std::array<uint64_t, SIZE / WORD_BITS> bits;
+    uint32_t latest;
+    uint32_t span;
+    uint32_t receivedCount;
+    bool hasLatest;
+
+    bool TestBit(uint32_t sequence) const {
+        const uint32_t slot = sequence % SIZE;
+        return (bits[slot / WORD_BITS] >> (slot % WORD_BITS)) & 1u;
+    }
+    void SetBit(uint32_t sequence) {
+        const uint32_t slot = sequence % SIZE;
+        bits[slot / WORD_BITS] |= uint64_t(1) << (slot % WORD_BITS);
+    }
+    void ClearBit(uint32_t sequence) {
+        const uint32_t slot = sequence % SIZE;
+        bits[slot / WORD_BITS] &= ~(uint64_t(1) << (slot % WORD_BITS));
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <memory>
+#include "EnemyTank.h"
+
+// Components of the server's enemy registry (entt). The small POD components
+// are what the per-tick systems read: broadphase rebuilds, tank separation,
+// lag compensation history and snapshot building iterate them contiguously.
+// EnemyBrain holds the behaviour state and is only touched by the AI step and
+// by damage; SyncEnemyComponents copies its results back into the PODs.
+namespace ServerComponents {
+    // Replicated ID (enemies start at 1000)
+    struct NetworkId {
+        uint32_t id;
+    };
+
+    struct Transform {
+        sf::Vector2f position;
+        float bodyRotation;     // Degrees
+        float barrelRotation;   // Degrees
+        float radius;
+    };
+
+    struct Health {
+        float current;
+        float max;
+        bool dead;
+    };
+
+    // Snapshot fields (SnapshotDelta::ENEMY_*) changed since the world snapshot
+    // was last updated. Only enemies with changes carry it, so the update
+    // walks just those (see GameServer::MarkEnemyDirty)
+    struct Dirty {
+        uint8_t fields;
+    };
+
+    struct EnemyKind {
+        EnemyTank::EnemyType type;
+    };
+
+    struct EnemyBrain {
+        std::unique_ptr<EnemyTank> tank;
+    };
+}
@@ -0,0 +1,355 @@
+#include "server_options.h"
+#include "directory_service.h"
+#include "packet_compression.h"
+#include "room_server.h"
+#include "spectator_relay.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    constexpr const char* SERVER_FLAG = "--server";
+    constexpr const char* CONFIG_KEY = "config";
+
+    std::string Trim(const std::string& text) {
+        const size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            return std::string();
+        }
+        const size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    // Whole string as an integer in [minimum, maximum]
+    bool ParseInteger(const std::string& text, long long minimum, long long maximum, long long& value) {
+        try {
+            size_t used = 0;
+            const long long parsed = std::stoll(text, &used);
+            if (used != text.size() || parsed < minimum || parsed > maximum) {
+                return false;
+            }
+            value = parsed;
+            return true;
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool ParseFlag(const std::string& text, bool& value) {
+        if (text == "1" || text == "true" || text == "yes" || text == "on") {
+            value = true;
+            return true;
+        }
+        if (text == "0" || text == "false" || text == "no" || text == "off") {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
+    // Splits "--key=value" or "--key value"; a bare "--flag" means "true".
+    // @return False if the argument is not an option
+    bool SplitOption(int argc, char* argv[], int& index, std::string& key, std::string& value) {
+        const std::string argument = argv[index];
+        if (argument.size() < 3 || argument.compare(0, 2, "--") != 0) {
+            return false;
+        }
+        const size_t equals = argument.find('=');
+        if (equals != std::string::npos) {
+            key = argument.substr(2, equals - 2);
+            value = argument.substr(equals + 1);
+        }
+        else if (index + 1 < argc && std::strncmp(argv[index + 1], "--", 2) != 0) {
+            key = argument.substr(2);
+            value = argv[++index];
+        }
+        else {
+            key = argument.substr(2);
+            value = "true";
+        }
+        return true;
+    }
+}
+
+bool ServerOptions::Set(const std::string& key, const std::string& value) {
+    long long number = 0;
+    if (key == "port") {
+        if (!ParseInteger(value, 1024, 65535, number)) return false;
+        port = static_cast<unsigned short>(number);
+    }
+    else if (key == "tick-rate") {
+        if (!ParseInteger(value, TickScheduler::MIN_TICK_RATE, TickScheduler::MAX_TICK_RATE, number)) return false;
+        tickRate = static_cast<unsigned int>(number);
+    }
+    else if (key == "max-players") {
+        if (!ParseInteger(value, 1, NetworkValidation::MAX_PLAYER_COUNT, number)) return false;
+        maxPlayers = static_cast<uint32_t>(number);
+    }
+    else if (key == "rooms") {
+        if (!ParseInteger(value, 1, RoomServer::MAX_ROOMS, number)) return false;
+        roomCount = static_cast<uint16_t>(number);
+    }
+    else if (key == "ingress-shards") {
+        if (!ParseInteger(value, 1, RoomServer::MAX_INGRESS_SHARDS, number)) return false;
+        ingressShards = static_cast<uint32_t>(number);
+    }
+    else if (key == "metrics-port") {
+        if (!ParseInteger(value, 0, 65535, number)) return false;
+        metricsPort = static_cast<unsigned short>(number);
+    }
+    else if (key == "network-thread") {
+        return ParseFlag(value, networkThread);
+    }
+    else if (key == "batched-socket") {
+        return ParseFlag(value, batchedSocket);
+    }
+    else if (key == "shared-memory") {
+        return ParseFlag(value, sharedMemory);
+    }
+    else if (key == "snapshot-pipeline") {
+        return ParseFlag(value, snapshotPipeline);
+    }
+    else if (key == "send-pacing") {
+        return ParseFlag(value, sendPacing);
+    }
+    else if (key == "event-bullets") {
+        return ParseFlag(value, eventBullets);
+    }
+    else if (key == "client-bandwidth") {
+        if (!ParseInteger(value, 0, UINT32_MAX, number)) return false;
+        clientBandwidth = static_cast<uint32_t>(number);
+    }
+    else if (key == "replication-rates") {
+        return ReplicationRates::Parse(value, replicationRates);
+    }
+    else if (key == "dead-reckoning") {
+        // A flag switches it on or off with the default thresholds
+        return ParseFlag(value, deadReckoning.enabled) || DeadReckoningSettings::Parse(value, deadReckoning);
+    }
+    else if (key == "compress-above") {
+        if (!ParseInteger(value, 0, PacketCompressor::MAX_RAW_BYTES, number)) return false;
+        compressionThreshold = static_cast<uint32_t>(number);
+    }
+    else if (key == "parallel-ai") {
+        return ParseFlag(value, parallelEnemyAI);
+    }
+    else if (key == "ai-budget-us") {
+        if (!ParseInteger(value, 0, UINT32_MAX, number)) return false;
+        enemyAIBudgetUs = static_cast<uint32_t>(number);
+    }
+    else if (key == "overload-control") {
+        return ParseFlag(value, overloadControl);
+    }
+    else if (key == "enemy-squads") {
+        return ParseFlag(value, enemySquads);
+    }
+    else if (key == "chunk-active-radius") {
+        if (!ParseInteger(value, 0, std::max(WorldChunks::COLUMNS, WorldChunks::ROWS), number)) return false;
+        chunkActiveRadius = static_cast<int>(number);
+    }
+    else if (key == "spectator-delay") {
+        if (!ParseInteger(value, 0, SpectatorStream::MAX_DELAY_MS, number)) return false;
+        spectatorDelayMs = static_cast<uint32_t>(number);
+    }
+    else if (key == "max-spectators") {
+        if (!ParseInteger(value, 0, 100000, number)) return false;
+        maxSpectators = static_cast<uint32_t>(number);
+    }
+    else if (key == "horde") {
+        if (!ParseInteger(value, 1, GameServer::MAX_HORDE_SIZE, number)) return false;
+        hordeSize = static_cast<uint32_t>(number);
+    }
+    else if (key == "lan-multicast") {
+        // A flag switches it on with the default group
+        bool enabled = false;
+        if (ParseFlag(value, enabled)) {
+            lanMulticastGroup = enabled ? LanMulticast::DEFAULT_GROUP : 0;
+            lanMulticastPort = enabled ? LanMulticast::DEFAULT_PORT : 0;
+            return true;
+        }
+        sf::IpAddress group = sf::IpAddress::Any;
+        unsigned short groupPort = 0;
+        if (!LanMulticast::ParseGroup(value, group, groupPort)) return false;
+        lanMulticastGroup = group.toInteger();
+        lanMulticastPort = groupPort;
+    }
+    else if (key == "network-conditions") {
+        return NetworkConditions::Parse(value, networkConditions);
+    }
+    else if (key == "map") {
+        if (value.empty()) return false;
+        mapPath = value;
+    }
+    else if (key == "record") {
+        recordingPath = value;
+    }
+    else if (key == "capture") {
+        if (value.empty()) return false;
+        capturePath = value;
+    }
+    else if (key == "journal") {
+        if (value.empty()) return false;
+        journalPath = value;
+    }
+    else if (key == "checkpoint") {
+        if (value.empty()) return false;
+        checkpointPath = value;
+    }
+    else if (key == "handoff") {
+        if (value.empty()) return false;
+        handoffPath = value;
+    }
+    else if (key == "ready-file") {
+        readyFile = value;
+    }
+    else if (key == "directory") {
+        sf::IpAddress address = sf::IpAddress::LocalHost;
+        unsigned short directoryPort = 0;
+        if (!Directory::ParseEndpoint(value, address, directoryPort)) return false;
+        directory = value;
+    }
+    else if (key == "advertise-address") {
+        if (!sf::IpAddress::resolve(value)) return false;
+        advertiseAddress = value;
+    }
+    else if (key == "trace") {
+        if (value.empty()) return false;
+        tracePath = value;
+    }
+    else if (key == "trace-slow-tick-ms") {
+        if (!ParseInteger(value, 0, 60000, number)) return false;
+        slowTickTraceMs = static_cast<uint32_t>(number);
+    }
+    else if (key == "simulation-cores") {
+        return ThreadTuning::ParseCores(value, threadTuning.simulationCores);
+    }
+    else if (key == "io-cores") {
+        return ThreadTuning::ParseCores(value, threadTuning.ioCores);
+    }
+    else if (key == "high-priority") {
+        return ParseFlag(value, threadTuning.highPriority);
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+bool ServerOptions::LoadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        Utils::printMsg("Error: Could not open server config " + path, error);
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        line = Trim(line);
+        if (line.empty()) {
+            continue;
+        }
+        const size_t equals = line.find('=');
+        const std::string key = equals != std::string::npos ? Trim(line.substr(0, equals)) : line;
+        const std::string value = equals != std::string::npos ? Trim(line.substr(equals + 1)) : "true";
+        if (!Set(key, value)) {
+            Utils::printMsg("Error: " + path + ":" + std::to_string(lineNumber) + ": invalid setting '" + line + "'", error);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ServerOptions::IsServerCommandLine(int argc, char* argv[]) {
+    return argc > 1 && std::strcmp(argv[1], SERVER_FLAG) == 0;
+}
+
+/**
+ * Two passes: the config file first, then every other option on top of it.
+ */
+bool ServerOptions::ParseCommandLine(int argc, char* argv[], ServerOptions& options) {
+    ServerOptions parsed;
+    std::string key, value;
+    for (int i = 2; i < argc; ++i) {
+        if (!SplitOption(argc, argv, i, key, value)) {
+            Utils::printMsg("Error: Unexpected argument '" + std::string(argv[i]) + "'", error);
+            return false;
+        }
+        if (key == CONFIG_KEY && !parsed.LoadFile(value)) {
+            return false;
+        }
+    }
+    for (int i = 2; i < argc; ++i) {
+        SplitOption(argc, argv, i, key, value);
+        if (key == "help") {
+            PrintUsage();
+            return false;
+        }
+        if (key != CONFIG_KEY && !parsed.Set(key, value)) {
+            Utils::printMsg("Error: Invalid option --" + key + " " + value, error);
+            return false;
+        }
+    }
+    options = parsed;
+    return true;
+}
+
+void ServerOptions::PrintUsage() {
+    std::cout <<
+        "Usage: TankGame --server [options]\n"
+        "  --config <file>              key = value lines, overridden by the options below\n"
+        "  --port <1024-65535>          UDP port (default 53000)\n"
+        "  --tick-rate <Hz>             Simulation rate, " << TickScheduler::MIN_TICK_RATE << "-" <<
+        TickScheduler::MAX_TICK_RATE << " (default " << TickScheduler::DEFAULT_TICK_RATE << ")\n"
+        "  --max-players <n>            Players per room (default " << NetworkValidation::MAX_PLAYER_COUNT << ")\n"
+        "  --rooms <n>                  Rooms on one socket (default 1)\n"
+        "  --ingress-shards <n>         With rooms: receive sockets sharing the port, a thread each (Linux, default 1)\n"
+        "  --metrics-port <port>        Metrics endpoint, single room only (default 0 = off)\n"
+        "  --network-thread             Dedicated network I/O thread\n"
+        "  --batched-socket             recvmmsg/sendmmsg (Linux) or Registered I/O (Windows)\n"
+        "  --shared-memory              Serve bots on this machine through shared memory instead of a socket\n"
+        "  --snapshot-pipeline          Encode and send snapshots on a thread overlapping the next tick\n"
+        "  --send-pacing                Spread each tick's datagrams over the tick instead of one burst\n"
+        "  --event-bullets              Replicate bullets as spawn events\n"
+        "  --client-bandwidth <B/s>     Replication budget per client (default 0 = unlimited)\n"
+        "  --replication-rates <spec>   Hz: near-players,far-players,near-enemies,far-enemies[,bullets[,near-px]]\n"
+        "  --dead-reckoning [spec]      Send motion only past position,rotation[,max-age-ms] error\n"
+        "  --compress-above <bytes>     Compress messages this large, e.g. 256 (default 0 = off)\n"
+        "  --parallel-ai                Enemy AI on the job system\n"
+        "  --ai-budget-us <us>          Enemy AI time budget per tick (default 0 = unlimited)\n"
+        "  --overload-control <on|off>  Shed AI, far replication and spawns while ticks overrun (default on)\n"
+        "  --enemy-squads               Nearby enemies share targets, waypoints and retreat spots\n"
+        "  --chunk-active-radius <n>    Chunks around a player where enemies think; others sleep (default " <<
+        WorldChunks::DEFAULT_ACTIVE_RADIUS << ")\n"
+        "  --spectator-delay <ms>       Delay of the spectator stream, up to " << SpectatorStream::MAX_DELAY_MS << " (default " << SpectatorStream::DEFAULT_DELAY_MS << ")\n"
+        "  --max-spectators <n>         Direct spectators per room; more through --spectator-relay (default " << SpectatorStream::MAX_SPECTATORS << ", 0 = off)\n"
+        "  --horde <enemies>            Stress scenario: hold this many enemies whatever the player count, up to " << GameServer::MAX_HORDE_SIZE << "\n"
+        "  --lan-multicast [group[:port]] Send shared state once to a multicast group, single room only (default " <<
+        sf::IpAddress(LanMulticast::DEFAULT_GROUP).toString() << ":" << LanMulticast::DEFAULT_PORT << ")\n"
+        "  --network-conditions <spec>  latency,jitter,loss[,duplicate[,reorder]]\n"
+        "  --map <file>                 Walls and crates, e.g. Assets/maps/crossroads.map (default: open arena)\n"
+        "  --record <file>              Record the match for replay\n"
+        "  --capture <file>             Capture every datagram for --analyze-capture (rotates at 64 MiB, keeps 4)\n"
+        "  --journal <file>             Journal kills, deaths, scores and spawns as binary records (rotates at 16 MiB, keeps 8)\n"
+        "  --checkpoint <file>          Checkpoint the match every " << GameServer::DEFAULT_CHECKPOINT_INTERVAL << " s; a server started on a leftover one resumes it\n"
+        "  --handoff <path>             Take the match over from the server listening at path, then listen there for the next one\n"
+        "  --ready-file <file>          Created with the port once the socket is bound\n"
+        "  --directory <host[:port]>    Report load to a directory service (default port " << Directory::DEFAULT_PORT << ")\n"
+        "  --advertise-address <host>   Address the directory sends players to (default: as seen by it)\n"
+        "  --trace <file.json>          Record a Chrome trace of ticks, datagrams and snapshots, written on shutdown\n"
+        "  --trace-slow-tick-ms <ms>    With --trace, also write <file>-tick<N>.json after a tick this long\n"
+        "  --simulation-cores <list>    Pin the tick thread (room workers in turn) to these cores, e.g. 2,3\n"
+        "  --io-cores <list>            Pin network I/O threads (router, shards) to these cores\n"
+        "  --high-priority              Raise simulation and I/O thread priority (Windows: precise tick timer)\n"
+        "Prints \"READY <port>\" on stdout once bound; SIGINT/SIGTERM stop the server.\n"
+        "Run the directory service itself with: --directory-service [port]\n"
+        "Relay a room to more spectators with: --spectator-relay <host[:port]> [listen port (default " <<
+        SpectatorRelay::DEFAULT_PORT << ")] [room]\n";
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "network_conditioner.h"
+#include "network_validation.h"
+#include "replication_budget.h"
+#include "lan_multicast.h"
+#include "spectator_stream.h"
+#include "thread_tuning.h"
+#include "world_chunks.h"
+#include "tick_scheduler.h"
+#include <cstdint>
+#include <string>
+
+// Server startup settings for unattended runs, filled from the command line
+// and/or a config file instead of the interactive prompts:
+//
+//   TankGame --server [--config server.cfg] [--port 53000] [--tick-rate 60] ...
+//
+// The config file holds one "key = value" per line ('#' starts a comment, a
+// bare key switches a flag on); options given on the command line override it
+// regardless of order. Keys are the long option names without the dashes.
+struct ServerOptions {
+    unsigned short port = 53000;
+    unsigned int tickRate = TickScheduler::DEFAULT_TICK_RATE;
+    uint32_t maxPlayers = NetworkValidation::MAX_PLAYER_COUNT;   // Per room
+    uint16_t roomCount = 1;
+    uint32_t ingressShards = 1;             // Multi-room receive sockets sharing the port
+    unsigned short metricsPort = 0;         // 0 = off
+    bool networkThread = false;
+    bool batchedSocket = false;
+    bool sharedMemory = false;              // Bots on this machine only, no socket
+    bool snapshotPipeline = false;
+    bool sendPacing = false;
+    bool eventBullets = false;
+    uint32_t clientBandwidth = 0;           // Bytes/s per client, 0 = unlimited
+    ReplicationRates replicationRates;
+    DeadReckoningSettings deadReckoning;
+    uint32_t compressionThreshold = 0;      // Bytes, 0 = off
+    bool parallelEnemyAI = false;
+    uint32_t enemyAIBudgetUs = 0;           // 0 = unlimited
+    bool overloadControl = true;
+    bool enemySquads = false;
+    int chunkActiveRadius = WorldChunks::DEFAULT_ACTIVE_RADIUS;    // Chunks around a player where enemies think
+    uint32_t spectatorDelayMs = SpectatorStream::DEFAULT_DELAY_MS;
+    uint32_t maxSpectators = SpectatorStream::MAX_SPECTATORS;   // Direct subscribers per room, 0 = no spectating
+    uint32_t hordeSize = 0;                 // Horde stress scenario: enemies held in the arena (0 = off)
+    uint32_t lanMulticastGroup = 0;         // sf::IpAddress::toInteger()
+    unsigned short lanMulticastPort = 0;    // 0 = LAN multicast off
+    NetworkConditions networkConditions;
+    std::string mapPath;                    // Obstacle map (empty = open arena)
+    std::string recordingPath;              // Empty = no recording
+    std::string capturePath;                // Datagram capture file (empty = none)
+    std::string journalPath;                // Gameplay event journal for analytics (empty = none)
+    std::string checkpointPath;             // Crash recovery checkpoint, restored at startup if present (empty = none)
+    std::string handoffPath;                // Unix socket to take the match over from, then hand it on at (empty = none)
+    std::string readyFile;                  // Written once the socket is bound (empty = none)
+    std::string directory;                  // "host[:port]" of a directory service to report to (empty = none)
+    std::string advertiseAddress;           // Address the directory hands out (empty = the one reports come from)
+    std::string tracePath;                  // Chrome trace written on shutdown (empty = tracing off)
+    uint32_t slowTickTraceMs = 0;           // Also dump the trace after a tick this long (0 = never)
+    ThreadTuning threadTuning;              // Core pinning and priority of simulation and I/O threads
+
+    // Applies one setting, e.g. ("tick-rate", "128")
+    // @return False, leaving the options untouched, for an unknown key or invalid value
+    bool Set(const std::string& key, const std::string& value);
+
+    // @return False if the file cannot be read or any line is invalid
+    bool LoadFile(const std::string& path);
+
+    // @return True if argv asks for an unattended server ("--server")
+    static bool IsServerCommandLine(int argc, char* argv[]);
+
+    // Parses everything after "--server". Prints the offending argument and
+    // returns false on errors, so the process can exit before binding anything.
+    static bool ParseCommandLine(int argc, char* argv[], ServerOptions& options);
+
+    static void PrintUsage();
+};
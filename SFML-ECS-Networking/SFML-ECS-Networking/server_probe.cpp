@@ -0,0 +1,173 @@
+#include "server_probe.h"
+#include "connection_token.h"
+#include "network_messages.h"
+#include "utils.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <optional>
+
+namespace {
+    struct CachedPick {
+        sf::IpAddress directory = sf::IpAddress::LocalHost;
+        unsigned short directoryPort = 0;
+        Directory::Assignment server;
+    };
+
+    // The process's pick per directory; a client only ever talks to one or two
+    std::vector<CachedPick> cachedPicks;
+
+    struct ProbeState {
+        std::array<int64_t, ServerProbe::SAMPLES> sentMicros{};
+        std::array<float, ServerProbe::SAMPLES> rttMs{};
+        int sent = 0;
+        int received = 0;
+    };
+}
+
+/**
+ * Challenges carry no request number, so the k-th challenge from a server is
+ * timed against the k-th request to it. A lost request makes the later
+ * samples look slower, never faster, and the median shrugs off one of them.
+ */
+void ServerProbe::Probe(const std::vector<Directory::Assignment>& candidates, std::vector<Result>& out) {
+    out.assign(candidates.size(), Result{});
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        out[i].server = candidates[i];
+    }
+    sf::UdpSocket socket;
+    if (candidates.empty() || socket.bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+        return;
+    }
+    socket.setBlocking(false);
+    sf::SocketSelector selector;
+    selector.add(socket);
+
+    sf::Packet request;
+    ConnectionTokens::WriteRequest(request);
+    sf::Packet reply;
+    std::vector<ProbeState> states(candidates.size());
+    const int64_t startMicros = GetSteadyMicros();
+    const int64_t deadlineMicros = startMicros + BUDGET_MS * 1000;
+    int round = 0;
+    int64_t nextRoundMicros = startMicros;
+    size_t outstanding = candidates.size() * SAMPLES;
+
+    while (outstanding > 0) {
+        int64_t now = GetSteadyMicros();
+        if (now >= deadlineMicros) {
+            break;
+        }
+        if (round < SAMPLES && now >= nextRoundMicros) {
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                const int64_t sendMicros = GetSteadyMicros();
+                if (socket.send(request, candidates[i].address, candidates[i].port) == sf::Socket::Status::Done) {
+                    states[i].sentMicros[states[i].sent++] = sendMicros;
+                }
+                else {
+                    outstanding--;
+                }
+            }
+            round++;
+            nextRoundMicros += SAMPLE_SPACING_MS * 1000;
+            now = GetSteadyMicros();
+        }
+        const int64_t wakeMicros = round < SAMPLES ? std::min(nextRoundMicros, deadlineMicros) : deadlineMicros;
+        if (wakeMicros <= now || !selector.wait(sf::microseconds(wakeMicros - now))) {
+            continue;
+        }
+        while (true) {
+            std::optional<sf::IpAddress> sender;
+            unsigned short senderPort = 0;
+            reply.clear();
+            if (socket.receive(reply, sender, senderPort) != sf::Socket::Status::Done) {
+                break;
+            }
+            const int64_t arrival = GetSteadyMicros();
+            uint8_t type = 0;
+            if (!sender || !(reply >> type) || type != static_cast<uint8_t>(NetMessageType::CONNECTION_CHALLENGE)) {
+                continue;
+            }
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                ProbeState& state = states[i];
+                if (candidates[i].address == sender.value() && candidates[i].port == senderPort && state.received < state.sent) {
+                    state.rttMs[state.received] = static_cast<float>(arrival - state.sentMicros[state.received]) / 1000.0f;
+                    state.received++;
+                    outstanding--;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        ProbeState& state = states[i];
+        out[i].samples = state.received;
+        if (state.received > 0) {
+            std::sort(state.rttMs.begin(), state.rttMs.begin() + state.received);
+            out[i].medianMs = state.rttMs[state.received / 2];
+        }
+    }
+}
+
+size_t ServerProbe::PickBest(const std::vector<Result>& results) {
+    size_t fastest = results.size();
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].samples > 0 && (fastest == results.size() || results[i].medianMs < results[fastest].medianMs)) {
+            fastest = i;
+        }
+    }
+    if (fastest == results.size()) {
+        return fastest;
+    }
+    // Results keep the directory's order: the first close enough is the least loaded
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].samples > 0 && results[i].medianMs <= results[fastest].medianMs + TIE_MS) {
+            return i;
+        }
+    }
+    return fastest;
+}
+
+bool ServerProbe::FindNearestServer(const sf::IpAddress& directory, unsigned short directoryPort, Directory::Assignment& out) {
+    for (const CachedPick& pick : cachedPicks) {
+        if (pick.directory == directory && pick.directoryPort == directoryPort) {
+            out = pick.server;
+            Utils::printMsg("Using this session's closest server " + out.address.toString() + ":" + std::to_string(out.port));
+            return true;
+        }
+    }
+
+    std::vector<Directory::Assignment> candidates;
+    if (!Directory::FindCandidates(directory, directoryPort, candidates)) {
+        return Directory::FindServer(directory, directoryPort, out);
+    }
+    if (candidates.size() == 1) {
+        out = candidates.front();
+        cachedPicks.push_back(CachedPick{ directory, directoryPort, out });
+        return true;
+    }
+    std::vector<Result> results;
+    Probe(candidates, results);
+    const size_t best = PickBest(results);
+    if (best == results.size()) {
+        Utils::printMsg("No candidate server answered the latency probe, using the directory's placement", warning);
+        return Directory::FindServer(directory, directoryPort, out);
+    }
+    Utils::printMsg("Latency to the " + std::to_string(results.size()) + " candidate servers:");
+    for (const Result& result : results) {
+        char line[96];
+        if (result.samples > 0) {
+            std::snprintf(line, sizeof(line), "  %s:%u - %.1f ms median of %d", result.server.address.toString().c_str(),
+                static_cast<unsigned>(result.server.port), static_cast<double>(result.medianMs), result.samples);
+        }
+        else {
+            std::snprintf(line, sizeof(line), "  %s:%u - no answer", result.server.address.toString().c_str(),
+                static_cast<unsigned>(result.server.port));
+        }
+        Utils::printMsg(line);
+    }
+    out = results[best].server;
+    cachedPicks.push_back(CachedPick{ directory, directoryPort, out });
+    return true;
+}
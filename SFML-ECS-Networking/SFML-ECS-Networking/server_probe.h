@@ -0,0 +1,45 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "directory_service.h"
+
+// Latency-aware server selection on top of the directory. The directory
+// lists the servers with a free room (Directory::FindCandidates); the client
+// then probes all of them at once from one socket with SAMPLES connection
+// requests each, SAMPLE_SPACING_MS apart, and takes the median round trip of
+// the challenges that come back within BUDGET_MS. A connection request is
+// what every client sends first anyway: servers answer it without keeping
+// state, so probing needs nothing new on their side.
+//
+// Servers within TIE_MS of the fastest count as equally close, and among
+// those the directory's order (load) decides. The pick is kept for the rest
+// of the process, so choosing again (a second connect through the same
+// directory) skips the probe; reconnects and session resumes already go back
+// to the server the client was on.
+namespace ServerProbe {
+    constexpr int SAMPLES = 3;
+    constexpr int64_t SAMPLE_SPACING_MS = 50;
+    constexpr int64_t BUDGET_MS = 300;
+    constexpr float TIE_MS = 10.0f;
+
+    struct Result {
+        Directory::Assignment server;
+        int samples = 0;                // Challenges received, 0 = no answer
+        float medianMs = 0.0f;
+    };
+
+    // Probes every candidate in parallel; blocks for at most BUDGET_MS.
+    // @param out One result per candidate, in candidate order
+    void Probe(const std::vector<Directory::Assignment>& candidates, std::vector<Result>& out);
+
+    // @return Index of the result to join, or results.size() if none answered
+    size_t PickBest(const std::vector<Result>& results);
+
+    // Candidates, probe and pick, or the cached pick for this directory.
+    // Falls back to the directory's own placement (Directory::FindServer)
+    // when it cannot list candidates or none of them answers.
+    // @return False if the directory did not answer or had no free room
+    bool FindNearestServer(const sf::IpAddress& directory, unsigned short directoryPort, Directory::Assignment& out);
+}
@@ -0,0 +1,263 @@
+#include "shared_memory_transport.h"
+#include "utils.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace SharedMemoryTransport;
+
+std::string SharedMemoryTransport::NameForPort(unsigned short port) {
+    return "tankgame-" + std::to_string(port);
+}
+
+namespace {
+    std::string PlatformName(const std::string& name) {
+#ifdef _WIN32
+        return "Local\\" + name;
+#else
+        return "/" + name;
+#endif
+    }
+}
+
+/**
+ * Creates a zero-filled region under name. A region a crashed server left
+ * behind is replaced (POSIX); on Windows the name is only taken while a
+ * process still has it mapped, so an existing one means another server.
+ */
+bool Mapping::Create(const std::string& name, size_t bytes) {
+    Close();
+    const std::string platformName = PlatformName(name);
+#ifdef _WIN32
+    const unsigned long long requested = bytes;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(requested >> 32), static_cast<DWORD>(requested & 0xFFFFFFFFull), platformName.c_str());
+    if (!mapping) {
+        Utils::printMsg("Failed to create shared memory " + name + " (error " + std::to_string(GetLastError()) + ")", error);
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        Utils::printMsg("Shared memory " + name + " is already in use by another server", error);
+        CloseHandle(mapping);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!view) {
+        Utils::printMsg("Failed to map shared memory " + name + " (error " + std::to_string(GetLastError()) + ")", error);
+        CloseHandle(mapping);
+        return false;
+    }
+    handle = mapping;
+#else
+    int descriptor = shm_open(platformName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (descriptor < 0 && errno == EEXIST) {
+        Utils::printMsg("Replacing stale shared memory " + name, warning);
+        shm_unlink(platformName.c_str());
+        descriptor = shm_open(platformName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (descriptor < 0) {
+        Utils::printMsg("Failed to create shared memory " + name + ": " + std::string(std::strerror(errno)), error);
+        return false;
+    }
+    if (ftruncate(descriptor, static_cast<off_t>(bytes)) != 0) {
+        Utils::printMsg("Failed to size shared memory " + name + ": " + std::string(std::strerror(errno)), error);
+        close(descriptor);
+        shm_unlink(platformName.c_str());
+        return false;
+    }
+    void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (view == MAP_FAILED) {
+        Utils::printMsg("Failed to map shared memory " + name + ": " + std::string(std::strerror(errno)), error);
+        shm_unlink(platformName.c_str());
+        return false;
+    }
+    ownedName = platformName;
+#endif
+    data = view;
+    size = bytes;
+    return true;
+}
+
+bool Mapping::Open(const std::string& name, size_t bytes) {
+    Close();
+    const std::string platformName = PlatformName(name);
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, platformName.c_str());
+    if (!mapping) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+    handle = mapping;
+#else
+    const int descriptor = shm_open(platformName.c_str(), O_RDWR, 0600);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || static_cast<size_t>(info.st_size) < bytes) {
+        close(descriptor);
+        return false;
+    }
+    void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+#endif
+    data = view;
+    size = bytes;
+    return true;
+}
+
+void Mapping::Close() {
+    if (!data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(handle);
+    handle = nullptr;
+#else
+    munmap(data, size);
+    if (!ownedName.empty()) {
+        shm_unlink(ownedName.c_str());
+    }
+#endif
+    ownedName.clear();
+    data = nullptr;
+    size = 0;
+}
+
+/**
+ * The new region is zero-filled by the OS, which is every slot free with empty
+ * rings, so only the header is written; touching all of it up front would
+ * commit the whole region for a handful of bots.
+ */
+bool SharedMemoryServer::Create(const std::string& name) {
+    Close();
+    if (!mapping.Create(name, sizeof(Region))) {
+        return false;
+    }
+    region = static_cast<Region*>(mapping.GetData());
+    region->magic = MAGIC;
+    region->version = VERSION;
+    region->serverRunning.store(1, std::memory_order_release);
+    nextSlot = 0;
+    emptyRun = 0;
+    droppedCount = 0;
+    Utils::printMsg("Shared memory transport " + name + " ready for " + std::to_string(MAX_CLIENTS) + " clients (" +
+        std::to_string(sizeof(Region) / (1024 * 1024)) + " MB)", success);
+    return true;
+}
+
+void SharedMemoryServer::Close() {
+    if (!region) {
+        return;
+    }
+    region->serverRunning.store(0, std::memory_order_release);
+    region = nullptr;
+    mapping.Close();
+}
+
+bool SharedMemoryServer::Receive(sf::Packet& packet, sf::IpAddress& address, unsigned short& port) {
+    if (!region) {
+        return false;
+    }
+    while (emptyRun < MAX_CLIENTS) {
+        const size_t index = nextSlot;
+        nextSlot = (nextSlot + 1) % MAX_CLIENTS;
+        ClientSlot& slot = region->clients[index];
+        if (slot.claimed.load(std::memory_order_acquire) != 0 && slot.toServer.TryPop(packet)) {
+            emptyRun = 0;
+            address = sf::IpAddress::LocalHost;
+            port = static_cast<unsigned short>(FIRST_CLIENT_PORT + index);
+            return true;
+        }
+        ++emptyRun;
+    }
+    emptyRun = 0;
+    return false;
+}
+
+bool SharedMemoryServer::Send(const sf::Packet& packet, sf::IpAddress address, unsigned short port) {
+    if (!region || address != sf::IpAddress::LocalHost || port < FIRST_CLIENT_PORT ||
+        port >= FIRST_CLIENT_PORT + MAX_CLIENTS) {
+        ++droppedCount;
+        return false;
+    }
+    ClientSlot& slot = region->clients[port - FIRST_CLIENT_PORT];
+    if (slot.claimed.load(std::memory_order_acquire) == 0 || !slot.toClient.TryPush(packet)) {
+        ++droppedCount;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Claims the first free slot. Whatever the previous owner left unread in the
+ * server-to-client ring is skipped; its unread client-to-server datagrams
+ * still reach the server, as late datagrams from a reused port would.
+ */
+bool SharedMemoryClient::Open(const std::string& name) {
+    Close();
+    if (!mapping.Open(name, sizeof(Region))) {
+        Utils::printMsg("No server found on shared memory " + name, error);
+        return false;
+    }
+    Region* candidate = static_cast<Region*>(mapping.GetData());
+    if (candidate->magic != MAGIC || candidate->version != VERSION ||
+        candidate->serverRunning.load(std::memory_order_acquire) == 0) {
+        Utils::printMsg("Shared memory " + name + " has no running server of this version", error);
+        mapping.Close();
+        return false;
+    }
+    for (size_t index = 0; index < MAX_CLIENTS; ++index) {
+        uint32_t expected = 0;
+        if (candidate->clients[index].claimed.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+            region = candidate;
+            slot = &candidate->clients[index];
+            slot->toClient.Skip();
+            port = static_cast<unsigned short>(FIRST_CLIENT_PORT + index);
+            return true;
+        }
+    }
+    Utils::printMsg("Every slot of shared memory " + name + " is taken", error);
+    mapping.Close();
+    return false;
+}
+
+void SharedMemoryClient::Close() {
+    if (slot) {
+        slot->claimed.store(0, std::memory_order_release);
+    }
+    slot = nullptr;
+    region = nullptr;
+    port = 0;
+    mapping.Close();
+}
+
+bool SharedMemoryClient::Receive(sf::Packet& packet) {
+    return slot && slot->toClient.TryPop(packet);
+}
+
+bool SharedMemoryClient::Send(const sf::Packet& packet) {
+    return slot && slot->toServer.TryPush(packet);
+}
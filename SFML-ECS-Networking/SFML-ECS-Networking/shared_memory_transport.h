@@ -0,0 +1,160 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Datagram transport through a named shared memory region, so bots on the
+// server's host reach it without the kernel network stack (server scaling
+// tests then measure the simulation). The server creates the region; each
+// client process maps it and claims one of MAX_CLIENTS slots, which holds a
+// single-producer/single-consumer ring per direction. Nothing blocks and
+// nothing is signalled: the server polls the claimed slots once per tick and
+// a client polls its own ring once per update, as they would a socket.
+// A client appears to the server as LocalHost, port FIRST_CLIENT_PORT + slot.
+// A client that exits without Close leaves its slot claimed until the
+// server restarts.
+namespace SharedMemoryTransport {
+    constexpr uint32_t MAGIC = 0x54475348;                  // "TGSH"
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t MAX_CLIENTS = 1024;
+    constexpr size_t RING_SLOTS = 32;                       // Per direction, power of two
+    constexpr size_t TO_SERVER_BYTES = 512;                 // Largest client datagram
+    constexpr size_t TO_CLIENT_BYTES = 1536;                // PacketAggregator::MAX_DATAGRAM_BYTES with room to spare
+    constexpr unsigned short SERVER_PORT = 53000;           // What clients see as the sender
+    constexpr unsigned short FIRST_CLIENT_PORT = 1024;
+    static_assert((RING_SLOTS & (RING_SLOTS - 1)) == 0, "RING_SLOTS must be a power of two");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory needs address-free atomics");
+
+    // Region name for a server port, so bots find the server they were pointed at
+    std::string NameForPort(unsigned short port);
+
+    // One direction of one slot. Indices only grow (mod 2^32), so a ring is
+    // empty when head == tail and full when tail - head == RING_SLOTS.
+    template <size_t SlotBytes>
+    struct Ring {
+        alignas(64) std::atomic<uint32_t> head;    // Consumer
+        alignas(64) std::atomic<uint32_t> tail;    // Producer
+        struct Slot {
+            uint32_t size;
+            uint8_t bytes[SlotBytes];
+        };
+        Slot slots[RING_SLOTS];
+
+        // @return False if the ring is full or the datagram does not fit a slot
+        bool TryPush(const sf::Packet& packet) {
+            const size_t size = packet.getDataSize();
+            const uint32_t currentTail = tail.load(std::memory_order_relaxed);
+            if (size > SlotBytes || currentTail - head.load(std::memory_order_acquire) >= RING_SLOTS) {
+                return false;
+            }
+            Slot& slot = slots[currentTail & (RING_SLOTS - 1)];
+            slot.size = static_cast<uint32_t>(size);
+            if (size > 0) {
+                std::memcpy(slot.bytes, packet.getData(), size);
+            }
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Replaces out's contents with the oldest datagram. @return False if empty
+        bool TryPop(sf::Packet& out) {
+            const uint32_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            const Slot& slot = slots[currentHead & (RING_SLOTS - 1)];
+            out.clear();
+            out.append(slot.bytes, std::min<size_t>(slot.size, SlotBytes));
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only: drops whatever a previous owner left
+        void Skip() { head.store(tail.load(std::memory_order_acquire), std::memory_order_release); }
+    };
+
+    struct ClientSlot {
+        alignas(64) std::atomic<uint32_t> claimed;      // 0 free, 1 owned by a client
+        Ring<TO_SERVER_BYTES> toServer;
+        Ring<TO_CLIENT_BYTES> toClient;
+    };
+
+    struct Region {
+        uint32_t magic;
+        uint32_t version;
+        std::atomic<uint32_t> serverRunning;
+        ClientSlot clients[MAX_CLIENTS];
+    };
+
+    // Platform mapping of a named region (Windows file mapping or POSIX shm)
+    class Mapping {
+    public:
+        Mapping() = default;
+        ~Mapping() { Close(); }
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        bool Create(const std::string& name, size_t bytes);    // Owner; removed again on Close
+        bool Open(const std::string& name, size_t bytes);
+        void Close();
+        void* GetData() const { return data; }
+
+    private:
+        void* data = nullptr;
+        size_t size = 0;
+        std::string ownedName;      // POSIX: unlinked on Close
+#ifdef _WIN32
+        void* handle = nullptr;
+#endif
+    };
+}
+
+// Server end: owns the region and reads every claimed slot
+class SharedMemoryServer {
+public:
+    ~SharedMemoryServer() { Close(); }
+
+    bool Create(const std::string& name);
+    void Close();
+    bool IsOpen() const { return region != nullptr; }
+
+    // Next datagram from any client, round-robin across slots so one busy
+    // client cannot starve the rest. @return False once every ring is empty
+    bool Receive(sf::Packet& packet, sf::IpAddress& address, unsigned short& port);
+    // @return False for an address that is not a slot, a full ring or an oversized datagram
+    bool Send(const sf::Packet& packet, sf::IpAddress address, unsigned short port);
+
+    uint64_t GetDroppedCount() const { return droppedCount; }
+
+private:
+    SharedMemoryTransport::Mapping mapping;
+    SharedMemoryTransport::Region* region = nullptr;
+    size_t nextSlot = 0;            // Where the next Receive starts looking
+    size_t emptyRun = 0;            // Slots found empty since the last datagram
+    uint64_t droppedCount = 0;
+};
+
+// Client end: one slot of a region a server created
+class SharedMemoryClient {
+public:
+    ~SharedMemoryClient() { Close(); }
+
+    // @return False if no server runs under name or every slot is taken
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const { return slot != nullptr; }
+    unsigned short GetPort() const { return port; }
+
+    bool Receive(sf::Packet& packet);
+    bool Send(const sf::Packet& packet);
+
+private:
+    SharedMemoryTransport::Mapping mapping;
+    SharedMemoryTransport::Region* region = nullptr;
+    SharedMemoryTransport::ClientSlot* slot = nullptr;
+    unsigned short port = 0;
+};
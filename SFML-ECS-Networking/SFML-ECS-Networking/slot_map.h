@@ -0,0 +1,145 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Dense container addressed by stable 32-bit generational handles.
+// Values live contiguously (iteration is a plain vector walk); removing one
+// moves the last value into its place. A handle is slot index (low INDEX_BITS)
+// plus the slot's generation, which is bumped on every removal, so handles to
+// removed values stop resolving instead of aliasing whatever reuses the slot.
+// Generations skip 0, so INVALID_HANDLE (0) never names a live value.
+// Insert and Remove are O(1) and do not allocate once Reserve has been called
+// (or the map has grown to its peak size).
+template <typename T>
+class SlotMap {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = 0;
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t MAX_SLOTS = 1u << INDEX_BITS;
+
+    void Reserve(size_t capacity) {
+        values.reserve(capacity);
+        denseToSlot.reserve(capacity);
+        slots.reserve(capacity);
+    }
+
+    // @return INVALID_HANDLE if all MAX_SLOTS slots are in use
+    Handle Insert(T value) {
+        uint32_t slotIndex;
+        if (freeHead != NO_SLOT) {
+            slotIndex = freeHead;
+            freeHead = slots[slotIndex].denseIndex;
+        }
+        else {
+            if (slots.size() >= MAX_SLOTS) {
+                return INVALID_HANDLE;
+            }
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{ 0, 1 });
+        }
+
+        Slot& slot = slots[slotIndex];
+        slot.denseIndex = static_cast<uint32_t>(values.size());
+        values.push_back(std::move(value));
+        denseToSlot.push_back(slotIndex);
+        return MakeHandle(slotIndex, slot.generation);
+    }
+
+    // @return False if the handle no longer resolves
+    bool Remove(Handle handle) {
+        const uint32_t slotIndex = handle & INDEX_MASK;
+        if (!Contains(handle)) {
+            return false;
+        }
+        RemoveDense(slots[slotIndex].denseIndex);
+        return true;
+    }
+
+    // Removes every value for which pred(T&) is true, in one pass
+    template <typename Pred>
+    size_t RemoveIf(Pred&& pred) {
+        size_t removed = 0;
+        for (size_t i = values.size(); i-- > 0;) {
+            if (pred(values[i])) {
+                RemoveDense(static_cast<uint32_t>(i));
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+    bool Contains(Handle handle) const {
+        const uint32_t slotIndex = handle & INDEX_MASK;
+        return handle != INVALID_HANDLE && slotIndex < slots.size() &&
+            slots[slotIndex].generation == (handle >> INDEX_BITS) &&
+            slots[slotIndex].denseIndex < values.size() && denseToSlot[slots[slotIndex].denseIndex] == slotIndex;
+    }
+
+    // @return Null if the handle no longer resolves
+    T* Get(Handle handle) { return Contains(handle) ? &values[slots[handle & INDEX_MASK].denseIndex] : nullptr; }
+    const T* Get(Handle handle) const {
+        return Contains(handle) ? &values[slots[handle & INDEX_MASK].denseIndex] : nullptr;
+    }
+
+    // Handle of the value at a dense position (0 .. Size() - 1)
+    Handle GetHandleAt(size_t denseIndex) const {
+        const uint32_t slotIndex = denseToSlot[denseIndex];
+        return MakeHandle(slotIndex, slots[slotIndex].generation);
+    }
+
+    // Removes everything; every outstanding handle stops resolving
+    void Clear() {
+        for (size_t i = values.size(); i-- > 0;) {
+            RemoveDense(static_cast<uint32_t>(i));
+        }
+    }
+
+    size_t Size() const { return values.size(); }
+    bool Empty() const { return values.empty(); }
+
+    // Dense iteration (order changes when values are removed)
+    typename std::vector<T>::iterator begin() { return values.begin(); }
+    typename std::vector<T>::iterator end() { return values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+private:
+    static constexpr uint32_t INDEX_MASK = MAX_SLOTS - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+    static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+    struct Slot {
+        uint32_t denseIndex;    // Position in values; next free slot while free
+        uint32_t generation;    // 1 .. GENERATION_MASK
+    };
+
+    std::vector<T> values;
+    std::vector<uint32_t> denseToSlot;
+    std::vector<Slot> slots;
+    uint32_t freeHead = NO_SLOT;
+
+    static Handle MakeHandle(uint32_t slotIndex, uint32_t generation) {
+        return (generation << INDEX_BITS) | slotIndex;
+    }
+
+    // Moves the last value into denseIndex and frees the removed value's slot
+    void RemoveDense(uint32_t denseIndex) {
+        const uint32_t slotIndex = denseToSlot[denseIndex];
+        const uint32_t last = static_cast<uint32_t>(values.size() - 1);
+        if (denseIndex != last) {
+            values[denseIndex] = std::move(values[last]);
+            denseToSlot[denseIndex] = denseToSlot[last];
+            slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+
+        Slot& slot = slots[slotIndex];
+        slot.generation = slot.generation == GENERATION_MASK ? 1 : slot.generation + 1;
+        slot.denseIndex = freeHead;
+        freeHead = slotIndex;
+    }
+};
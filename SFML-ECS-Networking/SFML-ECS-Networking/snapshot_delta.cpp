@@ -0,0 +1,419 @@
+#include "snapshot_delta.h"
+#include <algorithm>
+
+void WorldSnapshot::SortById() {
+    std::sort(players.begin(), players.end(),
+        [](const PlayerData& a, const PlayerData& b) { return a.playerId < b.playerId; });
+    std::sort(enemies.begin(), enemies.end(),
+        [](const EnemyData& a, const EnemyData& b) { return a.enemyId < b.enemyId; });
+}
+
+namespace {
+    // Copies into a slot that keeps its buffer: grows geometrically instead of
+    // to the exact size, so a world that gains one entity at a time does not
+    // reallocate every slot for each one
+    template <typename T>
+    void CopyKeepingCapacity(std::vector<T>& to, const std::vector<T>& from) {
+        if (to.capacity() < from.size()) {
+            to.reserve(std::max(from.size(), to.capacity() * 2));
+        }
+        to.assign(from.begin(), from.end());
+    }
+}
+
+void SnapshotHistory::Store(const WorldSnapshot& snapshot) {
+    WorldSnapshot& slot = slots[snapshot.sequence % HISTORY_SIZE];
+    if (&slot == &snapshot) {
+        return;
+    }
+    slot.sequence = snapshot.sequence;
+    slot.contentKey = snapshot.contentKey;
+    CopyKeepingCapacity(slot.players, snapshot.players);
+    CopyKeepingCapacity(slot.enemies, snapshot.enemies);
+}
+
+const WorldSnapshot* SnapshotHistory::Find(uint32_t sequence) const {
+    if (sequence == 0) {
+        return nullptr;
+    }
+    const WorldSnapshot& slot = slots[sequence % HISTORY_SIZE];
+    return slot.sequence == sequence ? &slot : nullptr;
+}
+
+void SnapshotHistory::Clear() {
+    for (auto& slot : slots) {
+        slot = WorldSnapshot();
+    }
+}
+
+size_t SnapshotHistory::GetApproximateBytes() const {
+    size_t bytes = sizeof(*this);
+    for (const WorldSnapshot& slot : slots) {
+        bytes += slot.players.capacity() * sizeof(PlayerData) + slot.enemies.capacity() * sizeof(EnemyData);
+    }
+    return bytes;
+}
+
+namespace SnapshotDelta {
+    namespace {
+        struct ChangedEntry {
+            size_t index;       // Index into current snapshot
+            uint16_t mask;
+        };
+
+        void WritePlayerFields(BitWriter& writer, const PlayerData& player, uint16_t mask) {
+            writer.WriteBits(mask, PLAYER_MASK_BITS);
+            if (mask & PLAYER_POSITION) NetworkUtils::WritePosition(writer, player.x, player.y);
+            if (mask & PLAYER_BODY_ROTATION) NetworkUtils::WriteRotation(writer, player.bodyRotation);
+            if (mask & PLAYER_BARREL_ROTATION) NetworkUtils::WriteRotation(writer, player.barrelRotation);
+            if (mask & PLAYER_COLOR) writer.WriteEnum(player.color, WirePrecision::COLOR_BITS);
+            if (mask & PLAYER_MOVEMENT) {
+                writer.WriteBool(player.isMoving_forward);
+                writer.WriteBool(player.isMoving_backward);
+                writer.WriteBool(player.isMoving_left);
+                writer.WriteBool(player.isMoving_right);
+            }
+            if (mask & PLAYER_HEALTH) NetworkUtils::WriteHealth(writer, player.health);
+            if (mask & PLAYER_MAX_HEALTH) NetworkUtils::WriteHealth(writer, player.maxHealth);
+            if (mask & PLAYER_SCORE) writer.WriteVarInt(player.score);
+            if (mask & PLAYER_DEAD) writer.WriteBool(player.isDead);
+        }
+
+        bool ReadPlayerFields(BitReader& reader, PlayerData& player) {
+            const uint16_t mask = static_cast<uint16_t>(reader.ReadBits(PLAYER_MASK_BITS));
+            if (mask & PLAYER_POSITION) NetworkUtils::ReadPosition(reader, player.x, player.y);
+            if (mask & PLAYER_BODY_ROTATION) player.bodyRotation = NetworkUtils::ReadRotation(reader);
+            if (mask & PLAYER_BARREL_ROTATION) player.barrelRotation = NetworkUtils::ReadRotation(reader);
+            if (mask & PLAYER_COLOR) {
+                const uint8_t colorId = static_cast<uint8_t>(reader.ReadBits(WirePrecision::COLOR_BITS));
+                player.color = NetworkUtils::IsValidColorId(colorId)
+                    ? static_cast<PlayerColor>(colorId) : PlayerColor::GREEN;
+            }
+            if (mask & PLAYER_MOVEMENT) {
+                player.isMoving_forward = reader.ReadBool();
+                player.isMoving_backward = reader.ReadBool();
+                player.isMoving_left = reader.ReadBool();
+                player.isMoving_right = reader.ReadBool();
+            }
+            if (mask & PLAYER_HEALTH) player.health = NetworkUtils::ReadHealth(reader);
+            if (mask & PLAYER_MAX_HEALTH) player.maxHealth = NetworkUtils::ReadHealth(reader);
+            if (mask & PLAYER_SCORE) player.score = reader.ReadVarInt();
+            if (mask & PLAYER_DEAD) player.isDead = reader.ReadBool();
+            return reader.IsValid();
+        }
+
+        void WriteEnemyFields(BitWriter& writer, const EnemyData& enemy, uint8_t mask) {
+            writer.WriteBits(mask, ENEMY_MASK_BITS);
+            if (mask & ENEMY_TYPE) writer.WriteBits(enemy.enemyType, WirePrecision::ENEMY_TYPE_BITS);
+            if (mask & ENEMY_POSITION) NetworkUtils::WritePosition(writer, enemy.x, enemy.y);
+            if (mask & ENEMY_BODY_ROTATION) NetworkUtils::WriteRotation(writer, enemy.bodyRotation);
+            if (mask & ENEMY_BARREL_ROTATION) NetworkUtils::WriteRotation(writer, enemy.barrelRotation);
+            if (mask & ENEMY_HEALTH) NetworkUtils::WriteHealth(writer, enemy.health);
+            if (mask & ENEMY_MAX_HEALTH) NetworkUtils::WriteHealth(writer, enemy.maxHealth);
+        }
+
+        bool ReadEnemyFields(BitReader& reader, EnemyData& enemy) {
+            const uint8_t mask = static_cast<uint8_t>(reader.ReadBits(ENEMY_MASK_BITS));
+            if (mask & ENEMY_TYPE) enemy.enemyType = static_cast<uint8_t>(reader.ReadBits(WirePrecision::ENEMY_TYPE_BITS));
+            if (mask & ENEMY_POSITION) NetworkUtils::ReadPosition(reader, enemy.x, enemy.y);
+            if (mask & ENEMY_BODY_ROTATION) enemy.bodyRotation = NetworkUtils::ReadRotation(reader);
+            if (mask & ENEMY_BARREL_ROTATION) enemy.barrelRotation = NetworkUtils::ReadRotation(reader);
+            if (mask & ENEMY_HEALTH) enemy.health = NetworkUtils::ReadHealth(reader);
+            if (mask & ENEMY_MAX_HEALTH) enemy.maxHealth = NetworkUtils::ReadHealth(reader);
+            return reader.IsValid();
+        }
+
+        /**
+         * Writes one entity section: changed/new entries, then removed IDs.
+         * Both lists are sorted by ID, so one merge pass finds all three cases,
+         * and IDs can be sent as gaps from the previous entry. The lists are
+         * per-thread scratch (the snapshot pipeline encodes on its own thread).
+         */
+        template <typename Entity, typename Mask, typename GetId, typename Diff, typename WriteFields>
+        void WriteSection(BitWriter& writer, const std::vector<Entity>* baseline,
+            const std::vector<Entity>& current, Mask allFields,
+            GetId getId, Diff diff, WriteFields writeFields) {
+            static thread_local std::vector<ChangedEntry> changed;
+            static thread_local std::vector<uint32_t> removed;
+            changed.clear();
+            removed.clear();
+
+            size_t b = 0;
+            const size_t baselineCount = baseline ? baseline->size() : 0;
+            for (size_t c = 0; c < current.size(); ++c) {
+                const uint32_t id = getId(current[c]);
+                while (b < baselineCount && getId((*baseline)[b]) < id) {
+                    removed.push_back(getId((*baseline)[b]));
+                    ++b;
+                }
+                if (b < baselineCount && getId((*baseline)[b]) == id) {
+                    const Mask mask = diff((*baseline)[b], current[c]);
+                    if (mask != 0) {
+                        changed.push_back({ c, mask });
+                    }
+                    ++b;
+                }
+                else {
+                    changed.push_back({ c, allFields });  // New since baseline
+                }
+            }
+            for (; b < baselineCount; ++b) {
+                removed.push_back(getId((*baseline)[b]));
+            }
+
+            writer.WriteVarUint(static_cast<uint32_t>(changed.size()));
+            uint32_t previousId = 0;
+            for (const ChangedEntry& entry : changed) {
+                const uint32_t id = getId(current[entry.index]);
+                writer.WriteVarUint(id - previousId);
+                previousId = id;
+                writeFields(writer, current[entry.index], static_cast<Mask>(entry.mask));
+            }
+            writer.WriteVarUint(static_cast<uint32_t>(removed.size()));
+            previousId = 0;
+            for (uint32_t id : removed) {
+                writer.WriteVarUint(id - previousId);
+                previousId = id;
+            }
+        }
+
+        /**
+         * Applies one entity section to out (a copy of the baseline).
+         * Entities not mentioned keep their baseline values.
+         */
+        template <typename Entity, typename GetId, typename SetId, typename ReadFields>
+        bool ReadSection(BitReader& reader, std::vector<Entity>& out,
+            GetId getId, SetId setId, ReadFields readFields) {
+            auto byId = [&getId](const Entity& entity, uint32_t id) { return getId(entity) < id; };
+
+            const uint32_t changedCount = reader.ReadVarUint();
+            if (!reader.IsValid() || changedCount > MAX_SECTION_ENTRIES) {
+                return false;
+            }
+            uint32_t id = 0;
+            for (uint32_t i = 0; i < changedCount; ++i) {
+                id += reader.ReadVarUint();
+                if (!reader.IsValid()) {
+                    return false;
+                }
+                auto it = std::lower_bound(out.begin(), out.end(), id, byId);
+                if (it == out.end() || getId(*it) != id) {
+                    it = out.insert(it, Entity());
+                    setId(*it, id);
+                }
+                if (!readFields(reader, *it)) {
+                    return false;
+                }
+            }
+
+            const uint32_t removedCount = reader.ReadVarUint();
+            if (!reader.IsValid() || removedCount > MAX_SECTION_ENTRIES) {
+                return false;
+            }
+            id = 0;
+            for (uint32_t i = 0; i < removedCount; ++i) {
+                id += reader.ReadVarUint();
+                if (!reader.IsValid()) {
+                    return false;
+                }
+                auto it = std::lower_bound(out.begin(), out.end(), id, byId);
+                if (it != out.end() && getId(*it) == id) {
+                    out.erase(it);
+                }
+            }
+            return true;
+        }
+
+        uint32_t PlayerId(const PlayerData& player) { return player.playerId; }
+        uint32_t EnemyId(const EnemyData& enemy) { return enemy.enemyId; }
+
+        // Compared at wire precision so sub-quantum jitter doesn't produce deltas
+        bool PositionChanged(float ax, float ay, float bx, float by) {
+            return NetworkUtils::QuantizePositionX(ax) != NetworkUtils::QuantizePositionX(bx) ||
+                NetworkUtils::QuantizePositionY(ay) != NetworkUtils::QuantizePositionY(by);
+        }
+        bool RotationChanged(float a, float b) {
+            return NetworkUtils::QuantizeRotation(a) != NetworkUtils::QuantizeRotation(b);
+        }
+        bool HealthChanged(float a, float b) {
+            return NetworkUtils::QuantizeHealth(a) != NetworkUtils::QuantizeHealth(b);
+        }
+
+        // 32-bit FNV-1a, fed one field at a time
+        constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+        constexpr uint32_t FNV_PRIME = 16777619u;
+
+        void HashField(uint32_t& hash, uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                hash = (hash ^ ((value >> shift) & 0xFFu)) * FNV_PRIME;
+            }
+        }
+    }
+
+    /**
+     * Floats go in quantized, the way they are written: the server hashes its
+     * full-precision snapshot, the client the dequantized values it decoded,
+     * and both quantize to the same steps.
+     */
+    uint32_t Hash(const WorldSnapshot& snapshot) {
+        uint32_t hash = FNV_OFFSET_BASIS;
+        HashField(hash, static_cast<uint32_t>(snapshot.players.size()));
+        for (const PlayerData& player : snapshot.players) {
+            HashField(hash, player.playerId);
+            HashField(hash, NetworkUtils::QuantizePositionX(player.x));
+            HashField(hash, NetworkUtils::QuantizePositionY(player.y));
+            HashField(hash, NetworkUtils::QuantizeRotation(player.bodyRotation));
+            HashField(hash, NetworkUtils::QuantizeRotation(player.barrelRotation));
+            HashField(hash, static_cast<uint32_t>(player.color));
+            HashField(hash, static_cast<uint32_t>(player.isMoving_forward) | player.isMoving_backward << 1 |
+                player.isMoving_left << 2 | player.isMoving_right << 3 | player.isDead << 4);
+            HashField(hash, NetworkUtils::QuantizeHealth(player.health));
+            HashField(hash, NetworkUtils::QuantizeHealth(player.maxHealth));
+            HashField(hash, static_cast<uint32_t>(player.score));
+        }
+        HashField(hash, static_cast<uint32_t>(snapshot.enemies.size()));
+        for (const EnemyData& enemy : snapshot.enemies) {
+            HashField(hash, enemy.enemyId);
+            HashField(hash, enemy.enemyType);
+            HashField(hash, NetworkUtils::QuantizePositionX(enemy.x));
+            HashField(hash, NetworkUtils::QuantizePositionY(enemy.y));
+            HashField(hash, NetworkUtils::QuantizeRotation(enemy.bodyRotation));
+            HashField(hash, NetworkUtils::QuantizeRotation(enemy.barrelRotation));
+            HashField(hash, NetworkUtils::QuantizeHealth(enemy.health));
+            HashField(hash, NetworkUtils::QuantizeHealth(enemy.maxHealth));
+        }
+        return hash;
+    }
+
+    uint16_t DiffPlayer(const PlayerData& baseline, const PlayerData& current) {
+        uint16_t mask = 0;
+        if (PositionChanged(baseline.x, baseline.y, current.x, current.y)) mask |= PLAYER_POSITION;
+        if (RotationChanged(baseline.bodyRotation, current.bodyRotation)) mask |= PLAYER_BODY_ROTATION;
+        if (RotationChanged(baseline.barrelRotation, current.barrelRotation)) mask |= PLAYER_BARREL_ROTATION;
+        if (baseline.color != current.color) mask |= PLAYER_COLOR;
+        if (baseline.isMoving_forward != current.isMoving_forward ||
+            baseline.isMoving_backward != current.isMoving_backward ||
+            baseline.isMoving_left != current.isMoving_left ||
+            baseline.isMoving_right != current.isMoving_right) mask |= PLAYER_MOVEMENT;
+        if (HealthChanged(baseline.health, current.health)) mask |= PLAYER_HEALTH;
+        if (HealthChanged(baseline.maxHealth, current.maxHealth)) mask |= PLAYER_MAX_HEALTH;
+        if (baseline.score != current.score) mask |= PLAYER_SCORE;
+        if (baseline.isDead != current.isDead) mask |= PLAYER_DEAD;
+        return mask;
+    }
+
+    uint8_t DiffEnemy(const EnemyData& baseline, const EnemyData& current) {
+        uint8_t mask = 0;
+        if (baseline.enemyType != current.enemyType) mask |= ENEMY_TYPE;
+        if (PositionChanged(baseline.x, baseline.y, current.x, current.y)) mask |= ENEMY_POSITION;
+        if (RotationChanged(baseline.bodyRotation, current.bodyRotation)) mask |= ENEMY_BODY_ROTATION;
+        if (RotationChanged(baseline.barrelRotation, current.barrelRotation)) mask |= ENEMY_BARREL_ROTATION;
+        if (HealthChanged(baseline.health, current.health)) mask |= ENEMY_HEALTH;
+        if (HealthChanged(baseline.maxHealth, current.maxHealth)) mask |= ENEMY_MAX_HEALTH;
+        return mask;
+    }
+
+    size_t EstimatePlayerBits(uint16_t mask) {
+        size_t bits = 8 + PLAYER_MASK_BITS;
+        if (mask & PLAYER_POSITION) bits += 2 * WirePrecision::POSITION_BITS;
+        if (mask & PLAYER_BODY_ROTATION) bits += WirePrecision::ROTATION_BITS;
+        if (mask & PLAYER_BARREL_ROTATION) bits += WirePrecision::ROTATION_BITS;
+        if (mask & PLAYER_COLOR) bits += WirePrecision::COLOR_BITS;
+        if (mask & PLAYER_MOVEMENT) bits += 4;
+        if (mask & PLAYER_HEALTH) bits += WirePrecision::HEALTH_BITS;
+        if (mask & PLAYER_MAX_HEALTH) bits += WirePrecision::HEALTH_BITS;
+        if (mask & PLAYER_SCORE) bits += 16;
+        if (mask & PLAYER_DEAD) bits += 1;
+        return bits;
+    }
+
+    size_t EstimateEnemyBits(uint8_t mask) {
+        size_t bits = 8 + ENEMY_MASK_BITS;
+        if (mask & ENEMY_TYPE) bits += WirePrecision::ENEMY_TYPE_BITS;
+        if (mask & ENEMY_POSITION) bits += 2 * WirePrecision::POSITION_BITS;
+        if (mask & ENEMY_BODY_ROTATION) bits += WirePrecision::ROTATION_BITS;
+        if (mask & ENEMY_BARREL_ROTATION) bits += WirePrecision::ROTATION_BITS;
+        if (mask & ENEMY_HEALTH) bits += WirePrecision::HEALTH_BITS;
+        if (mask & ENEMY_MAX_HEALTH) bits += WirePrecision::HEALTH_BITS;
+        return bits;
+    }
+
+    /**
+     * Serializes the body of a GAME_STATE_DELTA message.
+     * @param writer Writer for the message body (reset by the caller)
+     * @param header Sequence/timestamp header for this client
+     * @param baseline Last snapshot the client acknowledged, or nullptr for a full snapshot
+     * @param current Snapshot being sent (sorted by ID)
+     * @return False if the writer overflowed
+     */
+    bool Write(BitWriter& writer, const SnapshotHeader& header,
+        const WorldSnapshot* baseline, const WorldSnapshot& current) {
+        WriteHeader(writer, header, IsHashed(header.snapshotSequence) ? Hash(current) : 0);
+        WriteBody(writer, baseline, current);
+        return !writer.HasOverflowed();
+    }
+
+    void WriteHeader(BitWriter& writer, const SnapshotHeader& header, uint32_t stateHash) {
+        NetworkUtils::Write(writer, StateHeader(header.snapshotSequence, header.timestamp));
+        writer.WriteVarUint(header.baselineSequence);
+        writer.WriteVarUint(header.sequenceNumber);
+        writer.WriteVarUint(header.lastAckedInput);
+        // Apply time as an offset from the timestamp, a few bytes at most
+        writer.WriteBool(header.inputApplyMicros != 0);
+        if (header.inputApplyMicros != 0) {
+            const int64_t offset = header.inputApplyMicros - header.timestamp * 1000;
+            writer.WriteVarInt(static_cast<int32_t>(std::clamp<int64_t>(offset, INT32_MIN, INT32_MAX)));
+        }
+        const bool hashed = IsHashed(header.snapshotSequence);
+        writer.WriteBool(hashed);
+        if (hashed) {
+            writer.WriteBits(stateHash, 32);
+        }
+    }
+
+    void WriteBody(BitWriter& writer, const WorldSnapshot* baseline, const WorldSnapshot& current) {
+        WriteSection(writer, baseline ? &baseline->players : nullptr, current.players,
+            PLAYER_ALL, PlayerId, DiffPlayer, WritePlayerFields);
+        WriteSection(writer, baseline ? &baseline->enemies : nullptr, current.enemies,
+            ENEMY_ALL, EnemyId, DiffEnemy, WriteEnemyFields);
+    }
+
+    bool ReadHeader(BitReader& reader, const StateHeader& stateHeader, SnapshotHeader& header) {
+        header.snapshotSequence = stateHeader.sequence;
+        header.timestamp = stateHeader.timestamp;
+        header.baselineSequence = reader.ReadVarUint();
+        header.sequenceNumber = reader.ReadVarUint();
+        header.lastAckedInput = reader.ReadVarUint();
+        header.inputApplyMicros = reader.ReadBool() ? header.timestamp * 1000 + reader.ReadVarInt() : 0;
+        header.hasStateHash = reader.ReadBool();
+        header.stateHash = header.hasStateHash ? reader.ReadBits(32) : 0;
+        return reader.IsValid();
+    }
+
+    /**
+     * Reconstructs a full snapshot from the baseline and the delta body.
+     * @return False if the body is truncated or malformed (out is then unusable)
+     */
+    bool ReadBody(BitReader& reader, const SnapshotHeader& header,
+        const WorldSnapshot* baseline, WorldSnapshot& out) {
+        // Assigned and cleared rather than replaced, so a reused history slot
+        // keeps its capacity and steady-state decoding allocates nothing
+        if (baseline) {
+            out.players = baseline->players;
+            out.enemies = baseline->enemies;
+        }
+        else {
+            out.players.clear();
+            out.enemies.clear();
+        }
+        out.sequence = header.snapshotSequence;
+
+        const bool playersOk = ReadSection(reader, out.players, PlayerId,
+            [](PlayerData& player, uint32_t id) { player.playerId = id; }, ReadPlayerFields);
+        if (!playersOk) {
+            return false;
+        }
+        return ReadSection(reader, out.enemies, EnemyId,
+            [](EnemyData& enemy, uint32_t id) { enemy.enemyId = id; }, ReadEnemyFields);
+    }
+}
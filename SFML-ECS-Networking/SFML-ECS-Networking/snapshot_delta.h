@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "bit_stream.h"
+#include "network_messages.h"
+
+// Replicated world state for one GAME_STATE_DELTA, entities sorted by ID
+struct WorldSnapshot {
+    uint32_t sequence;                  // Per-client snapshot sequence (0 = none)
+    std::vector<PlayerData> players;    // Sorted by playerId
+    std::vector<EnemyData> enemies;     // Sorted by enemyId
+    // Server side: snapshots with the same nonzero key hold the same entities,
+    // so their encodings can be shared (see SnapshotEncodeCache). 0 = not known
+    uint64_t contentKey;
+
+    WorldSnapshot() : sequence(0), contentKey(0) {}
+
+    // Restores ID order after entities were appended in arbitrary order
+    void SortById();
+};
+
+// Fixed ring of recent snapshots, looked up by sequence number.
+// Server keeps one per client for baselines; the client keeps one for decoding.
+class SnapshotHistory {
+public:
+    static constexpr size_t HISTORY_SIZE = 32;  // ~0.7 s at the 45 Hz state rate
+
+    void Store(const WorldSnapshot& snapshot);
+
+    // @return Stored snapshot with this sequence, or nullptr if it was overwritten
+    const WorldSnapshot* Find(uint32_t sequence) const;
+
+    // Slot a snapshot with this sequence is stored in, for decoding in place.
+    // It may still hold the baseline; SnapshotDelta::ReadBody copies that first
+    WorldSnapshot& SlotFor(uint32_t sequence) { return slots[sequence % HISTORY_SIZE]; }
+
+    void Clear();
+
+    // The ring plus the entity lists its slots hold (see MemoryReport)
+    size_t GetApproximateBytes() const;
+
+private:
+    std::array<WorldSnapshot, HISTORY_SIZE> slots;
+};
+
+// Header written before every delta-compressed snapshot
+struct SnapshotHeader {
+    uint32_t snapshotSequence;      // Sequence of this snapshot for this client
+    uint32_t baselineSequence;      // Snapshot it was encoded against (0 = full snapshot)
+    int64_t timestamp;              // Server timestamp
+    uint32_t sequenceNumber;        // Server outgoing message sequence
+    uint32_t lastAckedInput;        // Last input sequence the server processed for this client
+    int64_t inputApplyMicros;       // Server steady time of the tick that applied it (0 = unknown)
+    // Set by ReadHeader: SnapshotDelta::Hash of the snapshot as the server
+    // encoded it, on every STATE_HASH_INTERVAL-th sequence
+    bool hasStateHash;
+    uint32_t stateHash;
+
+    SnapshotHeader() : snapshotSequence(0), baselineSequence(0), timestamp(0),
+        sequenceNumber(0), lastAckedInput(0), inputApplyMicros(0), hasStateHash(false), stateHash(0) {
+    }
+};
+
+// Delta encoding of WorldSnapshot against a baseline the client has acknowledged.
+// Each changed entity is sent as ID + field mask + only the masked fields; unchanged
+// entities are skipped and removed ones are listed by ID. A null baseline sends
+// every entity with every field. The body is bit-packed: IDs are varint gaps from
+// the previous ID in the section, masks use exactly as many bits as there are fields.
+namespace SnapshotDelta {
+    // Player field mask bits (names are not replicated here, see PlayerListMessage)
+    constexpr uint16_t PLAYER_POSITION = 1 << 0;
+    constexpr uint16_t PLAYER_BODY_ROTATION = 1 << 1;
+    constexpr uint16_t PLAYER_BARREL_ROTATION = 1 << 2;
+    constexpr uint16_t PLAYER_COLOR = 1 << 3;
+    constexpr uint16_t PLAYER_MOVEMENT = 1 << 4;
+    constexpr uint16_t PLAYER_HEALTH = 1 << 5;
+    constexpr uint16_t PLAYER_MAX_HEALTH = 1 << 6;
+    constexpr uint16_t PLAYER_SCORE = 1 << 7;
+    constexpr uint16_t PLAYER_DEAD = 1 << 8;
+    constexpr int PLAYER_MASK_BITS = 9;
+    constexpr uint16_t PLAYER_ALL = (1 << PLAYER_MASK_BITS) - 1;
+
+    // Enemy field mask bits
+    constexpr uint8_t ENEMY_TYPE = 1 << 0;
+    constexpr uint8_t ENEMY_POSITION = 1 << 1;
+    constexpr uint8_t ENEMY_BODY_ROTATION = 1 << 2;
+    constexpr uint8_t ENEMY_BARREL_ROTATION = 1 << 3;
+    constexpr uint8_t ENEMY_HEALTH = 1 << 4;
+    constexpr uint8_t ENEMY_MAX_HEALTH = 1 << 5;
+    constexpr int ENEMY_MASK_BITS = 6;
+    constexpr uint8_t ENEMY_ALL = (1 << ENEMY_MASK_BITS) - 1;
+
+    // Upper bound on entries per section accepted when decoding
+    constexpr uint32_t MAX_SECTION_ENTRIES = 4096;
+
+    // Snapshots whose sequence is a multiple of this carry a state hash, so
+    // a receiver whose reconstruction drifted notices within a few frames
+    constexpr uint32_t STATE_HASH_INTERVAL = 8;
+
+    // Hash of every replicated field at wire precision, in ID order: the
+    // sender's snapshot and a correct reconstruction of it hash the same
+    uint32_t Hash(const WorldSnapshot& snapshot);
+    inline bool IsHashed(uint32_t snapshotSequence) { return snapshotSequence % STATE_HASH_INTERVAL == 0; }
+
+    uint16_t DiffPlayer(const PlayerData& baseline, const PlayerData& current);
+    uint8_t DiffEnemy(const EnemyData& baseline, const EnemyData& current);
+
+    // Approximate encoded size of one changed entry with these fields, for
+    // budgeting before encoding (ID gap taken as one byte, score as two)
+    size_t EstimatePlayerBits(uint16_t mask);
+    size_t EstimateEnemyBits(uint8_t mask);
+
+    // Writes header and the delta of current against baseline; the caller writes the
+    // GAME_STATE_DELTA type byte to the packet and appends the writer after it
+    // (header.baselineSequence must match baseline, or be 0 with a null baseline)
+    // @return False if the snapshot did not fit the writer
+    bool Write(BitWriter& writer, const SnapshotHeader& header,
+        const WorldSnapshot* baseline, const WorldSnapshot& current);
+
+    // The two halves of Write. The header is the only part specific to the
+    // recipient; the body depends on nothing but baseline and current.
+    // stateHash is Hash(current), written only if IsHashed(header.snapshotSequence)
+    void WriteHeader(BitWriter& writer, const SnapshotHeader& header, uint32_t stateHash);
+    void WriteBody(BitWriter& writer, const WorldSnapshot* baseline, const WorldSnapshot& current);
+
+    // Reads the rest of the header once the caller has read the StateHeader that
+    // starts the message body (snapshot sequence and timestamp) and kept the snapshot
+    bool ReadHeader(BitReader& reader, const StateHeader& stateHeader, SnapshotHeader& header);
+
+    // Rebuilds the full snapshot from baseline (null for a full snapshot) plus the delta
+    bool ReadBody(BitReader& reader, const SnapshotHeader& header,
+        const WorldSnapshot* baseline, WorldSnapshot& out);
+}
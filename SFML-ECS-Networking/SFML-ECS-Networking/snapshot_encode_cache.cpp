@@ -0,0 +1,46 @@
+#include "snapshot_encode_cache.h"
+
+/**
+ * Looks the key pair up among this round's bodies; the first recipient of a
+ * pair encodes it into a new entry. The state hash, when the header needs it,
+ * is computed once per entry as well.
+ */
+bool SnapshotEncodeCache::Write(BitWriter& writer, const SnapshotHeader& header,
+    const WorldSnapshot* baseline, const WorldSnapshot& current) {
+    const uint64_t baselineKey = baseline ? baseline->contentKey : 0;
+    if (current.contentKey == 0 || (baseline && baselineKey == 0)) {
+        return SnapshotDelta::Write(writer, header, baseline, current);
+    }
+
+    Entry* entry = nullptr;
+    for (size_t i = 0; i < entryCount; ++i) {
+        if (entries[i].currentKey == current.contentKey && entries[i].baselineKey == baselineKey) {
+            entry = &entries[i];
+            sharedCount++;
+            break;
+        }
+    }
+    if (!entry) {
+        if (entryCount == MAX_ENTRIES) {
+            return SnapshotDelta::Write(writer, header, baseline, current);
+        }
+        if (entryCount == entries.size()) {
+            entries.emplace_back();
+        }
+        entry = &entries[entryCount++];
+        entry->baselineKey = baselineKey;
+        entry->currentKey = current.contentKey;
+        entry->hashed = false;
+        entry->body.Reset();
+        SnapshotDelta::WriteBody(entry->body, baseline, current);
+    }
+
+    const bool hashed = SnapshotDelta::IsHashed(header.snapshotSequence);
+    if (hashed && !entry->hashed) {
+        entry->stateHash = SnapshotDelta::Hash(current);
+        entry->hashed = true;
+    }
+    SnapshotDelta::WriteHeader(writer, header, hashed ? entry->stateHash : 0);
+    writer.Append(entry->body);
+    return !writer.HasOverflowed();
+}
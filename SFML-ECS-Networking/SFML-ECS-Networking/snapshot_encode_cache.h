@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bit_stream.h"
+#include "snapshot_delta.h"
+
+// Shares delta-encoded snapshot bodies between the recipients of one send
+// round. A body depends on nothing but the baseline and the snapshot, so
+// clients whose acknowledged baselines and current snapshots carry the same
+// WorldSnapshot::contentKey pairs (same world snapshot, same interest set,
+// nothing held back for them alone) get one encoding, copied after a header
+// written for each of them. Snapshots with a zero key are encoded as usual.
+//
+// One per encoding thread; Clear at the start of every round.
+class SnapshotEncodeCache {
+public:
+    static constexpr size_t MAX_ENTRIES = 16;   // Distinct bodies kept per round; more are encoded uncached
+
+    // Forgets the previous round's bodies (buffers are kept)
+    void Clear() { entryCount = 0; }
+
+    // SnapshotDelta::Write, taking the body from an earlier recipient with the same keys
+    // @return False if the snapshot did not fit the writer
+    bool Write(BitWriter& writer, const SnapshotHeader& header,
+        const WorldSnapshot* baseline, const WorldSnapshot& current);
+
+    // Bodies copied rather than encoded, ever
+    uint64_t GetSharedCount() const { return sharedCount; }
+
+private:
+    struct Entry {
+        uint64_t baselineKey = 0;       // 0 = full snapshot
+        uint64_t currentKey = 0;
+        bool hashed = false;
+        uint32_t stateHash = 0;
+        BitWriter body;
+    };
+
+    std::vector<Entry> entries;         // Grown up to MAX_ENTRIES, then reused
+    size_t entryCount = 0;
+    uint64_t sharedCount = 0;
+};
@@ -0,0 +1,172 @@
+#include "snapshot_pipeline.h"
+#include "logger.h"
+#include "network_messages.h"
+#include "thread_tuning.h"
+#include "trace_recorder.h"
+#include "utils.h"
+#include <chrono>
+
+SnapshotPipeline::ClientJob& SnapshotPipeline::Frame::AddJob() {
+    if (jobCount == jobs.size()) {
+        jobs.emplace_back();
+    }
+    ClientJob& job = jobs[jobCount++];
+    job.hasSnapshot = false;
+    job.hasBaseline = false;
+    job.outgoing.Clear();
+    job.after.Clear();
+    job.snapshotBytes = 0;
+    job.compressionSaved = 0;
+    job.sharedBody = false;
+    job.messageCount = 0;
+    job.datagrams = TrafficCounter();
+    return job;
+}
+
+SnapshotPipeline::SnapshotPipeline(sf::UdpSocket& socket)
+    : socket(socket), submitted(0), sent(0), stopping(false), running(false),
+    compressionThreshold(0), capture(nullptr), framesSent(0), stalls(0), sendMicros(0) {
+}
+
+SnapshotPipeline::~SnapshotPipeline() {
+    Stop();
+}
+
+bool SnapshotPipeline::Start() {
+    if (running) return true;
+
+    try {
+        stopping = false;
+        worker = std::thread(&SnapshotPipeline::Run, this);
+        running = true;
+        Utils::printMsg("Snapshot send thread started (" + std::to_string(FRAME_COUNT) + " frames)", success);
+        return true;
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Failed to start snapshot send thread: " + std::string(e.what()), error);
+        return false;
+    }
+}
+
+void SnapshotPipeline::Stop() {
+    if (!running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameReady.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    running = false;
+    Utils::printMsg("Snapshot send thread stopped", info);
+}
+
+/**
+ * The frame after the last one submitted is free once the sender has finished
+ * the frame that used it FRAME_COUNT submissions ago.
+ */
+SnapshotPipeline::Frame& SnapshotPipeline::AcquireFrame() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (submitted - sent >= FRAME_COUNT) {
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        frameSent.wait(lock, [this] { return submitted - sent < FRAME_COUNT; });
+    }
+    return frames[submitted % FRAME_COUNT];
+}
+
+void SnapshotPipeline::Submit() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        submitted++;
+    }
+    frameReady.notify_one();
+}
+
+/**
+ * Sender loop: sends frames in submission order. On stop, frames already
+ * submitted still go out.
+ */
+void SnapshotPipeline::Run() {
+    TraceRecorder::SetThreadName("Snapshot send");
+    ThreadTuner::ApplyToCurrentThread(ThreadRole::WORKER);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        frameReady.wait(lock, [this] { return stopping || sent < submitted; });
+        if (sent == submitted) {
+            return;     // Stopping with nothing left to send
+        }
+        Frame& frame = frames[sent % FRAME_COUNT];
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            TRACE_SCOPE("Send frame", "snapshot");
+            SendFrame(frame);
+        }
+        catch (const std::exception& e) {
+            Utils::printMsg("Exception in snapshot send thread: " + std::string(e.what()), error);
+        }
+        sendMicros.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+        framesSent.fetch_add(1, std::memory_order_relaxed);
+
+        lock.lock();
+        sent++;
+        frameSent.notify_one();
+    }
+}
+
+void SnapshotPipeline::SendFrame(Frame& frame) {
+    encodeCache.Clear();
+    for (size_t i = 0; i < frame.jobCount; ++i) {
+        SendJob(frame.jobs[i]);
+    }
+    frame.hasResults = true;
+}
+
+/**
+ * Encodes the client's snapshot between the messages queued before and after
+ * it, then coalesces and sends them as GameServer::FlushOutgoing would.
+ */
+void SnapshotPipeline::SendJob(ClientJob& job) {
+    if (job.hasSnapshot) {
+        TRACE_SCOPE("Encode snapshot", "snapshot");
+        writer.Reset();
+        const uint64_t shared = encodeCache.GetSharedCount();
+        if (encodeCache.Write(writer, job.header, job.hasBaseline ? &job.baseline : nullptr, job.snapshot)) {
+            job.sharedBody = encodeCache.GetSharedCount() != shared;
+            message.clear();
+            message << static_cast<uint8_t>(NetMessageType::GAME_STATE_DELTA);
+            writer.AppendTo(message);
+            job.snapshotBytes = message.getDataSize();
+            if (compressionThreshold != 0 && message.getDataSize() >= compressionThreshold &&
+                compressor.Compress(message, compressed)) {
+                job.compressionSaved = message.getDataSize() - compressed.getDataSize();
+                job.outgoing.Queue(compressed);
+            }
+            else {
+                job.outgoing.Queue(message);
+            }
+        }
+        else {
+            LOG_MSG(warning, "Snapshot for player " + std::to_string(job.playerId) +
+                " exceeds " + std::to_string(BitWriter::MAX_BYTES) + " bytes, not sent");
+        }
+    }
+    job.outgoing.TakeQueued(job.after);
+
+    job.messageCount = job.outgoing.GetQueuedCount();
+    job.outgoing.Flush([&](sf::Packet& datagram) {
+        job.datagrams.Add(datagram.getDataSize());
+        if (capture) {
+            capture->Record(PacketCapture::Direction::SENT, GetSteadyMicros(), job.address, job.port, datagram);
+        }
+        const sf::Socket::Status status = socket.send(datagram, job.address, job.port);
+        if (status != sf::Socket::Status::Done && status != sf::Socket::Status::NotReady) {
+            LOG_MSG(warning, "Failed to send to player " + std::to_string(job.playerId));
+        }
+    });
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bandwidth_stats.h"
+#include "bit_stream.h"
+#include "packet_aggregator.h"
+#include "packet_capture.h"
+#include "packet_compression.h"
+#include "snapshot_delta.h"
+#include "snapshot_encode_cache.h"
+
+// Encodes and sends each tick's snapshots on a thread of its own while the
+// next tick simulates. At the end of a tick the simulation fills a frame:
+// per client, the snapshot it decided to send (interest, schedule, dead
+// reckoning and budget already applied), a copy of its baseline, and the
+// messages queued for it that tick. From then on the frame is immutable to
+// the simulation; the sender delta-encodes, compresses, coalesces and sends
+// it. FRAME_COUNT frames rotate, so one can be filled while the other is sent,
+// and the tick thread only waits if the sender falls a whole frame behind.
+//
+// Everything that decides what a client gets stays on the tick thread, so the
+// bytes on the wire are the same as with synchronous sending. Results (sizes,
+// datagram counts) come back with the frame when it is reused.
+//
+// The sender writes straight to the socket, so the simulation thread's own
+// sends on it must be plain sf::UdpSocket sends (no network thread, batched
+// socket or network conditioner).
+class SnapshotPipeline {
+public:
+    static constexpr size_t FRAME_COUNT = 2;
+
+    struct ClientJob {
+        uint32_t playerId = 0;
+        sf::IpAddress address = sf::IpAddress::Any;
+        unsigned short port = 0;
+
+        bool hasSnapshot = false;
+        bool hasBaseline = false;
+        SnapshotHeader header;
+        WorldSnapshot baseline;         // Copy: the history slot may be reused before the sender runs
+        WorldSnapshot snapshot;
+        PacketAggregator outgoing;      // Messages queued ahead of the snapshot
+        PacketAggregator after;         // Messages queued after it
+
+        // Filled in by the sender
+        size_t snapshotBytes = 0;       // Encoded message before compression (0 = not sent)
+        size_t compressionSaved = 0;
+        bool sharedBody = false;        // Snapshot body encoded once for several clients
+        size_t messageCount = 0;
+        TrafficCounter datagrams;
+    };
+
+    struct Frame {
+        std::vector<ClientJob> jobs;    // Reused; only the first jobCount belong to this frame
+        size_t jobCount = 0;
+        bool hasResults = false;        // Sent, results not collected yet
+
+        // Next job slot, reset to empty (buffers keep their capacity)
+        ClientJob& AddJob();
+        void Clear() { jobCount = 0; hasResults = false; }
+    };
+
+    explicit SnapshotPipeline(sf::UdpSocket& socket);
+    ~SnapshotPipeline();
+
+    SnapshotPipeline(const SnapshotPipeline&) = delete;
+    SnapshotPipeline& operator=(const SnapshotPipeline&) = delete;
+
+    // Snapshots this large go compressed, as with GameServer::SetCompressionThreshold
+    // (set before Start)
+    void SetCompressionThreshold(uint32_t bytes) { compressionThreshold = bytes; }
+    // Records the datagrams this thread sends (set before Start; owned by the server)
+    void SetCapture(PacketCapture* packetCapture) { capture = packetCapture; }
+
+    bool Start();
+    // Sends every submitted frame, then stops the thread
+    void Stop();
+    bool IsRunning() const { return running; }
+
+    // Tick thread: the frame to fill next. Waits while the sender still has it.
+    // A frame that was sent comes back with hasResults set; collect them and
+    // Clear it before adding jobs.
+    Frame& AcquireFrame();
+    // Hands the acquired frame to the sender
+    void Submit();
+
+    // Diagnostics (any thread)
+    uint64_t GetFramesSent() const { return framesSent.load(std::memory_order_relaxed); }
+    uint64_t GetStalls() const { return stalls.load(std::memory_order_relaxed); }
+    uint64_t GetSendMicros() const { return sendMicros.load(std::memory_order_relaxed); }
+
+private:
+    sf::UdpSocket& socket;
+    std::array<Frame, FRAME_COUNT> frames;
+    uint64_t submitted;                 // Frames handed over (guarded by mutex)
+    uint64_t sent;                      // Frames the sender finished (guarded by mutex)
+    std::mutex mutex;
+    std::condition_variable frameReady;
+    std::condition_variable frameSent;
+    bool stopping;
+    bool running;
+    std::thread worker;
+
+    // Sender thread only
+    uint32_t compressionThreshold;
+    PacketCapture* capture;
+    BitWriter writer;
+    SnapshotEncodeCache encodeCache;    // Per frame
+    sf::Packet message;
+    sf::Packet compressed;
+    PacketCompressor compressor;
+
+    std::atomic<uint64_t> framesSent;
+    std::atomic<uint64_t> stalls;       // Times the tick thread waited for a frame
+    std::atomic<uint64_t> sendMicros;
+
+    void Run();
+    void SendFrame(Frame& frame);
+    void SendJob(ClientJob& job);
+};
@@ -0,0 +1,183 @@
+#include "soak_test.h"
+#include "allocation_counter.h"
+#include "bot_client.h"
+#include "local_server.h"
+#include "logger.h"
+#include "memory_report.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+    using SoakClock = std::chrono::steady_clock;
+
+    // Growth below these is noise whatever the percentage
+    constexpr double RESIDENT_FLOOR_BYTES = 4.0 * 1024 * 1024;
+    constexpr double SUBSYSTEM_FLOOR_BYTES = 64.0 * 1024;
+    constexpr double OBJECT_FLOOR = 32.0;
+    constexpr double ALLOCATION_FLOOR_PER_SECOND = 100.0;
+    constexpr double TICK_FLOOR_MICROS = 200.0;
+
+    struct Series {
+        std::string name;
+        double floor;
+        std::vector<double> values;     // One per sample
+    };
+
+    // Series of the given name, created on the first sample; later arrivals are
+    // left out, so every series has a value for every sample
+    void AddValue(std::vector<Series>& series, bool firstSample, const std::string& name, double floor, double value) {
+        auto it = std::find_if(series.begin(), series.end(), [&name](const Series& entry) { return entry.name == name; });
+        if (it != series.end()) {
+            it->values.push_back(value);
+        }
+        else if (firstSample) {
+            series.push_back(Series{ name, floor, { value } });
+        }
+    }
+
+    double Mean(std::vector<double>::const_iterator begin, std::vector<double>::const_iterator end) {
+        double total = 0.0;
+        for (auto it = begin; it != end; ++it) {
+            total += *it;
+        }
+        return begin != end ? total / static_cast<double>(end - begin) : 0.0;
+    }
+
+    void WriteCsv(const std::string& path, const std::vector<Series>& series, const std::vector<double>& minutes) {
+        std::ofstream file(path);
+        if (!file) {
+            Utils::printMsg("Error: Could not write soak samples to " + path, error);
+            return;
+        }
+        file << "minutes";
+        for (const Series& entry : series) {
+            file << "," << entry.name;
+        }
+        file << "\n";
+        for (size_t sample = 0; sample < minutes.size(); ++sample) {
+            file << minutes[sample];
+            for (const Series& entry : series) {
+                file << "," << entry.values[sample];
+            }
+            file << "\n";
+        }
+    }
+}
+
+/**
+ * Runs the bots on this thread at 60 Hz and samples the server on its tick
+ * thread (LocalServer::Inspect), which owns the tick stats window here since
+ * the server's own stats reporting is turned off.
+ */
+int SoakTest::Run(const SoakTestConfig& config) {
+    const float runSeconds = config.hours * 3600.0f;
+    const auto sampleInterval = std::chrono::duration<float>(std::max(config.sampleIntervalSeconds, 1.0f));
+    const float FRAME_SECONDS = 1.0f / 60.0f;
+
+    LocalServer server;
+    if (!server.Start([](GameServer& game) { game.SetStatsReportingEnabled(false); })) {
+        return -1;
+    }
+    BotLoadConfig botConfig;
+    botConfig.loopback = &server.GetNetwork();
+    botConfig.botCount = std::min<uint32_t>(config.botCount, static_cast<uint32_t>(LoopbackNetwork::MAX_ENDPOINTS));
+    Logger::Write("Soak test: " + std::to_string(botConfig.botCount) + " bots joining and leaving for " +
+        std::to_string(config.hours) + " h, sampled every " + std::to_string(static_cast<int>(sampleInterval.count())) + " s", info);
+
+    // Bots and server log at info per join; the samples bypass the filter
+    Logger::SetMinimumLevel(error);
+    AsyncLogScope asyncLog;
+    std::vector<Series> series;
+    std::vector<double> minutes;
+    MemoryReport memory;
+    {
+        BotLoadGenerator bots(botConfig);
+        const SoakClock::time_point start = SoakClock::now();
+        SoakClock::time_point frameStart = start;
+        SoakClock::time_point nextSample = start + std::chrono::duration_cast<SoakClock::duration>(sampleInterval);
+        SoakClock::time_point lastSample = start;
+        uint64_t lastAllocations = AllocationCounter::GetCount();
+        while (SoakClock::now() - start < std::chrono::duration<float>(runSeconds)) {
+            const SoakClock::time_point now = SoakClock::now();
+            bots.Update(std::chrono::duration<float>(now - frameStart).count());
+            frameStart = now;
+
+            if (now >= nextSample) {
+                TickStats ticks;
+                server.Inspect([&](GameServer& game) {
+                    ticks = game.TakeTickStats();
+                    game.ReportMemory(memory);
+                    });
+                const uint64_t allocations = AllocationCounter::GetCount();
+                const double seconds = std::chrono::duration<double>(now - lastSample).count();
+                const bool first = minutes.empty();
+                minutes.push_back(std::chrono::duration<double>(now - start).count() / 60.0);
+                AddValue(series, first, "resident_bytes", RESIDENT_FLOOR_BYTES, static_cast<double>(MemoryReport::GetResidentBytes()));
+                AddValue(series, first, "allocations_per_second", ALLOCATION_FLOOR_PER_SECOND,
+                    static_cast<double>(allocations - lastAllocations) / seconds);
+                AddValue(series, first, "tick_p50_us", TICK_FLOOR_MICROS, static_cast<double>(ticks.tickMicros.GetPercentile(50.0)));
+                AddValue(series, first, "tick_p99_us", TICK_FLOOR_MICROS, static_cast<double>(ticks.tickMicros.GetPercentile(99.0)));
+                for (const MemoryReport::Line& line : memory.GetLines()) {
+                    AddValue(series, first, std::string(line.subsystem) + " objects", OBJECT_FLOOR, static_cast<double>(line.count));
+                    AddValue(series, first, std::string(line.subsystem) + " bytes", SUBSYSTEM_FLOOR_BYTES, static_cast<double>(line.bytes));
+                }
+                std::string text;
+                memory.AppendText(text);
+                text.pop_back();
+                char head[192];
+                std::snprintf(head, sizeof(head), "Soak sample %zu at %.1f min - resident %s - %.0f allocations/s - tick p50 %llu us, p99 %llu us\n",
+                    minutes.size(), minutes.back(), MemoryReport::FormatBytes(MemoryReport::GetResidentBytes()).c_str(),
+                    static_cast<double>(allocations - lastAllocations) / seconds,
+                    static_cast<unsigned long long>(ticks.tickMicros.GetPercentile(50.0)),
+                    static_cast<unsigned long long>(ticks.tickMicros.GetPercentile(99.0)));
+                Logger::Write(head + text, info);
+                lastAllocations = allocations;
+                lastSample = now;
+                nextSample += std::chrono::duration_cast<SoakClock::duration>(sampleInterval);
+            }
+
+            const float frameTime = std::chrono::duration<float>(SoakClock::now() - now).count();
+            if (frameTime < FRAME_SECONDS) {
+                std::this_thread::sleep_for(std::chrono::duration<float>(FRAME_SECONDS - frameTime));
+            }
+        }
+        bots.Shutdown();
+    }
+    server.Stop();
+    Logger::SetMinimumLevel(debug);
+
+    if (!config.csvPath.empty()) {
+        WriteCsv(config.csvPath, series, minutes);
+    }
+    if (minutes.size() < config.warmupSamples + MIN_TREND_SAMPLES) {
+        Utils::printMsg("Soak test too short to judge a trend: " + std::to_string(minutes.size()) + " samples, " +
+            std::to_string(config.warmupSamples + MIN_TREND_SAMPLES) + " needed", warning);
+        return 0;
+    }
+    int drifted = 0;
+    for (const Series& entry : series) {
+        const auto begin = entry.values.cbegin() + config.warmupSamples;
+        const auto quarter = (entry.values.cend() - begin) / 4;
+        const double early = Mean(begin, begin + quarter);
+        const double late = Mean(entry.values.cend() - quarter, entry.values.cend());
+        const double growth = late - early;
+        if (growth > entry.floor && growth > early * config.maxGrowthPercent / 100.0) {
+            Utils::printMsg("Drift: " + entry.name + " rose from " + std::to_string(early) + " to " + std::to_string(late) +
+                " (first and last quarter after warm-up)", error);
+            drifted++;
+        }
+    }
+    if (drifted > 0) {
+        Utils::printMsg("Soak test failed: " + std::to_string(drifted) + " of " + std::to_string(series.size()) +
+            " metrics trended upward", error);
+        return -1;
+    }
+    Utils::printMsg("Soak test passed: no upward trend in " + std::to_string(series.size()) + " metrics over " +
+        std::to_string(minutes.size()) + " samples", success);
+    return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Long-running stability check: an in-process server (LocalServer) with bots
+// joining and leaving (BotLoadGenerator) for hours. Every sample interval it
+// records the process's resident memory, heap allocations per second, the
+// server's MemoryReport lines (players, enemies, bullets, sequence tracking,
+// pools...) and tick time percentiles. At the end every metric is checked for
+// an upward trend after the warm-up: the mean of the last quarter of its
+// samples against the mean of the first. Growth past maxGrowthPercent (and
+// past a small per-metric floor, so near-zero values do not trip it) is
+// drift, and fails the run. Memory and allocations are the whole process's,
+// bots included.
+struct SoakTestConfig {
+    float hours = 4.0f;
+    uint32_t botCount = 32;
+    float sampleIntervalSeconds = 60.0f;
+    uint32_t warmupSamples = 10;            // Left out of the trend: pools and caches still filling
+    float maxGrowthPercent = 25.0f;
+    std::string csvPath;                    // Every sample as CSV (empty = none)
+};
+
+namespace SoakTest {
+    constexpr uint32_t MIN_TREND_SAMPLES = 8;    // After the warm-up, or the trend is not judged
+
+    // @return 0 if nothing drifted, -1 on drift or if the server did not start
+    int Run(const SoakTestConfig& config);
+}
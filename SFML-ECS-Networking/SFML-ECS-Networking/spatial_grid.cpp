@@ -0,0 +1,173 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Creates a grid covering [0, worldWidth] x [0, worldHeight].
+ * @param worldWidth World width in pixels
+ * @param worldHeight World height in pixels
+ * @param cellSize Cell edge length (about one tank diameter works well)
+ */
+SpatialGrid::SpatialGrid(float worldWidth, float worldHeight, float cellSize)
+    : cellSize(cellSize > 1.0f ? cellSize : DEFAULT_CELL_SIZE),
+    maxRadius(0.0f), entryCount(0)
+{
+    inverseCellSize = 1.0f / this->cellSize;
+    columns = std::max(1, static_cast<int>(std::ceil(worldWidth * inverseCellSize)));
+    rows = std::max(1, static_cast<int>(std::ceil(worldHeight * inverseCellSize)));
+    cells.resize(static_cast<size_t>(columns) * static_cast<size_t>(rows));
+}
+
+void SpatialGrid::Clear() {
+    for (auto& cell : cells) {
+        cell.clear();
+    }
+    slots.clear();
+    maxRadius = 0.0f;
+    entryCount = 0;
+}
+
+void SpatialGrid::Reserve(size_t entriesPerCell) {
+    for (auto& cell : cells) {
+        cell.reserve(entriesPerCell);
+    }
+}
+
+void SpatialGrid::Insert(uint32_t id, sf::Vector2f position, float radius,
+    CollisionLayers::Mask layer, CollisionLayers::Mask mask) {
+    if (!std::isfinite(position.x) || !std::isfinite(position.y)) {
+        return;
+    }
+
+    const int cx = CellX(position.x);
+    const int cy = CellY(position.y);
+    cells[static_cast<size_t>(cy) * columns + cx].push_back({ id, position, radius, layer, mask });
+    maxRadius = std::max(maxRadius, radius);
+    entryCount++;
+}
+
+/**
+ * Moves an entry in place while it stays in its cell. The query reach only
+ * grows until the next Clear(), so shrinking radii stay conservative.
+ */
+void SpatialGrid::Update(uint32_t id, sf::Vector2f position, float radius,
+    CollisionLayers::Mask layer, CollisionLayers::Mask mask) {
+    if (!std::isfinite(position.x) || !std::isfinite(position.y)) {
+        Remove(id);
+        return;
+    }
+
+    const uint32_t cell = static_cast<uint32_t>(CellY(position.y) * columns + CellX(position.x));
+    maxRadius = std::max(maxRadius, radius);
+    auto [it, inserted] = slots.try_emplace(id, Slot{ cell, 0 });
+    if (!inserted) {
+        if (it->second.cell == cell) {
+            Entry& entry = cells[cell][it->second.index];
+            entry.position = position;
+            entry.radius = radius;
+            entry.layer = layer;
+            entry.mask = mask;
+            return;
+        }
+        RemoveAt(it->second);
+    }
+    else {
+        entryCount++;
+    }
+    it->second = { cell, static_cast<uint32_t>(cells[cell].size()) };
+    cells[cell].push_back({ id, position, radius, layer, mask });
+}
+
+void SpatialGrid::Remove(uint32_t id) {
+    auto it = slots.find(id);
+    if (it == slots.end()) {
+        return;
+    }
+    RemoveAt(it->second);
+    slots.erase(it);
+    entryCount--;
+}
+
+/**
+ * Swap-and-pop out of the bucket; the entry moved into the hole gets its
+ * slot fixed up.
+ */
+void SpatialGrid::RemoveAt(Slot slot) {
+    std::vector<Entry>& bucket = cells[slot.cell];
+    if (slot.index + 1 < bucket.size()) {
+        bucket[slot.index] = bucket.back();
+        slots[bucket[slot.index].id].index = slot.index;
+    }
+    bucket.pop_back();
+}
+
+void SpatialGrid::Query(sf::Vector2f position, float radius,
+    std::vector<const Entry*>& outCandidates, CollisionLayers::Mask mask) const {
+    outCandidates.clear();
+    if (entryCount == 0 || !std::isfinite(position.x) || !std::isfinite(position.y)) {
+        return;
+    }
+
+    const float reach = radius + maxRadius;
+    const int minX = CellX(position.x - reach);
+    const int maxX = CellX(position.x + reach);
+    const int minY = CellY(position.y - reach);
+    const int maxY = CellY(position.y + reach);
+
+    for (int y = minY; y <= maxY; ++y) {
+        const size_t rowOffset = static_cast<size_t>(y) * columns;
+        for (int x = minX; x <= maxX; ++x) {
+            for (const Entry& entry : cells[rowOffset + x]) {
+                if ((entry.layer & mask) != 0) {
+                    outCandidates.push_back(&entry);
+                }
+            }
+        }
+    }
+}
+
+void SpatialGrid::FindOverlappingPairs(float padding, std::vector<OverlapPair>& outPairs) const {
+    outPairs.clear();
+    if (entryCount < 2) {
+        return;
+    }
+
+    // Any partner of an entry lies within its radius + maxRadius + padding
+    for (const auto& cell : cells) {
+        for (const Entry& entry : cell) {
+            const float reach = entry.radius + maxRadius + padding;
+            const int minX = CellX(entry.position.x - reach);
+            const int maxX = CellX(entry.position.x + reach);
+            const int minY = CellY(entry.position.y - reach);
+            const int maxY = CellY(entry.position.y + reach);
+
+            for (int y = minY; y <= maxY; ++y) {
+                const size_t rowOffset = static_cast<size_t>(y) * columns;
+                for (int x = minX; x <= maxX; ++x) {
+                    for (const Entry& other : cells[rowOffset + x]) {
+                        if (other.id <= entry.id) {
+                            continue;  // Reported from the lower id, and skips self
+                        }
+                        if (!CollisionLayers::Interact(entry.layer, entry.mask, other.layer, other.mask)) {
+                            continue;
+                        }
+                        const float dx = other.position.x - entry.position.x;
+                        const float dy = other.position.y - entry.position.y;
+                        const float minDist = entry.radius + other.radius + padding;
+                        if (dx * dx + dy * dy < minDist * minDist) {
+                            outPairs.push_back({ &entry, &other });
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int SpatialGrid::CellX(float x) const {
+    return std::clamp(static_cast<int>(std::floor(x * inverseCellSize)), 0, columns - 1);
+}
+
+int SpatialGrid::CellY(float y) const {
+    return std::clamp(static_cast<int>(std::floor(y * inverseCellSize)), 0, rows - 1);
+}
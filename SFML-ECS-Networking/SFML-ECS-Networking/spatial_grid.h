@@ -0,0 +1,91 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "collision_layers.h"
+#include "world_constants.h"
+
+// Uniform-grid broadphase over the game world.
+// Entities are bucketed by their center; queries expand by the largest radius
+// inserted so far, so each entity lives in exactly one cell and never needs
+// de-duplication. Rebuilt once per tick with Clear() + Insert(), or kept
+// across frames and moved entry by entry with Update() / Remove().
+// Entries carry a collision layer and mask (collision_layers.h); grids that
+// hold one kind of entry can leave both at ALL.
+class SpatialGrid {
+public:
+    struct Entry {
+        uint32_t id;
+        sf::Vector2f position;
+        float radius;
+        CollisionLayers::Mask layer;
+        CollisionLayers::Mask mask;
+    };
+
+    // Two entries whose circles (plus padding) overlap; a->id < b->id
+    struct OverlapPair {
+        const Entry* a;
+        const Entry* b;
+    };
+
+    static constexpr float DEFAULT_CELL_SIZE = WorldConstants::TANK_RADIUS * 2.0f;
+
+    SpatialGrid(float worldWidth = WorldConstants::WORLD_WIDTH,
+        float worldHeight = WorldConstants::WORLD_HEIGHT,
+        float cellSize = DEFAULT_CELL_SIZE);
+
+    // Removes all entries but keeps cell capacity for the next rebuild
+    void Clear();
+
+    // Gives every cell room for entriesPerCell entries up front, so entries
+    // moving into cells no rebuild has used yet do not allocate
+    void Reserve(size_t entriesPerCell);
+
+    // Adds an entity; positions outside the world are clamped to edge cells
+    void Insert(uint32_t id, sf::Vector2f position, float radius,
+        CollisionLayers::Mask layer = CollisionLayers::ALL, CollisionLayers::Mask mask = CollisionLayers::ALL);
+
+    // Incremental use: adds the entry or moves it, touching the buckets only
+    // when it changes cell. Keeps an id index, so a grid is either rebuilt
+    // with Insert or maintained with Update / Remove, never both.
+    void Update(uint32_t id, sf::Vector2f position, float radius,
+        CollisionLayers::Mask layer = CollisionLayers::ALL, CollisionLayers::Mask mask = CollisionLayers::ALL);
+    void Remove(uint32_t id);
+
+    // Collects every entry on a layer in mask whose circle may overlap the query circle.
+    // Output is cleared first; candidates still need an exact narrowphase test.
+    void Query(sf::Vector2f position, float radius, std::vector<const Entry*>& outCandidates,
+        CollisionLayers::Mask mask = CollisionLayers::ALL) const;
+
+    // Collects every pair of entries closer than radiusA + radiusB + padding
+    // whose layers and masks accept each other (CollisionLayers::Interact).
+    // Each pair is reported once. Pointers stay valid until the next Clear/Insert.
+    void FindOverlappingPairs(float padding, std::vector<OverlapPair>& outPairs) const;
+
+    size_t GetEntryCount() const { return entryCount; }
+    int GetColumnCount() const { return columns; }
+    int GetRowCount() const { return rows; }
+    float GetCellSize() const { return cellSize; }
+
+private:
+    float cellSize;
+    float inverseCellSize;
+    int columns;
+    int rows;
+    float maxRadius;            // Largest radius inserted since Clear()
+    size_t entryCount;
+
+    std::vector<std::vector<Entry>> cells;  // Row-major cell buckets
+
+    struct Slot {
+        uint32_t cell;
+        uint32_t index;
+    };
+    std::unordered_map<uint32_t, Slot> slots;   // Incremental use only: where each id lives
+
+    int CellX(float x) const;
+    int CellY(float y) const;
+    void RemoveAt(Slot slot);
+};
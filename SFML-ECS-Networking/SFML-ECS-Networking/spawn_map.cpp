@@ -0,0 +1,131 @@
+#include "spawn_map.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    bool InsideSpawnBounds(sf::Vector2f position) {
+        return position.x >= WorldConstants::SPAWN_MIN_X && position.x <= WorldConstants::SPAWN_MAX_X &&
+            position.y >= WorldConstants::SPAWN_MIN_Y && position.y <= WorldConstants::SPAWN_MAX_Y;
+    }
+}
+
+SpawnMap::SpawnMap(float worldWidth, float worldHeight, float cellSize)
+    : cellSize(cellSize),
+    columns(std::max(1, static_cast<int>(std::ceil(worldWidth / cellSize)))),
+    rows(std::max(1, static_cast<int>(std::ceil(worldHeight / cellSize)))),
+    clearance(WorldConstants::TANK_RADIUS + WorldConstants::SPAWN_SAFETY_MARGIN),
+    danger(static_cast<size_t>(columns) * rows, 0),
+    open(static_cast<size_t>(columns) * rows, 0),
+    safeSlot(static_cast<size_t>(columns) * rows, -1) {
+    for (int cell = 0; cell < columns * rows; ++cell) {
+        open[cell] = InsideSpawnBounds(CellCenter(cell));
+    }
+    ClearDanger();
+}
+
+void SpawnMap::SetObstacles(const StaticObstacles& obstacles, float tankClearance) {
+    clearance = tankClearance;
+    for (int cell = 0; cell < columns * rows; ++cell) {
+        const sf::Vector2f center = CellCenter(cell);
+        open[cell] = InsideSpawnBounds(center) && !obstacles.OverlapsCircle(center, clearance);
+    }
+    ClearDanger();
+}
+
+void SpawnMap::ClearDanger() {
+    std::fill(danger.begin(), danger.end(), static_cast<uint16_t>(0));
+    safeCells.clear();
+    for (int cell = 0; cell < columns * rows; ++cell) {
+        safeSlot[cell] = -1;
+        if (open[cell]) {
+            safeSlot[cell] = static_cast<int32_t>(safeCells.size());
+            safeCells.push_back(static_cast<uint32_t>(cell));
+        }
+    }
+}
+
+/**
+ * Marks every cell with some point within SAFE_DISTANCE of the position:
+ * the distance to a cell is to its closest point, so anywhere in a cell
+ * left safe is far enough away.
+ */
+void SpawnMap::AddDanger(sf::Vector2f position) {
+    const int minX = std::max(0, static_cast<int>(std::floor((position.x - SAFE_DISTANCE) / cellSize)));
+    const int maxX = std::min(columns - 1, static_cast<int>(std::floor((position.x + SAFE_DISTANCE) / cellSize)));
+    const int minY = std::max(0, static_cast<int>(std::floor((position.y - SAFE_DISTANCE) / cellSize)));
+    const int maxY = std::min(rows - 1, static_cast<int>(std::floor((position.y + SAFE_DISTANCE) / cellSize)));
+    const float safeDistanceSq = SAFE_DISTANCE * SAFE_DISTANCE;
+
+    for (int y = minY; y <= maxY; ++y) {
+        const float closestY = std::clamp(position.y, y * cellSize, (y + 1) * cellSize);
+        const float dy = position.y - closestY;
+        for (int x = minX; x <= maxX; ++x) {
+            const float closestX = std::clamp(position.x, x * cellSize, (x + 1) * cellSize);
+            const float dx = position.x - closestX;
+            if (dx * dx + dy * dy >= safeDistanceSq) continue;
+
+            const int cell = y * columns + x;
+            if (danger[cell] == 0) {
+                RemoveSafe(cell);
+            }
+            if (danger[cell] < std::numeric_limits<uint16_t>::max()) {
+                danger[cell]++;
+            }
+        }
+    }
+}
+
+/**
+ * The point is drawn inside the cell (within the spawn bounds); where that
+ * draw hits an obstacle the cell's centre, known to be clear, is used.
+ */
+sf::Vector2f SpawnMap::Pick(RandomStream& random, const StaticObstacles& obstacles) const {
+    int cell = -1;
+    if (!safeCells.empty()) {
+        cell = static_cast<int>(safeCells[random.Below(static_cast<uint32_t>(safeCells.size()))]);
+    }
+    else {
+        uint16_t leastDanger = std::numeric_limits<uint16_t>::max();
+        for (int candidate = 0; candidate < columns * rows; ++candidate) {
+            if (open[candidate] && danger[candidate] < leastDanger) {
+                leastDanger = danger[candidate];
+                cell = candidate;
+            }
+        }
+    }
+    if (cell < 0) {
+        // Every cell is blocked; the world's centre, pushed clear
+        return obstacles.ResolveCircle(sf::Vector2f(WorldConstants::CENTER_X, WorldConstants::CENTER_Y), clearance);
+    }
+
+    const int x = cell % columns;
+    const int y = cell / columns;
+    const float minX = std::max(x * cellSize, WorldConstants::SPAWN_MIN_X);
+    const float maxX = std::min((x + 1) * cellSize, WorldConstants::SPAWN_MAX_X);
+    const float minY = std::max(y * cellSize, WorldConstants::SPAWN_MIN_Y);
+    const float maxY = std::min((y + 1) * cellSize, WorldConstants::SPAWN_MAX_Y);
+    const float positionX = random.Uniform(minX, maxX);
+    const float positionY = random.Uniform(minY, maxY);
+    const sf::Vector2f position(positionX, positionY);
+    return obstacles.OverlapsCircle(position, clearance) ? CellCenter(cell) : position;
+}
+
+size_t SpawnMap::GetApproximateBytes() const {
+    return sizeof(*this) + danger.capacity() * sizeof(uint16_t) + open.capacity() +
+        safeCells.capacity() * sizeof(uint32_t) + safeSlot.capacity() * sizeof(int32_t);
+}
+
+sf::Vector2f SpawnMap::CellCenter(int cell) const {
+    return sf::Vector2f((cell % columns + 0.5f) * cellSize, (cell / columns + 0.5f) * cellSize);
+}
+
+void SpawnMap::RemoveSafe(int cell) {
+    const int32_t slot = safeSlot[cell];
+    if (slot < 0) return;
+    const uint32_t last = safeCells.back();
+    safeCells[slot] = last;
+    safeSlot[last] = slot;
+    safeCells.pop_back();
+    safeSlot[cell] = -1;
+}
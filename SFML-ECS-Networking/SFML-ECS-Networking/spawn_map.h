@@ -0,0 +1,53 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "random_stream.h"
+#include "static_obstacles.h"
+#include "world_constants.h"
+
+// Coarse danger grid for spawn and respawn placement. Each cell counts the
+// live tanks within SAFE_DISTANCE of any point in it; the open cells (centre
+// inside the spawn bounds and clear of obstacles) with no danger are kept in
+// a list, so a safe position is one random pick rather than rejection
+// sampling against every tank. Rebuilt each tick with the target grids
+// (GameServer::RebuildTargetGrids); a spawn marks itself at once, so several
+// spawns in one tick spread out instead of landing together.
+class SpawnMap {
+public:
+    static constexpr float DEFAULT_CELL_SIZE = 80.0f;
+    static constexpr float SAFE_DISTANCE = 200.0f;     // From live enemies and players
+
+    SpawnMap(float worldWidth = WorldConstants::WORLD_WIDTH,
+        float worldHeight = WorldConstants::WORLD_HEIGHT,
+        float cellSize = DEFAULT_CELL_SIZE);
+
+    // Recomputes the open cells for a tank of the given clearance (radius
+    // plus margin); call whenever the map's obstacles change
+    void SetObstacles(const StaticObstacles& obstacles, float clearance);
+
+    // Per-tick rebuild: ClearDanger, then AddDanger for every live tank
+    void ClearDanger();
+    void AddDanger(sf::Vector2f position);
+
+    // A point in a random safe cell, clear of obstacles. With no safe cell
+    // left, a point in the least dangerous open cell.
+    sf::Vector2f Pick(RandomStream& random, const StaticObstacles& obstacles) const;
+
+    size_t GetSafeCellCount() const { return safeCells.size(); }
+    size_t GetApproximateBytes() const;
+
+private:
+    float cellSize;
+    int columns;
+    int rows;
+    float clearance;
+    std::vector<uint16_t> danger;       // Per cell
+    std::vector<uint8_t> open;
+    std::vector<uint32_t> safeCells;    // Open cells with no danger, in no order
+    std::vector<int32_t> safeSlot;      // Per cell: index in safeCells, -1 if absent
+
+    sf::Vector2f CellCenter(int cell) const;
+    void RemoveSafe(int cell);
+};
@@ -0,0 +1,241 @@
+#include "spectator_relay.h"
+#include "logger.h"
+#include "network_messages.h"
+#include "utils.h"
+
+SpectatorRelay::SpectatorRelay(const sf::IpAddress& upstreamAddress, unsigned short upstreamPort, uint16_t roomId,
+    unsigned short listenPort)
+    : upstreamAddress(upstreamAddress), upstreamPort(upstreamPort), roomId(roomId), listenPort(listenPort),
+    isRunning(false), upstreamToken(0), lastHandshakeSendMs(0), lastSubscribeSendMs(0), lastUpstreamReceiveMs(0),
+    lastStatsReportMs(0), forwardedDatagrams(0), failedSends(0) {
+    stream.SetDelay(0);
+    stream.SetCapacity(MAX_SPECTATORS);
+}
+
+SpectatorRelay::~SpectatorRelay() {
+    Shutdown();
+}
+
+bool SpectatorRelay::Initialize() {
+    if (isRunning) return true;
+
+    if (downstream.bind(listenPort) != sf::Socket::Status::Done) {
+        Utils::printMsg("Failed to bind relay socket to port " + std::to_string(listenPort), error);
+        return false;
+    }
+    if (upstream.bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+        Utils::printMsg("Failed to open the relay's upstream socket", error);
+        downstream.unbind();
+        return false;
+    }
+    downstream.setBlocking(false);
+    upstream.setBlocking(false);
+    selector.add(downstream);
+    selector.add(upstream);
+
+    const int64_t nowMs = GetCurrentTimestamp();
+    lastStatsReportMs = nowMs;
+    SendUpstreamHandshake(nowMs);
+    isRunning = true;
+    LOG_MSG(success, "Spectator relay listening on port " + std::to_string(listenPort) + ", watching room " +
+        std::to_string(roomId) + " of " + upstreamAddress.toString() + ":" + std::to_string(upstreamPort));
+    return true;
+}
+
+void SpectatorRelay::Update() {
+    if (!isRunning) return;
+
+    try {
+        if (selector.wait(sf::milliseconds(SELECTOR_TIMEOUT_MS))) {
+            const int64_t nowMs = GetCurrentTimestamp();
+            if (selector.isReady(upstream)) {
+                ReceiveUpstream(nowMs);
+            }
+            if (selector.isReady(downstream)) {
+                ReceiveDownstream(nowMs);
+            }
+        }
+
+        const int64_t nowMs = GetCurrentTimestamp();
+        UpdateSubscription(nowMs);
+        // Raw sends: the bytes go out exactly as the server encoded them
+        stream.Release(nowMs, [this](const sf::Packet& datagram, const sf::IpAddress& address, unsigned short port) {
+            SendRaw(downstream, datagram, address, port);
+        });
+        if (nowMs - lastStatsReportMs >= STATS_REPORT_MS) {
+            ReportStats();
+            lastStatsReportMs = nowMs;
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in relay Update: " + std::string(e.what()), error);
+    }
+}
+
+void SpectatorRelay::Shutdown() {
+    if (!isRunning) return;
+    selector.clear();
+    upstream.unbind();
+    downstream.unbind();
+    isRunning = false;
+}
+
+/**
+ * Stream datagrams are queued unchanged. The only message the relay reads
+ * itself is the upstream challenge, which never appears in the stream.
+ */
+void SpectatorRelay::ReceiveUpstream(int64_t nowMs) {
+    const size_t MAX_DATAGRAMS_PER_UPDATE = 1024;
+    for (size_t i = 0; i < MAX_DATAGRAMS_PER_UPDATE; ++i) {
+        std::optional<sf::IpAddress> sender;
+        unsigned short senderPort = 0;
+        packet.clear();
+        if (upstream.receive(packet, sender, senderPort) != sf::Socket::Status::Done) {
+            break;
+        }
+        if (sender != upstreamAddress || senderPort != upstreamPort || packet.getDataSize() == 0) {
+            continue;
+        }
+        const uint8_t type = static_cast<const uint8_t*>(packet.getData())[0];
+        if (type == static_cast<uint8_t>(NetMessageType::CONNECTION_CHALLENGE)) {
+            uint8_t challengeType = 0;
+            uint64_t token = 0;
+            if ((packet >> challengeType >> token) && token != 0) {
+                upstreamToken = token;
+                SendUpstreamSubscribe(nowMs);
+            }
+            continue;
+        }
+        if (upstreamToken != 0) {
+            stream.QueueDatagram(packet, nowMs);
+            lastUpstreamReceiveMs = nowMs;
+            forwardedDatagrams++;
+        }
+    }
+}
+
+void SpectatorRelay::ReceiveDownstream(int64_t nowMs) {
+    const size_t MAX_DATAGRAMS_PER_UPDATE = 1024;
+    for (size_t i = 0; i < MAX_DATAGRAMS_PER_UPDATE; ++i) {
+        std::optional<sf::IpAddress> sender;
+        unsigned short senderPort = 0;
+        packet.clear();
+        if (downstream.receive(packet, sender, senderPort) != sf::Socket::Status::Done) {
+            break;
+        }
+        if (sender) {
+            HandleSpectator(sender.value(), senderPort, nowMs);
+        }
+    }
+}
+
+/**
+ * Same rules as the server: a token-less connection request gets a
+ * challenge, and a SPECTATE_REQUEST must carry a token issued to its
+ * endpoint or the one it subscribed with. The requested room is ignored,
+ * a relay carries one. Players that reach a relay are simply not answered.
+ */
+void SpectatorRelay::HandleSpectator(const sf::IpAddress& address, unsigned short port, int64_t nowMs) {
+    uint64_t token = 0;
+    if (!ConnectionTokens::ReadToken(packet, token)) {
+        return;
+    }
+    if (token == 0) {
+        if (ConnectionTokens::IsConnectionRequest(packet)) {
+            outgoing.clear();
+            ConnectionTokens::WriteChallenge(outgoing, connectionTokens.Issue(address, port, nowMs));
+            SendRaw(downstream, outgoing, address, port);
+        }
+        return;
+    }
+    if (ConnectionTokens::PeekMessageType(packet) != static_cast<uint8_t>(NetMessageType::SPECTATE_REQUEST)) {
+        return;
+    }
+    const uint64_t subscribedToken = stream.FindToken(address, port);
+    if (token != subscribedToken && !connectionTokens.Validate(token, address, port, nowMs)) {
+        return;
+    }
+    const std::string endpoint = address.toString() + ":" + std::to_string(port);
+    if (!stream.Subscribe(address, port, token, nowMs)) {
+        LOG_MSG(debug, "Relay full (" + std::to_string(stream.GetCapacity()) + "), refused " + endpoint);
+        return;
+    }
+    if (subscribedToken == 0) {
+        LOG_MSG(info, "Spectator " + endpoint + " subscribed (" + std::to_string(stream.GetSpectatorCount()) + " watching)");
+    }
+}
+
+/**
+ * Mirrors a spectating client: retry the handshake until a token arrives,
+ * refresh the subscription, and start over after a subscription timeout with
+ * no stream and no handshake (the server restarted, or the subscription
+ * lapsed while the room was empty).
+ */
+void SpectatorRelay::UpdateSubscription(int64_t nowMs) {
+    if (upstreamToken == 0) {
+        if (nowMs - lastHandshakeSendMs >= HANDSHAKE_RETRY_MS) {
+            SendUpstreamHandshake(nowMs);
+        }
+        return;
+    }
+    if (nowMs - lastUpstreamReceiveMs > SpectatorStream::SPECTATOR_TIMEOUT_MS &&
+        nowMs - lastHandshakeSendMs > SpectatorStream::SPECTATOR_TIMEOUT_MS) {
+        LOG_MSG(debug, "No stream from " + upstreamAddress.toString() + ":" + std::to_string(upstreamPort) +
+            " for " + std::to_string(SpectatorStream::SPECTATOR_TIMEOUT_MS) + " ms, subscribing again");
+        upstreamToken = 0;
+        SendUpstreamHandshake(nowMs);
+        return;
+    }
+    if (nowMs - lastSubscribeSendMs >= SpectatorStream::REFRESH_MS) {
+        SendUpstreamSubscribe(nowMs);
+    }
+}
+
+void SpectatorRelay::SendUpstreamHandshake(int64_t nowMs) {
+    outgoing.clear();
+    ConnectionTokens::WriteRequest(outgoing);
+    lastHandshakeSendMs = nowMs;
+    // Non-blocking: a request that cannot go out now is covered by the retry
+    SendRaw(upstream, outgoing, upstreamAddress, upstreamPort);
+}
+
+void SpectatorRelay::SendUpstreamSubscribe(int64_t nowMs) {
+    SpectateMessage spectateMsg;
+    spectateMsg.roomId = roomId;
+    outgoing.clear();
+    outgoing << upstreamToken << spectateMsg;
+    lastSubscribeSendMs = nowMs;
+    SendRaw(upstream, outgoing, upstreamAddress, upstreamPort);
+}
+
+/**
+ * NotReady (a full send buffer on the non-blocking socket) drops the
+ * datagram like any other failure; the stats report carries the count.
+ */
+void SpectatorRelay::SendRaw(sf::UdpSocket& socket, const sf::Packet& datagram, const sf::IpAddress& address,
+    unsigned short port) {
+    const sf::Socket::Status status = socket.send(datagram.getData(), datagram.getDataSize(), address, port);
+    if (status != sf::Socket::Status::Done) {
+        if (failedSends == 0 && status != sf::Socket::Status::NotReady) {
+            LOG_MSG(warning, "Relay send to " + address.toString() + ":" + std::to_string(port) + " failed");
+        }
+        failedSends++;
+    }
+}
+
+void SpectatorRelay::ReportStats() {
+    const SpectatorStream::Stats& stats = stream.GetStats();
+    LOG_MSG(info, "=== RELAY STATS ===");
+    LOG_MSG(debug, "Upstream: " + std::string(upstreamToken != 0 ? "subscribed" : "handshaking") +
+        " - Forwarded: " + std::to_string(forwardedDatagrams) + " datagrams - Spectators: " +
+        std::to_string(stream.GetSpectatorCount()) + " - Sent: " +
+        std::to_string(stats.datagramsSent - reportedStats.datagramsSent) + " datagrams, " +
+        std::to_string((stats.bytesSent - reportedStats.bytesSent) / 1024) + " KB - Refused: " +
+        std::to_string(stats.subscriptionsRefused - reportedStats.subscriptionsRefused));
+    if (failedSends != 0) {
+        LOG_MSG(warning, "Relay sends failed: " + std::to_string(failedSends) + " datagrams dropped");
+    }
+    reportedStats = stats;
+    forwardedDatagrams = 0;
+    failedSends = 0;
+}
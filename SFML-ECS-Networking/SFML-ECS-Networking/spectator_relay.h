@@ -0,0 +1,75 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "connection_token.h"
+#include "spectator_stream.h"
+
+// Re-broadcasts one room's spectator stream, so an audience larger than the
+// server's direct spectator cap costs the server one subscriber per relay.
+// Upstream, the relay subscribes like any spectator (handshake, then a
+// SPECTATE_REQUEST every SpectatorStream::REFRESH_MS); downstream it speaks
+// the same handshake and subscription to its own spectators, who connect to
+// it as if it were the server. Upstream datagrams are forwarded byte for
+// byte with no further delay, and relays can be chained.
+class SpectatorRelay {
+public:
+    static constexpr unsigned short DEFAULT_PORT = 53200;
+    static constexpr size_t MAX_SPECTATORS = 1000;
+    static constexpr int64_t HANDSHAKE_RETRY_MS = 500;
+    static constexpr int SELECTOR_TIMEOUT_MS = 20;
+    static constexpr int64_t STATS_REPORT_MS = 10000;
+
+    SpectatorRelay(const sf::IpAddress& upstreamAddress, unsigned short upstreamPort, uint16_t roomId,
+        unsigned short listenPort = DEFAULT_PORT);
+    ~SpectatorRelay();
+
+    SpectatorRelay(const SpectatorRelay&) = delete;
+    SpectatorRelay& operator=(const SpectatorRelay&) = delete;
+
+    bool Initialize();
+
+    // Forwards pending upstream datagrams and answers spectators, waiting up
+    // to SELECTOR_TIMEOUT_MS for traffic
+    void Update();
+
+    void Shutdown();
+
+    bool IsRunning() const { return isRunning; }
+    size_t GetSpectatorCount() const { return stream.GetSpectatorCount(); }
+
+private:
+    sf::IpAddress upstreamAddress;
+    unsigned short upstreamPort;
+    uint16_t roomId;
+    unsigned short listenPort;
+    bool isRunning;
+
+    sf::UdpSocket upstream;             // To the server (or the next relay up)
+    sf::UdpSocket downstream;           // Bound to listenPort, serves spectators
+    sf::SocketSelector selector;
+    sf::Packet packet;                  // Receive buffer, reused
+    sf::Packet outgoing;
+
+    uint64_t upstreamToken;             // 0 until the upstream challenge arrived
+    int64_t lastHandshakeSendMs;
+    int64_t lastSubscribeSendMs;
+    int64_t lastUpstreamReceiveMs;
+
+    ConnectionTokens connectionTokens;
+    SpectatorStream stream;             // No delay: upstream already applied it
+    int64_t lastStatsReportMs;
+    SpectatorStream::Stats reportedStats;
+    uint64_t forwardedDatagrams;        // Since the last stats report
+    uint64_t failedSends;               // Since the last stats report, up and down
+
+    void ReceiveUpstream(int64_t nowMs);
+    void ReceiveDownstream(int64_t nowMs);
+    void HandleSpectator(const sf::IpAddress& address, unsigned short port, int64_t nowMs);
+    void UpdateSubscription(int64_t nowMs);
+    void SendUpstreamHandshake(int64_t nowMs);
+    void SendUpstreamSubscribe(int64_t nowMs);
+    // Raw send of the packet's bytes; a datagram that does not go out is counted
+    void SendRaw(sf::UdpSocket& socket, const sf::Packet& datagram, const sf::IpAddress& address, unsigned short port);
+    void ReportStats();
+};
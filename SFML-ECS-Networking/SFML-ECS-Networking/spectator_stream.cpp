@@ -0,0 +1,159 @@
+#include "spectator_stream.h"
+#include "logger.h"
+#include "utils.h"
+#include <algorithm>
+
+SpectatorStream::SpectatorStream()
+    : delayMs(DEFAULT_DELAY_MS), capacity(MAX_SPECTATORS), frameSequence(0), messageSequence(0),
+    streamedTableVersion(0), bulletsStreamed(false), keyframeRequested(false) {
+}
+
+void SpectatorStream::SetDelay(uint32_t delay) {
+    delayMs = std::min(delay, MAX_DELAY_MS);
+}
+
+bool SpectatorStream::Subscribe(sf::IpAddress address, unsigned short port, uint64_t connectionToken, int64_t nowMs) {
+    for (Spectator& spectator : spectators) {
+        if (spectator.address == address && spectator.port == port) {
+            spectator.connectionToken = connectionToken;
+            spectator.lastRefreshMs = nowMs;
+            return true;
+        }
+    }
+    if (spectators.size() >= capacity) {
+        stats.subscriptionsRefused++;
+        return false;
+    }
+    Spectator spectator;
+    spectator.address = address;
+    spectator.port = port;
+    spectator.connectionToken = connectionToken;
+    spectator.lastRefreshMs = nowMs;
+    spectators.push_back(spectator);
+    return true;
+}
+
+uint64_t SpectatorStream::FindToken(sf::IpAddress address, unsigned short port) const {
+    for (const Spectator& spectator : spectators) {
+        if (spectator.address == address && spectator.port == port) {
+            return spectator.connectionToken;
+        }
+    }
+    return 0;
+}
+
+bool SpectatorStream::NeedsPlayerTable(uint32_t tableVersion) const {
+    return keyframe.sequence == 0 || keyframeRequested || frameSequence + 1 - keyframe.sequence >= KEYFRAME_INTERVAL ||
+        tableVersion != streamedTableVersion;
+}
+
+/**
+ * Frame layout, in one aggregated run: the player table when due, the
+ * snapshot (a keyframe, or a delta against it), then the bullet list. The
+ * snapshot sequence doubles as the bullet list's, so both only move forward.
+ */
+void SpectatorStream::Publish(const WorldSnapshot& world, PlayerListMessage* playerTable,
+    const std::vector<BulletData>& bullets, int64_t nowMs) {
+    try {
+        const bool tableDue = NeedsPlayerTable(playerTable ? playerTable->tableVersion : streamedTableVersion);
+        const uint32_t sequence = ++frameSequence;
+        const bool isKeyframe = keyframe.sequence == 0 || keyframeRequested || sequence - keyframe.sequence >= KEYFRAME_INTERVAL;
+
+        if (tableDue && playerTable) {
+            playerTable->sequenceNumber = messageSequence++;
+            message.clear();
+            message << *playerTable;
+            frameOut.Queue(message);
+            streamedTableVersion = playerTable->tableVersion;
+        }
+
+        SnapshotHeader header;
+        header.snapshotSequence = sequence;
+        header.baselineSequence = isKeyframe ? 0 : keyframe.sequence;
+        header.timestamp = nowMs;
+        header.sequenceNumber = messageSequence++;
+        header.lastAckedInput = 0;
+        header.inputApplyMicros = 0;
+        writer.Reset();
+        if (SnapshotDelta::Write(writer, header, isKeyframe ? nullptr : &keyframe, world)) {
+            message.clear();
+            message << static_cast<uint8_t>(NetMessageType::GAME_STATE_DELTA);
+            writer.AppendTo(message);
+            frameOut.Queue(message);
+            if (isKeyframe) {
+                keyframe = world;
+                keyframe.sequence = sequence;
+                keyframeRequested = false;
+                stats.keyframesPublished++;
+            }
+        }
+        else {
+            LOG_MSG(warning, "Spectator snapshot exceeds " + std::to_string(BitWriter::MAX_BYTES) + " bytes, not sent");
+        }
+
+        if (!bullets.empty() || bulletsStreamed) {
+            bulletMessage.bullets = bullets;
+            bulletMessage.timestamp = nowMs;
+            bulletMessage.sequenceNumber = sequence;
+            writer.Reset();
+            NetworkUtils::Write(writer, bulletMessage);
+            if (!writer.HasOverflowed()) {
+                message.clear();
+                message << static_cast<uint8_t>(NetMessageType::BULLET_UPDATE);
+                writer.AppendTo(message);
+                frameOut.Queue(message);
+            }
+            bulletsStreamed = !bullets.empty();
+        }
+
+        stats.framesPublished++;
+        EndFrame(nowMs);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in SpectatorStream::Publish: " + std::string(e.what()), error);
+        frameOut.Clear();
+    }
+}
+
+void SpectatorStream::QueueDatagram(const sf::Packet& datagram, int64_t nowMs) {
+    PendingDatagram entry;
+    entry.releaseMs = nowMs + delayMs;
+    if (!spareDatagrams.empty()) {
+        entry.datagram = std::move(spareDatagrams.back());
+        spareDatagrams.pop_back();
+    }
+    entry.datagram.clear();
+    entry.datagram.append(datagram.getData(), datagram.getDataSize());
+    pending.push_back(std::move(entry));
+}
+
+/**
+ * Packs the frame's messages into datagrams and queues them for release
+ * after the delay.
+ */
+void SpectatorStream::EndFrame(int64_t nowMs) {
+    frameOut.Flush([&](sf::Packet& datagram) {
+        QueueDatagram(datagram, nowMs);
+        stats.datagramsEncoded++;
+        stats.bytesEncoded += datagram.getDataSize();
+    });
+}
+
+void SpectatorStream::ExpireSpectators(int64_t nowMs) {
+    spectators.erase(std::remove_if(spectators.begin(), spectators.end(), [nowMs](const Spectator& spectator) {
+        return nowMs - spectator.lastRefreshMs > SPECTATOR_TIMEOUT_MS;
+    }), spectators.end());
+}
+
+size_t SpectatorStream::GetApproximateBytes() const {
+    size_t bytes = sizeof(*this) + spectators.capacity() * sizeof(Spectator) +
+        keyframe.players.capacity() * sizeof(PlayerData) + keyframe.enemies.capacity() * sizeof(EnemyData) +
+        bulletMessage.bullets.capacity() * sizeof(BulletData);
+    for (const PendingDatagram& entry : pending) {
+        bytes += sizeof(entry) + entry.datagram.getDataSize();
+    }
+    for (const sf::Packet& datagram : spareDatagrams) {
+        bytes += sizeof(datagram) + datagram.getDataSize();
+    }
+    return bytes;
+}
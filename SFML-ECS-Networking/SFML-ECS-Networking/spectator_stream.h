@@ -0,0 +1,157 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "bit_stream.h"
+#include "network_messages.h"
+#include "packet_aggregator.h"
+#include "snapshot_delta.h"
+
+// One shared game stream per room for spectators. Each state tick the room's
+// world, player table and bullets are encoded once into datagrams, held back
+// by the stream delay (so watching gives nothing away to the players) and
+// then sent unchanged to every subscriber. The cost of a frame is one encode
+// plus one send per subscriber, with no per-spectator snapshots, interest or
+// acks.
+//
+// Spectators never ack, so a snapshot is a delta against the latest keyframe
+// (a full snapshot every KEYFRAME_INTERVAL frames) rather than against
+// something the receiver confirmed: a lost datagram costs only its own frame,
+// and a lost keyframe the frames up to the next one. The interval stays
+// under the client's SnapshotHistory so the keyframe is still there.
+//
+// A spectator subscribes with SPECTATE_REQUEST (after the usual connection
+// challenge) and repeats it every REFRESH_MS; one silent for
+// SPECTATOR_TIMEOUT_MS is dropped. Direct subscribers are capped, since each
+// costs a send on the simulation thread; large audiences go through
+// SpectatorRelay processes, each a single subscriber here that re-sends the
+// same datagrams to its own spectators.
+class SpectatorStream {
+public:
+    static constexpr uint32_t KEYFRAME_INTERVAL = SnapshotHistory::HISTORY_SIZE / 2;
+    static constexpr uint32_t DEFAULT_DELAY_MS = 2000;
+    static constexpr uint32_t MAX_DELAY_MS = 30000;
+    static constexpr size_t MAX_SPECTATORS = 64;                // Default cap on direct subscribers
+    static constexpr int64_t REFRESH_MS = 2000;
+    static constexpr int64_t SPECTATOR_TIMEOUT_MS = 10000;
+
+    struct Stats {
+        uint64_t framesPublished = 0;
+        uint64_t keyframesPublished = 0;
+        uint64_t datagramsEncoded = 0;
+        uint64_t bytesEncoded = 0;          // Encoded once, whatever the audience
+        uint64_t datagramsSent = 0;         // Fanned out: encoded datagrams x subscribers
+        uint64_t bytesSent = 0;
+        uint64_t subscriptionsRefused = 0;  // Stream full
+    };
+
+    SpectatorStream();
+
+    void SetDelay(uint32_t delayMs);
+    uint32_t GetDelay() const { return delayMs; }
+    void SetCapacity(size_t maxSpectators) { capacity = maxSpectators; }
+    size_t GetCapacity() const { return capacity; }
+
+    // Adds the endpoint or refreshes its subscription
+    // @return False if it is new and the stream is full
+    bool Subscribe(sf::IpAddress address, unsigned short port, uint64_t connectionToken, int64_t nowMs);
+    // Token the endpoint subscribed with, 0 if it is not subscribed
+    uint64_t FindToken(sf::IpAddress address, unsigned short port) const;
+    bool HasSpectators() const { return !spectators.empty(); }
+    size_t GetSpectatorCount() const { return spectators.size(); }
+
+    // True when the next frame carries the player table: a keyframe, or the
+    // table changed since it was last streamed. Lets the owner skip building it
+    bool NeedsPlayerTable(uint32_t tableVersion) const;
+
+    // Encodes one frame. playerTable may be null when NeedsPlayerTable is
+    // false (its sequence number is set here); bullets is the full list, sent
+    // while non-empty and once as it empties
+    void Publish(const WorldSnapshot& world, PlayerListMessage* playerTable,
+        const std::vector<BulletData>& bullets, int64_t nowMs);
+
+    // Makes the next frame a keyframe (a receiver that needs one right away)
+    void RequestKeyframe() { keyframeRequested = true; }
+    // Snapshot sequence of the last frame published (0 = none yet)
+    uint32_t GetFrameSequence() const { return frameSequence; }
+
+    // Queues an already encoded datagram (a relay forwarding upstream frames)
+    void QueueDatagram(const sf::Packet& datagram, int64_t nowMs);
+
+    // Hands every datagram whose delay has passed to send(packet, address, port)
+    // once per subscriber, then drops subscriptions that were not refreshed
+    template <typename SendFn>
+    void Release(int64_t nowMs, SendFn&& send);
+    // Hands every datagram whose delay has passed to send(packet, address, port)
+    // once, for a destination that stands for every receiver (a multicast
+    // group); subscriptions are not used
+    template <typename SendFn>
+    void ReleaseTo(int64_t nowMs, const sf::IpAddress& address, unsigned short port, SendFn&& send);
+
+    const Stats& GetStats() const { return stats; }
+    // Pending datagrams, spare buffers and the keyframe (see MemoryReport)
+    size_t GetApproximateBytes() const;
+
+private:
+    struct Spectator {
+        sf::IpAddress address = sf::IpAddress::Any;
+        unsigned short port = 0;
+        uint64_t connectionToken = 0;
+        int64_t lastRefreshMs = 0;
+    };
+
+    struct PendingDatagram {
+        int64_t releaseMs = 0;
+        sf::Packet datagram;
+    };
+
+    uint32_t delayMs;
+    size_t capacity;
+    std::vector<Spectator> spectators;
+    std::deque<PendingDatagram> pending;        // In release order
+    std::vector<sf::Packet> spareDatagrams;     // Released buffers, reused by the next frames
+    PacketAggregator frameOut;                  // Bundles and fragments one frame
+    BitWriter writer;
+    sf::Packet message;
+    BulletUpdateMessage bulletMessage;
+
+    WorldSnapshot keyframe;                     // Baseline of the frames since it
+    uint32_t frameSequence;                     // Snapshot sequence of the last frame (0 = none yet)
+    uint32_t messageSequence;
+    uint32_t streamedTableVersion;
+    bool bulletsStreamed;                       // Last frame listed bullets
+    bool keyframeRequested;
+    Stats stats;
+
+    void EndFrame(int64_t nowMs);
+    void ExpireSpectators(int64_t nowMs);
+};
+
+template <typename SendFn>
+void SpectatorStream::Release(int64_t nowMs, SendFn&& send) {
+    while (!pending.empty() && pending.front().releaseMs <= nowMs) {
+        sf::Packet& datagram = pending.front().datagram;
+        for (const Spectator& spectator : spectators) {
+            send(datagram, spectator.address, spectator.port);
+        }
+        stats.datagramsSent += spectators.size();
+        stats.bytesSent += spectators.size() * datagram.getDataSize();
+        spareDatagrams.push_back(std::move(datagram));
+        pending.pop_front();
+    }
+    ExpireSpectators(nowMs);
+}
+
+template <typename SendFn>
+void SpectatorStream::ReleaseTo(int64_t nowMs, const sf::IpAddress& address, unsigned short port, SendFn&& send) {
+    while (!pending.empty() && pending.front().releaseMs <= nowMs) {
+        sf::Packet& datagram = pending.front().datagram;
+        send(datagram, address, port);
+        stats.datagramsSent++;
+        stats.bytesSent += datagram.getDataSize();
+        spareDatagrams.push_back(std::move(datagram));
+        pending.pop_front();
+    }
+}
@@ -0,0 +1,158 @@
+#include "sprite_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+void SpriteBatch::SetSolidRegion(const sf::Texture* texture, const sf::IntRect& rect) {
+    solidTexture = texture;
+    solidTexCoords = sf::Vector2f(rect.position) + sf::Vector2f(rect.size) / 2.0f;
+}
+
+void SpriteBatch::Begin() {
+    staged.clear();
+    queue.clear();
+    textures.clear();
+    lastTexture = nullptr;
+    lastLayerTexture.fill(nullptr);
+    startedLayers = 0;
+    unsortedDrawCalls = 0;
+    prepared = false;
+}
+
+/**
+ * Corners are the texture rect in the sprite's local space, mapped through
+ * its transform; texture coordinates are the rect in pixels.
+ */
+void SpriteBatch::AddSprite(RenderLayer layer, const sf::Sprite& sprite) {
+    const sf::IntRect rect = sprite.getTextureRect();
+    const sf::Vector2f size(static_cast<float>(std::abs(rect.size.x)), static_cast<float>(std::abs(rect.size.y)));
+    const sf::Transform& transform = sprite.getTransform();
+
+    const sf::Vector2f texLeftTop(rect.position);
+    const sf::Vector2f texSize(rect.size);
+    AddQuad(layer, &sprite.getTexture(),
+        { transform.transformPoint({ 0.0f, 0.0f }), transform.transformPoint({ size.x, 0.0f }),
+          transform.transformPoint({ 0.0f, size.y }), transform.transformPoint(size) },
+        { texLeftTop, texLeftTop + sf::Vector2f(texSize.x, 0.0f),
+          texLeftTop + sf::Vector2f(0.0f, texSize.y), texLeftTop + texSize },
+        sprite.getColor());
+}
+
+void SpriteBatch::AddRect(RenderLayer layer, const sf::FloatRect& rect, sf::Color color) {
+    const sf::Vector2f leftTop = rect.position;
+    const sf::Vector2f rightBottom = rect.position + rect.size;
+    AddQuad(layer, solidTexture,
+        { leftTop, sf::Vector2f(rightBottom.x, leftTop.y), sf::Vector2f(leftTop.x, rightBottom.y), rightBottom },
+        { solidTexCoords, solidTexCoords, solidTexCoords, solidTexCoords },
+        color);
+}
+
+void SpriteBatch::AddTexturedRect(RenderLayer layer, const sf::Texture* texture, const sf::IntRect& textureRect,
+    const sf::FloatRect& rect, sf::Color color) {
+    const sf::Vector2f leftTop = rect.position;
+    const sf::Vector2f rightBottom = rect.position + rect.size;
+    const sf::Vector2f texLeftTop(textureRect.position);
+    const sf::Vector2f texRightBottom = texLeftTop + sf::Vector2f(textureRect.size);
+    AddQuad(layer, texture,
+        { leftTop, sf::Vector2f(rightBottom.x, leftTop.y), sf::Vector2f(leftTop.x, rightBottom.y), rightBottom },
+        { texLeftTop, sf::Vector2f(texRightBottom.x, texLeftTop.y), sf::Vector2f(texLeftTop.x, texRightBottom.y),
+          texRightBottom },
+        color);
+}
+
+void SpriteBatch::AddQuad(RenderLayer layer, const sf::Texture* texture, const std::array<sf::Vector2f, 4>& corners,
+    const std::array<sf::Vector2f, 4>& texCoords, sf::Color color) {
+    const size_t layerIndex = static_cast<size_t>(layer);
+    const uint32_t layerBit = 1u << layerIndex;
+    if (!(startedLayers & layerBit) || lastLayerTexture[layerIndex] != texture) {
+        startedLayers |= layerBit;
+        lastLayerTexture[layerIndex] = texture;
+        unsortedDrawCalls++;
+    }
+    queue.push_back(QueuedQuad{ static_cast<uint32_t>(layerIndex) << 16 | TextureSlot(texture),
+        static_cast<uint32_t>(staged.size()) });
+    // Left-top, right-top, left-bottom / right-top, right-bottom, left-bottom
+    static constexpr size_t ORDER[6] = { 0, 1, 2, 1, 3, 2 };
+    for (size_t corner : ORDER) {
+        staged.push_back(sf::Vertex{ corners[corner], color, texCoords[corner] });
+    }
+}
+
+/**
+ * Small per-frame IDs for textures, in order of first use, so a key fits in
+ * a few radix digits and runs come out in the order textures first appeared.
+ */
+uint32_t SpriteBatch::TextureSlot(const sf::Texture* texture) {
+    if (texture == lastTexture && !textures.empty()) {
+        return lastSlot;
+    }
+    auto it = std::find(textures.begin(), textures.end(), texture);
+    lastSlot = static_cast<uint32_t>(it - textures.begin());
+    if (it == textures.end()) {
+        textures.push_back(texture);
+    }
+    lastTexture = texture;
+    return lastSlot;
+}
+
+/**
+ * LSD radix sort of the keys, 8 bits a pass: texture slot, then layer. The
+ * slot's high byte only gets a pass when a frame used more than 256
+ * textures. Each pass is a stable counting sort.
+ */
+void SpriteBatch::SortQueue() {
+    sortScratch.resize(queue.size());
+    const int slotBytes = textures.size() > 256 ? 2 : 1;
+    const int shifts[3] = { 0, 8, 16 };
+    for (int pass = 0; pass < 3; ++pass) {
+        if (pass == 1 && slotBytes == 1) {
+            continue;
+        }
+        const int shift = shifts[pass];
+        std::array<uint32_t, 257> starts{};
+        for (const QueuedQuad& quad : queue) {
+            starts[((quad.key >> shift) & 0xFF) + 1]++;
+        }
+        for (size_t digit = 1; digit < starts.size(); ++digit) {
+            starts[digit] += starts[digit - 1];
+        }
+        for (const QueuedQuad& quad : queue) {
+            sortScratch[starts[(quad.key >> shift) & 0xFF]++] = quad;
+        }
+        queue.swap(sortScratch);
+    }
+}
+
+void SpriteBatch::Prepare() {
+    SortQueue();
+
+    // Copy the quads out in key order; a key change starts a run
+    vertices.clear();
+    runs.clear();
+    uint32_t runKey = 0;
+    for (const QueuedQuad& quad : queue) {
+        if (runs.empty() || quad.key != runKey) {
+            runKey = quad.key;
+            runs.push_back(Run{ textures[quad.key & 0xFFFF], vertices.size() });
+        }
+        vertices.insert(vertices.end(), staged.begin() + quad.firstVertex, staged.begin() + quad.firstVertex + 6);
+    }
+    prepared = true;
+}
+
+void SpriteBatch::Draw(sf::RenderTarget& target, sf::RenderStates states) {
+    if (!prepared) {
+        Prepare();
+    }
+    textureChanges = 0;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const Run& run = runs[i];
+        const size_t end = i + 1 < runs.size() ? runs[i + 1].firstVertex : vertices.size();
+        if (i == 0 || run.texture != runs[i - 1].texture) {
+            textureChanges++;
+        }
+        states.texture = run.texture;
+        target.draw(vertices.data() + run.firstVertex, end - run.firstVertex,
+            sf::PrimitiveType::Triangles, states);
+    }
+}
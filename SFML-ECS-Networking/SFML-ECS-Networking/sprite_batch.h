@@ -0,0 +1,90 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Draw layers, back to front
+enum class RenderLayer : uint8_t {
+    GROUND,
+    BODIES,             // Tank and enemy bodies
+    BARRELS,
+    BULLETS,
+    EFFECTS,            // Particles
+    UI,                 // Health bars
+    COUNT
+};
+
+// A render queue of transformed quads. Each quad is keyed by (layer, texture)
+// as it is submitted; Draw radix-sorts the keys once, so quads sharing a
+// texture within a layer are adjacent whatever order entities were visited
+// in, and issues one draw per run. The sort is stable: quads with the same
+// key keep their submission order. With the sprite atlas every layer is one
+// draw call; without it, one per texture per layer. Storage is kept across
+// frames, so steady frames do not allocate.
+class SpriteBatch {
+public:
+    static constexpr size_t LAYER_COUNT = static_cast<size_t>(RenderLayer::COUNT);
+
+    // Texture region of solid white used for untextured quads (AddRect);
+    // point it at the atlas so rects join the same run as sprites
+    void SetSolidRegion(const sf::Texture* texture, const sf::IntRect& rect);
+
+    // Clears the queue for a new frame
+    void Begin();
+
+    // The sprite's texture rect, transformed by its position/rotation/scale/origin
+    void AddSprite(RenderLayer layer, const sf::Sprite& sprite);
+    // Axis-aligned solid quad in world coordinates
+    void AddRect(RenderLayer layer, const sf::FloatRect& rect, sf::Color color);
+    // Axis-aligned quad showing textureRect of texture, tinted by color
+    void AddTexturedRect(RenderLayer layer, const sf::Texture* texture, const sf::IntRect& textureRect,
+        const sf::FloatRect& rect, sf::Color color);
+
+    // Sorts the queue into draw order. Touches no GPU state, so it may run on
+    // a worker with the Add calls; Draw prepares if this was not called.
+    void Prepare();
+    // One draw per run, layers in order
+    void Draw(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default);
+
+    // Last frame's totals (for the debug overlay). Texture changes count
+    // binds between consecutive draws; the unsorted count is the draws the
+    // quads would have taken in submission order.
+    size_t GetQuadCount() const { return queue.size(); }
+    size_t GetDrawCallCount() const { return runs.size(); }
+    size_t GetTextureChangeCount() const { return textureChanges; }
+    size_t GetUnsortedDrawCallCount() const { return unsortedDrawCalls; }
+
+private:
+    struct QueuedQuad {
+        uint32_t key;               // Layer << 16 | texture slot
+        uint32_t firstVertex;       // In staged
+    };
+    struct Run {
+        const sf::Texture* texture;
+        size_t firstVertex;
+    };
+
+    std::vector<sf::Vertex> staged;         // Two triangles per quad, in submission order
+    std::vector<QueuedQuad> queue;
+    std::vector<QueuedQuad> sortScratch;
+    std::vector<const sf::Texture*> textures;   // Slot -> texture, in order of first use this frame
+    const sf::Texture* lastTexture = nullptr;   // Slot of the previous quad, the usual hit
+    uint32_t lastSlot = 0;
+    std::vector<sf::Vertex> vertices;       // Sorted, drawn
+    std::vector<Run> runs;
+    std::array<const sf::Texture*, LAYER_COUNT> lastLayerTexture{};    // For the unsorted count
+    uint32_t startedLayers = 0;             // Bit per layer with a quad this frame
+    bool prepared = false;                  // vertices and runs hold this frame's queue
+    size_t unsortedDrawCalls = 0;
+    size_t textureChanges = 0;
+
+    const sf::Texture* solidTexture = nullptr;
+    sf::Vector2f solidTexCoords;        // Centre of the solid region
+
+    void AddQuad(RenderLayer layer, const sf::Texture* texture, const std::array<sf::Vector2f, 4>& corners,
+        const std::array<sf::Vector2f, 4>& texCoords, sf::Color color);
+    uint32_t TextureSlot(const sf::Texture* texture);
+    void SortQueue();
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded single-producer/single-consumer ring buffer.
+// Lock-free: one thread may call TryPush, one other thread may call TryPop.
+// Slots are preallocated and elements are swapped in and out rather than
+// moved, so any storage they own (packet buffers) circulates between the two
+// threads instead of being freed and reallocated on every push/pop.
+template <typename T, size_t Capacity>
+class SpscRingBuffer {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "SpscRingBuffer capacity must be a power of two");
+
+public:
+    SpscRingBuffer() : head(0), tail(0) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    // Producer side: returns false if the buffer is full (item is left untouched).
+    // On success item holds a spent element whose storage can be reused.
+    bool TryPush(T& item) {
+        const size_t currentTail = tail.load(std::memory_order_relaxed);
+        const size_t nextTail = (currentTail + 1) & MASK;
+        if (nextTail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        using std::swap;
+        swap(slots[currentTail], item);
+        tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: returns false if the buffer is empty.
+    // outItem's previous contents are handed back to the slot for the producer.
+    bool TryPop(T& outItem) {
+        const size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        using std::swap;
+        swap(outItem, slots[currentHead]);
+        head.store((currentHead + 1) & MASK, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a thread other than producer/consumer
+    bool IsEmpty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    // One slot is kept free to distinguish full from empty
+    static constexpr size_t GetCapacity() { return Capacity - 1; }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    std::array<T, Capacity> slots;
+    alignas(64) std::atomic<size_t> head;   // Next slot to read (consumer owned)
+    alignas(64) std::atomic<size_t> tail;   // Next slot to write (producer owned)
+};
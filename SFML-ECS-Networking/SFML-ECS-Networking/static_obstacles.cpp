@@ -0,0 +1,317 @@
+#include "static_obstacles.h"
+#include "utils.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    bool BoxLess(const StaticObstacles::Box& a, const StaticObstacles::Box& b) {
+        if (a.top != b.top) return a.top < b.top;
+        if (a.left != b.left) return a.left < b.left;
+        if (a.bottom != b.bottom) return a.bottom < b.bottom;
+        return a.right < b.right;
+    }
+
+    StaticObstacles::Box Grow(const StaticObstacles::Box& box, float amount) {
+        return { box.left - amount, box.top - amount, box.right + amount, box.bottom + amount };
+    }
+
+    /**
+     * Slab test of the segment from + t * delta, t in [0, limit], against a box.
+     * @return Entry t (0 when from is inside), or a negative value for a miss
+     */
+    float SegmentEntry(sf::Vector2f from, sf::Vector2f delta, const StaticObstacles::Box& box, float limit) {
+        float entry = 0.0f;
+        float exit = limit;
+        const float origin[2] = { from.x, from.y };
+        const float direction[2] = { delta.x, delta.y };
+        const float minimum[2] = { box.left, box.top };
+        const float maximum[2] = { box.right, box.bottom };
+        for (int axis = 0; axis < 2; ++axis) {
+            if (direction[axis] == 0.0f) {
+                if (origin[axis] < minimum[axis] || origin[axis] > maximum[axis]) {
+                    return -1.0f;
+                }
+                continue;
+            }
+            const float inverse = 1.0f / direction[axis];
+            float nearT = (minimum[axis] - origin[axis]) * inverse;
+            float farT = (maximum[axis] - origin[axis]) * inverse;
+            if (nearT > farT) std::swap(nearT, farT);
+            entry = std::max(entry, nearT);
+            exit = std::min(exit, farT);
+            if (entry > exit) {
+                return -1.0f;
+            }
+        }
+        return entry;
+    }
+
+    bool ParseKind(const std::string& text, StaticObstacles::Kind& kind) {
+        if (text == "wall") kind = StaticObstacles::Kind::WALL;
+        else if (text == "crate") kind = StaticObstacles::Kind::CRATE;
+        else return false;
+        return true;
+    }
+}
+
+void StaticObstacles::Build(std::vector<Obstacle> obstacleList) {
+    obstacles = std::move(obstacleList);
+    nodes.clear();
+    if (obstacles.empty()) {
+        return;
+    }
+    // Sorted first, so the same set gives the same tree whatever order it came in
+    std::sort(obstacles.begin(), obstacles.end(), [](const Obstacle& a, const Obstacle& b) {
+        return BoxLess(a.box, b.box);
+    });
+    nodes.reserve(2 * (obstacles.size() / LEAF_SIZE + 1));
+    BuildNode(0, static_cast<uint32_t>(obstacles.size()), 0);
+}
+
+void StaticObstacles::Clear() {
+    obstacles.clear();
+    nodes.clear();
+}
+
+/**
+ * Appends the node for obstacles [first, first + count) and, for an inner
+ * node, both subtrees after it. Splits at the median centre of the longer
+ * axis, so the tree stays balanced (depth about log2 of the leaf count).
+ * @return Index of the node
+ */
+uint32_t StaticObstacles::BuildNode(uint32_t first, uint32_t count, int depth) {
+    const uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    Box bounds = obstacles[first].box;
+    for (uint32_t i = first + 1; i < first + count; ++i) {
+        const Box& box = obstacles[i].box;
+        bounds.left = std::min(bounds.left, box.left);
+        bounds.top = std::min(bounds.top, box.top);
+        bounds.right = std::max(bounds.right, box.right);
+        bounds.bottom = std::max(bounds.bottom, box.bottom);
+    }
+    nodes[index].bounds = bounds;
+
+    if (count <= LEAF_SIZE || depth >= static_cast<int>(MAX_DEPTH) / 2) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+    }
+
+    const bool splitX = bounds.right - bounds.left >= bounds.bottom - bounds.top;
+    const auto begin = obstacles.begin() + first;
+    const uint32_t half = count / 2;
+    std::nth_element(begin, begin + half, begin + count, [splitX](const Obstacle& a, const Obstacle& b) {
+        const float centerA = splitX ? a.box.left + a.box.right : a.box.top + a.box.bottom;
+        const float centerB = splitX ? b.box.left + b.box.right : b.box.top + b.box.bottom;
+        return centerA != centerB ? centerA < centerB : BoxLess(a.box, b.box);
+    });
+
+    BuildNode(first, half, depth + 1);
+    const uint32_t second = BuildNode(first + half, count - half, depth + 1);
+    nodes[index].secondChild = second;
+    return index;
+}
+
+bool StaticObstacles::OverlapsCircle(sf::Vector2f center, float radius) const {
+    if (obstacles.empty()) {
+        return false;
+    }
+    bool overlaps = false;
+    const float radiusSq = radius * radius;
+    ForEachOverlapping(Box{ center.x - radius, center.y - radius, center.x + radius, center.y + radius },
+        [&](uint32_t i) {
+            const Box& box = obstacles[i].box;
+            const float dx = center.x - std::clamp(center.x, box.left, box.right);
+            const float dy = center.y - std::clamp(center.y, box.top, box.bottom);
+            overlaps = overlaps || dx * dx + dy * dy < radiusSq;
+        });
+    return overlaps;
+}
+
+/**
+ * Each pass collects the boxes the circle overlaps, sorts them by position
+ * and pushes the circle out of each in turn: along the line from the nearest
+ * point on the box, or out through the nearest edge when the centre is
+ * inside. A couple of passes settle a circle pressed into a corner.
+ */
+sf::Vector2f StaticObstacles::ResolveCircle(sf::Vector2f center, float radius) const {
+    if (obstacles.empty()) {
+        return center;
+    }
+    std::array<uint32_t, MAX_RESOLVE_CONTACTS> contacts;
+    for (int pass = 0; pass < RESOLVE_PASSES; ++pass) {
+        size_t contactCount = 0;
+        ForEachOverlapping(Box{ center.x - radius, center.y - radius, center.x + radius, center.y + radius },
+            [&](uint32_t i) {
+                if (contactCount < contacts.size()) {
+                    contacts[contactCount++] = i;
+                }
+            });
+        if (contactCount == 0) {
+            break;
+        }
+        std::sort(contacts.begin(), contacts.begin() + contactCount, [this](uint32_t a, uint32_t b) {
+            return BoxLess(obstacles[a].box, obstacles[b].box);
+        });
+
+        bool moved = false;
+        for (size_t c = 0; c < contactCount; ++c) {
+            const Box& box = obstacles[contacts[c]].box;
+            const sf::Vector2f nearest(std::clamp(center.x, box.left, box.right), std::clamp(center.y, box.top, box.bottom));
+            const sf::Vector2f offset = center - nearest;
+            const float distanceSq = offset.x * offset.x + offset.y * offset.y;
+            if (distanceSq >= radius * radius) {
+                continue;
+            }
+            if (distanceSq > 0.0f) {
+                center = nearest + offset * (radius / std::sqrt(distanceSq));
+            }
+            else {
+                const float toLeft = center.x - box.left;
+                const float toRight = box.right - center.x;
+                const float toTop = center.y - box.top;
+                const float toBottom = box.bottom - center.y;
+                const float nearestEdge = std::min(std::min(toLeft, toRight), std::min(toTop, toBottom));
+                if (nearestEdge == toLeft) center.x = box.left - radius;
+                else if (nearestEdge == toRight) center.x = box.right + radius;
+                else if (nearestEdge == toTop) center.y = box.top - radius;
+                else center.y = box.bottom + radius;
+            }
+            moved = true;
+        }
+        center.x = std::clamp(center.x, WorldConstants::PLAYABLE_MIN_X + radius, WorldConstants::PLAYABLE_MAX_X - radius);
+        center.y = std::clamp(center.y, WorldConstants::PLAYABLE_MIN_Y + radius, WorldConstants::PLAYABLE_MAX_Y - radius);
+        if (!moved) {
+            break;
+        }
+    }
+    return center;
+}
+
+bool StaticObstacles::SweepCircle(sf::Vector2f from, sf::Vector2f to, float radius, float& outFraction) const {
+    return Sweep(from, to, radius, false, outFraction);
+}
+
+bool StaticObstacles::Raycast(sf::Vector2f origin, sf::Vector2f direction, float maxDistance, float& outDistance) const {
+    float fraction = 1.0f;
+    if (!Sweep(origin, origin + direction * maxDistance, 0.0f, false, fraction)) {
+        return false;
+    }
+    outDistance = fraction * maxDistance;
+    return true;
+}
+
+bool StaticObstacles::HasLineOfSight(sf::Vector2f from, sf::Vector2f to) const {
+    float fraction = 1.0f;
+    return !Sweep(from, to, 0.0f, true, fraction);
+}
+
+/**
+ * Walks the tree along the segment, skipping nodes whose grown bounds it
+ * misses or only reaches after the nearest hit so far.
+ * @param anyHit Stop at the first hit found rather than the nearest
+ */
+bool StaticObstacles::Sweep(sf::Vector2f from, sf::Vector2f to, float radius, bool anyHit, float& outFraction) const {
+    if (nodes.empty()) {
+        return false;
+    }
+    const sf::Vector2f delta = to - from;
+    float best = 1.0f;
+    bool hit = false;
+
+    uint32_t stack[MAX_DEPTH];
+    size_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        const uint32_t index = stack[--depth];
+        const Node& node = nodes[index];
+        const float nodeEntry = SegmentEntry(from, delta, Grow(node.bounds, radius), best);
+        if (nodeEntry < 0.0f) {
+            continue;
+        }
+        if (node.count == 0) {
+            stack[depth++] = node.secondChild;
+            stack[depth++] = index + 1;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const float entry = SegmentEntry(from, delta, Grow(obstacles[i].box, radius), best);
+            if (entry >= 0.0f && (!hit || entry < best)) {
+                best = entry;
+                hit = true;
+                if (anyHit) {
+                    outFraction = best;
+                    return true;
+                }
+            }
+        }
+    }
+    if (hit) {
+        outFraction = best;
+    }
+    return hit;
+}
+
+bool StaticObstacles::LoadMap(const std::string& path, std::vector<Obstacle>& outObstacles) {
+    std::ifstream file(path);
+    if (!file) {
+        Utils::printMsg("Error: Could not open map " + path, error);
+        return false;
+    }
+    std::vector<Obstacle> loaded;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string kindName;
+        if (!(fields >> kindName) || kindName[0] == '#') {
+            continue;
+        }
+        Kind kind = Kind::WALL;
+        int left = 0, top = 0, width = 0, height = 0;
+        std::string extra;
+        const bool parsed = ParseKind(kindName, kind) && (fields >> left >> top >> width >> height) && !(fields >> extra);
+        if (!parsed || width <= 0 || height <= 0 ||
+            left < WorldConstants::PLAYABLE_MIN_X || top < WorldConstants::PLAYABLE_MIN_Y ||
+            left + width > WorldConstants::PLAYABLE_MAX_X || top + height > WorldConstants::PLAYABLE_MAX_Y) {
+            Utils::printMsg("Error: " + path + ":" + std::to_string(lineNumber) + ": invalid obstacle '" + line + "'", error);
+            return false;
+        }
+
+        // Pieces of whole pixels, none larger than MAX_OBSTACLE_SIZE
+        const int maxSize = static_cast<int>(MAX_OBSTACLE_SIZE);
+        const int columns = (width + maxSize - 1) / maxSize;
+        const int rows = (height + maxSize - 1) / maxSize;
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                Obstacle piece;
+                piece.kind = kind;
+                piece.box.left = static_cast<float>(left + width * column / columns);
+                piece.box.right = static_cast<float>(left + width * (column + 1) / columns);
+                piece.box.top = static_cast<float>(top + height * row / rows);
+                piece.box.bottom = static_cast<float>(top + height * (row + 1) / rows);
+                loaded.push_back(piece);
+            }
+        }
+    }
+    outObstacles = std::move(loaded);
+    return true;
+}
+
+const char* StaticObstacles::GetKindName(Kind kind) {
+    switch (kind) {
+    case Kind::WALL: return "wall";
+    case Kind::CRATE: return "crate";
+    default: return "unknown";
+    }
+}
+
+size_t StaticObstacles::GetApproximateBytes() const {
+    return sizeof(*this) + obstacles.capacity() * sizeof(Obstacle) + nodes.capacity() * sizeof(Node);
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "world_constants.h"
+
+// Static world geometry loaded with the map: walls and crates, as axis-aligned
+// boxes in a bounding volume hierarchy. Bullets (a sweep at spawn, see
+// ProjectilePool), tank movement (ResolveCircle after each step, on the
+// server and in client prediction) and enemy line of sight all query it.
+// Built once per map, or on a client whenever the streamed chunks change,
+// and read-only afterwards, so parallel enemy AI queries it without locking.
+//
+// The hierarchy is one array in depth-first order: an inner node's first
+// child follows it and the second is at secondChild. Leaves hold up to
+// LEAF_SIZE boxes, split at the median centre along the longer axis.
+//
+// Every query returns at once on an empty set, so a map without obstacles
+// behaves exactly as the open arena always has.
+class StaticObstacles {
+public:
+    enum class Kind : uint8_t { WALL, CRATE, COUNT };
+
+    struct Box {
+        float left = 0.0f;
+        float top = 0.0f;
+        float right = 0.0f;
+        float bottom = 0.0f;
+    };
+
+    struct Obstacle {
+        Box box;
+        Kind kind = Kind::WALL;
+    };
+
+    // Longer obstacles are split when the map is loaded, so everything that
+    // reaches into a chunk has its centre in that chunk or a neighbour (see
+    // world_chunks.h)
+    static constexpr float MAX_OBSTACLE_SIZE = WorldConstants::CHUNK_SIZE;
+
+    // Replaces the set and rebuilds the hierarchy
+    void Build(std::vector<Obstacle> obstacleList);
+    void Clear();
+
+    bool IsEmpty() const { return obstacles.empty(); }
+    // In hierarchy order
+    const std::vector<Obstacle>& GetObstacles() const { return obstacles; }
+
+    bool OverlapsCircle(sf::Vector2f center, float radius) const;
+
+    // Moves a circle out of every obstacle it overlaps and keeps it inside
+    // the playable area. Overlaps are resolved in a fixed order of the boxes
+    // themselves, so the server and a client holding only the nearby part of
+    // the map get the same answer.
+    sf::Vector2f ResolveCircle(sf::Vector2f center, float radius) const;
+
+    // First contact of a circle moving from -> to, as the fraction of the way
+    // in [0, 1] (0 when it starts overlapping). Boxes are grown by the radius,
+    // so contact at a corner comes slightly early.
+    bool SweepCircle(sf::Vector2f from, sf::Vector2f to, float radius, float& outFraction) const;
+    // Distance along a ray (direction normalized) to the first obstacle
+    bool Raycast(sf::Vector2f origin, sf::Vector2f direction, float maxDistance, float& outDistance) const;
+    bool HasLineOfSight(sf::Vector2f from, sf::Vector2f to) const;
+
+    // One obstacle per line: "wall|crate left top width height" in whole
+    // pixels. Blank lines and lines starting with # are skipped; obstacles
+    // larger than MAX_OBSTACLE_SIZE are split into pieces.
+    // @return False if the file could not be read or a line is invalid
+    static bool LoadMap(const std::string& path, std::vector<Obstacle>& outObstacles);
+    static const char* GetKindName(Kind kind);
+
+    size_t GetNodeCount() const { return nodes.size(); }
+    size_t GetApproximateBytes() const;
+
+private:
+    static constexpr uint32_t LEAF_SIZE = 4;
+    static constexpr int RESOLVE_PASSES = 3;       // Enough for a circle wedged into a corner
+    static constexpr size_t MAX_RESOLVE_CONTACTS = 16;
+    static constexpr size_t MAX_DEPTH = 64;        // Traversal stack; the tree is balanced
+
+    struct Node {
+        Box bounds;
+        uint32_t first = 0;         // Leaf: first obstacle
+        uint32_t count = 0;         // Leaf: obstacle count; 0 for inner nodes
+        uint32_t secondChild = 0;   // Inner node: index of the second child
+    };
+
+    std::vector<Obstacle> obstacles;
+    std::vector<Node> nodes;
+
+    uint32_t BuildNode(uint32_t first, uint32_t count, int depth);
+    bool Sweep(sf::Vector2f from, sf::Vector2f to, float radius, bool anyHit, float& outFraction) const;
+    // Indices of the obstacles whose box meets area
+    template <typename Visit>
+    void ForEachOverlapping(const Box& area, Visit&& visit) const;
+};
+
+template <typename Visit>
+void StaticObstacles::ForEachOverlapping(const Box& area, Visit&& visit) const {
+    if (nodes.empty()) {
+        return;
+    }
+    uint32_t stack[MAX_DEPTH];
+    size_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+        const uint32_t index = stack[--depth];
+        const Node& node = nodes[index];
+        if (node.bounds.right < area.left || node.bounds.left > area.right ||
+            node.bounds.bottom < area.top || node.bounds.top > area.bottom) {
+            continue;
+        }
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                const Box& box = obstacles[i].box;
+                if (box.right >= area.left && box.left <= area.right && box.bottom >= area.top && box.top <= area.bottom) {
+                    visit(i);
+                }
+            }
+        }
+        else {
+            stack[depth++] = node.secondChild;
+            stack[depth++] = index + 1;
+        }
+    }
+}
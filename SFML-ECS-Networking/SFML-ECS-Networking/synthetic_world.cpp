@@ -0,0 +1,207 @@
+#include "synthetic_world.h"
+#include "bullet_stats.h"
+#include "world_constants.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+const char* GetSimulationPhaseName(SimulationPhase phase) {
+    switch (phase) {
+    case SimulationPhase::ENEMIES: return "Enemies";
+    case SimulationPhase::BULLET_MOVEMENT: return "Bullet movement";
+    case SimulationPhase::BULLET_COLLISIONS: return "Bullet collisions";
+    case SimulationPhase::TANK_COLLISIONS: return "Tank collisions";
+    default: return "Unknown";
+    }
+}
+
+/**
+ * Builds the world: players first (IDs 1..playerCount), then enemies and
+ * bullets. Enemy spawning is switched off so only the top-up adds enemies.
+ */
+SyntheticWorld::SyntheticWorld(const SyntheticWorldConfig& config)
+    : config(config), random(config.seed) {
+    const float fraction = std::clamp(config.areaFraction, 0.01f, 1.0f);
+    const float halfWidth = WorldConstants::PLAYABLE_WIDTH * std::sqrt(fraction) * 0.5f;
+    const float halfHeight = WorldConstants::PLAYABLE_HEIGHT * std::sqrt(fraction) * 0.5f;
+    const float centerX = (WorldConstants::PLAYABLE_MIN_X + WorldConstants::PLAYABLE_MAX_X) * 0.5f;
+    const float centerY = (WorldConstants::PLAYABLE_MIN_Y + WorldConstants::PLAYABLE_MAX_Y) * 0.5f;
+    minX = std::max(centerX - halfWidth, WorldConstants::MOVEMENT_MIN_X);
+    maxX = std::min(centerX + halfWidth, WorldConstants::MOVEMENT_MAX_X);
+    minY = std::max(centerY - halfHeight, WorldConstants::MOVEMENT_MIN_Y);
+    maxY = std::min(centerY + halfHeight, WorldConstants::MOVEMENT_MAX_Y);
+
+    server.randomSeed = config.seed;
+    server.enemySpawnInterval = std::numeric_limits<float>::max();
+
+    AddPlayers();
+    TopUpEnemies();
+    TopUpBullets();
+}
+
+sf::Vector2f SyntheticWorld::RandomPosition() {
+    return sf::Vector2f(std::uniform_real_distribution<float>(minX, maxX)(random),
+        std::uniform_real_distribution<float>(minY, maxY)(random));
+}
+
+void SyntheticWorld::AddPlayers() {
+    for (uint32_t i = 0; i < config.playerCount; ++i) {
+        const unsigned short port = static_cast<unsigned short>(FIRST_PLAYER_PORT + i);
+        const uint32_t playerId = server.nextPlayerId++;
+        ClientInfo& client = server.clients.emplace(playerId, ClientInfo(sf::IpAddress::LocalHost, port)).first->second;
+        client.playerName = "Synthetic" + std::to_string(playerId);
+        server.AcquirePlayerSlot(client, playerId, static_cast<PlayerColor>(i % static_cast<uint32_t>(PlayerColor::COUNT)));
+
+        PlayerData& player = server.SimOf(client).player;
+        const sf::Vector2f position = RandomPosition();
+        player.x = position.x;
+        player.y = position.y;
+        player.health = 100.0f;
+        player.maxHealth = 100.0f;
+
+        server.clientsByEndpoint[GameServer::EndpointKey(client.address, port)] = playerId;
+    }
+    server.playerTableVersion++;
+}
+
+void SyntheticWorld::TopUpEnemies() {
+    while (server.GetEnemyCount() < config.enemyCount) {
+        RandomStream random = server.RandomFor(RandomPurpose::ENEMY_SPAWN, server.nextEnemyId);
+        server.SpawnEnemyAt(RandomPosition(), server.GetRandomEnemyType(random));
+    }
+}
+
+/**
+ * Fires bullets from random points in random directions until the pool holds
+ * bulletCount. Player bullets are owned by a random player (no players: all
+ * bullets belong to enemies), enemy bullets by the first enemy ID.
+ */
+void SyntheticWorld::TopUpBullets() {
+    std::uniform_real_distribution<float> angleDist(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> shareDist(0.0f, 1.0f);
+    while (server.projectiles.GetActiveCount() < config.bulletCount) {
+        const float angle = angleDist(random);
+        const bool enemyOwned = config.playerCount == 0 || shareDist(random) < config.enemyBulletShare;
+        const uint32_t ownerId = enemyOwned ? 1000 :
+            1 + std::uniform_int_distribution<uint32_t>(0, config.playerCount - 1)(random);
+        server.SpawnProjectile(server.nextBulletId++,
+            enemyOwned ? BulletStats::ENEMY_STANDARD : BulletStats::PLAYER_STANDARD,
+            RandomPosition(), sf::Vector2f(std::cos(angle), std::sin(angle)), ownerId,
+            enemyOwned ? CollisionLayers::ENEMY_BULLET : CollisionLayers::PLAYER_BULLET);
+    }
+}
+
+// Hits would otherwise kill every player within a few ticks and change the load
+void SyntheticWorld::RestorePlayers() {
+    for (auto& [playerId, client] : server.clients) {
+        PlayerSimState& sim = server.SimOf(client);
+        if (sim.player.health != sim.player.maxHealth || client.isDead) {
+            sim.player.health = sim.player.maxHealth;
+            sim.player.isDead = false;
+            client.isDead = false;
+            sim.dirtyFields |= SnapshotDelta::PLAYER_HEALTH | SnapshotDelta::PLAYER_DEAD;
+        }
+    }
+}
+
+// Destruction events queue reliably for players in view; nobody will ever ack them
+void SyntheticWorld::DiscardOutgoing() {
+    for (auto& [playerId, client] : server.clients) {
+        client.outgoing.Clear();
+        client.reliable.Reset();
+    }
+}
+
+SimulationTimings SyntheticWorld::Run(uint32_t tickCount, float deltaTime) {
+    using Clock = std::chrono::steady_clock;
+    SimulationTimings timings;
+    auto record = [&timings](SimulationPhase phase, Clock::time_point start) {
+        timings.totalNs[static_cast<size_t>(phase)] += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    };
+
+    for (uint32_t tick = 0; tick < tickCount; ++tick) {
+        server.AdvanceTimers();
+
+        Clock::time_point start = Clock::now();
+        server.UpdateEnemies(deltaTime);
+        record(SimulationPhase::ENEMIES, start);
+
+        start = Clock::now();
+        server.projectiles.Update(deltaTime);
+        server.ExpireProjectiles();
+        record(SimulationPhase::BULLET_MOVEMENT, start);
+
+        start = Clock::now();
+        server.RebuildTargetGrids();
+        if (server.lagCompensationEnabled) {
+            server.RecordEnemyPositionHistory(server.GetCurrentTimestamp());
+        }
+        server.CheckBulletCollisions();
+        server.RemoveDeadBullets();
+        record(SimulationPhase::BULLET_COLLISIONS, start);
+
+        start = Clock::now();
+        server.CheckServerSideCollisions(deltaTime);
+        record(SimulationPhase::TANK_COLLISIONS, start);
+
+        timings.ticks++;
+        // The next tick starts here: top-ups schedule their timers from it
+        server.firedTimers.clear();
+        server.tickNumber++;
+        DiscardOutgoing();
+        RestorePlayers();
+        TopUpEnemies();
+        TopUpBullets();
+    }
+    return timings;
+}
+
+ChurnTimings SyntheticWorld::RunChurn(uint32_t tickCount, uint32_t joinsPerTick, uint32_t sessionTicks, float deltaTime) {
+    using Clock = std::chrono::steady_clock;
+    ChurnTimings timings;
+    JoinMessage join;
+    for (uint32_t tick = 0; tick < tickCount; ++tick) {
+        const Clock::time_point start = Clock::now();
+        while (!churnedPlayers.empty() && churnedPlayers.front().leaveTick <= server.tickNumber) {
+            server.DropClient(churnedPlayers.front().playerId);
+            churnedPlayers.pop_front();
+            timings.leaves++;
+        }
+        for (uint32_t i = 0; i < joinsPerTick; ++i) {
+            const unsigned short port = static_cast<unsigned short>(FIRST_CHURN_PORT + churnJoins % CHURN_PORTS);
+            join.playerName = "Churn" + std::to_string(churnJoins++);
+            join.timestamp = server.GetCurrentTimestamp();
+            join.sequenceNumber = 1;
+            const uint32_t playerId = server.nextPlayerId;
+            server.HandleJoinRequest(join, 0, sf::IpAddress::LocalHost, port);
+            if (server.clients.count(playerId) != 0) {
+                churnedPlayers.push_back({ playerId, server.tickNumber + sessionTicks });
+                timings.joins++;
+            }
+        }
+        // As GameServer::Update's send
+        server.gameStateUpdateTimer += deltaTime;
+        if (server.gameStateUpdateTimer >= server.gameStateUpdateRate) {
+            server.SendGameStateToAll();
+            server.gameStateUpdateTimer = 0;
+        }
+        else if (!server.joinStatePending.empty()) {
+            server.SendJoinStates();
+        }
+        timings.tickMicros.Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count()));
+        timings.ticks++;
+
+        // Every player keeps sending, or snapshots would stop (see GameServer::SILENT_CLIENT_SECONDS)
+        for (auto& [playerId, client] : server.clients) {
+            client.lastHeardTick = server.tickNumber;
+        }
+        server.tickNumber++;
+        server.AdvanceTimers();
+        server.firedTimers.clear();
+        DiscardOutgoing();
+    }
+    return timings;
+}
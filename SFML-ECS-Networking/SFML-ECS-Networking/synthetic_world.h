@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <SFML/System/Vector2.hpp>
+#include "game_server.h"
+
+// Shape of a generated world. Everything is placed uniformly inside a region
+// covering areaFraction of the playable area (centered), so a smaller fraction
+// packs the same entities closer together.
+struct SyntheticWorldConfig {
+    uint32_t playerCount = 32;
+    uint32_t enemyCount = 50;
+    uint32_t bulletCount = 500;
+    float areaFraction = 1.0f;      // (0, 1]
+    float enemyBulletShare = 0.5f;  // Fraction of bullets owned by enemies
+    uint32_t seed = 12345;
+};
+
+// Simulation phases timed by SyntheticWorld
+enum class SimulationPhase : uint8_t {
+    ENEMIES,            // UpdateEnemies (AI, enemy shots, spawning off)
+    BULLET_MOVEMENT,    // ProjectilePool::Update
+    BULLET_COLLISIONS,  // CheckBulletCollisions + RemoveDeadBullets
+    TANK_COLLISIONS,    // CheckServerSideCollisions
+    COUNT
+};
+
+const char* GetSimulationPhaseName(SimulationPhase phase);
+
+struct SimulationTimings {
+    std::array<uint64_t, static_cast<size_t>(SimulationPhase::COUNT)> totalNs{};
+    uint32_t ticks = 0;
+
+    double GetNsPerTick(SimulationPhase phase) const {
+        return ticks > 0 ? static_cast<double>(totalNs[static_cast<size_t>(phase)]) / ticks : 0.0;
+    }
+};
+
+// Result of SyntheticWorld::RunChurn
+struct ChurnTimings {
+    LatencyHistogram tickMicros;    // Leaves, joins and the state send of each tick
+    uint32_t joins = 0;
+    uint32_t leaves = 0;
+    uint32_t ticks = 0;
+};
+
+// A GameServer world built in memory, without sockets or clients: players are
+// added straight to the client table, enemies and bullets at random positions.
+// Run steps the simulation phases of GameServer::Update in order and times
+// each one. Between ticks (untimed) the world is topped back up to its
+// configured counts and players are healed, so every tick sees the same load.
+// The same config and seed give the same world.
+class SyntheticWorld {
+public:
+    explicit SyntheticWorld(const SyntheticWorldConfig& config);
+
+    SimulationTimings Run(uint32_t tickCount, float deltaTime);
+
+    // Player churn on top of the configured players: joinsPerTick players join
+    // through the server's join handler every tick and each leaves the way a
+    // timed-out client does sessionTicks later. The leaves, joins and the
+    // state send (every snapshot interval, join replies in between) are timed
+    // together per tick; the simulation is not stepped. Churned players stay
+    // across calls, so a first call can serve as the warm-up.
+    ChurnTimings RunChurn(uint32_t tickCount, uint32_t joinsPerTick, uint32_t sessionTicks, float deltaTime);
+
+    size_t GetEnemyCount() { return server.GetEnemyCount(); }
+    size_t GetBulletCount() const { return server.projectiles.GetActiveCount(); }
+
+private:
+    static constexpr unsigned short FIRST_PLAYER_PORT = 40000;    // Never bound; endpoints only
+    static constexpr unsigned short FIRST_CHURN_PORT = 50000;
+    static constexpr unsigned short CHURN_PORTS = 10000;       // Reused in turn; far more than are ever connected
+
+    SyntheticWorldConfig config;
+    GameServer server;      // Never initialized
+    std::mt19937 random;
+    float minX, maxX, minY, maxY;
+
+    struct ChurnedPlayer {
+        uint32_t playerId;
+        uint64_t leaveTick;
+    };
+    std::deque<ChurnedPlayer> churnedPlayers;   // In join order, so leave order too
+    uint32_t churnJoins = 0;
+
+    sf::Vector2f RandomPosition();
+    void AddPlayers();
+    void TopUpEnemies();
+    void TopUpBullets();
+    void RestorePlayers();
+    void DiscardOutgoing();
+};
@@ -0,0 +1,141 @@
+#include "tank_batch.h"
+#include "utils.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace {
+    // GLSL 1.10, as SFML's own pipeline. The texture matrix SFML sets maps
+    // pixel coordinates to normalised ones. Array lengths are MAX_PARTS.
+    const char* const VERTEX_SHADER = R"(
+#version 110
+uniform vec4 partRects[32];         // left, top, width, height in pixels
+uniform vec4 partPlacements[32];    // origin x, y, scale x, y
+void main() {
+    float cornerIndex = floor(gl_Color.r * 255.0 + 0.5);
+    vec2 corner = vec2(mod(cornerIndex, 2.0), floor(cornerIndex / 2.0));
+    int part = int(gl_MultiTexCoord0.y + 0.5);
+    vec4 rect = partRects[part];
+    vec4 placement = partPlacements[part];
+    vec2 local = (corner * abs(rect.zw) - placement.xy) * placement.zw;
+    float s = sin(gl_MultiTexCoord0.x);
+    float c = cos(gl_MultiTexCoord0.x);
+    vec2 world = gl_Vertex.xy + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(world, 0.0, 1.0);
+    gl_TexCoord[0] = gl_TextureMatrix[0] * vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
+    gl_FrontColor = vec4(1.0);
+}
+)";
+
+    const char* const FRAGMENT_SHADER = R"(
+#version 110
+uniform sampler2D texture;
+void main() {
+    gl_FragColor = texture2D(texture, gl_TexCoord[0].xy) * gl_Color;
+}
+)";
+}
+
+bool TankBatch::Initialize() {
+    shaderLoaded = false;
+    if (!sf::Shader::isAvailable()) {
+        Utils::printMsg("Shaders unavailable, tanks are drawn as sprites", warning);
+        return false;
+    }
+    if (!shader.loadFromMemory(VERTEX_SHADER, FRAGMENT_SHADER)) {
+        Utils::printMsg("Tank shader failed to compile, tanks are drawn as sprites", warning);
+        return false;
+    }
+    shader.setUniform("texture", sf::Shader::CurrentTexture);
+    shaderLoaded = true;
+    partsChanged = true;
+    return true;
+}
+
+void TankBatch::Begin() {
+    vertices.clear();
+    barrels.clear();
+    tankCount = 0;
+}
+
+bool TankBatch::AddTank(const sf::Sprite& body, const sf::Sprite& barrel, sf::Vector2f position,
+    sf::Angle bodyRotation, sf::Angle barrelRotation) {
+    if (!shaderLoaded || !enabled) {
+        return false;
+    }
+    const int bodyPart = FindPart(body);
+    const int barrelPart = FindPart(barrel);
+    if (bodyPart < 0 || barrelPart < 0) {
+        return false;
+    }
+    AddQuad(vertices, position, bodyRotation, bodyPart);
+    AddQuad(barrels, position, barrelRotation, barrelPart);
+    tankCount++;
+    return true;
+}
+
+/**
+ * Bodies and barrels go up as one array, so the barrels are copied behind
+ * the bodies here; the part table is uploaded only when it grew.
+ */
+void TankBatch::Draw(sf::RenderTarget& target) {
+    if (tankCount == 0) {
+        return;
+    }
+    if (partsChanged) {
+        std::array<sf::Glsl::Vec4, MAX_PARTS> rects{};
+        std::array<sf::Glsl::Vec4, MAX_PARTS> placements{};
+        for (size_t i = 0; i < parts.size(); i++) {
+            const Part& part = parts[i];
+            rects[i] = sf::Glsl::Vec4(static_cast<float>(part.rect.position.x), static_cast<float>(part.rect.position.y),
+                static_cast<float>(part.rect.size.x), static_cast<float>(part.rect.size.y));
+            placements[i] = sf::Glsl::Vec4(part.origin.x, part.origin.y, part.scale.x, part.scale.y);
+        }
+        shader.setUniformArray("partRects", rects.data(), rects.size());
+        shader.setUniformArray("partPlacements", placements.data(), placements.size());
+        partsChanged = false;
+    }
+    vertices.insert(vertices.end(), barrels.begin(), barrels.end());
+    sf::RenderStates states;
+    states.texture = texture;
+    states.shader = &shader;
+    target.draw(vertices.data(), vertices.size(), sf::PrimitiveType::Triangles, states);
+}
+
+/**
+ * A linear search: a handful of parts (two per tank colour) in use at once.
+ * @return Index of the sprite's part, added if new; -1 if it cannot be drawn here
+ */
+int TankBatch::FindPart(const sf::Sprite& sprite) {
+    const sf::Texture* spriteTexture = &sprite.getTexture();
+    if (texture && spriteTexture != texture) {
+        return -1;
+    }
+    const sf::IntRect rect = sprite.getTextureRect();
+    const sf::Vector2f origin = sprite.getOrigin();
+    const sf::Vector2f scale = sprite.getScale();
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (parts[i].rect == rect && parts[i].origin == origin && parts[i].scale == scale) {
+            return static_cast<int>(i);
+        }
+    }
+    if (parts.size() >= MAX_PARTS) {
+        return -1;
+    }
+    texture = spriteTexture;
+    parts.push_back({ rect, origin, scale });
+    partsChanged = true;
+    return static_cast<int>(parts.size() - 1);
+}
+
+/**
+ * Two triangles, corners left-top, right-top, left-bottom, right-bottom as
+ * in the SpriteBatch; only the corner index differs between the vertices.
+ */
+void TankBatch::AddQuad(std::vector<sf::Vertex>& target, sf::Vector2f position, sf::Angle rotation, int part) {
+    static constexpr std::array<uint8_t, 6> CORNERS{ 0, 1, 2, 2, 1, 3 };
+    const sf::Vector2f instance(rotation.asRadians(), static_cast<float>(part));
+    for (uint8_t corner : CORNERS) {
+        target.push_back({ position, sf::Color(corner, 255, 255, 255), instance });
+    }
+}
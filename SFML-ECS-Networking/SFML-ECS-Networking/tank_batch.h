@@ -0,0 +1,62 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+// Draws every tank, body and barrel, from one vertex array in one draw.
+// Instead of placing two sprites per tank on the CPU (a transform each, four
+// corners through it), a tank is its position, two angles and two part
+// indices, and a vertex shader expands and rotates the quads. Each vertex of
+// a quad carries the same instance data:
+//   position   tank centre in world coordinates
+//   texCoords  (rotation in radians, part index)
+//   color.r    which corner of the quad (0 to 3)
+// A part is a texture rect with its origin and scale, registered the first
+// time a sprite with it is added; the shader reads them from uniform arrays.
+// All parts must come from one texture (the sprite atlas). Bodies are drawn
+// before barrels, as the BODIES and BARRELS layers of the SpriteBatch were.
+class TankBatch {
+public:
+    static constexpr size_t MAX_PARTS = 32;     // Uniform array length
+
+    // Compiles the shader; needs the window's GL context. False without
+    // shader support, and every AddTank then fails.
+    bool Initialize();
+    bool IsAvailable() const { return shaderLoaded; }
+    void SetEnabled(bool enable) { enabled = enable; }
+    bool IsEnabled() const { return enabled; }
+
+    // Clears the tanks for a new frame
+    void Begin();
+    // Queues a tank drawn with the body and barrel sprites' texture rects,
+    // origins and scales (not their positions or rotations). False when it
+    // was not queued: disabled, no shader, the part table is full or a
+    // sprite is on another texture. Submit it to the SpriteBatch instead.
+    // Touches no GPU state, so it may run on the render prepare worker.
+    bool AddTank(const sf::Sprite& body, const sf::Sprite& barrel, sf::Vector2f position,
+        sf::Angle bodyRotation, sf::Angle barrelRotation);
+    void Draw(sf::RenderTarget& target);
+
+    // Last frame's tanks (for the debug overlay)
+    size_t GetTankCount() const { return tankCount; }
+
+private:
+    struct Part {
+        sf::IntRect rect;
+        sf::Vector2f origin;
+        sf::Vector2f scale;
+    };
+
+    sf::Shader shader;
+    bool shaderLoaded = false;
+    bool enabled = true;
+    bool partsChanged = false;          // Uniforms to upload before the next draw
+    const sf::Texture* texture = nullptr;   // Of the first part; every part shares it
+    std::vector<Part> parts;
+    std::vector<sf::Vertex> vertices;   // Bodies, then barrels appended by Draw
+    std::vector<sf::Vertex> barrels;
+    size_t tankCount = 0;
+
+    int FindPart(const sf::Sprite& sprite);
+    static void AddQuad(std::vector<sf::Vertex>& target, sf::Vector2f position, sf::Angle rotation, int part);
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include "world_constants.h"
+
+// The one player tank movement step, shared by the server simulation, client
+// prediction and reconciliation replay, and Tank::Update. Server and client
+// must produce the same transform for the same input or every step is a
+// misprediction, so everything here is plain float math that is identical on
+// every compiler and platform: sine and cosine are a fixed polynomial rather
+// than the C library's, whose last bits differ between implementations.
+// All of it is constexpr, so the checks at the bottom run at compile time.
+namespace TankMovement {
+    constexpr float MOVEMENT_SPEED = 150.0f;    // Pixels per second
+    constexpr float ROTATION_SPEED = 200.0f;    // Degrees per second
+
+    struct Input {
+        bool forward = false;
+        bool backward = false;
+        bool left = false;
+        bool right = false;
+    };
+
+    struct Transform {
+        float x = 0.0f;
+        float y = 0.0f;
+        float rotationDegrees = 0.0f;   // [0, 360)
+    };
+
+    constexpr double PI = 3.14159265358979323846;
+
+    // sin over any finite angle: reduced to [-pi/2, pi/2], then Taylor to x^15
+    // (error below 1e-9 there, far under float precision)
+    constexpr float Sin(float radians) {
+        double x = static_cast<double>(radians);
+        const double turns = x / (2.0 * PI);
+        x -= 2.0 * PI * static_cast<double>(static_cast<long long>(turns < 0.0 ? turns - 0.5 : turns + 0.5));
+        if (x > PI / 2.0) {
+            x = PI - x;
+        }
+        else if (x < -PI / 2.0) {
+            x = -PI - x;
+        }
+        const double x2 = x * x;
+        double term = x;
+        double sum = x;
+        for (int n = 1; n <= 7; ++n) {
+            term *= -x2 / static_cast<double>((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return static_cast<float>(sum);
+    }
+
+    constexpr float Cos(float radians) {
+        return Sin(static_cast<float>(static_cast<double>(radians) + PI / 2.0));
+    }
+
+    // [0, 360); non-finite or absurd angles reset to 0
+    constexpr float WrapDegrees(float degrees) {
+        if (!(degrees > -36000.0f && degrees < 36000.0f)) {
+            return 0.0f;
+        }
+        while (degrees < 0.0f) {
+            degrees += 360.0f;
+        }
+        while (degrees >= 360.0f) {
+            degrees -= 360.0f;
+        }
+        return degrees;
+    }
+
+    constexpr float ClampMovement(float value, float minimum, float maximum) {
+        return value < minimum ? minimum : (value > maximum ? maximum : value);
+    }
+
+    /**
+     * Turns (left wins over right), then drives along the new heading (forward
+     * wins over backward), then keeps the tank center inside the movement bounds.
+     */
+    constexpr Transform Step(Transform transform, const Input& input, float deltaTime) {
+        if (input.left) {
+            transform.rotationDegrees -= ROTATION_SPEED * deltaTime;
+        }
+        else if (input.right) {
+            transform.rotationDegrees += ROTATION_SPEED * deltaTime;
+        }
+        transform.rotationDegrees = WrapDegrees(transform.rotationDegrees);
+
+        const float radians = static_cast<float>(static_cast<double>(transform.rotationDegrees) * (PI / 180.0));
+        const float dirX = Cos(radians);
+        const float dirY = Sin(radians);
+        if (input.forward) {
+            transform.x += dirX * MOVEMENT_SPEED * deltaTime;
+            transform.y += dirY * MOVEMENT_SPEED * deltaTime;
+        }
+        else if (input.backward) {
+            transform.x -= dirX * MOVEMENT_SPEED * deltaTime;
+            transform.y -= dirY * MOVEMENT_SPEED * deltaTime;
+        }
+
+        transform.x = ClampMovement(transform.x, WorldConstants::MOVEMENT_MIN_X, WorldConstants::MOVEMENT_MAX_X);
+        transform.y = ClampMovement(transform.y, WorldConstants::MOVEMENT_MIN_Y, WorldConstants::MOVEMENT_MAX_Y);
+        return transform;
+    }
+
+    // Compile-time checks of the kernel
+    namespace Checks {
+        constexpr bool Near(float a, float b, float tolerance) {
+            return a - b <= tolerance && b - a <= tolerance;
+        }
+
+        constexpr Transform Run(Transform start, const Input& input, float deltaTime, int steps) {
+            for (int i = 0; i < steps; ++i) {
+                start = Step(start, input, deltaTime);
+            }
+            return start;
+        }
+
+        constexpr Transform CENTER{ WorldConstants::CENTER_X, WorldConstants::CENTER_Y, 0.0f };
+        constexpr Input FORWARD{ true, false, false, false };
+        constexpr Input FORWARD_RIGHT{ true, false, false, true };
+        constexpr Input ALL_KEYS{ true, true, true, true };
+
+        static_assert(Near(Sin(0.0f), 0.0f, 1e-7f) && Near(Cos(0.0f), 1.0f, 1e-7f));
+        static_assert(Near(Sin(static_cast<float>(PI / 6.0)), 0.5f, 1e-6f));
+        static_assert(Near(Cos(static_cast<float>(PI)), -1.0f, 1e-6f));
+        static_assert(Near(Sin(static_cast<float>(-7.0 * PI / 2.0)), 1.0f, 1e-6f));
+
+        static_assert(WrapDegrees(-10.0f) == 350.0f && WrapDegrees(725.0f) == 5.0f && WrapDegrees(360.0f) == 0.0f);
+
+        // One second forward at 60 Hz covers MOVEMENT_SPEED along +x
+        static_assert(Near(Run(CENTER, FORWARD, 1.0f / 60.0f, 60).x - CENTER.x, MOVEMENT_SPEED, 0.01f));
+        static_assert(Run(CENTER, FORWARD, 1.0f / 60.0f, 60).y == CENTER.y);
+
+        // Holding every key: left and forward win, as on the server
+        static_assert(Near(Step(CENTER, ALL_KEYS, 0.1f).rotationDegrees, 340.0f, 1e-4f));
+
+        // Circling stays inside [0, 360) and a long drive stops at the bounds
+        static_assert(Run(CENTER, FORWARD_RIGHT, 1.0f / 60.0f, 600).rotationDegrees < 360.0f);
+        static_assert(Run(CENTER, FORWARD, 1.0f / 60.0f, 600).x == WorldConstants::MOVEMENT_MAX_X);
+
+        // Same input and start, same result: the property prediction relies on
+        static_assert(Run(CENTER, FORWARD_RIGHT, 1.0f / 128.0f, 300).x == Run(CENTER, FORWARD_RIGHT, 1.0f / 128.0f, 300).x);
+    }
+}
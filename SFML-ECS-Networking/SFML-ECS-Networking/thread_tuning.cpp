@@ -0,0 +1,189 @@
+#include "thread_tuning.h"
+#include "utils.h"
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Written by Configure before the server threads start, read-only afterwards
+    ThreadTuning configured;
+
+#ifdef __linux__
+    constexpr int RAISED_NICE = -10;
+#endif
+
+    const char* RoleName(ThreadRole role) {
+        switch (role) {
+        case ThreadRole::SIMULATION: return "simulation";
+        case ThreadRole::IO: return "I/O";
+        default: return "worker";
+        }
+    }
+
+    std::string JoinCores(const std::vector<unsigned int>& cores) {
+        std::string text;
+        for (unsigned int core : cores) {
+            text += (text.empty() ? "" : ",") + std::to_string(core);
+        }
+        return text;
+    }
+}
+
+bool ThreadTuning::ParseCores(const std::string& text, std::vector<unsigned int>& cores) {
+    const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> parsed;
+    std::stringstream stream(text);
+    std::string field;
+    try {
+        while (std::getline(stream, field, ',')) {
+            size_t used = 0;
+            const unsigned long core = std::stoul(field, &used);
+            if (used != field.size() || core >= hardwareThreads) {
+                return false;
+            }
+            parsed.push_back(static_cast<unsigned int>(core));
+        }
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    if (parsed.empty()) {
+        return false;
+    }
+    cores = parsed;
+    return true;
+}
+
+std::string ThreadTuning::Describe() const {
+    if (IsDefault()) {
+        return "OS placement, normal priority";
+    }
+    std::string text = "simulation cores " + (simulationCores.empty() ? std::string("any") : JoinCores(simulationCores)) +
+        ", I/O cores " + (ioCores.empty() ? std::string("any") : JoinCores(ioCores));
+    return text + (highPriority ? ", high priority" : ", normal priority");
+}
+
+void ThreadTuner::Configure(const ThreadTuning& tuning) {
+    configured = tuning;
+}
+
+const ThreadTuning& ThreadTuner::GetTuning() {
+    return configured;
+}
+
+/**
+ * Workers are only moved when some core is reserved, so the default leaves
+ * every thread where the OS put it.
+ */
+bool ThreadTuner::ApplyToCurrentThread(ThreadRole role, size_t index) {
+    if (role == ThreadRole::WORKER) {
+        std::vector<unsigned int> reserved = configured.simulationCores;
+        reserved.insert(reserved.end(), configured.ioCores.begin(), configured.ioCores.end());
+        if (reserved.empty()) {
+            return true;
+        }
+        if (!PinCurrentThreadExcept(reserved)) {
+            Utils::printMsg("Could not keep a worker thread off cores " + JoinCores(reserved), warning);
+            return false;
+        }
+        return true;
+    }
+
+    bool applied = true;
+    const std::vector<unsigned int>& cores = role == ThreadRole::SIMULATION ? configured.simulationCores : configured.ioCores;
+    if (!cores.empty()) {
+        const unsigned int core = cores[index % cores.size()];
+        if (!PinCurrentThread(core)) {
+            Utils::printMsg("Could not pin " + std::string(RoleName(role)) + " thread " + std::to_string(index) +
+                " to core " + std::to_string(core), warning);
+            applied = false;
+        }
+    }
+    if (configured.highPriority && !RaiseCurrentThreadPriority()) {
+        Utils::printMsg("Could not raise the priority of " + std::string(RoleName(role)) + " thread " +
+            std::to_string(index) + " (Linux needs CAP_SYS_NICE or a nice rlimit)", warning);
+        applied = false;
+    }
+    return applied;
+}
+
+bool ThreadTuner::PinCurrentThread(unsigned int core) {
+#ifdef _WIN32
+    if (core >= sizeof(DWORD_PTR) * 8) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+/**
+ * Allows every hardware thread except excludedCores.
+ * @return False if that leaves none
+ */
+bool ThreadTuner::PinCurrentThreadExcept(const std::vector<unsigned int>& excludedCores) {
+    const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    auto isExcluded = [&](unsigned int core) {
+        return std::find(excludedCores.begin(), excludedCores.end(), core) != excludedCores.end();
+    };
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (unsigned int core = 0; core < hardwareThreads && core < sizeof(DWORD_PTR) * 8; ++core) {
+        if (!isExcluded(core)) {
+            mask |= static_cast<DWORD_PTR>(1) << core;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool any = false;
+    for (unsigned int core = 0; core < hardwareThreads && core < CPU_SETSIZE; ++core) {
+        if (!isExcluded(core)) {
+            CPU_SET(core, &set);
+            any = true;
+        }
+    }
+    return any && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)isExcluded;
+    return false;
+#endif
+}
+
+/**
+ * Windows: highest priority within the process's class. Linux: a negative
+ * nice value for this thread only (nice is per thread there); real-time
+ * scheduling is avoided because the tick wait spins for its last stretch.
+ */
+bool ThreadTuner::RaiseCurrentThreadPriority() {
+#ifdef _WIN32
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST) != 0;
+#elif defined(__linux__)
+    const id_t threadId = static_cast<id_t>(syscall(SYS_gettid));
+    return setpriority(PRIO_PROCESS, threadId, RAISED_NICE) == 0;
+#else
+    return false;
+#endif
+}
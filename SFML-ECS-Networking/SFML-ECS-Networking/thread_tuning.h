@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a server thread does, which decides where ThreadTuning places it
+enum class ThreadRole : uint8_t {
+    SIMULATION,     // Ticks a GameServer (the server loop, room workers)
+    IO,             // Socket receive/send (network thread, router, ingress shards)
+    WORKER          // Everything else: job workers, snapshot sends, logging, capture
+};
+
+// Core pinning and priority for the server's latency-critical threads, so
+// other load on a shared host does not delay ticks. Simulation and I/O
+// threads are pinned to the listed cores (index i of a role takes core
+// i % count) and, with highPriority, run above normal priority; on Windows
+// that also paces ticks with a high-resolution waitable timer. Worker threads
+// are kept off every listed core. The default changes nothing.
+// Tick start lateness (TickStats) shows the effect of each setting.
+struct ThreadTuning {
+    std::vector<unsigned int> simulationCores;
+    std::vector<unsigned int> ioCores;
+    bool highPriority = false;
+
+    bool IsDefault() const { return simulationCores.empty() && ioCores.empty() && !highPriority; }
+
+    // "2" or "2,3" (core indices below the hardware thread count). Returns
+    // false, leaving cores untouched, if the text does not parse.
+    static bool ParseCores(const std::string& text, std::vector<unsigned int>& cores);
+    std::string Describe() const;
+};
+
+namespace ThreadTuner {
+    // Process-wide tuning; set before the server starts its threads
+    void Configure(const ThreadTuning& tuning);
+    const ThreadTuning& GetTuning();
+
+    // Places the calling thread as its role asks; index picks among the role's
+    // cores. Threads call this once at startup, after TraceRecorder::SetThreadName.
+    // @return False (after a warning) if a placement was asked for and failed
+    bool ApplyToCurrentThread(ThreadRole role, size_t index = 0);
+
+    // Platform calls. @return False if unsupported or the call failed
+    bool PinCurrentThread(unsigned int core);
+    bool PinCurrentThreadExcept(const std::vector<unsigned int>& excludedCores);
+    bool RaiseCurrentThreadPriority();
+}
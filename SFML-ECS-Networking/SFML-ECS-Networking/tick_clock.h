@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "network_messages.h"
+
+// What the simulation sees as "now" during one tick
+struct TickTime {
+    uint32_t tick = 0;
+    int64_t serverMicros = 0;   // Steady clock (same epoch as GetSteadyMicros)
+    int64_t wallMicros = 0;     // System clock, for logs and reports only
+};
+
+// Tick-scoped time service. The clocks are read once when a tick begins and
+// every system in that tick (message stamps, timeouts, lag compensation, RTT
+// samples) gets the same values without touching the clock again. A replay
+// begins each tick with the recorded time instead, so it sees exactly what
+// the recorded run saw. Outside a tick, reads fall through to the live clock.
+class TickClock {
+public:
+    void BeginTick(uint32_t tick) { BeginTick(tick, GetSteadyMicros()); }
+    void BeginTick(uint32_t tick, int64_t serverMicros) {
+        current.tick = tick;
+        current.serverMicros = serverMicros;
+        current.wallMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        inTick = true;
+    }
+    void EndTick() { inTick = false; }
+
+    bool IsInTick() const { return inTick; }
+    const TickTime& GetTickTime() const { return current; }
+
+    int64_t GetServerMicros() const { return inTick ? current.serverMicros : GetSteadyMicros(); }
+    int64_t GetServerMs() const { return GetServerMicros() / 1000; }
+
+private:
+    TickTime current;
+    bool inTick = false;
+};
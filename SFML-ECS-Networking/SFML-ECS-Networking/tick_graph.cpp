@@ -0,0 +1,87 @@
+#include "tick_graph.h"
+#include "job_system.h"
+#include "utils.h"
+#include <algorithm>
+#include <exception>
+
+bool TickGraph::Conflicts(const Phase& a, ResourceSet reads, ResourceSet writes) {
+    return (a.writes & (reads | writes)) != 0 || (a.reads & writes) != 0;
+}
+
+/**
+ * Waves are fixed when the phase is added, so every tick runs the same
+ * schedule whatever the thread count.
+ */
+void TickGraph::AddPhase(const char* name, ResourceSet reads, ResourceSet writes,
+    std::function<void(float)> run, bool usesJobs) {
+    size_t wave = 0;
+    for (const Phase& earlier : phases) {
+        if (Conflicts(earlier, reads, writes)) {
+            wave = std::max(wave, earlier.wave + 1);
+        }
+    }
+    if (usesJobs) {
+        // Its own wave, after everything so far; later phases may still fill earlier waves
+        wave = std::max(wave, waves.size());
+    }
+    else {
+        while (wave < waves.size() && waves[wave].exclusive) {
+            wave++;
+        }
+    }
+    if (wave == waves.size()) {
+        waves.emplace_back();
+    }
+
+    phases.push_back({ name, reads, writes, std::move(run), usesJobs, wave });
+    waves[wave].phases.push_back(phases.size() - 1);
+    waves[wave].exclusive = usesJobs;
+}
+
+void TickGraph::Run(float deltaTime, JobSystem* jobs) {
+    for (const Wave& wave : waves) {
+        if (!jobs || wave.phases.size() == 1) {
+            for (size_t index : wave.phases) {
+                RunPhase(phases[index], deltaTime);
+            }
+            continue;
+        }
+        jobs->ParallelFor(wave.phases.size(), 1, [this, &wave, deltaTime](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                RunPhase(phases[wave.phases[i]], deltaTime);
+            }
+        });
+    }
+}
+
+/**
+ * Phases may run on a worker thread, where an escaping exception would end
+ * the process.
+ */
+void TickGraph::RunPhase(Phase& phase, float deltaTime) {
+    try {
+        phase.run(deltaTime);
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Exception in tick phase " + std::string(phase.name) + ": " + e.what(), error);
+    }
+    catch (...) {
+        Utils::printMsg("Unknown exception in tick phase " + std::string(phase.name), error);
+    }
+}
+
+std::string TickGraph::Describe() const {
+    std::string text;
+    for (const Wave& wave : waves) {
+        if (!text.empty()) {
+            text += " | ";
+        }
+        for (size_t i = 0; i < wave.phases.size(); ++i) {
+            if (i > 0) {
+                text += " + ";
+            }
+            text += phases[wave.phases[i]].name;
+        }
+    }
+    return text;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Runs a fixed list of tick phases, overlapping the ones that touch disjoint
+// state. Each phase declares the state it reads and writes as bit sets; two
+// phases conflict when one writes what the other reads or writes. Phases are
+// grouped into waves as they are added: a phase joins the first wave after
+// every earlier phase it conflicts with, so conflicting phases keep their
+// declaration order and phases within a wave commute. Waves run one after the
+// other, the phases of a wave in parallel on a job system.
+//
+// The result is the same as running the phases serially in declaration
+// order, with or without workers, as long as the declarations are honest.
+class TickGraph {
+public:
+    using ResourceSet = uint32_t;
+
+    TickGraph() = default;
+
+    TickGraph(const TickGraph&) = delete;
+    TickGraph& operator=(const TickGraph&) = delete;
+
+    // Declares the next phase.
+    // @param name Static string, used in logs
+    // @param run Called with the tick's delta time
+    // @param usesJobs The phase runs its own ParallelFor; it gets a wave to itself
+    //        and always runs on the calling thread (JobSystem is not reentrant)
+    void AddPhase(const char* name, ResourceSet reads, ResourceSet writes,
+        std::function<void(float)> run, bool usesJobs = false);
+
+    // Runs every phase once. A null job system runs each wave's phases one
+    // after the other. An exception ends only the phase that threw.
+    void Run(float deltaTime, JobSystem* jobs);
+
+    size_t GetPhaseCount() const { return phases.size(); }
+    size_t GetWaveCount() const { return waves.size(); }
+    // Waves in order, e.g. "Movement | Enemies | Bullets + Targets | Hits"
+    std::string Describe() const;
+
+private:
+    struct Phase {
+        const char* name;
+        ResourceSet reads;
+        ResourceSet writes;
+        std::function<void(float)> run;
+        bool usesJobs;
+        size_t wave;
+    };
+
+    struct Wave {
+        std::vector<size_t> phases;     // Indices into phases, in declaration order
+        bool exclusive = false;         // Holds a phase that uses the job system
+    };
+
+    std::vector<Phase> phases;
+    std::vector<Wave> waves;
+
+    static bool Conflicts(const Phase& a, ResourceSet reads, ResourceSet writes);
+    static void RunPhase(Phase& phase, float deltaTime);
+};
@@ -0,0 +1,108 @@
+#include "tick_profiler.h"
+#include <algorithm>
+
+const char* GetTickPhaseName(TickPhase phase) {
+    switch (phase) {
+    case TickPhase::RECEIVE: return "Receive";
+    case TickPhase::PLAYER_MOVEMENT: return "Player movement";
+    case TickPhase::ENEMIES: return "Enemies";
+    case TickPhase::BULLETS: return "Bullets";
+    case TickPhase::TARGETS: return "Targets";
+    case TickPhase::LAG_HISTORY: return "Lag history";
+    case TickPhase::BULLET_HITS: return "Bullet hits";
+    case TickPhase::COLLISIONS: return "Collisions";
+    case TickPhase::DEATHS: return "Deaths";
+    case TickPhase::SEND_STATE: return "Send state";
+    case TickPhase::SEND_BULLETS: return "Send bullets";
+    case TickPhase::FLUSH: return "Flush";
+    default: return "Unknown";
+    }
+}
+
+void LatencyHistogram::Record(uint64_t microseconds) {
+    buckets[BucketIndex(microseconds)]++;
+    count++;
+    total += microseconds;
+    maxValue = std::max(maxValue, microseconds);
+}
+
+void LatencyHistogram::Reset() {
+    buckets.fill(0);
+    count = 0;
+    total = 0;
+    maxValue = 0;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    total += other.total;
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+/**
+ * Walks the buckets until the requested share of samples is covered.
+ */
+uint64_t LatencyHistogram::GetPercentile(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    const double clamped = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t rank = static_cast<uint64_t>(clamped / 100.0 * static_cast<double>(count) + 0.5);
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(BucketUpperBound(i), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+/**
+ * Values below SUB_BUCKETS get a bucket each; above that, bucket =
+ * octave * SUB_BUCKETS + the SUB_BUCKET_BITS bits after the leading one.
+ * Values past the last octave share the final bucket.
+ */
+size_t LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+
+    uint32_t highestBit = 0;
+    for (uint64_t v = value; v > 1; v >>= 1) {
+        highestBit++;
+    }
+    const uint32_t octave = highestBit - SUB_BUCKET_BITS + 1;
+    if (octave > OCTAVES) {
+        return BUCKET_COUNT - 1;
+    }
+    const uint32_t subBucket = static_cast<uint32_t>(value >> (highestBit - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return octave * SUB_BUCKETS + subBucket;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const uint32_t octave = static_cast<uint32_t>(index / SUB_BUCKETS);
+    const uint64_t subBucket = index % SUB_BUCKETS;
+    const uint32_t shift = octave - 1;
+    // Bucket covers [(SUB_BUCKETS + sub) << shift, (SUB_BUCKETS + sub + 1) << shift)
+    return ((SUB_BUCKETS + subBucket + 1) << shift) - 1;
+}
+
+void TickProfiler::Reset() {
+    for (LatencyHistogram& histogram : phases) {
+        histogram.Reset();
+    }
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        windowAllocationStart[i] = lifetimeAllocations[i].load(std::memory_order_relaxed);
+    }
+    windowOtherAllocationStart = otherAllocations.load(std::memory_order_relaxed);
+}
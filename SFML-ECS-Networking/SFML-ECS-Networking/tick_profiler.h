@@ -0,0 +1,143 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "allocation_counter.h"
+#include "trace_recorder.h"
+
+// Per-phase timers for GameServer::Update. Define TICK_PROFILER_ENABLED 0 to
+// compile PROFILE_TICK_PHASE out (no clock reads, nothing recorded).
+#ifndef TICK_PROFILER_ENABLED
+#define TICK_PROFILER_ENABLED 1
+#endif
+
+enum class TickPhase : uint8_t {
+    RECEIVE,            // ProcessIncomingMessages
+    PLAYER_MOVEMENT,    // SimulatePlayerMovement
+    ENEMIES,            // UpdateEnemies
+    BULLETS,            // Projectile movement and expiry
+    TARGETS,            // RebuildTargetGrids
+    LAG_HISTORY,        // RecordEnemyPositionHistory
+    BULLET_HITS,        // CheckBulletCollisions + RemoveDeadBullets
+    COLLISIONS,         // CheckServerSideCollisions
+    DEATHS,             // CheckPlayerDeaths + UpdateDeadPlayers
+    SEND_STATE,         // SendGameStateToAll
+    SEND_BULLETS,       // SendBulletUpdates
+    FLUSH,              // FlushOutgoing
+    COUNT
+};
+
+const char* GetTickPhaseName(TickPhase phase);
+
+// Latency histogram with fixed log-linear buckets: SUB_BUCKETS per power of
+// two of microseconds, so a percentile overstates the true value by at most
+// 1/SUB_BUCKETS (12.5%). Recording bumps one counter; nothing allocates.
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 3;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t OCTAVES = 24;                       // Up to ~134 s
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS * (OCTAVES + 1);
+
+    LatencyHistogram() { Reset(); }
+
+    void Record(uint64_t microseconds);
+    void Reset();
+    // Adds another histogram's samples (same buckets, so nothing is lost)
+    void Merge(const LatencyHistogram& other);
+
+    uint64_t GetCount() const { return count; }
+    uint64_t GetMax() const { return maxValue; }
+    double GetAverage() const { return count > 0 ? static_cast<double>(total) / static_cast<double>(count) : 0.0; }
+
+    // Upper bound of the bucket holding the given percentile (0-100), capped at the max
+    uint64_t GetPercentile(double percentile) const;
+
+private:
+    std::array<uint32_t, BUCKET_COUNT> buckets;
+    uint64_t count;
+    uint64_t total;
+    uint64_t maxValue;
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+};
+
+// One histogram per phase, reset with each stats window, plus run counts and
+// time per phase since startup that Reset leaves alone (metrics counters).
+// Allocation builds (ALLOCATION_TRACKING_ENABLED) also count each phase's
+// allocations, since startup and since Reset.
+class TickProfiler {
+public:
+    void Record(TickPhase phase, uint64_t microseconds) {
+        const size_t index = static_cast<size_t>(phase);
+        phases[index].Record(microseconds);
+        lifetimeRuns[index]++;
+        lifetimeMicros[index] += microseconds;
+    }
+    const LatencyHistogram& Get(TickPhase phase) const { return phases[static_cast<size_t>(phase)]; }
+    uint64_t GetLifetimeRuns(TickPhase phase) const { return lifetimeRuns[static_cast<size_t>(phase)]; }
+    uint64_t GetLifetimeMicros(TickPhase phase) const { return lifetimeMicros[static_cast<size_t>(phase)]; }
+
+    AllocationCounter::ScopeCounter* GetAllocationCounter(TickPhase phase) {
+        return &lifetimeAllocations[static_cast<size_t>(phase)];
+    }
+    uint64_t GetLifetimeAllocations(TickPhase phase) const {
+        return lifetimeAllocations[static_cast<size_t>(phase)].load(std::memory_order_relaxed);
+    }
+    // Since Reset
+    uint64_t GetAllocations(TickPhase phase) const {
+        return GetLifetimeAllocations(phase) - windowAllocationStart[static_cast<size_t>(phase)];
+    }
+    // For the whole tick; the phases inside take their own allocations
+    AllocationCounter::ScopeCounter* GetOtherAllocationCounter() { return &otherAllocations; }
+    uint64_t GetOtherAllocations() const { return otherAllocations.load(std::memory_order_relaxed) - windowOtherAllocationStart; }
+
+    void Reset();
+
+private:
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(TickPhase::COUNT);
+    std::array<LatencyHistogram, PHASE_COUNT> phases;
+    std::array<uint64_t, PHASE_COUNT> lifetimeRuns{};
+    std::array<uint64_t, PHASE_COUNT> lifetimeMicros{};
+    // Bumped from whichever thread allocates inside the phase (JobSystem workers included)
+    std::array<AllocationCounter::ScopeCounter, PHASE_COUNT> lifetimeAllocations{};
+    std::array<uint64_t, PHASE_COUNT> windowAllocationStart{};
+    AllocationCounter::ScopeCounter otherAllocations{ 0 };
+    uint64_t windowOtherAllocationStart = 0;
+};
+
+// Times the enclosing scope into one phase, and attributes its allocations to
+// it; also a trace event while tracing
+class ScopedPhaseTimer {
+public:
+    ScopedPhaseTimer(TickProfiler& profiler, TickPhase phase)
+        : profiler(profiler), phase(phase), start(std::chrono::steady_clock::now()),
+        allocations(profiler.GetAllocationCounter(phase)) {
+    }
+    ~ScopedPhaseTimer() {
+        const auto end = std::chrono::steady_clock::now();
+        profiler.Record(phase, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+        if (TraceRecorder::IsEnabled()) {
+            TraceRecorder::Instance().Record(GetTickPhaseName(phase), "tick",
+                TraceRecorder::ToMicros(start), TraceRecorder::ToMicros(end));
+        }
+    }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    TickProfiler& profiler;
+    TickPhase phase;
+    std::chrono::steady_clock::time_point start;
+    AllocationCounter::Scope allocations;
+};
+
+#if TICK_PROFILER_ENABLED
+#define PROFILE_TICK_PHASE(profiler, phase) ScopedPhaseTimer tickPhaseTimer_(profiler, phase)
+#else
+#define PROFILE_TICK_PHASE(profiler, phase) ((void)0)
+#endif
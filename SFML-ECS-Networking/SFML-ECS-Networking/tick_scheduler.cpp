@@ -0,0 +1,133 @@
+#include "tick_scheduler.h"
+#include "thread_tuning.h"
+#include "utils.h"
+#include <algorithm>
+
+void TickStats::Merge(const TickStats& other) {
+    ticksRun += other.ticksRun;
+    overrunTicks += other.overrunTicks;
+    droppedTicks += other.droppedTicks;
+    totalTickMs += other.totalTickMs;
+    maxTickMs = std::max(maxTickMs, other.maxTickMs);
+    lateSamples += other.lateSamples;
+    totalLateMs += other.totalLateMs;
+    maxLateMs = std::max(maxLateMs, other.maxLateMs);
+    tickMicros.Merge(other.tickMicros);
+}
+
+/**
+ * Creates a scheduler for the given simulation rate.
+ * @param tickRateHz Simulation ticks per second (clamped to MIN/MAX_TICK_RATE)
+ * @param maxCatchUpTicks Max ticks run in one frame before excess time is dropped
+ */
+TickScheduler::TickScheduler(unsigned int tickRateHz, int maxCatchUpTicks)
+    : tickRate(std::clamp(tickRateHz, MIN_TICK_RATE, MAX_TICK_RATE)),
+    maxCatchUpTicks(std::max(1, maxCatchUpTicks)),
+    accumulator(Clock::duration::zero()),
+    totalTicks(0),
+    lastTickMs(0.0)
+{
+    tickDuration = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / static_cast<double>(tickRate)));
+    tickDurationSeconds = 1.0f / static_cast<float>(tickRate);
+    lastFrameTime = Clock::now();
+    tickStartTime = lastFrameTime;
+
+    if (tickRate != tickRateHz) {
+        Utils::printMsg("Tick rate " + std::to_string(tickRateHz) + " Hz out of range, using " +
+            std::to_string(tickRate) + " Hz", warning);
+    }
+}
+
+TickScheduler::~TickScheduler() = default;
+
+/**
+ * Resets the accumulator and raises the OS timer resolution where supported.
+ * Without this, Windows rounds sf::sleep(1ms) up to the ~15.6 ms system tick.
+ * High priority tuning also asks for a high-resolution waitable timer
+ * (Windows 10 1803 and later); older systems keep the 1 ms sleeps.
+ */
+void TickScheduler::Start() {
+    if (!waiter.Start(ThreadTuner::GetTuning().highPriority)) {
+        Utils::printMsg("High-resolution waitable timer unavailable, pacing ticks with 1 ms sleeps", warning);
+    }
+    lastFrameTime = Clock::now();
+    accumulator = tickDuration;  // First tick runs immediately
+    Utils::printMsg("Tick scheduler started at " + std::to_string(tickRate) + " Hz (" +
+        std::to_string(tickDurationSeconds * 1000.0f) + " ms per tick)");
+}
+
+void TickScheduler::Resume() {
+    lastFrameTime = Clock::now();
+    accumulator = tickDuration;
+}
+
+/**
+ * Adds elapsed real time to the accumulator and returns the number of whole
+ * ticks that are due. Ticks beyond the catch-up limit are dropped so a long
+ * stall does not cause a spiral of death.
+ * @return Number of fixed-size ticks to simulate now
+ */
+int TickScheduler::ConsumeDueTicks() {
+    Clock::time_point now = Clock::now();
+    accumulator += now - lastFrameTime;
+    lastFrameTime = now;
+
+    int dueTicks = static_cast<int>(accumulator / tickDuration);
+    if (dueTicks > maxCatchUpTicks) {
+        stats.droppedTicks += static_cast<uint64_t>(dueTicks - maxCatchUpTicks);
+        accumulator -= tickDuration * (dueTicks - maxCatchUpTicks);
+        dueTicks = maxCatchUpTicks;
+    }
+
+    accumulator -= tickDuration * dueTicks;
+    if (dueTicks > 0) {
+        // What is left over is how long ago the latest of these ticks fell due
+        const double lateMs = std::chrono::duration<double, std::milli>(accumulator).count();
+        stats.lateSamples++;
+        stats.totalLateMs += lateMs;
+        stats.maxLateMs = std::max(stats.maxLateMs, lateMs);
+    }
+    return dueTicks;
+}
+
+void TickScheduler::BeginTick() {
+    tickStartTime = Clock::now();
+}
+
+/**
+ * Records the execution time of the tick started by BeginTick().
+ * A tick counts as an overrun when it uses more than its own time budget.
+ */
+void TickScheduler::EndTick() {
+    Clock::duration elapsed = Clock::now() - tickStartTime;
+    double elapsedMs = std::chrono::duration<double, std::milli>(elapsed).count();
+    lastTickMs = elapsedMs;
+
+    stats.ticksRun++;
+    stats.totalTickMs += elapsedMs;
+    stats.maxTickMs = std::max(stats.maxTickMs, elapsedMs);
+    stats.tickMicros.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    if (elapsed > tickDuration) {
+        stats.overrunTicks++;
+    }
+    totalTicks++;
+}
+
+/**
+ * Blocks until the accumulator holds a full tick.
+ */
+void TickScheduler::WaitForNextTick() const {
+    waiter.WaitUntil(GetNextTickTime());
+}
+
+/**
+ * Lets the server loop do work due before the tick (paced sends) without
+ * giving up the tick's precise start.
+ */
+bool TickScheduler::WaitForNextTick(int64_t wakeAtMicros) const {
+    const Clock::time_point tickTime = GetNextTickTime();
+    const Clock::time_point wakeTime{ std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(wakeAtMicros)) };
+    waiter.WaitUntil(std::min(tickTime, wakeTime));
+    return Clock::now() >= tickTime;
+}
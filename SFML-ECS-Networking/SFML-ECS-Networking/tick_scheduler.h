@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "precise_wait.h"
+#include "tick_profiler.h"
+
+// Timing statistics for the fixed-step simulation, reset each reporting window
+struct TickStats {
+    uint64_t ticksRun;          // Simulation ticks executed in this window
+    uint64_t overrunTicks;      // Ticks that took longer than the tick budget
+    uint64_t droppedTicks;      // Ticks discarded by the catch-up limit
+    double totalTickMs;         // Sum of tick execution times (for averaging)
+    double maxTickMs;           // Slowest tick in this window
+    uint64_t lateSamples;       // Frames that ran ticks (one lateness sample each)
+    double totalLateMs;         // Sum of how long after its due time each frame's last tick started
+    double maxLateMs;           // Tick jitter: worst start lateness in this window
+    LatencyHistogram tickMicros;    // Tick execution times, for percentiles
+
+    TickStats() : ticksRun(0), overrunTicks(0), droppedTicks(0),
+        totalTickMs(0.0), maxTickMs(0.0), lateSamples(0), totalLateMs(0.0), maxLateMs(0.0) {
+    }
+
+    double GetAverageTickMs() const {
+        return ticksRun > 0 ? totalTickMs / static_cast<double>(ticksRun) : 0.0;
+    }
+    double GetAverageLateMs() const {
+        return lateSamples > 0 ? totalLateMs / static_cast<double>(lateSamples) : 0.0;
+    }
+
+    // Adds another window (room workers publish several into one report)
+    void Merge(const TickStats& other);
+};
+
+// Fixed-timestep scheduler for the server simulation.
+// Accumulates real time, hands out whole ticks of a fixed size and paces
+// the loop between ticks without relying on the coarse OS sleep granularity
+// (PreciseWaiter). With high priority thread tuning (thread_tuning.h) on
+// Windows, waits use a high-resolution waitable timer instead of 1 ms sleeps.
+class TickScheduler {
+public:
+    static constexpr unsigned int DEFAULT_TICK_RATE = 60;     // Hz
+    static constexpr unsigned int MIN_TICK_RATE = 10;         // Hz
+    static constexpr unsigned int MAX_TICK_RATE = 240;        // Hz
+    static constexpr int DEFAULT_MAX_CATCH_UP_TICKS = 5;      // Max ticks run per frame after a stall
+
+    TickScheduler(unsigned int tickRateHz = DEFAULT_TICK_RATE,
+        int maxCatchUpTicks = DEFAULT_MAX_CATCH_UP_TICKS);
+    ~TickScheduler();
+
+    // Resets the accumulator so the first tick is due immediately
+    void Start();
+
+    // Forgets the time that passed while the loop was not ticking (idle server),
+    // so the next tick is due immediately instead of a catch-up burst
+    void Resume();
+
+    // Accumulates elapsed time and returns how many ticks should run now
+    int ConsumeDueTicks();
+
+    // Marks the start/end of one simulation tick for overrun accounting
+    void BeginTick();
+    void EndTick();
+
+    // Blocks until the next tick is due (coarse sleep, then short spin)
+    void WaitForNextTick() const;
+    // Same, but returns early once the steady clock (GetSteadyMicros) reaches wakeAtMicros
+    // @return True if the next tick is due
+    bool WaitForNextTick(int64_t wakeAtMicros) const;
+
+    // Configuration accessors
+    unsigned int GetTickRate() const { return tickRate; }
+    float GetTickDuration() const { return tickDurationSeconds; }
+    uint64_t GetTickCount() const { return totalTicks; }
+    double GetLastTickMs() const { return lastTickMs; }     // Execution time of the last tick
+
+    // Statistics window (reset after each report)
+    const TickStats& GetStats() const { return stats; }
+    void ResetStats() { stats = TickStats(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int tickRate;
+    int maxCatchUpTicks;
+    float tickDurationSeconds;
+    Clock::duration tickDuration;
+
+    Clock::time_point lastFrameTime;
+    Clock::time_point tickStartTime;
+    Clock::duration accumulator;
+    uint64_t totalTicks;
+    double lastTickMs;
+    PreciseWaiter waiter;
+
+    TickStats stats;
+
+    Clock::time_point GetNextTickTime() const { return lastFrameTime + (tickDuration - accumulator); }
+};
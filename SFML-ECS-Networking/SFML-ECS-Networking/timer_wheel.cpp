@@ -0,0 +1,182 @@
+#include "timer_wheel.h"
+
+/**
+ * Releases every pending node rather than dropping the node table, so ids
+ * issued before the reset can never match a timer scheduled after it.
+ */
+void TimerWheel::Reset(uint64_t tick) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].bucket != NONE) {
+            Release(static_cast<int32_t>(i));
+        }
+    }
+    heads.fill(NONE);
+    tails.fill(NONE);
+    currentTick = tick;
+    pendingCount = 0;
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64_t dueTick, uint8_t kind, uint32_t target, uint32_t data) {
+    int32_t index;
+    if (!freeNodes.empty()) {
+        index = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else {
+        index = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+        freeNodes.reserve(nodes.capacity());    // Releasing a node never allocates
+    }
+
+    Node& node = nodes[index];
+    node.dueTick = dueTick > currentTick ? dueTick : currentTick + 1;
+    node.kind = kind;
+    node.target = target;
+    node.data = data;
+    Place(index);
+    pendingCount++;
+    return (static_cast<TimerId>(node.generation) << 32) | static_cast<uint32_t>(index);
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    const int32_t index = Resolve(id);
+    if (index == NONE) {
+        return false;
+    }
+    Unlink(index);
+    Release(index);
+    pendingCount--;
+    return true;
+}
+
+bool TimerWheel::IsPending(TimerId id) const {
+    return Resolve(id) != NONE;
+}
+
+uint64_t TimerWheel::GetDueTick(TimerId id) const {
+    const int32_t index = Resolve(id);
+    return index == NONE ? 0 : nodes[index].dueTick;
+}
+
+/**
+ * Steps one tick at a time: on a tick whose low bits roll over, the matching
+ * slot of each higher level is cascaded into the levels below (highest first,
+ * so a timer can fall through several levels at once), then level 0's slot
+ * for the tick fires. With nothing pending the clock simply jumps.
+ */
+void TimerWheel::Advance(uint64_t tick, std::vector<Fired>& fired) {
+    while (currentTick < tick) {
+        if (pendingCount == 0) {
+            currentTick = tick;
+            return;
+        }
+        currentTick++;
+        for (uint32_t level = LEVELS - 1; level > 0; --level) {
+            const uint64_t lowMask = (uint64_t(1) << (SLOT_BITS * level)) - 1;
+            if ((currentTick & lowMask) == 0) {
+                Cascade(level);
+            }
+        }
+        FireSlot(fired);
+    }
+}
+
+/**
+ * The level is the highest SLOT_BITS group in which the due tick differs
+ * from the current one, so the timer is reached exactly when that group of
+ * the clock turns over to it. Timers beyond the top level's span wait in the
+ * next top slot to cascade and are placed again from there.
+ */
+void TimerWheel::Place(int32_t index) {
+    Node& node = nodes[index];
+    const uint64_t diff = node.dueTick ^ currentTick;
+
+    uint32_t level = 0;
+    while (level < LEVELS - 1 && (diff >> (SLOT_BITS * (level + 1))) != 0) {
+        level++;
+    }
+    uint64_t slot;
+    if ((diff >> (SLOT_BITS * LEVELS)) != 0) {
+        level = LEVELS - 1;
+        slot = ((currentTick >> (SLOT_BITS * level)) + 1) & (SLOTS - 1);
+    }
+    else {
+        slot = (node.dueTick >> (SLOT_BITS * level)) & (SLOTS - 1);
+    }
+
+    const int32_t bucket = static_cast<int32_t>(level * SLOTS + slot);
+    node.bucket = bucket;
+    node.next = NONE;
+    node.prev = tails[bucket];
+    if (tails[bucket] != NONE) {
+        nodes[tails[bucket]].next = index;
+    }
+    else {
+        heads[bucket] = index;
+    }
+    tails[bucket] = index;
+}
+
+void TimerWheel::Unlink(int32_t index) {
+    Node& node = nodes[index];
+    if (node.prev != NONE) {
+        nodes[node.prev].next = node.next;
+    }
+    else {
+        heads[node.bucket] = node.next;
+    }
+    if (node.next != NONE) {
+        nodes[node.next].prev = node.prev;
+    }
+    else {
+        tails[node.bucket] = node.prev;
+    }
+    node.prev = NONE;
+    node.next = NONE;
+}
+
+void TimerWheel::Release(int32_t index) {
+    Node& node = nodes[index];
+    node.bucket = NONE;
+    if (++node.generation == 0) {
+        node.generation = 1;
+    }
+    freeNodes.push_back(index);
+}
+
+void TimerWheel::Cascade(uint32_t level) {
+    const int32_t bucket = static_cast<int32_t>(level * SLOTS + ((currentTick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+    int32_t index = heads[bucket];
+    heads[bucket] = NONE;
+    tails[bucket] = NONE;
+    while (index != NONE) {
+        const int32_t next = nodes[index].next;
+        Place(index);
+        index = next;
+    }
+}
+
+void TimerWheel::FireSlot(std::vector<Fired>& fired) {
+    const int32_t bucket = static_cast<int32_t>(currentTick & (SLOTS - 1));
+    int32_t index = heads[bucket];
+    heads[bucket] = NONE;
+    tails[bucket] = NONE;
+    while (index != NONE) {
+        Node& node = nodes[index];
+        const int32_t next = node.next;
+        fired.push_back({ (static_cast<TimerId>(node.generation) << 32) | static_cast<uint32_t>(index),
+            node.kind, node.target, node.data });
+        Release(index);
+        pendingCount--;
+        index = next;
+    }
+}
+
+int32_t TimerWheel::Resolve(TimerId id) const {
+    const uint32_t index = static_cast<uint32_t>(id);
+    const uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= nodes.size() || nodes[index].generation != generation || nodes[index].bucket == NONE) {
+        return NONE;
+    }
+    return static_cast<int32_t>(index);
+}
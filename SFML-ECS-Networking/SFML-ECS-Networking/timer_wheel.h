@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel over simulation ticks.
+// LEVELS wheels of SLOTS slots each: level 0 holds timers due within the next
+// SLOTS ticks, one slot per tick; each higher level covers SLOTS times the
+// span of the one below and is cascaded down as time reaches it. Scheduling
+// and cancelling are O(1) and advancing a tick only touches the timers that
+// fire (plus an occasional cascade), however many are pending.
+// A timer carries a small kind tag and two payload words for its owner.
+class TimerWheel {
+public:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;     // 64 per level
+    static constexpr uint32_t LEVELS = 4;                   // 64^4 ticks, ~77 hours at 60 Hz
+
+    // Generation in the high half, node index in the low half; 0 is never issued
+    using TimerId = uint64_t;
+    static constexpr TimerId INVALID_TIMER = 0;
+
+    struct Fired {
+        TimerId id;
+        uint8_t kind;
+        uint32_t target;
+        uint32_t data;
+    };
+
+    TimerWheel() { Reset(0); }
+
+    // Drops every pending timer and restarts the clock at tick
+    void Reset(uint64_t tick);
+
+    // Timers due at or before the current tick fire on the next Advance
+    TimerId Schedule(uint64_t dueTick, uint8_t kind, uint32_t target, uint32_t data = 0);
+
+    // @return False if the timer already fired or was cancelled
+    bool Cancel(TimerId id);
+    bool IsPending(TimerId id) const;
+    // @return The tick a pending timer fires on, or 0 if it is not pending
+    uint64_t GetDueTick(TimerId id) const;
+
+    // Moves the clock to tick, appending every timer that came due to fired
+    // (by due tick, then in scheduling order). fired is not cleared.
+    void Advance(uint64_t tick, std::vector<Fired>& fired);
+
+    uint64_t GetCurrentTick() const { return currentTick; }
+    size_t GetPendingCount() const { return pendingCount; }
+
+private:
+    static constexpr int32_t NONE = -1;
+
+    struct Node {
+        uint64_t dueTick = 0;
+        uint32_t generation = 1;
+        uint32_t target = 0;
+        uint32_t data = 0;
+        int32_t prev = NONE;
+        int32_t next = NONE;
+        int32_t bucket = NONE;      // level * SLOTS + slot, NONE while free
+        uint8_t kind = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int32_t> freeNodes;
+    std::array<int32_t, LEVELS * SLOTS> heads;
+    std::array<int32_t, LEVELS * SLOTS> tails;
+    uint64_t currentTick;
+    size_t pendingCount;
+
+    void Place(int32_t index);
+    void Unlink(int32_t index);
+    void Release(int32_t index);
+    void Cascade(uint32_t level);
+    void FireSlot(std::vector<Fired>& fired);
+    int32_t Resolve(TimerId id) const;
+};
@@ -0,0 +1,142 @@
+#include "trace_recorder.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+    thread_local const char* threadName = nullptr;
+    thread_local void* threadBuffer = nullptr;      // TraceRecorder::ThreadBuffer of this thread
+
+    struct CopiedEvent {
+        const char* name;
+        const char* category;
+        int64_t beginMicros;
+        int64_t endMicros;
+        uint32_t threadId;
+    };
+
+    // Names are literals or process names typed by us; only quotes and backslashes need escaping
+    std::string Escape(const char* text) {
+        std::string escaped;
+        for (const char* c = text; *c; ++c) {
+            if (*c == '"' || *c == '\\') {
+                escaped += '\\';
+            }
+            escaped += *c;
+        }
+        return escaped;
+    }
+}
+
+TraceRecorder& TraceRecorder::Instance() {
+    static TraceRecorder instance;
+    return instance;
+}
+
+void TraceRecorder::SetProcessName(const std::string& name, uint32_t processId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    processName = name;
+    this->processId = processId;
+}
+
+void TraceRecorder::SetThreadName(const char* name) {
+    threadName = name;
+    if (threadBuffer) {
+        static_cast<ThreadBuffer*>(threadBuffer)->threadName.store(name, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Seqlock per ring: the claim is published (release fence) before the slot is
+ * rewritten, so a dump that read a slot mid-rewrite sees the claim after its
+ * acquire fence and drops the slot.
+ */
+void TraceRecorder::Record(const char* name, const char* category, int64_t beginMicros, int64_t endMicros) {
+    ThreadBuffer* buffer = static_cast<ThreadBuffer*>(threadBuffer);
+    if (!buffer) {
+        buffer = &RegisterThread();
+    }
+    const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    buffer->claimed.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event& event = buffer->events[index & (EVENTS_PER_THREAD - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.category.store(category, std::memory_order_relaxed);
+    event.beginMicros.store(beginMicros, std::memory_order_relaxed);
+    event.endMicros.store(endMicros, std::memory_order_relaxed);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::RegisterThread() {
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer& buffer = *buffers.back();
+    buffer.threadId = static_cast<uint32_t>(buffers.size());
+    buffer.threadName.store(threadName, std::memory_order_relaxed);
+    threadBuffer = &buffer;
+    return buffer;
+}
+
+/**
+ * Copies each ring's published events, then drops the ones its owner may
+ * have started overwriting meanwhile, and writes them after the process and
+ * thread name records. Threads keep recording while this runs.
+ */
+bool TraceRecorder::WriteChromeTrace(const std::string& path, int64_t clockOffsetMicros) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<CopiedEvent> events;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t first = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+        const size_t copiedFrom = events.size();
+        for (uint64_t index = first; index < written; ++index) {
+            const Event& event = buffer->events[index & (EVENTS_PER_THREAD - 1)];
+            events.push_back(CopiedEvent{ event.name.load(std::memory_order_relaxed),
+                event.category.load(std::memory_order_relaxed), event.beginMicros.load(std::memory_order_relaxed),
+                event.endMicros.load(std::memory_order_relaxed), buffer->threadId });
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t claimed = buffer->claimed.load(std::memory_order_relaxed);
+        const uint64_t overwritten = claimed > EVENTS_PER_THREAD ? claimed - EVENTS_PER_THREAD : 0;
+        if (overwritten > first) {
+            const size_t dropped = static_cast<size_t>(std::min(overwritten, written) - first);
+            events.erase(events.begin() + copiedFrom, events.begin() + copiedFrom + dropped);
+        }
+    }
+
+    try {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            Utils::printMsg("Failed to open trace file " + path, warning);
+            return false;
+        }
+        const std::string pid = std::to_string(processId);
+        file << "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid <<
+            ",\"args\":{\"name\":\"" << Escape(processName.c_str()) << "\"}}";
+        for (const std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+            if (const char* name = buffer->threadName.load(std::memory_order_relaxed)) {
+                file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->threadId <<
+                    ",\"args\":{\"name\":\"" << Escape(name) << "\"}}";
+            }
+        }
+        for (const CopiedEvent& event : events) {
+            file << ",\n{\"name\":\"" << Escape(event.name) << "\",\"cat\":\"" << Escape(event.category) <<
+                "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << event.threadId <<
+                ",\"ts\":" << (event.beginMicros + clockOffsetMicros) <<
+                ",\"dur\":" << (event.endMicros - event.beginMicros) << "}";
+        }
+        file << "\n]\n";
+        if (!file) {
+            Utils::printMsg("Failed to write trace file " + path, warning);
+            return false;
+        }
+    }
+    catch (const std::exception& e) {
+        Utils::printMsg("Error writing trace file " + path + " - " + std::string(e.what()), error);
+        return false;
+    }
+    Utils::printMsg("Wrote " + std::to_string(events.size()) + " trace events to " + path, success);
+    return true;
+}
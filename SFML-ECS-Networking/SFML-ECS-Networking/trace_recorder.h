@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Opt-in timeline of begin/end events (tick phases, datagrams, snapshot
+// encode/decode, frame phases) for finding individual bad ticks and frames.
+// Dumps are Chrome trace-event JSON in the array format, which
+// chrome://tracing and ui.perfetto.dev open directly; a server and a client
+// dump can be merged with "jq -s add server.json client.json". Timestamps are
+// the steady clock (GetSteadyMicros); a client passes its ClockSync offset
+// when dumping so its events land on the server's timeline.
+//
+// Each thread records into a ring of its own, so recording takes no lock:
+// claim a slot, fill it, then publish it by bumping the thread's count. Older
+// events are overwritten, so a dump holds roughly the last few seconds of
+// each thread. The first event on a thread allocates its ring. While
+// disabled, a TRACE_SCOPE costs one relaxed load.
+class TraceRecorder {
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 15;  // Power of two, ~1 MiB per thread
+
+    static TraceRecorder& Instance();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void SetEnabled(bool enabled) { this->enabled.store(enabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return Instance().enabled.load(std::memory_order_relaxed); }
+
+    // Process row in the trace; give each process its own ID so merged dumps stay apart
+    void SetProcessName(const std::string& name, uint32_t processId);
+    // Calling thread's row name (a string literal); may be called before tracing starts
+    static void SetThreadName(const char* name);
+
+    // name and category must be string literals: only the pointers are stored
+    void Record(const char* name, const char* category, int64_t beginMicros, int64_t endMicros);
+
+    // Writes every event still held, shifted by clockOffsetMicros
+    // @return False if the file could not be written
+    bool WriteChromeTrace(const std::string& path, int64_t clockOffsetMicros = 0);
+
+    static int64_t NowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static int64_t ToMicros(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+    }
+
+private:
+    TraceRecorder() = default;
+
+    // Fields are atomics only so a dump may read a slot the owner is rewriting;
+    // such slots are detected by the claim count and dropped
+    struct Event {
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<const char*> category{ nullptr };
+        std::atomic<int64_t> beginMicros{ 0 };
+        std::atomic<int64_t> endMicros{ 0 };
+    };
+
+    struct ThreadBuffer {
+        uint32_t threadId = 0;
+        std::atomic<const char*> threadName{ nullptr };
+        std::atomic<uint64_t> claimed{ 0 };         // Slots taken, including one being written
+        std::atomic<uint64_t> written{ 0 };         // Slots published
+        std::array<Event, EVENTS_PER_THREAD> events;
+    };
+
+    std::atomic<bool> enabled{ false };
+    std::mutex mutex;                                   // Registration and dumps
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Never freed: threads may still hold them
+    std::string processName = "TankGame";
+    uint32_t processId = 1;
+
+    ThreadBuffer& RegisterThread();
+};
+
+// Records the enclosing scope if tracing was on when it began
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category)
+        : name(name), category(category), beginMicros(TraceRecorder::IsEnabled() ? TraceRecorder::NowMicros() : -1) {
+    }
+    ~TraceScope() {
+        if (beginMicros >= 0) {
+            TraceRecorder::Instance().Record(name, category, beginMicros, TraceRecorder::NowMicros());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    int64_t beginMicros;
+};
+
+#define TRACE_SCOPE(name, category) TraceScope traceScope_(name, category)
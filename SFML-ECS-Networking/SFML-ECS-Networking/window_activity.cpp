@@ -0,0 +1,29 @@
+#include "window_activity.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+WindowActivity GetWindowActivity(const sf::WindowBase& window) {
+#ifdef _WIN32
+    if (IsIconic(window.getNativeHandle())) {
+        return WindowActivity::MINIMISED;
+    }
+#endif
+    return window.hasFocus() ? WindowActivity::FOREGROUND : WindowActivity::UNFOCUSED;
+}
+
+const char* GetWindowActivityName(WindowActivity activity) {
+    switch (activity) {
+    case WindowActivity::FOREGROUND: return "foreground";
+    case WindowActivity::UNFOCUSED: return "unfocused";
+    case WindowActivity::MINIMISED: return "minimised";
+    }
+    return "unknown";
+}
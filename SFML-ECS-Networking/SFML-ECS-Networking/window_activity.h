@@ -0,0 +1,16 @@
+#pragma once
+#include <SFML/Window/WindowBase.hpp>
+#include <cstdint>
+
+// How much of the client the player can see, which decides how much work a
+// frame does (MultiplayerGame::SetWindowActivity and the client loop in main.cpp)
+enum class WindowActivity : uint8_t {
+    FOREGROUND,         // Focused: full rate
+    UNFOCUSED,          // Visible behind another window: rendering throttled
+    MINIMISED           // Not visible: no rendering, network and inputs only
+};
+
+// Focus comes from SFML. Minimised is only detected on Windows (the window
+// is iconic); elsewhere a minimised window counts as unfocused.
+WindowActivity GetWindowActivity(const sf::WindowBase& window);
+const char* GetWindowActivityName(WindowActivity activity);
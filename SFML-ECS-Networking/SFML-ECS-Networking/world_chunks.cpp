@@ -0,0 +1,129 @@
+#include "world_chunks.h"
+
+namespace {
+    // Integer hash (lowbias32) of a tile coordinate and the seed
+    uint32_t HashTile(uint32_t seed, int x, int y) {
+        uint32_t h = seed ^ (static_cast<uint32_t>(x) * 0x9E3779B1u) ^ (static_cast<uint32_t>(y) * 0x85EBCA77u);
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        h *= 0x846CA68Bu;
+        h ^= h >> 16;
+        return h;
+    }
+}
+
+/**
+ * Patches of dirt, gravel or scorched ground on grass. Patches are 3x3 tile
+ * blocks picked in world tile coordinates, so they run across chunk edges,
+ * with single tiles sprinkled in.
+ */
+void WorldChunks::GenerateTiles(uint32_t worldSeed, ChunkId chunk, std::vector<uint8_t>& tiles) {
+    constexpr int PATCH_TILES = 3;
+    tiles.assign(TILE_COUNT, static_cast<uint8_t>(TileKind::GRASS));
+    const int firstX = ColumnOfChunk(chunk) * TILES_PER_SIDE;
+    const int firstY = RowOfChunk(chunk) * TILES_PER_SIDE;
+    for (int y = 0; y < TILES_PER_SIDE; ++y) {
+        for (int x = 0; x < TILES_PER_SIDE; ++x) {
+            const int tileX = firstX + x;
+            const int tileY = firstY + y;
+            const uint32_t patch = HashTile(worldSeed, tileX / PATCH_TILES, tileY / PATCH_TILES);
+            const uint32_t single = HashTile(worldSeed + 1, tileX, tileY);
+            TileKind kind = TileKind::GRASS;
+            if (patch % 8 == 0) {
+                kind = static_cast<TileKind>(1 + (patch >> 8) % (static_cast<uint32_t>(TileKind::COUNT) - 1));
+            }
+            else if (single % 24 == 0) {
+                kind = TileKind::GRAVEL;
+            }
+            tiles[y * TILES_PER_SIDE + x] = static_cast<uint8_t>(kind);
+        }
+    }
+}
+
+/**
+ * Walks the chunk rows and columns the rectangle covers; the result is
+ * sorted so callers see entries in list order, as the full-list loops did.
+ */
+void ChunkLists::Gather(sf::Vector2f center, float halfWidth, float halfHeight, std::vector<uint32_t>& outIndices) const {
+    outIndices.clear();
+    const int minColumn = WorldChunks::ColumnOf(center.x - halfWidth);
+    const int maxColumn = WorldChunks::ColumnOf(center.x + halfWidth);
+    const int minRow = WorldChunks::RowOf(center.y - halfHeight);
+    const int maxRow = WorldChunks::RowOf(center.y + halfHeight);
+    for (int row = minRow; row <= maxRow; ++row) {
+        const size_t first = static_cast<size_t>(row) * WorldChunks::COLUMNS;
+        // Chunks of one row are contiguous in entries
+        outIndices.insert(outIndices.end(), entries.begin() + starts[first + minColumn],
+            entries.begin() + starts[first + maxColumn + 1]);
+    }
+    std::sort(outIndices.begin(), outIndices.end());
+}
+
+size_t ChunkLists::GetOccupiedChunkCount() const {
+    size_t occupied = 0;
+    for (size_t chunk = 0; chunk < WorldChunks::COUNT; ++chunk) {
+        if (starts[chunk + 1] != starts[chunk]) {
+            occupied++;
+        }
+    }
+    return occupied;
+}
+
+void ChunkActivity::Clear() {
+    active.fill(false);
+    activeCount = 0;
+}
+
+void ChunkActivity::ActivateAround(sf::Vector2f position) {
+    const int column = WorldChunks::ColumnOf(position.x);
+    const int row = WorldChunks::RowOf(position.y);
+    for (int y = std::max(0, row - activeRadius); y <= std::min(WorldChunks::ROWS - 1, row + activeRadius); ++y) {
+        for (int x = std::max(0, column - activeRadius); x <= std::min(WorldChunks::COLUMNS - 1, column + activeRadius); ++x) {
+            bool& flag = active[static_cast<size_t>(y) * WorldChunks::COLUMNS + x];
+            if (!flag) {
+                flag = true;
+                activeCount++;
+            }
+        }
+    }
+}
+
+void ChunkContentStore::SetSeed(uint32_t worldSeed) {
+    if (worldSeed == seed) {
+        return;
+    }
+    seed = worldSeed;
+    for (std::vector<uint8_t>& chunkTiles : tiles) {
+        chunkTiles.clear();
+        chunkTiles.shrink_to_fit();
+    }
+    generatedCount = 0;
+}
+
+void ChunkContentStore::SetObstacles(const std::vector<StaticObstacles::Obstacle>& mapObstacles) {
+    for (std::vector<StaticObstacles::Obstacle>& chunkObstacles : obstacles) {
+        chunkObstacles.clear();
+    }
+    for (const StaticObstacles::Obstacle& obstacle : mapObstacles) {
+        const sf::Vector2f center((obstacle.box.left + obstacle.box.right) / 2.0f, (obstacle.box.top + obstacle.box.bottom) / 2.0f);
+        obstacles[WorldChunks::ChunkAt(center)].push_back(obstacle);
+    }
+}
+
+const std::vector<uint8_t>& ChunkContentStore::GetTiles(WorldChunks::ChunkId chunk) {
+    std::vector<uint8_t>& chunkTiles = tiles[chunk];
+    if (chunkTiles.empty()) {
+        WorldChunks::GenerateTiles(seed, chunk, chunkTiles);
+        generatedCount++;
+    }
+    return chunkTiles;
+}
+
+size_t ChunkContentStore::GetApproximateBytes() const {
+    size_t bytes = sizeof(*this) + generatedCount * WorldChunks::TILE_COUNT;
+    for (const std::vector<StaticObstacles::Obstacle>& chunkObstacles : obstacles) {
+        bytes += chunkObstacles.capacity() * sizeof(StaticObstacles::Obstacle);
+    }
+    return bytes;
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "static_obstacles.h"
+#include "world_constants.h"
+
+// The world as a grid of fixed-size chunks (WorldConstants::CHUNK_SIZE), so
+// per-tick work follows where the players are rather than how big the map is.
+//
+// On the server each state tick ChunkLists buckets the replicated enemies and
+// bullets by chunk, and interest passes only visit the chunks around a viewer.
+// ChunkActivity marks the chunks within an active radius of a live player;
+// enemies elsewhere sleep (no AI) until someone comes near.
+//
+// Static content, ground tiles generated from the world seed and the map's
+// obstacles (ChunkContentStore), is streamed: a client is sent the chunks within
+// STREAM_RADIUS of its tank (CHUNK_DATA, reliable) and drops those beyond
+// UNLOAD_RADIUS. The server forgets what it sent at FORGET_RADIUS, one ring
+// before the client unloads, so a chunk coming back into range is always
+// sent again.
+namespace WorldChunks {
+    using ChunkId = uint16_t;       // Row-major: row * COLUMNS + column
+
+    constexpr int COLUMNS = WorldConstants::CHUNK_COLUMNS;
+    constexpr int ROWS = WorldConstants::CHUNK_ROWS;
+    constexpr int COUNT = COLUMNS * ROWS;
+    static_assert(COUNT > 0 && COUNT <= 0xFFFF, "Chunk IDs are 16-bit");
+
+    constexpr int TILES_PER_SIDE = 10;
+    constexpr int TILE_COUNT = TILES_PER_SIDE * TILES_PER_SIDE;
+    constexpr float TILE_SIZE = WorldConstants::CHUNK_SIZE / TILES_PER_SIDE;
+
+    constexpr int STREAM_RADIUS = 2;                    // Chunks around the tank a client is sent
+    constexpr int FORGET_RADIUS = STREAM_RADIUS + 1;    // Server drops its record of a sent chunk
+    constexpr int UNLOAD_RADIUS = STREAM_RADIUS + 2;    // Client drops the chunk
+    constexpr int DEFAULT_ACTIVE_RADIUS = 3;            // Covers the whole default 4x3 map from any chunk
+    constexpr size_t MAX_PENDING_CHUNK_SENDS = 8;       // Reliable messages in flight before streaming waits
+
+    // Ground kinds, drawn as tints over the background; GRASS draws nothing
+    enum class TileKind : uint8_t { GRASS, DIRT, GRAVEL, SCORCHED, COUNT };
+
+    inline int ColumnOf(float x) {
+        return std::clamp(static_cast<int>(x / WorldConstants::CHUNK_SIZE), 0, COLUMNS - 1);
+    }
+    inline int RowOf(float y) {
+        return std::clamp(static_cast<int>(y / WorldConstants::CHUNK_SIZE), 0, ROWS - 1);
+    }
+    // Positions outside the world map to the edge chunks
+    inline ChunkId ChunkAt(sf::Vector2f position) {
+        return static_cast<ChunkId>(RowOf(position.y) * COLUMNS + ColumnOf(position.x));
+    }
+    inline int ColumnOfChunk(ChunkId chunk) { return chunk % COLUMNS; }
+    inline int RowOfChunk(ChunkId chunk) { return chunk / COLUMNS; }
+    inline sf::Vector2f ChunkOrigin(ChunkId chunk) {
+        return sf::Vector2f(ColumnOfChunk(chunk) * WorldConstants::CHUNK_SIZE, RowOfChunk(chunk) * WorldConstants::CHUNK_SIZE);
+    }
+    // Rings between two chunks (Chebyshev distance)
+    inline int Distance(ChunkId a, ChunkId b) {
+        return std::max(std::abs(ColumnOfChunk(a) - ColumnOfChunk(b)), std::abs(RowOfChunk(a) - RowOfChunk(b)));
+    }
+
+    // Deterministic for a seed, so every chunk can be regenerated on demand
+    void GenerateTiles(uint32_t worldSeed, ChunkId chunk, std::vector<uint8_t>& tiles);
+}
+
+// Indices into one replicated entity list (worldSnapshot.enemies, a bullet
+// list), bucketed by chunk. Rebuilt whole with the list, counting-sort style,
+// so a rebuild is two passes and keeps its buffers.
+class ChunkLists {
+public:
+    // positionOf(index) -> sf::Vector2f for each index below count
+    template <typename PositionFn>
+    void Rebuild(size_t count, PositionFn&& positionOf);
+
+    // Indices of every entry in the chunks the rectangle touches, ascending
+    // (so in list order). Entries still need an exact test.
+    void Gather(sf::Vector2f center, float halfWidth, float halfHeight, std::vector<uint32_t>& outIndices) const;
+
+    size_t GetEntryCount() const { return entries.size(); }
+    size_t GetOccupiedChunkCount() const;
+
+private:
+    std::array<uint32_t, WorldChunks::COUNT + 1> starts{};  // Chunk c holds entries[starts[c], starts[c + 1])
+    std::vector<uint32_t> entries;
+    std::vector<WorldChunks::ChunkId> chunkOf;              // Per index, between the two passes
+};
+
+// Chunks with a live player within the active radius; everything else may sleep
+class ChunkActivity {
+public:
+    ChunkActivity() : activeRadius(WorldChunks::DEFAULT_ACTIVE_RADIUS), activeCount(0) { active.fill(false); }
+
+    void SetActiveRadius(int radius) { activeRadius = std::max(0, radius); }
+    int GetActiveRadius() const { return activeRadius; }
+
+    void Clear();
+    void ActivateAround(sf::Vector2f position);
+    bool IsActive(sf::Vector2f position) const { return active[WorldChunks::ChunkAt(position)]; }
+    size_t GetActiveCount() const { return activeCount; }
+
+private:
+    std::array<bool, WorldChunks::COUNT> active;
+    int activeRadius;
+    size_t activeCount;
+};
+
+// Static chunk content: tiles generated the first time a chunk is asked for,
+// and the map's obstacles bucketed by the chunk holding their centre
+class ChunkContentStore {
+public:
+    static constexpr uint32_t DEFAULT_SEED = 0x7A4E5EEDu;
+
+    ChunkContentStore() : seed(DEFAULT_SEED), generatedCount(0) {}
+
+    // Drops what was generated for the previous seed
+    void SetSeed(uint32_t worldSeed);
+    const std::vector<uint8_t>& GetTiles(WorldChunks::ChunkId chunk);
+
+    void SetObstacles(const std::vector<StaticObstacles::Obstacle>& mapObstacles);
+    const std::vector<StaticObstacles::Obstacle>& GetObstacles(WorldChunks::ChunkId chunk) const { return obstacles[chunk]; }
+
+    size_t GetGeneratedCount() const { return generatedCount; }
+    size_t GetApproximateBytes() const;
+
+private:
+    uint32_t seed;
+    std::array<std::vector<uint8_t>, WorldChunks::COUNT> tiles;    // Empty until generated
+    std::array<std::vector<StaticObstacles::Obstacle>, WorldChunks::COUNT> obstacles;
+    size_t generatedCount;
+};
+
+template <typename PositionFn>
+void ChunkLists::Rebuild(size_t count, PositionFn&& positionOf) {
+    starts.fill(0);
+    chunkOf.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        chunkOf[i] = WorldChunks::ChunkAt(positionOf(i));
+        starts[chunkOf[i] + 1]++;
+    }
+    for (size_t chunk = 1; chunk < starts.size(); ++chunk) {
+        starts[chunk] += starts[chunk - 1];
+    }
+    entries.resize(count);
+    std::array<uint32_t, WorldChunks::COUNT> next;
+    std::copy(starts.begin(), starts.end() - 1, next.begin());
+    for (size_t i = 0; i < count; ++i) {
+        entries[next[chunkOf[i]]++] = static_cast<uint32_t>(i);
+    }
+}
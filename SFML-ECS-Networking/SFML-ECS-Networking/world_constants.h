@@ -1,11 +1,18 @@
 #pragma once
 
 namespace WorldConstants {
-   /* Total window/world width in pixels */
-    constexpr float WORLD_WIDTH = 1280.0f;
+    /* Side of one world chunk in pixels (see world_chunks.h) */
+    constexpr float CHUNK_SIZE = 320.0f;
 
-    /* Total window/world height in pixels */
-    constexpr float WORLD_HEIGHT = 960.0f;
+    /* World size in chunks; raise these for bigger maps */
+    constexpr int CHUNK_COLUMNS = 4;
+    constexpr int CHUNK_ROWS = 3;
+
+    /* Total world width in pixels */
+    constexpr float WORLD_WIDTH = CHUNK_SIZE * CHUNK_COLUMNS;
+
+    /* Total world height in pixels */
+    constexpr float WORLD_HEIGHT = CHUNK_SIZE * CHUNK_ROWS;
 
     /* Thickness of border decorations around playable area */
     constexpr float BORDER_THICKNESS = 48.0f;